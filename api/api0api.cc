@@ -18,6 +18,8 @@ along with this program; if not, write to the Free Software
 Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 ************************************************************************/
+#include <algorithm>
+#include <memory>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -28,21 +30,32 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "api0misc.h"
 #include "api0ucode.h"
 #include "btr0blob.h"
+#include "btr0bulk.h"
+#include "btr0defrag.h"
 #include "btr0pcur.h"
+#include "buf0buf.h"
+#include "buf0rea.h"
 #include "ddl0ddl.h"
 #include "dict0dict.h"
+#include "dict0hist.h"
+#include "dict0stats.h"
+#include "fil0trim.h"
 #include "innodb0types.h"
 #include "lock0lock.h"
 #include "lock0types.h"
+#include "log0arch.h"
+#include "log0backup.h"
 #include "pars0pars.h"
 #include "rem0cmp.h"
 #include "row0ins.h"
 #include "row0merge.h"
 #include "row0pread.h"
 #include "row0prebuilt.h"
+#include "row0row.h"
 #include "row0sel.h"
 #include "row0upd.h"
 #include "row0vers.h"
+#include "srv0conc.h"
 #include "srv0srv.h"
 #include "trx0roll.h"
 #include "ut0counter.h"
@@ -67,6 +80,110 @@ struct ib_db_format_t {
 /** This value is read at database startup. */
 static ib_db_format_t db_format;
 
+/**
+ * @param[in] profile Waits and rows examined of operations.
+ *
+ * @return the profile for the slow operation and transaction logs.
+ */
+static std::string ib_op_profile_to_string(const ut::Op_profile &profile) noexcept {
+  auto wait = [&profile](ut::Wait_type type) {
+    return std::format("{} ({} us)", profile.m_n_waits[size_t(type)], profile.m_wait_ns[size_t(type)] / 1000);
+  };
+
+  return std::format(
+    "page reads {}, lock waits {}, latch waits {}, log waits {}, rows examined {}", wait(ut::Wait_type::PAGE_READ),
+    wait(ut::Wait_type::LOCK), wait(ut::Wait_type::LATCH), wait(ut::Wait_type::LOG_FLUSH), profile.m_n_rows_examined
+  );
+}
+
+/**
+ * @param[in] trx_id Id of the transaction, 0 if it has none.
+ * @param[in] trx Address of the transaction object.
+ *
+ * @return the transaction for the slow operation and transaction logs. The
+ *  read-only transactions have no id, the address tells the ones that run
+ *  at the same time apart.
+ */
+static std::string ib_trx_to_log_string(trx_id_t trx_id, const void *trx) noexcept {
+  return std::format("trx {} ({})", trx_id, trx);
+}
+
+/** Times an API operation like Srv_op_stats::Timer. With the slow operation
+log on, the operation, its waits and its rows examined are also added to the
+profile of its transaction, see ib_trx_release(), and the operation is logged
+with them if it took longer than srv_config.m_slow_op_threshold_us. */
+struct Api_op_timer {
+  /**
+   * @param[in] op The operation that starts.
+   * @param[in,out] trx Transaction of the operation.
+   */
+  Api_op_timer(Srv_op op, Trx *trx) noexcept : m_timer(srv_op_stats, op), m_trx(trx), m_trx_addr(trx) {
+    if (srv_config.m_slow_op_threshold_us > 0 && ut::op_profile == nullptr) {
+      ut::op_profile = &m_profile;
+    }
+  }
+
+  ~Api_op_timer() noexcept { stop(); }
+
+  /** Ends the profile of the operation before the timer goes out of scope,
+  e.g., before the transaction is released. The latency is still recorded
+  when the timer goes out of scope. */
+  void stop() noexcept {
+    using namespace std::chrono;
+
+    if (ut::op_profile != &m_profile) {
+      return;
+    }
+
+    ut::op_profile = nullptr;
+
+    m_profile.m_n_ops = 1;
+    m_profile.m_op_ns = uint64_t(duration_cast<nanoseconds>(steady_clock::now() - m_timer.m_start).count());
+
+    if (m_trx != nullptr) {
+      m_trx_id = m_trx->m_id;
+      m_trx->m_op_profile.add(m_profile);
+    }
+
+    const auto us = m_profile.m_op_ns / 1000;
+
+    if (us < srv_config.m_slow_op_threshold_us) {
+      return;
+    }
+
+    log_warn(std::format(
+      "Slow {}: {} us, {}, {}", Srv_op_stats::get_name(m_timer.m_op), us, ib_trx_to_log_string(m_trx_id, m_trx_addr),
+      ib_op_profile_to_string(m_profile)
+    ));
+  }
+
+  /** The transaction is freed before the timer goes out of scope, the
+  operation is still timed and logged but not added to its profile. */
+  void detach_trx() noexcept {
+    m_trx_id = m_trx->m_id;
+    m_trx = nullptr;
+  }
+
+  Api_op_timer(const Api_op_timer &) = delete;
+  Api_op_timer &operator=(const Api_op_timer &) = delete;
+
+  /** Records the latency of the operation. */
+  Srv_op_stats::Timer m_timer;
+
+  /** Transaction of the operation, nullptr once it is freed. */
+  Trx *m_trx;
+
+  /** Address of the transaction, for the log. */
+  const void *m_trx_addr;
+
+  /** Id of the transaction when the operation ended or the transaction was
+  detached, for the log. It is assigned when the transaction starts. */
+  trx_id_t m_trx_id{};
+
+  /** Waits and rows examined of the operation. */
+  ut::Op_profile m_profile{};
+};
+
 /**
  * Does a simple memcmp(3).
  *
@@ -115,6 +232,12 @@ struct ib_qry_grph_t {
 
   /* Dummy query graph used in selects */
   que_fork_t *sel;
+
+  /** Version of the graph cache of the table when ins was checked out */
+  uint64_t ins_version;
+
+  /** Version of the graph cache of the table when upd was checked out */
+  uint64_t upd_version;
 };
 
 /* Query node types. */
@@ -144,9 +267,6 @@ struct ib_cursor_t {
   /** Instance heap */
   mem_heap_t *heap;
 
-  /** Heap to use for query graphs */
-  mem_heap_t *query_heap;
-
   /** Query processing info */
   ib_qry_proc_t q_proc;
 
@@ -155,6 +275,32 @@ struct ib_cursor_t {
 
   /** For reading rows */
   Prebuilt *prebuilt;
+
+  /** Bulk load of the clustered index, nullptr if none in progress */
+  Btree_bulk *bulk;
+
+  /** Heap for the rows of the bulk load */
+  mem_heap_t *bulk_heap;
+
+  /** true if the rows read leave the externally stored columns on their
+  BLOB pages, see ib_cursor_set_blob_streaming() */
+  bool stream_blobs;
+
+  /** true if ib_cursor_read_row() points the tuple into the leaf page
+  instead of copying the row, see ib_cursor_set_zero_copy() */
+  bool zero_copy;
+
+  /** Keeps the leaf page of the last row read in zero-copy mode S-latched
+  until the cursor is used again. Allocated from the cursor heap when
+  zero-copy is switched on, nullptr before. */
+  mtr_t *row_mtr;
+
+  /** true if the columns were declared with ib_cursor_set_columns() */
+  bool cols_declared;
+
+  /** true if the index of the cursor has all the declared columns, the rows
+  are then read from the secondary index records */
+  bool cols_covered;
 };
 
 /* InnoDB table columns used during table and index schema creation. */
@@ -224,6 +370,9 @@ struct ib_table_def_t {
   /** Page size */
   ulint page_size;
 
+  /** True if temporary table */
+  bool temporary;
+
   /** Vector of columns */
   std::vector<ib_col_t *> *cols;
 
@@ -234,11 +383,24 @@ struct ib_table_def_t {
   Table *table;
 };
 
+/** A column value buffer of a tuple */
+struct ib_col_buf_t {
+  /** Buffer allocated from the tuple heap, or nullptr */
+  byte *ptr;
+
+  /** Size of the buffer */
+  ulint size;
+};
+
 /* InnoDB tuple used for key operations. */
 struct ib_tuple_t {
   /** Heap used to build this and for copying the column values. */
   mem_heap_t *heap;
 
+  /** Buffers that ib_col_set_value() allocated, one per field. A buffer is
+  reused while the new value of the column fits in it. */
+  ib_col_buf_t *col_bufs;
+
   /** Tuple discriminitor. */
   ib_tuple_type_t type;
 
@@ -247,6 +409,13 @@ struct ib_tuple_t {
 
   /** The internal tuple instance */
   DTuple *ptr;
+
+  /** Leaf page that the columns point into if the row was read in
+  zero-copy mode, else nullptr */
+  Buf_block *zc_block;
+
+  /** Modify clock of zc_block when the row was read */
+  uint64_t zc_modify_clock;
 };
 
 using index_def_t = merge_index_def_t;
@@ -258,6 +427,10 @@ srv_active_wake_master_thread after each fetch or search, we only do
 it every INNOBASE_WAKE_INTERVAL'th step. */
 constexpr ulint INNOBASE_WAKE_INTERVAL = 32;
 
+/** ib_tuple_clear() keeps the capacity of a tuple heap that has grown up
+to this size, larger heaps (e.g. after reading a big BLOB) are shrunk. */
+constexpr ulint IB_TUPLE_HEAP_RETAIN_MAX = 1024 * 1024;
+
 /**
  * Does a simple memcmp(3).
  *
@@ -292,9 +465,17 @@ static bool ib_btr_cursor_is_positioned(const Btree_pcursor *pcur) noexcept {
          (pcur->m_pos_state == Btr_pcur_positioned::IS_POSITIONED || pcur->m_pos_state == Btr_pcur_positioned::WAS_POSITIONED);
 }
 
-/** Delays an INSERT, DELETE or UPDATE operation if the purge is lagging. */
-static void ib_delay_dml_if_needed() {
-  if (srv_dml_needed_delay) {
+/**
+ * Delays an INSERT, DELETE or UPDATE operation if the purge is lagging.
+ * Only transactions that add to the history list are delayed: the insert
+ * undo log is freed at commit, a transaction that has only inserted rows
+ * so far creates no work for the purge.
+ *
+ * @param[in] trx               Transaction doing the operation.
+ * @param[in] is_insert         true for an INSERT.
+ */
+static void ib_delay_dml_if_needed(const Trx *trx, bool is_insert) {
+  if (srv_dml_needed_delay > 0 && (!is_insert || trx->m_update_undo != nullptr)) {
     os_thread_sleep(srv_dml_needed_delay);
   }
 }
@@ -312,6 +493,10 @@ static Table *ib_open_table_by_id(ib_id_t tid, bool locked) noexcept {
   auto table_id = tid;
 
   if (!locked) {
+    if (auto table = srv_dict_sys->table_acquire_if_cached(Dict_id{table_id}); table != nullptr) {
+      return table;
+    }
+
     srv_dict_sys->mutex_acquire();
   }
 
@@ -454,15 +639,34 @@ static ulint ib_get_max_row_len(Index *index) {
  *
  * @param[in] rec           Record to read
  * @param[in] tuple         Tuple to read into
+ * @param[in] stream_blobs  true to leave the externally stored columns on
+ *                          their BLOB pages
+ * @param[in] copy_rec      false to point the tuple into rec
+ * @param[in] block         Latched leaf page of rec if it is not copied and
+ *                          is on a page, else nullptr
+ * @param[in] rec_index     Index of rec if it is a secondary index record read
+ *                          into a row tuple, the columns that are not in it are
+ *                          set to SQL NULL, else nullptr
  */
-static void ib_read_tuple(const rec_t *rec, ib_tuple_t *tuple) noexcept {
+static void ib_read_tuple(
+  const rec_t *rec, ib_tuple_t *tuple, bool stream_blobs, bool copy_rec = true, Buf_block *block = nullptr,
+  const Index *rec_index = nullptr
+) noexcept {
   ulint offsets_[REC_OFFS_NORMAL_SIZE];
   ulint *offsets = offsets_;
   DTuple *dtuple = tuple->ptr;
-  const Index *dindex = tuple->index;
+  const Index *dindex = rec_index != nullptr ? rec_index : tuple->index;
 
   rec_offs_init(offsets_);
 
+  ut_ad(rec_index == nullptr || tuple->type == TPL_ROW);
+
+  if (rec_index != nullptr) {
+    for (ulint i{}; i < dtuple_get_n_fields(dtuple); ++i) {
+      dfield_set_null(dtuple_get_nth_field(dtuple, i));
+    }
+  }
+
   {
     Phy_rec record{dindex, rec};
 
@@ -472,9 +676,19 @@ static void ib_read_tuple(const rec_t *rec, ib_tuple_t *tuple) noexcept {
   auto rec_meta_data = rec_get_info_bits(rec);
   dtuple_set_info_bits(dtuple, rec_meta_data);
 
-  /* Make a copy of the rec. */
-  auto ptr = reinterpret_cast<void *>(mem_heap_alloc(tuple->heap, rec_offs_size(offsets)));
-  auto copy = rec_copy(ptr, rec, offsets);
+  const rec_t *copy = rec;
+
+  if (copy_rec) {
+    /* Make a copy of the rec. */
+    auto ptr = reinterpret_cast<void *>(mem_heap_alloc(tuple->heap, rec_offs_size(offsets)));
+    copy = rec_copy(ptr, rec, offsets);
+  }
+
+  tuple->zc_block = block;
+
+  if (block != nullptr) {
+    tuple->zc_modify_clock = buf_block_get_modify_clock(block);
+  }
 
   /* Avoid a debug assertion in rec_offs_validate(). */
   ut_d(rec_offs_make_valid(rec, dindex, (ulint *)offsets));
@@ -489,6 +703,11 @@ static void ib_read_tuple(const rec_t *rec, ib_tuple_t *tuple) noexcept {
       auto col = index_field->get_col();
       auto col_no = col->get_no();
 
+      /* A column prefix is not the value of the column. */
+      if (index_field->m_prefix_len > 0) {
+        continue;
+      }
+
       dfield = dtuple_get_nth_field(dtuple, col_no);
 
     } else {
@@ -498,20 +717,227 @@ static void ib_read_tuple(const rec_t *rec, ib_tuple_t *tuple) noexcept {
     ulint len;
     auto data = rec_get_nth_field(copy, offsets, i, &len);
 
-    /* Fetch and copy any externally stored column. */
-    if (rec_offs_nth_extern(offsets, i)) {
-
+    if (!rec_offs_nth_extern(offsets, i)) {
+      dfield_set_data(dfield, data, len);
+    } else if (stream_blobs) {
+      /* Keep the local part and the field reference of the copy, the rest
+      is read on demand, see ib_col_fetch_extern(). */
+      dfield_set_data(dfield, data, len);
+      dfield_set_ext(dfield);
+    } else {
+      /* Fetch and copy any externally stored column. */
       Blob blob(srv_fsp, srv_btree_sys);
 
       data = blob.copy_externally_stored_field(copy, offsets, i, &len, tuple->heap);
 
       ut_a(len != UNIV_SQL_NULL);
+
+      dfield_set_data(dfield, data, len);
+    }
+  }
+}
+
+/**
+ * Read some of the columns of a clustered index record into a row tuple,
+ * the other columns are set to SQL NULL. Only the externally stored columns
+ * are copied, the tuple points into the record for the others.
+ *
+ * @param[in] rec           Record to read
+ * @param[in] offsets       Column offsets of rec
+ * @param[in,out] tuple     Row tuple to read into
+ * @param[in] fields        Positions of the columns in the index
+ */
+static void ib_read_tuple_fields(const rec_t *rec, const ulint *offsets, ib_tuple_t *tuple, const std::vector<ulint> &fields) noexcept {
+  auto dtuple = tuple->ptr;
+  const auto index = tuple->index;
+
+  ut_ad(tuple->type == TPL_ROW);
+
+  for (ulint i{}; i < dtuple_get_n_fields(dtuple); ++i) {
+    dfield_set_null(dtuple_get_nth_field(dtuple, i));
+  }
+
+  dtuple_set_info_bits(dtuple, rec_get_info_bits(rec));
+
+  for (auto i : fields) {
+    ulint len;
+    auto data = rec_get_nth_field(rec, offsets, i, &len);
+    auto dfield = dtuple_get_nth_field(dtuple, index->get_nth_field(i)->get_col()->get_no());
+
+    if (rec_offs_nth_extern(offsets, i)) {
+      Blob blob(srv_fsp, srv_btree_sys);
+
+      data = blob.copy_externally_stored_field(rec, offsets, i, &len, tuple->heap);
     }
 
     dfield_set_data(dfield, data, len);
   }
 }
 
+/**
+ * Empties column batches, keeping their buffers.
+ *
+ * @param[in,out] cols      Column batches
+ */
+static void ib_col_batch_clear(std::vector<ib_col_batch_t> &cols) noexcept {
+  for (auto &col : cols) {
+    col.data.clear();
+    col.nulls.clear();
+    col.offsets.assign(1, 0);
+  }
+}
+
+/**
+ * Gets the positions in a clustered index of the columns of batches.
+ *
+ * @param[in] index         Clustered index
+ * @param[in] cols          Column batches
+ * @param[out] fields       Positions of the columns in the index
+ *
+ * @return DB_SUCCESS or DB_DATA_MISMATCH if a column doesn't exist
+ */
+static ib_err_t ib_col_batch_fields(const Index *index, const std::vector<ib_col_batch_t> &cols, std::vector<ulint> &fields) noexcept {
+  fields.clear();
+
+  for (const auto &col : cols) {
+    if (col.col >= index->m_table->get_n_cols()) {
+      return DB_DATA_MISMATCH;
+    }
+
+    fields.push_back(index->get_nth_field_pos(col.col));
+  }
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Appends the columns of a clustered index record to column batches.
+ *
+ * @param[in] rec           Record to read
+ * @param[in] offsets       Column offsets of rec
+ * @param[in] index         Index of rec
+ * @param[in] fields        Positions of the columns of the batches in the index
+ * @param[in,out] cols      Column batches, one per field
+ * @param[in,out] heap      Heap for the externally stored columns
+ */
+static void ib_col_batch_append(
+  const rec_t *rec, const ulint *offsets, const Index *index, const std::vector<ulint> &fields, std::vector<ib_col_batch_t> &cols,
+  mem_heap_t *heap
+) noexcept {
+  for (ulint i{}; i < fields.size(); ++i) {
+    ulint len;
+    auto &col = cols[i];
+    const auto field_no = fields[i];
+    const auto row = col.n_rows();
+    auto data = rec_get_nth_field(rec, offsets, field_no, &len);
+
+    if (row % 8 == 0) {
+      col.nulls.push_back(0);
+    }
+
+    if (len == UNIV_SQL_NULL) {
+      col.nulls.back() |= ib_byte_t(1 << (row % 8));
+      col.offsets.push_back(col.data.size());
+      continue;
+    }
+
+    if (rec_offs_nth_extern(offsets, field_no)) {
+      Blob blob(srv_fsp, srv_btree_sys);
+
+      data = blob.copy_externally_stored_field(rec, offsets, field_no, &len, heap);
+    }
+
+    const auto dict_col = index->get_nth_field(field_no)->get_col();
+    const auto pos = col.data.size();
+
+    col.data.resize(pos + len);
+
+    auto dst = &col.data[pos];
+
+    switch (dict_col->mtype) {
+      case DATA_INT:
+        ut_a(len <= sizeof(uint64_t));
+        mach_read_int_type(dst, data, len, dict_col->prtype & DATA_UNSIGNED);
+        break;
+      case DATA_FLOAT:
+        if (len == sizeof(float)) {
+          const auto f = mach_float_read(data);
+          memcpy(dst, &f, sizeof(f));
+        } else {
+          memcpy(dst, data, len);
+        }
+        break;
+      case DATA_DOUBLE:
+        if (len == sizeof(double)) {
+          const auto d = mach_double_read(data);
+          memcpy(dst, &d, sizeof(d));
+        } else {
+          memcpy(dst, data, len);
+        }
+        break;
+      default:
+        memcpy(dst, data, len);
+    }
+
+    col.offsets.push_back(col.data.size());
+  }
+}
+
+/**
+ * Reads the externally stored part of a column that ib_read_tuple() left
+ * on its BLOB pages into the tuple heap.
+ *
+ * @param[in,out] tuple Tuple of the column.
+ * @param[in,out] dfield Column to read.
+ */
+static void ib_col_fetch_extern(ib_tuple_t *tuple, dfield_t *dfield) noexcept {
+  if (dfield_is_ext(dfield)) {
+    ulint len;
+    Blob blob(srv_fsp, srv_btree_sys);
+    const auto data = static_cast<const byte *>(dfield_get_data(dfield));
+
+    auto copy = blob.copy_externally_stored_field(&len, data, dfield_get_len(dfield), tuple->heap);
+
+    dfield_set_data(dfield, copy, len);
+  }
+}
+
+/**
+ * Reads all the columns of a tuple that ib_read_tuple() left on their BLOB
+ * pages, for the functions that use the whole tuple.
+ *
+ * @param[in,out] tuple Tuple to complete.
+ */
+static void ib_tuple_fetch_extern(ib_tuple_t *tuple) noexcept {
+  const auto n_fields = dtuple_get_n_fields(tuple->ptr);
+
+  for (ulint i{}; i < n_fields; ++i) {
+    ib_col_fetch_extern(tuple, dtuple_get_nth_field(tuple->ptr, i));
+  }
+}
+
+/**
+ * Gets the length of a column value, including the part that ib_read_tuple()
+ * left on the BLOB pages.
+ *
+ * @param[in] dfield Column.
+ *
+ * @return the length, or UNIV_SQL_NULL.
+ */
+static ulint ib_col_get_full_len(const dfield_t *dfield) noexcept {
+  const auto len = dfield_get_len(dfield);
+
+  if (!dfield_is_ext(dfield)) {
+    return len;
+  }
+
+  ut_a(len >= BTR_EXTERN_FIELD_REF_SIZE);
+
+  const auto field_ref = static_cast<const byte *>(dfield_get_data(dfield)) + len - BTR_EXTERN_FIELD_REF_SIZE;
+
+  return len - BTR_EXTERN_FIELD_REF_SIZE + mach_read_from_4(field_ref + BTR_EXTERN_LEN + 4);
+}
+
 /**
  * Create an InnoDB key tuple.
  *
@@ -539,6 +965,8 @@ static ib_tpl_t ib_key_tuple_new_low(const Index *index, ulint n_cols, mem_heap_
   }
 
   tuple->ptr = dtuple_create(heap, n_cols);
+  tuple->col_bufs = reinterpret_cast<ib_col_buf_t *>(mem_heap_zalloc(heap, n_cols * sizeof(ib_col_buf_t)));
+  tuple->zc_block = nullptr;
 
   /* Copy types and set to SQL_NULL. */
   index->copy_types(tuple->ptr, n_cols);
@@ -598,6 +1026,8 @@ static ib_tpl_t ib_row_tuple_new_low(const Index *index, ulint n_cols, mem_heap_
   tuple->type = TPL_ROW;
 
   tuple->ptr = dtuple_create(heap, n_cols);
+  tuple->col_bufs = reinterpret_cast<ib_col_buf_t *>(mem_heap_zalloc(heap, n_cols * sizeof(ib_col_buf_t)));
+  tuple->zc_block = nullptr;
 
   /* Copy types and set to SQL_NULL. */
   index->m_table->copy_types(tuple->ptr);
@@ -661,6 +1091,8 @@ ib_err_t ib_shutdown(ib_shutdown_t flag) {
   db_format.id = 0;
   db_format.name = nullptr;
 
+  ib_sql_cache_clear();
+
   return InnoDB::shutdown(flag);
 }
 
@@ -672,6 +1104,11 @@ ib_err_t ib_trx_start(ib_trx_t ib_trx, ib_trx_level_t ib_trx_level) {
   ut_a(ib_trx_level <= IB_TRX_SERIALIZABLE);
 
   if (trx->m_conc_state == TRX_NOT_STARTED) {
+    /* In a read-only instance every transaction is read-only. */
+    if (srv_config.m_read_only) {
+      trx->m_read_only = true;
+    }
+
     auto started = trx->start(ULINT_UNDEFINED);
     ut_a(started);
 
@@ -700,6 +1137,18 @@ ib_trx_t ib_trx_begin(ib_trx_level_t ib_trx_level) {
   return reinterpret_cast<ib_trx_t>(trx);
 }
 
+ib_trx_t ib_trx_begin_read_only(ib_trx_level_t ib_trx_level) {
+  auto trx = srv_trx_sys->create_user_trx(nullptr);
+
+  trx->m_read_only = true;
+
+  auto started = ib_trx_start((ib_trx_t)trx, ib_trx_level);
+
+  ut_a(started == DB_SUCCESS);
+
+  return reinterpret_cast<ib_trx_t>(trx);
+}
+
 ib_trx_state_t ib_trx_state(ib_trx_t ib_trx) {
   auto trx = reinterpret_cast<Trx *>(ib_trx);
 
@@ -712,68 +1161,285 @@ ib_err_t ib_trx_release(ib_trx_t ib_trx) {
   IB_CHECK_PANIC();
 
   ut_ad(trx != nullptr);
+
+  (void) srv_conc->force_exit(trx);
+
+  const auto &profile = trx->m_op_profile;
+
+  if (srv_config.m_slow_op_threshold_us > 0 && profile.m_op_ns / 1000 >= srv_config.m_slow_op_threshold_us) {
+    log_warn(std::format(
+      "Slow transaction: {} us in {} operations, {}, {}", profile.m_op_ns / 1000, profile.m_n_ops,
+      ib_trx_to_log_string(trx->m_id, trx), ib_op_profile_to_string(profile)
+    ));
+  }
+
   srv_trx_sys->destroy_user_trx(trx);
 
   return DB_SUCCESS;
 }
 
-ib_err_t ib_trx_commit(ib_trx_t ib_trx) {
-  auto trx = reinterpret_cast<Trx *>(ib_trx);
+/**
+ * Compares the keys of two deltas byte by byte. This is not the order of the
+ * index but it is the same total order for all the transactions.
+ *
+ * @param[in] lhs The key of a delta.
+ * @param[in] rhs The key of a delta of the same table.
+ *
+ * @return < 0, 0 or > 0 as lhs is less than, equal to or greater than rhs
+ */
+static int ib_delta_key_cmp(const DTuple *lhs, const DTuple *rhs) noexcept {
+  const auto n_fields = dtuple_get_n_fields(lhs);
 
-  IB_CHECK_PANIC();
+  ut_ad(n_fields == dtuple_get_n_fields(rhs));
 
-  auto err = trx->commit();
-  ut_a(err == DB_SUCCESS);
+  for (ulint i{}; i < n_fields; ++i) {
+    const auto a = dtuple_get_nth_field(lhs, i);
+    const auto b = dtuple_get_nth_field(rhs, i);
+    const auto len = dfield_get_len(a);
+
+    if (len != dfield_get_len(b)) {
+      return len < dfield_get_len(b) ? -1 : 1;
+    } else if (auto cmp = memcmp(dfield_get_data(a), dfield_get_data(b), len); cmp != 0) {
+      return cmp;
+    }
+  }
 
-  err = ib_schema_unlock(ib_trx);
-  ut_a(err == DB_SUCCESS || err == DB_SCHEMA_NOT_LOCKED);
+  return 0;
+}
 
-  err = ib_trx_release(ib_trx);
-  ut_a(err == DB_SUCCESS);
+/**
+ * Applies the deltas that the transaction added to commutative columns, see
+ * ib_cursor_add_delta(). The deltas of a column of a row are summed, the rows
+ * are X locked and updated in table id and key order.
+ *
+ * @param[in,out] trx The transaction, its deltas are discarded.
+ *
+ * @return DB_SUCCESS or error code
+ */
+static ib_err_t ib_trx_apply_deltas(Trx *trx) noexcept {
+  if (trx->m_deltas.empty()) {
+    return DB_SUCCESS;
+  }
 
-  ib_wake_master_thread();
+  /* A rollback on a lock wait timeout discards the deltas of the
+  transaction, take them over. */
+  auto deltas = std::move(trx->m_deltas);
+  auto heap = trx->m_delta_heap;
 
-  return DB_SUCCESS;
-}
+  trx->m_deltas.clear();
+  trx->m_delta_heap = nullptr;
 
-ib_err_t ib_trx_rollback(ib_trx_t ib_trx) {
-  auto trx = reinterpret_cast<Trx *>(ib_trx);
+  std::stable_sort(deltas.begin(), deltas.end(), [](const Trx_delta &lhs, const Trx_delta &rhs) {
+    if (lhs.m_table_id != rhs.m_table_id) {
+      return lhs.m_table_id < rhs.m_table_id;
+    } else if (const auto cmp = ib_delta_key_cmp(lhs.m_key, rhs.m_key); cmp != 0) {
+      return cmp < 0;
+    } else {
+      return lhs.m_col_no < rhs.m_col_no;
+    }
+  });
 
-  IB_CHECK_PANIC();
+  ib_err_t err{DB_SUCCESS};
+  ib_crsr_t ib_crsr{};
+  ib_tpl_t ib_key{};
+  const Trx_delta *positioned{};
 
-  auto err = trx_general_rollback(trx, false, nullptr);
+  auto close = [&]() {
+    if (ib_key != nullptr) {
+      ib_tuple_delete(ib_key);
+      ib_key = nullptr;
+    }
 
-  /* It should always succeed */
-  ut_a(err == DB_SUCCESS);
+    if (ib_crsr != nullptr) {
+      auto close_err = ib_cursor_close(ib_crsr);
+      ut_a(close_err == DB_SUCCESS);
+      ib_crsr = nullptr;
+    }
+  };
 
-  err = ib_schema_unlock(ib_trx);
-  ut_a(err == DB_SUCCESS || err == DB_SCHEMA_NOT_LOCKED);
+  for (auto it = deltas.begin(); it != deltas.end() && err == DB_SUCCESS;) {
+    auto delta = it->m_delta;
+    auto next = std::next(it);
 
-  err = ib_trx_release(ib_trx);
-  ut_a(err == DB_SUCCESS);
+    /* Sum the deltas of the same column of the row, while the sum fits. */
+    for (; next != deltas.end() && next->m_table_id == it->m_table_id && next->m_col_no == it->m_col_no &&
+           ib_delta_key_cmp(next->m_key, it->m_key) == 0;
+         ++next) {
+      int64_t sum;
 
-  ib_wake_master_thread();
+      if (__builtin_add_overflow(delta, next->m_delta, &sum)) {
+        break;
+      }
 
-  return err;
-}
+      delta = sum;
+    }
 
-/**
- * Check that the combination of values and name makes sense.
- *
- * @param[in] name The column name.
- * @param[in] ib_col_type The column type.
- * @param[in] ib_col_attr The column attribute.
- * @param[in] len The length of the column.
- * 
- * @return True if the combination is valid, false otherwise.
- */
-static bool ib_check_col_is_ok(const char *name, ib_col_type_t ib_col_type, ib_col_attr_t ib_col_attr, ulint len) {
-  if (strlen(name) > IB_MAX_COL_NAME_LEN) {
-    return false;
-  } else if ((ib_col_type == IB_VARCHAR || ib_col_type == IB_CHAR || ib_col_type == IB_BINARY) && len == 0) {
-    return false;
-  } else if (ib_col_type == IB_INT) {
-    switch (len) {
+    if (positioned == nullptr || positioned->m_table_id != it->m_table_id) {
+      close();
+
+      positioned = nullptr;
+
+      err = ib_cursor_open_table_using_id(it->m_table_id, reinterpret_cast<ib_trx_t>(trx), &ib_crsr);
+
+      if (err == DB_SUCCESS) {
+        err = ib_cursor_set_lock_mode(ib_crsr, IB_LOCK_X);
+      }
+
+      if (err == DB_SUCCESS) {
+        ib_key = ib_clust_search_tuple_create(ib_crsr);
+
+        if (dtuple_get_n_fields(reinterpret_cast<ib_tuple_t *>(ib_key)->ptr) != dtuple_get_n_fields(it->m_key)) {
+          err = DB_DATA_MISMATCH;
+        }
+      }
+    }
+
+    if (err == DB_SUCCESS && (positioned == nullptr || ib_delta_key_cmp(positioned->m_key, it->m_key) != 0)) {
+      auto key = reinterpret_cast<ib_tuple_t *>(ib_key);
+      int result;
+
+      for (ulint i{}; i < dtuple_get_n_fields(it->m_key); ++i) {
+        dfield_copy_data(dtuple_get_nth_field(key->ptr, i), dtuple_get_nth_field(it->m_key, i));
+      }
+
+      err = ib_cursor_moveto(ib_crsr, ib_key, IB_CUR_GE, &result);
+
+      if (err == DB_END_OF_INDEX || (err == DB_SUCCESS && result != 0)) {
+        err = DB_RECORD_NOT_FOUND;
+      }
+
+      positioned = &*it;
+    }
+
+    if (err == DB_SUCCESS) {
+      err = ib_cursor_increment(ib_crsr, it->m_col_no, delta, nullptr);
+    }
+
+    it = next;
+  }
+
+  close();
+
+  if (heap != nullptr) {
+    mem_heap_free(heap);
+  }
+
+  return err;
+}
+
+ib_err_t ib_trx_commit(ib_trx_t ib_trx) {
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  IB_CHECK_PANIC();
+
+  Api_op_timer timer(SRV_OP_TRX_COMMIT, trx);
+
+  if (auto err = ib_trx_apply_deltas(trx); err != DB_SUCCESS) {
+    timer.detach_trx();
+
+    auto rollback_err = ib_trx_rollback(ib_trx);
+    ut_a(rollback_err == DB_SUCCESS);
+
+    return err;
+  }
+
+  auto err = trx->commit();
+  ut_a(err == DB_SUCCESS);
+
+  err = ib_schema_unlock(ib_trx);
+  ut_a(err == DB_SUCCESS || err == DB_SCHEMA_NOT_LOCKED);
+
+  /* The commit is part of the profile of the transaction. */
+  timer.stop();
+
+  err = ib_trx_release(ib_trx);
+  ut_a(err == DB_SUCCESS);
+
+  ib_wake_master_thread();
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_trx_commit_async(ib_trx_t ib_trx, ib_trx_commit_cb_t callback, void *ctx) {
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  IB_CHECK_PANIC();
+
+  ut_a(callback != nullptr);
+
+  if (auto err = ib_trx_apply_deltas(trx); err != DB_SUCCESS) {
+    auto rollback_err = ib_trx_rollback(ib_trx);
+    ut_a(rollback_err == DB_SUCCESS);
+
+    return err;
+  }
+
+  auto err = trx->commit_async([callback, ctx]() { callback(ctx); });
+  ut_a(err == DB_SUCCESS);
+
+  err = ib_schema_unlock(ib_trx);
+  ut_a(err == DB_SUCCESS || err == DB_SCHEMA_NOT_LOCKED);
+
+  err = ib_trx_release(ib_trx);
+  ut_a(err == DB_SUCCESS);
+
+  ib_wake_master_thread();
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_trx_set_nonblocking(ib_trx_t ib_trx, ib_trx_wake_cb_t callback, void *ctx) {
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  IB_CHECK_PANIC();
+
+  if (callback != nullptr) {
+    trx->m_wake = [callback, ctx]() { callback(ctx); };
+  } else {
+    trx->m_wake = nullptr;
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_trx_rollback(ib_trx_t ib_trx) {
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  IB_CHECK_PANIC();
+
+  auto err = trx_general_rollback(trx, false, nullptr);
+
+  /* It should always succeed */
+  ut_a(err == DB_SUCCESS);
+
+  err = ib_schema_unlock(ib_trx);
+  ut_a(err == DB_SUCCESS || err == DB_SCHEMA_NOT_LOCKED);
+
+  err = ib_trx_release(ib_trx);
+  ut_a(err == DB_SUCCESS);
+
+  ib_wake_master_thread();
+
+  return err;
+}
+
+/**
+ * Check that the combination of values and name makes sense.
+ *
+ * @param[in] name The column name.
+ * @param[in] ib_col_type The column type.
+ * @param[in] ib_col_attr The column attribute.
+ * @param[in] len The length of the column.
+ * 
+ * @return True if the combination is valid, false otherwise.
+ */
+static bool ib_check_col_is_ok(const char *name, ib_col_type_t ib_col_type, ib_col_attr_t ib_col_attr, ulint len) {
+  if (strlen(name) > IB_MAX_COL_NAME_LEN) {
+    return false;
+  } else if ((ib_col_type == IB_VARCHAR || ib_col_type == IB_CHAR || ib_col_type == IB_BINARY) && len == 0) {
+    return false;
+  } else if (ib_col_type == IB_INT) {
+    switch (len) {
       case 1:
       case 2:
       case 4:
@@ -786,6 +1452,8 @@ static bool ib_check_col_is_ok(const char *name, ib_col_type_t ib_col_type, ib_c
     return false;
   } else if (ib_col_type == IB_DOUBLE && len != 8) {
     return false;
+  } else if ((ib_col_attr & IB_COL_COMMUTATIVE) && ib_col_type != IB_INT) {
+    return false;
   }
 
   return true;
@@ -841,6 +1509,10 @@ static ulint ib_col_get_prtype(const ib_col_t *ib_col) {
     prtype |= (DATA_CUSTOM_TYPE << 2);
   }
 
+  if (ib_col->ib_col_attr & IB_COL_COMMUTATIVE) {
+    prtype |= DATA_COMMUTATIVE;
+  }
+
   return prtype;
 }
 
@@ -894,6 +1566,20 @@ static const ib_key_col_t *ib_index_find_col(const std::vector<ib_key_col_t *> &
   return nullptr;
 }
 
+ib_err_t ib_table_schema_set_temporary(ib_tbl_sch_t ib_tbl_sch) {
+  auto table_def = (ib_table_def_t *)ib_tbl_sch;
+
+  IB_CHECK_PANIC();
+
+  if (table_def->table != nullptr) {
+    return DB_ERROR;
+  }
+
+  table_def->temporary = true;
+
+  return DB_SUCCESS;
+}
+
 ib_err_t ib_table_schema_add_col(ib_tbl_sch_t ib_tbl_sch, const char *name, ib_col_type_t ib_col_type, ib_col_attr_t ib_col_attr, uint16_t client_type, ulint len) {
   ib_err_t err = DB_SUCCESS;
   ib_table_def_t *table_def = (ib_table_def_t *)ib_tbl_sch;
@@ -1380,6 +2066,10 @@ static ulint ib_table_def_get_flags(const ib_table_def_t *table_def) {
       ut_error;
   }
 
+  if (table_def->temporary) {
+    flags |= DICT_TF2_TEMPORARY << DICT_TF2_SHIFT;
+  }
+
   return flags;
 }
 
@@ -1857,12 +2547,29 @@ static ib_err_t ib_table_get_id_low(const char *table_name, ib_id_t *table_id) n
   return err;
 }
 
+/**
+ * Checks if a transaction is a read-only transaction, see
+ * ib_trx_begin_read_only(). All the transactions of a read-only instance
+ * are read-only.
+ *
+ * @param[in] trx                 Transaction to check.
+ *
+ * @return true if the transaction must not modify data or the schema.
+ */
+static bool ib_trx_is_read_only(const Trx *trx) {
+  return trx != nullptr && trx->m_read_only;
+}
+
 ib_err_t ib_table_create(ib_trx_t ib_trx, const ib_tbl_sch_t ib_tbl_sch, ib_id_t *id) {
   auto ddl_trx = (Trx *)ib_trx;
   const auto table_def = (const ib_table_def_t *)ib_tbl_sch;
 
   IB_CHECK_PANIC();
 
+  if (ib_trx_is_read_only(ddl_trx)) {
+    return DB_READONLY;
+  }
+
   /* Another thread may have created the table already when we get
   here. We need to search the data dictionary before we attempt to
   create the table. */
@@ -1885,6 +2592,12 @@ ib_err_t ib_table_create(ib_trx_t ib_trx, const ib_tbl_sch_t ib_tbl_sch, ib_id_t
     return DB_SCHEMA_ERROR;
   }
 
+  /* In the system tablespace the pages of a temporary table would be
+  recovered like the others. */
+  if (table_def->temporary && !srv_config.m_file_per_table) {
+    return DB_UNSUPPORTED;
+  }
+
   ulint n_cluster{};
 
   /* Check that all index definitions are valid. */
@@ -1952,6 +2665,10 @@ ib_err_t ib_table_rename(ib_trx_t ib_trx, const char *old_name, const char *new_
 
   IB_CHECK_PANIC();
 
+  if (ib_trx_is_read_only(trx)) {
+    return DB_READONLY;
+  }
+
   if (!ib_schema_lock_is_exclusive(ib_trx)) {
     err = ib_schema_lock_exclusive(ib_trx);
 
@@ -2136,7 +2853,9 @@ ib_err_t ib_index_create(ib_idx_sch_t ib_idx_sch, ib_id_t *index_id) {
 
   IB_CHECK_PANIC();
 
-  if (!ib_schema_lock_is_exclusive((ib_trx_t)ib_index_def->usr_trx)) {
+  if (ib_trx_is_read_only(ib_index_def->usr_trx)) {
+    return DB_READONLY;
+  } else if (!ib_schema_lock_is_exclusive((ib_trx_t)ib_index_def->usr_trx)) {
     return DB_SCHEMA_NOT_LOCKED;
   } else if (ib_index_def->clustered) {
     err = ib_create_primary_index(ib_idx_sch, index_id);
@@ -2150,7 +2869,9 @@ ib_err_t ib_index_create(ib_idx_sch_t ib_idx_sch, ib_id_t *index_id) {
 ib_err_t ib_table_drop(ib_trx_t ib_trx, const char *name) {
   IB_CHECK_PANIC();
 
-  if (!ib_schema_lock_is_exclusive(ib_trx)) {
+  if (ib_trx_is_read_only(reinterpret_cast<const Trx *>(ib_trx))) {
+    return DB_READONLY;
+  } else if (!ib_schema_lock_is_exclusive(ib_trx)) {
     return DB_SCHEMA_NOT_LOCKED;
   }
 
@@ -2175,7 +2896,9 @@ ib_err_t ib_index_drop(ib_trx_t ib_trx, ib_id_t index_id) {
 
   IB_CHECK_PANIC();
 
-  if (!ib_schema_lock_is_exclusive(ib_trx)) {
+  if (ib_trx_is_read_only(reinterpret_cast<const Trx *>(ib_trx))) {
+    return DB_READONLY;
+  } else if (!ib_schema_lock_is_exclusive(ib_trx)) {
     return DB_SCHEMA_NOT_LOCKED;
   }
 
@@ -2229,14 +2952,6 @@ static ib_err_t ib_create_cursor(ib_crsr_t *ib_crsr, Table *table, ib_id_t index
 
   cursor->heap = heap;
 
-  cursor->query_heap = mem_heap_create(64);
-
-  if (cursor->query_heap == nullptr) {
-    mem_heap_free(heap);
-
-    return DB_OUT_OF_MEMORY;
-  }
-
   cursor->prebuilt = Prebuilt::create(srv_fsp, srv_btree_sys, table);
 
   auto prebuilt = cursor->prebuilt;
@@ -2417,13 +3132,100 @@ ib_err_t ib_cursor_open_table(const char *name, ib_trx_t ib_trx, ib_crsr_t *ib_c
 }
 
 /**
- * Free a context struct for a table handle.
+ * Releases the leaf page that the last row read in zero-copy mode points
+ * into, the columns of that row must not be used after this.
+ *
+ * @param[in,out] cursor Cursor that read the row
+ */
+static void ib_cursor_release_row(ib_cursor_t *cursor) noexcept {
+  if (cursor->row_mtr != nullptr && cursor->row_mtr->is_active()) {
+    cursor->row_mtr->commit();
+  }
+}
+
+/**
+ * Binds the query graphs of a cursor to a transaction.
+ *
+ * @param[in,out] q_proc Query graphs of the cursor
+ * @param[in] trx Transaction, or nullptr when the cursor is reset
+ */
+static void ib_qry_proc_set_trx(ib_qry_proc_t *q_proc, Trx *trx) noexcept {
+  for (auto graph : {q_proc->grph.ins, q_proc->grph.upd, q_proc->grph.sel}) {
+    if (graph != nullptr) {
+      graph->trx = trx;
+    }
+  }
+}
+
+/**
+ * Takes a query graph from the graph cache of a table.
+ *
+ * @param[in,out] table Table of the cursor
+ * @param[in,out] graphs The cached insert or update graphs of the table
+ * @param[out] version Version of the graph cache, the graph that the cursor
+ *  uses is returned with it
+ *
+ * @return a graph, or nullptr if the cursor must build one
+ */
+static que_fork_t *ib_qry_graph_checkout(Table *table, std::vector<que_fork_t *> *graphs, uint64_t *version) noexcept {
+  auto cache = &table->m_graph_cache;
+  std::lock_guard<std::mutex> lock(cache->m_mutex);
+
+  *version = cache->m_version;
+
+  if (graphs->empty()) {
+    return nullptr;
+  }
+
+  auto graph = graphs->back();
+
+  graphs->pop_back();
+
+  return graph;
+}
+
+/**
+ * Returns a query graph to the graph cache of a table, frees it if the
+ * indexes of the table changed since it was checked out or the cache is full.
+ *
+ * @param[in,out] table Table of the cursor
+ * @param[in,out] graphs The cached insert or update graphs of the table
+ * @param[in] graph Graph to return, or nullptr
+ * @param[in] version Version of the graph cache at checkout
+ */
+static void ib_qry_graph_checkin(Table *table, std::vector<que_fork_t *> *graphs, que_fork_t *graph, uint64_t version) noexcept {
+  if (graph == nullptr) {
+    return;
+  }
+
+  graph->trx = nullptr;
+
+  {
+    auto cache = &table->m_graph_cache;
+    std::lock_guard<std::mutex> lock(cache->m_mutex);
+
+    if (version == cache->m_version && graphs->size() < Table::Graph_cache::MAX_GRAPHS) {
+      graphs->push_back(graph);
+      return;
+    }
+  }
+
+  que_graph_free(graph);
+}
+
+/**
+ * Free a context struct for a table handle. The insert and update graphs
+ * are returned to the graph cache of the table.
  *
- * @param[in] q_proc in, own: qproc struct
+ * @param[in,out] q_proc in, own: qproc struct
+ * @param[in,out] table in: table of the cursor
  */
-static void ib_qry_proc_free(ib_qry_proc_t *q_proc) {
-  que_graph_free_recursive(q_proc->grph.ins);
-  que_graph_free_recursive(q_proc->grph.upd);
+static void ib_qry_proc_free(ib_qry_proc_t *q_proc, Table *table) noexcept {
+  auto cache = &table->m_graph_cache;
+
+  ib_qry_graph_checkin(table, &cache->m_ins, q_proc->grph.ins, q_proc->grph.ins_version);
+  ib_qry_graph_checkin(table, &cache->m_upd, q_proc->grph.upd, q_proc->grph.upd_version);
+
   que_graph_free_recursive(q_proc->grph.sel);
 
   memset(q_proc, 0x0, sizeof(*q_proc));
@@ -2440,17 +3242,31 @@ ib_err_t ib_cursor_reset(ib_crsr_t ib_crsr) {
     --prebuilt->m_trx->m_n_client_tables_in_use;
   }
 
-  /* The fields in this data structure are allocated from
-  the query heap and so need to be reset too. */
-  ib_qry_proc_free(&cursor->q_proc);
+  ib_cursor_release_row(cursor);
 
-  mem_heap_empty(cursor->query_heap);
+  /* Keep the query graphs, ib_cursor_attach_trx() binds them to the
+  next transaction. */
+  ib_qry_proc_set_trx(&cursor->q_proc, nullptr);
 
   prebuilt->clear();
 
   return DB_SUCCESS;
 }
 
+/**
+ * Frees the bulk load state of a cursor.
+ *
+ * @param[in,out] cursor in/out: cursor with a bulk load in progress
+ */
+static void ib_cursor_bulk_free(ib_cursor_t *cursor) noexcept {
+  call_destructor(cursor->bulk);
+  ut_delete(cursor->bulk);
+  cursor->bulk = nullptr;
+
+  mem_heap_free(cursor->bulk_heap);
+  cursor->bulk_heap = nullptr;
+}
+
 ib_err_t ib_cursor_close(ib_crsr_t ib_crsr) {
   ib_cursor_t *cursor = (ib_cursor_t *)ib_crsr;
   Prebuilt *prebuilt = cursor->prebuilt;
@@ -2458,7 +3274,16 @@ ib_err_t ib_cursor_close(ib_crsr_t ib_crsr) {
 
   IB_CHECK_PANIC();
 
-  ib_qry_proc_free(&cursor->q_proc);
+  if (cursor->row_mtr != nullptr) {
+    ib_cursor_release_row(cursor);
+    call_destructor(cursor->row_mtr);
+  }
+
+  ib_qry_proc_free(&cursor->q_proc, prebuilt->m_table);
+
+  if (cursor->bulk != nullptr) {
+    ib_cursor_bulk_free(cursor);
+  }
 
   /* The transaction could have been detached from the cursor. */
   if (trx != nullptr && trx->m_n_client_tables_in_use > 0) {
@@ -2471,7 +3296,6 @@ ib_err_t ib_cursor_close(ib_crsr_t ib_crsr) {
     Prebuilt::destroy(srv_dict_sys, cursor->prebuilt, false);
   }
 
-  mem_heap_free(cursor->query_heap);
   mem_heap_free(cursor->heap);
 
   return DB_SUCCESS;
@@ -2524,10 +3348,13 @@ static ib_err_t ib_insert_row_with_lock_retry(que_thr_t *thr, ins_node_t *node,
  * @return DB_SUCCESS or err code
  */
 static ib_err_t ib_execute_insert_query_graph(Table *table, que_fork_t *ins_graph, ins_node_t *node) noexcept {
+  auto trx = ins_graph->trx;
+
+  Srv_conc_guard conc_guard(trx);
+
   /* This is a short term solution to fix the purge lag. */
-  ib_delay_dml_if_needed();
+  ib_delay_dml_if_needed(trx, true);
 
-  auto trx = ins_graph->trx;
   auto savept = trx_savept_take(trx);
   auto thr = que_fork_get_first_thr(ins_graph);
 
@@ -2540,7 +3367,7 @@ static ib_err_t ib_execute_insert_query_graph(Table *table, que_fork_t *ins_grap
 
     ++table->m_stats.m_n_rows;
 
-    srv_n_rows_inserted++;
+    srv_n_rows_inserted.inc();
 
     ib_update_statistics_if_needed(table);
 
@@ -2553,7 +3380,26 @@ static ib_err_t ib_execute_insert_query_graph(Table *table, que_fork_t *ins_grap
 }
 
 /**
- * Create an insert query graph node.
+ * Loads the foreign key constraints of the table of a cursor before it's
+ * changed the first time, only DML needs them.
+ *
+ * @param[in,out] cursor Cursor that is about to change the table.
+ */
+static void ib_cursor_load_foreigns(ib_cursor_t *cursor) noexcept {
+  auto table = cursor->prebuilt->m_table;
+
+  if (!table->m_foreigns_loaded.load(std::memory_order_acquire)) {
+    srv_dict_sys->mutex_acquire();
+
+    (void) srv_dict_sys->table_load_foreigns(table);
+
+    srv_dict_sys->mutex_release();
+  }
+}
+
+/**
+ * Create an insert query graph node, or check one out from the graph cache
+ * of the table. The graph owns its heap, it outlives the cursor.
  *
  * @param[in] cursor in: Cursor instance
  */
@@ -2564,11 +3410,22 @@ static void ib_insert_query_graph_create(ib_cursor_t *cursor) noexcept {
 
   ut_a(trx->m_conc_state != TRX_NOT_STARTED);
 
+  ib_cursor_load_foreigns(cursor);
+
   if (node->ins == nullptr) {
     auto grph = &q_proc->grph;
-    auto heap = cursor->query_heap;
     auto table = cursor->prebuilt->m_table;
 
+    grph->ins = ib_qry_graph_checkout(table, &table->m_graph_cache.m_ins, &grph->ins_version);
+
+    if (grph->ins != nullptr) {
+      grph->ins->trx = trx;
+      node->ins = static_cast<ins_node_t *>(que_fork_get_first_thr(grph->ins)->child);
+      return;
+    }
+
+    auto heap = mem_heap_create(1024);
+
     node->ins = srv_row_ins->node_create(INS_DIRECT, table, heap);
 
     node->ins->m_select = nullptr;
@@ -2582,33 +3439,28 @@ static void ib_insert_query_graph_create(ib_cursor_t *cursor) noexcept {
     grph->ins = static_cast<que_fork_t *>(que_node_get_parent(pars_complete_graph_for_exec(node->ins, trx, heap)));
 
     grph->ins->state = QUE_FORK_ACTIVE;
+  } else {
+    q_proc->grph.ins->trx = trx;
   }
 }
 
-ib_err_t ib_cursor_insert_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_tpl) {
-  ulint n_fields;
-  ib_qry_node_t *node;
-  ib_qry_proc_t *q_proc;
-  DTuple *dst_dtuple;
-  ib_err_t err = DB_SUCCESS;
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
-  const auto src_tuple = reinterpret_cast<const ib_tuple_t *>(ib_tpl);
-
-  IB_CHECK_PANIC();
-
-  ib_insert_query_graph_create(cursor);
-
-  ut_ad(src_tuple->type == TPL_ROW);
-
-  q_proc = &cursor->q_proc;
-  node = &q_proc->node;
-
-  node->ins->m_state = INS_NODE_ALLOC_ROW_ID;
-  dst_dtuple = node->ins->m_row;
+/**
+ * Copy the columns of a row to the insert node, checking the NOT NULL
+ * constraints.
+ *
+ * @param[in,out] node in: insert node
+ * @param[in] src_tuple in: row to insert
+ *
+ * @return DB_SUCCESS or DB_DATA_MISMATCH
+ */
+static ib_err_t ib_insert_row_set_vals(ins_node_t *node, const ib_tuple_t *src_tuple) noexcept {
+  auto dst_dtuple = node->m_row;
+  const auto n_fields = dtuple_get_n_fields(src_tuple->ptr);
 
-  n_fields = dtuple_get_n_fields(src_tuple->ptr);
   ut_ad(n_fields == dtuple_get_n_fields(dst_dtuple));
 
+  node->m_state = INS_NODE_ALLOC_ROW_ID;
+
   /* Do a shallow copy of the data fields and check for nullptr
   constraints on columns. */
   for (ulint i = 0; i < n_fields; ++i) {
@@ -2621,8 +3473,7 @@ ib_err_t ib_cursor_insert_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_tpl) {
 
       if ((prtype & DATA_NOT_NULL) && dfield_is_null(src_field)) {
 
-        err = DB_DATA_MISMATCH;
-        break;
+        return DB_DATA_MISMATCH;
       }
 
       auto dst_field = dtuple_get_nth_field(dst_dtuple, i);
@@ -2636,523 +3487,1914 @@ ib_err_t ib_cursor_insert_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_tpl) {
     }
   }
 
-  if (err == DB_SUCCESS) {
-    err = ib_execute_insert_query_graph(src_tuple->index->m_table, q_proc->grph.ins, node->ins);
-  }
+  return DB_SUCCESS;
+}
 
-  return err;
+/**
+ * Checks if the transaction of a cursor is a read-only transaction, see
+ * ib_trx_begin_read_only().
+ *
+ * @param[in] cursor              Cursor to check.
+ *
+ * @return true if the cursor's transaction must not modify data.
+ */
+static bool ib_cursor_trx_is_read_only(const ib_cursor_t *cursor) {
+  return ib_trx_is_read_only(cursor->prebuilt->m_trx);
 }
 
 /**
- * Gets pointer to a prebuilt update vector used in updates.
+ * Starts reading the first page that a search of an index for a key would
+ * wait for, if the transaction is non-blocking. The callback of the
+ * transaction is invoked once the page has been read.
  *
- * @param[in] cursor in: current cursor
+ * @param[in] trx in: transaction of the search
+ * @param[in] index in: index to search
+ * @param[in] tuple in: search key
  *
- * @return update vector
+ * @return DB_WOULD_BLOCK if the search has to wait for a page, else DB_SUCCESS
  */
-static upd_t *ib_update_vector_create(ib_cursor_t *cursor) {
-  auto trx = cursor->prebuilt->m_trx;
-  auto heap = cursor->query_heap;
-  auto table = cursor->prebuilt->m_table;
-  auto q_proc = &cursor->q_proc;
-  auto grph = &q_proc->grph;
-  auto node = &q_proc->node;
+static ib_err_t ib_search_would_block(Trx *trx, const Index *index, const DTuple *tuple) noexcept {
+  if (!trx->m_wake || dtuple_get_n_fields(tuple) == 0) {
+    return DB_SUCCESS;
+  }
 
-  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+  page_no_t page_no;
+  const auto space = index->get_space_id();
+  Btree_cursor btr_cur(srv_fsp, srv_btree_sys);
 
-  if (node->upd == nullptr) {
-    node->upd = srv_row_upd->create_update_node(table, heap);
+  /* If the tree changes under the descent we don't know the leaf, the
+  search may then have to wait. */
+  const auto leaf_page_no = btr_cur.get_leaf_page_no(index, tuple, Current_location(), &page_no);
+
+  if (page_no == FIL_NULL && leaf_page_no != FIL_NULL && !srv_buf_pool->is_readable(space, leaf_page_no)) {
+    page_no = leaf_page_no;
   }
 
-  grph->upd = static_cast<que_fork_t *>(que_node_get_parent(pars_complete_graph_for_exec(node->upd, trx, heap)));
+  if (page_no == FIL_NULL) {
+    return DB_SUCCESS;
+  }
 
-  grph->upd->state = QUE_FORK_ACTIVE;
+  buf_read_page_async(space, page_no, trx->m_wake);
 
-  return node->upd->m_update;
+  return DB_WOULD_BLOCK;
 }
 
 /**
- * Note that a column has changed.
+ * Checks if the insert of a row would wait for the read of a clustered index
+ * page, see ib_search_would_block(). The secondary index pages are not checked.
  *
- * @param[in] cursor in: current cursor
- * @param[in/out] upd_field in/out: update field
- * @param[in] col_no in: column number
- * @param[in] dfield in: updated dfield
+ * @param[in] cursor in: cursor of the table
+ * @param[in] src_tuple in: row to insert
+ *
+ * @return DB_WOULD_BLOCK if the insert has to wait for a page, else DB_SUCCESS
  */
-static void ib_update_col(ib_cursor_t *cursor, upd_field_t *upd_field, ulint col_no, dfield_t *dfield) {
-  auto table = cursor->prebuilt->m_table;
-  auto index = table->get_first_index();
-
-  auto data_len = dfield_get_len(dfield);
+static ib_err_t ib_insert_would_block(const ib_cursor_t *cursor, const ib_tuple_t *src_tuple) noexcept {
+  auto trx = cursor->prebuilt->m_trx;
+  const auto clust_index = cursor->prebuilt->m_table->get_clustered_index();
 
-  if (data_len == UNIV_SQL_NULL) {
-    dfield_set_null(&upd_field->m_new_val);
-  } else {
-    dfield_copy_data(&upd_field->m_new_val, dfield);
+  /* The key of a generated clustered index is only known when the row id is assigned. */
+  if (!trx->m_wake || !clust_index->is_unique()) {
+    return DB_SUCCESS;
   }
 
-  upd_field->m_exp = nullptr;
+  auto heap = mem_heap_create(256);
+  auto entry = row_build_index_entry(src_tuple->ptr, nullptr, clust_index, heap);
+  auto err = ib_search_would_block(trx, clust_index, entry);
 
-  upd_field->m_orig_len = 0;
+  mem_heap_free(heap);
 
-  upd_field->m_field_no = index->get_clustered_field_pos(&table->m_cols[col_no]);
+  return err;
 }
 
-/**
- * Checks which fields have changed in a row and stores the new data
- * to an update vector.
- *
- * @param[in] cursor in: current cursor
- * @param[in/out] upd in/out: update vector
- * @param[in] old_tuple in: Old tuple in table
- * @param[in] new_tuple in: New tuple to update
- *
- * @return DB_SUCCESS or err code
- */
-static ib_err_t ib_calc_diff(ib_cursor_t *cursor, upd_t *upd, const ib_tuple_t *old_tuple, const ib_tuple_t *new_tuple) noexcept {
-  ulint n_changed = 0;
-  ib_err_t err = DB_SUCCESS;
-  const auto n_fields = dtuple_get_n_fields(new_tuple->ptr);
+ib_err_t ib_cursor_insert_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_tpl) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  const auto src_tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
 
-  ut_a(old_tuple->type == TPL_ROW);
-  ut_a(new_tuple->type == TPL_ROW);
-  ut_a(old_tuple->index->m_table == new_tuple->index->m_table);
+  IB_CHECK_PANIC();
 
-  for (ulint i = 0; i < n_fields; ++i) {
-    auto new_dfield = dtuple_get_nth_field(new_tuple->ptr, i);
-    auto old_dfield = dtuple_get_nth_field(old_tuple->ptr, i);
+  Api_op_timer timer(SRV_OP_CURSOR_INSERT, cursor->prebuilt->m_trx);
 
-    auto mtype = dtype_get_mtype(dfield_get_type(old_dfield));
-    auto prtype = dtype_get_prtype(dfield_get_type(old_dfield));
+  ib_cursor_release_row(cursor);
 
-    /* Skip the system columns */
-    if (mtype == DATA_SYS) {
-      continue;
+  if (ib_cursor_trx_is_read_only(cursor)) {
+    return DB_READONLY;
+  }
 
-    } else if ((prtype & DATA_NOT_NULL) && dfield_is_null(new_dfield)) {
+  ib_tuple_fetch_extern(src_tuple);
 
-      err = DB_DATA_MISMATCH;
-      break;
-    }
+  auto err = ib_insert_would_block(cursor, src_tuple);
 
-    if (dfield_get_len(new_dfield) != dfield_get_len(old_dfield) ||
-        (!dfield_is_null(old_dfield) &&
-         memcmp(dfield_get_data(new_dfield), dfield_get_data(old_dfield), dfield_get_len(old_dfield)) != 0)) {
+  if (err != DB_SUCCESS) {
+    return err;
+  }
 
-      auto upd_field = &upd->m_fields[n_changed];
+  ib_insert_query_graph_create(cursor);
 
-      ib_update_col(cursor, upd_field, i, new_dfield);
+  ut_ad(src_tuple->type == TPL_ROW);
 
-      ++n_changed;
-    }
-  }
+  auto q_proc = &cursor->q_proc;
+  auto node = q_proc->node.ins;
+
+  err = ib_insert_row_set_vals(node, src_tuple);
 
   if (err == DB_SUCCESS) {
-    upd->m_info_bits = 0;
-    upd->m_n_fields = n_changed;
+    err = ib_execute_insert_query_graph(src_tuple->index->m_table, q_proc->grph.ins, node);
   }
 
   return err;
 }
 
 /**
- * Run the update query and do error handling.
+ * Compare the clustered index keys of two rows.
  *
- * @param[in] thr in: Update query graph
- * @param[in] node in: Update node for the query
- * @param[in] savept in: savepoint to rollback to in case of an error
+ * @param[in] index in: clustered index
+ * @param[in] a in: row
+ * @param[in] b in: row
  *
- * @return DB_SUCCESS or error code
+ * @return < 0, 0 or > 0 as a is less than, equal to or greater than b
  */
-static ib_err_t ib_update_row_with_lock_retry(que_thr_t *thr, upd_node_t *node, trx_savept_t *savept) noexcept {
-  ib_err_t err;
-  bool lock_wait;
-
-  auto trx = thr_get_trx(thr);
-
-  do {
-    thr->run_node = node;
-    thr->prev_node = node;
+static int ib_tuple_cmp_clust_key(const Index *index, const ib_tuple_t *a, const ib_tuple_t *b) noexcept {
+  const auto n_uniq = index->get_n_unique();
 
-    (void) srv_row_upd->step(thr);
+  for (ulint i{}; i < n_uniq; ++i) {
+    const auto col_no = index->get_nth_field(i)->get_col()->get_no();
+    const auto cmp = cmp_dfield_dfield(index->m_cmp_ctx, dtuple_get_nth_field(a->ptr, col_no), dtuple_get_nth_field(b->ptr, col_no));
 
-    err = trx->m_error_state;
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
 
-    if (err != DB_SUCCESS) {
-      que_thr_stop_client(thr);
+  return 0;
+}
 
-      if (err != DB_RECORD_NOT_FOUND) {
-        thr->lock_state = QUE_THR_LOCK_ROW;
+ib_err_t ib_cursor_insert_rows(ib_crsr_t ib_crsr, const ib_tpl_t *ib_tpls, ulint n_rows, bool sorted, ib_err_t *errs) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  const auto table = cursor->prebuilt->m_table;
+  const auto clust_index = table->get_clustered_index();
 
-        lock_wait = ib_handle_errors(&err, trx, thr, savept);
+  IB_CHECK_PANIC();
 
-        thr->lock_state = QUE_THR_LOCK_NOLOCK;
-      } else {
-        lock_wait = false;
-      }
-    } else {
-      lock_wait = false;
-    }
-  } while (lock_wait);
+  ib_cursor_release_row(cursor);
 
-  return err;
-}
+  if (ib_cursor_trx_is_read_only(cursor)) {
+    return DB_READONLY;
+  }
 
-/**
- * Does an update or delete of a row.
- *
- * @param[in] cursor in: Cursor instance
- * @param[in] pcur in: Btree persistent cursor
- *
- * @return DB_SUCCESS or err code
- */
-static ib_err_t ib_execute_update_query_graph(ib_cursor_t *cursor, Btree_pcursor *pcur) noexcept {
-  auto trx = cursor->prebuilt->m_trx;
-  auto table = cursor->prebuilt->m_table;
-  auto q_proc = &cursor->q_proc;
+  if (n_rows == 0) {
+    return DB_SUCCESS;
+  }
 
-  /* The transaction must be running. */
-  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+  ib_insert_query_graph_create(cursor);
 
-  auto node = q_proc->node.upd;
+  std::vector<ulint> order(n_rows);
 
-  /* This is a short term solution to fix the purge lag. */
-  ib_delay_dml_if_needed();
+  for (ulint i{}; i < n_rows; ++i) {
+    order[i] = i;
+  }
 
-  ut_a(pcur->get_index()->is_clustered());
-  node->m_pcur->copy_stored_position(pcur);
+  /* Without a user defined key the rows go in row id order anyway. */
+  if (!sorted && clust_index->is_unique()) {
+    std::stable_sort(order.begin(), order.end(), [&](ulint a, ulint b) {
+      return ib_tuple_cmp_clust_key(
+        clust_index, reinterpret_cast<const ib_tuple_t *>(ib_tpls[a]), reinterpret_cast<const ib_tuple_t *>(ib_tpls[b])) < 0;
+    });
+  }
 
-  ut_a(node->m_pcur->get_rel_pos() == Btree_cursor_pos::ON);
+  auto q_proc = &cursor->q_proc;
+  auto node = q_proc->node.ins;
 
-  auto savept = trx_savept_take(trx);
+  /* The rows are in key order: each one first tries the clustered index
+  leaf page of the previous one, the tree is only searched on a new page. */
+  Btree_leaf_guess guess;
 
-  auto thr = que_fork_get_first_thr(q_proc->grph.upd);
+  node->m_clust_guess = &guess;
 
-  node->m_state = UPD_NODE_UPDATE_CLUSTERED;
+  /* Rows that reference the same parent row look it up only once. */
+  Foreign_key_cache fk_cache;
 
-  que_thr_move_to_run_state(thr);
+  if (!table->m_foreign_list.empty()) {
+    node->m_fk_cache = &fk_cache;
+  }
 
-  auto err = ib_update_row_with_lock_retry(thr, node, &savept);
+  ulint i{};
+  ib_err_t err{DB_SUCCESS};
 
-  if (err == DB_SUCCESS) {
+  for (; i < n_rows; ++i) {
+    auto src_tuple = reinterpret_cast<ib_tuple_t *>(ib_tpls[order[i]]);
 
-    que_thr_stop_for_client_no_error(thr, trx);
+    ut_ad(src_tuple->type == TPL_ROW);
 
-    if (node->m_is_delete) {
+    ib_tuple_fetch_extern(src_tuple);
 
-      if (table->m_stats.m_n_rows > 0) {
-        --table->m_stats.m_n_rows;
-      }
+    auto row_err = ib_insert_row_set_vals(node, src_tuple);
 
-      ++srv_n_rows_deleted;
-    } else {
-      ++srv_n_rows_updated;
+    if (row_err == DB_SUCCESS) {
+      row_err = ib_execute_insert_query_graph(table, q_proc->grph.ins, node);
     }
 
-    ib_update_statistics_if_needed(table);
+    errs[order[i]] = row_err;
 
-  } else if (err == DB_RECORD_NOT_FOUND) {
-    trx->m_error_state = DB_SUCCESS;
+    if (row_err == DB_DUPLICATE_KEY || row_err == DB_DATA_MISMATCH) {
+      /* Only this row was rolled back, carry on with the others. */
+      if (err == DB_SUCCESS) {
+        err = row_err;
+      }
+    } else if (row_err != DB_SUCCESS) {
+      err = row_err;
+      break;
+    }
   }
 
-  ib_wake_master_thread();
+  node->m_clust_guess = nullptr;
+  node->m_fk_cache = nullptr;
 
-  trx->m_op_info = "";
+  /* The rows that were not tried. */
+  while (++i < n_rows) {
+    errs[order[i]] = err;
+  }
 
   return err;
 }
 
-ib_err_t ib_cursor_update_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_old_tpl, const ib_tpl_t ib_new_tpl) {
+ib_err_t ib_cursor_bulk_load_begin(ib_crsr_t ib_crsr) {
   auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
   auto prebuilt = cursor->prebuilt;
-  const auto old_tuple = reinterpret_cast<const ib_tuple_t *>(ib_old_tpl);
-  const auto new_tuple = reinterpret_cast<const ib_tuple_t *>(ib_new_tpl);
+  auto trx = prebuilt->m_trx;
+  auto table = prebuilt->m_table;
 
   IB_CHECK_PANIC();
 
-  Btree_pcursor *pcur;
+  ib_cursor_release_row(cursor);
 
-  if (prebuilt->m_index->is_clustered()) {
-    pcur = prebuilt->m_pcur;
-  } else if (prebuilt->m_need_to_access_clustered && prebuilt->m_clust_pcur != nullptr) {
-    pcur = prebuilt->m_clust_pcur;
-  } else {
+  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+
+  if (cursor->bulk != nullptr) {
     return DB_ERROR;
   }
 
-  ut_a(old_tuple->type == TPL_ROW);
-  ut_a(new_tuple->type == TPL_ROW);
+  /* Nobody else can see the rows until the transaction commits. */
+  auto err = ib_trx_lock_table_with_retry(trx, table, LOCK_X);
 
-  auto upd = ib_update_vector_create(cursor);
-  auto err = ib_calc_diff(cursor, upd, old_tuple, new_tuple);
+  if (err != DB_SUCCESS) {
+    return err;
+  }
 
-  if (err == DB_SUCCESS) {
-    /* Note that this is not a delete. */
-    cursor->q_proc.node.upd->m_is_delete = false;
+  auto clust_index = table->get_clustered_index();
 
-    err = ib_execute_update_query_graph(cursor, pcur);
+  {
+    mtr_t mtr;
+
+    mtr.start();
+
+    mtr_s_lock(clust_index->get_lock(), &mtr);
+
+    const auto root = srv_btree_sys->root_get(clust_index->m_page_id, &mtr);
+    const auto is_empty = page_is_leaf(root) && page_get_n_recs(root) == 0;
+
+    mtr.commit();
+
+    if (!is_empty) {
+      return DB_INVALID_INPUT;
+    }
   }
 
-  return err;
+  auto ptr = ut_new(sizeof(Btree_bulk));
+
+  /* The table stays empty if we crash before the root is written, the
+  pages below it need no redo. */
+  cursor->bulk = new (ptr) Btree_bulk(srv_btree_sys, clust_index, trx->m_id, false);
+  cursor->bulk_heap = mem_heap_create(1024);
+
+  return DB_SUCCESS;
 }
 
-/**
- * Build the update query graph to delete a row from an index.
- *
- * @param[in] cursor in: current cursor
- * @param[in] pcur in: Btree persistent cursor
- * @param[in] rec in: record to delete
- *
- * @return DB_SUCCESS or err code
- */
-static ib_err_t ib_delete_row(ib_cursor_t *cursor, Btree_pcursor *pcur, const rec_t *rec) {
-  auto table = cursor->prebuilt->m_table;
-  auto index = table->get_first_index();
+ib_err_t ib_cursor_bulk_load_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_tpl) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  const auto src_tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
 
   IB_CHECK_PANIC();
 
-  auto n_cols = index->get_n_ordering_defined_by_user();
-  auto ib_tpl = ib_key_tuple_new(index, n_cols);
+  ut_ad(src_tuple->type == TPL_ROW);
 
-  if (ib_tpl == nullptr) {
-    return DB_OUT_OF_MEMORY;
+  if (cursor->bulk == nullptr) {
+    return DB_ERROR;
   }
 
-  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
-  auto upd = ib_update_vector_create(cursor);
+  ib_tuple_fetch_extern(src_tuple);
 
-  ib_read_tuple(rec, tuple);
-
-  upd->m_n_fields = ib_tuple_get_n_cols(ib_tpl);
+  auto heap = cursor->bulk_heap;
+  auto table = cursor->prebuilt->m_table;
+  auto clust_index = table->get_clustered_index();
 
-  for (ulint i{}; i < upd->m_n_fields; ++i) {
-    auto upd_field = &upd->m_fields[i];
-    auto dfield = dtuple_get_nth_field(tuple->ptr, i);
+  /* Shallow copy, the system columns are set below. */
+  auto row = dtuple_copy(src_tuple->ptr, heap);
+  const auto n_fields = dtuple_get_n_fields(row);
 
-    dfield_copy_data(&upd_field->m_new_val, dfield);
+  for (ulint i = 0; i < n_fields; ++i) {
+    auto field = dtuple_get_nth_field(row, i);
 
-    upd_field->m_exp = nullptr;
+    if (dtype_get_mtype(dfield_get_type(field)) != DATA_SYS &&
+        (dtype_get_prtype(dfield_get_type(field)) & DATA_NOT_NULL) &&
+        dfield_is_null(field)) {
 
-    upd_field->m_orig_len = 0;
+      return DB_DATA_MISMATCH;
+    }
+  }
 
-    upd->m_info_bits = 0;
+  auto row_id = mem_heap_zalloc(heap, DATA_ROW_ID_LEN);
 
-    upd_field->m_field_no = index->get_clustered_field_pos(&table->m_cols[i]);
+  /* No row id is stored if the clustered index is unique */
+  if (!clust_index->is_unique()) {
+    srv_dict_sys->m_store.sys_write_row_id(row_id, srv_dict_sys->m_store.sys_get_new_row_id());
+  }
+
+  dfield_set_data(dtuple_get_nth_field(row, table->get_sys_col(DATA_ROW_ID)->get_no()), row_id, DATA_ROW_ID_LEN);
+
+  auto trx_id = mem_heap_alloc(heap, DATA_TRX_ID_LEN);
+
+  Trx_sys::write_trx_id(trx_id, cursor->prebuilt->m_trx->m_id);
+  dfield_set_data(dtuple_get_nth_field(row, table->get_sys_col(DATA_TRX_ID)->get_no()), trx_id, DATA_TRX_ID_LEN);
+
+  /* Btree_bulk::insert() writes the roll pointer. */
+  auto roll_ptr = mem_heap_zalloc(heap, DATA_ROLL_PTR_LEN);
+
+  dfield_set_data(dtuple_get_nth_field(row, table->get_sys_col(DATA_ROLL_PTR)->get_no()), roll_ptr, DATA_ROLL_PTR_LEN);
+
+  auto entry = row_build_index_entry(row, nullptr, clust_index, heap);
+
+  auto err = cursor->bulk->insert(entry, 0);
+
+  mem_heap_empty(heap);
+
+  if (err == DB_SUCCESS) {
+    ++table->m_stats.m_n_rows;
+
+    srv_n_rows_inserted.inc();
+  }
+
+  return err;
+}
+
+/**
+ * Checks the foreign key constraints of a bulk loaded table, its rows were
+ * appended without the checks. The parent tables are S locked until the
+ * transaction commits.
+ *
+ * @param[in,out] trx in: transaction of the bulk load
+ * @param[in] table in: table that was loaded, it is X locked
+ *
+ * @return DB_SUCCESS or err code, DB_NO_REFERENCED_ROW if a row has no parent
+ */
+static ib_err_t ib_bulk_load_check_foreigns(Trx *trx, Table *table) noexcept {
+  if (!trx->m_check_foreigns) {
+    return DB_SUCCESS;
+  }
+
+  for (auto foreign : table->m_foreign_list) {
+    if (foreign->m_referenced_table == nullptr) {
+      (void) srv_dict_sys->table_get(foreign->m_referenced_table_name, false);
+    }
+
+    auto parent = foreign->m_referenced_table;
+
+    if (parent != nullptr && parent != table) {
+      auto err = ib_trx_lock_table_with_retry(trx, parent, LOCK_S);
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+    }
+
+    if (parent != nullptr) {
+      srv_dict_sys->mutex_acquire();
+
+      ++parent->m_n_foreign_key_checks_running;
+
+      srv_dict_sys->mutex_release();
+    }
+
+    const auto err = srv_row_ins->check_foreign_constraint_sorted(foreign);
+
+    if (parent != nullptr) {
+      srv_dict_sys->mutex_acquire();
+
+      ut_a(parent->m_n_foreign_key_checks_running > 0);
+      --parent->m_n_foreign_key_checks_running;
+
+      srv_dict_sys->mutex_release();
+    }
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_cursor_bulk_load_end(ib_crsr_t ib_crsr) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto trx = cursor->prebuilt->m_trx;
+  auto table = cursor->prebuilt->m_table;
+
+  IB_CHECK_PANIC();
+
+  if (cursor->bulk == nullptr) {
+    return DB_ERROR;
+  }
+
+  ib_cursor_load_foreigns(cursor);
+
+  auto err = cursor->bulk->finish(DB_SUCCESS);
+
+  ib_cursor_bulk_free(cursor);
+
+  if (err != DB_SUCCESS) {
+    return err;
+  }
+
+  std::vector<Index *> indexes;
+
+  for (auto index = table->get_first_index()->get_next(); index != nullptr; index = index->get_next()) {
+    indexes.push_back(index);
+  }
+
+  if (!indexes.empty()) {
+    /* The secondary indexes are empty too, sort their entries and load them the same way. */
+    err = row_merge_build_indexes(trx, table, table, indexes.data(), indexes.size(), nullptr);
+  }
+
+  if (err == DB_SUCCESS && !table->m_foreign_list.empty()) {
+    /* The foreign indexes are sorted now, merge them against the parents. */
+    err = ib_bulk_load_check_foreigns(trx, table);
+  }
+
+  ib_update_statistics_if_needed(table);
+
+  ib_wake_master_thread();
+
+  return err;
+}
+
+/**
+ * Gets pointer to a prebuilt update vector used in updates.
+ *
+ * @param[in] cursor in: current cursor
+ *
+ * @return update vector
+ */
+static upd_t *ib_update_vector_create(ib_cursor_t *cursor) {
+  auto trx = cursor->prebuilt->m_trx;
+  auto table = cursor->prebuilt->m_table;
+  auto q_proc = &cursor->q_proc;
+  auto grph = &q_proc->grph;
+  auto node = &q_proc->node;
+
+  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+
+  ib_cursor_load_foreigns(cursor);
+
+  /* The graph is checked out from the graph cache of the table or built
+  in its own heap on the first update of the cursor, then it's rebound to
+  the current transaction. It goes back to the cache when the cursor is
+  closed. */
+  if (grph->upd == nullptr) {
+    grph->upd = ib_qry_graph_checkout(table, &table->m_graph_cache.m_upd, &grph->upd_version);
+  }
+
+  if (grph->upd != nullptr) {
+    grph->upd->trx = trx;
+    node->upd = static_cast<upd_node_t *>(que_fork_get_first_thr(grph->upd)->child);
+  } else {
+    auto heap = mem_heap_create(1024);
+
+    node->upd = srv_row_upd->create_update_node(table, heap);
+
+    grph->upd = static_cast<que_fork_t *>(que_node_get_parent(pars_complete_graph_for_exec(node->upd, trx, heap)));
+
+    grph->upd->state = QUE_FORK_ACTIVE;
+  }
+
+  return node->upd->m_update;
+}
+
+/**
+ * Note that a column has changed.
+ *
+ * @param[in] cursor in: current cursor
+ * @param[in/out] upd_field in/out: update field
+ * @param[in] col_no in: column number
+ * @param[in] dfield in: updated dfield
+ */
+static void ib_update_col(ib_cursor_t *cursor, upd_field_t *upd_field, ulint col_no, dfield_t *dfield) {
+  auto table = cursor->prebuilt->m_table;
+  auto index = table->get_first_index();
+
+  auto data_len = dfield_get_len(dfield);
+
+  if (data_len == UNIV_SQL_NULL) {
+    dfield_set_null(&upd_field->m_new_val);
+  } else {
+    dfield_copy_data(&upd_field->m_new_val, dfield);
+  }
+
+  upd_field->m_exp = nullptr;
+
+  upd_field->m_orig_len = 0;
+
+  upd_field->m_field_no = index->get_clustered_field_pos(&table->m_cols[col_no]);
+}
+
+/**
+ * Checks which fields have changed in a row and stores the new data
+ * to an update vector.
+ *
+ * @param[in] cursor in: current cursor
+ * @param[in/out] upd in/out: update vector
+ * @param[in] old_tuple in: Old tuple in table
+ * @param[in] new_tuple in: New tuple to update
+ *
+ * @return DB_SUCCESS or err code
+ */
+static ib_err_t ib_calc_diff(ib_cursor_t *cursor, upd_t *upd, const ib_tuple_t *old_tuple, const ib_tuple_t *new_tuple) noexcept {
+  ulint n_changed = 0;
+  ib_err_t err = DB_SUCCESS;
+  const auto n_fields = dtuple_get_n_fields(new_tuple->ptr);
+
+  ut_a(old_tuple->type == TPL_ROW);
+  ut_a(new_tuple->type == TPL_ROW);
+  ut_a(old_tuple->index->m_table == new_tuple->index->m_table);
+
+  for (ulint i = 0; i < n_fields; ++i) {
+    auto new_dfield = dtuple_get_nth_field(new_tuple->ptr, i);
+    auto old_dfield = dtuple_get_nth_field(old_tuple->ptr, i);
+
+    auto mtype = dtype_get_mtype(dfield_get_type(old_dfield));
+    auto prtype = dtype_get_prtype(dfield_get_type(old_dfield));
+
+    /* Skip the system columns */
+    if (mtype == DATA_SYS) {
+      continue;
+
+    } else if ((prtype & DATA_NOT_NULL) && dfield_is_null(new_dfield)) {
+
+      err = DB_DATA_MISMATCH;
+      break;
+    }
+
+    if (dfield_get_len(new_dfield) != dfield_get_len(old_dfield) ||
+        (!dfield_is_null(old_dfield) &&
+         memcmp(dfield_get_data(new_dfield), dfield_get_data(old_dfield), dfield_get_len(old_dfield)) != 0)) {
+
+      auto upd_field = &upd->m_fields[n_changed];
+
+      ib_update_col(cursor, upd_field, i, new_dfield);
+
+      ++n_changed;
+    }
+  }
+
+  if (err == DB_SUCCESS) {
+    upd->m_info_bits = 0;
+    upd->m_n_fields = n_changed;
+  }
+
+  return err;
+}
+
+/**
+ * Run the update query and do error handling.
+ *
+ * @param[in] thr in: Update query graph
+ * @param[in] node in: Update node for the query
+ * @param[in] savept in: savepoint to rollback to in case of an error
+ *
+ * @return DB_SUCCESS or error code
+ */
+static ib_err_t ib_update_row_with_lock_retry(que_thr_t *thr, upd_node_t *node, trx_savept_t *savept) noexcept {
+  ib_err_t err;
+  bool lock_wait;
+
+  auto trx = thr_get_trx(thr);
+
+  do {
+    thr->run_node = node;
+    thr->prev_node = node;
+
+    (void) srv_row_upd->step(thr);
+
+    err = trx->m_error_state;
+
+    if (err != DB_SUCCESS) {
+      que_thr_stop_client(thr);
+
+      if (err != DB_RECORD_NOT_FOUND) {
+        thr->lock_state = QUE_THR_LOCK_ROW;
+
+        lock_wait = ib_handle_errors(&err, trx, thr, savept);
+
+        thr->lock_state = QUE_THR_LOCK_NOLOCK;
+      } else {
+        lock_wait = false;
+      }
+    } else {
+      lock_wait = false;
+    }
+  } while (lock_wait);
+
+  return err;
+}
+
+/**
+ * Does an update or delete of a row.
+ *
+ * @param[in] cursor in: Cursor instance
+ * @param[in] pcur in: Btree persistent cursor
+ *
+ * @return DB_SUCCESS or err code
+ */
+static ib_err_t ib_execute_update_query_graph(ib_cursor_t *cursor, Btree_pcursor *pcur) noexcept {
+  auto trx = cursor->prebuilt->m_trx;
+  auto table = cursor->prebuilt->m_table;
+  auto q_proc = &cursor->q_proc;
+
+  /* The transaction must be running. */
+  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+
+  auto node = q_proc->node.upd;
+
+  Srv_conc_guard conc_guard(trx);
+
+  /* This is a short term solution to fix the purge lag. */
+  ib_delay_dml_if_needed(trx, false);
+
+  ut_a(pcur->get_index()->is_clustered());
+  node->m_pcur->copy_stored_position(pcur);
+
+  ut_a(node->m_pcur->get_rel_pos() == Btree_cursor_pos::ON);
+
+  auto savept = trx_savept_take(trx);
+
+  auto thr = que_fork_get_first_thr(q_proc->grph.upd);
+
+  node->m_state = UPD_NODE_UPDATE_CLUSTERED;
+
+  que_thr_move_to_run_state(thr);
+
+  auto err = ib_update_row_with_lock_retry(thr, node, &savept);
+
+  if (err == DB_SUCCESS) {
+
+    que_thr_stop_for_client_no_error(thr, trx);
+
+    if (node->m_is_delete) {
+
+      if (table->m_stats.m_n_rows > 0) {
+        --table->m_stats.m_n_rows;
+      }
+
+      srv_n_rows_deleted.inc();
+    } else {
+      srv_n_rows_updated.inc();
+    }
+
+    ib_update_statistics_if_needed(table);
+
+  } else if (err == DB_RECORD_NOT_FOUND) {
+    trx->m_error_state = DB_SUCCESS;
+  }
+
+  ib_wake_master_thread();
+
+  trx->m_op_info = "";
+
+  return err;
+}
+
+/**
+ * Updates a row in place if the update only changes fixed size columns that
+ * are not ordering fields of any index. There is no query graph run and no
+ * memory allocation, the update vector is the one preallocated in the update
+ * node of the cursor. The row is not locked here, the cursor must have read
+ * it with an X lock. Nothing is changed if the update fails, so unlike the
+ * query graph no savepoint is needed.
+ *
+ * @param[in] cursor in: Cursor instance
+ * @param[in] pcur in: Btree persistent cursor on the clustered index record
+ * @param[in] upd in: Update vector computed by ib_calc_diff()
+ *
+ * @return true if the row was updated, false if the caller must run the
+ *  update query graph
+ */
+static bool ib_update_row_in_place(ib_cursor_t *cursor, Btree_pcursor *pcur, const upd_t *upd) noexcept {
+  auto trx = cursor->prebuilt->m_trx;
+  auto table = cursor->prebuilt->m_table;
+  auto index = table->get_first_index();
+
+  /* The query graph locks the row, a consistent or an S-locking read
+  didn't. */
+  if (cursor->prebuilt->m_select_lock_type != LOCK_X) {
+    return false;
+  }
+
+  for (ulint i{}; i < upd->m_n_fields; ++i) {
+    if (index->get_nth_col(upd->m_fields[i].m_field_no)->get_fixed_size() == 0) {
+      return false;
+    }
+  }
+
+  if (srv_row_upd->changes_some_index_ord_field_binary(table, upd)) {
+    return false;
+  }
+
+  Srv_conc_guard conc_guard(trx);
+
+  /* This is a short term solution to fix the purge lag. */
+  ib_delay_dml_if_needed(trx, false);
+
+  auto thr = que_fork_get_first_thr(cursor->q_proc.grph.upd);
+
+  /* On failure nothing was changed, the query graph will redo the update
+  and handle the error. It also locks the row if the lock mode of the cursor
+  was changed to LOCK_X after the row was read. */
+  if (srv_row_upd->clust_rec_in_place(pcur, upd, thr) != DB_SUCCESS) {
+    return false;
+  }
+
+  srv_n_rows_updated.inc();
+
+  ib_update_statistics_if_needed(table);
+
+  ib_wake_master_thread();
+
+  return true;
+}
+
+ib_err_t ib_cursor_update_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_old_tpl, const ib_tpl_t ib_new_tpl) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  const auto old_tuple = reinterpret_cast<ib_tuple_t *>(ib_old_tpl);
+  const auto new_tuple = reinterpret_cast<ib_tuple_t *>(ib_new_tpl);
+
+  IB_CHECK_PANIC();
+
+  Api_op_timer timer(SRV_OP_CURSOR_UPDATE, cursor->prebuilt->m_trx);
+
+  ib_cursor_release_row(cursor);
+
+  if (ib_cursor_trx_is_read_only(cursor)) {
+    return DB_READONLY;
+  }
+
+  Btree_pcursor *pcur;
+
+  if (prebuilt->m_index->is_clustered()) {
+    pcur = prebuilt->m_pcur;
+  } else if (prebuilt->m_need_to_access_clustered && prebuilt->m_clust_pcur != nullptr) {
+    pcur = prebuilt->m_clust_pcur;
+  } else {
+    return DB_ERROR;
+  }
+
+  ut_a(old_tuple->type == TPL_ROW);
+  ut_a(new_tuple->type == TPL_ROW);
+
+  ib_tuple_fetch_extern(old_tuple);
+  ib_tuple_fetch_extern(new_tuple);
+
+  auto upd = ib_update_vector_create(cursor);
+  auto err = ib_calc_diff(cursor, upd, old_tuple, new_tuple);
+
+  if (err == DB_SUCCESS && ib_update_row_in_place(cursor, pcur, upd)) {
+    return DB_SUCCESS;
+  } else if (err == DB_SUCCESS) {
+    /* Note that this is not a delete. */
+    cursor->q_proc.node.upd->m_is_delete = false;
+
+    err = ib_execute_update_query_graph(cursor, pcur);
+  }
+
+  return err;
+}
+
+/**
+ * Updates the row that an upsert found with the same primary key. The row
+ * was X-locked by the failed insert.
+ *
+ * @param[in] ib_crsr in: Cursor on the clustered index
+ * @param[in] src_tuple in: Row of the upsert
+ * @param[in] update_cols in: Columns to update, nullptr for all
+ * @param[in] n_update_cols in: Number of elements in update_cols
+ *
+ * @return DB_SUCCESS or err code
+ */
+static ib_err_t ib_upsert_update_row(ib_crsr_t ib_crsr, const ib_tuple_t *src_tuple, const ulint *update_cols, ulint n_update_cols) noexcept {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  auto index = prebuilt->m_index;
+  auto search_tuple = prebuilt->m_search_tuple;
+  const auto n_fields = index->get_n_ordering_defined_by_user();
+
+  dtuple_set_n_fields(search_tuple, n_fields);
+  dtuple_set_n_fields_cmp(search_tuple, n_fields);
+
+  for (ulint i{}; i < n_fields; ++i) {
+    const auto col_no = index->get_nth_field(i)->get_col()->get_no();
+
+    dfield_copy(dtuple_get_nth_field(search_tuple, i), dtuple_get_nth_field(src_tuple->ptr, col_no));
+  }
+
+  /* Read the latest version, a consistent read could return an older one.
+  The lock is already held, it is granted without a wait. */
+  const auto select_lock_type = prebuilt->m_select_lock_type;
+
+  prebuilt->m_select_lock_type = LOCK_X;
+
+  auto err = srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_GE, prebuilt, (ib_match_t)IB_EXACT_MATCH, ROW_SEL_MOVETO);
+
+  prebuilt->m_select_lock_type = select_lock_type;
+
+  if (err != DB_SUCCESS) {
+    return err;
+  }
+
+  auto old_tpl = ib_clust_read_tuple_create(ib_crsr);
+  auto new_tpl = ib_clust_read_tuple_create(ib_crsr);
+
+  if (old_tpl == nullptr || new_tpl == nullptr) {
+    err = DB_OUT_OF_MEMORY;
+  } else {
+    /* The row must stay valid during the update. */
+    const auto zero_copy = cursor->zero_copy;
+
+    cursor->zero_copy = false;
+
+    err = ib_cursor_read_row(ib_crsr, old_tpl);
+
+    cursor->zero_copy = zero_copy;
+  }
+
+  if (err == DB_SUCCESS) {
+    err = ib_tuple_copy(new_tpl, old_tpl);
+  }
+
+  if (err == DB_SUCCESS) {
+    auto new_tuple = reinterpret_cast<ib_tuple_t *>(new_tpl);
+    const auto n_cols = update_cols != nullptr ? n_update_cols : dtuple_get_n_fields(src_tuple->ptr);
+
+    for (ulint i{}; i < n_cols; ++i) {
+      const auto col_no = update_cols != nullptr ? update_cols[i] : i;
+
+      dfield_copy(dtuple_get_nth_field(new_tuple->ptr, col_no), dtuple_get_nth_field(src_tuple->ptr, col_no));
+    }
+
+    err = ib_cursor_update_row(ib_crsr, old_tpl, new_tpl);
+  }
+
+  if (old_tpl != nullptr) {
+    ib_tuple_delete(old_tpl);
+  }
+
+  if (new_tpl != nullptr) {
+    ib_tuple_delete(new_tpl);
+  }
+
+  return err;
+}
+
+ib_err_t ib_cursor_upsert_row(ib_crsr_t ib_crsr, const ib_tpl_t ib_tpl, const ulint *update_cols, ulint n_update_cols, bool *inserted) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  auto trx = prebuilt->m_trx;
+  const auto src_tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+
+  IB_CHECK_PANIC();
+
+  if (inserted != nullptr) {
+    *inserted = false;
+  }
+
+  if (!prebuilt->m_index->is_clustered()) {
+    return DB_ERROR;
+  }
+
+  ut_a(src_tuple->type == TPL_ROW);
+
+  for (ulint i{}; update_cols != nullptr && i < n_update_cols; ++i) {
+    if (update_cols[i] >= dtuple_get_n_fields(src_tuple->ptr)) {
+      return DB_DATA_MISMATCH;
+    }
+  }
+
+  /* The duplicate check of the insert X-locks the row with the same key
+  instead of S-locking it, like for INSERT ON DUPLICATE KEY UPDATE. */
+  const auto duplicates = trx->m_duplicates;
+
+  trx->m_duplicates |= TRX_DUP_IGNORE;
+
+  auto err = ib_cursor_insert_row(ib_crsr, ib_tpl);
+
+  trx->m_duplicates = duplicates;
+
+  if (err == DB_SUCCESS) {
+    if (inserted != nullptr) {
+      *inserted = true;
+    }
+  } else if (err == DB_DUPLICATE_KEY && trx->m_error_info == prebuilt->m_index) {
+    err = ib_upsert_update_row(ib_crsr, src_tuple, update_cols, n_update_cols);
+  }
+
+  return err;
+}
+
+ib_err_t ib_cursor_increment(ib_crsr_t ib_crsr, ulint col_no, int64_t delta, int64_t *new_value) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  auto table = prebuilt->m_table;
+
+  IB_CHECK_PANIC();
+
+  Api_op_timer timer(SRV_OP_CURSOR_UPDATE, cursor->prebuilt->m_trx);
+
+  ib_cursor_release_row(cursor);
+
+  if (ib_cursor_trx_is_read_only(cursor)) {
+    return DB_READONLY;
+  }
+
+  /* The row is not locked by the increment, the read must have X-locked it. */
+  if (prebuilt->m_select_lock_type != LOCK_X) {
+    return DB_ERROR;
+  }
+
+  Btree_pcursor *pcur;
+
+  if (prebuilt->m_index->is_clustered()) {
+    pcur = prebuilt->m_pcur;
+  } else if (prebuilt->m_need_to_access_clustered && prebuilt->m_clust_pcur != nullptr) {
+    pcur = prebuilt->m_clust_pcur;
+  } else {
+    return DB_ERROR;
+  }
+
+  if (col_no >= table->get_n_user_cols()) {
+    return DB_DATA_MISMATCH;
+  }
+
+  const auto col = table->get_nth_col(col_no);
+
+  /* The new value is written in place, it must not move the row in any
+  index. */
+  if (col->mtype != DATA_INT || col->len > sizeof(uint64_t) || col->m_ord_part) {
+    return DB_DATA_MISMATCH;
+  }
+
+  auto upd = ib_update_vector_create(cursor);
+  const auto field_no = table->get_first_index()->get_clustered_field_pos(col);
+  auto thr = que_fork_get_first_thr(cursor->q_proc.grph.upd);
+  int64_t value;
+
+  Srv_conc_guard conc_guard(prebuilt->m_trx);
+
+  /* This is a short term solution to fix the purge lag. */
+  ib_delay_dml_if_needed(prebuilt->m_trx, false);
+
+  auto err = srv_row_upd->clust_rec_increment(pcur, upd, field_no, col->prtype & DATA_UNSIGNED, delta, thr, &value);
+
+  if (err == DB_SUCCESS) {
+    if (new_value != nullptr) {
+      *new_value = value;
+    }
+
+    srv_n_rows_updated.inc();
+
+    ib_update_statistics_if_needed(table);
+
+    ib_wake_master_thread();
+  }
+
+  return err;
+}
+
+ib_err_t ib_cursor_add_delta(ib_crsr_t ib_crsr, const ib_tpl_t ib_key, ulint col_no, int64_t delta) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto key = reinterpret_cast<const ib_tuple_t *>(ib_key);
+  auto table = cursor->prebuilt->m_table;
+  auto trx = cursor->prebuilt->m_trx;
+  const auto index = table->get_clustered_index();
+
+  IB_CHECK_PANIC();
+
+  ut_a(trx != nullptr);
+
+  if (ib_cursor_trx_is_read_only(cursor)) {
+    return DB_READONLY;
+  } else if (col_no >= table->get_n_user_cols()) {
+    return DB_DATA_MISMATCH;
+  }
+
+  const auto col = table->get_nth_col(col_no);
+
+  /* The delta is applied in place at commit, see ib_cursor_increment(). */
+  if (!(col->prtype & DATA_COMMUTATIVE) || col->mtype != DATA_INT || col->m_ord_part) {
+    return DB_DATA_MISMATCH;
+  } else if (key->type != TPL_KEY || key->index != index ||
+             dtuple_get_n_fields(key->ptr) != index->get_n_ordering_defined_by_user()) {
+    return DB_DATA_MISMATCH;
+  }
+
+  for (ulint i{}; i < dtuple_get_n_fields(key->ptr); ++i) {
+    if (dfield_is_null(dtuple_get_nth_field(key->ptr, i))) {
+      return DB_DATA_MISMATCH;
+    }
+  }
+
+  if (delta == 0) {
+    return DB_SUCCESS;
+  }
+
+  if (trx->m_delta_heap == nullptr) {
+    trx->m_delta_heap = mem_heap_create(256);
+  }
+
+  auto copy = dtuple_copy(key->ptr, trx->m_delta_heap);
+
+  for (ulint i{}; i < dtuple_get_n_fields(copy); ++i) {
+    dfield_dup(dtuple_get_nth_field(copy, i), trx->m_delta_heap);
+  }
+
+  trx->m_deltas.push_back(Trx_delta{table->m_id, copy, col_no, delta});
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Adds the deltas that the transaction added to the commutative columns of
+ * the row to the columns read into a row tuple, see ib_cursor_add_delta().
+ *
+ * @param[in] trx The transaction that read the row.
+ * @param[in,out] tuple The row.
+ */
+static void ib_tuple_add_deltas(const Trx *trx, ib_tuple_t *tuple) noexcept {
+  const auto index = tuple->index->m_table->get_clustered_index();
+  const auto n_uniq = index->get_n_ordering_defined_by_user();
+  const auto dtuple = tuple->ptr;
+
+  for (const auto &delta : trx->m_deltas) {
+    if (delta.m_table_id != index->m_table->m_id) {
+      continue;
+    }
+
+    bool match{true};
+
+    for (ulint i{}; i < n_uniq && match; ++i) {
+      const auto field = dtuple_get_nth_field(dtuple, index->get_nth_field(i)->get_col()->get_no());
+      const auto key_field = dtuple_get_nth_field(delta.m_key, i);
+      const auto len = dfield_get_len(field);
+
+      match = len == dfield_get_len(key_field) && memcmp(dfield_get_data(field), dfield_get_data(key_field), len) == 0;
+    }
+
+    auto field = dtuple_get_nth_field(dtuple, delta.m_col_no);
+
+    if (!match || dfield_is_null(field)) {
+      continue;
+    }
+
+    /* The range of the column is checked when the delta is applied. */
+    const auto len = dfield_get_len(field);
+    const bool usign = dfield_get_type(field)->prtype & DATA_UNSIGNED;
+    uint64_t value{};
+
+    mach_read_int_type(&value, static_cast<const byte *>(dfield_get_data(field)), len, usign);
+
+    value += uint64_t(delta.m_delta);
+
+    /* The column may point into the page or into a shared copy of the row. */
+    auto buf = static_cast<byte *>(mem_heap_alloc(tuple->heap, len));
+
+    mach_write_int_type(buf, reinterpret_cast<const byte *>(&value), len, usign);
+
+    dfield_set_data(field, buf, len);
+  }
+}
+
+/**
+ * Build the update query graph to delete a row from an index.
+ *
+ * @param[in] cursor in: current cursor
+ * @param[in] pcur in: Btree persistent cursor
+ * @param[in] rec in: record to delete
+ *
+ * @return DB_SUCCESS or err code
+ */
+static ib_err_t ib_delete_row(ib_cursor_t *cursor, Btree_pcursor *pcur, const rec_t *rec) {
+  auto table = cursor->prebuilt->m_table;
+  auto index = table->get_first_index();
+
+  IB_CHECK_PANIC();
+
+  auto n_cols = index->get_n_ordering_defined_by_user();
+  auto ib_tpl = ib_key_tuple_new(index, n_cols);
+
+  if (ib_tpl == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+  auto upd = ib_update_vector_create(cursor);
+
+  ib_read_tuple(rec, tuple, false);
+
+  upd->m_n_fields = ib_tuple_get_n_cols(ib_tpl);
+
+  for (ulint i{}; i < upd->m_n_fields; ++i) {
+    auto upd_field = &upd->m_fields[i];
+    auto dfield = dtuple_get_nth_field(tuple->ptr, i);
+
+    dfield_copy_data(&upd_field->m_new_val, dfield);
+
+    upd_field->m_exp = nullptr;
+
+    upd_field->m_orig_len = 0;
+
+    upd->m_info_bits = 0;
+
+    upd_field->m_field_no = index->get_clustered_field_pos(&table->m_cols[i]);
   }
 
   /* Note that this is a delete. */
   cursor->q_proc.node.upd->m_is_delete = true;
 
-  auto err = ib_execute_update_query_graph(cursor, pcur);
+  auto err = ib_execute_update_query_graph(cursor, pcur);
+
+  ib_tuple_delete(ib_tpl);
+
+  return err;
+}
+
+ib_err_t ib_cursor_delete_row(ib_crsr_t ib_crsr) {
+  ib_err_t err;
+  Btree_pcursor *pcur;
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  IB_CHECK_PANIC();
+
+  Api_op_timer timer(SRV_OP_CURSOR_DELETE, cursor->prebuilt->m_trx);
+
+  ib_cursor_release_row(cursor);
+
+  if (ib_cursor_trx_is_read_only(cursor)) {
+    return DB_READONLY;
+  }
+
+  auto index = prebuilt->m_index->m_table->get_first_index();
+
+  /* Check whether this is a secondary index cursor */
+  if (index != prebuilt->m_index) {
+    if (prebuilt->m_need_to_access_clustered) {
+      pcur = prebuilt->m_clust_pcur;
+    } else {
+      return DB_ERROR;
+    }
+  } else {
+    pcur = prebuilt->m_pcur;
+  }
+
+  if (ib_btr_cursor_is_positioned(pcur)) {
+    const rec_t *rec;
+
+    if (!prebuilt->m_row_cache.is_cache_empty()) {
+      rec = prebuilt->m_row_cache.cache_get_row();
+      ut_a(rec != nullptr);
+    } else {
+      mtr_t mtr;
+
+      mtr.start();
+
+      if (pcur->restore_position(BTR_SEARCH_LEAF, &mtr, Current_location())) {
+
+        rec = pcur->get_rec();
+      } else {
+        rec = nullptr;
+      }
+
+      mtr.commit();
+    }
+
+    if (rec && !rec_get_deleted_flag(rec)) {
+      err = ib_delete_row(cursor, pcur, rec);
+    } else {
+      err = DB_RECORD_NOT_FOUND;
+    }
+  } else {
+    err = DB_RECORD_NOT_FOUND;
+  }
+
+  return err;
+}
+
+ib_err_t ib_cursor_delete_range(ib_crsr_t ib_crsr, const ib_tpl_t ib_low_tpl, const ib_tpl_t ib_high_tpl) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  auto trx = prebuilt->m_trx;
+  auto table = prebuilt->m_table;
+  auto index = table->get_first_index();
+  const auto low = reinterpret_cast<const ib_tuple_t *>(ib_low_tpl);
+  const auto high = reinterpret_cast<const ib_tuple_t *>(ib_high_tpl);
+
+  IB_CHECK_PANIC();
+
+  ib_cursor_release_row(cursor);
+
+  if (ib_cursor_trx_is_read_only(cursor)) {
+    return DB_READONLY;
+  }
+
+  if (prebuilt->m_index != index) {
+    return DB_ERROR;
+  }
+
+  ut_a(low == nullptr || (low->type == TPL_KEY && low->index == index));
+  ut_a(high == nullptr || (high->type == TPL_KEY && high->index == index));
+  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+
+  if (index->get_next() == nullptr && srv_lock_sys->is_table_x_locked(table, trx) &&
+      !srv_row_upd->index_is_referenced(index, trx)) {
+
+    /* Build the update graph, its query thread is used for the undo logging. */
+    (void) ib_update_vector_create(cursor);
+
+    /* This is a short term solution to fix the purge lag. */
+    ib_delay_dml_if_needed(trx, false);
+
+    ulint n_deleted;
+    auto savept = trx_savept_take(trx);
+    auto thr = que_fork_get_first_thr(cursor->q_proc.grph.upd);
+    auto err = srv_row_upd->del_mark_clust_range(
+      index, low != nullptr ? low->ptr : nullptr, high != nullptr ? high->ptr : nullptr, thr, &n_deleted
+    );
+
+    if (err != DB_SUCCESS) {
+      /* Roll back the possibly incomplete range delete. */
+      trx_general_rollback(trx, true, &savept);
+
+      return err;
+    }
+
+    table->m_stats.m_n_rows -= std::min(table->m_stats.m_n_rows, int64_t(n_deleted));
+    srv_n_rows_deleted.inc(n_deleted);
+
+    ib_update_statistics_if_needed(table);
+
+    ib_wake_master_thread();
+
+    return DB_SUCCESS;
+  }
+
+  /* Lock the rows that are deleted. */
+  if (prebuilt->m_select_lock_type != LOCK_X) {
+    auto err = ib_cursor_set_lock_mode(ib_crsr, IB_LOCK_X);
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  int result;
+  auto err = low != nullptr ? ib_cursor_moveto(ib_crsr, ib_low_tpl, IB_CUR_GE, &result) : ib_cursor_first(ib_crsr);
+
+  while (err == DB_SUCCESS) {
+    if (high != nullptr) {
+      mtr_t mtr;
+      bool past_high{};
+      bool restored{true};
+      mem_heap_t *heap{};
+      std::array<ulint, REC_OFFS_NORMAL_SIZE> rec_offsets;
+      auto pcur = prebuilt->m_pcur;
+
+      mtr.start();
+
+      const rec_t *rec{};
+
+      if (!prebuilt->m_row_cache.is_cache_empty()) {
+        rec = prebuilt->m_row_cache.cache_get_row();
+      } else if (pcur->restore_position(BTR_SEARCH_LEAF, &mtr, Current_location())) {
+        rec = pcur->get_rec();
+      } else {
+        /* The row is gone, there is nothing to compare and nothing to
+        delete. Don't let ib_cursor_delete_row() restore the cursor again
+        without the check, move to the next row and compare that. */
+        restored = false;
+      }
+
+      if (rec != nullptr) {
+        Phy_rec record{index, rec};
+
+        rec_offs_set_n_alloc(rec_offsets.data(), rec_offsets.size());
+
+        auto offsets = record.get_col_offsets(rec_offsets.data(), ULINT_UNDEFINED, &heap, Current_location());
+
+        past_high = cmp_dtuple_rec(index->m_cmp_ctx, high->ptr, rec, offsets) < 0;
+      }
+
+      mtr.commit();
+
+      if (heap != nullptr) {
+        mem_heap_free(heap);
+      }
+
+      if (past_high) {
+        break;
+      } else if (!restored) {
+        err = ib_cursor_next(ib_crsr);
+        continue;
+      }
+    }
+
+    err = ib_cursor_delete_row(ib_crsr);
+
+    if (err == DB_SUCCESS || err == DB_RECORD_NOT_FOUND) {
+      err = ib_cursor_next(ib_crsr);
+    }
+  }
+
+  return err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND ? DB_SUCCESS : err;
+}
+
+/**
+ * Returns the index to read a row tuple from when the cursor reads the rows
+ * from a covering secondary index, see ib_cursor_set_columns().
+ *
+ * @param[in] cursor in: Cursor instance
+ * @param[in] tuple in: Tuple to read into
+ *
+ * @return the secondary index, or nullptr if the row is read from the index
+ *  of the tuple
+ */
+static const Index *ib_cursor_covering_index(const ib_cursor_t *cursor, const ib_tuple_t *tuple) noexcept {
+  const auto prebuilt = cursor->prebuilt;
+
+  if (cursor->cols_covered && tuple->type == TPL_ROW && !prebuilt->m_need_to_access_clustered &&
+      !prebuilt->m_index->is_clustered()) {
+    return prebuilt->m_index;
+  } else {
+    return nullptr;
+  }
+}
+
+ib_err_t ib_cursor_read_row(ib_crsr_t ib_crsr, ib_tpl_t ib_tpl) {
+  ib_err_t err;
+  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  IB_CHECK_PANIC();
+
+  ut_a(cursor->prebuilt->m_trx->m_conc_state != TRX_NOT_STARTED);
+
+  ib_cursor_release_row(cursor);
+
+  /* When searching with IB_EXACT_MATCH set, row_search_mvcc()
+  will not position the persistent cursor but will copy the record
+  found into the row cache. It should be the only entry. */
+  if (!ib_cursor_is_positioned(ib_crsr) && cursor->prebuilt->m_row_cache.is_cache_empty()) {
+    err = DB_RECORD_NOT_FOUND;
+  } else if (!cursor->prebuilt->m_row_cache.is_cache_empty()) {
+    auto rec = cursor->prebuilt->m_row_cache.cache_get_row();
+    ut_a(rec != nullptr);
+
+    if (!rec_get_deleted_flag(rec)) {
+      /* The cached row stays until the cursor moves. */
+      ib_read_tuple(rec, tuple, cursor->stream_blobs, !cursor->zero_copy, nullptr, ib_cursor_covering_index(cursor, tuple));
+      err = DB_SUCCESS;
+    } else {
+      err = DB_RECORD_NOT_FOUND;
+    }
+  } else {
+    mtr_t local_mtr;
+    Btree_pcursor *pcur;
+    auto prebuilt = cursor->prebuilt;
+
+    if (prebuilt->m_need_to_access_clustered && tuple->type == TPL_ROW) {
+      pcur = prebuilt->m_clust_pcur;
+    } else {
+      pcur = prebuilt->m_pcur;
+    }
 
-  ib_tuple_delete(ib_tpl);
+    if (pcur == nullptr) {
+      return DB_ERROR;
+    }
+
+    /* In zero-copy mode the page stays latched until the cursor is used
+    again, see ib_cursor_release_row(). */
+    auto mtr = cursor->zero_copy ? cursor->row_mtr : &local_mtr;
+
+    mtr->start();
+
+    if (pcur->restore_position(BTR_SEARCH_LEAF, mtr, Current_location())) {
+      auto rec = pcur->get_rec();
+
+      if (!rec_get_deleted_flag(rec)) {
+        auto block = cursor->zero_copy ? pcur->get_block() : nullptr;
+
+        ib_read_tuple(rec, tuple, cursor->stream_blobs, block == nullptr, block, ib_cursor_covering_index(cursor, tuple));
+        err = DB_SUCCESS;
+      } else {
+        err = DB_RECORD_NOT_FOUND;
+      }
+    } else {
+      err = DB_RECORD_NOT_FOUND;
+    }
+
+    if (err != DB_SUCCESS || !cursor->zero_copy) {
+      mtr->commit();
+    }
+  }
+
+  if (err == DB_SUCCESS && tuple->type == TPL_ROW && !cursor->prebuilt->m_trx->m_deltas.empty()) {
+    ib_tuple_add_deltas(cursor->prebuilt->m_trx, tuple);
+  }
 
   return err;
 }
 
-ib_err_t ib_cursor_delete_row(ib_crsr_t ib_crsr) {
-  ib_err_t err;
-  Btree_pcursor *pcur;
+ib_err_t ib_cursor_read_batch(ib_crsr_t ib_crsr, ulint n, std::vector<ib_col_batch_t> &cols, ulint *n_read) {
   auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
   auto prebuilt = cursor->prebuilt;
+  auto index = prebuilt->m_index;
 
   IB_CHECK_PANIC();
 
-  auto index = prebuilt->m_index->m_table->get_first_index();
+  ib_cursor_release_row(cursor);
 
-  /* Check whether this is a secondary index cursor */
-  if (index != prebuilt->m_index) {
-    if (prebuilt->m_need_to_access_clustered) {
-      pcur = prebuilt->m_clust_pcur;
-    } else {
-      return DB_ERROR;
-    }
-  } else {
-    pcur = prebuilt->m_pcur;
+  ut_a(prebuilt->m_trx->m_conc_state != TRX_NOT_STARTED);
+
+  *n_read = 0;
+
+  ib_col_batch_clear(cols);
+
+  if (!index->is_clustered()) {
+    return DB_ERROR;
   }
 
-  if (ib_btr_cursor_is_positioned(pcur)) {
-    const rec_t *rec;
+  std::vector<ulint> fields;
 
-    if (!prebuilt->m_row_cache.is_cache_empty()) {
+  auto err = ib_col_batch_fields(index, cols, fields);
+
+  if (err != DB_SUCCESS) {
+    return err;
+  } else if (!ib_cursor_is_positioned(ib_crsr) && prebuilt->m_row_cache.is_cache_empty()) {
+    return DB_RECORD_NOT_FOUND;
+  }
+
+  auto heap = mem_heap_create(UNIV_PAGE_SIZE);
+  std::array<ulint, REC_OFFS_NORMAL_SIZE> rec_offsets;
+
+  rec_offs_set_n_alloc(rec_offsets.data(), rec_offsets.size());
+
+  while (*n_read < n && err == DB_SUCCESS) {
+    mtr_t mtr;
+    const rec_t *rec{};
+    const auto cached = !prebuilt->m_row_cache.is_cache_empty();
+
+    if (cached) {
       rec = prebuilt->m_row_cache.cache_get_row();
-      ut_a(rec != nullptr);
     } else {
-      mtr_t mtr;
-
       mtr.start();
 
-      if (pcur->restore_position(BTR_SEARCH_LEAF, &mtr, Current_location())) {
-
-        rec = pcur->get_rec();
-      } else {
-        rec = nullptr;
+      if (prebuilt->m_pcur->restore_position(BTR_SEARCH_LEAF, &mtr, Current_location())) {
+        rec = prebuilt->m_pcur->get_rec();
       }
+    }
+
+    if (rec == nullptr) {
+      err = DB_RECORD_NOT_FOUND;
+    } else if (!rec_get_deleted_flag(rec)) {
+      Phy_rec record{index, rec};
+
+      auto offsets = record.get_col_offsets(rec_offsets.data(), ULINT_UNDEFINED, &heap, Current_location());
+
+      ib_col_batch_append(rec, offsets, index, fields, cols, heap);
+
+      ++*n_read;
+    }
 
+    if (!cached) {
       mtr.commit();
     }
 
-    if (rec && !rec_get_deleted_flag(rec)) {
-      err = ib_delete_row(cursor, pcur, rec);
-    } else {
-      err = DB_RECORD_NOT_FOUND;
+    /* Only the externally stored columns of the current row are in the heap. */
+    mem_heap_empty(heap);
+
+    if (err == DB_SUCCESS) {
+      err = ib_cursor_next(ib_crsr);
     }
-  } else {
-    err = DB_RECORD_NOT_FOUND;
   }
 
+  mem_heap_free(heap);
+
+  return err;
+}
+
+ib_err_t ib_cursor_prev(ib_crsr_t ib_crsr) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  IB_CHECK_PANIC();
+
+  ib_cursor_release_row(cursor);
+
+  /* We want to move to the next record */
+  dtuple_set_n_fields(prebuilt->m_search_tuple, 0);
+
+  prebuilt->m_row_cache.cache_next();
+
+  Srv_conc_guard conc_guard(prebuilt->m_trx);
+
+  return srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_L, prebuilt, ROW_SEL_DEFAULT, ROW_SEL_PREV);
+}
+
+ib_err_t ib_cursor_next(ib_crsr_t ib_crsr) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  IB_CHECK_PANIC();
+
+  Api_op_timer timer(SRV_OP_CURSOR_NEXT, cursor->prebuilt->m_trx);
+
+  ib_cursor_release_row(cursor);
+
+  /* We want to move to the next record */
+  dtuple_set_n_fields(prebuilt->m_search_tuple, 0);
+
+  prebuilt->m_row_cache.cache_next();
+
+  Srv_conc_guard conc_guard(prebuilt->m_trx);
+
+  return srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_G, prebuilt, ROW_SEL_DEFAULT, ROW_SEL_NEXT);
+}
+
+/**
+ * Move cursor to the first record in the table.
+ *
+ * @param[in] cursor in: InnoDB cursor instance
+ * @param[in] mode in: Search mode
+ *
+ * @return DB_SUCCESS or err code
+ */
+static ib_err_t ib_cursor_position(ib_cursor_t *cursor, ib_srch_mode_t mode) {
+  auto prebuilt = cursor->prebuilt;
+
+  IB_CHECK_PANIC();
+
+  ib_cursor_release_row(cursor);
+
+  /* We want to position at one of the ends, row_search_mvcc()
+  uses the search_tuple fields to work out what to do. */
+  dtuple_set_n_fields(prebuilt->m_search_tuple, 0);
+
+  Srv_conc_guard conc_guard(prebuilt->m_trx);
+
+  return srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, mode, prebuilt, ROW_SEL_DEFAULT, ROW_SEL_MOVETO);
+}
+
+ib_err_t ib_cursor_first(ib_crsr_t ib_crsr) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  IB_CHECK_PANIC();
+
+  return ib_cursor_position(cursor, IB_CUR_G);
+}
+
+ib_err_t ib_cursor_last(ib_crsr_t ib_crsr) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  IB_CHECK_PANIC();
+
+  return ib_cursor_position(cursor, IB_CUR_L);
+}
+
+/**
+ * Sets the search tuple of a cursor to a key.
+ *
+ * @param[in,out] prebuilt in: prebuilt of the cursor
+ * @param[in] tuple in: key tuple
+ */
+static void ib_cursor_set_search_key(Prebuilt *prebuilt, const ib_tuple_t *tuple) noexcept {
+  auto search_tuple = prebuilt->m_search_tuple;
+
+  ut_a(tuple->type == TPL_KEY);
+
+  auto n_fields = prebuilt->m_index->get_n_ordering_defined_by_user();
+
+  dtuple_set_n_fields(search_tuple, n_fields);
+  dtuple_set_n_fields_cmp(search_tuple, n_fields);
+
+  /* Do a shallow copy */
+  for (ulint i{}; i < n_fields; ++i) {
+    dfield_copy(dtuple_get_nth_field(search_tuple, i), dtuple_get_nth_field(tuple->ptr, i));
+  }
+}
+
+ib_err_t ib_cursor_moveto(ib_crsr_t ib_crsr, ib_tpl_t ib_tpl, ib_srch_mode_t ib_srch_mode, int *result) {
+  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  IB_CHECK_PANIC();
+
+  Api_op_timer timer(SRV_OP_CURSOR_MOVETO, cursor->prebuilt->m_trx);
+
+  ib_cursor_release_row(cursor);
+
+  ib_cursor_set_search_key(prebuilt, tuple);
+
+  ut_a(prebuilt->m_select_lock_type <= LOCK_NUM);
+
+  auto err = ib_search_would_block(prebuilt->m_trx, prebuilt->m_index, prebuilt->m_search_tuple);
+
+  if (err != DB_SUCCESS) {
+    return err;
+  }
+
+  {
+    Srv_conc_guard conc_guard(prebuilt->m_trx);
+
+    err = srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, ib_srch_mode, prebuilt, (ib_match_t)cursor->match_mode, ROW_SEL_MOVETO);
+  }
+
+  *result = prebuilt->m_result;
+
   return err;
 }
 
-ib_err_t ib_cursor_read_row(ib_crsr_t ib_crsr, ib_tpl_t ib_tpl) {
-  ib_err_t err;
-  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+/**
+ * Compare the keys of two key tuples of an index.
+ *
+ * @param[in] index in: index of the keys
+ * @param[in] a in: key
+ * @param[in] b in: key
+ *
+ * @return < 0, 0 or > 0 as a is less than, equal to or greater than b
+ */
+static int ib_tuple_cmp_key(const Index *index, const ib_tuple_t *a, const ib_tuple_t *b) noexcept {
+  const auto n_fields = index->get_n_ordering_defined_by_user();
+
+  for (ulint i{}; i < n_fields; ++i) {
+    const auto cmp = cmp_dfield_dfield(index->m_cmp_ctx, dtuple_get_nth_field(a->ptr, i), dtuple_get_nth_field(b->ptr, i));
+
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Issues asynchronous reads of the leaf pages of keys that are not in the
+ * buffer pool, so that the lookups of a batch don't wait for them one by one.
+ *
+ * @param[in,out] prebuilt in: prebuilt of the cursor, its search tuple is used
+ * @param[in] ib_keys in: keys of the batch
+ * @param[in] order in: positions of the keys in key order
+ */
+static void ib_multi_get_prefetch(Prebuilt *prebuilt, const ib_tpl_t *ib_keys, const std::vector<ulint> &order) noexcept {
+  /* With a single leaf page to read there is nothing to overlap. */
+  constexpr ulint MIN_N_PAGES = 2;
+
+  const auto index = prebuilt->m_index;
+  const auto space = index->get_space_id();
+  Btree_cursor btr_cur(srv_fsp, srv_btree_sys);
+  std::vector<page_no_t> page_nos;
+
+  /* A non-blocking transaction must not wait for the non-leaf pages, the
+  first one that is missing is read instead of the leaf. */
+  page_no_t missing_page_no;
+  const auto missing = prebuilt->m_trx->m_wake ? &missing_page_no : nullptr;
+
+  page_nos.reserve(order.size());
+
+  for (auto i : order) {
+    ib_cursor_set_search_key(prebuilt, reinterpret_cast<const ib_tuple_t *>(ib_keys[i]));
+
+    auto page_no = btr_cur.get_leaf_page_no(index, prebuilt->m_search_tuple, Current_location(), missing);
+
+    if (missing != nullptr && missing_page_no != FIL_NULL) {
+      page_no = missing_page_no;
+    }
+
+    /* Consecutive keys are often on the same page. */
+    if (page_no != FIL_NULL && (page_nos.empty() || page_nos.back() != page_no) && !srv_buf_pool->peek(space, page_no)) {
+      page_nos.push_back(page_no);
+    }
+  }
+
+  /* Read each page once, in the file order. */
+  std::sort(page_nos.begin(), page_nos.end());
+
+  page_nos.erase(std::unique(page_nos.begin(), page_nos.end()), page_nos.end());
+
+  if (page_nos.size() >= MIN_N_PAGES) {
+    buf_read_ahead_pages(space, page_nos.data(), page_nos.size());
+  }
+}
+
+ib_err_t ib_cursor_multi_get(ib_crsr_t ib_crsr, const ib_tpl_t *ib_keys, ulint n, ib_tpl_t *ib_tpls, ib_err_t *errs) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  auto index = prebuilt->m_index;
+
+  IB_CHECK_PANIC();
+
+  ib_cursor_release_row(cursor);
+
+  ut_a(prebuilt->m_trx->m_conc_state != TRX_NOT_STARTED);
+  ut_a(prebuilt->m_select_lock_type <= LOCK_NUM);
+
+  if (!index->is_clustered()) {
+    return DB_ERROR;
+  } else if (n == 0) {
+    return DB_SUCCESS;
+  }
+
+  std::vector<ulint> order(n);
+
+  for (ulint i{}; i < n; ++i) {
+    order[i] = i;
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&](ulint a, ulint b) {
+    return ib_tuple_cmp_key(index, reinterpret_cast<const ib_tuple_t *>(ib_keys[a]), reinterpret_cast<const ib_tuple_t *>(ib_keys[b])) < 0;
+  });
+
+  ib_multi_get_prefetch(prebuilt, ib_keys, order);
+
+  /* The keys are in order: each lookup first tries the leaf page of the
+  previous one, the tree is only searched on a new page. */
+  Btree_leaf_guess guess;
+  auto btr_cur = prebuilt->m_pcur->get_btr_cur();
+
+  btr_cur->m_leaf_guess = &guess;
 
-  IB_CHECK_PANIC();
+  /* The rows must stay valid after the next lookup. */
+  const auto zero_copy = cursor->zero_copy;
 
-  ut_a(cursor->prebuilt->m_trx->m_conc_state != TRX_NOT_STARTED);
+  cursor->zero_copy = false;
 
-  /* When searching with IB_EXACT_MATCH set, row_search_mvcc()
-  will not position the persistent cursor but will copy the record
-  found into the row cache. It should be the only entry. */
-  if (!ib_cursor_is_positioned(ib_crsr) && cursor->prebuilt->m_row_cache.is_cache_empty()) {
-    err = DB_RECORD_NOT_FOUND;
-  } else if (!cursor->prebuilt->m_row_cache.is_cache_empty()) {
-    auto rec = cursor->prebuilt->m_row_cache.cache_get_row();
-    ut_a(rec != nullptr);
+  ulint i{};
+  ib_err_t err{DB_SUCCESS};
 
-    if (!rec_get_deleted_flag(rec)) {
-      ib_read_tuple(rec, tuple);
-      err = DB_SUCCESS;
-    } else {
-      err = DB_RECORD_NOT_FOUND;
-    }
-  } else {
-    mtr_t mtr;
-    Btree_pcursor *pcur;
-    auto prebuilt = cursor->prebuilt;
+  for (; i < n; ++i) {
+    ib_cursor_set_search_key(prebuilt, reinterpret_cast<const ib_tuple_t *>(ib_keys[order[i]]));
 
-    if (prebuilt->m_need_to_access_clustered && tuple->type == TPL_ROW) {
-      pcur = prebuilt->m_clust_pcur;
-    } else {
-      pcur = prebuilt->m_pcur;
-    }
+    /* The keys that were looked up before a DB_WOULD_BLOCK keep their results. */
+    auto row_err = ib_search_would_block(prebuilt->m_trx, index, prebuilt->m_search_tuple);
 
-    if (pcur == nullptr) {
-      return DB_ERROR;
+    if (row_err == DB_SUCCESS) {
+      row_err = srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_GE, prebuilt, (ib_match_t)IB_EXACT_MATCH, ROW_SEL_MOVETO);
     }
 
-    mtr.start();
+    if (row_err == DB_SUCCESS) {
+      row_err = ib_cursor_read_row(ib_crsr, ib_tpls[order[i]]);
+    } else if (row_err == DB_END_OF_INDEX) {
+      row_err = DB_RECORD_NOT_FOUND;
+    }
 
-    if (pcur->restore_position(BTR_SEARCH_LEAF, &mtr, Current_location())) {
-      auto rec = pcur->get_rec();
+    errs[order[i]] = row_err;
 
-      if (!rec_get_deleted_flag(rec)) {
-        ib_read_tuple(rec, tuple);
-        err = DB_SUCCESS;
-      } else {
-        err = DB_RECORD_NOT_FOUND;
-      }
-    } else {
-      err = DB_RECORD_NOT_FOUND;
+    if (row_err != DB_SUCCESS && row_err != DB_RECORD_NOT_FOUND) {
+      err = row_err;
+      break;
     }
+  }
 
-    mtr.commit();
+  btr_cur->m_leaf_guess = nullptr;
+  cursor->zero_copy = zero_copy;
+
+  /* The keys that were not looked up. */
+  while (++i < n) {
+    errs[order[i]] = err;
   }
 
   return err;
 }
 
-ib_err_t ib_cursor_prev(ib_crsr_t ib_crsr) {
+ib_err_t ib_cursor_get_by_pk(ib_crsr_t ib_crsr, const ib_tpl_t ib_key, ib_tpl_t ib_tpl) {
   auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto key = reinterpret_cast<const ib_tuple_t *>(ib_key);
+  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
   auto prebuilt = cursor->prebuilt;
+  auto index = prebuilt->m_index;
+  auto trx = prebuilt->m_trx;
 
   IB_CHECK_PANIC();
 
-  /* We want to move to the next record */
-  dtuple_set_n_fields(prebuilt->m_search_tuple, 0);
+  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+  ut_a(prebuilt->m_select_lock_type <= LOCK_NUM);
 
-  prebuilt->m_row_cache.cache_next();
+  if (!index->is_clustered() || key->type != TPL_KEY || tuple->type != TPL_ROW) {
+    return DB_ERROR;
+  }
 
-  return srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_L, prebuilt, ROW_SEL_DEFAULT, ROW_SEL_PREV);
-}
+  Api_op_timer timer(SRV_OP_CURSOR_MOVETO, trx);
 
-ib_err_t ib_cursor_next(ib_crsr_t ib_crsr) {
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
-  auto prebuilt = cursor->prebuilt;
+  ib_cursor_release_row(cursor);
 
-  IB_CHECK_PANIC();
+  ib_cursor_set_search_key(prebuilt, key);
 
-  /* We want to move to the next record */
-  dtuple_set_n_fields(prebuilt->m_search_tuple, 0);
+  auto err = ib_search_would_block(trx, index, prebuilt->m_search_tuple);
 
-  prebuilt->m_row_cache.cache_next();
+  if (err != DB_SUCCESS) {
+    return err;
+  }
 
-  return srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_G, prebuilt, ROW_SEL_DEFAULT, ROW_SEL_NEXT);
-}
+  const auto n_fields = dtuple_get_n_fields(prebuilt->m_search_tuple);
 
-/**
- * Move cursor to the first record in the table.
- *
- * @param[in] cursor in: InnoDB cursor instance
- * @param[in] mode in: Search mode
- *
- * @return DB_SUCCESS or err code
- */
-static ib_err_t ib_cursor_position(ib_cursor_t *cursor, ib_srch_mode_t mode) {
-  auto prebuilt = cursor->prebuilt;
+  /* A consistent read of a full key: search the leaf page directly and copy
+  the record if the read view sees it. Anything else, a locking read, a read
+  view that is not assigned yet, or an older version to build, goes through
+  the row search. */
+  if (prebuilt->m_select_lock_type == LOCK_NONE && trx->m_read_view != nullptr && n_fields > 0 && n_fields == index->get_n_unique()) {
+    mtr_t mtr;
+    Btree_cursor btr_cur(srv_fsp, srv_btree_sys);
 
-  IB_CHECK_PANIC();
+    mtr.start();
 
-  /* We want to position at one of the ends, row_search_mvcc()
-  uses the search_tuple fields to work out what to do. */
-  dtuple_set_n_fields(prebuilt->m_search_tuple, 0);
+    btr_cur.search_to_nth_level(nullptr, index, 0, prebuilt->m_search_tuple, PAGE_CUR_LE, BTR_SEARCH_LEAF, &mtr, Current_location());
 
-  return srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, mode, prebuilt, ROW_SEL_DEFAULT, ROW_SEL_MOVETO);
-}
+    const auto rec = btr_cur.get_rec();
 
-ib_err_t ib_cursor_first(ib_crsr_t ib_crsr) {
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+    if (!page_rec_is_user_rec(rec) || btr_cur.get_low_match() < n_fields) {
+      /* No version of the row is in the index. */
+      err = DB_RECORD_NOT_FOUND;
+    } else {
+      mem_heap_t *heap{};
+      std::array<ulint, REC_OFFS_NORMAL_SIZE> rec_offsets;
+      Phy_rec record{index, rec};
 
-  IB_CHECK_PANIC();
+      rec_offs_set_n_alloc(rec_offsets.data(), rec_offsets.size());
 
-  return ib_cursor_position(cursor, IB_CUR_G);
-}
+      auto offsets = record.get_col_offsets(rec_offsets.data(), ULINT_UNDEFINED, &heap, Current_location());
 
-ib_err_t ib_cursor_last(ib_crsr_t ib_crsr) {
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+      if (trx->m_isolation_level == TRX_ISO_READ_UNCOMMITTED ||
+          srv_lock_sys->clust_rec_cons_read_sees(rec, index, offsets, trx->m_read_view)) {
 
-  IB_CHECK_PANIC();
+        if (rec_get_deleted_flag(rec)) {
+          err = DB_RECORD_NOT_FOUND;
+        } else {
+          ib_read_tuple(rec, tuple, cursor->stream_blobs);
+          err = DB_SUCCESS;
+        }
+      } else {
+        err = DB_FAIL;
+      }
 
-  return ib_cursor_position(cursor, IB_CUR_L);
-}
+      if (heap != nullptr) {
+        mem_heap_free(heap);
+      }
+    }
 
-ib_err_t ib_cursor_moveto(ib_crsr_t ib_crsr, ib_tpl_t ib_tpl, ib_srch_mode_t ib_srch_mode, int *result) {
-  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
-  auto prebuilt = cursor->prebuilt;
-  auto search_tuple = prebuilt->m_search_tuple;
+    mtr.commit();
 
-  IB_CHECK_PANIC();
+    if (err != DB_FAIL) {
+      if (err == DB_SUCCESS) {
+        srv_n_rows_read.inc();
+        index->m_counters.inc(Index::ROWS_READ);
 
-  ut_a(tuple->type == TPL_KEY);
+        if (ut::op_profile != nullptr) {
+          ++ut::op_profile->m_n_rows_examined;
+        }
 
-  auto n_fields = prebuilt->m_index->get_n_ordering_defined_by_user();
+        if (!trx->m_deltas.empty()) {
+          ib_tuple_add_deltas(trx, tuple);
+        }
+      }
 
-  dtuple_set_n_fields(search_tuple, n_fields);
-  dtuple_set_n_fields_cmp(search_tuple, n_fields);
+      return err;
+    }
+  }
 
-  /* Do a shallow copy */
-  for (ulint i{}; i < n_fields; ++i) {
-    dfield_copy(dtuple_get_nth_field(search_tuple, i), dtuple_get_nth_field(tuple->ptr, i));
+  {
+    Srv_conc_guard conc_guard(trx);
+
+    err = srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_GE, prebuilt, (ib_match_t)IB_EXACT_MATCH, ROW_SEL_MOVETO);
   }
 
-  ut_a(prebuilt->m_select_lock_type <= LOCK_NUM);
+  if (err == DB_SUCCESS) {
+    /* The row is copied, the cursor is not left on it. */
+    const auto zero_copy = cursor->zero_copy;
 
-  auto err = srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, ib_srch_mode, prebuilt, (ib_match_t)cursor->match_mode, ROW_SEL_MOVETO);
+    cursor->zero_copy = false;
 
-  *result = prebuilt->m_result;
+    err = ib_cursor_read_row(ib_crsr, ib_tpl);
+
+    cursor->zero_copy = zero_copy;
+  } else if (err == DB_END_OF_INDEX) {
+    err = DB_RECORD_NOT_FOUND;
+  }
 
   return err;
 }
@@ -3164,9 +5406,19 @@ void ib_cursor_attach_trx(ib_crsr_t ib_crsr, ib_trx_t ib_trx) {
   ut_a(ib_trx != nullptr);
   ut_a(prebuilt->m_trx == nullptr);
 
+  /* The page of a zero-copy row is released by ib_cursor_reset(). */
+  ut_ad(cursor->row_mtr == nullptr || !cursor->row_mtr->is_active());
+
   prebuilt->clear();
   prebuilt->update_trx((Trx *)ib_trx);
 
+  /* The declared columns outlive the transaction. */
+  if (cursor->cols_declared) {
+    prebuilt->m_need_to_access_clustered = !prebuilt->m_index->is_clustered() && !cursor->cols_covered;
+  }
+
+  ib_qry_proc_set_trx(&cursor->q_proc, prebuilt->m_trx);
+
   /* Assign a read view if the transaction does not have it yet */
   auto rv = prebuilt->m_trx->assign_read_view();
   ut_a(rv != nullptr);
@@ -3186,6 +5438,125 @@ void ib_cursor_set_match_mode(ib_crsr_t ib_crsr, ib_match_mode_t match_mode) {
   cursor->match_mode = match_mode;
 }
 
+void ib_cursor_set_blob_streaming(ib_crsr_t ib_crsr, bool flag) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  cursor->stream_blobs = flag;
+}
+
+void ib_cursor_set_zero_copy(ib_crsr_t ib_crsr, bool flag) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  ib_cursor_release_row(cursor);
+
+  if (flag && cursor->row_mtr == nullptr) {
+    cursor->row_mtr = new (mem_heap_alloc(cursor->heap, sizeof(mtr_t))) mtr_t;
+  }
+
+  cursor->zero_copy = flag;
+}
+
+void ib_cursor_set_keep_page_fixed(ib_crsr_t ib_crsr, bool flag) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  prebuilt->m_pcur->set_keep_block_fixed(flag);
+  prebuilt->m_clust_pcur->set_keep_block_fixed(flag);
+}
+
+void ib_cursor_set_prefetch_rows(ib_crsr_t ib_crsr, ulint n_rows) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  cursor->prebuilt->m_row_cache.set_max_rows(n_rows);
+}
+
+/**
+ * Converts the filters of the API to filters on the records of an index.
+ *
+ * @param[in] index Index whose records are filtered.
+ * @param[in] filters Filters on columns of the table.
+ * @param[in] ib_values Row tuple with the values to compare with.
+ * @param[out] rec_filters Filters on the fields of the index.
+ *
+ * @return DB_SUCCESS or DB_DATA_MISMATCH if a filter can't be evaluated on the index
+ */
+static ib_err_t ib_filters_build(const Index *index, const std::vector<ib_scan_filter_t> &filters, const ib_tpl_t ib_values, Rec_filters &rec_filters) noexcept {
+  const auto table = index->m_table;
+  const auto values = reinterpret_cast<const ib_tuple_t *>(ib_values);
+
+  rec_filters.clear();
+
+  for (const auto &filter : filters) {
+    if (filter.col >= table->get_n_cols()) {
+      return DB_DATA_MISMATCH;
+    }
+
+    const auto field_no = index->get_nth_field_pos(filter.col);
+
+    /* The field must be complete in the record. Only the clustered index
+    stores columns externally. */
+    if (field_no == ULINT_UNDEFINED || index->get_nth_field(field_no)->m_prefix_len > 0 ||
+        (index->is_clustered() && table->get_nth_col(filter.col)->get_fixed_size() == 0)) {
+      return DB_DATA_MISMATCH;
+    }
+
+    const dfield_t *value{};
+
+    if (filter.op != ib_scan_filter_t::IS_NULL && filter.op != ib_scan_filter_t::IS_NOT_NULL) {
+      if (values == nullptr || values->type != TPL_ROW || values->index->m_table != table) {
+        return DB_DATA_MISMATCH;
+      }
+
+      value = dtuple_get_nth_field(values->ptr, filter.col);
+    }
+
+    rec_filters.push_back({field_no, static_cast<Rec_filter::Op>(filter.op), value});
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_cursor_set_filters(ib_crsr_t ib_crsr, const std::vector<ib_scan_filter_t> &filters, const ib_tpl_t ib_values) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  if (prebuilt->m_filter_heap != nullptr) {
+    mem_heap_free(prebuilt->m_filter_heap);
+    prebuilt->m_filter_heap = nullptr;
+  }
+
+  auto err = ib_filters_build(prebuilt->m_index, filters, ib_values, prebuilt->m_filters);
+
+  if (err != DB_SUCCESS || prebuilt->m_filters.empty()) {
+    prebuilt->m_filters.clear();
+    return err;
+  }
+
+  /* The values are copied, the tuple may be deleted. */
+  prebuilt->m_filter_heap = mem_heap_create(256);
+
+  for (auto &filter : prebuilt->m_filters) {
+    if (filter.m_value != nullptr) {
+      auto value = reinterpret_cast<dfield_t *>(mem_heap_dup(prebuilt->m_filter_heap, filter.m_value, sizeof(dfield_t)));
+
+      dfield_dup(value, prebuilt->m_filter_heap);
+
+      filter.m_value = value;
+    }
+  }
+
+  /* The cached rows were not filtered. */
+  prebuilt->m_row_cache.clear();
+
+  return DB_SUCCESS;
+}
+
+void ib_cursor_set_multi_range_read(ib_crsr_t ib_crsr, bool flag) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  cursor->prebuilt->m_multi_range_read = flag;
+}
+
 /**
  * @brief Get the dfield instance for the column in the tuple.
  * 
@@ -3195,7 +5566,11 @@ void ib_cursor_set_match_mode(ib_crsr_t ib_crsr, ib_match_mode_t match_mode) {
  * @return dfield_t* dfield instance in the tuple.
  */
 static dfield_t *ib_col_get_dfield(ib_tuple_t *tuple, ulint col_no) noexcept {
-  return dtuple_get_nth_field(tuple->ptr, col_no);
+  auto dfield = dtuple_get_nth_field(tuple->ptr, col_no);
+
+  ib_col_fetch_extern(tuple, dfield);
+
+  return dfield;
 }
 
 /**
@@ -3220,7 +5595,8 @@ ib_err_t ib_col_set_value(ib_tpl_t ib_tpl, ulint col_no, const void *s, ulint le
 
   ut_d(mem_heap_verify(tuple->heap));
 
-  auto dfield = ib_col_get_dfield(tuple, col_no);
+  /* The value is replaced, don't read a BLOB left on its pages. */
+  auto dfield = dtuple_get_nth_field(tuple->ptr, col_no);
 
   /* User wants to set the column to nullptr. */
   if (len == IB_SQL_NULL) {
@@ -3235,7 +5611,7 @@ ib_err_t ib_col_set_value(ib_tpl_t ib_tpl, ulint col_no, const void *s, ulint le
     return DB_DATA_MISMATCH;
   }
 
-  auto dst = static_cast<byte *>(dfield_get_data(dfield));
+  auto size = len;
 
   /* Since TEXT/CLOB also map to DATA_VARCHAR we need to make an
   exception. Perhaps we need to set the precise type and check
@@ -3243,15 +5619,20 @@ ib_err_t ib_col_set_value(ib_tpl_t ib_tpl, ulint col_no, const void *s, ulint le
   if (ib_col_is_capped(dtype)) {
 
     len = ut_min(len, dtype_get_len(dtype));
+    size = dtype_get_len(dtype);
+  }
 
-    if (dst == nullptr) {
-      dst = mem_heap_alloc(tuple->heap, dtype_get_len(dtype));
-      ut_a(dst != nullptr);
-    }
-  } else if (dst == nullptr || len > dfield_get_len(dfield)) {
-    dst = mem_heap_alloc(tuple->heap, len);
+  /* Only write to a buffer that was allocated for the column, the field
+  may point into a record copy that the tuple was read into. */
+  auto col_buf = &tuple->col_bufs[col_no];
+
+  if (col_buf->ptr == nullptr || col_buf->size < size) {
+    col_buf->ptr = mem_heap_alloc(tuple->heap, size);
+    col_buf->size = size;
   }
 
+  auto dst = col_buf->ptr;
+
   if (dst == nullptr) {
     return DB_OUT_OF_MEMORY;
   }
@@ -3332,12 +5713,23 @@ ib_err_t ib_col_set_value(ib_tpl_t ib_tpl, ulint col_no, const void *s, ulint le
 ulint ib_col_get_len(ib_tpl_t ib_tpl, ulint i) {
   auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
 
-  auto dfield = ib_col_get_dfield(tuple, i);
-  auto data_len = dfield_get_len(dfield);
+  auto dfield = dtuple_get_nth_field(tuple->ptr, i);
+  auto data_len = ib_col_get_full_len(dfield);
 
   return data_len == UNIV_SQL_NULL ? IB_SQL_NULL : data_len;
 }
 
+/**
+ * Checks that a tuple read in zero-copy mode still points into a page that
+ * the cursor keeps latched, and that the page was not changed. Catches the
+ * use of the columns after the cursor was moved in debug builds.
+ *
+ * @param[in] tuple Tuple whose columns are read.
+ */
+static void ib_tuple_check_zero_copy(const ib_tuple_t *tuple) noexcept {
+  ut_ad(tuple->zc_block == nullptr || buf_block_get_modify_clock(tuple->zc_block) == tuple->zc_modify_clock);
+}
+
 /**
  * Copy a column value from the tuple.
  *
@@ -3351,6 +5743,8 @@ ulint ib_col_get_len(ib_tpl_t ib_tpl, ulint i) {
 static ulint ib_col_copy_value_low(ib_tpl_t ib_tpl, ulint i, void *dst, ulint len) noexcept {
   auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
 
+  ib_tuple_check_zero_copy(tuple);
+
   auto dfield = ib_col_get_dfield(tuple, i);
   auto data = static_cast<const byte *>(dfield_get_data(dfield));
   auto data_len = dfield_get_len(dfield);
@@ -3437,6 +5831,10 @@ static ib_col_attr_t ib_col_get_attr(ulint prtype) {
     attr |= IB_COL_CUSTOM3;
   }
 
+  if (prtype & DATA_COMMUTATIVE) {
+    attr |= IB_COL_COMMUTATIVE;
+  }
+
   return static_cast<ib_col_attr_t>(attr);
 }
 
@@ -3452,8 +5850,8 @@ static ib_col_attr_t ib_col_get_attr(ulint prtype) {
 static ulint ib_col_get_meta_low(ib_tpl_t ib_tpl, ulint i, ib_col_meta_t *ib_col_meta) noexcept {
   auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
 
-  auto dfield = ib_col_get_dfield(tuple, i);
-  auto data_len = dfield_get_len(dfield);
+  auto dfield = dtuple_get_nth_field(tuple->ptr, i);
+  auto data_len = ib_col_get_full_len(dfield);
 
   /* We assume 1-1 mapping between the ENUM and internal type codes. */
   ib_col_meta->type = static_cast<ib_col_type_t>(dtype_get_mtype(dfield_get_type(dfield)));
@@ -3594,11 +5992,62 @@ ib_err_t ib_tuple_read_u64(ib_tpl_t ib_tpl, ulint i, uint64_t *ival) {
 
 const void *ib_col_get_value(ib_tpl_t ib_tpl, ulint i) {
   auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+
+  ib_tuple_check_zero_copy(tuple);
   auto dfield = ib_col_get_dfield(tuple, i);
   auto data = dfield_get_data(dfield);
   auto data_len = dfield_get_len(dfield);
 
-  return data_len != UNIV_SQL_NULL ? data : nullptr;
+  return data_len != UNIV_SQL_NULL ? data : nullptr;
+}
+
+ib_err_t ib_col_blob_open(ib_tpl_t ib_tpl, ulint i, ib_blob_t *ib_blob) {
+  auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+
+  IB_CHECK_PANIC();
+
+  *ib_blob = nullptr;
+
+  const auto dfield = dtuple_get_nth_field(tuple->ptr, i);
+
+  if (dfield_is_null(dfield)) {
+    return DB_DATA_MISMATCH;
+  }
+
+  auto ptr = ut_new(sizeof(Blob_reader));
+
+  if (ptr == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  auto reader = new (ptr) Blob_reader(
+    srv_fsp, srv_btree_sys, static_cast<const byte *>(dfield_get_data(dfield)), dfield_get_len(dfield), dfield_is_ext(dfield)
+  );
+
+  *ib_blob = reinterpret_cast<ib_blob_t>(reader);
+
+  return DB_SUCCESS;
+}
+
+uint64_t ib_blob_get_len(ib_blob_t ib_blob) {
+  return reinterpret_cast<const Blob_reader *>(ib_blob)->get_len();
+}
+
+ib_err_t ib_blob_read(ib_blob_t ib_blob, uint64_t offset, void *dst, ulint len, ulint *n_read) {
+  auto reader = reinterpret_cast<Blob_reader *>(ib_blob);
+
+  IB_CHECK_PANIC();
+
+  *n_read = reader->read(offset, static_cast<byte *>(dst), len);
+
+  return DB_SUCCESS;
+}
+
+void ib_blob_close(ib_blob_t ib_blob) {
+  auto reader = reinterpret_cast<Blob_reader *>(ib_blob);
+
+  call_destructor(reader);
+  ut_delete(reader);
 }
 
 ulint ib_col_get_meta(ib_tpl_t ib_tpl, ulint i, ib_col_meta_t *ib_col_meta) {
@@ -3612,8 +6061,23 @@ ib_tpl_t ib_tuple_clear(ib_tpl_t ib_tpl) {
 
   const auto index = tuple->index;
   const auto n_cols = dtuple_get_n_fields(tuple->ptr);
+  const auto size = mem_heap_get_size(heap);
 
-  mem_heap_empty(heap);
+  if (UT_LIST_GET_LEN(heap->base) > 1 && size <= IB_TUPLE_HEAP_RETAIN_MAX) {
+    /* mem_heap_empty() would keep only the first block and the next
+    row would grow the heap again. Replace it with a single block that
+    has the capacity of the grown heap instead. */
+    auto new_heap = mem_heap_create(size);
+
+    if (new_heap != nullptr) {
+      mem_heap_free(heap);
+      heap = new_heap;
+    } else {
+      mem_heap_empty(heap);
+    }
+  } else {
+    mem_heap_empty(heap);
+  }
 
   if (type == TPL_ROW) {
     return ib_row_tuple_new_low(index, n_cols, heap);
@@ -3676,7 +6140,7 @@ ib_err_t ib_tuple_get_cluster_key(ib_crsr_t ib_crsr, ib_tpl_t *ib_dst_tpl, const
 }
 
 ib_err_t ib_tuple_copy(ib_tpl_t ib_dst_tpl, const ib_tpl_t ib_src_tpl) {
-  const ib_tuple_t *src_tuple = (const ib_tuple_t *)ib_src_tpl;
+  ib_tuple_t *src_tuple = (ib_tuple_t *)ib_src_tpl;
   ib_tuple_t *dst_tuple = (ib_tuple_t *)ib_dst_tpl;
 
   IB_CHECK_PANIC();
@@ -3690,6 +6154,8 @@ ib_err_t ib_tuple_copy(ib_tpl_t ib_dst_tpl, const ib_tpl_t ib_src_tpl) {
     return DB_DATA_MISMATCH;
   }
 
+  ib_tuple_fetch_extern(src_tuple);
+
   auto n_fields = dtuple_get_n_fields(src_tuple->ptr);
   ut_ad(n_fields == dtuple_get_n_fields(dst_tuple->ptr));
 
@@ -3803,9 +6269,29 @@ ib_err_t ib_cursor_truncate(ib_crsr_t *ib_crsr, ib_id_t *table_id) {
   return err;
 }
 
+ib_err_t ib_index_defragment(ib_crsr_t ib_crsr, ulint *n_pages_freed) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+
+  IB_CHECK_PANIC();
+
+  Btree_defrag defrag(srv_btree_sys, cursor->prebuilt->m_index);
+
+  defrag.run();
+
+  if (n_pages_freed != nullptr) {
+    *n_pages_freed = defrag.get_n_pages_freed();
+  }
+
+  return DB_SUCCESS;
+}
+
 ib_err_t ib_table_truncate(const char *table_name, ib_id_t *table_id) {
   IB_CHECK_PANIC();
 
+  if (srv_config.m_read_only) {
+    return DB_READONLY;
+  }
+
   auto ib_trx = ib_trx_begin(IB_TRX_SERIALIZABLE);
 
   srv_dict_sys->mutex_acquire();
@@ -3914,6 +6400,10 @@ bool ib_database_create(const char *dbname) {
     }
   }
 
+  if (srv_config.m_read_only) {
+    return false;
+  }
+
   /* Only necessary if file per table is set. */
   if (srv_config.m_file_per_table) {
     return srv_fil->mkdir(dbname);
@@ -3930,6 +6420,8 @@ ib_err_t ib_database_drop(const char *dbname) {
 
   if (len == 0) {
     return DB_INVALID_INPUT;
+  } else if (srv_config.m_read_only) {
+    return DB_READONLY;
   }
 
   auto ptr = reinterpret_cast<char *>(mem_alloc(len + 2));
@@ -3992,6 +6484,12 @@ ib_err_t ib_schema_lock_exclusive(ib_trx_t ib_trx) {
 
   IB_CHECK_PANIC();
 
+  /* The DDL takes the exclusive lock, it cannot run in a read-only instance
+  or in a read-only transaction. */
+  if (srv_config.m_read_only || ib_trx_is_read_only(trx)) {
+    return DB_READONLY;
+  }
+
   if (trx->m_dict_operation_lock_mode == 0 || trx->m_dict_operation_lock_mode == RW_X_LATCH) {
 
     srv_dict_sys->lock_data_dictionary(trx);
@@ -4039,6 +6537,8 @@ ib_err_t ib_cursor_lock(ib_crsr_t ib_crsr, ib_lck_mode_t ib_lck_mode) {
 
   IB_CHECK_PANIC();
 
+  ib_cursor_release_row(cursor);
+
   return ib_trx_lock_table_with_retry(trx, table, Lock_mode(ib_lck_mode));
 }
 
@@ -4130,6 +6630,39 @@ void ib_cursor_set_cluster_access(ib_crsr_t ib_crsr) {
   prebuilt->m_need_to_access_clustered = true;
 }
 
+ib_err_t ib_cursor_set_columns(ib_crsr_t ib_crsr, const ulint *cols, ulint n_cols) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  const auto index = prebuilt->m_index;
+  const auto n_user_cols = index->m_table->get_n_user_cols();
+
+  ib_cursor_release_row(cursor);
+
+  bool covered{true};
+
+  for (ulint i{}; i < n_cols; ++i) {
+    if (cols[i] >= n_user_cols) {
+      return DB_DATA_MISMATCH;
+    }
+
+    /* Only a whole column in the index covers it. */
+    const auto pos = index->get_nth_field_pos(cols[i]);
+
+    if (pos == ULINT_UNDEFINED || index->get_nth_field(pos)->m_prefix_len > 0) {
+      covered = false;
+    }
+  }
+
+  cursor->cols_declared = true;
+  cursor->cols_covered = covered;
+
+  /* A covered read still looks up the clustered index record when the
+  secondary index record may not be visible, see Row_sel::mvcc_fetch(). */
+  prebuilt->m_need_to_access_clustered = !index->is_clustered() && !covered;
+
+  return DB_SUCCESS;
+}
+
 void ib_cursor_set_simple_select(ib_crsr_t ib_crsr) {
   auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
   auto prebuilt = cursor->prebuilt;
@@ -4137,6 +6670,13 @@ void ib_cursor_set_simple_select(ib_crsr_t ib_crsr) {
   prebuilt->m_simple_select = true;
 }
 
+void ib_cursor_set_scan_resistant(ib_crsr_t ib_crsr) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+
+  prebuilt->m_scan_resistant = true;
+}
+
 void ib_savepoint_take(ib_trx_t ib_trx, const void *name, ulint name_len) {
   auto trx = reinterpret_cast<Trx *>(ib_trx);
 
@@ -4613,64 +7153,441 @@ ib_err_t ib_get_duplicate_key(ib_trx_t ib_trx, const char **table_name, const ch
     return DB_ERROR;
   }
 
-  *table_name = trx->m_error_info->get_table_name();
-  *index_name = trx->m_error_info->m_name;
+  *table_name = trx->m_error_info->get_table_name();
+  *index_name = trx->m_error_info->m_name;
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_get_table_statistics(ib_crsr_t ib_crsr, ib_table_stats_t *table_stats, size_t sizeof_ib_table_stats_t) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto table = cursor->prebuilt->m_table;
+
+  if (!table->m_stats.m_initialized) {
+    Dict_stats::init(table);
+  }
+
+  table_stats->stat_n_rows = table->m_stats.m_n_rows;
+  table_stats->stat_clustered_index_size = table->m_stats.m_clustered_index_size * UNIV_PAGE_SIZE;
+  table_stats->stat_sum_of_other_index_sizes = table->m_stats.m_sum_of_secondary_index_sizes * UNIV_PAGE_SIZE;
+  table_stats->stat_modified_counter = table->m_stats.m_modified_counter;
+
+  /* Callers built against the older, smaller struct don't have these. */
+  if (sizeof_ib_table_stats_t >= offsetof(ib_table_stats_t, untrimmed_bytes)) {
+    table_stats->lock_waits = table->m_lock_waits.m_n_waits.load(std::memory_order_relaxed);
+    table_stats->lock_wait_time_us = table->m_lock_waits.m_wait_us.load(std::memory_order_relaxed);
+  }
+
+  if (sizeof_ib_table_stats_t >= sizeof(ib_table_stats_t)) {
+    const auto n_pages = srv_fil_trim != nullptr ? srv_fil_trim->get_n_pages_untrimmed(table->m_space_id) : 0;
+
+    table_stats->untrimmed_bytes = uint64_t(n_pages) * UNIV_PAGE_SIZE;
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_get_index_stat_n_diff_key_vals(ib_crsr_t ib_crsr, const char *index_name, uint64_t *ncols, int64_t **n_diff) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto table = cursor->prebuilt->m_table;
+
+  if (!table->m_stats.m_initialized) {
+    Dict_stats::init(table);
+  }
+
+  auto index = table->get_index_on_name(index_name);
+
+  if (index == nullptr) {
+    return DB_NOT_FOUND;
+  }
+
+  *ncols = index->m_n_uniq;
+
+  *n_diff = (int64_t *)malloc(sizeof(int64_t) * index->m_n_uniq);
+
+  srv_dict_sys->index_stat_mutex_enter(index);
+
+  memcpy(*n_diff, index->m_stats.m_n_diff_key_vals, sizeof(int64_t) * index->m_n_uniq);
+
+  srv_dict_sys->index_stat_mutex_exit(index);
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_get_index_lock_wait_stats(ib_crsr_t ib_crsr, const char *index_name, uint64_t *lock_waits, uint64_t *lock_wait_time_us) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto table = cursor->prebuilt->m_table;
+  auto index = table->get_index_on_name(index_name);
+
+  if (index == nullptr) {
+    return DB_NOT_FOUND;
+  }
+
+  *lock_waits = index->m_lock_waits.m_n_waits.load(std::memory_order_relaxed);
+  *lock_wait_time_us = index->m_lock_waits.m_wait_us.load(std::memory_order_relaxed);
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_index_stats(ib_crsr_t ib_crsr, const char *index_name, ib_index_stats_t *index_stats, size_t sizeof_ib_index_stats_t) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto table = cursor->prebuilt->m_table;
+  auto index = table->get_index_on_name(index_name);
+
+  if (index == nullptr) {
+    return DB_NOT_FOUND;
+  }
+
+  if (sizeof_ib_index_stats_t < sizeof(ib_index_stats_t)) {
+    return DB_INVALID_INPUT;
+  }
+
+  const auto &counters = index->m_counters;
+
+  index_stats->rows_read = counters.value(Index::ROWS_READ);
+  index_stats->rows_inserted = counters.value(Index::ROWS_INSERTED);
+  index_stats->rows_updated = counters.value(Index::ROWS_UPDATED);
+  index_stats->rows_delete_marked = counters.value(Index::ROWS_DELETE_MARKED);
+  index_stats->rows_purged = counters.value(Index::ROWS_PURGED);
+  index_stats->page_splits = counters.value(Index::PAGE_SPLITS);
+  index_stats->page_merges = counters.value(Index::PAGE_MERGES);
+  index_stats->optimistic_inserts = counters.value(Index::OPTIMISTIC_INSERTS);
+  index_stats->pessimistic_inserts = counters.value(Index::PESSIMISTIC_INSERTS);
+  index_stats->page_reads = counters.value(Index::PAGE_READS);
+  index_stats->lock_waits = index->m_lock_waits.m_n_waits.load(std::memory_order_relaxed);
+  index_stats->lock_wait_time_us = index->m_lock_waits.m_wait_us.load(std::memory_order_relaxed);
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_update_table_statistics(ib_crsr_t crsr) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(crsr);
+  auto table = cursor->prebuilt->m_table;
+
+  if (auto err = Dict_stats::update(table); err != DB_SUCCESS) {
+    return err;
+  }
+
+  return Index_histogram::update(table);
+}
+
+ib_err_t ib_table_set_stats_sample_pages(ib_crsr_t crsr, uint64_t n_pages) {
+  auto cursor = reinterpret_cast<ib_cursor_t *>(crsr);
+
+  IB_CHECK_PANIC();
+
+  return Dict_stats::set_sample_pages(cursor->prebuilt->m_table, ulint(n_pages));
+}
+
+ib_err_t ib_cursor_estimate_range(
+  ib_crsr_t ib_crsr, ib_tpl_t ib_low, ib_srch_mode_t low_mode, ib_tpl_t ib_high, ib_srch_mode_t high_mode, int64_t *n_rows) {
+
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto index = cursor->prebuilt->m_index;
+
+  IB_CHECK_PANIC();
+
+  ib_cursor_release_row(cursor);
+
+  auto heap = mem_heap_create(64);
+  auto empty = dtuple_create(heap, 0);
+
+  auto key = [empty](ib_tpl_t ib_tpl) {
+    if (ib_tpl == nullptr) {
+      return empty;
+    }
+
+    auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+
+    ut_a(tuple->type == TPL_KEY);
+
+    return tuple->ptr;
+  };
+
+  auto low = key(ib_low);
+  auto high = key(ib_high);
+
+  Index_histogram::load_or_refresh(index);
+
+  Btree_cursor btr_cur(srv_fsp, srv_btree_sys);
+
+  *n_rows = btr_cur.estimate_n_rows_in_range(index, low, ulint(low_mode), high, ulint(high_mode));
+
+  mem_heap_free(heap);
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_cursor_sample(ib_crsr_t ib_crsr, ulint n, uint64_t seed, ib_tpl_t *ib_tpls, ulint *n_sampled) {
+  /* Descents per requested row, the rejected ones and the ones that find
+  an empty page included, before giving up on a small index. */
+  constexpr ulint MAX_DESCENTS_PER_ROW = 8;
+
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto prebuilt = cursor->prebuilt;
+  auto index = prebuilt->m_index;
+
+  IB_CHECK_PANIC();
+
+  ib_cursor_release_row(cursor);
+
+  ut_a(prebuilt->m_trx->m_conc_state != TRX_NOT_STARTED);
+  ut_a(prebuilt->m_select_lock_type <= LOCK_NUM);
+
+  *n_sampled = 0;
+
+  const auto n_fields = index->get_n_ordering_defined_by_user();
+  auto search_tuple = prebuilt->m_search_tuple;
+
+  /* The rows must stay valid after the next lookup. */
+  const auto zero_copy = cursor->zero_copy;
+
+  cursor->zero_copy = false;
+
+  auto rnd_state = ulint(seed);
+  double max_weight{};
+  ib_err_t err{DB_SUCCESS};
+  auto heap = mem_heap_create(256);
+  Btree_cursor btr_cur(srv_fsp, srv_btree_sys);
+
+  for (ulint i{}; i < n * MAX_DESCENTS_PER_ROW && *n_sampled < n; ++i) {
+    mtr_t mtr;
+    double weight;
+    DTuple *key{};
+
+    mtr.start();
+
+    btr_cur.open_at_rnd_pos(index, BTR_SEARCH_LEAF, &mtr, Current_location(), &rnd_state, &weight);
+
+    auto rec = btr_cur.get_rec();
+
+    if (page_rec_is_user_rec(rec)) {
+      /* A descent reaches a record with the probability 1 / weight. It is
+      accepted with a probability proportional to its weight, the largest
+      weight seen so far stands in for the unknown largest one. */
+      max_weight = std::max(max_weight, weight);
+
+      const auto accept = double(ut_rnd_gen_ulint(&rnd_state) % 1000000) / 1000000.0;
+
+      if (accept * max_weight < weight) {
+        key = index->build_data_tuple(rec, n_fields, heap);
+      }
+    }
+
+    mtr.commit();
+
+    if (key == nullptr) {
+      continue;
+    }
+
+    dtuple_set_n_fields(search_tuple, n_fields);
+    dtuple_set_n_fields_cmp(search_tuple, n_fields);
+
+    for (ulint j{}; j < n_fields; ++j) {
+      dfield_copy(dtuple_get_nth_field(search_tuple, j), dtuple_get_nth_field(key, j));
+    }
+
+    /* The record can have been deleted or be invisible to the transaction,
+    the next visible row is read instead. */
+    err = srv_row_sel->mvcc_fetch(srv_config.m_force_recovery, IB_CUR_GE, prebuilt, (ib_match_t)IB_CLOSEST_MATCH, ROW_SEL_MOVETO);
+
+    if (err == DB_SUCCESS) {
+      err = ib_cursor_read_row(ib_crsr, ib_tpls[*n_sampled]);
+
+      if (err == DB_SUCCESS) {
+        ++*n_sampled;
+      }
+    } else if (err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND) {
+      err = DB_SUCCESS;
+    }
+
+    mem_heap_empty(heap);
+
+    if (err != DB_SUCCESS) {
+      break;
+    }
+  }
+
+  cursor->zero_copy = zero_copy;
+
+  mem_heap_free(heap);
+
+  return err;
+}
+
+ib_err_t ib_buffer_pool_stats(ib_buffer_pool_stats_t **stats, uint64_t *n_stats) {
+  static_assert(IB_BUFFER_POOL_N_AGE_BUCKETS == Buf_index_stats::N_AGE_BUCKETS);
+
+  *stats = nullptr;
+  *n_stats = 0;
+
+  if (srv_buf_pool == nullptr) {
+    return DB_ERROR;
+  }
+
+  const auto index_stats = srv_buf_pool->get_index_stats();
+
+  if (index_stats.empty()) {
+    return DB_SUCCESS;
+  }
+
+  *stats = (ib_buffer_pool_stats_t *)malloc(sizeof(ib_buffer_pool_stats_t) * index_stats.size());
+
+  if (*stats == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  for (const auto &src : index_stats) {
+    auto &dst = (*stats)[(*n_stats)++];
+
+    dst.space_id = src.m_space_id;
+    dst.index_id = src.m_index_id;
+    dst.n_pages = src.m_n_pages;
+    dst.n_dirty = src.m_n_dirty;
+    dst.n_old = src.m_n_old;
+    dst.n_young = src.m_n_pages - src.m_n_old;
+
+    std::copy(src.m_n_age.begin(), src.m_n_age.end(), dst.n_age);
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_buffer_pool_page_visit(ib_buffer_pool_page_visit_cb_t callback, void *arg) {
+  static_assert(IB_BUF_PAGE_FILE_PAGE == ulint(BUF_BLOCK_FILE_PAGE));
+  static_assert(IB_BUF_PAGE_REMOVE_HASH == ulint(BUF_BLOCK_REMOVE_HASH));
+
+  if (srv_buf_pool == nullptr) {
+    return DB_ERROR;
+  }
+
+  const auto completed = srv_buf_pool->visit_pages([&](const Buf_page_info &info) {
+    ib_buffer_pool_page_t page{};
+
+    page.instance = uint32_t(info.m_instance_no);
+    page.state = ib_buffer_page_state_t(info.m_state);
+    page.space_id = info.m_space_id;
+    page.page_no = info.m_page_no;
+    page.page_type = info.m_page_type;
+    page.index_id = info.m_index_id;
+    page.fix_count = uint32_t(info.m_buf_fix_count);
+    page.io_pending = info.m_io_fix != BUF_IO_NONE;
+    page.dirty = info.m_oldest_modification != 0;
+    page.oldest_modification = info.m_oldest_modification;
+    page.newest_modification = info.m_newest_modification;
+    page.access_time = info.m_access_time;
+    page.old = info.m_old;
+    page.lru_age = info.m_LRU_age;
+
+    return callback(arg, &page) == 0;
+  });
+
+  return completed ? DB_SUCCESS : DB_INTERRUPTED;
+}
+
+ib_err_t ib_tablespace_io_visit(ib_tablespace_io_visit_cb_t callback, void *arg) {
+  static_assert(IB_IO_PAGE_N_CLASSES == FIL_IO_PAGE_CLASS_COUNT);
+  static_assert(IB_IO_PAGE_OTHER == ulint(Fil_io_page_class::OTHER));
+
+  if (srv_fil == nullptr) {
+    return DB_ERROR;
+  }
+
+  auto copy = [](const auto &from, ib_io_counters_t *to) {
+    for (ulint i{}; i < FIL_IO_PAGE_CLASS_COUNT; ++i) {
+      to[i].n_ios = from[i].m_n_ios;
+      to[i].n_bytes = from[i].m_n_bytes;
+      to[i].latency_us = from[i].m_latency_us;
+    }
+  };
 
-  return DB_SUCCESS;
-}
+  for (const auto &snapshot : srv_fil->get_io_stats()) {
+    ib_tablespace_io_stats_t stats{};
 
-ib_err_t ib_get_table_statistics(ib_crsr_t ib_crsr, ib_table_stats_t *table_stats, size_t sizeof_ib_table_stats_t) {
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
-  auto table = cursor->prebuilt->m_table;
+    stats.space_id = snapshot.m_space_id;
+    stats.name = snapshot.m_name.c_str();
+    stats.n_pending = snapshot.m_n_pending;
 
-  if (!table->m_stats.m_initialized) {
-    srv_dict_sys->update_statistics(table);
-  }
+    copy(snapshot.m_reads, stats.reads);
+    copy(snapshot.m_writes, stats.writes);
 
-  table_stats->stat_n_rows = table->m_stats.m_n_rows;
-  table_stats->stat_clustered_index_size = table->m_stats.m_clustered_index_size * UNIV_PAGE_SIZE;
-  table_stats->stat_sum_of_other_index_sizes = table->m_stats.m_sum_of_secondary_index_sizes * UNIV_PAGE_SIZE;
-  table_stats->stat_modified_counter = table->m_stats.m_modified_counter;
+    if (callback(arg, &stats) != 0) {
+      return DB_INTERRUPTED;
+    }
+  }
 
   return DB_SUCCESS;
 }
 
-ib_err_t ib_get_index_stat_n_diff_key_vals(ib_crsr_t ib_crsr, const char *index_name, uint64_t *ncols, int64_t **n_diff) {
-  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
-  auto table = cursor->prebuilt->m_table;
+ib_err_t ib_log_stream_open(uint64_t start_lsn, ib_log_stream_t *ib_stream) {
+  IB_CHECK_PANIC();
 
-  if (!table->m_stats.m_initialized) {
-    srv_dict_sys->update_statistics(table);
+  *ib_stream = nullptr;
+
+  if (!srv_was_started) {
+    return DB_ERROR;
   }
 
-  auto index = table->get_index_on_name(index_name);
+  Log_stream *stream;
 
-  if (index == nullptr) {
-    return DB_NOT_FOUND;
+  if (auto err = Log_stream::create(start_lsn, stream); err != DB_SUCCESS) {
+    return err;
   }
 
-  *ncols = index->m_n_uniq;
+  *ib_stream = reinterpret_cast<ib_log_stream_t>(stream);
 
-  *n_diff = (int64_t *)malloc(sizeof(int64_t) * index->m_n_uniq);
+  return DB_SUCCESS;
+}
 
-  srv_dict_sys->index_stat_mutex_enter(index);
+ib_err_t ib_log_stream_read(ib_log_stream_t ib_stream, ib_log_rec_t *rec) {
+  IB_CHECK_PANIC();
 
-  memcpy(*n_diff, index->m_stats.m_n_diff_key_vals, sizeof(int64_t) * index->m_n_uniq);
+  auto stream = reinterpret_cast<Log_stream *>(ib_stream);
 
-  srv_dict_sys->index_stat_mutex_exit(index);
+  Log_stream::Record log_rec;
+
+  if (auto err = stream->next(log_rec); err != DB_SUCCESS) {
+    return err;
+  }
+
+  rec->lsn = log_rec.m_lsn;
+  rec->end_lsn = log_rec.m_end_lsn;
+  rec->type = log_rec.m_type;
+  rec->space_id = log_rec.m_space;
+  rec->page_no = log_rec.m_page_no;
+  rec->mtr_end = log_rec.m_mtr_end;
+  rec->body = log_rec.m_body;
+  rec->body_len = log_rec.m_body_len;
 
   return DB_SUCCESS;
 }
 
-ib_err_t ib_update_table_statistics(ib_crsr_t crsr) {
-  auto cursor = reinterpret_cast<ib_cursor_t *>(crsr);
-  auto table = cursor->prebuilt->m_table;
+ib_err_t ib_log_stream_close(ib_log_stream_t ib_stream) {
+  auto stream = reinterpret_cast<Log_stream *>(ib_stream);
 
-  srv_dict_sys->update_statistics(table);
+  Log_stream::destroy(stream);
 
   return DB_SUCCESS;
 }
 
+ib_err_t ib_backup(ib_backup_t &opts) {
+  IB_CHECK_PANIC();
+
+  if (!srv_was_started || !opts.sink) {
+    return DB_ERROR;
+  }
+
+  Backup backup(srv_fil, opts.sink, opts.since_lsn, opts.max_pages_per_sec);
+
+  const auto err = backup.run();
+
+  opts.start_lsn = backup.get_start_lsn();
+  opts.end_lsn = backup.get_end_lsn();
+  opts.n_pages = backup.get_n_pages();
+
+  return err;
+}
+
 ib_err_t ib_error_inject(int error_to_inject) {
   if (error_to_inject == 1) {
     log_fatal("test panic message");
@@ -4700,6 +7617,9 @@ ib_err_t ib_parallel_select_count_star(ib_trx_t ib_trx, std::vector<ib_crsr_t> &
     auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
     Parallel_reader::Config config(full_scan, cursor->prebuilt->m_index);
 
+    /* A full scan for an aggregate must not evict the working set. */
+    config.m_scan_resistant = true;
+
     err = reader.add_scan(trx, config, [&](const Parallel_reader::Ctx *ctx) {
       n_recs.inc(1, ctx->thread_id());
       return DB_SUCCESS;
@@ -4734,51 +7654,270 @@ ib_err_t ib_parallel_select_count_star(ib_trx_t ib_trx, std::vector<ib_crsr_t> &
   return err;
 }
 
-static dberr_t check_table(Trx *trx, Index *index, size_t n_threads) {
-  ut_a(n_threads > 1);
+ib_err_t ib_parallel_scan(ib_trx_t ib_trx, ib_crsr_t ib_crsr, size_t n_threads, const ib_tpl_t ib_start, const ib_tpl_t ib_end, const ib_parallel_scan_t &cbs) {
+  IB_CHECK_PANIC();
 
-  using Shards = ut::Sharded_counter<Parallel_reader::MAX_THREADS>;
+  ut_a(n_threads > 0);
+  ut_a(cbs.row || (cbs.batch && cbs.batch_size > 0));
+
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+  auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
+  auto index = cursor->prebuilt->m_index;
+  const auto start = reinterpret_cast<const ib_tuple_t *>(ib_start);
+  const auto end = reinterpret_cast<const ib_tuple_t *>(ib_end);
 
-  Shards n_recs{};
-  Shards n_dups{};
-  Shards n_corrupt{};
+  /* The reader only scans clustered indexes. */
+  if (!index->is_clustered() || trx->m_conc_state != TRX_ACTIVE) {
+    return DB_ERROR;
+  }
 
-  n_dups.clear();
-  n_recs.clear();
-  n_corrupt.clear();
+  for (auto key : {start, end}) {
+    if (key != nullptr && (key->type != TPL_KEY || key->index != index)) {
+      return DB_DATA_MISMATCH;
+    }
+  }
+
+  /* All the threads read the same snapshot. */
+  auto rv = trx->assign_read_view();
+  ut_a(rv != nullptr);
+
+  const auto n_cols = index->m_table->get_n_cols();
+  const Parallel_reader::Scan_range range(start != nullptr ? start->ptr : nullptr, end != nullptr ? end->ptr : nullptr);
+  Parallel_reader::Config config(range, index);
+
+  auto err = ib_filters_build(index, cbs.filters, cbs.filter_values, config.m_filters);
+
+  if (err != DB_SUCCESS) {
+    return err;
+  }
+
+  /* Positions in the clustered index of the columns to read. */
+  std::vector<ulint> fields{};
+
+  for (auto col : cbs.cols) {
+    if (col >= n_cols) {
+      return DB_DATA_MISMATCH;
+    }
+
+    fields.push_back(index->get_nth_field_pos(col));
+  }
+
+  n_threads = Parallel_reader::available_threads(n_threads, false);
+
+  /* The column batches of each thread, a single threaded run uses the first. */
+  std::vector<std::vector<ib_col_batch_t>> batches;
+
+  if (cbs.batch) {
+    std::vector<ib_col_batch_t> cols;
+
+    for (ulint i{}; i < (cbs.cols.empty() ? n_cols : cbs.cols.size()); ++i) {
+      ib_col_batch_t col{};
+
+      col.col = cbs.cols.empty() ? i : cbs.cols[i];
+      cols.push_back(std::move(col));
+    }
+
+    err = ib_col_batch_fields(index, cols, fields);
+    ut_a(err == DB_SUCCESS);
 
-  using Tuples = std::vector<DTuple *>;
-  using Heaps = std::vector<mem_heap_t *>;
-  using Blocks = std::vector<const Buf_block *>;
+    ib_col_batch_clear(cols);
 
-  Heaps heaps;
-  Tuples prev_tuples;
-  Blocks prev_blocks;
+    batches.assign(std::max(n_threads, size_t(1)), cols);
+  }
+
+  /* The statistics of each thread, a single threaded run uses the first. */
+  std::vector<ib_parallel_scan_stats_t> stats;
 
-  for (size_t i = 0; i < n_threads; ++i) {
-    heaps.push_back(mem_heap_create(4096));
+  if (cbs.stats) {
+    stats.resize(std::max(n_threads, size_t(1)));
   }
 
   Parallel_reader reader(n_threads);
-  Parallel_reader::Scan_range full_scan;
-  Parallel_reader::Config config(full_scan, index);
 
-  auto err = reader.add_scan(trx, config, [&](const Parallel_reader::Ctx *ctx) {
+  /* The heap of a thread holds the tuple of the row it is visiting. */
+  reader.set_start_callback([&](Parallel_reader::Thread_ctx *thread_ctx) -> dberr_t {
+    if (thread_ctx->get_state() == Parallel_reader::State::CTX && cbs.stats) {
+      /* The rows of the range are counted by the row visitor below. */
+      stats[thread_ctx->m_thread_id].range_rows.push_back(0);
+    }
+
+    if (thread_ctx->get_state() != Parallel_reader::State::THREAD) {
+      return DB_SUCCESS;
+    }
+
+    thread_ctx->set_callback_ctx(mem_heap_create(UNIV_PAGE_SIZE));
+
+    return cbs.init ? cbs.init(thread_ctx->m_thread_id) : DB_SUCCESS;
+  });
+
+  reader.set_finish_callback([&](Parallel_reader::Thread_ctx *thread_ctx) -> dberr_t {
+    if (thread_ctx->get_state() != Parallel_reader::State::THREAD) {
+      return DB_SUCCESS;
+    }
+
+    auto heap = thread_ctx->get_callback_ctx<mem_heap_t>();
+
+    if (heap != nullptr) {
+      mem_heap_free(heap);
+      thread_ctx->set_callback_ctx<mem_heap_t>(nullptr);
+    }
+
+    dberr_t err{DB_SUCCESS};
+
+    /* Deliver the rows of the last, partial batch. */
+    if (cbs.batch && !reader.is_error_set()) {
+      const auto &batch = batches[thread_ctx->m_thread_id];
+
+      if (batch.front().n_rows() > 0) {
+        err = cbs.batch(thread_ctx->m_thread_id, batch);
+      }
+    }
+
+    if (cbs.finish) {
+      const auto finish_err = cbs.finish(thread_ctx->m_thread_id);
+
+      if (err == DB_SUCCESS) {
+        err = finish_err;
+      }
+    }
+
+    if (cbs.stats) {
+      const auto &thread_stats = thread_ctx->m_stats;
+      auto &s = stats[thread_ctx->m_thread_id];
+
+      s.n_ranges = thread_stats.m_n_ctxs;
+      s.n_pages = thread_stats.m_n_pages;
+      s.n_skipped = thread_stats.m_n_skipped;
+      s.scan_ns = thread_stats.m_traverse_ns.count();
+      s.dequeue_ns = thread_stats.m_dequeue_ns.count();
+      s.idle_ns = thread_stats.m_idle_ns.count();
+
+      cbs.stats(thread_ctx->m_thread_id, s);
+    }
+
+    return err;
+  });
+
+  /* A full scan must not evict the working set. */
+  config.m_scan_resistant = start == nullptr && end == nullptr;
+
+  err = reader.add_scan(trx, config, [&](const Parallel_reader::Ctx *ctx) -> dberr_t {
+    auto heap = ctx->thread_ctx()->get_callback_ctx<mem_heap_t>();
+
+    mem_heap_empty(heap);
+
+    if (cbs.stats) {
+      auto &s = stats[ctx->thread_id()];
+
+      ++s.n_rows;
+      ++s.range_rows.back();
+    }
+
+    if (cbs.batch) {
+      auto &batch = batches[ctx->thread_id()];
+
+      ib_col_batch_append(ctx->m_rec, ctx->m_offsets, index, fields, batch, heap);
+
+      if (batch.front().n_rows() < cbs.batch_size) {
+        return DB_SUCCESS;
+      }
+
+      const auto err = cbs.batch(ctx->thread_id(), batch);
+
+      ib_col_batch_clear(batch);
+
+      return err;
+    }
+
+    auto ib_tpl = ib_row_tuple_new_low(index, n_cols, heap);
+    auto tuple = reinterpret_cast<ib_tuple_t *>(ib_tpl);
+
+    if (fields.empty()) {
+      ib_read_tuple(ctx->m_rec, tuple, false);
+    } else {
+      ib_read_tuple_fields(ctx->m_rec, ctx->m_offsets, tuple, fields);
+    }
+
+    return cbs.row(ctx->thread_id(), ib_tpl);
+  });
+
+  if (err == DB_SUCCESS) {
+    err = reader.run(n_threads);
+  }
+
+  if (err == DB_OUT_OF_RESOURCES) {
+    log_warn(
+      "Resource not available to create threads for parallel scan."
+      " Falling back to single thread mode."
+    );
+
+    for (auto &s : stats) {
+      s = ib_parallel_scan_stats_t{};
+    }
+
+    err = reader.run(0);
+  }
+
+  return err;
+}
+
+/** State of the check of one index by check_table(). */
+struct Check_index {
+  using Shards = ut::Sharded_counter<Parallel_reader::MAX_THREADS>;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] index Index to check.
+   * @param[in] n_threads Number of scan threads.
+   */
+  Check_index(Index *index, size_t n_threads) noexcept : m_index(index) {
+    n_threads = std::max(n_threads, size_t(1));
+
+    m_prev_tuples.resize(n_threads);
+    m_prev_blocks.resize(n_threads);
+
+    for (size_t i{}; i < n_threads; ++i) {
+      m_heaps.push_back(mem_heap_create(4096));
+    }
+
+    m_n_recs.clear();
+    m_n_pages.clear();
+    m_n_dups.clear();
+    m_n_corrupt.clear();
+    m_n_bad_pages.clear();
+  }
+
+  /** Destructor. */
+  ~Check_index() noexcept {
+    for (auto heap : m_heaps) {
+      mem_heap_free(heap);
+    }
+  }
+
+  /**
+   * Checks a record against the previous record read by the thread and, on
+   * the first record of a page, the page.
+   *
+   * @param[in] ctx Scan context of the record.
+   */
+  void check(const Parallel_reader::Ctx *ctx) noexcept {
     const auto rec = ctx->m_rec;
     const auto block = ctx->m_block;
     const auto id = ctx->thread_id();
+    const auto index = m_index;
 
-    n_recs.inc(1, id);
+    m_n_recs.inc(1, id);
 
-    auto heap = heaps[id];
+    auto heap = m_heaps[id];
 
     if (ctx->m_start) {
       /* Starting scan of a new range. We need to reset the previous tuple
       because we don't know what the value of the previous last tuple was. */
-      prev_tuples[id] = nullptr;
+      m_prev_tuples[id] = nullptr;
     }
 
-    auto prev_tuple = prev_tuples[id];
+    auto prev_tuple = m_prev_tuples[id];
     ulint *offsets{};
 
     {
@@ -4811,7 +7950,7 @@ static dberr_t check_table(Trx *trx, Index *index, size_t n_threads) {
         std::ostringstream rec_os{};
         std::ostringstream dtuple_os{};
 
-        n_corrupt.inc(1, id);
+        m_n_corrupt.inc(1, id);
         prev_tuple->print(dtuple_os);
         rec_os << rec_to_string(rec);
 
@@ -4829,7 +7968,7 @@ static dberr_t check_table(Trx *trx, Index *index, size_t n_threads) {
         std::ostringstream rec_os{};
         std::ostringstream dtuple_os{};
 
-        n_dups.inc(1, id);
+        m_n_dups.inc(1, id);
         rec_os << rec_to_string(rec);
         prev_tuple->print(dtuple_os);
 
@@ -4839,61 +7978,191 @@ static dberr_t check_table(Trx *trx, Index *index, size_t n_threads) {
       }
     }
 
-    if (prev_blocks[id] != block || prev_blocks[id] == nullptr) {
+    if (m_prev_blocks[id] != block || m_prev_blocks[id] == nullptr) {
+      m_n_pages.inc(1, id);
+
+      if (!page_validate(block->get_frame(), index)) {
+        m_n_bad_pages.inc(1, id);
+
+        log_err(std::format("Page {} of index {} of table {} is corrupt", block->get_page_no(), index->m_name, index->m_table->m_name));
+      }
+
       mem_heap_empty(heap);
 
       Phy_rec record{index, rec};
 
       offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
 
-      prev_blocks[id] = block;
+      m_prev_blocks[id] = block;
     }
 
     ulint n_ext{};
 
-    prev_tuples[id] = row_rec_to_index_entry(ROW_COPY_DATA, rec, index, offsets, &n_ext, heap);
+    m_prev_tuples[id] = row_rec_to_index_entry(ROW_COPY_DATA, rec, index, offsets, &n_ext, heap);
+  }
 
-    return DB_SUCCESS;
-  });
+  /**
+   * Gets the result of the check.
+   *
+   * @return the result, err is set if the index has errors.
+   */
+  ib_check_table_t::index_t result() noexcept {
+    ib_check_table_t::index_t result{};
 
-  if (err == DB_SUCCESS) {
-    prev_tuples.resize(n_threads);
-    prev_blocks.resize(n_threads);
+    result.name = m_index->m_name;
+    result.n_recs = m_n_recs.value();
+    result.n_pages = m_n_pages.value();
+    result.n_dups = m_n_dups.value();
+    result.n_wrong_order = m_n_corrupt.value();
+    result.n_bad_pages = m_n_bad_pages.value();
+
+    if (result.n_dups > 0) {
+      log_err("Found ", result.n_dups, " duplicate rows in ", m_index->m_name);
+      result.err = DB_DUPLICATE_KEY;
+    }
+
+    if (result.n_wrong_order > 0) {
+      log_err("Found ", result.n_wrong_order, " rows in the wrong order in ", m_index->m_name);
+      result.err = DB_INDEX_CORRUPT;
+    }
+
+    if (result.n_bad_pages > 0) {
+      log_err("Found ", result.n_bad_pages, " corrupt pages in ", m_index->m_name);
+      result.err = DB_INDEX_CORRUPT;
+    }
+
+    return result;
+  }
+
+  /** Index checked. */
+  Index *m_index{};
+
+  /** Last record read by each thread, as a tuple. */
+  std::vector<DTuple *> m_prev_tuples;
+
+  /** Page of the last record read by each thread. */
+  std::vector<const Buf_block *> m_prev_blocks;
+
+  /** Heap of each thread for its last record. */
+  std::vector<mem_heap_t *> m_heaps;
 
+  /** Number of records read. */
+  Shards m_n_recs{};
+
+  /** Number of leaf pages read. */
+  Shards m_n_pages{};
+
+  /** Number of duplicate keys. */
+  Shards m_n_dups{};
+
+  /** Number of records in the wrong order. */
+  Shards m_n_corrupt{};
+
+  /** Number of pages that failed page_validate(). */
+  Shards m_n_bad_pages{};
+};
+
+/**
+ * Checks indexes of a table, their leaf pages are scanned together by the
+ * same threads. The records are read as they are stored, without a read view,
+ * so that the number of records of the indexes can be compared.
+ *
+ * @param[in] indexes Indexes to check, if the first one is the clustered index
+ *  the number of records in the others must match it.
+ * @param[in] n_threads Number of threads to use.
+ * @param[in,out] check The rate limit, and the results of the indexes on return.
+ *
+ * @return DB_SUCCESS or the error of the first index that has errors.
+ */
+static dberr_t check_table(const std::vector<Index *> &indexes, size_t n_threads, ib_check_table_t &check) {
+  std::vector<std::unique_ptr<Check_index>> checks;
+
+  for (auto index : indexes) {
+    checks.push_back(std::make_unique<Check_index>(index, n_threads));
+  }
+
+  Parallel_reader reader(n_threads);
+
+  reader.set_max_pages_per_sec(check.max_pages_per_sec);
+
+  dberr_t err{DB_SUCCESS};
+
+  for (auto &index_check : checks) {
+    Parallel_reader::Scan_range full_scan;
+    Parallel_reader::Config config(full_scan, index_check->m_index);
+
+    config.m_scan_resistant = true;
+
+    err = reader.add_scan(nullptr, config, [c = index_check.get()](const Parallel_reader::Ctx *ctx) {
+      c->check(ctx);
+      return DB_SUCCESS;
+    });
+
+    if (err != DB_SUCCESS) {
+      break;
+    }
+  }
+
+  if (err == DB_SUCCESS) {
     err = reader.run(n_threads);
   }
 
   if (err == DB_OUT_OF_RESOURCES) {
-    ut_a(n_threads > 0);
     log_warn("Resource not available to create threads for parallel scan. Trying single threaded mode.");
 
     err = reader.run(0);
   }
 
-  for (auto heap : heaps) {
-    mem_heap_free(heap);
+  check.indexes.clear();
+
+  for (auto &index_check : checks) {
+    check.indexes.push_back(index_check->result());
   }
 
-  if (n_dups.value() > 0) {
-    log_err("Found ", n_dups.value(), " duplicate rows in ", index->m_name);
-    err = DB_DUPLICATE_KEY;
+  if (err != DB_SUCCESS) {
+    return err;
+  }
+
+  const auto &clust = check.indexes.front();
+
+  if (indexes.front()->is_clustered()) {
+    for (size_t i{1}; i < check.indexes.size(); ++i) {
+      auto &result = check.indexes[i];
+
+      if (result.n_recs != clust.n_recs) {
+        log_err(std::format(
+          "Index {} of table {} has {} entries, the clustered index has {}",
+          result.name,
+          indexes[i]->m_table->m_name,
+          result.n_recs,
+          clust.n_recs
+        ));
+
+        if (result.err == DB_SUCCESS) {
+          result.err = DB_INDEX_CORRUPT;
+        }
+      }
+    }
   }
 
-  if (n_corrupt.value() > 0) {
-    log_err("Found ", n_corrupt.value(), " rows in the wrong order in ", index->m_name);
-    err = DB_INDEX_CORRUPT;
+  for (const auto &result : check.indexes) {
+    if (result.err != DB_SUCCESS) {
+      return result.err;
+    }
   }
 
-  return err;
+  return DB_SUCCESS;
 }
 
-ib_err_t ib_check_table(ib_trx_t *ib_trx, ib_crsr_t ib_crsr, size_t n_threads) {
+ib_err_t ib_check_table(ib_trx_t ib_trx, ib_crsr_t ib_crsr, size_t n_threads, ib_check_table_t *check) {
   auto trx = reinterpret_cast<Trx *>(ib_trx);
   auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
   auto prebuilt = cursor->prebuilt;
   auto index = prebuilt->m_index;
 
-  ut_a(prebuilt->m_trx->m_conc_state == TRX_NOT_STARTED);
+  IB_CHECK_PANIC();
+
+  ut_a(prebuilt->m_table == index->m_table);
 
   if (index->is_clustered()) {
     /* The clustered index of a table is always available. During online ALTER TABLE
@@ -4906,24 +8175,28 @@ ib_err_t ib_check_table(ib_trx_t *ib_trx, ib_crsr_t ib_crsr, size_t n_threads) {
     return DB_DDL_IN_PROGRESS;
   }
 
-  if (trx->m_isolation_level > TRX_ISO_READ_UNCOMMITTED && prebuilt->m_select_lock_type == LOCK_NONE && index->is_clustered() &&
-      trx->m_client_n_tables_locked == 0) {
-    n_threads = Parallel_reader::available_threads(n_threads, false);
+  if (trx->m_isolation_level == TRX_ISO_READ_UNCOMMITTED || prebuilt->m_select_lock_type != LOCK_NONE ||
+      trx->m_client_n_tables_locked > 0) {
+    log_err("Invalid transaction state for check table");
+    return DB_ERROR;
+  }
 
-    auto rv = trx->assign_read_view();
-    ut_a(rv != nullptr);
+  std::vector<Index *> indexes;
 
-    auto trx = prebuilt->m_trx;
+  indexes.push_back(index);
 
-    ut_a(prebuilt->m_table == index->m_table);
+  if (index->is_clustered()) {
+    for (auto sec_index = index->get_next(); sec_index != nullptr; sec_index = sec_index->get_next()) {
+      /* Skip secondary indexes that are being created online. */
+      if (!sec_index->is_online_ddl_in_progress()) {
+        indexes.push_back(sec_index);
+      }
+    }
+  }
 
-    std::vector<Index *> indexes;
+  n_threads = Parallel_reader::available_threads(n_threads, false);
 
-    indexes.push_back(index);
+  ib_check_table_t local_check{};
 
-    return check_table(trx, index, n_threads);
-  } else {
-    log_err("Invalid transaction state for check table");
-    return DB_ERROR;
-  }
+  return check_table(indexes, n_threads, check != nullptr ? *check : local_check);
 }
@@ -23,17 +23,41 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <strings.h>
 #endif /** HAVE_STRINGS_H */
 
+#include <utility>
+
+#include "btr0sea.h"
+#include "buf0dblwr.h"
+#include "buf0flu.h"
 #include "buf0lru.h"
 #include "db0err.h"
 #include "dict0dict.h"
 #include "innodb0types.h"
 #include "log0recv.h"
+#include "os0proc.h"
 #include "os0sync.h"
+#include "os0thread.h"
 #include "srv0srv.h"
+#include "trx0rseg.h"
 #include "trx0sys.h"
+#include "ut0wait.h"
 
 static char *srv_file_flush_method_str = nullptr;
 
+static char *srv_buf_pool_huge_pages_str = nullptr;
+
+static char *srv_buf_pool_numa_str = nullptr;
+
+static char *srv_doublewrite_mode_str = nullptr;
+
+static char *srv_flush_neighbors_str = nullptr;
+
+static char *srv_log_checksum_algorithm_str = nullptr;
+
+static char *srv_log_io_mode_str = nullptr;
+
+/** The CPUs of the thread classes, see os_thread_set_class_cpus(). */
+static char *srv_thread_cpus_str[OS_THREAD_N_CLASSES];
+
 /* A point in the LRU list (expressed as a percent), all blocks from this
 point onwards (inclusive) are considered "old" blocks. */
 static ulint lru_old_blocks_pct;
@@ -349,6 +373,254 @@ static ib_err_t ib_cfg_var_set_flush_method(struct ib_cfg_var *cfg_var, const vo
 }
 
 /* @} */
+
+/**
+ * Set the value of the config variable "buffer_pool_huge_pages".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "buffer_pool_huge_pages"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_buffer_pool_huge_pages(struct ib_cfg_var *cfg_var, const void *value) {
+  const char *value_str;
+  ib_err_t err = DB_SUCCESS;
+
+  ut_a(strcasecmp(cfg_var->name, "buffer_pool_huge_pages") == 0);
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  value_str = *(const char **)value;
+
+  if (0 == strcmp(value_str, "off")) {
+    srv_config.m_buf_pool_huge_pages = OS_HUGE_PAGES_OFF;
+  } else if (0 == strcmp(value_str, "transparent")) {
+    srv_config.m_buf_pool_huge_pages = OS_HUGE_PAGES_TRANSPARENT;
+  } else if (0 == strcmp(value_str, "2M")) {
+    srv_config.m_buf_pool_huge_pages = OS_HUGE_PAGES_2M;
+  } else if (0 == strcmp(value_str, "1G")) {
+    srv_config.m_buf_pool_huge_pages = OS_HUGE_PAGES_1G;
+  } else {
+    err = DB_INVALID_INPUT;
+  }
+
+  if (err == DB_SUCCESS) {
+    *(const char **)cfg_var->tank = value_str;
+  }
+
+  return err;
+}
+
+/**
+ * Set the value of the config variable "buffer_pool_numa".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "buffer_pool_numa"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_buffer_pool_numa(struct ib_cfg_var *cfg_var, const void *value) {
+  const char *value_str;
+  ib_err_t err = DB_SUCCESS;
+
+  ut_a(strcasecmp(cfg_var->name, "buffer_pool_numa") == 0);
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  value_str = *(const char **)value;
+
+  if (0 == strcmp(value_str, "off")) {
+    srv_config.m_buf_pool_numa = OS_NUMA_OFF;
+  } else if (0 == strcmp(value_str, "interleave")) {
+    srv_config.m_buf_pool_numa = OS_NUMA_INTERLEAVE;
+  } else if (0 == strcmp(value_str, "bind")) {
+    srv_config.m_buf_pool_numa = OS_NUMA_BIND;
+  } else {
+    err = DB_INVALID_INPUT;
+  }
+
+  if (err == DB_SUCCESS) {
+    *(const char **)cfg_var->tank = value_str;
+  }
+
+  return err;
+}
+
+/**
+ * Set the value of the config variable "doublewrite_mode".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "doublewrite_mode"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_doublewrite_mode(struct ib_cfg_var *cfg_var, const void *value) {
+  const char *value_str;
+  ib_err_t err = DB_SUCCESS;
+
+  ut_a(strcasecmp(cfg_var->name, "doublewrite_mode") == 0);
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  value_str = *(const char **)value;
+
+  if (0 == strcmp(value_str, "single")) {
+    srv_config.m_doublewrite_mode = DBLWR_MODE_SINGLE;
+  } else if (0 == strcmp(value_str, "parallel")) {
+    srv_config.m_doublewrite_mode = DBLWR_MODE_PARALLEL;
+  } else if (0 == strcmp(value_str, "auto")) {
+    srv_config.m_doublewrite_mode = DBLWR_MODE_AUTO;
+  } else if (0 == strcmp(value_str, "atomic")) {
+    srv_config.m_doublewrite_mode = DBLWR_MODE_ATOMIC;
+  } else {
+    err = DB_INVALID_INPUT;
+  }
+
+  if (err == DB_SUCCESS) {
+    *(const char **)cfg_var->tank = value_str;
+  }
+
+  return err;
+}
+
+/**
+ * Set the value of the config variable "log_checksum_algorithm".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "log_checksum_algorithm"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_log_checksum_algorithm(struct ib_cfg_var *cfg_var, const void *value) {
+  const char *value_str;
+  ib_err_t err = DB_SUCCESS;
+
+  ut_a(strcasecmp(cfg_var->name, "log_checksum_algorithm") == 0);
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  value_str = *(const char **)value;
+
+  if (0 == strcmp(value_str, "crc32c")) {
+    srv_config.m_log_checksum_algorithm = LOG_CHECKSUM_CRC32C;
+  } else if (0 == strcmp(value_str, "innodb")) {
+    srv_config.m_log_checksum_algorithm = LOG_CHECKSUM_INNODB;
+  } else {
+    err = DB_INVALID_INPUT;
+  }
+
+  if (err == DB_SUCCESS) {
+    *(const char **)cfg_var->tank = value_str;
+  }
+
+  return err;
+}
+
+/**
+ * Set the value of the config variable "log_io_mode".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "log_io_mode"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_log_io_mode(struct ib_cfg_var *cfg_var, const void *value) {
+  const char *value_str;
+  ib_err_t err = DB_SUCCESS;
+
+  ut_a(strcasecmp(cfg_var->name, "log_io_mode") == 0);
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  value_str = *(const char **)value;
+
+  if (0 == strcmp(value_str, "buffered")) {
+    srv_config.m_log_io_mode = LOG_IO_BUFFERED;
+  } else if (0 == strcmp(value_str, "direct")) {
+    srv_config.m_log_io_mode = LOG_IO_DIRECT;
+  } else if (0 == strcmp(value_str, "direct_dsync")) {
+    srv_config.m_log_io_mode = LOG_IO_DIRECT_DSYNC;
+  } else {
+    err = DB_INVALID_INPUT;
+  }
+
+  if (err == DB_SUCCESS) {
+    *(const char **)cfg_var->tank = value_str;
+  }
+
+  return err;
+}
+
+/**
+ * Set the value of one of the config variables "*_thread_cpus".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be one of "*_thread_cpus"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_thread_cpus(struct ib_cfg_var *cfg_var, const void *value) {
+  static constexpr std::pair<const char *, os_thread_class_t> classes[] = {
+    {"io_thread_cpus", OS_THREAD_CLASS_IO},
+    {"log_thread_cpus", OS_THREAD_CLASS_LOG},
+    {"master_thread_cpus", OS_THREAD_CLASS_MASTER},
+    {"monitor_thread_cpus", OS_THREAD_CLASS_MONITOR},
+    {"task_thread_cpus", OS_THREAD_CLASS_TASK},
+    {"reader_thread_cpus", OS_THREAD_CLASS_READER},
+    {"flush_thread_cpus", OS_THREAD_CLASS_FLUSH}};
+
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  auto value_str = *(const char **)value;
+
+  for (const auto &[name, thread_class] : classes) {
+    if (strcasecmp(cfg_var->name, name) == 0) {
+      if (!os_thread_set_class_cpus(thread_class, value_str)) {
+        return DB_INVALID_INPUT;
+      }
+
+      *(const char **)cfg_var->tank = value_str;
+
+      return DB_SUCCESS;
+    }
+  }
+
+  ut_error;
+
+  return DB_ERROR;
+}
+
+/**
+ * Set the value of the config variable "flush_neighbors".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "flush_neighbors"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_flush_neighbors(struct ib_cfg_var *cfg_var, const void *value) {
+  const char *value_str;
+  ib_err_t err = DB_SUCCESS;
+
+  ut_a(strcasecmp(cfg_var->name, "flush_neighbors") == 0);
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  value_str = *(const char **)value;
+
+  if (0 == strcmp(value_str, "off")) {
+    srv_config.m_flush_neighbors = FLUSH_NEIGHBORS_OFF;
+  } else if (0 == strcmp(value_str, "contiguous")) {
+    srv_config.m_flush_neighbors = FLUSH_NEIGHBORS_CONTIGUOUS;
+  } else if (0 == strcmp(value_str, "area")) {
+    srv_config.m_flush_neighbors = FLUSH_NEIGHBORS_AREA;
+  } else if (0 == strcmp(value_str, "auto")) {
+    srv_config.m_flush_neighbors = FLUSH_NEIGHBORS_AUTO;
+  } else {
+    err = DB_INVALID_INPUT;
+  }
+
+  if (err == DB_SUCCESS) {
+    *(const char **)cfg_var->tank = value_str;
+  }
+
+  return err;
+}
+
 /**
  * Retrieve the value of the config variable "log_group_home_dir".
  *
@@ -391,12 +663,129 @@ static ib_err_t ib_cfg_var_set_LRU_old_blocks_pct(struct ib_cfg_var *cfg_var, co
   }
 
   if (srv_buf_pool != nullptr) {
-    srv_buf_pool->m_LRU->old_ratio_update(*(ulint *)value, true);
+    srv_buf_pool->old_ratio_update(*(ulint *)value, true);
   }
 
   return DB_SUCCESS;
 }
 
+/**
+ * Set the value of the config variable "log_buffer_size". Once InnoDB has
+ * been started the log buffer is resized online.
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "log_buffer_size"
+ * @param value - in: value to set, must point to ulint variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_log_buffer_size(struct ib_cfg_var *cfg_var, const void *value) {
+  ut_a(strcasecmp(cfg_var->name, "log_buffer_size") == 0);
+  ut_a(cfg_var->type == IB_CFG_ULINT);
+
+  if (cfg_var->validate != nullptr) {
+    ib_err_t ret;
+
+    ret = cfg_var->validate(cfg_var, value);
+
+    if (ret != DB_SUCCESS) {
+      return (ret);
+    }
+  }
+
+  if (srv_was_started) {
+    const auto size = *(ulint *)value;
+
+    /* The buffer shrinks back to this size when it has grown. */
+    srv_config.m_log_buffer_size = ut_uint64_align_up(size, UNIV_PAGE_SIZE) / UNIV_PAGE_SIZE;
+
+    log_sys->resize_buffer(size);
+  }
+
+  return ib_cfg_assign(cfg_var->type, cfg_var->tank, value);
+}
+
+/**
+ * Set the value of the config variable "log_files_in_group". Once InnoDB has
+ * been started the log files are added or removed online.
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "log_files_in_group"
+ * @param value - in: value to set, must point to ulint variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_log_files_in_group(struct ib_cfg_var *cfg_var, const void *value) {
+  ut_a(strcasecmp(cfg_var->name, "log_files_in_group") == 0);
+  ut_a(cfg_var->type == IB_CFG_ULINT);
+
+  if (cfg_var->validate != nullptr) {
+    ib_err_t ret;
+
+    ret = cfg_var->validate(cfg_var, value);
+
+    if (ret != DB_SUCCESS) {
+      return (ret);
+    }
+  }
+
+  if (srv_was_started) {
+    if (auto err = log_sys->resize_files(*(ulint *)value); err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  return ib_cfg_assign(cfg_var->type, cfg_var->tank, value);
+}
+
+/**
+ * Set the value of the config variable "buffer_pool_size". Once InnoDB has
+ * been started the buffer pool is resized online.
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "buffer_pool_size"
+ * @param value - in: value to set, must point to ulint variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_buffer_pool_size(struct ib_cfg_var *cfg_var, const void *value) {
+  ut_a(strcasecmp(cfg_var->name, "buffer_pool_size") == 0);
+  ut_a(cfg_var->type == IB_CFG_ULINT);
+
+  if (cfg_var->validate != nullptr) {
+    ib_err_t ret;
+
+    ret = cfg_var->validate(cfg_var, value);
+
+    if (ret != DB_SUCCESS) {
+      return (ret);
+    }
+  }
+
+  if (srv_was_started && !srv_buf_pool->resize(*(ulint *)value)) {
+    return DB_ERROR;
+  }
+
+  return ib_cfg_assign(cfg_var->type, cfg_var->tank, value);
+}
+
+/**
+ * Set the value of the config variable "adaptive_hash_index". Turning the
+ * adaptive hash index off empties it.
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "adaptive_hash_index"
+ * @param value - in: value to set, must point to bool variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_adaptive_hash_index(struct ib_cfg_var *cfg_var, const void *value) {
+  ut_a(strcasecmp(cfg_var->name, "adaptive_hash_index") == 0);
+  ut_a(cfg_var->type == IB_CFG_IBOOL);
+
+  if (srv_btr_search != nullptr) {
+    srv_btr_search->set_enabled(*static_cast<const bool *>(value));
+  }
+
+  return ib_cfg_assign(cfg_var->type, cfg_var->tank, value);
+}
+
 /* @} */
 
 /* ib_cfg_var_get_generic() is used to get the value of lru_old_blocks_pct */
@@ -432,24 +821,167 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_adaptive_flushing)},
 
-  {STRUCT_FLD(name, "additional_mem_pool_size"),
+  {STRUCT_FLD(name, "adaptive_hash_index"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_adaptive_hash_index),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_adaptive_hash_index)},
+
+  {STRUCT_FLD(name, "adaptive_hash_index_parts"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
-   STRUCT_FLD(min_val, 512 * 1024),
-   STRUCT_FLD(max_val, IB_UINT64_T_MAX),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 512),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_adaptive_hash_index_parts)},
+
+  {STRUCT_FLD(name, "additional_mem_pool_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 512 * 1024),
+   STRUCT_FLD(max_val, IB_UINT64_T_MAX),
    STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
    STRUCT_FLD(set, ib_cfg_var_set_generic),
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_mem_pool_size)},
 
-  {STRUCT_FLD(name, "buffer_pool_size"),
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "aio_per_cpu_queues"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_aio_per_cpu_queues)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "aio_sqpoll"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_aio_sqpoll)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "aio_write_coalesce_window"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
-   STRUCT_FLD(min_val, 5 * 1024 * 1024),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 100000),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_aio_write_coalesce_window)},
+
+  {STRUCT_FLD(name, "buffer_pool_chunk_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1024 * 1024),
    STRUCT_FLD(max_val, ULINT_MAX),
    STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
    STRUCT_FLD(set, ib_cfg_var_set_generic),
    STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_chunk_size)},
+
+  {STRUCT_FLD(name, "buffer_pool_dump_at_shutdown"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_dump_at_shutdown)},
+
+  {STRUCT_FLD(name, "buffer_pool_dump_interval"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_dump_interval)},
+
+  {STRUCT_FLD(name, "buffer_pool_dump_pct"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 100),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_dump_pct)},
+
+  {STRUCT_FLD(name, "buffer_pool_huge_pages"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_buffer_pool_huge_pages),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_buf_pool_huge_pages_str)},
+
+  {STRUCT_FLD(name, "buffer_pool_instances"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, MAX_BUFFER_POOLS),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_instances)},
+
+  {STRUCT_FLD(name, "buffer_pool_load_at_startup"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_load_at_startup)},
+
+  {STRUCT_FLD(name, "buffer_pool_numa"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_buffer_pool_numa),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_buf_pool_numa_str)},
+
+  {STRUCT_FLD(name, "buffer_pool_prefault"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_prefault)},
+
+  {STRUCT_FLD(name, "buffer_pool_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 5 * 1024 * 1024),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_buffer_pool_size),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_buf_pool_size)},
 
   {STRUCT_FLD(name, "checksums"),
@@ -462,6 +994,17 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_use_checksums)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "concurrency_tickets"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_concurrency_tickets)},
+
   {STRUCT_FLD(name, "data_file_path"),
    STRUCT_FLD(type, IB_CFG_TEXT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -491,6 +1034,29 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(set, ib_cfg_var_set_generic),
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_use_doublewrite_buf)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "dict_table_cache_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_dict_table_cache_size)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "doublewrite_mode"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_doublewrite_mode),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_doublewrite_mode_str)},
+
   {STRUCT_FLD(name, "file_per_table"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -501,6 +1067,38 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_file_per_table)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "file_preallocate_extents"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 1024),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_file_preallocate_extents)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "file_trim_freed_extents"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_file_trim_freed_extents)},
+
+  {STRUCT_FLD(name, "fill_factor"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 10),
+   STRUCT_FLD(max_val, 100),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_fill_factor)},
+
   {STRUCT_FLD(name, "flush_log_at_trx_commit"),
    STRUCT_FLD(type, IB_CFG_ULONG),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -521,6 +1119,39 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_file_flush_method_str)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "flush_neighbors"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_flush_neighbors),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_flush_neighbors_str)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "flush_read_throttle"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_flush_read_throttle)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "flush_thread_cpus"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_thread_cpus),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_thread_cpus_str[OS_THREAD_CLASS_FLUSH])},
+
   {STRUCT_FLD(name, "force_recovery"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -531,6 +1162,17 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_force_recovery)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "index_build_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 64),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_index_build_threads)},
+
   {STRUCT_FLD(name, "io_capacity"),
    STRUCT_FLD(type, IB_CFG_ULONG),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -541,6 +1183,92 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_io_capacity)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "io_thread_cpus"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_thread_cpus),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_thread_cpus_str[OS_THREAD_CLASS_IO])},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "l2_cache_file"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_l2_cache_file)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "l2_cache_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_l2_cache_size)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "latch_profile"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &sync_latch_profile)},
+
+  {STRUCT_FLD(name, "lazy_checksums"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_lazy_checksums)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "lazy_tablespace_load"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_lazy_tablespace_load)},
+
+  {STRUCT_FLD(name, "leaf_prefetch_pages"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 64),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_leaf_prefetch_pages)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "lock_grant_by_weight"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_lock_grant_by_weight)},
+
   {STRUCT_FLD(name, "lock_wait_timeout"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -551,16 +1279,49 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &ses_lock_wait_timeout)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "log_archive_dir"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_log_archive_dir)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "log_buffer_max_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, IB_UINT64_T_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_log_buffer_max_size)},
+
   {STRUCT_FLD(name, "log_buffer_size"),
    STRUCT_FLD(type, IB_CFG_ULINT),
-   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
    STRUCT_FLD(min_val, 256 * 1024),
    STRUCT_FLD(max_val, IB_UINT64_T_MAX),
    STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
-   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(set, ib_cfg_var_set_log_buffer_size),
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_log_buffer_curr_size)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "log_checksum_algorithm"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_log_checksum_algorithm),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_log_checksum_algorithm_str)},
+
   {STRUCT_FLD(name, "log_file_size"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -573,11 +1334,11 @@ static const ib_cfg_var cfg_vars_defaults[] = {
 
   {STRUCT_FLD(name, "log_files_in_group"),
    STRUCT_FLD(type, IB_CFG_ULINT),
-   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
    STRUCT_FLD(min_val, 2),
    STRUCT_FLD(max_val, 100),
    STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
-   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(set, ib_cfg_var_set_log_files_in_group),
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_n_log_files)},
 
@@ -591,6 +1352,28 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_log_group_home_dir),
    STRUCT_FLD(tank, nullptr)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "log_io_mode"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_log_io_mode),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_log_io_mode_str)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "log_thread_cpus"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_thread_cpus),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_thread_cpus_str[OS_THREAD_CLASS_LOG])},
+
   {STRUCT_FLD(name, "max_dirty_pages_pct"),
    STRUCT_FLD(type, IB_CFG_ULONG),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -611,6 +1394,39 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_max_purge_lag)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "max_purge_lag_delay"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 10000000),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_max_purge_lag_delay)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "master_thread_cpus"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_thread_cpus),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_thread_cpus_str[OS_THREAD_CLASS_MASTER])},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "monitor_thread_cpus"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_thread_cpus),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_thread_cpus_str[OS_THREAD_CLASS_MONITOR])},
+
   {STRUCT_FLD(name, "lru_old_blocks_pct"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -631,6 +1447,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &Buf_LRU::s_old_threshold_ms)},
 
+  {STRUCT_FLD(name, "lru_protected_pct"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 50),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_lru_protected_pct)},
+
   {STRUCT_FLD(name, "open_files"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -641,6 +1467,26 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_max_n_open_files)},
 
+  {STRUCT_FLD(name, "page_cleaner_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 64),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_page_cleaner_threads)},
+
+  {STRUCT_FLD(name, "page_compression"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_page_compression)},
+
   {STRUCT_FLD(name, "read_io_threads"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -651,6 +1497,17 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_n_read_io_threads)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "recovery_apply_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 64),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_recovery_apply_threads)},
+
   {STRUCT_FLD(name, "write_io_threads"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -683,6 +1540,49 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_print_verbose_log)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "purge_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 64),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_purge_threads)},
+
+  {STRUCT_FLD(name, "random_read_ahead"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_random_read_ahead)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "read_only"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_read_only)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "reader_thread_cpus"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_thread_cpus),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_thread_cpus_str[OS_THREAD_CLASS_READER])},
+
   /* New, not present in InnoDB/MySQL */
   {STRUCT_FLD(name, "rollback_on_timeout"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
@@ -694,6 +1594,28 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &ses_rollback_on_timeout)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "rollback_segments"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, TRX_SYS_N_RSEGS),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_rollback_segments)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "slow_op_threshold_us"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_slow_op_threshold_us)},
+
   {STRUCT_FLD(name, "stats_sample_pages"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -724,6 +1646,83 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_n_spin_wait_rounds)},
 
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "tablespace_load_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 64),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_tablespace_load_threads)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "task_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 256),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_task_threads)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "task_thread_cpus"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_thread_cpus),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_thread_cpus_str[OS_THREAD_CLASS_TASK])},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "thread_concurrency"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 1000),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_thread_concurrency)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "thread_concurrency_autotune"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_thread_concurrency_autotune)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "truncate_in_place"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_truncate_in_place)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "undo_cache_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, TRX_RSEG_N_SLOTS / 2),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_undo_cache_size)},
+
   {STRUCT_FLD(name, "use_sys_malloc"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -747,6 +1746,39 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    ),
    STRUCT_FLD(get, ib_cfg_var_get_version),
    STRUCT_FLD(tank, nullptr)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "version_cache_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_vers_cache_size)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "wait_trace"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &ut_wait_trace)},
+
+  /* New, not present in InnoDB/MySQL */
+  {STRUCT_FLD(name, "wait_trace_events"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 16),
+   STRUCT_FLD(max_val, 1024 * 1024),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &ut_wait_trace_events)},
 };
 /* @} */
 
@@ -939,20 +1971,77 @@ ib_err_t ib_cfg_init() {
   if (ib_cfg_set(name, var) != DB_SUCCESS) \
   ut_error
 
+  IB_CFG_SET("adaptive_hash_index", true);
+  IB_CFG_SET("adaptive_hash_index_parts", 8);
   IB_CFG_SET("additional_mem_pool_size", 4 * 1024 * 1024);
+  IB_CFG_SET("aio_per_cpu_queues", false);
+  IB_CFG_SET("aio_sqpoll", false);
+  IB_CFG_SET("aio_write_coalesce_window", 200);
+  IB_CFG_SET("buffer_pool_chunk_size", 128 * 1024 * 1024);
+  IB_CFG_SET("buffer_pool_dump_at_shutdown", true);
+  IB_CFG_SET("buffer_pool_dump_interval", 0);
+  IB_CFG_SET("buffer_pool_dump_pct", 25);
+  IB_CFG_SET("buffer_pool_huge_pages", "off");
+  IB_CFG_SET("buffer_pool_instances", 1);
+  IB_CFG_SET("buffer_pool_load_at_startup", true);
+  IB_CFG_SET("buffer_pool_numa", "off");
+  IB_CFG_SET("buffer_pool_prefault", false);
   IB_CFG_SET("buffer_pool_size", 8 * 1024 * 1024);
+  IB_CFG_SET("concurrency_tickets", 500);
   IB_CFG_SET("data_home_dir", "./");
+  IB_CFG_SET("dict_table_cache_size", 4096);
+  IB_CFG_SET("doublewrite_mode", "single");
   IB_CFG_SET("file_per_table", true);
+  IB_CFG_SET("file_preallocate_extents", 16);
+  IB_CFG_SET("file_trim_freed_extents", false);
+  IB_CFG_SET("fill_factor", 100);
   IB_CFG_SET("flush_method", "fsync");
+  IB_CFG_SET("flush_neighbors", "auto");
+  IB_CFG_SET("flush_read_throttle", true);
+  IB_CFG_SET("flush_thread_cpus", "");
+  IB_CFG_SET("index_build_threads", 4);
+  IB_CFG_SET("io_thread_cpus", "");
+  IB_CFG_SET("l2_cache_size", 1024 * 1024 * 1024);
+  IB_CFG_SET("latch_profile", false);
+  IB_CFG_SET("lazy_checksums", false);
+  IB_CFG_SET("lazy_tablespace_load", false);
+  IB_CFG_SET("leaf_prefetch_pages", 16);
   IB_CFG_SET("lock_wait_timeout", 60);
   IB_CFG_SET("log_buffer_size", 384 * 1024);
+  IB_CFG_SET("log_buffer_max_size", 16 * 1024 * 1024);
+  IB_CFG_SET("log_checksum_algorithm", "crc32c");
   IB_CFG_SET("log_file_size", 16 * 1024 * 1024);
   IB_CFG_SET("log_files_in_group", 2);
   IB_CFG_SET("log_group_home_dir", ".");
+  IB_CFG_SET("log_io_mode", "buffered");
+  IB_CFG_SET("log_thread_cpus", "");
   IB_CFG_SET("lru_old_blocks_pct", 3 * 100 / 8);
   IB_CFG_SET("lru_block_access_recency", 0);
+  IB_CFG_SET("lru_protected_pct", 5);
+  IB_CFG_SET("master_thread_cpus", "");
+  IB_CFG_SET("monitor_thread_cpus", "");
+  IB_CFG_SET("page_cleaner_threads", 4);
+  IB_CFG_SET("page_compression", false);
+  IB_CFG_SET("purge_threads", 4);
+  IB_CFG_SET("lock_grant_by_weight", false);
+  IB_CFG_SET("random_read_ahead", false);
+  IB_CFG_SET("read_only", false);
+  IB_CFG_SET("reader_thread_cpus", "");
   IB_CFG_SET("rollback_on_timeout", true);
+  IB_CFG_SET("rollback_segments", 1);
   IB_CFG_SET("read_io_threads", 4);
+  IB_CFG_SET("recovery_apply_threads", 4);
+  IB_CFG_SET("slow_op_threshold_us", 0);
+  IB_CFG_SET("tablespace_load_threads", 8);
+  IB_CFG_SET("task_threads", 8);
+  IB_CFG_SET("task_thread_cpus", "");
+  IB_CFG_SET("thread_concurrency", 0);
+  IB_CFG_SET("thread_concurrency_autotune", false);
+  IB_CFG_SET("truncate_in_place", false);
+  IB_CFG_SET("undo_cache_size", 256);
+  IB_CFG_SET("version_cache_size", 1024 * 1024);
+  IB_CFG_SET("wait_trace", false);
+  IB_CFG_SET("wait_trace_events", 4096);
   IB_CFG_SET("write_io_threads", 4);
 #undef IB_CFG_SET
 
@@ -27,7 +27,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include "api0misc.h"
 #include "dict0dict.h"
-#include "dict0dict.h"
+#include "dict0stats.h"
 #include "innodb0types.h"
 #include "lock0lock.h"
 #include "pars0pars.h"
@@ -77,6 +77,7 @@ bool ib_handle_errors(db_err *new_err, Trx *trx, que_thr_t *thr, trx_savept_t *s
         /* fall through */
       case DB_DUPLICATE_KEY:
       case DB_FOREIGN_DUPLICATE_KEY:
+      case DB_WOULD_BLOCK:
       case DB_TOO_BIG_RECORD:
       case DB_ROW_IS_REFERENCED:
       case DB_NO_REFERENCED_ROW:
@@ -91,6 +92,16 @@ bool ib_handle_errors(db_err *new_err, Trx *trx, que_thr_t *thr, trx_savept_t *s
         }
         break;
       case DB_LOCK_WAIT:
+        if (trx->m_wake && srv_lock_sys->cancel_wait_nonblocking(trx, trx->m_wake)) {
+          /* The thread is running again, handle it like a lock wait timeout,
+          the caller retries the call once the callback has been invoked. */
+          trx->m_error_state = DB_WOULD_BLOCK;
+
+          que_thr_stop_client(thr);
+
+          continue;
+        }
+
         InnoDB::suspend_user_thread(thr);
 
         if (trx->m_error_state != DB_SUCCESS) {
@@ -204,18 +215,11 @@ db_err ib_trx_lock_table_with_retry(Trx *trx, Table *table, enum Lock_mode mode)
 }
 
 void ib_update_statistics_if_needed(Table *table) {
-  auto counter = table->m_stats.m_modified_counter++;
-
-  /* Calculate new statistics if 1 / 16 of table has been modified
-  since the last time a statistics batch was run, or if
-  stat_modified_counter > 2 000 000 000 (to avoid wrap-around).
-  We calculate statistics at most every 16th round, since we may have
-  a counter table which is very small and updated very often. */
+  /* Checked by Index_histogram::load_or_refresh() */
+  ++table->m_stats.m_hist_modified_counter;
 
-  if (counter > 2000000000 || ((int64_t)counter > 16 + table->m_stats.m_n_rows / 16)) {
-
-    srv_dict_sys->update_statistics(table);
-  }
+  /* The statistics are recalculated by the master thread. */
+  Dict_stats::row_modified(table);
 }
 
 const char *ib_strerror(ib_err_t err) {
@@ -316,6 +320,8 @@ const char *ib_strerror(ib_err_t err) {
       return "Index corrupt";
     case DB_DDL_IN_PROGRESS:
       return "DDL in progress";
+    case DB_WOULD_BLOCK:
+      return "Operation would block";
   }
 
   /* Do not add default: in order to produce a warning if new code
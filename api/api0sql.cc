@@ -30,11 +30,107 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #endif
 
 #include "api0api.h"
+#include "api0misc.h"
 #include "dict0dict.h"
 #include "pars0pars.h"
 #include "que0que.h"
 #include "trx0roll.h"
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/** The query graphs of the statements run with ib_exec_sql() and
+ib_exec_ddl_sql(), by the SQL text and the names and types of the arguments.
+A graph is removed from the cache while it runs. It refers to the cached
+tables and indexes, it is only reused at the dictionary schema version that
+it was parsed at. */
+struct Sql_cache {
+  /** Maximum number of cached graphs. */
+  static constexpr ulint MAX_GRAPHS = 128;
+
+  /** A cached graph. */
+  struct Entry {
+    /** The query graph. */
+    que_t *m_graph;
+
+    /** Dict::m_schema_version when the graph was parsed. */
+    ulint m_schema_version;
+  };
+
+  /**
+   * Removes a graph from the cache. The caller must own the dictionary mutex.
+   *
+   * @param[in] key             Key of the statement.
+   *
+   * @return the graph or nullptr if there is none for the current schema.
+   */
+  que_t *acquire(const std::string &key) {
+    ut_ad(mutex_own(&srv_dict_sys->m_mutex));
+
+    Entry entry;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto it = m_graphs.find(key);
+
+      if (it == m_graphs.end()) {
+        return nullptr;
+      }
+
+      entry = it->second;
+      m_graphs.erase(it);
+    }
+
+    if (entry.m_schema_version != srv_dict_sys->m_schema_version) {
+      que_graph_free(entry.m_graph);
+      return nullptr;
+    }
+
+    return entry.m_graph;
+  }
+
+  /**
+   * Returns a graph to the cache, frees it if the cache is full or already
+   * has a graph for the statement.
+   *
+   * @param[in] key             Key of the statement.
+   * @param[in] graph           Graph to cache.
+   * @param[in] schema_version  Dict::m_schema_version when it was parsed.
+   */
+  void release(std::string &&key, que_t *graph, ulint schema_version) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_graphs.size() < MAX_GRAPHS && m_graphs.emplace(std::move(key), Entry{graph, schema_version}).second) {
+        return;
+      }
+    }
+
+    que_graph_free(graph);
+  }
+
+  /** Frees the cached graphs. */
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto &[key, entry] : m_graphs) {
+      que_graph_free(entry.m_graph);
+    }
+
+    m_graphs.clear();
+  }
+
+  /** Protects m_graphs. */
+  std::mutex m_mutex{};
+
+  /** The cached graphs. */
+  std::unordered_map<std::string, Entry> m_graphs{};
+};
+
+static Sql_cache sql_cache;
+
 /**
  * Function to parse ib_exec_sql() and ib_exec_ddl_sql() args.
  *
@@ -117,6 +213,119 @@ static pars_info_t *ib_exec_vsql(int n_args, va_list ap) {
  return info;
 }
 
+/**
+ * Builds the cache key of a statement. The bound literals are part of the
+ * parsed graph by name and type, the bound ids by value.
+ *
+ * @param[in] sql               SQL text.
+ * @param[in] info              Arguments of the statement.
+ * @param[out] key              The key.
+ *
+ * @return false if the graph can't be cached, it calls user functions.
+ */
+static bool ib_sql_cache_key(const char *sql, const pars_info_t *info, std::string &key) {
+  if (!info->m_funcs.empty()) {
+    return false;
+  }
+
+  key = sql;
+
+  for (const auto blit : info->m_bound_lits) {
+    key += std::format("\n:{} {} {}", blit->name, blit->type, blit->prtype);
+
+    if (blit->type != DATA_VARCHAR && blit->type != DATA_BLOB) {
+      key += std::format(" {}", blit->length);
+    }
+  }
+
+  for (const auto bid : info->m_bound_ids) {
+    key += std::format("\n${} {}", bid->name, bid->id);
+  }
+
+  return true;
+}
+
+/**
+ * Runs a statement, with a cached graph if there is one.
+ *
+ * @param[in] info              Arguments of the statement, freed on return.
+ * @param[in] sql               SQL text.
+ * @param[in] reserve_dict_mutex If true, acquire the dictionary mutex,
+ *                              otherwise the caller owns it.
+ * @param[in] trx               Transaction.
+ *
+ * @return error code or DB_SUCCESS
+ */
+static db_err ib_eval_sql(pars_info_t *info, const char *sql, bool reserve_dict_mutex, Trx *trx) {
+  std::string key;
+  const auto cacheable = ib_sql_cache_key(sql, info, key);
+
+  ut_a(trx->m_error_state == DB_SUCCESS);
+
+  if (reserve_dict_mutex) {
+    srv_dict_sys->mutex_acquire();
+  }
+
+  auto graph = cacheable ? sql_cache.acquire(key) : nullptr;
+  const auto schema_version = srv_dict_sys->m_schema_version;
+
+  if (graph != nullptr) {
+    pars_rebind_literals(graph, info);
+  } else {
+    /* The graph owns info, a cached graph keeps the info that it was
+    parsed with. */
+    graph = pars_sql(info, sql);
+    info = nullptr;
+  }
+
+  if (reserve_dict_mutex) {
+    srv_dict_sys->mutex_release();
+  }
+
+  ut_a(graph != nullptr);
+
+  graph->trx = trx;
+  trx->m_graph = nullptr;
+
+  graph->fork_type = QUE_FORK_USER_INTERFACE;
+
+  auto thr = que_fork_start_command(graph);
+  ut_a(thr != nullptr);
+
+  que_run_threads(thr);
+
+  if (info != nullptr) {
+    pars_info_free(info);
+  }
+
+  const auto err = trx->m_error_state;
+
+  if (reserve_dict_mutex) {
+    srv_dict_sys->mutex_acquire();
+  }
+
+  /* A statement that changed the schema, e.g., created a table, can't
+  be run again from the same graph. */
+  const auto unchanged = schema_version == srv_dict_sys->m_schema_version;
+
+  if (reserve_dict_mutex) {
+    srv_dict_sys->mutex_release();
+  }
+
+  if (cacheable && unchanged && err == DB_SUCCESS) {
+    graph->trx = nullptr;
+    sql_cache.release(std::move(key), graph, schema_version);
+  } else {
+    que_graph_free(graph);
+  }
+
+  return err;
+}
+
+void ib_sql_cache_clear() {
+  sql_cache.clear();
+}
+
 ib_err_t ib_exec_sql( const char *sql, ulint n_args, ...) {
   va_list ap;
 
@@ -135,7 +344,7 @@ ib_err_t ib_exec_sql( const char *sql, ulint n_args, ...) {
   trx->m_op_info = "exec client sql";
 
   /* Note that we've already acquired the dictionary mutex. */
-  auto err = que_eval_sql(info, sql, true, trx);
+  auto err = ib_eval_sql(info, sql, true, trx);
   ut_a(err == DB_SUCCESS);
 
   if (err != DB_SUCCESS) {
@@ -154,6 +363,11 @@ ib_err_t ib_exec_sql( const char *sql, ulint n_args, ...) {
 ib_err_t ib_exec_ddl_sql(const char *sql, ulint n_args, ...) {
   va_list ap;
 
+  /* The exclusive schema lock is not granted in a read-only instance. */
+  if (srv_config.m_read_only) {
+    return DB_READONLY;
+  }
+
   va_start(ap, n_args);
 
   auto info = ib_exec_vsql(n_args, ap);
@@ -174,7 +388,7 @@ ib_err_t ib_exec_ddl_sql(const char *sql, ulint n_args, ...) {
 
   /* Note that we've already acquired the dictionary mutex by
   setting reserve_dict_mutex to false. */
-  err = que_eval_sql(info, sql, false, trx);
+  err = ib_eval_sql(info, sql, false, trx);
   ut_a(err == DB_SUCCESS);
 
   err = ib_schema_unlock((ib_trx_t)trx);
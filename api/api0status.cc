@@ -26,6 +26,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "api0ucode.h"
 #include "innodb0types.h"
 #include "srv0srv.h"
+#include "ut0wait.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 /** InnoDB status variables types. */
 enum ib_status_type_t {
@@ -72,6 +77,14 @@ static const ib_status_t status_vars[] = {
 
   {"bytes_total_read", IB_STATUS_ULINT, &export_vars.innodb_data_read},
 
+  {"bytes_compressed_saved", IB_STATUS_ULINT, &export_vars.innodb_data_compressed_saved},
+
+  {"pages_preallocated", IB_STATUS_ULINT, &export_vars.innodb_data_pages_preallocated},
+
+  {"pages_trimmed", IB_STATUS_ULINT, &export_vars.innodb_data_pages_trimmed},
+
+  {"pages_untrimmed", IB_STATUS_ULINT, &export_vars.innodb_data_pages_untrimmed},
+
   /* Buffer pool related */
   {"buffer_pool_current_size", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_pages_total},
 
@@ -83,6 +96,10 @@ static const ib_status_t status_vars[] = {
 
   {"buffer_pool_free_pages", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_pages_free},
 
+  {"buffer_pool_huge_pages", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_huge_pages},
+
+  {"buffer_pool_numa", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_numa},
+
   {"buffer_pool_read_reqs", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_read_requests},
 
   {"buffer_pool_reads", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_reads},
@@ -99,6 +116,28 @@ static const ib_status_t status_vars[] = {
 
   {"buffer_pool_pages_written", IB_STATUS_ULINT, &export_vars.innodb_pages_written},
 
+  /* L2 page cache related */
+  {"l2_cache_hits", IB_STATUS_ULINT, &export_vars.innodb_l2_cache_hits},
+
+  {"l2_cache_pages_written", IB_STATUS_ULINT, &export_vars.innodb_l2_cache_pages_written},
+
+  /* Adaptive hash index related */
+  {"adaptive_hash_hits", IB_STATUS_ULINT, &export_vars.innodb_adaptive_hash_hits},
+
+  {"adaptive_hash_misses", IB_STATUS_ULINT, &export_vars.innodb_adaptive_hash_misses},
+
+  {"adaptive_hash_entries", IB_STATUS_ULINT, &export_vars.innodb_adaptive_hash_entries},
+
+  /* Persistent cursor related */
+  {"cursor_restore_hits", IB_STATUS_ULINT, &export_vars.innodb_pcur_restore_hits},
+
+  {"cursor_restore_misses", IB_STATUS_ULINT, &export_vars.innodb_pcur_restore_misses},
+
+  /* Index defragmentation related */
+  {"defrag_pages_scanned", IB_STATUS_ULINT, &export_vars.innodb_defrag_pages_scanned},
+
+  {"defrag_pages_freed", IB_STATUS_ULINT, &export_vars.innodb_defrag_pages_freed},
+
   /* Double write buffer related */
   {"double_write_pages_written", IB_STATUS_ULINT, &export_vars.innodb_dblwr_pages_written},
 
@@ -119,6 +158,22 @@ static const ib_status_t status_vars[] = {
 
   {"log_fsync_req_pending", IB_STATUS_ULINT, &export_vars.innodb_os_log_pending_fsyncs},
 
+  {"log_group_commits", IB_STATUS_ULINT, &export_vars.innodb_log_group_commits},
+
+  {"log_group_commit_fsyncs", IB_STATUS_ULINT, &export_vars.innodb_log_group_commit_fsyncs},
+
+  {"log_commits_per_fsync", IB_STATUS_ULINT, &export_vars.innodb_log_commits_per_fsync},
+
+  {"log_checkpoint_age", IB_STATUS_ULINT, &export_vars.innodb_log_checkpoint_age},
+
+  {"log_checkpoint_age_async", IB_STATUS_ULINT, &export_vars.innodb_log_checkpoint_age_async},
+
+  {"log_checkpoint_age_sync", IB_STATUS_ULINT, &export_vars.innodb_log_checkpoint_age_sync},
+
+  {"log_checkpoint_async_time_us", IB_STATUS_ULINT, &export_vars.innodb_log_checkpoint_async_time_us},
+
+  {"log_checkpoint_sync_time_us", IB_STATUS_ULINT, &export_vars.innodb_log_checkpoint_sync_time_us},
+
   /* Lock related */
   {"lock_row_waits", IB_STATUS_ULINT, &export_vars.innodb_row_lock_waits},
 
@@ -136,6 +191,187 @@ static const ib_status_t status_vars[] = {
   {"row_total_updated", IB_STATUS_ULINT, &export_vars.innodb_rows_updated},
   {"row_total_deleted", IB_STATUS_ULINT, &export_vars.innodb_rows_deleted},
 
+  /* Background rollback of the transactions recovered at startup */
+  {"recovery_rollback_trxs_left", IB_STATUS_ULINT, &export_vars.innodb_recovery_rollback_trxs_left},
+
+  {"recovery_rollback_undo_recs_left", IB_STATUS_ULINT, &export_vars.innodb_recovery_rollback_undo_recs_left},
+
+  /* Recovery phases */
+  {"recovery_dblwr_time_ms", IB_STATUS_ULINT, &export_vars.innodb_recovery_dblwr_time_ms},
+  {"recovery_dblwr_pages_restored", IB_STATUS_ULINT, &export_vars.innodb_recovery_dblwr_pages_restored},
+  {"recovery_scan_time_ms", IB_STATUS_ULINT, &export_vars.innodb_recovery_scan_time_ms},
+  {"recovery_scan_bytes", IB_STATUS_ULINT, &export_vars.innodb_recovery_scan_bytes},
+  {"recovery_parse_time_ms", IB_STATUS_ULINT, &export_vars.innodb_recovery_parse_time_ms},
+  {"recovery_parse_records", IB_STATUS_ULINT, &export_vars.innodb_recovery_parse_records},
+  {"recovery_parse_bytes", IB_STATUS_ULINT, &export_vars.innodb_recovery_parse_bytes},
+  {"recovery_apply_time_ms", IB_STATUS_ULINT, &export_vars.innodb_recovery_apply_time_ms},
+  {"recovery_apply_pages", IB_STATUS_ULINT, &export_vars.innodb_recovery_apply_pages},
+  {"recovery_rollback_time_ms", IB_STATUS_ULINT, &export_vars.innodb_recovery_rollback_time_ms},
+  {"recovery_rollback_undo_recs", IB_STATUS_ULINT, &export_vars.innodb_recovery_rollback_undo_recs},
+  {"recovery_pages_read", IB_STATUS_ULINT, &export_vars.innodb_recovery_pages_read},
+  {"recovery_peak_memory", IB_STATUS_ULINT, &export_vars.innodb_recovery_peak_memory},
+
+  /* Startup steps */
+  {"startup_buf_pool_time_ms", IB_STATUS_ULINT, &export_vars.innodb_startup_buf_pool_time_ms},
+  {"startup_files_time_ms", IB_STATUS_ULINT, &export_vars.innodb_startup_files_time_ms},
+  {"startup_tablespaces_time_ms", IB_STATUS_ULINT, &export_vars.innodb_startup_tablespaces_time_ms},
+  {"startup_recovery_time_ms", IB_STATUS_ULINT, &export_vars.innodb_startup_recovery_time_ms},
+  {"startup_dict_time_ms", IB_STATUS_ULINT, &export_vars.innodb_startup_dict_time_ms},
+  {"startup_threads_time_ms", IB_STATUS_ULINT, &export_vars.innodb_startup_threads_time_ms},
+  {"startup_total_time_ms", IB_STATUS_ULINT, &export_vars.innodb_startup_total_time_ms},
+
+  /* I/O classes */
+  {"aio_foreground_read_pending", IB_STATUS_ULINT, &export_vars.innodb_aio_foreground_read_pending},
+  {"aio_foreground_read_latency_us", IB_STATUS_ULINT, &export_vars.innodb_aio_foreground_read_latency_us},
+  {"aio_read_ahead_pending", IB_STATUS_ULINT, &export_vars.innodb_aio_read_ahead_pending},
+  {"aio_read_ahead_latency_us", IB_STATUS_ULINT, &export_vars.innodb_aio_read_ahead_latency_us},
+  {"aio_flush_pending", IB_STATUS_ULINT, &export_vars.innodb_aio_flush_pending},
+  {"aio_flush_latency_us", IB_STATUS_ULINT, &export_vars.innodb_aio_flush_latency_us},
+  {"aio_log_pending", IB_STATUS_ULINT, &export_vars.innodb_aio_log_pending},
+  {"aio_log_latency_us", IB_STATUS_ULINT, &export_vars.innodb_aio_log_latency_us},
+  {"aio_read_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_aio_read_latency_p50_us},
+  {"aio_read_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_aio_read_latency_p99_us},
+  {"aio_read_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_aio_read_latency_p999_us},
+  {"aio_write_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_aio_write_latency_p50_us},
+  {"aio_write_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_aio_write_latency_p99_us},
+  {"aio_write_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_aio_write_latency_p999_us},
+  {"aio_log_write_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_aio_log_write_latency_p50_us},
+  {"aio_log_write_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_aio_log_write_latency_p99_us},
+  {"aio_log_write_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_aio_log_write_latency_p999_us},
+  {"aio_recovery_pending", IB_STATUS_ULINT, &export_vars.innodb_aio_recovery_pending},
+  {"aio_recovery_latency_us", IB_STATUS_ULINT, &export_vars.innodb_aio_recovery_latency_us},
+
+  /* Purge */
+  {"purge_history_length", IB_STATUS_ULINT, &export_vars.innodb_purge_history_len},
+  {"purge_records_per_sec", IB_STATUS_ULINT, &export_vars.innodb_purge_records_per_sec},
+  {"purge_undo_logs_added_per_sec", IB_STATUS_ULINT, &export_vars.innodb_purge_undo_logs_added_per_sec},
+  {"purge_oldest_view_age_sec", IB_STATUS_ULINT, &export_vars.innodb_purge_oldest_view_age},
+  {"purge_oldest_view_trx_id", IB_STATUS_I64, &export_vars.innodb_purge_oldest_view_trx_id},
+  {"purge_dml_delay_us", IB_STATUS_ULINT, &export_vars.innodb_purge_dml_delay_us},
+
+  /* Undo log segment cache */
+  {"undo_cache_hits", IB_STATUS_ULINT, &export_vars.innodb_undo_cache_hits},
+  {"undo_cache_misses", IB_STATUS_ULINT, &export_vars.innodb_undo_cache_misses},
+  {"undo_cached", IB_STATUS_ULINT, &export_vars.innodb_undo_cached},
+
+  /* Transaction commit phases */
+  {"trx_commit_undo_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_undo_latency_p50_us},
+  {"trx_commit_undo_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_undo_latency_p99_us},
+  {"trx_commit_undo_waiting", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_undo_waiting},
+  {"trx_commit_lock_release_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_lock_release_latency_p50_us},
+  {"trx_commit_lock_release_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_lock_release_latency_p99_us},
+  {"trx_commit_lock_release_waiting", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_lock_release_waiting},
+  {"trx_commit_log_write_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_log_write_latency_p50_us},
+  {"trx_commit_log_write_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_log_write_latency_p99_us},
+  {"trx_commit_log_write_waiting", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_log_write_waiting},
+  {"trx_commit_log_flush_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_log_flush_latency_p50_us},
+  {"trx_commit_log_flush_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_log_flush_latency_p99_us},
+  {"trx_commit_log_flush_waiting", IB_STATUS_ULINT, &export_vars.innodb_trx_commit_log_flush_waiting},
+
+  /* Mini-transaction commits and log buffer reservations */
+  {"mtr_log_bytes_count", IB_STATUS_ULINT, &export_vars.innodb_mtr_log_bytes_count},
+  {"mtr_log_bytes_p50", IB_STATUS_ULINT, &export_vars.innodb_mtr_log_bytes_p50},
+  {"mtr_log_bytes_p99", IB_STATUS_ULINT, &export_vars.innodb_mtr_log_bytes_p99},
+  {"mtr_log_bytes_max", IB_STATUS_ULINT, &export_vars.innodb_mtr_log_bytes_max},
+  {"mtr_memo_slots_count", IB_STATUS_ULINT, &export_vars.innodb_mtr_memo_slots_count},
+  {"mtr_memo_slots_p50", IB_STATUS_ULINT, &export_vars.innodb_mtr_memo_slots_p50},
+  {"mtr_memo_slots_p99", IB_STATUS_ULINT, &export_vars.innodb_mtr_memo_slots_p99},
+  {"mtr_memo_slots_max", IB_STATUS_ULINT, &export_vars.innodb_mtr_memo_slots_max},
+  {"mtr_commit_count", IB_STATUS_ULINT, &export_vars.innodb_mtr_commit_count},
+  {"mtr_commit_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_mtr_commit_latency_p50_us},
+  {"mtr_commit_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_mtr_commit_latency_p99_us},
+  {"mtr_commit_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_mtr_commit_latency_max_us},
+  {"log_space_waits", IB_STATUS_ULINT, &export_vars.innodb_log_space_waits},
+  {"log_space_wait_p50_us", IB_STATUS_ULINT, &export_vars.innodb_log_space_wait_p50_us},
+  {"log_space_wait_p99_us", IB_STATUS_ULINT, &export_vars.innodb_log_space_wait_p99_us},
+  {"log_space_wait_max_us", IB_STATUS_ULINT, &export_vars.innodb_log_space_wait_max_us},
+  {"log_flush_order_waits", IB_STATUS_ULINT, &export_vars.innodb_log_flush_order_waits},
+  {"log_flush_order_wait_p50_us", IB_STATUS_ULINT, &export_vars.innodb_log_flush_order_wait_p50_us},
+  {"log_flush_order_wait_p99_us", IB_STATUS_ULINT, &export_vars.innodb_log_flush_order_wait_p99_us},
+  {"log_flush_order_wait_max_us", IB_STATUS_ULINT, &export_vars.innodb_log_flush_order_wait_max_us},
+
+  /* Latch contention, the per site top-N is in the monitor output */
+  {"latch_acquisitions", IB_STATUS_ULINT, &export_vars.innodb_latch_acquisitions},
+  {"latch_contended", IB_STATUS_ULINT, &export_vars.innodb_latch_contended},
+  {"latch_spin_rounds", IB_STATUS_ULINT, &export_vars.innodb_latch_spin_rounds},
+  {"latch_os_waits", IB_STATUS_ULINT, &export_vars.innodb_latch_os_waits},
+  {"latch_wait_time_us", IB_STATUS_ULINT, &export_vars.innodb_latch_wait_time_us},
+  {"latch_max_wait_us", IB_STATUS_ULINT, &export_vars.innodb_latch_max_wait_us},
+
+  /* Memory allocated with ut_new() and by the memory heaps, by subsystem */
+  {"mem_buf_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::BUF)]},
+  {"mem_buf_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::BUF)]},
+  {"mem_dict_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::DICT)]},
+  {"mem_dict_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::DICT)]},
+  {"mem_lock_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::LOCK)]},
+  {"mem_lock_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::LOCK)]},
+  {"mem_log_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::LOG)]},
+  {"mem_log_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::LOG)]},
+  {"mem_recv_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::RECV)]},
+  {"mem_recv_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::RECV)]},
+  {"mem_merge_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::MERGE)]},
+  {"mem_merge_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::MERGE)]},
+  {"mem_row_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::ROW)]},
+  {"mem_row_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::ROW)]},
+  {"mem_trx_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::TRX)]},
+  {"mem_trx_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::TRX)]},
+  {"mem_fil_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::FIL)]},
+  {"mem_fil_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::FIL)]},
+  {"mem_heap_cache_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::HEAP_CACHE)]},
+  {"mem_heap_cache_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::HEAP_CACHE)]},
+  {"mem_other_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_bytes[size_t(Mem_tag::OTHER)]},
+  {"mem_other_peak_bytes", IB_STATUS_ULINT, &export_vars.innodb_mem_tag_peak_bytes[size_t(Mem_tag::OTHER)]},
+
+  /* Dictionary cache */
+  {"dict_tables_cached", IB_STATUS_ULINT, &export_vars.innodb_dict_tables_cached},
+  {"dict_tables_loaded", IB_STATUS_ULINT, &export_vars.innodb_dict_tables_loaded},
+  {"dict_tables_evicted", IB_STATUS_ULINT, &export_vars.innodb_dict_tables_evicted},
+
+  /* Transactions and locks */
+  {"trx_active", IB_STATUS_ULINT, &export_vars.innodb_trx_active},
+  {"trx_user", IB_STATUS_ULINT, &export_vars.innodb_trx_user},
+  {"lock_rec_locks", IB_STATUS_ULINT, &export_vars.innodb_lock_rec_locks},
+  {"conc_active", IB_STATUS_ULINT, &export_vars.innodb_conc_active},
+  {"conc_waiting", IB_STATUS_ULINT, &export_vars.innodb_conc_waiting},
+  {"conc_limit", IB_STATUS_ULINT, &export_vars.innodb_conc_limit},
+
+  /* Operation latencies, see ib_status_get_latencies() for a snapshot */
+  {"op_cursor_moveto_count", IB_STATUS_ULINT, &export_vars.innodb_op_count[SRV_OP_CURSOR_MOVETO]},
+  {"op_cursor_moveto_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p50_us[SRV_OP_CURSOR_MOVETO]},
+  {"op_cursor_moveto_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p99_us[SRV_OP_CURSOR_MOVETO]},
+  {"op_cursor_moveto_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p999_us[SRV_OP_CURSOR_MOVETO]},
+  {"op_cursor_moveto_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_max_us[SRV_OP_CURSOR_MOVETO]},
+  {"op_cursor_next_count", IB_STATUS_ULINT, &export_vars.innodb_op_count[SRV_OP_CURSOR_NEXT]},
+  {"op_cursor_next_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p50_us[SRV_OP_CURSOR_NEXT]},
+  {"op_cursor_next_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p99_us[SRV_OP_CURSOR_NEXT]},
+  {"op_cursor_next_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p999_us[SRV_OP_CURSOR_NEXT]},
+  {"op_cursor_next_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_max_us[SRV_OP_CURSOR_NEXT]},
+  {"op_cursor_insert_count", IB_STATUS_ULINT, &export_vars.innodb_op_count[SRV_OP_CURSOR_INSERT]},
+  {"op_cursor_insert_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p50_us[SRV_OP_CURSOR_INSERT]},
+  {"op_cursor_insert_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p99_us[SRV_OP_CURSOR_INSERT]},
+  {"op_cursor_insert_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p999_us[SRV_OP_CURSOR_INSERT]},
+  {"op_cursor_insert_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_max_us[SRV_OP_CURSOR_INSERT]},
+  {"op_cursor_update_count", IB_STATUS_ULINT, &export_vars.innodb_op_count[SRV_OP_CURSOR_UPDATE]},
+  {"op_cursor_update_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p50_us[SRV_OP_CURSOR_UPDATE]},
+  {"op_cursor_update_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p99_us[SRV_OP_CURSOR_UPDATE]},
+  {"op_cursor_update_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p999_us[SRV_OP_CURSOR_UPDATE]},
+  {"op_cursor_update_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_max_us[SRV_OP_CURSOR_UPDATE]},
+  {"op_cursor_delete_count", IB_STATUS_ULINT, &export_vars.innodb_op_count[SRV_OP_CURSOR_DELETE]},
+  {"op_cursor_delete_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p50_us[SRV_OP_CURSOR_DELETE]},
+  {"op_cursor_delete_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p99_us[SRV_OP_CURSOR_DELETE]},
+  {"op_cursor_delete_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p999_us[SRV_OP_CURSOR_DELETE]},
+  {"op_cursor_delete_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_max_us[SRV_OP_CURSOR_DELETE]},
+  {"op_trx_commit_count", IB_STATUS_ULINT, &export_vars.innodb_op_count[SRV_OP_TRX_COMMIT]},
+  {"op_trx_commit_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p50_us[SRV_OP_TRX_COMMIT]},
+  {"op_trx_commit_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p99_us[SRV_OP_TRX_COMMIT]},
+  {"op_trx_commit_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p999_us[SRV_OP_TRX_COMMIT]},
+  {"op_trx_commit_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_max_us[SRV_OP_TRX_COMMIT]},
+  {"op_lock_wait_count", IB_STATUS_ULINT, &export_vars.innodb_op_count[SRV_OP_LOCK_WAIT]},
+  {"op_lock_wait_latency_p50_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p50_us[SRV_OP_LOCK_WAIT]},
+  {"op_lock_wait_latency_p99_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p99_us[SRV_OP_LOCK_WAIT]},
+  {"op_lock_wait_latency_p999_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_p999_us[SRV_OP_LOCK_WAIT]},
+  {"op_lock_wait_latency_max_us", IB_STATUS_ULINT, &export_vars.innodb_op_latency_max_us[SRV_OP_LOCK_WAIT]},
+
   /* Miscellaneous */
   {"page_size", IB_STATUS_ULINT, &export_vars.innodb_page_size},
 
@@ -160,6 +396,63 @@ ib_err_t ib_status_get_all(const char ***names, uint32_t *names_num) {
   return (DB_SUCCESS);
 }
 
+ib_err_t ib_status_get_latencies(ib_latency_t **latencies, uint32_t *n, bool reset) {
+  *n = SRV_OP_COUNT;
+
+  *latencies = (ib_latency_t *)malloc(*n * sizeof(ib_latency_t));
+  if (*latencies == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  for (ulint op = 0; op < SRV_OP_COUNT; ++op) {
+    const auto p = srv_op_stats.get_percentiles(Srv_op(op), reset);
+    auto &latency = (*latencies)[op];
+
+    latency.name = Srv_op_stats::get_name(Srv_op(op));
+    latency.count = p.m_count;
+    latency.p50_us = p.m_p50;
+    latency.p99_us = p.m_p99;
+    latency.p999_us = p.m_p999;
+    latency.max_us = p.m_max;
+  }
+
+  return DB_SUCCESS;
+}
+
+static_assert(ulint(ut::Wait_type::AIO_SLOT) == IB_WAIT_AIO_SLOT, "ib_wait_type_t must follow ut::Wait_type");
+
+ib_err_t ib_wait_trace_get(ib_wait_event_t **events, uint64_t *n_events, bool reset) {
+  std::vector<ut::Wait_event> waits;
+
+  ut::wait_trace_collect(waits, reset);
+
+  *n_events = waits.size();
+
+  *events = (ib_wait_event_t *)malloc(std::max<size_t>(waits.size(), 1) * sizeof(ib_wait_event_t));
+  if (*events == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  for (size_t i{}; i < waits.size(); ++i) {
+    const auto &wait = waits[i];
+    auto &event = (*events)[i];
+
+    event.type = ib_wait_type_t(wait.m_type);
+    event.start_ns = wait.m_start_ns;
+    event.duration_ns = wait.m_duration_ns;
+    event.object = wait.m_object;
+    event.thread_id = wait.m_thread_id;
+    event.file = wait.m_file;
+    event.line = wait.m_line;
+  }
+
+  return DB_SUCCESS;
+}
+
+ib_err_t ib_wait_trace_dump(const char *path) {
+  return ut::wait_trace_dump(path);
+}
+
 /* @} */
 
 /**
@@ -216,3 +509,43 @@ ib_err_t ib_status_get_i64(const char *name, int64_t *dst) {
 
   return err;
 }
+
+ib_err_t ib_status_visit(ib_status_visit_cb_t callback, void *arg) {
+  /* Copy all the values at once, the callback then reads the copy and
+  can take its time without holding up the other threads. */
+  auto vars = std::make_unique<export_struc>();
+
+  InnoDB::snapshot_innodb_status(*vars);
+
+  const auto base = reinterpret_cast<const byte *>(&export_vars);
+  const auto snapshot = reinterpret_cast<const byte *>(vars.get());
+
+  for (auto ptr = status_vars; ptr->name != nullptr; ++ptr) {
+    /* The entries point into export_vars, read the same field of the copy. */
+    const auto val = snapshot + (reinterpret_cast<const byte *>(ptr->val) - base);
+    int64_t value;
+
+    switch (ptr->type) {
+      case IB_STATUS_ULINT:
+        value = int64_t(*reinterpret_cast<const ulint *>(val));
+        break;
+
+      case IB_STATUS_IBOOL:
+        value = *reinterpret_cast<const bool *>(val);
+        break;
+
+      case IB_STATUS_I64:
+        value = *reinterpret_cast<const int64_t *>(val);
+        break;
+
+      default:
+        ut_error;
+    }
+
+    if (callback(arg, ptr->name, value) != 0) {
+      return DB_INTERRUPTED;
+    }
+  }
+
+  return DB_SUCCESS;
+}
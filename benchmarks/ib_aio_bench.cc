@@ -0,0 +1,539 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Benchmark of the asynchronous i/o subsystem.
+
+ ib_aio_bench [--file_mb=<n>] [--block_size=<bytes>] [--queue_depth=<n>]
+              [--jobs=<n>] [--read_pct=<0..100>] [--read_queues=<n>]
+              [--write_queues=<n>] [--slots=<n>] [--direct=on|off]
+              [--duration=<seconds>] [--out=<file>]
+
+ The requests are submitted with AIO::submit() and reaped with AIO::reap()
+ directly, the engine is not started. An AIO instance is created with the
+ given slots and queues and one thread reaps each of its read and write
+ queues, like the i/o handler threads of the engine do. The test tablespace
+ ib_aio_bench.ibd is created in the current directory, filled with zeros to
+ --file_mb and kept for the next run.
+
+ Each of the --jobs threads keeps --queue_depth requests of --block_size bytes
+ in flight at random aligned offsets of the file, --read_pct of them are reads
+ and the rest writes. The reads are submitted in the foreground read class
+ and the writes in the flush class, so the class limits of the slots apply as
+ they do to the page reads and the page flushes of the engine.
+
+ The IOPS, the bandwidth and the submit to reap latencies of the reads and of
+ the writes are printed with their histograms, followed by the latencies of
+ each queue as the AIO instance measured them. The results are written as JSON
+ in the layout of the Google Benchmark output, like ib_bench does. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "fil0types.h"
+#include "os0aio.h"
+#include "os0file.h"
+#include "srv0srv.h"
+#include "ut0histogram.h"
+#include "ut0mem.h"
+
+namespace bench {
+
+/** The test tablespace. */
+constexpr const char *FILE_NAME = "ib_aio_bench.ibd";
+
+/** Options. */
+struct Options {
+  /** Size of the test tablespace in MiB. */
+  uint64_t m_file_mb{1024};
+
+  /** Length of a request in bytes. */
+  ulint m_block_size{16 * 1024};
+
+  /** Requests in flight per job. */
+  ulint m_queue_depth{32};
+
+  /** Submitting threads. */
+  ulint m_jobs{1};
+
+  /** Percentage of the requests that are reads. */
+  ulint m_read_pct{100};
+
+  /** Queues of the read handler. */
+  ulint m_read_queues{4};
+
+  /** Queues of the write handler. */
+  ulint m_write_queues{4};
+
+  /** Slots per handler, the engine uses 256. */
+  ulint m_slots{256};
+
+  /** If true, the file is opened with O_DIRECT. */
+  bool m_direct{true};
+
+  /** How long the requests are submitted. */
+  std::chrono::seconds m_duration{10};
+
+  /** File for the JSON results, stdout if empty. */
+  std::string m_out{};
+
+  /** @return the number of blocks in the file. */
+  uint64_t n_blocks() const noexcept { return m_file_mb * 1024 * 1024 / m_block_size; }
+};
+
+struct Job;
+
+/** A request, it owns a buffer of the block size. */
+struct Request {
+  /** The job that submitted the request. */
+  Job *m_job{};
+
+  /** Buffer of the request. */
+  byte *m_buf{};
+
+  /** true for a read, false for a write. */
+  bool m_read{};
+
+  /** When the request was submitted. */
+  std::chrono::steady_clock::time_point m_start{};
+};
+
+/** A submitting thread, the reapers return its requests when they complete. */
+struct Job {
+  /** Wait for a completed request.
+  @return the request. */
+  Request *acquire() {
+    std::unique_lock lock(m_mutex);
+
+    m_cv.wait(lock, [this] { return !m_free.empty(); });
+
+    auto request = m_free.back();
+
+    m_free.pop_back();
+
+    return request;
+  }
+
+  /** Return a completed request.
+  @param[in] request The request. */
+  void release(Request *request) {
+    {
+      std::lock_guard lock(m_mutex);
+
+      m_free.push_back(request);
+    }
+
+    m_cv.notify_one();
+  }
+
+  /** Wait until all the requests completed.
+  @param[in] n_requests Number of requests of the job. */
+  void drain(size_t n_requests) {
+    std::unique_lock lock(m_mutex);
+
+    m_cv.wait(lock, [&] { return m_free.size() == n_requests; });
+  }
+
+  /** Random offsets and request types. */
+  std::mt19937_64 m_rng{};
+
+  /** Protects m_free. */
+  std::mutex m_mutex{};
+
+  /** Signalled when a request is returned. */
+  std::condition_variable m_cv{};
+
+  /** Requests that are not in flight. */
+  std::vector<Request *> m_free{};
+};
+
+/** Results of the reads or of the writes. */
+struct Op_stats {
+  /** Completed requests. */
+  std::atomic<uint64_t> m_n_requests{};
+
+  /** Bytes transferred. */
+  std::atomic<uint64_t> m_n_bytes{};
+
+  /** Submit to reap latencies. */
+  ut::Latency_histogram m_latency{};
+};
+
+/** Reap the completed requests of a queue until the AIO shuts down.
+@param[in,out] aio The AIO instance
+@param[in] queue_id The queue
+@param[in,out] reads Statistics of the reads
+@param[in,out] writes Statistics of the writes */
+static void reaper(AIO *aio, aio::Queue_id queue_id, Op_stats &reads, Op_stats &writes) {
+  for (;;) {
+    IO_ctx io_ctx{};
+
+    auto err = aio->reap(queue_id, io_ctx);
+
+    if (io_ctx.is_shutdown()) {
+      return;
+    }
+
+    ut_a(err == DB_SUCCESS);
+    ut_a(io_ctx.m_ret > 0);
+
+    auto request = static_cast<Request *>(io_ctx.m_msg);
+    auto &stats = request->m_read ? reads : writes;
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request->m_start);
+
+    stats.m_latency.add(uint64_t(us.count()));
+    stats.m_n_bytes.fetch_add(uint64_t(io_ctx.m_ret), std::memory_order_relaxed);
+    stats.m_n_requests.fetch_add(1, std::memory_order_relaxed);
+
+    request->m_job->release(request);
+  }
+}
+
+/** Keep the requests of a job in flight until the end time.
+@param[in,out] aio The AIO instance
+@param[in] node The test tablespace file
+@param[in] opts Options
+@param[in,out] job The job
+@param[in] end When to stop submitting */
+static void submitter(AIO *aio, fil_node_t *node, const Options &opts, Job &job, std::chrono::steady_clock::time_point end) {
+  std::uniform_int_distribution<uint64_t> block(0, opts.n_blocks() - 1);
+  std::uniform_int_distribution<ulint> pct(0, 99);
+
+  while (std::chrono::steady_clock::now() < end) {
+    auto request = job.acquire();
+    const auto off = off_t(block(job.m_rng) * opts.m_block_size);
+
+    request->m_read = pct(job.m_rng) < opts.m_read_pct;
+
+    IO_ctx io_ctx{};
+
+    io_ctx.m_fil_node = node;
+    io_ctx.m_msg = request;
+
+    if (request->m_read) {
+      io_ctx.m_io_request = IO_request::Async_read;
+      io_ctx.m_io_class = IO_class::Foreground_read;
+    } else {
+      io_ctx.m_io_request = IO_request::Async_write;
+      io_ctx.m_io_class = IO_class::Flush;
+    }
+
+    request->m_start = std::chrono::steady_clock::now();
+
+    auto err = aio->submit(std::move(io_ctx), request->m_buf, opts.m_block_size, off);
+    ut_a(err == DB_SUCCESS);
+  }
+
+  job.drain(opts.m_queue_depth);
+}
+
+/** @return the non-empty buckets of a histogram, one per line. */
+static std::string histogram_to_string(const ut::Latency_histogram &histogram) {
+  std::string str;
+  uint64_t n{};
+  const auto total = histogram.get_count();
+
+  for (ulint i{}; i < ut::Latency_histogram::N_BUCKETS; ++i) {
+    const auto count = histogram.m_buckets[i].load(std::memory_order_relaxed);
+
+    if (count > 0) {
+      n += count;
+      str += std::format(
+        "  <= {:>10}us {:>12} {:6.2f}%\n", ut::Latency_histogram::get_upper_bound(i), count, 100.0 * double(n) / double(total));
+    }
+  }
+
+  return str;
+}
+
+/** @return the results in JSON. */
+static std::string to_json(const Options &opts, ulint align, std::chrono::microseconds elapsed, const Op_stats &reads, const Op_stats &writes) {
+  std::ostringstream os;
+  char date[64];
+  const auto now = std::time(nullptr);
+  const auto secs = std::max(double(elapsed.count()) / 1e6, 1e-6);
+
+  (void) std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+  os << "{\n  \"context\": {\n";
+  os << std::format("    \"date\": \"{}\",\n", date);
+  os << std::format("    \"num_cpus\": {},\n", std::thread::hardware_concurrency());
+  os << std::format("    \"file_mb\": {},\n", opts.m_file_mb);
+  os << std::format("    \"block_size\": {},\n", opts.m_block_size);
+  os << std::format("    \"queue_depth\": {},\n", opts.m_queue_depth);
+  os << std::format("    \"jobs\": {},\n", opts.m_jobs);
+  os << std::format("    \"read_pct\": {},\n", opts.m_read_pct);
+  os << std::format("    \"read_queues\": {},\n", opts.m_read_queues);
+  os << std::format("    \"write_queues\": {},\n", opts.m_write_queues);
+  os << std::format("    \"slots\": {},\n", opts.m_slots);
+  os << std::format("    \"direct_io_align\": {}\n", align);
+  os << "  },\n  \"benchmarks\": [\n";
+
+  const std::array<std::pair<const char *, const Op_stats *>, 2> ops{{{"read", &reads}, {"write", &writes}}};
+  bool first{true};
+
+  for (const auto &[name, stats] : ops) {
+    const auto n_requests = stats->m_n_requests.load();
+
+    if (n_requests == 0) {
+      continue;
+    }
+
+    const auto percentiles = stats->m_latency.get_percentiles();
+
+    os << std::format(
+      "{}    {{\"name\": \"aio/{}\", \"threads\": {}, \"iterations\": {}, \"real_time\": {:.3f}, \"time_unit\": \"s\", "
+      "\"bytes_per_second\": {:.0f}, \"items_per_second\": {:.0f}, "
+      "\"p50_us\": {}, \"p99_us\": {}, \"p999_us\": {}, \"max_us\": {}}}",
+      first ? "" : ",\n", name, opts.m_jobs, n_requests, secs, double(stats->m_n_bytes.load()) / secs,
+      double(n_requests) / secs, percentiles.m_p50, percentiles.m_p99, percentiles.m_p999, percentiles.m_max);
+
+    first = false;
+  }
+
+  os << "\n  ]\n}\n";
+
+  return os.str();
+}
+
+}  // namespace bench
+
+int main(int argc, char **argv) {
+  bench::Options opts;
+
+  for (int i{1}; i < argc; ++i) {
+    const std::string arg{argv[i]};
+    const auto value = [&](const char *name) { return strtoull(arg.c_str() + strlen(name), nullptr, 10); };
+
+    if (arg.starts_with("--file_mb=")) {
+      opts.m_file_mb = value("--file_mb=");
+    } else if (arg.starts_with("--block_size=")) {
+      opts.m_block_size = ulint(value("--block_size="));
+    } else if (arg.starts_with("--queue_depth=")) {
+      opts.m_queue_depth = ulint(value("--queue_depth="));
+    } else if (arg.starts_with("--jobs=")) {
+      opts.m_jobs = ulint(value("--jobs="));
+    } else if (arg.starts_with("--read_pct=")) {
+      opts.m_read_pct = ulint(value("--read_pct="));
+    } else if (arg.starts_with("--read_queues=")) {
+      opts.m_read_queues = ulint(value("--read_queues="));
+    } else if (arg.starts_with("--write_queues=")) {
+      opts.m_write_queues = ulint(value("--write_queues="));
+    } else if (arg.starts_with("--slots=")) {
+      opts.m_slots = ulint(value("--slots="));
+    } else if (arg == "--direct=on" || arg == "--direct=off") {
+      opts.m_direct = arg == "--direct=on";
+    } else if (arg.starts_with("--duration=")) {
+      opts.m_duration = std::chrono::seconds(value("--duration="));
+    } else if (arg.starts_with("--out=")) {
+      opts.m_out = arg.substr(strlen("--out="));
+    } else {
+      opts.m_block_size = 0;
+      break;
+    }
+  }
+
+  if (opts.m_block_size == 0 || opts.m_block_size % IB_FILE_BLOCK_SIZE != 0 || opts.n_blocks() == 0 ||
+      opts.m_queue_depth == 0 || opts.m_jobs == 0 || opts.m_read_pct > 100 || opts.m_read_queues == 0 ||
+      opts.m_write_queues == 0 || opts.m_slots == 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--file_mb=<n>] [--block_size=<bytes>] [--queue_depth=<n>] [--jobs=<n>] [--read_pct=<0..100>]"
+                 " [--read_queues=<n>] [--write_queues=<n>] [--slots=<n>] [--direct=on|off] [--duration=<seconds>]"
+                 " [--out=<file>]\n";
+    return EXIT_FAILURE;
+  }
+
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  /* The AIO instance needs the synchronization primitives, the rest of the
+  engine is not started. */
+  InnoDB::general_init();
+
+  os_file_init();
+
+  auto aio = AIO::create(opts.m_slots, opts.m_read_queues, opts.m_write_queues, false, false, std::chrono::microseconds(0));
+
+  if (aio == nullptr) {
+    std::cerr << "Failed to create an AIO instance\n";
+    return EXIT_FAILURE;
+  }
+
+  bool exists{};
+  os_file_type_t type;
+
+  if (!os_file_status(bench::FILE_NAME, &exists, &type)) {
+    return EXIT_FAILURE;
+  }
+
+  bool success{};
+  auto fh = os_file_create_simple(bench::FILE_NAME, exists ? OS_FILE_OPEN : OS_FILE_CREATE, OS_FILE_READ_WRITE, &success);
+
+  if (!success) {
+    return EXIT_FAILURE;
+  }
+
+  /* Only the part that is missing is written. */
+  if (!os_file_set_size(bench::FILE_NAME, fh, off_t(opts.m_file_mb * 1024 * 1024)) || !os_file_flush(fh)) {
+    return EXIT_FAILURE;
+  }
+
+  if (opts.m_direct && !os_file_set_nocache(fh, bench::FILE_NAME, "open")) {
+    std::cerr << "O_DIRECT is not supported, the page cache is used\n";
+  }
+
+  const auto align = os_file_get_direct_io_align(fh);
+
+  if (!os_file_is_direct_io_aligned(align, nullptr, opts.m_block_size, 0)) {
+    std::cerr << std::format("The block size must be a multiple of the O_DIRECT alignment {}\n", align);
+    return EXIT_FAILURE;
+  }
+
+  /* The AIO needs a file node of a tablespace, the latencies of the space
+  are recorded like those of a real one. */
+  ut::Latency_histogram space_latency{};
+  Fil_space_io_stats space_io_stats{};
+  fil_space_t space{};
+
+  space.m_name = const_cast<char *>(bench::FILE_NAME);
+  space.m_type = FIL_TABLESPACE;
+  space.m_io_latency = &space_latency;
+  space.m_io_stats = &space_io_stats;
+  space.m_magic_n = FIL_SPACE_MAGIC_N;
+
+  fil_node_t node{};
+
+  node.m_space = &space;
+  node.m_file_name = const_cast<char *>(bench::FILE_NAME);
+  node.open = true;
+  node.m_fh = fh;
+  node.m_fixed_fd = aio->register_file(fh);
+  node.m_direct_io_align = align;
+  node.m_magic_n = FIL_NODE_MAGIC_N;
+
+  /* One area for all the buffers, registered like the buffer pool chunks. */
+  const auto n_requests = opts.m_jobs * opts.m_queue_depth;
+  const auto area_size = n_requests * opts.m_block_size;
+  auto ptr = static_cast<byte *>(ut_new(area_size + UNIV_PAGE_SIZE));
+  auto area = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
+
+  std::mt19937_64 rng(std::random_device{}());
+
+  for (ulint i{}; i < area_size; i += sizeof(uint64_t)) {
+    const auto v = rng();
+
+    memcpy(area + i, &v, sizeof(v));
+  }
+
+  aio->register_buffer(area, area_size);
+
+  std::vector<bench::Job> jobs(opts.m_jobs);
+  std::vector<bench::Request> requests(n_requests);
+
+  for (ulint i{}; i < n_requests; ++i) {
+    auto &job = jobs[i / opts.m_queue_depth];
+
+    requests[i].m_job = &job;
+    requests[i].m_buf = area + i * opts.m_block_size;
+    job.m_free.push_back(&requests[i]);
+  }
+
+  bench::Op_stats reads;
+  bench::Op_stats writes;
+  std::vector<std::thread> reapers;
+
+  /* Queue 0 is the log queue, the read queues come next. */
+  for (aio::Queue_id queue_id{1}; queue_id <= opts.m_read_queues + opts.m_write_queues; ++queue_id) {
+    reapers.emplace_back(bench::reaper, aio, queue_id, std::ref(reads), std::ref(writes));
+  }
+
+  std::cerr << std::format(
+    "{} MiB, {} byte blocks, {} jobs of queue depth {}, {}% reads, {} read and {} write queues of {} slots, O_DIRECT {}\n",
+    opts.m_file_mb, opts.m_block_size, opts.m_jobs, opts.m_queue_depth, opts.m_read_pct, opts.m_read_queues,
+    opts.m_write_queues, opts.m_slots, align > 0 ? "on" : "off");
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto end = start + opts.m_duration;
+  std::vector<std::thread> submitters;
+
+  for (ulint i{}; i < opts.m_jobs; ++i) {
+    jobs[i].m_rng.seed(rng() + i);
+    submitters.emplace_back(bench::submitter, aio, &node, std::cref(opts), std::ref(jobs[i]), end);
+  }
+
+  for (auto &thread : submitters) {
+    thread.join();
+  }
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  const auto secs = std::max(double(elapsed.count()) / 1e6, 1e-6);
+
+  for (const auto &[name, stats] : {std::pair{"read", &reads}, std::pair{"write", &writes}}) {
+    const auto n = stats->m_n_requests.load();
+
+    if (n == 0) {
+      continue;
+    }
+
+    std::cerr << std::format(
+      "{}: {:.0f} IOPS, {:.1f} MiB/s, {}\n{}", name, double(n) / secs,
+      double(stats->m_n_bytes.load()) / secs / (1024.0 * 1024.0), stats->m_latency.get_percentiles().to_string(),
+      bench::histogram_to_string(stats->m_latency));
+  }
+
+  std::cerr << aio->latency_to_string();
+
+  aio->shutdown();
+
+  for (auto &thread : reapers) {
+    thread.join();
+  }
+
+  aio->unregister_buffer(area, area_size);
+
+  if (node.m_fixed_fd != -1) {
+    aio->unregister_file(node.m_fixed_fd);
+  }
+
+  AIO::destroy(aio);
+
+  ut_delete(ptr);
+
+  (void) os_file_close(fh);
+
+  os_file_free();
+
+  const auto json = bench::to_json(opts, align, elapsed, reads, writes);
+
+  if (opts.m_out.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream os(opts.m_out, std::ios::out | std::ios::trunc);
+
+    os << json;
+
+    if (!os) {
+      std::cerr << "Cannot write " << opts.m_out << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
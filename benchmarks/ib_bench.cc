@@ -0,0 +1,603 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Microbenchmarks of the engine hot paths.
+
+ ib_bench [--filter=<substring>] [--min_time=<seconds>] [--out=<file>]
+
+ The engine is started in the current working directory, a table with a
+ single leaf page is created for the page and record benchmarks. The results
+ are written as JSON in the layout of the Google Benchmark output, so that
+ its tools can compare two runs:
+
+ {
+   "context": {"date": ..., "num_cpus": ..., "library_build_type": ..., "page_size": ...},
+   "benchmarks": [
+     {"name": ..., "threads": ..., "iterations": ..., "real_time": ..., "time_unit": "ns"},
+     ...
+   ]
+ }
+
+ real_time is the wall clock time of one iteration of one thread. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <latch>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "buf0buf.h"
+#include "data0data.h"
+#include "dict0dict.h"
+#include "mem0mem.h"
+#include "mtr0mtr.h"
+#include "page0cur.h"
+#include "page0page.h"
+#include "rem0cmp.h"
+#include "rem0rec.h"
+#include "srv0srv.h"
+#include "sync0rw.h"
+#include "sync0sync.h"
+#include "ut0crc32.h"
+#include "ut0mpmcbq.h"
+
+#include "../tests/test0aux.h"
+
+#define DATABASE "bench"
+#define TABLE "t"
+
+/** Number of rows in the benchmark table, they fit in the root page. */
+constexpr uint32_t N_ROWS = 200;
+
+#ifdef UNIV_DEBUG
+constexpr const char *BUILD_TYPE = "debug";
+#else
+constexpr const char *BUILD_TYPE = "release";
+#endif /* UNIV_DEBUG */
+
+namespace bench {
+
+/** Keeps the compiler from optimizing away a value that is not used. */
+template <typename T>
+inline void do_not_optimize(T const &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/** Runs n iterations of a benchmark in the thread thread_no. */
+using Body = std::function<void(uint64_t n, ulint thread_no)>;
+
+/** The result of a benchmark. */
+struct Result {
+  /** Name of the benchmark. */
+  std::string m_name;
+
+  /** Number of threads that ran it. */
+  ulint m_n_threads{};
+
+  /** Number of iterations run by each thread. */
+  uint64_t m_iterations{};
+
+  /** Wall clock time of one iteration in nanoseconds. */
+  double m_ns_per_iteration{};
+};
+
+/** Runs the benchmarks and collects their results. */
+struct Runner {
+  /**
+   * Runs a benchmark until it took at least m_min_time, the number of
+   * iterations grows with each run.
+   *
+   * @param[in] name            Name of the benchmark.
+   * @param[in] n_threads       Number of threads that run the body.
+   * @param[in] body            The benchmark.
+   */
+  void run(const std::string &name, ulint n_threads, Body body) {
+    const auto full_name = n_threads > 1 ? std::format("{}/threads:{}", name, n_threads) : name;
+
+    if (!m_filter.empty() && full_name.find(m_filter) == std::string::npos) {
+      return;
+    }
+
+    uint64_t n{1};
+
+    for (;;) {
+      const auto elapsed = time(n, n_threads, body);
+
+      if (elapsed >= m_min_time || n >= MAX_ITERATIONS) {
+        m_results.push_back({full_name, n_threads, n, double(elapsed.count()) / double(n)});
+
+        std::cerr << std::format("{:<48} {:>12.1f} ns {:>12} iterations\n", full_name, m_results.back().m_ns_per_iteration, n);
+        break;
+      }
+
+      /* Aim at 1.4 times the minimum, like Google Benchmark does. */
+      const auto multiplier = elapsed.count() > 0 ? 1.4 * double(m_min_time.count()) / double(elapsed.count()) : 10.0;
+
+      n = std::min(MAX_ITERATIONS, uint64_t(double(n) * std::clamp(multiplier, 2.0, 10.0)));
+    }
+  }
+
+  /** @return the results in JSON. */
+  std::string to_json() const {
+    std::ostringstream os;
+    char date[64];
+    const auto now = std::time(nullptr);
+
+    (void) std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    os << "{\n  \"context\": {\n";
+    os << std::format("    \"date\": \"{}\",\n", date);
+    os << std::format("    \"num_cpus\": {},\n", std::thread::hardware_concurrency());
+    os << std::format("    \"library_build_type\": \"{}\",\n", BUILD_TYPE);
+    os << std::format("    \"page_size\": {}\n", UNIV_PAGE_SIZE);
+    os << "  },\n  \"benchmarks\": [\n";
+
+    for (size_t i{}; i < m_results.size(); ++i) {
+      const auto &result = m_results[i];
+
+      os << std::format(
+        "    {{\"name\": \"{}\", \"threads\": {}, \"iterations\": {}, \"real_time\": {:.3f}, \"time_unit\": \"ns\"}}{}\n",
+        result.m_name, result.m_n_threads, result.m_iterations, result.m_ns_per_iteration,
+        i + 1 < m_results.size() ? "," : "");
+    }
+
+    os << "  ]\n}\n";
+
+    return os.str();
+  }
+
+  /** A run stops growing at this many iterations. */
+  static constexpr uint64_t MAX_ITERATIONS = 1000000000;
+
+  /** Only the benchmarks whose name contains this are run. */
+  std::string m_filter{};
+
+  /** Minimum time of the final run of a benchmark. */
+  std::chrono::nanoseconds m_min_time{std::chrono::milliseconds(500)};
+
+  /** The results, in the order the benchmarks ran. */
+  std::vector<Result> m_results{};
+
+ private:
+  /**
+   * Runs n iterations on each thread.
+   *
+   * @return the wall clock time from the start of the first thread to the
+   *  end of the last one.
+   */
+  static std::chrono::nanoseconds time(uint64_t n, ulint n_threads, const Body &body) {
+    if (n_threads == 1) {
+      const auto start = std::chrono::steady_clock::now();
+
+      body(n, 0);
+
+      return std::chrono::steady_clock::now() - start;
+    }
+
+    std::latch ready(ptrdiff_t(n_threads) + 1);
+    std::latch go(1);
+    std::vector<std::thread> threads;
+
+    for (ulint i{}; i < n_threads; ++i) {
+      threads.emplace_back([&, i]() {
+        ready.count_down();
+        go.wait();
+        body(n, i);
+      });
+    }
+
+    ready.arrive_and_wait();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    go.count_down();
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    return std::chrono::steady_clock::now() - start;
+  }
+};
+
+/** @return the thread counts of the contention benchmarks. */
+static std::vector<ulint> thread_counts() {
+  const ulint n_cpus = std::max(1U, std::thread::hardware_concurrency());
+  std::vector<ulint> counts;
+
+  for (ulint n{1}; n <= std::min(n_cpus, ulint{16}); n *= 2) {
+    counts.push_back(n);
+  }
+
+  return counts;
+}
+
+static void crc32_benchmarks(Runner &runner) {
+  std::vector<byte> data(UNIV_PAGE_SIZE);
+
+  for (size_t i{}; i < data.size(); ++i) {
+    data[i] = byte(i * 7 + 3);
+  }
+
+  std::vector<std::pair<std::string, crc32::Checksum>> variants{{"software", crc32::software}};
+
+#if defined(__x86_64__)
+  if (crc32::can_use_crc32()) {
+    variants.emplace_back("unrolled_loop_poly_mul", crc32::unrolled_loop_poly_mul);
+
+    if (crc32::can_use_poly_mul()) {
+      variants.emplace_back("pclmul", crc32::pclmul);
+    }
+  }
+#endif /* __x86_64__ */
+
+  variants.emplace_back("checksum", crc32::checksum);
+
+  for (const auto &[variant, checksum] : variants) {
+    for (const size_t len : {size_t{64}, size_t{UNIV_PAGE_SIZE}}) {
+      runner.run(std::format("ut_crc32/{}/{}", variant, len), 1, [&](uint64_t n, ulint) {
+        for (uint64_t i{}; i < n; ++i) {
+          do_not_optimize(checksum(data.data(), len));
+        }
+      });
+    }
+  }
+}
+
+static void channel_benchmarks(Runner &runner) {
+  for (const auto n_threads : thread_counts()) {
+    Bounded_channel<ulint> channel(1024);
+
+    runner.run("Bounded_channel/push_pop", n_threads, [&](uint64_t n, ulint thread_no) {
+      ulint value{};
+
+      for (uint64_t i{}; i < n; ++i) {
+        while (!channel.enqueue(thread_no)) {}
+        while (!channel.dequeue(value)) {}
+      }
+
+      do_not_optimize(value);
+    });
+  }
+}
+
+static void mem_heap_benchmarks(Runner &runner) {
+  runner.run("mem_heap/create_alloc_free", 1, [](uint64_t n, ulint) {
+    for (uint64_t i{}; i < n; ++i) {
+      auto heap = mem_heap_create(1024);
+
+      for (ulint j{}; j < 4; ++j) {
+        do_not_optimize(mem_heap_alloc(heap, 64));
+      }
+
+      mem_heap_free(heap);
+    }
+  });
+}
+
+static void mtr_benchmarks(Runner &runner) {
+  runner.run("mtr/start_commit", 1, [](uint64_t n, ulint) {
+    for (uint64_t i{}; i < n; ++i) {
+      mtr_t mtr;
+
+      mtr.start();
+      mtr.commit();
+    }
+  });
+}
+
+static void latch_benchmarks(Runner &runner) {
+  mutex_t mutex;
+  rw_lock_t rw_lock;
+
+  mutex_create(&mutex, IF_DEBUG("bench_mutex",) IF_SYNC_DEBUG(SYNC_NO_ORDER_CHECK,) Current_location());
+  rw_lock_create(&rw_lock, SYNC_NO_ORDER_CHECK);
+
+  for (const auto n_threads : thread_counts()) {
+    runner.run("mutex/enter_exit", n_threads, [&](uint64_t n, ulint) {
+      for (uint64_t i{}; i < n; ++i) {
+        mutex_enter(&mutex);
+        mutex_exit(&mutex);
+      }
+    });
+
+    runner.run("rw_lock/s_lock_unlock", n_threads, [&](uint64_t n, ulint) {
+      for (uint64_t i{}; i < n; ++i) {
+        rw_lock_s_lock(&rw_lock);
+        rw_lock_s_unlock(&rw_lock);
+      }
+    });
+
+    runner.run("rw_lock/x_lock_unlock", n_threads, [&](uint64_t n, ulint) {
+      for (uint64_t i{}; i < n; ++i) {
+        rw_lock_x_lock(&rw_lock);
+        rw_lock_x_unlock(&rw_lock);
+      }
+    });
+  }
+
+  rw_lock_free(&rw_lock);
+  mutex_free(&mutex);
+}
+
+/** DROP TABLE bench/t, if it was left over by a run that did not finish. */
+static void drop_table_if_exists() {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  auto err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  (void) ib_table_drop(ib_trx, DATABASE "/" TABLE);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** CREATE TABLE bench/t(c1 INT UNSIGNED PRIMARY KEY, c2 VARCHAR(32)) with
+N_ROWS rows. */
+static void create_table() {
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+  ib_id_t table_id{};
+
+  auto err = ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_VARCHAR, IB_COL_NONE, 0, 32);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  ib_crsr_t crsr{};
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_cursor_lock(crsr, IB_LOCK_IX);
+  assert(err == DB_SUCCESS);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (uint32_t i{}; i < N_ROWS; ++i) {
+    const auto c2 = std::format("row {:08}", i);
+
+    err = ib_tuple_write_u32(tpl, 0, i);
+    assert(err == DB_SUCCESS);
+
+    err = ib_col_set_value(tpl, 1, c2.c_str(), c2.length());
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_insert_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+static void page_benchmarks(Runner &runner) {
+  auto table = srv_dict_sys->table_get(DATABASE "/" TABLE, false);
+  assert(table != nullptr);
+
+  const auto index = table->get_first_index();
+  const Page_id page_id{index->get_space_id(), index->get_page_no()};
+
+  for (const auto n_threads : thread_counts()) {
+    runner.run("Buf_pool::get/hit", n_threads, [&](uint64_t n, ulint) {
+      for (uint64_t i{}; i < n; ++i) {
+        mtr_t mtr;
+
+        mtr.start();
+
+        Buf_pool::Request req{
+          .m_rw_latch = RW_S_LATCH,
+          .m_page_id = page_id,
+          .m_mode = BUF_GET,
+          .m_file = __FILE__,
+          .m_line = __LINE__,
+          .m_mtr = &mtr
+        };
+
+        do_not_optimize(srv_buf_pool->get(req, nullptr));
+
+        mtr.commit();
+      }
+    });
+  }
+
+  /* The record benchmarks keep the root page latched. */
+  mtr_t mtr;
+
+  mtr.start();
+
+  Buf_pool::Request req{
+    .m_rw_latch = RW_S_LATCH,
+    .m_page_id = page_id,
+    .m_mode = BUF_GET,
+    .m_file = __FILE__,
+    .m_line = __LINE__,
+    .m_mtr = &mtr
+  };
+
+  const auto block = srv_buf_pool->get(req, nullptr);
+  const auto page = block->get_frame();
+
+  if (!page_is_leaf(page) || page_get_n_recs(page) != N_ROWS) {
+    std::cerr << "The benchmark table does not fit in one page, skipping the page benchmarks\n";
+    mtr.commit();
+    return;
+  }
+
+  auto heap = mem_heap_create(1024);
+  auto tuple = dtuple_create(heap, 1);
+  byte key[sizeof(uint32_t)];
+
+  dfield_set_data(dtuple_get_nth_field(tuple, 0), key, sizeof(key));
+  index->copy_types(tuple, 1);
+
+  runner.run("page_cur_search_with_match", 1, [&](uint64_t n, ulint) {
+    page_cur_t cursor;
+
+    for (uint64_t i{}; i < n; ++i) {
+      mach_write_to_4(key, uint32_t(i % N_ROWS));
+
+      (void) page_cur_search(block, index, tuple, PAGE_CUR_LE, &cursor);
+
+      do_not_optimize(page_cur_get_rec(&cursor));
+    }
+  });
+
+  /* The record in the middle of the page. */
+  page_cur_t cursor;
+
+  mach_write_to_4(key, N_ROWS / 2);
+
+  (void) page_cur_search(block, index, tuple, PAGE_CUR_LE, &cursor);
+
+  const auto rec = page_cur_get_rec(&cursor);
+
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+
+  rec_offs_init(offsets_);
+
+  runner.run("rec_get_offsets", 1, [&](uint64_t n, ulint) {
+    Phy_rec record{index, rec};
+
+    for (uint64_t i{}; i < n; ++i) {
+      offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
+
+      do_not_optimize(offsets);
+    }
+  });
+
+  runner.run("cmp_dtuple_rec_with_match", 1, [&](uint64_t n, ulint) {
+    for (uint64_t i{}; i < n; ++i) {
+      ulint matched_fields{};
+      ulint matched_bytes{};
+
+      do_not_optimize(cmp_dtuple_rec_with_match(index, tuple, rec, offsets, &matched_fields, &matched_bytes));
+    }
+  });
+
+  mem_heap_free(heap);
+
+  mtr.commit();
+}
+
+}  // namespace bench
+
+int main(int argc, char **argv) {
+  bench::Runner runner;
+  std::string out;
+
+  for (int i{1}; i < argc; ++i) {
+    const std::string arg{argv[i]};
+
+    if (arg.starts_with("--filter=")) {
+      runner.m_filter = arg.substr(strlen("--filter="));
+    } else if (arg.starts_with("--min_time=")) {
+      runner.m_min_time = std::chrono::nanoseconds(uint64_t(atof(arg.c_str() + strlen("--min_time=")) * 1e9));
+    } else if (arg.starts_with("--out=")) {
+      out = arg.substr(strlen("--out="));
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--filter=<substring>] [--min_time=<seconds>] [--out=<file>]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  err = ib_cfg_set_int("buffer_pool_size", 64 * 1024 * 1024);
+  assert(err == DB_SUCCESS);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  (void) ib_database_create(DATABASE);
+
+  bench::drop_table_if_exists();
+
+  bench::create_table();
+
+  bench::crc32_benchmarks(runner);
+  bench::channel_benchmarks(runner);
+  bench::mem_heap_benchmarks(runner);
+  bench::mtr_benchmarks(runner);
+  bench::latch_benchmarks(runner);
+  bench::page_benchmarks(runner);
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  const auto json = runner.to_json();
+
+  if (out.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream os(out, std::ios::out | std::ios::trunc);
+
+    os << json;
+
+    if (!os) {
+      std::cerr << "Cannot write " << out << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,861 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Scalability benchmark of the lock manager.
+
+ ib_lock_bench [--mode=lock_sys|btree|both] [--threads=<n>[,<n>...]]
+               [--rows=<n>] [--hot_rows=<n>] [--hot_pct=<0..100>]
+               [--write_pct=<0..100>] [--gap=rec|next_key|gap|mixed]
+               [--locks_per_trx=<n>] [--duration=<seconds>]
+               [--lock_wait_timeout=<seconds>] [--out=<file>]
+
+ Each thread runs transactions that lock --locks_per_trx rows in random
+ order and commit, which releases the locks and grants them to the waiters.
+ --hot_pct of the rows are picked from the first --hot_rows rows, the rest
+ uniformly from all of them. --write_pct of the locks are X locks, the rest
+ S locks. --gap selects the kind of the record locks: rec locks only the
+ records, next_key the records and the gaps before them, gap only the gaps,
+ mixed picks one of the three for each lock. The random lock order makes
+ deadlocks, they are detected when a lock request has to wait.
+
+ The lock_sys mode calls Lock_sys::rec_lock() directly under the kernel
+ mutex, on pages that only exist in the lock system, so only the lock
+ manager is measured. A lock wait is handled like the engine does, the
+ thread is suspended until the lock is granted, it times out or the
+ transaction is chosen as a deadlock victim. The time that rec_lock() holds
+ the kernel mutex is measured, and the time of the commits that release
+ the locks and grant them to the waiters.
+
+ The btree mode locks the rows of a real table bench/t through the cursor
+ API, with locking reads, so the locks are taken by the row search on the
+ B-tree pages. The rows have even keys, a gap lock is taken by a search for
+ an odd key and a next-key lock by a scan of two rows.
+
+ Each mode runs for --duration with each thread count. The lock
+ acquisitions per second, the waits, the deadlocks, the lock wait timeouts,
+ the latencies of the lock requests including the waits and the wait
+ profile of the kernel mutex are printed and written as JSON in the layout
+ of the Google Benchmark output, like ib_bench does. The kernel mutex wait
+ profile needs the latch profiler, it is switched on. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "api0misc.h"
+#include "buf0buf.h"
+#include "dict0dict.h"
+#include "lock0lock.h"
+#include "mach0data.h"
+#include "page0page.h"
+#include "pars0pars.h"
+#include "que0que.h"
+#include "row0sel.h"
+#include "srv0srv.h"
+#include "sync0spin.h"
+#include "trx0trx.h"
+#include "ut0histogram.h"
+#include "ut0mem.h"
+
+#include "../tests/test0aux.h"
+
+#define DATABASE "bench"
+#define TABLE "t"
+
+namespace bench {
+
+/** Rows on a page of the lock_sys mode. */
+constexpr uint32_t ROWS_PER_PAGE = 100;
+
+/** The pages of the lock_sys mode are numbered from here, far above the
+pages of the table whose space they use. */
+constexpr page_no_t FIRST_FAKE_PAGE_NO = 1 << 30;
+
+/** Kind of a record lock. */
+enum Gap_mode { REC, NEXT_KEY, GAP, MIXED };
+
+/** Options. */
+struct Options {
+  /** "lock_sys", "btree" or "both". */
+  std::string m_mode{"both"};
+
+  /** Thread counts to run with. */
+  std::vector<ulint> m_threads{1, 2, 4, 8, 16};
+
+  /** Rows that are locked. */
+  uint32_t m_rows{100000};
+
+  /** Rows of the hot set. */
+  uint32_t m_hot_rows{100};
+
+  /** Percentage of the locks on the hot set. */
+  uint32_t m_hot_pct{50};
+
+  /** Percentage of the locks that are X locks. */
+  uint32_t m_write_pct{20};
+
+  /** Kind of the record locks. */
+  Gap_mode m_gap{REC};
+
+  /** Rows locked by a transaction. */
+  uint32_t m_locks_per_trx{10};
+
+  /** How long each thread count runs. */
+  std::chrono::seconds m_duration{10};
+
+  /** Lock wait timeout in seconds. */
+  ulint m_lock_wait_timeout{10};
+
+  /** File for the JSON results, stdout if empty. */
+  std::string m_out{};
+};
+
+/** Results of a run, the threads add to them. */
+struct Stats {
+  /** Locks acquired. */
+  std::atomic<uint64_t> m_n_locks{};
+
+  /** Lock requests that waited. */
+  std::atomic<uint64_t> m_n_waits{};
+
+  /** Committed transactions. */
+  std::atomic<uint64_t> m_n_commits{};
+
+  /** Transactions rolled back as deadlock victims. */
+  std::atomic<uint64_t> m_n_deadlocks{};
+
+  /** Transactions rolled back on a lock wait timeout. */
+  std::atomic<uint64_t> m_n_timeouts{};
+
+  /** Latencies of the lock requests including the waits, in microseconds. */
+  ut::Latency_histogram m_request_us{};
+
+  /** Lock wait times, in microseconds. */
+  ut::Latency_histogram m_wait_us{};
+
+  /** Kernel mutex hold times of the lock requests, in nanoseconds. Only
+  measured in the lock_sys mode. */
+  ut::Latency_histogram m_hold_ns{};
+
+  /** Commit times, in microseconds. Only measured in the lock_sys mode. */
+  ut::Latency_histogram m_commit_us{};
+};
+
+/** Wait profile of the kernel mutex class. */
+struct Kernel_mutex_profile {
+  /** @return the current counts. */
+  static Kernel_mutex_profile get() {
+    auto latch_class = kernel_mutex.m_class;
+
+    return {latch_class->m_acquisitions.value(), latch_class->m_os_waits.load(), latch_class->m_wait_ns.load()};
+  }
+
+  /** @return the counts since an earlier snapshot. */
+  Kernel_mutex_profile operator-(const Kernel_mutex_profile &rhs) const {
+    return {m_acquisitions - rhs.m_acquisitions, m_os_waits - rhs.m_os_waits, m_wait_ns - rhs.m_wait_ns};
+  }
+
+  /** Blocking acquisitions. */
+  uint64_t m_acquisitions{};
+
+  /** Suspensions in the wait array. */
+  uint64_t m_os_waits{};
+
+  /** Time waited, in nanoseconds. */
+  uint64_t m_wait_ns{};
+};
+
+/** Results of a mode and a thread count. */
+struct Result {
+  /** Benchmark name. */
+  std::string m_name;
+
+  /** Threads. */
+  ulint m_n_threads{};
+
+  /** Wall clock time of the run. */
+  std::chrono::microseconds m_elapsed{};
+
+  /** Locks acquired, waits, commits, deadlocks and timeouts. */
+  uint64_t m_n_locks{};
+  uint64_t m_n_waits{};
+  uint64_t m_n_commits{};
+  uint64_t m_n_deadlocks{};
+  uint64_t m_n_timeouts{};
+
+  /** Percentiles of the requests, of the waits, of the hold times and of
+  the commits. */
+  ut::Latency_percentiles m_request_us{};
+  ut::Latency_percentiles m_wait_us{};
+  ut::Latency_percentiles m_hold_ns{};
+  ut::Latency_percentiles m_commit_us{};
+
+  /** Kernel mutex waits during the run. */
+  Kernel_mutex_profile m_kernel_mutex{};
+};
+
+/** Picks the rows and the lock modes of a thread. */
+struct Generator {
+  Generator(const Options &opts, uint64_t seed) : m_opts(opts), m_rng(seed) {}
+
+  /** @return the next row. */
+  uint32_t row() {
+    if (m_pct(m_rng) < m_opts.m_hot_pct) {
+      return std::uniform_int_distribution<uint32_t>(0, std::min(m_opts.m_hot_rows, m_opts.m_rows) - 1)(m_rng);
+    } else {
+      return std::uniform_int_distribution<uint32_t>(0, m_opts.m_rows - 1)(m_rng);
+    }
+  }
+
+  /** @return true for an X lock, false for an S lock. */
+  bool is_write() { return m_pct(m_rng) < m_opts.m_write_pct; }
+
+  /** @return the kind of the next lock. */
+  Gap_mode gap() { return m_opts.m_gap == MIXED ? Gap_mode(m_pct(m_rng) % 3) : m_opts.m_gap; }
+
+  /** Options. */
+  const Options &m_opts;
+
+  /** Random numbers. */
+  std::mt19937_64 m_rng;
+
+  /** Percentages. */
+  std::uniform_int_distribution<uint32_t> m_pct{0, 99};
+};
+
+/** @return microseconds since a time point. */
+static uint64_t us_since(std::chrono::steady_clock::time_point start) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+/** @return nanoseconds since a time point. */
+static uint64_t ns_since(std::chrono::steady_clock::time_point start) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+/** The pages of the lock_sys mode. The blocks only carry the page id and
+a frame with the number of records in the heap, that is all that the lock
+system reads from them. */
+struct Fake_pages {
+  /** @param[in] space Space of the pages
+  @param[in] n_rows Number of rows */
+  Fake_pages(space_id_t space, uint32_t n_rows) {
+    m_n_blocks = (n_rows + ROWS_PER_PAGE - 1) / ROWS_PER_PAGE;
+
+    m_frame_ptr = static_cast<byte *>(ut_new(2 * UNIV_PAGE_SIZE));
+    m_frame = static_cast<byte *>(ut_align(m_frame_ptr, UNIV_PAGE_SIZE));
+    memset(m_frame, 0, UNIV_PAGE_SIZE);
+
+    /* A compact page with the infimum, the supremum and ROWS_PER_PAGE
+    records. */
+    mach_write_to_2(m_frame + PAGE_HEADER + PAGE_N_HEAP, 0x8000 | (PAGE_HEAP_NO_USER_LOW + ROWS_PER_PAGE));
+
+    m_blocks = static_cast<Buf_block *>(ut_new(m_n_blocks * sizeof(Buf_block)));
+    memset(static_cast<void *>(m_blocks), 0, m_n_blocks * sizeof(Buf_block));
+
+    for (ulint i{}; i < m_n_blocks; ++i) {
+      auto &block = m_blocks[i];
+
+      block.m_page.m_space = space;
+      block.m_page.m_page_no = page_no_t(FIRST_FAKE_PAGE_NO + i);
+      block.m_page.m_state = BUF_BLOCK_FILE_PAGE;
+      block.m_frame = m_frame;
+    }
+  }
+
+  ~Fake_pages() {
+    ut_delete(m_blocks);
+    ut_delete(m_frame_ptr);
+  }
+
+  /** @return the block of a row. */
+  const Buf_block *block(uint32_t row) const { return &m_blocks[row / ROWS_PER_PAGE]; }
+
+  /** @return the heap number of a row. */
+  static ulint heap_no(uint32_t row) { return PAGE_HEAP_NO_USER_LOW + row % ROWS_PER_PAGE; }
+
+  /** Number of blocks. */
+  ulint m_n_blocks{};
+
+  /** The blocks. */
+  Buf_block *m_blocks{};
+
+  /** The frame shared by all the blocks. */
+  byte *m_frame{};
+
+  /** Memory of the frame. */
+  byte *m_frame_ptr{};
+};
+
+/** Requests a record lock like the row search does, waits if it has to.
+@param[in] block Page of the record
+@param[in] heap_no Heap number of the record
+@param[in] mode Lock mode
+@param[in] index Index of the record
+@param[in,out] thr Query thread of the transaction
+@param[in,out] stats Statistics
+@return DB_SUCCESS, DB_DEADLOCK or DB_LOCK_WAIT_TIMEOUT, the transaction was
+rolled back on an error */
+static db_err rec_lock(const Buf_block *block, ulint heap_no, Lock_mode mode, const Index *index, que_thr_t *thr, Stats &stats) {
+  auto trx = thr_get_trx(thr);
+  const auto start = std::chrono::steady_clock::now();
+  bool waited{};
+
+  for (;;) {
+    thr->run_node = thr;
+    thr->prev_node = thr->common.parent;
+
+    mutex_enter(&kernel_mutex);
+
+    const auto hold_start = std::chrono::steady_clock::now();
+
+    auto err = srv_lock_sys->rec_lock(false, mode, block, heap_no, index, thr);
+
+    stats.m_hold_ns.add(ns_since(hold_start));
+
+    mutex_exit(&kernel_mutex);
+
+    trx->m_error_state = err;
+
+    if (likely(err == DB_SUCCESS)) {
+      que_thr_stop_for_client_no_error(thr, trx);
+      break;
+    }
+
+    que_thr_stop_client(thr);
+
+    if (err == DB_LOCK_WAIT && !waited) {
+      waited = true;
+      stats.m_n_waits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const auto is_wait = err == DB_LOCK_WAIT;
+    const auto wait_start = std::chrono::steady_clock::now();
+    const auto was_lock_wait = ib_handle_errors(&err, trx, thr, nullptr);
+
+    if (is_wait) {
+      stats.m_wait_us.add(us_since(wait_start));
+    }
+
+    if (!was_lock_wait) {
+      return err;
+    }
+
+    /* The lock was granted, the retry finds it. */
+  }
+
+  stats.m_request_us.add(us_since(start));
+
+  return DB_SUCCESS;
+}
+
+/** A thread of the lock_sys mode.
+@param[in] opts Options
+@param[in] pages The pages of the rows
+@param[in] table_id Id of the table the locks are on
+@param[in] index Index of the locks
+@param[in] seed Random seed
+@param[in] end When to stop
+@param[in,out] stats Statistics */
+static void lock_sys_thread(const Options &opts, const Fake_pages &pages, ib_id_t table_id, const Index *index, uint64_t seed,
+                            std::chrono::steady_clock::time_point end, Stats &stats) {
+  Generator gen(opts, seed);
+
+  while (std::chrono::steady_clock::now() < end) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+    auto err = ib_table_lock(ib_trx, table_id, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    /* A dummy graph for the lock module calls, like the table locks of the
+    cursor API use. */
+    auto heap = mem_heap_create(512);
+    auto thr = pars_complete_graph_for_exec(sel_node_t::create(heap), trx, heap);
+
+    thr->graph->state = QUE_FORK_ACTIVE;
+    thr = que_fork_get_first_thr(static_cast<que_fork_t *>(que_node_get_parent(thr)));
+    que_thr_move_to_run_state(thr);
+
+    for (uint32_t i{}; i < opts.m_locks_per_trx && err == DB_SUCCESS; ++i) {
+      const auto row = gen.row();
+      auto mode = gen.is_write() ? LOCK_X : LOCK_S;
+
+      switch (gen.gap()) {
+        case REC:
+          mode = Lock_mode(mode | LOCK_REC_NOT_GAP);
+          break;
+        case GAP:
+          mode = Lock_mode(mode | LOCK_GAP);
+          break;
+        case NEXT_KEY:
+        case MIXED:
+          break;
+      }
+
+      err = rec_lock(pages.block(row), Fake_pages::heap_no(row), mode, index, thr, stats);
+
+      if (err == DB_SUCCESS) {
+        stats.m_n_locks.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    que_graph_free(thr->graph);
+
+    if (err == DB_SUCCESS) {
+      /* The commit releases the locks and grants them to the waiters. */
+      const auto start = std::chrono::steady_clock::now();
+
+      err = ib_trx_commit(ib_trx);
+      assert(err == DB_SUCCESS);
+
+      stats.m_commit_us.add(us_since(start));
+      stats.m_n_commits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      (err == DB_DEADLOCK ? stats.m_n_deadlocks : stats.m_n_timeouts).fetch_add(1, std::memory_order_relaxed);
+
+      err = ib_trx_rollback(ib_trx);
+      assert(err == DB_SUCCESS);
+    }
+  }
+}
+
+/** A thread of the btree mode.
+@param[in] opts Options
+@param[in] seed Random seed
+@param[in] end When to stop
+@param[in,out] stats Statistics */
+static void btree_thread(const Options &opts, uint64_t seed, std::chrono::steady_clock::time_point end, Stats &stats) {
+  Generator gen(opts, seed);
+  ib_crsr_t crsr{};
+
+  auto err = ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &crsr);
+  assert(err == DB_SUCCESS);
+
+  auto key = ib_clust_search_tuple_create(crsr);
+  assert(key != nullptr);
+
+  while (std::chrono::steady_clock::now() < end) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    ib_cursor_attach_trx(crsr, ib_trx);
+
+    err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    for (uint32_t i{}; i < opts.m_locks_per_trx && err == DB_SUCCESS; ++i) {
+      const auto row = gen.row();
+      const auto gap = gen.gap();
+      const auto start = std::chrono::steady_clock::now();
+      int res{};
+
+      err = ib_cursor_set_lock_mode(crsr, gen.is_write() ? IB_LOCK_X : IB_LOCK_S);
+      assert(err == DB_SUCCESS);
+
+      /* The rows have even keys, the odd keys are in the gaps. */
+      err = ib_tuple_write_u32(key, 0, gap == GAP ? 2 * row + 1 : 2 * row);
+      assert(err == DB_SUCCESS);
+
+      ib_cursor_set_match_mode(crsr, gap == NEXT_KEY ? IB_CLOSEST_MATCH : IB_EXACT_MATCH);
+
+      err = ib_cursor_moveto(crsr, key, IB_CUR_GE, &res);
+
+      if (gap == NEXT_KEY && err == DB_SUCCESS) {
+        err = ib_cursor_next(crsr);
+      }
+
+      if (err == DB_RECORD_NOT_FOUND || err == DB_END_OF_INDEX) {
+        err = DB_SUCCESS;
+      }
+
+      if (err == DB_SUCCESS) {
+        stats.m_request_us.add(us_since(start));
+        stats.m_n_locks.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    auto reset_err = ib_cursor_reset(crsr);
+    assert(reset_err == DB_SUCCESS);
+
+    if (err == DB_SUCCESS) {
+      err = ib_trx_commit(ib_trx);
+      assert(err == DB_SUCCESS);
+
+      stats.m_n_commits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      assert(err == DB_DEADLOCK || err == DB_LOCK_WAIT_TIMEOUT);
+
+      (err == DB_DEADLOCK ? stats.m_n_deadlocks : stats.m_n_timeouts).fetch_add(1, std::memory_order_relaxed);
+
+      err = ib_trx_rollback(ib_trx);
+      assert(err == DB_SUCCESS);
+    }
+  }
+
+  ib_tuple_delete(key);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+}
+
+/** @return the value of a status variable. */
+static int64_t status(const char *name) {
+  int64_t v{};
+
+  auto err = ib_status_get_i64(name, &v);
+  assert(err == DB_SUCCESS);
+
+  return v;
+}
+
+/** Runs a mode with a thread count.
+@param[in] opts Options
+@param[in] mode "lock_sys" or "btree"
+@param[in] n_threads Number of threads
+@param[in] pages The pages of the lock_sys mode
+@param[in] table_id Id of the table
+@param[in] index Clustered index of the table
+@return the results */
+static Result run(const Options &opts, const std::string &mode, ulint n_threads, const Fake_pages &pages, ib_id_t table_id,
+                  const Index *index) {
+  Stats stats;
+  std::vector<std::thread> threads;
+  const auto waits = status("row_lock_waits");
+  const auto profile = Kernel_mutex_profile::get();
+  const auto start = std::chrono::steady_clock::now();
+  const auto end = start + opts.m_duration;
+
+  for (ulint i{}; i < n_threads; ++i) {
+    if (mode == "lock_sys") {
+      threads.emplace_back(lock_sys_thread, std::cref(opts), std::cref(pages), table_id, index, uint64_t(i + 1), end, std::ref(stats));
+    } else {
+      threads.emplace_back(btree_thread, std::cref(opts), uint64_t(i + 1), end, std::ref(stats));
+    }
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  Result result;
+
+  result.m_name = std::format("lock/{}/threads:{}", mode, n_threads);
+  result.m_n_threads = n_threads;
+  result.m_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  result.m_n_locks = stats.m_n_locks.load();
+  result.m_n_commits = stats.m_n_commits.load();
+  result.m_n_deadlocks = stats.m_n_deadlocks.load();
+  result.m_n_timeouts = stats.m_n_timeouts.load();
+  result.m_request_us = stats.m_request_us.get_percentiles();
+  result.m_hold_ns = stats.m_hold_ns.get_percentiles();
+  result.m_commit_us = stats.m_commit_us.get_percentiles();
+  result.m_kernel_mutex = Kernel_mutex_profile::get() - profile;
+
+  if (mode == "lock_sys") {
+    result.m_n_waits = stats.m_n_waits.load();
+    result.m_wait_us = stats.m_wait_us.get_percentiles();
+  } else {
+    /* The waits happen inside the row search, the engine counts them. */
+    result.m_n_waits = uint64_t(status("row_lock_waits") - waits);
+  }
+
+  const auto secs = std::max(double(result.m_elapsed.count()) / 1e6, 1e-6);
+
+  std::cerr << std::format(
+    "{:<28} {:>12.0f} locks/s {:>10.0f} trx/s waits: {} deadlocks: {} timeouts: {}\n"
+    "  request: {}\n",
+    result.m_name, double(result.m_n_locks) / secs, double(result.m_n_commits) / secs, result.m_n_waits,
+    result.m_n_deadlocks, result.m_n_timeouts, result.m_request_us.to_string());
+
+  if (mode == "lock_sys") {
+    std::cerr << std::format(
+      "  wait: {}\n  commit: {}\n  kernel_mutex hold: p50: {}ns, p99: {}ns, p999: {}ns, max: {}ns\n",
+      result.m_wait_us.to_string(), result.m_commit_us.to_string(), result.m_hold_ns.m_p50, result.m_hold_ns.m_p99,
+      result.m_hold_ns.m_p999, result.m_hold_ns.m_max);
+  }
+
+  std::cerr << std::format(
+    "  kernel_mutex: {} blocking acquisitions, {} os waits, {:.3f} ms waited\n", result.m_kernel_mutex.m_acquisitions,
+    result.m_kernel_mutex.m_os_waits, double(result.m_kernel_mutex.m_wait_ns) / 1e6);
+
+  return result;
+}
+
+/** CREATE TABLE bench/t(c1 INT UNSIGNED PRIMARY KEY, c2 INT UNSIGNED) with
+rows of the keys 0, 2, 4, ... */
+static void create_table(const Options &opts) {
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+  ib_id_t table_id{};
+
+  auto err = ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  (void) ib_table_drop(ib_trx, DATABASE "/" TABLE);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  ib_crsr_t crsr{};
+
+  err = ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &crsr);
+  assert(err == DB_SUCCESS);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (uint32_t row{}; row < opts.m_rows; row += 1000) {
+    ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    ib_cursor_attach_trx(crsr, ib_trx);
+
+    err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    for (auto i = row; i < std::min(row + 1000, opts.m_rows); ++i) {
+      err = ib_tuple_write_u32(tpl, 0, 2 * i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_tuple_write_u32(tpl, 1, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    err = ib_cursor_reset(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+
+  ib_tuple_delete(tpl);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+}
+
+/** @return the results in JSON. */
+static std::string to_json(const Options &opts, const std::vector<Result> &results) {
+  std::ostringstream os;
+  char date[64];
+  const auto now = std::time(nullptr);
+  const std::array<const char *, 4> gaps{"rec", "next_key", "gap", "mixed"};
+
+  (void) std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+  os << "{\n  \"context\": {\n";
+  os << std::format("    \"date\": \"{}\",\n", date);
+  os << std::format("    \"num_cpus\": {},\n", std::thread::hardware_concurrency());
+  os << std::format("    \"rows\": {},\n", opts.m_rows);
+  os << std::format("    \"hot_rows\": {},\n", opts.m_hot_rows);
+  os << std::format("    \"hot_pct\": {},\n", opts.m_hot_pct);
+  os << std::format("    \"write_pct\": {},\n", opts.m_write_pct);
+  os << std::format("    \"gap\": \"{}\",\n", gaps[opts.m_gap]);
+  os << std::format("    \"locks_per_trx\": {}\n", opts.m_locks_per_trx);
+  os << "  },\n  \"benchmarks\": [\n";
+
+  for (size_t i{}; i < results.size(); ++i) {
+    const auto &r = results[i];
+    const auto secs = std::max(double(r.m_elapsed.count()) / 1e6, 1e-6);
+
+    os << std::format(
+      "    {{\"name\": \"{}\", \"threads\": {}, \"iterations\": {}, \"real_time\": {:.3f}, \"time_unit\": \"us\", "
+      "\"items_per_second\": {:.0f}, \"trx_per_second\": {:.0f}, \"waits\": {}, \"deadlocks\": {}, \"timeouts\": {}, "
+      "\"request_p50_us\": {}, \"request_p99_us\": {}, \"wait_p50_us\": {}, \"wait_p99_us\": {}, "
+      "\"hold_p50_ns\": {}, \"hold_p99_ns\": {}, \"commit_p50_us\": {}, \"commit_p99_us\": {}, "
+      "\"kernel_mutex_os_waits\": {}, \"kernel_mutex_wait_ns\": {}}}{}\n",
+      r.m_name, r.m_n_threads, r.m_n_locks,
+      r.m_n_locks > 0 ? double(r.m_elapsed.count()) * double(r.m_n_threads) / double(r.m_n_locks) : 0.0,
+      double(r.m_n_locks) / secs, double(r.m_n_commits) / secs, r.m_n_waits, r.m_n_deadlocks, r.m_n_timeouts,
+      r.m_request_us.m_p50, r.m_request_us.m_p99, r.m_wait_us.m_p50, r.m_wait_us.m_p99, r.m_hold_ns.m_p50,
+      r.m_hold_ns.m_p99, r.m_commit_us.m_p50, r.m_commit_us.m_p99, r.m_kernel_mutex.m_os_waits, r.m_kernel_mutex.m_wait_ns, i + 1 < results.size() ? "," : "");
+  }
+
+  os << "  ]\n}\n";
+
+  return os.str();
+}
+
+}  // namespace bench
+
+int main(int argc, char **argv) {
+  bench::Options opts;
+  bool valid{true};
+
+  for (int i{1}; i < argc && valid; ++i) {
+    const std::string arg{argv[i]};
+    const auto value = [&](const char *name) { return strtoul(arg.c_str() + strlen(name), nullptr, 10); };
+
+    if (arg.starts_with("--mode=")) {
+      opts.m_mode = arg.substr(strlen("--mode="));
+    } else if (arg.starts_with("--threads=")) {
+      std::istringstream is(arg.substr(strlen("--threads=")));
+      std::string n;
+
+      opts.m_threads.clear();
+
+      while (std::getline(is, n, ',')) {
+        opts.m_threads.push_back(strtoul(n.c_str(), nullptr, 10));
+      }
+    } else if (arg.starts_with("--rows=")) {
+      opts.m_rows = uint32_t(value("--rows="));
+    } else if (arg.starts_with("--hot_rows=")) {
+      opts.m_hot_rows = uint32_t(value("--hot_rows="));
+    } else if (arg.starts_with("--hot_pct=")) {
+      opts.m_hot_pct = uint32_t(value("--hot_pct="));
+    } else if (arg.starts_with("--write_pct=")) {
+      opts.m_write_pct = uint32_t(value("--write_pct="));
+    } else if (arg == "--gap=rec") {
+      opts.m_gap = bench::REC;
+    } else if (arg == "--gap=next_key") {
+      opts.m_gap = bench::NEXT_KEY;
+    } else if (arg == "--gap=gap") {
+      opts.m_gap = bench::GAP;
+    } else if (arg == "--gap=mixed") {
+      opts.m_gap = bench::MIXED;
+    } else if (arg.starts_with("--locks_per_trx=")) {
+      opts.m_locks_per_trx = uint32_t(value("--locks_per_trx="));
+    } else if (arg.starts_with("--duration=")) {
+      opts.m_duration = std::chrono::seconds(value("--duration="));
+    } else if (arg.starts_with("--lock_wait_timeout=")) {
+      opts.m_lock_wait_timeout = value("--lock_wait_timeout=");
+    } else if (arg.starts_with("--out=")) {
+      opts.m_out = arg.substr(strlen("--out="));
+    } else {
+      valid = false;
+    }
+  }
+
+  if (!valid || (opts.m_mode != "lock_sys" && opts.m_mode != "btree" && opts.m_mode != "both") || opts.m_threads.empty() ||
+      std::find(opts.m_threads.begin(), opts.m_threads.end(), 0) != opts.m_threads.end() || opts.m_rows == 0 ||
+      opts.m_hot_rows == 0 || opts.m_hot_pct > 100 || opts.m_write_pct > 100 || opts.m_locks_per_trx == 0) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--mode=lock_sys|btree|both] [--threads=<n>[,<n>...]] [--rows=<n>] [--hot_rows=<n>]"
+                 " [--hot_pct=<0..100>] [--write_pct=<0..100>] [--gap=rec|next_key|gap|mixed] [--locks_per_trx=<n>]"
+                 " [--duration=<seconds>] [--lock_wait_timeout=<seconds>] [--out=<file>]\n";
+    return EXIT_FAILURE;
+  }
+
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  err = ib_cfg_set_int("buffer_pool_size", 256 * 1024 * 1024);
+  assert(err == DB_SUCCESS);
+
+  err = ib_cfg_set_int("lock_wait_timeout", opts.m_lock_wait_timeout);
+  assert(err == DB_SUCCESS);
+
+  err = ib_cfg_set_bool_on("latch_profile");
+  assert(err == DB_SUCCESS);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  (void) ib_database_create(DATABASE);
+
+  bench::create_table(opts);
+
+  ib_id_t table_id{};
+
+  err = ib_table_get_id(DATABASE "/" TABLE, &table_id);
+  assert(err == DB_SUCCESS);
+
+  /* The lock_sys mode puts its locks on the clustered index of the table,
+  the table is not dropped while it is open. */
+  auto table = srv_dict_sys->table_get(DATABASE "/" TABLE, true);
+  assert(table != nullptr);
+
+  std::vector<bench::Result> results;
+
+  {
+    const bench::Fake_pages pages(table->m_space_id, opts.m_rows);
+
+    for (const auto mode : {"lock_sys", "btree"}) {
+      if (opts.m_mode == mode || opts.m_mode == "both") {
+        for (auto n_threads : opts.m_threads) {
+          results.push_back(bench::run(opts, mode, n_threads, pages, table_id, table->get_clustered_index()));
+        }
+      }
+    }
+  }
+
+  srv_dict_sys->table_decrement_handle_count(table, false);
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  const auto json = bench::to_json(opts, results);
+
+  if (opts.m_out.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream os(opts.m_out, std::ios::out | std::ios::trunc);
+
+    os << json;
+
+    if (!os) {
+      std::cerr << "Cannot write " << opts.m_out << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
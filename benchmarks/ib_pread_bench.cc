@@ -0,0 +1,583 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Parallel scan scalability benchmark.
+
+ ib_pread_bench [--rows=<n>] [--row_len=<bytes>] [--buffer_pool_mb=<n>]
+                [--resident_pct=<0..100>] [--filter_pct=<0..100>]
+                [--threads=<n>[,<n>...]] [--out=<file>]
+
+ Creates bench/t(c1 INT UNSIGNED PRIMARY KEY, c2 INT UNSIGNED,
+ c3 VARCHAR(--row_len)) with --rows rows, c2 is c1 % 100. For each thread
+ count the engine is restarted so that the buffer pool is empty, the first
+ --resident_pct percent of the rows are read into it and then the table is
+ scanned with ib_parallel_scan() and a batch visitor that sums c1. With a
+ --buffer_pool_mb smaller than the table even a warm scan reads pages.
+
+ With --filter_pct below 100 the scan pushes down c2 < --filter_pct, the
+ rows that fail it are skipped by the scan threads without being copied.
+
+ For each run the rows per second, the I/O and the work of each scan thread
+ are printed: the ranges it scanned, the time in the traversal of the
+ ranges, the time taking ranges off the shared queue and the time idle
+ waiting for the busy threads to split their ranges. The imbalance is the
+ largest number of rows of a range, and of a thread, over the mean. The
+ results are written as JSON in the layout of the Google Benchmark output,
+ like ib_bench does, with one entry per run and one per scan thread. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../tests/test0aux.h"
+
+#define DATABASE "bench"
+#define TABLE "t"
+
+namespace bench {
+
+/** Page size of the tablespaces. */
+constexpr int64_t PAGE_SIZE = 16 * 1024;
+
+/** Options. */
+struct Options {
+  /** Rows in the table. */
+  uint32_t m_rows{1000000};
+
+  /** Length of the c3 column. */
+  uint32_t m_row_len{100};
+
+  /** Buffer pool size in MiB, 0 to fit the table. */
+  uint64_t m_buffer_pool_mb{};
+
+  /** Percentage of the rows read into the buffer pool before a scan. */
+  uint32_t m_resident_pct{100};
+
+  /** Percentage of the rows that pass the pushed down filter. */
+  uint32_t m_filter_pct{100};
+
+  /** Scan thread counts to run with. */
+  std::vector<size_t> m_threads{1, 2, 4, 8, 16};
+
+  /** File for the JSON results, stdout if empty. */
+  std::string m_out{};
+};
+
+/** The work of a scan thread. */
+struct Thread_result {
+  size_t m_thread_id{};
+  ib_parallel_scan_stats_t m_stats{};
+};
+
+/** Results of a run. */
+struct Result {
+  size_t m_n_threads{};
+  std::chrono::microseconds m_elapsed{};
+
+  /** Rows passed to the visitor. */
+  uint64_t m_n_rows{};
+
+  /** Records skipped by the scan threads. */
+  uint64_t m_n_skipped{};
+
+  /** Sum of c1 over the rows visited. */
+  uint64_t m_sum{};
+
+  /** Pages read from the files during the scan. */
+  int64_t m_pages_read{};
+
+  /** Number of ranges scanned by all the threads. */
+  size_t m_n_ranges{};
+
+  /** Rows of the smallest and of the largest range. */
+  uint64_t m_min_range_rows{};
+  uint64_t m_max_range_rows{};
+
+  /** Largest rows of a range and of a thread over the means. */
+  double m_range_imbalance{};
+  double m_thread_imbalance{};
+
+  /** Time of all the threads in the traversal, the dequeue and idle. */
+  uint64_t m_scan_ns{};
+  uint64_t m_dequeue_ns{};
+  uint64_t m_idle_ns{};
+
+  /** The work of each thread, by thread id. */
+  std::vector<Thread_result> m_threads;
+};
+
+/** @return the value of a status variable. */
+static int64_t status(const char *name) {
+  int64_t v{};
+
+  auto err = ib_status_get_i64(name, &v);
+  assert(err == DB_SUCCESS);
+
+  return v;
+}
+
+/** Set the configuration and start the engine. */
+static void startup(const Options &opts) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  /* Room for the table, the rows are about 20 bytes longer than c3 and the
+  pages are filled to about 15/16. */
+  const uint64_t table_bytes = uint64_t(opts.m_rows) * (opts.m_row_len + 20) * 16 / 15;
+  const uint64_t buffer_pool_bytes =
+    opts.m_buffer_pool_mb > 0 ? opts.m_buffer_pool_mb * 1024 * 1024 : std::max(table_bytes * 5 / 4, uint64_t(64 * 1024 * 1024));
+
+  err = ib_cfg_set_int("buffer_pool_size", buffer_pool_bytes);
+  assert(err == DB_SUCCESS);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+}
+
+/** Create the table and insert the rows. */
+static void load(const Options &opts) {
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+  ib_id_t table_id{};
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  auto err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  (void) ib_table_drop(ib_trx, DATABASE "/" TABLE);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c3", IB_VARCHAR, IB_COL_NONE, 0, opts.m_row_len);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  ib_crsr_t crsr{};
+
+  err = ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &crsr);
+  assert(err == DB_SUCCESS);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  const std::string c3(opts.m_row_len, 'x');
+
+  for (uint32_t c1{}; c1 < opts.m_rows; c1 += 1000) {
+    ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    assert(ib_trx != nullptr);
+
+    ib_cursor_attach_trx(crsr, ib_trx);
+
+    err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    for (auto i = c1; i < std::min(c1 + 1000, opts.m_rows); ++i) {
+      err = ib_tuple_write_u32(tpl, 0, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_tuple_write_u32(tpl, 1, i % 100);
+      assert(err == DB_SUCCESS);
+
+      err = ib_col_set_value(tpl, 2, c3.data(), c3.size());
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    err = ib_cursor_reset(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+
+  ib_tuple_delete(tpl);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+}
+
+/** Scan the table, or the rows before a key.
+@param[in] opts                 Options
+@param[in] n_threads            Number of scan threads
+@param[in] end                  Scan the rows before this key, all if 0
+@param[in] filter               Push down c2 < --filter_pct
+@param[in,out] result           The rows and the work of the threads are
+                                added to it
+@return the error code of the scan */
+static ib_err_t scan(const Options &opts, size_t n_threads, uint32_t end, bool filter, Result &result) {
+  ib_crsr_t crsr{};
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  assert(ib_trx != nullptr);
+
+  auto err = ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  auto end_tpl = ib_clust_search_tuple_create(crsr);
+  assert(end_tpl != nullptr);
+
+  err = ib_tuple_write_u32(end_tpl, 0, end);
+  assert(err == DB_SUCCESS);
+
+  auto filter_values = ib_clust_read_tuple_create(crsr);
+  assert(filter_values != nullptr);
+
+  ib_parallel_scan_t cbs{};
+  std::mutex mutex{};
+
+  /* The sums are per thread, padded to keep them on different cache lines. */
+  std::vector<std::array<uint64_t, 8>> sums(std::max(n_threads, size_t(1)));
+
+  cbs.cols = {0};
+
+  cbs.batch = [&](size_t thread_id, const std::vector<ib_col_batch_t> &batch) -> ib_err_t {
+    const auto &c1 = batch[0];
+    auto &sum = sums[thread_id][0];
+
+    /* The values are in the host format, back to back. */
+    for (ulint i{}; i < c1.n_rows(); ++i) {
+      uint32_t v;
+
+      memcpy(&v, &c1.data[c1.offsets[i]], sizeof(v));
+      sum += v;
+    }
+
+    return DB_SUCCESS;
+  };
+
+  cbs.stats = [&](size_t thread_id, const ib_parallel_scan_stats_t &stats) {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    result.m_threads.push_back(Thread_result{thread_id, stats});
+  };
+
+  if (filter) {
+    err = ib_tuple_write_u32(filter_values, 1, opts.m_filter_pct);
+    assert(err == DB_SUCCESS);
+
+    cbs.filters.push_back(ib_scan_filter_t{1, ib_scan_filter_t::LT});
+    cbs.filter_values = filter_values;
+  }
+
+  err = ib_parallel_scan(ib_trx, crsr, n_threads, nullptr, end > 0 ? end_tpl : nullptr, cbs);
+
+  for (const auto &sum : sums) {
+    result.m_sum += sum[0];
+  }
+
+  ib_tuple_delete(filter_values);
+  ib_tuple_delete(end_tpl);
+
+  auto close_err = ib_cursor_close(crsr);
+  assert(close_err == DB_SUCCESS);
+
+  close_err = ib_trx_commit(ib_trx);
+  assert(close_err == DB_SUCCESS);
+
+  return err;
+}
+
+/** Run the scan with a number of threads on a restarted engine.
+@param[in] opts                 Options
+@param[in] n_threads            Number of scan threads
+@return the results */
+static Result run(const Options &opts, size_t n_threads) {
+  Result result{};
+
+  /* Empty the buffer pool. */
+  auto err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  startup(opts);
+
+  if (opts.m_resident_pct > 0) {
+    Result warmup{};
+    const auto end = uint32_t(uint64_t(opts.m_rows) * opts.m_resident_pct / 100);
+
+    err = scan(opts, 1, end < opts.m_rows ? end : 0, false, warmup);
+    assert(err == DB_SUCCESS);
+  }
+
+  const auto pages_read = status("buffer_pool_pages_read");
+  const auto start = std::chrono::steady_clock::now();
+
+  err = scan(opts, n_threads, 0, opts.m_filter_pct < 100, result);
+  assert(err == DB_SUCCESS);
+
+  result.m_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  result.m_pages_read = status("buffer_pool_pages_read") - pages_read;
+  result.m_n_threads = n_threads;
+
+  std::sort(result.m_threads.begin(), result.m_threads.end(),
+            [](const Thread_result &lhs, const Thread_result &rhs) { return lhs.m_thread_id < rhs.m_thread_id; });
+
+  uint64_t max_thread_rows{};
+  result.m_min_range_rows = std::numeric_limits<uint64_t>::max();
+
+  for (const auto &thread : result.m_threads) {
+    const auto &stats = thread.m_stats;
+
+    result.m_n_rows += stats.n_rows;
+    result.m_n_skipped += stats.n_skipped;
+    result.m_n_ranges += stats.range_rows.size();
+    result.m_scan_ns += stats.scan_ns;
+    result.m_dequeue_ns += stats.dequeue_ns;
+    result.m_idle_ns += stats.idle_ns;
+
+    max_thread_rows = std::max(max_thread_rows, stats.n_rows);
+
+    for (auto n_rows : stats.range_rows) {
+      result.m_min_range_rows = std::min(result.m_min_range_rows, n_rows);
+      result.m_max_range_rows = std::max(result.m_max_range_rows, n_rows);
+    }
+  }
+
+  if (result.m_n_ranges == 0) {
+    result.m_min_range_rows = 0;
+  }
+
+  if (result.m_n_rows > 0) {
+    result.m_range_imbalance = double(result.m_max_range_rows) * double(result.m_n_ranges) / double(result.m_n_rows);
+    result.m_thread_imbalance = double(max_thread_rows) * double(result.m_threads.size()) / double(result.m_n_rows);
+  }
+
+  return result;
+}
+
+/** @return ns as a percentage of the wall time of all the threads. */
+static double pct_of_wall(const Result &r, uint64_t ns) {
+  const auto wall_ns = double(r.m_elapsed.count()) * 1000.0 * double(std::max(r.m_threads.size(), size_t(1)));
+
+  return wall_ns > 0 ? 100.0 * double(ns) / wall_ns : 0.0;
+}
+
+/** Print the results of a run. */
+static void print(const Result &r) {
+  const auto secs = std::max(double(r.m_elapsed.count()) / 1e6, 1e-6);
+
+  std::cerr << std::format(
+    "threads {:>3} ({} ran): {:>12.0f} rows/s {:>12.0f} recs/s {:>8.1f} MiB/s read, {} pages read, {} ranges"
+    " of {}..{} rows, imbalance range {:.2f} thread {:.2f}, scan {:.1f}% dequeue {:.2f}% idle {:.1f}%\n",
+    r.m_n_threads, r.m_threads.size(), double(r.m_n_rows) / secs, double(r.m_n_rows + r.m_n_skipped) / secs,
+    double(r.m_pages_read * PAGE_SIZE) / secs / (1024.0 * 1024.0), r.m_pages_read, r.m_n_ranges, r.m_min_range_rows,
+    r.m_max_range_rows, r.m_range_imbalance, r.m_thread_imbalance, pct_of_wall(r, r.m_scan_ns), pct_of_wall(r, r.m_dequeue_ns),
+    pct_of_wall(r, r.m_idle_ns));
+
+  for (const auto &thread : r.m_threads) {
+    const auto &stats = thread.m_stats;
+
+    std::cerr << std::format("  thread {:>3}: {:>10} rows {:>6} ranges {:>8} pages, scan {:>8.1f} ms dequeue {:>8.3f} ms idle {:>8.1f} ms\n",
+                             thread.m_thread_id, stats.n_rows, stats.n_ranges, stats.n_pages, double(stats.scan_ns) / 1e6,
+                             double(stats.dequeue_ns) / 1e6, double(stats.idle_ns) / 1e6);
+  }
+}
+
+/** @return the results in JSON, in the Google Benchmark layout. */
+static std::string to_json(const Options &opts, const std::vector<Result> &results) {
+  std::ostringstream os;
+  char date[64];
+  const auto now = std::time(nullptr);
+
+  (void) std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+  os << "{\n  \"context\": {\n";
+  os << std::format("    \"date\": \"{}\",\n", date);
+  os << std::format("    \"num_cpus\": {},\n", std::thread::hardware_concurrency());
+  os << std::format("    \"rows\": {},\n", opts.m_rows);
+  os << std::format("    \"row_len\": {},\n", opts.m_row_len);
+  os << std::format("    \"buffer_pool_mb\": {},\n", opts.m_buffer_pool_mb);
+  os << std::format("    \"resident_pct\": {},\n", opts.m_resident_pct);
+  os << std::format("    \"filter_pct\": {}\n", opts.m_filter_pct);
+  os << "  },\n  \"benchmarks\": [\n";
+
+  std::vector<std::string> entries;
+
+  for (const auto &r : results) {
+    const auto secs = std::max(double(r.m_elapsed.count()) / 1e6, 1e-6);
+    const auto name = std::format("pread/threads:{}", r.m_n_threads);
+
+    entries.push_back(std::format(
+      "    {{\"name\": \"{}\", \"threads\": {}, \"iterations\": 1, \"real_time\": {:.3f}, \"time_unit\": \"ms\", "
+      "\"items_per_second\": {:.0f}, \"bytes_per_second\": {:.0f}, \"rows\": {}, \"skipped\": {}, \"pages_read\": {}, "
+      "\"ranges\": {}, \"range_rows_min\": {}, \"range_rows_max\": {}, \"range_imbalance\": {:.3f}, "
+      "\"thread_imbalance\": {:.3f}, \"scan_pct\": {:.2f}, \"dequeue_pct\": {:.3f}, \"idle_pct\": {:.2f}}}",
+      name, r.m_threads.size(), double(r.m_elapsed.count()) / 1000.0, double(r.m_n_rows) / secs,
+      double(r.m_pages_read * PAGE_SIZE) / secs, r.m_n_rows, r.m_n_skipped, r.m_pages_read, r.m_n_ranges,
+      r.m_min_range_rows, r.m_max_range_rows, r.m_range_imbalance, r.m_thread_imbalance, pct_of_wall(r, r.m_scan_ns),
+      pct_of_wall(r, r.m_dequeue_ns), pct_of_wall(r, r.m_idle_ns)));
+
+    for (const auto &thread : r.m_threads) {
+      const auto &stats = thread.m_stats;
+
+      entries.push_back(std::format(
+        "    {{\"name\": \"{}/thread:{}\", \"iterations\": 1, \"real_time\": {:.3f}, \"time_unit\": \"ms\", "
+        "\"rows\": {}, \"skipped\": {}, \"ranges\": {}, \"pages\": {}, \"scan_ms\": {:.3f}, \"dequeue_ms\": {:.3f}, "
+        "\"idle_ms\": {:.3f}}}",
+        name, thread.m_thread_id, double(r.m_elapsed.count()) / 1000.0, stats.n_rows, stats.n_skipped, stats.n_ranges,
+        stats.n_pages, double(stats.scan_ns) / 1e6, double(stats.dequeue_ns) / 1e6, double(stats.idle_ns) / 1e6));
+    }
+  }
+
+  for (size_t i{}; i < entries.size(); ++i) {
+    os << entries[i] << (i + 1 < entries.size() ? ",\n" : "\n");
+  }
+
+  os << "  ]\n}\n";
+
+  return os.str();
+}
+
+}  // namespace bench
+
+int main(int argc, char **argv) {
+  bench::Options opts;
+  bool valid{true};
+
+  for (int i{1}; i < argc && valid; ++i) {
+    const std::string arg{argv[i]};
+    const auto value = [&](const char *name) { return strtoul(arg.c_str() + strlen(name), nullptr, 10); };
+
+    if (arg.starts_with("--rows=")) {
+      opts.m_rows = uint32_t(value("--rows="));
+    } else if (arg.starts_with("--row_len=")) {
+      opts.m_row_len = uint32_t(value("--row_len="));
+    } else if (arg.starts_with("--buffer_pool_mb=")) {
+      opts.m_buffer_pool_mb = value("--buffer_pool_mb=");
+    } else if (arg.starts_with("--resident_pct=")) {
+      opts.m_resident_pct = uint32_t(value("--resident_pct="));
+    } else if (arg.starts_with("--filter_pct=")) {
+      opts.m_filter_pct = uint32_t(value("--filter_pct="));
+    } else if (arg.starts_with("--threads=")) {
+      std::istringstream is(arg.substr(strlen("--threads=")));
+      std::string n;
+
+      opts.m_threads.clear();
+
+      while (std::getline(is, n, ',')) {
+        opts.m_threads.push_back(strtoul(n.c_str(), nullptr, 10));
+      }
+    } else if (arg.starts_with("--out=")) {
+      opts.m_out = arg.substr(strlen("--out="));
+    } else {
+      valid = false;
+    }
+  }
+
+  if (!valid || opts.m_rows == 0 || opts.m_row_len == 0 || opts.m_resident_pct > 100 || opts.m_filter_pct > 100 ||
+      opts.m_threads.empty() || std::find(opts.m_threads.begin(), opts.m_threads.end(), 0) != opts.m_threads.end()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--rows=<n>] [--row_len=<bytes>] [--buffer_pool_mb=<n>] [--resident_pct=<0..100>]"
+                 " [--filter_pct=<0..100>] [--threads=<n>[,<n>...]] [--out=<file>]\n";
+    return EXIT_FAILURE;
+  }
+
+  bench::startup(opts);
+
+  (void) ib_database_create(DATABASE);
+
+  bench::load(opts);
+
+  /* The rows that pass c2 < --filter_pct, c2 is c1 % 100. */
+  uint64_t expected_rows{};
+  uint64_t expected_sum{};
+
+  for (uint32_t c1{}; c1 < opts.m_rows; ++c1) {
+    if (c1 % 100 < opts.m_filter_pct) {
+      ++expected_rows;
+      expected_sum += c1;
+    }
+  }
+
+  std::vector<bench::Result> results;
+  bool ok{true};
+
+  for (auto n_threads : opts.m_threads) {
+    auto result = bench::run(opts, n_threads);
+
+    bench::print(result);
+
+    if (result.m_n_rows != expected_rows || result.m_sum != expected_sum) {
+      std::cerr << std::format("Scanned {} rows with sum {}, expected {} rows with sum {}\n", result.m_n_rows, result.m_sum,
+                               expected_rows, expected_sum);
+      ok = false;
+    }
+
+    results.push_back(std::move(result));
+  }
+
+  auto err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  const auto json = bench::to_json(opts, results);
+
+  if (opts.m_out.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream os(opts.m_out, std::ios::out | std::ios::trunc);
+
+    os << json;
+
+    if (!os) {
+      std::cerr << "Cannot write " << opts.m_out << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
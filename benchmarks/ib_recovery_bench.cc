@@ -0,0 +1,718 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Crash recovery benchmark.
+
+ ib_recovery_bench [--redo_mb=<n>] [--pages=<n>] [--batch=<rows>]
+                   [--kill_at=commit|active] [--apply_threads=<n>]
+                   [--max_time=<seconds>] [--out=<file>]
+
+ Run it in an empty directory. The program runs in three phases, it
+ re-executes itself with --phase=<phase> for the next one:
+
+ load     Creates bench/t(c1 INT UNSIGNED PRIMARY KEY, c2 INT UNSIGNED,
+          c3 VARCHAR(800)) with about 16 rows per page on --pages leaf
+          pages and shuts down normally, so that the load leaves no log to
+          recover.
+
+ run      Forks a child that updates random rows in transactions of
+          --batch rows until the checkpoint age reaches --redo_mb, the
+          updates are spread over all the pages. The buffer pool holds all the pages and the background
+          flushing is throttled so that the pages stay dirty. With
+          --kill_at=active a transaction that updated --batch rows is left
+          uncommitted. The versions of the committed rows are written to
+          ib_recovery_bench.expected and the child kills itself with
+          SIGKILL, the parent waits for that.
+
+ recover  Times the startup and the recovery phases, waits for the rollback
+          of the recovered transactions, then checks every row against the
+          expected versions and drops the table.
+
+ The recovery figures are printed and written as JSON in the layout of the
+ Google Benchmark output, like ib_bench does, with the throughput of each
+ phase in bytes_per_second and items_per_second. */
+
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../tests/test0aux.h"
+
+#define DATABASE "bench"
+#define TABLE "t"
+
+namespace bench {
+
+/** Approximate number of rows that fit in a leaf page. */
+constexpr uint32_t ROWS_PER_PAGE = 16;
+
+/** Length of the c3 column. */
+constexpr size_t C3_LEN = 800;
+
+/** Versions of the committed rows, written by the run phase. */
+constexpr const char *EXPECTED_FILE = "ib_recovery_bench.expected";
+
+/** Options, the same ones in every phase. */
+struct Options {
+  /** The phase to run. */
+  std::string m_phase{"load"};
+
+  /** Log to generate in MiB. */
+  uint64_t m_redo_mb{256};
+
+  /** Leaf pages the updates are spread over. */
+  uint32_t m_pages{4096};
+
+  /** Rows updated by a transaction. */
+  uint32_t m_batch{100};
+
+  /** "commit" or "active". */
+  std::string m_kill_at{"commit"};
+
+  /** Recovery apply threads, 0 for the default. */
+  ulint m_apply_threads{};
+
+  /** The run phase stops after this long even if the checkpoint age is not
+  reached, the background flushing may be keeping up. */
+  std::chrono::seconds m_max_time{600};
+
+  /** File for the JSON results, stdout if empty. */
+  std::string m_out{};
+
+  /** @return the number of rows in the table. */
+  uint32_t n_rows() const noexcept { return m_pages * ROWS_PER_PAGE; }
+};
+
+/** @return the c3 value of a row version, so that recovery can be checked. */
+static std::string payload(uint32_t c1, uint32_t c2) {
+  const auto s = std::format("{:010}:{:010};", c1, c2);
+  std::string c3;
+
+  while (c3.size() + s.size() <= C3_LEN) {
+    c3 += s;
+  }
+
+  return c3;
+}
+
+/** @return the value of a status variable. */
+static int64_t status(const char *name) {
+  int64_t v{};
+
+  auto err = ib_status_get_i64(name, &v);
+  assert(err == DB_SUCCESS);
+
+  return v;
+}
+
+/** Set the configuration, the same in every phase. */
+static void configure(const Options &opts) {
+  test_configure();
+
+  const uint64_t page_size = 16 * 1024;
+  const auto redo_bytes = opts.m_redo_mb * 1024 * 1024;
+
+  /* Two log files of at least the log to generate each, the async flush
+  starts well after that. */
+  auto err = ib_cfg_set_int("log_file_size", std::max(redo_bytes, uint64_t(32 * 1024 * 1024)));
+  assert(err == DB_SUCCESS);
+
+  /* Room for all the pages and the undo, they must stay dirty. */
+  err = ib_cfg_set_int("buffer_pool_size", std::max(uint64_t(opts.m_pages) * page_size * 2, uint64_t(64 * 1024 * 1024)));
+  assert(err == DB_SUCCESS);
+
+  err = ib_cfg_set_int("max_dirty_pages_pct", 95);
+  assert(err == DB_SUCCESS);
+
+  err = ib_cfg_set_bool_off("adaptive_flushing");
+  assert(err == DB_SUCCESS);
+
+  err = ib_cfg_set_int("io_capacity", 100);
+  assert(err == DB_SUCCESS);
+
+  if (opts.m_apply_threads > 0) {
+    err = ib_cfg_set_int("recovery_apply_threads", opts.m_apply_threads);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** Re-execute the program for the next phase. */
+[[noreturn]] static void next_phase(int argc, char **argv, const char *phase) {
+  std::vector<char *> args;
+  auto arg = std::format("--phase={}", phase);
+
+  for (int i{}; i < argc; ++i) {
+    if (strncmp(argv[i], "--phase=", strlen("--phase=")) != 0) {
+      args.push_back(argv[i]);
+    }
+  }
+
+  args.push_back(arg.data());
+  args.push_back(nullptr);
+
+  execvp(argv[0], args.data());
+  perror("execvp");
+  abort();
+}
+
+/** Create the table and insert the rows. */
+static void load(const Options &opts) {
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+  ib_id_t table_id{};
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  auto err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  (void) ib_table_drop(ib_trx, DATABASE "/" TABLE);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c3", IB_VARCHAR, IB_COL_NONE, 0, C3_LEN);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  ib_crsr_t crsr{};
+
+  err = ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &crsr);
+  assert(err == DB_SUCCESS);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (uint32_t c1{}; c1 < opts.n_rows(); c1 += 1000) {
+    ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    assert(ib_trx != nullptr);
+
+    ib_cursor_attach_trx(crsr, ib_trx);
+
+    err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    for (auto i = c1; i < std::min(c1 + 1000, opts.n_rows()); ++i) {
+      const auto c3 = payload(i, 0);
+
+      err = ib_tuple_write_u32(tpl, 0, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_tuple_write_u32(tpl, 1, 0);
+      assert(err == DB_SUCCESS);
+
+      err = ib_col_set_value(tpl, 2, c3.data(), c3.size());
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    err = ib_cursor_reset(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+
+  ib_tuple_delete(tpl);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+}
+
+/** Updates rows through a cursor. */
+struct Updater {
+  Updater() {
+    auto err = ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &m_crsr);
+    assert(err == DB_SUCCESS);
+
+    m_key_tpl = ib_clust_search_tuple_create(m_crsr);
+    assert(m_key_tpl != nullptr);
+
+    m_old_tpl = ib_clust_read_tuple_create(m_crsr);
+    assert(m_old_tpl != nullptr);
+
+    m_new_tpl = ib_clust_read_tuple_create(m_crsr);
+    assert(m_new_tpl != nullptr);
+  }
+
+  ~Updater() {
+    ib_tuple_delete(m_key_tpl);
+    ib_tuple_delete(m_old_tpl);
+    ib_tuple_delete(m_new_tpl);
+
+    auto err = ib_cursor_close(m_crsr);
+    assert(err == DB_SUCCESS);
+  }
+
+  /** Begin a transaction. */
+  ib_trx_t begin() {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    assert(ib_trx != nullptr);
+
+    ib_cursor_attach_trx(m_crsr, ib_trx);
+
+    auto err = ib_cursor_set_lock_mode(m_crsr, IB_LOCK_X);
+    assert(err == DB_SUCCESS);
+
+    return ib_trx;
+  }
+
+  /** Detach the cursor and commit. */
+  void commit(ib_trx_t ib_trx) {
+    auto err = ib_cursor_reset(m_crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+
+  /** Bump the version of a row and rewrite c3.
+  @param[in] c1                 Row to update
+  @return the new version */
+  uint32_t update(uint32_t c1) {
+    int res = ~0;
+
+    auto err = ib_tuple_write_u32(m_key_tpl, 0, c1);
+    assert(err == DB_SUCCESS);
+
+    ib_cursor_set_match_mode(m_crsr, IB_EXACT_MATCH);
+
+    err = ib_cursor_moveto(m_crsr, m_key_tpl, IB_CUR_GE, &res);
+    assert(err == DB_SUCCESS && res == 0);
+
+    m_old_tpl = ib_tuple_clear(m_old_tpl);
+    assert(m_old_tpl != nullptr);
+
+    err = ib_cursor_read_row(m_crsr, m_old_tpl);
+    assert(err == DB_SUCCESS);
+
+    uint32_t c2{};
+
+    err = ib_tuple_read_u32(m_old_tpl, 1, &c2);
+    assert(err == DB_SUCCESS);
+
+    ++c2;
+
+    m_new_tpl = ib_tuple_clear(m_new_tpl);
+    assert(m_new_tpl != nullptr);
+
+    err = ib_tuple_copy(m_new_tpl, m_old_tpl);
+    assert(err == DB_SUCCESS);
+
+    err = ib_tuple_write_u32(m_new_tpl, 1, c2);
+    assert(err == DB_SUCCESS);
+
+    const auto c3 = payload(c1, c2);
+
+    err = ib_col_set_value(m_new_tpl, 2, c3.data(), c3.size());
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_update_row(m_crsr, m_old_tpl, m_new_tpl);
+    assert(err == DB_SUCCESS);
+
+    return c2;
+  }
+
+  ib_crsr_t m_crsr{};
+  ib_tpl_t m_key_tpl{};
+  ib_tpl_t m_old_tpl{};
+  ib_tpl_t m_new_tpl{};
+};
+
+/** Generate the log and kill the process. */
+[[noreturn]] static void run(const Options &opts) {
+  const auto redo_bytes = int64_t(opts.m_redo_mb * 1024 * 1024);
+  const auto max_age = status("log_checkpoint_age_async");
+  std::vector<uint32_t> versions(opts.n_rows());
+  std::mt19937 rng(opts.m_pages);
+  Updater updater;
+
+  if (redo_bytes > max_age) {
+    std::cerr << std::format("--redo_mb={} is more than the async checkpoint age of {} bytes, a checkpoint will cut it short\n",
+                             opts.m_redo_mb, max_age);
+  }
+
+  /* The rows of the transaction left active are not updated by the others
+  so that they don't wait for its locks. */
+  const uint32_t first_row = opts.m_kill_at == "active" ? opts.m_batch : 0;
+  std::uniform_int_distribution<uint32_t> dist(first_row, opts.n_rows() - 1);
+
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t n_trxs{};
+
+  while (status("log_checkpoint_age") < redo_bytes) {
+    if (std::chrono::steady_clock::now() - start > opts.m_max_time) {
+      std::cerr << std::format("The checkpoint age is {} bytes after {} s, the background flush keeps up\n",
+                               status("log_checkpoint_age"), opts.m_max_time.count());
+      break;
+    }
+
+    auto ib_trx = updater.begin();
+
+    for (uint32_t i{}; i < opts.m_batch; ++i) {
+      const auto c1 = dist(rng);
+
+      versions[c1] = updater.update(c1);
+    }
+
+    updater.commit(ib_trx);
+
+    ++n_trxs;
+  }
+
+  if (opts.m_kill_at == "active") {
+    auto ib_trx = updater.begin();
+
+    for (uint32_t c1{}; c1 < opts.m_batch; ++c1) {
+      (void) updater.update(c1);
+    }
+
+    auto err = ib_cursor_reset(updater.m_crsr);
+    assert(err == DB_SUCCESS);
+
+    /* Commit another transaction to flush the log of the active one. */
+    auto ib_trx2 = updater.begin();
+
+    versions[opts.n_rows() - 1] = updater.update(opts.n_rows() - 1);
+
+    updater.commit(ib_trx2);
+
+    (void) ib_trx;
+  }
+
+  {
+    std::ofstream os(EXPECTED_FILE, std::ios::out | std::ios::trunc | std::ios::binary);
+
+    os.write(reinterpret_cast<const char *>(versions.data()), versions.size() * sizeof(versions[0]));
+    os.flush();
+
+    if (!os) {
+      std::cerr << "Cannot write " << EXPECTED_FILE << "\n";
+      abort();
+    }
+  }
+
+  std::cerr << std::format("Generated {} bytes of log in {} transactions, killing the process\n", status("log_checkpoint_age"), n_trxs);
+
+  sync();
+
+  kill(getpid(), SIGKILL);
+
+  abort();
+}
+
+/** Check the rows against the expected versions.
+@return true if all the rows are as expected */
+static bool validate(const Options &opts) {
+  std::vector<uint32_t> versions(opts.n_rows());
+
+  {
+    std::ifstream is(EXPECTED_FILE, std::ios::in | std::ios::binary);
+
+    is.read(reinterpret_cast<char *>(versions.data()), versions.size() * sizeof(versions[0]));
+
+    if (!is) {
+      std::cerr << "Cannot read " << EXPECTED_FILE << "\n";
+      return false;
+    }
+  }
+
+  ib_crsr_t crsr{};
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  assert(ib_trx != nullptr);
+
+  auto err = ib_cursor_open_table(DATABASE "/" TABLE, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  uint32_t n_rows{};
+  uint32_t n_bad{};
+
+  err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    uint32_t c1{};
+    uint32_t c2{};
+
+    err = ib_cursor_read_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    err = ib_tuple_read_u32(tpl, 0, &c1);
+    assert(err == DB_SUCCESS);
+
+    err = ib_tuple_read_u32(tpl, 1, &c2);
+    assert(err == DB_SUCCESS);
+
+    const auto c3 = payload(c1, c2);
+    const auto len = ib_col_get_len(tpl, 2);
+
+    if (c1 != n_rows || c2 != versions[c1] || len != c3.size() || memcmp(ib_col_get_value(tpl, 2), c3.data(), len) != 0) {
+      if (n_bad++ < 10) {
+        std::cerr << std::format("Row {}: found c1 {} version {}, expected version {}\n", n_rows, c1, c2, versions[n_rows]);
+      }
+    }
+
+    ++n_rows;
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+
+  ib_tuple_delete(tpl);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  if (n_rows != opts.n_rows()) {
+    std::cerr << std::format("Found {} rows, expected {}\n", n_rows, opts.n_rows());
+    return false;
+  }
+
+  return n_bad == 0;
+}
+
+/** A timed recovery phase. */
+struct Phase {
+  const char *m_name;
+  int64_t m_time_ms;
+  int64_t m_n_bytes;
+  int64_t m_n_items;
+};
+
+/** @return the phases in JSON, in the Google Benchmark layout. */
+static std::string to_json(const Options &opts, const std::vector<Phase> &phases) {
+  std::ostringstream os;
+  char date[64];
+  const auto now = std::time(nullptr);
+
+  (void) std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+  os << "{\n  \"context\": {\n";
+  os << std::format("    \"date\": \"{}\",\n", date);
+  os << std::format("    \"num_cpus\": {},\n", std::thread::hardware_concurrency());
+  os << std::format("    \"redo_mb\": {},\n", opts.m_redo_mb);
+  os << std::format("    \"pages\": {},\n", opts.m_pages);
+  os << std::format("    \"kill_at\": \"{}\",\n", opts.m_kill_at);
+  os << std::format("    \"apply_threads\": {}\n", opts.m_apply_threads);
+  os << "  },\n  \"benchmarks\": [\n";
+
+  for (size_t i{}; i < phases.size(); ++i) {
+    const auto &phase = phases[i];
+    const auto secs = std::max(double(phase.m_time_ms) / 1000.0, 0.001);
+
+    os << std::format(
+      "    {{\"name\": \"recovery/{}\", \"iterations\": 1, \"real_time\": {}, \"time_unit\": \"ms\", "
+      "\"bytes_per_second\": {:.0f}, \"items_per_second\": {:.0f}}}{}\n",
+      phase.m_name, phase.m_time_ms, double(phase.m_n_bytes) / secs, double(phase.m_n_items) / secs,
+      i + 1 < phases.size() ? "," : "");
+  }
+
+  os << "  ]\n}\n";
+
+  return os.str();
+}
+
+}  // namespace bench
+
+int main(int argc, char **argv) {
+  bench::Options opts;
+
+  for (int i{1}; i < argc; ++i) {
+    const std::string arg{argv[i]};
+
+    if (arg.starts_with("--phase=")) {
+      opts.m_phase = arg.substr(strlen("--phase="));
+    } else if (arg.starts_with("--redo_mb=")) {
+      opts.m_redo_mb = strtoull(arg.c_str() + strlen("--redo_mb="), nullptr, 10);
+    } else if (arg.starts_with("--pages=")) {
+      opts.m_pages = strtoul(arg.c_str() + strlen("--pages="), nullptr, 10);
+    } else if (arg.starts_with("--batch=")) {
+      opts.m_batch = strtoul(arg.c_str() + strlen("--batch="), nullptr, 10);
+    } else if (arg.starts_with("--kill_at=")) {
+      opts.m_kill_at = arg.substr(strlen("--kill_at="));
+    } else if (arg.starts_with("--apply_threads=")) {
+      opts.m_apply_threads = strtoul(arg.c_str() + strlen("--apply_threads="), nullptr, 10);
+    } else if (arg.starts_with("--max_time=")) {
+      opts.m_max_time = std::chrono::seconds(strtoul(arg.c_str() + strlen("--max_time="), nullptr, 10));
+    } else if (arg.starts_with("--out=")) {
+      opts.m_out = arg.substr(strlen("--out="));
+    } else {
+      opts.m_phase.clear();
+      break;
+    }
+  }
+
+  if ((opts.m_phase != "load" && opts.m_phase != "run" && opts.m_phase != "recover") || opts.m_redo_mb == 0 ||
+      opts.m_batch == 0 || opts.n_rows() <= opts.m_batch || (opts.m_kill_at != "commit" && opts.m_kill_at != "active")) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--redo_mb=<n>] [--pages=<n>] [--batch=<rows>] [--kill_at=commit|active]"
+                 " [--apply_threads=<n>] [--max_time=<seconds>] [--out=<file>]\n";
+    return EXIT_FAILURE;
+  }
+
+  if (opts.m_phase == "run") {
+    /* The child generates the log and is killed, this process waits for it
+    and recovers. */
+    const auto pid = fork();
+
+    if (pid == -1) {
+      perror("fork");
+      return EXIT_FAILURE;
+    } else if (pid > 0) {
+      int wstatus{};
+
+      if (waitpid(pid, &wstatus, 0) != pid || !WIFSIGNALED(wstatus) || WTERMSIG(wstatus) != SIGKILL) {
+        std::cerr << "The run phase did not end with SIGKILL\n";
+        return EXIT_FAILURE;
+      }
+
+      bench::next_phase(argc, argv, "recover");
+    }
+  }
+
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  bench::configure(opts);
+
+  if (opts.m_phase == "load") {
+    err = ib_startup("default");
+    assert(err == DB_SUCCESS);
+
+    (void) ib_database_create(DATABASE);
+
+    bench::load(opts);
+
+    err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+    assert(err == DB_SUCCESS);
+
+    bench::next_phase(argc, argv, "run");
+
+  } else if (opts.m_phase == "run") {
+    err = ib_startup("default");
+    assert(err == DB_SUCCESS);
+
+    bench::run(opts);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  const auto startup_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+  while (bench::status("recovery_rollback_trxs_left") > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  const auto page_size = int64_t(16 * 1024);
+  const auto pages_read = bench::status("recovery_pages_read");
+
+  const std::vector<bench::Phase> phases{
+    {"startup", startup_ms, 0, 0},
+    {"dblwr", bench::status("recovery_dblwr_time_ms"), bench::status("recovery_dblwr_pages_restored") * page_size,
+     bench::status("recovery_dblwr_pages_restored")},
+    {"scan", bench::status("recovery_scan_time_ms"), bench::status("recovery_scan_bytes"), pages_read},
+    {"parse", bench::status("recovery_parse_time_ms"), bench::status("recovery_parse_bytes"), bench::status("recovery_parse_records")},
+    {"apply", bench::status("recovery_apply_time_ms"), bench::status("recovery_apply_pages") * page_size,
+     bench::status("recovery_apply_pages")},
+    {"rollback", bench::status("recovery_rollback_time_ms"), 0, bench::status("recovery_rollback_undo_recs")},
+  };
+
+  for (const auto &phase : phases) {
+    const auto secs = std::max(double(phase.m_time_ms) / 1000.0, 0.001);
+
+    std::cerr << std::format("{:<10} {:>8} ms {:>10.1f} MiB/s {:>12.0f} items/s\n", phase.m_name, phase.m_time_ms,
+                             double(phase.m_n_bytes) / secs / (1024.0 * 1024.0), double(phase.m_n_items) / secs);
+  }
+
+  const auto valid = bench::validate(opts);
+
+  std::cerr << (valid ? "Validation OK\n" : "Validation FAILED\n");
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  (void) unlink(bench::EXPECTED_FILE);
+
+  const auto json = bench::to_json(opts, phases);
+
+  if (opts.m_out.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream os(opts.m_out, std::ios::out | std::ios::trunc);
+
+    os << json;
+
+    if (!os) {
+      std::cerr << "Cannot write " << opts.m_out << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -19,11 +19,25 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #include "btr0btr.h"
 #include "btr0blob.h"
 #include "buf0lru.h"
+#include "buf0rea.h"
+#include "fsp0types.h"
 #include "mtr0mtr.h"
 #include "mtr0log.h"
 #include "row0types.h"
 #include "row0upd.h"
 
+#include <array>
+
+/** Maximum length of the part of a BLOB on one page. */
+constexpr ulint BLOB_PART_MAX_LEN = UNIV_PAGE_SIZE - FIL_PAGE_DATA - BTR_BLOB_HDR_SIZE - FIL_PAGE_DATA_END;
+
+/** Number of BLOB pages written in one mini-transaction, the redo of a
+batch must stay well below the smallest log buffer. */
+constexpr ulint BLOB_PAGES_PER_MTR = 4;
+
+/** BLOBs of at least this many pages are stored in whole extents. */
+constexpr ulint BLOB_EXTENT_MIN_PAGES = FSP_EXTENT_SIZE / 2;
+
 const byte field_ref_zero[BTR_EXTERN_FIELD_REF_SIZE] = {};
 
 ulint Blob::get_externally_stored_len(rec_t *rec, const ulint *offsets) noexcept {
@@ -224,18 +238,20 @@ void Blob::blob_free(Buf_block *block, mtr_t *mtr) noexcept {
 
   mtr->commit();
 
-  mutex_enter(&m_fsp->m_buf_pool->m_mutex);
+  auto buf_pool = m_fsp->m_buf_pool->get_instance(&block->m_page);
+
+  mutex_enter(&buf_pool->m_mutex);
   mutex_enter(&block->m_mutex);
 
   /* Only free the block if it is still allocated to the same file page. */
 
   if (block->get_state() == BUF_BLOCK_FILE_PAGE && block->get_space() == space && block->get_page_no() == page_no) {
 
-    auto block_status = m_fsp->m_buf_pool->m_LRU->free_block(&block->m_page, nullptr);
+    auto block_status = buf_pool->m_LRU->free_block(&block->m_page, nullptr);
     ut_a(block_status == Buf_LRU::Block_status::FREED);
   }
 
-  mutex_exit(&m_fsp->m_buf_pool->m_mutex);
+  mutex_exit(&buf_pool->m_mutex);
   mutex_exit(&block->m_mutex);
 }
 
@@ -249,7 +265,9 @@ db_err Blob::store_big_rec_extern_fields(
 ) noexcept {
 
   ut_ad(rec_offs_validate(rec, index, offsets));
-  ut_ad(local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(
+    local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || local_mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK)
+  );
   ut_ad(local_mtr->memo_contains(rec_block, MTR_MEMO_PAGE_X_FIX));
   ut_ad(rec_block->get_frame() == page_align(rec));
   ut_a(index->is_clustered());
@@ -285,41 +303,83 @@ db_err Blob::store_big_rec_extern_fields(
 
     ut_a(extern_len > 0);
 
+    const auto data = static_cast<const byte *>(big_rec_vec->fields[i].data) + big_rec_vec->fields[i].len;
+
+    /* A big BLOB is given whole extents, see the FSP_UP case of
+    fseg_alloc_free_page_low(): its pages are then contiguous and in the
+    order of the chain, instead of fragment pages around the record. */
+    const byte direction = extern_len >= BLOB_EXTENT_MIN_PAGES * BLOB_PART_MAX_LEN ? FSP_UP : FSP_NO_DIR;
+
     page_no_t prev_page_no = FIL_NULL;
 
-    for (;;) {
+    while (extern_len > 0) {
       mtr_t mtr;
-      page_no_t hint_page_no;
+      ulint n_blocks{};
+      std::array<Buf_block *, BLOB_PAGES_PER_MTR> blocks;
+      const auto n_pages = ut_min(BLOB_PAGES_PER_MTR, (extern_len + BLOB_PART_MAX_LEN - 1) / BLOB_PART_MAX_LEN);
 
       mtr.start();
 
-      if (prev_page_no == FIL_NULL) {
-        hint_page_no = 1 + rec_page_no;
-      } else {
-        hint_page_no = prev_page_no + 1;
-      }
+      /* Allocate the pages of the batch first, each page is then written
+      with the number of its successor in a single log record. */
+      while (n_blocks < n_pages) {
+        page_no_t hint_page_no;
+
+        if (n_blocks > 0) {
+          hint_page_no = blocks[n_blocks - 1]->get_page_no() + 1;
+        } else if (prev_page_no != FIL_NULL) {
+          hint_page_no = prev_page_no + 1;
+        } else {
+          hint_page_no = rec_page_no + 1;
+        }
 
-      auto block = m_btree->page_alloc(index, hint_page_no, FSP_NO_DIR, 0, &mtr);
+        auto block = m_btree->page_alloc(index, hint_page_no, direction, 0, &mtr);
+
+        if (unlikely(block == nullptr)) {
+          break;
+        }
 
-      if (unlikely(block == nullptr)) {
+        buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_EXTERN_STORAGE));
+
+        blocks[n_blocks++] = block;
+      }
+
+      if (unlikely(n_blocks == 0)) {
 
         mtr.commit();
 
         return DB_OUT_OF_FILE_SPACE;
       }
 
-      auto page_no = block->get_page_no();
-      auto page = block->get_frame();
+      for (ulint j{}; j < n_blocks; ++j) {
+        const auto page = blocks[j]->get_frame();
+        const auto blob_header = page + FIL_PAGE_DATA;
+        const auto store_len = ut_min(extern_len, BLOB_PART_MAX_LEN);
+        const auto next_page_no = j + 1 < n_blocks ? blocks[j + 1]->get_page_no() : FIL_NULL;
+
+        /* The page type must be logged before the string, recovery only
+        applies a string write to a page that is not an index page. */
+        mlog_write_ulint(page + FIL_PAGE_TYPE, FIL_PAGE_TYPE_BLOB, MLOG_2BYTES, &mtr);
+
+        mach_write_to_4(blob_header + BTR_BLOB_HDR_PART_LEN, store_len);
+        mach_write_to_4(blob_header + BTR_BLOB_HDR_NEXT_PAGE_NO, next_page_no);
+
+        memcpy(blob_header + BTR_BLOB_HDR_SIZE, data - extern_len, store_len);
+
+        mlog_log_string(blob_header, BTR_BLOB_HDR_SIZE + store_len, &mtr);
+
+        extern_len -= store_len;
+      }
 
       if (prev_page_no != FIL_NULL) {
 
         Buf_pool::Request req {
           .m_rw_latch = RW_X_LATCH,
           .m_page_id = { space_id, prev_page_no },
-	        .m_mode = BUF_GET,
-	        .m_file = __FILE__,
-	        .m_line = __LINE__,
-	        .m_mtr = &mtr
+          .m_mode = BUF_GET,
+          .m_file = __FILE__,
+          .m_line = __LINE__,
+          .m_mtr = &mtr
         };
 
         auto prev_block = m_fsp->m_buf_pool->get(req, nullptr);
@@ -328,32 +388,9 @@ db_err Blob::store_big_rec_extern_fields(
 
         auto prev_page = prev_block->get_frame();
 
-        mlog_write_ulint(prev_page + FIL_PAGE_DATA + BTR_BLOB_HDR_NEXT_PAGE_NO, page_no, MLOG_4BYTES, &mtr);
-      }
-
-      mlog_write_ulint(page + FIL_PAGE_TYPE, FIL_PAGE_TYPE_BLOB, MLOG_2BYTES, &mtr);
-
-      ulint store_len;
-
-      if (extern_len > (UNIV_PAGE_SIZE - FIL_PAGE_DATA - BTR_BLOB_HDR_SIZE - FIL_PAGE_DATA_END)) {
-        store_len = UNIV_PAGE_SIZE - FIL_PAGE_DATA - BTR_BLOB_HDR_SIZE - FIL_PAGE_DATA_END;
-      } else {
-        store_len = extern_len;
+        mlog_write_ulint(prev_page + FIL_PAGE_DATA + BTR_BLOB_HDR_NEXT_PAGE_NO, blocks[0]->get_page_no(), MLOG_4BYTES, &mtr);
       }
 
-      mlog_write_string(
-        page + FIL_PAGE_DATA + BTR_BLOB_HDR_SIZE,
-        (const byte *)big_rec_vec->fields[i].data + big_rec_vec->fields[i].len - extern_len,
-        store_len,
-        &mtr
-      );
-
-      mlog_write_ulint(page + FIL_PAGE_DATA + BTR_BLOB_HDR_PART_LEN, store_len, MLOG_4BYTES, &mtr);
-
-      mlog_write_ulint(page + FIL_PAGE_DATA + BTR_BLOB_HDR_NEXT_PAGE_NO, FIL_NULL, MLOG_4BYTES, &mtr);
-
-      extern_len -= store_len;
-
       Buf_pool::Request req {
         .m_rw_latch = RW_X_LATCH,
         .m_page_id = { space_id, rec_page_no },
@@ -374,17 +411,18 @@ db_err Blob::store_big_rec_extern_fields(
       if (prev_page_no == FIL_NULL) {
         mlog_write_ulint(field_ref + BTR_EXTERN_SPACE_ID, space_id, MLOG_4BYTES, &mtr);
 
-        mlog_write_ulint(field_ref + BTR_EXTERN_PAGE_NO, page_no, MLOG_4BYTES, &mtr);
+        mlog_write_ulint(field_ref + BTR_EXTERN_PAGE_NO, blocks[0]->get_page_no(), MLOG_4BYTES, &mtr);
 
         mlog_write_ulint(field_ref + BTR_EXTERN_OFFSET, FIL_PAGE_DATA, MLOG_4BYTES, &mtr);
       }
 
-      prev_page_no = page_no;
+      prev_page_no = blocks[n_blocks - 1]->get_page_no();
 
       mtr.commit();
 
-      if (extern_len == 0) {
-        break;
+      if (unlikely(n_blocks < n_pages)) {
+        /* The pages written so far are in the chain, rollback frees them. */
+        return DB_OUT_OF_FILE_SPACE;
       }
     }
   }
@@ -431,7 +469,9 @@ void Blob::free_externally_stored_field(
 ) noexcept {
 
 #ifdef UNIV_DEBUG
-  ut_ad(local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
+  ut_ad(
+    local_mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK) || local_mtr->memo_contains(index->get_lock(), MTR_MEMO_SX_LOCK)
+  );
   ut_ad(local_mtr->memo_contains_page(field_ref, MTR_MEMO_PAGE_X_FIX));
   ut_ad(!rec || rec_offs_validate(rec, index, offsets));
 
@@ -712,4 +752,130 @@ byte *Blob::copy_externally_stored_field(const rec_t *rec, const ulint *offsets,
   auto data = static_cast<const byte *>(rec_get_nth_field(rec, offsets, no, &local_len));
 
   return copy_externally_stored_field(len, data, local_len, heap);
-}
\ No newline at end of file
+}
+
+Blob_reader::Blob_reader(FSP *fsp, Btree *btree, const byte *data, ulint len, bool is_extern) noexcept
+  : m_blob(fsp, btree), m_local(data), m_local_len(len) {
+
+  if (!is_extern) {
+    return;
+  }
+
+  ut_a(len >= BTR_EXTERN_FIELD_REF_SIZE);
+
+  m_local_len -= BTR_EXTERN_FIELD_REF_SIZE;
+
+  const auto field_ref = data + m_local_len;
+
+  m_space_id = mach_read_from_4(field_ref + BTR_EXTERN_SPACE_ID);
+  m_first_page_no = mach_read_from_4(field_ref + BTR_EXTERN_PAGE_NO);
+  m_first_offset = mach_read_from_4(field_ref + BTR_EXTERN_OFFSET);
+
+  /* The length is 0 if the BLOB is being or has been deleted, only the
+  local part can be read then, as in copy_externally_stored_field(). */
+  m_extern_len = mach_read_from_4(field_ref + BTR_EXTERN_LEN + 4);
+}
+
+void Blob_reader::read_ahead(page_no_t page_no) noexcept {
+  if (page_no == FIL_NULL || (page_no >= m_ra_low && page_no < m_ra_high)) {
+    return;
+  }
+
+  /* Don't read beyond the pages that the rest of the BLOB needs. */
+  const auto n_pages = ut_min(N_READ_AHEAD_PAGES, ulint((m_extern_len - m_page_start + BLOB_PART_MAX_LEN - 1) / BLOB_PART_MAX_LEN));
+
+  std::array<page_no_t, N_READ_AHEAD_PAGES> page_nos;
+
+  for (ulint i{}; i < n_pages; ++i) {
+    page_nos[i] = page_no + i;
+  }
+
+  m_ra_low = page_no;
+  m_ra_high = page_no + n_pages;
+
+  buf_read_ahead_pages(m_space_id, page_nos.data(), n_pages);
+}
+
+ulint Blob_reader::read(uint64_t offset, byte *buf, ulint len) noexcept {
+  if (offset >= get_len()) {
+    return 0;
+  }
+
+  len = ulint(ut_min(uint64_t(len), get_len() - offset));
+
+  ulint n_read{};
+
+  if (offset < m_local_len) {
+    n_read = ut_min(len, ulint(m_local_len - offset));
+
+    memcpy(buf, m_local + offset, n_read);
+  }
+
+  if (n_read == len) {
+    return n_read;
+  }
+
+  auto extern_offset = offset + n_read - m_local_len;
+
+  if (m_page_no == FIL_NULL || extern_offset < m_page_start) {
+    /* Reading backwards, walk the chain again from the start. */
+    m_page_no = m_first_page_no;
+    m_page_offset = m_first_offset;
+    m_page_start = 0;
+
+    read_ahead(m_page_no);
+  }
+
+  while (n_read < len && m_page_no != FIL_NULL) {
+    mtr_t mtr;
+
+    mtr.start();
+
+    Buf_pool::Request req {
+      .m_rw_latch = RW_S_LATCH,
+      .m_page_id = { m_space_id, m_page_no },
+      .m_mode = BUF_GET,
+      .m_file = __FILE__,
+      .m_line = __LINE__,
+      .m_mtr = &mtr
+    };
+
+    auto block = m_blob.m_fsp->m_buf_pool->get(req, nullptr);
+    const auto page = block->get_frame();
+
+    buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_EXTERN_STORAGE));
+
+    m_blob.check_blob_fil_page_type(m_space_id, m_page_no, page, true);
+
+    const auto blob_header = page + m_page_offset;
+    const auto part_len = m_blob.blob_get_part_len(blob_header);
+    const auto next_page_no = m_blob.blob_get_next_page_no(blob_header);
+
+    if (extern_offset < m_page_start + part_len) {
+      const auto copy_len = ut_min(len - n_read, ulint(m_page_start + part_len - extern_offset));
+
+      memcpy(buf + n_read, blob_header + BTR_BLOB_HDR_SIZE + (extern_offset - m_page_start), copy_len);
+
+      n_read += copy_len;
+      extern_offset += copy_len;
+    }
+
+    mtr.commit();
+
+    if (extern_offset < m_page_start + part_len) {
+      /* The next read may continue on this page. */
+      break;
+    }
+
+    m_page_start += part_len;
+    m_page_no = next_page_no;
+
+    /* On other BLOB pages except the first the BLOB header
+    always is at the page data start: */
+    m_page_offset = FIL_PAGE_DATA;
+
+    read_ahead(m_page_no);
+  }
+
+  return n_read;
+}
@@ -26,12 +26,16 @@ Created 6/2/1994 Heikki Tuuri
 
 #include "btr0cur.h"
 #include "btr0pcur.h"
+#include "btr0sea.h"
 #include "fsp0fsp.h"
 #include "lock0lock.h"
 #include "page0page.h"
 #include "rem0cmp.h"
 #include "trx0trx.h"
 #include "ut0mem.h"
+#include "ut0probe.h"
+
+#include <algorithm>
 
 /*
 Latching strategy of the InnoDB B-tree
@@ -310,6 +314,19 @@ ulint Btree::get_size(const Index *index, ulint flag) noexcept{
 
 void Btree::page_free_low(const Index *index, Buf_block *block, ulint level, mtr_t *mtr) noexcept {
   ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
+
+  if (level == 0 && srv_btr_search != nullptr) {
+    srv_btr_search->drop_page_hash(index, block);
+  }
+
+  if (level == 0) {
+    auto expected = block;
+
+    /* Don't let inserts go to a free page that happens to look like the
+    rightmost leaf when read back. */
+    (void) index->m_append_block.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+  }
+
   /* The page gets invalid for optimistic searches: increment the frame
   modify clock */
 
@@ -537,6 +554,10 @@ bool Btree::page_reorganize_low(bool recovery, Buf_block *block, const Index *in
 
   ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
 
+  if (srv_btr_search != nullptr) {
+    srv_btr_search->drop_page_hash(index, block);
+  }
+
   const auto data_size1 = page_get_data_size(page);
   const auto max_ins_size1 = page_get_max_insert_size_after_reorganize(page, 1);
 
@@ -602,7 +623,24 @@ bool Btree::page_reorganize_low(bool recovery, Buf_block *block, const Index *in
 }
 
 bool Btree::page_reorganize(Buf_block *block, const Index *index, mtr_t *mtr) noexcept {
-  return page_reorganize_low(false, block, index, mtr);
+  ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
+
+  /* The locks are created under the page latch, none can appear while we
+  hold it. Without explicit locks the heap numbers are free to change and
+  the records can be compacted in place. */
+  if (m_lock_sys->rec_expl_exist_on_page(block->get_page_id())) {
+    return page_reorganize_low(false, block, index, mtr);
+  }
+
+  if (srv_btr_search != nullptr) {
+    srv_btr_search->drop_page_hash(index, block);
+  }
+
+  block->m_check_index_page_at_flush = true;
+
+  page_compact(block, index, mtr);
+
+  return true;
 }
 
 byte *Btree::parse_page_reorganize(byte *ptr, byte *, Index *index, Buf_block *block, mtr_t *mtr) noexcept {
@@ -747,7 +785,15 @@ bool Btree::page_get_split_rec_to_right(Btree_cursor *btr_cur, rec_t *&split_rec
   the previous insert on the same page, we assume that there is a
   pattern of sequential inserts here. */
 
-  if (likely(page_header_get_ptr(page, PAGE_LAST_INSERT) == insert_point)) {
+  if (page_rec_is_supremum(page_rec_get_next(insert_point)) && mach_read_from_4(page + FIL_PAGE_NEXT) == FIL_NULL) {
+
+    /* Appending to the end of the index, whatever the last insert was:
+    leave this page full and start the next one with the new record. */
+    split_rec = nullptr;
+
+    return true;
+
+  } else if (likely(page_header_get_ptr(page, PAGE_LAST_INSERT) == insert_point)) {
 
     const auto next_rec = page_rec_get_next(insert_point);
 
@@ -953,7 +999,36 @@ void Btree::insert_on_non_leaf_level(Index *index, ulint level, DTuple *tuple, m
   ut_a(err == DB_SUCCESS);
 }
 
-void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, mtr_t *mtr) noexcept {
+ulint Btree::node_ptr_n_fields(const Index *index, const rec_t *split_rec, const ulint *offsets, const DTuple *tuple, bool insert_left, mem_heap_t *heap) noexcept {
+  ulint n_bytes{};
+  ulint n_matched{};
+  const auto n_uniq = index->get_n_unique_in_tree();
+  const auto prev_rec = page_rec_get_prev_const(split_rec);
+
+  if (page_rec_is_user_rec(prev_rec)) {
+    Phy_rec record{index, prev_rec};
+
+    const auto prev_offsets = record.get_col_offsets(nullptr, n_uniq, &heap, Current_location());
+
+    (void) cmp_rec_rec_with_match(prev_rec, split_rec, prev_offsets, offsets, index, &n_matched, &n_bytes);
+  }
+
+  if (insert_left) {
+    ulint n_tuple_matched{};
+
+    n_bytes = 0;
+
+    (void) cmp_dtuple_rec_with_match(index, tuple, split_rec, offsets, &n_tuple_matched, &n_bytes);
+
+    n_matched = std::max(n_matched, n_tuple_matched);
+  }
+
+  /* The first field that differs from the greatest key of the lower half
+  is the last one needed. */
+  return std::min(n_matched + 1, n_uniq);
+}
+
+void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, ulint n_fields, mtr_t *mtr) noexcept {
   page_t *lower_page;
   page_t *upper_page;
   ulint lower_page_no;
@@ -982,6 +1057,8 @@ void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec,
     /* Replace the address of the old child node (= page) with the
     address of the new lower half */
 
+    ut_ad(page_cur_change_allowed(page_align(btr_cur.get_rec()), index, mtr));
+
     node_ptr_set_child_page_no(btr_cur.get_rec(), offsets, lower_page_no, mtr);
     mem_heap_empty(heap);
 
@@ -1001,6 +1078,12 @@ void Btree::attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec,
 
   const auto node_ptr_upper = index->build_node_ptr(split_rec, upper_page_no, heap, level);
 
+  /* Suffix truncation: the node pointer is still greater than any key of
+  the lower half and not greater than any key of the upper half. */
+  for (auto i = n_fields; i < index->get_n_unique_in_tree(); ++i) {
+    dfield_set_null(dtuple_get_nth_field(node_ptr_upper, i));
+  }
+
   /* Insert it next to the pointer to the lower half. Note that this
   may generate recursion leading to a split on the higher level. */
 
@@ -1092,6 +1175,11 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
     ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
     ut_ad(page_get_n_recs(page) >= 1);
 
+    if (srv_btr_search != nullptr) {
+      /* Half of the records move to the new page. */
+      srv_btr_search->drop_page_hash(btr_cur->get_index(), block);
+    }
+
     auto page_no = block->get_page_no();
 
     /* 1. Decide the split record; split_rec == nullptr means that the
@@ -1149,6 +1237,10 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
 
     page_create(new_block, btr_cur->get_index(), page_get_level(page, mtr), mtr);
 
+    btr_cur->get_index()->m_counters.inc(Index::PAGE_SPLITS);
+
+    IB_PROBE(btr__page__split, btr_cur->get_index()->m_id, page_no, new_block->get_page_no(), direction);
+
     /* 3. Calculate the first record on the upper half-page, and the
     first record (move_limit) on original page which ends up on the
     upper half */
@@ -1156,6 +1248,7 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
     byte *buf{};
     rec_t *first_rec{};
     rec_t *move_limit{};
+    auto n_fields = n_uniq;
 
     if (split_rec != nullptr) {
       first_rec = move_limit = split_rec;
@@ -1166,6 +1259,12 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
 
       insert_left = cmp_dtuple_rec(btr_cur->get_index()->m_cmp_ctx, tuple, split_rec, offsets) < 0;
 
+      /* On the upper levels the node pointer must equal the first record
+      of the child, see validate_level(). */
+      if (page_is_leaf(page)) {
+        n_fields = node_ptr_n_fields(btr_cur->get_index(), split_rec, offsets, tuple, insert_left, heap);
+      }
+
     } else {
 
       buf = reinterpret_cast<byte *>(mem_alloc(rec_get_converted_size(btr_cur->get_index(), tuple, n_ext)));
@@ -1177,7 +1276,7 @@ rec_t *Btree::page_split_and_insert(Btree_cursor *btr_cur, const DTuple *tuple,
 
     /* 4. Do first the modifications in the tree structure */
 
-    attach_half_pages(btr_cur->get_index(), block, first_rec, new_block, direction, mtr);
+    attach_half_pages(btr_cur->get_index(), block, first_rec, new_block, direction, n_fields, mtr);
 
     /* If the split is made on the leaf level and the insert will fit
     on the appropriate half-page, we may release the tree x-latch.
@@ -1436,9 +1535,9 @@ bool Btree::compress(Btree_cursor *cursor, mtr_t *mtr) noexcept {
   page_t *merge_page;
   Btree_cursor btr_cur(m_fsp, this);
 
-  auto block = btr_cur.get_block();
-  auto page = btr_cur.get_page_no();
-  auto index = btr_cur.get_index();
+  auto block = cursor->get_block();
+  auto page = cursor->get_page_no();
+  auto index = cursor->get_index();
 
   ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
   ut_ad(mtr->memo_contains(block, MTR_MEMO_PAGE_X_FIX));
@@ -1540,7 +1639,7 @@ bool Btree::compress(Btree_cursor *cursor, mtr_t *mtr) noexcept {
     m_lock_sys->update_merge_left(merge_block, orig_pred, block);
 
   } else {
-    auto orig_succ = page_copy_rec_list_end(merge_block, block, page_get_infimum_rec(page), cursor->m_index, mtr);
+    auto orig_succ = page_copy_rec_list_end(merge_block, block, page_get_infimum_rec(page), index, mtr);
 
     ut_a(orig_succ == nullptr);
 
@@ -1550,6 +1649,8 @@ bool Btree::compress(Btree_cursor *cursor, mtr_t *mtr) noexcept {
     /* Replace the address of the old child node (= page) with the
     address of the merge page to the right */
 
+    ut_ad(page_cur_change_allowed(page_align(btr_cur.get_rec()), index, mtr));
+
     node_ptr_set_child_page_no(btr_cur.get_rec(), offsets, right_page_no, mtr);
     node_ptr_delete(index, merge_block, mtr);
 
@@ -1564,6 +1665,8 @@ bool Btree::compress(Btree_cursor *cursor, mtr_t *mtr) noexcept {
 
   ut_ad(check_node_ptr(index, merge_block, mtr));
 
+  index->m_counters.inc(Index::PAGE_MERGES);
+
   return true;
 }
 
@@ -1665,6 +1768,7 @@ void Btree::discard_page(Btree_cursor *btr_cur, mtr_t *mtr) noexcept{
     auto node_ptr = page_rec_get_next(page_get_infimum_rec(merge_page));
 
     ut_ad(page_rec_is_user_rec(node_ptr));
+    ut_ad(page_cur_change_allowed(merge_page, index, mtr));
 
     set_min_rec_mark(node_ptr, mtr);
   }
@@ -0,0 +1,427 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file btr/btr0bulk.cc
+Sorted bulk build of a B-tree
+*******************************************************/
+
+#include "btr0bulk.h"
+#include "btr0blob.h"
+#include "btr0btr.h"
+#include "buf0buf.h"
+#include "data0data.h"
+#include "dict0dict.h"
+#include "fsp0fsp.h"
+#include "log0log.h"
+#include "mtr0mtr.h"
+#include "page0cur.h"
+#include "page0page.h"
+#include "rem0cmp.h"
+#include "rem0rec.h"
+#include "srv0srv.h"
+#include "trx0undo.h"
+
+#include <algorithm>
+
+Btree_bulk::Btree_bulk(Btree *btree, const Index *index, trx_id_t trx_id, bool redo) noexcept
+  : m_btree(btree),
+    m_index(index),
+    m_trx_id(trx_id),
+    m_reserve(UNIV_PAGE_SIZE * (100 - srv_config.m_fill_factor) / 100),
+    m_redo(redo),
+    m_heap(mem_heap_create(1024)) {
+
+  /* Leave at least the room on the clustered index leaves that sequential
+  inserts leave, see Btree_cursor::optimistic_insert(). */
+  m_leaf_reserve = index->is_clustered() ? std::max(m_reserve, Dict::index_get_space_reserve()) : m_reserve;
+}
+
+Btree_bulk::~Btree_bulk() noexcept {
+  for (auto &level : m_levels) {
+    m_btree->m_buf_pool->block_free(level.m_block);
+  }
+
+  for (auto &[offset, big_rec] : m_big_recs) {
+    dtuple_big_rec_free(big_rec);
+  }
+
+  mem_heap_free(m_heap);
+}
+
+void Btree_bulk::page_init(ulint level_no) noexcept {
+  auto &level = m_levels[level_no];
+
+  if (level.m_block == nullptr) {
+    level.m_block = m_btree->m_buf_pool->block_alloc();
+  }
+
+  /* The page is logged as a whole when it is written to the tree. */
+  mtr_t mtr;
+
+  mtr.start();
+
+  const auto log_mode = mtr.set_log_mode(MTR_LOG_NONE);
+
+  ::page_create(m_index, level.m_block, &mtr);
+
+  mtr.set_log_mode(log_mode);
+
+  mtr.commit();
+
+  auto page = level.m_block->get_frame();
+
+  mach_write_to_2(page + PAGE_HEADER + PAGE_LEVEL, level_no);
+  mach_write_to_8(page + PAGE_HEADER + PAGE_INDEX_ID, m_index->m_id);
+
+  if (level_no == 0 && !m_index->is_clustered()) {
+    page_set_max_trx_id(level.m_block, m_trx_id, nullptr);
+  }
+
+  level.m_last_rec = page_get_infimum_rec(page);
+}
+
+db_err Btree_bulk::store_ext(page_no_t page_no) noexcept {
+  if (m_big_recs.empty()) {
+    return DB_SUCCESS;
+  }
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  mtr_x_lock(m_index->get_lock(), &mtr);
+
+  auto block = m_btree->block_get(m_index->get_space_id(), page_no, RW_X_LATCH, &mtr);
+  auto page = block->get_frame();
+
+  Blob blob(m_btree->m_fsp, m_btree);
+
+  auto err = DB_SUCCESS;
+  ulint *offsets{};
+
+  for (auto &[offset, big_rec] : m_big_recs) {
+    if (err == DB_SUCCESS) {
+      auto rec = page + offset;
+
+      {
+        Phy_rec record{m_index, rec};
+
+        offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &m_heap, Current_location());
+      }
+
+      err = blob.store_big_rec_extern_fields(m_index, block, rec, offsets, big_rec, &mtr);
+    }
+
+    dtuple_big_rec_free(big_rec);
+  }
+
+  m_big_recs.clear();
+
+  mtr.commit();
+
+  return err;
+}
+
+void Btree_bulk::flush_unlogged() noexcept {
+  auto log = m_btree->m_fsp->m_log;
+
+  /* The pages were modified up to m_unlogged_lsn, the flush also writes the
+  pages of the other indexes that are older. */
+  while (!log->preflush_pool_modified_pages(m_unlogged_lsn + 1, true)) {
+    ;
+  }
+
+  m_btree->m_fsp->m_fil->flush(m_index->get_space_id());
+
+  m_unlogged_lsn = 0;
+}
+
+db_err Btree_bulk::page_commit(ulint level_no, bool is_root) noexcept {
+  const auto space = m_index->get_space_id();
+  const auto prev_page_no = m_levels[level_no].m_prev_page_no;
+  const auto image = m_levels[level_no].m_block->get_frame();
+
+  ut_ad(page_get_n_recs(image) > 0);
+  ut_ad(!is_root || prev_page_no == FIL_NULL);
+
+  if (is_root && m_unlogged_lsn > 0) {
+    flush_unlogged();
+  }
+
+  m_btree->m_fsp->m_log->free_check();
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  mtr_x_lock(m_index->get_lock(), &mtr);
+
+  Buf_block *block;
+  Buf_block *prev_block{};
+
+  if (is_root) {
+    block = m_btree->root_block_get(m_index->m_page_id, &mtr);
+
+    auto root = block->get_frame();
+
+    ut_a(page_get_n_recs(root) == 0);
+
+    /* The file segments of the index are rooted in the root page. */
+    memcpy(image + PAGE_HEADER + PAGE_BTR_SEG_LEAF, root + PAGE_HEADER + PAGE_BTR_SEG_LEAF, 2 * FSEG_HEADER_SIZE);
+
+    buf_block_modify_clock_inc(block);
+
+  } else {
+    /* Latch the pages of a level left to right. */
+    if (prev_page_no != FIL_NULL) {
+      prev_block = m_btree->block_get(space, prev_page_no, RW_X_LATCH, &mtr);
+    }
+
+    ulint n_reserved;
+
+    if (!m_btree->m_fsp->reserve_free_extents(&n_reserved, space, 1, FSP_NORMAL, &mtr)) {
+      mtr.commit();
+
+      return DB_OUT_OF_FILE_SPACE;
+    }
+
+    const auto hint_page_no = prev_page_no == FIL_NULL ? 0 : prev_page_no + 1;
+
+    block = m_btree->page_alloc(m_index, hint_page_no, FSP_UP, level_no, &mtr);
+
+    m_btree->m_fsp->m_fil->space_release_free_extents(space, n_reserved);
+
+    if (block == nullptr) {
+      mtr.commit();
+
+      return DB_OUT_OF_FILE_SPACE;
+    }
+
+    ::page_create(m_index, block, &mtr);
+  }
+
+  /* The allocation of the page is logged in any case, the file segment must
+  be consistent after a crash. */
+  const auto log_page = m_redo || is_root;
+  const auto log_mode = log_page ? mtr.get_log_mode() : mtr.set_log_mode(MTR_LOG_NONE);
+
+  auto page = block->get_frame();
+
+  /* Copy what a MLOG_PAGE_BUILT record restores, see page_parse_built(). */
+  const auto heap_len = ulint(page_header_get_ptr(image, PAGE_HEAP_TOP) - (image + PAGE_HEADER));
+  const auto dir_len = page_dir_get_n_slots(image) * PAGE_DIR_SLOT_SIZE;
+
+  memcpy(page + PAGE_HEADER, image + PAGE_HEADER, heap_len);
+  memcpy(page + UNIV_PAGE_SIZE - PAGE_DIR - dir_len, image + UNIV_PAGE_SIZE - PAGE_DIR - dir_len, dir_len);
+
+  block->m_check_index_page_at_flush = true;
+
+  Btree::page_set_prev(page, prev_page_no, &mtr);
+  Btree::page_set_next(page, FIL_NULL, &mtr);
+
+  const auto page_no = block->get_page_no();
+
+  if (prev_block != nullptr) {
+    Btree::page_set_next(prev_block->get_frame(), page_no, &mtr);
+  }
+
+  page_built_write_log(page, &mtr);
+
+  ut_ad(page_validate(page, const_cast<Index *>(m_index)));
+
+  mtr.set_log_mode(log_mode);
+
+  mtr.commit();
+
+  if (!log_page) {
+    m_unlogged_lsn = mtr.m_end_lsn;
+  }
+
+  ++m_n_pages;
+
+  if (level_no == 0) {
+    /* The BLOB pages are written after the record that points to them,
+    like Row_insert::index_entry_low() does. */
+    if (auto err = store_ext(page_no); err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  if (is_root) {
+    return DB_SUCCESS;
+  }
+
+  auto &level = m_levels[level_no];
+  const auto first_rec = page_rec_get_next(page_get_infimum_rec(image));
+  auto node_ptr = m_index->build_node_ptr(first_rec, page_no, m_heap, level_no);
+
+  /* There is no lower limit to the records of the leftmost page of a level. */
+  if (level.m_n_pages == 0) {
+    dtuple_set_info_bits(node_ptr, dtuple_get_info_bits(node_ptr) | REC_INFO_MIN_REC_FLAG);
+  }
+
+  level.m_prev_page_no = page_no;
+  ++level.m_n_pages;
+
+  return append(level_no + 1, node_ptr, 0, nullptr);
+}
+
+db_err Btree_bulk::append(ulint level_no, const DTuple *tuple, ulint n_ext, big_rec_t *big_rec) noexcept {
+  if (level_no == m_levels.size()) {
+    ut_a(level_no < BTR_MAX_DEPTH);
+
+    m_levels.push_back(Level{.m_prev_page_no = FIL_NULL});
+
+    page_init(level_no);
+  }
+
+  const auto rec_size = rec_get_converted_size(m_index, tuple, n_ext);
+
+  {
+    const auto page = m_levels[level_no].m_block->get_frame();
+    const auto max_size = page_get_max_insert_size(page, 1);
+    const auto reserve = level_no == 0 ? m_leaf_reserve : m_reserve;
+
+    if (page_get_n_recs(page) > 0 && (rec_size > max_size || max_size - rec_size < reserve)) {
+
+      if (auto err = page_commit(level_no, false); err != DB_SUCCESS) {
+
+        if (big_rec != nullptr) {
+          dtuple_big_rec_free(big_rec);
+        }
+
+        return err;
+      }
+
+      page_init(level_no);
+    }
+  }
+
+  /* page_commit() can add a level, look the level up again. */
+  auto &level = m_levels[level_no];
+
+  auto rec = rec_convert_dtuple_to_rec(reinterpret_cast<byte *>(mem_heap_alloc(m_heap, rec_size)), m_index, tuple, n_ext);
+
+  ulint *offsets;
+
+  {
+    Phy_rec record{m_index, rec};
+
+    offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &m_heap, Current_location());
+  }
+
+  /* No mtr, the page is not in the tree yet. */
+  level.m_last_rec = page_cur_insert_rec_low(level.m_last_rec, m_index, rec, offsets, nullptr);
+  ut_a(level.m_last_rec != nullptr);
+
+  if (big_rec != nullptr) {
+    m_big_recs.emplace_back(page_offset(level.m_last_rec), big_rec);
+  }
+
+  return DB_SUCCESS;
+}
+
+db_err Btree_bulk::check_order(const DTuple *tuple) noexcept {
+  if (m_levels.empty() || page_rec_is_infimum(m_levels[0].m_last_rec)) {
+    return DB_SUCCESS;
+  }
+
+  const auto last_rec = m_levels[0].m_last_rec;
+
+  ulint *offsets;
+
+  {
+    Phy_rec record{m_index, last_rec};
+
+    offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &m_heap, Current_location());
+  }
+
+  ulint matched_fields{};
+  ulint matched_bytes{};
+  const auto cmp = cmp_dtuple_rec_with_match(m_index, tuple, last_rec, offsets, &matched_fields, &matched_bytes);
+
+  if (m_index->is_unique() && matched_fields >= m_index->get_n_unique()) {
+    /* A NULL is not equal to another NULL in a unique key. */
+    for (ulint i{}; i < m_index->get_n_unique(); ++i) {
+      if (dfield_is_null(dtuple_get_nth_field(tuple, i))) {
+        return cmp > 0 ? DB_SUCCESS : DB_INVALID_INPUT;
+      }
+    }
+
+    return DB_DUPLICATE_KEY;
+  }
+
+  return cmp > 0 ? DB_SUCCESS : DB_INVALID_INPUT;
+}
+
+db_err Btree_bulk::insert(DTuple *tuple, ulint n_ext) noexcept {
+  ut_ad(dtuple_check_typed(tuple));
+
+  if (auto err = check_order(tuple); err != DB_SUCCESS) {
+    mem_heap_empty(m_heap);
+
+    return err;
+  }
+
+  if (m_index->is_clustered()) {
+    /* The insert has no undo log record, a consistent read that doesn't
+    see the transaction of the record treats it as not inserted yet. */
+    const auto pos = m_index->get_sys_col_field_pos(DATA_ROLL_PTR);
+    auto field = dtuple_get_nth_field(tuple, pos);
+
+    trx_write_roll_ptr(reinterpret_cast<byte *>(dfield_get_data(field)), trx_undo_build_roll_ptr(true, 0, 0, 0));
+  }
+
+  big_rec_t *big_rec{};
+
+  if (page_rec_needs_ext(rec_get_converted_size(m_index, tuple, n_ext))) {
+    big_rec = dtuple_convert_big_rec(m_index, tuple, &n_ext);
+
+    if (big_rec == nullptr) {
+      mem_heap_empty(m_heap);
+
+      return DB_TOO_BIG_RECORD;
+    }
+
+    /* The fields are stored after the page is written, the data of the
+    caller is gone by then. */
+    for (ulint i{}; i < big_rec->n_fields; ++i) {
+      auto &field = big_rec->fields[i];
+
+      field.data = mem_heap_dup(big_rec->heap, field.data, field.len);
+    }
+  }
+
+  const auto err = append(0, tuple, n_ext, big_rec);
+
+  mem_heap_empty(m_heap);
+
+  return err;
+}
+
+db_err Btree_bulk::finish(db_err err) noexcept {
+  /* The loop adds a level when the topmost level has more than one page. */
+  for (ulint level_no{}; err == DB_SUCCESS && level_no < m_levels.size(); ++level_no) {
+    const auto is_root = level_no + 1 == m_levels.size() && m_levels[level_no].m_n_pages == 0;
+
+    err = page_commit(level_no, is_root);
+  }
+
+  mem_heap_empty(m_heap);
+
+  return err;
+}
@@ -46,7 +46,9 @@ Created 10/16/1994 Heikki Tuuri
 
 #include "btr0btr.h"
 #include "btr0blob.h"
+#include "btr0sea.h"
 #include "buf0lru.h"
+#include "dict0hist.h"
 #include "dict0types.h"
 #include "lock0lock.h"
 #include "mtr0log.h"
@@ -65,6 +67,90 @@ Created 10/16/1994 Heikki Tuuri
 can be released by page reorganize, then it is reorganized */
 constexpr ulint BTR_CUR_PAGE_REORGANIZE_LIMIT = UNIV_PAGE_SIZE / 32;
 
+/** Number of times a leaf search descends the tree without the tree latch
+before it gives up and latches the tree */
+constexpr ulint BTR_CUR_OPTIMISTIC_RETRIES = 3;
+
+/**
+ * Searches a copy of a non-leaf page for the node pointer to follow.
+ *
+ * @param[in] index             Index of the page.
+ * @param[in] page              Consistent copy of the page, aligned to UNIV_PAGE_SIZE.
+ * @param[in] tuple             Search key.
+ * @param[in] mode              PAGE_CUR_L or PAGE_CUR_LE.
+ * @param[in,out] heap          Heap for the record offsets, or nullptr.
+ *
+ * @return the last node pointer < tuple (PAGE_CUR_L) or <= tuple (PAGE_CUR_LE).
+ */
+static const rec_t *node_ptr_search(const Index *index, const page_t *page, const DTuple *tuple, ulint mode, mem_heap_t **heap) noexcept {
+  ulint low_matched_fields{};
+  ulint low_matched_bytes{};
+  ulint up_matched_fields{};
+  ulint up_matched_bytes{};
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  rec_offs_init(offsets_);
+
+  ut_ad(mode == PAGE_CUR_L || mode == PAGE_CUR_LE);
+
+  const auto n_fields = dtuple_get_n_fields_cmp(tuple);
+
+  /* Returns true if the record belongs to the lower limit, as in page_cur_search_with_match(). */
+  auto is_low = [&](const rec_t *rec, ulint &matched_fields, ulint &matched_bytes) -> bool {
+    ut_pair_min(&matched_fields, &matched_bytes, low_matched_fields, low_matched_bytes, up_matched_fields, up_matched_bytes);
+
+    {
+      Phy_rec record{index, rec};
+
+      offsets = record.get_col_offsets(offsets, n_fields, heap, Current_location());
+    }
+
+    const auto cmp = cmp_dtuple_rec_with_match(index, tuple, rec, offsets, &matched_fields, &matched_bytes);
+
+    return cmp > 0 || (cmp == 0 && mode == PAGE_CUR_LE);
+  };
+
+  ulint low{};
+  ulint up = page_dir_get_n_slots(page) - 1;
+
+  while (up - low > 1) {
+    ulint matched_fields;
+    ulint matched_bytes;
+    const auto mid = (low + up) / 2;
+
+    if (is_low(page_dir_slot_get_rec(page_dir_get_nth_slot(page, mid)), matched_fields, matched_bytes)) {
+      low = mid;
+      low_matched_fields = matched_fields;
+      low_matched_bytes = matched_bytes;
+    } else {
+      up = mid;
+      up_matched_fields = matched_fields;
+      up_matched_bytes = matched_bytes;
+    }
+  }
+
+  const rec_t *low_rec = page_dir_slot_get_rec(page_dir_get_nth_slot(page, low));
+  const rec_t *up_rec = page_dir_slot_get_rec(page_dir_get_nth_slot(page, up));
+
+  for (auto rec = page_rec_get_next_const(low_rec); rec != up_rec; rec = page_rec_get_next_const(rec)) {
+    ulint matched_fields;
+    ulint matched_bytes;
+
+    if (!is_low(rec, matched_fields, matched_bytes)) {
+      break;
+    }
+
+    low_rec = rec;
+    low_matched_fields = matched_fields;
+    low_matched_bytes = matched_bytes;
+  }
+
+  /* The first node pointer of a level has the min rec flag set, it is less than any key. */
+  ut_ad(page_rec_is_user_rec(low_rec));
+
+  return low_rec;
+}
+
 
 /**
  * The following function is used to set the deleted bit of a record.
@@ -174,12 +260,72 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
   )
 
   estimate = latch_mode & BTR_ESTIMATE;
-  latch_mode = latch_mode & ~(BTR_INSERT | BTR_ESTIMATE);
+
+  /* The key of an insert is usually not in the tree yet, don't let it
+  reset the learning of the adaptive hash index. */
+  auto use_hash = level == 0 && !estimate && !(latch_mode & BTR_INSERT);
+
+  /* Inserts with increasing keys all go to the rightmost leaf. */
+  const auto append = level == 0 && (latch_mode & BTR_INSERT) && mode == PAGE_CUR_LE && (latch_mode & ~BTR_INSERT) == BTR_MODIFY_LEAF;
+
+  /* The externally stored fields are written under an SX tree latch, the
+  searches that don't latch the tree can't be used. */
+  const auto external = (latch_mode & BTR_MODIFY_EXTERNAL) != 0;
+
+  ut_ad(!external || (latch_mode & ~BTR_MODIFY_EXTERNAL) == BTR_MODIFY_LEAF);
+
+  latch_mode = latch_mode & ~(BTR_INSERT | BTR_ESTIMATE | BTR_MODIFY_EXTERNAL);
+
+  /* Inserts and lookups of a batch in key order try the leaf page of the
+  previous one first. */
+  const auto guess_leaf = m_leaf_guess != nullptr && level == 0 && !estimate && (append || (latch_mode == BTR_SEARCH_LEAF && mode == PAGE_CUR_GE));
 
   ut_ad(!insert_planned || (mode == PAGE_CUR_LE));
 
   m_flag = BTR_CUR_BINARY;
   m_index = index;
+  m_parent_page_no = FIL_NULL;
+
+  ulint fold{};
+
+  use_hash = use_hash && !external && srv_btr_search != nullptr && srv_btr_search->is_candidate(index, tuple, mode, latch_mode);
+
+  if (use_hash) {
+    fold = dtuple_fold(tuple, dtuple_get_n_fields_cmp(tuple), 0, index->m_id);
+
+    if (search_hash(tuple, fold, mode, latch_mode, mtr, loc)) {
+      return;
+    }
+  }
+
+  if (guess_leaf && search_leaf_guess(tuple, mode, latch_mode, mtr, loc)) {
+    return;
+  }
+
+  if (append && search_append(tuple, mtr, loc)) {
+    return;
+  }
+
+  if (level == 0 && !estimate && !external && (latch_mode == BTR_SEARCH_LEAF || latch_mode == BTR_MODIFY_LEAF)) {
+    for (ulint i = 0; i < BTR_CUR_OPTIMISTIC_RETRIES; ++i) {
+      if (search_optimistic(tuple, mode, latch_mode, mtr, loc)) {
+
+        if (use_hash) {
+          update_hash(tuple, fold, mode);
+        }
+
+        if (append) {
+          update_append();
+        }
+
+        if (guess_leaf) {
+          update_leaf_guess();
+        }
+
+        return;
+      }
+    }
+  }
 
   /* Store the position of the tree latch we push to mtr so that we
   know how to release it when we have latched leaf node(s) */
@@ -189,6 +335,11 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
   if (latch_mode == BTR_MODIFY_TREE) {
     mtr_x_lock(index->get_lock(), mtr);
 
+  } else if (external) {
+    /* Excludes tree modifications, so the non-leaf pages can be
+    read without latching them, but lets readers in. */
+    mtr_sx_lock(index->get_lock(), mtr);
+
   } else if (latch_mode == BTR_CONT_MODIFY_TREE) {
     /* Do nothing */
     ut_ad(mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK));
@@ -257,6 +408,10 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
 
     block = get_buf_pool()->get(req, nullptr);
 
+    if (req.m_read) {
+      index->m_counters.inc(Index::PAGE_READS);
+    }
+
     if (block == nullptr) {
 
       ut_ad(m_thr != nullptr);
@@ -294,7 +449,7 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
         latch_leaves(page, space, page_no, latch_mode, mtr);
       }
 
-      if ((latch_mode != BTR_MODIFY_TREE) && (latch_mode != BTR_CONT_MODIFY_TREE)) {
+      if ((latch_mode != BTR_MODIFY_TREE) && (latch_mode != BTR_CONT_MODIFY_TREE) && !external) {
 
         /* Release the tree s-latch */
 
@@ -336,6 +491,10 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
       offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
     }
 
+    if (height == 0) {
+      m_parent_page_no = page_no;
+    }
+
     /* Go to the child node */
     page_no = m_btree->node_ptr_get_child_page_no(node_ptr, offsets);
   }
@@ -353,6 +512,543 @@ void Btree_cursor::search_to_nth_level(Paths *paths, const Index *index, ulint l
     ut_ad(m_up_match != ULINT_UNDEFINED || mode != PAGE_CUR_GE);
     ut_ad(m_up_match != ULINT_UNDEFINED || mode != PAGE_CUR_LE);
     ut_ad(m_low_match != ULINT_UNDEFINED || mode != PAGE_CUR_LE);
+
+    if (use_hash) {
+      update_hash(tuple, fold, mode);
+    }
+
+    if (append) {
+      update_append();
+    }
+
+    if (guess_leaf) {
+      update_leaf_guess();
+    }
+  }
+}
+
+bool Btree_cursor::search_optimistic(const DTuple *tuple, ulint mode, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept {
+  /* Copy of the non-leaf page being searched, page_align() must work on it. */
+  alignas(UNIV_PAGE_SIZE) static thread_local byte copy[UNIV_PAGE_SIZE];
+
+  uint64_t version;
+  const auto lock = m_index->get_lock();
+
+  /* A structure change holds the tree x-latch, it's the only writer of
+  the non-leaf pages. */
+  if (!rw_lock_read_begin(lock, version)) {
+    return false;
+  }
+
+  ulint page_mode;
+
+  switch (mode) {
+    case PAGE_CUR_GE:
+      page_mode = PAGE_CUR_L;
+      break;
+    case PAGE_CUR_G:
+      page_mode = PAGE_CUR_LE;
+      break;
+    default:
+      page_mode = mode;
+      break;
+  }
+
+  mem_heap_t *heap{};
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  rec_offs_init(offsets_);
+
+  Buf_block *block{};
+  ulint height{ULINT_UNDEFINED};
+  const auto space = m_index->get_space_id();
+  auto page_no = m_index->get_page_no();
+
+  for (;;) {
+    const auto savepoint = mtr->set_savepoint();
+
+    Buf_pool::Request req {
+      .m_rw_latch = height == 0 ? latch_mode : RW_NO_LATCH,
+      .m_page_id = { space, page_no },
+      .m_mode = BUF_GET,
+      .m_file = loc.m_from.file_name(),
+      .m_line = loc.m_from.line(),
+      .m_mtr = mtr
+    };
+
+    block = get_buf_pool()->get(req, nullptr);
+
+    if (req.m_read) {
+      m_index->m_counters.inc(Index::PAGE_READS);
+    }
+
+    if (height == 0) {
+      /* No structure change since the parent was copied: the key is still in
+      this leaf and with the leaf latched none can start that would move it. */
+      if (!rw_lock_read_validate(lock, version)) {
+        mtr->release_block_at_savepoint(savepoint, block);
+        block = nullptr;
+      }
+
+      break;
+    }
+
+    memcpy(copy, block->get_frame(), UNIV_PAGE_SIZE);
+
+    mtr->release_block_at_savepoint(savepoint, block);
+
+    /* Don't look at the copy before it's known to be consistent. */
+    if (!rw_lock_read_validate(lock, version)) {
+      block = nullptr;
+      break;
+    }
+
+    ut_ad(m_btree->page_get_index_id(copy) == m_index->m_id);
+
+    if (height == ULINT_UNDEFINED) {
+      height = m_btree->page_get_level_low(copy);
+      m_tree_height = height + 1;
+
+      if (height == 0) {
+        /* The root is a leaf, latch it. */
+        continue;
+      }
+    }
+
+    const auto node_ptr = node_ptr_search(m_index, copy, tuple, page_mode, &heap);
+
+    {
+      Phy_rec record{m_index, node_ptr};
+
+      offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
+    }
+
+    if (height == 1) {
+      m_parent_page_no = page_no;
+    }
+
+    page_no = m_btree->node_ptr_get_child_page_no(node_ptr, offsets);
+
+    --height;
+  }
+
+  if (likely_null(heap)) {
+    mem_heap_free(heap);
+  }
+
+  if (block == nullptr) {
+    return false;
+  }
+
+  buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
+
+  block->m_check_index_page_at_flush = true;
+
+  ut_ad(page_is_leaf(block->get_frame()));
+
+  ulint up_match{};
+  ulint up_bytes{};
+  ulint low_match{};
+  ulint low_bytes{};
+
+  page_cur_search_with_match(block, m_index, tuple, mode, &up_match, &up_bytes, &low_match, &low_bytes, get_page_cur());
+
+  m_low_match = low_match;
+  m_low_bytes = low_bytes;
+  m_up_match = up_match;
+  m_up_bytes = up_bytes;
+
+  return true;
+}
+
+bool Btree_cursor::search_append(const DTuple *tuple, mtr_t *mtr, Source_location loc) noexcept {
+  auto block = m_index->m_append_block.load(std::memory_order_relaxed);
+
+  if (block == nullptr) {
+    return false;
+  }
+
+  Buf_pool::Request req {
+    .m_rw_latch = RW_X_LATCH,
+    .m_guess = block,
+    .m_modify_clock = m_index->m_append_modify_clock.load(std::memory_order_relaxed),
+    .m_file = loc.m_from.file_name(),
+    .m_line = loc.m_from.line(),
+    .m_mtr = mtr
+  };
+
+  /* Fails if the page was freed or a record of it deleted or moved, a split
+  moves records, since the guess was made. */
+  if (!get_buf_pool()->try_get(req)) {
+    return false;
+  }
+
+  const auto page = block->get_frame();
+
+  /* The block may have been evicted and reused for another page, whose
+  modify clock starts again from 0. */
+  if (block->get_space() != m_index->get_space_id()
+      || !page_is_leaf(page)
+      || m_btree->page_get_index_id(page) != m_index->m_id
+      || mach_read_from_4(page + FIL_PAGE_NEXT) != FIL_NULL
+      || page_get_n_recs(page) == 0) {
+
+    m_btree->leaf_page_release(block, BTR_MODIFY_LEAF, mtr);
+
+    auto expected = block;
+
+    (void) m_index->m_append_block.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+
+    return false;
+  }
+
+  /* Nothing follows the last record of the rightmost leaf, an entry greater
+  than it belongs right after it. */
+  const auto rec = page_rec_get_prev(page_get_supremum_rec(page));
+
+  mem_heap_t *heap{};
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  rec_offs_init(offsets_);
+
+  {
+    Phy_rec record{m_index, rec};
+
+    offsets = record.get_col_offsets(offsets, dtuple_get_n_fields_cmp(tuple), &heap, Current_location());
+  }
+
+  ulint n_matched{};
+  ulint n_bytes{};
+  const auto cmp = cmp_dtuple_rec_with_match(m_index, tuple, rec, offsets, &n_matched, &n_bytes);
+
+  if (heap != nullptr) {
+    mem_heap_free(heap);
+  }
+
+  if (cmp <= 0) {
+    m_btree->leaf_page_release(block, BTR_MODIFY_LEAF, mtr);
+
+    return false;
+  }
+
+  buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
+
+  block->m_check_index_page_at_flush = true;
+
+  page_cur_position(rec, block, get_page_cur());
+
+  m_low_match = n_matched;
+  m_low_bytes = n_bytes;
+  m_up_match = 0;
+  m_up_bytes = 0;
+
+  return true;
+}
+
+void Btree_cursor::update_append() noexcept {
+  const auto block = page_cur_get_block(get_page_cur());
+  const auto page = block->get_frame();
+
+  ut_ad(page_is_leaf(page));
+
+  if (mach_read_from_4(page + FIL_PAGE_NEXT) == FIL_NULL) {
+    m_index->m_append_modify_clock.store(buf_block_get_modify_clock(block), std::memory_order_relaxed);
+    m_index->m_append_block.store(block, std::memory_order_relaxed);
+  }
+}
+
+bool Btree_cursor::search_leaf_guess(const DTuple *tuple, ulint mode, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept {
+  auto block = m_leaf_guess->m_block;
+
+  if (block == nullptr) {
+    return false;
+  }
+
+  Buf_pool::Request req {
+    .m_rw_latch = latch_mode == BTR_SEARCH_LEAF ? RW_S_LATCH : RW_X_LATCH,
+    .m_guess = block,
+    .m_modify_clock = m_leaf_guess->m_modify_clock,
+    .m_file = loc.m_from.file_name(),
+    .m_line = loc.m_from.line(),
+    .m_mtr = mtr
+  };
+
+  if (!get_buf_pool()->try_get(req)) {
+    m_leaf_guess->m_block = nullptr;
+    return false;
+  }
+
+  const auto page = block->get_frame();
+
+  /* As in search_append(), the block may now hold another page. */
+  if (block->get_space() != m_index->get_space_id()
+      || !page_is_leaf(page)
+      || m_btree->page_get_index_id(page) != m_index->m_id
+      || page_get_n_recs(page) == 0) {
+
+    m_btree->leaf_page_release(block, latch_mode, mtr);
+
+    m_leaf_guess->m_block = nullptr;
+
+    return false;
+  }
+
+  ulint up_match{};
+  ulint up_bytes{};
+  ulint low_match{};
+  ulint low_bytes{};
+
+  page_cur_search_with_match(block, m_index, tuple, mode, &up_match, &up_bytes, &low_match, &low_bytes, get_page_cur());
+
+  const auto rec = page_cur_get_rec(get_page_cur());
+
+  bool outside;
+
+  if (mode == PAGE_CUR_LE) {
+    /* An entry before the first record may belong to the previous page, one
+    after the last record to the next page, unless it equals that record. */
+    outside = page_rec_is_infimum(rec)
+      ? mach_read_from_4(page + FIL_PAGE_PREV) != FIL_NULL
+      : page_rec_is_supremum(page_rec_get_next(rec))
+          && low_match < dtuple_get_n_fields_cmp(tuple)
+          && mach_read_from_4(page + FIL_PAGE_NEXT) != FIL_NULL;
+  } else {
+    /* A key after the last record may be on the next page, and the previous
+    page may end with records that are not less than the key. */
+    outside = page_rec_is_supremum(rec)
+      ? mach_read_from_4(page + FIL_PAGE_NEXT) != FIL_NULL
+      : page_rec_is_infimum(page_rec_get_prev(rec))
+          && mach_read_from_4(page + FIL_PAGE_PREV) != FIL_NULL;
+  }
+
+  if (outside) {
+    m_btree->leaf_page_release(block, latch_mode, mtr);
+
+    return false;
+  }
+
+  buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
+
+  block->m_check_index_page_at_flush = true;
+
+  m_low_match = low_match;
+  m_low_bytes = low_bytes;
+  m_up_match = up_match;
+  m_up_bytes = up_bytes;
+
+  return true;
+}
+
+void Btree_cursor::update_leaf_guess() noexcept {
+  const auto block = page_cur_get_block(get_page_cur());
+
+  ut_ad(page_is_leaf(block->get_frame()));
+
+  m_leaf_guess->m_block = block;
+  m_leaf_guess->m_modify_clock = buf_block_get_modify_clock(block);
+}
+
+page_no_t Btree_cursor::get_leaf_page_no(
+  const Index *index, const DTuple *tuple, Source_location loc, page_no_t *missing_page_no
+) noexcept {
+  alignas(UNIV_PAGE_SIZE) static thread_local byte copy[UNIV_PAGE_SIZE];
+
+  if (missing_page_no != nullptr) {
+    *missing_page_no = FIL_NULL;
+  }
+
+  uint64_t version;
+  const auto lock = index->get_lock();
+
+  if (!rw_lock_read_begin(lock, version)) {
+    return FIL_NULL;
+  }
+
+  mem_heap_t *heap{};
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  rec_offs_init(offsets_);
+
+  ulint height{ULINT_UNDEFINED};
+  const auto space = index->get_space_id();
+  auto page_no = index->get_page_no();
+
+  for (;;) {
+    mtr_t mtr;
+
+    mtr.start();
+
+    Buf_pool::Request req {
+      .m_rw_latch = RW_NO_LATCH,
+      .m_page_id = { space, page_no },
+      .m_mode = missing_page_no == nullptr ? BUF_GET : BUF_GET_IF_IN_POOL,
+      .m_file = loc.m_from.file_name(),
+      .m_line = loc.m_from.line(),
+      .m_mtr = &mtr
+    };
+
+    auto block = get_buf_pool()->get(req, nullptr);
+
+    if (req.m_read) {
+      index->m_counters.inc(Index::PAGE_READS);
+    }
+
+    if (block == nullptr) {
+      mtr.commit();
+
+      *missing_page_no = page_no;
+      page_no = FIL_NULL;
+      break;
+    }
+
+    memcpy(copy, block->get_frame(), UNIV_PAGE_SIZE);
+
+    mtr.commit();
+
+    if (!rw_lock_read_validate(lock, version)) {
+      page_no = FIL_NULL;
+      break;
+    }
+
+    if (height == ULINT_UNDEFINED) {
+      height = m_btree->page_get_level_low(copy);
+
+      if (height == 0) {
+        page_no = FIL_NULL;
+        break;
+      }
+    }
+
+    const auto node_ptr = node_ptr_search(index, copy, tuple, PAGE_CUR_LE, &heap);
+
+    {
+      Phy_rec record{index, node_ptr};
+
+      offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
+    }
+
+    page_no = m_btree->node_ptr_get_child_page_no(node_ptr, offsets);
+
+    if (--height == 0) {
+      break;
+    }
+  }
+
+  if (likely_null(heap)) {
+    mem_heap_free(heap);
+  }
+
+  return page_no;
+}
+
+bool Btree_cursor::search_hash(const DTuple *tuple, ulint fold, ulint mode, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept {
+  rec_t *rec;
+  auto block = srv_btr_search->guess(get_buf_pool(), m_index, fold, latch_mode, rec, mtr, loc);
+
+  if (block == nullptr) {
+    srv_btr_search->count(fold, false);
+    return false;
+  }
+
+  mem_heap_t *heap{};
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  rec_offs_init(offsets_);
+
+  const auto n_fields = dtuple_get_n_fields_cmp(tuple);
+
+  /* Returns the number of fields of the tuple that match a record. */
+  auto match = [&](const rec_t *rec, ulint &n_bytes) -> ulint {
+    ulint n_matched{};
+
+    n_bytes = 0;
+
+    {
+      Phy_rec record{m_index, rec};
+
+      offsets = record.get_col_offsets(offsets, n_fields, &heap, Current_location());
+    }
+
+    (void) cmp_dtuple_rec_with_match(m_index, tuple, rec, offsets, &n_matched, &n_bytes);
+
+    return n_matched;
+  };
+
+  ulint n_bytes{};
+  const auto found = page_rec_is_user_rec(rec) && match(rec, n_bytes) == n_fields;
+
+  if (found) {
+    /* The key is unique, the record is the last one <= tuple and the first
+    one >= tuple. Match the neighbor on the other side as the binary search
+    would, a neighbor on another page doesn't match anything. */
+    ulint n_other{};
+    ulint n_other_bytes{};
+
+    if (mode == PAGE_CUR_LE) {
+      const auto next = page_rec_get_next(rec);
+
+      if (!page_rec_is_supremum(next)) {
+        n_other = match(next, n_other_bytes);
+      }
+
+      m_low_match = n_fields;
+      m_low_bytes = n_bytes;
+      m_up_match = n_other;
+      m_up_bytes = n_other_bytes;
+
+    } else {
+      ut_ad(mode == PAGE_CUR_GE);
+
+      const auto prev = page_rec_get_prev(rec);
+
+      if (!page_rec_is_infimum(prev)) {
+        n_other = match(prev, n_other_bytes);
+      }
+
+      m_up_match = n_fields;
+      m_up_bytes = n_bytes;
+      m_low_match = n_other;
+      m_low_bytes = n_other_bytes;
+    }
+
+    page_cur_position(rec, block, get_page_cur());
+
+    m_flag = BTR_CUR_HASH;
+    m_fold = fold;
+    m_n_fields = n_fields;
+    m_n_bytes = 0;
+
+  } else {
+    /* A fold collision or the record was updated in place. */
+    m_btree->leaf_page_release(block, latch_mode, mtr);
+
+    srv_btr_search->erase(fold, block);
+
+    m_flag = BTR_CUR_HASH_FAIL;
+  }
+
+  if (heap != nullptr) {
+    mem_heap_free(heap);
+  }
+
+  srv_btr_search->count(fold, found);
+
+  return found;
+}
+
+void Btree_cursor::update_hash(const DTuple *tuple, ulint fold, ulint mode) noexcept {
+  const auto rec = page_cur_get_rec(get_page_cur());
+  const auto n_matched = mode == PAGE_CUR_LE ? m_low_match : m_up_match;
+
+  if (!page_rec_is_user_rec(rec) || n_matched < dtuple_get_n_fields_cmp(tuple)) {
+    /* The key is not in the tree, start learning again. */
+    m_index->m_n_hash_potential = 0;
+
+  } else if (m_index->m_n_hash_potential < Btr_search::BUILD_LIMIT) {
+    ++m_index->m_n_hash_potential;
+
+  } else {
+    srv_btr_search->insert(m_index, fold, page_cur_get_block(get_page_cur()), rec);
   }
 }
 
@@ -390,6 +1086,7 @@ void Btree_cursor::open_at_index_side(
 
   auto page_cursor = get_page_cur();
   m_index = index;
+  m_parent_page_no = FIL_NULL;
 
   auto space = index->get_space_id();
   auto page_no = index->get_page_no();
@@ -408,6 +1105,11 @@ void Btree_cursor::open_at_index_side(
     };
 
     auto block = get_buf_pool()->get(req, nullptr);
+
+    if (req.m_read) {
+      index->m_counters.inc(Index::PAGE_READS);
+    }
+
     auto page = block->get_frame();
 
     ut_ad(index->m_id == get_btree()->page_get_index_id(page));
@@ -468,6 +1170,10 @@ void Btree_cursor::open_at_index_side(
       offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
     }
 
+    if (height == 0) {
+      m_parent_page_no = page_no;
+    }
+
     /* Go to the child node */
     page_no = get_btree()->node_ptr_get_child_page_no(node_ptr, offsets);
   }
@@ -477,7 +1183,9 @@ void Btree_cursor::open_at_index_side(
   }
 }
 
-void Btree_cursor::open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept {
+void Btree_cursor::open_at_rnd_pos(
+  const Index *index, ulint latch_mode, mtr_t *mtr, Source_location loc, ulint *rnd_state, double *weight
+) noexcept {
   rec_t *node_ptr;
   mem_heap_t *heap{};
   ulint offsets_[REC_OFFS_NORMAL_SIZE];
@@ -499,6 +1207,10 @@ void Btree_cursor::open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *
 
   auto height = ULINT_UNDEFINED;
 
+  if (weight != nullptr) {
+    *weight = 1;
+  }
+
   for (;;) {
 
     Buf_pool::Request req {
@@ -511,6 +1223,11 @@ void Btree_cursor::open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *
     };
 
     auto block = get_buf_pool()->get(req, nullptr);
+
+    if (req.m_read) {
+      index->m_counters.inc(Index::PAGE_READS);
+    }
+
     auto page = block->get_frame();
 
     ut_ad(index->m_id == m_btree->page_get_index_id(page));
@@ -525,7 +1242,11 @@ void Btree_cursor::open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *
       latch_leaves(page, space, page_no, latch_mode, mtr);
     }
 
-    page_cur_open_on_rnd_user_rec(block, page_cursor);
+    page_cur_open_on_rnd_user_rec(block, page_cursor, rnd_state);
+
+    if (weight != nullptr) {
+      *weight *= std::max(page_get_n_recs(page), ulint(1));
+    }
 
     if (height == 0) {
 
@@ -578,7 +1299,7 @@ rec_t *Btree_cursor::insert_if_possible(const DTuple *tuple, ulint n_ext, mtr_t
   return rec;
 }
 
-inline db_err Btree_cursor::ins_lock_and_undo(ulint flags, const DTuple *entry, que_thr_t *thr, mtr_t *mtr, bool *inherit) noexcept {
+inline db_err Btree_cursor::ins_lock_and_undo(ulint flags, const DTuple *entry, que_thr_t *thr, mtr_t *mtr, bool *inherit, bool undo_in_mtr) noexcept {
   /* Check if we have to wait for a lock: enqueue an explicit lock request if yes */
 
   auto rec = get_rec();
@@ -594,7 +1315,7 @@ inline db_err Btree_cursor::ins_lock_and_undo(ulint flags, const DTuple *entry,
 
   if (index->is_clustered()) {
 
-    err = trx_undo_report_row_operation(flags, TRX_UNDO_INSERT_OP, thr, index, entry, nullptr, 0, nullptr, &roll_ptr);
+    err = trx_undo_report_row_operation(flags, TRX_UNDO_INSERT_OP, thr, index, entry, nullptr, 0, nullptr, undo_in_mtr ? mtr : nullptr, &roll_ptr);
 
     if (err != DB_SUCCESS) {
 
@@ -692,7 +1413,7 @@ db_err Btree_cursor::optimistic_insert(ulint flags, DTuple *entry, rec_t **rec,
   }
 
   /* Check locks and write to the undo log, if specified */
-  err = ins_lock_and_undo(flags, entry, thr, mtr, &inherit);
+  err = ins_lock_and_undo(flags, entry, thr, mtr, &inherit, true);
 
   if (unlikely(err != DB_SUCCESS)) {
 
@@ -744,6 +1465,8 @@ db_err Btree_cursor::optimistic_insert(ulint flags, DTuple *entry, rec_t **rec,
 
   *big_rec = big_rec_vec;
 
+  m_index->m_counters.inc(Index::OPTIMISTIC_INSERTS);
+
   return DB_SUCCESS;
 }
 
@@ -778,7 +1501,7 @@ db_err Btree_cursor::pessimistic_insert(ulint flags, DTuple *entry, rec_t **rec,
   /* Retry with a pessimistic insert. Check locks and write to undo log,
   if specified */
 
-  err = ins_lock_and_undo(flags, entry, thr, mtr, &dummy_inh);
+  err = ins_lock_and_undo(flags, entry, thr, mtr, &dummy_inh, false);
 
   if (err != DB_SUCCESS) {
 
@@ -846,6 +1569,8 @@ db_err Btree_cursor::pessimistic_insert(ulint flags, DTuple *entry, rec_t **rec,
 
   *big_rec = big_rec_vec;
 
+  m_index->m_counters.inc(Index::PESSIMISTIC_INSERTS);
+
   return DB_SUCCESS;
 }
 
@@ -855,7 +1580,8 @@ db_err Btree_cursor::upd_lock_and_undo(
   ulint cmpl_info,
   que_thr_t *thr,
   mtr_t *mtr,
-  roll_ptr_t *roll_ptr
+  roll_ptr_t *roll_ptr,
+  bool undo_in_mtr
 ) noexcept {
   ut_ad(update && thr && roll_ptr);
 
@@ -897,7 +1623,7 @@ db_err Btree_cursor::upd_lock_and_undo(
 
   /* Append the info about the update in the undo log */
 
-  err = trx_undo_report_row_operation(flags, TRX_UNDO_MODIFY_OP, thr, index, nullptr, update, cmpl_info, rec, roll_ptr);
+  err = trx_undo_report_row_operation(flags, TRX_UNDO_MODIFY_OP, thr, index, nullptr, update, cmpl_info, rec, undo_in_mtr ? mtr : nullptr, roll_ptr);
 
   return err;
 }
@@ -1015,7 +1741,7 @@ db_err Btree_cursor::update_in_place(ulint flags, const upd_t *update, ulint cmp
 #endif /* UNIV_DEBUG */
 
   /* Do lock checking and undo logging */
-  auto err = upd_lock_and_undo(flags, update, cmpl_info, thr, mtr, &roll_ptr);
+  auto err = upd_lock_and_undo(flags, update, cmpl_info, thr, mtr, &roll_ptr, true);
 
   if (unlikely(err != DB_SUCCESS)) {
 
@@ -1047,6 +1773,8 @@ db_err Btree_cursor::update_in_place(ulint flags, const upd_t *update, ulint cmp
     mem_heap_free(heap);
   }
 
+  index->m_counters.inc(Index::ROWS_UPDATED);
+
   return DB_SUCCESS;
 }
 
@@ -1153,7 +1881,7 @@ db_err Btree_cursor::optimistic_update(ulint flags, const upd_t *update, ulint c
   }
 
   /* Do lock checking and undo logging */
-  err = upd_lock_and_undo(flags, update, cmpl_info, thr, mtr, &roll_ptr);
+  err = upd_lock_and_undo(flags, update, cmpl_info, thr, mtr, &roll_ptr, true);
 
   if (err != DB_SUCCESS) {
   err_exit:
@@ -1198,6 +1926,8 @@ db_err Btree_cursor::optimistic_update(ulint flags, const upd_t *update, ulint c
 
   mem_heap_free(heap);
 
+  index->m_counters.inc(Index::ROWS_UPDATED);
+
   return DB_SUCCESS;
 }
 
@@ -1275,7 +2005,7 @@ db_err Btree_cursor::pessimistic_update(
   }
 
   /* Do lock checking and undo logging */
-  auto err = upd_lock_and_undo(flags, update, cmpl_info, thr, mtr, &roll_ptr);
+  auto err = upd_lock_and_undo(flags, update, cmpl_info, thr, mtr, &roll_ptr, false);
 
   if (err != DB_SUCCESS) {
 
@@ -1466,6 +2196,10 @@ return_after_reservations:
 
   *big_rec = big_rec_vec;
 
+  if (err == DB_SUCCESS) {
+    index->m_counters.inc(Index::ROWS_UPDATED);
+  }
+
   return err;
 }
 
@@ -1592,7 +2326,7 @@ db_err Btree_cursor::del_mark_set_clust_rec(ulint flags, bool val, que_thr_t *th
   if (err == DB_SUCCESS) {
     roll_ptr_t roll_ptr;
 
-    err = trx_undo_report_row_operation(flags, TRX_UNDO_MODIFY_OP, thr, index, nullptr, nullptr, 0, rec, &roll_ptr);
+    err = trx_undo_report_row_operation(flags, TRX_UNDO_MODIFY_OP, thr, index, nullptr, nullptr, 0, rec, mtr, &roll_ptr);
 
     if (err == DB_SUCCESS) {
       set_deleted_flag(rec, val > 0);
@@ -1604,6 +2338,10 @@ db_err Btree_cursor::del_mark_set_clust_rec(ulint flags, bool val, que_thr_t *th
       }
 
       del_mark_set_clust_rec_log(flags, rec, index, val, trx, roll_ptr, mtr);
+
+      if (val) {
+        index->m_counters.inc(Index::ROWS_DELETE_MARKED);
+      }
     }
   }
 
@@ -1678,6 +2416,10 @@ db_err Btree_cursor::del_mark_set_sec_rec(ulint flags, bool val, que_thr_t *thr,
 
   del_mark_set_sec_rec_log(rec, val, mtr);
 
+  if (val) {
+    m_index->m_counters.inc(Index::ROWS_DELETE_MARKED);
+  }
+
   return DB_SUCCESS;
 }
 
@@ -1791,6 +2533,8 @@ db_err Btree_cursor::pessimistic_delete(bool has_reserved_extents, trx_rb_ctx rb
         non-leaf level, we must mark the new leftmost node
         pointer as the predefined minimum record */
 
+        ut_ad(page_cur_change_allowed(page, index, mtr));
+
         m_btree->set_min_rec_mark(next_rec, mtr);
 
       } else {
@@ -1849,6 +2593,12 @@ void Btree_cursor::add_path_info(Paths *path, ulint height, ulint root_height) n
 }
 
 int64_t Btree_cursor::estimate_n_rows_in_range(Index *index, const DTuple *tuple1, ulint mode1, const DTuple *tuple2, ulint mode2) noexcept {
+  /* The histogram is cheaper and doesn't assume that the keys are spread
+  evenly over the pages. */
+  if (const auto n_rows = Index_histogram::estimate_n_rows_in_range(index, tuple1, mode1, tuple2, mode2); n_rows >= 0) {
+    return n_rows;
+  }
+
   Paths path1;
 
   mtr_t mtr;
@@ -1989,16 +2739,20 @@ void Btree_cursor::estimate_number_of_different_key_vals(const Index *index) noe
 
   n_diff = (int64_t *)mem_zalloc((n_cols + 1) * sizeof(int64_t));
 
+  /* The table can override the configured number of pages to sample. */
+  const uint64_t sample_pages =
+    index->m_table->m_stats.m_sample_pages > 0 ? index->m_table->m_stats.m_sample_pages : srv_config.m_stats_sample_pages;
+
   /* It makes no sense to test more pages than are contained
   in the index, thus we lower the number if it is too high */
-  if (srv_config.m_stats_sample_pages > index->m_stats.m_index_size) {
+  if (sample_pages > index->m_stats.m_index_size) {
     if (index->m_stats.m_index_size > 0) {
       n_sample_pages = index->m_stats.m_index_size;
     } else {
       n_sample_pages = 1;
     }
   } else {
-    n_sample_pages = srv_config.m_stats_sample_pages;
+    n_sample_pages = sample_pages;
   }
 
   /* We sample some pages in the index to get an estimate */
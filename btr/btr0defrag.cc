@@ -0,0 +1,134 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file btr/btr0defrag.cc
+Online defragmentation of a B-tree
+*******************************************************/
+
+#include "btr0defrag.h"
+#include "btr0btr.h"
+#include "btr0cur.h"
+#include "buf0buf.h"
+#include "data0data.h"
+#include "dict0dict.h"
+#include "fsp0fsp.h"
+#include "log0log.h"
+#include "mtr0mtr.h"
+#include "page0page.h"
+#include "rem0rec.h"
+#include "srv0srv.h"
+
+std::atomic<ulint> srv_defrag_n_pages_scanned{};
+std::atomic<ulint> srv_defrag_n_pages_freed{};
+
+Btree_defrag::Btree_defrag(Btree *btree, const Index *index) noexcept
+  : m_btree(btree),
+    m_index(index),
+    m_max_data_size(UNIV_PAGE_SIZE * srv_config.m_fill_factor / 100) {}
+
+bool Btree_defrag::merge(Buf_block *block, Buf_block *next_block, mtr_t *mtr) noexcept {
+  const auto page = block->get_frame();
+  const auto next_page = next_block->get_frame();
+  const auto data_size = page_get_data_size(next_page);
+
+  if (page_get_data_size(page) + data_size > m_max_data_size ||
+      data_size > page_get_max_insert_size_after_reorganize(page, page_get_n_recs(next_page))) {
+
+    return false;
+  }
+
+  Btree_cursor cursor(m_btree->m_fsp, m_btree);
+
+  cursor.position(m_index, page_get_infimum_rec(next_page), next_block);
+
+  /* The left neighbour of the page is block, compress() merges into it. */
+  return m_btree->compress(&cursor, mtr);
+}
+
+void Btree_defrag::run() noexcept {
+  DTuple *key{};
+  auto heap = mem_heap_create(256);
+  const auto space = m_index->get_space_id();
+  const auto n_uniq = m_index->get_n_unique_in_tree();
+
+  for (;;) {
+    mtr_t mtr;
+    bool at_end{};
+    Btree_cursor cursor(m_btree->m_fsp, m_btree);
+
+    m_btree->m_fsp->m_log->free_check();
+
+    mtr.start();
+
+    if (key == nullptr) {
+      cursor.open_at_index_side(nullptr, true, m_index, BTR_MODIFY_TREE, 0, &mtr, Current_location());
+    } else {
+      cursor.search_to_nth_level(nullptr, m_index, 0, key, PAGE_CUR_LE, BTR_MODIFY_TREE, &mtr, Current_location());
+    }
+
+    auto block = cursor.get_block();
+
+    for (ulint i = 0; i < N_PAGES_PER_MTR; ++i) {
+      const auto next_page_no = m_btree->page_get_next(block->get_frame(), &mtr);
+
+      ++m_n_pages_scanned;
+      srv_defrag_n_pages_scanned.fetch_add(1, std::memory_order_relaxed);
+
+      if (next_page_no == FIL_NULL) {
+        at_end = true;
+        break;
+      }
+
+      auto next_block = m_btree->block_get(space, next_page_no, RW_X_LATCH, &mtr);
+
+      if (merge(block, next_block, &mtr)) {
+        ++m_n_pages_freed;
+        srv_defrag_n_pages_freed.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        block = next_block;
+      }
+    }
+
+    if (!at_end) {
+      /* Resume from the first key of the page once the tree is latched
+      again, the page may have been merged or split by then. */
+      const auto rec = page_rec_get_next(page_get_infimum_rec(block->get_frame()));
+
+      mem_heap_empty(heap);
+
+      key = dtuple_create(heap, n_uniq);
+      m_index->copy_types(key, n_uniq);
+
+      rec_copy_prefix_to_dtuple(key, rec, m_index, n_uniq, heap);
+
+      dtuple_set_info_bits(key, 0);
+    }
+
+    mtr.commit();
+
+    if (at_end) {
+      break;
+    }
+  }
+
+  mem_heap_free(heap);
+
+  log_info(std::format(
+    "Defragmented index {} of table {}: {} leaf pages visited, {} freed",
+    m_index->m_name, m_index->m_table->m_name, m_n_pages_scanned, m_n_pages_freed
+  ));
+}
@@ -24,21 +24,32 @@ Created 2/23/1996 Heikki Tuuri
 
 #include "btr0pcur.h"
 #include "btr0types.h"
+#include "buf0rea.h"
+#include "srv0srv.h"
 #include "trx0trx.h"
 
+/** Number of consecutive moves to the next leaf page after which the cursor
+is taken to be in a range scan and the following leaf pages are prefetched. */
+constexpr ulint BTR_PCUR_PREFETCH_THRESHOLD = 2;
+
+/** Maximum number of leaf pages that are prefetched ahead of the cursor,
+the upper bound of leaf_prefetch_pages. */
+constexpr ulint BTR_PCUR_PREFETCH_MAX = 64;
+
 Btree_pcursor::Btree_pcursor(FSP *fsp, Btree *btree) noexcept : m_btr_cur(fsp, btree) {
   m_btr_cur.m_index = nullptr;
   init(0);
 }
 
 Btree_pcursor::~Btree_pcursor() noexcept {
+  set_fixed_block(nullptr);
+
   if (m_old_rec_buf != nullptr) {
     mem_free(m_old_rec_buf);
 
     m_old_rec_buf = nullptr;
   }
 
-
   m_old_rec = nullptr;
   m_old_n_fields = 0;
   m_latch_mode = BTR_NO_LATCHES;
@@ -47,11 +58,47 @@ Btree_pcursor::~Btree_pcursor() noexcept {
   m_pos_state = Btr_pcur_positioned::UNSET;
 }
 
+void Btree_pcursor::set_fixed_block(Buf_block *block) noexcept {
+  if (!m_keep_block_fixed) {
+    block = nullptr;
+  }
+
+  if (block == m_fixed_block) {
+    return;
+  }
+
+  if (m_fixed_block != nullptr) {
+    mutex_enter(&m_fixed_block->m_mutex);
+    m_fixed_block->fix_dec();
+    mutex_exit(&m_fixed_block->m_mutex);
+  }
+
+  if (block != nullptr) {
+    ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
+
+    mutex_enter(&block->m_mutex);
+    buf_block_buf_fix_inc(block, __FILE__, __LINE__);
+    mutex_exit(&block->m_mutex);
+  }
+
+  m_fixed_block = block;
+}
+
+void Btree_pcursor::set_keep_block_fixed(bool keep) noexcept {
+  m_keep_block_fixed = keep;
+
+  if (!keep) {
+    set_fixed_block(nullptr);
+  }
+}
+
 void Btree_pcursor::store_position(mtr_t *mtr) noexcept {
   ut_a(m_pos_state == Btr_pcur_positioned::IS_POSITIONED);
   ut_ad(m_latch_mode != BTR_NO_LATCHES);
 
   auto block = get_block();
+
+  set_fixed_block(block);
   auto index = m_btr_cur.m_index;
   auto page_cursor = get_page_cur();
 
@@ -111,8 +158,16 @@ void Btree_pcursor::copy_stored_position(Btree_pcursor *src) noexcept {
     mem_free(m_old_rec_buf);
   }
 
+  /* The fixed block belongs to the source cursor. */
+  set_fixed_block(nullptr);
+
+  const auto keep_block_fixed = m_keep_block_fixed;
+
   *this = *src;
 
+  m_keep_block_fixed = keep_block_fixed;
+  m_fixed_block = nullptr;
+
   if (src->m_old_rec_buf != nullptr) {
 
     m_old_rec_buf = static_cast<byte*>(mem_alloc(src->m_buf_size));
@@ -172,6 +227,8 @@ bool Btree_pcursor::restore_position(ulint latch_mode, mtr_t *mtr, Source_locati
     };
 
     if (likely(srv_buf_pool->try_get(req))) {
+      srv_pcur_restore_hits.inc();
+
       m_pos_state = Btr_pcur_positioned::IS_POSITIONED;
 
       buf_block_dbg_add_level(IF_SYNC_DEBUG(get_block(), SYNC_TREE_NODE));
@@ -203,6 +260,8 @@ bool Btree_pcursor::restore_position(ulint latch_mode, mtr_t *mtr, Source_locati
         return false;
       }
     }
+
+    srv_pcur_restore_misses.inc();
   }
 
   /* If optimistic restoration did not succeed, open the cursor anew */
@@ -248,6 +307,8 @@ bool Btree_pcursor::restore_position(ulint latch_mode, mtr_t *mtr, Source_locati
     m_modify_clock = buf_block_get_modify_clock(m_block_when_stored);
     m_old_stored = true;
 
+    set_fixed_block(m_block_when_stored);
+
     ret = true;
 
   } else {
@@ -291,7 +352,7 @@ void Btree_pcursor::move_to_next_page(mtr_t *mtr) noexcept {
 
   ut_ad(next_page_no != FIL_NULL);
 
-  auto next_block = m_btr_cur.m_btree->block_get(space_id, next_page_no, m_latch_mode, mtr);
+  auto next_block = m_btr_cur.m_btree->block_get(space_id, next_page_no, m_latch_mode, mtr, m_btr_cur.get_index());
   auto next_page = next_block->get_frame();
 
 #ifdef UNIV_BTR_DEBUG
@@ -305,6 +366,123 @@ void Btree_pcursor::move_to_next_page(mtr_t *mtr) noexcept {
   page_cur_set_before_first(next_block, get_page_cur());
 
   page_check_dir(next_page);
+
+  prefetch_next_pages(next_block, mtr);
+}
+
+void Btree_pcursor::prefetch_next_pages(const Buf_block *block, mtr_t *mtr) noexcept {
+  const auto n_pages = std::min(ulint(srv_config.m_leaf_prefetch_pages), BTR_PCUR_PREFETCH_MAX);
+
+  if (m_n_prefetched > 0) {
+    --m_n_prefetched;
+  }
+
+  /* Refill the window when half of it was consumed. */
+  if (n_pages == 0 || ++m_n_next_pages < BTR_PCUR_PREFETCH_THRESHOLD || m_n_prefetched > n_pages / 2) {
+    return;
+  }
+
+  auto index = m_btr_cur.m_index;
+  auto btree = m_btr_cur.m_btree;
+  const auto space = index->get_space_id();
+
+  /* The pages are read after the last one prefetched, or after this page
+  if the window is empty. */
+  const auto last_page_no = m_n_prefetched > 0 ? m_prefetch_page_no : block->get_page_no();
+
+  if (m_n_next_pages == BTR_PCUR_PREFETCH_THRESHOLD) {
+    m_prefetch_parent_page_no = m_btr_cur.m_parent_page_no;
+  }
+
+  ulint n{};
+  bool found{};
+  mem_heap_t *heap{};
+  page_no_t page_nos[BTR_PCUR_PREFETCH_MAX];
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  rec_offs_init(offsets_);
+
+  /* The leaf page may have moved to the right neighbour of its parent
+  since the parent was found, look at two parents at most. We hold leaf
+  latches, a parent is latched only if it's in the buffer pool and not
+  latched by another thread: waiting for it could deadlock with a split. */
+  auto parent_page_no = m_prefetch_parent_page_no;
+
+  for (ulint i = 0; i < 2 && parent_page_no != FIL_NULL && n < n_pages; ++i) {
+    Buf_pool::Request req {
+      .m_page_id = { space, parent_page_no },
+      .m_file = __FILE__,
+      .m_line = __LINE__,
+      .m_mtr = mtr
+    };
+
+    const auto savepoint = mtr->set_savepoint();
+    auto parent = m_btr_cur.get_buf_pool()->try_get_by_page_id(req);
+
+    if (parent == nullptr) {
+      break;
+    }
+
+    const auto page = parent->get_frame();
+
+    /* The page number is a hint, the page may since have been freed
+    or reused. */
+    if (btree->page_get_index_id(page) != index->m_id || btree->page_get_level(page, mtr) != 1) {
+      mtr->release_block_at_savepoint(savepoint, const_cast<Buf_block *>(parent));
+      parent_page_no = FIL_NULL;
+      break;
+    }
+
+    auto rec = page_rec_get_next_const(page_get_infimum_rec(page));
+
+    for (; !page_rec_is_supremum(rec) && n < n_pages; rec = page_rec_get_next_const(rec)) {
+      {
+        Phy_rec record{index, rec};
+
+        offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
+      }
+
+      const auto child_page_no = btree->node_ptr_get_child_page_no(rec, offsets);
+
+      if (found) {
+        page_nos[n++] = child_page_no;
+        m_prefetch_parent_page_no = parent_page_no;
+      } else if (child_page_no == last_page_no) {
+        found = true;
+      }
+    }
+
+    parent_page_no = btree->page_get_next(page, mtr);
+
+    mtr->release_block_at_savepoint(savepoint, const_cast<Buf_block *>(parent));
+  }
+
+  if (likely_null(heap)) {
+    mem_heap_free(heap);
+  }
+
+  if (!found) {
+    /* The parents are unknown or busy, follow the leaf chain instead,
+    one page ahead. The next time start from the parent that wasn't
+    looked at, if any. */
+    const auto next_page_no = btree->page_get_next(block->get_frame(), mtr);
+
+    m_n_prefetched = 0;
+    m_prefetch_parent_page_no = parent_page_no;
+
+    if (next_page_no == FIL_NULL) {
+      return;
+    }
+
+    page_nos[n++] = next_page_no;
+  }
+
+  if (n > 0) {
+    m_n_prefetched += n;
+    m_prefetch_page_no = page_nos[n - 1];
+
+    (void) buf_read_ahead_pages(space, page_nos, n);
+  }
 }
 
 void Btree_pcursor::move_backward_from_page(mtr_t *mtr) noexcept {
@@ -0,0 +1,250 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file btr/btr0sea.cc
+The adaptive hash index
+*******************************************************/
+
+#include "btr0sea.h"
+#include "btr0types.h"
+#include "buf0buf.h"
+#include "data0data.h"
+#include "dict0dict.h"
+#include "mtr0mtr.h"
+#include "page0cur.h"
+#include "page0page.h"
+#include "rem0rec.h"
+#include "srv0srv.h"
+#include "ut0rnd.h"
+
+#include <algorithm>
+#include <mutex>
+
+Btr_search *srv_btr_search{};
+
+Btr_search::Btr_search(ulint n_parts, ulint max_entries) noexcept
+  : m_enabled(srv_config.m_adaptive_hash_index),
+    m_max_part_entries(std::max(MIN_PART_ENTRIES, max_entries / n_parts)),
+    m_parts(n_parts) {}
+
+Btr_search *Btr_search::create(ulint n_parts, ulint max_entries) noexcept {
+  ut_a(n_parts > 0);
+
+  auto ptr = ut_new(sizeof(Btr_search));
+  return new (ptr) Btr_search(n_parts, max_entries);
+}
+
+void Btr_search::destroy(Btr_search *&search) noexcept {
+  call_destructor(search);
+  ut_delete(search);
+  search = nullptr;
+}
+
+Btr_search::Partition &Btr_search::get_partition(ulint fold) noexcept {
+  return m_parts[ut_hash_ulint(fold, m_parts.size())];
+}
+
+void Btr_search::set_enabled(bool enabled) noexcept {
+  m_enabled.store(enabled, std::memory_order_relaxed);
+
+  if (!enabled) {
+    /* insert() checks the flag under the partition latch, no entry can
+    be added after the partition was emptied. */
+    clear();
+  }
+}
+
+bool Btr_search::is_candidate(const Index *index, const DTuple *tuple, ulint mode, ulint latch_mode) const noexcept {
+  /* Only a full unique key identifies a single record, the record found
+  is then the right position for both PAGE_CUR_LE and PAGE_CUR_GE. */
+  return is_enabled() && (latch_mode == BTR_SEARCH_LEAF || latch_mode == BTR_MODIFY_LEAF) &&
+         (mode == PAGE_CUR_LE || mode == PAGE_CUR_GE) && dtuple_get_n_fields_cmp(tuple) == index->get_n_unique_in_tree();
+}
+
+Buf_block *Btr_search::guess(Buf_pool *buf_pool, const Index *index, ulint fold, ulint latch_mode, rec_t *&rec, mtr_t *mtr, Source_location loc) noexcept {
+  auto &part = get_partition(fold);
+
+  /* Keep the partition latched until the block is buffer-fixed, see clear(). */
+  std::shared_lock<std::shared_mutex> latch(part.m_latch);
+
+  const auto it = part.m_entries.find(fold);
+
+  if (it == part.m_entries.end() || it->second.m_index_id != index->m_id) {
+    return nullptr;
+  }
+
+  const auto &entry = it->second;
+
+  Buf_pool::Request req {
+    .m_rw_latch = latch_mode,
+    .m_guess = entry.m_block,
+    .m_modify_clock = entry.m_modify_clock,
+    .m_file = loc.m_from.file_name(),
+    .m_line = loc.m_from.line(),
+    .m_mtr = mtr
+  };
+
+  /* Fails if the block was evicted, the page freed or a record of it
+  deleted or moved since the entry was added. */
+  if (!buf_pool->try_get(req)) {
+    return nullptr;
+  }
+
+  auto block = entry.m_block;
+  const auto offset = entry.m_offset;
+
+  latch.unlock();
+
+  buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
+
+  block->m_check_index_page_at_flush = true;
+
+  auto page = block->get_frame();
+
+  ut_ad(page_is_leaf(page));
+  ut_ad(mach_read_from_8(page + PAGE_HEADER + PAGE_INDEX_ID) == index->m_id);
+
+  rec = page + offset;
+
+  return block;
+}
+
+void Btr_search::insert(const Index *index, ulint fold, Buf_block *block, const rec_t *rec) noexcept {
+  ut_ad(page_rec_is_user_rec(rec));
+  ut_ad(page_is_leaf(block->get_frame()));
+
+  auto &part = get_partition(fold);
+
+  std::lock_guard<std::shared_mutex> latch(part.m_latch);
+
+  if (!is_enabled()) {
+    return;
+  }
+
+  if (part.m_entries.size() >= m_max_part_entries && !part.m_entries.contains(fold)) {
+    part.m_entries.erase(part.m_entries.begin());
+  }
+
+  /* The flag is only reset with the page x-latched, we have it latched. */
+  block->m_is_hashed = true;
+
+  part.m_entries[fold] = Entry{
+    .m_index_id = index->m_id,
+    .m_block = block,
+    .m_modify_clock = buf_block_get_modify_clock(block),
+    .m_offset = page_offset(rec)
+  };
+}
+
+void Btr_search::erase(ulint fold, const Buf_block *block) noexcept {
+  auto &part = get_partition(fold);
+
+  std::lock_guard<std::shared_mutex> latch(part.m_latch);
+
+  const auto it = part.m_entries.find(fold);
+
+  if (it != part.m_entries.end() && it->second.m_block == block) {
+    part.m_entries.erase(it);
+  }
+}
+
+void Btr_search::drop_page_hash(const Index *index, Buf_block *block) noexcept {
+  if (!block->m_is_hashed) {
+    return;
+  }
+
+  block->m_is_hashed = false;
+
+  const auto page = block->get_frame();
+
+  if (!page_is_leaf(page)) {
+    return;
+  }
+
+  mem_heap_t *heap{};
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  rec_offs_init(offsets_);
+
+  const auto n_fields = index->get_n_unique_in_tree();
+
+  /* An entry that was added for a key that folds differently from the
+  stored record, e.g., of a case insensitive column, is not found here.
+  It stays until it is replaced, it can't be used because the caller
+  changes the modify clock of the block. */
+  for (auto rec = page_rec_get_next(page_get_infimum_rec(page)); !page_rec_is_supremum(rec); rec = page_rec_get_next(rec)) {
+    {
+      Phy_rec record{index, rec};
+
+      offsets = record.get_col_offsets(offsets, n_fields, &heap, Current_location());
+    }
+
+    erase(rec_fold(rec, offsets, n_fields, 0, index->m_id), block);
+  }
+
+  if (heap != nullptr) {
+    mem_heap_free(heap);
+  }
+}
+
+void Btr_search::drop_index(uint64_t index_id) noexcept {
+  for (auto &part : m_parts) {
+    std::lock_guard<std::shared_mutex> latch(part.m_latch);
+
+    std::erase_if(part.m_entries, [index_id](const auto &it) { return it.second.m_index_id == index_id; });
+  }
+}
+
+void Btr_search::clear() noexcept {
+  for (auto &part : m_parts) {
+    std::lock_guard<std::shared_mutex> latch(part.m_latch);
+
+    part.m_entries.clear();
+  }
+}
+
+ulint Btr_search::get_n_hits() const noexcept {
+  ulint n{};
+
+  for (const auto &part : m_parts) {
+    n += part.m_n_hits.load(std::memory_order_relaxed);
+  }
+
+  return n;
+}
+
+ulint Btr_search::get_n_misses() const noexcept {
+  ulint n{};
+
+  for (const auto &part : m_parts) {
+    n += part.m_n_misses.load(std::memory_order_relaxed);
+  }
+
+  return n;
+}
+
+ulint Btr_search::get_n_entries() const noexcept {
+  ulint n{};
+
+  for (const auto &part : m_parts) {
+    std::shared_lock<std::shared_mutex> latch(part.m_latch);
+
+    n += part.m_entries.size();
+  }
+
+  return n;
+}
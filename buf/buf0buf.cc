@@ -32,6 +32,7 @@ Created 11/5/1995 Heikki Tuuri
 #include "buf0buf.h"
 
 #include "btr0btr.h"
+#include "btr0sea.h"
 #include "buf0flu.h"
 #include "buf0lru.h"
 #include "buf0rea.h"
@@ -42,8 +43,14 @@ Created 11/5/1995 Heikki Tuuri
 #include "log0recv.h"
 #include "mem0mem.h"
 #include "os0proc.h"
+#include "page0cur.h"
 #include "srv0srv.h"
+#include "srv0task.h"
 #include "trx0undo.h"
+#include "ut0wait.h"
+
+#include <algorithm>
+#include <thread>
 
 /*
                 IMPLEMENTATION OF THE BUFFER POOL
@@ -215,6 +222,18 @@ constexpr int WAIT_FOR_READ = 5000;
 /** Number of attemtps made to read in a page in the buffer pool */
 constexpr ulint BUF_PAGE_READ_MAX_RETRIES = 100;
 
+/** Minimum size of a buffer pool instance in bytes. */
+constexpr uint64_t BUF_POOL_INSTANCE_MIN_SIZE = 16 * 1024 * 1024;
+
+/** How long Buf_pool_instance::resize() waits for the blocks of the chunks it
+is removing to be released before it gives up shrinking, in milliseconds. */
+constexpr ulint WITHDRAW_TIMEOUT_MS = 60 * 1000;
+
+/** @return the object of a page read wait, see ut::Wait_type. */
+static uint64_t page_object(const Page_id &page_id) noexcept {
+  return (uint64_t(page_id.m_space_id) << 32) | page_id.m_page_no;
+}
+
 /** Checksum function. */
 crc32::Checksum crc32::checksum = {};
 
@@ -233,9 +252,16 @@ struct buf_chunk_t {
 
   /** Array of buffer control blocks */
   Buf_block *blocks{};
+
+  /** The frame of blocks[0], the frames of the chunk are contiguous. Kept here
+  so that block_align() does not have to touch the memory of the chunk. */
+  byte *frames{};
+
+  /** The huge pages and the NUMA policy that back mem. */
+  os_mem_placement_t placement{};
 };
 
-bool Buf_pool::peek_if_too_old(const Buf_page *bpage) {
+bool Buf_pool_instance::peek_if_too_old(const Buf_page *bpage) {
   if (unlikely(m_freed_page_clock == 0)) {
     /* If eviction has not started yet, do not update the statistics or move blocks
     in the LRU list.  This is either the warm-up phase or an in-memory workload. */
@@ -259,7 +285,14 @@ bool Buf_pool::peek_if_too_old(const Buf_page *bpage) {
   }
 }
 
-Buf_block *Buf_pool::block_alloc() {
+bool Buf_pool_instance::peek_if_young(const Buf_page *bpage) const {
+  /* FIXME: bpage->m_freed_page_clock is 31 bits */
+  return (m_freed_page_clock & ((1UL << 31) - 1)) <
+         ((ulint)bpage->m_freed_page_clock +
+          (m_curr_size * (Buf_LRU::OLD_RATIO_DIV - m_LRU->get_old_ratio()) / (Buf_LRU::OLD_RATIO_DIV * 4)));
+}
+
+Buf_block *Buf_pool_instance::block_alloc() {
   auto block = m_LRU->get_free_block();
 
   buf_block_set_state(block, BUF_BLOCK_MEMORY);
@@ -267,7 +300,7 @@ Buf_block *Buf_pool::block_alloc() {
   return block;
 }
 
-void Buf_pool::block_free(Buf_block *block) {
+void Buf_pool_instance::block_free(Buf_block *block) {
 
   mutex_acquire();
 
@@ -282,16 +315,12 @@ void Buf_pool::block_free(Buf_block *block) {
   mutex_release();
 }
 
-void Buf_pool::release(Buf_block *block, ulint rw_latch, mtr_t *mtr) {
+void Buf_pool_instance::release(Buf_block *block, ulint rw_latch, mtr_t *mtr) {
   ut_a(block->get_state() == BUF_BLOCK_FILE_PAGE);
   ut_a(block->m_page.m_buf_fix_count > 0);
 
   if (rw_latch == RW_X_LATCH && mtr->m_modifications) {
-    mutex_acquire();
-
     m_flusher->note_modification(block, mtr);
-
-    mutex_release();
   }
 
   mutex_enter(&block->m_mutex);
@@ -340,12 +369,18 @@ bool Buf_pool::is_corrupted(const byte *read_buf) {
   disabled. Otherwise, skip checksum calculation and return false */
 
   if (likely(srv_config.m_use_checksums)) {
-    auto checksum = mach_read_from_4(read_buf + FIL_PAGE_SPACE_OR_CHKSUM);
-
-    if (checksum != 0 &&
-        checksum != BUF_NO_CHECKSUM_MAGIC &&
-	      checksum != buf_page_data_calc_checksum(read_buf)) {
-
+    const auto checksum = mach_read_from_4(read_buf + FIL_PAGE_SPACE_OR_CHKSUM);
+    const auto trailer = mach_read_from_4(read_buf + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM);
+
+    if (checksum == 0 || checksum == BUF_NO_CHECKSUM_MAGIC) {
+      return false;
+    } else if (checksum == trailer) {
+      return checksum != buf_page_calc_crc32c(read_buf);
+    } else if (trailer == BUF_NO_CHECKSUM_MAGIC) {
+      /* Legacy format. Builds without SSE4.2 stored crc32::NO_CHECKSUM
+      instead of the checksum. */
+      return checksum != crc32::NO_CHECKSUM && checksum != buf_page_data_calc_checksum(read_buf);
+    } else {
       return true;
     }
   }
@@ -360,7 +395,7 @@ void buf_page_print(const byte *read_buf, ulint) {
   ib_logger(ib_stream, "  Page dump in ascii and hex (%lu bytes):\n", (ulong)size);
   ib_logger(ib_stream, "\nEnd of page dump\n");
 
-  auto checksum =  buf_page_data_calc_checksum(read_buf);
+  auto checksum = buf_page_calc_crc32c(read_buf);
 
   ib_logger(
     ib_stream,
@@ -420,17 +455,87 @@ void buf_page_print(const byte *read_buf, ulint) {
   }
 }
 
-void Buf_pool::block_init(Buf_block *block, byte *frame) {
+/**
+ * Reports a page that failed the checks of Buf_pool::is_corrupted() and stops
+ * the server unless force_recovery allows ignoring corrupt pages.
+ *
+ * @param[in] bpage             Page that was read.
+ * @param[in] frame             Frame of the page.
+ */
+static void buf_page_report_corruption(const Buf_page *bpage, const byte *frame) {
+  ib_logger(
+    ib_stream,
+    "Database page corruption on disk or a failed file read of page %lu."
+    " You may have to recover from a backup.",
+    (ulong)bpage->m_page_no
+  );
+
+  buf_page_print(frame, 0);
+
+  ib_logger(
+    ib_stream,
+    "Database page corruption on disk or a failed file read of page %lu."
+    " You may have to recoverfrom a backup.",
+    (ulong)bpage->m_page_no
+  );
+  ib_logger(
+    ib_stream,
+    "It is also possible that your operating system has corrupted its own file cache"
+    " and rebooting your computer removes the error. If the corrupt page is an index page"
+    " you can also try to fix the corruption by dumping, dropping, and reimporting"
+    " the corrupt table. You can use CHECK TABLE to scan your table for corruption."
+    " You can also use the force recovery flags."
+  );
+
+  if (srv_config.m_force_recovery < IB_RECOVERY_IGNORE_CORRUPT) {
+    log_fatal("Ending processing because of a corrupt database page.");
+  }
+}
+
+void Buf_pool_instance::verify_on_access(Buf_block *block) {
+  /* Dirty read, the flag is set before the read is posted and is only
+  cleared below, after the check. */
+  if (likely(!block->m_page.m_verify_on_access)) {
+    return;
+  }
+
+  /* The check is done under the block mutex, so that the threads that
+  access the page concurrently do not use it before it is checked. */
+  mutex_enter(&block->m_mutex);
+
+  if (block->m_page.m_verify_on_access) {
+    ut_ad(buf_block_get_io_fix(block) == BUF_IO_NONE);
+
+    if (Buf_pool::is_corrupted(block->m_frame)) {
+      buf_page_report_corruption(&block->m_page, block->m_frame);
+    }
+
+    block->m_page.m_verify_on_access = false;
+  }
+
+  mutex_exit(&block->m_mutex);
+}
+
+void Buf_pool_instance::block_init(Buf_block *block, byte *frame) {
   UNIV_MEM_DESC(frame, UNIV_PAGE_SIZE, block);
 
   block->m_frame = frame;
 
+  block->m_page.m_buf_pool_index = m_instance_no;
+  block->m_page.m_hash_next = nullptr;
   block->m_page.m_state = BUF_BLOCK_NOT_USED;
   block->m_page.m_buf_fix_count = 0;
   block->m_page.m_io_fix = BUF_IO_NONE;
+  block->m_page.m_verify_on_access = false;
+  block->m_page.m_protected = false;
+  block->m_page.m_write_run_next = nullptr;
 
   block->m_modify_clock = 0;
 
+  block->m_is_hashed = false;
+
+  new (&block->m_dir_cache) std::atomic<Page_dir_cache *>(nullptr);
+
   ut_d(block->m_page.m_file_page_was_freed = false);
 
   block->m_check_index_page_at_flush = false;
@@ -450,7 +555,7 @@ void Buf_pool::block_init(Buf_block *block, byte *frame) {
 #endif /* UNIV_SYNC_DEBUG */
 }
 
-buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
+buf_chunk_t *Buf_pool_instance::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
 
   /* Round down to a multiple of page size, although it already should be. */
   mem_size = ut_2pow_round(mem_size, UNIV_PAGE_SIZE);
@@ -459,7 +564,15 @@ buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
   mem_size += ut_2pow_round((mem_size / UNIV_PAGE_SIZE) * sizeof(Buf_block) + (UNIV_PAGE_SIZE - 1), UNIV_PAGE_SIZE);
 
   chunk->mem_size = mem_size;
-  chunk->mem = os_mem_alloc_large(&chunk->mem_size);
+
+  chunk->placement.m_huge_pages = os_huge_pages_t(srv_config.m_buf_pool_huge_pages);
+  chunk->placement.m_numa = os_numa_policy_t(srv_config.m_buf_pool_numa);
+
+  /* With OS_NUMA_BIND all the chunks of an instance are on the same node,
+  the instances are spread round-robin over the nodes. */
+  chunk->placement.m_numa_node = m_instance_no;
+
+  chunk->mem = os_mem_alloc_large(&chunk->mem_size, &chunk->placement);
 
   if (unlikely(chunk->mem == nullptr)) {
 
@@ -469,9 +582,9 @@ buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
   /* Allocate the block descriptors from the start of the memory block. */
   chunk->blocks = (Buf_block *)chunk->mem;
 
-  /* Align a pointer to the first frame.  Note that when os_large_page_size is
-  smaller than UNIV_PAGE_SIZE, we may allocate one fewer block than requested.
-  When it is bigger, we may allocate more blocks than requested. */
+  /* Align a pointer to the first frame.  Note that when the page size of the
+  mapping is smaller than UNIV_PAGE_SIZE, we may allocate one fewer block than
+  requested. When it is bigger, we may allocate more blocks than requested. */
 
   auto frame = (byte *)ut_align((byte *)chunk->mem, UNIV_PAGE_SIZE);
 
@@ -489,6 +602,8 @@ buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
     chunk->size = size;
   }
 
+  chunk->frames = frame;
+
   /* Init block structs and assign frames for them. Then we assign the frames
   to the first blocks (we already mapped the memory above). */
 
@@ -498,19 +613,70 @@ buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
 
     block_init(block, frame);
 
-    /* Add the block to the free list */
-    UT_LIST_ADD_LAST(m_free_list, &block->m_page);
-    ut_d(block->m_page.m_in_free_list = true);
-
     ++block;
 
     frame += UNIV_PAGE_SIZE;
   }
 
+  /* Take the page faults of the frames here, where the instances are opened
+  in parallel, rather than in the first reads into them. */
+  if (srv_config.m_buf_pool_prefault) {
+    memset(chunk->frames, 0, chunk->size * UNIV_PAGE_SIZE);
+  }
+
+  /* The frames are read and written with fixed buffers, the kernel then
+  does not pin their pages on every request. */
+  if (srv_aio != nullptr) {
+    srv_aio->register_buffer(chunk->frames, chunk->size * UNIV_PAGE_SIZE);
+  }
+
   return chunk;
 }
 
-const Buf_block *Buf_pool::chunk_not_freed(buf_chunk_t *chunk) {
+void Buf_pool_instance::chunk_add_free_blocks(buf_chunk_t *chunk) {
+  ut_ad(mutex_own(&m_mutex));
+
+  auto block = chunk->blocks;
+
+  for (ulint i = chunk->size; i--; ++block) {
+    UT_LIST_ADD_LAST(m_free_list, &block->m_page);
+    ut_d(block->m_page.m_in_free_list = true);
+  }
+}
+
+void Buf_pool_instance::chunk_free(buf_chunk_t *chunk) {
+  ut_ad(mutex_own(&m_mutex));
+
+  auto block = chunk->blocks;
+
+  for (ulint i = chunk->size; i--; ++block) {
+    ut_a(block->get_state() == BUF_BLOCK_NOT_USED);
+    ut_ad(!block->m_page.m_in_free_list);
+    ut_ad(!block->m_page.m_in_LRU_list);
+    ut_ad(!block->m_page.m_in_flush_list);
+
+    mutex_free(&block->m_mutex);
+    rw_lock_free(&block->m_rw_lock);
+
+    auto dir_cache = block->m_dir_cache.load(std::memory_order_relaxed);
+
+    Page_dir_cache::destroy(dir_cache);
+
+#ifdef UNIV_SYNC_DEBUG
+    rw_lock_free(&block->m_debug_latch);
+#endif /* UNIV_SYNC_DEBUG */
+  }
+
+  if (srv_aio != nullptr) {
+    srv_aio->unregister_buffer(chunk->frames, chunk->size * UNIV_PAGE_SIZE);
+  }
+
+  os_mem_free_large(chunk->mem, chunk->mem_size);
+
+  *chunk = buf_chunk_t{};
+}
+
+const Buf_block *Buf_pool_instance::chunk_not_freed(buf_chunk_t *chunk) {
   ut_ad(mutex_own(&m_mutex));
 
   auto block = chunk->blocks;
@@ -541,11 +707,22 @@ const Buf_block *Buf_pool::chunk_not_freed(buf_chunk_t *chunk) {
   return nullptr;
 }
 
-Buf_pool::Buf_pool()
-  : m_LRU(new (std::nothrow) Buf_LRU(this)),
+Buf_page_hash::Buf_page_hash(ulint n_cells) {
+  const auto n_cells_per_partition = std::max(ulint(1), (n_cells + N_PARTITIONS - 1) / N_PARTITIONS);
+
+  m_n_cells = n_cells_per_partition * N_PARTITIONS;
+
+  for (auto &partition : m_partitions) {
+    partition.m_cells.assign(n_cells_per_partition, nullptr);
+  }
+}
+
+Buf_pool_instance::Buf_pool_instance(ulint instance_no)
+  : m_instance_no(instance_no),
+    m_LRU(new (std::nothrow) Buf_LRU(this)),
     m_flusher(new (std::nothrow) Buf_flush(this)) {}
 
-bool Buf_pool::open(uint64_t pool_size) {
+bool Buf_pool_instance::open(uint64_t pool_size, uint64_t chunk_size) {
 
   if (m_LRU == nullptr || m_flusher == nullptr) {
     return false;
@@ -555,30 +732,36 @@ bool Buf_pool::open(uint64_t pool_size) {
   ------------------------------- */
   mutex_create(&m_mutex, IF_DEBUG("buffer_pool",) IF_SYNC_DEBUG(SYNC_BUF_POOL,) Current_location());
 
-  mutex_acquire();
+  mutex_create(&m_flush_list_mutex, IF_DEBUG("flush_list",) IF_SYNC_DEBUG(SYNC_BUF_FLUSH_LIST,) Current_location());
 
-  auto chunk = reinterpret_cast<buf_chunk_t *>(mem_alloc(sizeof(buf_chunk_t)));
+  mutex_acquire();
 
-  m_n_chunks = 1;
-  m_chunks = chunk;
+  m_chunks = reinterpret_cast<buf_chunk_t *>(mem_zalloc(MAX_CHUNKS * sizeof(buf_chunk_t)));
+  m_chunk_size = chunk_size;
 
   UT_LIST_INIT(m_LRU_list);
   UT_LIST_INIT(m_free_list);
   UT_LIST_INIT(m_flush_list);
+  UT_LIST_INIT(m_withdraw_list);
 
-  if (!chunk_init(chunk, pool_size)) {
-    mem_free(chunk);
-    mutex_release();
-    return false;
-  }
+  for (auto size = pool_size; size > 0; size -= std::min(size, chunk_size)) {
+    const auto n_chunks = m_n_chunks.load();
+    auto chunk = &m_chunks[n_chunks];
 
-  srv_config.m_buf_pool_old_size = pool_size;
+    if (n_chunks == MAX_CHUNKS || chunk_init(chunk, std::min(size, chunk_size)) == nullptr) {
+      mutex_release();
+      return false;
+    }
+
+    chunk_add_free_blocks(chunk);
 
-  m_curr_size = chunk->size;
+    m_curr_size += chunk->size;
+    m_n_chunks.store(n_chunks + 1);
+  }
 
-  srv_config.m_buf_pool_curr_size = m_curr_size * UNIV_PAGE_SIZE;
+  m_n_chunks_new = m_n_chunks;
 
-  m_page_hash = new page_hash_t{};
+  m_page_hash = new Buf_page_hash(2 * m_curr_size);
 
   m_last_printout_time = ut_time();
 
@@ -599,15 +782,10 @@ bool Buf_pool::open(uint64_t pool_size) {
 
   mutex_release();
 
-  /* 4. Initialize the buddy allocator fields */
-  /* All fields are initialized by mem_zalloc(). */
-
-  crc32::checksum = crc32::init();
-
   return true;
 }
 
-void Buf_pool::close() {
+void Buf_pool_instance::close() {
   delete m_page_hash;
 
   for (ulint i = BUF_FLUSH_LRU; i < BUF_FLUSH_N_TYPES; i++) {
@@ -616,7 +794,7 @@ void Buf_pool::close() {
   }
 }
 
-Buf_pool::~Buf_pool() {
+Buf_pool_instance::~Buf_pool_instance() {
   auto chunks = m_chunks;
   auto chunk = chunks + m_n_chunks;
 
@@ -627,11 +805,263 @@ Buf_pool::~Buf_pool() {
 
   m_n_chunks = 0;
 
-  mem_free(m_chunks);
+  if (m_chunks != nullptr) {
+    mem_free(m_chunks);
+  }
 }
 
 
-void Buf_pool::make_young(Buf_page *bpage) {
+bool Buf_pool_instance::will_be_withdrawn(const Buf_page *bpage) const {
+  ut_ad(mutex_own(&m_mutex));
+
+  const auto block = reinterpret_cast<const Buf_block *>(bpage);
+  const auto chunk_end = m_chunks + m_n_chunks.load();
+
+  for (auto chunk = m_chunks + m_n_chunks_new; chunk < chunk_end; ++chunk) {
+    if (block >= chunk->blocks && block < chunk->blocks + chunk->size) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Buf_pool_instance::grow(uint64_t pool_size) {
+  ut_ad(!mutex_own(&m_mutex));
+
+  auto size = pool_size - get_curr_size();
+
+  while (size > 0) {
+    const auto n_chunks = m_n_chunks.load();
+
+    if (n_chunks == MAX_CHUNKS) {
+      log_err(std::format("Buffer pool instance {} already has the maximum of {} chunks", m_instance_no, MAX_CHUNKS));
+      return false;
+    }
+
+    auto chunk = &m_chunks[n_chunks];
+
+    /* The chunk is not visible to the other threads yet, allocate it without
+    holding the buffer pool mutex. */
+    if (chunk_init(chunk, std::min(size, m_chunk_size)) == nullptr) {
+      log_err(std::format("Cannot allocate a chunk of {} bytes for buffer pool instance {}", std::min(size, m_chunk_size), m_instance_no));
+      return false;
+    }
+
+    size -= std::min(size, m_chunk_size);
+
+    mutex_acquire();
+
+    chunk_add_free_blocks(chunk);
+
+    m_curr_size += chunk->size;
+    m_n_chunks_new = n_chunks + 1;
+    m_n_chunks.store(n_chunks + 1, std::memory_order_release);
+
+    mutex_release();
+  }
+
+  return true;
+}
+
+bool Buf_pool_instance::withdraw_blocks() {
+  ut_ad(!mutex_own(&m_mutex));
+
+  ulint n_withdrawn{};
+  auto last_progress_time = ut_time_ms();
+
+  for (;;) {
+    ulint n_to_withdraw{};
+    ulint n_in_LRU{};
+
+    mutex_acquire();
+
+    const auto chunk_end = m_chunks + m_n_chunks.load();
+
+    for (auto chunk = m_chunks + m_n_chunks_new; chunk < chunk_end; ++chunk) {
+      n_to_withdraw += chunk->size;
+    }
+
+    /* 1. Take the free blocks. The blocks that are freed from now on go to
+    m_withdraw_list directly, see Buf_LRU::block_free_non_file_page(). */
+    for (auto bpage = UT_LIST_GET_FIRST(m_free_list); bpage != nullptr;) {
+      auto next = UT_LIST_GET_NEXT(m_list, bpage);
+
+      if (will_be_withdrawn(bpage)) {
+        ut_ad(bpage->m_in_free_list);
+        ut_d(bpage->m_in_free_list = false);
+
+        UT_LIST_REMOVE(m_free_list, bpage);
+        UT_LIST_ADD_LAST(m_withdraw_list, bpage);
+      }
+
+      bpage = next;
+    }
+
+    if (UT_LIST_GET_LEN(m_withdraw_list) == n_to_withdraw) {
+      mutex_release();
+      return true;
+    }
+
+    if (UT_LIST_GET_LEN(m_withdraw_list) > n_withdrawn) {
+      n_withdrawn = UT_LIST_GET_LEN(m_withdraw_list);
+      last_progress_time = ut_time_ms();
+    }
+
+    /* 2. Move the file pages to the end of the LRU list, so that the LRU flush
+    and eviction below pick them before any other page. Each page is visited
+    once, the pages moved are appended after the end of the scan. */
+    auto bpage = UT_LIST_GET_FIRST(m_LRU_list);
+
+    for (auto n = UT_LIST_GET_LEN(m_LRU_list); n > 0 && bpage != nullptr; --n) {
+      auto next = UT_LIST_GET_NEXT(m_LRU_list, bpage);
+
+      if (will_be_withdrawn(bpage)) {
+        m_LRU->make_block(bpage);
+        ++n_in_LRU;
+      }
+
+      bpage = next;
+    }
+
+    mutex_release();
+
+    if (ut_time_ms() - last_progress_time > WITHDRAW_TIMEOUT_MS) {
+      log_warn(std::format(
+        "Buffer pool instance {}: gave up withdrawing blocks, {} of {} withdrawn, the rest are in use",
+        m_instance_no, n_withdrawn, n_to_withdraw));
+
+      return false;
+    }
+
+    /* 3. Flush the dirty pages, then evict the clean pages so that their
+    blocks end up in m_withdraw_list. Pages that are buffer-fixed and blocks
+    that are used for other purposes are retried in the next round. */
+    ulint n_freed{};
+
+    if (n_in_LRU > 0) {
+      if (m_flusher->batch(srv_dblwr, BUF_FLUSH_LRU, n_in_LRU, 0) != ULINT_UNDEFINED) {
+        m_flusher->wait_batch_end(BUF_FLUSH_LRU);
+      }
+
+      mutex_acquire();
+
+      /* Freeing a page releases the buffer pool mutex, restart from the end
+      of the LRU list after every page freed. */
+      for (bool freed{true}; freed;) {
+        freed = false;
+
+        auto bpage = UT_LIST_GET_LAST(m_LRU_list);
+
+        for (ulint i{}; !freed && bpage != nullptr && i < n_in_LRU; ++i) {
+          auto prev = UT_LIST_GET_PREV(m_LRU_list, bpage);
+
+          if (will_be_withdrawn(bpage)) {
+            auto block_mutex = buf_page_get_mutex(bpage);
+
+            mutex_enter(block_mutex);
+
+            freed = m_LRU->free_block(bpage, nullptr) == Buf_LRU::Block_status::FREED;
+
+            mutex_exit(block_mutex);
+          }
+
+          bpage = prev;
+        }
+
+        if (freed) {
+          ++n_freed;
+        }
+      }
+
+      mutex_release();
+    }
+
+    if (n_freed == 0) {
+      os_thread_sleep(10000);
+    }
+  }
+}
+
+bool Buf_pool_instance::shrink(uint64_t pool_size) {
+  ut_ad(!mutex_own(&m_mutex));
+
+  mutex_acquire();
+
+  const auto n_chunks = m_n_chunks.load();
+  auto n_chunks_new = n_chunks;
+  auto size = get_curr_size();
+
+  /* The first chunk is never removed. */
+  while (n_chunks_new > 1 && size - m_chunks[n_chunks_new - 1].size * UNIV_PAGE_SIZE >= pool_size) {
+    size -= m_chunks[n_chunks_new - 1].size * UNIV_PAGE_SIZE;
+    --n_chunks_new;
+  }
+
+  if (n_chunks_new == n_chunks) {
+    mutex_release();
+    return true;
+  }
+
+  m_n_chunks_new = n_chunks_new;
+
+  mutex_release();
+
+  const auto withdrawn = withdraw_blocks();
+
+  if (withdrawn && srv_btr_search != nullptr) {
+    /* The adaptive hash index points to blocks, forget them before the
+    memory of the chunks is freed. */
+    srv_btr_search->clear();
+  }
+
+  mutex_acquire();
+
+  if (!withdrawn) {
+    /* Give the blocks back, the instance keeps its size. */
+    m_n_chunks_new = n_chunks;
+
+    while (auto bpage = UT_LIST_GET_FIRST(m_withdraw_list)) {
+      UT_LIST_REMOVE(m_withdraw_list, bpage);
+      UT_LIST_ADD_LAST(m_free_list, bpage);
+      ut_d(bpage->m_in_free_list = true);
+    }
+
+    mutex_release();
+
+    return false;
+  }
+
+  while (auto bpage = UT_LIST_GET_FIRST(m_withdraw_list)) {
+    UT_LIST_REMOVE(m_withdraw_list, bpage);
+  }
+
+  /* Unpublish the chunks before their memory is released. */
+  m_n_chunks.store(n_chunks_new, std::memory_order_release);
+
+  for (auto i = n_chunks_new; i < n_chunks; ++i) {
+    m_curr_size -= m_chunks[i].size;
+    chunk_free(&m_chunks[i]);
+  }
+
+  mutex_release();
+
+  return true;
+}
+
+bool Buf_pool_instance::resize(uint64_t pool_size) {
+  pool_size = ut_2pow_round(pool_size, UNIV_PAGE_SIZE);
+
+  if (pool_size > get_curr_size()) {
+    return grow(pool_size);
+  } else if (pool_size < get_curr_size()) {
+    return shrink(pool_size);
+  } else {
+    return true;
+  }
+}
+
+void Buf_pool_instance::make_young(Buf_page *bpage) {
   mutex_acquire();
 
   ut_a(bpage->in_file());
@@ -641,11 +1071,28 @@ void Buf_pool::make_young(Buf_page *bpage) {
   mutex_release();
 }
 
-void Buf_pool::set_accessed_make_young(Buf_page *bpage, unsigned access_time) {
+void Buf_pool_instance::set_accessed_make_young(Buf_page *bpage, unsigned access_time, bool scan) {
   ut_ad(!mutex_own(&m_mutex));
   ut_a(bpage->in_file());
 
-  if (peek_if_too_old(bpage)) {
+  if (scan) {
+
+    if (access_time == 0) {
+      const ulint time_ms = ut_time_ms();
+
+      mutex_acquire();
+
+      buf_page_set_accessed(bpage, time_ms);
+
+      /* Recycle the page before the ones that were read in by the other threads. */
+      m_LRU->make_block(bpage);
+
+      ++m_stat.n_pages_not_made_young;
+
+      mutex_release();
+    }
+
+  } else if (peek_if_too_old(bpage)) {
     mutex_acquire();
 
     m_LRU->make_block_young(bpage);
@@ -663,7 +1110,7 @@ void Buf_pool::set_accessed_make_young(Buf_page *bpage, unsigned access_time) {
   }
 }
 
-void Buf_pool::check_index_page_at_flush(space_id_t space, page_no_t page_no) {
+void Buf_pool_instance::check_index_page_at_flush(space_id_t space, page_no_t page_no) {
   mutex_acquire();
 
   auto block = hash_get_block(space, page_no);
@@ -675,13 +1122,14 @@ void Buf_pool::check_index_page_at_flush(space_id_t space, page_no_t page_no) {
   mutex_release();
 }
 
-Buf_block *Buf_pool::block_align(const byte *ptr) {
-  ulint i = m_n_chunks;;
+Buf_block *Buf_pool_instance::block_align(const byte *ptr) {
+  /* No mutex: the chunk descriptors never move and resize() publishes a new
+  chunk only after it has been initialized. A chunk that is being removed
+  has no pages left in it, so ptr cannot point into it. */
+  ulint i = m_n_chunks.load(std::memory_order_acquire);
 
-  /* TODO: protect Buf_pool::m_chunks with a mutex (it will
-  currently remain constant after Buf_pool::open()) */
   for (auto chunk = m_chunks; i--; ++chunk) {
-    lint offs = ptr - chunk->blocks->m_frame;
+    lint offs = ptr - chunk->frames;
 
     if (unlikely(offs < 0)) {
 
@@ -710,7 +1158,7 @@ Buf_block *Buf_pool::block_align(const byte *ptr) {
         file pages may have been freed and reused.  Do not complain. */
           break;
         case BUF_BLOCK_REMOVE_HASH:
-          /* Buf_pool::m_LRU->block_remove_hashed_page() will overwrite the FIL_PAGE_OFFSET and
+          /* Buf_pool_instance::m_LRU->block_remove_hashed_page() will overwrite the FIL_PAGE_OFFSET and
           FIL_PAGE_SPACE_ID with 0xff and set the state to BUF_BLOCK_REMOVE_HASH. */
           ut_ad(page_get_space_id(page_align(ptr)) == 0xffffffff);
           ut_ad(page_get_page_no(page_align(ptr)) == 0xffffffff);
@@ -728,17 +1176,15 @@ Buf_block *Buf_pool::block_align(const byte *ptr) {
     }
   }
 
-  /* The block should always be found. */
-  ut_error;
+  /* The block belongs to another instance. */
   return nullptr;
 }
 
-bool Buf_pool::pointer_is_block_field(const void *ptr) {
+bool Buf_pool_instance::pointer_is_block_field(const void *ptr) {
   auto chunk = m_chunks;
-  const auto chunk_end = chunk + m_n_chunks;
+  const auto chunk_end = chunk + m_n_chunks.load(std::memory_order_acquire);
 
-  /* TODO: protect Buf_pool::m_chunks with a mutex (it will
-  currently remain constant after Buf_pool::open()) */
+  /* No mutex, see block_align(). */
   while (chunk < chunk_end) {
     if (ptr >= (void *)chunk->blocks && ptr < (void *)(chunk->blocks + chunk->size)) {
 
@@ -751,7 +1197,7 @@ bool Buf_pool::pointer_is_block_field(const void *ptr) {
   return false;
 }
 
-Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
+Buf_block *Buf_pool_instance::get(Request &req, Buf_block *guess) {
   ulint n_retries{};
   Buf_block *block{};
   const auto &page_id{req.m_page_id};
@@ -767,34 +1213,31 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
   mtr_memo_type_t fix_type;
 
   for (;;) {
-    mutex_acquire();
+    /* Returns with the block mutex held, the buffer pool mutex is not needed
+    because the buffer fix below prevents the eviction of the block. */
+    block = hash_lock_block(page_id.m_space_id, page_id.m_page_no, guess);
 
-    block = guess;
+    if (block == nullptr) {
+      guess = nullptr;
 
-    if (block != nullptr) {
-      if (page_id.m_page_no != block->m_page.m_page_no ||
-	        page_id.m_space_id != block->m_page.m_space ||
-	        block->get_state() != BUF_BLOCK_FILE_PAGE) {
+      if (req.m_mode == BUF_GET_IF_IN_POOL) {
+        return nullptr;
+      }
 
-        block = guess = nullptr;
+      ut::Wait_timer read_wait(ut::Wait_type::PAGE_READ, page_object(page_id), req.m_file, req.m_line);
 
-      } else {
-        ut_ad(block->m_page.m_in_page_hash);
-      }
-    }
+      read_wait.start();
 
-    if (block == nullptr) {
-      block = hash_get_block(page_id.m_space_id, page_id.m_page_no);
-    }
+      const auto success = buf_read_page(page_id.m_space_id, page_id.m_page_no);
 
-    if (block == nullptr) {
-      mutex_release();
+      read_wait.stop();
 
-      if (req.m_mode == BUF_GET_IF_IN_POOL) {
-        return nullptr;
-      }
+      if (success) {
 
-      if (buf_read_page(page_id.m_space_id, page_id.m_page_no)) {
+        req.m_read = true;
+
+        /* The other pages of the area may be needed soon too. */
+        buf_read_ahead_random(this, page_id.m_space_id, page_id.m_page_no);
 
         n_retries = 0;
 
@@ -822,43 +1265,36 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
     }
   }
 
+  ut_ad(mutex_own(&block->m_mutex));
+  ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
+
   auto must_read = buf_block_get_io_fix(block) == BUF_IO_READ;
 
-  if (must_read && req.m_mode == BUF_GET_IF_IN_POOL) {
-    /* The page is only being read to buffer */
-    mutex_release();
+  /* Another thread reads the page, the wait for it ends with the latch. */
+  ut::Wait_timer read_wait(ut::Wait_type::PAGE_READ, page_object(page_id), req.m_file, req.m_line);
 
-    return nullptr;
+  if (must_read) {
+    read_wait.start();
   }
 
-  switch (block->get_state()) {
-    case BUF_BLOCK_FILE_PAGE:
-      break;
+  if (must_read && req.m_mode == BUF_GET_IF_IN_POOL) {
+    /* The page is only being read to buffer */
+    mutex_exit(&block->m_mutex);
 
-    case BUF_BLOCK_NOT_USED:
-    case BUF_BLOCK_READY_FOR_USE:
-    case BUF_BLOCK_MEMORY:
-    case BUF_BLOCK_REMOVE_HASH:
-      ut_error;
-      break;
+    return nullptr;
   }
 
-  ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
-
-  mutex_enter(&block->m_mutex);
-
   UNIV_MEM_ASSERT_RW(&block->m_page, sizeof(block->m_page));
 
   buf_block_buf_fix_inc(block, req.m_file, req.m_line);
 
   mutex_exit(&block->m_mutex);
 
-  /* Check if this is the first access to the page */
+  /* Check if this is the first access to the page. We do a dirty read on
+  purpose, to avoid mutex contention. */
   auto access_time = buf_page_is_accessed(&block->m_page);
 
-  mutex_release();
-
-  set_accessed_make_young(&block->m_page, access_time);
+  set_accessed_make_young(&block->m_page, access_time, req.m_mtr->m_scan);
 
   ut_ad(!block->m_page.m_file_page_was_freed);
 
@@ -905,8 +1341,13 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
       break;
   }
 
+  read_wait.stop();
+
   req.m_mtr->memo_push(block, fix_type);
 
+  /* The read, if any, has completed by now. */
+  verify_on_access(block);
+
   if (access_time == 0) {
     /* In the case of a first access, try to apply linear read-ahead */
 
@@ -916,7 +1357,7 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
   return block;
 }
 
-bool Buf_pool::try_get(Request& req) {
+bool Buf_pool_instance::try_get(Request& req) {
   ut_ad(req.m_guess != nullptr);
   ut_ad(req.m_mtr != nullptr);
   ut_ad(req.m_mtr->m_state == MTR_ACTIVE);
@@ -941,7 +1382,7 @@ bool Buf_pool::try_get(Request& req) {
 
   const auto access_time = buf_page_is_accessed(&req.m_guess->m_page);
 
-  set_accessed_make_young(&req.m_guess->m_page, access_time);
+  set_accessed_make_young(&req.m_guess->m_page, access_time, req.m_mtr->m_scan);
 
   bool success;
   mtr_memo_type_t fix_type;
@@ -996,6 +1437,8 @@ bool Buf_pool::try_get(Request& req) {
 
     req.m_mtr->memo_push(req.m_guess, fix_type);
 
+    verify_on_access(req.m_guess);
+
     ut_ad(++m_dbg_counter % 5771 || validate());
     ut_ad(req.m_guess->m_page.m_buf_fix_count > 0);
     ut_ad(req.m_guess->get_state() == BUF_BLOCK_FILE_PAGE);
@@ -1013,7 +1456,7 @@ bool Buf_pool::try_get(Request& req) {
   }
 }
 
-bool Buf_pool::try_get_known_nowait(Request& req) {
+bool Buf_pool_instance::try_get_known_nowait(Request& req) {
   ut_ad(req.m_mtr != nullptr);
   ut_ad(req.m_mtr->m_state == MTR_ACTIVE);
   ut_ad(req.m_rw_latch == RW_S_LATCH || req.m_rw_latch == RW_X_LATCH);
@@ -1038,7 +1481,7 @@ bool Buf_pool::try_get_known_nowait(Request& req) {
 
   mutex_exit(&req.m_guess->m_mutex);
 
-  if (req.m_mode == BUF_MAKE_YOUNG && peek_if_too_old(&req.m_guess->m_page)) {
+  if (req.m_mode == BUF_MAKE_YOUNG && !req.m_mtr->m_scan && peek_if_too_old(&req.m_guess->m_page)) {
 
     mutex_acquire();
 
@@ -1088,6 +1531,8 @@ bool Buf_pool::try_get_known_nowait(Request& req) {
 
     req.m_mtr->memo_push(req.m_guess, fix_type);
 
+    verify_on_access(req.m_guess);
+
     ut_ad(++m_dbg_counter % 5771 || validate());
     ut_ad(req.m_guess->m_page.m_buf_fix_count > 0);
     ut_ad(req.m_guess->get_state() == BUF_BLOCK_FILE_PAGE);
@@ -1099,27 +1544,19 @@ bool Buf_pool::try_get_known_nowait(Request& req) {
   }
 }
 
-const Buf_block *Buf_pool::try_get_by_page_id(Request& req) {
+const Buf_block *Buf_pool_instance::try_get_by_page_id(Request& req) {
   ut_ad(req.m_mtr != nullptr);
   ut_ad(req.m_mtr->m_state == MTR_ACTIVE);
 
   const auto &page_id{req.m_page_id};
 
-  mutex_acquire();
-
-  auto block = hash_get_block(page_id.m_space_id, page_id.m_page_no);
+  auto block = hash_lock_block(page_id.m_space_id, page_id.m_page_no, nullptr);
 
   if (block == nullptr) {
 
-    mutex_release();
-
     return nullptr;
   }
 
-  mutex_enter(&block->m_mutex);
-
-  mutex_release();
-
   ut_ad(block->get_space() == page_id.m_space_id);
   ut_ad(block->get_page_no() == page_id.m_page_no);
   ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
@@ -1154,6 +1591,8 @@ const Buf_block *Buf_pool::try_get_by_page_id(Request& req) {
 
   req.m_mtr->memo_push(block, fix_type);
 
+  verify_on_access(block);
+
   ut_ad(++m_dbg_counter % 5771 || validate());
   ut_ad(block->m_page.m_buf_fix_count > 0);
   ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
@@ -1166,19 +1605,22 @@ const Buf_block *Buf_pool::try_get_by_page_id(Request& req) {
   return block;
 }
 
-void Buf_pool::page_init_low(Buf_page *bpage) {
+void Buf_pool_instance::page_init_low(Buf_page *bpage) {
   bpage->m_flush_type = BUF_FLUSH_LRU;
   bpage->m_io_fix = BUF_IO_NONE;
   bpage->m_buf_fix_count = 0;
   bpage->m_freed_page_clock = 0;
   bpage->m_access_time = 0;
+  bpage->m_verify_on_access = false;
+  bpage->m_protected = false;
+  bpage->m_write_run_next = nullptr;
   bpage->m_newest_modification = 0;
   bpage->m_oldest_modification = 0;
 
   ut_d(bpage->m_file_page_was_freed = false);
 }
 
-void Buf_pool::page_init(space_id_t space, page_no_t page_no, Buf_block *block) {
+void Buf_pool_instance::page_init(space_id_t space, page_no_t page_no, Buf_block *block, bool is_temp) {
   ut_ad(mutex_own(&m_mutex));
   ut_ad(mutex_own(&(block->m_mutex)));
   ut_a(block->get_state() != BUF_BLOCK_FILE_PAGE);
@@ -1223,17 +1665,22 @@ void Buf_pool::page_init(space_id_t space, page_no_t page_no, Buf_block *block)
 
   page_init_low(&block->m_page);
 
+  block->m_page.m_is_temp = is_temp;
+
   ut_ad(!block->m_page.m_in_page_hash);
   ut_d(block->m_page.m_in_page_hash = true);
 
-  auto it = m_page_hash->emplace(Page_id(space, page_no), &block->m_page);
-  ut_a(it.second);
+  m_page_hash->insert(&block->m_page);
 }
 
-Buf_page *Buf_pool::init_for_read(db_err *err, space_id_t space, page_no_t page_no, int64_t tablespace_version) {
+Buf_page *Buf_pool_instance::init_for_read(db_err *err, space_id_t space, page_no_t page_no, int64_t tablespace_version) {
   Buf_page *bpage{};
   auto block = m_LRU->get_free_block();
 
+  /* Looked up before the buffer pool mutex is taken, it is the same for
+  all the pages of the space. */
+  const auto is_temp = srv_fil->space_is_temp(space);
+
   *err = DB_SUCCESS;
 
   mutex_acquire();
@@ -1269,7 +1716,7 @@ Buf_page *Buf_pool::init_for_read(db_err *err, space_id_t space, page_no_t page_
 
     mutex_enter(&block->m_mutex);
 
-    page_init(space, page_no, block);
+    page_init(space, page_no, block, is_temp);
 
     m_LRU->add_block(bpage, true /* to old blocks */);
 
@@ -1289,13 +1736,14 @@ Buf_page *Buf_pool::init_for_read(db_err *err, space_id_t space, page_no_t page_
   return bpage;
 }
 
-Buf_block *Buf_pool::create(space_id_t space, page_no_t page_no, mtr_t *mtr) {
+Buf_block *Buf_pool_instance::create(space_id_t space, page_no_t page_no, mtr_t *mtr) {
   auto time_ms = ut_time_ms();
 
   ut_ad(mtr != nullptr);
   ut_ad(mtr->m_state == MTR_ACTIVE);
 
   auto free_block = m_LRU->get_free_block();
+  const auto is_temp = srv_fil->space_is_temp(space);
 
   mutex_acquire();
 
@@ -1325,7 +1773,7 @@ Buf_block *Buf_pool::create(space_id_t space, page_no_t page_no, mtr_t *mtr) {
 
   mutex_enter(&block->m_mutex);
 
-  page_init(space, page_no, block);
+  page_init(space, page_no, block, is_temp);
 
   /* The block must be put to the LRU list */
   m_LRU->add_block(&block->m_page, false);
@@ -1346,7 +1794,7 @@ Buf_block *Buf_pool::create(space_id_t space, page_no_t page_no, mtr_t *mtr) {
   such can exist if the page belonged to an index which was dropped */
 
   /* Flush pages from the end of the LRU list if necessary */
-  m_flusher->free_margin(srv_dblwr);
+  m_flusher->request_free_margin(srv_dblwr);
 
   auto frame = block->m_frame;
 
@@ -1367,7 +1815,7 @@ Buf_block *Buf_pool::create(space_id_t space, page_no_t page_no, mtr_t *mtr) {
   return block;
 }
 
-void Buf_pool::io_complete(Buf_page *bpage) {
+void Buf_pool_instance::io_complete(Buf_page *bpage) {
   ut_a(bpage->in_file());
 
   /* We do not need protect io_fix here by mutex to read
@@ -1383,6 +1831,9 @@ void Buf_pool::io_complete(Buf_page *bpage) {
 
     auto frame = reinterpret_cast<Buf_block *>(bpage)->m_frame;
 
+    /* The buffer pool only holds uncompressed frames. */
+    Fil::decompress_page(frame);
+
     /* If this page is not uninitialized and not in the
     doublewrite buffer, then the page number and space id
     should be the same as in block. */
@@ -1414,37 +1865,16 @@ void Buf_pool::io_complete(Buf_page *bpage) {
       );
     }
 
-    /* From version 3.23.38 up we store the page checksum
-    to the 4 first bytes of the page end lsn field */
-
-    if (is_corrupted(frame)) {
-      ib_logger(
-        ib_stream,
-        "Database page corruption on disk or a failed file read of page %lu."
-        " You may have to recover from a backup.",
-        (ulong)bpage->m_page_no
-      );
-
-      buf_page_print(frame, 0);
-
-      ib_logger(
-        ib_stream,
-        "Database page corruption on disk or a failed file read of page %lu."
-        " You may have to recoverfrom a backup.",
-        (ulong)bpage->m_page_no
-      );
-      ib_logger(
-        ib_stream,
-        "It is also possible that your operating system has corrupted its own file cache"
-        " and rebooting your computer removes the error. If the corrupt page is an index page"
-        " you can also try to fix the corruption by dumping, dropping, and reimporting"
-        " the corrupt table. You can use CHECK TABLE to scan your table for corruption."
-        " You can also use the force recovery flags."
-      );
+    /* The log is applied to the page below, it must be checked first. */
+    if (recv_recovery_on) {
+      bpage->m_verify_on_access = false;
+    }
 
-      if (srv_config.m_force_recovery < IB_RECOVERY_IGNORE_CORRUPT) {
-        log_fatal("Ending processing because of a corrupt database page.");
-      }
+    /* A read-ahead page is checked by the first thread that accesses it,
+    see verify_on_access(), this keeps the checksum off the IO completion
+    path that the waiting readers depend on. */
+    if (!bpage->m_verify_on_access && Buf_pool::is_corrupted(frame)) {
+      buf_page_report_corruption(bpage, frame);
     }
 
     if (recv_recovery_on) {
@@ -1494,7 +1924,7 @@ void Buf_pool::io_complete(Buf_page *bpage) {
   mutex_release();
 }
 
-void Buf_pool::invalidate() {
+void Buf_pool_instance::invalidate() {
   mutex_acquire();
 
   for (auto i = ulint(BUF_FLUSH_LRU); i < ulint(BUF_FLUSH_N_TYPES); ++i) {
@@ -1542,7 +1972,7 @@ void Buf_pool::invalidate() {
 }
 
 #if defined UNIV_DEBUG
-bool Buf_pool::validate() {
+bool Buf_pool_instance::validate() {
   ulint n_single_flush = 0;
   ulint n_LRU_flush = 0;
   ulint n_list_flush = 0;
@@ -1626,14 +2056,19 @@ bool Buf_pool::validate() {
 
   ut_a(UT_LIST_GET_LEN(m_LRU_list) == n_lru);
 
-  if (UT_LIST_GET_LEN(m_free_list) != n_free) {
+  if (UT_LIST_GET_LEN(m_free_list) + UT_LIST_GET_LEN(m_withdraw_list) != n_free) {
 
-    ib_logger(ib_stream, "Free list len %lu, free blocks %lu\n", (ulong)UT_LIST_GET_LEN(m_free_list), (ulong)n_free);
+    ib_logger(ib_stream, "Free list len %lu, withdrawn %lu, free blocks %lu\n", (ulong)UT_LIST_GET_LEN(m_free_list),
+              (ulong)UT_LIST_GET_LEN(m_withdraw_list), (ulong)n_free);
 
     ut_error;
   }
 
-  ut_a(UT_LIST_GET_LEN(m_flush_list) == n_flush);
+  /* Pages are dirtied without the buffer pool mutex, but they are removed
+  from the flush list only with it: the list can only have grown. */
+  flush_list_mutex_acquire();
+  ut_a(UT_LIST_GET_LEN(m_flush_list) >= n_flush);
+  flush_list_mutex_release();
 
   ut_a(m_n_flush[BUF_FLUSH_SINGLE_PAGE] == n_single_flush);
   ut_a(m_n_flush[BUF_FLUSH_LIST] == n_list_flush);
@@ -1647,7 +2082,7 @@ bool Buf_pool::validate() {
   return true;
 }
 
-void Buf_pool::print() {
+void Buf_pool_instance::print() {
   uint64_t id;
   Index *index;
 
@@ -1743,7 +2178,7 @@ void Buf_pool::print() {
   ut_a(validate());
 }
 
-ulint Buf_pool::get_latched_pages_number() {
+ulint Buf_pool_instance::get_latched_pages_number() {
   ulint fixed_pages_number{};
 
   mutex_acquire();
@@ -1777,13 +2212,22 @@ ulint Buf_pool::get_latched_pages_number() {
 
 #endif /* UNIV_DEBUG */
 
-ulint Buf_pool::get_n_pending_ios() {
+ulint Buf_pool_instance::get_n_pending_ios() {
   return
     m_n_pend_reads + m_n_flush[BUF_FLUSH_LRU] + m_n_flush[BUF_FLUSH_LIST] +
     m_n_flush[BUF_FLUSH_SINGLE_PAGE];
 }
 
-ulint Buf_pool::get_modified_ratio_pct() {
+ulint Buf_pool_instance::get_numa_node() const noexcept {
+  /* All the chunks of an instance are bound to the same node, see chunk_init(). */
+  if (m_n_chunks.load(std::memory_order_relaxed) == 0 || m_chunks[0].placement.m_numa != OS_NUMA_BIND) {
+    return ULINT_UNDEFINED;
+  }
+
+  return m_chunks[0].placement.m_numa_node;
+}
+
+ulint Buf_pool_instance::get_modified_ratio_pct() {
   mutex_acquire();
 
   auto ratio = (100 * UT_LIST_GET_LEN(m_flush_list)) / (1 + UT_LIST_GET_LEN(m_LRU_list) + UT_LIST_GET_LEN(m_free_list));
@@ -1795,7 +2239,7 @@ ulint Buf_pool::get_modified_ratio_pct() {
   return ratio;
 }
 
-void Buf_pool::print_io(ib_stream_t ib_stream) {
+void Buf_pool_instance::print_io(ib_stream_t ib_stream) {
   time_t current_time;
   double time_elapsed;
   ulint n_gets_diff;
@@ -1883,12 +2327,12 @@ void Buf_pool::print_io(ib_stream_t ib_stream) {
   mutex_release();
 }
 
-void Buf_pool::refresh_io_stats() {
+void Buf_pool_instance::refresh_io_stats() {
   m_last_printout_time = time(nullptr);
   m_old_stat = m_stat;
 }
 
-bool Buf_pool::all_freed() {
+bool Buf_pool_instance::all_freed() {
   mutex_acquire();
 
   auto chunk = m_chunks;
@@ -1908,7 +2352,7 @@ bool Buf_pool::all_freed() {
   return true;
 }
 
-bool Buf_pool::is_io_pending() {
+bool Buf_pool_instance::is_io_pending() {
   mutex_acquire();
 
   auto ret = m_n_pend_reads + m_n_flush[BUF_FLUSH_LRU] + m_n_flush[BUF_FLUSH_LIST] + m_n_flush[BUF_FLUSH_SINGLE_PAGE] > 0;
@@ -1918,7 +2362,7 @@ bool Buf_pool::is_io_pending() {
   return ret;
 }
 
-ulint Buf_pool::get_free_list_len() {
+ulint Buf_pool_instance::get_free_list_len() {
   mutex_acquire();
 
   const auto len = UT_LIST_GET_LEN(m_free_list);
@@ -1928,8 +2372,137 @@ ulint Buf_pool::get_free_list_len() {
   return len;
 }
 
+void Buf_pool_instance::collect_index_stats(Buf_index_stats_map &stats, uint32_t now) noexcept {
+  for (ulint i = 0;; ++i) {
+    for (ulint offs = 0;; offs += INDEX_STATS_BATCH) {
+      mutex_acquire();
+
+      /* Chunks may have been removed by a resize while the mutex was released. */
+      if (i >= m_n_chunks.load(std::memory_order_relaxed)) {
+        mutex_release();
+        return;
+      }
+
+      const auto chunk = &m_chunks[i];
+
+      if (offs >= chunk->size) {
+        mutex_release();
+        break;
+      }
+
+      const auto end = std::min(chunk->size, offs + INDEX_STATS_BATCH);
+
+      for (auto block = &chunk->blocks[offs]; block < &chunk->blocks[end]; ++block) {
+        const auto bpage = &block->m_page;
+
+        /* The frame of a page that is being read in is not valid yet. */
+        if (block->get_state() != BUF_BLOCK_FILE_PAGE || buf_page_get_io_fix(bpage) == BUF_IO_READ) {
+          continue;
+        }
+
+        const auto frame = block->get_frame();
+        const auto index_id = srv_fil->page_get_type(frame) == FIL_PAGE_TYPE_INDEX ? mach_read_from_8(frame + PAGE_HEADER + PAGE_INDEX_ID) : 0;
+        auto &index_stats = stats[{bpage->get_space(), index_id}];
+
+        index_stats.m_space_id = bpage->get_space();
+        index_stats.m_index_id = index_id;
+
+        ++index_stats.m_n_pages;
+
+        if (bpage->m_oldest_modification != 0) {
+          ++index_stats.m_n_dirty;
+        }
+
+        if (buf_page_is_old(bpage)) {
+          ++index_stats.m_n_old;
+        }
+
+        const auto access_time = buf_page_is_accessed(bpage);
+
+        if (access_time == 0) {
+          ++index_stats.m_n_age[0];
+        } else {
+          const auto &limits = Buf_index_stats::AGE_LIMITS;
+          const auto it = std::upper_bound(limits.begin(), limits.end(), uint32_t(now - access_time));
+
+          ++index_stats.m_n_age[1 + (it - limits.begin())];
+        }
+      }
+
+      mutex_release();
+    }
+  }
+}
+
+bool Buf_pool_instance::collect_page_infos(ulint &chunk_no, ulint &offset, std::vector<Buf_page_info> &infos) noexcept {
+  infos.clear();
+
+  mutex_acquire();
+
+  /* Chunks may have been removed by a resize while the mutex was released. */
+  while (chunk_no < m_n_chunks.load(std::memory_order_relaxed) && offset >= m_chunks[chunk_no].size) {
+    ++chunk_no;
+    offset = 0;
+  }
+
+  if (chunk_no >= m_n_chunks.load(std::memory_order_relaxed)) {
+    mutex_release();
+    return false;
+  }
+
+  const auto chunk = &m_chunks[chunk_no];
+  const auto end = std::min(chunk->size, offset + PAGE_INFO_BATCH);
+
+  for (auto block = &chunk->blocks[offset]; block < &chunk->blocks[end]; ++block) {
+    const auto bpage = &block->m_page;
+    auto &info = infos.emplace_back();
+
+    info.m_instance_no = m_instance_no;
+    info.m_state = block->get_state();
+
+    if (info.m_state != BUF_BLOCK_FILE_PAGE) {
+      continue;
+    }
+
+    /* The block mutex protects the fix count and the io fix, the buffer pool
+    mutex the rest. */
+    mutex_enter(&block->m_mutex);
+
+    info.m_space_id = bpage->get_space();
+    info.m_page_no = bpage->get_page_no();
+    info.m_io_fix = buf_page_get_io_fix(bpage);
+    info.m_buf_fix_count = bpage->m_buf_fix_count;
+    info.m_oldest_modification = bpage->m_oldest_modification;
+    info.m_newest_modification = bpage->m_newest_modification;
+    info.m_access_time = buf_page_is_accessed(bpage);
+    info.m_old = buf_page_is_old(bpage);
+
+    mutex_exit(&block->m_mutex);
+
+    /* The clocks are 31 bits in the descriptor and can wrap. */
+    info.m_LRU_age = (m_freed_page_clock - bpage->get_freed_page_clock()) & 0x7FFFFFFFUL;
+
+    /* The frame of a page that is being read in is not valid yet. */
+    if (info.m_io_fix != BUF_IO_READ) {
+      const auto frame = block->get_frame();
+
+      info.m_page_type = uint16_t(srv_fil->page_get_type(frame));
+
+      if (info.m_page_type == FIL_PAGE_TYPE_INDEX) {
+        info.m_index_id = mach_read_from_8(frame + PAGE_HEADER + PAGE_INDEX_ID);
+      }
+    }
+  }
+
+  offset = end;
+
+  mutex_release();
+
+  return true;
+}
+
 #ifdef UNIV_DEBUG
-Buf_page *Buf_pool::set_file_page_was_freed(space_id_t space, page_no_t page_no) {
+Buf_page *Buf_pool_instance::set_file_page_was_freed(space_id_t space, page_no_t page_no) {
   mutex_acquire();
 
   auto bpage = hash_get_page(space, page_no);
@@ -1944,3 +2517,637 @@ Buf_page *Buf_pool::set_file_page_was_freed(space_id_t space, page_no_t page_no)
 }
 #endif /* UNIV_DEBUG */
 
+
+/**
+ * Reports the huge pages and the NUMA policy backing the buffer pool, warns
+ * if they are not what was configured.
+ *
+ * @param[in] buf_pool          The buffer pool.
+ */
+static void report_mem_placement(const Buf_pool *buf_pool) {
+  constexpr const char *huge_pages_names[] = {"off", "transparent", "2M", "1G"};
+  constexpr const char *numa_names[] = {"off", "interleave", "bind"};
+
+  const auto huge_pages = buf_pool->get_huge_pages();
+  const auto numa = buf_pool->get_numa_policy();
+
+  if (huge_pages != srv_config.m_buf_pool_huge_pages || numa != srv_config.m_buf_pool_numa) {
+    log_warn(std::format(
+      "Requested huge pages: {}, NUMA policy: {} for the buffer pool, using huge pages: {}, NUMA policy: {}",
+      huge_pages_names[srv_config.m_buf_pool_huge_pages], numa_names[srv_config.m_buf_pool_numa],
+      huge_pages_names[huge_pages], numa_names[numa]));
+  } else if (huge_pages != OS_HUGE_PAGES_OFF || numa != OS_NUMA_OFF) {
+    log_info(std::format(
+      "Buffer pool huge pages: {}, NUMA policy: {}", huge_pages_names[huge_pages], numa_names[numa]));
+  }
+}
+
+Buf_pool::~Buf_pool() noexcept {}
+
+bool Buf_pool::open(uint64_t pool_size) {
+  ut_a(m_instances.empty());
+
+  auto n_instances = std::clamp(srv_config.m_buf_pool_instances, ulint(1), MAX_BUFFER_POOLS);
+
+  /* Don't split a small buffer pool into instances that are too small
+  for the LRU heuristics to work. */
+  n_instances = std::max(ulint(1), std::min(n_instances, ulint(pool_size / BUF_POOL_INSTANCE_MIN_SIZE)));
+
+  if (n_instances != srv_config.m_buf_pool_instances) {
+    log_info(std::format(
+      "Adjusted the number of buffer pool instances from {} to {} for a buffer pool of {} bytes",
+      srv_config.m_buf_pool_instances, n_instances, pool_size));
+
+    srv_config.m_buf_pool_instances = n_instances;
+  }
+
+  const auto instance_size = ut_2pow_round(pool_size / n_instances, UNIV_PAGE_SIZE);
+
+  auto chunk_size = ut_2pow_round(std::max(uint64_t(srv_config.m_buf_pool_chunk_size), uint64_t(UNIV_PAGE_SIZE)), UNIV_PAGE_SIZE);
+
+  /* Leave room for the instances to grow to four times their size. */
+  if (instance_size / chunk_size > Buf_pool_instance::MAX_CHUNKS / 4) {
+    chunk_size = ut_2pow_round(instance_size / (Buf_pool_instance::MAX_CHUNKS / 4), UNIV_PAGE_SIZE) + UNIV_PAGE_SIZE;
+
+    log_info(std::format(
+      "Adjusted the buffer pool chunk size from {} to {} bytes", srv_config.m_buf_pool_chunk_size, chunk_size));
+
+    srv_config.m_buf_pool_chunk_size = chunk_size;
+  }
+
+  m_instances.resize(n_instances);
+
+  /* Initializing the block descriptors, and prefaulting the frames, of a
+  large buffer pool takes long. The instances are independent and are opened
+  in parallel, before the task scheduler is created, on threads of their own. */
+  std::atomic<bool> success{true};
+
+  auto open_instance = [&](ulint i) {
+    std::unique_ptr<Buf_pool_instance> buf_pool(new (std::nothrow) Buf_pool_instance(i));
+
+    if (buf_pool == nullptr || !buf_pool->open(instance_size, chunk_size)) {
+      success.store(false, std::memory_order_relaxed);
+    } else {
+      m_instances[i] = std::move(buf_pool);
+    }
+  };
+
+  Task_group tasks(Task_class::Background);
+
+  for (ulint i{1}; i < n_instances; ++i) {
+    tasks.run([&open_instance, i]() { open_instance(i); });
+  }
+
+  open_instance(0);
+
+  tasks.wait();
+
+  if (!success.load(std::memory_order_relaxed)) {
+    std::erase(m_instances, nullptr);
+    return false;
+  }
+
+  srv_config.m_buf_pool_old_size = pool_size;
+
+  srv_config.m_buf_pool_curr_size = get_curr_size();
+
+  report_mem_placement(this);
+
+  crc32::checksum = crc32::init();
+
+  return true;
+}
+
+void Buf_pool::close() {
+  for (auto &buf_pool : m_instances) {
+    buf_pool->close();
+  }
+}
+
+bool Buf_pool::resize(uint64_t pool_size) {
+  std::lock_guard<std::mutex> lock(m_resize_mutex);
+
+  const auto old_size = get_curr_size();
+  const auto instance_size = pool_size / m_instances.size();
+
+  log_info(std::format("Resizing the buffer pool from {} to {} bytes", old_size, pool_size));
+
+  bool success{true};
+
+  for (auto &buf_pool : m_instances) {
+    if (!buf_pool->resize(instance_size)) {
+      success = false;
+    }
+  }
+
+  srv_config.m_buf_pool_old_size = pool_size;
+
+  srv_config.m_buf_pool_curr_size = get_curr_size();
+
+  report_mem_placement(this);
+
+  if (success) {
+    log_info(std::format("Resized the buffer pool to {} bytes", srv_config.m_buf_pool_curr_size));
+  } else {
+    log_err(std::format(
+      "Could not resize the buffer pool to {} bytes, its size is now {} bytes", pool_size, srv_config.m_buf_pool_curr_size));
+  }
+
+  return success;
+}
+
+ulint Buf_pool::get_n_pending_ios() {
+  ulint n_pending{};
+
+  for (auto &buf_pool : m_instances) {
+    n_pending += buf_pool->get_n_pending_ios();
+  }
+
+  return n_pending;
+}
+
+void Buf_pool::print_io(ib_stream_t ib_stream) {
+  for (auto &buf_pool : m_instances) {
+    if (m_instances.size() > 1) {
+      log_info(std::format("Buffer pool instance {}", buf_pool->m_instance_no));
+    }
+
+    buf_pool->print_io(ib_stream);
+  }
+}
+
+void Buf_pool::refresh_io_stats() {
+  for (auto &buf_pool : m_instances) {
+    buf_pool->refresh_io_stats();
+  }
+}
+
+bool Buf_pool::all_freed() {
+  for (auto &buf_pool : m_instances) {
+    ut_a(buf_pool->all_freed());
+  }
+
+  return true;
+}
+
+bool Buf_pool::is_io_pending() {
+  for (auto &buf_pool : m_instances) {
+    if (buf_pool->is_io_pending()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Buf_pool::invalidate() {
+  for (auto &buf_pool : m_instances) {
+    buf_pool->invalidate();
+  }
+}
+
+ulint Buf_pool::get_modified_ratio_pct() {
+  ulint n_dirty{};
+  ulint n_pages{};
+
+  for (auto &buf_pool : m_instances) {
+    buf_pool->mutex_acquire();
+
+    n_dirty += UT_LIST_GET_LEN(buf_pool->m_flush_list);
+    n_pages += UT_LIST_GET_LEN(buf_pool->m_LRU_list) + UT_LIST_GET_LEN(buf_pool->m_free_list);
+
+    buf_pool->mutex_release();
+  }
+
+  /* 1 + is there to avoid division by zero */
+  return (100 * n_dirty) / (1 + n_pages);
+}
+
+bool Buf_pool::try_get(Request &req) {
+  return get_instance(&req.m_guess->m_page)->try_get(req);
+}
+
+bool Buf_pool::try_get_known_nowait(Request &req) {
+  return get_instance(&req.m_guess->m_page)->try_get_known_nowait(req);
+}
+
+const Buf_block *Buf_pool::try_get_by_page_id(Request &req) {
+  return get_instance(req.m_page_id.m_space_id, req.m_page_id.m_page_no)->try_get_by_page_id(req);
+}
+
+Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
+  return get_instance(req.m_page_id.m_space_id, req.m_page_id.m_page_no)->get(req, guess);
+}
+
+Buf_block *Buf_pool::create(space_id_t space, page_no_t page_no, mtr_t *mtr) {
+  return get_instance(space, page_no)->create(space, page_no, mtr);
+}
+
+void Buf_pool::make_young(Buf_page *bpage) {
+  get_instance(bpage)->make_young(bpage);
+}
+
+void Buf_pool::check_index_page_at_flush(space_id_t space, page_no_t page_no) {
+  get_instance(space, page_no)->check_index_page_at_flush(space, page_no);
+}
+
+ulint Buf_pool::get_curr_pages() const {
+  ulint n_pages{};
+
+  for (auto &buf_pool : m_instances) {
+    n_pages += buf_pool->m_curr_size;
+  }
+
+  return n_pages;
+}
+
+uint64_t Buf_pool::get_oldest_modification() const {
+  lsn_t oldest_lsn{};
+
+  for (auto &buf_pool : m_instances) {
+    const auto lsn = buf_pool->get_oldest_modification();
+
+    if (lsn != 0 && (oldest_lsn == 0 || lsn < oldest_lsn)) {
+      oldest_lsn = lsn;
+    }
+  }
+
+  if (oldest_lsn != 0) {
+    /* A page linked after the last page of a flush list may be older by
+    as much as the slack. */
+    oldest_lsn = std::max(oldest_lsn, BUF_FLUSH_LIST_SLACK + 1) - BUF_FLUSH_LIST_SLACK;
+  }
+
+  return oldest_lsn;
+}
+
+Buf_block *Buf_pool::block_alloc() {
+  const auto i = m_next_alloc.fetch_add(1, std::memory_order_relaxed);
+
+  return get_instance_at(i % m_instances.size())->block_alloc();
+}
+
+void Buf_pool::block_free(Buf_block *block) {
+  get_instance(&block->m_page)->block_free(block);
+}
+
+void Buf_pool::release(Buf_block *block, ulint rw_latch, mtr_t *mtr) {
+  get_instance(&block->m_page)->release(block, rw_latch, mtr);
+}
+
+ulint Buf_pool::get_free_list_len() {
+  ulint len{};
+
+  for (auto &buf_pool : m_instances) {
+    len += buf_pool->get_free_list_len();
+  }
+
+  return len;
+}
+
+os_huge_pages_t Buf_pool::get_huge_pages() const {
+  auto huge_pages = OS_HUGE_PAGES_1G;
+
+  for (auto &buf_pool : m_instances) {
+    const auto n_chunks = buf_pool->m_n_chunks.load(std::memory_order_acquire);
+
+    for (ulint i = 0; i < n_chunks; ++i) {
+      huge_pages = std::min(huge_pages, buf_pool->m_chunks[i].placement.m_huge_pages);
+    }
+  }
+
+  return m_instances.empty() ? OS_HUGE_PAGES_OFF : huge_pages;
+}
+
+os_numa_policy_t Buf_pool::get_numa_policy() const {
+  auto numa = OS_NUMA_BIND;
+
+  for (auto &buf_pool : m_instances) {
+    const auto n_chunks = buf_pool->m_n_chunks.load(std::memory_order_acquire);
+
+    for (ulint i = 0; i < n_chunks; ++i) {
+      numa = std::min(numa, buf_pool->m_chunks[i].placement.m_numa);
+    }
+  }
+
+  return m_instances.empty() ? OS_NUMA_OFF : numa;
+}
+
+ulint Buf_pool::get_LRU_len() const {
+  ulint len{};
+
+  /* Dirty read, only used for statistics. */
+  for (auto &buf_pool : m_instances) {
+    len += UT_LIST_GET_LEN(buf_pool->m_LRU_list);
+  }
+
+  return len;
+}
+
+ulint Buf_pool::get_flush_list_len() const {
+  ulint len{};
+
+  /* Dirty read, only used for statistics. */
+  for (auto &buf_pool : m_instances) {
+    len += UT_LIST_GET_LEN(buf_pool->m_flush_list);
+  }
+
+  return len;
+}
+
+ulint Buf_pool::get_n_pend_reads() const {
+  ulint n_pend_reads{};
+
+  for (auto &buf_pool : m_instances) {
+    n_pend_reads += buf_pool->m_n_pend_reads;
+  }
+
+  return n_pend_reads;
+}
+
+ulint Buf_pool::get_write_requests() const {
+  ulint n_write_requests{};
+
+  for (auto &buf_pool : m_instances) {
+    n_write_requests += buf_pool->m_write_requests;
+  }
+
+  return n_write_requests;
+}
+
+std::vector<Buf_index_stats> Buf_pool::get_index_stats() const {
+  Buf_index_stats_map stats{};
+  const auto now = uint32_t(ut_time_ms());
+
+  for (auto &buf_pool : m_instances) {
+    buf_pool->collect_index_stats(stats, now);
+  }
+
+  std::vector<Buf_index_stats> result{};
+
+  result.reserve(stats.size());
+
+  for (const auto &[key, index_stats] : stats) {
+    result.push_back(index_stats);
+  }
+
+  return result;
+}
+
+bool Buf_pool::visit_pages(const std::function<bool(const Buf_page_info &)> &visitor) const {
+  std::vector<Buf_page_info> infos{};
+
+  infos.reserve(Buf_pool_instance::PAGE_INFO_BATCH);
+
+  for (auto &buf_pool : m_instances) {
+    ulint chunk_no{};
+    ulint offset{};
+
+    while (buf_pool->collect_page_infos(chunk_no, offset, infos)) {
+      for (const auto &info : infos) {
+        if (!visitor(info)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+buf_pool_stat_t Buf_pool::get_stat() const {
+  buf_pool_stat_t stat{};
+
+  for (auto &buf_pool : m_instances) {
+    stat += buf_pool->m_stat;
+  }
+
+  return stat;
+}
+
+Buf_block *Buf_pool::block_align(const byte *ptr) {
+  for (auto &buf_pool : m_instances) {
+    auto block = buf_pool->block_align(ptr);
+
+    if (block != nullptr) {
+      return block;
+    }
+  }
+
+  /* The block should always be found. */
+  ut_error;
+  return nullptr;
+}
+
+bool Buf_pool::pointer_is_block_field(const void *ptr) {
+  for (auto &buf_pool : m_instances) {
+    if (buf_pool->pointer_is_block_field(ptr)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Buf_page *Buf_pool::init_for_read(db_err *err, space_id_t space, page_no_t page_no, int64_t tablespace_version) {
+  return get_instance(space, page_no)->init_for_read(err, space, page_no, tablespace_version);
+}
+
+void Buf_pool::io_complete(Buf_page *bpage) {
+  while (bpage != nullptr) {
+    /* Unlink the page first, once its write has completed it can be
+    evicted and reused. */
+    auto next = bpage->m_write_run_next;
+
+    bpage->m_write_run_next = nullptr;
+
+    const Page_id page_id{bpage->m_space, bpage->m_page_no};
+    const auto is_read = buf_page_get_io_fix(bpage) == BUF_IO_READ;
+
+    get_instance(bpage)->io_complete(bpage);
+
+    if (is_read && m_n_read_waiters.load(std::memory_order_acquire) > 0) {
+      wake_read_waiters(page_id.space_id(), page_id.page_no());
+    }
+
+    bpage = next;
+  }
+}
+
+void Buf_pool::add_read_waiter(space_id_t space, page_no_t page_no, std::function<void()> callback) {
+  std::lock_guard<std::mutex> lock(m_read_waiters_mutex);
+
+  m_read_waiters.emplace(Page_id{space, page_no}, std::move(callback));
+  m_n_read_waiters.fetch_add(1, std::memory_order_release);
+}
+
+void Buf_pool::wake_read_waiters(space_id_t space, page_no_t page_no) {
+  std::vector<std::function<void()>> callbacks;
+
+  {
+    std::lock_guard<std::mutex> lock(m_read_waiters_mutex);
+
+    auto [first, last] = m_read_waiters.equal_range(Page_id{space, page_no});
+
+    for (auto it = first; it != last; ++it) {
+      callbacks.push_back(std::move(it->second));
+    }
+
+    m_read_waiters.erase(first, last);
+    m_n_read_waiters.fetch_sub(callbacks.size(), std::memory_order_release);
+  }
+
+  /* The callbacks are invoked without the mutex, they may register again. */
+  for (auto &callback : callbacks) {
+    callback();
+  }
+}
+
+bool Buf_pool::is_read_pending(space_id_t space, page_no_t page_no) {
+  auto buf_pool = get_instance(space, page_no);
+
+  buf_pool->mutex_acquire();
+
+  auto bpage = buf_pool->hash_get_page(space, page_no);
+  const auto pending = bpage != nullptr && buf_page_get_io_fix(bpage) == BUF_IO_READ;
+
+  buf_pool->mutex_release();
+
+  return pending;
+}
+
+ulint Buf_pool::flush_batch(DBLWR *dblwr, buf_flush flush_type, ulint min_n, uint64_t lsn_limit) {
+  ulint n_skipped{};
+  ulint n_flushed{};
+  const auto n_instances = m_instances.size();
+
+  if (min_n != ULINT_MAX) {
+    /* Split the work evenly between the instances, rounding up. */
+    min_n = (min_n + n_instances - 1) / n_instances;
+  }
+
+  for (auto &buf_pool : m_instances) {
+    const auto n_pages = buf_pool->m_flusher->batch(dblwr, flush_type, min_n, lsn_limit);
+
+    if (n_pages == ULINT_UNDEFINED) {
+      ++n_skipped;
+    } else {
+      n_flushed += n_pages;
+    }
+  }
+
+  /* If an lsn_limit was specified then the caller relies on all the pages
+  older than it having been flushed, which isn't the case if any instance
+  was skipped. */
+  if (n_skipped == n_instances || (n_skipped > 0 && flush_type == BUF_FLUSH_LIST && lsn_limit != IB_UINT64_T_MAX)) {
+    return ULINT_UNDEFINED;
+  }
+
+  return n_flushed;
+}
+
+void Buf_pool::wait_batch_end(buf_flush type) {
+  for (auto &buf_pool : m_instances) {
+    buf_pool->m_flusher->wait_batch_end(type);
+  }
+}
+
+void Buf_pool::free_margin(DBLWR *dblwr) {
+  for (auto &buf_pool : m_instances) {
+    buf_pool->m_flusher->free_margin(dblwr);
+  }
+}
+
+void Buf_pool::stat_update() {
+  for (auto &buf_pool : m_instances) {
+    /* Update the statistics collected for deciding LRU eviction policy. */
+    buf_pool->m_LRU->stat_update();
+  }
+}
+
+void Buf_pool::invalidate_tablespace(space_id_t space_id) {
+  /* The space is no longer in the tablespace memory cache, which is how
+  the sweep recognises its pages. */
+  ut_a(srv_fil->tablespace_deleted_or_being_deleted_in_mem(space_id, -1));
+
+  for (auto &buf_pool : m_instances) {
+    buf_pool->m_LRU->request_sweep();
+  }
+}
+
+void Buf_pool::sweep_dropped() {
+  /* Up to 64K pages of each instance a second. */
+  constexpr ulint max_batches = 256;
+
+  for (auto &buf_pool : m_instances) {
+    (void) buf_pool->m_LRU->sweep_dropped(max_batches);
+  }
+}
+
+bool Buf_pool::running_out() {
+  ulint n_avail{};
+
+  if (recv_recovery_on) {
+    return false;
+  }
+
+  for (auto &buf_pool : m_instances) {
+    buf_pool->mutex_acquire();
+
+    n_avail += UT_LIST_GET_LEN(buf_pool->m_free_list) + UT_LIST_GET_LEN(buf_pool->m_LRU_list);
+
+    buf_pool->mutex_release();
+  }
+
+  return n_avail < get_curr_pages() / 4;
+}
+
+ulint Buf_pool::old_ratio_update(ulint old_pct, bool adjust) {
+  auto ratio = old_pct;
+
+  for (auto &buf_pool : m_instances) {
+    ratio = buf_pool->m_LRU->old_ratio_update(old_pct, adjust);
+  }
+
+  return ratio;
+}
+
+void Buf_pool::recv_note_modification(Buf_block *block, uint64_t start_lsn, uint64_t end_lsn) {
+  get_instance(&block->m_page)->m_flusher->recv_note_modification(block, start_lsn, end_lsn);
+}
+
+void Buf_pool::free_flush_list() {
+  for (auto &buf_pool : m_instances) {
+    buf_pool->m_flusher->free_flush_list();
+  }
+}
+
+#ifdef UNIV_DEBUG
+void Buf_pool::print() {
+  for (auto &buf_pool : m_instances) {
+    buf_pool->print();
+  }
+}
+
+Buf_page *Buf_pool::set_file_page_was_freed(space_id_t space, page_no_t page_no) {
+  return get_instance(space, page_no)->set_file_page_was_freed(space, page_no);
+}
+
+ulint Buf_pool::get_latched_pages_number() {
+  ulint n_latched{};
+
+  for (auto &buf_pool : m_instances) {
+    n_latched += buf_pool->get_latched_pages_number();
+  }
+
+  return n_latched;
+}
+
+bool Buf_pool::validate() {
+  for (auto &buf_pool : m_instances) {
+    ut_a(buf_pool->validate());
+  }
+
+  return true;
+}
+#endif /* UNIV_DEBUG */
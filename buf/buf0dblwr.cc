@@ -22,24 +22,64 @@ Doublewrite buffer
 Created 2024-09-25 by Sunny Bains. */
 
 #include "buf0dblwr.h"
+#include "log0recv.h"
+#include "srv0srv.h"
+#include "srv0task.h"
 #include "trx0sys.h"
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 /** The doublewrite buffer instance */
 DBLWR *srv_dblwr{};
 
+/** Maximum number of consecutive data file pages that DBLWR::recover_pages()
+compares with one read */
+constexpr ulint DBLWR_RECOVER_MAX_RUN = 32;
+
+/** Maximum number of threads that DBLWR::recover_pages() compares the pages
+with */
+constexpr ulint DBLWR_RECOVER_MAX_THREADS = 8;
+
+/**
+ * @param[in] mode              The doublewrite mode, a dblwr_mode_t.
+ * @param[in] fsp               Filespace manager, for the buffer pool.
+ *
+ * @return the number of slots to split the doublewrite area into.
+ */
+static ulint dblwr_n_slots(ulint mode, const FSP *fsp) noexcept {
+  if (mode == DBLWR_MODE_PARALLEL || mode == DBLWR_MODE_AUTO) {
+    return std::clamp(fsp->m_buf_pool->get_n_instances(), ulint(1), DBLWR_MAX_SLOTS);
+  } else {
+    return 1;
+  }
+}
+
 DBLWR::DBLWR(FSP *fsp)
   : m_fsp(fsp),
+    m_mode(srv_config.m_doublewrite_mode),
     m_block1(ULINT32_UNDEFINED),
-    m_block2(ULINT32_UNDEFINED) {
-
-
-  mutex_create(&m_mutex, IF_DEBUG("DBLWR::m_mutex",) IF_SYNC_DEBUG(SYNC_DOUBLEWRITE,) Current_location());
+    m_block2(ULINT32_UNDEFINED),
+    m_slots(dblwr_n_slots(m_mode, fsp)) {
 
   m_ptr = static_cast<byte *>(ut_new((1 + 2 * SYS_DOUBLEWRITE_BLOCK_SIZE) * UNIV_PAGE_SIZE));
 
   m_write_buf = static_cast<byte *>(ut_align(m_ptr, UNIV_PAGE_SIZE));
 
-  m_bpages.resize(2 * SYS_DOUBLEWRITE_BLOCK_SIZE);
+  const auto n_slots = m_slots.size();
+  const auto n_pages = 2 * SYS_DOUBLEWRITE_BLOCK_SIZE;
+
+  for (ulint i{}; i < n_slots; ++i) {
+    auto &slot = m_slots[i];
+
+    mutex_create(&slot.m_mutex, IF_DEBUG("DBLWR::Slot::m_mutex",) IF_SYNC_DEBUG(SYNC_DOUBLEWRITE,) Current_location());
+
+    slot.m_start = i * n_pages / n_slots;
+    slot.m_n_pages = (i + 1) * n_pages / n_slots - slot.m_start;
+    slot.m_write_buf = m_write_buf + slot.m_start * UNIV_PAGE_SIZE;
+    slot.m_bpages.resize(slot.m_n_pages);
+  }
 }
 
 DBLWR::~DBLWR() {
@@ -47,7 +87,26 @@ DBLWR::~DBLWR() {
     ut_delete(m_ptr);
   }
 
-  mutex_free(&m_mutex);
+  for (auto &slot : m_slots) {
+    mutex_free(&slot.m_mutex);
+  }
+}
+
+bool DBLWR::is_bypassed(space_id_t space_id) const noexcept {
+  /* A torn page of a temporary table is never read, the table is dropped
+  at startup. */
+  if (m_fsp->m_fil->space_is_temp(space_id)) {
+    return true;
+  }
+
+  switch (m_mode) {
+    case DBLWR_MODE_ATOMIC:
+      return true;
+    case DBLWR_MODE_AUTO:
+      return m_fsp->m_fil->space_has_atomic_writes(space_id);
+    default:
+      return false;
+  }
 }
 
 bool DBLWR::is_page_inside(page_no_t page_no) const noexcept {
@@ -212,87 +271,185 @@ void DBLWR::recover_pages() noexcept {
   ut_a(m_block1 != ULINT32_UNDEFINED);
   ut_a(m_block2 != ULINT32_UNDEFINED);
 
-  auto ptr = static_cast<byte *>(ut_new(2 * UNIV_PAGE_SIZE));
-  auto read_buf = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
+  const auto start{std::chrono::steady_clock::now()};
+  auto &stats = recv_stats.m_phases[RECV_PHASE_DBLWR];
 
-  /* Read the trx sys header to check if we are using the doublewrite buffer.
-   * Note: We bypass the buffer pool here.*/
+  {
+    auto ptr = static_cast<byte *>(ut_new(2 * UNIV_PAGE_SIZE));
+    auto read_buf = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
 
-  m_fsp->m_fil->io(IO_request::Sync_read, false, SYS_TABLESPACE, TRX_SYS_PAGE_NO, 0, UNIV_PAGE_SIZE, read_buf, nullptr);
+    /* Read the trx sys header to check if we are using the doublewrite buffer.
+     * Note: We bypass the buffer pool here.*/
+
+    m_fsp->m_fil->io(IO_request::Sync_read, false, SYS_TABLESPACE, TRX_SYS_PAGE_NO, 0, UNIV_PAGE_SIZE, read_buf, nullptr);
 
-  {
     const auto dblwr = read_buf + SYS_DOUBLEWRITE;
 
     /* Check that the doublewrite buffer has been created */
     ut_a(mach_read_from_4(dblwr + SYS_DOUBLEWRITE_MAGIC) == SYS_DOUBLEWRITE_MAGIC_N);
+
+    ut_delete(ptr);
   }
 
   auto buf = m_write_buf;
 
-  /* Read the pages from both the doublewrite buffers into memory */
-
-  m_fsp->m_fil->io(
-    IO_request::Sync_read,
-    false,
-    SYS_TABLESPACE,
-    m_block1,
-    0,
-    SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
-    buf,
-    nullptr);
-
-  m_fsp->m_fil->io(
-    IO_request::Sync_read,
-    false,
-    SYS_TABLESPACE,
-    m_block2,
-    0,
-    SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
-    buf + SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
-    nullptr
-  );
+  /* Read the pages from both the doublewrite buffers into memory, each block
+   * with one large read, the two at the same time. */
+  {
+    auto read_block = [this](page_no_t block, byte *block_buf) {
+      m_fsp->m_fil->io(
+        IO_request::Sync_read,
+        false,
+        SYS_TABLESPACE,
+        block,
+        0,
+        SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE,
+        block_buf,
+        nullptr
+      );
+    };
 
-  /* Check if any of these pages is half-written in data files, in the intended
-   * position */
+    Task_group tasks(Task_class::Background);
+
+    tasks.run([&read_block, buf, this]() { read_block(m_block2, buf + SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE); });
+
+    read_block(m_block1, buf);
+
+    tasks.wait();
+  }
+
+  stats.m_n_bytes += 2 * SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE;
+
+  /** A page in the doublewrite buffer and its position in the data files. */
+  struct Copy {
+    space_id_t m_space_id;
+    page_no_t m_page_no;
+    lsn_t m_lsn;
+
+    /** The copy, in buf */
+    const byte *m_page;
+  };
 
-  auto page = buf;
+  std::vector<Copy> copies;
+
+  copies.reserve(2 * SYS_DOUBLEWRITE_BLOCK_SIZE);
 
   for (ulint i{}; i < SYS_DOUBLEWRITE_BLOCK_SIZE * 2; ++i) {
-    const auto page_no = mach_read_from_4(page + FIL_PAGE_OFFSET);
-    const auto space_id = mach_read_from_4(page + FIL_PAGE_SPACE_ID);
+    const auto page = buf + i * UNIV_PAGE_SIZE;
+
+    copies.push_back(Copy{
+      .m_space_id = space_id_t(mach_read_from_4(page + FIL_PAGE_SPACE_ID)),
+      .m_page_no = page_no_t(mach_read_from_4(page + FIL_PAGE_OFFSET)),
+      .m_lsn = mach_read_from_8(page + FIL_PAGE_LSN),
+      .m_page = page
+    });
+  }
+
+  /* Sort by position in the data files, the consecutive pages of a space
+   * are then compared with one read. If the area was split into slots the
+   * same page can be in it more than once, the newest copy is sorted first
+   * and only it may be used. */
+  std::sort(copies.begin(), copies.end(), [](const Copy &lhs, const Copy &rhs) {
+    if (lhs.m_space_id != rhs.m_space_id) {
+      return lhs.m_space_id < rhs.m_space_id;
+    } else if (lhs.m_page_no != rhs.m_page_no) {
+      return lhs.m_page_no < rhs.m_page_no;
+    } else {
+      return lhs.m_lsn > rhs.m_lsn;
+    }
+  });
 
-    if (!m_fsp->m_fil->tablespace_exists_in_mem(space_id)) {
+  std::vector<Copy> pages;
+
+  pages.reserve(copies.size());
+
+  for (const auto &copy : copies) {
+    if (!pages.empty() && pages.back().m_space_id == copy.m_space_id && pages.back().m_page_no == copy.m_page_no) {
+      /* A newer copy of the page is in another slot. */
+    } else if (!m_fsp->m_fil->tablespace_exists_in_mem(copy.m_space_id)) {
       /* Maybe we have dropped the single-table tablespace
       and this page once belonged to it: do nothing */
-    } else if (!m_fsp->m_fil->check_adress_in_tablespace(space_id, page_no)) {
+    } else if (!m_fsp->m_fil->check_adress_in_tablespace(copy.m_space_id, copy.m_page_no)) {
       log_warn(std::format(
         "A page in the doublewrite buffer is not within space bounds; space id {}"
         " page number {}, page {} in doublewrite buf.",
-        space_id,
-        page_no,
-        i
+        copy.m_space_id,
+        copy.m_page_no,
+        ulint(copy.m_page - buf) / UNIV_PAGE_SIZE
       ));
 
-    } else if (space_id == SYS_TABLESPACE && is_page_inside(page_no)) {
+    } else if (copy.m_space_id == SYS_TABLESPACE && is_page_inside(copy.m_page_no)) {
       /* It is an unwritten doublewrite buffer page: do nothing */
     } else {
-      /* Read in the actual page from the file */
-      m_fsp->m_fil->io(IO_request::Sync_read, false, space_id, page_no, 0, UNIV_PAGE_SIZE, read_buf, nullptr);
+      pages.push_back(copy);
+    }
+  }
+
+  /* Runs of consecutive pages of a space, [first, last) in pages. */
+  std::vector<std::pair<ulint, ulint>> runs;
+
+  for (ulint i{}; i < pages.size(); ++i) {
+    if (runs.empty() || runs.back().second - runs.back().first == DBLWR_RECOVER_MAX_RUN ||
+        pages[i].m_space_id != pages[i - 1].m_space_id || pages[i].m_page_no != pages[i - 1].m_page_no + 1) {
+      runs.emplace_back(i, i + 1);
+    } else {
+      ++runs.back().second;
+    }
+  }
+
+  /* Check if any of these pages is half-written in data files, in the intended
+   * position. The runs are compared by several threads. */
+
+  std::atomic<ulint> next_run{};
+  std::atomic<ulint> n_restored{};
+
+  auto verify = [&]() {
+    auto ptr = static_cast<byte *>(ut_new((1 + DBLWR_RECOVER_MAX_RUN) * UNIV_PAGE_SIZE));
+    auto read_buf = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
+
+    for (auto r = next_run.fetch_add(1, std::memory_order_relaxed); r < runs.size();
+         r = next_run.fetch_add(1, std::memory_order_relaxed)) {
+
+      const auto [first, last] = runs[r];
+      const auto &first_page = pages[first];
+
+      /* Read in the actual pages from the file */
+      m_fsp->m_fil->io(
+        IO_request::Sync_read,
+        false,
+        first_page.m_space_id,
+        first_page.m_page_no,
+        0,
+        (last - first) * UNIV_PAGE_SIZE,
+        read_buf,
+        nullptr
+      );
 
-      /* Check if the page is corrupt */
+      stats.m_n_pages_read += last - first;
 
-      if (unlikely(m_fsp->m_buf_pool->is_corrupted(read_buf))) {
+      for (auto i = first; i < last; ++i) {
+        const auto &copy = pages[i];
+        const auto page = const_cast<byte *>(copy.m_page);
+        const auto file_page = read_buf + (i - first) * UNIV_PAGE_SIZE;
+
+        Fil::decompress_page(file_page);
+
+        /* Check if the page is corrupt */
+
+        if (likely(!m_fsp->m_buf_pool->is_corrupted(file_page))) {
+          continue;
+        }
 
         log_warn(std::format(
           "Database page corruption or a failed file read of space {} page {}."
           " Trying to recover it from the doublewrite buffer.",
-          space_id,
-          page_no
+          copy.m_space_id,
+          copy.m_page_no
         ));
 
         if (m_fsp->m_buf_pool->is_corrupted(page)) {
           log_info("Dump of the page:");
-          buf_page_print(read_buf, 0);
+          buf_page_print(file_page, 0);
           log_warn("Dump of corresponding page in doublewrite buffer:");
           buf_page_print(page, 0);
 
@@ -306,18 +463,45 @@ void DBLWR::recover_pages() noexcept {
         /* Write the good page from the doublewrite buffer to the intended
          * position */
 
-        m_fsp->m_fil->io(IO_request::Sync_write, false, space_id, page_no, 0, UNIV_PAGE_SIZE, page, nullptr);
+        m_fsp->m_fil->io(IO_request::Sync_write, false, copy.m_space_id, copy.m_page_no, 0, UNIV_PAGE_SIZE, page, nullptr);
 
         log_info("Recovered the page from the doublewrite buffer.");
+
+        ++stats.m_n_items;
+        n_restored.fetch_add(1, std::memory_order_relaxed);
       }
     }
 
-    page += UNIV_PAGE_SIZE;
+    ut_delete(ptr);
+  };
+
+  {
+    const auto n_threads = std::min(runs.size(), DBLWR_RECOVER_MAX_THREADS);
+
+    Task_group tasks(Task_class::Background);
+
+    for (ulint i{1}; i < n_threads; ++i) {
+      tasks.run(verify);
+    }
+
+    verify();
+
+    tasks.wait();
+  }
+
+  if (n_restored.load(std::memory_order_relaxed) > 0) {
+    m_fsp->m_fil->flush_file_spaces(FIL_TABLESPACE);
   }
 
-  m_fsp->m_fil->flush_file_spaces(FIL_TABLESPACE);
+  recv_stats.add_time(RECV_PHASE_DBLWR, start);
 
-  ut_delete(ptr);
+  log_info(std::format(
+    "Checked {} pages from the doublewrite buffer with {} reads, restored {}, in {} ms",
+    pages.size(),
+    runs.size(),
+    n_restored.load(std::memory_order_relaxed),
+    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+  ));
 }
 
 DBLWR *DBLWR::create(FSP *fsp) noexcept {
@@ -0,0 +1,267 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file buf/buf0dump.cc
+Buffer pool dump and load
+*******************************************************/
+
+#include "buf0dump.h"
+#include "buf0buf.h"
+#include "buf0rea.h"
+#include "os0sync.h"
+#include "srv0srv.h"
+#include "os0thread-create.h"
+#include "ut0lst.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+Buf_dump *srv_buf_dump{};
+
+/** @return the path of the dump file. */
+static std::filesystem::path buf_dump_path() noexcept {
+  return std::filesystem::path(srv_config.m_data_home) / Buf_dump::FILE_NAME;
+}
+
+Buf_dump::Buf_dump() noexcept
+  : m_event(os_event_create("buf_dump_event")) {}
+
+Buf_dump::~Buf_dump() noexcept {
+  ut_a(!m_thread.joinable());
+
+  os_event_free(m_event);
+}
+
+Buf_dump *Buf_dump::create() noexcept {
+  auto ptr = ut_new(sizeof(Buf_dump));
+  return ptr == nullptr ? nullptr : new (ptr) Buf_dump();
+}
+
+void Buf_dump::destroy(Buf_dump *&buf_dump) noexcept {
+  call_destructor(buf_dump);
+  ut_delete(buf_dump);
+  buf_dump = nullptr;
+}
+
+void Buf_dump::start() noexcept {
+  ut_a(!m_thread.joinable());
+
+  m_shutdown.store(false, std::memory_order_release);
+
+  m_thread = create_joinable_thread(&Buf_dump::run, this);
+}
+
+void Buf_dump::shutdown(bool dump_all) noexcept {
+  if (m_thread.joinable()) {
+    m_shutdown.store(true, std::memory_order_release);
+
+    os_event_set(m_event);
+
+    m_thread.join();
+  }
+
+  if (dump_all) {
+    (void) dump(100);
+  } else if (srv_config.m_buf_pool_dump_at_shutdown) {
+    (void) dump(srv_config.m_buf_pool_dump_pct);
+  }
+}
+
+bool Buf_dump::sleep(std::chrono::microseconds timeout) noexcept {
+  const auto sig_count = os_event_reset(m_event);
+
+  if (!is_shutdown()) {
+    (void) m_event->wait_time(timeout, sig_count);
+  }
+
+  return !is_shutdown();
+}
+
+db_err Buf_dump::dump(ulint pct) noexcept {
+  const auto path = buf_dump_path();
+  auto tmp_path = path;
+
+  tmp_path += ".incomplete";
+
+  std::vector<Page_id> page_ids;
+
+  for (ulint i = 0; i < srv_buf_pool->get_n_instances(); ++i) {
+    auto buf_pool = srv_buf_pool->get_instance_at(i);
+
+    buf_pool->mutex_acquire();
+
+    const auto len = UT_LIST_GET_LEN(buf_pool->m_LRU_list);
+    auto n = std::min(len, std::max(ulint(1), len * pct / 100));
+
+    page_ids.reserve(page_ids.size() + n);
+
+    /* The young end of the list is at the start. */
+    for (auto bpage = UT_LIST_GET_FIRST(buf_pool->m_LRU_list); bpage != nullptr && n > 0; --n) {
+      ut_ad(bpage->in_file());
+
+      page_ids.emplace_back(bpage->get_space(), bpage->get_page_no());
+
+      bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage);
+    }
+
+    buf_pool->mutex_release();
+  }
+
+  {
+    std::ofstream out(tmp_path, std::ios::out | std::ios::trunc);
+
+    for (const auto &page_id : page_ids) {
+      if (!out) {
+        break;
+      }
+
+      out << page_id.m_space_id << ',' << page_id.m_page_no << '\n';
+    }
+
+    out.flush();
+
+    if (!out) {
+      log_err(std::format("Cannot write the buffer pool dump file {}", tmp_path.string()));
+      return DB_ERROR;
+    }
+  }
+
+  std::error_code ec;
+
+  std::filesystem::rename(tmp_path, path, ec);
+
+  if (ec) {
+    log_err(std::format("Cannot rename {} to {}: {}", tmp_path.string(), path.string(), ec.message()));
+    return DB_ERROR;
+  }
+
+  log_info(std::format("Dumped {} buffer pool page ids to {}", page_ids.size(), path.string()));
+
+  return DB_SUCCESS;
+}
+
+db_err Buf_dump::load() noexcept {
+  const auto path = buf_dump_path();
+  std::ifstream in(path);
+
+  if (!in) {
+    /* Nothing was dumped, e.g., the first start. */
+    return DB_SUCCESS;
+  }
+
+  std::vector<Page_id> page_ids;
+
+  /* There is no point in reading more pages than fit in the buffer pool. */
+  const auto max_pages = srv_buf_pool->get_curr_pages();
+
+  for (;;) {
+    char sep{};
+    space_id_t space;
+    page_no_t page_no;
+
+    if (!(in >> space >> sep >> page_no) || sep != ',') {
+      break;
+    }
+
+    if (page_ids.size() >= max_pages) {
+      break;
+    }
+
+    page_ids.emplace_back(space, page_no);
+  }
+
+  if (!in.eof() && page_ids.size() < max_pages) {
+    log_warn(std::format("Ignoring the garbage after line {} of {}", page_ids.size(), path.string()));
+  }
+
+  /* Read the pages in file order, so that the reads can be merged. */
+  std::sort(page_ids.begin(), page_ids.end(), [](const Page_id &lhs, const Page_id &rhs) {
+    return lhs.m_space_id < rhs.m_space_id || (lhs.m_space_id == rhs.m_space_id && lhs.m_page_no < rhs.m_page_no);
+  });
+
+  log_info(std::format("Loading {} buffer pool pages from {}", page_ids.size(), path.string()));
+
+  ulint n_read{};
+  ulint n_this_second{};
+  auto second_start = ut_time_ms();
+  const auto full = srv_buf_pool->get_curr_pages() / 100 * 95;
+  std::array<page_no_t, LOAD_BATCH_SIZE> page_nos;
+
+  for (size_t i = 0; i < page_ids.size();) {
+    if (is_shutdown()) {
+      log_info(std::format("Buffer pool load aborted after {} pages", n_read));
+      return DB_SUCCESS;
+    }
+
+    if (srv_buf_pool->get_LRU_len() >= full) {
+      /* Reading more would evict the pages read by the user threads. */
+      break;
+    }
+
+    /* Let the reads of the user threads go first. */
+    if (srv_buf_pool->get_n_pend_reads() >= LOAD_BATCH_SIZE) {
+      (void) sleep(std::chrono::milliseconds(10));
+      continue;
+    }
+
+    ulint n{};
+    const auto space = page_ids[i].m_space_id;
+
+    while (i < page_ids.size() && n < page_nos.size() && page_ids[i].m_space_id == space) {
+      page_nos[n++] = page_ids[i++].m_page_no;
+    }
+
+    n_read += buf_read_load_pages(space, page_nos.data(), n);
+    n_this_second += n;
+
+    /* Throttle the load to io_capacity pages per second. */
+    if (n_this_second >= std::max(ulint(PCT_IO(100)), LOAD_BATCH_SIZE)) {
+      const auto now = ut_time_ms();
+
+      if (now < second_start + 1000 && !sleep(std::chrono::milliseconds(second_start + 1000 - now))) {
+        continue;
+      }
+
+      n_this_second = 0;
+      second_start = ut_time_ms();
+    }
+  }
+
+  log_info(std::format("Buffer pool load completed, read {} pages", n_read));
+
+  return DB_SUCCESS;
+}
+
+void Buf_dump::run() noexcept {
+  if (srv_config.m_buf_pool_load_at_startup) {
+    (void) load();
+  }
+
+  auto last_dump = ut_time_ms();
+
+  while (sleep(std::chrono::seconds(1))) {
+    const auto interval = srv_config.m_buf_pool_dump_interval;
+
+    if (interval > 0 && ut_time_ms() - last_dump >= interval * 60 * 1000) {
+      (void) dump(srv_config.m_buf_pool_dump_pct);
+      last_dump = ut_time_ms();
+    }
+  }
+}
@@ -25,21 +25,41 @@ Created 11/11/1995 Heikki Tuuri
 #include "buf0dblwr.h"
 #include "buf0flu.h"
 #include "buf0buf.h"
+#include "buf0l2.h"
 #include "buf0lru.h"
 #include "buf0rea.h"
 #include "fil0fil.h"
 #include "log0log.h"
 #include "os0aio.h"
 #include "os0file.h"
+#include "os0sync.h"
+#include "os0thread-create.h"
+#include "os0thread.h"
 #include "page0page.h"
 #include "srv0srv.h"
 #include "trx0sys.h"
 #include "ut0lst.h"
+#include "ut0probe.h"
+
+#include <cmath>
+
+Page_cleaner *srv_page_cleaner{};
+
+/**
+ * @param[in] bpage             Page in the flush list.
+ * @param[in] lsn_limit         Flush the pages modified before this lsn.
+ *
+ * @return true if neither bpage nor the pages linked after it, towards the
+ *  head of the flush list, can have been modified before lsn_limit.
+ */
+static bool is_past_lsn_limit(const Buf_page *bpage, lsn_t lsn_limit) {
+  return bpage->m_oldest_modification >= lsn_limit && bpage->m_oldest_modification - lsn_limit >= BUF_FLUSH_LIST_SLACK;
+}
 
 Buf_page *Buf_flush::insert_in_flush_rbt(Buf_page *bpage) {
   Buf_page *prev = nullptr;
 
-  ut_ad(m_buf_pool->mutex_is_owned());
+  ut_ad(m_buf_pool->flush_list_mutex_is_owned());
 
   /* Insert this buffer into the rbt. */
   auto insert_result = flush_set_insert(m_buf_pool->m_recovery_flush_list, bpage);
@@ -58,7 +78,7 @@ Buf_page *Buf_flush::insert_in_flush_rbt(Buf_page *bpage) {
 }
 
 void Buf_flush::delete_from_flush_rbt(Buf_page *bpage) {
-  ut_ad(m_buf_pool->mutex_is_owned());
+  ut_ad(m_buf_pool->flush_list_mutex_is_owned());
 
   auto ret = flush_set_erase(m_buf_pool->m_recovery_flush_list, bpage);
   ut_a(ret);
@@ -89,14 +109,16 @@ bool Buf_flush::block_cmp(const Buf_page *b1, const Buf_page *b2) {
 }
 
 void Buf_flush::init_flush_list() {
-  ut_ad(m_buf_pool->mutex_is_owned());
+  m_buf_pool->flush_list_mutex_acquire();
 
   /* Create red black tree for speedy insertions in flush list. */
   m_buf_pool->m_recovery_flush_list = flush_set_create(block_cmp);
+
+  m_buf_pool->flush_list_mutex_release();
 }
 
 void Buf_flush::free_flush_list() {
-  mutex_enter(&m_buf_pool->m_mutex);
+  m_buf_pool->flush_list_mutex_acquire();
 
 #if defined UNIV_DEBUG || defined UNIV_BUF_DEBUG
   ut_a(validate_low());
@@ -105,14 +127,14 @@ void Buf_flush::free_flush_list() {
   flush_set_destroy(m_buf_pool->m_recovery_flush_list);
   m_buf_pool->m_recovery_flush_list = nullptr;
 
-  mutex_exit(&m_buf_pool->m_mutex);
+  m_buf_pool->flush_list_mutex_release();
 }
 
 void Buf_flush::insert_into_flush_list(Buf_block *block) {
-  ut_ad(m_buf_pool->mutex_is_owned());
+  ut_ad(m_buf_pool->flush_list_mutex_is_owned());
   ut_ad(
     (UT_LIST_GET_FIRST(m_buf_pool->m_flush_list) == nullptr) ||
-    (UT_LIST_GET_FIRST(m_buf_pool->m_flush_list)->m_oldest_modification <= block->m_page.m_oldest_modification)
+    (UT_LIST_GET_FIRST(m_buf_pool->m_flush_list)->m_oldest_modification <= block->m_page.m_oldest_modification + BUF_FLUSH_LIST_SLACK)
   );
 
   /* If we are in the recovery then we need to update the flush
@@ -122,6 +144,11 @@ void Buf_flush::insert_into_flush_list(Buf_block *block) {
     return;
   }
 
+  if (srv_buf_l2 != nullptr) {
+    /* The copy in the L2 cache is stale from now on. */
+    srv_buf_l2->invalidate(block->get_space(), block->get_page_no());
+  }
+
   ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
   ut_ad(block->m_page.m_in_LRU_list);
   ut_ad(block->m_page.m_in_page_hash);
@@ -135,7 +162,7 @@ void Buf_flush::insert_into_flush_list(Buf_block *block) {
 }
 
 void Buf_flush::insert_sorted_into_flush_list(Buf_block *block) {
-  ut_ad(m_buf_pool->mutex_is_owned());
+  ut_ad(m_buf_pool->flush_list_mutex_is_owned());
   ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
 
   ut_ad(block->m_page.m_in_LRU_list);
@@ -143,6 +170,10 @@ void Buf_flush::insert_sorted_into_flush_list(Buf_block *block) {
   ut_ad(!block->m_page.m_in_flush_list);
   ut_d(block->m_page.m_in_flush_list = true);
 
+  if (srv_buf_l2 != nullptr) {
+    srv_buf_l2->invalidate(block->get_space(), block->get_page_no());
+  }
+
   Buf_page *prev_b{};
 
   /* For the most part when this function is called the m_recovery_flush_list
@@ -223,6 +254,8 @@ void Buf_flush::remove(Buf_page *bpage) {
   ut_ad(mutex_own(buf_page_get_mutex(bpage)));
   ut_ad(bpage->m_in_flush_list);
 
+  m_buf_pool->flush_list_mutex_acquire();
+
   switch (bpage->get_state()) {
     case BUF_BLOCK_NOT_USED:
     case BUF_BLOCK_READY_FOR_USE:
@@ -250,6 +283,8 @@ void Buf_flush::remove(Buf_page *bpage) {
     ut_ad(ptr->m_in_flush_list);
   };
   ut_list_validate(m_buf_pool->m_flush_list, check);
+
+  m_buf_pool->flush_list_mutex_release();
 }
 
 void Buf_flush::relocate_on_flush_list(Buf_page *bpage, Buf_page *dpage) {
@@ -261,6 +296,8 @@ void Buf_flush::relocate_on_flush_list(Buf_page *bpage, Buf_page *dpage) {
   ut_ad(bpage->m_in_flush_list);
   ut_ad(dpage->m_in_flush_list);
 
+  m_buf_pool->flush_list_mutex_acquire();
+
   /* If recovery is active we must swap the control blocks in
   the m_recovery_flush_list  as well. */
   if (likely_null(m_buf_pool->m_recovery_flush_list)) {
@@ -289,6 +326,8 @@ void Buf_flush::relocate_on_flush_list(Buf_page *bpage, Buf_page *dpage) {
 #if defined UNIV_DEBUG || defined UNIV_BUF_DEBUG
   ut_a(validate_low());
 #endif /* UNIV_DEBUG || UNIV_BUF_DEBUG */
+
+  m_buf_pool->flush_list_mutex_release();
 }
 
 void Buf_flush::write_complete(Buf_page *bpage) {
@@ -322,39 +361,126 @@ void Buf_flush::sync_datafiles() {
   /* Wait until all pending async writes are completed */
   srv_aio->wait_for_pending_ops(aio::WRITE);
 
-  /* Now we flush the data to disk (for example, with fsync) */
+  /* Now we flush the data to disk, the fsyncs of the files run in parallel */
   srv_fil->flush_file_spaces(FIL_TABLESPACE);
 
   return;
 }
 
-void Buf_flush::buffered_writes(DBLWR *dblwr) {
-  ulint len;
-  ulint len2;
-  byte *write_buf;
+/** The pages are chained with Buf_page::m_write_run_next, the first page is
+the message of the write and Buf_pool::io_complete() completes them all. */
+struct Buf_flush::Write_run {
+  Write_run() = default;
+
+  ~Write_run() noexcept {
+    ut_a(m_n_pages == 0);
+  }
+
+  Write_run(Write_run &&) = delete;
+  Write_run(const Write_run &) = delete;
+  Write_run &operator=(Write_run &&) = delete;
+  Write_run &operator=(const Write_run &) = delete;
+
+  /**
+   * Adds a page to the run, the pages collected so far are submitted first
+   * if the page does not follow them.
+   *
+   * @param bpage The page to write, io fixed for BUF_IO_WRITE.
+   * @param frame The frame of the page.
+   */
+  void add(Buf_page *bpage, byte *frame) noexcept {
+    const auto space = bpage->get_space();
+    const auto page_no = bpage->get_page_no();
+
+    if (m_n_pages > 0 && (space != m_space || page_no != m_page_no + m_n_pages || m_n_pages == m_iovs.size())) {
+      submit();
+    }
+
+    ut_ad(bpage->m_write_run_next == nullptr);
+
+    if (m_n_pages == 0) {
+      m_space = space;
+      m_page_no = page_no;
+      m_first = bpage;
+    } else {
+      m_last->m_write_run_next = bpage;
+    }
+
+    m_last = bpage;
+    m_iovs[m_n_pages++] = {frame, UNIV_PAGE_SIZE};
+
+    if (space == SYS_TABLESPACE) {
+      /* The system tablespace can be made of several files, a run could
+      cross a file boundary. */
+      submit();
+    } else if (srv_config.m_page_compression) {
+      /* Fil::io() compresses the pages that are written one at a time. */
+      submit();
+    }
+  }
+
+  /** Posts the write of the pages collected so far. */
+  void submit() noexcept {
+    if (m_n_pages == 1) {
+      srv_fil->io(IO_request::Async_write, true, m_space, m_page_no, 0, UNIV_PAGE_SIZE, m_iovs[0].iov_base, m_first);
+    } else if (m_n_pages > 1) {
+      (void) srv_fil->io_vectored(m_space, m_page_no, m_iovs.data(), m_n_pages, m_first);
+    }
+
+    m_n_pages = 0;
+    m_first = nullptr;
+    m_last = nullptr;
+  }
+
+  /** Tablespace of the pages. */
+  space_id_t m_space{};
+
+  /** Page number of the first page. */
+  page_no_t m_page_no{};
+
+  /** Number of pages in the run. */
+  ulint m_n_pages{};
 
+  /** First page of the run, the message of the write. */
+  Buf_page *m_first{};
+
+  /** Last page of the run. */
+  Buf_page *m_last{};
+
+  /** The frames of the pages. */
+  std::array<iovec, AIO::MAX_IOVS> m_iovs{};
+};
+
+void Buf_flush::buffered_writes(DBLWR *dblwr) {
   if (!srv_config.m_use_doublewrite_buf || dblwr == nullptr) {
     /* Sync the writes to the disk. */
     sync_datafiles();
     return;
   }
 
-  mutex_enter(&dblwr->m_mutex);
+  auto &slot = dblwr->get_slot(m_buf_pool->m_instance_no);
+
+  mutex_enter(&slot.m_mutex);
 
   /* Write first to doublewrite buffer blocks. We use synchronous
   aio and thus know that file write has been completed when the
   control returns. */
 
-  if (dblwr->m_first_free == 0) {
+  if (slot.m_first_free == 0) {
 
-    mutex_exit(&dblwr->m_mutex);
+    mutex_exit(&slot.m_mutex);
+
+    if (dblwr->may_bypass()) {
+      /* Pages may have been written in place. */
+      sync_datafiles();
+    }
 
     return;
   }
 
-  for (ulint i{}; i < dblwr->m_first_free; ++i) {
+  for (ulint i{}; i < slot.m_first_free; ++i) {
 
-    auto block = reinterpret_cast<const Buf_block *>(dblwr->m_bpages[i]);
+    auto block = reinterpret_cast<const Buf_block *>(slot.m_bpages[i]);
 
     if (block->get_state() != BUF_BLOCK_FILE_PAGE) {
       /* No simple validate for compressed pages exists. */
@@ -382,66 +508,48 @@ void Buf_flush::buffered_writes(DBLWR *dblwr) {
   }
 
   /* Increment the doublewrite flushed pages counter */
-  srv_dblwr_pages_written += dblwr->m_first_free;
-  ++srv_dblwr_writes;
-
-  len = ut_min(SYS_DOUBLEWRITE_BLOCK_SIZE, dblwr->m_first_free) * UNIV_PAGE_SIZE;
-
-  write_buf = dblwr->m_write_buf;
-
-  ulint i{};
-
-  srv_fil->io(IO_request::Sync_write, false, TRX_SYS_SPACE, dblwr->m_block1, 0, len, write_buf, nullptr);
-
-  for (len2 = 0; len2 + UNIV_PAGE_SIZE <= len; len2 += UNIV_PAGE_SIZE, i++) {
-    const Buf_block *block = reinterpret_cast<Buf_block *>(dblwr->m_bpages[i]);
-
-    if (likely(block->get_state() == BUF_BLOCK_FILE_PAGE) &&
-        unlikely(
-          memcmp(write_buf + len2 + (FIL_PAGE_LSN + 4), write_buf + len2 + (UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + 4), 4)
-        )) {
-
-      log_err(
-        "The page to be written seems corrupt! The lsn fields do not match!"
-        " Noticed in the doublewrite block1."
-      );
-    }
-  }
-
-  if (dblwr->m_first_free <= SYS_DOUBLEWRITE_BLOCK_SIZE) {
-    goto flush;
-  }
-
-  len = (dblwr->m_first_free - SYS_DOUBLEWRITE_BLOCK_SIZE) * UNIV_PAGE_SIZE;
-
-  write_buf = dblwr->m_write_buf + SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE;
-  ut_ad(i == SYS_DOUBLEWRITE_BLOCK_SIZE);
-
-  srv_fil->io(IO_request::Sync_write, false, TRX_SYS_SPACE, dblwr->m_block2, 0, len, (void *)write_buf, nullptr);
-
-  for (len2 = 0; len2 + UNIV_PAGE_SIZE <= len; len2 += UNIV_PAGE_SIZE, i++) {
-    const Buf_block *block = reinterpret_cast<Buf_block *>(dblwr->m_bpages[i]);
-
-    if (likely(block->get_state() == BUF_BLOCK_FILE_PAGE) &&
-        unlikely(memcmp(write_buf + len2 + (FIL_PAGE_LSN + 4), write_buf + len2 + (UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + 4), 4))) {
-      log_err(
-        "The page to be written seems corrupt! The lsn fields do not match!"
-        " Noticed in the doublewrite block2."
-      );
+  srv_dblwr_pages_written.inc(slot.m_first_free);
+  srv_dblwr_writes.inc();
+
+  /* A slot can straddle the two doublewrite blocks, write the part in
+  each block with one write. */
+  for (ulint i{}; i < slot.m_first_free;) {
+    const auto pos = slot.m_start + i;
+    const auto n = std::min(slot.m_first_free - i, SYS_DOUBLEWRITE_BLOCK_SIZE - pos % SYS_DOUBLEWRITE_BLOCK_SIZE);
+    auto write_buf = slot.m_write_buf + i * UNIV_PAGE_SIZE;
+
+    srv_fil->io(IO_request::Sync_write, false, TRX_SYS_SPACE, dblwr->get_page_no(pos), 0, n * UNIV_PAGE_SIZE, write_buf, nullptr);
+
+    for (ulint len{}; len < n * UNIV_PAGE_SIZE; len += UNIV_PAGE_SIZE, ++i) {
+      const Buf_block *block = reinterpret_cast<Buf_block *>(slot.m_bpages[i]);
+
+      if (likely(block->get_state() == BUF_BLOCK_FILE_PAGE) &&
+          unlikely(
+            memcmp(write_buf + len + (FIL_PAGE_LSN + 4), write_buf + len + (UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + 4), 4)
+          )) {
+
+        log_err(std::format(
+          "The page to be written seems corrupt! The lsn fields do not match!"
+          " Noticed in the doublewrite block{}.",
+          pos < SYS_DOUBLEWRITE_BLOCK_SIZE ? 1 : 2
+        ));
+      }
     }
   }
 
-flush:
   /* Now flush the doublewrite buffer data to disk */
 
   srv_fil->flush(TRX_SYS_SPACE);
 
   /* We know that the writes have been flushed to disk now
   and in recovery we will find them in the doublewrite buffer
-  blocks. Next do the writes to the intended positions. */
+  blocks. Next do the writes to the intended positions, the
+  pages of a flush area are consecutive and are written together. */
 
-  for (i = 0; i < dblwr->m_first_free; ++i) {
-    const Buf_block *block = reinterpret_cast<Buf_block *>(dblwr->m_bpages[i]);
+  Write_run run;
+
+  for (ulint i{}; i < slot.m_first_free; ++i) {
+    const Buf_block *block = reinterpret_cast<Buf_block *>(slot.m_bpages[i]);
 
     ut_a(block->m_page.in_file());
 
@@ -457,59 +565,54 @@ flush:
       ));
     }
 
-    srv_fil->io(
-      IO_request::Async_write,
-      true,
-      block->get_space(),
-      block->get_page_no(),
-      0,
-      UNIV_PAGE_SIZE,
-      (void *)block->m_frame,
-      (void *)block
-    );
+    run.add(slot.m_bpages[i], block->m_frame);
 
     /* Increment the counter of I/O operations used
     for selecting LRU policy. */
     m_buf_pool->m_LRU->stat_inc_io();
   }
 
+  run.submit();
+
   /* Sync the writes to the disk. */
   sync_datafiles();
 
   /* We can now reuse the doublewrite memory buffer: */
-  dblwr->m_first_free = 0;
+  slot.m_first_free = 0;
 
-  mutex_exit(&dblwr->m_mutex);
+  mutex_exit(&slot.m_mutex);
 }
 
 void Buf_flush::post_to_doublewrite_buf(DBLWR *dblwr, Buf_page *bpage) {
+  auto &slot = dblwr->get_slot(m_buf_pool->m_instance_no);
+
   for (;;) {
-    mutex_enter(&dblwr->m_mutex);
+    mutex_enter(&slot.m_mutex);
 
     ut_a(bpage->in_file());
 
-    if (dblwr->m_first_free < 2 * SYS_DOUBLEWRITE_BLOCK_SIZE) {
+    if (slot.m_first_free < slot.m_n_pages) {
       break;
     }
 
-    mutex_exit(&dblwr->m_mutex);
+    mutex_exit(&slot.m_mutex);
 
     buffered_writes(dblwr);
   }
 
   ut_a(bpage->get_state() == BUF_BLOCK_FILE_PAGE);
 
-  memcpy(dblwr->m_write_buf + UNIV_PAGE_SIZE * dblwr->m_first_free, reinterpret_cast<Buf_block *>(bpage)->m_frame, UNIV_PAGE_SIZE);
+  memcpy(slot.m_write_buf + UNIV_PAGE_SIZE * slot.m_first_free, reinterpret_cast<Buf_block *>(bpage)->m_frame, UNIV_PAGE_SIZE);
 
-  dblwr->m_bpages[dblwr->m_first_free] = bpage;
+  slot.m_bpages[slot.m_first_free] = bpage;
 
-  ++dblwr->m_first_free;
+  ++slot.m_first_free;
 
-  if (dblwr->m_first_free >= 2 * SYS_DOUBLEWRITE_BLOCK_SIZE) {
-    mutex_exit(&dblwr->m_mutex);
+  if (slot.m_first_free >= slot.m_n_pages) {
+    mutex_exit(&slot.m_mutex);
     buffered_writes(dblwr);
   } else {
-    mutex_exit(&dblwr->m_mutex);
+    mutex_exit(&slot.m_mutex);
   }
 }
 
@@ -519,19 +622,18 @@ void Buf_flush::init_for_writing(byte *page, lsn_t newest_lsn) {
 
   mach_write_to_8(page + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM, newest_lsn);
 
-  /* Store the new formula checksum */
+  /* Store the CRC32C checksum in the header and, in place of the first
+4 bytes of the end lsn field, in the trailer. The checksum covers
+neither field. */
 
-  mach_write_to_4(page + FIL_PAGE_SPACE_OR_CHKSUM, buf_page_data_calc_checksum(page));
+  const auto checksum = buf_page_calc_crc32c(page);
 
-  /* We overwrite the first 4 bytes of the end lsn field to store
-  the old formula checksum. Since it depends also on the field
-  FIL_PAGE_SPACE_OR_CHKSUM, it has to be calculated after storing the
-  new formula checksum. */
+  mach_write_to_4(page + FIL_PAGE_SPACE_OR_CHKSUM, checksum);
 
-  mach_write_to_4(page + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM, BUF_NO_CHECKSUM_MAGIC);
+  mach_write_to_4(page + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM, checksum);
 }
 
-void Buf_flush::write_block_low(DBLWR *dblwr, Buf_page *bpage) {
+void Buf_flush::write_block_low(DBLWR *dblwr, Buf_page *bpage, Write_run *run) {
   page_t *frame = nullptr;
 
   ut_ad(bpage->in_file());
@@ -563,14 +665,20 @@ void Buf_flush::write_block_low(DBLWR *dblwr, Buf_page *bpage) {
       break;
   }
 
-  if (!srv_config.m_use_doublewrite_buf || dblwr == nullptr) {
-    srv_fil->io(IO_request::Async_write, true, bpage->get_space(), bpage->get_page_no(), 0, UNIV_PAGE_SIZE, frame, bpage);
-  } else {
+  const auto use_doublewrite = srv_config.m_use_doublewrite_buf && dblwr != nullptr;
+
+  if (use_doublewrite && !dblwr->is_bypassed(bpage->get_space())) {
     post_to_doublewrite_buf(dblwr, bpage);
+  } else if (run != nullptr && !use_doublewrite) {
+    /* A bypassed page relies on RWF_ATOMIC, which covers a single buffer,
+    it cannot be part of a vectored write. */
+    run->add(bpage, frame);
+  } else {
+    srv_fil->io(IO_request::Async_write, true, bpage->get_space(), bpage->get_page_no(), 0, UNIV_PAGE_SIZE, frame, bpage);
   }
 }
 
-inline static bool free_page_if_truncated(Buf_pool *buf_pool, Buf_page *bpage) {
+inline static bool free_page_if_truncated(Buf_pool_instance *buf_pool, Buf_page *bpage) {
   ut_a(bpage != nullptr);
 
   ut_ad(buf_pool->mutex_is_owned());
@@ -582,8 +690,8 @@ inline static bool free_page_if_truncated(Buf_pool *buf_pool, Buf_page *bpage) {
   bool page_from_flush_list = bpage->m_oldest_modification != 0;
 
   if (table_truncated) {
-    log_err(std::format("freeing a page from truncated table, tablespace_id: {}, page_no: {}", space, bpage->m_page_no));
-    // free up the page.
+    /* The tablespace was dropped, the page is freed lazily here or by
+    Buf_LRU::sweep_dropped(). */
     buf_pool->m_LRU->free_block(bpage, nullptr);
 
     if (page_from_flush_list) {
@@ -596,7 +704,7 @@ inline static bool free_page_if_truncated(Buf_pool *buf_pool, Buf_page *bpage) {
   return false;
 }
 
-void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type) {
+void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type, Write_run *run) {
   ut_ad(m_buf_pool->mutex_is_owned());
   ut_ad(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
   ut_ad(bpage->in_file());
@@ -639,6 +747,11 @@ void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type) {
       m_flush_list or LRU_list. */
 
       if (!is_s_latched) {
+        /* The latch holder may wait for one of the pages of the run. */
+        if (run != nullptr) {
+          run->submit();
+        }
+
         buffered_writes(dblwr);
 
         rw_lock_s_lock_gen(&((Buf_block *)bpage)->m_rw_lock, BUF_IO_WRITE);
@@ -673,17 +786,59 @@ void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type) {
   m_oldest_modification != 0.  Thus, it cannot be relocated in the
   buffer pool or removed from m_flush_list or LRU_list. */
 
-  write_block_low(dblwr, bpage);
+  IB_PROBE(page__flush, bpage->get_space(), bpage->get_page_no(), int(flush_type), bpage->m_oldest_modification);
+
+  write_block_low(dblwr, bpage, run);
+}
+
+flush_neighbors_t Buf_flush::get_neighbors_mode() noexcept {
+  const auto mode = flush_neighbors_t(srv_config.m_flush_neighbors);
+
+  if (mode != FLUSH_NEIGHBORS_AUTO) {
+    return mode;
+  }
+
+  const auto latency = srv_aio->get_write_latency();
+
+  /* Until a write has completed assume a rotating disk. */
+  if (latency.count() == 0 || latency >= FLUSH_NEIGHBORS_SEEK_LATENCY) {
+    return FLUSH_NEIGHBORS_AREA;
+  } else {
+    return FLUSH_NEIGHBORS_OFF;
+  }
+}
+
+bool Buf_flush::is_flushable_neighbor(space_id_t space, page_no_t page_no, buf_flush flush_type) {
+  ut_ad(m_buf_pool->mutex_is_owned());
+
+  auto bpage = m_buf_pool->hash_get_page(space, page_no);
+
+  if (bpage == nullptr) {
+    return false;
+  }
+
+  auto block_mutex = buf_page_get_mutex(bpage);
+
+  mutex_enter(block_mutex);
+
+  /* The same conditions as for the neighbors in try_neighbors(). */
+  const auto flushable = (flush_type != BUF_FLUSH_LRU || buf_page_is_old(bpage)) && ready_for_flush(bpage, flush_type) &&
+                         bpage->m_buf_fix_count == 0;
+
+  mutex_exit(block_mutex);
+
+  return flushable;
 }
 
 ulint Buf_flush::try_neighbors(DBLWR* dblwr, space_id_t space, page_no_t page_no, buf_flush flush_type) {
   ulint count{};
   page_no_t low;
   page_no_t high;
+  const auto mode = get_neighbors_mode();
 
   ut_ad(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
 
-  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < Buf_LRU::OLD_MIN_LEN) {
+  if (mode == FLUSH_NEIGHBORS_OFF || UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < Buf_LRU::OLD_MIN_LEN) {
     /* If there is little space, it is better not to flush any
     block except from the end of the LRU list */
 
@@ -705,36 +860,44 @@ ulint Buf_flush::try_neighbors(DBLWR* dblwr, space_id_t space, page_no_t page_no
     high = srv_fil->space_get_size(space);
   }
 
+  Write_run run;
+
   m_buf_pool->mutex_acquire();
 
-  for (auto i = low; i < high; ++i) {
+  if (mode == FLUSH_NEIGHBORS_CONTIGUOUS) {
+    /* Start from the first page of the dirty run that ends at page_no. */
+    auto first = page_no;
 
-    auto bpage = m_buf_pool->hash_get_page(space, i);
+    while (first > low && is_flushable_neighbor(space, first - 1, flush_type)) {
+      --first;
+    }
 
-    if (bpage == nullptr) {
+    low = first;
+  }
 
-      continue;
-    }
+  for (auto i = low; i < high; ++i) {
+    bool flushed{};
 
-    {
+    auto bpage = m_buf_pool->hash_get_page(space, i);
+
+    if (bpage != nullptr) {
       auto block_mutex = buf_page_get_mutex(bpage);
 
       mutex_enter(block_mutex);
 
       if (free_page_if_truncated(m_buf_pool, bpage)) {
-        mutex_exit(block_mutex);
-        continue;
+        bpage = nullptr;
       }
 
       mutex_exit(block_mutex);
     }
 
-    ut_a(bpage->in_file());
+    ut_a(bpage == nullptr || bpage->in_file());
 
     /* We avoid flushing 'non-old' blocks in an LRU flush,
     because the flushed blocks are soon freed */
 
-    if (flush_type != BUF_FLUSH_LRU || i == page_no || buf_page_is_old(bpage)) {
+    if (bpage != nullptr && (flush_type != BUF_FLUSH_LRU || i == page_no || buf_page_is_old(bpage))) {
       auto block_mutex = buf_page_get_mutex(bpage);
 
       mutex_enter(block_mutex);
@@ -745,19 +908,27 @@ ulint Buf_flush::try_neighbors(DBLWR* dblwr, space_id_t space, page_no_t page_no
         Semaphore waits are expensive because we must flush the doublewrite buffer before
         we start waiting. */
 
-        page(dblwr, bpage, flush_type);
+        page(dblwr, bpage, flush_type, &run);
         ut_ad(!mutex_own(block_mutex));
         ++count;
+        flushed = true;
 
         m_buf_pool->mutex_acquire();
       } else {
         mutex_exit(block_mutex);
       }
     }
+
+    if (!flushed && i > page_no && mode == FLUSH_NEIGHBORS_CONTIGUOUS) {
+      /* The dirty run that contains page_no ends here. */
+      break;
+    }
   }
 
   m_buf_pool->mutex_release();
 
+  run.submit();
+
   return count;
 }
 
@@ -799,8 +970,11 @@ ulint Buf_flush::batch(DBLWR *dblwr, buf_flush flush_type, ulint min_n, uint64_t
     } else {
       ut_ad(flush_type == BUF_FLUSH_LIST);
 
+      m_buf_pool->flush_list_mutex_acquire();
       bpage = UT_LIST_GET_LAST(m_buf_pool->m_flush_list);
-      if (!bpage || bpage->m_oldest_modification >= lsn_limit) {
+      m_buf_pool->flush_list_mutex_release();
+
+      if (!bpage || is_past_lsn_limit(bpage, lsn_limit)) {
         /* We have flushed enough */
 
         break;
@@ -821,7 +995,9 @@ ulint Buf_flush::batch(DBLWR *dblwr, buf_flush flush_type, ulint min_n, uint64_t
       ut_a(bpage->in_file());
 
       mutex_enter(block_mutex);
-      if (!free_page_if_truncated(m_buf_pool, bpage)) {
+      if (flush_type == BUF_FLUSH_LIST && bpage->m_oldest_modification >= lsn_limit) {
+        /* Linked out of order, younger than the limit. */
+      } else if (!free_page_if_truncated(m_buf_pool, bpage)) {
         ready = ready_for_flush(bpage, flush_type);
       }
       mutex_exit(block_mutex);
@@ -843,8 +1019,15 @@ ulint Buf_flush::batch(DBLWR *dblwr, buf_flush flush_type, ulint min_n, uint64_t
       } else {
         ut_ad(flush_type == BUF_FLUSH_LIST);
 
+        m_buf_pool->flush_list_mutex_acquire();
         bpage = UT_LIST_GET_PREV(m_list, bpage);
+        m_buf_pool->flush_list_mutex_release();
+
         ut_ad(!bpage || bpage->m_in_flush_list);
+
+        if (bpage != nullptr && is_past_lsn_limit(bpage, lsn_limit)) {
+          bpage = nullptr;
+        }
       }
     } while (bpage != nullptr);
 
@@ -866,14 +1049,10 @@ ulint Buf_flush::batch(DBLWR *dblwr, buf_flush flush_type, ulint min_n, uint64_t
 
   buffered_writes(dblwr);
 
-  srv_buf_pool_flushed += page_count;
+  /* Submit the writes that are still held back for coalescing. */
+  srv_aio->submit_batch();
 
-  /* We keep track of all flushes happening as part of LRU
-  flush. When estimating the desired rate at which m_flush_list
-  should be flushed we factor in this value. */
-  if (flush_type == BUF_FLUSH_LRU) {
-    m_LRU_flush_page_count += page_count;
-  }
+  srv_buf_pool_flushed.inc(page_count);
 
   return page_count;
 }
@@ -896,7 +1075,7 @@ ulint Buf_flush::LRU_recommendation() {
   bpage = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list);
 
   while (bpage != nullptr && n_replaceable < get_free_block_margin() + get_extra_margin() &&
-         (distance < Buf_LRU::get_free_search_len())) {
+         (distance < m_buf_pool->m_LRU->get_free_search_len())) {
 
     auto block_mutex = buf_page_get_mutex(bpage);
 
@@ -941,81 +1120,44 @@ void Buf_flush::free_margin(DBLWR *dblwr) {
   }
 }
 
-void Buf_flush::stat_update() {
-  auto lsn = log_sys->get_lsn();
-
-  if (m_stat_cur.m_redo == 0) {
-    /* First time around. Just update the current LSN and return. */
-    m_stat_cur.m_redo = lsn;
-    return;
-  }
+ulint Buf_flush::get_n_pages_older_than(lsn_t lsn_limit, ulint max_pages) const {
+  ulint n_pages{};
 
-  auto item = &m_stats[m_stat_ind];
+  m_buf_pool->flush_list_mutex_acquire();
 
-  /* values for this interval */
-  auto lsn_diff = lsn - m_stat_cur.m_redo;
-  auto n_flushed = m_LRU_flush_page_count - m_stat_cur.m_n_flushed;
+  for (auto bpage = UT_LIST_GET_LAST(m_buf_pool->m_flush_list);
+       bpage != nullptr && n_pages < max_pages && !is_past_lsn_limit(bpage, lsn_limit);
+       bpage = UT_LIST_GET_PREV(m_list, bpage)) {
 
-  /* add the current value and subtract the obsolete entry. */
-  m_stat_sum.m_redo += lsn_diff - item->m_redo;
-  m_stat_sum.m_n_flushed += n_flushed - item->m_n_flushed;
+    ut_ad(bpage->m_in_flush_list);
 
-  /* put current entry in the array. */
-  item->m_redo = lsn_diff;
-  item->m_n_flushed = n_flushed;
+    if (bpage->m_oldest_modification < lsn_limit) {
+      ++n_pages;
+    }
+  }
 
-  /* update the index */
-  ++m_stat_ind;
-  m_stat_ind %= m_stats.size();
+  m_buf_pool->flush_list_mutex_release();
 
-  /* reset the current entry. */
-  m_stat_cur.m_redo = lsn;
-  m_stat_cur.m_n_flushed = m_LRU_flush_page_count;
+  return n_pages;
 }
 
-ulint Buf_flush::get_desired_flush_rate() {
-  auto lsn = log_sys->get_lsn();
-  auto log_capacity = log_sys->get_capacity();
-
-  /* log_capacity should never be zero after the initialization of log subsystem. */
-  ut_ad(log_capacity != 0);
-
-  /* Get total number of dirty pages. It is OK to access m_flush_list without holding
-  any mtex as we are using this only for heuristics. */
-  auto n_dirty = UT_LIST_GET_LEN(m_buf_pool->m_flush_list);
-
-  /* An overflow can happen if we generate more than 2^32 bytes of redo in this
-  interval i.e.: 4G of redo in 1 second. We can safely consider this as infinity
-  because if we ever come close to 4G we'll start a synchronous flush of dirty pages.
-
-  Redo_avg below is average at which redo is generated in past STAT_N_INTERVAL 
-  redo generated in the current interval. */
-  auto redo_avg = ulint(m_stat_sum.m_redo / STAT_N_INTERVAL + (lsn - m_stat_cur.m_redo));
-
-  /* An overflow can happen possibly if we flush more than 2^32 pages in STAT_N_INTERVAL.
-  This is a very very unlikely scenario. Even when this happens it means that our flush
-  rate will be off the mark. It won't affect correctness of any subsystem.
-
-  lru_flush_avg below is rate at which pages are flushed as part of LRU flush in
-  past STAT_N_INTERVAL the number of pages flushed in the current interval. */
-
-  auto lru_flush_avg = m_stat_sum.m_n_flushed / STAT_N_INTERVAL + (m_LRU_flush_page_count - m_stat_cur.m_n_flushed);
-
-  auto n_flush_req = (n_dirty * redo_avg) / log_capacity;
-
-  /* The number of pages that we want to flush from the flush
-  list is the difference between the required rate and the
-  number of pages that we are historically flushing from the
-  LRU list */
-  lint rate = n_flush_req - lru_flush_avg;
-
-  return rate > 0 ? ulint(rate) : 0;
+void Buf_flush::request_free_margin(DBLWR *dblwr) {
+  if (srv_page_cleaner != nullptr && srv_page_cleaner->is_running()) {
+    /* Dirty read, this is only a hint for the page cleaner. */
+    if (UT_LIST_GET_LEN(m_buf_pool->m_free_list) < get_free_block_margin()) {
+      srv_page_cleaner->wakeup();
+    }
+  } else {
+    free_margin(dblwr);
+  }
 }
 
 #if defined UNIV_DEBUG
 bool Buf_flush::validate_low() {
   std::optional<Buf_page_set_itr> rnode{};
 
+  ut_ad(m_buf_pool->flush_list_mutex_is_owned());
+
   UT_LIST_CHECK(m_buf_pool->m_flush_list);
 
   auto bpage = UT_LIST_GET_FIRST(m_buf_pool->m_flush_list);
@@ -1045,7 +1187,11 @@ bool Buf_flush::validate_low() {
 
     bpage = UT_LIST_GET_NEXT(m_list, bpage);
 
-    ut_a(!bpage || om >= bpage->m_oldest_modification);
+    if (m_buf_pool->m_recovery_flush_list != nullptr) {
+      ut_a(!bpage || om >= bpage->m_oldest_modification);
+    } else {
+      ut_a(!bpage || om + BUF_FLUSH_LIST_SLACK >= bpage->m_oldest_modification);
+    }
   }
 
   /* By this time we must have exhausted the traversal of
@@ -1056,12 +1202,371 @@ bool Buf_flush::validate_low() {
 }
 
 bool Buf_flush::validate() {
-  m_buf_pool->mutex_acquire();
+  m_buf_pool->flush_list_mutex_acquire();
 
   auto ret = validate_low();
 
-  m_buf_pool->mutex_release();
+  m_buf_pool->flush_list_mutex_release();
 
   return ret;
 }
 #endif /* UNIV_DEBUG */
+
+Page_cleaner::Page_cleaner(ulint n_threads) noexcept
+  : m_n_threads(std::max(ulint(1), n_threads)),
+    m_wakeup_event(os_event_create("page_cleaner_wakeup")),
+    m_round_event(os_event_create("page_cleaner_round")),
+    m_done_event(os_event_create("page_cleaner_done")),
+    m_n_flush_list(srv_buf_pool->get_n_instances()) {}
+
+Page_cleaner::~Page_cleaner() noexcept {
+  ut_a(!is_running());
+  ut_a(m_threads.empty());
+
+  os_event_free(m_wakeup_event);
+  os_event_free(m_round_event);
+  os_event_free(m_done_event);
+}
+
+Page_cleaner *Page_cleaner::create(ulint n_threads) noexcept {
+  auto ptr = ut_new(sizeof(Page_cleaner));
+  return ptr == nullptr ? nullptr : new (ptr) Page_cleaner(n_threads);
+}
+
+void Page_cleaner::destroy(Page_cleaner *&page_cleaner) noexcept {
+  call_destructor(page_cleaner);
+  ut_delete(page_cleaner);
+  page_cleaner = nullptr;
+}
+
+void Page_cleaner::start() noexcept {
+  ut_a(m_threads.empty());
+
+  m_shutdown.store(false, std::memory_order_release);
+
+  m_threads.reserve(m_n_threads);
+
+  m_threads.emplace_back(create_joinable_thread(&Page_cleaner::coordinator, this));
+
+  for (ulint i = 1; i < m_n_threads; ++i) {
+    m_threads.emplace_back(create_joinable_thread(&Page_cleaner::worker, this));
+  }
+
+  m_running.store(true, std::memory_order_release);
+
+  log_info(std::format("Started {} page cleaner thread(s)", m_n_threads));
+}
+
+void Page_cleaner::shutdown() noexcept {
+  if (!is_running()) {
+    return;
+  }
+
+  /* From now on the user threads flush in the foreground. */
+  m_running.store(false, std::memory_order_release);
+
+  m_shutdown.store(true, std::memory_order_release);
+
+  /* The coordinator wakes up the workers when it exits. */
+  os_event_set(m_wakeup_event);
+
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+
+  m_threads.clear();
+}
+
+void Page_cleaner::wakeup() noexcept {
+  os_event_set(m_wakeup_event);
+}
+
+ulint Page_cleaner::get_pct_for_dirty() const noexcept {
+  const auto dirty_pct = srv_buf_pool->get_modified_ratio_pct();
+  const auto max_dirty_pct = srv_config.m_max_buf_pool_modified_pct;
+
+  if (dirty_pct > max_dirty_pct) {
+
+    /* Try to keep the number of modified pages in the buffer pool under the
+    limit wished by the user */
+    return 100;
+
+  } else if (srv_config.m_adaptive_flushing && dirty_pct >= max_dirty_pct / 2) {
+
+    /* Ramp up linearly as we approach the limit, instead of switching from
+    nothing to full capacity when it is crossed. */
+    return dirty_pct * 100 / (max_dirty_pct + 1);
+
+  } else {
+
+    return 0;
+  }
+}
+
+ulint Page_cleaner::get_pct_for_age(lsn_t age) const noexcept {
+  const auto lwm = log_sys->get_capacity() / 100 * ADAPTIVE_FLUSHING_LWM;
+
+  if (!srv_config.m_adaptive_flushing || age < lwm) {
+    return 0;
+  }
+
+  /* The age factor is 100 when the asynchronous preflush threshold is reached.
+  The percentage grows faster than linearly so that the flushing rate is low
+  when the age is small, and is well above io_capacity by the time the user
+  threads would start preflushing by themselves:
+
+    age factor    10    50    100   116 (the synchronous threshold)
+    percentage     4    47    133   166 */
+  const auto max_age = std::max(log_sys->get_max_modified_age_async(), ulint(1));
+  const auto age_factor = double(age) * 100.0 / double(max_age);
+
+  return ulint(age_factor * std::sqrt(age_factor) / 7.5);
+}
+
+ulint Page_cleaner::get_flush_list_targets(ulint now) noexcept {
+  const auto n_instances = srv_buf_pool->get_n_instances();
+  const auto lsn = log_sys->get_lsn();
+
+  /* 1. Update the smoothed rates, the first round only takes the samples. */
+  const auto n_flushed = m_n_flushed.exchange(0);
+
+  if (m_prev_time == 0) {
+    m_prev_lsn = lsn;
+    m_prev_time = now;
+  } else if (now > m_prev_time) {
+    const auto elapsed = double(now - m_prev_time) / 1000.0;
+    const auto lsn_rate = double(lsn - m_prev_lsn) / elapsed;
+    const auto page_rate = double(n_flushed) / elapsed;
+
+    m_lsn_rate_avg = (m_lsn_rate_avg * (FLUSH_AVG_ROUNDS - 1) + lsn_rate) / FLUSH_AVG_ROUNDS;
+    m_page_rate_avg = (m_page_rate_avg * (FLUSH_AVG_ROUNDS - 1) + page_rate) / FLUSH_AVG_ROUNDS;
+
+    m_prev_lsn = lsn;
+    m_prev_time = now;
+  }
+
+  std::fill(m_n_flush_list.begin(), m_n_flush_list.end(), 0);
+
+  const auto oldest_lsn = srv_buf_pool->get_oldest_modification();
+
+  if (oldest_lsn == 0) {
+    /* There are no dirty pages. */
+    return 0;
+  }
+
+  const auto pct_for_dirty = get_pct_for_dirty();
+
+  if (!srv_config.m_adaptive_flushing) {
+    const auto n_pages = ulint(PCT_IO(pct_for_dirty));
+
+    std::fill(m_n_flush_list.begin(), m_n_flush_list.end(), (n_pages + n_instances - 1) / n_instances);
+
+    return n_pages;
+  }
+
+  const auto age = lsn > oldest_lsn ? lsn - oldest_lsn : 0;
+  const auto pct_for_age = get_pct_for_age(age);
+  const ulint max_pages = PCT_IO(MAX_IO_PCT);
+
+  /* 2. Count the pages that must be flushed for the oldest modification to
+  keep up with one second worth of redo generation. */
+  const auto lsn_limit = oldest_lsn + lsn_t(m_lsn_rate_avg);
+
+  ulint n_pages_for_lsn{};
+
+  for (ulint i{}; i < n_instances; ++i) {
+    auto flusher = srv_buf_pool->get_instance_at(i)->m_flusher.get();
+
+    m_n_flush_list[i] = flusher->get_n_pages_older_than(lsn_limit, max_pages);
+    n_pages_for_lsn += m_n_flush_list[i];
+  }
+
+  /* 3. Average the three estimates. On its own the percentage jumps with the
+  dirty page ratio and the checkpoint age, and the page count jumps with
+  bursts of redo. The smoothed page rate makes the controller remember what
+  it did in the past rounds. */
+  const auto pct_total = std::max(pct_for_dirty, pct_for_age);
+
+  auto n_pages = ulint((PCT_IO(pct_total) + m_page_rate_avg + double(n_pages_for_lsn)) / 3.0);
+
+  if (pct_for_dirty == 100) {
+    n_pages = std::max(n_pages, ulint(PCT_IO(100)));
+  }
+
+  n_pages = throttle_for_reads(std::min(n_pages, max_pages), pct_for_dirty, pct_for_age);
+
+  /* 4. Distribute the pages over the instances. When the checkpoint age is the
+  concern, the instances that hold the oldest modifications flush more,
+  otherwise the pages are spread evenly. */
+  const auto by_age = pct_for_age > 30 && n_pages_for_lsn > 0;
+
+  for (auto &n : m_n_flush_list) {
+    if (by_age) {
+      n = (n_pages * n + n_pages_for_lsn - 1) / n_pages_for_lsn;
+    } else {
+      n = (n_pages + n_instances - 1) / n_instances;
+    }
+  }
+
+  return n_pages;
+}
+
+ulint Page_cleaner::throttle_for_reads(ulint n_pages, ulint pct_for_dirty, ulint pct_for_age) const noexcept {
+  if (!srv_config.m_flush_read_throttle || pct_for_dirty >= 100 || pct_for_age >= 100) {
+    return n_pages;
+  }
+
+  const auto stats = srv_aio->get_class_stats(IO_class::Foreground_read);
+  const auto limit = stats.m_baseline * READ_LATENCY_THROTTLE;
+
+  if (stats.m_baseline.count() == 0 || stats.m_latency <= limit) {
+    return n_pages;
+  }
+
+  /* Flush in proportion to how far the reads are above the limit, but keep
+  the flushing going. */
+  const auto throttled = ulint(double(n_pages) * double(limit.count()) / double(stats.m_latency.count()));
+
+  return std::max(throttled, std::min(n_pages, ulint(PCT_IO(10))));
+}
+
+void Page_cleaner::flush_instance(Buf_pool_instance *buf_pool, ulint n_flush_list) noexcept {
+  auto flusher = buf_pool->m_flusher.get();
+
+  /* With the instances bound to NUMA nodes, flush from the node of the
+  instance unless the page cleaner has CPUs of its own. */
+  if (!os_thread_class_is_bound(OS_THREAD_CLASS_FLUSH)) {
+    static thread_local ulint bound_node{ULINT_UNDEFINED};
+    const auto node = buf_pool->get_numa_node();
+
+    if (node != ULINT_UNDEFINED && node != bound_node) {
+      bound_node = node;
+      os_thread_bind_to_numa_node(node);
+    }
+  }
+
+  /* 1. Flush the dirty pages at the LRU tail. The writes complete asynchronously,
+  the blocks are moved to the free list by step 2 of a later round. */
+  flusher->free_margin(srv_dblwr);
+
+  /* 2. Move clean blocks from the LRU tail to the free list. The free list
+  length is a dirty read, it is only used for heuristics. */
+  const auto target = flusher->get_free_block_margin();
+
+  for (ulint i{}; i < target && UT_LIST_GET_LEN(buf_pool->m_free_list) < target; ++i) {
+    if (!buf_pool->m_LRU->search_and_free_block(0)) {
+      break;
+    }
+  }
+
+  /* 3. Flush the oldest dirty pages from the flush list. */
+  if (n_flush_list > 0) {
+    const auto n_flushed = flusher->batch(srv_dblwr, BUF_FLUSH_LIST, n_flush_list, IB_UINT64_T_MAX);
+
+    if (n_flushed != ULINT_UNDEFINED) {
+      m_n_flushed.fetch_add(n_flushed);
+    }
+  }
+}
+
+void Page_cleaner::process_instances() noexcept {
+  const auto n_instances = srv_buf_pool->get_n_instances();
+
+  for (;;) {
+    const auto i = m_next_instance.fetch_add(1);
+
+    if (i >= n_instances) {
+      break;
+    }
+
+    flush_instance(srv_buf_pool->get_instance_at(i), m_n_flush_list[i]);
+
+    if (m_n_pending.fetch_sub(1) == 1) {
+      /* This was the last instance of the round. */
+      os_event_set(m_done_event);
+    }
+  }
+}
+
+void Page_cleaner::run_round() noexcept {
+  const auto n_instances = srv_buf_pool->get_n_instances();
+
+  m_n_pending.store(n_instances);
+  m_next_instance.store(0);
+
+  auto sig_count = os_event_reset(m_done_event);
+
+  m_round.fetch_add(1);
+
+  if (m_n_threads > 1) {
+    os_event_set(m_round_event);
+  }
+
+  process_instances();
+
+  while (m_n_pending.load() > 0) {
+    os_event_wait_low(m_done_event, sig_count);
+    sig_count = os_event_reset(m_done_event);
+  }
+}
+
+void Page_cleaner::coordinator() noexcept {
+  os_thread_bind(OS_THREAD_CLASS_FLUSH);
+
+  auto next_flush_list_time = ut_time_ms();
+
+  while (!m_shutdown.load(std::memory_order_acquire)) {
+    const auto sig_count = os_event_reset(m_wakeup_event);
+    const auto now = ut_time_ms();
+
+    ulint n_flush_list{};
+
+    /* Flush the flush lists at most once a second, user threads that run
+    short of free blocks can request LRU rounds more often than that. */
+    if (now >= next_flush_list_time) {
+      n_flush_list = get_flush_list_targets(now);
+      next_flush_list_time = now + 1000;
+    } else {
+      std::fill(m_n_flush_list.begin(), m_n_flush_list.end(), 0);
+    }
+
+    run_round();
+
+    if (n_flush_list > 0) {
+      const auto oldest_lsn = srv_buf_pool->get_oldest_modification();
+
+      if (oldest_lsn != 0 && log_sys->get_lsn() - oldest_lsn > log_sys->get_max_modified_age_async()) {
+        /* We are about to make the user threads preflush, start the next
+        round without sleeping. */
+        next_flush_list_time = 0;
+        continue;
+      }
+    }
+
+    (void) m_wakeup_event->wait_time(std::chrono::seconds(1), sig_count);
+  }
+
+  /* Let the workers exit. */
+  os_event_set(m_round_event);
+}
+
+void Page_cleaner::worker() noexcept {
+  os_thread_bind(OS_THREAD_CLASS_FLUSH);
+
+  auto round = m_round.load();
+
+  for (;;) {
+    const auto sig_count = os_event_reset(m_round_event);
+
+    if (m_shutdown.load(std::memory_order_acquire)) {
+      break;
+    }
+
+    if (const auto current = m_round.load(); current != round) {
+      round = current;
+      process_instances();
+    } else {
+      os_event_wait_low(m_round_event, sig_count);
+    }
+  }
+}
@@ -0,0 +1,355 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file buf/buf0l2.cc
+Second level page cache for the clean pages evicted from the buffer pool
+*******************************************************/
+
+#include "buf0l2.h"
+#include "buf0buf.h"
+#include "fil0fil.h"
+#include "mach0data.h"
+#include "os0sync.h"
+#include "os0thread-create.h"
+#include "srv0srv.h"
+
+Buf_l2_cache *srv_buf_l2{};
+
+Buf_l2_cache::Buf_l2_cache(const char *path, os_file_t file, ulint n_slots) noexcept
+  : m_path(path),
+    m_file(file),
+    m_slots(n_slots),
+    m_event(os_event_create("buf_l2_event")) {
+
+  mutex_create(&m_mutex, IF_DEBUG("buf_l2_mutex",) IF_SYNC_DEBUG(SYNC_ANY_LATCH,) Current_location());
+
+  /* Hand out the slots in file order. */
+  m_free.reserve(n_slots);
+
+  for (auto i = n_slots; i > 0; --i) {
+    m_free.push_back(i - 1);
+  }
+
+  m_index.reserve(n_slots);
+
+  m_write_buf_ptr = static_cast<byte *>(ut_new((WRITE_QUEUE_SIZE + 1) * UNIV_PAGE_SIZE));
+
+  if (m_write_buf_ptr != nullptr) {
+    auto buf = static_cast<byte *>(ut_align(m_write_buf_ptr, UNIV_PAGE_SIZE));
+
+    for (auto &write : m_queue) {
+      write.m_buf = buf;
+      buf += UNIV_PAGE_SIZE;
+    }
+  }
+}
+
+Buf_l2_cache::~Buf_l2_cache() noexcept {
+  ut_a(!m_thread.joinable());
+
+  if (m_write_buf_ptr != nullptr) {
+    ut_delete(m_write_buf_ptr);
+  }
+
+  (void) os_file_close(m_file);
+
+  /* The index is not persistent, the contents are useless after a restart. */
+  (void) os_file_delete_if_exists(m_path.c_str());
+
+  mutex_free(&m_mutex);
+
+  os_event_free(m_event);
+}
+
+Buf_l2_cache *Buf_l2_cache::create() noexcept {
+  const auto path = srv_config.m_l2_cache_file;
+  const auto n_slots = srv_config.m_l2_cache_size / UNIV_PAGE_SIZE;
+
+  if (path == nullptr || *path == '\0' || n_slots == 0) {
+    return nullptr;
+  }
+
+  if (n_slots <= WRITE_QUEUE_SIZE) {
+    log_warn(std::format("The l2_cache_size must be larger than {} pages, the L2 cache is disabled", WRITE_QUEUE_SIZE));
+    return nullptr;
+  }
+
+  bool success;
+  auto file = os_file_create(path, OS_FILE_OVERWRITE, OS_FILE_NORMAL, OS_DATA_FILE, &success);
+
+  if (!success) {
+    log_err(std::format("Cannot create the L2 cache file {}, the L2 cache is disabled", path));
+    return nullptr;
+  }
+
+  auto ptr = ut_new(sizeof(Buf_l2_cache));
+
+  if (ptr == nullptr) {
+    (void) os_file_close(file);
+    return nullptr;
+  }
+
+  auto l2_cache = new (ptr) Buf_l2_cache(path, file, n_slots);
+
+  if (l2_cache->m_write_buf_ptr == nullptr) {
+    destroy(l2_cache);
+    return nullptr;
+  }
+
+  log_info(std::format("Using the L2 cache file {} of {} pages", path, n_slots));
+
+  return l2_cache;
+}
+
+void Buf_l2_cache::destroy(Buf_l2_cache *&l2_cache) noexcept {
+  call_destructor(l2_cache);
+  ut_delete(l2_cache);
+  l2_cache = nullptr;
+}
+
+void Buf_l2_cache::start() noexcept {
+  ut_a(!m_thread.joinable());
+
+  m_shutdown.store(false, std::memory_order_release);
+
+  m_thread = create_joinable_thread(&Buf_l2_cache::run, this);
+}
+
+void Buf_l2_cache::shutdown() noexcept {
+  m_shutdown.store(true, std::memory_order_release);
+
+  if (m_thread.joinable()) {
+    os_event_set(m_event);
+
+    m_thread.join();
+  }
+
+  log_info(std::format("L2 cache: {} pages read, {} pages written", get_n_hits(), get_n_writes()));
+}
+
+void Buf_l2_cache::free_slot(ulint slot_no) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  auto &slot = m_slots[slot_no];
+
+  ut_a(slot.m_state != Slot_state::FREE);
+
+  m_index.erase(slot.m_page_id);
+
+  slot.m_state = Slot_state::FREE;
+  ++slot.m_seq;
+
+  m_free.push_back(slot_no);
+}
+
+ulint Buf_l2_cache::get_slot() noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (m_free.empty()) {
+    /* Reuse the oldest page, the slots that are being written are skipped,
+    there are fewer of them than slots. */
+    while (m_slots[m_hand].m_state != Slot_state::VALID) {
+      m_hand = (m_hand + 1) % m_slots.size();
+    }
+
+    free_slot(m_hand);
+
+    m_hand = (m_hand + 1) % m_slots.size();
+  }
+
+  const auto slot_no = m_free.back();
+
+  m_free.pop_back();
+
+  return slot_no;
+}
+
+void Buf_l2_cache::insert(space_id_t space, page_no_t page_no, const byte *frame) noexcept {
+  if (is_shutdown()) {
+    return;
+  }
+
+  const auto tablespace_version = srv_fil->space_get_version(space);
+
+  if (tablespace_version == -1) {
+    /* The tablespace was dropped. */
+    return;
+  }
+
+  const Page_id page_id(space, page_no);
+
+  mutex_enter(&m_mutex);
+
+  /* A cached page that is still in the index was not modified since it was
+  cached. If the device does not keep up with the evictions the page is not
+  cached. */
+  if (m_queue_len == m_queue.size() || m_index.contains(page_id)) {
+    mutex_exit(&m_mutex);
+    return;
+  }
+
+  const auto slot_no = get_slot();
+  auto &slot = m_slots[slot_no];
+
+  slot.m_page_id = page_id;
+  slot.m_tablespace_version = tablespace_version;
+  slot.m_state = Slot_state::WRITING;
+
+  m_index.emplace(page_id, slot_no);
+
+  auto &write = m_queue[(m_queue_first + m_queue_len) % m_queue.size()];
+
+  write.m_slot = slot_no;
+  write.m_seq = slot.m_seq;
+
+  memcpy(write.m_buf, frame, UNIV_PAGE_SIZE);
+
+  /* Restore the page id that Buf_LRU::block_remove_hashed_page() wiped. */
+  mach_write_to_4(write.m_buf + FIL_PAGE_OFFSET, page_no);
+  mach_write_to_4(write.m_buf + FIL_PAGE_SPACE_ID, space);
+
+  ++m_queue_len;
+
+  mutex_exit(&m_mutex);
+
+  os_event_set(m_event);
+}
+
+bool Buf_l2_cache::read(space_id_t space, page_no_t page_no, int64_t tablespace_version, byte *frame) noexcept {
+  const Page_id page_id(space, page_no);
+
+  mutex_enter(&m_mutex);
+
+  auto it = m_index.find(page_id);
+
+  if (it == m_index.end() || m_slots[it->second].m_state != Slot_state::VALID) {
+    mutex_exit(&m_mutex);
+    return false;
+  }
+
+  const auto slot_no = it->second;
+
+  if (m_slots[slot_no].m_tablespace_version != tablespace_version) {
+    /* The page belongs to a dropped tablespace that had the same id. */
+    free_slot(slot_no);
+    mutex_exit(&m_mutex);
+    return false;
+  }
+
+  const auto seq = m_slots[slot_no].m_seq;
+
+  mutex_exit(&m_mutex);
+
+  auto success = os_file_read(m_file, frame, UNIV_PAGE_SIZE, slot_offset(slot_no));
+
+  mutex_enter(&m_mutex);
+
+  /* The slot could have been reused for another page while it was read. */
+  success = success && m_slots[slot_no].m_seq == seq;
+
+  mutex_exit(&m_mutex);
+
+  if (!success) {
+    return false;
+  }
+
+  if (mach_read_from_4(frame + FIL_PAGE_OFFSET) != page_no || mach_read_from_4(frame + FIL_PAGE_SPACE_ID) != space ||
+      Buf_pool::is_corrupted(frame)) {
+
+    log_warn(std::format("The L2 cache copy of page {} is corrupt, reading the page from the data file", page_id.to_string()));
+
+    mutex_enter(&m_mutex);
+
+    if (m_slots[slot_no].m_seq == seq) {
+      free_slot(slot_no);
+    }
+
+    mutex_exit(&m_mutex);
+
+    return false;
+  }
+
+  m_n_hits.fetch_add(1, std::memory_order_relaxed);
+
+  return true;
+}
+
+void Buf_l2_cache::invalidate(space_id_t space, page_no_t page_no) noexcept {
+  mutex_enter(&m_mutex);
+
+  if (auto it = m_index.find(Page_id(space, page_no)); it != m_index.end()) {
+    free_slot(it->second);
+  }
+
+  mutex_exit(&m_mutex);
+}
+
+void Buf_l2_cache::invalidate_tablespace(space_id_t space) noexcept {
+  mutex_enter(&m_mutex);
+
+  for (ulint i{}; i < m_slots.size(); ++i) {
+    if (m_slots[i].m_state != Slot_state::FREE && m_slots[i].m_page_id.m_space_id == space) {
+      free_slot(i);
+    }
+  }
+
+  mutex_exit(&m_mutex);
+}
+
+void Buf_l2_cache::run() noexcept {
+  while (!is_shutdown()) {
+    const auto sig_count = os_event_reset(m_event);
+
+    mutex_enter(&m_mutex);
+
+    if (m_queue_len == 0) {
+      mutex_exit(&m_mutex);
+
+      if (!is_shutdown()) {
+        m_event->wait(sig_count);
+      }
+
+      continue;
+    }
+
+    /* The entry stays queued until it is written, so that its buffer is
+    not reused. */
+    const auto write = m_queue[m_queue_first];
+    const auto pending = m_slots[write.m_slot].m_seq == write.m_seq;
+
+    mutex_exit(&m_mutex);
+
+    /* A page that was modified while it was queued is not written. */
+    const auto success = !pending || os_file_write(m_path.c_str(), m_file, write.m_buf, UNIV_PAGE_SIZE, slot_offset(write.m_slot));
+
+    mutex_enter(&m_mutex);
+
+    if (m_slots[write.m_slot].m_seq == write.m_seq) {
+      if (success) {
+        m_slots[write.m_slot].m_state = Slot_state::VALID;
+        m_n_writes.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        free_slot(write.m_slot);
+      }
+    }
+
+    m_queue_first = (m_queue_first + 1) % m_queue.size();
+    --m_queue_len;
+
+    mutex_exit(&m_mutex);
+  }
+}
@@ -32,6 +32,7 @@ Created 11/5/1995 Heikki Tuuri
 
 #include "buf0buf.h"
 #include "buf0flu.h"
+#include "buf0l2.h"
 #include "fil0fil.h"
 #include "log0recv.h"
 #include "os0file.h"
@@ -40,6 +41,8 @@ Created 11/5/1995 Heikki Tuuri
 #include "sync0sync.h"
 #include "ut0lst.h"
 
+#include <unordered_map>
+
 /** The number of blocks from the LRU_old pointer onward, including
 the block pointed to, must be Buf_LRU::old_ratio/OLD_RATIO_DIV
 of the whole LRU list length, except that the tolerance defined below
@@ -58,95 +61,108 @@ static_assert(NON_MIN_LEN < Buf_LRU::OLD_MIN_LEN, "error Buf_LRU::NON_MIN_LEN >=
 ulint Buf_LRU::s_old_ratio{};
 ulint Buf_LRU::s_old_threshold_ms{};
 
-void Buf_LRU::invalidate_tablespace(space_id_t id) {
-  bool all_freed{};
-
-  while (!all_freed) {
-    m_buf_pool->mutex_acquire();
-
-    all_freed = true;
-
-    auto bpage = UT_LIST_GET_LAST(srv_buf_pool->m_LRU_list);
-
-    while (bpage != nullptr) {
-      ut_a(bpage->in_file());
+ulint Buf_LRU::sweep_dropped(ulint max_batches) noexcept {
+  ulint n_freed{};
 
-      auto prev_bpage = UT_LIST_GET_PREV(m_LRU_list, bpage);
+  /* A space id is not reused while the server runs, a dropped space stays
+  dropped. */
+  std::unordered_map<space_id_t, bool> dropped;
 
-      /* bpage->m_space and bpage->m_io_fix are protected by
-      buf_pool_mutex and block_mutex.  It is safe to check
-      them while holding buf_pool_mutex only. */
+  for (ulint i{}; i < max_batches; ++i) {
+    m_buf_pool->mutex_acquire();
 
-      if (bpage->get_space() != id) {
+    if (m_sweep_pos == nullptr) {
+      const auto n_requests = m_n_sweep_requests.load(std::memory_order_relaxed);
 
-        /* Skip this block, as it does not belong to the space that is being invalidated. */
+      if (i > 0 || n_requests == m_n_sweeps_started) {
+        /* Don't start another sweep in the same call. */
+        m_buf_pool->mutex_release();
+        break;
+      }
 
-      } else if (buf_page_get_io_fix(bpage) != BUF_IO_NONE) {
+      m_n_sweeps_started = n_requests;
+      m_sweep_pos = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list);
+    }
 
-        /* We cannot remove this page during this scan yet; maybe the
-        system is currently reading it in, or flushing the modifications
-        to the file */
+    for (ulint n{}; m_sweep_pos != nullptr && n < SWEEP_BATCH; ++n) {
+      auto bpage = m_sweep_pos;
 
-        all_freed = false;
+      m_sweep_pos = UT_LIST_GET_PREV(m_LRU_list, bpage);
 
-      } else {
-        auto block_mutex = buf_page_get_mutex(bpage);
+      ut_a(bpage->in_file());
 
-        mutex_enter(block_mutex);
+      const auto space_id = bpage->get_space();
+      auto it = dropped.find(space_id);
 
-        if (bpage->m_buf_fix_count > 0) {
+      if (it == dropped.end()) {
+        it = dropped.emplace(space_id, srv_fil->tablespace_deleted_or_being_deleted_in_mem(space_id, -1)).first;
+      }
 
-          /* We cannot remove this page during this scan yet; maybe the system is
-          currently reading it in, or flushing the modifications to the file */
+      /* bpage->m_io_fix is protected by buf_pool_mutex and block_mutex. It
+      is safe to check it while holding buf_pool_mutex only. A page that is
+      being read or written is freed by the next sweep or the flush. */
+      if (!it->second || buf_page_get_io_fix(bpage) != BUF_IO_NONE) {
+        continue;
+      }
 
-          all_freed = false;
-          break;
+      auto block_mutex = buf_page_get_mutex(bpage);
 
-        } else {
+      mutex_enter(block_mutex);
 
-          if (bpage->m_oldest_modification != 0) {
-            srv_buf_pool->m_flusher->remove(bpage);
-          }
+      if (bpage->m_buf_fix_count == 0) {
+        if (bpage->m_oldest_modification != 0) {
+          m_buf_pool->m_flusher->remove(bpage);
+        }
 
-          /* Remove from the LRU list. */
-          block_remove_hashed_page(bpage);
+        /* Remove from the LRU list. */
+        block_remove_hashed_page(bpage);
 
-          {
-            /* We can't cast it using buf_page_get_block() because of the checks there. */
-            auto block{reinterpret_cast<Buf_block *>(bpage)};
-            block_free_hashed_page(block);
-          }
+        {
+          /* We can't cast it using buf_page_get_block() because of the checks there. */
+          auto block{reinterpret_cast<Buf_block *>(bpage)};
+          block_free_hashed_page(block);
         }
 
-        mutex_exit(block_mutex);
+        ++n_freed;
       }
 
-      bpage = prev_bpage;
+      mutex_exit(block_mutex);
     }
 
     m_buf_pool->mutex_release();
-
-    if (!all_freed) {
-      os_thread_sleep(20000);
-    }
   }
+
+  return n_freed;
 }
 
 bool Buf_LRU::free_from_common_LRU_list(ulint n_iterations) {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
-  auto distance = 100 + (n_iterations * srv_buf_pool->m_curr_size) / 10;
+  auto distance = 100 + (n_iterations * m_buf_pool->m_curr_size) / 10;
 
-  for (auto bpage = UT_LIST_GET_LAST(srv_buf_pool->m_LRU_list); likely(bpage != nullptr) && likely(distance > 0);
-       bpage = UT_LIST_GET_PREV(m_LRU_list, bpage), distance--) {
+  for (auto bpage = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list); likely(bpage != nullptr) && likely(distance > 0); distance--) {
 
     auto block_mutex = buf_page_get_mutex(bpage);
+    auto prev_bpage = UT_LIST_GET_PREV(m_LRU_list, bpage);
 
     ut_ad(bpage->m_in_LRU_list);
     ut_ad(bpage->in_file());
 
     mutex_enter(block_mutex);
 
+    if (is_protected(bpage, n_iterations)) {
+      mutex_exit(block_mutex);
+
+      /* Give the page another lap, remove_block() clears the flag. */
+      make_block_young(bpage);
+
+      bpage->m_protected = true;
+      ++m_n_protected;
+
+      bpage = prev_bpage;
+      continue;
+    }
+
     auto accessed = buf_page_is_accessed(bpage);
     auto block_status = free_block(bpage, nullptr);
 
@@ -157,12 +173,13 @@ bool Buf_LRU::free_from_common_LRU_list(ulint n_iterations) {
         /* Keep track of pages that are evicted without ever being accessed.
 	his gives us a measure of the effectiveness of readahead */
         if (!accessed) {
-          ++srv_buf_pool->m_stat.n_ra_pages_evicted;
+          ++m_buf_pool->m_stat.n_ra_pages_evicted;
         }
         return true;
 
       case Block_status::NOT_FREED:
         /* The block was dirty, buffer-fixed, or I/O-fixed.  Keep looking. */
+        bpage = prev_bpage;
         continue;
 
       case Block_status::CANNOT_RELOCATE:
@@ -176,15 +193,45 @@ bool Buf_LRU::free_from_common_LRU_list(ulint n_iterations) {
   return false;
 }
 
+bool Buf_LRU::is_protected(Buf_page *bpage, ulint n_iterations) {
+  ut_ad(mutex_own(&m_buf_pool->m_mutex));
+  ut_ad(mutex_own(buf_page_get_mutex(bpage)));
+
+  /* The frame of a page that is being read is not valid yet, the other
+  fixed pages cannot be evicted anyway. */
+  if (!buf_page_can_relocate(bpage)) {
+    return false;
+  }
+
+  const auto frame = reinterpret_cast<Buf_block *>(bpage)->m_frame;
+  const auto non_leaf = srv_fil->page_get_type(frame) == FIL_PAGE_TYPE_INDEX && !page_is_leaf(frame);
+
+  if (!non_leaf && bpage->m_protected) {
+    /* The page was freed and reused as a leaf page. */
+    bpage->m_protected = false;
+    --m_n_protected;
+  }
+
+  /* Under heavy memory pressure, when the first scan found nothing to
+  evict, all the pages are fair game. */
+  if (!non_leaf || n_iterations > 1 || srv_config.m_lru_protected_pct == 0) {
+    return false;
+  }
+
+  /* The pages that are already protected stay protected, the quota only
+  limits the admission of new ones. */
+  return bpage->m_protected || m_n_protected < UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) * srv_config.m_lru_protected_pct / 100;
+}
+
 bool Buf_LRU::search_and_free_block(ulint n_iterations) {
   m_buf_pool->mutex_acquire();
 
   auto freed = free_from_common_LRU_list(n_iterations);
 
   if (!freed) {
-    srv_buf_pool->m_LRU_flush_ended = 0;
-  } else if (srv_buf_pool->m_LRU_flush_ended > 0) {
-    --srv_buf_pool->m_LRU_flush_ended;
+    m_buf_pool->m_LRU_flush_ended = 0;
+  } else if (m_buf_pool->m_LRU_flush_ended > 0) {
+    --m_buf_pool->m_LRU_flush_ended;
   }
 
   m_buf_pool->mutex_release();
@@ -195,7 +242,7 @@ bool Buf_LRU::search_and_free_block(ulint n_iterations) {
 void Buf_LRU::try_free_flushed_blocks() {
   m_buf_pool->mutex_acquire();
 
-  while (srv_buf_pool->m_LRU_flush_ended > 0) {
+  while (m_buf_pool->m_LRU_flush_ended > 0) {
 
     m_buf_pool->mutex_release();
 
@@ -211,7 +258,7 @@ bool Buf_LRU::buf_pool_running_out() {
   m_buf_pool->mutex_acquire();
 
   auto ret = !recv_recovery_on &&
-             UT_LIST_GET_LEN(srv_buf_pool->m_free_list) + UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < srv_buf_pool->m_curr_size / 4;
+             UT_LIST_GET_LEN(m_buf_pool->m_free_list) + UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < m_buf_pool->m_curr_size / 4;
 
   m_buf_pool->mutex_release();
 
@@ -221,7 +268,7 @@ bool Buf_LRU::buf_pool_running_out() {
 Buf_block *Buf_LRU::get_free_only() {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
-  auto block = (Buf_block *)UT_LIST_GET_FIRST(srv_buf_pool->m_free_list);
+  auto block = (Buf_block *)UT_LIST_GET_FIRST(m_buf_pool->m_free_list);
 
   if (block != nullptr) {
     ut_ad(block->m_page.m_in_free_list);
@@ -230,7 +277,7 @@ Buf_block *Buf_LRU::get_free_only() {
     ut_ad(!block->m_page.m_in_LRU_list);
     ut_a(!block->m_page.in_file());
 
-    UT_LIST_REMOVE(srv_buf_pool->m_free_list, (&block->m_page));
+    UT_LIST_REMOVE(m_buf_pool->m_free_list, (&block->m_page));
 
     mutex_enter(&block->m_mutex);
 
@@ -255,7 +302,7 @@ loop:
   m_buf_pool->mutex_acquire();
 
   if (!recv_recovery_on &&
-      UT_LIST_GET_LEN(srv_buf_pool->m_free_list) + UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < srv_buf_pool->m_curr_size / 20) {
+      UT_LIST_GET_LEN(m_buf_pool->m_free_list) + UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < m_buf_pool->m_curr_size / 20) {
 
     ut_print_timestamp(ib_stream);
 
@@ -265,13 +312,13 @@ loop:
       " Check that your transactions do not set too many row locks."
       " Your buffer pool size is %lu MB. Maybe you should make the buffer pool bigger?"
       " We intentionally generate a seg fault to print a stack trace on Linux!\n",
-      (ulong)(srv_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
+      (ulong)(m_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
     );
 
     ut_error;
 
-  } else if (!recv_recovery_on && (UT_LIST_GET_LEN(srv_buf_pool->m_free_list) + UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list)) <
-                                    srv_buf_pool->m_curr_size / 3) {
+  } else if (!recv_recovery_on && (UT_LIST_GET_LEN(m_buf_pool->m_free_list) + UT_LIST_GET_LEN(m_buf_pool->m_LRU_list)) <
+                                    m_buf_pool->m_curr_size / 3) {
 
     if (!m_switched_on_monitor) {
 
@@ -285,7 +332,7 @@ loop:
         " row locks. Your buffer pool size is %lu MB.Maybe you should"
         " make the buffer pool bigger? Starting the InnoDB Monitor to"
         " print diagnostics, including lock heap and hash index sizes",
-        (ulong)(srv_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
+        (ulong)(m_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
       );
 
       m_switched_on_monitor = true;
@@ -367,14 +414,19 @@ loop:
     os_event_set(srv_lock_timeout_thread_event);
   }
 
-  /* No free block was found: try to flush the LRU list */
+  /* No free block was found: try to flush the LRU list. This should be rare
+  when the page cleaner is running, wake it up to replenish the free list. */
 
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
-  ++srv_buf_pool_wait_free;
+  if (srv_page_cleaner != nullptr && srv_page_cleaner->is_running()) {
+    srv_page_cleaner->wakeup();
+  }
+
+  m_buf_pool->m_flusher->free_margin(srv_dblwr);
+  srv_buf_pool_wait_free.inc();
 
   m_buf_pool->mutex_acquire();
 
-  if (srv_buf_pool->m_LRU_flush_ended > 0) {
+  if (m_buf_pool->m_LRU_flush_ended > 0) {
     /* We have written pages in an LRU flush. To make the insert
     buffer more efficient, we try to move these pages to the free
     list. */
@@ -397,7 +449,7 @@ loop:
 }
 
 void Buf_LRU::old_adjust_len() {
-  ut_a(srv_buf_pool->m_LRU_old);
+  ut_a(m_buf_pool->m_LRU_old);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
   ut_ad(m_old_ratio >= OLD_RATIO_MIN);
   ut_ad(m_old_ratio <= OLD_RATIO_MAX);
@@ -407,15 +459,15 @@ void Buf_LRU::old_adjust_len() {
     "OLD_RATIO_MIN * OLD_MIN_LEN <= OLD_RATIO_DIV * (OLD_TOLERANCE + 5)"
   );
 
-  auto old_len = srv_buf_pool->m_LRU_old_len;
+  auto old_len = m_buf_pool->m_LRU_old_len;
 
   auto new_len = std::min(
-    UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
-    UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
+    UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
+    UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
   );
 
   for (;;) {
-    auto lru_old = srv_buf_pool->m_LRU_old;
+    auto lru_old = m_buf_pool->m_LRU_old;
 
     ut_a(lru_old->m_old);
     ut_ad(lru_old->m_in_LRU_list);
@@ -424,19 +476,19 @@ void Buf_LRU::old_adjust_len() {
 
     if (old_len + OLD_TOLERANCE < new_len) {
 
-      srv_buf_pool->m_LRU_old = lru_old = UT_LIST_GET_PREV(m_LRU_list, lru_old);
+      m_buf_pool->m_LRU_old = lru_old = UT_LIST_GET_PREV(m_LRU_list, lru_old);
 
-      old_len = ++srv_buf_pool->m_LRU_old_len;
+      old_len = ++m_buf_pool->m_LRU_old_len;
 
       buf_page_set(lru_old, true);
 
     } else if (old_len > new_len + OLD_TOLERANCE) {
 
-      srv_buf_pool->m_LRU_old = UT_LIST_GET_NEXT(m_LRU_list, lru_old);
+      m_buf_pool->m_LRU_old = UT_LIST_GET_NEXT(m_LRU_list, lru_old);
 
-      --srv_buf_pool->m_LRU_old_len;
+      --m_buf_pool->m_LRU_old_len;
 
-      old_len = srv_buf_pool->m_LRU_old_len;
+      old_len = m_buf_pool->m_LRU_old_len;
 
       buf_page_set(lru_old, false);
 
@@ -448,13 +500,13 @@ void Buf_LRU::old_adjust_len() {
 
 void Buf_LRU::old_init() {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
-  ut_a(UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) == OLD_MIN_LEN);
+  ut_a(UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) == OLD_MIN_LEN);
 
   /* We first initialize all blocks in the LRU list as old and then use
   the adjust function to move the LRU_old pointer to the right
   position */
 
-  for (auto bpage = UT_LIST_GET_LAST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_PREV(m_LRU_list, bpage)) {
+  for (auto bpage = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_PREV(m_LRU_list, bpage)) {
 
     ut_ad(bpage->m_in_LRU_list);
     ut_ad(bpage->in_file());
@@ -463,14 +515,14 @@ void Buf_LRU::old_init() {
     bpage->m_old = true;
   }
 
-  srv_buf_pool->m_LRU_old = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list);
-  srv_buf_pool->m_LRU_old_len = UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list);
+  m_buf_pool->m_LRU_old = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list);
+  m_buf_pool->m_LRU_old_len = UT_LIST_GET_LEN(m_buf_pool->m_LRU_list);
 
   old_adjust_len();
 }
 
 void Buf_LRU::remove_block(Buf_page *bpage) {
-  ut_ad(srv_buf_pool);
+  ut_ad(m_buf_pool != nullptr);
   ut_ad(bpage);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
@@ -478,10 +530,21 @@ void Buf_LRU::remove_block(Buf_page *bpage) {
 
   ut_ad(bpage->m_in_LRU_list);
 
+  if (unlikely(bpage == m_sweep_pos)) {
+    m_sweep_pos = UT_LIST_GET_PREV(m_LRU_list, bpage);
+  }
+
+  if (bpage->m_protected) {
+    ut_ad(m_n_protected > 0);
+
+    bpage->m_protected = false;
+    --m_n_protected;
+  }
+
   /* If the LRU_old pointer is defined and points to just this block,
   move it backward one step */
 
-  if (unlikely(bpage == srv_buf_pool->m_LRU_old)) {
+  if (unlikely(bpage == m_buf_pool->m_LRU_old)) {
 
     /* Below: the previous block is guaranteed to exist, because the LRU_old pointer is
     only allowed to differ by OLD_TOLERANCE from strict Buf_LRU::old_ratio/OLD_RATIO_DIV
@@ -489,37 +552,37 @@ void Buf_LRU::remove_block(Buf_page *bpage) {
     auto prev_bpage = UT_LIST_GET_PREV(m_LRU_list, bpage);
 
     ut_a(prev_bpage);
-    srv_buf_pool->m_LRU_old = prev_bpage;
+    m_buf_pool->m_LRU_old = prev_bpage;
     buf_page_set(prev_bpage, true);
 
-    ++srv_buf_pool->m_LRU_old_len;
+    ++m_buf_pool->m_LRU_old_len;
   }
 
   /* Remove the block from the LRU list */
-  UT_LIST_REMOVE(srv_buf_pool->m_LRU_list, bpage);
+  UT_LIST_REMOVE(m_buf_pool->m_LRU_list, bpage);
   ut_d(bpage->m_in_LRU_list = false);
 
   /* If the LRU list is so short that LRU_old is not defined,
   clear the "old" flags and return */
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < OLD_MIN_LEN) {
 
-    for (bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
+    for (bpage = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
       /* This loop temporarily violates the assertions of buf_page_set(). */
       bpage->m_old = false;
     }
 
-    srv_buf_pool->m_LRU_old = nullptr;
-    srv_buf_pool->m_LRU_old_len = 0;
+    m_buf_pool->m_LRU_old = nullptr;
+    m_buf_pool->m_LRU_old_len = 0;
 
     return;
   }
 
-  ut_ad(srv_buf_pool->m_LRU_old);
+  ut_ad(m_buf_pool->m_LRU_old);
 
   /* Update the LRU_old_len field if necessary */
   if (buf_page_is_old(bpage)) {
 
-    srv_buf_pool->m_LRU_old_len--;
+    m_buf_pool->m_LRU_old_len--;
   }
 
   /* Adjust the length of the old block list if necessary */
@@ -527,74 +590,74 @@ void Buf_LRU::remove_block(Buf_page *bpage) {
 }
 
 void Buf_LRU::add_block_to_end_low(Buf_page *bpage) {
-  ut_ad(srv_buf_pool);
+  ut_ad(m_buf_pool != nullptr);
   ut_ad(bpage);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
   ut_a(bpage->in_file());
 
   ut_ad(!bpage->m_in_LRU_list);
-  UT_LIST_ADD_LAST(srv_buf_pool->m_LRU_list, bpage);
+  UT_LIST_ADD_LAST(m_buf_pool->m_LRU_list, bpage);
   ut_d(bpage->m_in_LRU_list = true);
 
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
 
-    ut_ad(srv_buf_pool->m_LRU_old);
+    ut_ad(m_buf_pool->m_LRU_old);
 
     /* Adjust the length of the old block list if necessary */
 
     buf_page_set(bpage, true);
-    srv_buf_pool->m_LRU_old_len++;
+    m_buf_pool->m_LRU_old_len++;
     old_adjust_len();
 
-  } else if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
+  } else if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
 
     /* The LRU list is now long enough for LRU_old to become
     defined: init it */
 
     old_init();
   } else {
-    buf_page_set(bpage, srv_buf_pool->m_LRU_old != nullptr);
+    buf_page_set(bpage, m_buf_pool->m_LRU_old != nullptr);
   }
 }
 
 void Buf_LRU::add_block_low(Buf_page *bpage, bool old) {
-  ut_ad(srv_buf_pool);
+  ut_ad(m_buf_pool != nullptr);
   ut_ad(bpage);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
   ut_a(bpage->in_file());
   ut_ad(!bpage->m_in_LRU_list);
 
-  if (!old || (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < OLD_MIN_LEN)) {
+  if (!old || (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < OLD_MIN_LEN)) {
 
-    UT_LIST_ADD_FIRST(srv_buf_pool->m_LRU_list, bpage);
+    UT_LIST_ADD_FIRST(m_buf_pool->m_LRU_list, bpage);
 
-    bpage->m_freed_page_clock = srv_buf_pool->m_freed_page_clock;
+    bpage->m_freed_page_clock = m_buf_pool->m_freed_page_clock;
   } else {
-    UT_LIST_INSERT_AFTER(srv_buf_pool->m_LRU_list, srv_buf_pool->m_LRU_old, bpage);
-    srv_buf_pool->m_LRU_old_len++;
+    UT_LIST_INSERT_AFTER(m_buf_pool->m_LRU_list, m_buf_pool->m_LRU_old, bpage);
+    m_buf_pool->m_LRU_old_len++;
   }
 
   ut_d(bpage->m_in_LRU_list = true);
 
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
 
-    ut_ad(srv_buf_pool->m_LRU_old);
+    ut_ad(m_buf_pool->m_LRU_old);
 
     /* Adjust the length of the old block list if necessary */
 
     buf_page_set(bpage, old);
     old_adjust_len();
 
-  } else if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
+  } else if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
 
     /* The LRU list is now long enough for LRU_old to become
     defined: init it */
 
     old_init();
   } else {
-    buf_page_set(bpage, srv_buf_pool->m_LRU_old != nullptr);
+    buf_page_set(bpage, m_buf_pool->m_LRU_old != nullptr);
   }
 }
 
@@ -606,7 +669,7 @@ void Buf_LRU::make_block_young(Buf_page *bpage) {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
   if (bpage->m_old) {
-    ++srv_buf_pool->m_stat.n_pages_made_young;
+    ++m_buf_pool->m_stat.n_pages_made_young;
   }
 
   remove_block(bpage);
@@ -654,6 +717,12 @@ Buf_LRU::Block_status Buf_LRU::free_block(Buf_page *bpage, bool *buf_pool_mutex_
 
     UNIV_MEM_VALID(((Buf_block *)bpage)->m_frame, UNIV_PAGE_SIZE);
 
+    if (srv_buf_l2 != nullptr) {
+      /* The page is clean and nobody can access it until it is freed below,
+      copy it to the L2 cache while we do not hold any mutex. */
+      srv_buf_l2->insert(bpage->m_space, bpage->m_page_no, ((Buf_block *)bpage)->m_frame);
+    }
+
     UNIV_MEM_INVALID(((Buf_block *)bpage)->m_frame, UNIV_PAGE_SIZE);
 
     m_buf_pool->mutex_acquire();
@@ -698,9 +767,14 @@ void Buf_LRU::block_free_non_file_page(Buf_block *block) {
   memset(frame + FIL_PAGE_SPACE_ID, 0xcafe, 4);
 #endif /* UNIV_DEBUG */
 
-  UT_LIST_ADD_FIRST(srv_buf_pool->m_free_list, &block->m_page);
+  if (unlikely(m_buf_pool->will_be_withdrawn(&block->m_page))) {
+    /* The chunk of the block is being removed by Buf_pool_instance::resize(). */
+    UT_LIST_ADD_LAST(m_buf_pool->m_withdraw_list, &block->m_page);
+  } else {
+    UT_LIST_ADD_FIRST(m_buf_pool->m_free_list, &block->m_page);
 
-  ut_d(block->m_page.m_in_free_list = true);
+    ut_d(block->m_page.m_in_free_list = true);
+  }
 
   UNIV_MEM_ASSERT_AND_FREE(block, UNIV_PAGE_SIZE);
 }
@@ -717,7 +791,7 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
 
   remove_block(bpage);
 
-  srv_buf_pool->m_freed_page_clock += 1;
+  m_buf_pool->m_freed_page_clock += 1;
 
   switch (bpage->get_state()) {
     case BUF_BLOCK_FILE_PAGE:
@@ -735,7 +809,7 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
       break;
   }
 
-  auto hashed_bpage = srv_buf_pool->hash_get_page(bpage->m_space, bpage->m_page_no);
+  auto hashed_bpage = m_buf_pool->hash_get_page(bpage->m_space, bpage->m_page_no);
 
   if (unlikely(bpage != hashed_bpage)) {
     ib_logger(ib_stream, "Error: page %lu %lu not found in the hash table ", (ulong)bpage->m_space, (ulong)bpage->m_page_no);
@@ -755,11 +829,11 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
 
     m_buf_pool->mutex_release();
 
-    srv_buf_pool->print();
+    m_buf_pool->print();
 
     print();
 
-    srv_buf_pool->validate();
+    m_buf_pool->validate();
 
     validate();
 #endif /* UNIV_DEBUG */
@@ -769,7 +843,7 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
   ut_ad(bpage->m_in_page_hash);
   ut_d(bpage->m_in_page_hash = false);
 
-  srv_buf_pool->m_page_hash->erase(Page_id(bpage->m_space, bpage->m_page_no));
+  m_buf_pool->m_page_hash->erase(bpage);
 
   switch (bpage->get_state()) {
     case BUF_BLOCK_FILE_PAGE:
@@ -817,13 +891,13 @@ ulint Buf_LRU::old_ratio_update(ulint old_pct, bool adjust) {
   if (adjust) {
     m_buf_pool->mutex_acquire();
 
-    auto buf_LRU = srv_buf_pool->m_LRU.get();
+    auto buf_LRU = m_buf_pool->m_LRU.get();
 
     if (ratio != buf_LRU->m_old_ratio) {
 
       buf_LRU->m_old_ratio = ratio;
 
-      if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
+      if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
 
         buf_LRU->old_adjust_len();
       }
@@ -841,7 +915,7 @@ ulint Buf_LRU::old_ratio_update(ulint old_pct, bool adjust) {
 
 void Buf_LRU::stat_update() {
   /* If we haven't started eviction yet then don't update stats. */
-  if (srv_buf_pool->m_freed_page_clock != 0) {
+  if (m_buf_pool->m_freed_page_clock != 0) {
     m_buf_pool->mutex_acquire();
 
     /* Update the index. */
@@ -866,26 +940,31 @@ void Buf_LRU::stat_update() {
 bool Buf_LRU::validate() {
   m_buf_pool->mutex_acquire();
 
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
 
-    ut_a(srv_buf_pool->m_LRU_old);
+    ut_a(m_buf_pool->m_LRU_old);
 
-    const auto old_len = srv_buf_pool->m_LRU_old_len;
+    const auto old_len = m_buf_pool->m_LRU_old_len;
 
     const auto new_len = std::min(
-      UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
-      UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
+      UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
+      UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
     );
 
     ut_a(old_len >= new_len - OLD_TOLERANCE);
     ut_a(old_len <= new_len + OLD_TOLERANCE);
   }
 
-  UT_LIST_CHECK(srv_buf_pool->m_LRU_list);
+  UT_LIST_CHECK(m_buf_pool->m_LRU_list);
 
   ulint old_len{};
+  ulint n_protected{};
+
+  for (auto bpage = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
 
-  for (auto bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
+    if (bpage->m_protected) {
+      ++n_protected;
+    }
 
     switch (bpage->get_state()) {
       default:
@@ -906,7 +985,7 @@ bool Buf_LRU::validate() {
       ++old_len;
 
       if (old_len >= 1) {
-        ut_a(srv_buf_pool->m_LRU_old == bpage);
+        ut_a(m_buf_pool->m_LRU_old == bpage);
       } else {
         ut_a(prev == nullptr || buf_page_is_old(prev));
       }
@@ -915,14 +994,15 @@ bool Buf_LRU::validate() {
     }
   }
 
-  ut_a(srv_buf_pool->m_LRU_old_len == old_len);
+  ut_a(m_buf_pool->m_LRU_old_len == old_len);
+  ut_a(m_n_protected == n_protected);
 
   auto check = [](const Buf_page *page) {
     ut_ad(page->m_in_free_list);
   };
-  ut_list_validate(srv_buf_pool->m_free_list, check);
+  ut_list_validate(m_buf_pool->m_free_list, check);
 
-  for (auto bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_free_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_list, bpage)) {
+  for (auto bpage = UT_LIST_GET_FIRST(m_buf_pool->m_free_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_list, bpage)) {
 
     ut_a(bpage->get_state() == BUF_BLOCK_NOT_USED);
   }
@@ -935,7 +1015,7 @@ bool Buf_LRU::validate() {
 void Buf_LRU::print() {
   m_buf_pool->mutex_acquire();
 
-  for (auto bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
+  for (auto bpage = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
 
     ib_logger(ib_stream, "BLOCK space %lu page %lu ", (ulong)bpage->get_space(), (ulong)bpage->get_page_no());
 
@@ -29,18 +29,30 @@ Created 11/5/1995 Heikki Tuuri
 
 #include "buf0buf.h"
 #include "buf0flu.h"
+#include "buf0l2.h"
 #include "buf0lru.h"
 #include "log0recv.h"
 #include "os0file.h"
 #include "srv0srv.h"
 #include "trx0sys.h"
 #include "ut0logger.h"
+#include "ut0probe.h"
 
-/** If there are srv_buf_pool->m_curr_size per the number below pending reads, then
+/** If there are buf_pool->m_curr_size per the number below pending reads, then
 read-ahead is not done: this is to prevent flooding the buffer pool with
 i/o-fixed buffer blocks */
 constexpr ulint BUF_READ_AHEAD_PEND_LIMIT = 2;
 
+/**
+ * @param[in] area              Size of the read-ahead area.
+ *
+ * @return the number of recently accessed pages of an area that trigger
+ *  random read-ahead of the rest of the area.
+ */
+constexpr ulint buf_read_ahead_random_threshold(ulint area) {
+  return 5 + area / 8;
+}
+
 /**
  * @brief Low-level function which reads a page asynchronously from a file to
  * the buffer srv_buf_pool if it is not already there, in which case does nothing.
@@ -98,6 +110,26 @@ static db_err buf_read_page(
 
   ut_a(bpage->get_state() == BUF_BLOCK_FILE_PAGE);
 
+  /* Nobody waits for the pages read in the background, checking them can wait
+  until they are accessed, if they are accessed at all. */
+  if (batch && srv_config.m_lazy_checksums) {
+    mutex_enter(buf_page_get_mutex(bpage));
+
+    bpage->m_verify_on_access = true;
+
+    mutex_exit(buf_page_get_mutex(bpage));
+  }
+
+  auto frame = buf_page_get_block(bpage)->get_frame();
+
+  if (srv_buf_l2 != nullptr && srv_buf_l2->read(space, page_no, tablespace_version, frame)) {
+    /* The page was read from the L2 cache, complete the read here also
+    for an asynchronous request. */
+    srv_buf_pool->io_complete(bpage);
+
+    return DB_SUCCESS;
+  }
+
   err = srv_fil->io(
     io_request,
     batch,
@@ -105,7 +137,7 @@ static db_err buf_read_page(
     page_no,
     0,
     UNIV_PAGE_SIZE,
-    buf_page_get_block(bpage)->get_frame(),
+    frame,
     bpage);
 
   ut_a(err == DB_SUCCESS);
@@ -121,12 +153,16 @@ static db_err buf_read_page(
 }
 
 bool buf_read_page(ulint space, ulint offset) {
+  IB_PROBE(page__read__start, space, offset);
+
   auto tablespace_version = srv_fil->space_get_version(space);
   auto err = buf_read_page(IO_request::Sync_read, false, space, offset, tablespace_version);
 
+  IB_PROBE(page__read__done, space, offset, int(err));
+
   if (err == DB_SUCCESS) {
 
-    ++srv_buf_pool_reads;
+    srv_buf_pool_reads.inc();
 
   } else if (err == DB_TABLESPACE_DELETED) {
 
@@ -138,28 +174,100 @@ bool buf_read_page(ulint space, ulint offset) {
     );
   }
 
+  auto buf_pool = srv_buf_pool->get_instance(space, offset);
+
   /* Flush pages from the end of the LRU list if necessary */
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
+  buf_pool->m_flusher->request_free_margin(srv_dblwr);
 
   /* Increment number of I/O operations used for LRU policy. */
-  srv_buf_pool->m_LRU->stat_inc_io();
+  buf_pool->m_LRU->stat_inc_io();
 
   return err == DB_SUCCESS;
 }
 
-ulint buf_read_ahead_linear(Buf_pool *buf_pool, space_id_t space, page_no_t offset) {
+void buf_read_page_async(space_id_t space, page_no_t page_no, std::function<void()> callback) {
+  /* Register first, the read may complete before buf_read_page() returns. */
+  srv_buf_pool->add_read_waiter(space, page_no, std::move(callback));
+
+  auto tablespace_version = srv_fil->space_get_version(space);
+  auto err = buf_read_page(IO_request::Async_read, false, space, page_no, tablespace_version);
+
+  if (err == DB_SUCCESS) {
+    srv_buf_pool_reads.inc();
+
+    srv_buf_pool->get_instance(space, page_no)->m_LRU->stat_inc_io();
+
+  } else if (!srv_buf_pool->is_read_pending(space, page_no)) {
+    /* The page is readable already, or the tablespace was dropped: the
+    caller finds out when it retries. If another thread reads the page its
+    completion wakes us up. */
+    srv_buf_pool->wake_read_waiters(space, page_no);
+  }
+}
+
+/**
+ * @brief Reads the pages of a read-ahead area that are not in the buffer pool,
+ * the reads are submitted as a single batch.
+ *
+ * @param[in,out] buf_pool Buffer pool instance that owns the area.
+ * @param[in] space Tablespace id.
+ * @param[in] low First page of the area.
+ * @param[in] high Page after the last page of the area.
+ * @param[in] tablespace_version Version of the tablespace when the area was checked.
+ *
+ * @return the number of page read requests issued.
+ */
+static ulint buf_read_ahead_area(Buf_pool_instance *buf_pool, space_id_t space, page_no_t low, page_no_t high, int64_t tablespace_version) {
+  ulint count{};
+
+  for (auto i = low; i < high; ++i) {
+    /* It is only sensible to do read-ahead in the non-sync aio mode. */
+    auto err = buf_read_page(IO_request::Async_read, true, space, i, tablespace_version);
+
+    if (err == DB_SUCCESS) {
+
+      ++count;
+
+    } else if (err == DB_TABLESPACE_DELETED) {
+
+      log_info(
+        std::format(
+          "Read-ahead trying to access tablespace {} page {}, but the tablespace does not"
+          " exist or is just being dropped.", space, i)
+      );
+
+      break;
+
+    } else {
+      ut_a(err == DB_FAIL);
+    }
+  }
+
+  /* Submit the whole area with one system call. */
+  srv_aio->submit_batch();
+
+  /* Flush pages from the end of the LRU list if necessary */
+  buf_pool->m_flusher->request_free_margin(srv_dblwr);
+
+  /* Read ahead is considered one I/O operation for the purpose of LRU policy decision. */
+  buf_pool->m_LRU->stat_inc_io();
+
+  buf_pool->m_stat.n_ra_pages_read += count;
+
+  return count;
+}
+
+ulint buf_read_ahead_linear(Buf_pool_instance *buf_pool, space_id_t space, page_no_t offset) {
   Buf_page *bpage;
   buf_frame_t *frame;
   Buf_page *pred_bpage = nullptr;
   page_no_t pred_offset;
   page_no_t succ_offset;
-  ulint count;
   int asc_or_desc;
   ulint new_offset;
   ulint fail_count;
-  db_err err;
   ulint i;
-  const ulint buf_read_ahead_linear_area = srv_buf_pool->get_read_ahead_area();
+  const ulint buf_read_ahead_linear_area = buf_pool->get_read_ahead_area();
   ulint threshold;
 
   if (unlikely(srv_startup_is_before_trx_rollback_phase)) {
@@ -196,7 +304,7 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, space_id_t space, page_no_t offs
     return 0;
   }
 
-  if (srv_buf_pool->m_n_pend_reads > srv_buf_pool->m_curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
+  if (buf_pool->m_n_pend_reads > buf_pool->m_curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
     buf_pool->mutex_release();
 
     return 0;
@@ -214,12 +322,12 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, space_id_t space, page_no_t offs
 
   /* How many out of order accessed pages can we ignore
   when working out the access pattern for linear readahead */
-  threshold = ut_min((64 - srv_config.m_read_ahead_threshold), srv_buf_pool->get_read_ahead_area());
+  threshold = ut_min((64 - srv_config.m_read_ahead_threshold), buf_pool->get_read_ahead_area());
 
   fail_count = 0;
 
   for (i = low; i < high; i++) {
-    bpage = srv_buf_pool->hash_get_page(space, i);
+    bpage = buf_pool->hash_get_page(space, i);
 
     if (bpage == nullptr || !buf_page_is_accessed(bpage)) {
       /* Not accessed */
@@ -254,7 +362,7 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, space_id_t space, page_no_t offs
   /* If we got this far, we know that enough pages in the area have
   been accessed in the right order: linear read-ahead can be sensible */
 
-  bpage = srv_buf_pool->hash_get_page(space, offset);
+  bpage = buf_pool->hash_get_page(space, offset);
 
   if (bpage == nullptr) {
     buf_pool->mutex_release();
@@ -312,38 +420,144 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, space_id_t space, page_no_t offs
     return 0;
   }
 
-  count = 0;
+  return buf_read_ahead_area(buf_pool, space, low, high, tablespace_version);
+}
 
-  for (i = low; i < high; i++) {
-    /* It is only sensible to do read-ahead in the non-sync
-    aio mode: hence false as the first parameter */
+ulint buf_read_ahead_random(Buf_pool_instance *buf_pool, space_id_t space, page_no_t offset) {
+  if (!srv_config.m_random_read_ahead || unlikely(srv_startup_is_before_trx_rollback_phase)) {
+    /* No read-ahead to avoid thread deadlocks */
+    return 0;
+  }
+
+  if (Trx_sys::is_hdr_page(space, offset)) {
+    /* Don't do a read-ahead in the system area. Being cautious. */
+    return 0;
+  }
+
+  const auto area = buf_pool->get_read_ahead_area();
+  const page_no_t low = (offset / area) * area;
+  page_no_t high = (offset / area + 1) * area;
+
+  /* Remember the tablespace version before we ask the tablespace size
+  below: if DISCARD + IMPORT changes the actual .ibd file meanwhile, we
+  do not try to read outside the bounds of the tablespace! */
+
+  auto tablespace_version = srv_fil->space_get_version(space);
 
-    err = buf_read_page(IO_request::Async_read, true, space, i, tablespace_version);
+  high = std::min(high, page_no_t(srv_fil->space_get_size(space)));
+
+  if (high <= low) {
+    return 0;
+  }
+
+  buf_pool->mutex_acquire();
+
+  if (buf_pool->m_n_pend_reads > buf_pool->m_curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
+    buf_pool->mutex_release();
+
+    return 0;
+  }
+
+  /* Count how many pages of the area have been accessed recently, if
+  enough have, the rest of the area is likely to be accessed soon. */
+
+  ulint n_recent{};
+  const auto threshold = buf_read_ahead_random_threshold(area);
+
+  for (auto i = low; i < high && n_recent < threshold; ++i) {
+    auto bpage = buf_pool->hash_get_page(space, i);
+
+    if (bpage != nullptr && buf_page_is_accessed(bpage) && buf_pool->peek_if_young(bpage)) {
+      ++n_recent;
+    }
+  }
+
+  buf_pool->mutex_release();
+
+  if (n_recent < threshold) {
+    return 0;
+  }
+
+  return buf_read_ahead_area(buf_pool, space, low, high, tablespace_version);
+}
+
+ulint buf_read_ahead_pages(space_id_t space, const page_no_t *page_nos, ulint n_pages) {
+  if (unlikely(srv_startup_is_before_trx_rollback_phase)) {
+    /* No read-ahead to avoid thread deadlocks */
+    return 0;
+  }
+
+  /* Remember the tablespace version before we ask the tablespace size
+  below, see buf_read_ahead_random(). */
+  auto tablespace_version = srv_fil->space_get_version(space);
+  const auto space_size = srv_fil->space_get_size(space);
+
+  if (space_size == ULINT_UNDEFINED) {
+    return 0;
+  }
+
+  ulint count{};
+
+  for (ulint i = 0; i < n_pages; ++i) {
+    auto buf_pool = srv_buf_pool->get_instance(space, page_nos[i]);
+
+    /* Dirty read of the pending reads, the limit is only a hint. The page
+    numbers come from pages that may have changed, check the bounds. */
+    if (page_nos[i] >= space_size || buf_pool->m_n_pend_reads > buf_pool->m_curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
+      continue;
+    }
+
+    auto err = buf_read_page(IO_request::Async_read, true, space, page_nos[i], tablespace_version);
 
     if (err == DB_SUCCESS) {
 
       ++count;
 
-    } else if (err == DB_TABLESPACE_DELETED) {
+      ++buf_pool->m_stat.n_ra_pages_read;
 
-      log_info(
-        std::format(
-          "Lnear readahead trying to access tablespace {} page {},but the tablespace does not"
-          " exist or is just being dropped.", space, i)
-      );
+      buf_pool->m_flusher->request_free_margin(srv_dblwr);
 
-    } else {
-      ut_a(err == DB_FAIL);
+    } else if (err == DB_TABLESPACE_DELETED) {
+
+      break;
     }
   }
 
-  /* Flush pages from the end of the LRU list if necessary */
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
+  if (count > 0) {
+    srv_aio->submit_batch();
+  }
 
-  /* Read ahead is considered one I/O operation for the purpose of LRU policy decision. */
-  srv_buf_pool->m_LRU->stat_inc_io();
+  return count;
+}
+
+ulint buf_read_load_pages(space_id_t space, const page_no_t *page_nos, ulint n_pages) {
+  const auto space_size = srv_fil->space_get_size(space);
 
-  srv_buf_pool->m_stat.n_ra_pages_read += count;
+  if (space_size == ULINT_UNDEFINED) {
+    /* The tablespace was dropped after the dump was written. */
+    return 0;
+  }
+
+  ulint count{};
+  auto tablespace_version = srv_fil->space_get_version(space);
+
+  for (ulint i = 0; i < n_pages; ++i) {
+    if (page_nos[i] >= space_size) {
+      /* The tablespace was truncated after the dump was written. */
+      continue;
+    }
+
+    auto err = buf_read_page(IO_request::Async_read, true, space, page_nos[i], tablespace_version);
+
+    if (err == DB_SUCCESS) {
+      ++count;
+    }
+  }
+
+  srv_aio->submit_batch();
+
+  /* Flush pages from the end of the LRU list if necessary */
+  srv_buf_pool->free_margin(srv_dblwr);
 
   return count;
 }
@@ -360,7 +574,12 @@ void buf_read_recv_pages(bool sync, space_id_t space, const page_no_t *page_nos,
   for (ulint i = 0; i < n_stored; i++) {
     ulint count{};
 
-    while (srv_buf_pool->m_n_pend_reads >= recv_n_pool_free_frames / 2) {
+    if (srv_buf_pool->get_n_pend_reads() >= recv_n_pool_free_frames / 2) {
+      /* The reads must be in flight for the count to go down. */
+      srv_aio->submit_batch();
+    }
+
+    while (srv_buf_pool->get_n_pend_reads() >= recv_n_pool_free_frames / 2) {
 
       os_thread_sleep(10000);
 
@@ -372,7 +591,7 @@ void buf_read_recv_pages(bool sync, space_id_t space, const page_no_t *page_nos,
           std::format(
             "Waited for 10 seconds for pending reads to the buffer pool to"
             " be finished. Number of pending reads {}. pending pread calls {}",
-            srv_buf_pool->m_n_pend_reads, os_file_n_pending_preads.load())
+            srv_buf_pool->get_n_pend_reads(), os_file_n_pending_preads.load())
 	);
       }
     }
@@ -384,6 +603,8 @@ void buf_read_recv_pages(bool sync, space_id_t space, const page_no_t *page_nos,
     }
   }
 
+  srv_aio->submit_batch();
+
   /* Flush pages from the end of the LRU list if necessary */
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
+  srv_buf_pool->free_margin(srv_dblwr);
 }
@@ -36,6 +36,8 @@
 #cmakedefine HAVE_LOCALTIME_R
 #cmakedefine HAVE_LOCKING
 #cmakedefine HAVE_LONG_LONG_INT
+#cmakedefine HAVE_LZ4
+#cmakedefine HAVE_LZ4_H
 #cmakedefine HAVE_MALLOC_H
 #cmakedefine HAVE_MATH_H
 #cmakedefine HAVE_MEMCPY
@@ -82,6 +84,7 @@
 #cmakedefine HAVE_SYS_MMAN_H
 #cmakedefine HAVE_SYS_NDIR_H
 #cmakedefine HAVE_SYS_RESOURCE_H
+#cmakedefine HAVE_SYS_SDT_H
 #cmakedefine HAVE_SYS_SHM_H
 #cmakedefine HAVE_SYS_STAT_H
 #cmakedefine HAVE_SYS_TIME_H
@@ -96,6 +99,7 @@
 #cmakedefine HAVE_UINT8_T
 #cmakedefine HAVE_UNISTD_H
 #cmakedefine HAVE_UNSIGNED_LONG_LONG_INT
+#cmakedefine HAVE_USDT
 #cmakedefine HAVE_U_INT32_T
 #cmakedefine HAVE_VALGRIND_MEMCHECK_H
 #cmakedefine HAVE_ZLIB_H
@@ -104,6 +108,7 @@
 #cmakedefine IB_ATOMIC_MODE_INNODB
 #cmakedefine IB_ATOMIC_MODE_INTRINSICS
 #cmakedefine IB_ATOMIC_MODE_NATIVE
+#cmakedefine IB_PAGE_SIZE_SHIFT @IB_PAGE_SIZE_SHIFT@
 #cmakedefine NO_MINUS_C_MINUS_O
 #cmakedefine PACKAGE
 #cmakedefine PACKAGE_BUGREPORT
@@ -618,8 +618,8 @@ std::ostream &dfield_t::print(std::ostream &out) const {
   return out;
 }
 
-int DTuple::compare(const rec_t *rec, const Index *, const ulint *offsets, ulint *matched_fields) const {
+int DTuple::compare(const rec_t *rec, const Index *index, const ulint *offsets, ulint *matched_fields) const {
   ulint matched_bytes{};
 
-  return cmp_dtuple_rec_with_match(nullptr, this, rec, offsets, matched_fields, &matched_bytes);
+  return cmp_dtuple_rec_with_match(index, this, rec, offsets, matched_fields, &matched_bytes);
 }
@@ -10,6 +10,8 @@ Created 12 Oct 2008.
 #include "btr0pcur.h"
 #include "ddl0ddl.h"
 #include "dict0dict.h"
+#include "dict0hist.h"
+#include "dict0stats.h"
 #include "fil0fil.h"
 #include "fsp0fsp.h"
 #include "lock0lock.h"
@@ -211,6 +213,8 @@ db_err DDL::drop_table(const char *in_name, Trx *trx, bool drop_db) noexcept {
     return func_exit(DB_TABLE_NOT_FOUND);
   }
 
+  (void) m_dict->table_load_foreigns(table);
+
   /* Check if the table is referenced by foreign key constraints from
   some other table (not the table itself) */
 
@@ -233,6 +237,11 @@ db_err DDL::drop_table(const char *in_name, Trx *trx, bool drop_db) noexcept {
     }
   }
 
+  /* Stop the opens without the dictionary mutex before reading the handle
+  count, see Dict::Table_hash::acquire(). If the drop is deferred the next
+  open with the mutex publishes the table again. */
+  table->m_published.store(false);
+
   if (table->m_n_handles_opened > 0) {
     auto added = add_table_to_background_drop_list(table->m_name);
 
@@ -291,6 +300,21 @@ db_err DDL::drop_table(const char *in_name, Trx *trx, bool drop_db) noexcept {
   tables in Innobase. Deleting a row from SYS_INDEXES table also
   frees the file segments of the B-tree associated with the index. */
 
+  /* Only user tables have histograms and persistent statistics. They are
+  keyed by index id, which is never reused: rows left behind on failure are
+  only wasted space. */
+  if (strchr(table->m_name, '/') != nullptr) {
+    for (auto index : table->m_indexes) {
+      if (auto err = Index_histogram::drop(m_dict, index->m_id, trx); err != DB_SUCCESS) {
+        log_warn(std::format("Deleting the histogram of index {} of table {} failed with error {}", index->m_name, table->m_name, (int) err));
+      }
+
+      if (auto err = Dict_stats::drop(m_dict, index->m_id, trx); err != DB_SUCCESS) {
+        log_warn(std::format("Deleting the statistics of index {} of table {} failed with error {}", index->m_name, table->m_name, (int) err));
+      }
+    }
+  }
+
   auto info = pars_info_create();
 
   pars_info_add_str_literal(info, "table_name", in_name);
@@ -367,14 +391,11 @@ db_err DDL::drop_table(const char *in_name, Trx *trx, bool drop_db) noexcept {
     dict_table_remove_from_cache(table) below. */
     auto name_copy = mem_heap_strdup(heap, in_name);
     const auto space_id = table->m_space_id;
-
-    bool is_path;
+    const auto is_temp = table->is_temporary();
 
     if (table->m_dir_path_of_temp_table != nullptr) {
-      is_path = true;
       name_or_path = mem_heap_strdup(heap, table->m_dir_path_of_temp_table);
     } else {
-      is_path = false;
       name_or_path = name_copy;
     }
 
@@ -391,7 +412,7 @@ db_err DDL::drop_table(const char *in_name, Trx *trx, bool drop_db) noexcept {
     if (err == DB_SUCCESS && space_id != SYS_TABLESPACE) {
       auto fil = m_dict->m_store.m_fsp->m_fil;
 
-      if (!fil->space_for_table_exists_in_mem(space_id, name_or_path, is_path, false, true)) {
+      if (!fil->space_for_table_exists_in_mem(space_id, name_or_path, is_temp, false, !is_temp)) {
         err = DB_SUCCESS;
         log_info(std::format("Removed {} from the internal data dictionary", name_copy));
       } else if (!fil->delete_tablespace(space_id)) {
@@ -646,6 +667,8 @@ db_err DDL::truncate_table(Table *table, Trx *trx) noexcept{
     return err;
   };
 
+  (void) m_dict->table_load_foreigns(table);
+
   /* Check if the table is referenced by foreign key constraints from
   some other table (not the table itself) */
 
@@ -694,7 +717,15 @@ db_err DDL::truncate_table(Table *table, Trx *trx) noexcept{
 
   trx->m_table_id = table->m_id;
 
-  if (table->m_space_id > 0 && !table->m_dir_path_of_temp_table) {
+  if (table->m_space_id > 0 && srv_config.m_truncate_in_place) {
+    /* The index trees are freed and created in place below, like in the
+    system tablespace. The pages of the table stay in the buffer pool as
+    freed pages, there is no scan of the buffer pool. The read-ahead of the
+    old pages is discarded. The redo log of the old pages applies to the
+    same file, the tablespace keeps its id. */
+    fsp->m_fil->space_increment_version(table->m_space_id);
+
+  } else if (table->m_space_id > 0 && !table->m_dir_path_of_temp_table) {
     /* Discard and create the single-table tablespace. */
     auto space_id = table->m_space_id;
     const auto flags = fsp->m_fil->space_get_flags(space_id);
@@ -702,7 +733,7 @@ db_err DDL::truncate_table(Table *table, Trx *trx) noexcept{
     if (flags != ULINT_UNDEFINED && fsp->m_fil->discard_tablespace(space_id)) {
       space_id = SYS_TABLESPACE;
 
-      if (fsp->m_fil->create_new_single_table_tablespace(&space_id, table->m_name, false, flags, FIL_IBD_FILE_INITIAL_SIZE) != DB_SUCCESS) {
+      if (fsp->m_fil->create_new_single_table_tablespace(&space_id, table->m_name, table->is_temporary(), flags, FIL_IBD_FILE_INITIAL_SIZE) != DB_SUCCESS) {
         log_err(std::format("TRUNCATE TABLE {} failed to create a new tablespace", table->m_name));
         table->m_ibd_file_missing = true;
         return func_exit(DB_ERROR);
@@ -865,6 +896,14 @@ db_err DDL::drop_index(Table *table, Index *index, Trx *trx) noexcept {
 
   ut_a(err == DB_SUCCESS);
 
+  if (auto hist_err = Index_histogram::drop(m_dict, index->m_id, trx); hist_err != DB_SUCCESS) {
+    log_warn(std::format("Deleting the histogram of index {} of table {} failed with error {}", index->m_name, table->m_name, (int) hist_err));
+  }
+
+  if (auto stats_err = Dict_stats::drop(m_dict, index->m_id, trx); stats_err != DB_SUCCESS) {
+    log_warn(std::format("Deleting the statistics of index {} of table {} failed with error {}", index->m_name, table->m_name, (int) stats_err));
+  }
+
   /* Replace this index with another equivalent index for all
   foreign key constraints on this table where this index is used */
 
@@ -940,6 +979,9 @@ db_err DDL::rename_table(const char *old_name, const char *new_name, Trx *trx) n
     return func_exit(DB_TABLE_NOT_FOUND);
   }
 
+  /* The constraints in the cache are renamed with the table. */
+  (void) m_dict->table_load_foreigns(table);
+
   /* We use the private SQL parser of Innobase to generate the query
   graphs needed in updating the dictionary data from system tables. */
 
@@ -1218,6 +1260,8 @@ db_err DDL::drop_database(const char *name, Trx *trx) noexcept {
 
       /* Wait until the user does not have any queries running on the table */
 
+      table->m_published.store(false);
+
       if (table->m_n_handles_opened > 0) {
         m_dict->unlock_data_dictionary(trx);
 
@@ -23,9 +23,14 @@ Created 1/8/1996 Heikki Tuuri
 ***********************************************************************/
 
 #include "dict0dict.h"
+#include "btr0sea.h"
+#include "dict0hist.h"
+#include "dict0stats.h"
 #include "page0page.h"
+#include "que0que.h"
 #include "trx0undo.h"
 
+#include <algorithm>
 #include <ctype.h>
 
 /** The dictionary system */
@@ -51,8 +56,10 @@ Dict::~Dict() noexcept {
 
   mutex_acquire();
 
-  for (auto &it : m_tables) {
-    tables.emplace_back(it.second);
+  for (auto &shard : m_tables.m_shards) {
+    for (auto &it : shard.m_tables) {
+      tables.emplace_back(it.second);
+    }
   }
 
   for (auto table : tables) {
@@ -132,32 +139,100 @@ void Dict::index_stat_mutex_exit(const Index *index) noexcept {
 }
 
 void Dict::table_decrement_handle_count(Table *table, bool dict_locked) noexcept {
+  ut_ad(!dict_locked || mutex_own(&m_mutex));
+
+  /* A drop that sees the count above zero is deferred to the background
+  drop queue, so the last close doesn't need the dictionary mutex. */
+  const auto n_handles = table->m_n_handles_opened.fetch_sub(1);
+
+  ut_a(n_handles > 0);
+}
+
+void Dict::table_increment_handle_count(Table *table, bool dict_locked) noexcept {
   if (!dict_locked) {
     mutex_acquire();
   }
 
   ut_ad(mutex_own(&m_mutex));
-  ut_a(table->m_n_handles_opened > 0);
 
-  --table->m_n_handles_opened;
+  ++table->m_n_handles_opened;
+
+  table->m_lru_referenced.store(true, std::memory_order_relaxed);
 
   if (!dict_locked) {
     mutex_release();
   }
 }
 
-void Dict::table_increment_handle_count(Table *table, bool dict_locked) noexcept {
-  if (!dict_locked) {
-    mutex_acquire();
+bool Dict::table_can_be_evicted(const Table *table) const noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  /* The system tables and the temporary tables can't be loaded again. */
+  if (strchr(table->m_name, '/') == nullptr || table->m_dir_path_of_temp_table != nullptr || table->is_temporary()) {
+    return false;
   }
 
-  ut_ad(mutex_own(&m_mutex));
+  /* Purge, rollback and the foreign key checks hold the dictionary latch
+  while they use a table, record locks go with a table lock. */
+  if (table->m_n_foreign_key_checks_running > 0 || !table->m_locks.empty() || !table->m_foreign_list.empty() ||
+      !table->m_referenced_list.empty()) {
+    return false;
+  }
 
-  ++table->m_n_handles_opened;
+  for (auto index : table->m_indexes) {
+    if (index->m_to_be_dropped || *index->m_name == TEMP_INDEX_PREFIX) {
+      return false;
+    }
+  }
 
-  if (!dict_locked) {
-    mutex_release();
+  return true;
+}
+
+ulint Dict::evict_tables() noexcept {
+  const auto max_tables = srv_config.m_dict_table_cache_size;
+
+  if (max_tables == 0 || UT_LIST_GET_LEN(m_table_LRU) <= max_tables) {
+    return 0;
+  }
+
+  rw_lock_x_lock(&m_lock);
+
+  mutex_acquire();
+
+  ulint n_evicted{};
+  const auto n_tables = UT_LIST_GET_LEN(m_table_LRU);
+
+  /* Every table is visited at most once, a table that was opened since
+  the last pass gets a second chance at the head of the list. */
+  auto table = UT_LIST_GET_LAST(m_table_LRU);
+
+  for (ulint i{}; table != nullptr && i < n_tables && n_tables - n_evicted > max_tables; ++i) {
+    auto prev = UT_LIST_GET_PREV(m_table_LRU, table);
+
+    if (table->m_lru_referenced.exchange(false, std::memory_order_relaxed)) {
+      UT_LIST_REMOVE(m_table_LRU, table);
+      UT_LIST_ADD_FIRST(m_table_LRU, table);
+    } else if (table_can_be_evicted(table)) {
+      /* Stop the opens without the dictionary mutex before reading the
+      handle count, see Table_hash::acquire(). */
+      table->m_published.store(false);
+
+      if (table->m_n_handles_opened == 0) {
+        table_remove_from_cache(table);
+        ++n_evicted;
+      }
+    }
+
+    table = prev;
   }
+
+  m_n_tables_evicted += n_evicted;
+
+  mutex_release();
+
+  rw_lock_x_unlock(&m_lock);
+
+  return n_evicted;
 }
 
 Index *Dict::index_find_on_id(Dict_id id) noexcept {
@@ -284,12 +359,22 @@ bool Dict::table_col_in_clustered_key(const Table *table, ulint n) noexcept {
 }
 
 Table *Dict::table_get(const char *table_name, bool ref_count) noexcept {
+  if (ref_count) {
+    if (auto table = table_acquire_if_cached(table_name); table != nullptr) {
+      return table;
+    }
+  }
+
   mutex_acquire();
 
   auto table = table_get(table_name);
 
   if (ref_count && table != nullptr) {
     table_increment_handle_count(table, true);
+
+    if (!table->m_ibd_file_missing) {
+      table->m_published.store(true, std::memory_order_release);
+    }
   }
 
   mutex_release();
@@ -298,7 +383,7 @@ Table *Dict::table_get(const char *table_name, bool ref_count) noexcept {
     /* If table->m_ibd_file_missing == true, this will
     print an error message and return without doing
     anything. */
-    update_statistics(table);
+    Dict_stats::init(table);
   }
 
   return table;
@@ -311,6 +396,10 @@ Table *Dict::table_get_using_id(ib_recovery_t recovery, Dict_id table_id, bool r
 
   if (ref_count && table != nullptr) {
     table_increment_handle_count(table, true);
+
+    if (!table->m_ibd_file_missing) {
+      table->m_published.store(true, std::memory_order_release);
+    }
   }
 
   return table;
@@ -391,26 +480,16 @@ void Dict::table_add_to_cache(Table *table) noexcept {
 
   table->m_big_rows = row_len >= BIG_ROW_SIZE;
 
-  /* Look for a table with the same name: error if such exists */
-  if (const auto it = m_tables.find(table->m_name); it != m_tables.end()) {
-    ut_a(it->second == nullptr);
-  }
-
-  /* Look for a table with the same id: error if such exists */
-  if (const auto it = m_table_ids.find(table->m_id); it != m_table_ids.end()) {
-    ut_a(it->second == nullptr);
-  }
-
-  /* Add table to hash table of tables */
+  /* Add table to hash table of tables, error if a table with the same name exists */
   {
-    auto res = m_tables.emplace(std::string_view{table->m_name}, table);
-    ut_a(res.second);
+    const auto inserted = m_tables.insert(std::string_view{table->m_name}, table);
+    ut_a(inserted);
   }
 
-  /* Add table to hash table of tables based on table id */
+  /* Add table to hash table of tables based on table id, error if a table with the same id exists */
   {
-    auto res = m_table_ids.emplace(table->m_id, table);
-    ut_a(res.second);
+    const auto inserted = m_table_ids.insert(table->m_id, table);
+    ut_a(inserted);
   }
 
   /* Add table to LRU list of tables */
@@ -422,16 +501,14 @@ void Dict::table_add_to_cache(Table *table) noexcept {
 bool Dict::table_rename_in_cache(Table *table, const char *new_name, bool rename_also_foreigns) noexcept {
   ut_ad(mutex_own(&m_mutex));
 
+  ++m_schema_version;
+
   const auto old_size = mem_heap_get_size(table->m_heap);
   const auto old_name = table->m_name;
 
   /* Look for a table with the same name: error if such exists */
   {
-    Table *table2{nullptr};
-
-    if (const auto it = m_tables.find(new_name); it != m_tables.end()) {
-      table2 = it->second;
-    }
+    auto table2 = m_tables.find(new_name);
 
     if (likely_null(table2)) {
       log_err("Dictionary cache already contains a table ", new_name, " cannot rename table ", old_name);
@@ -456,7 +533,7 @@ bool Dict::table_rename_in_cache(Table *table, const char *new_name, bool rename
   table->m_name = mem_heap_strdup(table->m_heap, new_name);
 
   /* Add table to hash table of tables */
-  m_tables.emplace(table->m_name, table);
+  m_tables.insert(table->m_name, table);
   m_size += mem_heap_get_size(table->m_heap) - old_size;
 
   if (!rename_also_foreigns) {
@@ -557,19 +634,23 @@ void Dict::table_change_id_in_cache(Table *table, uint64_t new_id) noexcept {
   ut_ad(mutex_own(&m_mutex));
   ut_ad(table->m_magic_n == DICT_TABLE_MAGIC_N);
 
+  ++m_schema_version;
+
   /* Remove the table from the hash table of id's */
   m_table_ids.erase(table->m_id);
   table->m_id = new_id;
 
   /* Add the table back to the hash table */
-  auto ret = m_table_ids.emplace(table->m_id, table);
-  ut_ad(ret.second);
+  const auto inserted = m_table_ids.insert(table->m_id, table);
+  ut_ad(inserted);
 }
 
 void Dict::table_remove_from_cache(Table *table) noexcept {
   ut_ad(mutex_own(&m_mutex));
   ut_ad(table->m_magic_n == DICT_TABLE_MAGIC_N);
 
+  ++m_schema_version;
+
   /* Remove the foreign constraints from the cache */
   for (auto foreign : table->m_foreign_list) {
     foreign_remove_from_cache(foreign);
@@ -587,7 +668,10 @@ void Dict::table_remove_from_cache(Table *table) noexcept {
     index_remove_from_cache(table, index);
   }
 
-  /* Remove table from the hash tables of tables */
+  /* Remove table from the hash tables of tables, the X latches wait for
+  the lookups without the dictionary mutex to finish with the table. */
+  table->m_published.store(false);
+
   m_tables.erase(table->m_name);
   m_table_ids.erase(table->m_id);
 
@@ -714,8 +798,9 @@ bool Dict::index_too_big_for_tree(const Table *table, const Index *new_index) no
   page.  No additional sparse page directory entry will
   be generated for the first few user records. */
 
-  /* Maximum allowed size of a record on a leaf page */
-  auto page_rec_max = page_get_free_space_of_empty() / 2;
+  /* Maximum allowed size of a record on a leaf page, the field end offsets
+  limit it to REC_MAX_DATA_SIZE on the pages larger than 16K */
+  auto page_rec_max = std::min(page_get_free_space_of_empty() / 2, REC_MAX_DATA_SIZE);
 
   /* Maximum allowed size of a node pointer record */
   auto page_ptr_max = page_rec_max;
@@ -882,8 +967,45 @@ db_err Dict::index_add_to_cache(Index *index, ulint page_no, bool strict) noexce
     new_index->get_nth_field(i)->m_col->m_ord_part = 1;
   }
 
+  /* Count the leading key fields that compare as plain integers. */
+  new_index->m_n_int_fields = 0;
+
+  for (ulint i{}; i < n_ord; ++i) {
+    const auto field = new_index->get_nth_field(i);
+    const auto col = field->get_col();
+    const auto size = col->get_fixed_size();
+
+    if ((col->mtype != DATA_INT && col->mtype != DATA_SYS) || !(col->prtype & DATA_NOT_NULL) || field->m_prefix_len > 0 || size == 0 || size > 8) {
+      break;
+    }
+
+    ++new_index->m_n_int_fields;
+  }
+
+  /* Without NULLs and variable-length fields the leaf records all have the
+  same field offsets, work them out once. */
+  {
+    ulint end{};
+    auto ends = reinterpret_cast<ulint *>(mem_heap_alloc(new_index->m_heap, new_index->m_n_fields * sizeof(ulint)));
+
+    for (ulint i{}; i < new_index->m_n_fields; ++i) {
+      const auto field = new_index->get_nth_field(i);
+
+      if (!(field->get_col()->prtype & DATA_NOT_NULL) || field->m_fixed_len == 0) {
+        ends = nullptr;
+        break;
+      }
+
+      end += field->m_fixed_len;
+      ends[i] = end;
+    }
+
+    new_index->m_fixed_field_ends = ends;
+  }
+
   /* Add the new index as the last index for the table */
 
+  table->graph_cache_clear();
   table->m_indexes.push_back(new_index);
   new_index->m_table = table;
 
@@ -909,6 +1031,8 @@ db_err Dict::index_add_to_cache(Index *index, ulint page_no, bool strict) noexce
 
   m_size += mem_heap_get_size(new_index->m_heap);
 
+  ++m_schema_version;
+
   Index::destroy(index, Current_location());
 
   return DB_SUCCESS;
@@ -921,9 +1045,18 @@ void Dict::index_remove_from_cache(Table *table, Index *index) noexcept {
   ut_ad(index->m_magic_n == DICT_INDEX_MAGIC_N);
   ut_ad(mutex_own(&m_mutex));
 
+  ++m_schema_version;
+
+  if (srv_btr_search != nullptr) {
+    srv_btr_search->drop_index(index->m_id);
+  }
+
   rw_lock_free(&index->m_lock);
 
+  Index_histogram::destroy(index->m_histogram);
+
   /* Remove the index from the list of indexes of the table */
+  table->graph_cache_clear();
   table->m_indexes.remove(index);
 
   const auto size = mem_heap_get_size(index->m_heap);
@@ -1354,10 +1487,26 @@ Table::Table(mem_heap_t *heap, const char *name, space_id_t space_id, ulint n_co
 }
 
 Table::~Table() noexcept {
+  graph_cache_clear();
+
   ut_d(m_cached = false);
   ut_ad(m_magic_n == DICT_TABLE_MAGIC_N);
 }
 
+void Table::graph_cache_clear() noexcept {
+  std::lock_guard<std::mutex> lock(m_graph_cache.m_mutex);
+
+  for (auto graphs : {&m_graph_cache.m_ins, &m_graph_cache.m_upd}) {
+    for (auto graph : *graphs) {
+      que_graph_free(graph);
+    }
+
+    graphs->clear();
+  }
+
+  ++m_graph_cache.m_version;
+}
+
 Table *Table::create(const char *name, space_id_t space, ulint n_cols, ulint flags, bool ibd_file_missing, Source_location loc) noexcept {
   ut_a(!(flags & (~0UL << DICT_TF2_BITS)));
 
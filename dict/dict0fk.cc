@@ -40,6 +40,9 @@ Created 2024-Oct-15 by Sunny Bains
 
 #include <ctype.h>
 
+#include <algorithm>
+#include <vector>
+
 void Dict::foreign_remove_from_cache(Foreign *&foreign) noexcept {
   // ut_ad(mutex_own(&m_mutex));
 
@@ -138,6 +141,59 @@ void Dict::foreign_error_report(Foreign *fk, const char *msg) noexcept {
   mutex_exit(&m_foreign_err_mutex);
 }
 
+db_err Dict::table_load_foreigns(Table *table) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (table->m_foreigns_loaded.load(std::memory_order_relaxed)) {
+    return DB_SUCCESS;
+  }
+
+  /* A cascading update or delete reaches the tables that are linked to
+  this one, their constraints are loaded too. The flags are only set
+  when all the lists are complete: DML checks them without the mutex. */
+  std::vector<Table *> pending{table};
+  std::vector<Table *> loaded{};
+  db_err err{DB_SUCCESS};
+
+  while (!pending.empty()) {
+    auto next = pending.back();
+
+    pending.pop_back();
+
+    if (next->m_foreigns_loaded.load(std::memory_order_relaxed) || std::find(loaded.begin(), loaded.end(), next) != loaded.end()) {
+      continue;
+    }
+
+    loaded.push_back(next);
+
+    if (auto load_err = m_loader.load_foreigns(next->m_name, true); load_err != DB_SUCCESS && load_err != DB_NOT_FOUND) {
+      log_warn(std::format("Loading the foreign key constraints of table {} failed with error {}", next->m_name, (int) load_err));
+
+      if (err == DB_SUCCESS) {
+        err = load_err;
+      }
+    }
+
+    for (auto foreign : next->m_foreign_list) {
+      if (foreign->m_referenced_table != nullptr) {
+        pending.push_back(foreign->m_referenced_table);
+      }
+    }
+
+    for (auto foreign : next->m_referenced_list) {
+      if (foreign->m_foreign_table != nullptr) {
+        pending.push_back(foreign->m_foreign_table);
+      }
+    }
+  }
+
+  for (auto loaded_table : loaded) {
+    loaded_table->m_foreigns_loaded.store(true, std::memory_order_release);
+  }
+
+  return err;
+}
+
 db_err Dict::foreign_add_to_cache(Foreign *foreign, bool check_charsets) noexcept {
   Index *index;
 
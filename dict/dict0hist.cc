@@ -0,0 +1,526 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file dict/dict0hist.cc
+Equi-depth histograms of the keys of an index
+*******************************************************/
+
+#include "dict0hist.h"
+#include "data0data.h"
+#include "dict0dict.h"
+#include "mach0data.h"
+#include "page0cur.h"
+#include "pars0pars.h"
+#include "que0que.h"
+#include "rem0cmp.h"
+#include "rem0rec.h"
+#include "row0pread.h"
+#include "row0sel.h"
+#include "srv0srv.h"
+#include "trx0roll.h"
+#include "trx0sys.h"
+#include "trx0trx.h"
+
+#include <algorithm>
+
+/** Histograms are kept for user tables only, their names are prefixed
+with the database name. */
+static bool has_histograms(const Table *table) noexcept {
+  return strchr(table->m_name, '/') != nullptr;
+}
+
+/**
+ * Compares a key with a bucket bound on the fields that both have.
+ *
+ * @param[in] index             Index of the key.
+ * @param[in] tuple             Key, may be a prefix.
+ * @param[in] bound             Bucket bound.
+ *
+ * @return 1, 0, -1 if tuple is greater, equal, less than the bound.
+ */
+static int compare(const Index *index, const DTuple *tuple, const DTuple *bound) noexcept {
+  const auto n_fields = std::min(dtuple_get_n_fields_cmp(tuple), dtuple_get_n_fields(bound));
+
+  for (ulint i{}; i < n_fields; ++i) {
+    const auto cmp = cmp_dfield_dfield(index->m_cmp_ctx, dtuple_get_nth_field(tuple, i), dtuple_get_nth_field(bound, i));
+
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+
+  return 0;
+}
+
+Index_histogram::Index_histogram(const Index *index) noexcept : m_index(index), m_heap(mem_heap_create(1024)) {}
+
+Index_histogram::~Index_histogram() noexcept {
+  mem_heap_free(m_heap);
+}
+
+void Index_histogram::destroy(Index_histogram *&histogram) noexcept {
+  if (histogram != nullptr) {
+    call_destructor(histogram);
+    ut_delete(histogram);
+    histogram = nullptr;
+  }
+}
+
+Index_histogram *Index_histogram::build(Index *index) noexcept {
+  using Samples = std::vector<DTuple *>;
+
+  const auto n_uniq = index->get_n_unique();
+  const auto n_rows = uint64_t(std::max<int64_t>(index->m_table->m_stats.m_n_rows, 1));
+  const auto step = std::max<uint64_t>(n_rows / (N_BUCKETS * N_SAMPLES_PER_BUCKET), 1);
+
+  std::vector<mem_heap_t *> heaps{};
+  std::vector<Samples> samples(N_THREADS);
+  std::vector<uint64_t> n_recs(N_THREADS);
+
+  for (ulint i{}; i < N_THREADS; ++i) {
+    heaps.push_back(mem_heap_create(4096));
+  }
+
+  Parallel_reader reader(N_THREADS);
+  Parallel_reader::Scan_range full_scan;
+  Parallel_reader::Config config(full_scan, index);
+
+  /* A full scan for statistics must not evict the working set. */
+  config.m_scan_resistant = true;
+
+  /* Without a transaction the latest version of the records is read, that
+  is good enough for statistics. */
+  auto err = reader.add_scan(nullptr, config, [&](const Parallel_reader::Ctx *ctx) {
+    const auto id = ctx->thread_id();
+
+    if (n_recs[id]++ % step == 0) {
+      auto tuple = dtuple_create(heaps[id], n_uniq);
+
+      index->copy_types(tuple, n_uniq);
+
+      rec_copy_prefix_to_dtuple(tuple, ctx->m_rec, index, n_uniq, heaps[id]);
+
+      samples[id].push_back(tuple);
+    }
+
+    return DB_SUCCESS;
+  });
+
+  const auto n_threads = Parallel_reader::available_threads(N_THREADS, false);
+
+  if (err == DB_SUCCESS) {
+    err = reader.run(n_threads);
+  }
+
+  if (err == DB_OUT_OF_RESOURCES) {
+    err = reader.run(0);
+  }
+
+  Index_histogram *histogram{};
+
+  if (err == DB_SUCCESS) {
+    Samples all{};
+    uint64_t n_total{};
+
+    for (ulint i{}; i < N_THREADS; ++i) {
+      n_total += n_recs[i];
+      all.insert(all.end(), samples[i].begin(), samples[i].end());
+    }
+
+    std::sort(all.begin(), all.end(), [index](const DTuple *lhs, const DTuple *rhs) {
+      return compare(index, lhs, rhs) < 0;
+    });
+
+    auto ptr = ut_new(sizeof(Index_histogram));
+    histogram = new (ptr) Index_histogram(index);
+
+    const auto n_samples = all.size();
+    const auto n_buckets = std::min<ulint>(N_BUCKETS, n_samples);
+
+    for (ulint i{}; i < n_buckets; ++i) {
+      /* Last sample of the bucket, the samples are spread evenly. */
+      const auto pos = (i + 1) * n_samples / n_buckets - 1;
+      auto bound = dtuple_copy(all[pos], histogram->m_heap);
+
+      for (ulint j{}; j < n_uniq; ++j) {
+        dfield_dup(dtuple_get_nth_field(bound, j), histogram->m_heap);
+      }
+
+      const auto n_bucket_rows = i + 1 == n_buckets ? n_total : (pos + 1) * n_total / n_samples;
+
+      histogram->m_buckets.push_back(Bucket{.m_bound = bound, .m_n_rows = n_bucket_rows});
+    }
+  } else {
+    log_warn(std::format("Histogram scan of index {} of table {} failed with error {}", index->m_name, index->m_table->m_name, (int) err));
+  }
+
+  for (auto heap : heaps) {
+    mem_heap_free(heap);
+  }
+
+  return histogram;
+}
+
+db_err Index_histogram::save(Trx *trx) const noexcept {
+  auto info = pars_info_create();
+
+  pars_info_add_uint64_literal(info, "index_id", m_index->m_id);
+
+  auto err = que_eval_sql(
+    info,
+    "PROCEDURE DELETE_HISTOGRAM_PROC () IS\n"
+    "BEGIN\n"
+    "DELETE FROM SYS_HISTOGRAMS WHERE INDEX_ID = :index_id;\n"
+    "END;\n",
+    true,
+    trx
+  );
+
+  for (ulint i{}; err == DB_SUCCESS && i < m_buckets.size(); ++i) {
+    const auto bound = m_buckets[i].m_bound;
+    const auto n_fields = dtuple_get_n_fields(bound);
+
+    info = pars_info_create();
+
+    /* Each field is stored as a 4 byte length, UNIV_SQL_NULL for
+    SQL NULL, followed by the data. */
+    ulint len{};
+
+    for (ulint j{}; j < n_fields; ++j) {
+      const auto field = dtuple_get_nth_field(bound, j);
+
+      len += 4 + (dfield_is_null(field) ? 0 : dfield_get_len(field));
+    }
+
+    auto buf = reinterpret_cast<byte *>(mem_heap_alloc(info->m_heap, len));
+    auto ptr = buf;
+
+    for (ulint j{}; j < n_fields; ++j) {
+      const auto field = dtuple_get_nth_field(bound, j);
+
+      if (dfield_is_null(field)) {
+        mach_write_to_4(ptr, UNIV_SQL_NULL);
+        ptr += 4;
+      } else {
+        const auto field_len = dfield_get_len(field);
+
+        mach_write_to_4(ptr, field_len);
+        memcpy(ptr + 4, dfield_get_data(field), field_len);
+        ptr += 4 + field_len;
+      }
+    }
+
+    pars_info_add_uint64_literal(info, "index_id", m_index->m_id);
+    pars_info_add_int4_literal(info, "bucket", lint(i));
+    pars_info_add_uint64_literal(info, "n_rows", m_buckets[i].m_n_rows);
+    pars_info_add_literal(info, "bound", buf, len, DATA_BLOB, DATA_BINARY_TYPE);
+
+    err = que_eval_sql(
+      info,
+      "PROCEDURE INSERT_HISTOGRAM_PROC () IS\n"
+      "BEGIN\n"
+      "INSERT INTO SYS_HISTOGRAMS VALUES (:index_id, :bucket, :n_rows, :bound);\n"
+      "END;\n",
+      true,
+      trx
+    );
+  }
+
+  return err;
+}
+
+bool Index_histogram::add_bucket(uint64_t n_rows, const byte *ptr, ulint len) noexcept {
+  const auto n_uniq = m_index->get_n_unique();
+
+  if (!m_buckets.empty() && n_rows < m_buckets.back().m_n_rows) {
+    return false;
+  }
+
+  auto bound = dtuple_create(m_heap, n_uniq);
+
+  m_index->copy_types(bound, n_uniq);
+
+  const auto end = ptr + len;
+
+  for (ulint i{}; i < n_uniq; ++i) {
+    auto field = dtuple_get_nth_field(bound, i);
+
+    if (end - ptr < 4) {
+      return false;
+    }
+
+    const auto field_len = mach_read_from_4(ptr);
+
+    ptr += 4;
+
+    if (field_len == UNIV_SQL_NULL) {
+      dfield_set_null(field);
+    } else if (ulint(end - ptr) < field_len) {
+      return false;
+    } else {
+      dfield_set_data(field, mem_heap_dup(m_heap, ptr, field_len), field_len);
+      ptr += field_len;
+    }
+  }
+
+  if (ptr != end) {
+    return false;
+  }
+
+  m_buckets.push_back(Bucket{.m_bound = bound, .m_n_rows = n_rows});
+
+  return true;
+}
+
+void *Index_histogram::fetch_bucket(void *row, void *arg) noexcept {
+  auto node = static_cast<sel_node_t *>(row);
+  auto histogram = static_cast<Index_histogram *>(arg);
+
+  auto exp = node->m_select_list;
+  const auto n_rows_field = que_node_get_val(exp);
+  const auto bound_field = que_node_get_val(que_node_get_next(exp));
+
+  ut_a(dfield_get_len(n_rows_field) == 8);
+
+  const auto n_rows = mach_read_from_8(static_cast<const byte *>(dfield_get_data(n_rows_field)));
+
+  if (dfield_is_null(bound_field) ||
+      !histogram->add_bucket(n_rows, static_cast<const byte *>(dfield_get_data(bound_field)), dfield_get_len(bound_field))) {
+
+    log_warn(std::format("Ignoring the malformed histogram of index {} of table {}", histogram->m_index->m_name, histogram->m_index->m_table->m_name));
+
+    histogram->m_buckets.clear();
+
+    return nullptr;
+  }
+
+  return histogram;
+}
+
+Index_histogram *Index_histogram::load(const Index *index) noexcept {
+  auto ptr = ut_new(sizeof(Index_histogram));
+  auto histogram = new (ptr) Index_histogram(index);
+
+  auto info = pars_info_create();
+
+  pars_info_add_uint64_literal(info, "index_id", index->m_id);
+  pars_info_add_function(info, "fetch_bucket", fetch_bucket, histogram);
+
+  auto trx = srv_trx_sys->create_user_trx(nullptr);
+  auto started = trx->start(ULINT_UNDEFINED);
+  ut_a(started);
+
+  trx->m_op_info = "loading index histogram";
+
+  auto err = que_eval_sql(
+    info,
+    "PROCEDURE LOAD_HISTOGRAM_PROC () IS\n"
+    "DECLARE FUNCTION fetch_bucket;\n"
+    "DECLARE CURSOR c IS\n"
+    "  SELECT N_ROWS, BOUND FROM SYS_HISTOGRAMS\n"
+    "  WHERE INDEX_ID = :index_id ORDER BY BUCKET;\n"
+    "BEGIN\n"
+    "  OPEN c;\n"
+    "  WHILE 1 = 1 LOOP\n"
+    "    FETCH c INTO fetch_bucket();\n"
+    "    IF (SQL % NOTFOUND) THEN\n"
+    "      EXIT;\n"
+    "    END IF;\n"
+    "  END LOOP;\n"
+    "  CLOSE c;\n"
+    "END;\n",
+    true,
+    trx
+  );
+
+  auto err_commit = trx->commit();
+  ut_a(err_commit == DB_SUCCESS);
+
+  trx->m_op_info = "";
+
+  srv_trx_sys->destroy_user_trx(trx);
+
+  if (err != DB_SUCCESS || histogram->m_buckets.empty()) {
+    destroy(histogram);
+  }
+
+  return histogram;
+}
+
+void Index_histogram::install(Index *index, Index_histogram *histogram) noexcept {
+  srv_dict_sys->index_stat_mutex_enter(index);
+
+  std::swap(index->m_histogram, histogram);
+  index->m_histogram_loaded = true;
+
+  srv_dict_sys->index_stat_mutex_exit(index);
+
+  destroy(histogram);
+}
+
+db_err Index_histogram::update(Table *table) noexcept {
+  /* A badly corrupted index can cause a crash in the scan, see Dict::update_statistics(). */
+  if (!has_histograms(table) || table->m_ibd_file_missing || srv_config.m_force_recovery > IB_RECOVERY_NO_TRX_UNDO) {
+    return DB_SUCCESS;
+  }
+
+  table->m_stats.m_hist_modified_counter = 0;
+
+  auto trx = srv_trx_sys->create_user_trx(nullptr);
+  auto started = trx->start(ULINT_UNDEFINED);
+  ut_a(started);
+
+  trx->m_op_info = "updating index histograms";
+
+  db_err err{DB_SUCCESS};
+
+  for (auto index : table->m_indexes) {
+    auto histogram = build(index);
+
+    if (histogram == nullptr) {
+      err = DB_ERROR;
+      break;
+    }
+
+    err = histogram->save(trx);
+
+    if (err != DB_SUCCESS) {
+      destroy(histogram);
+      break;
+    }
+
+    install(index, histogram);
+  }
+
+  if (err == DB_SUCCESS) {
+    err = trx->commit();
+  } else {
+    trx->m_error_state = DB_SUCCESS;
+    trx_general_rollback(trx, false, nullptr);
+  }
+
+  trx->m_op_info = "";
+
+  srv_trx_sys->destroy_user_trx(trx);
+
+  return err;
+}
+
+void Index_histogram::load_or_refresh(Index *index) noexcept {
+  auto table = index->m_table;
+
+  if (!has_histograms(table) || srv_config.m_force_recovery > IB_RECOVERY_NO_TRX_UNDO) {
+    return;
+  }
+
+  srv_dict_sys->index_stat_mutex_enter(index);
+
+  const auto loaded = index->m_histogram_loaded;
+  auto has_histogram = index->m_histogram != nullptr;
+
+  /* Only one thread reads the stored histogram. */
+  index->m_histogram_loaded = true;
+
+  srv_dict_sys->index_stat_mutex_exit(index);
+
+  if (!loaded) {
+    auto histogram = load(index);
+
+    has_histogram = histogram != nullptr;
+
+    install(index, histogram);
+  }
+
+  /* Only the tables that were analyzed once get their histograms refreshed. */
+  if (has_histogram && int64_t(table->m_stats.m_hist_modified_counter) > 16 + table->m_stats.m_n_rows / int64_t(REFRESH_RATIO)) {
+    (void) update(table);
+  }
+}
+
+db_err Index_histogram::drop(Dict *dict, Dict_id index_id, Trx *trx) noexcept {
+  ut_ad(mutex_own(&dict->m_mutex));
+
+  /* The table is missing while the dictionary is being created. */
+  if (dict->table_get("SYS_HISTOGRAMS") == nullptr) {
+    return DB_SUCCESS;
+  }
+
+  auto info = pars_info_create();
+
+  pars_info_add_uint64_literal(info, "index_id", index_id);
+
+  return que_eval_sql(
+    info,
+    "PROCEDURE DROP_HISTOGRAM_PROC () IS\n"
+    "BEGIN\n"
+    "DELETE FROM SYS_HISTOGRAMS WHERE INDEX_ID = :index_id;\n"
+    "END;\n",
+    false,
+    trx
+  );
+}
+
+uint64_t Index_histogram::get_n_rows_before(const DTuple *tuple, bool inclusive) const noexcept {
+  /* The first bucket whose bound is not below the key, or not below or
+  equal to it when the rows equal to the key are counted. */
+  const auto it = std::partition_point(m_buckets.begin(), m_buckets.end(), [&](const Bucket &bucket) {
+    const auto cmp = compare(m_index, tuple, bucket.m_bound);
+    return inclusive ? cmp >= 0 : cmp > 0;
+  });
+
+  if (it == m_buckets.end()) {
+    return m_buckets.back().m_n_rows;
+  }
+
+  const auto n_rows_before = it == m_buckets.begin() ? 0 : std::prev(it)->m_n_rows;
+
+  /* Assume the key is in the middle of its bucket. */
+  return n_rows_before + (it->m_n_rows - n_rows_before) / 2;
+}
+
+int64_t Index_histogram::estimate_n_rows_in_range(
+  const Index *index, const DTuple *tuple1, ulint mode1, const DTuple *tuple2, ulint mode2) noexcept {
+
+  int64_t n_rows{-1};
+
+  srv_dict_sys->index_stat_mutex_enter(index);
+
+  if (const auto histogram = index->m_histogram; histogram != nullptr) {
+    const auto n_total = histogram->m_buckets.back().m_n_rows;
+
+    const auto low = dtuple_get_n_fields(tuple1) == 0 ? 0 : histogram->get_n_rows_before(tuple1, mode1 == PAGE_CUR_G);
+
+    const auto high =
+      dtuple_get_n_fields(tuple2) == 0 ? n_total : histogram->get_n_rows_before(tuple2, mode2 == PAGE_CUR_G || mode2 == PAGE_CUR_LE);
+
+    const auto n_range = high > low ? high - low : 1;
+
+    /* Scale to the current size of the table, the histogram is from
+    the last time the table was analyzed. */
+    const auto n_table_rows = index->m_table->m_stats.m_n_rows;
+
+    if (n_total > 0 && n_table_rows > 0) {
+      n_rows = std::max<int64_t>(int64_t(double(n_range) * double(n_table_rows) / double(n_total)), 1);
+    } else {
+      n_rows = int64_t(n_range);
+    }
+  }
+
+  srv_dict_sys->index_stat_mutex_exit(index);
+
+  return n_rows;
+}
@@ -285,24 +285,36 @@ db_err Dict_load::open(bool in_crash_recovery) noexcept {
 
         const auto space_id = mach_read_from_4(field);
 
+        field = rec_get_nth_field(rec, 7, &len);
+
+        const auto is_temp = (mach_read_from_4(field) & DICT_TF2_TEMPORARY) != 0;
+
         pcur.store_position(&mtr);
 
         mtr.commit();
 
         if (space_id == DICT_HDR_SPACE) {
           /* The system tablespace always exists. */
+        } else if (is_temp) {
+          /* A temporary table is dropped below in drop_all_temp_tables(),
+          its file is not opened and may not be consistent after a crash. */
+          if (!srv_config.m_read_only) {
+            auto path = fil->make_ibd_name(name, true);
+
+            (void) os_file_delete_if_exists(path);
+
+            mem_free(path);
+          }
+
         } else if (in_crash_recovery) {
           /* Check that the tablespace (the .ibd file) really exists; print a warning
-           if not. Do not print warnings for temporary tables. */
+           if not. */
           field = rec_get_nth_field(rec, 4, &len);
 
           /* Don't support any other format than V1 */
           ut_a((mach_read_from_4(field) & 0x80000000UL) != 0);
 
-          field = rec_get_nth_field(rec, 7, &len);
-          auto is_temp = (mach_read_from_4(field) & DICT_TF2_TEMPORARY) != 0;
-
-          fil->space_for_table_exists_in_mem(space_id, name, is_temp, true, !is_temp);
+          fil->space_for_table_exists_in_mem(space_id, name, false, true, true);
 
         } else {
           /* It is a normal database startup: create the space object and
@@ -757,10 +769,10 @@ Table *Dict_load::load_table(ib_recovery_t recovery, const char *name) noexcept
 
   /* If the force recovery flag is set, we open the table irrespective
   of the error condition, since the user may want to dump data from the
-  clustered index. However we load the foreign key information only if
-  all indexes were loaded. */
+  clustered index. The foreign key constraints are loaded by the first
+  DML or DDL on the table, see Dict::table_load_foreigns(). */
   if (err == DB_SUCCESS) {
-    err = load_foreigns(table->m_name, true);
+    ++m_dict->m_n_tables_loaded;
   } else if (recovery == IB_RECOVERY_DEFAULT) {
     m_dict->table_remove_from_cache(table);
     table = nullptr;
@@ -0,0 +1,384 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file dict/dict0stats.cc
+Persistent index statistics
+*******************************************************/
+
+#include "dict0stats.h"
+#include "dict0dict.h"
+#include "mach0data.h"
+#include "pars0pars.h"
+#include "que0que.h"
+#include "row0sel.h"
+#include "srv0srv.h"
+#include "trx0roll.h"
+#include "trx0sys.h"
+#include "trx0trx.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+/** A SYS_INDEX_STATS row read by Dict_stats::load(). */
+struct Index_stats_row {
+  /** Index whose row is read. */
+  const Index *m_index{};
+
+  /** true if the row was found and is well formed. */
+  bool m_found{};
+
+  /** SAMPLE_PAGES column. */
+  ulint m_sample_pages{};
+
+  /** INDEX_SIZE column. */
+  page_no_t m_index_size{};
+
+  /** N_LEAF_PAGES column. */
+  page_no_t m_n_leaf_pages{};
+
+  /** N_DIFF column, one estimate per key prefix. */
+  std::vector<int64_t> m_n_diff{};
+};
+
+/** Protects recalc_queue. */
+static std::mutex recalc_mutex;
+
+/** Ids of the tables whose statistics the master thread recalculates. */
+static std::vector<Dict_id> recalc_queue;
+
+/** Statistics are persisted for user tables only, their names are
+prefixed with the database name. */
+static bool has_persistent_stats(const Table *table) noexcept {
+  return srv_dict_sys->m_persistent_stats && strchr(table->m_name, '/') != nullptr;
+}
+
+void *Dict_stats::fetch_row(void *row, void *arg) noexcept {
+  auto node = static_cast<sel_node_t *>(row);
+  auto stats_row = static_cast<Index_stats_row *>(arg);
+  const auto n_diff_len = (stats_row->m_index->get_n_unique() + 1) * 8;
+
+  auto exp = node->m_select_list;
+  const auto sample_pages_field = que_node_get_val(exp);
+
+  exp = que_node_get_next(exp);
+  const auto index_size_field = que_node_get_val(exp);
+
+  exp = que_node_get_next(exp);
+  const auto n_leaf_pages_field = que_node_get_val(exp);
+
+  exp = que_node_get_next(exp);
+  const auto n_diff_field = que_node_get_val(exp);
+
+  ut_a(dfield_get_len(sample_pages_field) == 4);
+  ut_a(dfield_get_len(index_size_field) == 4);
+  ut_a(dfield_get_len(n_leaf_pages_field) == 4);
+
+  if (dfield_is_null(n_diff_field) || dfield_get_len(n_diff_field) != n_diff_len) {
+    log_warn(std::format(
+      "Ignoring the malformed statistics of index {} of table {}", stats_row->m_index->m_name, stats_row->m_index->m_table->m_name));
+
+    return nullptr;
+  }
+
+  stats_row->m_sample_pages = mach_read_from_4(static_cast<const byte *>(dfield_get_data(sample_pages_field)));
+  stats_row->m_index_size = page_no_t(mach_read_from_4(static_cast<const byte *>(dfield_get_data(index_size_field))));
+  stats_row->m_n_leaf_pages = page_no_t(mach_read_from_4(static_cast<const byte *>(dfield_get_data(n_leaf_pages_field))));
+
+  auto ptr = static_cast<const byte *>(dfield_get_data(n_diff_field));
+
+  for (ulint i{}; i <= stats_row->m_index->get_n_unique(); ++i, ptr += 8) {
+    stats_row->m_n_diff.push_back(int64_t(mach_read_from_8(ptr)));
+  }
+
+  stats_row->m_found = true;
+
+  return nullptr;
+}
+
+bool Dict_stats::load(Table *table) noexcept {
+  std::vector<Index_stats_row> rows{};
+
+  auto trx = srv_trx_sys->create_user_trx(nullptr);
+  auto started = trx->start(ULINT_UNDEFINED);
+  ut_a(started);
+
+  trx->m_op_info = "loading index statistics";
+
+  for (auto index : table->m_indexes) {
+    rows.push_back(Index_stats_row{.m_index = index});
+  }
+
+  db_err err{DB_SUCCESS};
+
+  for (auto &row : rows) {
+    auto info = pars_info_create();
+
+    pars_info_add_uint64_literal(info, "index_id", row.m_index->m_id);
+    pars_info_add_function(info, "fetch_row", fetch_row, &row);
+
+    err = que_eval_sql(
+      info,
+      "PROCEDURE LOAD_INDEX_STATS_PROC () IS\n"
+      "DECLARE FUNCTION fetch_row;\n"
+      "DECLARE CURSOR c IS\n"
+      "  SELECT SAMPLE_PAGES, INDEX_SIZE, N_LEAF_PAGES, N_DIFF\n"
+      "  FROM SYS_INDEX_STATS WHERE INDEX_ID = :index_id;\n"
+      "BEGIN\n"
+      "  OPEN c;\n"
+      "  FETCH c INTO fetch_row();\n"
+      "  CLOSE c;\n"
+      "END;\n",
+      true,
+      trx
+    );
+
+    if (err != DB_SUCCESS || !row.m_found) {
+      break;
+    }
+  }
+
+  auto err_commit = trx->commit();
+  ut_a(err_commit == DB_SUCCESS);
+
+  trx->m_op_info = "";
+
+  srv_trx_sys->destroy_user_trx(trx);
+
+  /* An index that was added since the statistics were stored has none,
+  they are all calculated again then. */
+  if (err != DB_SUCCESS || !std::all_of(rows.begin(), rows.end(), [](const Index_stats_row &row) { return row.m_found; })) {
+    return false;
+  }
+
+  ulint sum_of_index_sizes{};
+
+  for (auto &row : rows) {
+    auto index = const_cast<Index *>(row.m_index);
+
+    srv_dict_sys->index_stat_mutex_enter(index);
+
+    index->m_stats.m_index_size = row.m_index_size;
+    index->m_stats.m_n_leaf_pages = row.m_n_leaf_pages;
+
+    std::copy(row.m_n_diff.begin(), row.m_n_diff.end(), index->m_stats.m_n_diff_key_vals);
+
+    srv_dict_sys->index_stat_mutex_exit(index);
+
+    sum_of_index_sizes += row.m_index_size;
+  }
+
+  auto &stats = table->m_stats;
+  const auto &clust = rows.front();
+
+  stats.m_sample_pages = clust.m_sample_pages;
+  stats.m_n_rows = clust.m_n_diff[clust.m_index->get_n_unique()];
+  stats.m_clustered_index_size = clust.m_index_size;
+  stats.m_sum_of_secondary_index_sizes = sum_of_index_sizes - clust.m_index_size;
+  stats.m_initialized = true;
+  stats.m_modified_counter = 0;
+
+  return true;
+}
+
+db_err Dict_stats::save(const Table *table) noexcept {
+  auto trx = srv_trx_sys->create_user_trx(nullptr);
+  auto started = trx->start(ULINT_UNDEFINED);
+  ut_a(started);
+
+  trx->m_op_info = "storing index statistics";
+
+  db_err err{DB_SUCCESS};
+
+  for (auto index : table->m_indexes) {
+    auto info = pars_info_create();
+
+    pars_info_add_uint64_literal(info, "index_id", index->m_id);
+
+    err = que_eval_sql(
+      info,
+      "PROCEDURE DELETE_INDEX_STATS_PROC () IS\n"
+      "BEGIN\n"
+      "DELETE FROM SYS_INDEX_STATS WHERE INDEX_ID = :index_id;\n"
+      "END;\n",
+      true,
+      trx
+    );
+
+    if (err != DB_SUCCESS) {
+      break;
+    }
+
+    const auto n_diff_len = (index->get_n_unique() + 1) * 8;
+
+    info = pars_info_create();
+
+    auto n_diff = reinterpret_cast<byte *>(mem_heap_alloc(info->m_heap, n_diff_len));
+
+    srv_dict_sys->index_stat_mutex_enter(index);
+
+    const auto index_size = index->m_stats.m_index_size;
+    const auto n_leaf_pages = index->m_stats.m_n_leaf_pages;
+
+    for (ulint i{}; i <= index->get_n_unique(); ++i) {
+      mach_write_to_8(n_diff + i * 8, uint64_t(index->m_stats.m_n_diff_key_vals[i]));
+    }
+
+    srv_dict_sys->index_stat_mutex_exit(index);
+
+    pars_info_add_uint64_literal(info, "index_id", index->m_id);
+    pars_info_add_int4_literal(info, "sample_pages", lint(table->m_stats.m_sample_pages));
+    pars_info_add_int4_literal(info, "index_size", lint(index_size));
+    pars_info_add_int4_literal(info, "n_leaf_pages", lint(n_leaf_pages));
+    pars_info_add_literal(info, "n_diff", n_diff, n_diff_len, DATA_BLOB, DATA_BINARY_TYPE);
+
+    err = que_eval_sql(
+      info,
+      "PROCEDURE INSERT_INDEX_STATS_PROC () IS\n"
+      "BEGIN\n"
+      "INSERT INTO SYS_INDEX_STATS VALUES (:index_id, :sample_pages, :index_size, :n_leaf_pages, :n_diff);\n"
+      "END;\n",
+      true,
+      trx
+    );
+
+    if (err != DB_SUCCESS) {
+      break;
+    }
+  }
+
+  if (err == DB_SUCCESS) {
+    err = trx->commit();
+  } else {
+    trx->m_error_state = DB_SUCCESS;
+    trx_general_rollback(trx, false, nullptr);
+  }
+
+  trx->m_op_info = "";
+
+  srv_trx_sys->destroy_user_trx(trx);
+
+  return err;
+}
+
+void Dict_stats::init(Table *table) noexcept {
+  if (has_persistent_stats(table) && !table->m_ibd_file_missing && load(table)) {
+    return;
+  }
+
+  if (auto err = update(table); err != DB_SUCCESS) {
+    log_warn(std::format("Storing the statistics of table {} failed with error {}", table->m_name, (int) err));
+  }
+}
+
+db_err Dict_stats::update(Table *table) noexcept {
+  srv_dict_sys->update_statistics(table);
+
+  if (!table->m_stats.m_initialized || !has_persistent_stats(table)) {
+    return DB_SUCCESS;
+  }
+
+  return save(table);
+}
+
+void Dict_stats::row_modified(Table *table) noexcept {
+  auto &stats = table->m_stats;
+  const auto counter = stats.m_modified_counter++;
+
+  /* Recalculate if 1 / RECALC_RATIO of the table has been modified since
+  the last time or if the counter is about to wrap around. The 16 extra
+  rows keep a very small table that is updated very often from being
+  queued all the time. */
+  if (counter <= 2000000000 && int64_t(counter) <= 16 + stats.m_n_rows / RECALC_RATIO) {
+    return;
+  }
+
+  if (stats.m_recalc_queued.exchange(true)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(recalc_mutex);
+
+  recalc_queue.push_back(table->m_id);
+}
+
+ulint Dict_stats::recalc_queued() noexcept {
+  std::vector<Dict_id> table_ids{};
+
+  {
+    std::lock_guard<std::mutex> lock(recalc_mutex);
+
+    table_ids.swap(recalc_queue);
+  }
+
+  for (auto table_id : table_ids) {
+    srv_dict_sys->mutex_acquire();
+
+    /* Only the tables still in the cache, a dropped or evicted table
+    gets its statistics when it's opened the next time. The open handle
+    keeps the table from being dropped under us. */
+    auto table = srv_dict_sys->table_get_on_id(table_id);
+
+    if (table != nullptr) {
+      srv_dict_sys->table_increment_handle_count(table, true);
+    }
+
+    srv_dict_sys->mutex_release();
+
+    if (table == nullptr) {
+      continue;
+    }
+
+    table->m_stats.m_recalc_queued.store(false);
+
+    if (auto err = update(table); err != DB_SUCCESS) {
+      log_warn(std::format("Storing the statistics of table {} failed with error {}", table->m_name, (int) err));
+    }
+
+    srv_dict_sys->table_decrement_handle_count(table, false);
+  }
+
+  return table_ids.size();
+}
+
+db_err Dict_stats::set_sample_pages(Table *table, ulint n_pages) noexcept {
+  table->m_stats.m_sample_pages = n_pages;
+
+  return update(table);
+}
+
+db_err Dict_stats::drop(Dict *dict, Dict_id index_id, Trx *trx) noexcept {
+  ut_ad(mutex_own(&dict->m_mutex));
+
+  if (!dict->m_persistent_stats) {
+    return DB_SUCCESS;
+  }
+
+  auto info = pars_info_create();
+
+  pars_info_add_uint64_literal(info, "index_id", index_id);
+
+  return que_eval_sql(
+    info,
+    "PROCEDURE DROP_INDEX_STATS_PROC () IS\n"
+    "BEGIN\n"
+    "DELETE FROM SYS_INDEX_STATS WHERE INDEX_ID = :index_id;\n"
+    "END;\n",
+    false,
+    trx
+  );
+}
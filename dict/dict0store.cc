@@ -333,16 +333,13 @@ db_err Dict_store::build_table_def_step(que_thr_t *thr, Table_node *node) noexce
     - page 2 is the first inode page,
     - page 3 will contain the root of the clustered index of the table we create here. */
 
-    bool is_path;
     const char *path_or_name;
     space_id_t space_id{NULL_SPACE_ID};
 
     if (table->m_dir_path_of_temp_table != nullptr) {
       /* We place tables created with CREATE TEMPORARY TABLE in the configured tmp dir. */
-      is_path = true;
       path_or_name = table->m_dir_path_of_temp_table;
     } else {
-      is_path = false;
       path_or_name = table->m_name;
     }
 
@@ -350,7 +347,7 @@ db_err Dict_store::build_table_def_step(que_thr_t *thr, Table_node *node) noexce
 
     auto fil = m_fsp->m_fil;
 
-    auto err = fil->create_new_single_table_tablespace(&space_id, path_or_name, is_path, flags, FIL_IBD_FILE_INITIAL_SIZE);
+    auto err = fil->create_new_single_table_tablespace(&space_id, path_or_name, table->is_temporary(), flags, FIL_IBD_FILE_INITIAL_SIZE);
 
     table->m_space_id = space_id;
 
@@ -1077,6 +1074,103 @@ db_err Dict_store::create_or_check_foreign_constraint_tables() noexcept {
   return err;
 }
 
+db_err Dict_store::create_or_check_stats_table(const char *name, const char *sql, const char *what) noexcept {
+  m_dict->mutex_acquire();
+
+  auto sys_table = m_dict->table_get(name);
+
+  if (sys_table != nullptr && sys_table->m_indexes.size() == 1) {
+
+    if (!sys_table->m_cached) {
+      Table::destroy(sys_table, Current_location());
+    }
+
+    m_dict->mutex_release();
+
+    return DB_SUCCESS;
+  }
+
+  m_dict->mutex_release();
+
+  auto trx = srv_trx_sys->create_user_trx(nullptr);
+  auto started = trx->start(ULINT_UNDEFINED);
+  ut_a(started);
+
+  trx->m_op_info = "creating statistics sys table";
+
+  m_dict->lock_data_dictionary(trx);
+
+  if (sys_table != nullptr) {
+    log_warn("Dropping incompletely created ", name, " table");
+    if (auto err = m_dict->m_ddl.drop_table(name, trx, true); err != DB_SUCCESS) {
+      log_warn("DROP table failed with error ", err , " while dropping table ", name);
+    }
+    auto err_commit = trx->commit();
+    ut_a(err_commit == DB_SUCCESS);
+  }
+
+  (void) trx->start_if_not_started();
+
+  log_info("Creating ", what, " system table");
+
+  auto err = que_eval_sql(nullptr, sql, false, trx);
+
+  if (err != DB_SUCCESS) {
+    log_err("Error ", (int)err, " in creation");
+
+    ut_a(err == DB_OUT_OF_FILE_SPACE || err == DB_TOO_MANY_CONCURRENT_TRXS);
+
+    log_err("Creation failed tablespace is full dropping incompletely created ", name, " table");
+
+    (void) m_dict->m_ddl.drop_table(name, trx, true);
+
+    auto err_commit = trx->commit();
+    ut_a(err_commit == DB_SUCCESS);
+
+    err = DB_MUST_GET_MORE_FILE_SPACE;
+  }
+
+  m_dict->unlock_data_dictionary(trx);
+
+  srv_trx_sys->destroy_user_trx(trx);
+
+  if (err == DB_SUCCESS) {
+    log_info(what, " system table created");
+  }
+
+  return err;
+}
+
+db_err Dict_store::create_or_check_histogram_table() noexcept {
+  return create_or_check_stats_table(
+    "SYS_HISTOGRAMS",
+    "PROCEDURE CREATE_HISTOGRAM_SYS_TABLE_PROC () IS\n"
+    "BEGIN\n"
+    "CREATE TABLE SYS_HISTOGRAMS(INDEX_ID BINARY(8), BUCKET INT, N_ROWS BINARY(8), BOUND BLOB);\n"
+    "CREATE UNIQUE CLUSTERED INDEX ID_IND ON SYS_HISTOGRAMS (INDEX_ID, BUCKET);\n"
+    "COMMIT WORK;\n"
+    "END;\n",
+    "Index histogram"
+  );
+}
+
+db_err Dict_store::create_or_check_index_stats_table() noexcept {
+  const auto err = create_or_check_stats_table(
+    "SYS_INDEX_STATS",
+    "PROCEDURE CREATE_INDEX_STATS_SYS_TABLE_PROC () IS\n"
+    "BEGIN\n"
+    "CREATE TABLE SYS_INDEX_STATS(INDEX_ID BINARY(8), SAMPLE_PAGES INT, INDEX_SIZE INT, N_LEAF_PAGES INT, N_DIFF BLOB);\n"
+    "CREATE UNIQUE CLUSTERED INDEX ID_IND ON SYS_INDEX_STATS (INDEX_ID);\n"
+    "COMMIT WORK;\n"
+    "END;\n",
+    "Index statistics"
+  );
+
+  m_dict->m_persistent_stats = err == DB_SUCCESS;
+
+  return err;
+}
+
 db_err Dict_store::foreign_eval_sql(pars_info_t *info, const char *sql, Table *table, Foreign *foreign, Trx *trx) noexcept {
     (void) trx->start_if_not_started();
 
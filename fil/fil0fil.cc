@@ -22,9 +22,16 @@ The tablespace memory cache
 Created 10/25/1995 Heikki Tuuri
 *******************************************************/
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "buf0buf.h"
+#include "buf0dblwr.h"
 #include "buf0flu.h"
 #include "buf0lru.h"
 #include "dict0dict.h"
@@ -38,11 +45,17 @@ Created 10/25/1995 Heikki Tuuri
 #include "os0aio.h"
 #include "os0file.h"
 #include "os0sync.h"
+#include "os0thread-create.h"
 #include "page0page.h"
 #include "srv0srv.h"
+#include "srv0task.h"
 #include "sync0sync.h"
 #include "ut0logger.h"
 
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif /* HAVE_LZ4 */
+
 /*
                 IMPLEMENTATION OF THE TABLESPACE MEMORY CACHE
                 =============================================
@@ -91,13 +104,15 @@ to a hash table. Each tablespace and log file is given an unique 32-bit
 identifier.
 
 Some operating systems do not support many open files at the same time,
-though NT seems to tolerate at least 900 open files. Therefore, we put the
-open files in an LRU-list. If we need to open another file, we may close the
-file at the end of the LRU-list. When an i/o-operation is pending on a file,
-the file cannot be closed. We take the file nodes with pending i/o-operations
-out of the LRU-list and keep a count of pending operations. When an operation
-completes, we decrement the count and return the file node to the LRU-list if
-the count drops to zero. */
+though NT seems to tolerate at least 900 open files. Therefore, every i/o
+stamps its file with the time of the access and a background thread, the
+file closer, closes the least recently used files when too many are open.
+When an i/o-operation is pending on a file, the file cannot be closed, we
+keep a count of pending operations per file.
+
+The space id lookup is sharded, a read of a page of an open single-file
+tablespace takes only the shared latch of its shard and updates the pending
+count atomically, it doesn't take the Fil::sys mutex. */
 
 // FIXME: Remove this global variable
 Fil *srv_fil;
@@ -114,24 +129,43 @@ Fil::Fil(ulint max_n_open) {
 
   m_max_n_open = max_n_open;
 
+  m_closer_event = os_event_create("fil_closer_event");
+
   UT_LIST_INIT(m_space_list);
   UT_LIST_INIT(m_unflushed_spaces);
 }
 
 Fil::~Fil() noexcept {
-  for (auto [id, space] : m_space_by_id) {
-    ut_a(space->m_magic_n == FIL_SPACE_MAGIC_N);
+  ut_a(!m_closer_thread.joinable());
+  ut_a(!m_load_thread.joinable());
 
-    for (auto node : space->m_chain) {
-      ut_a(node->m_magic_n == FIL_NODE_MAGIC_N);
-      mem_free(node->m_file_name);
-      mem_free(node);
+  for (auto &shard : m_space_shards) {
+    for (auto [id, space] : shard.m_spaces) {
+      ut_a(space->m_magic_n == FIL_SPACE_MAGIC_N);
+
+      for (auto node : space->m_chain) {
+        ut_a(node->m_magic_n == FIL_NODE_MAGIC_N);
+        mem_free(node->m_file_name);
+        mem_free(node);
+      }
+
+      rw_lock_free(&space->m_latch);
+
+      call_destructor(space->m_io_latency);
+      ut_delete(space->m_io_latency);
+
+      call_destructor(space->m_io_stats);
+      ut_delete(space->m_io_stats);
+
+      mem_free(space->m_name);
+      mem_free(space);
     }
+  }
 
-    rw_lock_free(&space->m_latch);
+  os_event_free(m_closer_event);
 
-    mem_free(space->m_name);
-    mem_free(space);
+  for (auto ptr : m_comp_buf_ptrs) {
+    ut_delete(ptr);
   }
 
   ut_a(UT_LIST_GET_LEN(m_space_list) == 0);
@@ -165,9 +199,11 @@ int Fil::tablename_compare(const char *name1, const char *name2) {
 fil_space_t *Fil::space_get_by_id(space_id_t id) {
   ut_ad(mutex_own(&m_mutex));
 
-  auto it{m_space_by_id.find(id)};
+  /* The shards are only changed with the mutex held. */
+  const auto &spaces = get_space_shard(id).m_spaces;
+  auto it{spaces.find(id)};
 
-  return it != m_space_by_id.end() ? it->second : nullptr;
+  return it != spaces.end() ? it->second : nullptr;
 }
 
 fil_space_t *Fil::space_get_by_name(const char *name) {
@@ -240,9 +276,16 @@ void Fil::node_create(const char *name, ulint size, space_id_t id, bool is_raw)
   ut_a(!is_raw || srv_start_raw_disk_in_use);
 
   node->m_is_raw_disk = is_raw;
+  node->m_atomic_writes = false;
+  node->m_punch_hole = false;
+  node->m_block_size = IB_FILE_BLOCK_SIZE;
+  node->m_direct_io_align = 0;
+  node->m_fixed_fd = -1;
   node->m_size_in_pages = size;
   node->m_magic_n = FIL_NODE_MAGIC_N;
+  node->m_closing = false;
   node->m_n_pending = 0;
+  node->m_last_access = 0;
   node->m_n_pending_flushes = 0;
 
   node->m_modification_counter = 0;
@@ -280,7 +323,6 @@ void Fil::node_open_file(fil_node_t *node, fil_space_t *space, bool startup) {
   bool success;
 
   ut_ad(mutex_own(&m_mutex));
-  ut_a(node->m_n_pending == 0);
   ut_a(node->open == false);
 
   if (node->m_size_in_pages == 0) {
@@ -382,20 +424,70 @@ void Fil::node_open_file(fil_node_t *node, fil_space_t *space, bool startup) {
 
   node->open = true;
 
+  if (space->m_type != FIL_LOG) {
+    node->m_direct_io_align = os_file_get_direct_io_align(node->m_fh);
+
+    /* All data file i/o is done in whole pages from page aligned buffers. */
+    if (node->m_direct_io_align > 0 && UNIV_PAGE_SIZE % node->m_direct_io_align != 0) {
+      log_fatal(std::format(
+        "O_DIRECT i/o to '{}' must be aligned to {} bytes, the page size {} is not a multiple of it",
+        node->m_file_name, node->m_direct_io_align, UNIV_PAGE_SIZE
+      ));
+    }
+  }
+
+  if (srv_aio != nullptr) {
+    node->m_fixed_fd = srv_aio->register_file(node->m_fh);
+  }
+
+  /* Atomic writes are only possible with direct IO. */
+  if (space->m_type == FIL_TABLESPACE && srv_config.m_doublewrite_mode == DBLWR_MODE_AUTO &&
+      srv_config.m_unix_file_flush_method == SRV_UNIX_O_DIRECT) {
+
+    node->m_atomic_writes = os_file_supports_atomic_writes(node->m_fh, UNIV_PAGE_SIZE);
+
+    space->m_atomic_writes = true;
+
+    for (auto n = UT_LIST_GET_FIRST(space->m_chain); n != nullptr; n = UT_LIST_GET_NEXT(m_chain, n)) {
+      space->m_atomic_writes = space->m_atomic_writes && n->m_atomic_writes;
+    }
+  }
+
+  /* The pages of a single-table tablespace can be compressed, a compressed
+  page is found by its page number in the file. A shorter write is not
+  atomic, the pages of a file with atomic writes bypass the doublewrite
+  buffer and are never compressed. */
+  if (space->m_type == FIL_TABLESPACE && space->m_id != SYS_TABLESPACE && !node->m_atomic_writes) {
+    node->m_block_size = std::max(os_file_get_block_size(node->m_fh), node->m_direct_io_align);
+    node->m_punch_hole = node->m_block_size < UNIV_PAGE_SIZE;
+  }
+
   ++m_n_open;
+
+  if (m_n_open >= m_max_n_open * CLOSER_HIGH_WATER_PCT / 100) {
+    os_event_set(m_closer_event);
+  }
 }
 
 void Fil::node_close_file(fil_node_t *node) {
   ut_ad(mutex_own(&m_mutex));
   ut_a(node->open);
-  ut_a(node->m_n_pending == 0);
+  /* m_n_pending can be non-zero for a moment: prepare_io_fast() increments
+  it before it sees that the file is being closed and backs off, without
+  touching the file. The callers checked that there is no i/o pending. */
   ut_a(node->m_n_pending_flushes == 0);
   ut_a(node->m_modification_counter == node->m_flush_counter);
 
+  if (node->m_fixed_fd != -1) {
+    srv_aio->unregister_file(node->m_fixed_fd);
+    node->m_fixed_fd = -1;
+  }
+
   auto ret = os_file_close(node->m_fh);
   ut_a(ret);
 
   node->open = false;
+  node->m_direct_io_align = 0;
   ut_a(m_n_open > 0);
 
   --m_n_open;
@@ -452,6 +544,12 @@ void Fil::mutex_enter_and_prepare_for_io(space_id_t space_id) {
 
       return;
 
+    } else if (m_closer_shutdown.load(std::memory_order_acquire) && close_lru_files_low(1) > 0) {
+      /* The file closer is not running, e.g., during recovery, we closed
+      a file ourselves */
+
+      return;
+
     } else  if (n_retries >= 2) {
 
       log_warn(std::format(
@@ -465,17 +563,18 @@ void Fil::mutex_enter_and_prepare_for_io(space_id_t space_id) {
       return;
     }
 
-    mutex_exit(&m_mutex);
-
-    os_thread_sleep(20000);
+    const bool stopped = space->m_stop_ios;
 
-    if (!space->m_stop_ios) {
+    mutex_exit(&m_mutex);
 
-      /* Flush tablespaces so that we can close modified files in the LRU list */
-      flush_file_spaces(FIL_TABLESPACE);
+    if (!stopped) {
+      /* Let the file closer flush and close the least recently used files */
+      os_event_set(m_closer_event);
 
       ++n_retries;
     }
+
+    os_thread_sleep(20000);
   }
 }
 
@@ -585,9 +684,14 @@ try_again:
 
   space->m_stop_ios = false;
   space->m_is_being_deleted = false;
+  space->m_is_extending = false;
   space->m_type = fil_type;
   space->m_size_in_pages = 0;
   space->m_flags = flags;
+  space->m_atomic_writes = false;
+  space->m_is_temp = false;
+  space->m_io_latency = new (ut_new(sizeof(ut::Latency_histogram))) ut::Latency_histogram();
+  space->m_io_stats = new (ut_new(sizeof(Fil_space_io_stats))) Fil_space_io_stats();
 
   space->m_n_reserved_extents = 0;
 
@@ -599,7 +703,10 @@ try_again:
   rw_lock_create(&space->m_latch, SYNC_FSP);
 
   {
-    auto r{m_space_by_id.emplace(id, space)};
+    auto &shard = get_space_shard(id);
+    std::unique_lock<std::shared_mutex> latch(shard.m_latch);
+
+    auto r{shard.m_spaces.emplace(id, space)};
     ut_a(r.second);
   }
 
@@ -674,7 +781,12 @@ bool Fil::space_free(space_id_t id, bool own_mutex) {
   }
 
   {
-    auto r{m_space_by_id.erase(id)};
+    /* Waits for the fast path lookups of the space to finish, after this
+    no other thread can find the space without the mutex. */
+    auto &shard = get_space_shard(id);
+    std::unique_lock<std::shared_mutex> latch(shard.m_latch);
+
+    auto r{shard.m_spaces.erase(id)};
     ut_a(r == 1);
   }
 
@@ -697,6 +809,11 @@ bool Fil::space_free(space_id_t id, bool own_mutex) {
 
   UT_LIST_REMOVE(m_space_list, space);
 
+  if (space->m_is_temp) {
+    const auto n_temp_spaces = m_n_temp_spaces.fetch_sub(1, std::memory_order_relaxed);
+    ut_a(n_temp_spaces > 0);
+  }
+
   ut_a(space->m_magic_n == FIL_SPACE_MAGIC_N);
   ut_a(space->m_n_pending_flushes == 0);
 
@@ -717,6 +834,12 @@ bool Fil::space_free(space_id_t id, bool own_mutex) {
 
   rw_lock_free(&(space->m_latch));
 
+  call_destructor(space->m_io_latency);
+  ut_delete(space->m_io_latency);
+
+  call_destructor(space->m_io_stats);
+  ut_delete(space->m_io_stats);
+
   mem_free(space->m_name);
   mem_free(space);
 
@@ -827,6 +950,16 @@ void Fil::close_all_files() {
     ut_a(UT_LIST_GET_LEN(space->m_chain) == 1 || space->m_type == FIL_LOG);
     auto node = UT_LIST_GET_FIRST(space->m_chain);
 
+    for (auto n : space->m_chain) {
+      if (n->open && n->m_modification_counter > n->m_flush_counter) {
+        /* The flush_method can skip the flushes, e.g., of the log after
+        the last checkpoint. */
+        (void) os_file_flush(n->m_fh);
+
+        n->m_flush_counter = n->m_modification_counter;
+      }
+    }
+
     if (node->open) {
       node_close_file(node);
     }
@@ -912,7 +1045,7 @@ db_err Fil::write_flushed_lsn_to_data_files(lsn_t lsn) {
   return DB_SUCCESS;
 }
 
-void Fil::read_flushed_lsn(os_file_t fh, lsn_t &flushed_lsn) {
+void Fil::read_flushed_lsn(os_file_t fh, lsn_t &flushed_lsn, ulint &page_size_shift) {
   auto ptr = static_cast<byte *>(ut_new(2 * UNIV_PAGE_SIZE));
   /* Align the memory for a possible read from a raw device */
   auto buf = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
@@ -921,6 +1054,7 @@ void Fil::read_flushed_lsn(os_file_t fh, lsn_t &flushed_lsn) {
   ut_a(success);
 
   flushed_lsn = mach_read_from_8(buf + FIL_PAGE_FILE_FLUSH_LSN);
+  page_size_shift = FSP::get_page_size_shift(buf);
 
   ut_delete(ptr);
 }
@@ -1122,16 +1256,18 @@ bool Fil::delete_tablespace(space_id_t id) {
 
     mutex_exit(&m_mutex);
 
-    /* Invalidate in the buffer pool all pages belonging to the tablespace.
-    Since we have set space->is_being_deleted = true, readahead can no longer
-    read more pages of this tablespace to the buffer pool. Thus we can clean
-    the tablespace out of the buffer pool completely and permanently. The flag
+    /* Since we have set space->is_being_deleted = true, readahead can no
+    longer read more pages of this tablespace to the buffer pool. The flag
     is_being_deleted also prevents Fil::flush() from being applied to this
-    tablespace. */
+    tablespace. The pages of the tablespace in the buffer pool can't be found
+    once it is freed from the cache, they are freed lazily by the LRU
+    eviction, the flush and the sweep, not by a scan of the buffer pool. */
 
     auto success = space_free(id, false);
 
     if (success) {
+      srv_buf_pool->invalidate_tablespace(id);
+
       mtr_t mtr;
 
       /* Write a log record to replay during recovery. */
@@ -1192,7 +1328,7 @@ bool Fil::delete_tablespace(space_id_t id) {
         " pending i/o's on it, loop count {}.",
         space->m_name,
         space->m_n_pending_flushes,
-        node->m_n_pending,
+        node->m_n_pending.load(),
         count
       ));
     }
@@ -1264,7 +1400,8 @@ char *Fil::make_ibd_name(const char *name, bool is_temp) {
   auto sz = dirlen + namelen + sizeof("/.ibd");
   auto filename = static_cast<char *>(mem_alloc(sz));
 
-  std::snprintf(filename, sz, "%s%s.ibd", normalize_path(srv_config.m_data_home), name);
+  /* The recovery scan only opens the .ibd files, see scan_tablespace_files(). */
+  std::snprintf(filename, sz, "%s%s.%s", normalize_path(srv_config.m_data_home), name, is_temp ? "ibt" : "ibd");
 
   return filename;
 }
@@ -1359,7 +1496,7 @@ retry:
   /* Check that the old name in the space is right */
 
   if (old_name_was_specified) {
-    old_path = make_ibd_name(old_name, false);
+    old_path = make_ibd_name(old_name, space->m_is_temp);
 
     ut_a(tablename_compare(space->m_name, old_path) == 0);
     ut_a(tablename_compare(node->m_file_name, old_path) == 0);
@@ -1368,7 +1505,7 @@ retry:
   }
 
   /* Rename the tablespace and the node in the memory cache */
-  path = make_ibd_name(new_name, false);
+  path = make_ibd_name(new_name, space->m_is_temp);
   success = rename_tablespace_in_mem(space, node, path);
 
   if (success) {
@@ -1494,7 +1631,7 @@ db_err Fil::create_new_single_table_tablespace(space_id_t *space_id, const char
 
   mach_write_to_4(page + FIL_PAGE_SPACE_ID, *space_id);
 
-  srv_buf_pool->m_flusher->init_for_writing(page, 0);
+  Buf_flush::init_for_writing(page, 0);
 
   ret = os_file_write(path, file, page, UNIV_PAGE_SIZE, 0);
 
@@ -1510,7 +1647,8 @@ db_err Fil::create_new_single_table_tablespace(space_id_t *space_id, const char
     return err_exit(path, file);
   }
 
-  ret = os_file_flush(file);
+  /* A temporary table is not recovered, its space id need not be durable. */
+  ret = is_temp || os_file_flush(file);
 
   if (!ret) {
     log_err(std::format("File flush of tablespace {} failed", path));
@@ -1529,6 +1667,15 @@ db_err Fil::create_new_single_table_tablespace(space_id_t *space_id, const char
     return err_exit(path, -1);
   }
 
+  if (is_temp) {
+    mutex_enter(&m_mutex);
+
+    space_get_by_id(*space_id)->m_is_temp = true;
+    m_n_temp_spaces.fetch_add(1, std::memory_order_relaxed);
+
+    mutex_exit(&m_mutex);
+  }
+
   node_create(path, size, *space_id, false);
 
   {
@@ -1815,7 +1962,7 @@ func_exit:
   mem_free(filepath);
 }
 
-db_err Fil::scan_and_load_tablespaces(const std::string &dir, ib_recovery_t recovery, ulint max_depth, ulint depth) {
+db_err Fil::scan_tablespace_files(const std::string &dir, ulint max_depth, ulint depth, Tablespace_files &files) {
   namespace fs = std::filesystem;
 
   if (depth >= max_depth) {
@@ -1862,17 +2009,17 @@ db_err Fil::scan_and_load_tablespaces(const std::string &dir, ib_recovery_t reco
         return DB_ERROR;
       }
 
-      /* Recursively load tablespaces. */
-      auto err = scan_and_load_tablespaces(filename, recovery, max_depth, depth + 1);
+      /* Recursively scan for tablespaces. */
+      auto err = scan_tablespace_files(filename, max_depth, depth + 1, files);
 
       if (err != DB_SUCCESS) {
-        log_err(std::format("Failed to scan and load tablespaces in directory: '{}'", filename));
+        log_err(std::format("Failed to scan for tablespaces in directory: '{}'", filename));
       }
 
     } else if (it->is_regular_file() && it->path().filename().has_extension() &&
                it->path().filename().extension().string() == ext) {
 
-      load_single_table_tablespace(recovery, dir_name.c_str(), filename.c_str());
+      files.emplace_back(dir_name, filename);
     }
   }
 
@@ -1880,7 +2027,64 @@ db_err Fil::scan_and_load_tablespaces(const std::string &dir, ib_recovery_t reco
 }
 
 db_err Fil::load_single_table_tablespaces(const std::string &dir, ib_recovery_t recovery, ulint max_depth) {
-  return scan_and_load_tablespaces(dir, recovery, max_depth, 0);
+  const auto start{std::chrono::steady_clock::now()};
+
+  Tablespace_files files{};
+
+  if (auto err = scan_tablespace_files(dir, max_depth, 0, files); err != DB_SUCCESS) {
+    return err;
+  }
+
+  const auto n_threads{std::max(ulint{1}, std::min(srv_config.m_n_tablespace_load_threads, ulint(files.size())))};
+
+  /* Opening a file and reading its first page is mostly waiting for the
+  disk, the threads take the next file until all have been loaded. The
+  tablespace memory cache is protected by m_mutex. */
+  std::atomic<ulint> next{};
+
+  auto load = [&]() {
+    for (auto i{next.fetch_add(1)}; i < files.size(); i = next.fetch_add(1)) {
+      const auto &[dbname, filename] = files[i];
+
+      load_single_table_tablespace(recovery, dbname.c_str(), filename.c_str());
+    }
+  };
+
+  Task_group tasks(Task_class::Tablespace_load);
+
+  for (ulint i{1}; i < n_threads; ++i) {
+    tasks.run(load);
+  }
+
+  load();
+
+  tasks.wait();
+
+  const auto elapsed{std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)};
+
+  log_info(std::format("Loaded {} single-table tablespaces with {} threads in {} ms", files.size(), n_threads, elapsed.count()));
+
+  srv_startup_stats.add_time(STARTUP_STEP_TABLESPACES, start);
+
+  return DB_SUCCESS;
+}
+
+void Fil::start_loading_tablespaces(const std::string &dir, ib_recovery_t recovery, size_t max_depth) noexcept {
+  ut_a(!m_load_thread.joinable());
+
+  m_load_thread = create_joinable_thread([this, dir, recovery, max_depth]() {
+    (void) load_single_table_tablespaces(dir, recovery, max_depth);
+  });
+}
+
+bool Fil::wait_for_tablespaces() noexcept {
+  if (!m_load_thread.joinable()) {
+    return false;
+  }
+
+  m_load_thread.join();
+
+  return true;
 }
 
 void Fil::print_orphaned_tablespaces() {
@@ -1900,6 +2104,82 @@ void Fil::print_orphaned_tablespaces() {
   mutex_exit(&m_mutex);
 }
 
+std::string Fil::io_latency_to_string(ulint max_spaces) {
+  std::vector<std::pair<ut::Latency_percentiles, std::string>> spaces;
+
+  mutex_enter(&m_mutex);
+
+  for (auto space : m_space_list) {
+    const auto percentiles = space->m_io_latency->get_percentiles();
+
+    if (percentiles.m_count > 0) {
+      spaces.emplace_back(percentiles, space->m_name);
+    }
+  }
+
+  mutex_exit(&m_mutex);
+
+  std::sort(spaces.begin(), spaces.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs.first.m_p99 > rhs.first.m_p99;
+  });
+
+  std::string str;
+
+  for (ulint i{}; i < spaces.size() && i < max_spaces; ++i) {
+    str += std::format("{}: {}\n", spaces[i].second, spaces[i].first.to_string());
+  }
+
+  return str;
+}
+
+std::vector<Fil_space_io_snapshot> Fil::get_io_stats() {
+  std::vector<Fil_space_io_snapshot> snapshots;
+
+  auto copy = [](const Fil_space_io_stats::Counters_by_class &from, std::array<Fil_space_io_snapshot::Counts, FIL_IO_PAGE_CLASS_COUNT> &to) {
+    for (ulint i{}; i < FIL_IO_PAGE_CLASS_COUNT; ++i) {
+      to[i].m_n_ios = from[i].m_n_ios.load(std::memory_order_relaxed);
+      to[i].m_n_bytes = from[i].m_n_bytes.load(std::memory_order_relaxed);
+      to[i].m_latency_us = from[i].m_latency_us.load(std::memory_order_relaxed);
+    }
+  };
+
+  mutex_enter(&m_mutex);
+
+  snapshots.reserve(UT_LIST_GET_LEN(m_space_list));
+
+  for (auto space : m_space_list) {
+    auto &snapshot = snapshots.emplace_back();
+
+    snapshot.m_space_id = space->m_id;
+    snapshot.m_name = space->m_name;
+
+    copy(space->m_io_stats->m_reads, snapshot.m_reads);
+    copy(space->m_io_stats->m_writes, snapshot.m_writes);
+
+    for (auto node : space->m_chain) {
+      snapshot.m_n_pending += node->m_n_pending.load(std::memory_order_relaxed);
+    }
+  }
+
+  mutex_exit(&m_mutex);
+
+  return snapshots;
+}
+
+void Fil::space_increment_version(space_id_t id) {
+  mutex_enter(&m_mutex);
+
+  auto space = space_get_by_id(id);
+
+  if (space != nullptr) {
+    ++m_tablespace_version;
+
+    space->m_tablespace_version = m_tablespace_version;
+  }
+
+  mutex_exit(&m_mutex);
+}
+
 bool Fil::tablespace_deleted_or_being_deleted_in_mem(space_id_t id, int64_t version) {
   mutex_enter(&m_mutex);
 
@@ -1922,6 +2202,32 @@ bool Fil::tablespace_deleted_or_being_deleted_in_mem(space_id_t id, int64_t vers
   return false;
 }
 
+bool Fil::space_has_atomic_writes(space_id_t id) {
+  mutex_enter(&m_mutex);
+
+  auto space = space_get_by_id(id);
+  auto atomic_writes = space != nullptr && space->m_atomic_writes;
+
+  mutex_exit(&m_mutex);
+
+  return atomic_writes;
+}
+
+bool Fil::space_is_temp(space_id_t id) {
+  if (m_n_temp_spaces.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+
+  mutex_enter(&m_mutex);
+
+  auto space = space_get_by_id(id);
+  auto is_temp = space != nullptr && space->m_is_temp;
+
+  mutex_exit(&m_mutex);
+
+  return is_temp;
+}
+
 bool Fil::tablespace_exists_in_mem(space_id_t id) {
   mutex_enter(&m_mutex);
 
@@ -2065,12 +2371,113 @@ ulint Fil::get_space_id_for_table(const char *name) {
 }
 
 bool Fil::extend_space_to_desired_size(page_no_t *actual_size, space_id_t space_id, page_no_t size_after_extend) {
+  auto space = space_begin_extend(space_id);
+  ut_a(space != nullptr);
+
+  return space_extend_low(actual_size, space, size_after_extend);
+}
+
+page_no_t Fil::space_preallocate(space_id_t space_id, page_no_t size_after_extend) {
+  auto space = space_begin_extend(space_id);
+
+  if (space == nullptr) {
+    return 0;
+  }
+
+  const auto old_size = space->m_size_in_pages;
+
+  page_no_t actual_size;
+  (void) space_extend_low(&actual_size, space, size_after_extend);
+
+  return actual_size > old_size ? actual_size - old_size : 0;
+}
+
+bool Fil::space_punch_hole(space_id_t space_id, page_no_t page_no, page_no_t n_pages, const std::function<bool()> &can_punch) {
   mutex_enter_and_prepare_for_io(space_id);
 
   auto space = space_get_by_id(space_id);
 
+  if (space == nullptr || space->m_is_being_deleted || space->m_stop_ios) {
+    mutex_exit(&m_mutex);
+
+    return false;
+  }
+
+  auto node = UT_LIST_GET_FIRST(space->m_chain);
+
+  /* Only the files of the system tablespace have their size before they are
+  opened, a single-table tablespace has one file. */
+  while (node != nullptr && UT_LIST_GET_LEN(space->m_chain) > 1 && node->m_size_in_pages <= page_no) {
+    page_no -= node->m_size_in_pages;
+    node = UT_LIST_GET_NEXT(m_chain, node);
+  }
+
+  if (node == nullptr) {
+    mutex_exit(&m_mutex);
+
+    return false;
+  }
+
+  /* Opens the file if it is closed, the pending i/o keeps it open. */
+  node_prepare_for_io(node, space);
+
+  if (node->m_size_in_pages <= page_no) {
+    node_complete_io(node, IO_request::Sync_read);
+    mutex_exit(&m_mutex);
+
+    return false;
+  }
+
+  n_pages = std::min(n_pages, page_no_t(node->m_size_in_pages - page_no));
+
+  mutex_exit(&m_mutex);
+
+  bool punched{};
+
+  if (can_punch()) {
+    const auto off = off_t(page_no) * off_t(UNIV_PAGE_SIZE);
+
+    punched = os_file_punch_hole(node->m_fh, off, off_t(n_pages) * off_t(UNIV_PAGE_SIZE));
+  }
+
+  complete_io(node, IO_request::Sync_read);
+
+  return punched;
+}
+
+fil_space_t *Fil::space_begin_extend(space_id_t space_id) {
+  for (;;) {
+    mutex_enter_and_prepare_for_io(space_id);
+
+    auto space = space_get_by_id(space_id);
+
+    if (space == nullptr || space->m_is_being_deleted) {
+      mutex_exit(&m_mutex);
+
+      return nullptr;
+    }
+
+    if (!space->m_is_extending) {
+      space->m_is_extending = true;
+
+      return space;
+    }
+
+    mutex_exit(&m_mutex);
+
+    os_thread_sleep(1000);
+  }
+}
+
+bool Fil::space_extend_low(page_no_t *actual_size, fil_space_t *space, page_no_t size_after_extend) {
+  ut_ad(mutex_own(&m_mutex));
+  ut_a(space->m_is_extending);
+
+  const auto space_id = space->m_id;
+
   if (space->m_size_in_pages >= size_after_extend) {
     *actual_size = space->m_size_in_pages;
+    space->m_is_extending = false;
 
     mutex_exit(&m_mutex);
 
@@ -2083,52 +2490,73 @@ bool Fil::extend_space_to_desired_size(page_no_t *actual_size, space_id_t space_
 
   node_prepare_for_io(node, space);
 
-  auto start_page_no = space->m_size_in_pages;
-  /* Extend at most 64 pages at a time */
-  auto buf_size = ut_min(64, size_after_extend - start_page_no) * page_size;
-  auto buf2 = static_cast<byte *>(mem_alloc(buf_size + page_size));
-  auto buf = static_cast<byte *>(ut_align(buf2, page_size));
+  const auto start_page_no = space->m_size_in_pages;
 
-  memset(buf, 0, buf_size);
+  /* The file can't be closed while there is i/o pending on it and no other
+  thread extends the space, the i/o is done without the mutex so that it
+  doesn't stall the i/o to the other spaces. */
+  mutex_exit(&m_mutex);
 
   bool success{true};
-  auto io_request = IO_request::Sync_write;
+  page_no_t n_pages_added{};
+  const auto io_request = IO_request::Sync_write;
 
-  while (start_page_no < size_after_extend) {
-    const ulint n_pages = ut_min(buf_size / page_size, size_after_extend - start_page_no);
-    const off_t off = off_t(start_page_no) * page_size;
+  if (os_file_allocate(node->m_fh, off_t(start_page_no) * page_size, off_t(size_after_extend - start_page_no) * page_size)) {
+    n_pages_added = size_after_extend - start_page_no;
+  } else {
+    /* The file system doesn't support fallocate() or the disk is full,
+    write zeroed pages, the write will tell which. Extend at most 64 pages
+    at a time */
+    auto buf_size = ut_min(64, size_after_extend - start_page_no) * page_size;
+    auto buf2 = static_cast<byte *>(mem_alloc(buf_size + page_size));
+    auto buf = static_cast<byte *>(ut_align(buf2, page_size));
 
-    IO_ctx io_ctx = {.m_batch = false, .m_fil_node = node, .m_msg = nullptr, .m_io_request = io_request};
+    memset(buf, 0, buf_size);
 
-    success = srv_aio->submit(std::move(io_ctx), buf, page_size * n_pages, off);
+    for (auto page_no = start_page_no; page_no < size_after_extend;) {
+      const ulint n_pages = ut_min(buf_size / page_size, size_after_extend - page_no);
+      const off_t off = off_t(page_no) * page_size;
 
-    if (success) {
-      node->m_size_in_pages += n_pages;
-      space->m_size_in_pages += n_pages;
+      IO_ctx io_ctx = {
+        .m_batch = false,
+        .m_fil_node = node,
+        .m_msg = nullptr,
+        .m_io_request = io_request,
+        .m_io_class = get_io_class(io_request, false)
+      };
 
-      os_has_said_disk_full = false;
-    } else {
-      /* Let us measure the size of the file to determine how much we were able
-       * to extend it */
+      success = srv_aio->submit(std::move(io_ctx), buf, page_size * n_pages, off) == DB_SUCCESS;
 
-      auto n_pages = ((ulint)(os_file_get_size_as_iblonglong(node->m_fh) / page_size)) - node->m_size_in_pages;
+      if (!success) {
+        /* Let us measure the size of the file to determine how much we were able
+         * to extend it */
 
-      node->m_size_in_pages += n_pages;
-      space->m_size_in_pages += n_pages;
+        n_pages_added = ((ulint)(os_file_get_size_as_iblonglong(node->m_fh) / page_size)) - node->m_size_in_pages;
 
-      break;
+        break;
+      }
+
+      n_pages_added += n_pages;
+      page_no += n_pages;
     }
 
-    start_page_no += n_pages;
+    mem_free(buf2);
+  }
+
+  mutex_enter(&m_mutex);
+
+  if (success) {
+    os_has_said_disk_full = false;
   }
 
-  mem_free(buf2);
+  node->m_size_in_pages += n_pages_added;
+  space->m_size_in_pages += n_pages_added;
+  space->m_is_extending = false;
 
   node_complete_io(node, io_request);
 
   *actual_size = space->m_size_in_pages;
 
-
   mutex_exit(&m_mutex);
 
   flush(space_id);
@@ -2188,12 +2616,21 @@ void Fil::node_prepare_for_io(fil_node_t *node, fil_space_t *space) {
 
   if (node->open == false) {
     /* File is closed: open it */
-    ut_a(node->m_n_pending == 0);
-
     node_open_file(node, space, false);
   }
 
   node->m_n_pending++;
+  node->m_last_access.store(ut_time_ms(), std::memory_order_relaxed);
+}
+
+/**
+ * @param io_request Type of an i/o.
+ * @return true if the file must be flushed by Fil::flush() after the i/o. A
+ *  durable log write was synced with its write.
+ */
+static bool fil_io_needs_flush(IO_request io_request) noexcept {
+  return io_request == IO_request::Sync_write || io_request == IO_request::Async_write ||
+         io_request == IO_request::Sync_log_write || io_request == IO_request::Async_log_write;
 }
 
 void Fil::node_complete_io(fil_node_t *node, IO_request io_request) {
@@ -2203,7 +2640,7 @@ void Fil::node_complete_io(fil_node_t *node, IO_request io_request) {
 
   --node->m_n_pending;
 
-  if (io_request == IO_request::Sync_write) {
+  if (fil_io_needs_flush(io_request) && !node->m_space->m_is_temp) {
     ++m_modification_counter;
     node->m_modification_counter = m_modification_counter;
 
@@ -2215,72 +2652,174 @@ void Fil::node_complete_io(fil_node_t *node, IO_request io_request) {
   }
 }
 
-[[noreturn]] void Fil::report_invalid_page_access(
-  ulint block_offset,
-  space_id_t space_id,
-  const char *space_name,
-  ulint byte_offset,
-  ulint len,
-  IO_request io_request
-) {
-  log_fatal(std::format(
-    "Trying to access page number {} in space {}, space name {}, which is"
-    " outside the tablespace bounds. Byte offset {}, len {}, i/o type {}."
-    " If you get this error at server startup, please check that your config"
-    " file matches the ibdata files that you have in the server.",
-    block_offset,
-    space_id,
-    space_name,
-    byte_offset,
-    len,
-    (int)io_request
-  ));
-  ut_error;
+void Fil::complete_io(fil_node_t *node, IO_request io_request) {
+  if (fil_io_needs_flush(io_request)) {
+    mutex_enter(&m_mutex);
+
+    node_complete_io(node, io_request);
+
+    mutex_exit(&m_mutex);
+  } else {
+    const auto n_pending = node->m_n_pending.fetch_sub(1);
+    ut_a(n_pending > 0);
+  }
 }
 
-db_err Fil::io(
-  IO_request io_request, bool batched, space_id_t space_id, page_no_t page_no, ulint byte_offset, ulint len, void *buf,
-  void *message
-) {
-  ut_ad(len > 0);
-  ut_ad(buf != nullptr);
-  ut_ad(byte_offset < UNIV_PAGE_SIZE);
+fil_node_t *Fil::prepare_io_fast(space_id_t space_id, page_no_t page_no) {
+  auto &shard = get_space_shard(space_id);
+  std::shared_lock<std::shared_mutex> latch(shard.m_latch);
 
-  static_assert((1 << UNIV_PAGE_SIZE_SHIFT) == UNIV_PAGE_SIZE, "error (1 << UNIV_PAGE_SIZE_SHIFT) != UNIV_PAGE_SIZE");
+  auto it = shard.m_spaces.find(space_id);
 
-  ut_ad(validate());
+  if (it == shard.m_spaces.end()) {
+    return nullptr;
+  }
 
-  bool is_sync_request{};
+  auto space = it->second;
+  auto node = UT_LIST_GET_FIRST(space->m_chain);
 
-  switch (io_request) {
-    case IO_request::None:
-      ut_error;
-      break;
-    case IO_request::Sync_log_read:
-      is_sync_request = true;
-      // fallthrough
-    case IO_request::Async_log_read:
-      break;
+  if (node == nullptr || UT_LIST_GET_LEN(space->m_chain) != 1) {
+    return nullptr;
+  }
 
-    case IO_request::Sync_log_write:
-      is_sync_request = true;
-      // falthrough
-    case IO_request::Async_log_write:
-      break;
+  /* Announce the i/o before checking that the file can be used: the threads
+  that close or rename the file or delete the space set their flag before
+  they check that there is no pending i/o, so one of us sees the other. The
+  size only grows while the file is open, a stale size sends the request to
+  the slow path. */
+  node->m_n_pending.fetch_add(1);
 
-    case IO_request::Sync_read:
-      is_sync_request = true;
-      // falthrough
-    case IO_request::Async_read:
-      srv_data_read += len;
-      break;
+  if (node->open && !node->m_closing && !space->m_stop_ios && !space->m_is_being_deleted &&
+      page_no < node->m_size_in_pages) {
 
-    case IO_request::Sync_write:
-      is_sync_request = true;
-      // falthrough
-    case IO_request::Async_write:
-      srv_data_written += len;
-      break;
+    node->m_last_access.store(ut_time_ms(), std::memory_order_relaxed);
+
+    return node;
+  }
+
+  node->m_n_pending.fetch_sub(1);
+
+  return nullptr;
+}
+
+ulint Fil::close_lru_files_low(ulint n_to_close) {
+  ut_ad(mutex_own(&m_mutex));
+
+  std::vector<fil_node_t *> nodes;
+
+  for (auto space : m_space_list) {
+    if (space->m_type != FIL_TABLESPACE || space->m_id == SYS_TABLESPACE || space->m_stop_ios ||
+        space->m_is_being_deleted || space->m_is_extending) {
+      continue;
+    }
+
+    for (auto node : space->m_chain) {
+      if (node->open && node->m_n_pending == 0 && node->m_n_pending_flushes == 0 &&
+          node->m_modification_counter == node->m_flush_counter) {
+        nodes.push_back(node);
+      }
+    }
+  }
+
+  n_to_close = std::min(n_to_close, nodes.size());
+
+  std::partial_sort(nodes.begin(), nodes.begin() + n_to_close, nodes.end(), [](const fil_node_t *lhs, const fil_node_t *rhs) {
+    return lhs->m_last_access.load(std::memory_order_relaxed) < rhs->m_last_access.load(std::memory_order_relaxed);
+  });
+
+  ulint n_closed{};
+
+  for (ulint i{}; i < n_to_close; ++i) {
+    auto node = nodes[i];
+
+    /* See prepare_io_fast(), a read that started meanwhile keeps the file open. */
+    node->m_closing = true;
+
+    if (node->m_n_pending == 0) {
+      node_close_file(node);
+      ++n_closed;
+    }
+
+    node->m_closing = false;
+  }
+
+  return n_closed;
+}
+
+void Fil::start_file_closer() {
+  ut_a(!m_closer_thread.joinable());
+
+  m_closer_shutdown.store(false, std::memory_order_release);
+
+  m_closer_thread = create_joinable_thread(&Fil::file_closer, this);
+}
+
+void Fil::shutdown_file_closer() {
+  if (m_closer_thread.joinable()) {
+    m_closer_shutdown.store(true, std::memory_order_release);
+
+    os_event_set(m_closer_event);
+
+    m_closer_thread.join();
+  }
+}
+
+void Fil::file_closer() {
+  while (!m_closer_shutdown.load(std::memory_order_acquire)) {
+    const auto sig_count = os_event_reset(m_closer_event);
+
+    ulint n_closed{};
+    ulint n_to_close{};
+
+    mutex_enter(&m_mutex);
+
+    if (m_n_open >= m_max_n_open * CLOSER_HIGH_WATER_PCT / 100) {
+      n_to_close = m_n_open - m_max_n_open * CLOSER_LOW_WATER_PCT / 100;
+      n_closed = close_lru_files_low(n_to_close);
+    }
+
+    mutex_exit(&m_mutex);
+
+    std::chrono::microseconds timeout = std::chrono::seconds(1);
+
+    if (n_closed < n_to_close) {
+      /* The other files have unflushed writes or pending i/o, flush them
+      so that they can be closed in the next round. */
+      flush_file_spaces(FIL_TABLESPACE);
+
+      timeout = std::chrono::milliseconds(10);
+    }
+
+    (void) m_closer_event->wait_time(timeout, sig_count);
+  }
+}
+
+[[noreturn]] void Fil::report_invalid_page_access(
+  ulint block_offset,
+  space_id_t space_id,
+  const char *space_name,
+  ulint byte_offset,
+  ulint len,
+  IO_request io_request
+) {
+  log_fatal(std::format(
+    "Trying to access page number {} in space {}, space name {}, which is"
+    " outside the tablespace bounds. Byte offset {}, len {}, i/o type {}."
+    " If you get this error at server startup, please check that your config"
+    " file matches the ibdata files that you have in the server.",
+    block_offset,
+    space_id,
+    space_name,
+    byte_offset,
+    len,
+    (int)io_request
+  ));
+  ut_error;
+}
+
+fil_node_t *Fil::prepare_io(IO_request io_request, space_id_t space_id, page_no_t &page_no, ulint byte_offset, ulint len) {
+  if (auto node = prepare_io_fast(space_id, page_no); node != nullptr) {
+    return node;
   }
 
   /* Reserve the Fil::system mutex and make sure that we can open at
@@ -2302,7 +2841,7 @@ db_err Fil::io(
       len
     ));
 
-    return DB_TABLESPACE_DELETED;
+    return nullptr;
   }
 
   auto fil_node = UT_LIST_GET_FIRST(space->m_chain);
@@ -2340,6 +2879,77 @@ db_err Fil::io(
   /* Now we have made the changes in the data structures of Fil::system */
   mutex_exit(&m_mutex);
 
+  return fil_node;
+}
+
+IO_class Fil::get_io_class(IO_request io_request, bool batched) noexcept {
+  IO_ctx io_ctx{.m_io_request = io_request};
+
+  if (io_ctx.is_log_request()) {
+    return IO_class::Log;
+  } else if (recv_recovery_on) {
+    return IO_class::Recovery;
+  } else if (!io_ctx.is_read_request()) {
+    return IO_class::Flush;
+  } else if (batched) {
+    return IO_class::Read_ahead;
+  } else {
+    return IO_class::Foreground_read;
+  }
+}
+
+db_err Fil::io(
+  IO_request io_request, bool batched, space_id_t space_id, page_no_t page_no, ulint byte_offset, ulint len, void *buf,
+  void *message
+) {
+  ut_ad(len > 0);
+  ut_ad(buf != nullptr);
+  ut_ad(byte_offset < UNIV_PAGE_SIZE);
+
+  static_assert((1 << UNIV_PAGE_SIZE_SHIFT) == UNIV_PAGE_SIZE, "error (1 << UNIV_PAGE_SIZE_SHIFT) != UNIV_PAGE_SIZE");
+
+  ut_ad(validate());
+
+  bool is_sync_request{};
+
+  switch (io_request) {
+    case IO_request::None:
+      ut_error;
+      break;
+    case IO_request::Sync_log_read:
+      is_sync_request = true;
+      // fallthrough
+    case IO_request::Async_log_read:
+      break;
+
+    case IO_request::Sync_log_write:
+    case IO_request::Sync_log_write_durable:
+      is_sync_request = true;
+      // falthrough
+    case IO_request::Async_log_write:
+      break;
+
+    case IO_request::Sync_read:
+      is_sync_request = true;
+      // falthrough
+    case IO_request::Async_read:
+      srv_data_read.inc(len);
+      break;
+
+    case IO_request::Sync_write:
+      is_sync_request = true;
+      // falthrough
+    case IO_request::Async_write:
+      srv_data_written.inc(len);
+      break;
+  }
+
+  auto fil_node = prepare_io(io_request, space_id, page_no, byte_offset, len);
+
+  if (fil_node == nullptr) {
+    return DB_TABLESPACE_DELETED;
+  }
+
   /* Calculate the low 32 bits and the high 32 bits of the file offset */
 
   off_t off = (off_t(page_no) * off_t(UNIV_PAGE_SIZE)) + byte_offset;
@@ -2351,7 +2961,28 @@ db_err Fil::io(
   ut_a(byte_offset % IB_FILE_BLOCK_SIZE == 0);
   ut_a((len % IB_FILE_BLOCK_SIZE) == 0);
 
-  IO_ctx io_ctx = {.m_batch = batched, .m_fil_node = fil_node, .m_msg = message, .m_io_request = io_request};
+  byte *comp_buf{};
+
+  /* Page 0 is read directly from the file when the tablespace is opened,
+  it is never compressed. */
+  if ((io_request == IO_request::Async_write || io_request == IO_request::Sync_write) && srv_config.m_page_compression &&
+      page_no > 0 && byte_offset == 0 && len == UNIV_PAGE_SIZE && fil_node->m_punch_hole.load(std::memory_order_relaxed)) {
+
+    comp_buf = compress_page(fil_node, static_cast<const byte *>(buf), len);
+
+    if (comp_buf != nullptr) {
+      buf = comp_buf;
+    }
+  }
+
+  IO_ctx io_ctx = {
+    .m_batch = batched,
+    .m_fil_node = fil_node,
+    .m_msg = message,
+    .m_io_request = io_request,
+    .m_io_class = get_io_class(io_request, batched),
+    .m_comp_buf = comp_buf
+  };
 
   /* Queue the aio request */
   auto err = srv_aio->submit(std::move(io_ctx), buf, len, off);
@@ -2360,11 +2991,11 @@ db_err Fil::io(
   if (is_sync_request) {
     /* The i/o operation is already completed when we return from os_aio: */
 
-    mutex_enter(&m_mutex);
-
-    node_complete_io(fil_node, io_request);
+    if (comp_buf != nullptr) {
+      complete_compressed_write(fil_node, comp_buf);
+    }
 
-    mutex_exit(&m_mutex);
+    complete_io(fil_node, io_request);
 
     ut_ad(validate());
   }
@@ -2372,6 +3003,167 @@ db_err Fil::io(
   return DB_SUCCESS;
 }
 
+db_err Fil::io_vectored(space_id_t space_id, page_no_t page_no, const iovec *iov, ulint n_iov, void *message) {
+  ut_ad(n_iov > 0);
+  ut_ad(validate());
+
+  ulint len{};
+
+  for (ulint i{}; i < n_iov; ++i) {
+    len += iov[i].iov_len;
+  }
+
+  srv_data_written.inc(len);
+
+  auto fil_node = prepare_io(IO_request::Async_write, space_id, page_no, 0, len);
+
+  if (fil_node == nullptr) {
+    return DB_TABLESPACE_DELETED;
+  }
+
+  /* The whole write must be in the same file. */
+  ut_a(fil_node->m_size_in_pages - page_no >= (len + UNIV_PAGE_SIZE - 1) / UNIV_PAGE_SIZE);
+
+  IO_ctx io_ctx = {
+    .m_batch = false,
+    .m_fil_node = fil_node,
+    .m_msg = message,
+    .m_io_request = IO_request::Async_write,
+    .m_io_class = get_io_class(IO_request::Async_write, false)
+  };
+
+  auto err = srv_aio->submit_vectored(std::move(io_ctx), iov, n_iov, off_t(page_no) * off_t(UNIV_PAGE_SIZE));
+  ut_a(err == DB_SUCCESS);
+
+  return DB_SUCCESS;
+}
+
+byte *Fil::comp_buf_acquire() noexcept {
+  std::lock_guard<std::mutex> lock(m_comp_bufs_mutex);
+
+  if (m_comp_bufs.empty()) {
+    /* The buffers are page aligned for O_DIRECT. */
+    auto ptr = ut_new((COMP_BUFS_PER_CHUNK + 1) * UNIV_PAGE_SIZE);
+    auto buf = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
+
+    m_comp_buf_ptrs.push_back(ptr);
+
+    for (ulint i{}; i < COMP_BUFS_PER_CHUNK; ++i) {
+      m_comp_bufs.push_back(buf + i * UNIV_PAGE_SIZE);
+    }
+  }
+
+  auto buf = m_comp_bufs.back();
+
+  m_comp_bufs.pop_back();
+
+  return buf;
+}
+
+void Fil::comp_buf_release(byte *buf) noexcept {
+  std::lock_guard<std::mutex> lock(m_comp_bufs_mutex);
+
+  m_comp_bufs.push_back(buf);
+}
+
+ulint Fil::compressed_write_len(const fil_node_t *node, ulint comp_len) noexcept {
+  return ut_calc_align(FIL_PAGE_COMP_DATA + comp_len, node->m_block_size);
+}
+
+byte *Fil::compress_page(const fil_node_t *node, const byte *page, ulint &len) noexcept {
+#ifdef HAVE_LZ4
+  auto comp_buf = comp_buf_acquire();
+
+  const auto n = LZ4_compress_default(
+    reinterpret_cast<const char *>(page + FIL_PAGE_DATA),
+    reinterpret_cast<char *>(comp_buf + FIL_PAGE_COMP_DATA),
+    int(UNIV_PAGE_SIZE - FIL_PAGE_DATA),
+    int(UNIV_PAGE_SIZE - FIL_PAGE_COMP_DATA)
+  );
+
+  /* Nothing is saved unless at least one block of the file is punched. */
+  if (n <= 0 || compressed_write_len(node, ulint(n)) >= UNIV_PAGE_SIZE) {
+    comp_buf_release(comp_buf);
+    return nullptr;
+  }
+
+  len = compressed_write_len(node, ulint(n));
+
+  memcpy(comp_buf, page, FIL_PAGE_DATA);
+
+  mach_write_to_2(comp_buf + FIL_PAGE_TYPE, FIL_PAGE_TYPE_COMPRESSED);
+  mach_write_to_2(comp_buf + FIL_PAGE_COMP_ORIG_TYPE, mach_read_from_2(page + FIL_PAGE_TYPE));
+  mach_write_to_2(comp_buf + FIL_PAGE_COMP_LEN, ulint(n));
+
+  memset(comp_buf + FIL_PAGE_COMP_DATA + n, 0, len - (FIL_PAGE_COMP_DATA + n));
+
+  srv_data_compressed_saved.inc(UNIV_PAGE_SIZE - len);
+
+  return comp_buf;
+#else
+  (void) node;
+  (void) page;
+  (void) len;
+
+  return nullptr;
+#endif /* HAVE_LZ4 */
+}
+
+void Fil::complete_compressed_write(fil_node_t *node, byte *comp_buf) noexcept {
+  const auto page_no = mach_read_from_4(comp_buf + FIL_PAGE_OFFSET);
+  const auto len = compressed_write_len(node, mach_read_from_2(comp_buf + FIL_PAGE_COMP_LEN));
+  const auto off = off_t(page_no) * off_t(UNIV_PAGE_SIZE) + off_t(len);
+
+  /* The tail of the page may still hold an older version of it, it is
+  not read by decompress_page() and punching it only frees the space. */
+  if (!os_file_punch_hole(node->m_fh, off, off_t(UNIV_PAGE_SIZE - len)) && node->m_punch_hole.exchange(false)) {
+    log_warn(std::format(
+      "The file system of '{}' does not support punching holes, the pages written to it are no longer compressed",
+      node->m_file_name
+    ));
+  }
+
+  comp_buf_release(comp_buf);
+}
+
+void Fil::decompress_page(byte *page) noexcept {
+  if (mach_read_from_2(page + FIL_PAGE_TYPE) != FIL_PAGE_TYPE_COMPRESSED) {
+    return;
+  }
+
+#ifdef HAVE_LZ4
+  thread_local std::vector<byte> data;
+
+  const auto comp_len = mach_read_from_2(page + FIL_PAGE_COMP_LEN);
+  const auto data_len = UNIV_PAGE_SIZE - FIL_PAGE_DATA;
+
+  data.resize(data_len);
+
+  if (comp_len <= UNIV_PAGE_SIZE - FIL_PAGE_COMP_DATA &&
+      LZ4_decompress_safe(
+        reinterpret_cast<const char *>(page + FIL_PAGE_COMP_DATA), reinterpret_cast<char *>(data.data()), int(comp_len), int(data_len)
+      ) == int(data_len)) {
+
+    const auto type = mach_read_from_2(page + FIL_PAGE_COMP_ORIG_TYPE);
+
+    memcpy(page + FIL_PAGE_DATA, data.data(), data_len);
+    mach_write_to_2(page + FIL_PAGE_TYPE, type);
+
+    return;
+  }
+
+  log_err(std::format(
+    "Cannot decompress page {} of space {}, the compressed data is corrupt",
+    mach_read_from_4(page + FIL_PAGE_OFFSET), mach_read_from_4(page + FIL_PAGE_SPACE_ID)
+  ));
+#else
+  log_err(std::format(
+    "Page {} of space {} is compressed but LZ4 support was not compiled in",
+    mach_read_from_4(page + FIL_PAGE_OFFSET), mach_read_from_4(page + FIL_PAGE_SPACE_ID)
+  ));
+#endif /* HAVE_LZ4 */
+}
+
 bool Fil::aio_wait(ulint segment) {
   ut_ad(validate());
 
@@ -2386,11 +3178,11 @@ bool Fil::aio_wait(ulint segment) {
   ut_a(io_ctx.m_ret > 0);
   ut_a(err == DB_SUCCESS);
 
-  mutex_enter(&m_mutex);
-
-  node_complete_io(io_ctx.m_fil_node, io_ctx.m_io_request);
+  if (io_ctx.m_comp_buf != nullptr) {
+    complete_compressed_write(io_ctx.m_fil_node, io_ctx.m_comp_buf);
+  }
 
-  mutex_exit(&m_mutex);
+  complete_io(io_ctx.m_fil_node, io_ctx.m_io_request);
 
   ut_ad(validate());
 
@@ -2476,16 +3268,7 @@ void Fil::flush(space_id_t space_id) {
       node->m_n_pending_flushes--;
 
     skip_flush:
-      if (node->m_flush_counter < old_mod_counter) {
-        node->m_flush_counter = old_mod_counter;
-
-        if (space->m_is_in_unflushed_spaces && space_is_flushed(space)) {
-
-          space->m_is_in_unflushed_spaces = false;
-
-          UT_LIST_REMOVE(m_unflushed_spaces, space);
-        }
-      }
+      node_flushed_low(space, node, old_mod_counter);
 
       if (space->m_type == FIL_TABLESPACE) {
         --m_n_pending_tablespace_flushes;
@@ -2502,6 +3285,21 @@ void Fil::flush(space_id_t space_id) {
   mutex_exit(&m_mutex);
 }
 
+void Fil::node_flushed_low(fil_space_t *space, fil_node_t *node, int64_t old_mod_counter) {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (node->m_flush_counter < old_mod_counter) {
+    node->m_flush_counter = old_mod_counter;
+
+    if (space->m_is_in_unflushed_spaces && space_is_flushed(space)) {
+
+      space->m_is_in_unflushed_spaces = false;
+
+      UT_LIST_REMOVE(m_unflushed_spaces, space);
+    }
+  }
+}
+
 void Fil::flush_file_spaces(ulint purpose) {
   mutex_enter(&m_mutex);
 
@@ -2512,6 +3310,16 @@ void Fil::flush_file_spaces(ulint purpose) {
     return;
   }
 
+  /* A file of a tablespace that is being flushed in the batch below. */
+  struct Pending_flush {
+    fil_space_t *m_space;
+    fil_node_t *m_node;
+    int64_t m_old_mod_counter;
+  };
+
+  const auto batch = purpose == FIL_TABLESPACE && srv_aio != nullptr;
+  std::vector<Pending_flush> pending;
+
   /* Assemble a list of space ids to flush.  Previously, we
   traversed unflushed_spaces and called UT_LIST_GET_NEXT()
   on a space that was just removed from the list by Fil::flush().
@@ -2522,8 +3330,35 @@ void Fil::flush_file_spaces(ulint purpose) {
   space_ids.reserve(n_space_ids + 1);
 
   for (auto space : m_unflushed_spaces) {
-    if (space->m_type == purpose && !space->m_is_being_deleted) {
+    if (space->m_type != purpose || space->m_is_being_deleted || space_is_flushed(space)) {
+      continue;
+    }
+
+    /* A space with a file that another thread is flushing is flushed by
+    Fil::flush(), which waits for it. */
+    auto busy = !batch;
+
+    for (auto node : space->m_chain) {
+      busy = busy || node->m_n_pending_flushes > 0;
+    }
+
+    if (busy) {
       space_ids.push_back(space->m_id);
+      continue;
+    }
+
+    for (auto node : space->m_chain) {
+      if (node->m_modification_counter > node->m_flush_counter) {
+        ut_a(node->open);
+
+        /* Prevent dropping of the space and closing of the file while
+        we are flushing */
+        ++space->m_n_pending_flushes;
+        ++node->m_n_pending_flushes;
+        ++m_n_pending_tablespace_flushes;
+
+        pending.push_back({space, node, node->m_modification_counter});
+      }
     }
   }
 
@@ -2531,6 +3366,31 @@ void Fil::flush_file_spaces(ulint purpose) {
 
   mutex_exit(&m_mutex);
 
+  if (!pending.empty()) {
+    std::vector<os_file_t> files;
+
+    files.reserve(pending.size());
+
+    for (const auto &flush : pending) {
+      files.push_back(flush.m_node->m_fh);
+    }
+
+    srv_aio->sync_files(files.data(), files.size());
+
+    mutex_enter(&m_mutex);
+
+    for (const auto &flush : pending) {
+      --flush.m_node->m_n_pending_flushes;
+
+      node_flushed_low(flush.m_space, flush.m_node, flush.m_old_mod_counter);
+
+      --flush.m_space->m_n_pending_flushes;
+      --m_n_pending_tablespace_flushes;
+    }
+
+    mutex_exit(&m_mutex);
+  }
+
   for (auto space_id : space_ids) {
     if (space_id == FIL_NULL) {
       break;
@@ -2539,23 +3399,71 @@ void Fil::flush_file_spaces(ulint purpose) {
   }
 }
 
-bool Fil::validate() {
+std::vector<Fil::Space_files> Fil::get_space_files(ulint purpose) {
+  std::vector<Space_files> spaces;
+
   mutex_enter(&m_mutex);
 
-  ulint n_open{};
+  for (auto space : m_space_list) {
+    if (space->m_type != purpose || space->m_is_being_deleted) {
+      continue;
+    }
+
+    auto &files = spaces.emplace_back(Space_files{space->m_id, {}}).m_files;
 
-  for (auto &[id, space] : m_space_by_id) {
+    /* The size of a file that is not the last one of its space is set when
+    the space is created. */
+    page_no_t page_no{};
 
     for (auto node : space->m_chain) {
+      files.emplace_back(node->m_file_name, page_no);
+      page_no += node->m_size_in_pages;
+    }
+  }
 
-      ut_a(node->open || node->m_n_pending == 0);
+  mutex_exit(&m_mutex);
 
-      if (node->m_n_pending > 0) {
-        ut_a(node->open);
-      }
+  return spaces;
+}
+
+std::string Fil::space_free_last_file(space_id_t space_id, ulint n_files) {
+  std::string path;
 
-      if (node->open) {
-        ++n_open;
+  mutex_enter(&m_mutex);
+
+  auto space = space_get_by_id(space_id);
+
+  ut_a(space != nullptr && space->m_type == FIL_LOG);
+
+  if (UT_LIST_GET_LEN(space->m_chain) > n_files) {
+    auto node = UT_LIST_GET_LAST(space->m_chain);
+
+    path = node->m_file_name;
+
+    node_free(node, space);
+  }
+
+  mutex_exit(&m_mutex);
+
+  return path;
+}
+
+bool Fil::validate() {
+  mutex_enter(&m_mutex);
+
+  ulint n_open{};
+
+  for (auto &shard : m_space_shards) {
+    for (auto &[id, space] : shard.m_spaces) {
+
+      for (auto node : space->m_chain) {
+
+        /* The pending count of a closed file can only be non-zero for a
+        moment, see prepare_io_fast(). */
+
+        if (node->open) {
+          ++n_open;
+        }
       }
     }
   }
@@ -2588,6 +3496,29 @@ Fil_page_type Fil::page_get_type(const byte *page) {
   return static_cast<Fil_page_type>(mach_read_from_2(page + FIL_PAGE_TYPE));
 }
 
+Fil_io_page_class Fil_space_io_stats::get_page_class(const byte *ptr, ulint len, off_t off) noexcept {
+  if (off % UNIV_PAGE_SIZE != 0 || len < FIL_PAGE_COMP_ORIG_TYPE + 2) {
+    return Fil_io_page_class::OTHER;
+  }
+
+  auto type = Fil::page_get_type(ptr);
+
+  if (type == FIL_PAGE_TYPE_COMPRESSED) {
+    type = static_cast<Fil_page_type>(mach_read_from_2(ptr + FIL_PAGE_COMP_ORIG_TYPE));
+  }
+
+  switch (type) {
+    case FIL_PAGE_TYPE_INDEX:
+      return Fil_io_page_class::INDEX;
+    case FIL_PAGE_TYPE_UNDO_LOG:
+      return Fil_io_page_class::UNDO;
+    case FIL_PAGE_TYPE_BLOB:
+      return Fil_io_page_class::BLOB;
+    default:
+      return Fil_io_page_class::SYSTEM;
+  }
+}
+
 bool Fil::rmdir(const char *dbname) {
   bool success{};
   char dir[OS_FILE_MAX_PATH];
@@ -0,0 +1,133 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file fil/fil0prealloc.cc
+Tablespace preallocation
+*******************************************************/
+
+#include "fil0prealloc.h"
+#include "fil0fil.h"
+#include "fsp0types.h"
+#include "os0sync.h"
+#include "os0thread-create.h"
+#include "srv0srv.h"
+
+#include <algorithm>
+
+Fil_prealloc *srv_fil_prealloc{};
+
+Fil_prealloc::Fil_prealloc(Fil *fil) noexcept
+  : m_fil(fil), m_event(os_event_create("fil_prealloc_event")) {}
+
+Fil_prealloc::~Fil_prealloc() noexcept {
+  ut_a(!m_thread.joinable());
+
+  os_event_free(m_event);
+}
+
+Fil_prealloc *Fil_prealloc::create(Fil *fil) noexcept {
+  auto ptr = ut_new(sizeof(Fil_prealloc));
+  return ptr == nullptr ? nullptr : new (ptr) Fil_prealloc(fil);
+}
+
+void Fil_prealloc::destroy(Fil_prealloc *&prealloc) noexcept {
+  call_destructor(prealloc);
+  ut_delete(prealloc);
+  prealloc = nullptr;
+}
+
+void Fil_prealloc::start() noexcept {
+  ut_a(!m_thread.joinable());
+
+  m_shutdown.store(false, std::memory_order_release);
+
+  m_thread = create_joinable_thread(&Fil_prealloc::run, this);
+}
+
+void Fil_prealloc::shutdown() noexcept {
+  if (m_thread.joinable()) {
+    m_shutdown.store(true, std::memory_order_release);
+
+    os_event_set(m_event);
+
+    m_thread.join();
+  }
+
+  m_requests.clear();
+}
+
+void Fil_prealloc::request(space_id_t space_id, page_no_t size) noexcept {
+  const auto max_extents = srv_config.m_file_preallocate_extents;
+
+  if (max_extents == 0 || space_id == SYS_TABLESPACE || is_shutdown()) {
+    return;
+  }
+
+  /* Don't grow a small space by much more than the inserts would. */
+  const auto n_extents = std::min(max_extents, std::max(ulint(1), size / FSP_EXTENT_SIZE / 8));
+  const auto target = page_no_t(size + n_extents * FSP_EXTENT_SIZE);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = std::find_if(m_requests.begin(), m_requests.end(), [space_id](const Request &request) {
+      return request.m_space_id == space_id;
+    });
+
+    if (it != m_requests.end()) {
+      it->m_size = std::max(it->m_size, target);
+      return;
+    }
+
+    m_requests.push_back({space_id, target});
+  }
+
+  os_event_set(m_event);
+}
+
+void Fil_prealloc::run() noexcept {
+  std::vector<Request> requests;
+
+  while (!is_shutdown()) {
+    const auto sig_count = os_event_reset(m_event);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      requests.swap(m_requests);
+    }
+
+    if (requests.empty()) {
+      (void) m_event->wait_time(std::chrono::seconds(1), sig_count);
+      continue;
+    }
+
+    for (const auto &request : requests) {
+      if (is_shutdown()) {
+        break;
+      }
+
+      /* Does nothing if the file is big enough already or the space was
+      dropped meanwhile. */
+      const auto n_pages = m_fil->space_preallocate(request.m_space_id, request.m_size);
+
+      m_n_pages.fetch_add(n_pages, std::memory_order_relaxed);
+    }
+
+    requests.clear();
+  }
+}
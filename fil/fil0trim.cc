@@ -0,0 +1,173 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file fil/fil0trim.cc
+Trimming of the freed extents
+*******************************************************/
+
+#include "fil0trim.h"
+#include "fsp0fsp.h"
+#include "log0log.h"
+#include "os0sync.h"
+#include "os0thread-create.h"
+#include "srv0srv.h"
+
+Fil_trim *srv_fil_trim{};
+
+Fil_trim::Fil_trim(FSP *fsp) noexcept
+  : m_fsp(fsp), m_event(os_event_create("fil_trim_event")) {}
+
+Fil_trim::~Fil_trim() noexcept {
+  ut_a(!m_thread.joinable());
+
+  os_event_free(m_event);
+}
+
+Fil_trim *Fil_trim::create(FSP *fsp) noexcept {
+  auto ptr = ut_new(sizeof(Fil_trim));
+  return ptr == nullptr ? nullptr : new (ptr) Fil_trim(fsp);
+}
+
+void Fil_trim::destroy(Fil_trim *&trim) noexcept {
+  call_destructor(trim);
+  ut_delete(trim);
+  trim = nullptr;
+}
+
+void Fil_trim::start() noexcept {
+  ut_a(!m_thread.joinable());
+
+  m_shutdown.store(false, std::memory_order_release);
+
+  m_thread = create_joinable_thread(&Fil_trim::run, this);
+}
+
+void Fil_trim::shutdown() noexcept {
+  if (m_thread.joinable()) {
+    m_shutdown.store(true, std::memory_order_release);
+
+    os_event_set(m_event);
+
+    m_thread.join();
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_requests.clear();
+  m_n_untrimmed.clear();
+  m_n_pages_untrimmed.store(0, std::memory_order_relaxed);
+}
+
+void Fil_trim::request(space_id_t space_id, page_no_t page_no) noexcept {
+  if (!srv_config.m_file_trim_freed_extents || is_shutdown()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_requests.push_back({space_id, page_no, 0});
+
+    ++m_n_untrimmed[space_id];
+  }
+
+  m_n_pages_untrimmed.fetch_add(FSP_EXTENT_SIZE, std::memory_order_relaxed);
+
+  os_event_set(m_event);
+}
+
+ulint Fil_trim::get_n_pages_untrimmed(space_id_t space_id) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_n_untrimmed.find(space_id);
+
+  return it == m_n_untrimmed.end() ? 0 : it->second * FSP_EXTENT_SIZE;
+}
+
+void Fil_trim::forget(space_id_t space_id) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_n_untrimmed.find(space_id);
+    ut_a(it != m_n_untrimmed.end() && it->second > 0);
+
+    if (--it->second == 0) {
+      m_n_untrimmed.erase(it);
+    }
+  }
+
+  m_n_pages_untrimmed.fetch_sub(FSP_EXTENT_SIZE, std::memory_order_relaxed);
+}
+
+void Fil_trim::run() noexcept {
+  lsn_t checkpoint_lsn{};
+  std::vector<Request> requests;
+  std::vector<Request> retries;
+
+  while (!is_shutdown()) {
+    const auto sig_count = os_event_reset(m_event);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      requests.swap(m_requests);
+    }
+
+    /* The extents that were freed after the last checkpoint can only be
+    trimmed after the next one. */
+    const auto lsn = m_fsp->m_log->m_last_checkpoint_lsn.load(std::memory_order_relaxed);
+
+    if (lsn > checkpoint_lsn) {
+      checkpoint_lsn = lsn;
+      requests.insert(requests.end(), retries.begin(), retries.end());
+      retries.clear();
+    }
+
+    if (requests.empty()) {
+      (void) m_event->wait_time(std::chrono::seconds(1), sig_count);
+      continue;
+    }
+
+    for (auto &request : requests) {
+      if (is_shutdown()) {
+        break;
+      }
+
+      switch (m_fsp->trim_free_extent(request.m_space_id, request.m_page_no)) {
+        case FSP::Trim_status::Trimmed:
+          m_n_pages_trimmed.fetch_add(FSP_EXTENT_SIZE, std::memory_order_relaxed);
+          forget(request.m_space_id);
+          break;
+
+        case FSP::Trim_status::Retry:
+          if (++request.m_n_tries < MAX_TRIES) {
+            retries.push_back(request);
+          } else {
+            forget(request.m_space_id);
+          }
+          break;
+
+        case FSP::Trim_status::Not_free:
+        case FSP::Trim_status::Failed:
+          forget(request.m_space_id);
+          break;
+      }
+    }
+
+    requests.clear();
+  }
+}
@@ -28,6 +28,8 @@ Created 11/29/1995 Heikki Tuuri
 #include "dict0store.h"
 #include "dict0dict.h"
 #include "fil0fil.h"
+#include "fil0prealloc.h"
+#include "fil0trim.h"
 #include "fut0fut.h"
 #include "log0log.h"
 #include "mtr0log.h"
@@ -42,9 +44,9 @@ constexpr auto FSP_HEADER_OFFSET = FIL_PAGE_DATA;
 /** Tablespace id */
 constexpr ulint FSP_SPACE_ID = 0;
 
-/** This field contained a value up to which we know that the modifications
-in the database have been flushed to the file space; not used now */
-constexpr ulint FSP_NOT_USED = 4;
+/** UNIV_PAGE_SIZE_SHIFT of the build that created the space, 0 if it was
+created before the page size was recorded, those all have 16K pages */
+constexpr ulint FSP_PAGE_SIZE_SHIFT = 4;
 
 /** Current size of the space in pages */
 constexpr ulint FSP_SIZE = 8;
@@ -89,6 +91,9 @@ constexpr ulint FSP_HEADER_SIZE = 32 + 5 * FLST_BASE_NODE_SIZE;
 /** This many free extents are added to the free list from above FSP_FREE_LIMIT at a time */
 constexpr ulint FSP_FREE_ADD = 4;
 
+/** A tablespace is extended by at most this many extents at a time */
+constexpr ulint FSP_MAX_EXTEND = 64;
+
 /** The list node for linking segment inode pages */
 constexpr ulint FSEG_INODE_PAGE_NODE = FSEG_PAGE_DATA;
 
@@ -153,6 +158,21 @@ constexpr ulint FSEG_FREE_LIST_LIMIT = 40;
 
 constexpr ulint FSEG_FREE_LIST_MAX_LEN = 4;
 
+/** The free list of a fast growing segment is filled with at most this many
+extents at a time, see FSP::fseg_get_fill_size() */
+constexpr ulint FSEG_FREE_LIST_MAX_FILL = 64;
+
+/** A segment whose free list runs out within this time after it was filled
+grows fast, the next fill is doubled */
+constexpr auto FSEG_FAST_GROWTH = std::chrono::seconds(1);
+
+/** A segment whose free list lasts longer than this grows slowly, the next
+fill is halved */
+constexpr auto FSEG_SLOW_GROWTH = std::chrono::seconds(30);
+
+/** The growth of at most this many segments is remembered */
+constexpr ulint FSEG_GROWTH_MAX_SEGMENTS = 4096;
+
 /** The identifier of the segmentto which this extent belongs */
 constexpr ulint XDES_ID = 0;
 
@@ -196,6 +216,9 @@ constexpr ulint XDES_SIZE = XDES_BITMAP + UT_BITS_IN_BYTES(FSP_EXTENT_SIZE * XDE
 /** Offset of the descriptor array on a descriptor page */
 constexpr ulint XDES_ARR_OFFSET = FSP_HEADER_OFFSET + FSP_HEADER_SIZE;
 
+static_assert(XDES_ARR_OFFSET + XDES_SIZE * (UNIV_PAGE_SIZE / FSP_EXTENT_SIZE) <= UNIV_PAGE_SIZE - FIL_PAGE_DATA_END,
+              "The extent descriptors do not fit on a descriptor page");
+
 FSP *srv_fsp{};
 
 /**
@@ -788,9 +811,11 @@ bool FSP::try_extend_data_file(ulint *actual_increase, space_id_t space, fsp_hea
   if (size < 32 * extent_size) {
     size_increase = extent_size;
   } else {
-    /* Below in fsp_fill_free_list() we assume that we add at most FSP_FREE_ADD
-    extents at a time */
-    size_increase = FSP_FREE_ADD * extent_size;
+    /* Grow by an eighth of the size, a big space that grows fast is then
+    extended less often. fill_free_list() adds FSP_FREE_ADD extents of it
+    to the free list at a time, the rest stays above the free limit. */
+    size_increase = ut_calc_align_down(size / 8, extent_size);
+    size_increase = std::clamp(size_increase, page_no_t(FSP_FREE_ADD * extent_size), page_no_t(FSP_MAX_EXTEND * extent_size));
   }
 
   if (size_increase == 0) {
@@ -805,10 +830,10 @@ bool FSP::try_extend_data_file(ulint *actual_increase, space_id_t space, fsp_hea
     ut_a(success);
   }
 
-  /* We ignore any fragments of a full megabyte when storing the size
+  /* We ignore any fragments of a full extent when storing the size
   to the space header */
 
-  const auto new_size = ut_calc_align_down(actual_size, (1024 * 1024) / UNIV_PAGE_SIZE);
+  const auto new_size = ut_calc_align_down(actual_size, FSP_EXTENT_SIZE);
   mlog_write_ulint(header + FSP_SIZE, new_size, MLOG_4BYTES, mtr);
 
   *actual_increase = new_size - old_size;
@@ -886,6 +911,66 @@ void FSP::free_extent(space_id_t space, ulint page, mtr_t *mtr) noexcept {
   xdes_init(descr, mtr);
 
   flst_add_last(header + FSP_FREE, descr + XDES_FLST_NODE, mtr);
+
+  if (srv_fil_trim != nullptr) {
+    srv_fil_trim->request(space, page_no_t(page - page % FSP_EXTENT_SIZE));
+  }
+}
+
+FSP::Trim_status FSP::trim_free_extent(space_id_t space, page_no_t page) noexcept {
+  ut_ad(page % FSP_EXTENT_SIZE == 0);
+
+  mtr_t mtr;
+  auto status = Trim_status::Failed;
+
+  /* The mini-transaction is still active when the hole is punched, the
+  extent can't be allocated in between. */
+  const auto punched = m_fil->space_punch_hole(space, page, FSP_EXTENT_SIZE, [&]() -> bool {
+    mtr.start();
+
+    mtr_sx_lock(m_fil->space_get_latch(space), &mtr);
+
+    Buf_pool::Request req {
+      .m_rw_latch = RW_X_LATCH,
+      .m_page_id = { space, 0 },
+      .m_mode = BUF_GET_IF_IN_POOL,
+      .m_file = __FILE__,
+      .m_line = __LINE__,
+      .m_mtr = &mtr
+    };
+
+    auto block = m_buf_pool->get(req, nullptr);
+
+    /* Every change to the free lists changes the space header. */
+    if (block == nullptr || block->m_page.m_newest_modification > m_log->m_last_checkpoint_lsn.load(std::memory_order_relaxed)) {
+      status = Trim_status::Retry;
+      return false;
+    }
+
+    buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_FSP_PAGE));
+
+    auto header = FSP_HEADER_OFFSET + block->get_frame();
+    auto descr = xdes_get_descriptor_with_space_hdr(header, space, page, &mtr);
+
+    if (descr == nullptr || xdes_get_state(descr, &mtr) != XDES_FREE) {
+      status = Trim_status::Not_free;
+      return false;
+    }
+
+    status = Trim_status::Trimmed;
+
+    return true;
+  });
+
+  if (mtr.is_active()) {
+    mtr.commit();
+  }
+
+  if (status == Trim_status::Trimmed && !punched) {
+    status = Trim_status::Failed;
+  }
+
+  return status;
 }
 
 void FSP::fseg_fill_free_list(FSP::fseg_inode_t *inode, space_id_t space, page_no_t hint, mtr_t *mtr) noexcept {
@@ -907,7 +992,10 @@ void FSP::fseg_fill_free_list(FSP::fseg_inode_t *inode, space_id_t space, page_n
     return;
   }
 
-  for (ulint i{}; i < FSEG_FREE_LIST_MAX_LEN; ++i) {
+  const auto seg_id = mtr->read_uint64(inode + FSEG_ID);
+  const auto n_extents = fseg_get_fill_size(seg_id, reserved);
+
+  for (ulint i{}; i < n_extents; ++i) {
     auto descr = xdes_get_descriptor(space, hint, mtr);
 
     if (descr == nullptr || XDES_FREE != xdes_get_state(descr, mtr)) {
@@ -921,7 +1009,6 @@ void FSP::fseg_fill_free_list(FSP::fseg_inode_t *inode, space_id_t space, page_n
 
     xdes_set_state(descr, XDES_FSEG, mtr);
 
-    const auto seg_id = mtr->read_uint64(inode + FSEG_ID);
     ut_ad(mach_read_from_4(inode + FSEG_MAGIC_N) == FSEG_MAGIC_N_VALUE);
 
     mlog_write_uint64(descr + XDES_ID, seg_id, mtr);
@@ -932,6 +1019,44 @@ void FSP::fseg_fill_free_list(FSP::fseg_inode_t *inode, space_id_t space, page_n
   }
 }
 
+ulint FSP::fseg_get_fill_size(uint64_t seg_id, ulint n_reserved) noexcept {
+  const auto now = std::chrono::steady_clock::now();
+  const auto max_extents = std::clamp(n_reserved / FSP_EXTENT_SIZE / 8, FSEG_FREE_LIST_MAX_LEN, FSEG_FREE_LIST_MAX_FILL);
+
+  std::lock_guard<std::mutex> lock(m_fseg_growth_mutex);
+
+  auto it = m_fseg_growth.find(seg_id);
+
+  if (it == m_fseg_growth.end()) {
+    /* Forget the segments that stopped growing or were dropped. */
+    if (m_fseg_growth.size() >= FSEG_GROWTH_MAX_SEGMENTS) {
+      std::erase_if(m_fseg_growth, [now](const auto &entry) { return now - entry.second.m_last_fill > FSEG_SLOW_GROWTH; });
+
+      if (m_fseg_growth.size() >= FSEG_GROWTH_MAX_SEGMENTS) {
+        m_fseg_growth.clear();
+      }
+    }
+
+    m_fseg_growth.emplace(seg_id, Fseg_growth{now, FSEG_FREE_LIST_MAX_LEN});
+
+    return FSEG_FREE_LIST_MAX_LEN;
+  }
+
+  auto &growth = it->second;
+  const auto elapsed = now - growth.m_last_fill;
+
+  if (elapsed < FSEG_FAST_GROWTH) {
+    growth.m_n_extents *= 2;
+  } else if (elapsed > FSEG_SLOW_GROWTH) {
+    growth.m_n_extents /= 2;
+  }
+
+  growth.m_n_extents = std::clamp(growth.m_n_extents, FSEG_FREE_LIST_MAX_LEN, max_extents);
+  growth.m_last_fill = now;
+
+  return growth.m_n_extents;
+}
+
 FSP::xdes_t *FSP::fseg_alloc_free_extent(fseg_inode_t *inode, space_id_t space, mtr_t *mtr) noexcept{
   xdes_t *descr;
 
@@ -1158,7 +1283,7 @@ bool FSP::fseg_validate_low(fseg_inode_t *inode, mtr_t *mtr2) noexcept {
   while (!m_fil->addr_is_null(node_addr)) {
     mtr.start();
 
-    mtr_x_lock(m_fil->space_get_latch(space), &mtr);
+    mtr_sx_lock(m_fil->space_get_latch(space), &mtr);
 
     auto descr = xdes_lst_get_descriptor(space, node_addr, &mtr);
 
@@ -1179,7 +1304,7 @@ bool FSP::fseg_validate_low(fseg_inode_t *inode, mtr_t *mtr2) noexcept {
 
   while (!m_fil->addr_is_null(node_addr)) {
     mtr.start();
-    mtr_x_lock(m_fil->space_get_latch(space), &mtr);
+    mtr_sx_lock(m_fil->space_get_latch(space), &mtr);
 
     auto descr = xdes_lst_get_descriptor(space, node_addr, &mtr);
 
@@ -1201,7 +1326,7 @@ bool FSP::fseg_validate_low(fseg_inode_t *inode, mtr_t *mtr2) noexcept {
 
   while (!m_fil->addr_is_null(node_addr)) {
     mtr.start();
-    mtr_x_lock(m_fil->space_get_latch(space), &mtr);
+    mtr_sx_lock(m_fil->space_get_latch(space), &mtr);
 
     auto descr = xdes_lst_get_descriptor(space, node_addr, &mtr);
 
@@ -1251,7 +1376,7 @@ FSP::fsp_header_t *FSP::get_space_header(space_id_t id, mtr_t *mtr) noexcept {
 }
 
 FSP::xdes_t *FSP::xdes_lst_get_descriptor(space_id_t space, Fil_addr lst_node, mtr_t *mtr) noexcept {
-  ut_ad(mtr->memo_contains(m_fil->space_get_latch(space), MTR_MEMO_X_LOCK));
+  ut_ad(mtr->memo_contains(m_fil->space_get_latch(space), MTR_MEMO_SX_LOCK));
   auto descr = fut_get_ptr(space, lst_node, RW_X_LATCH, mtr) - XDES_FLST_NODE;
 
   return descr;
@@ -1499,7 +1624,7 @@ ulint FSP::alloc_free_page(space_id_t space, page_no_t hint, mtr_t *mtr) noexcep
 }
 
 FSP::xdes_t *FSP::xdes_get_descriptor_with_space_hdr(fsp_header_t *sp_header, space_id_t space, ulint offset, mtr_t *mtr) noexcept {
-  ut_ad(mtr->memo_contains(m_fil->space_get_latch(space), MTR_MEMO_X_LOCK));
+  ut_ad(mtr->memo_contains(m_fil->space_get_latch(space), MTR_MEMO_SX_LOCK));
   ut_ad(mtr->memo_contains_page(sp_header, MTR_MEMO_PAGE_S_FIX) || mtr->memo_contains_page(sp_header, MTR_MEMO_PAGE_X_FIX));
   ut_ad(page_offset(sp_header) == FSP_HEADER_OFFSET);
 
@@ -1887,7 +2012,7 @@ void FSP::init_fields(page_t *page, space_id_t space_id, ulint flags) noexcept {
 }
 
 void FSP::header_init(space_id_t space, ulint size, mtr_t *mtr) noexcept {
-  mtr_x_lock(m_fil->space_get_latch(space), mtr);
+  mtr_sx_lock(m_fil->space_get_latch(space), mtr);
 
   auto block = m_buf_pool->create(space, 0, mtr);
 
@@ -1918,7 +2043,7 @@ void FSP::header_init(space_id_t space, ulint size, mtr_t *mtr) noexcept {
   auto header = FSP_HEADER_OFFSET + page;
 
   mlog_write_ulint(header + FSP_SPACE_ID, space, MLOG_4BYTES, mtr);
-  mlog_write_ulint(header + FSP_NOT_USED, 0, MLOG_4BYTES, mtr);
+  mlog_write_ulint(header + FSP_PAGE_SIZE_SHIFT, UNIV_PAGE_SIZE_SHIFT, MLOG_4BYTES, mtr);
 
   mlog_write_ulint(header + FSP_SIZE, size, MLOG_4BYTES, mtr);
   mlog_write_ulint(header + FSP_FREE_LIMIT, 0, MLOG_4BYTES, mtr);
@@ -1954,12 +2079,18 @@ ulint FSP::get_flags(const page_t *page) noexcept {
   return mach_read_from_4(FSP_HEADER_OFFSET + FSP_SPACE_FLAGS + page);
 }
 
+ulint FSP::get_page_size_shift(const page_t *page) noexcept {
+  const auto shift = mach_read_from_4(FSP_HEADER_OFFSET + FSP_PAGE_SIZE_SHIFT + page);
+
+  return shift == 0 ? 14 : shift;
+}
+
 ulint FSP::init_system_space_free_limit() noexcept {
   mtr_t mtr;
 
   mtr.start();
 
-  mtr_x_lock(m_fil->space_get_latch(SYS_TABLESPACE), &mtr);
+  mtr_sx_lock(m_fil->space_get_latch(SYS_TABLESPACE), &mtr);
 
   auto header = get_space_header(SYS_TABLESPACE, &mtr);
   auto limit = mtr.read_ulint(header + FSP_FREE_LIMIT, MLOG_4BYTES);
@@ -1978,7 +2109,7 @@ ulint FSP::get_system_space_size() noexcept {
 
   mtr.start();
 
-  mtr_x_lock(m_fil->space_get_latch(SYS_TABLESPACE), &mtr);
+  mtr_s_lock(m_fil->space_get_latch(SYS_TABLESPACE), &mtr);
 
   auto header = get_space_header(SYS_TABLESPACE, &mtr);
   auto size = mtr.read_ulint(header + FSP_SIZE, MLOG_4BYTES);
@@ -2018,9 +2149,9 @@ Buf_block *FSP::fseg_create_general(
     header = byte_offset + block->get_frame();
   }
 
-  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_X_LOCK));
+  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_SX_LOCK));
 
-  mtr_x_lock(latch, mtr);
+  mtr_sx_lock(latch, mtr);
 
   ulint n_reserved{};
 
@@ -2112,9 +2243,9 @@ ulint FSP::fseg_n_reserved_pages(fseg_header_t *header, ulint *used, mtr_t *mtr)
   const auto space = page_get_space_id(page_align(header));
   auto latch = m_fil->space_get_latch(space);
 
-  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_X_LOCK));
+  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_SX_LOCK));
 
-  mtr_x_lock(latch, mtr);
+  mtr_sx_lock(latch, mtr);
 
   auto inode = fseg_inode_get(header, space, mtr);
 
@@ -2131,9 +2262,9 @@ page_no_t FSP::fseg_alloc_free_page_general(
   space_id_t space = page_get_space_id(page_align(seg_header));
   auto latch = m_fil->space_get_latch(space);
 
-  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_X_LOCK));
+  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_SX_LOCK));
 
-  mtr_x_lock(latch, mtr);
+  mtr_sx_lock(latch, mtr);
 
   auto inode = fseg_inode_get(seg_header, space, mtr);
 
@@ -2171,9 +2302,9 @@ bool FSP::reserve_free_extents(ulint *n_reserved, space_id_t space, ulint n_ext,
 
   auto latch = m_fil->space_get_latch(space);
 
-  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_X_LOCK));
+  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_SX_LOCK));
 
-  mtr_x_lock(latch, mtr);
+  mtr_sx_lock(latch, mtr);
 
   auto space_header = get_space_header(space, mtr);
 
@@ -2210,6 +2341,12 @@ bool FSP::reserve_free_extents(ulint *n_reserved, space_id_t space, ulint n_ext,
 
     auto n_free = n_free_list_ext + n_free_up;
 
+    /* Let the file grow in the background before the inserts have to wait
+    for it, the space header is still extended below. */
+    if (n_free < n_ext + Fil_prealloc::LOW_FREE_EXTENTS && srv_fil_prealloc != nullptr) {
+      srv_fil_prealloc->request(space, size);
+    }
+
     if (alloc_type == FSP_NORMAL) {
       /* We reserve 1 extent + 0.5 % of the space size to undo logs
       and 1 extent + 0.5 % to cleaning operations; NOTE: this source
@@ -2266,7 +2403,9 @@ uint64_t FSP::get_available_space_in_free_extents(space_id_t space) noexcept {
 
   auto latch = m_fil->space_get_latch(space);
 
-  mtr_x_lock(latch, &mtr);
+  /* Only reads the space header, let it run concurrently with an
+  allocation, which holds the latch in SX mode. */
+  mtr_s_lock(latch, &mtr);
 
   auto space_header = get_space_header(space, &mtr);
 
@@ -2350,9 +2489,9 @@ void FSP::fseg_mark_page_used(fseg_inode_t *seg_inode, space_id_t space, page_no
 void FSP::fseg_free_page(fseg_header_t *seg_header, space_id_t space, page_no_t page, mtr_t *mtr) noexcept {
   auto latch = m_fil->space_get_latch(space);
 
-  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_X_LOCK));
+  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_SX_LOCK));
 
-  mtr_x_lock(latch, mtr);
+  mtr_sx_lock(latch, mtr);
 
   const auto seg_inode = fseg_inode_get(seg_header, space, mtr);
 
@@ -2366,9 +2505,9 @@ bool FSP::fseg_free_step(fseg_header_t *header, mtr_t *mtr) noexcept {
   auto header_page = page_get_page_no(page_align(header));
   auto latch = m_fil->space_get_latch(space);
 
-  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_X_LOCK));
+  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_SX_LOCK));
 
-  mtr_x_lock(latch, mtr);
+  mtr_sx_lock(latch, mtr);
 
   auto descr = xdes_get_descriptor(space, header_page, mtr);
 
@@ -2428,9 +2567,9 @@ bool FSP::fseg_free_step_not_header(fseg_header_t *header, mtr_t *mtr) noexcept
   const auto space = page_get_space_id(page_align(header));
   auto latch = m_fil->space_get_latch(space);
 
-  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_X_LOCK));
+  ut_ad(!mutex_own(&kernel_mutex) || mtr->memo_contains(latch, MTR_MEMO_SX_LOCK));
 
-  mtr_x_lock(latch, mtr);
+  mtr_sx_lock(latch, mtr);
 
   auto inode = fseg_inode_get(header, space, mtr);
   auto descr = fseg_get_first_extent(inode, space, mtr);
@@ -2470,7 +2609,7 @@ bool FSP::fseg_free_step_not_header(fseg_header_t *header, mtr_t *mtr) noexcept
 bool FSP::fseg_validate(fseg_header_t *header, mtr_t *mtr) noexcept {
   auto space = page_get_space_id(page_align(header));
 
-  mtr_x_lock(m_fil->space_get_latch(space), mtr);
+  mtr_sx_lock(m_fil->space_get_latch(space), mtr);
 
   auto inode = fseg_inode_get(header, space, mtr);
 
@@ -2481,7 +2620,7 @@ bool FSP::fseg_validate(fseg_header_t *header, mtr_t *mtr) noexcept {
 void FSP::fseg_print(fseg_header_t *header, mtr_t *mtr) noexcept {
   auto space = page_get_space_id(page_align(header));
 
-  mtr_x_lock(m_fil->space_get_latch(space), mtr);
+  mtr_sx_lock(m_fil->space_get_latch(space), mtr);
 
   auto inode = fseg_inode_get(header, space, mtr);
 
@@ -2498,10 +2637,10 @@ bool FSP::validate(space_id_t space) noexcept {
   from the fsp system */
   mtr2.start();
 
-  mtr_x_lock(latch, &mtr2);
+  mtr_sx_lock(latch, &mtr2);
 
   mtr.start();
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   auto header = get_space_header(space, &mtr);
   auto size = mtr.read_ulint(header + FSP_SIZE, MLOG_4BYTES);
@@ -2524,7 +2663,7 @@ bool FSP::validate(space_id_t space) noexcept {
   /* Validate FSP_FREE list */
   mtr.start();
 
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   header = get_space_header(space, &mtr);
 
@@ -2537,7 +2676,7 @@ bool FSP::validate(space_id_t space) noexcept {
   while (!m_fil->addr_is_null(node_addr)) {
     mtr.start();
 
-    mtr_x_lock(latch, &mtr);
+    mtr_sx_lock(latch, &mtr);
 
     ++descr_count;
     auto descr = xdes_lst_get_descriptor(space, node_addr, &mtr);
@@ -2553,7 +2692,7 @@ bool FSP::validate(space_id_t space) noexcept {
   /* Validate FSP_FREE_FRAG list */
   mtr.start();
 
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   header = get_space_header(space, &mtr);
   node_addr = flst_get_first(header + FSP_FREE_FRAG, &mtr);
@@ -2565,7 +2704,7 @@ bool FSP::validate(space_id_t space) noexcept {
   while (!m_fil->addr_is_null(node_addr)) {
     mtr.start();
 
-    mtr_x_lock(latch, &mtr);
+    mtr_sx_lock(latch, &mtr);
 
     ++descr_count;
     auto descr = xdes_lst_get_descriptor(space, node_addr, &mtr);
@@ -2582,7 +2721,7 @@ bool FSP::validate(space_id_t space) noexcept {
 
   /* Validate FSP_FULL_FRAG list */
   mtr.start();
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   header = get_space_header(space, &mtr);
   node_addr = flst_get_first(header + FSP_FULL_FRAG, &mtr);
@@ -2591,7 +2730,7 @@ bool FSP::validate(space_id_t space) noexcept {
 
   while (!m_fil->addr_is_null(node_addr)) {
     mtr.start();
-    mtr_x_lock(latch, &mtr);
+    mtr_sx_lock(latch, &mtr);
 
     ++descr_count;
     auto descr = xdes_lst_get_descriptor(space, node_addr, &mtr);
@@ -2607,7 +2746,7 @@ bool FSP::validate(space_id_t space) noexcept {
   /* Validate segments */
   mtr.start();
 
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   header = get_space_header(space, &mtr);
 
@@ -2627,7 +2766,7 @@ bool FSP::validate(space_id_t space) noexcept {
     do {
       mtr.start();
 
-      mtr_x_lock(latch, &mtr);
+      mtr_sx_lock(latch, &mtr);
 
       auto seg_inode_page = fut_get_ptr(space, node_addr, RW_X_LATCH, &mtr) - FSEG_INODE_PAGE_NODE;
 
@@ -2654,7 +2793,7 @@ bool FSP::validate(space_id_t space) noexcept {
 
   mtr.start();
 
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   header = get_space_header(space, &mtr);
 
@@ -2673,7 +2812,7 @@ bool FSP::validate(space_id_t space) noexcept {
     do {
       mtr.start();
 
-      mtr_x_lock(latch, &mtr);
+      mtr_sx_lock(latch, &mtr);
 
       auto seg_inode_page = fut_get_ptr(space, node_addr, RW_X_LATCH, &mtr) - FSEG_INODE_PAGE_NODE;
 
@@ -2720,13 +2859,13 @@ void FSP::print(space_id_t space) noexcept {
 
   mtr2.start();
 
-  mtr_x_lock(latch, &mtr2);
+  mtr_sx_lock(latch, &mtr2);
 
   mtr_t mtr;
 
   mtr.start();
 
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   auto header = get_space_header(space, &mtr);
   auto size = mtr.read_ulint(header + FSP_SIZE, MLOG_4BYTES);
@@ -2762,7 +2901,7 @@ void FSP::print(space_id_t space) noexcept {
 
   mtr.start();
 
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   header = get_space_header(space, &mtr);
 
@@ -2781,7 +2920,7 @@ void FSP::print(space_id_t space) noexcept {
 
       mtr.start();
 
-      mtr_x_lock(latch, &mtr);
+      mtr_sx_lock(latch, &mtr);
 
       auto seg_inode_page = fut_get_ptr(space, node_addr, RW_X_LATCH, &mtr) - FSEG_INODE_PAGE_NODE;
 
@@ -2803,7 +2942,7 @@ void FSP::print(space_id_t space) noexcept {
 
   mtr.start();
 
-  mtr_x_lock(latch, &mtr);
+  mtr_sx_lock(latch, &mtr);
 
   header = get_space_header(space, &mtr);
 
@@ -2820,7 +2959,7 @@ void FSP::print(space_id_t space) noexcept {
 
       mtr.start();
 
-      mtr_x_lock(latch, &mtr);
+      mtr_sx_lock(latch, &mtr);
 
       auto seg_inode_page = fut_get_ptr(space, node_addr, RW_X_LATCH, &mtr) - FSEG_INODE_PAGE_NODE;
 
@@ -41,7 +41,7 @@ is executed in a background transaction. It will lock the data
 dictionary lock for the duration of the query.
 @param[in] sql                  SQL to execute
 @param[in] args                 Arguments to SQL
-@return	DB_SUCCESS or error code */
+@return	DB_SUCCESS, DB_READONLY in a read-only instance, or error code */
 ib_err_t ib_exec_ddl_sql(const char *sql, ulint n_args, ...);
 
 /** Initialize the config system.
@@ -45,3 +45,6 @@ enum db_err ib_trx_lock_table_with_retry(
 /** Updates the table modification counter and calculates new estimates
 for table and index statistics if necessary. */
 void ib_update_statistics_if_needed(Table *table); /*!< in/out: table */
+
+/** Frees the query graphs cached by ib_exec_sql() and ib_exec_ddl_sql(). */
+void ib_sql_cache_clear();
@@ -377,4 +377,90 @@ struct Blob {
    * The B-tree handler.
    */
   Btree *m_btree{};
-};
\ No newline at end of file
+};
+
+/** Reads a column value in pieces, an externally stored part is read from
+its BLOB pages straight into the caller's buffer. The position in the BLOB
+page chain is kept between reads, sequential reads visit each page once.
+The clustered index record that the column was read from must stay locked,
+or visible in the read view of the transaction, while the reader is used. */
+struct Blob_reader {
+  /** Maximum number of BLOB pages read ahead at a time. */
+  static constexpr ulint N_READ_AHEAD_PAGES = 32;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] fsp             File space handler.
+   * @param[in] btree           The B-tree handler.
+   * @param[in] data            Column data, if the column is externally stored
+   *                            the local part followed by the field reference.
+   * @param[in] len             Length of data.
+   * @param[in] is_extern       true if the column is externally stored.
+   */
+  Blob_reader(FSP *fsp, Btree *btree, const byte *data, ulint len, bool is_extern) noexcept;
+
+  /**
+   * @return the length of the column value.
+   */
+  [[nodiscard]] uint64_t get_len() const noexcept {
+    return m_local_len + m_extern_len;
+  }
+
+  /**
+   * Copies a part of the column value.
+   *
+   * @param[in] offset          Offset in the value to start the copy from.
+   * @param[out] buf            Buffer to copy to.
+   * @param[in] len             Number of bytes to copy.
+   *
+   * @return the number of bytes copied, less than len if the end of the
+   *  value was reached.
+   */
+  [[nodiscard]] ulint read(uint64_t offset, byte *buf, ulint len) noexcept;
+
+ private:
+  /**
+   * Issues reads of the pages following a BLOB page. The pages of a BLOB
+   * are allocated with the previous page + 1 as the hint, the window is a
+   * guess that is correct for most BLOBs.
+   *
+   * @param[in] page_no         The next page of the chain, FIL_NULL if none.
+   */
+  void read_ahead(page_no_t page_no) noexcept;
+
+ private:
+  /** For the BLOB page helpers. */
+  Blob m_blob;
+
+  /** The locally stored part of the value. */
+  const byte *m_local{};
+
+  /** Length of the locally stored part. */
+  ulint m_local_len{};
+
+  /** Length of the externally stored part, 0 if none. */
+  uint64_t m_extern_len{};
+
+  /** Tablespace of the BLOB pages. */
+  space_id_t m_space_id{};
+
+  /** First BLOB page. */
+  page_no_t m_first_page_no{FIL_NULL};
+
+  /** Offset of the BLOB header on the first page. */
+  ulint m_first_offset{};
+
+  /** The current page, FIL_NULL to start from the first page. */
+  page_no_t m_page_no{FIL_NULL};
+
+  /** Offset of the BLOB header on the current page. */
+  ulint m_page_offset{};
+
+  /** Offset in the externally stored part where the current page starts. */
+  uint64_t m_page_start{};
+
+  /** Pages [m_ra_low, m_ra_high) have been read ahead. */
+  page_no_t m_ra_low{};
+  page_no_t m_ra_high{};
+};
@@ -135,7 +135,9 @@ struct Btree {
   [[nodiscard]] rec_t *root_raise_and_insert(Btree_cursor *cursor, const DTuple *tuple, ulint n_ext, mtr_t *mtr) noexcept;
 
   /**
-   * Reorganizes an index page.
+   * Reorganizes an index page. If there are no explicit record locks on the
+   * page the records are compacted in place with page_compact(), else the
+   * page is rebuilt through a temporary block and the locks are moved.
    * 
    * IMPORTANT: if btr_page_reorganize() is invoked on a compressed leaf
    * page of a non-clustered index, the caller must update the insert
@@ -365,10 +367,11 @@ struct Btree {
    * @param[in] page_no         Page number
    * @param[in] rw_latch        Latch mode
    * @param[in,out] mtr         Mini-transaction.
+   * @param[in] index           If not nullptr, the index whose page reads are counted
    * 
    * @return	buffer block
    */
-  [[nodiscard]]inline Buf_block *block_get(space_id_t space_id, page_no_t page_no, ulint rw_latch, mtr_t *mtr) noexcept {
+  [[nodiscard]]inline Buf_block *block_get(space_id_t space_id, page_no_t page_no, ulint rw_latch, mtr_t *mtr, const Index *index = nullptr) noexcept {
     Buf_pool::Request req {
       .m_rw_latch = rw_latch,
       .m_page_id = { space_id, page_no },
@@ -380,6 +383,10 @@ struct Btree {
 
     auto block = srv_buf_pool->get(req, nullptr);
 
+    if (req.m_read && index != nullptr) {
+      index->m_counters.inc(Index::PAGE_READS);
+    }
+
     if (rw_latch != RW_NO_LATCH) {
 
       buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_TREE_NODE));
@@ -729,9 +736,30 @@ private:
    * @param[in] split_rec       First record on upper half page.
    * @param[in,out] new_block   The new half page.
    * @param[in] direction       FSP_UP or FSP_DOWN.
+   * @param[in] n_fields        Number of leading key fields of split_rec to
+   *                            keep in the node pointer to the upper half,
+   *                            see node_ptr_n_fields().
    * @param[in] mtr             Mini-transaction handle.
    */
-  void attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, mtr_t *mtr) noexcept;
+  void attach_half_pages(Index *index, Buf_block *block, rec_t *split_rec, Buf_block *new_block, ulint direction, ulint n_fields, mtr_t *mtr) noexcept;
+
+  /**
+   * Computes the number of leading key fields of the first record of the
+   * upper half of a leaf split that separate it from the lower half. The
+   * node pointer to the upper half only needs these, the other key fields
+   * are stored as SQL NULL, which sorts before any value.
+   *
+   * @param[in] index           The index tree.
+   * @param[in] split_rec       First record on the upper half page.
+   * @param[in] offsets         Offsets of the key fields of split_rec.
+   * @param[in] tuple           Tuple to insert.
+   * @param[in] insert_left     true if the tuple goes to the lower half.
+   * @param[in] heap            Temporary memory heap.
+   *
+   * @return number of key fields, at most the number of unique fields in
+   *  the tree.
+   */
+  [[nodiscard]] ulint node_ptr_n_fields(const Index *index, const rec_t *split_rec, const ulint *offsets, const DTuple *tuple, bool insert_left, mem_heap_t *heap) noexcept;
 
   /**
    * Determine if a tuple is smaller than any record on the page.
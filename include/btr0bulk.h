@@ -0,0 +1,217 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/btr0bulk.h
+Sorted bulk build of a B-tree
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "data0types.h"
+#include "db0err.h"
+#include "mem0types.h"
+#include "page0types.h"
+#include "rem0types.h"
+#include "trx0types.h"
+
+#include <utility>
+#include <vector>
+
+struct Btree;
+struct Buf_block;
+struct Index;
+
+/** Builds a B-tree bottom up from entries that arrive in ascending order.
+
+The pages of a level are built one at a time in a buffer outside the tree,
+records are appended left to right without redo logging. A page is written to
+the tree once the next entry would take it over the fill factor: a page is
+allocated, the whole page is logged with a single MLOG_PAGE_BUILT record and
+it is linked behind the previous page of the level. The node pointer to the
+page is then appended to the level above the same way, the levels above the
+leaves are thus built incrementally.
+
+finish() writes the pages that are still being built, the page on the topmost
+level becomes the root page of the index. Until then the root is left empty:
+if the build fails the index stays empty, the pages written so far remain
+allocated to the segments of the index until it is dropped.
+
+The index must be empty and no other thread may access it during the build,
+the records are written without locks and without undo log records.
+
+If the build is not logged, only the page allocations are: the contents of
+the pages below the root are written without redo. Before the root is
+written finish() flushes them and syncs the tablespace, the root page is then
+logged as usual. After a crash before that the root is still empty, the index
+is then empty as if the build had failed. */
+struct Btree_bulk {
+  /**
+   * Constructor.
+   *
+   * @param[in] btree           B-tree of the index.
+   * @param[in] index           Index to build, must be empty.
+   * @param[in] trx_id          Id of the transaction that builds the index.
+   * @param[in] redo            false to write the pages below the root
+   *                            without redo, see above.
+   */
+  Btree_bulk(Btree *btree, const Index *index, trx_id_t trx_id, bool redo = true) noexcept;
+
+  /** Destructor, frees the pages still being built. */
+  ~Btree_bulk() noexcept;
+
+  Btree_bulk(const Btree_bulk &) = delete;
+  Btree_bulk &operator=(const Btree_bulk &) = delete;
+
+  /**
+   * Appends an entry to the leaf level. Fields that don't fit on a page are
+   * converted to externally stored fields, the tuple is modified then.
+   *
+   * @param[in,out] tuple       Entry to append, greater than the previous one.
+   * @param[in] n_ext           Number of externally stored columns.
+   *
+   * @return DB_SUCCESS, DB_DUPLICATE_KEY if the key of a unique index equals
+   *  the previous key, DB_INVALID_INPUT if the entry is not greater than the
+   *  previous one, DB_TOO_BIG_RECORD or DB_OUT_OF_FILE_SPACE.
+   */
+  [[nodiscard]] db_err insert(DTuple *tuple, ulint n_ext) noexcept;
+
+  /**
+   * Writes the pages still being built and makes the page on the topmost
+   * level the root page.
+   *
+   * @param[in] err             DB_SUCCESS, or the error that stopped the
+   *                            build, the root is then left empty.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err finish(db_err err) noexcept;
+
+  /** @return the number of pages written to the index. */
+  [[nodiscard]] ulint get_n_pages() const noexcept { return m_n_pages; }
+
+ private:
+  /** The page being built on a level. */
+  struct Level {
+    /** Buffer of the page, not a page of the tree. */
+    Buf_block *m_block{};
+
+    /** Last record appended to the page, the infimum if none. */
+    rec_t *m_last_rec{};
+
+    /** Page number of the previous page written on the level, FIL_NULL
+    if none. */
+    page_no_t m_prev_page_no{};
+
+    /** Number of pages written on the level. */
+    ulint m_n_pages{};
+  };
+
+  /**
+   * Starts building a new page on a level.
+   *
+   * @param[in] level_no        Level of the page.
+   */
+  void page_init(ulint level_no) noexcept;
+
+  /**
+   * Appends a record to the page being built on a level. Writes the page
+   * first if the record would take it over the fill factor.
+   *
+   * @param[in] level_no        Level of the record.
+   * @param[in] tuple           Record to append.
+   * @param[in] n_ext           Number of externally stored columns.
+   * @param[in] big_rec         Fields of the record to store externally, or
+   *                            nullptr. Owned by the builder, also on failure.
+   *
+   * @return DB_SUCCESS or DB_OUT_OF_FILE_SPACE.
+   */
+  [[nodiscard]] db_err append(ulint level_no, const DTuple *tuple, ulint n_ext, big_rec_t *big_rec) noexcept;
+
+  /**
+   * Writes the page being built on a level to the tree and appends the node
+   * pointer to it to the level above.
+   *
+   * @param[in] level_no        Level of the page.
+   * @param[in] is_root         true if it's the only page of the topmost
+   *                            level, the page is then written to the root.
+   *
+   * @return DB_SUCCESS or DB_OUT_OF_FILE_SPACE.
+   */
+  [[nodiscard]] db_err page_commit(ulint level_no, bool is_root) noexcept;
+
+  /**
+   * Stores the externally stored fields of the records of a leaf page
+   * that was written to the tree.
+   *
+   * @param[in] page_no         Page number of the leaf page.
+   *
+   * @return DB_SUCCESS or DB_OUT_OF_FILE_SPACE.
+   */
+  [[nodiscard]] db_err store_ext(page_no_t page_no) noexcept;
+
+  /** Flushes the pages that were written without redo and syncs the
+  tablespace, they must be durable before the root is logged. */
+  void flush_unlogged() noexcept;
+
+  /**
+   * Checks that an entry sorts after the last leaf record.
+   *
+   * @param[in] tuple           Entry to append.
+   *
+   * @return DB_SUCCESS, DB_DUPLICATE_KEY or DB_INVALID_INPUT.
+   */
+  [[nodiscard]] db_err check_order(const DTuple *tuple) noexcept;
+
+ private:
+  /** B-tree of the index. */
+  Btree *m_btree{};
+
+  /** Index to build. */
+  const Index *m_index{};
+
+  /** Id of the transaction that builds the index. */
+  trx_id_t m_trx_id{};
+
+  /** Free space left on a page, from the fill factor. */
+  ulint m_reserve{};
+
+  /** Free space left on a leaf page. */
+  ulint m_leaf_reserve{};
+
+  /** Number of pages written to the index. */
+  ulint m_n_pages{};
+
+  /** true if the pages below the root are logged. */
+  bool m_redo{true};
+
+  /** End lsn of the last mini-transaction that wrote a page without redo,
+  0 if none. */
+  lsn_t m_unlogged_lsn{};
+
+  /** Heap for the converted records and node pointers, emptied after each
+  entry. */
+  mem_heap_t *m_heap{};
+
+  /** The pages being built, indexed by level, the leaves are level 0. */
+  std::vector<Level> m_levels{};
+
+  /** Externally stored fields of the records of the leaf page being built,
+  with the offsets of the records in the page. */
+  std::vector<std::pair<ulint, big_rec_t *>> m_big_recs{};
+};
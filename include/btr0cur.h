@@ -69,6 +69,16 @@ constexpr ulint BTR_CUR_PAGE_LOW_FILL_LIMIT = UNIV_PAGE_SIZE / 2;
 /** Size of path array (in slots) */
 constexpr ulint BTR_PATH_ARRAY_N_SLOTS = 250;
 
+/** The leaf page a batch of inserts or lookups in key order went to last.
+The next one of the batch tries it before descending the tree. */
+struct Btree_leaf_guess {
+  /** Leaf block, nullptr if none */
+  Buf_block *m_block{};
+
+  /** Modify clock of the block when it was remembered */
+  uint64_t m_modify_clock{};
+};
+
 struct Btree_cursor {
   /**
    * A slot in the path array. We store here info on a search path down the tree.
@@ -182,8 +192,16 @@ struct Btree_cursor {
    * @param[in] latch_mode      The latch mode (BTR_SEARCH_LEAF, ...).
    * @param[in] mtr             The mini-transaction handle.
    * @param[in] loc             The source location.
-   */
-  void open_at_rnd_pos(const Index *index, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept;
+   * @param[in,out] rnd_state   State of the random numbers, see
+   *                            ut_rnd_gen_ulint(), nullptr to use the shared
+   *                            generator.
+   * @param[out] weight         If not nullptr, the product of the number of
+   *                            records on the pages of the path, the inverse
+   *                            of the probability that the record was chosen.
+   */
+  void open_at_rnd_pos(
+    const Index *index, ulint latch_mode, mtr_t *mtr, Source_location loc, ulint *rnd_state = nullptr, double *weight = nullptr
+  ) noexcept;
 
   /**
    * Tries to perform an insert to a page in an index tree, next to cursor.
@@ -279,14 +297,15 @@ struct Btree_cursor {
   /**
    * Marks a clustered index record deleted. Writes an undo log record to undo log on this delete marking.
    * Writes in the trx id field the id of the deleting transaction, and in the roll ptr field pointer to the
-   * undo log record created.
+   * undo log record created. The undo log record is written in mtr when it fits on the last undo log page.
    *
    * @param[in] flags           Undo logging and locking flags
    * @param[in] val             Value to set
    * @param[in] thr             Query thread
-   * @param[in] mtr             Mtr
+   * @param[in] mtr             Mtr, no index page may be latched in it after this call
    *
-   * @return DB_SUCCESS, DB_LOCK_WAIT, or error number
+   * @return DB_SUCCESS, DB_LOCK_WAIT, DB_FAIL if mtr holds the last undo log page for other records and the
+   *  undo record does not fit on it, or error number
    */
   [[nodiscard]] db_err del_mark_set_clust_rec(ulint flags, bool val, que_thr_t *thr, mtr_t *mtr) noexcept;
 
@@ -428,6 +447,16 @@ struct Btree_cursor {
     return page_cur_get_rec(&m_page_cur);
   }
 
+  /**
+   * Returns the number of fields that matched the record at the cursor after
+   * a search with PAGE_CUR_LE, see m_low_match.
+   *
+   * @return Number of matched fields.
+   */
+  [[nodiscard]] inline ulint get_low_match() const noexcept {
+    return m_low_match;
+  }
+
   /**
    * Invalidates a tree cursor by setting the record pointer to nullptr.
    */
@@ -571,10 +600,11 @@ private:
    * @param[in] thr             Query thread or nullptr.
    * @param[in] mtr             Mini-transaction.
    * @param[in] inherit         True if the inserted new record maybe should inherit LOCK_GAP type locks from the successor record.
+   * @param[in] undo_in_mtr     True if the undo record can be written in mtr, only when no tree page is latched after it.
    *
    * @return DB_SUCCESS, DB_WAIT_LOCK, DB_FAIL, or error number.
    */
-  [[nodiscard]] inline db_err ins_lock_and_undo(ulint flags, const DTuple *entry, que_thr_t *thr, mtr_t *mtr, bool *inherit) noexcept;
+  [[nodiscard]] inline db_err ins_lock_and_undo(ulint flags, const DTuple *entry, que_thr_t *thr, mtr_t *mtr, bool *inherit, bool undo_in_mtr) noexcept;
 
   #ifdef UNIV_DEBUG
   /**
@@ -596,6 +626,7 @@ private:
    * @param[in] thr             The query thread.
    * @param[in] mtr             The mini-transaction.
    * @param[in] roll_ptr        The roll pointer.
+   * @param[in] undo_in_mtr     True if the undo record can be written in mtr, only when no tree page is latched after it.
    * 
    * @return DB_SUCCESS, DB_WAIT_LOCK, or error number
    */
@@ -605,7 +636,8 @@ private:
     ulint cmpl_info,
     que_thr_t *thr,
     mtr_t *mtr,
-    roll_ptr_t *roll_ptr
+    roll_ptr_t *roll_ptr,
+    bool undo_in_mtr
   ) noexcept;
 
   /**
@@ -711,10 +743,121 @@ private:
     return m_lock_sys;
   }
 
+  /**
+   * Finds the number of the leaf page that a key belongs to, without the
+   * index tree latch and without accessing the leaf page. The non-leaf pages
+   * are searched the same way as in search_optimistic(). The result is a
+   * hint, the tree may change as soon as this returns.
+   *
+   * If missing_page_no is not nullptr the non-leaf pages are not read, the
+   * descent stops at the first one that is not in the buffer pool.
+   *
+   * @param[in] index           Index to search.
+   * @param[in] tuple           Search key.
+   * @param[in] loc             Location of the caller.
+   * @param[out] missing_page_no The non-leaf page that is not in the buffer
+   *                            pool, FIL_NULL if the descent did not stop.
+   *
+   * @return the leaf page number, or FIL_NULL if the root is a leaf, the
+   *  tree changed during the descent or a page was missing.
+   */
+  [[nodiscard]] page_no_t get_leaf_page_no(
+    const Index *index, const DTuple *tuple, Source_location loc, page_no_t *missing_page_no = nullptr
+  ) noexcept;
+
 #ifndef UNIT_TESTING
 private:
 #endif /* UNIT_TESTING */
 
+  /**
+   * Positions the cursor on a leaf record with the adaptive hash index.
+   *
+   * @param[in] tuple           Search key, a full unique key.
+   * @param[in] fold            Fold of the key.
+   * @param[in] mode            PAGE_CUR_LE or PAGE_CUR_GE.
+   * @param[in] latch_mode      BTR_SEARCH_LEAF or BTR_MODIFY_LEAF.
+   * @param[in,out] mtr         Mini-transaction.
+   * @param[in] loc             Location of the caller.
+   *
+   * @return true if the cursor is positioned on the record of the key and
+   *  its page is latched, false if the tree must be searched.
+   */
+  [[nodiscard]] bool search_hash(const DTuple *tuple, ulint fold, ulint mode, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept;
+
+  /**
+   * Positions the cursor on the leaf level without the index tree latch.
+   * The non-leaf pages are only buffer-fixed, each one is copied and the
+   * copy is searched once the tree latch version shows that no x-latch
+   * holder changed the tree meanwhile. Only the leaf page is latched.
+   *
+   * @param[in] tuple           Search key.
+   * @param[in] mode            PAGE_CUR_L, ...
+   * @param[in] latch_mode      BTR_SEARCH_LEAF or BTR_MODIFY_LEAF.
+   * @param[in,out] mtr         Mini-transaction.
+   * @param[in] loc             Location of the caller.
+   *
+   * @return true if the cursor is positioned and the leaf page latched,
+   *  false if the tree changed during the descent, the caller must then
+   *  search with the tree latch.
+   */
+  [[nodiscard]] bool search_optimistic(const DTuple *tuple, ulint mode, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept;
+
+  /**
+   * Positions the cursor for an insert past the last key of the index, on
+   * the last user record of the rightmost leaf remembered in the index,
+   * without descending the tree.
+   *
+   * @param[in] tuple           Entry to insert.
+   * @param[in,out] mtr         Mini-transaction.
+   * @param[in] loc             Location of the caller.
+   *
+   * @return true if the cursor is positioned and the leaf page x-latched,
+   *  false if the guess is stale or the entry isn't greater than the last
+   *  key, the caller must then search the tree.
+   */
+  [[nodiscard]] bool search_append(const DTuple *tuple, mtr_t *mtr, Source_location loc) noexcept;
+
+  /**
+   * Remembers the leaf page of the cursor in the index for search_append()
+   * if it's the rightmost leaf. The page must be x-latched.
+   */
+  void update_append() noexcept;
+
+  /**
+   * Positions the cursor for an insert (PAGE_CUR_LE, BTR_MODIFY_LEAF) or a
+   * lookup (PAGE_CUR_GE, BTR_SEARCH_LEAF) on the leaf page in m_leaf_guess,
+   * with a binary search of that page only. The key must fall between the
+   * first and the last user record of the page, or after the last one of
+   * the rightmost leaf, before the first one of the leftmost leaf.
+   *
+   * @param[in] tuple           Entry to insert or key to look up.
+   * @param[in] mode            PAGE_CUR_LE or PAGE_CUR_GE.
+   * @param[in] latch_mode      BTR_MODIFY_LEAF or BTR_SEARCH_LEAF.
+   * @param[in,out] mtr         Mini-transaction.
+   * @param[in] loc             Location of the caller.
+   *
+   * @return true if the cursor is positioned and the leaf page latched,
+   *  false if the guess is stale or the key may belong to another page,
+   *  the caller must then search the tree.
+   */
+  [[nodiscard]] bool search_leaf_guess(const DTuple *tuple, ulint mode, ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept;
+
+  /**
+   * Remembers the leaf page of the cursor in m_leaf_guess. The page must
+   * be latched.
+   */
+  void update_leaf_guess() noexcept;
+
+  /**
+   * Learns from a leaf search that the hash index could have answered and
+   * adds the record found to the hash index once the index is hot.
+   *
+   * @param[in] tuple           Search key, a full unique key.
+   * @param[in] fold            Fold of the key.
+   * @param[in] mode            PAGE_CUR_LE or PAGE_CUR_GE.
+   */
+  void update_hash(const DTuple *tuple, ulint fold, ulint mode) noexcept;
+
   /** Index where positioned */
   const Index *m_index{};
 
@@ -730,6 +873,10 @@ private:
    * in the insert buffer */
   que_thr_t *m_thr{};
 
+  /** Set by the caller of search_to_nth_level() for an insert or a lookup
+   * that is part of a batch in key order, nullptr otherwise */
+  Btree_leaf_guess *m_leaf_guess{};
+
   /** Search method used */
   Method m_flag{BTR_CUR_NONE};
 
@@ -737,6 +884,11 @@ private:
   * operation */
   ulint m_tree_height{};
 
+  /** Page number of the parent of the leaf page found by the last descent
+  to the leaf level, FIL_NULL if not known. Only a hint: the page can be
+  split, merged or freed once the tree latch is released. */
+  page_no_t m_parent_page_no{FIL_NULL};
+
   /** If the search mode was PAGE_CUR_LE, the number of matched fields to the
   * the first user record to the right of the cursor record after
   * search_to_nth_level; for the mode PAGE_CUR_GE, the matched fields
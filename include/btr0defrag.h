@@ -0,0 +1,99 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/btr0defrag.h
+Online defragmentation of a B-tree
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+
+struct Btree;
+struct Buf_block;
+struct Index;
+struct mtr_t;
+
+/** Merges under-full neighbour pages of the leaf level of an index.
+
+The leaf level is walked left to right in chunks of N_PAGES_PER_MTR pages,
+each chunk in its own mini-transaction that holds the tree x-latch: other
+threads get the index between the chunks. A page is merged into its left
+neighbour with Btree::compress() when the records of both fit in a page
+within the fill factor, the emptied page is freed to its segment. The
+upper levels shrink as the node pointers of the freed pages are deleted.
+
+The walk resumes from the first key of the last page visited, a page
+merged or split by another thread meanwhile is visited again at worst. */
+struct Btree_defrag {
+  /** Number of leaf pages visited with the tree latched. */
+  static constexpr ulint N_PAGES_PER_MTR = 32;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] btree           B-tree of the index.
+   * @param[in] index           Index to defragment.
+   */
+  Btree_defrag(Btree *btree, const Index *index) noexcept;
+
+  /** Walks the whole leaf level once. */
+  void run() noexcept;
+
+  /** @return the number of leaf pages visited. */
+  [[nodiscard]] ulint get_n_pages_scanned() const noexcept { return m_n_pages_scanned; }
+
+  /** @return the number of leaf pages freed. */
+  [[nodiscard]] ulint get_n_pages_freed() const noexcept { return m_n_pages_freed; }
+
+ private:
+  /**
+   * Merges a page into its left neighbour if the records of both fit.
+   *
+   * @param[in,out] block       The left neighbour.
+   * @param[in,out] next_block  The page to merge, freed on success.
+   * @param[in,out] mtr         Mini-transaction that holds the tree x-latch
+   *                            and both pages x-latched.
+   *
+   * @return true if the page was merged.
+   */
+  [[nodiscard]] bool merge(Buf_block *block, Buf_block *next_block, mtr_t *mtr) noexcept;
+
+ private:
+  /** B-tree of the index. */
+  Btree *m_btree{};
+
+  /** Index to defragment. */
+  const Index *m_index{};
+
+  /** Maximum size of the records of a merged page, from the fill factor. */
+  ulint m_max_data_size{};
+
+  /** Number of leaf pages visited. */
+  ulint m_n_pages_scanned{};
+
+  /** Number of leaf pages freed. */
+  ulint m_n_pages_freed{};
+};
+
+/** Number of leaf pages visited by all the defragmentations, for progress. */
+extern std::atomic<ulint> srv_defrag_n_pages_scanned;
+
+/** Number of leaf pages freed by all the defragmentations. */
+extern std::atomic<ulint> srv_defrag_n_pages_freed;
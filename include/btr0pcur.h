@@ -167,6 +167,19 @@ struct Btree_pcursor {
    */
   [[nodiscard]] bool restore_position(ulint latch_mode, mtr_t *mtr, Source_location loc) noexcept;
 
+  /**
+   * @brief Sets whether the block of the stored position is kept buffer-fixed
+   * between store_position() and restore_position(). The block then cannot be
+   * evicted or relocated, and the position is restored without a search unless
+   * the page was modified in between. Off by default.
+   *
+   * Note: A buffer-fixed block stops the tablespace of the index from being
+   * dropped, the cursor must be closed first.
+   *
+   * @param[in] keep            true to keep the block fixed.
+   */
+  void set_keep_block_fixed(bool keep) noexcept;
+
   /**
    * @brief Releases the page latch and bufferfix reserved by the cursorif the latch mode is BTR_LEAF_SEARCH or BTR_LEAF_MODIFY.
    * 
@@ -187,6 +200,17 @@ struct Btree_pcursor {
    */
   void move_to_next_page(mtr_t *mtr) noexcept;
 
+  /**
+   * @brief Prefetches the leaf pages that follow a page once the cursor
+   * has moved forward page by page a few times. The page numbers are taken
+   * from the node pointers of the parent pages, which are only latched if
+   * that doesn't have to wait, else from the FIL_PAGE_NEXT of the page.
+   * 
+   * @param[in] block           The leaf page the cursor moved to, latched.
+   * @param[in] mtr             The mtr (mini-transaction) object.
+   */
+  void prefetch_next_pages(const Buf_block *block, mtr_t *mtr) noexcept;
+
   /**
    * @brief Moves the persistent cursor backward if it is on the first record of the page.
    * Releases the latch on the current page and bufferunfixes it.
@@ -551,6 +575,35 @@ struct Btree_pcursor {
 
   /** Read level where the cursor would be positioned or re-positioned. */
   ulint m_read_level{};
+
+  /** Number of moves to the next leaf page since the cursor was opened. */
+  ulint m_n_next_pages{};
+
+  /** Number of leaf pages prefetched that the cursor hasn't reached yet. */
+  ulint m_n_prefetched{};
+
+  /** Last leaf page prefetched, valid if m_n_prefetched > 0. */
+  page_no_t m_prefetch_page_no{FIL_NULL};
+
+  /** Parent page of m_prefetch_page_no, FIL_NULL if not known. */
+  page_no_t m_prefetch_parent_page_no{FIL_NULL};
+
+  /** true if the block of the stored position is kept buffer-fixed, see
+  set_keep_block_fixed() */
+  bool m_keep_block_fixed{};
+
+  /** The block that the cursor keeps buffer-fixed, or nullptr */
+  Buf_block *m_fixed_block{};
+
+private:
+  /**
+   * @brief Buffer-fixes the block of the stored position if the cursor keeps
+   * it fixed, the block that was fixed before is released.
+   *
+   * @param[in] block           The block, latched by the caller, or nullptr
+   *                            to only release the fixed block.
+   */
+  void set_fixed_block(Buf_block *block) noexcept;
 };
 
 inline Btree_cursor_pos Btree_pcursor::get_rel_pos() const noexcept {
@@ -814,6 +867,9 @@ inline void Btree_pcursor::init(ulint read_level) noexcept {
   m_old_rec_buf = nullptr;
   m_old_rec = nullptr;
   m_read_level = read_level;
+  m_n_next_pages = 0;
+  m_n_prefetched = 0;
+  m_prefetch_parent_page_no = FIL_NULL;
 }
 
 inline void Btree_pcursor::open(
@@ -888,6 +944,8 @@ inline void Btree_pcursor::set_random_position(const Index *index, ulint latch_m
 }
 
 inline void Btree_pcursor::close() noexcept {
+  set_fixed_block(nullptr);
+
   if (m_old_rec_buf != nullptr) {
     mem_free(m_old_rec_buf);
     m_old_rec = nullptr;
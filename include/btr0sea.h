@@ -0,0 +1,256 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/btr0sea.h
+The adaptive hash index
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "data0types.h"
+#include "rem0types.h"
+
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+struct Buf_block;
+struct Buf_pool;
+struct Index;
+struct mtr_t;
+
+/** The adaptive hash index.
+
+Maps the unique key of a leaf record, folded together with the index id, to
+the buffer block and the offset of the record in the page. A point lookup
+that finds its key here latches the leaf page directly instead of descending
+the tree from the root, see Btree_cursor::search_to_nth_level().
+
+An entry is only a guess: it also records the modify clock of the block, the
+block is latched only if the clock is unchanged, i.e., no record of the page
+was deleted or moved and the block still holds the same page. The cursor then
+compares the record with the search key. A stale entry costs a miss, never a
+wrong result.
+
+Only searches of a full unique key in a leaf page, with BTR_SEARCH_LEAF or
+BTR_MODIFY_LEAF, use the hash index. The keys of an index are added after
+BUILD_LIMIT such searches in a row found their key, searches that don't find
+their key start the count again.
+
+The entries are split into partitions by the fold, each with its own latch.
+The latch is held while the block is buffer-fixed, clear() therefore waits
+for the lookups in flight and the buffer pool calls it before it frees the
+memory of the chunks it removes. */
+struct Btr_search {
+  /** Number of point lookups in a row on an index that found their key
+  before the keys of the index are added to the hash index. */
+  static constexpr ulint BUILD_LIMIT = 100;
+
+  /** Minimum number of entries of a partition. */
+  static constexpr ulint MIN_PART_ENTRIES = 1024;
+
+  /** A hash index entry. */
+  struct Entry {
+    /** Id of the index of the record. */
+    uint64_t m_index_id{};
+
+    /** Block that held the leaf page of the record when the entry was added. */
+    Buf_block *m_block{};
+
+    /** Modify clock of the block when the entry was added. */
+    uint64_t m_modify_clock{};
+
+    /** Offset of the record in the page. */
+    ulint m_offset{};
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param[in] n_parts         Number of partitions.
+   * @param[in] max_entries     Maximum number of entries, an arbitrary entry
+   *                            of a full partition is replaced on an insert.
+   */
+  Btr_search(ulint n_parts, ulint max_entries) noexcept;
+
+  /** Destructor. */
+  ~Btr_search() noexcept = default;
+
+  /**
+   * Creates an instance.
+   *
+   * @param[in] n_parts         Number of partitions.
+   * @param[in] max_entries     Maximum number of entries.
+   *
+   * @return the instance.
+   */
+  [[nodiscard]] static Btr_search *create(ulint n_parts, ulint max_entries) noexcept;
+
+  /**
+   * Destroys an instance.
+   *
+   * @param[in,out] search      Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Btr_search *&search) noexcept;
+
+  /** @return true if the searches use the hash index. */
+  [[nodiscard]] bool is_enabled() const noexcept {
+    return m_enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Turns the hash index on or off, turning it off empties it.
+   *
+   * @param[in] enabled         true to turn it on.
+   */
+  void set_enabled(bool enabled) noexcept;
+
+  /**
+   * Checks if the hash index can answer a search.
+   *
+   * @param[in] index           Index to search.
+   * @param[in] tuple           Search key.
+   * @param[in] mode            Search mode, PAGE_CUR_LE, PAGE_CUR_GE, ...
+   * @param[in] latch_mode      Latch mode without the BTR_INSERT and
+   *                            BTR_ESTIMATE flags.
+   *
+   * @return true if the search is a point lookup of a unique key in a leaf page.
+   */
+  [[nodiscard]] bool is_candidate(const Index *index, const DTuple *tuple, ulint mode, ulint latch_mode) const noexcept;
+
+  /**
+   * Looks up a key and latches the leaf page of its record in the mtr. The
+   * caller must compare the record with the key.
+   *
+   * @param[in] buf_pool        Buffer pool.
+   * @param[in] index           Index to search.
+   * @param[in] fold            Fold of the key, see dtuple_fold().
+   * @param[in] latch_mode      BTR_SEARCH_LEAF or BTR_MODIFY_LEAF.
+   * @param[out] rec            The record on success.
+   * @param[in,out] mtr         Mini-transaction.
+   * @param[in] loc             Location of the caller.
+   *
+   * @return the latched block, or nullptr if there is no entry, the page has
+   *  changed since the entry was added or it could not be latched without
+   *  waiting.
+   */
+  [[nodiscard]] Buf_block *guess(Buf_pool *buf_pool, const Index *index, ulint fold, ulint latch_mode, rec_t *&rec, mtr_t *mtr, Source_location loc) noexcept;
+
+  /**
+   * Counts the outcome of a lookup.
+   *
+   * @param[in] fold            Fold of the key.
+   * @param[in] hit             true if the lookup positioned the cursor.
+   */
+  void count(ulint fold, bool hit) noexcept {
+    auto &part = get_partition(fold);
+
+    if (hit) {
+      part.m_n_hits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      part.m_n_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Adds the entry of a leaf record or replaces the entry of its fold. The
+   * caller must have the page latched.
+   *
+   * @param[in] index           Index of the record.
+   * @param[in] fold            Fold of the key of the record.
+   * @param[in,out] block       Leaf page of the record.
+   * @param[in] rec             Record.
+   */
+  void insert(const Index *index, ulint fold, Buf_block *block, const rec_t *rec) noexcept;
+
+  /**
+   * Removes the entry of a fold if it points to a block.
+   *
+   * @param[in] fold            Fold of the key.
+   * @param[in] block           Block of the entry.
+   */
+  void erase(ulint fold, const Buf_block *block) noexcept;
+
+  /**
+   * Removes the entries of the records of a leaf page. Called before the
+   * page is reorganized, split or freed. The caller must have the page
+   * x-latched.
+   *
+   * @param[in] index           Index of the page.
+   * @param[in,out] block       The page.
+   */
+  void drop_page_hash(const Index *index, Buf_block *block) noexcept;
+
+  /**
+   * Removes the entries of an index, called when the index is removed from
+   * the dictionary cache.
+   *
+   * @param[in] index_id        Id of the index.
+   */
+  void drop_index(uint64_t index_id) noexcept;
+
+  /** Removes all the entries. */
+  void clear() noexcept;
+
+  /** @return the number of searches the hash index answered. */
+  [[nodiscard]] ulint get_n_hits() const noexcept;
+
+  /** @return the number of searches the hash index could not answer. */
+  [[nodiscard]] ulint get_n_misses() const noexcept;
+
+  /** @return the number of entries. */
+  [[nodiscard]] ulint get_n_entries() const noexcept;
+
+ private:
+  /** A partition of the hash index. */
+  struct alignas(64) Partition {
+    /** Protects m_entries. */
+    mutable std::shared_mutex m_latch{};
+
+    /** Map from the fold of a key to its entry. */
+    std::unordered_map<ulint, Entry> m_entries{};
+
+    /** Number of searches answered by the entries of this partition. */
+    std::atomic<ulint> m_n_hits{};
+
+    /** Number of searches this partition could not answer. */
+    std::atomic<ulint> m_n_misses{};
+  };
+
+  /**
+   * @param[in] fold            Fold of a key.
+   *
+   * @return the partition of a fold.
+   */
+  [[nodiscard]] Partition &get_partition(ulint fold) noexcept;
+
+ private:
+  /** true if the searches use the hash index. */
+  std::atomic<bool> m_enabled{};
+
+  /** Maximum number of entries of a partition. */
+  ulint m_max_part_entries{};
+
+  /** The partitions. */
+  std::vector<Partition> m_parts;
+};
+
+/** The adaptive hash index, nullptr if not created. */
+extern Btr_search *srv_btr_search;
@@ -84,7 +84,9 @@ to delete record only. It is used to optimize block->lock range.*/
 constexpr size_t BTR_LATCH_FOR_DELETE = 32768;
 
 /** In the case of BTR_MODIFY_LEAF, the caller intends to allocate or
-free the pages of externally stored fields. */
+free the pages of externally stored fields. The leaf is X-latched and the
+tree SX-latched: the tree structure cannot change but readers can still
+descend the tree. */
 constexpr size_t BTR_MODIFY_EXTERNAL = 65536;
 
 #define BTR_LATCH_MODE_WITHOUT_FLAGS(latch_mode) \
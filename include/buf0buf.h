@@ -32,6 +32,7 @@ Created 11/5/1995 Heikki Tuuri
 #include "mtr0types.h"
 #include "page0types.h"
 #include "ut0crc32.h"
+#include "ut0rnd.h"
 
 /** mutex protecting the buffer pool struct and control blocks, except the
 read-write lock in them */
@@ -128,8 +129,8 @@ FILE_PAGE => NOT_USED	NOTE: This transition is allowed if and only if
   (3) io_fix == 0.
 */
 
-inline uint64_t Buf_pool::get_oldest_modification() const {
-  mutex_enter(&m_mutex);
+inline uint64_t Buf_pool_instance::get_oldest_modification() const {
+  flush_list_mutex_acquire();
 
   auto bpage = UT_LIST_GET_LAST(m_flush_list);
 
@@ -142,7 +143,7 @@ inline uint64_t Buf_pool::get_oldest_modification() const {
     lsn = bpage->m_oldest_modification;
   }
 
-  mutex_exit(&m_mutex);
+  flush_list_mutex_release();
 
   /* The returned answer may be out of date: the flush_list can
   change after the mutex has been released. */
@@ -536,15 +537,63 @@ inline void Buf_block::fix_dec() {
   IF_SYNC_DEBUG(rw_lock_s_unlock(&m_debug_latch));
 }
 
-inline Buf_page *Buf_pool::hash_get_page(space_id_t space_id, page_no_t page_no) {
-  ut_ad(mutex_own(&m_mutex));
+inline ulint Buf_page_hash::hash(space_id_t space_id, page_no_t page_no) const noexcept {
+  return ut_hash_ulint(buf_page_address_fold(space_id, page_no), m_n_cells);
+}
 
-  // Look for the page in the hash table
-  Buf_page *bpage{nullptr};
-  if (auto it = m_page_hash->find(Page_id(space_id, page_no)); it != m_page_hash->end()) {
-    bpage = it->second;
+inline Buf_page *Buf_page_hash::find_low(ulint h, space_id_t space_id, page_no_t page_no) const noexcept {
+  for (auto bpage = get_cell(h); bpage != nullptr; bpage = bpage->m_hash_next) {
+    if (bpage->m_space == space_id && bpage->m_page_no == page_no) {
+      return bpage;
+    }
   }
 
+  return nullptr;
+}
+
+inline Buf_page *Buf_page_hash::find(space_id_t space_id, page_no_t page_no) const noexcept {
+  return find_low(hash(space_id, page_no), space_id, page_no);
+}
+
+inline Buf_page *Buf_page_hash::find_latched(space_id_t space_id, page_no_t page_no) const noexcept {
+  const auto h = hash(space_id, page_no);
+  std::shared_lock<std::shared_mutex> latch(get_partition(h).m_latch);
+
+  return find_low(h, space_id, page_no);
+}
+
+inline void Buf_page_hash::insert(Buf_page *bpage) noexcept {
+  const auto h = hash(bpage->m_space, bpage->m_page_no);
+  std::lock_guard<std::shared_mutex> latch(get_partition(h).m_latch);
+
+  ut_ad(find_low(h, bpage->m_space, bpage->m_page_no) == nullptr);
+
+  auto &cell = get_cell(h);
+
+  bpage->m_hash_next = cell;
+  cell = bpage;
+}
+
+inline void Buf_page_hash::erase(Buf_page *bpage) noexcept {
+  const auto h = hash(bpage->m_space, bpage->m_page_no);
+  std::lock_guard<std::shared_mutex> latch(get_partition(h).m_latch);
+
+  auto prev = &get_cell(h);
+
+  while (*prev != bpage) {
+    ut_a(*prev != nullptr);
+    prev = &(*prev)->m_hash_next;
+  }
+
+  *prev = bpage->m_hash_next;
+  bpage->m_hash_next = nullptr;
+}
+
+inline Buf_page *Buf_pool_instance::hash_get_page(space_id_t space_id, page_no_t page_no) {
+  ut_ad(mutex_own(&m_mutex));
+
+  auto bpage = m_page_hash->find(space_id, page_no);
+
   if (bpage != nullptr) {
     ut_a(bpage->in_file());
     ut_ad(bpage->m_in_page_hash);
@@ -554,18 +603,55 @@ inline Buf_page *Buf_pool::hash_get_page(space_id_t space_id, page_no_t page_no)
   return bpage;
 }
 
-inline Buf_block *Buf_pool::hash_get_block(space_id_t space, page_no_t page_no) {
+inline Buf_block *Buf_pool_instance::hash_get_block(space_id_t space, page_no_t page_no) {
   return buf_page_get_block(hash_get_page(space, page_no));
 }
 
-inline bool Buf_pool::peek(space_id_t space_id, page_no_t page_no) {
-  mutex_enter(&m_mutex);
+inline Buf_block *Buf_pool_instance::hash_lock_block(space_id_t space, page_no_t page_no, Buf_block *guess) {
+  ut_ad(!mutex_own(&m_mutex));
+
+  auto block = guess;
+
+  for (;;) {
+    if (block == nullptr) {
+      auto bpage = m_page_hash->find_latched(space, page_no);
+
+      if (bpage == nullptr) {
+        return nullptr;
+      }
+
+      /* Don't check the state here, we don't hold any mutex yet. */
+      block = bpage->get_block();
+    }
+
+    mutex_enter(&block->m_mutex);
+
+    /* The block may have been evicted or reused for another page since we
+    looked it up, the page id and the state are stable under the block mutex. */
+    if (block->m_page.m_space == space && block->m_page.m_page_no == page_no &&
+        block->get_state() == BUF_BLOCK_FILE_PAGE) {
+
+      ut_ad(block->m_page.m_in_page_hash);
+      return block;
+    }
+
+    mutex_exit(&block->m_mutex);
 
-  auto bpage = hash_get_page(space_id, page_no);
+    block = nullptr;
+  }
+}
 
-  mutex_exit(&m_mutex);
+inline bool Buf_pool_instance::peek(space_id_t space_id, page_no_t page_no) {
+  return m_page_hash->find_latched(space_id, page_no) != nullptr;
+}
 
-  return bpage != nullptr;
+inline Buf_pool_instance *Buf_pool::get_instance(space_id_t space_id, page_no_t page_no) const noexcept {
+  /* Use the same instance for all the pages of a read-ahead area. */
+  return get_instance_at(buf_page_address_fold(space_id, page_no >> 6) % m_instances.size());
+}
+
+inline bool Buf_pool::peek(space_id_t space_id, page_no_t page_no) {
+  return get_instance(space_id, page_no)->peek(space_id, page_no);
 }
 
 inline buf_frame_t *Buf_block::get_frame() const {
@@ -612,6 +698,24 @@ inline void buf_page_release_latch(Buf_block *block, ulint rw_latch) {
   }
 }
 
+/** Calculates the legacy checksum of a page, stored in FIL_PAGE_SPACE_OR_CHKSUM
+with BUF_NO_CHECKSUM_MAGIC in the trailer. It is only verified, new pages are
+written with buf_page_calc_crc32c().
+@param[in] page                 Page to checksum.
+@return checksum */
 inline uint32_t buf_page_data_calc_checksum(const byte *page) {
   return crc32::checksum(page + FIL_PAGE_OFFSET, UNIV_PAGE_SIZE - FIL_PAGE_DATA);
 }
+
+/** Calculates the CRC32C checksum of a page. The checksum fields and
+FIL_PAGE_FILE_FLUSH_LSN, which is written in place, are not covered. The
+checksum is stored both in FIL_PAGE_SPACE_OR_CHKSUM and in the first 4 bytes
+of the trailer, which tells it apart from the legacy format.
+@param[in] page                 Page to checksum.
+@return checksum */
+inline uint32_t buf_page_calc_crc32c(const byte *page) {
+  const auto header = crc32::checksum(page + FIL_PAGE_OFFSET, FIL_PAGE_FILE_FLUSH_LSN - FIL_PAGE_OFFSET);
+  const auto body = crc32::checksum(page + FIL_PAGE_DATA, UNIV_PAGE_SIZE - FIL_PAGE_DATA - FIL_PAGE_END_LSN_CHKSUM);
+
+  return header ^ body;
+}
@@ -72,6 +72,31 @@ constexpr auto SYS_DOUBLEWRITE_BLOCK_SIZE = FSP_EXTENT_SIZE;
 
 /* @} */
 
+/** Maximum number of slots the doublewrite area is split into, each slot
+has 2 * SYS_DOUBLEWRITE_BLOCK_SIZE / DBLWR_MAX_SLOTS pages at least. */
+constexpr ulint DBLWR_MAX_SLOTS = 8;
+
+/** How flushed pages are protected against torn writes, the value of the
+"doublewrite_mode" config variable. */
+enum dblwr_mode_t : ulint {
+  /** All the flushers share the whole doublewrite area. */
+  DBLWR_MODE_SINGLE,
+
+  /** The doublewrite area is split into slots, one per buffer pool
+  instance up to DBLWR_MAX_SLOTS, so that the batches of parallel page
+  cleaners do not serialize on one area. */
+  DBLWR_MODE_PARALLEL,
+
+  /** The pages of files that are on devices that report atomic writes of
+  at least a page are written in place with RWF_ATOMIC, the other pages go
+  through the doublewrite slots as in DBLWR_MODE_PARALLEL. Requires O_DIRECT. */
+  DBLWR_MODE_AUTO,
+
+  /** The storage is configured to guarantee atomic page writes, e.g., the
+  device or the file system, the doublewrite buffer is bypassed. */
+  DBLWR_MODE_ATOMIC
+};
+
 /** Doublewrite control struct */
 struct DBLWR {
 
@@ -115,7 +140,9 @@ struct DBLWR {
    * upgrading to an InnoDB version which supports multiple tablespaces, then this
    * function performs the necessary update operations. If we are in a crash
    * recovery, this function uses a possible doublewrite buffer to restore
-   * half-written pages in the data files.
+   * half-written pages in the data files. The pages in the data files are
+   * compared by several threads, consecutive ones with one read, and only
+   * the corrupt ones are written.
    * 
    */
   void recover_pages() noexcept;
@@ -142,11 +169,73 @@ struct DBLWR {
    */
   static bool check_if_exists(Fil* fil, std::pair<page_no_t, page_no_t> &offsets) noexcept;
 
+  /** A range of the doublewrite area that is filled and written by one
+  flusher at a time. */
+  struct Slot {
+    /** mutex protecting the first_free field and write_buf */
+    mutex_t m_mutex{};
+
+    /** Position of the first page of the slot in the doublewrite area */
+    ulint m_start{};
+
+    /** Number of pages in the slot */
+    ulint m_n_pages{};
+
+    /** First free position in write_buf measured in units of UNIV_PAGE_SIZE */
+    ulint m_first_free{};
+
+    /** Points into DBLWR::m_write_buf at m_start */
+    byte *m_write_buf{};
+
+    /** Array to store pointers to the buffer blocks which have been
+    cached to write_buf */
+    std::vector<Buf_page*> m_bpages{};
+  };
+
+  /**
+   * Returns the slot used by the flusher of a buffer pool instance.
+   *
+   * @param[in] instance_no     Index of the buffer pool instance.
+   *
+   * @return the slot.
+   */
+  [[nodiscard]] Slot &get_slot(ulint instance_no) noexcept {
+    return m_slots[instance_no % m_slots.size()];
+  }
+
+  /**
+   * @param[in] pos             Position of a page in the doublewrite area,
+   *                            the first block followed by the second one.
+   *
+   * @return the page number of the position in the system tablespace.
+   */
+  [[nodiscard]] page_no_t get_page_no(ulint pos) const noexcept {
+    ut_ad(pos < 2 * SYS_DOUBLEWRITE_BLOCK_SIZE);
+
+    return pos < SYS_DOUBLEWRITE_BLOCK_SIZE ? m_block1 + pos : m_block2 + pos - SYS_DOUBLEWRITE_BLOCK_SIZE;
+  }
+
+  /**
+   * Checks if the pages of a tablespace can be written in place without
+   * going through the doublewrite buffer.
+   *
+   * @param[in] space_id        Tablespace of the page to write.
+   *
+   * @return true if the writes of a page to the tablespace cannot be torn,
+   *  or if a torn page of it is never read, see fil_space_t::m_is_temp.
+   */
+  [[nodiscard]] bool is_bypassed(space_id_t space_id) const noexcept;
+
+  /** @return true if some page writes may bypass the doublewrite buffer. */
+  [[nodiscard]] bool may_bypass() const noexcept {
+    return m_mode == DBLWR_MODE_ATOMIC || m_mode == DBLWR_MODE_AUTO;
+  }
+
   /** Filespace manager for IO. */
   FSP *m_fsp{};
 
-  /** mutex protecting the first_free field and write_buf */
-  mutex_t m_mutex{};
+  /** The doublewrite mode, a dblwr_mode_t. */
+  const ulint m_mode{};
 
   /** The page number of the first doublewrite block (64 pages) */
   page_no_t m_block1{};
@@ -154,9 +243,6 @@ struct DBLWR {
   /** Page number of the second block */
   page_no_t m_block2{};
 
-  /** First free position in write_buf measured in units of UNIV_PAGE_SIZE */
-  ulint m_first_free{};
-
   /** Write buffer used in writing to the doublewrite buffer, aligned to an
   address divisible by UNIV_PAGE_SIZE (which is required by Windows aio) */
   byte *m_write_buf{};
@@ -164,9 +250,8 @@ struct DBLWR {
   /** pointer to write_buf, but unaligned */
   byte *m_ptr{};
 
-   /** Array to store pointers to the buffer blocks which have been
-  cached to write_buf */
-  std::vector<Buf_page*> m_bpages{};
+  /** The slots of the doublewrite area, they partition the whole area. */
+  std::vector<Slot> m_slots{};
 };
 
 /** Doublewrite system */
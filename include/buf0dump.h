@@ -0,0 +1,132 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/buf0dump.h
+Dumps the page ids of the hottest buffer pool pages to a file, and reads
+these pages back into the buffer pool at startup.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+struct Cond_var;
+
+/** Buffer pool dump and load.
+
+The dump is a text file in the data home directory with one "space,page_no"
+line per page, the pages are taken from the young end of the LRU list of each
+buffer pool instance. It is written at shutdown and, optionally, every
+buffer_pool_dump_interval minutes by a background thread.
+
+At startup the same thread reads the file back, sorts the page ids and
+posts batched asynchronous reads in the style of buf_read_recv_pages(). The
+load is throttled to io_capacity pages per second and backs off while there
+are pending reads, so that the reads of the user threads are served first. */
+struct Buf_dump {
+  /** Name of the dump file in the data home directory. */
+  static constexpr const char *FILE_NAME = "ib_buffer_pool";
+
+  /** Maximum number of reads posted to the IO layer in one batch. */
+  static constexpr ulint LOAD_BATCH_SIZE = 64;
+
+  /** Constructor. */
+  Buf_dump() noexcept;
+
+  /** Destructor. The thread must have been shut down. */
+  ~Buf_dump() noexcept;
+
+  /**
+   * Creates an instance, the thread is not started.
+   *
+   * @return the instance or nullptr if out of memory.
+   */
+  [[nodiscard]] static Buf_dump *create() noexcept;
+
+  /**
+   * Destroys an instance.
+   *
+   * @param[in,out] buf_dump    Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Buf_dump *&buf_dump) noexcept;
+
+  /** Starts the background thread, it loads the dump first if
+  buffer_pool_load_at_startup is set. */
+  void start() noexcept;
+
+  /**
+   * Stops the background thread, aborting a load that is in progress, and
+   * dumps the buffer pool if buffer_pool_dump_at_shutdown is set.
+   *
+   * @param[in] dump_all        Dump all the pages, even if
+   *                            buffer_pool_dump_at_shutdown is not set.
+   */
+  void shutdown(bool dump_all = false) noexcept;
+
+  /**
+   * Writes the page ids of the hottest pages of each buffer pool instance
+   * to the dump file.
+   *
+   * @param[in] pct             Percentage of the LRU list of each instance
+   *                            to dump.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err dump(ulint pct) noexcept;
+
+  /**
+   * Reads the pages listed in the dump file into the buffer pool.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err load() noexcept;
+
+ private:
+  /** The background thread. */
+  void run() noexcept;
+
+  /**
+   * Sleeps until the timeout expires or shutdown is requested.
+   *
+   * @param[in] timeout         Time to sleep.
+   *
+   * @return false if shutdown was requested.
+   */
+  [[nodiscard]] bool sleep(std::chrono::microseconds timeout) noexcept;
+
+  /** @return true if the thread should exit. */
+  [[nodiscard]] bool is_shutdown() const noexcept {
+    return m_shutdown.load(std::memory_order_acquire);
+  }
+
+ private:
+  /** Set to true to make the thread exit. */
+  std::atomic<bool> m_shutdown{};
+
+  /** Set to wake up the thread on shutdown. */
+  Cond_var *m_event{};
+
+  /** The dump and load thread. */
+  std::thread m_thread{};
+};
+
+/** The buffer pool dump and load, nullptr if not running. */
+extern Buf_dump *srv_buf_dump;
@@ -32,22 +32,47 @@ Created 11/5/1995 Heikki Tuuri
 #include "ut0byte.h"
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
+struct Cond_var;
 struct DBLWR;
 struct Buf_page;
 struct Buf_block;
 
+/** Which neighbors of a page are flushed with it, the value of the
+"flush_neighbors" config variable. */
+enum flush_neighbors_t : ulint {
+  /** Only the page itself is flushed. */
+  FLUSH_NEIGHBORS_OFF,
+
+  /** The dirty pages that are adjacent to the page, up to the first page
+  that cannot be flushed, within its flush area. */
+  FLUSH_NEIGHBORS_CONTIGUOUS,
+
+  /** All the flushable pages in the flush area of the page. */
+  FLUSH_NEIGHBORS_AREA,
+
+  /** FLUSH_NEIGHBORS_AREA while the measured data file write latency is that
+  of a rotating disk, FLUSH_NEIGHBORS_OFF on devices without seek cost. */
+  FLUSH_NEIGHBORS_AUTO
+};
+
+/** With FLUSH_NEIGHBORS_AUTO the flush area is used while the average data
+file write latency is at least this, i.e., while a write includes a seek. */
+constexpr std::chrono::microseconds FLUSH_NEIGHBORS_SEEK_LATENCY{1000};
+
 struct Buf_flush {
-  /** Number of intervals for which we keep the history of these stats.
-  Each interval is 1 second, defined by the rate at which
-  srv_error_monitor_thread() calls buf_pool->m_flusher->stat_update(). */
-  static constexpr ulint STAT_N_INTERVAL = 20;
+  /** Consecutive pages that are written in place with one vectored write. */
+  struct Write_run;
 
   /** Constructor
    * 
    * @param buf_pool The buffer pool.
    */
-  explicit Buf_flush(Buf_pool *buf_pool) : m_buf_pool(buf_pool) {}
+  explicit Buf_flush(Buf_pool_instance *buf_pool) : m_buf_pool(buf_pool) {}
 
   /**
   * Remove a block from the flush list of modified blocks.
@@ -80,13 +105,22 @@ struct Buf_flush {
    */
   void free_margin(DBLWR *dblwr);
 
+  /**
+   * Makes sure that there is a margin of replaceable pages at the end of the
+   * LRU list. If the page cleaner is running, it is only woken up when the free
+   * list is running short, otherwise the calling thread does the flushing.
+   *
+   * @param[in,out] dblwr The doublewrite buffer to use
+   */
+  void request_free_margin(DBLWR *dblwr);
+
   /**
    * Initializes a page for writing to the tablespace.
    *
    * @param page The page to initialize.
    * @param newest_lsn The newest modification LSN to the page.
    */
-  void init_for_writing(byte *page, uint64_t newest_lsn);
+  static void init_for_writing(byte *page, uint64_t newest_lsn);
 
   /**
    * This utility flushes dirty blocks from the end of the LRU list or flush_list.
@@ -132,21 +166,16 @@ struct Buf_flush {
   bool ready_for_replace(Buf_page *bpage);
 
   /**
-   * @brief Update the historical stats that we are collecting for flush rate
-   * heuristics at the end of each interval.
-   */
-  void stat_update();
-
-  /**
-   * @brief Determines the fraction of dirty pages that need to be flushed based
-   * on the speed at which we generate redo log. Note that if redo log
-   * is generated at significant rate without a corresponding increase
-   * in the number of dirty pages (for example, an in-memory workload)
-   * it can cause IO bursts of flushing. This function implements heuristics
-   * to avoid this burstiness.
-   * @return Number of dirty pages to be flushed per second.
+   * @brief Counts the pages at the end of the flush list whose oldest
+   * modification is below a limit, that is the pages that must be flushed
+   * for the oldest modification of this instance to reach the limit.
+   *
+   * @param[in] lsn_limit       Count the pages modified before this LSN.
+   * @param[in] max_pages       Stop counting at this number of pages.
+   *
+   * @return Number of pages, at most max_pages.
    */
-  ulint get_desired_flush_rate();
+  [[nodiscard]] ulint get_n_pages_older_than(lsn_t lsn_limit, ulint max_pages) const;
 
 #if defined UNIV_DEBUG
   /** Validates the flush list.
@@ -166,7 +195,9 @@ struct Buf_flush {
   void free_flush_list();
 
   /**
-   * @brief Inserts a modified block into the flush list.
+   * @brief Inserts a modified block into the flush list. The caller must own
+   * the flush list mutex. The block's oldest_modification can be smaller than
+   * that of the first block in the list by up to BUF_FLUSH_LIST_SLACK.
    *
    * @param block The block which is modified.
    */
@@ -175,7 +206,7 @@ struct Buf_flush {
   /**
    * @brief Inserts a modified block into the flush list in the right sorted position.
    * This function is used by recovery, because there the modifications do not
-   * necessarily come in the order of lsn's.
+   * necessarily come in the order of lsn's. The caller must own the flush list mutex.
    *
    * @param block The block which is modified.
    */
@@ -184,7 +215,8 @@ struct Buf_flush {
   /**
    * @brief This function should be called at a mini-transaction commit, if a page was
    * modified in it. Puts the block to the list of modified blocks, if it is not
-   * already in it.
+   * already in it. Only the flush list mutex is acquired, the X-latch on the block
+   * keeps the flushers away.
    *
    * @param block The block which is modified.
    * @param mtr The mini-transaction.
@@ -195,7 +227,6 @@ struct Buf_flush {
   #ifdef UNIV_SYNC_DEBUG
     ut_ad(rw_lock_own(&block->m_lock, RW_LOCK_EX));
   #endif /* UNIV_SYNC_DEBUG */
-    ut_ad(mutex_own(&m_buf_pool->m_mutex));
   
     ut_ad(mtr->m_start_lsn != 0);
     ut_ad(mtr->m_modifications);
@@ -204,16 +235,20 @@ struct Buf_flush {
     block->m_page.m_newest_modification = mtr->m_end_lsn;
   
     if (!block->m_page.m_oldest_modification) {
+
+      m_buf_pool->flush_list_mutex_acquire();
   
       block->m_page.m_oldest_modification = mtr->m_start_lsn;
       ut_ad(block->m_page.m_oldest_modification != 0);
   
       insert_into_flush_list(block);
+
+      m_buf_pool->flush_list_mutex_release();
     } else {
       ut_ad(block->m_page.m_oldest_modification <= mtr->m_start_lsn);
     }
   
-    ++m_buf_pool->m_write_requests;
+    m_buf_pool->m_write_requests.fetch_add(1, std::memory_order_relaxed);
   }
   
   /**
@@ -232,7 +267,7 @@ struct Buf_flush {
     ut_ad(rw_lock_own(&(block->lock), RW_LOCK_EX));
   #endif /* UNIV_SYNC_DEBUG */
   
-    m_buf_pool->mutex_acquire();
+    m_buf_pool->flush_list_mutex_acquire();
   
     ut_ad(block->m_page.m_newest_modification <= end_lsn);
   
@@ -249,14 +284,14 @@ struct Buf_flush {
       ut_ad(block->m_page.m_oldest_modification <= start_lsn);
     }
   
-    m_buf_pool->mutex_release();
+    m_buf_pool->flush_list_mutex_release();
   }
 
   /** When free_margin is called, it tries to make this many blocks
   available to replacement in the free list and at the end of the LRU list (to
   make sure that a read-ahead batch can be read efficiently in a single sweep). */
   auto get_free_block_margin() const {
-    return 5 + srv_buf_pool->get_read_ahead_area();
+    return 5 + m_buf_pool->get_read_ahead_area();
   }
 
   /** Extra margin to apply above the free block margin */
@@ -265,27 +300,11 @@ struct Buf_flush {
   }
 
 #if defined UNIV_DEBUG
-  /** Validates the flush list.
+  /** Validates the flush list, the caller must own the flush list mutex.
   @return	true if ok */
   bool validate_low();
 #endif /* UNIV_DEBUG */
 
-  /** @brief Statistics for selecting flush rate based on redo log
-  generation speed.
-
-  These statistics are generated for heuristics used in estimating the
-  rate at which we should flush the dirty blocks to avoid bursty IO
-  activity. Note that the rate of flushing not only depends on how many
-  dirty pages we have in the buffer pool but it is also a fucntion of
-  how much redo the workload is generating and at what rate. */
-  struct Stat {
-    /** Amount of redo generated. */
-    uint64_t m_redo{};
-  
-    /** Number of pages flushed. */
-    ulint m_n_flushed{};
-  };
-
 private:
   /**
    * @brief Insert a block in the m_recovery_flush_list and returns a pointer to its predecessor or nullptr if no predecessor.
@@ -321,8 +340,8 @@ private:
   void sync_datafiles();
 
   /**
-   * @brief Flushes possible buffered writes from the doublewrite memory buffer to disk,
-   * and also wakes up the aio thread if simulated aio is used.
+   * @brief Flushes possible buffered writes from the doublewrite slot of this
+   * buffer pool instance to disk, and also wakes up the aio thread if simulated aio is used.
    * It is very important to call this function after a batch of writes has been posted,
    * and also when we may have to wait for a page latch! Otherwise a deadlock of threads can occur.
    * 
@@ -331,7 +350,24 @@ private:
   void buffered_writes(DBLWR *dblwr);
 
   /**
-   * @brief Posts a buffer page for writing. If the doublewrite memory buffer is full,
+   * @return the flush_neighbors mode to use for the next flush,
+   * FLUSH_NEIGHBORS_AUTO is resolved from the measured write latency.
+   */
+  [[nodiscard]] static flush_neighbors_t get_neighbors_mode() noexcept;
+
+  /**
+   * @brief Checks if a neighbor of a page that is flushed can be flushed
+   * with it. The caller must hold the buffer pool mutex.
+   *
+   * @param space The space id.
+   * @param page_no The page number of the neighbor.
+   * @param flush_type The flush type (BUF_FLUSH_LRU or BUF_FLUSH_LIST).
+   * @return true if the neighbor is dirty and can be flushed without a wait.
+   */
+  [[nodiscard]] bool is_flushable_neighbor(space_id_t space, page_no_t page_no, buf_flush flush_type);
+
+  /**
+   * @brief Posts a buffer page for writing. If the doublewrite slot of this instance is full,
    * calls buf_pool->m_flusher->buffered_writes and waits for for free space to appear.
    *
    * @param bpage The buffer block to write.
@@ -344,8 +380,10 @@ private:
    * 
    * @param[in,out] dblwr The doublewrite buffer to use
    * @param bpage The buffer block to write.
+   * @param run If not nullptr and the page is written in place, the write
+   *   is added to the run instead of being posted, the caller submits it.
    */
-  void write_block_low(DBLWR *dblwr, Buf_page *bpage);
+  void write_block_low(DBLWR *dblwr, Buf_page *bpage, Write_run *run = nullptr);
 
   /**
    * @brief Writes a flushable page asynchronously from the buffer pool to a file.
@@ -355,11 +393,14 @@ private:
    * @param[in,out] dblwr Doublewrite buffer to use
    * @param bpage The buffer control block.
    * @param flush_type The flush type.
+   * @param run The pending vectored write to add the page to, or nullptr.
    */
-  void page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type);
+  void page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type, Write_run *run = nullptr);
 
   /**
-   * @brief Flushes to disk all flushable pages within the flush area.
+   * @brief Flushes to disk the flushable pages within the flush area, which
+   * of them depends on the flush_neighbors mode. Consecutive pages that are
+   * written in place are posted as one vectored write.
    * 
    * @param[in,out] dblwr The doublewrite buffer
    * @param space The space id.
@@ -390,25 +431,200 @@ private:
   /**
    * @brief The buffer pool.
    */
-  Buf_pool *m_buf_pool{};
+  Buf_pool_instance *m_buf_pool{};
 
-  /** Sampled values buf_pool->m_flusher->stat_cur.
-  Not protected by any mutex.  Updated by buf_pool->m_flusher->stat_update(). */
-  std::array<Stat, STAT_N_INTERVAL> m_stats{};
+/* @} */
 
-  /** Cursor to m_stats[]. Updated in a round-robin fashion. */
-  ulint m_stat_ind{};
+};
 
-  /** Values at start of the current interval. Reset by stat_update(). */
-  Stat m_stat_cur;
+/** @brief The page cleaner.
+
+A coordinator thread plus a number of worker threads that flush the buffer
+pool instances in the background. Once a second, or earlier when a user
+thread finds that the free list of an instance is running short, the
+coordinator starts a round. In a round every buffer pool instance is handled
+by exactly one thread, the coordinator included:
+
+  1. the LRU tail is flushed to establish the free block margin,
+  2. clean blocks at the LRU tail are moved to the free list until the
+     free block target is reached, so that Buf_LRU::get_free_block() rarely
+     has to search the LRU list or flush in the foreground,
+  3. at most once a second, dirty pages are flushed from the flush list to
+     keep the modified page ratio and the checkpoint age in check.
+
+The number of pages flushed in step 3 is chosen by the adaptive flushing
+controller, see get_flush_list_targets(). It looks at the smoothed rate of
+redo generation, the age of the oldest modification against the preflush
+thresholds of the redo log and the modified page ratio. The flushing rate
+ramps up smoothly as the checkpoint age grows, so that the user threads
+rarely hit the synchronous preflush in Log::checkpoint_margin(). */
+struct Page_cleaner {
+  /** Number of flush list rounds over which the redo generation rate and the
+  page flushing rate are averaged. */
+  static constexpr ulint FLUSH_AVG_ROUNDS = 30;
+
+  /** Percentage of the redo log capacity at which the checkpoint age starts
+  to drive the flushing. */
+  static constexpr ulint ADAPTIVE_FLUSHING_LWM = 10;
+
+  /** Upper bound on the pages flushed from the flush lists per second, as a
+  percentage of io_capacity. */
+  static constexpr ulint MAX_IO_PCT = 200;
+
+  /** The flushing backs off when the foreground reads take this many times
+  their usual latency. */
+  static constexpr ulint READ_LATENCY_THROTTLE = 2;
 
-  /** Running sum of past values of buf_pool->m_flusher->stat_cur.
-  Updated by buf_pool->m_flusher->stat_update(). Not protected by any mutex. */
-  Stat m_stat_sum;
+  /**
+   * Constructor.
+   *
+   * @param[in] n_threads       Total number of threads, including the coordinator.
+   */
+  explicit Page_cleaner(ulint n_threads) noexcept;
 
-  /** Number of pages flushed through non m_flush_list flushes. */
-  ulint m_LRU_flush_page_count{};
+  /** Destructor. The threads must have been shut down. */
+  ~Page_cleaner() noexcept;
 
-/* @} */
+  /**
+   * Creates an instance of the page cleaner, the threads are not started.
+   *
+   * @param[in] n_threads       Total number of threads, including the coordinator.
+   * @return the page cleaner instance or nullptr if out of memory.
+   */
+  [[nodiscard]] static Page_cleaner *create(ulint n_threads) noexcept;
+
+  /**
+   * Destroys a page cleaner instance.
+   *
+   * @param[in,out] page_cleaner Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Page_cleaner *&page_cleaner) noexcept;
+
+  /** Starts the coordinator and the worker threads. */
+  void start() noexcept;
+
+  /** Signals the threads to exit and waits until they have exited. */
+  void shutdown() noexcept;
+
+  /** Wakes up the coordinator to start a new round. */
+  void wakeup() noexcept;
 
+  /** @return true if the page cleaner threads are running. */
+  [[nodiscard]] bool is_running() const noexcept {
+    return m_running.load(std::memory_order_acquire);
+  }
+
+ private:
+  /** The coordinator thread. */
+  void coordinator() noexcept;
+
+  /** A worker thread. */
+  void worker() noexcept;
+
+  /**
+   * @return the percentage of io_capacity to flush because of the modified page ratio.
+   */
+  [[nodiscard]] ulint get_pct_for_dirty() const noexcept;
+
+  /**
+   * @param[in] age             Age of the oldest modification in the buffer pool.
+   *
+   * @return the percentage of io_capacity to flush because of the checkpoint age.
+   */
+  [[nodiscard]] ulint get_pct_for_age(lsn_t age) const noexcept;
+
+  /**
+   * Updates the smoothed redo generation and page flushing rates and sets the
+   * number of pages to flush from the flush list of each buffer pool instance
+   * in the next round.
+   *
+   * @param[in] now             Current time in milliseconds.
+   *
+   * @return the total number of pages to flush from the flush lists.
+   */
+  ulint get_flush_list_targets(ulint now) noexcept;
+
+  /**
+   * Reduces the number of pages to flush while the foreground reads are slower
+   * than usual, the flush writes compete with them for the disk. Nothing is
+   * reduced when the modified page ratio or the checkpoint age is at its limit.
+   *
+   * @param[in] n_pages         Number of pages to flush.
+   * @param[in] pct_for_dirty   See get_pct_for_dirty().
+   * @param[in] pct_for_age     See get_pct_for_age().
+   *
+   * @return the number of pages to flush.
+   */
+  [[nodiscard]] ulint throttle_for_reads(ulint n_pages, ulint pct_for_dirty, ulint pct_for_age) const noexcept;
+
+  /** Runs a round over all the buffer pool instances and waits until it ends. */
+  void run_round() noexcept;
+
+  /** Processes buffer pool instances of the current round until there are none left. */
+  void process_instances() noexcept;
+
+  /**
+   * Flushes one buffer pool instance.
+   *
+   * @param[in,out] buf_pool    Buffer pool instance to flush.
+   * @param[in] n_flush_list    Number of pages to flush from the flush list.
+   */
+  void flush_instance(Buf_pool_instance *buf_pool, ulint n_flush_list) noexcept;
+
+ private:
+  /** Total number of threads, including the coordinator. */
+  const ulint m_n_threads;
+
+  /** true while the threads are running. */
+  std::atomic<bool> m_running{};
+
+  /** Set to true to make the threads exit. */
+  std::atomic<bool> m_shutdown{};
+
+  /** The coordinator waits on this between rounds. */
+  Cond_var *m_wakeup_event{};
+
+  /** The workers wait on this for a new round to start. */
+  Cond_var *m_round_event{};
+
+  /** Set when all the instances of the round have been processed. */
+  Cond_var *m_done_event{};
+
+  /** Round counter, incremented by the coordinator to start a round. */
+  std::atomic<ulint> m_round{};
+
+  /** Index of the next buffer pool instance to process in this round. */
+  std::atomic<ulint> m_next_instance{};
+
+  /** Number of instances in this round that have not been processed yet. */
+  std::atomic<ulint> m_n_pending{};
+
+  /** Number of pages to flush from the flush list of each instance in this
+  round. Written by the coordinator before it starts the round. */
+  std::vector<ulint> m_n_flush_list{};
+
+  /** Number of pages flushed from the flush lists since the last flush list round. */
+  std::atomic<ulint> m_n_flushed{};
+
+  /** Adaptive flushing state, only accessed by the coordinator. @{ */
+
+  /** LSN at the previous flush list round. */
+  lsn_t m_prev_lsn{};
+
+  /** Time of the previous flush list round in milliseconds. */
+  ulint m_prev_time{};
+
+  /** Smoothed redo generation rate in bytes per second. */
+  double m_lsn_rate_avg{};
+
+  /** Smoothed flush list flushing rate in pages per second. */
+  double m_page_rate_avg{};
+
+  /* @} */
+
+  /** The coordinator and the worker threads. */
+  std::vector<std::thread> m_threads{};
 };
+
+/** The page cleaner, nullptr if not running. */
+extern Page_cleaner *srv_page_cleaner;
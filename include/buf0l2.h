@@ -0,0 +1,260 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/buf0l2.h
+Second level page cache on a local device for the clean pages that are
+evicted from the buffer pool.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "os0file.h"
+#include "sync0sync.h"
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Cond_var;
+
+/** The L2 page cache.
+
+The cache file, l2_cache_file, is an array of l2_cache_size / UNIV_PAGE_SIZE
+page slots. The index that maps page ids to slots is kept in memory only, the
+cache starts empty after a restart.
+
+When the LRU evicts a clean page, see Buf_LRU::free_block(), the page is
+copied to one of WRITE_QUEUE_SIZE staging buffers and is written to its slot
+by a background thread. If all the staging buffers are in use the page is not
+cached. A slot is reused in FIFO order once there are no free slots left.
+
+buf_read_page() looks up the index before reading from the data file, a page
+that is read from the cache is verified with its checksum and its page id.
+An entry is removed when its page is modified, see
+Buf_flush::insert_into_flush_list(), and when its tablespace is invalidated.
+The entries also record the version of the tablespace, so a page that was
+cached before a tablespace was dropped never matches the new tablespace that
+reuses its id. */
+struct Buf_l2_cache {
+  /** Maximum number of pages that wait to be written to the cache. */
+  static constexpr ulint WRITE_QUEUE_SIZE = 64;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] path            Path of the cache file.
+   * @param[in] file            The open cache file.
+   * @param[in] n_slots         Number of pages in the cache.
+   */
+  Buf_l2_cache(const char *path, os_file_t file, ulint n_slots) noexcept;
+
+  /** Destructor. The thread must have been shut down. */
+  ~Buf_l2_cache() noexcept;
+
+  /**
+   * Creates the cache file and an instance, the thread is not started.
+   *
+   * @return the instance or nullptr if the cache is not configured or the
+   *  file cannot be created.
+   */
+  [[nodiscard]] static Buf_l2_cache *create() noexcept;
+
+  /**
+   * Destroys an instance and closes the cache file.
+   *
+   * @param[in,out] l2_cache    Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Buf_l2_cache *&l2_cache) noexcept;
+
+  /** Starts the background thread that writes the pages to the cache file. */
+  void start() noexcept;
+
+  /** Stops the background thread, the queued writes are dropped. */
+  void shutdown() noexcept;
+
+  /**
+   * Queues a clean page that is evicted from the buffer pool for writing
+   * to the cache. The page is copied, the frame can be reused on return.
+   * Must not be called with a buffer pool or block mutex held.
+   *
+   * @param[in] space           Tablespace id of the page.
+   * @param[in] page_no         Page number.
+   * @param[in] frame           The page frame, the page id fields in the
+   *                            header can have been wiped.
+   */
+  void insert(space_id_t space, page_no_t page_no, const byte *frame) noexcept;
+
+  /**
+   * Reads a page from the cache.
+   *
+   * @param[in] space           Tablespace id of the page.
+   * @param[in] page_no         Page number.
+   * @param[in] tablespace_version Version of the tablespace the page is read for.
+   * @param[out] frame          Where to read the page.
+   *
+   * @return true if the page was read, false if it is not in the cache.
+   */
+  [[nodiscard]] bool read(space_id_t space, page_no_t page_no, int64_t tablespace_version, byte *frame) noexcept;
+
+  /**
+   * Removes a page from the cache, e.g., because it is modified.
+   *
+   * @param[in] space           Tablespace id of the page.
+   * @param[in] page_no         Page number.
+   */
+  void invalidate(space_id_t space, page_no_t page_no) noexcept;
+
+  /**
+   * Removes all the pages of a tablespace from the cache.
+   *
+   * @param[in] space           Tablespace id.
+   */
+  void invalidate_tablespace(space_id_t space) noexcept;
+
+  /** @return the number of pages read from the cache. */
+  [[nodiscard]] ulint get_n_hits() const noexcept {
+    return m_n_hits.load(std::memory_order_relaxed);
+  }
+
+  /** @return the number of pages written to the cache. */
+  [[nodiscard]] ulint get_n_writes() const noexcept {
+    return m_n_writes.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /** State of a cache slot. */
+  enum class Slot_state : uint8_t {
+    /** Not mapped to a page. */
+    FREE,
+
+    /** Mapped, the page is queued or being written. */
+    WRITING,
+
+    /** Mapped, the slot contains the page. */
+    VALID
+  };
+
+  /** A page slot of the cache file. */
+  struct Slot {
+    /** The page in the slot. */
+    Page_id m_page_id{};
+
+    /** Version of the tablespace of the page when it was cached. */
+    int64_t m_tablespace_version{};
+
+    /** Incremented when the slot is remapped or freed, to detect that a
+    write or a read without the mutex raced with it. */
+    uint64_t m_seq{};
+
+    Slot_state m_state{Slot_state::FREE};
+  };
+
+  /** A page that waits to be written to its slot. */
+  struct Write {
+    /** Slot to write to. */
+    ulint m_slot{ULINT_UNDEFINED};
+
+    /** The value of Slot::m_seq when the write was queued. */
+    uint64_t m_seq{};
+
+    /** Copy of the page, UNIV_PAGE_SIZE aligned. */
+    byte *m_buf{};
+  };
+
+  /** The background thread. */
+  void run() noexcept;
+
+  /**
+   * Unmaps a slot. The caller must own m_mutex.
+   *
+   * @param[in] slot_no         Slot to free.
+   */
+  void free_slot(ulint slot_no) noexcept;
+
+  /**
+   * Takes a free slot, or the oldest mapped one. The caller must own m_mutex.
+   *
+   * @return the slot number
+   */
+  [[nodiscard]] ulint get_slot() noexcept;
+
+  /** @return the file offset of a slot. */
+  [[nodiscard]] static off_t slot_offset(ulint slot_no) noexcept {
+    return off_t(slot_no) * off_t(UNIV_PAGE_SIZE);
+  }
+
+  /** @return true if the thread should exit. */
+  [[nodiscard]] bool is_shutdown() const noexcept {
+    return m_shutdown.load(std::memory_order_acquire);
+  }
+
+ private:
+  /** Path of the cache file. */
+  std::string m_path{};
+
+  /** The cache file. */
+  os_file_t m_file{};
+
+  /** Protects the fields below. */
+  mutex_t m_mutex{};
+
+  /** The page slots of the cache file. */
+  std::vector<Slot> m_slots{};
+
+  /** The slot of each cached page. */
+  Page_id_hash<ulint> m_index{};
+
+  /** Slots that are not mapped to a page. */
+  std::vector<ulint> m_free{};
+
+  /** The next slot to reuse when there are no free slots. */
+  ulint m_hand{};
+
+  /** Pages to write, a ring buffer of WRITE_QUEUE_SIZE entries. */
+  std::array<Write, WRITE_QUEUE_SIZE> m_queue{};
+
+  /** Position of the first queued write in m_queue. */
+  ulint m_queue_first{};
+
+  /** Number of queued writes. */
+  ulint m_queue_len{};
+
+  /** Memory of the staging buffers of m_queue. */
+  byte *m_write_buf_ptr{};
+
+  /** Number of pages read from the cache. */
+  std::atomic<ulint> m_n_hits{};
+
+  /** Number of pages written to the cache. */
+  std::atomic<ulint> m_n_writes{};
+
+  /** Set to true to make the thread exit. */
+  std::atomic<bool> m_shutdown{};
+
+  /** Set when a write is queued and on shutdown. */
+  Cond_var *m_event{};
+
+  /** The writer thread. */
+  std::thread m_thread{};
+};
+
+/** The L2 page cache, nullptr if it is not configured. */
+extern Buf_l2_cache *srv_buf_l2;
@@ -29,6 +29,8 @@ Created 11/5/1995 Heikki Tuuri
 #include "buf0types.h"
 #include "ut0byte.h"
 
+#include <atomic>
+
 struct Buf_LRU {
 
   /** Number of intervals for which we keep the history of these stats.
@@ -81,7 +83,7 @@ struct Buf_LRU {
 
   /** Constructor
   @param[in] old_threshold_ms   Move the blocks to the "new" list after this threshold. */
-  explicit Buf_LRU(Buf_pool *buf_pool)
+  explicit Buf_LRU(Buf_pool_instance *buf_pool)
     : m_buf_pool(buf_pool),
       m_old_ratio(s_old_ratio),
       m_old_threshold_ms(s_old_threshold_ms) {}
@@ -105,11 +107,28 @@ struct Buf_LRU {
    */
   bool buf_pool_running_out();
 
-  /** Invalidates all pages belonging to a given tablespace when we are deleting
-  the data file(s) of tHat tablespace. A PROBLEM: if readahead is being started,
-  what guarantees that it will not try to read in pages after this operation has
-  completed? */
-  void invalidate_tablespace(space_id_t space_id); /*!< in: space id */
+  /** Number of pages of the LRU list sweep_dropped() looks at with the
+  buf_pool mutex held. */
+  static constexpr ulint SWEEP_BATCH = 256;
+
+  /** Requests that the pages of a dropped tablespace are freed, returns
+  immediately. The pages can't be found after the drop, sweep_dropped() frees
+  them later if the LRU eviction hasn't done it by then. */
+  void request_sweep() noexcept {
+    m_n_sweep_requests.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Frees the pages of the dropped tablespaces. A sweep walks the LRU list
+   * from the end, SWEEP_BATCH pages at a time, and releases the buf_pool
+   * mutex between the batches. Each request_sweep() starts a new sweep once
+   * the current one has reached the start of the list.
+   *
+   * @param[in] max_batches     Maximum number of batches to do.
+   *
+   * @return the number of pages freed.
+   */
+  ulint sweep_dropped(ulint max_batches) noexcept;
 
   /**
    * Try to free a block. If bpage is a descriptor of a compressed-only page, the
@@ -211,8 +230,8 @@ struct Buf_LRU {
   #endif /* UNIV_DEBUG */
   
   /** Maximum LRU list search length in buf_pool->m_flusher->LRU_recommendation() */
-  static ulint get_free_search_len () {
-    return 5 + 2 * srv_buf_pool->get_read_ahead_area();
+  ulint get_free_search_len() const {
+    return 5 + 2 * m_buf_pool->get_read_ahead_area();
   }
 
   /** Increments the I/O counter in buf_LRU_stat_cur. */
@@ -275,6 +294,14 @@ private:
   @return	true if freed */
   bool free_from_common_LRU_list(ulint n_iterations);
 
+  /** Checks if a page at the end of the LRU list should get another lap
+  instead of being evicted: non-leaf B-tree pages are kept in the buffer pool
+  while they use at most lru_protected_pct of the LRU list.
+  @param[in] bpage              Page in the LRU list, its block mutex is held.
+  @param[in] n_iterations       See free_from_common_LRU_list().
+  @return true if the page should not be evicted now */
+  bool is_protected(Buf_page *bpage, ulint n_iterations);
+
   /** Moves the LRU_old pointer so that the length of the old blocks list
   is inside the allowed limits. */
   void old_adjust_len();
@@ -309,7 +336,7 @@ private:
   /** @name Heuristics for detecting index scan @{ */
 
   /** The buffer pool. */
-  Buf_pool *m_buf_pool{};
+  Buf_pool_instance *m_buf_pool{};
 
   /** Reserve this much/OLD_RATIO_DIV of the buffer pool for "old" blocks.
   Protected by buf_pool_mutex. */
@@ -329,6 +356,22 @@ private:
   frames in the buffer pool, we set this to true */
   bool m_switched_on_monitor{};
 
+  /** Number of pages in the LRU list with Buf_page::m_protected set.
+  Protected by buf_pool_mutex. */
+  ulint m_n_protected{};
+
+  /** Number of times request_sweep() was called. */
+  std::atomic<ulint> m_n_sweep_requests{};
+
+  /** Value of m_n_sweep_requests when the current sweep started. Protected
+  by buf_pool_mutex. */
+  ulint m_n_sweeps_started{};
+
+  /** The page the current sweep continues at, nullptr when no sweep is in
+  progress. remove_block() moves it to the previous page when it removes this
+  one. Protected by buf_pool_mutex. */
+  Buf_page *m_sweep_pos{};
+
 public:
 
   /** Current operation counters. Not protected by any mutex. Cleared by stat_update(). */
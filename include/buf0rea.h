@@ -41,6 +41,19 @@ Created 11/5/1995 Heikki Tuuri
  */
 bool buf_read_page(ulint space, ulint offset);
 
+/**
+ * @brief Starts an asynchronous read of a page, if it is not in the buffer
+ *        pool already, and invokes a callback once the page can be accessed
+ *        without waiting for its read. The callback is invoked from the IO
+ *        completion, or from this function if the page is already readable,
+ *        could not be read or the read completed synchronously.
+ *
+ * @param space The space id.
+ * @param page_no The page number.
+ * @param callback Invoked once, it must not block.
+ */
+void buf_read_page_async(space_id_t space, page_no_t page_no, std::function<void()> callback);
+
 /**
  * @brief Applies linear read-ahead if the specified page is a border
  *        page of a linear read-ahead area and all the pages in the area
@@ -67,7 +80,50 @@ bool buf_read_page(ulint space, ulint offset);
  *  want access to this page (see NOTE 3 above).
  * @return The number of page read requests issued.
  */
-ulint buf_read_ahead_linear(Buf_pool *buf_pool, space_id_t space, page_no_t page_no);
+ulint buf_read_ahead_linear(Buf_pool_instance *buf_pool, space_id_t space, page_no_t page_no);
+
+/**
+ * @brief Applies random read-ahead if random_read_ahead is set and enough
+ *        pages of the read-ahead area of the page were accessed recently,
+ *        in any order. The missing pages of the area are read with
+ *        asynchronous reads that are submitted as a single batch.
+ *   NOTE: the calling thread may own latches on pages: to avoid deadlocks
+ *        this function must be written such that it cannot end up waiting
+ *        for these latches!
+ * @param buf_pool The buffer pool instance that owns the page.
+ * @param space The space id.
+ * @param page_no The page number of the page that was just read.
+ * @return The number of page read requests issued.
+ */
+ulint buf_read_ahead_random(Buf_pool_instance *buf_pool, space_id_t space, page_no_t page_no);
+
+/**
+ * @brief Issues asynchronous read requests for a list of pages that are
+ *        likely to be accessed soon, e.g. the next leaf pages of a range
+ *        scan. Pages that are already in the buffer pool, pages beyond the
+ *        end of the tablespace and pages of instances with too many pending
+ *        reads are skipped.
+ *   NOTE: the calling thread may own latches on pages: to avoid deadlocks
+ *        this function must be written such that it cannot end up waiting
+ *        for these latches!
+ * @param space The space id.
+ * @param page_nos The page numbers to read, in the expected access order.
+ * @param n_pages The number of page numbers in the array.
+ * @return The number of page read requests issued.
+ */
+ulint buf_read_ahead_pages(space_id_t space, const page_no_t *page_nos, ulint n_pages);
+
+/**
+ * @brief Issues asynchronous read requests for pages listed in a buffer pool
+ *        dump. Pages that are already in the buffer pool and pages that are
+ *        beyond the end of the tablespace are skipped.
+ *
+ * @param space space id
+ * @param page_nos array of page numbers to read, in ascending order
+ * @param n_pages number of page numbers in the array
+ * @return The number of page read requests issued.
+ */
+ulint buf_read_load_pages(space_id_t space, const page_no_t *page_nos, ulint n_pages);
 
 /**
  * @brief Issues read requests for pages which recovery wants to read in.
@@ -27,12 +27,20 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include "innodb0types.h"
 
+#include <array>
+#include <atomic>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
+#include <shared_mutex>
 #include <sstream>
 #include <unordered_map>
+#include <vector>
 
+#include "os0proc.h"
 #include "sync0mutex.h"
 #include "sync0rw.h"
 #include "ut0mem.h"
@@ -52,12 +60,21 @@ struct Buf_page;
 /** Buffer block for which an uncompressed page exists */
 struct Buf_block;
 
+/** Copy of the keys of a page directory, see page0cur.h */
+struct Page_dir_cache;
+
 /** Buffer pool chunk comprising buf_block_t */
 struct buf_chunk_t;
 
-/** Buffer pool comprising buf_chunk_t */
+/** Buffer pool comprising Buf_pool_instance */
 struct Buf_pool;
 
+/** Buffer pool instance comprising buf_chunk_t */
+struct Buf_pool_instance;
+
+/** Doublewrite buffer. */
+struct DBLWR;
+
 /** Buffer pool statistics struct */
 struct buf_pool_stat_t;
 
@@ -122,6 +139,16 @@ constexpr ulint BUF_KEEP_OLD = 52;
 /** The buffer pool of the database */
 extern Buf_pool *srv_buf_pool;
 
+/** Maximum number of buffer pool instances, Buf_page::m_buf_pool_index
+must be able to hold the instance number. */
+constexpr ulint MAX_BUFFER_POOLS = 64;
+
+/** The flush lists are sorted on oldest_modification within this many bytes
+of redo: a page can be linked after pages whose oldest_modification is up to
+this much larger. It must be small compared to the log group capacity, since
+the checkpoint can lag this much behind the oldest dirty page. */
+constexpr lsn_t BUF_FLUSH_LIST_SLACK = 256 * 1024;
+
 #ifdef UNIV_DEBUG
 /*! If this is set true, the program prints info whenever read or flush occurs */
 extern bool buf_debug_prints;
@@ -296,6 +323,10 @@ struct Buf_page {
 
   bool m_old;
 
+  /** index of the buffer pool instance that owns this block, set once when the
+  block is initialized; @see Buf_pool::get_instance() */
+  uint8_t m_buf_pool_index;
+
   /** the value of Buf_pool::freed_page_clock when this block was the last time
   put to the head of the LRU list; a thread is allowed to read this for
   heuristic purposes without holding any mutex or latch */
@@ -305,6 +336,25 @@ struct Buf_page {
   buffer pool */
   uint32_t m_access_time{};
 
+  /** true if the page was read by read-ahead with lazy_checksums set and its
+  checksum is verified on the first access instead of in io_complete().
+  Protected by the block mutex. */
+  bool m_verify_on_access{};
+
+  /** true if the page is in the tablespace of a temporary table, see
+  fil_space_t::m_is_temp. A mini-transaction that only modifies such pages
+  writes no redo log. Set when the page is initialized. */
+  bool m_is_temp{};
+
+  /** true if the page is a non-leaf B-tree page that was moved back to the
+  start of the LRU list instead of being evicted, see Buf_LRU::is_protected().
+  Protected by buf_pool_mutex. */
+  bool m_protected{};
+
+  /** Next page of the same vectored write while the write is pending, the
+  first page of the run is the i/o message, see Buf_pool::io_complete(). */
+  Buf_page *m_write_run_next{};
+
   /** @name Page flushing fields
   All these are protected by buf_pool_mutex. */
   /* @{ */
@@ -331,6 +381,16 @@ struct Buf_page {
 
   /* @} */
 
+  /** @name Page hash fields
+  Modified only when holding buf_pool_mutex, buf_block_t::mutex and the
+  Buf_page_hash partition latch in X mode. */
+  /* @{ */
+
+  /** next block in the same Buf_page_hash cell */
+  Buf_page *m_hash_next;
+
+  /* @} */
+
   /** @name LRU replacement algorithm fields
   These fields are protected by buf_pool_mutex only
   not the buf_block_t::mutex). */
@@ -472,8 +532,17 @@ struct Buf_block {
   NOTE that these fields are NOT protected by any semaphore! */
   /* @{ */
 
+  /** true if the adaptive hash index may have entries that point to this
+  block; set with the page latched, reset with the page x-latched, see
+  Btr_search::drop_page_hash() */
+  bool m_is_hashed;
+
   /* @} */
 
+  /** Copy of the keys of the page directory for searches, created on the
+  first search of the page, see Page_dir_cache. Freed with the block. */
+  mutable std::atomic<Page_dir_cache *> m_dir_cache;
+
 #ifdef UNIV_SYNC_DEBUG
   /** @name Debug fields */
   /* @{ */
@@ -518,15 +587,109 @@ struct buf_pool_stat_t {
   /** number of pages not made young because the first access
   was not long enough ago, in buf_page_peek_if_too_old() */
   ulint n_pages_not_made_young{};
+
+  /** Accumulate the statistics of another buffer pool instance.
+  @param[in] rhs                Statistics to add.
+  @return *this */
+  buf_pool_stat_t &operator+=(const buf_pool_stat_t &rhs) noexcept {
+    n_page_gets += rhs.n_page_gets;
+    n_pages_read += rhs.n_pages_read;
+    n_pages_written += rhs.n_pages_written;
+    n_pages_created += rhs.n_pages_created;
+    n_ra_pages_read += rhs.n_ra_pages_read;
+    n_ra_pages_evicted += rhs.n_ra_pages_evicted;
+    n_pages_made_young += rhs.n_pages_made_young;
+    n_pages_not_made_young += rhs.n_pages_not_made_young;
+    return *this;
+  }
 };
 
-/** @brief The buffer pool structure.
+/** Buffer pool usage of one index, or of the non-index pages of a
+tablespace, see Buf_pool::get_index_stats(). */
+struct Buf_index_stats {
+  /** Upper bounds, in milliseconds since the first access, of the buckets
+  of m_n_age after the "never accessed" bucket. The last bucket has no bound. */
+  static constexpr std::array<uint32_t, 5> AGE_LIMITS{1000, 10 * 1000, 60 * 1000, 10 * 60 * 1000, 60 * 60 * 1000};
 
-NOTE! The definition appears here only for other modules of this
-directory (buf) to see it. Do not use from outside! */
-struct Buf_pool {
-  using page_hash_t = Page_id_hash<Buf_page *>;
+  /** Number of buckets in m_n_age. */
+  static constexpr ulint N_AGE_BUCKETS = AGE_LIMITS.size() + 2;
+
+  /** Tablespace id */
+  space_id_t m_space_id{};
+
+  /** Index id, 0 for the pages that do not belong to an index */
+  uint64_t m_index_id{};
+
+  /** Number of pages in the buffer pool */
+  ulint m_n_pages{};
 
+  /** Number of pages that are modified but not yet flushed */
+  ulint m_n_dirty{};
+
+  /** Number of pages in the old sublist of the LRU list */
+  ulint m_n_old{};
+
+  /** Number of pages by the time since the first access: never accessed,
+  then one bucket per AGE_LIMITS entry and the rest. */
+  std::array<ulint, N_AGE_BUCKETS> m_n_age{};
+};
+
+/** Index stats keyed by (space id, index id). */
+using Buf_index_stats_map = std::map<std::pair<space_id_t, uint64_t>, Buf_index_stats>;
+
+/** A copy of the descriptor of a buffer pool block, see
+Buf_pool::visit_pages(). The fields after m_state are only set for
+BUF_BLOCK_FILE_PAGE. */
+struct Buf_page_info {
+  /** Buffer pool instance of the block */
+  ulint m_instance_no{};
+
+  /** State of the block */
+  Buf_page_state m_state{};
+
+  /** Tablespace id */
+  space_id_t m_space_id{};
+
+  /** Page number */
+  page_no_t m_page_no{};
+
+  /** FIL_PAGE_TYPE of the frame, 0 while the page is being read in */
+  uint16_t m_page_type{};
+
+  /** Index id of an index page, else 0 */
+  uint64_t m_index_id{};
+
+  /** Pending i/o, see enum buf_io_fix */
+  ulint m_io_fix{};
+
+  /** Number of threads that have the block buffer fixed */
+  ulint m_buf_fix_count{};
+
+  /** LSN of the oldest modification that is not yet flushed, 0 if clean */
+  lsn_t m_oldest_modification{};
+
+  /** LSN of the newest modification, 0 if never modified */
+  lsn_t m_newest_modification{};
+
+  /** Time of the first access, from ut_time_ms(), 0 if never accessed */
+  uint32_t m_access_time{};
+
+  /** true if the page is in the old sublist of the LRU list */
+  bool m_old{};
+
+  /** Number of pages evicted from the instance since the page was last
+  moved to the head of the LRU list. It grows as the page moves towards the
+  tail, it stands in for the position in the list which cannot be had
+  without walking the list. */
+  ulint m_LRU_age{};
+};
+
+/** @brief The buffer pool. It is split into srv_config.m_buf_pool_instances
+instances to reduce contention on the buffer pool mutex. Each page is mapped
+to exactly one instance by hashing its Page_id, see get_instance(). Requests
+that name a page, or pass a block, are routed to the owning instance, the
+rest are aggregated over all the instances. */
+struct Buf_pool {
   struct Request {
     /** RW_S_LATCH or RW_X_LATCH */
     ulint m_rw_latch{};
@@ -554,18 +717,39 @@ struct Buf_pool {
 
     /** Mini-transaction to track the latches. */
     mtr_t *m_mtr{};
+
+    /** Set by get() if the calling thread read the page from disk. */
+    bool m_read{};
   };
 
   static_assert(std::is_standard_layout<Request>::value, "Request must have a standard layout");
 
   /** Default constructor. */
-  Buf_pool();
+  Buf_pool() = default;
 
   /** Destructor. */
   ~Buf_pool() noexcept;
 
+  /**
+   * Creates the buffer pool instances. The pool size is split evenly between
+   * srv_config.m_buf_pool_instances instances.
+   *
+   * @param[in] pool_size       Total size of the buffer pool in bytes.
+   * @return true on success.
+   */
   [[nodiscard]] bool open(uint64_t pool_size);
 
+  /**
+   * Resizes the buffer pool while it is in use. Every instance grows by adding
+   * chunks, or shrinks by withdrawing the blocks of its last chunks and freeing
+   * them. The size is rounded to whole chunks. Concurrent calls are serialized.
+   *
+   * @param[in] pool_size       New total size of the buffer pool in bytes.
+   * @return true on success. On failure the instances that could not be resized
+   *  keep their old size.
+   */
+  [[nodiscard]] bool resize(uint64_t pool_size);
+
   /** Returns the number of pending buf pool ios.
   @return number of pending I/O operations */
   [[nodiscard]] ulint get_n_pending_ios();
@@ -574,10 +758,563 @@ struct Buf_pool {
   @para,[in,out] ib_stream      File write to write. */
   void print_io(ib_stream_t ib_stream);
 
+  /** Refreshes the statistics used to print per-second averages. */
+  void refresh_io_stats();
+
+  /** Asserts that all file pages in the buffer are in a replaceable state.
+  @return true */
+  [[nodiscard]] bool all_freed();
+
+  /** Checks that there currently are no pending i/o-operations for the buffer pool.
+  @return true if there is pending I/O */
+  [[nodiscard]] bool is_io_pending();
+
+  /** Invalidates the file pages in the buffer pool when an archive recovery is
+  completed. All the file pages buffered must be in a replaceable state when
+  this function is called: not latched and not modified. */
+  void invalidate();
+
   /** Returns the ratio in percents of modified pages in the buffer pool /
   database pages in the buffer pool.
-  @return modified page percentage ratio */
-  [[nodiscard]] ulint buf_get_modified_ratio_pct();
+  @return	modified page percentage ratio */
+  [[nodiscard]] ulint get_modified_ratio_pct();
+
+  /** Prepares the buffer pool for shutdown. */
+  void close();
+
+  /**
+   * Get optimistic access to a database page.
+   * @param[in,out]       Request.
+   */
+  bool try_get(Request &req);
+
+  /**
+   * This is used to get access to a known database page, when no waiting can be done.
+   *
+   * @param[in]       Get request
+   * @return          true if success
+   */
+  bool try_get_known_nowait(Request &request);
+
+  /*** Given a tablespace id and page number tries to get that page. If the page is not in
+  the buffer pool it is not loaded and nullptr is returned. Suitable for using when holding
+  the kernel mutex.
+  @param[in,out] req       Request 
+  @return page or nullptr */
+  const Buf_block *try_get_by_page_id(Request &req);
+
+  /**
+   * This is the general function used to get access to a database page.
+   *
+   * @param[in,out] req    Request
+   * @param[in] guess      Hint 
+   * 
+   * @return          pointer to the block or nullptr
+   */
+  Buf_block *get(Request &req, Buf_block *guess);
+
+  /**
+   * Initializes a page to the buffer buf_pool. The page is usually not read
+   * from a file even if it cannot be found in the buffer buf_pool.
+   *
+   * @param space     in: space id
+   * @param page_no   in: page_no of the page within space in units of a page
+   * @param mtr       in: mini-transaction handle
+   * @return          pointer to the block, page bufferfixed
+   */
+  [[nodiscard]] Buf_block *create(space_id_t space, page_no_t page_no, mtr_t *mtr);
+
+  /**
+   * Moves a page to the start of the buffer pool LRU list.
+   *
+   * @param bpage     in: buffer block of a file page
+   */
+  void make_young(Buf_page *bpage);
+
+  /**
+   * Resets the check_index_page_at_flush field of a page if found in the buffer pool.
+   *
+   * @param space     in: space id
+   * @param page_no   in: page number
+   */
+  void check_index_page_at_flush(space_id_t space, page_no_t page_no);
+
+  /**
+   * Gets the current size of the buffer pool in bytes.
+   *
+   * @return The size of the buffer pool in bytes.
+   */
+  [[nodiscard]] uint64_t get_curr_size() const { return get_curr_pages() * UNIV_PAGE_SIZE; }
+
+  /**
+   * Gets the current size of the buffer pool in pages, summed over all instances.
+   *
+   * @return The size of the buffer pool in pages.
+   */
+  [[nodiscard]] ulint get_curr_pages() const;
+
+  /**
+   * Gets a lower bound of the oldest_modification lsn of the pages in the
+   * flush lists. The pages of the mini-transactions that have written their log
+   * but not linked their pages yet are not included, see
+   * Log::buf_pool_get_oldest_modification(). Returns zero if there are no
+   * pages in the flush lists.
+   *
+   * @return The oldest modification in the pool, zero if none.
+  */
+  [[nodiscard]] uint64_t get_oldest_modification() const;
+
+  /** Allocates a buffer block. The instances are used in a round-robin fashion.
+  @return own: the allocated block, in state BUF_BLOCK_MEMORY */
+  [[nodiscard]] Buf_block *block_alloc();
+
+  /**
+   * @brief Frees a buffer block which does not contain a file page.
+   *
+   * @param block Pointer to the buffer block to be freed.
+   */
+  void block_free(Buf_block *block);
+
+  /**
+   * @brief Decrements the bufferfix count of a buffer control block and releases a latch, if specified.
+   *
+   * @param block The buffer block.
+   * @param rw_latch The type of latch (RW_S_LATCH, RW_X_LATCH, RW_NO_LATCH).
+   * @param mtr The mtr.
+   */
+  void release(Buf_block *block, ulint rw_latch, mtr_t *mtr);
+
+  /**
+   * Checks if a page is corrupt. Both the CRC32C format and the legacy
+   * format are accepted, see buf_page_calc_crc32c().
+   *
+   * @param read_buf  in: a database page
+   * @return          true if corrupted
+   */
+  [[nodiscard]] static bool is_corrupted(const byte *read_buf);
+
+  /**
+   * @brief Checks if the page can be found in the buffer pool hash table.
+   *
+   * Note that it is possible that the page is not yet read from disk.
+   *
+   * @param space_id The space id of the page.
+   * @param page_no Page number within the space
+   * @return true if found in the page hash table, false otherwise.
+   */
+  [[nodiscard]] bool peek(space_id_t space_id, page_no_t page_no);
+
+  /** Gets the current length of the free list of buffer blocks.
+  @return	length of the free list, summed over all instances */
+  [[nodiscard]] ulint get_free_list_len();
+
+  /** @return length of the LRU lists, summed over all instances. */
+  [[nodiscard]] ulint get_LRU_len() const;
+
+  /** @return length of the flush lists, summed over all instances. */
+  [[nodiscard]] ulint get_flush_list_len() const;
+
+  /** @return number of pending reads, summed over all instances. */
+  [[nodiscard]] ulint get_n_pend_reads() const;
+
+  /** @return the kind of pages backing the buffer pool, the weakest over all the chunks. */
+  [[nodiscard]] os_huge_pages_t get_huge_pages() const;
+
+  /** @return the NUMA policy of the buffer pool, OS_NUMA_OFF if any chunk
+  could not be placed as configured. */
+  [[nodiscard]] os_numa_policy_t get_numa_policy() const;
+
+  /** @return number of write requests, summed over all instances. */
+  [[nodiscard]] ulint get_write_requests() const;
+
+  /**
+   * Collects the buffer pool usage of each index. The blocks are scanned in
+   * batches of Buf_pool_instance::INDEX_STATS_BATCH, the instance mutex is
+   * released between the batches, so the result is only approximate.
+   *
+   * @return the usage sorted by (space id, index id).
+   */
+  [[nodiscard]] std::vector<Buf_index_stats> get_index_stats() const;
+
+  /**
+   * Calls the visitor with a copy of the descriptor of each block, instance
+   * by instance and chunk by chunk. The descriptors are copied in batches of
+   * Buf_pool_instance::PAGE_INFO_BATCH blocks, the visitor is called with
+   * the instance mutex released, so a page can be missed or seen twice if it
+   * is evicted and read back in meanwhile.
+   *
+   * @param[in] visitor Returns false to stop the scan.
+   *
+   * @return false if the visitor stopped the scan.
+   */
+  bool visit_pages(const std::function<bool(const Buf_page_info &)> &visitor) const;
+
+  /** @return the statistics summed over all instances. */
+  [[nodiscard]] buf_pool_stat_t get_stat() const;
+
+  /** Gets the block to whose frame the pointer is pointing to.
+  @param[in] ptr                 Pointer to a frame.
+  @return pointer to block, never nullptr */
+  [[nodiscard]] Buf_block *block_align(const byte *ptr);
+
+  /** Find out if a pointer belongs to a buf_block_t. It can be a pointer to
+  the buf_block_t itself or a member of it
+  @param[in] ptr                  Pointer not dereferenced
+  @return true if ptr belongs to a buf_block_t struct */
+  [[nodiscard]] bool pointer_is_block_field(const void *ptr);
+
+  /**
+   * Initializes a page for reading into the buffer pool instance that owns it.
+   * @see Buf_pool_instance::init_for_read().
+   *
+   * @param[out] err - Pointer to the error code (DB_SUCCESS or DB_TABLESPACE_DELETED).
+   * @param space - The space id.
+   * @param page_no - The page number.
+   * @param[in] tablespace_version - Prevents reading from a wrong version of the tablespace.
+   * @return Pointer to the block or nullptr.
+   */
+  Buf_page *init_for_read(db_err *err, space_id_t space, page_no_t page_no, int64_t tablespace_version);
+
+  /**
+   * @brief Completes an asynchronous read or write request of a file page to or from the buffer pool.
+   * The pages of a vectored write are completed together, see Buf_page::m_write_run_next.
+   * 
+   * @param bpage Pointer to the block in question.
+   */
+  void io_complete(Buf_page *bpage);
+
+  /**
+   * Registers a callback that io_complete() invokes when the read of a page
+   * completes. The caller must start the read, or wake the waiters itself if
+   * the page turns out to be readable already, see is_read_pending().
+   *
+   * @param[in] space           Tablespace ID.
+   * @param[in] page_no         Page number.
+   * @param[in] callback        Invoked once, it must not block.
+   */
+  void add_read_waiter(space_id_t space, page_no_t page_no, std::function<void()> callback);
+
+  /**
+   * Invokes and removes the callbacks registered for a page.
+   *
+   * @param[in] space           Tablespace ID.
+   * @param[in] page_no         Page number.
+   */
+  void wake_read_waiters(space_id_t space, page_no_t page_no);
+
+  /**
+   * Checks if a page is being read into the buffer pool. The read completion
+   * of io_complete() is ordered with this check by the buffer pool mutex.
+   *
+   * @param[in] space           Tablespace ID.
+   * @param[in] page_no         Page number.
+   * @return true if the page is in the page hash and its read has not completed.
+   */
+  [[nodiscard]] bool is_read_pending(space_id_t space, page_no_t page_no);
+
+  /**
+   * Checks if a page can be accessed without waiting for a read, i.e. it is
+   * in the buffer pool and its read has completed.
+   *
+   * @param[in] space           Tablespace ID.
+   * @param[in] page_no         Page number.
+   * @return true if the page is readable.
+   */
+  [[nodiscard]] bool is_readable(space_id_t space, page_no_t page_no) {
+    return peek(space, page_no) && !is_read_pending(space, page_no);
+  }
+
+  /**
+   * Flushes dirty blocks from the end of the LRU lists or the flush lists of all
+   * the instances. The min_n target is split evenly between the instances.
+   * @see Buf_flush::batch().
+   *
+   * @param[in,out] dblwr       Doublewrite buffer to use
+   * @param flush_type          BUF_FLUSH_LRU or BUF_FLUSH_LIST
+   * @param min_n               wished minimum number of blocks flushed
+   * @param lsn_limit           In the case BUF_FLUSH_LIST all blocks whose oldest_modification
+   *                            is smaller than this should be flushed
+   *
+   * @return number of blocks for which the write request was queued; ULINT_UNDEFINED if
+   *         an lsn_limit was given and a flush of the same type was already running
+   *         in at least one of the instances
+   */
+  ulint flush_batch(DBLWR *dblwr, buf_flush flush_type, ulint min_n, uint64_t lsn_limit);
+
+  /**
+   * Waits until the flush batches of the given type end in all the instances.
+   *
+   * @param type The type of flush batch to wait for (BUF_FLUSH_LRU or BUF_FLUSH_LIST).
+   */
+  void wait_batch_end(buf_flush type);
+
+  /**
+   * Flushes pages from the end of the LRU lists of all the instances if there
+   * is too small a margin of replaceable pages there.
+   *
+   * @param[in,out] dblwr The doublewrite buffer to use
+   */
+  void free_margin(DBLWR *dblwr);
+
+  /** Update the LRU eviction statistics of all the instances. */
+  void stat_update();
+
+  /**
+   * Requests that the pages of a dropped tablespace are freed from all the
+   * instances, see Buf_LRU::request_sweep(). Returns immediately.
+   *
+   * @param[in] space_id        The dropped tablespace.
+   */
+  void invalidate_tablespace(space_id_t space_id);
+
+  /** Frees some of the pages of the dropped tablespaces in each instance,
+  see Buf_LRU::sweep_dropped(). Called once a second. */
+  void sweep_dropped();
+
+  /**
+   * Returns true if less than 25 % of the buffer pool is available.
+   * @see Buf_LRU::buf_pool_running_out().
+   *
+   * @return true if less than 25 % of buffer pool left
+   */
+  [[nodiscard]] bool running_out();
+
+  /**
+   * Updates the old blocks ratio of the LRU lists of all the instances.
+   * @see Buf_LRU::old_ratio_update().
+   *
+   * @param old_pct Reserve this percentage of the buffer pool for "old" blocks.
+   * @param adjust True to adjust the LRU lists.
+   * @return The updated old_pct.
+   */
+  ulint old_ratio_update(ulint old_pct, bool adjust);
+
+  /**
+   * @brief This function should be called when recovery has modified a buffer page.
+   * @see Buf_flush::recv_note_modification().
+   *
+   * @param block The block which is modified.
+   * @param start_lsn The start LSN of the first MTR in a set of MTRs.
+   * @param end_lsn The end LSN of the last MTR in the set of MTRs.
+   */
+  void recv_note_modification(Buf_block *block, uint64_t start_lsn, uint64_t end_lsn);
+
+  /** Frees up the recovery flush_list of all the instances. */
+  void free_flush_list();
+
+  /** @return the number of buffer pool instances. */
+  [[nodiscard]] ulint get_n_instances() const noexcept {
+    return m_instances.size();
+  }
+
+  /**
+   * @param[in] i               Instance number.
+   * @return the buffer pool instance with index i.
+   */
+  [[nodiscard]] Buf_pool_instance *get_instance_at(ulint i) const noexcept {
+    ut_ad(i < m_instances.size());
+    return m_instances[i].get();
+  }
+
+  /**
+   * Maps a page to the buffer pool instance that owns it. All the pages in
+   * an aligned area of 64 pages map to the same instance, so that linear
+   * read-ahead and neighbour flushing stay within one instance.
+   *
+   * @param[in] space_id        Tablespace ID.
+   * @param[in] page_no         Page number.
+   * @return the buffer pool instance that owns the page.
+   */
+  [[nodiscard]] Buf_pool_instance *get_instance(space_id_t space_id, page_no_t page_no) const noexcept;
+
+  /**
+   * @param[in] bpage           Control block.
+   * @return the buffer pool instance that owns the block.
+   */
+  [[nodiscard]] Buf_pool_instance *get_instance(const Buf_page *bpage) const noexcept {
+    return get_instance_at(bpage->m_buf_pool_index);
+  }
+
+#ifdef UNIV_DEBUG
+  /** Prints info of the buffer pool data structure. */
+  void print();
+
+  /**
+   * Sets file_page_was_freed true if the page is found in the buffer pool.
+   *
+   * @param space     in: space id
+   * @param page_no   in: page number
+   * @return          control block if found in page hash table, otherwise nullptr
+   */
+  Buf_page *set_file_page_was_freed(space_id_t space, page_no_t page_no);
+
+  /** Returns the number of latched pages in the buffer pool.
+  @return        number of latched pages */
+  ulint get_latched_pages_number();
+
+  /** Check the state of all the buffer pool instances.
+  @return true if they are consistent. */
+  bool validate();
+#endif /* UNIV_DEBUG */
+
+ private:
+  /** The buffer pool instances. */
+  std::vector<std::unique_ptr<Buf_pool_instance>> m_instances{};
+
+  /** Round-robin cursor used by block_alloc(). */
+  std::atomic<ulint> m_next_alloc{};
+
+  /** Serializes resize() calls. */
+  std::mutex m_resize_mutex{};
+
+  /** Number of entries in m_read_waiters, read without the mutex by io_complete(). */
+  std::atomic<ulint> m_n_read_waiters{};
+
+  /** Protects m_read_waiters. */
+  std::mutex m_read_waiters_mutex{};
+
+  /** Callbacks of add_read_waiter(), by page id. */
+  std::unordered_multimap<Page_id, std::function<void()>, Page_id::Hash> m_read_waiters{};
+};
+
+/** @brief The page hash of a buffer pool instance.
+
+A fixed size chained hash table of the file pages, indexed by (space id, page
+number), the chains are linked through Buf_page::m_hash_next. The cells are
+split into N_PARTITIONS partitions, each protected by its own rw-latch, so
+that lookups do not have to acquire the buffer pool mutex.
+
+Inserts and deletes must hold the buffer pool mutex, the block mutex and the
+partition latch in X mode. A lookup must hold either the buffer pool mutex,
+see find(), or the partition latch in S mode, see find_latched(). */
+struct Buf_page_hash {
+  /** Number of partitions, must be a power of 2. */
+  static constexpr ulint N_PARTITIONS = 16;
+
+  static_assert((N_PARTITIONS & (N_PARTITIONS - 1)) == 0, "N_PARTITIONS must be a power of 2");
+
+  /** Constructor.
+  @param[in] n_cells            Minimum number of hash cells. */
+  explicit Buf_page_hash(ulint n_cells);
+
+  /** Looks up a file page. The caller must hold the buffer pool mutex.
+  @param[in] space_id           Tablespace ID.
+  @param[in] page_no            Page number.
+  @return the control block or nullptr if not found */
+  [[nodiscard]] Buf_page *find(space_id_t space_id, page_no_t page_no) const noexcept;
+
+  /** Looks up a file page, the partition of the page is S latched for the
+  duration of the lookup. The caller doesn't have to hold any mutex, but the
+  block can be evicted or reused as soon as this function returns, therefore
+  the caller must validate the page id and the state of the block under the
+  block mutex.
+  @param[in] space_id           Tablespace ID.
+  @param[in] page_no            Page number.
+  @return the control block or nullptr if not found */
+  [[nodiscard]] Buf_page *find_latched(space_id_t space_id, page_no_t page_no) const noexcept;
+
+  /** Inserts a file page. The page must not be in the hash table.
+  @param[in,out] bpage          Control block to insert. */
+  void insert(Buf_page *bpage) noexcept;
+
+  /** Removes a file page. The page must be in the hash table.
+  @param[in,out] bpage          Control block to remove. */
+  void erase(Buf_page *bpage) noexcept;
+
+ private:
+  /** A partition of the hash table, aligned to a cache line so that readers
+  latching different partitions do not share cache lines. */
+  struct alignas(hardware_destructive_interference_size) Partition {
+    /** Protects m_cells and the chains hanging off them. */
+    std::shared_mutex m_latch{};
+
+    /** Heads of the hash chains. */
+    std::vector<Buf_page *> m_cells{};
+  };
+
+  /** @return the hash value of a page.
+  @param[in] space_id           Tablespace ID.
+  @param[in] page_no            Page number. */
+  [[nodiscard]] ulint hash(space_id_t space_id, page_no_t page_no) const noexcept;
+
+  /** @return the partition that a hash value maps to.
+  @param[in] h                  Hash value returned by hash(). */
+  [[nodiscard]] Partition &get_partition(ulint h) const noexcept {
+    return m_partitions[h & (N_PARTITIONS - 1)];
+  }
+
+  /** @return the hash cell that a hash value maps to.
+  @param[in] h                  Hash value returned by hash(). */
+  [[nodiscard]] Buf_page *&get_cell(ulint h) const noexcept {
+    return get_partition(h).m_cells[h / N_PARTITIONS];
+  }
+
+  /** Walks a hash chain.
+  @param[in] h                  Hash value returned by hash().
+  @param[in] space_id           Tablespace ID.
+  @param[in] page_no            Page number.
+  @return the control block or nullptr if not found */
+  [[nodiscard]] Buf_page *find_low(ulint h, space_id_t space_id, page_no_t page_no) const noexcept;
+
+ private:
+  /** Total number of cells, a multiple of N_PARTITIONS. */
+  ulint m_n_cells{};
+
+  /** The partitions. */
+  mutable std::array<Partition, N_PARTITIONS> m_partitions{};
+};
+
+/** @brief A buffer pool instance. Each instance owns its own mutex, page hash,
+free list, LRU list and flush list. Pages are mapped to an instance by
+Buf_pool::get_instance().
+
+NOTE! The definition appears here only for other modules of this
+directory (buf) to see it. Do not use from outside! */
+struct Buf_pool_instance {
+  using Request = Buf_pool::Request;
+
+  /** Constructor.
+  @param[in] instance_no        Index of this instance in Buf_pool::m_instances. */
+  explicit Buf_pool_instance(ulint instance_no);
+
+  /** Destructor. */
+  ~Buf_pool_instance() noexcept;
+
+  /** Maximum number of chunks in an instance, the chunk descriptors are
+  allocated up front so that their addresses never change. */
+  static constexpr ulint MAX_CHUNKS = 1024;
+
+  /** Number of blocks visited by collect_index_stats() per acquisition of
+  the instance mutex. */
+  static constexpr ulint INDEX_STATS_BATCH = 256;
+
+  /** Number of blocks copied by collect_page_infos() per acquisition of
+  the instance mutex. */
+  static constexpr ulint PAGE_INFO_BATCH = 256;
+
+  /** Allocate the chunks and initialize the lists of this instance.
+  @param[in] pool_size          Size of this instance in bytes.
+  @param[in] chunk_size         Size of a chunk in bytes.
+  @return true on success. */
+  [[nodiscard]] bool open(uint64_t pool_size, uint64_t chunk_size);
+
+  /** Grows or shrinks this instance to the closest whole number of chunks.
+  The caller must not hold the buffer pool mutex.
+  @param[in] pool_size          New size of this instance in bytes.
+  @return true on success, false if the instance keeps its old size. */
+  [[nodiscard]] bool resize(uint64_t pool_size);
+
+  /** Returns the number of pending buf pool ios.
+  @return number of pending I/O operations */
+  [[nodiscard]] ulint get_n_pending_ios();
+
+  /** @return the NUMA node that the frames of this instance are bound to, or
+  ULINT_UNDEFINED if they are not bound to one node. */
+  [[nodiscard]] ulint get_numa_node() const noexcept;
+
+  /** Prints info of the buffer i/o.
+  @para,[in,out] ib_stream      File write to write. */
+  void print_io(ib_stream_t ib_stream);
 
   /** Refreshes the statistics used to print per-second averages. */
   void refresh_io_stats();
@@ -600,9 +1337,6 @@ struct Buf_pool {
   @return	modified page percentage ratio */
   ulint get_modified_ratio_pct();
 
-  /** Reset the buffer variables. */
-  void init();
-
   /** Prepares the buffer pool for shutdown. */
   void close();
 
@@ -707,14 +1441,6 @@ struct Buf_pool {
    */
   void release(Buf_block *block, ulint rw_latch, mtr_t *mtr);
 
-  /**
-   * Checks if a page is corrupt.
-   *
-   * @param read_buf  in: a database page
-   * @return          true if corrupted
-   */
-  [[nodiscard]] bool is_corrupted(const byte *read_buf);
-
   /**
    * @brief Returns the control block of a file page, nullptr if not found.
    *
@@ -738,6 +1464,22 @@ struct Buf_pool {
    */
   [[nodiscard]] Buf_block *hash_get_block(space_id_t space, page_no_t page_no);
 
+  /**
+   * @brief Looks up a file page without holding the buffer pool mutex and
+   * acquires the mutex of its block.
+   *
+   * The caller must not hold the buffer pool mutex. The page id and the state of
+   * the block are validated under the block mutex, so the block can't be evicted
+   * until the caller releases Buf_block::m_mutex.
+   *
+   * @param space The space id of the page.
+   * @param page_no Page number within the space.
+   * @param guess Block to try before the page hash lookup, or nullptr.
+   * @return The control block in state BUF_BLOCK_FILE_PAGE with its mutex held,
+   *         nullptr if the page is not in the buffer pool.
+   */
+  [[nodiscard]] Buf_block *hash_lock_block(space_id_t space, page_no_t page_no, Buf_block *guess);
+
   /**
    * @brief Checks if the page can be found in the buffer pool hash table.
    *
@@ -753,9 +1495,28 @@ struct Buf_pool {
   @return	length of the free list */
   [[nodiscard]] ulint get_free_list_len();
 
+  /** Checks the page of a block that was read with the check deferred to the
+  first access, see Buf_page::m_verify_on_access. The read must have completed.
+  @param[in,out] block          Buffer fixed block. */
+  void verify_on_access(Buf_block *block);
+
+  /** Adds the usage of the file pages of this instance to stats.
+  @param[in,out] stats          Usage per (space id, index id).
+  @param[in] now                Current time, from ut_time_ms(). */
+  void collect_index_stats(Buf_index_stats_map &stats, uint32_t now) noexcept;
+
+  /** Copies the descriptors of the next PAGE_INFO_BATCH blocks of this
+  instance, under the instance mutex.
+  @param[in,out] chunk_no       Chunk of the first block, start with 0.
+  @param[in,out] offset         Offset of the first block in the chunk,
+                                start with 0. Both are advanced past the batch.
+  @param[out] infos             The descriptors.
+  @return false if there were no blocks left */
+  bool collect_page_infos(ulint &chunk_no, ulint &offset, std::vector<Buf_page_info> &infos) noexcept;
+
   /** Gets the block to whose frame the pointer is pointing to.
   @param[in] ptr                 Pointer to a frame.
-  @return pointer to block, never nullptr */
+  @return pointer to block, or nullptr if the frame is not in this instance */
   [[nodiscard]] Buf_block *block_align(const byte *ptr);
 
   /** Find out if a pointer belongs to a buf_block_t. It can be a pointer to
@@ -764,6 +1525,19 @@ struct Buf_pool {
   @return true if ptr belongs to a buf_block_t struct */
   [[nodiscard]] bool pointer_is_block_field(const void *ptr);
 
+  /** Checks if a block belongs to a chunk that is being withdrawn by resize().
+  The caller must hold the buffer pool mutex.
+  @param[in] bpage                Block to check.
+  @return true if the block must go to m_withdraw_list instead of the free list. */
+  [[nodiscard]] bool will_be_withdrawn(const Buf_page *bpage) const;
+
+  /** Checks if a block is in the first quarter of the young blocks of the LRU
+  list, i.e., it has been made young recently. NOTE: does not reserve the buffer
+  pool mutex, the result is a heuristic.
+  @param[in] bpage                Block to check.
+  @return true if the block was made young recently. */
+  [[nodiscard]] bool peek_if_young(const Buf_page *bpage) const;
+
   /**
    * Initializes a page for reading into the buffer pool. If the page is
    * already in the buffer pool, or if we specify to read only ibuf pages
@@ -795,6 +1569,24 @@ struct Buf_pool {
     mutex_enter(&m_mutex);
   }
 
+  /**
+   * @brief Acquires the flush list mutex, no other latch may be acquired
+   * while it is held.
+   */
+  void flush_list_mutex_acquire() const noexcept {
+    mutex_enter(&m_flush_list_mutex);
+  }
+
+  /** Releases the flush list mutex. */
+  void flush_list_mutex_release() const noexcept {
+    mutex_exit(&m_flush_list_mutex);
+  }
+
+  /** @return true if the flush list mutex is owned. */
+  [[nodiscard]] bool flush_list_mutex_is_owned() const noexcept {
+    return mutex_own(&m_flush_list_mutex);
+  }
+
 #ifdef UNIV_DEBUG
   /** Prints info of the buffer pool data structure. */
   void print();
@@ -868,10 +1660,15 @@ struct Buf_pool {
    * This high-level function can be used to prevent an important page from slipping
    * out of the buffer pool.
    *
+   * A scan, see mtr_t::set_scan(), never makes a page young. A page that the scan
+   * is the first to access is moved to the end of the LRU list instead, so that it
+   * is the first to be evicted unless some other thread accesses it later.
+   *
    * @param bpage Buffer block of a file page (in/out)
    * @param access_time Access time of the page (in: bpage->m_access_time read under mutex protection, or 0 if unknown)
+   * @param scan true if the page is fetched by a scan
    */
-  void set_accessed_make_young(Buf_page *bpage, unsigned access_time);
+  void set_accessed_make_young(Buf_page *bpage, unsigned access_time, bool scan);
 
   /**
    * @brief Inits a page to the buffer buf_pool.
@@ -879,8 +1676,9 @@ struct Buf_pool {
    * @param space in: space id
    * @param page_no in: Page number within space
    * @param block in: block to init
+   * @param is_temp in: true if the space holds a temporary table
    */
-  void page_init(space_id_t space, page_no_t page_no, Buf_block *block);
+  void page_init(space_id_t space, page_no_t page_no, Buf_block *block, bool is_temp);
 
   /** Recommends a move of a block to the start of the LRU list if there is danger
    * of dropping from the buffer pool. NOTE: does not reserve the buffer pool mutex.
@@ -899,6 +1697,13 @@ struct Buf_pool {
    */
   buf_chunk_t *chunk_init(buf_chunk_t *chunk, ulint mem_size);
 
+  /**
+   * @brief Adds the blocks of an initialized chunk to the free list.
+   *
+   * @param[in,out] chunk Chunk returned by chunk_init().
+   */
+  void chunk_add_free_blocks(buf_chunk_t *chunk);
+
   /**
    * @brief Checks that all file pages in the buffer chunk are in a replaceable state.
    * 
@@ -907,6 +1712,41 @@ struct Buf_pool {
    */
   const Buf_block *chunk_not_freed(buf_chunk_t *chunk);
 
+  /**
+   * @brief Frees the block descriptors and the memory of a chunk, its blocks
+   * must not be in use or in any list.
+   *
+   * @param[in,out] chunk Chunk to free.
+   */
+  void chunk_free(buf_chunk_t *chunk);
+
+  /**
+   * @brief Adds chunks until the instance is at least pool_size bytes.
+   *
+   * @param[in] pool_size New size of this instance in bytes.
+   * @return true on success.
+   */
+  bool grow(uint64_t pool_size);
+
+  /**
+   * @brief Removes the last chunks for as long as the instance stays at least
+   * pool_size bytes.
+   *
+   * @param[in] pool_size New size of this instance in bytes.
+   * @return true on success.
+   */
+  bool shrink(uint64_t pool_size);
+
+  /**
+   * @brief Moves the blocks of the chunks from m_n_chunks_new onwards to
+   * m_withdraw_list. Free blocks are taken directly, clean pages are evicted,
+   * dirty pages are flushed first. Blocks that are buffer-fixed or in use for
+   * other purposes are retried until they are released.
+   *
+   * @return true if all the blocks were withdrawn, false on timeout.
+   */
+  bool withdraw_blocks();
+
   /**
    * @brief Initializes a buffer control block when the buf_pool is created.
    * 
@@ -924,6 +1764,10 @@ struct Buf_pool {
 
   public:
 
+  /** Index of this instance in Buf_pool::m_instances, it is also stored in
+  Buf_page::m_buf_pool_index of every block owned by this instance. */
+  const ulint m_instance_no;
+
   /** mutex protecting the buffer pool struct and control blocks, except the
   read-write lock in them */
   mutable mutex_t m_mutex{};
@@ -941,18 +1785,31 @@ struct Buf_pool {
   /** @name General fields */
   /* @{ */
 
-  /** number of buffer pool chunks */
-  ulint m_n_chunks{};
+  /** number of buffer pool chunks. Changed only while holding the buffer
+  pool mutex, block_align() and pointer_is_block_field() read it without. */
+  std::atomic<ulint> m_n_chunks{};
 
-  /** buffer pool chunks */
+  /** buffer pool chunks, an array of MAX_CHUNKS descriptors */
   buf_chunk_t *m_chunks{};
 
+  /** size of the chunks added by resize(), in bytes */
+  uint64_t m_chunk_size{};
+
+  /** while shrinking, the number of chunks that are kept; the blocks of the
+  chunks after these are being withdrawn. Equal to m_n_chunks otherwise.
+  Protected by the buffer pool mutex. */
+  ulint m_n_chunks_new{};
+
+  /** blocks withdrawn from the chunks that are being removed. Protected by
+  the buffer pool mutex. */
+  UT_LIST_BASE_NODE_T(Buf_page, m_list) m_withdraw_list{};
+
   /** current pool size in pages */
   ulint m_curr_size{};
 
   /** hash table of Buf_page or buf_block_t file pages,
-  Buf_page::in_file() == true, indexed by (m_nspace_id, m_page_no) */
-  page_hash_t *m_page_hash{};
+  Buf_page::in_file() == true, indexed by (m_space, m_page_no) */
+  Buf_page_hash *m_page_hash{};
 
   /** Number of pending read operations */
   ulint m_n_pend_reads{};
@@ -972,7 +1829,15 @@ struct Buf_pool {
 
   /* @{ */
 
-  /** base node of the modified block list */
+  /** mutex protecting m_flush_list, m_recovery_flush_list and the
+  m_oldest_modification of the pages that are not in the flush list yet.
+  Dirtying a page takes only this mutex and not m_mutex. Removing a page
+  from the flush list requires both, so it is enough to hold either one
+  of them to traverse the list. */
+  mutable mutex_t m_flush_list_mutex{};
+
+  /** base node of the modified block list, it is sorted on
+  m_oldest_modification within BUF_FLUSH_LIST_SLACK, see Log::flush_order_begin() */
   UT_LIST_BASE_NODE_T(Buf_page, m_list) m_flush_list;
 
   /** this is true when a flush of the given type is being initialized */
@@ -1024,7 +1889,7 @@ struct Buf_pool {
   ulint m_LRU_old_len{};
 
   /** Number of write requests issued */
-  ulint m_write_requests{};
+  std::atomic<ulint> m_write_requests{};
 
   /** LRU replacement algorithm */
   std::unique_ptr<Buf_LRU> m_LRU{};
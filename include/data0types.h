@@ -165,6 +165,10 @@ const ulint DATA_BINARY_TYPE = 1024;
 /** first custom type starts here */
 const ulint DATA_CUSTOM_TYPE = 2048;
 
+/** This is ORed to the precise type of an integer column that is changed
+by adding commutative deltas, after the three custom types. */
+const ulint DATA_COMMUTATIVE = DATA_CUSTOM_TYPE << 3;
+
 /* This many bytes we need to store the type information affecting the
 alphabetical order for a single field and decide the storage size of an
 SQL null*/
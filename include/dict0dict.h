@@ -39,6 +39,8 @@ Created 1/8/1996 Heikki Tuuri
 #include "ut0mem.h"
 #include "ut0rnd.h"
 
+#include <array>
+#include <shared_mutex>
 #include <string_view>
 #include <unordered_map>
 
@@ -173,6 +175,52 @@ struct Dict {
    */
   [[nodiscard]] Table *table_get(const char *table_name, bool inc_count) noexcept;
 
+  /**
+   * @brief Looks up a table in the cache without the dictionary mutex and
+   * increments its open handle count. Only finds the tables that have been
+   * opened before with the mutex and that are not being dropped.
+   *
+   * @param[in] table_name The table name.
+   *
+   * @return The table object, or nullptr if it must be looked up with the mutex.
+   */
+  [[nodiscard]] Table *table_acquire_if_cached(const char *table_name) noexcept {
+    return m_tables.acquire(table_name);
+  }
+
+  /**
+   * @brief Looks up a table in the cache by id without the dictionary mutex
+   * and increments its open handle count, see table_acquire_if_cached(const char *).
+   *
+   * @param[in] table_id The table id.
+   *
+   * @return The table object, or nullptr if it must be looked up with the mutex.
+   */
+  [[nodiscard]] Table *table_acquire_if_cached(Dict_id table_id) noexcept {
+    return m_table_ids.acquire(table_id);
+  }
+
+  /**
+   * @brief Loads the foreign key constraints of a table, and of the tables that
+   * it's linked to by constraints, unless they were loaded already. They aren't
+   * loaded with the table, only when DML or DDL on the table needs them.
+   *
+   * @param[in,out] table The table, in the dictionary cache.
+   *
+   * @return DB_SUCCESS or error code of the first constraint that failed to load.
+   */
+  db_err table_load_foreigns(Table *table) noexcept;
+
+  /**
+   * @brief Evicts the least recently used tables from the dictionary cache
+   * until it holds at most srv_config.m_dict_table_cache_size tables. Only
+   * the user tables that have no open handles, locks or foreign key
+   * constraints in the cache are evicted. The master thread calls this.
+   *
+   * @return Number of tables evicted.
+   */
+  ulint evict_tables() noexcept;
+
   /**
    * Returns a table instance based on table id.
    * 
@@ -532,11 +580,7 @@ struct Dict {
   [[nodiscard]] inline Table *table_check_if_in_cache(const char *table_name) noexcept {
     ut_ad(mutex_own(&m_mutex));
 
-    if (const auto it = m_tables.find(table_name); it != m_tables.end()) {
-      return  it->second;
-    } else {
-      return nullptr;
-    }
+    return m_tables.find(table_name);
   }
 
   /**
@@ -570,11 +614,7 @@ struct Dict {
   inline Table *table_get_on_id(Dict_id table_id) noexcept {
     ut_ad(mutex_own(&m_mutex));
 
-    if (const auto it = m_table_ids.find(table_id); it != m_table_ids.end()) {
-      return it->second;
-    } else {
-      return nullptr;
-    }
+    return m_table_ids.find(table_id);
   }
 
   /**
@@ -602,7 +642,16 @@ struct Dict {
 private:
 #endif /* UNIT_TEST */
 
-  
+  /**
+   * @brief Checks if a table can be evicted from the dictionary cache. The
+   * caller must own the dictionary mutex and the dictionary latch in X mode.
+   *
+   * @param[in] table The table.
+   *
+   * @return true if nothing refers to the table.
+   */
+  [[nodiscard]] bool table_can_be_evicted(const Table *table) const noexcept;
+
   /**
    * @brief Builds the dictionary cache representation for a clustered index.
    *
@@ -925,11 +974,128 @@ public:
   /** Mutex protecting the foreign and unique error buffers */
   mutable mutex_t m_foreign_err_mutex{};
 
+  /** Number of shards of the hash tables of the tables. */
+  static constexpr ulint N_TABLE_SHARDS = 16;
+
+  /** A shard of a hash table of the tables. A table is added and removed
+  with the dictionary mutex and the latch in exclusive mode. It's looked up
+  with either of them, table_acquire_if_cached() only takes the latch in
+  shared mode. */
+  template <typename Key>
+  struct alignas(64) Table_shard {
+    /** Protects m_tables. */
+    mutable std::shared_mutex m_latch{};
+
+    /** Map from the key to the table instance. */
+    std::unordered_map<Key, Table *> m_tables{};
+  };
+
+  /** A hash table of the tables, sharded on the hash of the key.
+  @tparam Key                   Table name or table id */
+  template <typename Key>
+  struct Table_hash {
+    /**
+     * @param[in] key Table name or table id.
+     * @return the shard of the key.
+     */
+    [[nodiscard]] Table_shard<Key> &get_shard(const Key &key) noexcept {
+      return m_shards[std::hash<Key>{}(key) % N_TABLE_SHARDS];
+    }
+
+    /**
+     * @param[in] key Table name or table id.
+     * @return the shard of the key.
+     */
+    [[nodiscard]] const Table_shard<Key> &get_shard(const Key &key) const noexcept {
+      return m_shards[std::hash<Key>{}(key) % N_TABLE_SHARDS];
+    }
+
+    /**
+     * @brief Looks up a table, the caller must own the dictionary mutex.
+     *
+     * @param[in] key Table name or table id.
+     * @return the table or nullptr if not found.
+     */
+    [[nodiscard]] Table *find(const Key &key) const noexcept {
+      const auto &shard = get_shard(key);
+
+      if (const auto it = shard.m_tables.find(key); it != shard.m_tables.end()) {
+        return it->second;
+      } else {
+        return nullptr;
+      }
+    }
+
+    /**
+     * @brief Looks up a table without the dictionary mutex and opens a handle
+     * to it. See Table::m_published for why the table can't be freed under us.
+     *
+     * @param[in] key Table name or table id.
+     * @return the table or nullptr if it isn't cached or isn't published.
+     */
+    [[nodiscard]] Table *acquire(const Key &key) noexcept {
+      const auto &shard = get_shard(key);
+      std::shared_lock latch{shard.m_latch};
+
+      const auto it = shard.m_tables.find(key);
+
+      if (it == shard.m_tables.end() || !it->second->m_published.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+
+      auto table = it->second;
+
+      table->m_n_handles_opened.fetch_add(1);
+
+      /* Pairs with the drop clearing the flag before it reads the handle count. */
+      if (!table->m_published.load()) {
+        table->m_n_handles_opened.fetch_sub(1);
+        return nullptr;
+      }
+
+      /* Read first, the line is only written once per eviction pass. */
+      if (!table->m_lru_referenced.load(std::memory_order_relaxed)) {
+        table->m_lru_referenced.store(true, std::memory_order_relaxed);
+      }
+
+      return table;
+    }
+
+    /**
+     * @brief Adds a table, the caller must own the dictionary mutex.
+     *
+     * @param[in] key Table name or table id.
+     * @param[in] table Table to add.
+     * @return true if added, false if the key was already in the hash table.
+     */
+    bool insert(const Key &key, Table *table) noexcept {
+      auto &shard = get_shard(key);
+      std::unique_lock latch{shard.m_latch};
+
+      return shard.m_tables.emplace(key, table).second;
+    }
+
+    /**
+     * @brief Removes a table, the caller must own the dictionary mutex.
+     *
+     * @param[in] key Table name or table id.
+     */
+    void erase(const Key &key) noexcept {
+      auto &shard = get_shard(key);
+      std::unique_lock latch{shard.m_latch};
+
+      shard.m_tables.erase(key);
+    }
+
+    /** The shards of the hash table. */
+    std::array<Table_shard<Key>, N_TABLE_SHARDS> m_shards{};
+  };
+
   /** Hash table of the tables, based on name */
-  std::unordered_map<std::string_view, Table *> m_tables{};
+  Table_hash<std::string_view> m_tables{};
 
   /** Hash table of the tables, based on id */
-  std::unordered_map<Dict_id, Table *> m_table_ids{};
+  Table_hash<Dict_id> m_table_ids{};
 
   /** LRU list of tables */
   UT_LIST_BASE_NODE_T(Table, m_table_LRU) m_table_LRU{};
@@ -952,6 +1118,22 @@ public:
   /** Dummy index for ROW_FORMAT=REDUNDANT supremum and infimum records */
   Index *m_dummy_index{};
 
+  /** true once SYS_INDEX_STATS exists, the index statistics of the user
+  tables are then stored and loaded, see Dict_stats */
+  bool m_persistent_stats{};
+
+  /** Number of tables loaded to the cache from the system tables */
+  ulint m_n_tables_loaded{};
+
+  /** Number of tables evicted from the cache */
+  ulint m_n_tables_evicted{};
+
+  /** Incremented when a table is renamed, changes its id or is removed from
+  the cache, or when an index is added to or removed from the cache. A query
+  graph parsed at one version refers to the cached tables and indexes that
+  exist at that version. */
+  ulint m_schema_version{};
+
   /** Data dictionary booting/creation. */
   Dict_store m_store;
 
@@ -0,0 +1,210 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/dict0hist.h
+Equi-depth histograms of the keys of an index
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "data0types.h"
+#include "db0err.h"
+#include "dict0types.h"
+#include "mem0types.h"
+#include "trx0types.h"
+
+#include <vector>
+
+/** Equi-depth histogram of the keys of an index, for range estimates.
+
+The histogram is built by a parallel scan of the index that keeps every k-th
+record as a sample, k is chosen from the row estimate of the table so that
+about N_SAMPLES_PER_BUCKET samples fall in each bucket. The sorted samples
+are cut into N_BUCKETS buckets holding the same number of rows, a bucket is
+described by its largest key and the number of rows up to it. A frequent
+key value spans several buckets, a range that covers it gets their rows.
+
+The histograms are stored in SYS_HISTOGRAMS, one row per bucket, and loaded
+on first use. They are rebuilt when the rows modified in the table since the
+last build exceed 1 / REFRESH_RATIO of its rows, estimates are scaled to the
+current row estimate of the table in between. */
+struct Index_histogram {
+  /** Number of buckets of a histogram. */
+  static constexpr ulint N_BUCKETS = 128;
+
+  /** Number of samples wanted per bucket. */
+  static constexpr ulint N_SAMPLES_PER_BUCKET = 16;
+
+  /** Number of threads used to scan an index. */
+  static constexpr ulint N_THREADS = 4;
+
+  /** The histograms of a table are rebuilt after this fraction of its
+  rows was modified. */
+  static constexpr ulint REFRESH_RATIO = 8;
+
+  /** A bucket of the histogram. */
+  struct Bucket {
+    /** Largest key in the bucket, the first get_n_unique() fields. */
+    DTuple *m_bound{};
+
+    /** Number of rows in this bucket and the buckets before it. */
+    uint64_t m_n_rows{};
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param[in] index           Index of the histogram.
+   */
+  explicit Index_histogram(const Index *index) noexcept;
+
+  /** Destructor. */
+  ~Index_histogram() noexcept;
+
+  Index_histogram(const Index_histogram &) = delete;
+  Index_histogram &operator=(const Index_histogram &) = delete;
+
+  /**
+   * Frees a histogram.
+   *
+   * @param[in,out] histogram   Histogram to free, may be nullptr, set to nullptr.
+   */
+  static void destroy(Index_histogram *&histogram) noexcept;
+
+  /**
+   * Builds the histograms of all the indexes of a table, stores them and
+   * installs them in the dictionary cache.
+   *
+   * @param[in,out] table       Table to analyze.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] static db_err update(Table *table) noexcept;
+
+  /**
+   * Loads the histogram of an index on first use, and rebuilds the
+   * histograms of its table if enough rows were modified since they were
+   * built. Does nothing for an index without a stored histogram.
+   *
+   * @param[in,out] index       Index that an estimate is wanted for.
+   */
+  static void load_or_refresh(Index *index) noexcept;
+
+  /**
+   * Deletes the stored histogram of an index that is being dropped.
+   *
+   * @param[in,out] dict        Data dictionary, its mutex is owned.
+   * @param[in] index_id        Id of the index.
+   * @param[in,out] trx         Transaction that drops the index.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] static db_err drop(Dict *dict, Dict_id index_id, Trx *trx) noexcept;
+
+  /**
+   * Estimates the number of rows in a range from the histogram of an index.
+   *
+   * @param[in] index           Index of the range.
+   * @param[in] tuple1          Range start, no fields for -infinity.
+   * @param[in] mode1           Search mode of the range start.
+   * @param[in] tuple2          Range end, no fields for +infinity.
+   * @param[in] mode2           Search mode of the range end.
+   *
+   * @return the estimate, or -1 if the index has no histogram.
+   */
+  [[nodiscard]] static int64_t estimate_n_rows_in_range(
+    const Index *index, const DTuple *tuple1, ulint mode1, const DTuple *tuple2, ulint mode2) noexcept;
+
+ private:
+  /**
+   * Builds the histogram of an index with a parallel scan.
+   *
+   * @param[in] index           Index to scan.
+   *
+   * @return the histogram, or nullptr if the scan failed.
+   */
+  [[nodiscard]] static Index_histogram *build(Index *index) noexcept;
+
+  /**
+   * Reads the stored histogram of an index.
+   *
+   * @param[in] index           Index of the histogram.
+   *
+   * @return the histogram, or nullptr if none is stored.
+   */
+  [[nodiscard]] static Index_histogram *load(const Index *index) noexcept;
+
+  /**
+   * Replaces the stored histogram of the index.
+   *
+   * @param[in,out] trx         Transaction to write with.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err save(Trx *trx) const noexcept;
+
+  /**
+   * Installs a histogram in the dictionary cache and frees the previous one.
+   *
+   * @param[in,out] index       Index of the histogram.
+   * @param[in] histogram       New histogram, or nullptr.
+   */
+  static void install(Index *index, Index_histogram *histogram) noexcept;
+
+  /**
+   * Callback of FETCH in load(), appends the bucket of a SYS_HISTOGRAMS row.
+   *
+   * @param[in] row             The sel_node_t of the cursor.
+   * @param[in,out] arg         The histogram being loaded.
+   *
+   * @return nullptr to stop the fetch.
+   */
+  static void *fetch_bucket(void *row, void *arg) noexcept;
+
+  /**
+   * Appends a bucket that is read from SYS_HISTOGRAMS.
+   *
+   * @param[in] n_rows          Number of rows up to the end of the bucket.
+   * @param[in] ptr             Serialized bound of the bucket.
+   * @param[in] len             Length of the serialized bound.
+   *
+   * @return true if the bound was well formed.
+   */
+  [[nodiscard]] bool add_bucket(uint64_t n_rows, const byte *ptr, ulint len) noexcept;
+
+  /**
+   * Number of rows before a key.
+   *
+   * @param[in] tuple           Key, may be a prefix of the bounds.
+   * @param[in] inclusive       true to count the rows equal to the key too.
+   *
+   * @return the estimated number of rows.
+   */
+  [[nodiscard]] uint64_t get_n_rows_before(const DTuple *tuple, bool inclusive) const noexcept;
+
+ private:
+  /** Index of the histogram. */
+  const Index *m_index{};
+
+  /** Heap for the bounds. */
+  mem_heap_t *m_heap{};
+
+  /** The buckets in key order. */
+  std::vector<Bucket> m_buckets{};
+};
@@ -57,9 +57,8 @@ struct Dict_load {
 
   /**
    * Loads a table definition and also all its index definitions, and also
-   * the cluster definition if the table is a member in a cluster. Also loads
-   * all foreign key constraints where the foreign key is in the table or where
-   * a foreign key references columns in this table.
+   * the cluster definition if the table is a member in a cluster. The foreign
+   * key constraints are not loaded, see Dict::table_load_foreigns().
    *
    * @param[in] recovery Recovery flag
    * @param[in] name Table name in the databasename/tablename format
@@ -0,0 +1,133 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/dict0stats.h
+Persistent index statistics
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "db0err.h"
+#include "dict0types.h"
+#include "trx0types.h"
+
+/** Persistent statistics of the indexes of a table.
+
+The index sizes and the estimates of the number of different key values of
+the indexes of a user table are stored in SYS_INDEX_STATS, one row per index,
+every time they are calculated. When the table is opened after a restart the
+stored statistics are used instead of sampling the indexes again.
+
+A thread that modifies a table doesn't recalculate the statistics itself, it
+queues the table once the rows modified since the last calculation exceed
+1 / RECALC_RATIO of its rows, and the master thread recalculates and stores
+them. The number of leaf pages sampled per index can be set per table, it is
+stored with the statistics. */
+struct Dict_stats {
+  /** The statistics of a table are recalculated after this fraction of
+  its rows was modified. */
+  static constexpr int64_t RECALC_RATIO = 16;
+
+  /**
+   * Initializes the statistics of a table that is opened: loads the stored
+   * statistics or, if there are none, calculates and stores them. The caller
+   * must not own the dictionary mutex.
+   *
+   * @param[in,out] table       Table that was opened.
+   */
+  static void init(Table *table) noexcept;
+
+  /**
+   * Calculates the statistics of a table and stores them. The caller must
+   * not own the dictionary mutex.
+   *
+   * @param[in,out] table       Table to analyze.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] static db_err update(Table *table) noexcept;
+
+  /**
+   * Counts a row modification and queues the table for a recalculation of
+   * its statistics if enough rows were modified.
+   *
+   * @param[in,out] table       Table that was modified.
+   */
+  static void row_modified(Table *table) noexcept;
+
+  /**
+   * The master thread calls this regularly to recalculate the statistics
+   * of the queued tables.
+   *
+   * @return the number of tables that were processed.
+   */
+  static ulint recalc_queued() noexcept;
+
+  /**
+   * Sets the number of leaf pages sampled per index of a table, then
+   * recalculates and stores its statistics.
+   *
+   * @param[in,out] table       Table to set the sample size of.
+   * @param[in] n_pages         Number of pages, 0 for the global stats_sample_pages.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] static db_err set_sample_pages(Table *table, ulint n_pages) noexcept;
+
+  /**
+   * Deletes the stored statistics of an index that is being dropped.
+   *
+   * @param[in,out] dict        Data dictionary, its mutex is owned.
+   * @param[in] index_id        Id of the index.
+   * @param[in,out] trx         Transaction that drops the index.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] static db_err drop(Dict *dict, Dict_id index_id, Trx *trx) noexcept;
+
+ private:
+  /**
+   * Reads the stored statistics of the indexes of a table and installs them,
+   * if all the indexes have them.
+   *
+   * @param[in,out] table       Table to load the statistics of.
+   *
+   * @return true if the statistics were loaded.
+   */
+  [[nodiscard]] static bool load(Table *table) noexcept;
+
+  /**
+   * Replaces the stored statistics of the indexes of a table.
+   *
+   * @param[in] table           Table whose statistics were calculated.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] static db_err save(const Table *table) noexcept;
+
+  /**
+   * Callback of FETCH in load(), copies a SYS_INDEX_STATS row.
+   *
+   * @param[in] row             The sel_node_t of the cursor.
+   * @param[in,out] arg         The Index_stats_row being read.
+   *
+   * @return nullptr to stop the fetch.
+   */
+  static void *fetch_row(void *row, void *arg) noexcept;
+};
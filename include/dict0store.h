@@ -196,6 +196,24 @@ struct Dict_store {
    */
   [[nodiscard]] db_err create_or_check_foreign_constraint_tables() noexcept;
 
+  /**
+   * @brief Creates the SYS_HISTOGRAMS table that stores the index histograms,
+   * see Index_histogram, at database creation or database start if it is not
+   * found.
+   *
+   * @return DB_SUCCESS on success, or an error code on failure.
+   */
+  [[nodiscard]] db_err create_or_check_histogram_table() noexcept;
+
+  /**
+   * @brief Creates the SYS_INDEX_STATS table that stores the persistent index
+   * statistics, see Dict_stats, at database creation or database start if it
+   * is not found.
+   *
+   * @return DB_SUCCESS on success, or an error code on failure.
+   */
+  [[nodiscard]] db_err create_or_check_index_stats_table() noexcept;
+
   /**
    * @brief Creates the dictionary header and system tables.
    * 
@@ -355,6 +373,18 @@ struct Dict_store {
    */
   void drop_index_tree(rec_t *rec, mtr_t *mtr) noexcept;
 
+  /**
+   * @brief Creates a statistics system table with a single clustered index
+   * if it is not found or is not of the right form.
+   *
+   * @param[in] name Name of the system table.
+   * @param[in] sql Procedure that creates the table and its index.
+   * @param[in] what What the table stores, for the log messages.
+   *
+   * @return DB_SUCCESS on success, or an error code on failure.
+   */
+  [[nodiscard]] db_err create_or_check_stats_table(const char *name, const char *sql, const char *what) noexcept;
+
   /** The dictionary . */
   Dict *m_dict{};
 
@@ -32,8 +32,12 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #include "que0types.h"
 #include "rem0types.h"
 #include "sync0rw.h"
+#include "ut0counter.h"
 
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <vector>
 
 struct Table;
 
@@ -49,6 +53,8 @@ struct Insert_node;
 struct Commit_node;
 struct Index_node;
 struct Table_node;
+struct Index_histogram;
+struct Buf_block;
 
 /** Space id and page no where the dictionary header resides */
 constexpr space_id_t DICT_HDR_SPACE = SYS_TABLESPACE;
@@ -402,6 +408,44 @@ struct Field {
 
 /** Data structure for an index. */ 
 struct Index {
+  /** Operation and structure counters of an index, see m_counters. */
+  enum Counter : uint8_t {
+    /** Rows returned by a search on the index */
+    ROWS_READ,
+
+    /** Index entries inserted */
+    ROWS_INSERTED,
+
+    /** Index records updated */
+    ROWS_UPDATED,
+
+    /** Index records delete marked */
+    ROWS_DELETE_MARKED,
+
+    /** Index records removed by purge */
+    ROWS_PURGED,
+
+    /** Page splits, see Btree::page_split_and_insert() */
+    PAGE_SPLITS,
+
+    /** Page merges, see Btree::compress() */
+    PAGE_MERGES,
+
+    /** Inserts that fit in the leaf page */
+    OPTIMISTIC_INSERTS,
+
+    /** Inserts that had to change the tree structure */
+    PESSIMISTIC_INSERTS,
+
+    /** Pages read from disk by the cursors on the index */
+    PAGE_READS,
+
+    /** Number of counters */
+    N_COUNTERS
+  };
+
+  /** Number of shards of m_counters. */
+  static constexpr size_t N_COUNTER_SHARDS = 8;
 
   /**
    * @brief Constructor for an index instance.
@@ -919,6 +963,12 @@ struct Index {
   /** Number of nullable fields */
   unsigned m_n_nullable : 10;
 
+  /** Number of leading fields of the unique key that are NOT NULL integers
+   * of a fixed size of at most 8 bytes, cmp_dtuple_rec_with_match() and
+   * cmp_rec_rec_with_match() compare them as integers. Set when the index is
+   * added to the cache. */
+  unsigned m_n_int_fields : 10;
+
   /** True if the index object is in the dictionary cache */
   unsigned m_cached : 1;
 
@@ -951,15 +1001,47 @@ struct Index {
   /** Array of field descriptions */
   Field *m_fields;
 
+  /** If all the fields are NOT NULL and of a fixed size, the end offsets of
+  the fields of a leaf record, the same for all of them; else nullptr.
+  Allocated from m_heap when the index is added to the cache. */
+  ulint *m_fixed_field_ends{};
+
   /* List of indexes of the table */
   UT_LIST_NODE_T(Index) m_indexes;
 
   /** Statistics for query optimization */
   Stats m_stats;
 
+  /** Histogram of the keys for range estimates, or nullptr. Protected by
+  the index statistics mutex. */
+  Index_histogram *m_histogram{};
+
+  /** true once the stored histogram was looked up, whether one was found or not */
+  bool m_histogram_loaded{};
+
   /** read-write lock protecting the upper levels of the index tree */
   mutable rw_lock_t m_lock;
 
+  /** Number of point lookups in a row that found their key, the keys of the
+  index are added to the adaptive hash index after Btr_search::BUILD_LIMIT
+  of them. Not protected by any latch, only used for heuristics. */
+  mutable ulint m_n_hash_potential{};
+
+  /** Guess of the rightmost leaf page for inserts past the last key, see
+  Btree_cursor::search_append(). The two fields are read and written
+  without a latch and may not match, the page is checked once latched. */
+  mutable std::atomic<Buf_block *> m_append_block{};
+
+  /** Modify clock of m_append_block when the guess was made */
+  mutable std::atomic<uint64_t> m_append_modify_clock{};
+
+  /** Waits for record locks on the index */
+  mutable Lock_wait_stats m_lock_waits{};
+
+  /** Counters of the operations on the index, sharded by thread because a
+  hot index is updated by all the threads. Not reset, see ib_index_stats(). */
+  mutable ut::Counter_set<N_COUNTERS, N_COUNTER_SHARDS> m_counters{};
+
   /** Client compare context. For use defined column types and BLOBs
   the client is responsible for comparing the column values. This field
   is the argument for the callback compare function. */
@@ -1389,6 +1471,15 @@ struct Table {
     return !m_referenced_list.empty();
   }
 
+  /**
+   * @brief Checks if a table is temporary, see DICT_TF2_TEMPORARY.
+   *
+   * @return True if the table is dropped at the next startup.
+   */
+  [[nodiscard]] inline bool is_temporary() const noexcept {
+    return ((m_flags >> DICT_TF2_SHIFT) & DICT_TF2_TEMPORARY) != 0;
+  }
+
   /**
    * @brief Gets the referenced constraint for an index.
    * 
@@ -1573,6 +1664,12 @@ struct Table {
    */
   [[nodiscard]] bool link_cols(Index *index) noexcept;
 
+  /**
+   * Frees the cached query graphs of the table and invalidates the graphs
+   * that are checked out, they were built for the current set of indexes.
+   */
+  void graph_cache_clear() noexcept;
+
   /**
    * Copies types of columns contained in table to tuple and sets all fields of the
    * tuple to the SQL NULL value. This function should be called right after dtuple_create().
@@ -1610,11 +1707,47 @@ struct Table {
     for heuristics */
     ulint m_modified_counter{};
 
+    /** Like m_modified_counter, but reset when the histograms of the indexes
+    are rebuilt, see Index_histogram */
+    ulint m_hist_modified_counter{};
+
+    /** Number of leaf pages sampled per index when the statistics are
+    calculated, 0 for srv_config.m_stats_sample_pages. It is stored with
+    the persistent statistics, see Dict_stats */
+    ulint m_sample_pages{};
+
+    /** true while the table waits in the queue of the statistics
+    recalculations done by the master thread */
+    std::atomic<bool> m_recalc_queued{};
+
     /** true if statistics have been calculated the first time after database
     startup or table creation */
     bool m_initialized{};
   };
 
+  /**
+   * @brief Insert and update query graphs of the client API that are not in
+   * use. A cursor checks a graph out instead of building it and returns it
+   * when it's closed. Each graph owns its heap, they are freed with the table.
+   */
+  struct Graph_cache {
+    /** Maximum number of graphs of each kind kept per table */
+    static constexpr ulint MAX_GRAPHS = 8;
+
+    /** Protects the fields below */
+    std::mutex m_mutex;
+
+    /** Insert graphs */
+    std::vector<que_fork_t *> m_ins;
+
+    /** Update graphs */
+    std::vector<que_fork_t *> m_upd;
+
+    /** Incremented when an index is added to or removed from the table,
+    the graphs built before that are freed instead of being returned */
+    uint64_t m_version{};
+  };
+
   /** DICT_TF_COMPACT, ... */
   unsigned m_flags : DICT_TF2_BITS;
 
@@ -1677,8 +1810,28 @@ struct Table {
   UT_LIST_NODE_T(Table) m_table_LRU;
 
   /** Count of how many handles the user has opened to this table; dropping
-  of the table is NOT allowed until this count gets to zero */
-  uint32_t m_n_handles_opened;
+  of the table is NOT allowed until this count gets to zero. It is
+  incremented without the dictionary mutex by Dict::table_acquire_if_cached()
+  and decremented without it when a handle is closed. */
+  std::atomic<uint32_t> m_n_handles_opened;
+
+  /** true if the table is fully loaded and can be opened without the
+  dictionary mutex. Set when the table is opened with the mutex, cleared
+  by a drop before it checks m_n_handles_opened: a lock free open either
+  sees the flag cleared after incrementing the count, or the drop sees the
+  count and is deferred. The table is only freed after it's removed from
+  the hash tables under the shard latch, so the lookup itself is safe. */
+  std::atomic<bool> m_published;
+
+  /** true once the foreign key constraints of the table were loaded, they
+  are loaded by the first DML or DDL on the table, see
+  Dict::table_load_foreigns(). Set with the dictionary mutex. */
+  std::atomic<bool> m_foreigns_loaded;
+
+  /** Set when a handle is opened to the table, cleared by the eviction of
+  the dictionary cache which moves the table to the head of the LRU list
+  instead of evicting it then, see Dict::evict_tables(). */
+  std::atomic<bool> m_lru_referenced;
 
   /** Count of how many foreign key check operations are currently being performed
   on the table: we cannot drop the table while there are foreign key checks running
@@ -1688,6 +1841,9 @@ struct Table {
   /** List of locks on the table */
   Table_locks m_locks;
 
+  /** Waits for table and record locks on the table */
+  mutable Lock_wait_stats m_lock_waits{};
+
   /** This field is used to specify in simulations tables which are so big
   that disk should be accessed: disk access is simulated by putting the
   thread to sleep for a while; NOTE that this flag is not stored to the data
@@ -1697,6 +1853,9 @@ struct Table {
 
   /** Table statistics */
   Stats m_stats;
+
+  /** Cached query graphs of the client API */
+  Graph_cache m_graph_cache;
   
   /* @} */
 
@@ -34,10 +34,20 @@ Created 10/25/1995 Heikki Tuuri
 #include "srv0srv.h"
 #include "sync0rw.h"
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Forward declaration
 struct mtr_t;
+struct Cond_var;
 
 struct Fil {
 
@@ -46,15 +56,27 @@ struct Fil {
    */
   explicit Fil(ulint max_n_open);
 
-  /** Destructor */
+  /** Destructor, the file closer must have been shut down. */
   ~Fil() noexcept;
 
+  /** Starts the thread that closes the least recently used files when
+  more than max_files_open files are open. */
+  void start_file_closer();
+
+  /** Stops the file closer thread. */
+  void shutdown_file_closer();
+
   /** Returns the version number of a tablespace, -1 if not found.
   @return version number, -1 if the tablespace does not exist in the
   memory cache
   @param[in] space_id             Tablespace ID */
   int64_t space_get_version(space_id_t space_id);
 
+  /** Gives a tablespace a new version number, the reads of its pages that
+  were started with the old version are discarded when they complete.
+  @param[in] space_id             Tablespace ID */
+  void space_increment_version(space_id_t space_id);
+
   /** Returns the latch of a file space.
   @param[in] space_id             Tablespace ID
   @return	latch protecting storage allocation */
@@ -123,11 +145,13 @@ struct Fil {
   @return	DB_SUCCESS or error number */
   db_err write_flushed_lsn_to_data_files(lsn_t lsn);
 
-  /** Reads the flushed lsn and arch no fields from a data file at database
+  /** Reads the flushed lsn and the page size from a data file at database
   startup.
   @param[in] fh                    Open data file handle
-  @param[out] flushed_lsn          Maximum flushed LSN */
-  void read_flushed_lsn(os_file_t fh, lsn_t &max_flushed_lsn);
+  @param[out] flushed_lsn          Maximum flushed LSN
+  @param[out] page_size_shift      2-logarithm of the page size the file
+                                   was created with */
+  void read_flushed_lsn(os_file_t fh, lsn_t &max_flushed_lsn, ulint &page_size_shift);
 
    /** Parses the body of a log record written about an .ibd file operation. That
    is, the log record part after the standard (type, space id, page no) header of
@@ -204,7 +228,8 @@ struct Fil {
                                 databasename/tablename format of InnoDB,
                                 or a dir path to a temp table
   @param[in] is_temp            true if a table created with
-                                CREATE TEMPORARY TABLE
+                                CREATE TEMPORARY TABLE, the file is an
+                                .ibt file that crash recovery ignores
   @param[in] flags              Tablespace flags
   @param[in] size);             The initial size of the tablespace file
                                 in pages, must be >= FIL_IBD_FILE_INITIAL_SIZE
@@ -254,6 +279,25 @@ struct Fil {
    */
   db_err load_single_table_tablespaces(const std::string &path, ib_recovery_t recovery, size_t max_depth);
 
+  /**
+   * Runs load_single_table_tablespaces() in a background thread, so that the
+   * .ibd files are read while the log is being scanned. The single-table
+   * tablespaces must not be used before wait_for_tablespaces() has returned.
+   *
+   * @param[in] path              The path to the database files and sub-directories
+   * @param[in] recovery          The recovery flag
+   * @param[in] max_depth         The maximum depth of the directory tree to scan
+   */
+  void start_loading_tablespaces(const std::string &path, ib_recovery_t recovery, size_t max_depth) noexcept;
+
+  /**
+   * Waits until the loading started by start_loading_tablespaces() is done.
+   *
+   * @return true if this call waited for the loading, false if none was
+   *  started or an earlier call already waited for it.
+   */
+  bool wait_for_tablespaces() noexcept;
+
   /** If we need crash recovery, and we have called
   load_single_table_tablespaces() and dict_load_single_table_tablespaces(),
   we can call this function to print an error message of orphaned .ibd files
@@ -261,6 +305,23 @@ struct Fil {
   and space id. */
   void print_orphaned_tablespaces();
 
+  /**
+   * Returns the i/o latency percentiles of the tablespaces with the slowest
+   * requests, one tablespace per line.
+   *
+   * @param[in] max_spaces        Maximum number of tablespaces to report.
+   *
+   * @return the tablespaces and their latencies, sorted by the 99th percentile.
+   */
+  [[nodiscard]] std::string io_latency_to_string(ulint max_spaces);
+
+  /**
+   * Copies the i/o statistics of all the tablespaces.
+   *
+   * @return the statistics, in the order of the space list.
+   */
+  [[nodiscard]] std::vector<Fil_space_io_snapshot> get_io_stats();
+
   /**
    * Returns true if a single-table tablespace does not exist in the memory
    * cache, or is being deleted there.
@@ -273,6 +334,46 @@ struct Fil {
    */
   bool tablespace_deleted_or_being_deleted_in_mem(space_id_t space_id, int64_t version);
 
+  /**
+   * Checks if all the files of a tablespace support atomic page writes,
+   * the files that were not opened yet are assumed not to.
+   *
+   * @param[in] space_id    Space id
+   *
+   * @return true if a page write to the tablespace cannot be torn.
+   */
+  bool space_has_atomic_writes(space_id_t space_id);
+
+  /**
+   * Checks if a tablespace holds a temporary table.
+   *
+   * @param[in] space_id    Space id
+   *
+   * @return true if the space is not recovered after a crash, see
+   *  fil_space_t::m_is_temp.
+   */
+  bool space_is_temp(space_id_t space_id);
+
+  /**
+  * @brief Allocates a file name for a single-table tablespace.
+  * The string must be freed by caller with mem_free().
+  * 
+  * @param name The table name or a dir path of a TEMPORARY table.
+  * @param is_temp True for a TEMPORARY table, its file is an .ibt file.
+  * @return char* The allocated file name.
+  */
+  char *make_ibd_name(const char *name, bool is_temp);
+
+  /**
+   * Restores a page that was compressed when it was written, see
+   * srv_config_t::m_page_compression. Other pages are left as they are,
+   * so is a page that cannot be decompressed, it then fails the checksum
+   * check.
+   *
+   * @param[in,out] page  A page as it was read from a data file.
+   */
+  static void decompress_page(byte *page) noexcept;
+
   /**
    * Returns true if a single-table tablespace exists in the memory cache.
    *
@@ -323,6 +424,34 @@ struct Fil {
    */
   bool extend_space_to_desired_size(page_no_t *actual_size, space_id_t space_id, page_no_t size_after_extend);
 
+  /**
+   * Extends a single-table tablespace file ahead of demand, the space
+   * header is not changed. Does nothing if the space does not exist or is
+   * being deleted.
+   *
+   * @param[in] space_id          space id
+   * @param[in] size_after_extend desired size of the file in pages
+   *
+   * @return the number of pages the file was extended by.
+   */
+  page_no_t space_preallocate(space_id_t space_id, page_no_t size_after_extend);
+
+  /**
+   * Deallocates the disk space of a range of pages of a space, the file
+   * keeps its size. The file can't be closed or deleted while can_punch
+   * runs and the hole is punched.
+   *
+   * @param[in] space_id          space id
+   * @param[in] page_no           first page of the range
+   * @param[in] n_pages           number of pages, the range is cut at the end
+   *                              of the file of page_no
+   * @param[in] can_punch         called before the hole is punched, nothing
+   *                              is done if it returns false
+   *
+   * @return true if the hole was punched.
+   */
+  bool space_punch_hole(space_id_t space_id, page_no_t page_no, page_no_t n_pages, const std::function<bool()> &can_punch);
+
   /**
    * Tries to reserve free extents in a file space.
    *
@@ -385,6 +514,22 @@ struct Fil {
     void *buf,
     void *message);
 
+  /**
+   * Posts an asynchronous write of consecutive pages from several buffers,
+   * the pages are written with one vectored write and complete as one i/o.
+   *
+   * @param space_id              in: space id
+   * @param page_no               in: page number of the first page
+   * @param iov                   in: buffers to write, UNIV_PAGE_SIZE each,
+   *                              at most AIO::MAX_IOVS, the pages must not
+   *                              cross a file boundary
+   * @param n_iov                 in: number of buffers
+   * @param message               in: message for aio handler
+   * @return DB_SUCCESS, or DB_TABLESPACE_DELETED if we are trying to do
+   *         i/o on a tablespace which does not exist
+   */
+  db_err io_vectored(space_id_t space_id, page_no_t page_no, const iovec *iov, ulint n_iov, void *message);
+
   /**
    * Waits for an aio operation to complete. This function is used to write the
    * handler for completed requests. The aio array of pending requests is divided
@@ -407,12 +552,43 @@ struct Fil {
 
   /**
    * Flushes to disk writes in file spaces of the given type possibly cached by
-   * the OS.
+   * the OS. The files of the tablespaces are flushed with fsyncs submitted
+   * together to the AIO layer, the spaces without writes since their last
+   * flush are skipped.
    * 
    * @param[in] purpose           FIL_TABLESPACE, FIL_LOG
    */
   void flush_file_spaces(ulint purpose);
 
+  /** The files of a file space, see get_space_files(). */
+  struct Space_files {
+    /** Space id. */
+    space_id_t m_id{};
+
+    /** The paths of the files in the order of the chain, with the number
+    of the first page of the space that is in each. */
+    std::vector<std::pair<std::string, page_no_t>> m_files{};
+  };
+
+  /**
+   * Returns the files of the file spaces of a type, the spaces that are
+   * being dropped are skipped.
+   *
+   * @param[in] purpose           FIL_TABLESPACE, FIL_LOG
+   * @return the spaces in the order of the space list
+   */
+  std::vector<Space_files> get_space_files(ulint purpose);
+
+  /**
+   * Frees the last file node of a log space if it has more than n_files
+   * files, the file is not deleted. There must be no i/o on the file.
+   *
+   * @param[in] space_id          Log space id
+   * @param[in] n_files           Number of files to keep
+   * @return the path of the file, empty if the space has n_files files
+   */
+  std::string space_free_last_file(space_id_t space_id, ulint n_files);
+
   /**
    * Checks the consistency of the tablespace cache.
    * 
@@ -539,6 +715,66 @@ private:
    */
   void node_complete_io(fil_node_t *node, IO_request io_request);
 
+  /**
+   * @brief Updates the data structures when an i/o operation finishes. A read
+   * only decrements the pending count of the node, a write also marks the
+   * node as modified under the Fil::sys mutex.
+   *
+   * @param node - file node
+   * @param io_request - type of the i/o
+   */
+  void complete_io(fil_node_t *node, IO_request io_request);
+
+  /**
+   * @brief Looks up the file node of a page and prepares it for i/o without
+   * the Fil::sys mutex. Only handles a space with one file that is open and
+   * that nobody is closing, renaming or deleting, and a page inside the known
+   * size of the file.
+   *
+   * @param space_id - space id
+   * @param page_no - page number in the tablespace
+   * @return the file node with its pending count incremented, or nullptr if
+   *  prepare_io() must be used
+   */
+  fil_node_t *prepare_io_fast(space_id_t space_id, page_no_t page_no);
+
+  /**
+   * @brief Closes up to n_to_close open tablespace files, least recently used
+   * first. Only closes files without pending i/o or unflushed writes, the
+   * system tablespace and the log files are never closed. The caller must
+   * hold the Fil::sys mutex.
+   *
+   * @param n_to_close - number of files to close
+   * @return the number of files closed
+   */
+  ulint close_lru_files_low(ulint n_to_close);
+
+  /** The file closer thread. */
+  void file_closer();
+
+  /**
+   * Waits until no other thread extends a space and marks it as being
+   * extended, on success the caller owns the Fil::sys mutex.
+   *
+   * @param[in] space_id          space id
+   *
+   * @return the space or nullptr if it does not exist or is being deleted.
+   */
+  fil_space_t *space_begin_extend(space_id_t space_id);
+
+  /**
+   * Extends the last file of a space marked by space_begin_extend(), with
+   * fallocate() if the file system supports it else by writing zeroed
+   * pages. The Fil::sys mutex is released during the i/o and on return.
+   *
+   * @param[out] actual_size      size of the space after the extension
+   * @param[in,out] space         space to extend
+   * @param[in] size_after_extend desired size in pages after the extension
+   *
+   * @return true if success
+   */
+  bool space_extend_low(page_no_t *actual_size, fil_space_t *space, page_no_t size_after_extend);
+
   /**
    * @brief Checks if a single-table tablespace for a given table name
    * exists in the tablespace memory cache.
@@ -572,6 +808,17 @@ private:
   */
   bool space_is_flushed(fil_space_t *space) ;
 
+  /**
+   * Records that a file was flushed up to a modification count, takes the
+   * space off the unflushed list if all its files are flushed. The caller
+   * must hold the Fil::sys mutex.
+   *
+   * @param[in,out] space         space of the file
+   * @param[in,out] node          file that was flushed
+   * @param[in] old_mod_counter   modification count before the flush began
+   */
+  void node_flushed_low(fil_space_t *space, fil_node_t *node, int64_t old_mod_counter);
+
   /**
    * Opens a the file of a node of a tablespace.
    * The caller must own the Fil::system mutex.
@@ -667,16 +914,6 @@ private:
    */
   bool rename_tablespace_in_mem(fil_space_t *space, fil_node_t *node, const char *path);
 
-  /**
-  * @brief Allocates a file name for a single-table tablespace.
-  * The string must be freed by caller with mem_free().
-  * 
-  * @param name The table name or a dir path of a TEMPORARY table.
-  * @param is_temp True if it is a dir path.
-  * @return char* The allocated file name.
-  */
-  char *make_ibd_name(const char *name, bool is_temp);
-
   /**
   * @param recovery recovery flag
   * @param dbname database (or directory) name
@@ -684,15 +921,18 @@ private:
   */
   void load_single_table_tablespace(ib_recovery_t recovery, const char *dbname, const char *filename);
 
-  /** Scan the given directory and load the tablespaces. So that we can map the physical files back
+  /** The .ibd files found by scan_tablespace_files(), (dbname, filename) pairs. */
+  using Tablespace_files = std::vector<std::pair<std::string, std::string>>;
+
+  /** Scan the given directory for the tablespace files. So that we can map the physical files back
    * to their names that are stored in the data dictionary.
    * 
    * @param dir The directory to scan
-   * @param recovery The recovery flag
    * @param max_depth The maximum depth of the directory tree to scan
    * @param depth The current depth of the directory tree 
+   * @param files The files found are appended here
    */
-  db_err scan_and_load_tablespaces(const std::string &dir, ib_recovery_t recovery, ulint max_depth, ulint depth);
+  db_err scan_tablespace_files(const std::string &dir, ulint max_depth, ulint depth, Tablespace_files &files);
 
   /**
   * @brief Prepares a file node for i/o. Opens the file if it is closed. Updates the
@@ -705,6 +945,73 @@ private:
   */
   void node_prepare_for_io(fil_node_t *node, fil_space_t *space);
 
+  /**
+  * @brief Looks up the file node of a page and prepares it for i/o, see
+  * node_prepare_for_io(). Acquires and releases the Fil::sys mutex.
+  *
+  * @param io_request in: type of the i/o
+  * @param space_id in: space id
+  * @param page_no in/out: page number in the tablespace, on return the page
+  *   number in the file
+  * @param byte_offset in: offset of the i/o in the page
+  * @param len in: i/o length
+  * @return the file node or nullptr if the tablespace does not exist
+  */
+  fil_node_t *prepare_io(IO_request io_request, space_id_t space_id, page_no_t &page_no, ulint byte_offset, ulint len);
+
+  /**
+  * @brief Classifies a request for the i/o scheduling.
+  *
+  * @param io_request in: type of the i/o
+  * @param batched in: true if the request is part of a batch
+  * @return the class of the request
+  */
+  static IO_class get_io_class(IO_request io_request, bool batched) noexcept;
+
+  /**
+  * @brief Takes a page aligned buffer for the compressed image of a page
+  * write from the pool, the pool is grown if it is empty.
+  *
+  * @return the buffer, UNIV_PAGE_SIZE bytes
+  */
+  byte *comp_buf_acquire() noexcept;
+
+  /**
+  * @brief Returns a buffer taken with comp_buf_acquire() to the pool.
+  *
+  * @param buf in: the buffer
+  */
+  void comp_buf_release(byte *buf) noexcept;
+
+  /**
+  * @param node in: file node written to
+  * @param comp_len in: length of the compressed data of a page
+  * @return the length of the write of the compressed page
+  */
+  static ulint compressed_write_len(const fil_node_t *node, ulint comp_len) noexcept;
+
+  /**
+  * @brief Compresses a page that is about to be written to a single-table
+  * tablespace. The header of the page is kept, see FIL_PAGE_COMP_DATA.
+  *
+  * @param node in: file node the page is written to
+  * @param page in: the page, its checksums are already set
+  * @param len out: the length to write if the page was compressed
+  * @return the compressed image, nullptr if the page must be written as is
+  */
+  byte *compress_page(const fil_node_t *node, const byte *page, ulint &len) noexcept;
+
+  /**
+  * @brief Punches the unused tail of a compressed page out of the file after
+  * its write completed and returns the compressed image to the pool. The
+  * compression of the file is disabled if the file system does not support
+  * punching holes.
+  *
+  * @param node in: file node that was written
+  * @param comp_buf in: the compressed image that was written
+  */
+  void complete_compressed_write(fil_node_t *node, byte *comp_buf) noexcept;
+
   /**
   * @brief Report information about an invalid page access.
   *
@@ -742,8 +1049,39 @@ private:
   /** The mutex protecting the cache */
   mutable mutex_t m_mutex{};
 
+  /** The file closer is woken when this percentage of max_files_open files
+  is open. */
+  static constexpr ulint CLOSER_HIGH_WATER_PCT = 90;
+
+  /** The file closer closes files until this percentage of max_files_open
+  files is open. */
+  static constexpr ulint CLOSER_LOW_WATER_PCT = 80;
+
+  /** Number of shards of the map from space id to tablespace instance. */
+  static constexpr ulint N_SPACE_SHARDS = 64;
+
+  /** A shard of the map from space id to tablespace instance. A space is
+  added and removed with the Fil::sys mutex and the latch in exclusive
+  mode. It's looked up with either of them, prepare_io_fast() only takes
+  the latch in shared mode. */
+  struct alignas(64) Space_shard {
+    /** Protects m_spaces. */
+    std::shared_mutex m_latch{};
+
+    /** Map from space id to tablespace instance. */
+    std::unordered_map<space_id_t, fil_space_t*> m_spaces{};
+  };
+
+  /**
+   * @param id - space id
+   * @return the shard of a space id.
+   */
+  Space_shard &get_space_shard(space_id_t id) noexcept {
+    return m_space_shards[id % N_SPACE_SHARDS];
+  }
+
   /** Map from space id to tablespace instance. */
-  std::unordered_map<space_id_t, fil_space_t*> m_space_by_id{};
+  std::array<Space_shard, N_SPACE_SHARDS> m_space_shards{};
 
   /** Map from space name to the tablespace instance */
   std::unordered_map<std::string_view, fil_space_t*> m_space_by_name{};
@@ -754,6 +1092,22 @@ private:
   /** n_open is not allowed to exceed this */
   ulint m_max_n_open{};
 
+  /** Set to wake up the file closer when many files are open */
+  Cond_var *m_closer_event{};
+
+  /** True if the file closer is not running or must exit */
+  std::atomic<bool> m_closer_shutdown{true};
+
+  /** Number of spaces that hold a temporary table, space_is_temp() doesn't
+  take the mutex while there are none. */
+  std::atomic<ulint> m_n_temp_spaces{};
+
+  /** The file closer thread */
+  std::thread m_closer_thread{};
+
+  /** Loads the single-table tablespaces at startup, see start_loading_tablespaces() */
+  std::thread m_load_thread{};
+
   /** When we write to a file we increment this by one */
   int64_t m_modification_counter{};
 
@@ -774,6 +1128,19 @@ private:
 
   /** List of all file spaces */
   UT_LIST_BASE_NODE_T(fil_space_t, m_space_list) m_space_list;
+
+  /** Number of buffers for compressed page images allocated at a time. */
+  static constexpr ulint COMP_BUFS_PER_CHUNK = 16;
+
+  /** Protects m_comp_bufs and m_comp_buf_ptrs. */
+  std::mutex m_comp_bufs_mutex{};
+
+  /** Free buffers for the compressed images of the page writes, a buffer is
+  in use while its write is in flight. */
+  std::vector<byte *> m_comp_bufs{};
+
+  /** The allocations m_comp_bufs are carved from, freed by the destructor. */
+  std::vector<void *> m_comp_buf_ptrs{};
 };
 
 extern Fil *sys_fil;
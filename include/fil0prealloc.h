@@ -0,0 +1,136 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/fil0prealloc.h
+Extends the files of the tablespaces that are running out of free extents
+ahead of demand.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Cond_var;
+struct Fil;
+
+/** Tablespace preallocation.
+
+FSP::reserve_free_extents() calls request() when a single-table tablespace
+has few free extents left. The background thread then extends the file,
+not the space header, by file_preallocate_extents extents past the size in
+the space header, at most by an eighth of it. When the inserting thread
+extends the space later the file is already big enough, only the space
+header is changed and it doesn't wait for the file to grow. */
+struct Fil_prealloc {
+  /** A space has few free extents left when it has less than this many
+  extents more than the request needs. */
+  static constexpr ulint LOW_FREE_EXTENTS = 8;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] fil             Tablespace memory cache.
+   */
+  explicit Fil_prealloc(Fil *fil) noexcept;
+
+  /** Destructor. The thread must have been shut down. */
+  ~Fil_prealloc() noexcept;
+
+  /**
+   * Creates an instance, the thread is not started.
+   *
+   * @param[in] fil             Tablespace memory cache.
+   *
+   * @return the instance or nullptr if out of memory.
+   */
+  [[nodiscard]] static Fil_prealloc *create(Fil *fil) noexcept;
+
+  /**
+   * Destroys an instance.
+   *
+   * @param[in,out] prealloc    Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Fil_prealloc *&prealloc) noexcept;
+
+  /** Starts the background thread. */
+  void start() noexcept;
+
+  /** Stops the background thread, the pending requests are dropped. */
+  void shutdown() noexcept;
+
+  /**
+   * Requests that the file of a space is extended ahead of the space header.
+   * Does nothing if preallocation is disabled or the space is already queued.
+   *
+   * @param[in] space_id        Space that is running out of free extents.
+   * @param[in] size            Size of the space in pages in its header.
+   */
+  void request(space_id_t space_id, page_no_t size) noexcept;
+
+  /** @return the number of pages the files were extended by in the background. */
+  [[nodiscard]] ulint get_n_pages_preallocated() const noexcept {
+    return m_n_pages.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /** The background thread. */
+  void run() noexcept;
+
+  /** @return true if the thread should exit. */
+  [[nodiscard]] bool is_shutdown() const noexcept {
+    return m_shutdown.load(std::memory_order_acquire);
+  }
+
+ private:
+  /** A queued request. */
+  struct Request {
+    /** Space to extend. */
+    space_id_t m_space_id;
+
+    /** Size of the file in pages to extend it to. */
+    page_no_t m_size;
+  };
+
+  /** Tablespace memory cache. */
+  Fil *m_fil{};
+
+  /** Protects m_requests. */
+  std::mutex m_mutex{};
+
+  /** The spaces to extend, in the order of the requests. */
+  std::vector<Request> m_requests{};
+
+  /** Number of pages the files were extended by. */
+  std::atomic<ulint> m_n_pages{};
+
+  /** Set to true to make the thread exit. */
+  std::atomic<bool> m_shutdown{};
+
+  /** Set to wake up the thread on a request or shutdown. */
+  Cond_var *m_event{};
+
+  /** The preallocation thread. */
+  std::thread m_thread{};
+};
+
+/** The tablespace preallocator, nullptr if not running. */
+extern Fil_prealloc *srv_fil_prealloc;
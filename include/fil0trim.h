@@ -0,0 +1,163 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/fil0trim.h
+Deallocates the disk space of the extents that were freed in the tablespaces.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct Cond_var;
+struct FSP;
+
+/** Trimming of the freed extents.
+
+FSP::free_extent() calls request() when an extent goes back to the free list
+of a space. The background thread punches a hole over the extent in the file
+with FSP::trim_free_extent() once the checkpoint has passed the free, so that
+the recovery never applies log to the pages of the extent, and if the extent
+is still free. The file keeps its size, the SSD can reuse the blocks. */
+struct Fil_trim {
+  /** The thread retries the extents that can't be trimmed yet after a
+  checkpoint, it gives up on an extent after this many tries. */
+  static constexpr ulint MAX_TRIES = 64;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] fsp             File space management.
+   */
+  explicit Fil_trim(FSP *fsp) noexcept;
+
+  /** Destructor. The thread must have been shut down. */
+  ~Fil_trim() noexcept;
+
+  /**
+   * Creates an instance, the thread is not started.
+   *
+   * @param[in] fsp             File space management.
+   *
+   * @return the instance or nullptr if out of memory.
+   */
+  [[nodiscard]] static Fil_trim *create(FSP *fsp) noexcept;
+
+  /**
+   * Destroys an instance.
+   *
+   * @param[in,out] trim        Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Fil_trim *&trim) noexcept;
+
+  /** Starts the background thread. */
+  void start() noexcept;
+
+  /** Stops the background thread, the pending requests are dropped. */
+  void shutdown() noexcept;
+
+  /**
+   * Requests that a freed extent is trimmed. Does nothing if trimming is
+   * disabled.
+   *
+   * @param[in] space_id        Space of the extent.
+   * @param[in] page_no         First page of the extent.
+   */
+  void request(space_id_t space_id, page_no_t page_no) noexcept;
+
+  /** @return the number of pages trimmed. */
+  [[nodiscard]] ulint get_n_pages_trimmed() const noexcept {
+    return m_n_pages_trimmed.load(std::memory_order_relaxed);
+  }
+
+  /** @return the number of pages freed and not trimmed yet. */
+  [[nodiscard]] ulint get_n_pages_untrimmed() const noexcept {
+    return m_n_pages_untrimmed.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @param[in] space_id        Space to look up.
+   *
+   * @return the number of pages of a space freed and not trimmed yet.
+   */
+  [[nodiscard]] ulint get_n_pages_untrimmed(space_id_t space_id) noexcept;
+
+ private:
+  /** The background thread. */
+  void run() noexcept;
+
+  /** @return true if the thread should exit. */
+  [[nodiscard]] bool is_shutdown() const noexcept {
+    return m_shutdown.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Forgets an extent, it was trimmed or can't be.
+   *
+   * @param[in] space_id        Space of the extent.
+   */
+  void forget(space_id_t space_id) noexcept;
+
+ private:
+  /** A queued request. */
+  struct Request {
+    /** Space of the extent. */
+    space_id_t m_space_id;
+
+    /** First page of the extent. */
+    page_no_t m_page_no;
+
+    /** Number of times the extent could not be trimmed yet. */
+    ulint m_n_tries;
+  };
+
+  /** File space management. */
+  FSP *m_fsp{};
+
+  /** Protects m_requests and m_n_untrimmed. */
+  std::mutex m_mutex{};
+
+  /** The extents to trim. */
+  std::vector<Request> m_requests{};
+
+  /** Number of extents queued or being trimmed, by space. */
+  std::unordered_map<space_id_t, ulint> m_n_untrimmed{};
+
+  /** Number of pages trimmed. */
+  std::atomic<ulint> m_n_pages_trimmed{};
+
+  /** Number of pages queued or being trimmed. */
+  std::atomic<ulint> m_n_pages_untrimmed{};
+
+  /** Set to true to make the thread exit. */
+  std::atomic<bool> m_shutdown{};
+
+  /** Set to wake up the thread on a request or shutdown. */
+  Cond_var *m_event{};
+
+  /** The trim thread. */
+  std::thread m_thread{};
+};
+
+/** The extent trimmer, nullptr if not running. */
+extern Fil_trim *srv_fil_trim;
@@ -4,6 +4,10 @@
 
 #include "innodb0types.h"
 
+#include <array>
+#include <atomic>
+#include <string>
+
 #include "sync0rw.h"
 #include "ut0lst.h"
 
@@ -80,6 +84,21 @@ constexpr ulint FIL_PAGE_SPACE_ID = 34;
 /** start of the data on the page */
 constexpr ulint FIL_PAGE_DATA = 38;
 
+/* @} */
+/** Header of a page that Fil compressed before writing it, the fields
+before FIL_PAGE_DATA are those of the uncompressed page except for
+FIL_PAGE_TYPE @{ */
+
+/** FIL_PAGE_TYPE of the uncompressed page, 2 bytes */
+constexpr ulint FIL_PAGE_COMP_ORIG_TYPE = FIL_PAGE_DATA;
+
+/** Length of the compressed data, 2 bytes */
+constexpr ulint FIL_PAGE_COMP_LEN = FIL_PAGE_DATA + 2;
+
+/** Start of the compressed data, it is the LZ4 compressed bytes of the
+uncompressed page from FIL_PAGE_DATA to the end of the page */
+constexpr ulint FIL_PAGE_COMP_DATA = FIL_PAGE_DATA + 4;
+
 /* @} */
 /** File page trailer @{ */
 
@@ -121,7 +140,11 @@ enum Fil_page_type {
   FIL_PAGE_TYPE_XDES = 9,
 
   /** Uncompressed BLOB page */
-  FIL_PAGE_TYPE_BLOB = 10
+  FIL_PAGE_TYPE_BLOB = 10,
+
+  /** A page that was compressed when it was written, see FIL_PAGE_COMP_DATA.
+  Only found in the data files, the buffer pool frames are uncompressed. */
+  FIL_PAGE_TYPE_COMPRESSED = 14
 };
 
 /* @} */
@@ -142,6 +165,108 @@ constexpr uint32_t FIL_NODE_MAGIC_N = 89389;
 
 struct fil_space_t;
 
+namespace ut {
+struct Latency_histogram;
+} // namespace ut
+
+/** Kind of the pages that an i/o transfers, see Fil_space_io_stats. */
+enum class Fil_io_page_class : uint8_t {
+  /** B-tree pages */
+  INDEX,
+
+  /** Undo log pages */
+  UNDO,
+
+  /** BLOB pages */
+  BLOB,
+
+  /** Space management, inode, transaction system and the other pages */
+  SYSTEM,
+
+  /** Redo log i/o, and the i/o that does not start at a page boundary */
+  OTHER
+};
+
+/** Number of Fil_io_page_class values. */
+constexpr ulint FIL_IO_PAGE_CLASS_COUNT = ulint(Fil_io_page_class::OTHER) + 1;
+
+/** I/O statistics of a tablespace, updated when a request to one of its
+files completes. A write that was coalesced with its neighbours counts as
+one i/o of the kind of its first page. */
+struct Fil_space_io_stats {
+  /** Counters of the reads or of the writes of one kind of page. */
+  struct Counters {
+    /** Number of completed requests */
+    std::atomic<uint64_t> m_n_ios{};
+
+    /** Bytes transferred */
+    std::atomic<uint64_t> m_n_bytes{};
+
+    /** Sum of the submit to completion latencies in microseconds */
+    std::atomic<uint64_t> m_latency_us{};
+  };
+
+  using Counters_by_class = std::array<Counters, FIL_IO_PAGE_CLASS_COUNT>;
+
+  /**
+   * @brief Returns the kind of the pages of a request.
+   *
+   * @param[in] ptr First buffer of the request.
+   * @param[in] len Number of bytes transferred.
+   * @param[in] off File offset of the request.
+   * @return the kind of the first page, OTHER if the request does not start
+   *  at a page boundary.
+   */
+  [[nodiscard]] static Fil_io_page_class get_page_class(const byte *ptr, ulint len, off_t off) noexcept;
+
+  /**
+   * @brief Adds a completed request.
+   *
+   * @param[in] is_read true for a read, false for a write.
+   * @param[in] page_class Kind of the pages transferred.
+   * @param[in] len Number of bytes transferred.
+   * @param[in] us Latency in microseconds.
+   */
+  void add(bool is_read, Fil_io_page_class page_class, ulint len, uint64_t us) noexcept {
+    auto &counters = (is_read ? m_reads : m_writes)[ulint(page_class)];
+
+    counters.m_n_ios.fetch_add(1, std::memory_order_relaxed);
+    counters.m_n_bytes.fetch_add(len, std::memory_order_relaxed);
+    counters.m_latency_us.fetch_add(us, std::memory_order_relaxed);
+  }
+
+  /** Reads by kind of page */
+  Counters_by_class m_reads{};
+
+  /** Writes by kind of page */
+  Counters_by_class m_writes{};
+};
+
+/** Copy of the i/o statistics of a tablespace, see Fil::get_io_stats(). */
+struct Fil_space_io_snapshot {
+  /** Values of Fil_space_io_stats::Counters */
+  struct Counts {
+    uint64_t m_n_ios{};
+    uint64_t m_n_bytes{};
+    uint64_t m_latency_us{};
+  };
+
+  /** Space id */
+  space_id_t m_space_id{};
+
+  /** Space name */
+  std::string m_name{};
+
+  /** Reads by kind of page */
+  std::array<Counts, FIL_IO_PAGE_CLASS_COUNT> m_reads{};
+
+  /** Writes by kind of page */
+  std::array<Counts, FIL_IO_PAGE_CLASS_COUNT> m_writes{};
+
+  /** Number of i/o requests to the files of the space that did not complete */
+  ulint m_n_pending{};
+};
+
 /** File node of a tablespace or the log data space */
 struct fil_node_t {
   /** backpointer to the space where this node belongs */
@@ -150,23 +275,54 @@ struct fil_node_t {
   /** path to the file */
   char *m_file_name;
 
-  /** true if file open */
-  bool open;
+  /** true if file open, set with the Fil::sys mutex; Fil::prepare_io_fast()
+  reads it without the mutex */
+  std::atomic<bool> open;
+
+  /** set by the thread that closes the file before it checks m_n_pending,
+  a thread that doesn't hold the Fil::sys mutex must not start i/o on the
+  file while it is set */
+  std::atomic<bool> m_closing;
 
   /** OS handle to the file, if file open */
   os_file_t m_fh;
 
+  /** Index of the file in the files registered with the AIO io_urings,
+  -1 if it is not registered */
+  int m_fixed_fd;
+
   /** true if the 'file' is actually a raw device or a raw
   disk partition */
   bool m_is_raw_disk;
 
+  /** true if the file was found to support atomic page writes when it
+  was opened, the writes to it are then issued with RWF_ATOMIC */
+  bool m_atomic_writes;
+
+  /** true if the pages written to the file can be compressed, it is cleared
+  when the file system turns out not to support punching holes in it */
+  std::atomic<bool> m_punch_hole;
+
+  /** size of the allocation unit of the file system in bytes, a compressed
+  page is written rounded up to it and the rest of the page is punched */
+  ulint m_block_size;
+
+  /** alignment that O_DIRECT requires of the i/o to the file, 0 if the
+  file is not open or not opened with O_DIRECT */
+  ulint m_direct_io_align;
+
   /** size of the file in database pages, 0 if not known yet;
   the possible last incomplete megabyte may be ignored if space == 0 */
   page_no_t m_size_in_pages;
 
   /** count of pending i/o's on this file; closing of the file is not
-  allowed if this is > 0 */
-  uint32_t m_n_pending;
+  allowed if this is > 0. Incremented and decremented without the Fil::sys
+  mutex by the reads that take the fast path */
+  std::atomic<uint32_t> m_n_pending;
+
+  /** time of the last i/o to the file in milliseconds, the file closer
+  closes the least recently used files first */
+  std::atomic<uint64_t> m_last_access;
 
   /** count of pending flushes on this file; closing of the file
   is not allowed if this is > 0 */
@@ -209,13 +365,17 @@ struct fil_space_t {
 
   /** true if we want to rename the .ibd file of tablespace and want to
   stop temporarily posting of new i/o requests on the file */
-  bool m_stop_ios;
+  std::atomic<bool> m_stop_ios;
 
   /** this is set to true when we start deleting a single-table tablespace
   and its file; when this flag is set no further i/o or flush requests can
   be placed on this space, though there may be such requests still being
   processed on this space */
-  bool m_is_being_deleted;
+  std::atomic<bool> m_is_being_deleted;
+
+  /** true while a thread extends the last file of the space, the other
+  threads wait for it to finish */
+  bool m_is_extending;
 
   /** FIL_TABLESPACE or FIL_LOG */
   Fil_type m_type;
@@ -231,6 +391,21 @@ struct fil_space_t {
   /** File format, or 0 */
   uint32_t m_flags;
 
+  /** true if all the files of the space support atomic page writes */
+  bool m_atomic_writes;
+
+  /** true if the space holds a temporary table. Its file is not found by
+  crash recovery and the table is dropped at startup, so its pages bypass
+  the doublewrite buffer and its file is never fsync'ed. */
+  bool m_is_temp;
+
+  /** Latencies of the i/o requests to the files of the space */
+  ut::Latency_histogram *m_io_latency;
+
+  /** Counts, bytes and latencies of the i/o requests to the files of the
+  space by kind of page */
+  Fil_space_io_stats *m_io_stats;
+
   /** number of reserved free extents for ongoing operations like B-tree
   page split */
   uint32_t m_n_reserved_extents;
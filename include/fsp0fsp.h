@@ -32,6 +32,10 @@ Created 12/18/1995 Heikki Tuuri
 #include "page0types.h"
 #include "ut0byte.h"
 
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
 struct Log;
 struct Fil;
 struct Buf_pool;
@@ -63,6 +67,21 @@ struct FSP {
    */
   using fseg_inode_t = byte;
 
+  /** Result of trim_free_extent(). */
+  enum class Trim_status {
+    /** The extent was trimmed. */
+    Trimmed,
+
+    /** The extent is no longer free. */
+    Not_free,
+
+    /** The extent can be trimmed after the next checkpoint. */
+    Retry,
+
+    /** The space was dropped or its file doesn't support punching holes. */
+    Failed
+  };
+
   /** Consutructor.
    * 
    * @param[in] log             Log instance
@@ -128,6 +147,16 @@ struct FSP {
    */
   [[nodiscard]] ulint get_flags(const page_t *page) noexcept;
 
+  /**
+   * Reads the page size the tablespace was created with from its first page.
+   * Only the start of the page is read, it can be a page of any size.
+   * 
+   * @param[in] page            Header page (page 0 in the tablespace).
+   * 
+   * @return	the 2-logarithm of the page size
+   */
+  [[nodiscard]] static ulint get_page_size_shift(const page_t *page) noexcept;
+
   /**
    * Writes the space id and compressed page size to a tablespace header.
    * This function is used past the buffer pool when we in fil0fil.c create
@@ -410,6 +439,19 @@ struct FSP {
    */
   [[nodiscard]] ulint get_size_low(page_t *page) noexcept;
 
+  /**
+   * Deallocates the disk space of a free extent, see Fil_trim. The extent is
+   * only trimmed if the last checkpoint is past the last change to the space
+   * header, it is then past the free of the extent and the recovery doesn't
+   * apply the log of the pages of the extent to the zeroed blocks.
+   *
+   * @param[in] space           Tablespace ID.
+   * @param[in] page            First page of the extent.
+   *
+   * @return the outcome.
+   */
+  [[nodiscard]] Trim_status trim_free_extent(space_id_t space, page_no_t page) noexcept;
+
 private:
   /**
    * Returns an extent to the free list of a space.
@@ -616,6 +658,19 @@ private:
    */
   void fseg_fill_free_list(fseg_inode_t *inode, space_id_t space, page_no_t hint, mtr_t *mtr) noexcept;
 
+  /**
+   * Returns the number of extents to add to the free list of a segment. It
+   * starts at FSEG_FREE_LIST_MAX_LEN and doubles each time the free list runs
+   * out again soon after it was filled, it halves when the segment grows
+   * slowly. It is at most an eighth of the size of the segment.
+   *
+   * @param[in] seg_id            The segment id.
+   * @param[in] n_reserved        Number of pages reserved by the segment.
+   *
+   * @return the number of extents to add.
+   */
+  [[nodiscard]] ulint fseg_get_fill_size(uint64_t seg_id, ulint n_reserved) noexcept;
+
   /**
    * Allocates a free extent for the segment: looks first in the free list of the
    * segment, then tries to allocate from the space free list. NOTE that the extent
@@ -704,4 +759,23 @@ public:
   Fil *m_fil{};
 
   Buf_pool *m_buf_pool{};
+
+private:
+  /** Recent growth of a segment, see fseg_get_fill_size(). */
+  struct Fseg_growth {
+    /** When the free list of the segment was last filled. */
+    std::chrono::steady_clock::time_point m_last_fill;
+
+    /** Number of extents added to the free list on the last fill. */
+    ulint m_n_extents;
+  };
+
+  /** Protects m_fseg_growth, the segments of different spaces grow
+  concurrently. */
+  std::mutex m_fseg_growth_mutex{};
+
+  /** The growth of the segments whose free list was filled, by segment id.
+  Only kept in memory, a segment starts again from the minimum after a
+  restart. */
+  std::unordered_map<uint64_t, Fseg_growth> m_fseg_growth{};
 };
@@ -48,8 +48,10 @@ constexpr byte FSP_NO_DIR = 113;
 
 /* @} */
 
-/** File space extent size (one megabyte) in pages */
-constexpr ulint FSP_EXTENT_SIZE = 1 << (20 - UNIV_PAGE_SIZE_SHIFT);
+/** File space extent size in pages: one megabyte up to 16K pages, 64 pages
+above that so that the descriptors of the extents that a descriptor page
+covers still fit on it */
+constexpr ulint FSP_EXTENT_SIZE = UNIV_PAGE_SIZE_SHIFT <= 14 ? 1 << (20 - UNIV_PAGE_SIZE_SHIFT) : 64;
 
 /** On a page of any file segment, data may be put starting from this offset */
 constexpr auto FSEG_PAGE_DATA = FIL_PAGE_DATA;
@@ -52,8 +52,17 @@ constexpr ulint UNIV_MEM_ALIGNMENT = 8;
 /** The following alignment is used in aligning lints etc. */
 constexpr ulint UNIV_WORD_ALIGNMENT = UNIV_WORD_SIZE;
 
-/** The 2-logarithm of UNIV_PAGE_SIZE: */
+/** The 2-logarithm of UNIV_PAGE_SIZE, set with -DIB_PAGE_SIZE when the
+library is built. It stays a constant so that the page arithmetic is folded
+by the compiler, the size a database was created with is in the header of
+its system tablespace and it can only be opened by a build with that size. */
+#ifdef IB_PAGE_SIZE_SHIFT
+constexpr ulint UNIV_PAGE_SIZE_SHIFT = IB_PAGE_SIZE_SHIFT;
+#else
 constexpr ulint UNIV_PAGE_SIZE_SHIFT = 14;
+#endif /* IB_PAGE_SIZE_SHIFT */
+
+static_assert(UNIV_PAGE_SIZE_SHIFT >= 12 && UNIV_PAGE_SIZE_SHIFT <= 16, "The page size must be 4K, 8K, 16K, 32K or 64K");
 
 /** The universal page size of the database */
 constexpr ulint UNIV_PAGE_SIZE = 1UL << UNIV_PAGE_SIZE_SHIFT;
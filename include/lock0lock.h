@@ -32,8 +32,14 @@ Created 5/7/1996 Heikki Tuuri
 #include "row0vers.h"
 #include "srv0srv.h"
 
+#include <array>
+#include <functional>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 struct Trx_sys;
 struct Buf_block;
@@ -48,6 +54,205 @@ extern bool lock_print_waits;
 /* Buffer for storing information about the most recent deadlock error */
 extern ib_stream_t lock_latest_err_stream;
 
+/**
+ * The record locks of the pages, partitioned by page id into shards that are
+ * hash tables of their own. A shard is rehashed on its own when it grows, so
+ * an insert under the kernel mutex never rehashes the locks of all the pages.
+ * It has the subset of the std::unordered_map interface that the lock system
+ * uses.
+ *
+ * The lock lists of the pages are protected by the kernel mutex. Each shard
+ * also has a latch: a page is added and removed with the kernel mutex and the
+ * latch of its shard in exclusive mode. It's looked up with either of them,
+ * has_locks() only takes the latch in shared mode. Latch order: the kernel
+ * mutex before a shard latch, a thread holds at most one shard latch and
+ * doesn't wait for anything else while it holds it.
+ */
+struct Rec_lock_hash {
+  /** Number of shards, a power of 2. */
+  static constexpr size_t N_SHARDS = 64;
+
+  using Shard = Page_id_hash<Rec_locks>;
+  using Shards = std::array<Shard, N_SHARDS>;
+
+  /** Latch of a shard, see above. */
+  struct alignas(64) Shard_latch {
+    std::shared_mutex m_latch{};
+  };
+
+  /** Iterates over the pages of all the shards. */
+  template <bool Const>
+  struct Iterator {
+    using Shards_t = std::conditional_t<Const, const Shards, Shards>;
+    using Base = std::conditional_t<Const, Shard::const_iterator, Shard::iterator>;
+    using value_type = Shard::value_type;
+    using reference = std::conditional_t<Const, const value_type &, value_type &>;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+    /**
+     * Constructor.
+     *
+     * @param[in] shards      The shards.
+     * @param[in] shard       Shard of it, N_SHARDS for the end.
+     * @param[in] it          Position in the shard.
+     */
+    Iterator(Shards_t *shards, size_t shard, Base it) noexcept : m_shards(shards), m_shard(shard), m_it(it) {
+      skip_empty();
+    }
+
+    reference operator*() const noexcept { return *m_it; }
+
+    pointer operator->() const noexcept { return &*m_it; }
+
+    Iterator &operator++() noexcept {
+      ++m_it;
+      skip_empty();
+      return *this;
+    }
+
+    bool operator==(const Iterator &rhs) const noexcept {
+      return m_shard == rhs.m_shard && (m_shard == N_SHARDS || m_it == rhs.m_it);
+    }
+
+    /** Moves to the first page of the next non empty shard if at the end of a shard. */
+    void skip_empty() noexcept {
+      while (m_shard < N_SHARDS && m_it == (*m_shards)[m_shard].end()) {
+        if (++m_shard < N_SHARDS) {
+          m_it = (*m_shards)[m_shard].begin();
+        }
+      }
+    }
+
+    /** The shards. */
+    Shards_t *m_shards{};
+
+    /** Shard of m_it, N_SHARDS at the end. */
+    size_t m_shard{};
+
+    /** Position in the shard. */
+    Base m_it{};
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  iterator begin() noexcept { return iterator(&m_shards, 0, m_shards[0].begin()); }
+
+  iterator end() noexcept { return iterator(&m_shards, N_SHARDS, {}); }
+
+  const_iterator begin() const noexcept { return const_iterator(&m_shards, 0, m_shards[0].begin()); }
+
+  const_iterator end() const noexcept { return const_iterator(&m_shards, N_SHARDS, {}); }
+
+  /**
+   * @param[in] page_id        Page to find.
+   *
+   * @return the locks of the page, or end().
+   */
+  iterator find(const Page_id &page_id) noexcept {
+    auto &shard = m_shards[shard_of(page_id)];
+    auto it = shard.find(page_id);
+
+    return it == shard.end() ? end() : iterator(&m_shards, shard_of(page_id), it);
+  }
+
+  /**
+   * @param[in] page_id        Page to find.
+   *
+   * @return the locks of the page, or end().
+   */
+  const_iterator find(const Page_id &page_id) const noexcept {
+    const auto &shard = m_shards[shard_of(page_id)];
+    auto it = shard.find(page_id);
+
+    return it == shard.end() ? end() : const_iterator(&m_shards, shard_of(page_id), it);
+  }
+
+  /**
+   * Adds the locks of a page.
+   *
+   * @param[in] page_id        Page of the locks.
+   * @param[in] rec_locks      Locks of the page.
+   *
+   * @return the position of the page and true if it was added.
+   */
+  std::pair<iterator, bool> emplace(const Page_id &page_id, Rec_locks &&rec_locks) noexcept {
+    const auto i = shard_of(page_id);
+    std::unique_lock<std::shared_mutex> latch(m_latches[i].m_latch);
+    auto [it, inserted] = m_shards[i].emplace(page_id, std::move(rec_locks));
+
+    return {iterator(&m_shards, i, it), inserted};
+  }
+
+  /**
+   * Removes the locks of a page.
+   *
+   * @param[in] it             Position of the page.
+   */
+  void erase(iterator it) noexcept {
+    std::unique_lock<std::shared_mutex> latch(m_latches[it.m_shard].m_latch);
+    m_shards[it.m_shard].erase(it.m_it);
+  }
+
+  /**
+   * Removes the locks of a page.
+   *
+   * @param[in] page_id        Page of the locks.
+   *
+   * @return the number of pages removed.
+   */
+  size_t erase(const Page_id &page_id) noexcept {
+    const auto i = shard_of(page_id);
+    std::unique_lock<std::shared_mutex> latch(m_latches[i].m_latch);
+
+    return m_shards[i].erase(page_id);
+  }
+
+  /**
+   * Checks if a page has locks, the kernel mutex need not be owned. The
+   * answer stays valid only while no lock can be added to the page, e.g.,
+   * while the page is x-latched.
+   *
+   * @param[in] page_id        Page to check.
+   *
+   * @return true if the page has a lock list, it can be empty.
+   */
+  bool has_locks(const Page_id &page_id) const noexcept {
+    const auto i = shard_of(page_id);
+    std::shared_lock<std::shared_mutex> latch(m_latches[i].m_latch);
+
+    return m_shards[i].contains(page_id);
+  }
+
+  /** @return the number of pages that have locks. */
+  size_t size() const noexcept {
+    size_t n{};
+
+    for (const auto &shard : m_shards) {
+      n += shard.size();
+    }
+
+    return n;
+  }
+
+ private:
+  /**
+   * @param[in] page_id        Page.
+   *
+   * @return the shard of the page.
+   */
+  static size_t shard_of(const Page_id &page_id) noexcept {
+    /* Consecutive pages go to different shards. */
+    return (page_id.m_page_no ^ (page_id.m_space_id * 31)) & (N_SHARDS - 1);
+  }
+
+  /** The shards. */
+  Shards m_shards{};
+
+  /** The latches of the shards. */
+  mutable std::array<Shard_latch, N_SHARDS> m_latches{};
+};
+
 struct Lock_sys {
   /**
    * Creates the lock system at database start.
@@ -489,6 +694,21 @@ struct Lock_sys {
    */
   void cancel_waiting_and_release(Lock *lock) noexcept;
 
+  /**
+   * @brief Cancels the lock wait of a non-blocking transaction.
+   *
+   * If the transaction still waits for a lock, the request is cancelled and the callback is
+   * invoked the next time a transaction releases its locks, when the request may succeed.
+   * The callback is invoked with the kernel mutex held, it must not block.
+   *
+   * @param[in,out] trx The transaction that got DB_LOCK_WAIT.
+   * @param[in] callback Invoked once the lock request should be retried.
+   *
+   * @return true if the wait was cancelled, false if the lock was already granted or the
+   *  transaction was chosen as a deadlock victim.
+   */
+  [[nodiscard]] bool cancel_wait_nonblocking(Trx *trx, std::function<void()> callback) noexcept;
+
   /**
    * @brief Removes locks on a table to be dropped or truncated.
    *
@@ -531,6 +751,17 @@ struct Lock_sys {
    */
   [[nodiscard]] bool is_table_exclusive(Table *table, Trx *trx) noexcept;
 
+  /**
+   * @brief Checks if the transaction holds a LOCK_X on the table. No other
+   * transaction can then have locks on the table or any of its records.
+   *
+   * @param[in] table The table to check.
+   * @param[in] trx The transaction to check.
+   *
+   * @return true if trx holds a granted LOCK_X on the table.
+   */
+  [[nodiscard]] bool is_table_x_locked(Table *table, Trx *trx) noexcept;
+
   /**
    * @brief Checks that a transaction id is sensible, i.e., not in the future.
    *
@@ -726,6 +957,31 @@ struct Lock_sys {
 private:
 #endif /* !UNIT_TESTING */
 
+  /**
+   * @brief Allocates a lock object from the pool of the transaction.
+   *
+   * When the free list of the size class is empty, a slab of locks of that
+   * size is carved from the transaction lock heap.
+   *
+   * @param[in,out] trx Transaction that will own the lock.
+   * @param[in] n_bytes Size of the lock bitmap in bytes, as returned by
+   *                    Lock_pool::bitmap_size(), 0 for a table lock.
+   *
+   * @return an uninitialized lock object with room for the bitmap.
+   */
+  [[nodiscard]] Lock *lock_alloc(Trx *trx, ulint n_bytes) noexcept;
+
+  /**
+   * @brief Returns a lock object to the pool of its transaction.
+   *
+   * The lock must have been removed from the lock queues and from the lock
+   * list of the transaction. Its type, mode and owner stay valid until the
+   * transaction creates another lock.
+   *
+   * @param[in,out] lock The lock to free.
+   */
+  void lock_free(Lock *lock) noexcept;
+
   /**
    * @brief Creates a new record lock and inserts it into the lock queue.
    *
@@ -811,27 +1067,46 @@ private:
   [[nodiscard]] bool deadlock_occurs(Lock *lock, Trx *trx) noexcept;
 
   /**
-   * @brief Looks recursively for a deadlock.
+   * @brief Looks for a deadlock with an iterative depth first search of the waits-for graph.
    *
-   * This function performs a recursive search to detect deadlocks in the lock system.
-   * It checks if the transaction `trx` waiting for the lock `wait_lock` causes a deadlock
-   * starting from the transaction `start`.
+   * This function checks if the transaction `start` waiting for the lock `wait_lock` causes
+   * a deadlock. The search uses an explicit stack (m_deadlock_stack) instead of recursion,
+   * and skips the transactions whose m_deadlock_mark equals m_deadlock_epoch, i.e., whose
+   * subtree has already been searched exhaustively by this search.
    *
-   * @param[in] start The recursion starting point.
-   * @param[in] trx A transaction waiting for a lock.
+   * @param[in] start The transaction requesting the lock.
    * @param[in] wait_lock The lock that is waiting to be granted.
-   * @param[in,out] cost The number of calculation steps thus far. If this exceeds
-   *                     LOCK_MAX_N_STEPS_..., the function returns LOCK_EXCEED_MAX_DEPTH.
-   * @param[in] depth The recursion depth. If this exceeds LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK,
-   *                  the function returns LOCK_EXCEED_MAX_DEPTH.
    *
    * @return 0 if no deadlock is found.
    * @return LOCK_VICTIM_IS_START if a deadlock is found and 'start' is chosen as the victim.
    * @return LOCK_VICTIM_IS_OTHER if a deadlock is found and another transaction is chosen as the victim.
    *         In this case, the search must be repeated as there may be another deadlock.
-   * @return LOCK_EXCEED_MAX_DEPTH if the lock search exceeds the maximum steps or depth.
+   * @return LOCK_EXCEED_MAX_DEPTH if the search exceeds LOCK_MAX_N_STEPS_IN_DEADLOCK_CHECK steps
+   *         or LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK depth.
+   */
+  [[nodiscard]] ulint deadlock_search(Trx *start, Lock *wait_lock) noexcept;
+
+  /**
+   * @brief Returns the first lock ahead of wait_lock in its queue that wait_lock may have to wait for.
+   *
+   * @param[in] wait_lock The waiting lock.
+   * @param[out] heap_no The heap number of the record wait_lock is waiting for, or
+   *                     ULINT_UNDEFINED for a table lock.
+   *
+   * @return the lock, or nullptr if there is none.
+   */
+  [[nodiscard]] Lock *deadlock_first_ahead(Lock *wait_lock, ulint &heap_no) noexcept;
+
+  /**
+   * @brief Returns the lock after lock that is ahead of wait_lock in its queue.
+   *
+   * @param[in] wait_lock The waiting lock.
+   * @param[in] lock A lock ahead of wait_lock, returned by a previous call or deadlock_first_ahead().
+   * @param[in] heap_no As returned by deadlock_first_ahead().
+   *
+   * @return the lock, or nullptr if wait_lock has been reached.
    */
-  [[nodiscard]] ulint deadlock_recursive(Trx *start, Trx *trx, Lock *wait_lock, ulint *cost, ulint depth) noexcept;
+  [[nodiscard]] static Lock *deadlock_next_ahead(Lock *wait_lock, Lock *lock, ulint heap_no) noexcept;
 
   /**
    * @brief Gets the wait flag of a lock.
@@ -1013,6 +1288,18 @@ private:
    */
   [[nodiscard]] inline bool rec_lock_fast(bool impl, Lock_mode mode, const Buf_block *block, ulint heap_no, const Index *index, que_thr_t *thr) noexcept;
 
+  /**
+   * Checks without the kernel mutex if a modification of a record on an
+   * x-latched page needs no lock struct: there are no locks on the page and
+   * the caller checked that no other transaction can hold an implicit lock
+   * on the record. See Rec_lock_hash for the latching.
+   *
+   * @param[in] block Buffer block containing the record, x-latched.
+   *
+   * @return true if the modification can proceed with an implicit lock.
+   */
+  [[nodiscard]] bool rec_modify_check_fast(const Buf_block *block) const noexcept;
+
   /**
    * @brief General, slower routine for locking a record.
    *
@@ -1069,6 +1356,36 @@ private:
    */
   [[nodiscard]] bool rec_has_to_wait_in_queue(const Rec_locks &rec_locks, Lock *wait_lock, ulint heap_no) const noexcept;
 
+  /**
+   * @brief Checks if a waiting record lock request has to wait for a granted lock.
+   *
+   * Unlike rec_has_to_wait_in_queue(), the waiting requests and the position
+   * in the queue are ignored.
+   *
+   * @param[in] rec_locks The record locks to check.
+   * @param[in] wait_lock The lock request that is waiting.
+   * @param[in] heap_no The heap number of the record.
+   * 
+   * @return true if a granted lock blocks the request, false otherwise.
+   */
+  [[nodiscard]] bool rec_has_to_wait_for_granted(const Rec_locks &rec_locks, Lock *wait_lock, ulint heap_no) const noexcept;
+
+  /**
+   * @brief Grants the waiting record lock requests of a page that no longer have to wait.
+   *
+   * By default the requests are granted in queue order, a request waits for the
+   * requests ahead of it. With srv_config.m_lock_grant_by_weight the requests
+   * are considered by the number of locks their transaction holds, the most
+   * first, and a request is granted if no granted lock blocks it. A transaction
+   * that holds many locks usually blocks others, letting it finish first shortens
+   * the waits on hot rows. A lock granted out of order is moved to the front of
+   * the queue, so that the requests still waiting find it ahead of them.
+   *
+   * @param[in,out] rec_locks The record locks of the page.
+   * @param[in] heap_no Only grant requests on this record, or ULINT_UNDEFINED for all records.
+   */
+  void rec_grant_waiting(Rec_locks &rec_locks, ulint heap_no) noexcept;
+
   /**
    * @brief Grants a lock to a waiting lock request and releases the waiting transaction.
    *
@@ -1361,10 +1678,10 @@ private:
   /**
    * @brief The lock table.
    *
-   * This unordered map holds the locks for each page in the buffer pool.
+   * This sharded hash table holds the locks for each page in the buffer pool.
    * The key is the page ID, and the value is the list of locks on that page.
    */
-  Page_id_hash<Rec_locks> m_rec_locks{};
+  Rec_lock_hash m_rec_locks{};
   
   /**
    * @brief The buffer pool.
@@ -1382,6 +1699,58 @@ private:
    */
   Trx_sys *m_trx_sys{};
 
+  /** A transaction on the path of the deadlock search. */
+  struct Deadlock_frame {
+    /** The transaction waiting for m_wait_lock. */
+    Trx *m_trx;
+
+    /** The lock m_trx is waiting for. */
+    Lock *m_wait_lock;
+
+    /** The next lock ahead of m_wait_lock to check, or nullptr. */
+    Lock *m_lock;
+
+    /** Heap number of the record m_wait_lock is waiting for, or ULINT_UNDEFINED. */
+    ulint m_heap_no;
+  };
+
+  /**
+   * @brief Identifies the current deadlock search, protected by the kernel mutex.
+   *
+   * A transaction whose Trx::m_deadlock_mark equals this value has been searched
+   * exhaustively by the current search. Incrementing it clears all the marks
+   * without visiting every transaction.
+   */
+  uint64_t m_deadlock_epoch{};
+
+  /**
+   * @brief Stack of the deadlock search, protected by the kernel mutex.
+   *
+   * Kept here so that its memory is reused by every search.
+   */
+  std::vector<Deadlock_frame> m_deadlock_stack{};
+
+  /**
+   * @brief Copies of the record locks of a page being reorganized, protected by the kernel mutex.
+   *
+   * Kept here so that its memory is reused by every reorganization.
+   */
+  std::vector<byte> m_reorganize_buf{};
+
+  /**
+   * @brief Waiting locks considered by rec_grant_waiting(), protected by the kernel mutex.
+   *
+   * Kept here so that its memory is reused by every grant.
+   */
+  std::vector<Lock *> m_grant_candidates{};
+
+  /**
+   * @brief Callbacks of cancel_wait_nonblocking(), protected by the kernel mutex.
+   *
+   * They are invoked by release_off_kernel().
+   */
+  std::vector<std::function<void()>> m_release_waiters{};
+
   /**
    * @brief Whether to print the InnoDB lock monitor.
    *
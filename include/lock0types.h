@@ -30,6 +30,11 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 #include "mem0types.h"
 #include "ut0lst.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+
 struct Lock;
 struct Trx;
 struct Buf_pool;
@@ -527,16 +532,27 @@ struct Lock {
   }
 
   /**
-   * @brief Copies a record lock to the specified memory heap.
+   * @brief Copies a record lock to the specified buffer.
    *
-   * This function creates a copy of the given record lock and stores it in the provided memory heap.
+   * This function creates a copy of the given record lock in the buffer.
    * The copied lock includes the lock structure and its associated bitmap.
    *
-   * @param[in] heap The memory heap where the lock copy will be stored.
+   * @param[out] ptr The buffer where the lock copy will be stored, it must
+   *                 have room for rec_size() bytes.
    * 
    * @return A pointer to the copied lock.
    */
-  [[nodiscard]] inline Lock *rec_clone(mem_heap_t *heap) const noexcept;
+  [[nodiscard]] Lock *rec_clone(void *ptr) const noexcept;
+
+  /**
+   * @brief Gets the size of a record lock including its bitmap.
+   *
+   * @return The size of the lock structure and its bitmap in bytes.
+   */
+  [[nodiscard]] ulint rec_size() const noexcept {
+    ut_ad(type() == LOCK_REC);
+    return sizeof(Lock) + rec_get_n_bits() / 8;
+  }
 
   /**
    * @brief Gets the mode of a lock in a human readable string.
@@ -676,6 +692,88 @@ static_assert(sizeof(Lock) <= 64, "Lock must be 64 bytes or smaller");
 /** We need this to read beyond Lock. */
 static_assert(std::is_standard_layout<Lock>::value, "Lock must have a standard layout");
 
+/** Per transaction free lists of lock objects. The objects are carved in
+slabs from the transaction lock heap and a lock that is removed before the
+transaction ends goes back to its free list, the memory is returned when
+the lock heap is emptied. Record locks are kept in size classes by the size
+of their bitmap, rounded up to a power of two. Table locks have no bitmap
+and use class 0. */
+struct Lock_pool {
+  /** The smallest record lock bitmap is 2^MIN_BITMAP_SHIFT bytes. */
+  static constexpr ulint MIN_BITMAP_SHIFT = 4;
+
+  /** Number of size classes, the largest pooled bitmap is 2 KB, enough
+  for the heap numbers of a 16 KB page. Larger locks are not pooled. */
+  static constexpr ulint N_SIZE_CLASSES = 9;
+
+  /** Bytes carved from the lock heap when a free list is empty. */
+  static constexpr ulint SLAB_SIZE = 1024;
+
+  /** Size of the first block of the transaction lock heap, it is kept
+  when the heap is emptied and so it is reused by a pooled transaction. */
+  static constexpr ulint HEAP_SIZE = 4 * SLAB_SIZE;
+
+  /**
+   * @brief Rounds a record lock bitmap size up to its size class.
+   *
+   * @param[in] n_bytes Minimum size of the bitmap in bytes, 0 for a table lock.
+   *
+   * @return the size of the bitmap in bytes.
+   */
+  [[nodiscard]] static ulint bitmap_size(ulint n_bytes) noexcept {
+    if (n_bytes == 0) {
+      return 0;
+    } else {
+      return std::bit_ceil(std::max(n_bytes, ulint(1) << MIN_BITMAP_SHIFT));
+    }
+  }
+
+  /**
+   * @brief Gets the size class of a lock.
+   *
+   * @param[in] n_bytes Size of the bitmap in bytes, as returned by bitmap_size().
+   *
+   * @return the size class, or ULINT_UNDEFINED if the lock is not pooled.
+   */
+  [[nodiscard]] static ulint size_class(ulint n_bytes) noexcept {
+    if (n_bytes == 0) {
+      return 0;
+    }
+
+    ut_ad(std::has_single_bit(n_bytes));
+
+    const auto size_class = ulint(std::countr_zero(n_bytes)) - MIN_BITMAP_SHIFT + 1;
+
+    return size_class < N_SIZE_CLASSES ? size_class : ULINT_UNDEFINED;
+  }
+
+  /** Forgets the free locks, called when the lock heap is emptied. */
+  void clear() noexcept { m_free.fill(nullptr); }
+
+  /** Free lists by size class, linked through Lock::m_trx_locks. */
+  std::array<Lock *, N_SIZE_CLASSES> m_free{};
+};
+
+/** Lock waits on a table or an index. The counters are updated without a
+latch when a wait ends. */
+struct Lock_wait_stats {
+  /**
+   * @brief Records a lock wait that has ended.
+   *
+   * @param[in] us Time waited in microseconds.
+   */
+  void add(uint64_t us) noexcept {
+    m_n_waits.fetch_add(1, std::memory_order_relaxed);
+    m_wait_us.fetch_add(us, std::memory_order_relaxed);
+  }
+
+  /** Number of lock waits. */
+  std::atomic<uint64_t> m_n_waits{};
+
+  /** Total time waited in microseconds. */
+  std::atomic<uint64_t> m_wait_us{};
+};
+
 /** Lock operation struct */
 struct Lock_op {
   /** Table to be locked */
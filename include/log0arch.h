@@ -0,0 +1,302 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/log0arch.h
+Redo log archiving and reading the parsed log records from an lsn.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "mtr0types.h"
+#include "os0file.h"
+#include "sync0sync.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+/** The log archive.
+
+The log files are a circular buffer, the log before the last checkpoint can
+be overwritten. Log::checkpoint() calls archive() before it writes a new
+checkpoint, which appends the log blocks from the log files to the current
+archive file in log_archive_dir, up to the log that has been flushed to disk.
+
+An archive file holds consecutive log blocks as they are in the log files,
+checksums included and without a file header. It is named after the lsn of
+its first block, see FILE_PREFIX. A new file is started at startup, from the
+last checkpoint, and when the current one reaches the size of a log file. The
+files of successive runs can overlap by a few blocks, their contents are the
+same. The files are never removed, that is up to the user. */
+struct Log_archiver {
+  /** Prefix of the archive file names, the lsn follows, zero padded. */
+  static constexpr char FILE_PREFIX[] = "ib_logarch_";
+
+  /** Maximum number of bytes copied at a time. */
+  static constexpr ulint COPY_SIZE = 64 * 1024;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] dir             The archive directory.
+   * @param[in] max_file_size   Size at which a new archive file is started.
+   */
+  Log_archiver(const char *dir, ulint max_file_size) noexcept;
+
+  /** Destructor. */
+  ~Log_archiver() noexcept;
+
+  /** @return true if log_archive_dir is set. */
+  [[nodiscard]] static bool is_enabled() noexcept;
+
+  /**
+   * Creates the archive directory if it does not exist and starts a new
+   * archive file at the last checkpoint. The log must have been opened.
+   *
+   * @return the instance or nullptr on error.
+   */
+  [[nodiscard]] static Log_archiver *create() noexcept;
+
+  /**
+   * Destroys an instance, the current archive file is flushed and closed.
+   *
+   * @param[in,out] log_arch    Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Log_archiver *&log_arch) noexcept;
+
+  /**
+   * Copies the complete log blocks up to an lsn from the log files to the
+   * archive and makes them durable. Must not be called with the log mutex.
+   *
+   * @param[in] lsn             Archive up to here, the log must have been
+   *                            flushed to disk up to it.
+   */
+  void archive(lsn_t lsn) noexcept;
+
+  /** @return the lsn up to which the log is archived, block aligned. */
+  [[nodiscard]] lsn_t get_archived_lsn() const noexcept {
+    return m_archived_lsn.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Reads log blocks from the archive.
+   *
+   * @param[in] start_lsn       Lsn of the first block, block aligned.
+   * @param[out] buf            Where to read, aligned for direct i/o.
+   * @param[in] len             Maximum number of bytes to read, a multiple
+   *                            of IB_FILE_BLOCK_SIZE.
+   *
+   * @return the number of bytes read, 0 if start_lsn is not in the archive.
+   */
+  [[nodiscard]] ulint read(lsn_t start_lsn, byte *buf, ulint len) noexcept;
+
+ private:
+  /** An archive file. */
+  struct File {
+    /** Path of the file. */
+    std::string m_path{};
+
+    /** The lsn after the last block in the file. */
+    lsn_t m_end_lsn{};
+  };
+
+  /**
+   * Closes the current file and creates a new one. The caller must own
+   * m_mutex.
+   *
+   * @param[in] start_lsn       Lsn of the first block of the file.
+   *
+   * @return true on success.
+   */
+  [[nodiscard]] bool open_file(lsn_t start_lsn) noexcept;
+
+  /** Registers the archive files of the earlier runs. */
+  void scan_dir() noexcept;
+
+  /** @return the path of the archive file that starts at an lsn. */
+  [[nodiscard]] std::string file_path(lsn_t start_lsn) const noexcept;
+
+ private:
+  /** The archive directory. */
+  std::string m_dir{};
+
+  /** Size at which a new archive file is started. */
+  ulint m_max_file_size{};
+
+  /** Protects the fields below and serializes archive(). */
+  mutable mutex_t m_mutex{};
+
+  /** The archive files by the lsn of their first block, the last one is
+  being appended to. */
+  std::map<lsn_t, File> m_files{};
+
+  /** The archive file that is being appended to. */
+  os_file_t m_file{-1};
+
+  /** Lsn of the first block of m_file. */
+  lsn_t m_file_start_lsn{};
+
+  /** Lsn up to which the log is archived. */
+  std::atomic<lsn_t> m_archived_lsn{};
+
+  /** Memory of m_buf. */
+  byte *m_buf_ptr{};
+
+  /** Copy buffer of COPY_SIZE bytes, UNIV_PAGE_SIZE aligned. */
+  byte *m_buf{};
+};
+
+/** Reads the log records from an lsn, from the archive and the log files.
+
+The records are returned in lsn order up to the log that is flushed to disk,
+the end of a flushed log write is always the end of a mini-transaction. The
+log before the last checkpoint can only be read from the archive. */
+struct Log_stream {
+  /** A parsed log record. */
+  struct Record {
+    /** Lsn of the start of the record. */
+    lsn_t m_lsn{};
+
+    /** Lsn of the end of the record. */
+    lsn_t m_end_lsn{};
+
+    /** Type of the record, without MLOG_SINGLE_REC_FLAG. */
+    mlog_type_t m_type{MLOG_UNKNOWN};
+
+    /** Tablespace id, undefined for MLOG_MULTI_REC_END. */
+    space_id_t m_space{};
+
+    /** Page number, undefined for MLOG_MULTI_REC_END and MLOG_DUMMY_RECORD. */
+    page_no_t m_page_no{};
+
+    /** Body of the record after the type, space id and page number, valid
+    up to the next call of Log_stream::next(). */
+    const byte *m_body{};
+
+    /** Length of m_body. */
+    ulint m_body_len{};
+
+    /** True if the record ends a mini-transaction, reading can be resumed
+    from m_end_lsn. */
+    bool m_mtr_end{};
+  };
+
+  /** Number of log bytes read from the files at a time. */
+  static constexpr ulint READ_SIZE = 64 * 1024;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] start_lsn       Lsn of the first record.
+   */
+  explicit Log_stream(lsn_t start_lsn) noexcept;
+
+  /** Destructor. */
+  ~Log_stream() noexcept;
+
+  /**
+   * Creates a stream.
+   *
+   * @param[in] start_lsn       Lsn of the start of a mini-transaction, or 0
+   *                            for the last checkpoint.
+   * @param[out] stream         The stream.
+   *
+   * @return DB_SUCCESS, DB_INVALID_INPUT if start_lsn cannot be the start of
+   *  a record or DB_OUT_OF_MEMORY.
+   */
+  [[nodiscard]] static db_err create(lsn_t start_lsn, Log_stream *&stream) noexcept;
+
+  /**
+   * Destroys a stream.
+   *
+   * @param[in,out] stream      Stream to destroy, set to nullptr on return.
+   */
+  static void destroy(Log_stream *&stream) noexcept;
+
+  /**
+   * Parses the next log record.
+   *
+   * @param[out] rec            The record.
+   *
+   * @return DB_SUCCESS, DB_END_OF_INDEX if all the flushed log has been read,
+   *  later calls return the log flushed meanwhile, DB_MISSING_HISTORY if the
+   *  log was overwritten and is not in the archive, DB_CORRUPTION.
+   */
+  [[nodiscard]] db_err next(Record &rec) noexcept;
+
+  /**
+   * Reads log blocks as they are on disk, from the archive or else from the
+   * log files. Only the log that is flushed to disk must be read, the last
+   * block can be incomplete.
+   *
+   * @param[in] start_lsn       Lsn of the first block, block aligned.
+   * @param[out] buf            Where to read, aligned for direct i/o.
+   * @param[in] len             Maximum number of bytes to read, a multiple
+   *                            of IB_FILE_BLOCK_SIZE.
+   *
+   * @return the number of bytes read, 0 if the log at start_lsn was
+   *  overwritten and is not in the archive.
+   */
+  [[nodiscard]] static ulint read_blocks(lsn_t start_lsn, byte *buf, ulint len) noexcept;
+
+ private:
+  /**
+   * Appends the data of the next log blocks to m_data.
+   *
+   * @param[in] limit_lsn       Read up to here, the flushed lsn.
+   *
+   * @return DB_SUCCESS, DB_MISSING_HISTORY or DB_CORRUPTION.
+   */
+  [[nodiscard]] db_err fill(lsn_t limit_lsn) noexcept;
+
+  /**
+   * Reads log blocks from the log files. Only the log after the last
+   * checkpoint can be read.
+   *
+   * @param[in] start_lsn       Lsn of the first block, block aligned.
+   * @param[out] buf            Where to read.
+   * @param[in] len             Number of bytes to read.
+   *
+   * @return the number of bytes read, 0 if start_lsn is overwritten.
+   */
+  [[nodiscard]] static ulint read_log_files(lsn_t start_lsn, byte *buf, ulint len) noexcept;
+
+ private:
+  /** Lsn of the record at m_data[m_pos]. */
+  lsn_t m_lsn{};
+
+  /** The lsn after the log data in m_data. */
+  lsn_t m_read_lsn{};
+
+  /** Log data to parse, without the block headers and trailers. */
+  std::vector<byte> m_data{};
+
+  /** Offset of the next record in m_data. */
+  ulint m_pos{};
+
+  /** Memory of m_buf. */
+  byte *m_buf_ptr{};
+
+  /** Read buffer of READ_SIZE bytes, UNIV_PAGE_SIZE aligned. */
+  byte *m_buf{};
+};
+
+/** The log archive, nullptr if the log is not archived. */
+extern Log_archiver *srv_log_arch;
@@ -0,0 +1,211 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/log0backup.h
+Online backup of the data files and the log
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "fil0fil.h"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** An online backup.
+
+The pages of the tablespaces are read from the data files while the engine
+runs, a page that is being written can be read torn and is read again until
+it passes Buf_pool::is_corrupted(). The pages are read at different times, the
+log from the last checkpoint before the copy up to the log flushed after it
+makes them consistent.
+
+The log is written to the backup as the images of the log files, with the
+checkpoint at the start of the copy. The restored files are recovered like
+after a crash when the engine is started on them, the log is applied up to the
+end lsn of the backup. The log is copied while the pages are, from the archive
+if there is one, otherwise it must not be overwritten before it is copied and
+it must fit in the log files.
+
+An incremental backup only copies the pages modified after the start lsn of
+an earlier backup, and the last page of each file so that the restored file
+has its size. A page that is not copied was not modified since that backup
+started, and the log of the incremental backup covers the modifications made
+after its own start. */
+struct Backup {
+  /**
+   * Receives the backup, writes data to a file of the backup.
+   *
+   * @param[in] path            Path of the file as the engine opened it.
+   * @param[in] offset          Offset in the file.
+   * @param[in] data            The data to write.
+   * @param[in] len             Length of data.
+   *
+   * @return DB_SUCCESS or error code, an error stops the backup.
+   */
+  using Sink = std::function<db_err(const char *path, uint64_t offset, const byte *data, ulint len)>;
+
+  /** Number of times a page that fails the checks is read again. */
+  static constexpr ulint MAX_PAGE_READS = 100;
+
+  /** The log is copied after this many pages. */
+  static constexpr ulint LOG_COPY_INTERVAL = 64;
+
+  /** Number of bytes of log read at a time. */
+  static constexpr ulint LOG_READ_SIZE = 64 * 1024;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] fil             The file system.
+   * @param[in] sink            Receives the backup.
+   * @param[in] since_lsn       Start lsn of an earlier backup for an
+   *                            incremental backup, 0 for a full backup.
+   * @param[in] max_pages_per_sec Maximum number of pages read per second,
+   *                            0 for no limit.
+   */
+  Backup(Fil *fil, Sink sink, lsn_t since_lsn, ulint max_pages_per_sec) noexcept;
+
+  /** Destructor. */
+  ~Backup() noexcept;
+
+  /**
+   * Copies the tablespaces and the log.
+   *
+   * @return DB_SUCCESS, DB_MISSING_HISTORY if the log was overwritten before
+   *  it was copied, DB_OUT_OF_FILE_SPACE if the log written during the backup
+   *  does not fit in the log files, or the error of the sink.
+   */
+  [[nodiscard]] db_err run() noexcept;
+
+  /** @return the checkpoint lsn that the recovery of the backup starts at. */
+  [[nodiscard]] lsn_t get_start_lsn() const noexcept { return m_start_lsn; }
+
+  /** @return the lsn that the backup is consistent at. */
+  [[nodiscard]] lsn_t get_end_lsn() const noexcept { return m_end_lsn; }
+
+  /** @return the number of pages copied. */
+  [[nodiscard]] uint64_t get_n_pages() const noexcept { return m_n_pages; }
+
+  /** @return the number of pages read. */
+  [[nodiscard]] uint64_t get_n_pages_read() const noexcept { return m_n_pages_read; }
+
+ private:
+  /**
+   * Copies the pages of a tablespace.
+   *
+   * @param[in] space           The files of the tablespace.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err copy_space(const Fil::Space_files &space) noexcept;
+
+  /**
+   * Reads a page until it passes the checks.
+   *
+   * @param[in] space_id        Tablespace id.
+   * @param[in] page_no         Page number.
+   *
+   * @return DB_SUCCESS, DB_TABLESPACE_DELETED or DB_CORRUPTION.
+   */
+  [[nodiscard]] db_err read_page(space_id_t space_id, page_no_t page_no) noexcept;
+
+  /**
+   * Writes the headers of the log files with the checkpoint at m_start_lsn.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err write_log_headers() noexcept;
+
+  /**
+   * Copies the log that has been flushed to disk.
+   *
+   * @param[in] lsn             Copy up to here.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err copy_log(lsn_t lsn) noexcept;
+
+  /**
+   * Writes log data to the log file images.
+   *
+   * @param[in] lsn             Lsn of the data, block aligned.
+   * @param[in] data            Log blocks.
+   * @param[in] len             Length of data.
+   *
+   * @return DB_SUCCESS or error code.
+   */
+  [[nodiscard]] db_err write_log(lsn_t lsn, const byte *data, ulint len) noexcept;
+
+  /** Waits so that the pages are read at most at m_max_pages_per_sec. */
+  void throttle() noexcept;
+
+ private:
+  /** The file system. */
+  Fil *m_fil{};
+
+  /** Receives the backup. */
+  Sink m_sink{};
+
+  /** Only the pages modified after this are copied. */
+  lsn_t m_since_lsn{};
+
+  /** Maximum number of pages read per second, 0 for no limit. */
+  ulint m_max_pages_per_sec{};
+
+  /** The checkpoint lsn that the recovery of the backup starts at. */
+  lsn_t m_start_lsn{};
+
+  /** Number of the checkpoint at m_start_lsn. */
+  lsn_t m_checkpoint_no{};
+
+  /** The lsn that the backup is consistent at. */
+  lsn_t m_end_lsn{};
+
+  /** Lsn of the first block in the log file images. */
+  lsn_t m_log_start_lsn{};
+
+  /** Lsn of the next block to copy, the last block copied can be copied
+  again when more of it has been written. */
+  lsn_t m_log_copied_lsn{};
+
+  /** Size of a log file. */
+  ulint m_log_file_size{};
+
+  /** Paths of the log files. */
+  std::vector<std::string> m_log_files{};
+
+  /** Number of pages copied. */
+  uint64_t m_n_pages{};
+
+  /** Number of pages read, for the throttling. */
+  uint64_t m_n_pages_read{};
+
+  /** When the first page was read. */
+  std::chrono::steady_clock::time_point m_throttle_start{};
+
+  /** Memory of m_buf. */
+  byte *m_buf_ptr{};
+
+  /** Buffer of LOG_READ_SIZE bytes for the pages and the log,
+  UNIV_PAGE_SIZE aligned. */
+  byte *m_buf{};
+};
@@ -39,8 +39,16 @@ Created 12/9/1995 Heikki Tuuri
 #include "srv0srv.h"
 #include "sync0rw.h"
 #include "sync0sync.h"
+#include "ut0crc32.h"
+#include "ut0link_buf.h"
 #include "ut0lst.h"
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
 struct Log;
 struct log_group_t;
 
@@ -196,12 +204,12 @@ struct Log {
  }
  
  /**
-  * Calculates the checksum for a log block.
+  * Calculates the original InnoDB checksum of a log block.
   *
   * @param block The log block.
   * @return The checksum.
   */
- [[nodiscard]] static uint32_t block_calc_checksum(const byte *block) noexcept {
+ [[nodiscard]] static uint32_t block_calc_checksum_innodb(const byte *block) noexcept {
    uint32_t sh = 0;   // Shift value.
    uint32_t sum = 1;  // Checksum value.
  
@@ -220,6 +228,49 @@ struct Log {
  
    return sum;
  }
+
+ /**
+  * Calculates the CRC32C checksum of a log block.
+  *
+  * @param block The log block.
+  * @return The checksum.
+  */
+ [[nodiscard]] static uint32_t block_calc_checksum_crc32c(const byte *block) noexcept {
+   return crc32::checksum(block, IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE);
+ }
+
+ /**
+  * Calculates the checksum of a log block with the log_checksum_algorithm.
+  *
+  * @param block The log block.
+  * @return The checksum.
+  */
+ [[nodiscard]] static uint32_t block_calc_checksum(const byte *block) noexcept {
+   if (srv_config.m_log_checksum_algorithm == LOG_CHECKSUM_CRC32C) {
+     return block_calc_checksum_crc32c(block);
+   } else {
+     return block_calc_checksum_innodb(block);
+   }
+ }
+
+ /**
+  * Checks the checksum of a log block. The log can have been written with
+  * either algorithm: log_checksum_algorithm can have been changed since, and
+  * a restart does not rewrite the log after the last checkpoint. The current
+  * algorithm is tried first.
+  *
+  * @param block The log block.
+  * @return true if the checksum is valid.
+  */
+ [[nodiscard]] static bool is_block_checksum_ok(const byte *block) noexcept {
+   const auto checksum = block_get_checksum(block);
+
+   if (srv_config.m_log_checksum_algorithm == LOG_CHECKSUM_CRC32C) {
+     return checksum == block_calc_checksum_crc32c(block) || checksum == block_calc_checksum_innodb(block);
+   } else {
+     return checksum == block_calc_checksum_innodb(block) || checksum == block_calc_checksum_crc32c(block);
+   }
+ }
  
  /**
   * Gets a log block checksum field value.
@@ -275,51 +326,39 @@ struct Log {
    block_set_first_rec_group(log_block, 0);
  }
  
+ /** Set in m_sn while the log buffer is resized, the mini-transactions that
+ reserve their log meanwhile wait before they copy it to the log buffer. */
+ static constexpr uint64_t SN_LOCKED = 1ULL << 63;
+
  /**
-  * Reserves space in the log buffer and writes a string to the log.
-  * The log must be released with log_release().
+  * Converts a data byte sequence number to an lsn. The sequence numbers count
+  * only the log record bytes, the lsn also counts the log block headers and
+  * trailers.
   *
-  * @param str The string to write to the log.
-  * @param len The length of the string.
-  * @param start_lsn[out] The start lsn of the log record.
-  * @return The end lsn of the log record, or zero if it did not succeed.
+  * @param sn The sequence number.
+  * @return The lsn, it is never at the header or the trailer of a log block.
   */
- [[nodiscard]] lsn_t reserve_and_write_fast(const void *str, ulint len, lsn_t *start_lsn) noexcept {
-   auto data_len = len + m_buf_free % IB_FILE_BLOCK_SIZE;
- 
-   if (data_len >= IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
-     /* The string does not fit within the current log block
-     or the log block would become full */
-     return 0;
-   }
- 
-   *start_lsn = m_lsn;
- 
-   memcpy(m_buf + m_buf_free, str, len);
- 
-   block_set_data_len(static_cast<byte *>(ut_align_down(m_buf + m_buf_free, IB_FILE_BLOCK_SIZE)), data_len);
- 
-   m_buf_free += len;
- 
-   ut_ad(m_buf_free <= m_buf_size);
- 
-   m_lsn += len;
- 
-   return m_lsn;
+ [[nodiscard]] static constexpr lsn_t sn_to_lsn(uint64_t sn) noexcept {
+   return sn / LOG_BLOCK_DATA_SIZE * IB_FILE_BLOCK_SIZE + sn % LOG_BLOCK_DATA_SIZE + LOG_BLOCK_HDR_SIZE;
  }
- 
- /** Gets the current lsn.
+
+ /**
+  * Converts an lsn to a data byte sequence number, see sn_to_lsn().
+  *
+  * @param lsn The lsn, must not be at the header or the trailer of a log block.
+  * @return The sequence number.
+  */
+ [[nodiscard]] static constexpr uint64_t lsn_to_sn(lsn_t lsn) noexcept {
+   return lsn / IB_FILE_BLOCK_SIZE * LOG_BLOCK_DATA_SIZE + lsn % IB_FILE_BLOCK_SIZE - LOG_BLOCK_HDR_SIZE;
+ }
+
+ /** Gets the current lsn, the end of the log reserved so far. The log up to
+  * that lsn may still be being copied to the log buffer.
   * 
   * @return	current lsn
   */
  [[nodiscard]] lsn_t get_lsn() const noexcept {
-   acquire();
- 
-   auto lsn = m_lsn;
- 
-   release();
- 
-   return lsn;
+   return sn_to_lsn(m_sn.load(std::memory_order_acquire) & ~SN_LOCKED);
  }
  
  /**
@@ -331,6 +370,26 @@ struct Log {
  [[nodiscard]] ulint get_capacity() const noexcept{
    return m_log_group_capacity;
  }
+
+ /**
+  * Gets the modified age above which an asynchronous preflush of the buffer pool starts.
+  * It is OK to read the value without holding mutex because it is constant.
+  *
+  * @return The asynchronous preflush threshold.
+  */
+ [[nodiscard]] ulint get_max_modified_age_async() const noexcept {
+   return m_max_modified_age_async;
+ }
+
+ /**
+  * Gets the modified age above which the user threads preflush the buffer pool synchronously.
+  * It is OK to read the value without holding mutex because it is constant.
+  *
+  * @return The synchronous preflush threshold.
+  */
+ [[nodiscard]] ulint get_max_modified_age_sync() const noexcept {
+   return m_max_modified_age_sync;
+ }
  
  /**
   * Checks if there is a need for a log buffer flush or a new checkpoint, and does this if yes.
@@ -381,30 +440,68 @@ struct Log {
     off_t log_file_size) noexcept;
  
  /**
-  * @brief Opens the log for log_write_low.
-  * The log must be closed with log_close and released with log_release.
+  * Reserves the lsn range for the log of a mini-transaction, the caller then
+  * copies the log with write() and calls close(). The reservation is a single
+  * atomic increment, the mini-transactions copy their log in parallel. Waits
+  * if the log buffer is full.
   *
-  * @param len Length of data to be catenated.
-  * @return Start lsn of the log record.
+  * @param len The length of the log records.
+  * @param end_lsn[out] The end lsn of the range.
+  * @return The start lsn of the range.
   */
- [[nodiscard]] lsn_t reserve_and_open(ulint len) noexcept;
+ [[nodiscard]] lsn_t reserve(ulint len, lsn_t *end_lsn) noexcept;
  
  /**
-  * @brief Writes to the log the string given.
-  * It is assumed that the caller holds the log mutex.
+  * Copies log records to a reserved range of the log buffer.
   *
-  * @param str String to write.
-  * @param str_len Length of the string.
+  * @param lsn Where to copy the records, within the reserved range.
+  * @param str The log records.
+  * @param len The length of the log records.
+  * @return The lsn after the copied records.
   */
- void write_low(const byte *str, ulint str_len) noexcept;
+ [[nodiscard]] lsn_t write(lsn_t lsn, const byte *str, ulint len) noexcept;
  
  /**
-  * @brief Closes the log.
+  * Marks a reserved range as copied to the log buffer. The log writer writes
+  * the log up to the first range that is not copied yet.
   *
-  * @param recovery Recovery flag.
-  * @return Lsn.
+  * @param start_lsn Start lsn of the range.
+  * @param end_lsn End lsn of the range.
   */
- [[nodiscard]] lsn_t close(ib_recovery_t recovery) noexcept;
+ void close(lsn_t start_lsn, lsn_t end_lsn) noexcept;
+
+ /**
+  * Called by mtr_t::commit() before the modified pages are linked to the flush
+  * lists. The flush lists are sorted only within LOG_RECENT_CLOSED_SIZE: waits
+  * until the mini-transactions that started more than that before start_lsn
+  * have linked their pages.
+  *
+  * @param start_lsn Start lsn of the mini-transaction.
+  */
+ void flush_order_begin(lsn_t start_lsn) noexcept;
+
+ /**
+  * Called by mtr_t::commit() once the modified pages are linked to the flush
+  * lists.
+  *
+  * @param start_lsn Start lsn of the mini-transaction.
+  * @param end_lsn End lsn of the mini-transaction.
+  */
+ void flush_order_end(lsn_t start_lsn, lsn_t end_lsn) noexcept {
+   if (end_lsn > start_lsn) {
+     m_recent_closed.add_link(start_lsn, end_lsn);
+   }
+ }
+
+ /**
+  * Restarts the log at an lsn, e.g., after recovery. The log mutex must be
+  * owned and there must be no concurrent mini-transactions.
+  *
+  * @param lsn The new lsn.
+  * @param last_block The log block that contains lsn, or nullptr if lsn is at
+  *  the start of a block, then a new block is started.
+  */
+ void reset(lsn_t lsn, const byte *last_block) noexcept;
  
  /**
   * @brief Initializes the log.
@@ -436,7 +533,113 @@ struct Log {
   * @param flush_to_disk True if we want the written log also to be flushed to disk.
   */
  void write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept;
- 
+
+ /**
+  * Waits until the log of a committing transaction is written, and flushed
+  * to disk if requested. The writes and the flushes are done by the log
+  * writer and log flusher threads, a flush covers all the transactions that
+  * wait for it, the transactions that arrive during a flush are covered by
+  * the next one. If the threads are not running the caller does the write
+  * itself with write_up_to().
+  *
+  * @param lsn The end lsn of the commit mini-transaction.
+  * @param flush_to_disk True if the log must also be flushed to disk.
+  */
+ void commit_up_to(lsn_t lsn, bool flush_to_disk) noexcept;
+
+ /**
+  * Like commit_up_to() but does not wait: callback is invoked once the log up
+  * to lsn is written, and flushed to disk if requested. It is invoked by the
+  * log writer or the log flusher thread, or by the caller before returning if
+  * the log is already there or the threads are not running. The callback must
+  * not block and must not call back into the engine.
+  *
+  * @param lsn The end lsn of the commit mini-transaction.
+  * @param flush_to_disk True if the log must also be flushed to disk.
+  * @param callback Invoked once the commit is durable.
+  */
+ void commit_async(lsn_t lsn, bool flush_to_disk, std::function<void()> callback) noexcept;
+
+ /**
+  * Starts the log writer, the log flusher and the checkpointer threads. The
+  * log must have been recovered.
+  */
+ void start_threads() noexcept;
+
+ /**
+  * Stops the log writer, log flusher and checkpointer threads, the threads
+  * that wait for them do their writes themselves.
+  */
+ void stop_threads() noexcept;
+
+ /**
+  * Resizes the log buffer. The log in the buffer is written to the log files
+  * first, the mini-transactions that reserve their log meanwhile wait.
+  * Must not be called by a thread that has reserved log it did not close.
+  *
+  * @param size The new size in bytes, rounded up to a multiple of the page size.
+  */
+ void resize_buffer(ulint size) noexcept;
+
+ /**
+  * Changes the number of files of the log group at runtime, the file size
+  * cannot be changed. The new files are created first, the group is switched
+  * at a checkpoint, under the log mutex: if the log from the checkpoint on
+  * is where the new geometry maps it, it stays where it is, otherwise it is
+  * copied to a file that it does not overlap. The checkpoint written then
+  * records the number of files for the recovery, the files that the group
+  * shrank by are deleted after it.
+  *
+  * @param n_files The new number of files, at least 2.
+  * @return DB_SUCCESS or error code
+  */
+ [[nodiscard]] db_err resize_files(ulint n_files) noexcept;
+
+ /**
+  * Changes the number of files of a log group, the caller owns the log
+  * mutex. Used by the recovery to apply the number of files recorded in
+  * the checkpoint, the log files of the group must be in its file space.
+  *
+  * @param[in,out] group Log group.
+  * @param[in] n_files The number of files.
+  * @return false if the group is too small, see calc_max_ages()
+  */
+ [[nodiscard]] bool group_set_n_files(log_group_t *group, ulint n_files) noexcept;
+
+ /**
+  * Shrinks a log buffer that has grown back to the configured log_buffer_size
+  * once the log has been generated slowly for a while. Called once a second
+  * by the master thread.
+  */
+ void buffer_shrink_if_idle() noexcept;
+
+ /** @return the number of commits that waited for the log flusher. */
+ [[nodiscard]] ulint get_n_group_commits() const noexcept {
+   return m_n_group_commits.load(std::memory_order_relaxed);
+ }
+
+ /** @return the number of flushes to disk done by the log flusher. */
+ [[nodiscard]] ulint get_n_group_commit_fsyncs() const noexcept {
+   return m_n_group_commit_fsyncs.load(std::memory_order_relaxed);
+ }
+
+ /** @return the age of the last checkpoint, lsn - last checkpoint lsn. */
+ [[nodiscard]] lsn_t get_checkpoint_age() const noexcept {
+   return get_lsn() - m_last_checkpoint_lsn.load(std::memory_order_relaxed);
+ }
+
+ /** @return the time in microseconds the checkpoint age was over the async
+ margin, m_max_checkpoint_age_async, but not over the sync margin. */
+ [[nodiscard]] uint64_t get_checkpoint_async_time_us() const noexcept {
+   return m_checkpoint_async_time_us.load(std::memory_order_relaxed);
+ }
+
+ /** @return the time in microseconds the checkpoint age was over the sync
+ margin, m_max_checkpoint_age, when the mini-transactions stall. */
+ [[nodiscard]] uint64_t get_checkpoint_sync_time_us() const noexcept {
+   return m_checkpoint_sync_time_us.load(std::memory_order_relaxed);
+ }
+
  /**
   * @brief Does a synchronous flush of the log buffer to disk.
   */
@@ -505,10 +708,11 @@ struct Log {
   *
   * @param buf The buffer containing checkpoint info.
   * @param n The nth slot.
-  * @param file_no The archived file number (output parameter).
+  * @param n_files The number of files of the group, 0 if it was not
+  *   recorded (output parameter).
   * @param offset The archived file offset (output parameter).
   */
- void checkpoint_get_nth_group_info(const byte *buf, ulint n, ulint *file_no, ulint *offset) noexcept;
+ void checkpoint_get_nth_group_info(const byte *buf, ulint n, ulint *n_files, ulint *offset) noexcept;
  
  /**
   * Writes checkpoint info to groups.
@@ -533,6 +737,16 @@ struct Log {
   */
  void group_read_log_seg(ulint type, byte *buf, log_group_t *group, lsn_t start_lsn, lsn_t end_lsn) noexcept;
  
+ /**
+  * Calculates the offset of an lsn within a log group. The caller must own
+  * the log mutex.
+  *
+  * @param lsn   LSN, must be within 4 GB of group->lsn
+  * @param group Log group
+  * @return      Offset within the log group
+  */
+ [[nodiscard]] uint64_t group_calc_lsn_offset(lsn_t lsn, const log_group_t *group) noexcept;
+
  /**
   * Writes a buffer to a log file group.
   *
@@ -542,8 +756,10 @@ struct Log {
   * @param start_lsn The start lsn of the buffer. Must be divisible by IB_FILE_BLOCK_SIZE.
   * @param new_data_offset The start offset of new data in the buffer. This
   *   parameter is used to decide if we have to write a new log file header.
+  * @param durable If true the writes are durable when this returns, see
+  *   IO_request::Sync_log_write_durable.
   */
- void group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_lsn, ulint new_data_offset) noexcept;
+ void group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_lsn, ulint new_data_offset, bool durable) noexcept;
  
  /**
   * Sets the field values in a log group to correspond to a given lsn.
@@ -573,10 +789,13 @@ struct Log {
  /**
   * @brief Peeks the current lsn.
   *
-  * @param lsn The output parameter where the current lsn will be stored if the function returns true.
-  * @return True if success, false if could not get the log system mutex.
+  * @param lsn The output parameter where the current lsn will be stored.
+  * @return True, the lsn can be read without the log system mutex.
   */
- [[nodiscard]] bool peek_lsn(lsn_t *lsn) noexcept;
+ [[nodiscard]] bool peek_lsn(lsn_t *lsn) noexcept {
+   *lsn = get_lsn();
+   return true;
+ }
  
  /**
   * Refreshes the statistics used to print per-second averages.
@@ -615,6 +834,39 @@ private:
    */
   [[nodiscard]] lsn_t buf_pool_get_oldest_modification() noexcept;
 
+  /**
+   * Waits for a resize of the log buffer to end. Called by a mini-transaction
+   * whose reservation found SN_LOCKED set.
+   */
+  void wait_for_resize() const noexcept;
+
+  /** Doubles the size of the log buffer, up to log_buffer_max_size, if
+  a mini-transaction had to wait for space in it. */
+  void grow_buffer() noexcept;
+
+  /** The log writer thread, writes the log up to m_write_requested_lsn. */
+  void writer_thread() noexcept;
+
+  /** The log flusher thread, flushes the written log to disk. */
+  void flusher_thread() noexcept;
+
+  /** Invokes the callbacks of the commit_async() requests that the written
+  and flushed log now covers. */
+  void complete_async_commits() noexcept;
+
+  /** Requests the log writer to write the log up to lsn.
+  @param[in] lsn                Lsn to write up to. */
+  void request_write(lsn_t lsn) noexcept;
+
+  /** The checkpointer thread, writes a checkpoint when the checkpoint age is
+  over the async margin. */
+  void checkpointer_thread() noexcept;
+
+  /** @return true if the log threads should exit. */
+  [[nodiscard]] bool is_threads_shutdown() const noexcept {
+    return m_threads_shutdown.load(std::memory_order_acquire);
+  }
+
   /**
    * Calculates the offset within a log group, when the log file headers are not included.
    *
@@ -634,15 +886,6 @@ private:
    */
   [[nodiscard]] uint64_t group_calc_real_offset(ulint offset, const log_group_t *group) noexcept;
 
-  /**
-   * Calculates the offset of an lsn within a log group.
-   *
-   * @param lsn   LSN, must be within 4 GB of group->lsn
-   * @param group Log group
-   * @return      Offset within the log group
-   */
-  [[nodiscard]] uint64_t group_calc_lsn_offset(lsn_t lsn, const log_group_t *group) noexcept;
-
    /**
     * Calculates the recommended highest values for lsn - last_checkpoint_lsn,
     * lsn - buf_get_oldest_modification(), and lsn - max_archive_lsn_age.
@@ -651,6 +894,56 @@ private:
     *  accommodate the number of OS threads in the database server */
    [[nodiscard]] bool calc_max_ages() noexcept;
 
+   /**
+    * Same as calc_max_ages(), the caller owns the log mutex and handles
+    * the error.
+    *
+    * @return false if the smallest log group is too small */
+   [[nodiscard]] bool calc_max_ages_low() noexcept;
+
+  /**
+   * Allocates the file header buffers of a log group, for group->n_files.
+   *
+   * @param[in,out] group Log group.
+   */
+  void group_alloc_file_header_bufs(log_group_t *group) noexcept;
+
+  /**
+   * Frees the file header buffers of a log group.
+   *
+   * @param[in,out] group Log group.
+   */
+  void group_free_file_header_bufs(log_group_t *group) noexcept;
+
+  /**
+   * Creates the log files of a group that it is grown to, and adds them to
+   * the file space of the group. A file that exists is overwritten.
+   *
+   * @param[in] group Log group.
+   * @param[in] n_files The number of files of the group after the resize.
+   * @return DB_SUCCESS or DB_ERROR
+   */
+  [[nodiscard]] db_err group_create_files(const log_group_t *group, ulint n_files) noexcept;
+
+  /**
+   * Removes the last files of the file space of a group and deletes them.
+   *
+   * @param[in] group Log group.
+   * @param[in] n_files The number of files to keep.
+   */
+  void group_delete_files(const log_group_t *group, ulint n_files) noexcept;
+
+  /**
+   * Switches a log group to a new number of files, if the log from the last
+   * checkpoint on can be kept. The caller owns the log mutex.
+   *
+   * @param[in,out] group Log group.
+   * @param[in] n_files The new number of files.
+   * @return DB_SUCCESS, DB_FAIL if a checkpoint must be made first and the
+   *  switch tried again, or DB_ERROR if the group would be too small
+   */
+  [[nodiscard]] db_err group_switch_n_files(log_group_t *group, ulint n_files) noexcept;
+
    /**
     * Does the unlockings needed in flush I/O completion.
     *
@@ -689,8 +982,9 @@ private:
    * @param group The log group
    * @param nth_file The header to the nth file in the log file space
    * @param start_lsn The log file data starts at this LSN
+   * @param durable If true the write is durable when this returns
    */
-  void group_file_header_flush(log_group_t *group, ulint nth_file, lsn_t start_lsn) noexcept;
+  void group_file_header_flush(log_group_t *group, ulint nth_file, lsn_t start_lsn, bool durable) noexcept;
 
   /**
    * Stores a 4-byte checksum to the trailer checksum field of a log block
@@ -701,6 +995,27 @@ private:
    */
   void block_store_checksum(byte *block) noexcept; 
 
+  /**
+   * Waits until a reserved range can be copied to the log buffer: the
+   * previous contents of the buffer must have been written and the range
+   * must be within LOG_RECENT_WRITTEN_SIZE of the oldest range being copied.
+   *
+   * @param start_lsn Start lsn of the range.
+   * @param end_lsn End lsn of the range.
+   */
+  void wait_for_space(lsn_t start_lsn, lsn_t end_lsn) noexcept;
+
+  /**
+   * Copies the log blocks from the log buffer to the write buffer and
+   * completes their headers. The caller must own the log mutex.
+   *
+   * @param start_lsn The lsn up to which the log has been written.
+   * @param end_lsn The lsn up to which the log is copied to the log buffer.
+   * @return The number of bytes to write from m_write_buf, a multiple of
+   *  IB_FILE_BLOCK_SIZE.
+   */
+  [[nodiscard]] ulint copy_to_write_buf(lsn_t start_lsn, lsn_t end_lsn) noexcept;
+
   /**
    * Tries to establish a big enough margin of free space in
    * the log buffer, such that a new log entry can be catenated
@@ -713,10 +1028,19 @@ private:
    *
    * @param buf Buffer for checkpoint info
    * @param n Nth slot
-   * @param file_no Archived file number
+   * @param n_files Number of files of the group
    * @param offset Archived file offset
    */
-  void checkpoint_set_nth_group_info(byte *buf, ulint n, ulint file_no, ulint offset) noexcept;
+  void checkpoint_set_nth_group_info(byte *buf, ulint n, ulint n_files, ulint offset) noexcept;
+
+  /**
+   * Fills the checkpoint buffer of a log group for the next checkpoint.
+   *
+   * @param[in,out] group Log group.
+   * @return the checkpoint field in the first log file to write it to,
+   *  LOG_CHECKPOINT_1 or LOG_CHECKPOINT_2
+   */
+  [[nodiscard]] ulint group_checkpoint_prepare(log_group_t *group) noexcept;
 
   /**
    * Writes the checkpoint info to a log group header.
@@ -747,11 +1071,14 @@ public:
    */
   byte m_pad[64];
 
-  /** Log sequence number */
-  lsn_t m_lsn{};
+  /** Number of log record bytes reserved so far, see sn_to_lsn(). The
+  mini-transactions reserve their log with a fetch-add on this. */
+  std::atomic<uint64_t> m_sn{};
 
-  /** First free offset within the log buffer */
-  ulint m_buf_free{};
+  /** The mini-transactions can copy their log to the log buffer below this
+  lsn, the contents of the buffer before m_buf_limit_lsn - m_buf_size have
+  been copied to the write buffer. */
+  std::atomic<lsn_t> m_buf_limit_lsn{};
 
   /** Mutex protecting the log */
   mutable mutex_t m_mutex{};
@@ -759,44 +1086,58 @@ public:
   /* Unaligned log buffer */
   byte *m_buf_ptr{};
 
-  /** Log buffer */
+  /** Log buffer, a ring buffer where the log of lsn is at lsn % m_buf_size */
   byte *m_buf{};
 
-  /** Log buffer size in bytes */
-  ulint m_buf_size{};
+  /** Log buffer size in bytes, changes only while SN_LOCKED is set and the
+  log mutex is owned */
+  std::atomic<ulint> m_buf_size{};
+
+  /** Unaligned write buffer */
+  byte *m_write_buf_ptr{};
+
+  /** The log is written to the log files from this buffer, the log writer
+  copies the log blocks to it from the log buffer */
+  byte *m_write_buf{};
+
+  /* recommended maximum number of bytes in the log buffer that are not
+  written, after which the buffer is flushed */
+  std::atomic<ulint> m_max_buf_free{};
 
-  /* recommended maximum value of buf_free, after which the buffer is flushed */
-  ulint m_max_buf_free{};
+  /** Set by a mini-transaction that had to wait for space in the log buffer,
+  the buffer is grown by the next free_check() */
+  std::atomic<bool> m_buf_grow_requested{};
 
-#ifdef UNIV_DEBUG
+  /** Used by buffer_shrink_if_idle() only: the lsn at the previous call and
+  since when the log has been generated slowly @{ */
+  lsn_t m_buf_idle_lsn{};
+  time_t m_buf_idle_since{};
+  /* @} */
 
-  /** value of buf free when log was last time opened; only in the debug version */
-  ulint m_old_buf_free{};
+  /** The ranges of the log buffer that the mini-transactions have copied
+  their log to, the tail is the lsn up to which the log can be written */
+  Link_buf m_recent_written;
 
-  /** value of lsn when log was last time opened; only in the debug version */
-  lsn_t m_old_lsn{};
-#endif /* UNIV_DEBUG */
+  /** The ranges of the mini-transactions that have linked their pages to
+  the flush lists, the pages of the mini-transactions that have not were
+  all modified at or after the tail */
+  Link_buf m_recent_closed;
 
   /** This is set to true when there may be need to flush the log buffer,
   or preflush buffer pool pages, or make a checkpoint; this MUST be true
   when lsn - last_checkpoint_lsn > max_checkpoint_age; this flag is
   peeked at by log_free_check(), which does not reserve the log mutex */
-  bool m_check_flush_or_checkpoint{};
+  std::atomic<bool> m_check_flush_or_checkpoint{};
 
   /** Log groups */
   UT_LIST_BASE_NODE_T_EXTERN(log_group_t, log_groups) m_log_groups{};
 
   /** The fields involved in the log buffer flush @{ */
 
-  /** First offset in the log buffer where the byte content may not exist
-  written to file, e.g., the start offset of a log record catenated later;
-  this is advanced when a flush operation is completed to all the log groups */
-  ulint m_buf_next_to_write{};
-
   /** First log sequence number not yet written to any log group; for this
   to be advanced, it is enough that the write i/o has been completed for
   any one log group */
-  lsn_t m_written_to_some_lsn{};
+  std::atomic<lsn_t> m_written_to_some_lsn{};
 
   /** First log sequence number not yet written to some log group; for this
   to be advanced, it is enough that the write i/o has been completed for all
@@ -804,20 +1145,17 @@ public:
   this value is redundant. Also it is possible that this value falls behind
   the flushed_to_disk_lsn transiently.  It is appropriate to use either
   flushed_to_disk_lsn or write_lsn which are always up-to-date and accurate. */
-  lsn_t m_written_to_all_lsn{};
+  std::atomic<lsn_t> m_written_to_all_lsn{};
 
   /** End lsn for the current running write */
   lsn_t m_write_lsn{};
 
-  /** THe data in buffer has been written up to this offset when the current
-  write ends: this field will then be copied to buf_next_to_write */
-  ulint m_write_end_offset{};
-
   /** End lsn for the current running write + flush operation */
   lsn_t m_current_flush_lsn{};
 
-  /** How far we have written the log AND flushed to disk */
-  lsn_t m_flushed_to_disk_lsn{};
+  /** How far we have written the log AND flushed to disk, read without the
+  log mutex by commit_up_to() */
+  std::atomic<lsn_t> m_flushed_to_disk_lsn{};
 
   /** Number of currently pending flushes or writes */
   ulint m_n_pending_writes{};
@@ -882,8 +1220,8 @@ public:
   /** Next checkpoint number */
   lsn_t m_next_checkpoint_no{};
 
-  /** Latest checkpoint lsn */
-  lsn_t m_last_checkpoint_lsn{};
+  /** Latest checkpoint lsn, read without the log mutex by close() */
+  std::atomic<lsn_t> m_last_checkpoint_lsn{};
 
   /** Next checkpoint lsn */
   lsn_t m_next_checkpoint_lsn{};
@@ -899,6 +1237,69 @@ public:
 
   /** Checkpoint header is read to this buffer */
   byte *m_checkpoint_buf{};
+  /* @} */
+
+  /** Fields of the log writer, log flusher and checkpointer threads @{ */
+
+  /** The highest lsn that a committing transaction waits to be written */
+  std::atomic<lsn_t> m_write_requested_lsn{};
+
+  /** True while the threads run and commit_up_to() can wait for them */
+  std::atomic<bool> m_threads_active{};
+
+  /** Set to true to make the threads exit */
+  std::atomic<bool> m_threads_shutdown{};
+
+  /** Set when a write is requested and on shutdown */
+  Cond_var *m_writer_event{};
+
+  /** Set when the writer has written the log and on shutdown */
+  Cond_var *m_flusher_event{};
+
+  /** Set when the log is written or flushed by the threads, the committing
+  transactions wait for it */
+  Cond_var *m_commit_event{};
+
+  /** Protects m_async_written and m_async_flushed */
+  std::mutex m_async_commits_mutex{};
+
+  /** Serializes resize_files() */
+  std::mutex m_resize_files_mutex{};
+
+  /** Callbacks of commit_async() that wait for the log to be written, by lsn */
+  std::multimap<lsn_t, std::function<void()>> m_async_written{};
+
+  /** Callbacks of commit_async() that wait for the log to be flushed, by lsn */
+  std::multimap<lsn_t, std::function<void()>> m_async_flushed{};
+
+  /** Number of commits that waited for the log flusher */
+  std::atomic<ulint> m_n_group_commits{};
+
+  /** Number of flushes to disk done by the log flusher */
+  std::atomic<ulint> m_n_group_commit_fsyncs{};
+
+  /** The log writer thread */
+  std::thread m_writer_thread{};
+
+  /** The log flusher thread */
+  std::thread m_flusher_thread{};
+
+  /** Set when the checkpoint age is over the async margin and on shutdown */
+  Cond_var *m_checkpointer_event{};
+
+  /** Set when the checkpointer has written a checkpoint, the threads that
+  are over the sync margin wait for it */
+  Cond_var *m_checkpoint_done_event{};
+
+  /** See get_checkpoint_async_time_us() */
+  std::atomic<uint64_t> m_checkpoint_async_time_us{};
+
+  /** See get_checkpoint_sync_time_us() */
+  std::atomic<uint64_t> m_checkpoint_sync_time_us{};
+
+  /** The checkpointer thread */
+  std::thread m_checkpointer_thread{};
+  /* @} */
 };
    
 using log_t = Log;
\ No newline at end of file
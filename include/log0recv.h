@@ -33,7 +33,12 @@ Created 9/20/1997 Heikki Tuuri
 #include "srv0srv.h"
 #include "ut0byte.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 /**
  * Applies the hashed log records to the page, if the page lsn is less than
@@ -101,22 +106,25 @@ void recv_sys_var_init() noexcept;
 */
 void recv_apply_log_recs(DBLWR *dblwr, bool flush_and_free_pages) noexcept;
 
-/**
- * Block of log record data, variable size struct, see note.
- */
-struct Log_record_data {
+/** A chunk of the log records of a page, variable size struct: the records
+are stored physically immediately after it, see Page_log_records. */
+struct Log_record_chunk {
+  /** @return the records. */
+  [[nodiscard]] byte *data() noexcept {
+    return reinterpret_cast<byte *>(this + 1);
+  }
 
-  /** @return string representation of the data.  */
-  std::string to_string() const noexcept;
+  /** Next chunk or nullptr */
+  Log_record_chunk *m_next{};
 
-  /** Pointer to the next block or nullptr */
-  Log_record_data *m_next;
+  /** Number of bytes of records stored after the struct */
+  uint32_t m_used{};
 
-  /* Note: the log record data is stored physically immediately after this
-  struct, max amount RECV_DATA_BLOCK_SIZE bytes of it */
+  /** Number of bytes after the struct */
+  uint32_t m_size{};
 };
 
-/** Parsed log log record */
+/** Parsed log record, decoded from the chunks of a page by Log_record_reader. */
 struct Log_record {
 
   /** @return string representation of the data.  */
@@ -138,11 +146,8 @@ struct Log_record {
   not necessarily the end lsn of this log record */
   lsn_t m_end_lsn{};
 
-  /** Pointer to the next log record in the singly linked list */
-  Log_record *m_next{};
-
-  /** Chain of blocks containing the log record body */
-  Log_record_data *m_data{};
+  /** The record body, valid until the next record is read */
+  byte *m_body{};
 };
 
 /** States of recv_addr_struct */
@@ -166,6 +171,10 @@ enum Recv_addr_state {
 /** @return string presentation of Recv_addr_state */
 std::string to_string(Recv_addr_state s) noexcept;
 
+/** The log records of a page, in lsn order. They are packed in a list of
+chunks: a record is stored as its type, the start lsn and the length of its
+mtr if it is the first record of the mtr for the page, its length and its body.
+The chunks grow up to what the memory heap can allocate in the buffer pool. */
 struct Page_log_records {
   /** @return string representation of the data.  */
   std::string to_string() const noexcept;
@@ -173,17 +182,19 @@ struct Page_log_records {
   /** Recovery state of the page */
   Recv_addr_state m_state{RECV_NOT_PROCESSED};
 
-  /** Head of the singly linked list */
-  Log_record *m_rec_head{};
+  /** First chunk of the records */
+  Log_record_chunk *m_head{};
+
+  /** Chunk that the records are appended to */
+  Log_record_chunk *m_tail{};
 
-  /** Tail of the singly linked list. */
-  Log_record *m_rec_tail{};
+  /** Start lsn of the mtr of the last record */
+  lsn_t m_last_start_lsn{};
 };
 
 /** Recovery system data structure */
 struct Recv_sys {
-  using Page_log_records_map = std::unordered_map<page_no_t, Page_log_records*>;
-  using Tablespace_map = std::unordered_map<space_id_t, Page_log_records_map>;
+  using Page_map = Page_id_hash<Page_log_records *>;
 
   /** Constructor */
   Recv_sys() noexcept;
@@ -229,6 +240,25 @@ struct Recv_sys {
   /** @return string representation of the data.  */
   std::string to_string() const noexcept;
 
+ private:
+  /**
+   * Appends a chunk to the records of a page.
+   *
+   * @param[in,out] page_recs   Records of the page.
+   * @param[in] min_size        The chunk must hold at least this many bytes.
+   */
+  void add_chunk(Page_log_records *page_recs, ulint min_size) noexcept;
+
+  /**
+   * Appends bytes to the records of a page.
+   *
+   * @param[in,out] page_recs   Records of the page.
+   * @param[in] ptr             Bytes to append.
+   * @param[in] len             Number of bytes.
+   */
+  void append(Page_log_records *page_recs, const byte *ptr, ulint len) noexcept;
+
+ public:
   /** mutex protecting the fields apply_log_recs, n_addrs, and
   the state field in each recv_addr struct */
   mutable mutex_t m_mutex{};
@@ -286,15 +316,99 @@ struct Recv_sys {
   mem_heap_t *m_heap{};
 
   /** Parsed log records that need to be applied to the tablepsace pages. */
-  Tablespace_map m_log_records{};
+  Page_map m_log_records{};
 
   /** Number of log records parsed and stored in m_log_records so far. */
   ulint m_n_log_records{};
+
+  /** Pages whose first log record was parsed since the last prefetch, their
+  reads are issued while the scan goes on. */
+  std::vector<Page_id> m_prefetch{};
+
+  /** Number of pages prefetched in the current batch. */
+  ulint m_n_prefetched{};
+};
+
+/** Phases of the recovery, see Recv_stats. */
+enum Recv_phase {
+  /** Restore of the half-written pages from the doublewrite buffer */
+  RECV_PHASE_DBLWR,
+
+  /** Read of the log and scan of its blocks */
+  RECV_PHASE_SCAN,
+
+  /** Parse of the log records and their storage in recv_sys */
+  RECV_PHASE_PARSE,
+
+  /** Application of the log records to the pages */
+  RECV_PHASE_APPLY,
+
+  /** Background rollback of the recovered transactions */
+  RECV_PHASE_ROLLBACK,
+
+  RECV_PHASE_N
+};
+
+/** @return string presentation of Recv_phase */
+const char *to_string(Recv_phase phase) noexcept;
+
+/** Telemetry of a recovery phase. */
+struct Recv_phase_stats {
+  /** Time spent in the phase in microseconds */
+  std::atomic<uint64_t> m_time_us{};
+
+  /** Bytes processed: doublewrite buffer and log bytes read, log record bytes parsed */
+  std::atomic<ulint> m_n_bytes{};
+
+  /** Items processed: pages restored, log records parsed, pages recovered,
+  undo log records rolled back */
+  std::atomic<ulint> m_n_items{};
+
+  /** Data pages read by the phase */
+  std::atomic<ulint> m_n_pages_read{};
+};
+
+/** Telemetry of the last recovery, it outlives recv_sys. */
+struct Recv_stats {
+  /**
+   * Adds the time since start to a phase.
+   *
+   * @param[in] phase           Phase to add to.
+   * @param[in] start           When the phase started.
+   */
+  void add_time(Recv_phase phase, std::chrono::steady_clock::time_point start) noexcept {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    m_phases[phase].m_time_us += uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  }
+
+  /**
+   * Records the memory used by recv_sys, if it is a new peak.
+   *
+   * @param[in] size            Bytes used.
+   */
+  void update_peak_memory(ulint size) noexcept {
+    auto peak = m_peak_memory.load();
+
+    while (size > peak && !m_peak_memory.compare_exchange_weak(peak, size)) {}
+  }
+
+  /** @return the summary of all the phases on one line. */
+  std::string to_string() const noexcept;
+
+  /** The phases, indexed by Recv_phase */
+  std::array<Recv_phase_stats, RECV_PHASE_N> m_phases{};
+
+  /** Peak memory used by recv_sys for the parsed log records */
+  std::atomic<ulint> m_peak_memory{};
 };
 
 /** The recovery system */
 extern Recv_sys *recv_sys;
 
+/** Telemetry of the recovery */
+extern Recv_stats recv_stats;
+
 /** true when applying redo log records during crash recovery; false
 otherwise.  Note that this is false while a background thread is
 rolling back incomplete transactions. */
@@ -313,6 +427,38 @@ extern ib_cb_t recv_pre_rollback_hook;
 /** Maximum page number encountered in the redo log */
 extern ulint recv_max_parsed_page_no;
 
+/**
+ * Flags that corrupt log was found while parsing. The log is also parsed
+ * outside of recovery, see Log_stream, when there is no recv_sys.
+ */
+inline void recv_set_found_corrupt_log() noexcept {
+  if (recv_sys != nullptr) {
+    recv_sys->m_found_corrupt_log = true;
+  }
+}
+
+/**
+ * Tries to parse a single log record and returns its length.
+ * 
+ * @param ptr Pointer to the buffer.
+ * @param end_ptr Pointer to the end of the buffer.
+ * @param type Pointer to the type of the log record.
+ * @param space Pointer to the space id.
+ * @param page_no Pointer to the page number.
+ * @param body Pointer to the log record body.
+ * 
+ * @return	length of the record, or 0 if the record was not complete
+ */
+[[nodiscard]] ulint recv_parse_log_rec(byte *ptr, byte *end_ptr, mlog_type_t *type, space_id_t *space, page_no_t *page_no, byte **body) noexcept;
+
+/**
+ * Calculates the new value for lsn when more data is added to the log.
+ * 
+ * @param lsn The old lsn.
+ * @param len The length of the data added, excluding log block headers.
+ */
+[[nodiscard]] lsn_t recv_calc_lsn_on_data_add(lsn_t lsn, uint64_t len) noexcept;
+
 /** This many frames must be left free in the buffer pool when we scan
 the log and store the scanned log records in the buffer pool: we will
 use these free frames to read in pages when we start applying the
@@ -25,6 +25,34 @@ constexpr ulint LOG_WAIT_ONE_GROUP = 92;
 constexpr ulint LOG_WAIT_ALL_GROUPS = 93;
 /* @} */
 
+/** How the log files are written, the value of the "log_io_mode" config
+variable. */
+enum log_io_mode_t : ulint {
+  /** Buffered writes, made durable by a separate flush as set by the
+  flush_method. */
+  LOG_IO_BUFFERED,
+
+  /** The log files are opened with O_DIRECT, a write that must be durable
+  is submitted together with a linked fdatasync, see
+  IO_request::Sync_log_write_durable. */
+  LOG_IO_DIRECT,
+
+  /** The log files are opened with O_DIRECT and O_DSYNC, every write is
+  durable when it completes. */
+  LOG_IO_DIRECT_DSYNC
+};
+
+/** The checksum of the log blocks that are written, the value of the
+"log_checksum_algorithm" config variable. Either is accepted when the log
+is read, see Log::is_block_checksum_ok(). */
+enum log_checksum_algorithm_t : ulint {
+  /** The original InnoDB shift and add checksum. */
+  LOG_CHECKSUM_INNODB,
+
+  /** CRC32C, computed with the instructions of the CPU if it has them. */
+  LOG_CHECKSUM_CRC32C
+};
+
 /* Values used as flags */
 constexpr ulint LOG_FLUSH = 7652559;
 constexpr ulint LOG_CHECKPOINT = 78656949;
@@ -35,6 +63,15 @@ constexpr auto LOG_START_LSN = lsn_t(16 * IB_FILE_BLOCK_SIZE);
 
 #define LOG_BUFFER_SIZE (srv_config.m_log_buffer_size * UNIV_PAGE_SIZE)
 
+/** How far, in lsn, a mini-transaction can start copying its log to the log
+buffer ahead of the oldest one that is still copying. */
+constexpr ulint LOG_RECENT_WRITTEN_SIZE = 128 * 1024;
+
+/** How far, in lsn, a mini-transaction can start linking its pages to the
+flush lists ahead of the oldest one that is still linking. The flush lists
+are sorted within this distance, it must not exceed BUF_FLUSH_LIST_SLACK. */
+constexpr ulint LOG_RECENT_CLOSED_SIZE = 128 * 1024;
+
 /* Offsets of a log block header */
 
 /** block number which must be > 0 and is allowed to wrap around at 2G; the
@@ -72,6 +109,9 @@ constexpr ulint LOG_BLOCK_CHECKSUM = 4;
 /** trailer size in bytes */
 constexpr ulint LOG_BLOCK_TRL_SIZE = 4;
 
+/** Number of log record bytes in a log block */
+constexpr ulint LOG_BLOCK_DATA_SIZE = IB_FILE_BLOCK_SIZE - LOG_BLOCK_HDR_SIZE - LOG_BLOCK_TRL_SIZE;
+
 /** Maximum number of log groups in log_group_struct::checkpoint_buf */
 constexpr ulint LOG_MAX_N_GROUPS = 32;
 
@@ -85,7 +125,10 @@ constexpr ulint LOG_CHECKPOINT_GROUP_ARRAY = 32;
 /*@} */
 
 /* For each value smaller than LOG_MAX_N_GROUPS the following 8 bytes: @{*/
-constexpr ulint LOG_CHECKPOINT_UNUSED_FILE_NO = 0;
+
+/** Number of files of the group when the checkpoint was written, 0 if
+it was not recorded, the checkpoint offset is in a group of that size */
+constexpr ulint LOG_CHECKPOINT_N_FILES = 0;
 constexpr ulint LOG_CHECKPOINT_UNUSED_OFFSET = 4;
 constexpr ulint LOG_CHECKPOINT_ARRAY_END = LOG_CHECKPOINT_GROUP_ARRAY + LOG_MAX_N_GROUPS * 8;
 constexpr ulint LOG_CHECKPOINT_CHECKSUM_1 = LOG_CHECKPOINT_ARRAY_END;
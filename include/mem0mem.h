@@ -108,6 +108,9 @@ struct mem_block_info_t {
   /** Location where the heap was created */
   Source_location m_loc;
 
+  /** Subsystem that the block is accounted to, derived from m_loc */
+  Mem_tag m_tag;
+
   /** In the first block in the list this is the base
   node of the list of blocks; in subsequent blocks this is undefined */
   UT_LIST_BASE_NODE_T_EXTERN(mem_block_t, list) base;
@@ -188,6 +191,12 @@ void mem_heap_block_free(mem_heap_t *heap, mem_block_t *block);
  */
 void mem_heap_free_block_free(mem_heap_t *heap);
 
+/**
+ * Prints the statistics of the thread local heap block caches, one line
+ * per block size class.
+ */
+void mem_heap_cache_print() noexcept;
+
 /**
  * Adds a new block to a memory heap.
  *
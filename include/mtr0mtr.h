@@ -35,6 +35,7 @@ Created 11/26/1995 Heikki Tuuri
 #include "sync0rw.h"
 #include "sync0sync.h"
 #include "ut0byte.h"
+#include "ut0histogram.h"
 
 
 /* Mini-transaction handle and buffer */
@@ -51,7 +52,10 @@ struct mtr_t {
    * @return mtr buffer which also acts as the mtr handle.
    */
   inline mtr_t *start() noexcept {
-    dyn_array_create(&m_memo);
+    m_memo_heap = nullptr;
+    m_memo_size = 0;
+    m_memo_capacity = MEMO_INLINE_SLOTS;
+
     dyn_array_create(&m_log);
 
     m_log_mode = MTR_LOG_ALL;
@@ -69,6 +73,13 @@ struct mtr_t {
     m_dblwr_create_in_progress = true;
   }
 
+  /** Mark the mini-transaction as part of a scan that reads each page once:
+  the pages it fetches are not made young in the LRU list. Survives commit()
+  and start(), so that a cursor can set it once. */
+  inline void set_scan() noexcept {
+    m_scan = true;
+  }
+
   /**
    * @brief Releases the latches stored in an mtr memo down to a savepoint.
    * 
@@ -122,11 +133,15 @@ struct mtr_t {
    */
   void memo_push(void *object, mtr_memo_type_t type) noexcept { 
     ut_ad(type >= MTR_MEMO_PAGE_S_FIX);
-    ut_ad(type <= MTR_MEMO_X_LOCK);
+    ut_ad(type <= MTR_MEMO_SX_LOCK);
     ut_ad(m_magic_n == MTR_MAGIC_N);
     ut_ad(m_state == MTR_ACTIVE);
 
-    auto slot = reinterpret_cast<mtr_memo_slot_t *>(dyn_array_push(&m_memo, sizeof(mtr_memo_slot_t)));
+    if (unlikely(m_memo_size == m_memo_capacity)) {
+      memo_grow();
+    }
+
+    auto slot = memo_slot(m_memo_size++);
 
     slot->m_type = type;
     slot->m_object = object;
@@ -135,14 +150,13 @@ struct mtr_t {
   /**
    * @brief Sets and returns a savepoint in mtr.
    * 
-   * @return Savepoint.
+   * @return Savepoint, the number of slots in the memo.
    */
   [[nodiscard]] ulint set_savepoint() noexcept {
     ut_ad(m_magic_n == MTR_MAGIC_N);
     ut_ad(m_state == MTR_ACTIVE);
 
-    // FIXME: This can become expensive multi-block mtrs
-    return dyn_array_get_data_size(&m_memo);
+    return m_memo_size;
   }
 
   /**
@@ -160,13 +174,13 @@ struct mtr_t {
    * @param[in] savepoint       The savepoint.
    * @param[in] lock            The latch to release.
    */
-  void release_s_latch_at_savepoint(ulint savepoint, rw_lock_t *lock) const noexcept {
+  void release_s_latch_at_savepoint(ulint savepoint, rw_lock_t *lock) noexcept {
     ut_ad(m_magic_n == MTR_MAGIC_N);
     ut_ad(m_state == MTR_ACTIVE);
 
-    ut_ad(dyn_array_get_data_size(&m_memo) > savepoint);
+    ut_ad(m_memo_size > savepoint);
 
-    auto slot = static_cast<mtr_memo_slot_t *>(dyn_array_get_element(&m_memo, savepoint));
+    auto slot = memo_slot(savepoint);
 
     ut_ad(slot->m_object == lock);
     ut_ad(slot->m_type == MTR_MEMO_S_LOCK);
@@ -239,6 +253,19 @@ struct mtr_t {
     memo_push(lock, MTR_MEMO_X_LOCK);
   }
 
+  /**
+   * @brief Locks a lock in sx-mode.
+   * 
+   * @param[in] lock            The rw-lock.
+   * @param[in] file            The file name.
+   * @param[in] line The line number.
+   */
+  inline void sx_lock_func(rw_lock_t *lock, const char *file, ulint line) {
+    rw_lock_sx_lock_func(lock, file, line);
+
+    memo_push(lock, MTR_MEMO_SX_LOCK);
+  }
+
   /* @return true if the mtr is active. */
   [[nodiscard]] inline bool is_active() const noexcept {
     return m_state == MTR_ACTIVE;
@@ -272,12 +299,8 @@ struct mtr_t {
     ut_ad(m_magic_n == MTR_MAGIC_N);
     ut_ad(m_state == MTR_ACTIVE || m_state == MTR_COMMITTING);
 
-    auto offset = dyn_array_get_data_size(&m_memo);
-
-    while (offset > 0) {
-      offset -= sizeof(mtr_memo_slot_t);
-
-      auto slot = static_cast<mtr_memo_slot_t *>(dyn_array_get_element(&m_memo, offset));
+    for (auto i = m_memo_size; i > 0; --i) {
+      auto slot = memo_slot(i - 1);
 
       if (object == slot->m_object && type == slot->m_type) {
         return true;
@@ -300,12 +323,45 @@ struct mtr_t {
    */
   void disable_redo_logging() noexcept;
 
+  /**
+   * @param[in] i               Index of the slot, must be < m_memo_size.
+   *
+   * @return the memo slot.
+   */
+  [[nodiscard]] mtr_memo_slot_t *memo_slot(ulint i) noexcept {
+    ut_ad(i < m_memo_capacity);
+    return (m_memo_heap != nullptr ? m_memo_heap : m_memo_inline) + i;
+  }
+
+  /**
+   * @param[in] i               Index of the slot, must be < m_memo_size.
+   *
+   * @return the memo slot.
+   */
+  [[nodiscard]] const mtr_memo_slot_t *memo_slot(ulint i) const noexcept {
+    return const_cast<mtr_t *>(this)->memo_slot(i);
+  }
+
+  /** Doubles the capacity of the memo, it moves from m_memo_inline to the
+  heap the first time. */
+  void memo_grow() noexcept;
+
+  /** Frees the memo if it is on the heap. */
+  void memo_free() noexcept;
+
+  /** Number of memo slots in the mtr itself. A B-tree descent latches one
+  page per level, most mtrs never need the heap. */
+  static constexpr ulint MEMO_INLINE_SLOTS = 32;
+
   /** Mini-transaction state. */
   mtr_state_t m_state{MTR_UNDEFINED};
 
   /** True if the doublewrite is being created. */
   bool m_dblwr_create_in_progress{};
 
+  /** True if the pages are fetched by a scan, see set_scan(). */
+  bool m_scan{};
+
   /** True if the mtr made modifications to buffer pool pages */
   bool m_modifications;
 
@@ -315,8 +371,18 @@ struct mtr_t {
   /** Count of how many page initial log records have been written to the mtr log */
   uint32_t m_n_log_recs;
 
-  /** Memo stack for locks etc. */
-  dyn_array_t m_memo;
+  /** Memo stack for locks etc, the slots are in m_memo_inline until they
+  don't fit and then in m_memo_heap. */
+  mtr_memo_slot_t m_memo_inline[MEMO_INLINE_SLOTS];
+
+  /** The memo slots when there are more than MEMO_INLINE_SLOTS, or nullptr. */
+  mtr_memo_slot_t *m_memo_heap{};
+
+  /** Number of slots in the memo. */
+  ulint m_memo_size{};
+
+  /** Number of slots that fit in the memo without memo_grow(). */
+  ulint m_memo_capacity{MEMO_INLINE_SLOTS};
 
   /** Mini-transaction log */
   dyn_array_t m_log;
@@ -336,3 +402,69 @@ struct mtr_t {
 
 /** This macro locks an rw-lock in x-mode. */
 #define mtr_x_lock(B, MTR) (MTR)->x_lock_func((B), __FILE__, __LINE__)
+
+/** This macro locks an rw-lock in sx-mode. */
+#define mtr_sx_lock(B, MTR) (MTR)->sx_lock_func((B), __FILE__, __LINE__)
+
+/** What the mini-transaction commits record, to tell the large
+mini-transactions and the waits for the log buffer apart in the tail
+latency. */
+enum Mtr_stat : ulint {
+  /** Log bytes of a mini-transaction that writes log. */
+  MTR_STAT_LOG_BYTES,
+
+  /** Memo slots at the commit, of all the mini-transactions. */
+  MTR_STAT_MEMO_SLOTS,
+
+  /** Microseconds from the start of the commit to the release of the
+  latches, of a mini-transaction that writes log. */
+  MTR_STAT_COMMIT_US,
+
+  /** Microseconds that Log::reserve() waited for space in the log buffer
+  or for a resize of it, only the reservations that waited. */
+  MTR_STAT_LOG_SPACE_WAIT_US,
+
+  /** Microseconds that Log::flush_order_begin() waited for the mini-
+  transactions before it to add their pages to the flush lists, only the
+  commits that waited. */
+  MTR_STAT_FLUSH_ORDER_WAIT_US,
+
+  MTR_STAT_COUNT
+};
+
+/** Histograms of the mini-transaction commits. The histograms hold any
+value, not only latencies, see Mtr_stat for the unit of each. */
+struct Mtr_stats {
+  /** Number of shards of each histogram. */
+  static constexpr std::int32_t N_SHARDS = 16;
+
+  /**
+   * Records a value.
+   *
+   * @param[in] stat What the value is.
+   * @param[in] value The value.
+   */
+  void add(Mtr_stat stat, uint64_t value) noexcept { m_histograms[stat].add(value); }
+
+  /**
+   * Returns the percentiles of a histogram.
+   *
+   * @param[in] stat The histogram.
+   * @param[in] reset True to remove the samples after they are read.
+   *
+   * @return the percentiles of the samples since the last reset.
+   */
+  [[nodiscard]] ut::Latency_percentiles get_percentiles(Mtr_stat stat, bool reset) noexcept {
+    ut::Latency_histogram histogram;
+
+    m_histograms[stat].collect(histogram, reset);
+
+    return histogram.get_percentiles();
+  }
+
+  /** Histograms, indexed by Mtr_stat. */
+  std::array<ut::Sharded_latency_histogram<N_SHARDS>, MTR_STAT_COUNT> m_histograms{};
+};
+
+/** Statistics of the mini-transactions of all threads. */
+extern Mtr_stats mtr_stats;
@@ -45,6 +45,9 @@ enum mtr_memo_type_t : byte {
 
   /** Page is locked in X-mode */
   MTR_MEMO_X_LOCK = 56,
+
+  /** Lock is held in SX-mode */
+  MTR_MEMO_SX_LOCK = 57,
 };
 
 /** @name Log item types
@@ -88,7 +91,8 @@ enum mlog_type_t : byte {
   /** Delete record list start on index page */
   MLOG_LIST_START_DELETE = 16,
 
-  /** Copy record list end to a new created index page */
+  /** Copy record list end to a new created index page, only parsed, the
+  copy is now logged with MLOG_PAGE_BUILT */
   MLOG_LIST_END_COPY_CREATED = 17,
 
   /** Reorganize an index page. */
@@ -145,6 +149,13 @@ enum mlog_type_t : byte {
   /** Log record about an .ibd file deletion */
   MLOG_FILE_DELETE = 35,
 
+  /** Image of the records, the page header and the page directory of an
+  index page that was built from sorted records, see page_built_write_log() */
+  MLOG_PAGE_BUILT = 36,
+
+  /** Compact the records of an index page in place, see page_compact() */
+  MLOG_PAGE_COMPACT = 37,
+
   /** Biggest value (used in assertions) */
   MLOG_BIGGEST_TYPE = 47,
 
@@ -253,6 +264,10 @@ inline const char *mlog_type_str(mlog_type_t type) noexcept {
       return "MLOG_FILE_RENAME";
     case MLOG_FILE_DELETE:
       return "MLOG_FILE_DELETE";
+    case MLOG_PAGE_BUILT:
+      return "MLOG_PAGE_BUILT";
+    case MLOG_PAGE_COMPACT:
+      return "MLOG_PAGE_COMPACT";
     default:
       log_fatal("Unknown mlog_type_t: ", (ulint) type);
       return "UNKNOWN";
@@ -18,6 +18,11 @@ limitations under the License.
 #pragma once
 
 #include "innodb0types.h"
+#include "ut0histogram.h"
+
+#include <chrono>
+
+#include <sys/uio.h>
 
 struct fil_node_t;
 
@@ -42,6 +47,49 @@ enum class IO_request {
   Sync_write,
   Sync_log_read,
   Sync_log_write,
+
+  /** A synchronous log write that is durable when it returns: the write and
+  an fdatasync are submitted together as linked io_uring requests. */
+  Sync_log_write_durable,
+};
+
+/** Number of request types. */
+constexpr ulint IO_REQUEST_COUNT = ulint(IO_request::Sync_log_write_durable) + 1;
+
+/** Classes of i/o. A background class can only use a share of the slots of
+its handler, the rest is kept for the other classes, and the requests of
+each class are submitted with their own i/o priority. */
+enum class IO_class {
+  /** Reads that a user thread waits for. */
+  Foreground_read,
+
+  /** Read-ahead and buffer pool load reads. */
+  Read_ahead,
+
+  /** Writes of dirty pages. */
+  Flush,
+
+  /** Redo log reads and writes. */
+  Log,
+
+  /** Data file reads and writes during crash recovery. */
+  Recovery,
+};
+
+/** Number of i/o classes. */
+constexpr ulint IO_CLASS_COUNT = ulint(IO_class::Recovery) + 1;
+
+/** Statistics of an i/o class. */
+struct IO_class_stats {
+  /** Number of requests that have been submitted and not completed. */
+  ulint m_n_pending{};
+
+  /** Moving average of the latency of the recent requests, zero if
+  no request completed yet. */
+  std::chrono::microseconds m_latency{};
+
+  /** Slow moving average of the latency, what the latency usually is. */
+  std::chrono::microseconds m_baseline{};
 };
 
 struct IO_ctx {
@@ -53,6 +101,7 @@ struct IO_ctx {
       case IO_request::Sync_write:
       case IO_request::Sync_log_read:
       case IO_request::Sync_log_write:
+      case IO_request::Sync_log_write_durable:
         return true;
       default:
         return false;
@@ -65,6 +114,7 @@ struct IO_ctx {
       case IO_request::Async_log_write:
       case IO_request::Sync_log_read:
       case IO_request::Sync_log_write:
+      case IO_request::Sync_log_write_durable:
         return true;
       default:
         return false;
@@ -93,12 +143,15 @@ struct IO_ctx {
     m_fil_node = nullptr;
     m_msg = nullptr;
     m_io_request = IO_request::None;
+    m_comp_buf = nullptr;
   }
 
   /** IO file operation result. */
   int m_ret{-1}; 
 
-  /**  Batch mode, we need to wake up the IO handler threads after posting the batch. */
+  /** Batch mode, the caller must call AIO::submit_batch() after posting the batch.
+  Batched data file writes can be coalesced with adjacent writes, each one is
+  still completed with its own context. */
   bool m_batch{};
 
   /** File meta data. */
@@ -109,9 +162,20 @@ struct IO_ctx {
 
   /** Request type. */
   IO_request m_io_request{};
+
+  /** Class of the request, for the scheduling. */
+  IO_class m_io_class{IO_class::Foreground_read};
+
+  /** The compressed image of the page if Fil compressed a page write, it
+  is returned to Fil when the write completes. Such a write is never
+  coalesced with other writes. */
+  byte *m_comp_buf{};
 };
 
 struct AIO {
+  /** Maximum number of buffers in a submit_vectored() request. */
+  static constexpr ulint MAX_IOVS = 64;
+
   /**
   * @brief Initializes the asynchronous io system.
   * Note: The log uses a single thread for IO.
@@ -119,10 +183,20 @@ struct AIO {
   * @param[in] n_slots          Total number of slots per handler
   * @param[in] n_read_queues    Number of queues for read operations
   * @param[in] n_write_queues   Number of queues for write operations
+  * @param[in] sqpoll           If true, a kernel thread shared by all the
+  *                             rings polls their submission queues
+  * @param[in] per_cpu          If true, a request goes to the queue of the
+  *                             CPU of the submitting thread instead of the
+  *                             queue with the fewest pending requests
+  * @param[in] coalesce_window  How long batched writes to adjacent offsets
+  *                             of a file are merged into one vectored
+  *                             write, zero disables the merging
   * 
   * @retval AIO* Pointer to the created instance. Call destroy() below to delete it.
   */
-  static AIO* create(ulint n_slots, ulint n_read_queues, ulint n_write_queues) noexcept;
+  static AIO* create(
+    ulint n_slots, ulint n_read_queues, ulint n_write_queues, bool sqpoll, bool per_cpu,
+    std::chrono::microseconds coalesce_window) noexcept;
 
   /** Destroy an instance that was created using AIO::create()
    * @param[own] aio The instance to destroy.
@@ -144,6 +218,63 @@ struct AIO {
   */
   [[nodiscard]] virtual db_err submit(IO_ctx&& io_ctx, void *buf, ulint n, off_t off) noexcept = 0;
 
+  /**
+  * @brief Submits an asynchronous write of several buffers to consecutive
+  * file offsets as one vectored request, it completes as one request.
+  *
+  * @param[in] io_ctx           Context of the i/o operation, an Async_write.
+  * @param[in] iov              Buffers to write, they are copied.
+  * @param[in] n_iov            Number of buffers, at most MAX_IOVS.
+  * @param[in] off              File offset of the first buffer.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] virtual db_err submit_vectored(IO_ctx&& io_ctx, const iovec *iov, ulint n_iov, off_t off) noexcept = 0;
+
+  /**
+   * @return the moving average of the latency of the asynchronous data file
+   * writes, zero until the first write completed.
+   */
+  [[nodiscard]] virtual std::chrono::microseconds get_write_latency() const noexcept = 0;
+
+  /**
+  * @brief Registers a memory area with the io_uring rings as fixed buffers.
+  * The reads and writes of buffers that are inside a registered area don't
+  * pin the user pages on every request. Nothing is registered if the kernel
+  * refuses, the area is then used as an ordinary buffer.
+  *
+  * @param[in] ptr              Start of the area, it must stay valid until
+  *                             unregister_buffer() is called.
+  * @param[in] len              Length of the area in bytes.
+  */
+  virtual void register_buffer(void *ptr, ulint len) noexcept = 0;
+
+  /**
+  * @brief Unregisters a memory area registered with register_buffer(), there
+  * must be no pending i/o to it.
+  *
+  * @param[in] ptr              Start of the area.
+  * @param[in] len              Length of the area in bytes.
+  */
+  virtual void unregister_buffer(void *ptr, ulint len) noexcept = 0;
+
+  /**
+  * @brief Registers an open file with the io_uring rings, the kernel then
+  * doesn't look up the file on every request.
+  *
+  * @param[in] fh               File handle.
+  * @return the index of the file in the registered files, -1 if it could not
+  * be registered.
+  */
+  [[nodiscard]] virtual int register_file(os_file_t fh) noexcept = 0;
+
+  /**
+  * @brief Unregisters a file registered with register_file(), there must be
+  * no pending i/o to it.
+  *
+  * @param[in] index            Index returned by register_file().
+  */
+  virtual void unregister_file(int index) noexcept = 0;
+
   /**
   * @brief Reaps requests that have completed. It's a blocking function.
   *
@@ -153,6 +284,48 @@ struct AIO {
   */
   [[nodiscard]] virtual db_err reap(aio::Queue_id queue_id, IO_ctx &io_ctx) noexcept = 0;
 
+  /**
+  * @brief Flushes several files to disk. The fsyncs are submitted together
+  * and run in parallel, returns when all of them are done. A file whose
+  * fsync fails is flushed again with os_file_flush(), which reports the
+  * error.
+  *
+  * @param[in] files            Files to flush.
+  * @param[in] n_files          Number of files.
+  */
+  virtual void sync_files(const os_file_t *files, ulint n_files) noexcept = 0;
+
+  /**
+  * @brief Submits the asynchronous read requests that were posted with
+  * IO_ctx::m_batch set. Batched requests are queued until the next request
+  * that is not batched is submitted to the same queue, or until this is
+  * called, so that a batch costs one system call. Batched data file writes
+  * are held in open write runs until this is called at the latest.
+  */
+  virtual void submit_batch() noexcept = 0;
+
+  /**
+  * @brief Returns the statistics of an i/o class.
+  *
+  * @param[in] io_class         Class to return the statistics of.
+  * @return the number of pending requests and the latencies of the class.
+  */
+  [[nodiscard]] virtual IO_class_stats get_class_stats(IO_class io_class) const noexcept = 0;
+
+  /**
+  * @brief Adds the submit to completion latencies of the requests of a type
+  * to a histogram.
+  *
+  * @param[in] io_request       Type of the requests.
+  * @param[in,out] histogram    Histogram to add the latencies to.
+  */
+  virtual void get_latency(IO_request io_request, ut::Latency_histogram &histogram) const noexcept = 0;
+
+  /**
+   * @return the latency percentiles by request type and by queue, one per line.
+  */
+  [[nodiscard]] virtual std::string latency_to_string() const = 0;
+
   /**
   * @brief Waits until there are no pending operations
   * 
@@ -200,7 +373,27 @@ inline const char* to_string(IO_request request) noexcept {
     case IO_request::Sync_log_write:
       return "Sync_log_write";
       break;
+    case IO_request::Sync_log_write_durable:
+      return "Sync_log_write_durable";
+      break;
   }
   ut_error;
   return "Unknown IO request type";
 }
+
+inline const char* to_string(IO_class io_class) noexcept {
+  switch(io_class) {
+    case IO_class::Foreground_read:
+      return "foreground_read";
+    case IO_class::Read_ahead:
+      return "read_ahead";
+    case IO_class::Flush:
+      return "flush";
+    case IO_class::Log:
+      return "log";
+    case IO_class::Recovery:
+      return "recovery";
+  }
+  ut_error;
+  return "Unknown IO class";
+}
@@ -214,7 +214,10 @@ os_file_t os_file_create_simple_no_error_handling(
  * @param file_name         [in] File name, used in the diagnostic message.
  * @param operation_name    [in] "open" or "create"; used in the diagnostic message.
  */
-void os_file_set_nocache(int fd, const char *file_name, const char *operation_name);
+/**
+ * @return true if O_DIRECT was set.
+ */
+bool os_file_set_nocache(int fd, const char *file_name, const char *operation_name);
 
 /**
  * @brief Opens an existing file or creates a new.
@@ -289,6 +292,39 @@ bool os_file_get_size(os_file_t file, off_t *size);
  */
 int64_t os_file_get_size_as_iblonglong(os_file_t file);
 
+/**
+ * @brief Allocates disk space for a range of a file with fallocate(), the
+ * file is extended if the range ends past its end and the range reads back
+ * as zeros.
+ *
+ * @param file Handle to a file.
+ * @param offset Start of the range.
+ * @param len Length of the range in bytes.
+ * @return true if success, false if the file system doesn't support
+ *  fallocate() or the disk is full.
+ */
+bool os_file_allocate(os_file_t file, off_t offset, off_t len);
+
+/**
+ * @brief Deallocates the disk space of a range of a file, the size of the
+ * file does not change and the range reads back as zeros.
+ *
+ * @param file Handle to a file.
+ * @param offset Start of the range.
+ * @param len Length of the range in bytes.
+ * @return true if success, false if the file system doesn't support
+ *  punching holes.
+ */
+bool os_file_punch_hole(os_file_t file, off_t offset, off_t len);
+
+/**
+ * @brief Returns the allocation unit of the file system of a file.
+ *
+ * @param file Handle to a file.
+ * @return the block size in bytes, IB_FILE_BLOCK_SIZE if it is not known.
+ */
+ulint os_file_get_block_size(os_file_t file);
+
 /**
  * @brief Write the specified number of zeros to a newly created file.
  *
@@ -443,6 +479,41 @@ void os_file_print(ib_stream_t ib_stream);
  */
 bool os_file_get_status(const char *path, os_file_stat_t *stat_info);
 
+/**
+ * @brief Checks if the device of a file guarantees that writes of len bytes,
+ * aligned to len, are never torn. The file must be opened with O_DIRECT.
+ *
+ * @param file Handle to the file.
+ * @param len Size of the writes, e.g., UNIV_PAGE_SIZE.
+ * @return true if such writes issued with RWF_ATOMIC are atomic. Always false
+ *  if the system headers predate statx(STATX_WRITE_ATOMIC).
+ */
+bool os_file_supports_atomic_writes(os_file_t file, ulint len);
+
+/**
+ * @brief Returns the alignment that O_DIRECT i/o to a file requires of the
+ * buffer addresses, the lengths and the file offsets.
+ *
+ * @param file Handle to the file.
+ * @return the alignment in bytes, 0 if the file is not opened with O_DIRECT.
+ *  IB_FILE_BLOCK_SIZE if neither statx(STATX_DIOALIGN) nor the block device
+ *  tell the alignment.
+ */
+ulint os_file_get_direct_io_align(os_file_t file);
+
+/**
+ * @brief Checks that an i/o satisfies the O_DIRECT alignment of its file.
+ *
+ * @param align Alignment returned by os_file_get_direct_io_align().
+ * @param ptr Buffer of the i/o.
+ * @param n Length of the i/o in bytes.
+ * @param off File offset of the i/o.
+ * @return true if the i/o is aligned or the file is not opened with O_DIRECT.
+ */
+inline bool os_file_is_direct_io_aligned(ulint align, const void *ptr, ulint n, off_t off) {
+  return align == 0 || (uintptr_t(ptr) % align == 0 && n % align == 0 && ulint(off) % align == 0);
+}
+
 /**
  * @brief Resets the variables.
  */
@@ -27,17 +27,50 @@ Created 9/30/1995 Heikki Tuuri
 
 #include "innodb0types.h"
 
-#include <sys/ipc.h>
-#include <sys/shm.h>
+#include <vector>
 
 typedef void *os_process_t;
 
 typedef unsigned long int os_process_id_t;
 
-extern bool os_use_large_pages;
+/** The kind of pages that back a large memory allocation. */
+enum os_huge_pages_t : ulint {
+  /** Pages of the system page size. */
+  OS_HUGE_PAGES_OFF = 0,
 
-/* Large page size. This may be a boot-time option on some platforms */
-extern ulint os_large_page_size;
+  /** Transparent huge pages, requested with madvise(MADV_HUGEPAGE). */
+  OS_HUGE_PAGES_TRANSPARENT,
+
+  /** Explicitly reserved 2MB huge pages, mmap(MAP_HUGETLB). */
+  OS_HUGE_PAGES_2M,
+
+  /** Explicitly reserved 1GB huge pages, mmap(MAP_HUGETLB). */
+  OS_HUGE_PAGES_1G
+};
+
+/** NUMA memory policy of a large memory allocation. */
+enum os_numa_policy_t : ulint {
+  /** The default policy of the process, usually first touch. */
+  OS_NUMA_OFF = 0,
+
+  /** The pages are interleaved across all the nodes. */
+  OS_NUMA_INTERLEAVE,
+
+  /** The pages are bound to a single node. */
+  OS_NUMA_BIND
+};
+
+/** Where and how the memory of a large allocation is placed. */
+struct os_mem_placement_t {
+  /** Kind of pages. */
+  os_huge_pages_t m_huge_pages{OS_HUGE_PAGES_OFF};
+
+  /** NUMA policy. */
+  os_numa_policy_t m_numa{OS_NUMA_OFF};
+
+  /** Node for OS_NUMA_BIND. */
+  ulint m_numa_node{};
+};
 
 /** Converts the current process id to a number. It is not guaranteed that the
 number is unique. In Linux returns the 'process number' of the current
@@ -46,17 +79,63 @@ the thread id is not the same as one sees in 'top'.
 @return	process id as a number */
 ulint os_proc_get_number();
 
-/** Allocates large pages memory.
-@return	allocated memory */
-void *os_mem_alloc_large(ulint *n); /*!< in/out: number of bytes */
-
-/** Frees large pages memory. */
-void os_mem_free_large(
-  void *ptr, /*!< in: pointer returned by
-                                    os_mem_alloc_large() */
-  ulint size
-); /*!< in: size returned by
-                                    os_mem_alloc_large() */
+/**
+ * @return the number of NUMA nodes with memory, 1 if NUMA is not available.
+ */
+ulint os_numa_get_n_nodes();
+
+/**
+ * Parses a list of CPUs, for example "0-3,8,10-11".
+ *
+ * @param[in] list              The list.
+ * @param[out] cpus             The CPUs of the list.
+ *
+ * @return true if the list is valid.
+ */
+bool os_cpu_list_parse(const char *list, std::vector<ulint> &cpus);
+
+/**
+ * Gets the CPUs of a NUMA node.
+ *
+ * @param[in] node              The node.
+ * @param[out] cpus             The CPUs of the node.
+ *
+ * @return true if the node exists and has CPUs.
+ */
+bool os_numa_node_get_cpus(ulint node, std::vector<ulint> &cpus);
+
+/**
+ * Finds the NUMA node of the device that holds a file, for an NVMe drive
+ * that is the node its interrupts are delivered to.
+ *
+ * @param[in] path              A file or directory on the device.
+ *
+ * @return the node, or ULINT_UNDEFINED if it is not known.
+ */
+ulint os_numa_node_of_path(const char *path);
+
+/**
+ * Allocates a large block of memory directly from the operating system. If
+ * the huge pages or the NUMA policy that were asked for are not available
+ * the allocation falls back to what is, it only fails if there is no memory.
+ *
+ * @param[in,out] n             Number of bytes, rounded up to a multiple of
+ *                              the page size on return.
+ * @param[in,out] placement     The placement requested, the placement that
+ *                              was obtained on return. If nullptr, system
+ *                              pages and the default NUMA policy are used.
+ *
+ * @return the allocated memory or nullptr.
+ */
+void *os_mem_alloc_large(ulint *n, os_mem_placement_t *placement = nullptr);
+
+/**
+ * Frees memory allocated with os_mem_alloc_large().
+ *
+ * @param[in] ptr               Pointer returned by os_mem_alloc_large().
+ * @param[in] size              Size returned by os_mem_alloc_large().
+ */
+void os_mem_free_large(void *ptr, ulint size);
 
 /** Reset the variables. */
 void os_proc_var_init();
@@ -97,6 +97,77 @@ void os_thread_yield() noexcept;
  */
 void os_thread_sleep(ulint tm) noexcept;
 
+/** Classes of the background threads, the threads of a class can be bound
+to a set of CPUs, see os_thread_set_class_cpus(). */
+enum os_thread_class_t : ulint {
+  /** The AIO handler threads that reap the completions. */
+  OS_THREAD_CLASS_IO = 0,
+
+  /** The log writer, flusher and checkpointer. */
+  OS_THREAD_CLASS_LOG,
+
+  /** The master thread, it coordinates the purge. */
+  OS_THREAD_CLASS_MASTER,
+
+  /** The monitor, error monitor and lock timeout threads. */
+  OS_THREAD_CLASS_MONITOR,
+
+  /** The task scheduler workers, they run the purge workers among others. */
+  OS_THREAD_CLASS_TASK,
+
+  /** The Parallel_reader workers. */
+  OS_THREAD_CLASS_READER,
+
+  /** The page cleaner threads. */
+  OS_THREAD_CLASS_FLUSH,
+
+  /** Number of classes. */
+  OS_THREAD_N_CLASSES
+};
+
+/**
+ * Sets the CPUs of a thread class. The threads of the class that start after
+ * os_thread_class_cpus_init() are bound to them.
+ *
+ * @param[in] thread_class      The class.
+ * @param[in] cpus              "" to not bind the threads, a list of CPUs
+ *                              like "0-3,8", "node:N" for the CPUs of NUMA
+ *                              node N, or "device" for the CPUs of the NUMA
+ *                              node of the device of the data files.
+ *
+ * @return true if cpus is valid.
+ */
+bool os_thread_set_class_cpus(os_thread_class_t thread_class, const char *cpus);
+
+/**
+ * Resolves the CPUs of the thread classes, called at startup before the
+ * background threads are created.
+ *
+ * @param[in] data_home         Directory of the data files, for "device".
+ */
+void os_thread_class_cpus_init(const char *data_home);
+
+/**
+ * Binds the calling thread to the CPUs of its class, if it has any.
+ *
+ * @param[in] thread_class      The class of the thread.
+ */
+void os_thread_bind(os_thread_class_t thread_class);
+
+/**
+ * @param[in] thread_class      A thread class.
+ *
+ * @return true if the threads of the class are bound to a set of CPUs.
+ */
+bool os_thread_class_is_bound(os_thread_class_t thread_class);
+
+/**
+ * Binds the calling thread to the CPUs of a NUMA node.
+ *
+ * @param[in] node              The node.
+ */
+void os_thread_bind_to_numa_node(ulint node);
+
 /** Gets the last operating system error code for the calling thread.
 @return	last error on Windows, 0 otherwise */
 ulint os_thread_get_last_error();
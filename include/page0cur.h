@@ -32,6 +32,9 @@ Created 10/4/1994 Heikki Tuuri
 #include "page0page.h"
 #include "rem0rec.h"
 
+#include <atomic>
+#include <limits>
+
 #define PAGE_CUR_ADAPT
 
 /* Page cursor search modes; the values must be in this order! */
@@ -88,6 +91,22 @@ void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const
  */
 void page_cur_delete_rec(page_cur_t *cursor, const Index *index, const ulint *offsets, mtr_t *mtr);
 
+#ifdef UNIV_DEBUG
+/**
+ * @brief Checks that the records of a page may be changed by the mini-transaction.
+ * Btree_cursor::search_optimistic() reads the non-leaf pages without latching
+ * them and validates the reads against the index lock, the records of a non-leaf
+ * page must therefore only change while the index lock is X-latched. Pages that
+ * are built without a mini-transaction and crash recovery are exempt.
+ * 
+ * @param page Index page.
+ * @param index Index of the page.
+ * @param mtr Mini-transaction handle, or nullptr.
+ * @return true if the change is allowed.
+ */
+[[nodiscard]] bool page_cur_change_allowed(const page_t *page, const Index *index, const mtr_t *mtr) noexcept;
+#endif /* UNIV_DEBUG */
+
 /**
  * @brief Searches the right position for a page cursor.
  * 
@@ -106,14 +125,111 @@ void page_cur_search_with_match(
   ulint *iup_matched_bytes, ulint *ilow_matched_fields, ulint *ilow_matched_bytes, page_cur_t *cursor
 );
 
+/** Copy of the first key field of the records that own the directory slots
+of an index page, for indexes whose first field is a fixed length integer,
+stored so that it sorts as an unsigned big-endian number (DATA_INT, DATA_SYS).
+page_cur_search_with_match() narrows the binary search over the slots with a
+branchless search of the copy, the records are compared only on the slots
+whose first field ties with the search key.
+
+The copy is kept with the block and built once the page was searched twice
+without a change in between. It is valid while the modify clock of the block
+and the number of slots are those it was built for: the record owning a slot
+only changes when a record is deleted, which increments the modify clock, or
+when a slot is split, which adds a slot. The copy is built and read with the
+page latched and rebuilt only once stale, no reader sees it change. */
+struct Page_dir_cache {
+  /** Pages with fewer slots are searched without the copy. */
+  static constexpr ulint MIN_N_SLOTS = 8;
+
+  /** Alignment of the copied keys, a cache line. */
+  static constexpr ulint ALIGN = 64;
+
+  Page_dir_cache() = default;
+
+  /** Destructor. */
+  ~Page_dir_cache() noexcept;
+
+  Page_dir_cache(const Page_dir_cache &) = delete;
+  Page_dir_cache &operator=(const Page_dir_cache &) = delete;
+
+  /**
+   * Frees the cache of a block.
+   *
+   * @param[in,out] cache       Cache to free, may be nullptr, set to nullptr.
+   */
+  static void destroy(Page_dir_cache *&cache) noexcept;
+
+  /**
+   * Narrows the slot range of a page search with the copied keys, the limits
+   * are only moved to slots whose first field differs from that of the tuple.
+   *
+   * @param[in] block           Latched index page.
+   * @param[in] index           Index of the page.
+   * @param[in] tuple           Search tuple.
+   * @param[in,out] low         Lower limit slot, the record is below tuple.
+   * @param[in,out] up          Upper limit slot, the record is above tuple.
+   * @param[in,out] low_matched_fields Matched fields of the lower limit.
+   * @param[in,out] low_matched_bytes Matched bytes of the lower limit.
+   * @param[in,out] up_matched_fields Matched fields of the upper limit.
+   * @param[in,out] up_matched_bytes Matched bytes of the upper limit.
+   */
+  static void search(
+    const Buf_block *block, const Index *index, const DTuple *tuple, ulint &low, ulint &up, ulint &low_matched_fields,
+    ulint &low_matched_bytes, ulint &up_matched_fields, ulint &up_matched_bytes) noexcept;
+
+ private:
+  /**
+   * Copies the keys of the slot owners.
+   *
+   * @param[in] page            Index page.
+   * @param[in] key_len         Length of the first field.
+   * @param[in] modify_clock    Modify clock of the block.
+   * @param[in] n_slots         Number of slots of the page.
+   */
+  void build(const page_t *page, ulint key_len, uint64_t modify_clock, ulint n_slots) noexcept;
+
+ private:
+  /** Modify clock of the block when the keys were copied. */
+  std::atomic<uint64_t> m_modify_clock{std::numeric_limits<uint64_t>::max()};
+
+  /** Number of slots of the page when the keys were copied. */
+  std::atomic<ulint> m_n_slots{};
+
+  /** Modify clock and number of slots seen by the last search that found
+  the copy stale, the copy is rebuilt when the next one sees the same. */
+  std::atomic<uint64_t> m_pending_modify_clock{std::numeric_limits<uint64_t>::max()};
+  std::atomic<ulint> m_pending_n_slots{};
+
+  /** true while a thread copies the keys. */
+  std::atomic<bool> m_building{};
+
+  /** Length of the first field. */
+  ulint m_key_len{};
+
+  /** Number of copied keys, of the slots between the infimum and the supremum. */
+  ulint m_n_keys{};
+
+  /** Number of keys that fit in m_keys. */
+  ulint m_capacity{};
+
+  /** Allocated memory of m_keys. */
+  void *m_buf{};
+
+  /** The first field of the owner of slot i + 1 is m_keys[i], ALIGN aligned. */
+  uint64_t *m_keys{};
+};
+
 /**
  * @brief Positions a page cursor on a randomly chosen user record on a page. If there
  * are no user records, sets the cursor on the infimum record.
  * 
  * @param block In: Page.
  * @param cursor Out: Page cursor.
+ * @param rnd_state In/out: State of the random numbers, see ut_rnd_gen_ulint(),
+ *  nullptr to use the shared generator.
  */
-void page_cur_open_on_rnd_user_rec(Buf_block *block, page_cur_t *cursor);
+void page_cur_open_on_rnd_user_rec(Buf_block *block, page_cur_t *cursor, ulint *rnd_state = nullptr);
 
 /**
  * @brief Parses a log record of a record insert on a page.
@@ -140,6 +256,28 @@ byte *page_cur_parse_insert_rec(bool is_short, byte *ptr, byte *end_ptr, Buf_blo
  */
 byte *page_parse_copy_rec_list_to_created_page(byte *ptr, byte *end_ptr, Buf_block *block, Index *index, mtr_t *mtr);
 
+/**
+ * @brief Writes a MLOG_PAGE_BUILT log record of an index page that was built
+ * from sorted records. The record holds the page header, the records up to
+ * PAGE_HEAP_TOP and the page directory as they are, one record per page
+ * instead of one insert record per user record.
+ *
+ * @param[in] page              Index page, complete.
+ * @param[in] mtr               Mini-transaction.
+ */
+void page_built_write_log(page_t *page, mtr_t *mtr);
+
+/**
+ * @brief Parses a MLOG_PAGE_BUILT log record and copies the image to the page.
+ *
+ * @param[in] ptr               Buffer.
+ * @param[in] end_ptr           Buffer end.
+ * @param[in,out] block         Page or nullptr.
+ *
+ * @return End of log record or nullptr.
+ */
+byte *page_parse_built(byte *ptr, byte *end_ptr, Buf_block *block);
+
 /**
  * @brief Parses log record of a record delete on a page.
  * 
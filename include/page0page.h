@@ -467,6 +467,33 @@ byte *page_parse_delete_rec_list(
  */
 byte *page_parse_create(byte *ptr, byte *end_ptr, Buf_block *block, Index *index, mtr_t *mtr);
 
+/**
+ * Compacts the records of an index page in place: the records are slid down
+ * to the bottom of the heap in address order, the free list is dropped and
+ * the records get new heap numbers in their key order. The page directory
+ * keeps its slots. Unlike Btree::page_reorganize_low() this needs no
+ * temporary block and logs a single MLOG_PAGE_COMPACT record. The record
+ * locks of the page are not moved, the caller must check that there are none.
+ *
+ * @param[in,out] block buffer block of the page
+ * @param[in] index index of the page
+ * @param[in,out] mtr mini-transaction
+ */
+void page_compact(Buf_block *block, const Index *index, mtr_t *mtr);
+
+/**
+ * Parses a redo log record of compacting a page.
+ *
+ * @param[in] ptr buffer
+ * @param[in] end_ptr buffer end
+ * @param[in,out] block buffer block or NULL
+ * @param[in] index index of the page
+ * @param[in,out] mtr mini-transaction
+ *
+ * @return	end of log record or NULL
+ */
+byte *page_parse_compact(byte *ptr, byte *end_ptr, Buf_block *block, Index *index, mtr_t *mtr);
+
 /**
  * Prints record contents including the data relevant only in
  * the index page context.
@@ -788,7 +815,7 @@ inline bool page_rec_is_infimum(const rec_t *rec) {
  * the parameter rec. These are considered as the negative infinity and
  * the positive infinity in the alphabetical order.
  * 
- * @param[in] cmp_ctx client compare context
+ * @param[in] index index of the record
  * @param[in] dtuple data tuple
  * @param[in] rec physical record on a page; may also be page infimum or supremum,
  *  in which case matched-parameter values below are not affected
@@ -803,7 +830,7 @@ inline bool page_rec_is_infimum(const rec_t *rec) {
  *  respectively, when only the common first fields are compared
  */
 inline int page_cmp_dtuple_rec_with_match(
-  void *cmp_ctx,
+  const Index *index,
   const DTuple *dtuple,
   const rec_t *rec,
   const ulint *offsets,
@@ -823,7 +850,7 @@ inline int page_cmp_dtuple_rec_with_match(
     return -1;
   }
 
-  return cmp_dtuple_rec_with_match(cmp_ctx, dtuple, rec, offsets, matched_fields, matched_bytes);
+  return cmp_dtuple_rec_with_match(index, dtuple, rec, offsets, matched_fields, matched_bytes);
 }
 
 /**
@@ -1272,11 +1299,90 @@ inline void page_mem_free(page_t *page, rec_t *rec, const Index *index, const ul
 inline bool page_rec_needs_ext(ulint rec_size) {
   ut_ad(rec_size > REC_N_EXTRA_BYTES);
 
-#if UNIV_PAGE_SIZE > REC_MAX_DATA_SIZE
-  if (unlikely(rec_size >= REC_MAX_DATA_SIZE)) {
-    return true;
+  /* The field end offsets of a record are 14 bits, above 16K pages the
+  records must be shorter than the page allows. */
+  if constexpr (UNIV_PAGE_SIZE > REC_MAX_DATA_SIZE) {
+    if (unlikely(rec_size >= REC_MAX_DATA_SIZE)) {
+      return true;
+    }
   }
-#endif /* UNIV_PAGE_SIZE > REC_MAX_DATA_SIZE */
 
   return rec_size >= page_get_free_space_of_empty() / 2;
 }
+
+/**
+ * Offsets of the user records that a loop reads from one page. On a leaf
+ * page of an index whose fields are all NOT NULL and of a fixed size the
+ * records all have the same header and the same offsets, see
+ * Index::m_fixed_field_ends, they are computed for the first record and
+ * reused for the others. On the other pages they are computed for each
+ * record, the array is reused like in Rec_offsets.
+ */
+struct Page_rec_offsets {
+  /**
+   * @param[in] index           Index of the page.
+   * @param[in] page            The page that the records are read from.
+   * @param[in] n_fields        Number of fields to get the offsets of, or
+   *                            ULINT_UNDEFINED for all of them.
+   */
+  Page_rec_offsets(const Index *index, const page_t *page, ulint n_fields) noexcept
+      : m_index(index), m_n_fields(n_fields), m_fixed(index->m_fixed_field_ends != nullptr && page_is_leaf(page)) {
+    rec_offs_init(m_buf);
+  }
+
+  ~Page_rec_offsets() noexcept {
+    if (m_heap != nullptr) {
+      mem_heap_free(m_heap);
+    }
+  }
+
+  Page_rec_offsets(const Page_rec_offsets &) = delete;
+  Page_rec_offsets &operator=(const Page_rec_offsets &) = delete;
+
+  /**
+   * Gets the offsets of a user record of the page.
+   *
+   * @param[in] rec             A user record of the page.
+   *
+   * @return the offsets of rec, valid until the next call
+   */
+  [[nodiscard]] ulint *get(const rec_t *rec) noexcept {
+    ut_ad(page_rec_is_user_rec(rec));
+
+    if (m_fixed && m_computed) {
+      ut_ad(rec_get_n_fields(rec) == m_index->m_n_fields);
+      ut_d(rec_offs_make_valid(rec, m_index, m_offsets));
+
+      return m_offsets;
+    }
+
+    Phy_rec record{m_index, rec};
+
+    m_offsets = record.get_col_offsets(m_offsets, m_n_fields, &m_heap, Current_location());
+    m_computed = true;
+
+    return m_offsets;
+  }
+
+private:
+  /** Index of the page */
+  const Index *m_index{};
+
+  /** Number of fields to get the offsets of */
+  ulint m_n_fields{};
+
+  /** true if all the user records of the page have the same offsets */
+  bool m_fixed{};
+
+  /** true once m_offsets were computed for a record */
+  bool m_computed{};
+
+  /** Heap for the offsets of records with many fields */
+  mem_heap_t *m_heap{};
+
+  /** Buffer for the offsets of the other records */
+  ulint m_buf[REC_OFFS_NORMAL_SIZE];
+
+  /** The offsets, m_buf or allocated from m_heap */
+  ulint *m_offsets{m_buf};
+};
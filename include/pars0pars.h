@@ -128,6 +128,18 @@ int yyparse();
  */
 que_t *pars_sql(pars_info_t *info, const char *str);
 
+/**
+ * @brief Sets the bound literals of a parsed graph to the values in another
+ * info struct, so that the graph can be executed again with other values.
+ *
+ * The info must bind the same names with the same types as the info that the
+ * graph was parsed with, the graph keeps pointers to its values.
+ *
+ * @param[in,out] graph Query graph returned by pars_sql().
+ * @param[in] info Info struct with the new values.
+ */
+void pars_rebind_literals(que_t *graph, pars_info_t *info);
+
 /**
  * @brief Retrieves characters to the lexical analyzer.
  * 
@@ -216,7 +216,8 @@ struct sym_node_struct {
   /** Type of the parsed token */
   sym_tab_entry token_type;
 
-  /** Name of an id */
+  /** Name of an id, or of a literal bound with pars_info_add_literal(),
+  nullptr for the other literals */
   const char *name;
 
   /** Id name length */
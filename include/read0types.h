@@ -5,6 +5,8 @@
 #include "mem0mem.h"
 #include "trx0types.h"
 
+struct Row_vers_cache;
+
 /** Normal consistent read view where transaction does not see
 changes made by active transactions except creating transaction. */
 constexpr ulint VIEW_NORMAL = 1;
@@ -57,6 +59,13 @@ struct read_view_t {
   /** trx id of creating transaction, or 0 used in purge */
   trx_id_t creator_trx_id;
 
+  /** Time when the view was created */
+  time_t created;
+
+  /** Old versions of records built for the view, created on the first use,
+  nullptr if none */
+  Row_vers_cache *vers_cache;
+
   /** List of read views in srv_trx_sys */
   UT_LIST_NODE_T(read_view_t) view_list;
 };
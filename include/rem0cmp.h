@@ -30,6 +30,8 @@ Created 7/1/1994 Heikki Tuuri
 #include "innodb0types.h"
 #include "rem0rec.h"
 
+#include <vector>
+
 /**
  * @brief Compares two columns for equality.
  *
@@ -139,6 +141,163 @@ int cmp_dtuple_rec_with_match(
   ulint *matched_bytes
 ) noexcept;
 
+/**
+ * Compares a data tuple to a physical record of an index. The leading
+ * integer fields of the index key, see Index::m_n_int_fields, are compared
+ * as integers, the rest as in the function above. matched_bytes is 0 when
+ * the order is resolved in an integer field.
+ * @see cmp_dtuple_rec_with_match
+ *
+ * @param[in] index            Index of the record.
+ * @param[in] dtuple           Pointer to the data tuple.
+ * @param[in] rec              Pointer to the physical record.
+ * @param[in] offsets          Array returned by Phy_rec::get_col_offsets().
+ * @param[in,out] matched_fields Number of already completely matched fields.
+ * @param[in,out] matched_bytes  Number of already matched bytes within the
+ *                             first field not completely matched.
+ *
+ * @return 1, 0, -1, if dtuple is greater, equal, less than rec, respectively
+ */
+int cmp_dtuple_rec_with_match(
+  const Index *index,
+  const DTuple *dtuple,
+  const rec_t *rec,
+  const ulint *offsets,
+  ulint *matched_fields,
+  ulint *matched_bytes
+) noexcept;
+
+/**
+ * Reads a big-endian unsigned integer of N bytes, the compiler turns the
+ * loop into a load and a byte swap.
+ *
+ * @param[in] b                Integer to read.
+ *
+ * @return the value
+ */
+template <ulint N>
+[[nodiscard]] inline uint64_t cmp_read_int(const byte *b) noexcept {
+  static_assert(N >= 1 && N <= 8, "Integer fields are at most 8 bytes");
+
+  uint64_t v{};
+
+  for (ulint i{}; i < N; ++i) {
+    v = (v << 8) | b[i];
+  }
+
+  return v;
+}
+
+/**
+ * Compares two fixed-width integer fields of N bytes. The integers are
+ * stored big-endian, with the sign bit of signed ones inverted, the order
+ * of their unsigned values is the order of their bytes.
+ *
+ * @param[in] a                First field.
+ * @param[in] b                Second field.
+ *
+ * @return 1, 0, -1, if a is greater, equal, less than b, respectively
+ */
+template <ulint N>
+[[nodiscard]] inline int cmp_int_field(const byte *a, const byte *b) noexcept {
+  const auto x = cmp_read_int<N>(a);
+  const auto y = cmp_read_int<N>(b);
+
+  return (x > y) - (x < y);
+}
+
+/**
+ * Compares two fixed-width integer fields.
+ *
+ * @param[in] a                First field.
+ * @param[in] b                Second field.
+ * @param[in] len              Length of both fields, 1 to 8.
+ *
+ * @return 1, 0, -1, if a is greater, equal, less than b, respectively
+ */
+[[nodiscard]] inline int cmp_int_field(const byte *a, const byte *b, ulint len) noexcept {
+  switch (len) {
+    case 1:
+      return cmp_int_field<1>(a, b);
+    case 2:
+      return cmp_int_field<2>(a, b);
+    case 3:
+      return cmp_int_field<3>(a, b);
+    case 4:
+      return cmp_int_field<4>(a, b);
+    case 5:
+      return cmp_int_field<5>(a, b);
+    case 6:
+      return cmp_int_field<6>(a, b);
+    case 7:
+      return cmp_int_field<7>(a, b);
+    case 8:
+      return cmp_int_field<8>(a, b);
+    default:
+      ut_error;
+      return 0;
+  }
+}
+
+/**
+ * Gets the maximum size of the normalized key of the first fields of an
+ * index entry, see cmp_normalize_key().
+ *
+ * @param[in] index            Index of the entries.
+ * @param[in] n_fields         Number of leading fields to encode.
+ *
+ * @return the maximum size in bytes, or 0 if a field has a type that can't
+ *  be normalized: DECIMAL, client types, BLOBs with a collation other than
+ *  latin1_swedish_ci and columns longer than DICT_MAX_INDEX_COL_LEN.
+ */
+[[nodiscard]] ulint cmp_normalized_key_max_size(const Index *index, ulint n_fields) noexcept;
+
+/**
+ * Encodes the first fields of an index entry into a byte string whose
+ * memcmp() order is the order of cmp_dfield_dfield() on the fields, the
+ * first difference deciding. Equal entries have equal encodings and no
+ * encoding is a prefix of another one. cmp_normalized_key_max_size() must
+ * have returned a non-zero size for the index.
+ *
+ * @param[in] index            Index of the entry.
+ * @param[in] fields           Fields of the entry.
+ * @param[in] n_fields         Number of leading fields to encode.
+ * @param[out] buf             Buffer of cmp_normalized_key_max_size() bytes.
+ *
+ * @return the size of the encoding
+ */
+ulint cmp_normalize_key(const Index *index, const dfield_t *fields, ulint n_fields, byte *buf) noexcept;
+
+/** Compares a field of an index record with a constant. */
+struct Rec_filter {
+  /** Comparison. NULL compares neither true nor false, a NULL field only
+  passes IS_NULL. */
+  enum class Op : uint8_t { EQ, NE, LT, LE, GT, GE, IS_NULL, IS_NOT_NULL };
+
+  /** Position of the field in the index, it must not be stored externally. */
+  ulint m_field_no{ULINT_UNDEFINED};
+
+  /** Comparison to apply. */
+  Op m_op{Op::EQ};
+
+  /** Value to compare with, unused by IS_NULL and IS_NOT_NULL. */
+  const dfield_t *m_value{};
+};
+
+using Rec_filters = std::vector<Rec_filter>;
+
+/**
+ * Evaluates filters on a physical record.
+ *
+ * @param[in] index            Index of the record.
+ * @param[in] rec              Physical record.
+ * @param[in] offsets          Array returned by Phy_rec::get_col_offsets().
+ * @param[in] filters          Filters to evaluate.
+ *
+ * @return true if all the filters are true
+ */
+[[nodiscard]] bool cmp_rec_filters(const Index *index, const rec_t *rec, const ulint *offsets, const Rec_filters &filters) noexcept;
+
 /**
  * Compares a data tuple to a physical record.
  * @see cmp_dtuple_rec_with_match
@@ -1418,3 +1418,67 @@ private:
   /** Record byte array */
   const rec_t *m_rec{};
 };
+
+/**
+ * Offsets of the record a cursor or a scan is on. The array is reused from
+ * one record to the next, a heap is only created for records with more than
+ * REC_OFFS_NORMAL_SIZE fields and kept for the following ones. The offsets
+ * of the last record are kept until the record changes, the owner must call
+ * invalidate() whenever the page latch is released.
+ */
+struct Rec_offsets {
+  Rec_offsets() noexcept {
+    rec_offs_init(m_buf);
+  }
+
+  ~Rec_offsets() noexcept {
+    if (m_heap != nullptr) {
+      mem_heap_free(m_heap);
+    }
+  }
+
+  Rec_offsets(const Rec_offsets &) = delete;
+  Rec_offsets &operator=(const Rec_offsets &) = delete;
+
+  /**
+   * Gets the offsets of a record, computes them unless they are the ones of
+   * the last record.
+   *
+   * @param[in] index           Index of the record.
+   * @param[in] rec             Record.
+   *
+   * @return the offsets of all the fields of rec
+   */
+  [[nodiscard]] ulint *get(const Index *index, const rec_t *rec) noexcept {
+    if (rec != m_rec || index != m_index) {
+      Phy_rec record{index, rec};
+
+      m_offsets = record.get_col_offsets(m_offsets, ULINT_UNDEFINED, &m_heap, Current_location());
+      m_index = index;
+      m_rec = rec;
+    }
+
+    return m_offsets;
+  }
+
+  /** Forgets the last record, its page may change. */
+  void invalidate() noexcept {
+    m_rec = nullptr;
+  }
+
+private:
+  /** Record of m_offsets, nullptr if none */
+  const rec_t *m_rec{};
+
+  /** Index of m_rec */
+  const Index *m_index{};
+
+  /** Offsets array, m_buf or allocated from m_heap */
+  ulint *m_offsets{m_buf};
+
+  /** Heap for records with many fields, or nullptr */
+  mem_heap_t *m_heap{};
+
+  /** Offsets array for records with up to REC_OFFS_NORMAL_SIZE fields */
+  ulint m_buf[REC_OFFS_NORMAL_SIZE];
+};
@@ -30,9 +30,54 @@ Created 4/20/1996 Heikki Tuuri
 #include "row0types.h"
 #include "trx0types.h"
 
+#include <string>
+#include <unordered_set>
+
 const ulint INS_NODE_MAGIC_N = 15849075;
 
 struct Row_update;
+struct Btree_leaf_guess;
+
+/** The parent keys that the foreign key checks of a batch of inserts found.
+The transaction keeps the S lock on each parent record until it commits and
+the batch only inserts, so a key that was found once is found again by the
+later rows of the batch: they skip the lookup in the parent index. Keys are
+compared byte by byte, a key that only compares equal is looked up again. */
+struct Foreign_key_cache {
+  /**
+   * @param[in] foreign         Foreign key constraint
+   * @param[in] entry           Entry of the foreign index, its first fields are the key
+   *
+   * @return true if the parent key of entry was found before
+   */
+  [[nodiscard]] bool contains(const Foreign *foreign, const DTuple *entry) noexcept {
+    make_key(foreign, entry);
+
+    return m_keys.contains(m_key);
+  }
+
+  /**
+   * Notes that the parent key of entry was found and S locked.
+   *
+   * @param[in] foreign         Foreign key constraint
+   * @param[in] entry           Entry of the foreign index, its first fields are the key
+   */
+  void insert(const Foreign *foreign, const DTuple *entry) {
+    make_key(foreign, entry);
+
+    m_keys.insert(m_key);
+  }
+
+ private:
+  /** Builds the key of the constraint and the entry in m_key. */
+  void make_key(const Foreign *foreign, const DTuple *entry);
+
+  /** The keys that were found, each one prefixed by its constraint */
+  std::unordered_set<std::string> m_keys{};
+
+  /** Buffer for the key being looked up */
+  std::string m_key{};
+};
 
 struct Row_insert {
 
@@ -84,6 +129,21 @@ struct Row_insert {
    */
   [[nodiscard]] db_err check_foreign_constraint(bool check_ref, const Foreign *foreign, const Table *table, DTuple *entry, que_thr_t *thr) noexcept;
 
+  /**
+   * @brief Checks that every row of the foreign index of a constraint has a parent row.
+   *
+   * Both indexes are sorted on the key of the constraint: the distinct keys of the
+   * foreign index are read in batches and merged against a forward scan of the
+   * referenced index, that is searched once per batch. No record locks are set, the
+   * caller must hold an S lock on the referenced table and an X lock on the foreign
+   * table, for a table that was bulk loaded.
+   *
+   * @param[in] foreign Foreign key constraint, both its tables must be in the cache.
+   *
+   * @return DB_SUCCESS or DB_NO_REFERENCED_ROW
+   */
+  [[nodiscard]] db_err check_foreign_constraint_sorted(const Foreign *foreign) noexcept;
+
   /**
    * @brief Creates an insert node struct.
    * 
@@ -117,10 +177,11 @@ struct Row_insert {
    * @param[in] n_ext Number of externally stored columns.
    * @param[in] foreign True if foreign key constraints should be checked.
    * @param[in] thr Query thread.
+   * @param[in,out] guess Leaf page of the previous insert of a batch, or nullptr.
    * 
    * @return DB_SUCCESS, DB_LOCK_WAIT, DB_DUPLICATE_KEY, or some other error code.
    */
-  [[nodiscard]] db_err index_entry(const Index *index, DTuple *entry, ulint n_ext, bool foreign, que_thr_t *thr) noexcept;
+  [[nodiscard]] db_err index_entry(const Index *index, DTuple *entry, ulint n_ext, bool foreign, que_thr_t *thr, Btree_leaf_guess *guess = nullptr) noexcept;
 
   /**
    * @brief Inserts a row into a table.
@@ -345,6 +406,20 @@ struct Row_insert {
    */
   [[nodiscard]] db_err scan_sec_index_for_duplicate(const Index *index, DTuple *entry, que_thr_t *thr) noexcept;
 
+  /**
+   * @brief Does the work of scan_sec_index_for_duplicate() on the leaf page
+   * that the insert cursor is on, without a new search, if all the records
+   * that the scan would look at are on that page. Sets the same locks.
+   *
+   * @param[in] btr_cur Insert cursor on a unique non-clustered index, the page is latched.
+   * @param[in] entry Index entry.
+   * @param[in] thr Query thread.
+   *
+   * @return DB_SUCCESS, DB_DUPLICATE_KEY, DB_LOCK_WAIT, or DB_FAIL if the
+   * records may continue on another page, then nothing was locked.
+   */
+  [[nodiscard]] db_err check_sec_index_for_duplicate_on_page(Btree_cursor *btr_cur, DTuple *entry, que_thr_t *thr) noexcept;
+
   /**
    * @brief Checks if a unique key violation error would occur at an index entry insert.
    * 
@@ -389,10 +464,11 @@ struct Row_insert {
    * @param[in] entry Index entry to insert.
    * @param[in] n_ext Number of externally stored columns.
    * @param[in] thr Query thread.
+   * @param[in,out] guess Leaf page of the previous insert of a batch, or nullptr.
    * 
    * @return DB_SUCCESS, DB_LOCK_WAIT, DB_FAIL if pessimistic retry needed, or error code.
    */
-  [[nodiscard]] db_err index_entry_low(ulint mode, const Index *index, DTuple *entry, ulint n_ext, que_thr_t *thr) noexcept;
+  [[nodiscard]] db_err index_entry_low(ulint mode, const Index *index, DTuple *entry, ulint n_ext, que_thr_t *thr, Btree_leaf_guess *guess = nullptr) noexcept;
 
   /**
    * @brief Sets the values of the dtuple fields in entry from the values of appropriate columns in row.
@@ -413,6 +489,19 @@ struct Row_insert {
    */
   [[nodiscard]] db_err index_entry_step(ins_node_t *node, que_thr_t *thr) noexcept;
 
+  /**
+   * @brief Issues the reads of the secondary index leaf pages that the entries of
+   * the row will be inserted to.
+   *
+   * The entries are inserted one index at a time, each insert would wait for its
+   * own random read. Reading the leaf pages that are not in the buffer pool
+   * asynchronously, before the first secondary index insert, makes the reads
+   * overlap.
+   *
+   * @param[in,out] node Row insert node, positioned after the clustered index entry.
+   */
+  void prefetch_sec_index_leaves(ins_node_t *node) noexcept;
+
   /**
    * @brief Allocates a row id for row and inits the node->index field.
    * 
@@ -504,6 +593,14 @@ struct Insert_node {
   /** Buffer for the row id sys field in row */
   byte *m_row_id_buf{};
 
+  /** Clustered index leaf page of the previous row, set while a batch of
+   * rows in key order is inserted, nullptr otherwise */
+  Btree_leaf_guess *m_clust_guess{};
+
+  /** Parent keys found by the foreign key checks, set while a batch of rows
+   * is inserted, nullptr otherwise */
+  Foreign_key_cache *m_fk_cache{};
+
   /** Transaction id or the last transaction which executed the node */
   trx_id_t m_trx_id{};
 
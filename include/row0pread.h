@@ -31,6 +31,7 @@ Created 2018-01-27 by Sunny Bains. */
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <list>
 #include <memory>
@@ -51,6 +52,7 @@ struct Table;
 #include "db0err.h"
 #include "fil0fil.h"
 #include "os0sync.h"
+#include "rem0cmp.h"
 #include "rem0types.h"
 #include "ut0mpmcbq.h"
 
@@ -92,6 +94,11 @@ other threads complete their sub-tree scans they will pick up more execution
 contexts (Ctx) from the Parallel_reader run queue and start scanning the
 sub-partitions as normal.
 
+Sub-trees can still differ a lot in size, or in how many of their pages are
+in the buffer pool. When a worker finds the run queue empty while others are
+still scanning, each busy worker gives away part of what it has left the next
+time it reaches a page boundary, see Ctx::donate().
+
 Note: The Ctx instances are in a virtual list. Each Ctx instance has a
 range to scan. The start point of this range instance is the end point
 of the Ctx instance scanning values less than its start point. A Ctx
@@ -169,6 +176,13 @@ class Parallel_reader {
     [[nodiscard]] std::string to_string() const;
   };
 
+  /** Filters are evaluated on the visible version of a record, before the
+  callback, so that the rows they reject are never converted. The fields must
+  have a fixed size. */
+  using Filter = Rec_filter;
+
+  using Filters = Rec_filters;
+
   /** Scan (Scan_ctx) configuration. */
   struct Config {
     /** Constructor.
@@ -207,6 +221,14 @@ class Parallel_reader {
     /** Partition id if the index to be scanned belongs to a partitioned table,
     else std::numeric_limits<size_t>::max(). */
     size_t m_partition_id{std::numeric_limits<size_t>::max()};
+
+    /** Only the rows for which all the filters are true are passed to the
+    callback. */
+    Filters m_filters{};
+
+    /** true if the leaf pages read by the scan should not displace the working
+    set in the buffer pool, see mtr_t::set_scan(). */
+    bool m_scan_resistant{};
   };
 
   /** Thread related context information. */
@@ -271,6 +293,31 @@ class Parallel_reader {
     /** Current persistent cursor. */
     PCursor *m_pcursor{};
 
+    /** Work done by the thread, complete in the thread finish callback. */
+    struct Stats {
+      /** Number of Ctx traversed. */
+      size_t m_n_ctxs{};
+
+      /** Number of pages visited by the traversals. */
+      size_t m_n_pages{};
+
+      /** Number of records skipped because they were not visible or did
+      not pass the filters. */
+      uint64_t m_n_skipped{};
+
+      /** Time spent in Ctx::traverse(). */
+      std::chrono::nanoseconds m_traverse_ns{};
+
+      /** Time spent in dequeue(), including the mutex wait. */
+      std::chrono::nanoseconds m_dequeue_ns{};
+
+      /** Time spent waiting for other threads to enqueue work. */
+      std::chrono::nanoseconds m_idle_ns{};
+    };
+
+    /** Statistics of this thread. */
+    Stats m_stats{};
+
     Thread_ctx(Thread_ctx &&) = delete;
     Thread_ctx(const Thread_ctx &) = delete;
     Thread_ctx &operator=(Thread_ctx &&) = delete;
@@ -330,6 +377,16 @@ class Parallel_reader {
   @param[in] f                  Call after last row is processed.*/
   void set_finish_callback(Finish &&f) { m_finish_callback = std::move(f); }
 
+  /** Limit the rate at which the scans move to the next leaf page, the
+  threads wait with the page latches released when they are ahead.
+  @param[in] n_pages            Pages per second of all the scans, 0 for no
+                                limit. */
+  void set_max_pages_per_sec(ulint n_pages) noexcept {
+    m_max_pages_per_sec = n_pages;
+    m_throttle_start = std::chrono::steady_clock::now();
+    m_n_pages_throttled.store(0, std::memory_order_relaxed);
+  }
+
   /** Spawn the threads to do the parallel read for the specified range.
   Don't wait for the spawned to threads to complete.
   @param[in]  n_threads number of threads that *need* to be spawned
@@ -387,6 +444,11 @@ class Parallel_reader {
   /** @return true if job queue is empty. */
   [[nodiscard]] bool is_queue_empty() const;
 
+  /** @return true if a worker is waiting for work and there is none queued. */
+  [[nodiscard]] bool is_work_wanted() const {
+    return m_n_idle.load(std::memory_order_relaxed) > 0 && is_queue_empty();
+  }
+
   /** Poll for requests and execute.
   @param[in]  thread_ctx  thread related context information */
   void worker(Thread_ctx *thread_ctx);
@@ -437,6 +499,9 @@ class Parallel_reader {
   /** Total tasks executed so far. */
   std::atomic_size_t m_n_completed{};
 
+  /** Number of workers waiting for a context to execute. */
+  std::atomic_size_t m_n_idle{};
+
   /** Callback at start (before processing any rows). */
   Start m_start_callback{};
 
@@ -446,6 +511,15 @@ class Parallel_reader {
   /** Error during parallel read. */
   std::atomic<dberr_t> m_err{DB_SUCCESS};
 
+  /** Maximum pages per second that the scans move to, 0 for no limit. */
+  ulint m_max_pages_per_sec{};
+
+  /** When the rate limit was set. */
+  std::chrono::steady_clock::time_point m_throttle_start{};
+
+  /** Number of pages moved to since the rate limit was set. */
+  std::atomic<uint64_t> m_n_pages_throttled{};
+
   /** List of threads used for paralle_read purpose. */
   std::vector<std::thread> m_parallel_read_threads;
 
@@ -590,6 +664,12 @@ class Parallel_reader::Scan_ctx {
   @return true if row is visible to the transaction. */
   [[nodiscard]] bool check_visibility(const rec_t *&rec, ulint *&offsets, mem_heap_t *&heap, mtr_t *mtr);
 
+  /** Evaluate the filters of the scan on a record.
+  @param[in]      rec           Visible version of the row.
+  @param[in]      offsets       Column offsets of rec.
+  @return true if all the filters are true. */
+  [[nodiscard]] bool check_filters(const rec_t *rec, const ulint *offsets) const;
+
   /** Create an execution context for a range and add it to
   the Parallel_reader's run queue.
   @param[in] range              Range for which to create the context.
@@ -732,6 +812,13 @@ class Parallel_reader::Ctx {
   @return DB_SUCCESS or error code. */
   [[nodiscard]] dberr_t split();
 
+  /** Give the second half of the rest of the range to idle workers. The
+  cursor must be after the last record of a page, it is positioned on the
+  first record of the next page.
+  @param[in]  pcursor persistent b-tree cursor
+  @return DB_SUCCESS, DB_END_OF_INDEX if there is no next page, or error code */
+  [[nodiscard]] dberr_t donate(PCursor *pcursor);
+
   /** @return true if in error state. */
   [[nodiscard]] bool is_error_set() const {
     return m_scan_ctx->m_reader->is_error_set() || m_scan_ctx->is_error_set();
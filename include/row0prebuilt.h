@@ -23,18 +23,28 @@ Created 02/03/2009 Sunny Bains
 
 #pragma once
 
+#include <algorithm>
+
 #include "innodb0types.h"
 #include "lock0types.h"
+#include "rem0cmp.h"
 #include "row0sel.h"
 
 struct Trx;
 struct Table;
 
+/** Number of rows the first refill of the row cache holds. */
 constexpr ulint FETCH_CACHE_SIZE = 6;
 
 /* After fetching this many rows, we start caching them in fetch_cache */
 constexpr ulint FETCH_CACHE_THRESHOLD  = 4;
 
+/** Upper bound for the rows a cursor prefetches per page visit. */
+constexpr ulint FETCH_CACHE_MAX_SIZE = 1024;
+
+/** The row cache stops growing once the copies of a refill take this many bytes. */
+constexpr ulint FETCH_CACHE_MAX_BYTES = 1024 * 1024;
+
 /* Values for hint_need_to_fetch_extra_cols */
 constexpr ulint ROW_RETRIEVE_PRIMARY_KEY = 1;
 
@@ -119,72 +129,21 @@ struct Prebuilt {
 
   /* Cached row. */
   struct Cached_row {
-    /**
-     * Add a row to the cache.
-     * 
-     * @param[in] rec record
-     * @param[in] offsets offsets
-     */
-    void add_row(const rec_t *rec, const ulint *offsets) noexcept {
-      /* Get the size of the physical record in the page */
-      const auto rec_len = rec_offs_size(offsets);
-
-      /* Check if there is enough space for the record being added to the cache. Free existing memory if it won't fit. */
-      if (m_max_len < rec_len) {
-        if (m_ptr != nullptr) {
-
-          ut_a(m_max_len > 0);
-          ut_a(m_rec_len > 0);
-          mem_free(m_ptr);
-
-          m_ptr = nullptr;
-          m_rec = nullptr;
-          m_max_len = 0;
-          m_rec_len = 0;
-
-        } else {
-
-          ut_a(m_ptr == nullptr);
-          ut_a(m_rec == nullptr);
-          ut_a(m_max_len == 0);
-          ut_a(m_rec_len == 0);
-        }
-      }
-
-      m_rec_len = rec_len;
-
-      if (m_ptr == nullptr) {
-        m_max_len = m_rec_len * 2;
-        m_ptr = static_cast<byte *>(mem_alloc(m_max_len));
-      }
-
-      ut_a(m_max_len >= m_rec_len);
-
-      /* Note that the pointer returned by rec_copy() is actually an offset into cache->ptr, to the start of the record data. */
-      m_rec = rec_copy(m_ptr, rec, offsets);
-    }
-
-    /** Max len of rec if not nullptr */
-    uint32_t m_max_len{};
-
-    /** Length of valid data in rec */
-    uint32_t m_rec_len{};
-
-    /** Cached record, pointer into the start of the record data */
-    rec_t *m_rec{};
-
-    /** Pointer to start of record */
-    rec_t *m_ptr{};
+    /** Offset of the record origin in Row_cache::m_arena */
+    uint32_t m_rec_offset{};
   };
 
   /** Cache for rows fetched when positioning the cursor. */
   struct Row_cache {
     /**
-     * Clear the row cache.
+     * Clear the row cache. The refill size drops back to its initial value.
      */
     void clear() noexcept {
       m_first = 0;
       m_n_cached = 0;
+      m_n_fetched = 0;
+      m_arena_used = 0;
+      m_n_size = uint16_t(m_n_max > 0 ? std::min(FETCH_CACHE_SIZE, ulint(m_n_max)) : FETCH_CACHE_SIZE - 1);
     }
 
     /**
@@ -206,13 +165,25 @@ struct Prebuilt {
     }
 
     /**
-     * Check if the cache is full.
+     * Check if the cache is full, either by the number of rows or by
+     * the size of the row copies.
      * 
      * @return true if the cache is full.
      */
     [[nodiscard]] inline bool is_cache_full() const noexcept {
       ut_a(m_n_cached <= m_n_size);
-      return m_n_cached == m_n_size - 1;
+      return m_n_cached == m_n_size || m_arena_used >= FETCH_CACHE_MAX_BYTES;
+    }
+
+    /**
+     * Check if a scan with the cursor should fill the cache. This is the
+     * case once the cursor has fetched FETCH_CACHE_THRESHOLD rows one by one,
+     * if prefetching was enabled with set_max_rows().
+     * 
+     * @return true if the rows of the scan should be prefetched.
+     */
+    [[nodiscard]] inline bool is_prefetch_enabled() const noexcept {
+      return m_n_max > 1 && m_n_fetched >= FETCH_CACHE_THRESHOLD;
     }
 
     /**
@@ -222,7 +193,7 @@ struct Prebuilt {
      */
     [[nodiscard]] inline const rec_t *cache_get_row() const noexcept {
       ut_ad(!is_cache_empty());
-      return m_cached_rows[m_first].m_rec;
+      return m_arena + m_cached_rows[m_first].m_rec_offset;
     }
 
     /**
@@ -235,6 +206,7 @@ struct Prebuilt {
 
         if (is_cache_empty()) {
           m_first = 0;
+          m_arena_used = 0;
         }
       }
     }
@@ -248,18 +220,68 @@ struct Prebuilt {
     */
     inline void add_row(const rec_t *rec, const ulint *offsets) noexcept;
 
-    /** Memory heap for cached rows */
-    mem_heap_t *m_heap{};
+    /**
+     * Note that a scan filled the cache. The next refill caches twice as
+     * many rows, up to m_n_max and as long as the copies fit in FETCH_CACHE_MAX_BYTES.
+     */
+    void grow() noexcept {
+      if (m_n_size < m_n_max && m_arena_used * 2 <= FETCH_CACHE_MAX_BYTES) {
+        m_n_size = uint16_t(std::min(ulint(m_n_size) * 2, ulint(m_n_max)));
+      }
+    }
+
+    /**
+     * Set the maximum number of rows that a scan prefetches per page visit.
+     * 
+     * @param[in] n_rows 0 or 1 disables prefetching for scans, it is
+     *  clamped to FETCH_CACHE_MAX_SIZE.
+     */
+    void set_max_rows(ulint n_rows) noexcept {
+      m_n_max = uint16_t(std::min(n_rows, FETCH_CACHE_MAX_SIZE));
+      clear();
+    }
+
+    /**
+     * Make room for n_rows rows. Must only be called when the cache is empty.
+     * 
+     * @param[in] n_rows number of rows
+     */
+    void reserve_rows(ulint n_rows) noexcept;
+
+    /**
+     * Make room for len bytes in the arena. The cached rows are kept.
+     * 
+     * @param[in] len number of bytes
+     */
+    void reserve_bytes(ulint len) noexcept;
+
+    /**
+     * Free the memory of the cache.
+     */
+    void free() noexcept;
 
     /** A cache for fetched rows if we fetch many rows from
     the same cursor: it saves CPU time to fetch them in a batch. */
     Cached_row *m_cached_rows{};
 
-    /** Max size of the row cache. */
+    /** Copies of the cached rows, reused across the refills */
+    byte *m_arena{};
+
+    /** Size of m_arena in bytes */
+    uint32_t m_arena_size{};
+
+    /** Bytes of m_arena used by the current refill */
+    uint32_t m_arena_used{};
+
+    /** Number of rows m_cached_rows can hold */
+    uint16_t m_n_alloc{};
+
+    /** Max size of the row cache, set per cursor. 0 disables prefetching
+    for scans, only exact match searches then use the cache. */
     uint16_t m_n_max{};
 
-    /** Current max setting, must be <= n_max */
-    uint16_t m_n_size{};
+    /** Current max setting, grows up to n_max during a long scan */
+    uint16_t m_n_size{FETCH_CACHE_SIZE - 1};
 
     /* Position of the first not yet fetched row in fetch_cache */
     uint16_t m_first{};
@@ -267,6 +289,9 @@ struct Prebuilt {
     /** Number of not yet accessed rows in fetch_cache */
     uint16_t m_n_cached{};
 
+    /** Number of fetches from the index since the cursor was positioned */
+    ulint m_n_fetched{};
+
     /** ROW_SEL_NEXT or ROW_SEL_PREV */
     ib_cur_op_t m_direction{ROW_SEL_UNDEFINED};
   };
@@ -293,12 +318,31 @@ struct Prebuilt {
    * one column is not in the secondary index, then this is set to true */
   bool m_need_to_access_clustered{};
 
+  /** If true, a secondary index scan that fetches clustered index records
+   * reads ahead the clustered leaf pages of the records that follow on the
+   * secondary leaf page, see Row_sel::prefetch_clust_leaves() */
+  bool m_multi_range_read{};
+
+  /** The secondary index leaf page for which the clustered leaf pages were
+   * last read ahead */
+  page_no_t m_mrr_page_no{FIL_NULL};
+
+  /** Filters on the records of m_index. A record that fails them is skipped
+   * before the clustered index record is fetched and before it is copied */
+  Rec_filters m_filters{};
+
+  /** Memory heap for the values of m_filters */
+  mem_heap_t *m_filter_heap{};
+
   /** Caches the value of row_merge_is_index_usable(trx,index) */
   bool m_index_usable{};
 
   /** true if plain select */
   bool m_simple_select{};
 
+  /** true if the cursor scans many pages once, see mtr_t::set_scan() */
+  bool m_scan_resistant{};
+
   /**
    * Normally 0; if the session is using READ COMMITTED isolation level, in
    * a cursor search, if we set a new  record lock on an index, this is incremented;
@@ -308,6 +352,11 @@ struct Prebuilt {
    * latest record locks */
   uint8_t m_new_rec_locks{};
 
+  /** Set when a fetch returned DB_WOULD_BLOCK because of a lock wait, the next
+   * fetch processes the record that the cursor is stored on again instead of
+   * moving past it */
+  bool m_revisit_stored_rec{};
+
   /** Memory heap from which these auxiliary structures are allocated when needed */
   mem_heap_t *m_heap{};
 
@@ -45,6 +45,20 @@ function used in an SQL execution graph.
 @return	query thread to run next or nullptr */
 que_thr_t *row_purge_step(que_thr_t *thr); /** in: query thread */
 
+/**
+ * Does the purge operation for an undo log record that was fetched by the
+ * purge coordinator. Used by the purge worker threads, the caller must hold
+ * the data dictionary S-latch for the duration of the call.
+ *
+ * @param[in,out] node          Purge node owned by the calling worker.
+ * @param[in] trx               Purge transaction.
+ * @param[in] undo_rec          Undo log record to purge.
+ * @param[in] roll_ptr          Roll pointer to the undo log record.
+ * @param[in,out] cell          Reservation of the record in the purge array,
+ *                              it is released on return.
+ */
+void row_purge_rec(purge_node_t *node, Trx *trx, trx_undo_rec_t *undo_rec, roll_ptr_t roll_ptr, trx_undo_inf_t *cell);
+
 /* Purge node structure */
 
 struct purge_node_t {
@@ -97,4 +111,8 @@ struct purge_node_t {
 
   /** memory heap used as auxiliary storage for row; this must be emptied after a successful purge of a row */
   mem_heap_t *heap;
+
+  /** memory heap for the secondary index entries built from row, emptied after
+  each index; the entries point to the field data of row */
+  mem_heap_t *entry_heap;
 };
@@ -262,6 +262,22 @@ struct Row_sel {
     mem_heap_t **offset_heap,
     mtr_t *mtr) noexcept;
 
+  /**
+   * @brief Issues the reads of the clustered index leaf pages of the records
+   * from rec to the end of its secondary index leaf page.
+   *
+   * Each secondary index record would otherwise wait for its own random read
+   * of a clustered leaf page. The page numbers are found without latching
+   * the clustered index, sorted and read asynchronously, the rows are still
+   * returned in the secondary index order. Done once per secondary leaf page.
+   *
+   * @param[in,out] prebuilt prebuilt struct in the handle
+   * @param[in] sec_index secondary index where rec resides
+   * @param[in] rec record in sec_index, on a latched leaf page
+   * @param[in] trx transaction
+   */
+  void prefetch_clust_leaves(Prebuilt *prebuilt, const Index *sec_index, const rec_t *rec, Trx *trx) noexcept;
+
   /**
    * @brief Restores cursor position after it has been stored. We have to take into
    * account that the record cursor was positioned on may have been deleted.
@@ -256,6 +256,12 @@ struct upd_node_t {
   /** Memory heap used as auxiliary storage; this must be emptied after a successful update */
   mem_heap_t *m_heap{};
 
+  /** Memory heap for the secondary index entries built from m_row and m_upd_row,
+   * it is emptied after each index so that its first block is reused for the
+   * next index and the next row. The entries point to the field data of the
+   * rows, only the tuples themselves are allocated here. */
+  mem_heap_t *m_entry_heap{};
+
   /** Table node in symbol table */
   sym_node_t *m_table_sym{};
 
@@ -468,6 +474,66 @@ struct Row_update {
    */
   [[nodiscard]] que_thr_t *step(que_thr_t *thr) noexcept;
 
+  /**
+   * @brief Updates a clustered index record in place without running the
+   * update query graph. Used by the client interface for updates that change
+   * no ordering field of any index. The record is not locked, nothing is
+   * changed unless the transaction already holds an x-lock on it.
+   *
+   * @param[in,out] pcur  Persistent cursor stored on the record.
+   * @param[in] update    Update vector, clustered index field positions.
+   * @param[in] thr       Query thread, used for the undo logging.
+   *
+   * @return DB_SUCCESS, DB_FAIL if the transaction holds no x-lock on the
+   *  record, DB_OVERFLOW if the update changes the size of a field
+   *  or a field is stored externally, DB_RECORD_NOT_FOUND if the record is
+   *  gone, or an error code from the undo logging. Nothing is changed unless
+   *  DB_SUCCESS is returned.
+   */
+  [[nodiscard]] db_err clust_rec_in_place(Btree_pcursor *pcur, const upd_t *update, que_thr_t *thr) noexcept;
+
+  /**
+   * @brief Adds a delta to an integer field of a clustered index record in
+   * place, the old value is read and the new one written under the same page
+   * latch. The field must not be an ordering field of any index. The record
+   * is not locked, the transaction must already hold an x-lock on it.
+   *
+   * @param[in,out] pcur  Persistent cursor stored on the record.
+   * @param[out] update   Update vector, filled with the new value.
+   * @param[in] field_no  Clustered index field position of the column.
+   * @param[in] usign     Whether the column is unsigned.
+   * @param[in] delta     Value to add, can be negative.
+   * @param[in] thr       Query thread, used for the undo logging.
+   * @param[out] new_value The new value.
+   *
+   * @return DB_SUCCESS, DB_ERROR if the transaction holds no x-lock on the
+   *  record, DB_DATA_MISMATCH if the field is SQL NULL or the new
+   *  value is out of the range of the column, DB_RECORD_NOT_FOUND if the
+   *  record is gone, or an error code from the undo logging. Nothing is
+   *  changed unless DB_SUCCESS is returned.
+   */
+  [[nodiscard]] db_err clust_rec_increment(
+    Btree_pcursor *pcur, upd_t *update, ulint field_no, bool usign, int64_t delta, que_thr_t *thr, int64_t *new_value
+  ) noexcept;
+
+  /**
+   * @brief Delete marks the clustered index records in a key range. The
+   * records of a leaf page are delete marked in one mini-transaction. No
+   * record locks are taken, the caller must hold a LOCK_X on the table, and
+   * the table must have no secondary indexes.
+   *
+   * @param[in] index     Clustered index.
+   * @param[in] low       Lowest key to delete, inclusive, or nullptr for the
+   *                      start of the index.
+   * @param[in] high      Highest key to delete, inclusive, or nullptr for the
+   *                      end of the index.
+   * @param[in] thr       Query thread, used for the undo logging.
+   * @param[out] n_deleted Number of records delete marked.
+   *
+   * @return DB_SUCCESS or error code from the undo logging.
+   */
+  [[nodiscard]] db_err del_mark_clust_range(Index *index, const DTuple *low, const DTuple *high, que_thr_t *thr, ulint *n_deleted) noexcept;
+
   /**
    * @brief Parses the log data of system field values.
    * 
@@ -595,6 +661,23 @@ private:
    */
   [[nodiscard]] bool changes_first_fields_binary(DTuple *entry, const Index *index, const upd_t *update, ulint n) noexcept;
 
+  /**
+   * @brief Checks if a transaction holds an X lock on a clustered index
+   * record, either an explicit one or the implicit lock of the transaction
+   * that last modified the record.
+   *
+   * @param[in] block     Buffer block of the record, latched.
+   * @param[in] rec       Clustered index record.
+   * @param[in] index     Clustered index.
+   * @param[in] offsets   Phy_rec::get_col_offsets(rec, index).
+   * @param[in] trx       Transaction.
+   *
+   * @return true if the record is X-locked by trx.
+   */
+  [[nodiscard]] bool clust_rec_is_x_locked(
+    const Buf_block *block, const rec_t *rec, const Index *index, const ulint *offsets, const Trx *trx
+  ) const noexcept;
+
   /**
    * @brief Checks if the index is currently mentioned as a referenced
    * index in a foreign key constraint.
@@ -28,12 +28,102 @@ Created 2/6/1997 Heikki Tuuri
 #include "mem0types.h"
 #include "trx0types.h"
 
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 struct Trx;
 struct mtr_t;
 struct Index;
+struct Lock_sys;
 struct DTuple;
 struct read_view_t;
 
+/** The old versions of clustered index records that were built for a read
+view, so that a long running reader that reads the same rows again doesn't
+walk the same undo log records again. A version is found by the index, the
+trx id and the roll pointer of the latest version that the walk started
+from, these identify the record version for as long as the view exists
+because purge doesn't free the undo log records that the view may need.
+When the cache is over its size the oldest versions are evicted first. */
+struct Row_vers_cache {
+  /**
+   * Constructor.
+   *
+   * @param[in] max_size          Maximum number of bytes of the versions.
+   */
+  explicit Row_vers_cache(ulint max_size) noexcept : m_max_size(max_size) {}
+
+  /**
+   * Looks up the version of a record that the view sees.
+   *
+   * @param[in] index_id          Id of the clustered index.
+   * @param[in] trx_id            Trx id of the latest version.
+   * @param[in] roll_ptr          Roll pointer of the latest version.
+   * @param[in,out] heap          Heap for the copy of the version.
+   * @param[out] old_rec          Copy of the version, nullptr if the view
+   *                              doesn't see the record.
+   *
+   * @return true if the version is in the cache.
+   */
+  [[nodiscard]] bool lookup(uint64_t index_id, trx_id_t trx_id, roll_ptr_t roll_ptr, mem_heap_t *heap, const rec_t *&old_rec) noexcept;
+
+  /**
+   * Adds the version of a record that the view sees.
+   *
+   * @param[in] index_id          Id of the clustered index.
+   * @param[in] trx_id            Trx id of the latest version.
+   * @param[in] roll_ptr          Roll pointer of the latest version.
+   * @param[in] old_rec           Version seen, nullptr if none.
+   * @param[in] offsets           Offsets of old_rec.
+   */
+  void insert(uint64_t index_id, trx_id_t trx_id, roll_ptr_t roll_ptr, const rec_t *old_rec, const ulint *offsets) noexcept;
+
+ private:
+  /** Identifies the latest version of a record. */
+  struct Key {
+    bool operator==(const Key &rhs) const noexcept = default;
+
+    uint64_t m_index_id;
+    trx_id_t m_trx_id;
+    roll_ptr_t m_roll_ptr;
+  };
+
+  /** Hash function of Key. */
+  struct Key_hash {
+    size_t operator()(const Key &key) const noexcept {
+      return std::hash<uint64_t>()(key.m_roll_ptr ^ (key.m_trx_id << 20) ^ (key.m_index_id << 40));
+    }
+  };
+
+  /** A version that the view sees. */
+  struct Version {
+    /** Header and data of the record, empty if none. */
+    std::string m_rec;
+
+    /** Size of the header. */
+    ulint m_extra_size{};
+  };
+
+  using Versions = std::unordered_map<Key, Version, Key_hash>;
+
+  /** Maximum number of bytes of the versions. */
+  const ulint m_max_size;
+
+  /** Number of bytes of the versions. */
+  ulint m_size{};
+
+  /** Protects the cache, the threads of a parallel read share the view. */
+  std::mutex m_mutex{};
+
+  /** The versions. */
+  Versions m_versions{};
+
+  /** The keys of m_versions in the order they were added, for eviction. */
+  std::list<Key> m_order{};
+};
+
 struct Row_vers {
 
   /** A version of a clustered index record */
@@ -0,0 +1,192 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/srv0conc.h
+Admission control of the client threads
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+struct Trx;
+
+/** Admission control.
+
+Limits the number of transactions that run client operations inside the
+engine to thread_concurrency, 0 disables the limit. A transaction that is
+admitted gets concurrency_tickets tickets, each following operation uses one
+ticket without going through the admission again and the transaction keeps
+its place until the tickets are used up, it commits or it waits for a lock.
+
+A free place is taken with a compare and swap of the number of transactions
+inside. When there is none left, or when other transactions already wait, the
+transaction waits in a FIFO queue and a transaction that leaves hands its place
+to the oldest waiter.
+
+With thread_concurrency_autotune the limit is adjusted once a second between
+1 and thread_concurrency: it keeps moving in the same direction while the
+number of operations per second grows and turns around when it drops. */
+struct Srv_conc {
+  /** Interval between the adjustments of the limit. */
+  static constexpr std::chrono::milliseconds TUNE_INTERVAL{1000};
+
+  /** Constructor. */
+  Srv_conc() noexcept;
+
+  /** Destructor. No transaction may wait. */
+  ~Srv_conc() noexcept;
+
+  /**
+   * Creates an instance.
+   *
+   * @return the instance or nullptr if out of memory.
+   */
+  [[nodiscard]] static Srv_conc *create() noexcept;
+
+  /**
+   * Destroys an instance.
+   *
+   * @param[in,out] conc        Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Srv_conc *&conc) noexcept;
+
+  /**
+   * Called when a client operation starts, waits for a place if needed.
+   *
+   * @param[in,out] trx         Transaction of the operation.
+   */
+  void enter(Trx *trx) noexcept;
+
+  /**
+   * Called when a client operation ends, gives up the place once the tickets
+   * are used up.
+   *
+   * @param[in,out] trx         Transaction of the operation.
+   */
+  void exit(Trx *trx) noexcept;
+
+  /**
+   * Gives up the place of a transaction, e.g., at commit or before a lock
+   * wait.
+   *
+   * @param[in,out] trx         Transaction.
+   *
+   * @return true if the transaction had a place.
+   */
+  bool force_exit(Trx *trx) noexcept;
+
+  /**
+   * Takes a place for a transaction after a lock wait, without waiting even
+   * if the limit is reached.
+   *
+   * @param[in,out] trx         Transaction.
+   */
+  void force_enter(Trx *trx) noexcept;
+
+  /** @return the number of transactions inside. */
+  [[nodiscard]] ulint get_n_active() const noexcept { return m_n_active.load(std::memory_order_relaxed); }
+
+  /** @return the number of transactions waiting for a place. */
+  [[nodiscard]] ulint get_n_waiting() const noexcept { return m_n_waiting.load(std::memory_order_relaxed); }
+
+  /** @return the current limit, 0 if there is none. */
+  [[nodiscard]] ulint get_limit() const noexcept;
+
+ private:
+  /** A waiting transaction. */
+  struct Waiter {
+    /** Set when the waiter was given a place. */
+    bool m_granted{};
+
+    /** Signalled when m_granted is set. */
+    std::condition_variable m_cv{};
+  };
+
+  /** @return true if a place was taken. */
+  [[nodiscard]] bool try_acquire() noexcept;
+
+  /** Gives the free places to the oldest waiters, the caller must own
+  m_mutex. */
+  void grant() noexcept;
+
+  /** Gives up a place. */
+  void release() noexcept;
+
+  /** Adjusts the limit if the interval has passed. */
+  void tune() noexcept;
+
+ private:
+  /** Number of transactions inside. */
+  std::atomic<ulint> m_n_active{};
+
+  /** Number of transactions waiting for a place. */
+  std::atomic<ulint> m_n_waiting{};
+
+  /** The limit set by the tuner, 0 until the first adjustment. */
+  std::atomic<ulint> m_tuned_limit{};
+
+  /** Number of operations started since the last adjustment. */
+  std::atomic<uint64_t> m_n_ops{};
+
+  /** When the limit was last adjusted, in microseconds since the epoch of
+  the steady clock. The thread that swaps it adjusts the limit. */
+  std::atomic<int64_t> m_tune_time_us{};
+
+  /** Operations per second measured at the last adjustment. */
+  double m_last_rate{};
+
+  /** Direction of the last adjustment, +1 or -1. */
+  int m_direction{1};
+
+  /** Protects m_waiters, m_last_rate and m_direction. */
+  std::mutex m_mutex{};
+
+  /** The waiting transactions, oldest first. */
+  std::deque<Waiter *> m_waiters{};
+};
+
+/**
+ * Holds a place for a client operation for the duration of a scope.
+ */
+struct Srv_conc_guard {
+  /**
+   * Constructor, waits for a place.
+   *
+   * @param[in,out] trx         Transaction of the operation.
+   */
+  explicit Srv_conc_guard(Trx *trx) noexcept;
+
+  /** Destructor. */
+  ~Srv_conc_guard() noexcept;
+
+  Srv_conc_guard(const Srv_conc_guard &) = delete;
+  Srv_conc_guard &operator=(const Srv_conc_guard &) = delete;
+
+ private:
+  /** Transaction of the operation. */
+  Trx *m_trx{};
+};
+
+/** The admission control. */
+extern Srv_conc *srv_conc;
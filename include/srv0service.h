@@ -0,0 +1,148 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/srv0service.h
+Background services that run a periodic activity on a thread of their own
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+struct Cond_var;
+
+/** A background service.
+
+Runs rounds of one activity, e.g., purge, on its own thread so that a slow
+round doesn't delay the other activities. After a round that found no more
+work the thread waits for the interval or until it is woken up, otherwise
+it runs the next round right away. */
+struct Srv_service {
+  /**
+   * A round of the activity.
+   *
+   * @return true if there is more work to do right away.
+   */
+  using Round = std::function<bool()>;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] name            Name of the service, for the monitor.
+   * @param[in] interval        Time between the rounds when idle.
+   * @param[in] round           The activity.
+   */
+  Srv_service(const char *name, std::chrono::milliseconds interval, Round round) noexcept;
+
+  /** Destructor. The thread must have been shut down. */
+  ~Srv_service() noexcept;
+
+  /**
+   * Creates an instance, the thread is not started.
+   *
+   * @param[in] name            Name of the service, for the monitor.
+   * @param[in] interval        Time between the rounds when idle.
+   * @param[in] round           The activity.
+   *
+   * @return the instance or nullptr if out of memory.
+   */
+  [[nodiscard]] static Srv_service *create(const char *name, std::chrono::milliseconds interval, Round round) noexcept;
+
+  /**
+   * Destroys an instance.
+   *
+   * @param[in,out] service     Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Srv_service *&service) noexcept;
+
+  /** Starts the thread. */
+  void start() noexcept;
+
+  /**
+   * Stops the thread, does nothing if it is not running.
+   *
+   * @param[in] drain           If true, the rounds run until one finds no
+   *                            more work.
+   */
+  void shutdown(bool drain = false) noexcept;
+
+  /** Wakes up the thread if it waits for the next round. */
+  void wake() noexcept;
+
+  /** @return the name of the service. */
+  [[nodiscard]] const char *get_name() const noexcept { return m_name; }
+
+  /** @return the number of rounds run. */
+  [[nodiscard]] uint64_t get_n_rounds() const noexcept { return m_n_rounds.load(std::memory_order_relaxed); }
+
+  /** @return the total time spent in the rounds, in microseconds. */
+  [[nodiscard]] uint64_t get_busy_time_us() const noexcept { return m_busy_time_us.load(std::memory_order_relaxed); }
+
+  /** @return the time spent in the last round, in microseconds. */
+  [[nodiscard]] uint64_t get_last_round_us() const noexcept { return m_last_round_us.load(std::memory_order_relaxed); }
+
+ private:
+  /** The service thread. */
+  void run() noexcept;
+
+ private:
+  /** Name of the service. */
+  const char *m_name{};
+
+  /** Time between the rounds when idle. */
+  std::chrono::milliseconds m_interval{};
+
+  /** The activity. */
+  Round m_round{};
+
+  /** Set to true to make the thread exit. */
+  std::atomic<bool> m_shutdown{};
+
+  /** If true on shutdown, the thread exits after a round that found no
+  more work. */
+  std::atomic<bool> m_drain{};
+
+  /** Number of rounds run. */
+  std::atomic<uint64_t> m_n_rounds{};
+
+  /** Total time spent in the rounds, in microseconds. */
+  std::atomic<uint64_t> m_busy_time_us{};
+
+  /** Time spent in the last round, in microseconds. */
+  std::atomic<uint64_t> m_last_round_us{};
+
+  /** Set to wake up the thread. */
+  Cond_var *m_event{};
+
+  /** The service thread. */
+  std::thread m_thread{};
+};
+
+/** Syncs the log buffer to disk once a second. */
+extern Srv_service *srv_log_sync_service;
+
+/** Coordinates the purge of the undo logs. */
+extern Srv_service *srv_purge_service;
+
+/** Recalculates the queued index statistics and evicts tables from the
+dictionary cache. */
+extern Srv_service *srv_stats_service;
@@ -46,6 +46,12 @@ Created 10/10/1995 Heikki Tuuri
 #include "que0types.h"
 #include "sync0sync.h"
 #include "trx0types.h"
+#include "ut0histogram.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
 
 struct AIO;
 
@@ -177,9 +183,31 @@ struct Config {
   /** Location of the redo log group files. */
   char *m_log_group_home_dir{};
 
+  /** Directory where the log is archived before it is overwritten, the log
+  is not archived if not set. */
+  char *m_log_archive_dir{};
+
   /** Whether to create a new file for each table. */
   bool m_file_per_table{};
 
+  /** Maximum number of extents a single-table tablespace file is extended
+  by in the background ahead of demand, 0 disables the preallocation. */
+  ulint m_file_preallocate_extents{16};
+
+  /** true if the disk space of the extents freed in the tablespaces is
+  deallocated in the background, see Fil_trim. */
+  bool m_file_trim_freed_extents{};
+
+  /** true if TRUNCATE of a table in its own tablespace frees and recreates
+  the index trees in the tablespace instead of recreating the file. The file
+  does not shrink, the pages of the table in the buffer pool are not
+  invalidated and age out. */
+  bool m_truncate_in_place{};
+
+  /** Percentage of each page the bulk B-tree builder fills, the rest is left
+  free for later inserts and updates, see Btree_load. */
+  ulint m_fill_factor{100};
+
   /** Whether a new raw disk partition was initialized. */
   bool m_created_new_raw{};
 
@@ -198,18 +226,67 @@ struct Config {
   /** Current size of the log buffer, in pages. */
   ulint m_log_buffer_curr_size{ULINT_MAX};
 
+  /** The log buffer grows up to this size in bytes when the mini-transactions
+  have to wait for space in it. */
+  ulint m_log_buffer_max_size{};
+
   /** Whether to flush the log at transaction commit. */
   ulong m_flush_log_at_trx_commit{1};
   
   /** Whether to use adaptive flushing. */
   bool m_adaptive_flushing{true};
 
+  /** Whether the point lookups use the adaptive hash index. */
+  bool m_adaptive_hash_index{true};
+
+  /** Number of partitions of the adaptive hash index. */
+  ulint m_adaptive_hash_index_parts{8};
+
+  /** Whether the page cleaners flush less while the foreground page reads
+  are slower than usual. */
+  bool m_flush_read_throttle{true};
+
   /** Whether to use sys malloc. */
   bool m_use_sys_malloc{true};
 
   /** Size of the buffer pool, in pages. */
   ulint m_buf_pool_size{ULINT_MAX};
 
+  /** Number of buffer pool instances the buffer pool is split into. */
+  ulint m_buf_pool_instances{1};
+
+  /** Size of a buffer pool chunk in bytes, the unit by which the buffer pool
+  instances are resized. */
+  ulint m_buf_pool_chunk_size{128 * 1024 * 1024};
+
+  /** Whether to dump the page ids of the hottest pages at shutdown. */
+  bool m_buf_pool_dump_at_shutdown{true};
+
+  /** Interval between periodic buffer pool dumps in minutes, 0 disables them. */
+  ulint m_buf_pool_dump_interval{};
+
+  /** Percentage of the LRU list of each buffer pool instance that is dumped. */
+  ulint m_buf_pool_dump_pct{25};
+
+  /** Whether to read the pages in the buffer pool dump back in at startup. */
+  bool m_buf_pool_load_at_startup{true};
+
+  /** Kind of pages that back the buffer pool chunks, an os_huge_pages_t. */
+  ulint m_buf_pool_huge_pages{};
+
+  /** NUMA policy of the buffer pool chunks, an os_numa_policy_t. */
+  ulint m_buf_pool_numa{};
+
+  /** Whether to touch the frames of the buffer pool chunks when they are
+  allocated, so that the first reads don't take the page faults. */
+  bool m_buf_pool_prefault{};
+
+  /** Path of the L2 page cache file, the cache is disabled if not set. */
+  char *m_l2_cache_file{};
+
+  /** Size of the L2 page cache file in bytes, 0 disables the cache. */
+  ulint m_l2_cache_size{};
+
   /** Old size of the buffer pool, in pages. */
   ulint m_buf_pool_old_size{ULINT_MAX};
   
@@ -228,16 +305,75 @@ struct Config {
   /** Number of write I/O threads. */
   ulint m_n_write_io_threads{ULINT_MAX};
 
+  /** If true, the AIO io_uring submission queues are polled by a kernel thread. */
+  bool m_aio_sqpoll{false};
+
+  /** If true, an AIO request goes to the queue of the CPU that submits it. */
+  bool m_aio_per_cpu_queues{false};
+
+  /** How long in microseconds adjacent data file writes are merged into one
+  vectored write, 0 disables the merging. */
+  ulint m_aio_write_coalesce_window{200};
+
+  /** Number of page cleaner threads, capped at the number of buffer pool instances. */
+  ulint m_n_page_cleaner_threads{ULINT_MAX};
+
+  /** Number of threads that apply the log records to the pages in recovery. */
+  ulint m_n_recovery_apply_threads{ULINT_MAX};
+
+  /** Number of threads that open the .ibd files and read their headers at startup. */
+  ulint m_n_tablespace_load_threads{ULINT_MAX};
+
+  /** Number of threads that scan the clustered index and sort the entries
+  when indexes are created, 1 builds them in the calling thread. */
+  ulint m_n_index_build_threads{ULINT_MAX};
+
+  /** Number of worker threads of the task scheduler that runs the parallel
+  work of purge, index builds and the tablespace loading. */
+  ulint m_n_task_threads{ULINT_MAX};
+
+  /** Maximum number of transactions that run client operations at the same
+  time, 0 for no limit, see Srv_conc. */
+  ulint m_thread_concurrency{0};
+
+  /** Number of operations a transaction runs after it was admitted before
+  it goes through the admission control again. */
+  ulint m_concurrency_tickets{500};
+
+  /** If true, the admission control adjusts its limit between 1 and
+  m_thread_concurrency to the measured throughput. */
+  bool m_thread_concurrency_autotune{false};
+
+  /** If true, the .ibd files are only scanned when crash recovery is needed. In
+   * a normal startup the tablespaces are created from the data dictionary and
+   * their files are opened on the first access. */
+  bool m_lazy_tablespace_load{false};
+
   /** User settable value of the number of pages that must be present
    * in the buffer cache and accessed sequentially for InnoDB to trigger a
    * readahead request. */
   ulong m_read_ahead_threshold{56};
 
+  /** If true, read the rest of an extent when enough of its pages were
+   * accessed recently, in any order. */
+  bool m_random_read_ahead{false};
+
+  /** Number of leaf pages a cursor reads ahead of itself in a range scan,
+   * 0 disables the prefetch. */
+  ulint m_leaf_prefetch_pages{16};
+
+  /** Maximum percentage of the LRU list that the non-leaf B-tree pages
+   * may use when they are protected from eviction, 0 disables it. */
+  ulint m_lru_protected_pct{5};
+
   /** Number of IO operations per second the server can do */ 
   ulong m_io_capacity{200};
   
   /** File flush method. */
   ulint m_unix_file_flush_method{SRV_UNIX_FSYNC};
+
+  /** Which neighbors of a page are flushed with it, a flush_neighbors_t. */
+  ulint m_flush_neighbors{};
   
   /** Maximum number of open files. */  
   ulint m_max_n_open_files{1024};
@@ -249,6 +385,13 @@ struct Config {
   /** Force recovery. */
   ib_recovery_t m_force_recovery{IB_RECOVERY_DEFAULT};
 
+  /** If true then the files are opened read-only and nothing is written to
+  them: no log files or system tablespace are created, there is no crash
+  recovery, no purge and no background flushing, and the transactions cannot
+  change data. Used to serve reads from a copy of the files of a cleanly
+  shut down instance, e.g. a storage snapshot. */
+  bool m_read_only{};
+
   /** Fast shutdown. */
   ib_shutdown_t m_fast_shutdown{IB_SHUTDOWN_NORMAL};
 
@@ -258,13 +401,41 @@ struct Config {
   /** When estimating number of different key values in an index, sample
    * this many index pages */
   uint64_t m_stats_sample_pages{8};
+
+  /** API operations that take longer than this many microseconds are
+   * logged with the breakdown of their time, and so are the transactions
+   * whose operations took longer than this in total. 0 disables the log. */
+  ulint m_slow_op_threshold_us{0};
+
+  /** Maximum number of tables in the dictionary cache, the master thread
+   * evicts the least recently used unused tables above it. 0 disables the
+   * eviction. */
+  uint64_t m_dict_table_cache_size{4096};
   
   /** Whether to use doublewrite buffer. */
   bool m_use_doublewrite_buf{true};
+
+  /** How the doublewrite buffer is used, a dblwr_mode_t. */
+  ulint m_doublewrite_mode{};
+
+  /** How the log files are written, a log_io_mode_t. */
+  ulint m_log_io_mode{};
+
+  /** Checksum of the log blocks that are written, a log_checksum_algorithm_t. */
+  ulint m_log_checksum_algorithm{};
   
   /** Whether to use checksums. */
   bool m_use_checksums{true};
 
+  /** If true, the checksums of the pages read by read-ahead are verified
+   * on the first access instead of on the IO completion path. */
+  bool m_lazy_checksums{false};
+
+  /** If true, the pages of the single-table tablespaces are compressed with
+   * LZ4 when they are written and the unused tail of each page is punched
+   * out of the file. Only has an effect if LZ4 support was compiled in. */
+  bool m_page_compression{false};
+
   /** The InnoDB main thread tries to keep the ratio of modified pages
    * in the buffer pool to all database pages in the buffer pool smaller than
    * the following number. But it is not guaranteed that the value stays below
@@ -273,14 +444,49 @@ struct Config {
   
   /* Maximum allowable purge history length. <= 0 means 'infinite'. */
   ulong m_max_purge_lag{0};
+
+  /** Upper bound of the DML delay in microseconds when the purge lags,
+  0 means no bound. */
+  ulint m_max_purge_lag_delay{0};
+
+  /** Number of threads that purge the undo records of a batch, partitioned
+  by table, 1 purges them in the master thread. */
+  ulint m_n_purge_threads{1};
+
+  /** Maximum number of bytes of the old row versions that a read view
+  caches, 0 disables the cache, see Row_vers_cache. */
+  ulint m_vers_cache_size{0};
+
+  /** Number of rollback segments that transactions are assigned to round
+  robin, missing ones are created in the system tablespace at startup. */
+  ulint m_n_rollback_segments{1};
+
+  /** Maximum number of insert undo log segments, and as many update undo log
+  segments, that a rollback segment keeps for reuse at commit. Reusing one
+  only writes a new undo log header on its page, creating one allocates and
+  initializes a file segment. */
+  ulint m_undo_cache_size{256};
+
+  /** Grant a released record lock to the waiting transaction that holds
+  the most locks first, instead of in the order of the requests. */
+  bool m_lock_grant_by_weight{false};
 };
 
 /*-------------------------------------------*/
 
-extern ulint srv_n_rows_inserted;
-extern ulint srv_n_rows_updated;
-extern ulint srv_n_rows_deleted;
-extern ulint srv_n_rows_read;
+/** Number of shards of the server statistics counters */
+constexpr int32_t SRV_COUNTER_SHARDS = 64;
+
+/** A server statistic that is bumped from many threads. The shards are
+indexed by CPU and cache line aligned, so the writers don't share cache
+lines. They are summed only when the statistics are read, in
+InnoDB::export_innodb_status() and the monitor. */
+using srv_counter_t = ut::CPU_sharded_counter<SRV_COUNTER_SHARDS>;
+
+extern srv_counter_t srv_n_rows_inserted;
+extern srv_counter_t srv_n_rows_updated;
+extern srv_counter_t srv_n_rows_deleted;
+extern srv_counter_t srv_n_rows_read;
 
 extern bool srv_print_innodb_monitor;
 extern bool srv_print_innodb_tablespace_monitor;
@@ -332,47 +538,56 @@ constexpr ulint SRV_MAX_N_IO_THREADS = 32;
 constexpr ulint SRV_LOG_SPACE_FIRST_ID = 0xFFFFFFF0UL;
 
 /* the number of the log write requests done */
-extern ulint srv_log_write_requests;
+extern srv_counter_t srv_log_write_requests;
 
 /* the number of physical writes to the log performed */
-extern ulint srv_log_writes;
+extern srv_counter_t srv_log_writes;
 
 /* amount of data written to the log files in bytes */
-extern ulint srv_os_log_written;
+extern srv_counter_t srv_os_log_written;
 
 /* amount of writes being done to the log files */
 extern ulint srv_os_log_pending_writes;
 
 /* we increase this counter, when there we don't have enough space in the
 log buffer and have to flush it */
-extern ulint srv_log_waits;
+extern srv_counter_t srv_log_waits;
 
 /* variable that counts amount of data read in total (in bytes) */
-extern ulint srv_data_read;
+extern srv_counter_t srv_data_read;
 
 /* here we count the amount of data written in total (in bytes) */
-extern ulint srv_data_written;
+extern srv_counter_t srv_data_written;
+
+/* bytes of the data file page writes that were saved by compressing the
+pages, see srv_config_t::m_page_compression */
+extern srv_counter_t srv_data_compressed_saved;
+
+/* the number of persistent cursor positions restored without a search, and
+the number of optimistic restores that had to search the index again */
+extern srv_counter_t srv_pcur_restore_hits;
+extern srv_counter_t srv_pcur_restore_misses;
 
 /* this variable counts the amount of times, when the doublewrite buffer
 was flushed */
-extern ulint srv_dblwr_writes;
+extern srv_counter_t srv_dblwr_writes;
 
 /* here we store the number of pages that have been flushed to the
 doublewrite buffer */
-extern ulint srv_dblwr_pages_written;
+extern srv_counter_t srv_dblwr_pages_written;
 
 /* here we store the number of times when we had to wait for a free page
 in the buffer pool. It happens when the buffer pool is full and we need
 to make a flush, in order to be able to read or create a page. */
-extern ulint srv_buf_pool_wait_free;
+extern srv_counter_t srv_buf_pool_wait_free;
 
 /* variable to count the number of pages that were written from the
 buffer pool to disk */
-extern ulint srv_buf_pool_flushed;
+extern srv_counter_t srv_buf_pool_flushed;
 
 /** Number of buffer pool reads that led to the
 reading of a disk page */
-extern ulint srv_buf_pool_reads;
+extern srv_counter_t srv_buf_pool_reads;
 
 /* In this structure we store status variables to be passed to the client. */
 typedef struct Export_vars export_struc;
@@ -405,6 +620,78 @@ extern ulint srv_n_threads_active[];
 SRV_SHUTDOWN_CLEANUP and then to SRV_SHUTDOWN_LAST_PHASE, and so on */
 extern srv_shutdown_state srv_shutdown_state;
 
+/**
+ * @param[in] shutdown          Shutdown mode.
+ *
+ * @return true if the shutdown leaves the dirty pages in the buffer pool, the
+ *  next startup recovers them from the log.
+ */
+inline bool srv_shutdown_skips_flush(ib_shutdown_t shutdown) noexcept {
+  return shutdown == IB_SHUTDOWN_NO_BUFPOOL_FLUSH || shutdown == IB_SHUTDOWN_FAST_WARM;
+}
+
+/** Steps of InnoDB::start(), see Startup_stats. */
+enum Startup_step {
+  /** Allocation and initialization of the buffer pool instances */
+  STARTUP_STEP_BUF_POOL,
+
+  /** Creation or opening of the system tablespace and the log files */
+  STARTUP_STEP_FILES,
+
+  /** Loading of the single-table tablespaces, it overlaps the log scan */
+  STARTUP_STEP_TABLESPACES,
+
+  /** Doublewrite buffer restore and redo log recovery */
+  STARTUP_STEP_RECOVERY,
+
+  /** Start of the transaction system and loading of the data dictionary */
+  STARTUP_STEP_DICT,
+
+  /** Start of the background threads */
+  STARTUP_STEP_THREADS,
+
+  STARTUP_STEP_N
+};
+
+/** @return string presentation of Startup_step */
+const char *to_string(Startup_step step) noexcept;
+
+/** Time spent in the steps of the last startup. */
+struct Startup_stats {
+  /**
+   * Adds the time since start to a step.
+   *
+   * @param[in] step            Step to add to.
+   * @param[in] start           When the step started.
+   */
+  void add_time(Startup_step step, std::chrono::steady_clock::time_point start) noexcept {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    m_time_us[step] += uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  }
+
+  /** Resets the times, at the start of a startup. */
+  void clear() noexcept {
+    for (auto &time_us : m_time_us) {
+      time_us = 0;
+    }
+
+    m_total_us = 0;
+  }
+
+  /** @return the summary of all the steps on one line. */
+  std::string to_string() const noexcept;
+
+  /** Time spent in the steps in microseconds, indexed by Startup_step */
+  std::array<std::atomic<uint64_t>, STARTUP_STEP_N> m_time_us{};
+
+  /** Time from the start of InnoDB::start() until it returned in microseconds */
+  std::atomic<uint64_t> m_total_us{};
+};
+
+/** Telemetry of the startup */
+extern Startup_stats srv_startup_stats;
+
 struct InnoDB {
   /**
   * Boots Innobase server.
@@ -471,6 +758,21 @@ struct InnoDB {
    */
   static void wake_master_thread() noexcept;
 
+  /**
+   * Creates and starts the log sync, purge and stats services, see
+   * srv0service.h. Purge doesn't run with force_recovery >=
+   * IB_RECOVERY_NO_BACKGROUND.
+   *
+   * @return false if out of memory.
+   */
+  [[nodiscard]] static bool create_services() noexcept;
+
+  /** Stops the background services. */
+  static void shutdown_services() noexcept;
+
+  /** Stops and destroys the background services. */
+  static void destroy_services() noexcept;
+
   /**
    * Puts a user OS thread to wait for a lock to be released. If an error
    * occurs during the wait trx->error_state associated with thr is
@@ -541,6 +843,16 @@ struct InnoDB {
    */
   static void export_innodb_status() noexcept;
 
+  /**
+   * Takes a consistent snapshot of the status variables, the values are
+   * read once and copied under srv_innodb_monitor_mutex, so a concurrent
+   * export_innodb_status() can't mix two readings. The kernel mutex is only
+   * held while the transaction and lock counts are read.
+   *
+   * @param[out] vars           The snapshot.
+   */
+  static void snapshot_innodb_status(export_struc &vars) noexcept;
+
   /**
    * Reset variables.
    */
@@ -600,6 +912,103 @@ struct InnoDB {
   [[nodiscard]] static db_err shutdown(ib_shutdown_t shutdown) noexcept;
 };
 
+/** Operations whose latency is recorded in srv_op_stats. */
+enum Srv_op : ulint {
+  /** ib_cursor_moveto() */
+  SRV_OP_CURSOR_MOVETO,
+
+  /** ib_cursor_next() */
+  SRV_OP_CURSOR_NEXT,
+
+  /** ib_cursor_insert_row() */
+  SRV_OP_CURSOR_INSERT,
+
+  /** ib_cursor_update_row() */
+  SRV_OP_CURSOR_UPDATE,
+
+  /** ib_cursor_delete_row() */
+  SRV_OP_CURSOR_DELETE,
+
+  /** ib_trx_commit() */
+  SRV_OP_TRX_COMMIT,
+
+  /** A wait for a table or a record lock. */
+  SRV_OP_LOCK_WAIT,
+
+  SRV_OP_COUNT
+};
+
+/** Latency of the operations in Srv_op. */
+struct Srv_op_stats {
+  /** Number of shards of a histogram. */
+  static constexpr std::int32_t N_SHARDS = 16;
+
+  /** Times an operation for as long as it is in scope. */
+  struct Timer {
+    /**
+     * @param[in,out] stats Where to record the operation.
+     * @param[in] op The operation that starts.
+     */
+    Timer(Srv_op_stats &stats, Srv_op op) noexcept
+        : m_stats(stats), m_op(op), m_start(std::chrono::steady_clock::now()) {}
+
+    ~Timer() noexcept {
+      using namespace std::chrono;
+
+      m_stats.add(m_op, uint64_t(duration_cast<microseconds>(steady_clock::now() - m_start).count()));
+    }
+
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+    /** Where to record the operation. */
+    Srv_op_stats &m_stats;
+
+    /** The operation being timed. */
+    Srv_op m_op;
+
+    /** When the operation started. */
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  /**
+   * Records the latency of an operation.
+   *
+   * @param[in] op The operation.
+   * @param[in] us Latency in microseconds.
+   */
+  void add(Srv_op op, uint64_t us) noexcept { m_latency[op].add(us); }
+
+  /**
+   * Returns the percentiles of an operation.
+   *
+   * @param[in] op The operation.
+   * @param[in] reset True to remove the samples after they are read.
+   *
+   * @return the percentiles of the samples since the last reset.
+   */
+  [[nodiscard]] ut::Latency_percentiles get_percentiles(Srv_op op, bool reset) noexcept {
+    ut::Latency_histogram histogram;
+
+    m_latency[op].collect(histogram, reset);
+
+    return histogram.get_percentiles();
+  }
+
+  /**
+   * @param[in] op The operation.
+   *
+   * @return the name of an operation, e.g., "cursor_moveto".
+   */
+  [[nodiscard]] static const char *get_name(Srv_op op) noexcept;
+
+  /** Latency histograms, indexed by Srv_op. */
+  std::array<ut::Sharded_latency_histogram<N_SHARDS>, SRV_OP_COUNT> m_latency{};
+};
+
+/** Latency of the operations of all threads. */
+extern Srv_op_stats srv_op_stats;
+
 /** In this structure we store status variables to be passed to the client. */
 struct Export_vars {
   /** Pending reads */
@@ -626,6 +1035,18 @@ struct Export_vars {
   /** I/O read requests */
   ulint innodb_data_reads;              
 
+  /** Pages the tablespace files were extended by ahead of demand */
+  ulint innodb_data_pages_preallocated;
+
+  /** Pages of the freed extents whose disk space was deallocated */
+  ulint innodb_data_pages_trimmed;
+
+  /** Pages of the freed extents whose disk space is not deallocated yet */
+  ulint innodb_data_pages_untrimmed;
+
+  /** Bytes of the page writes saved by the page compression */
+  ulint innodb_data_compressed_saved;
+
   /** Buffer pool size */
   ulint innodb_buffer_pool_pages_total; 
 
@@ -641,6 +1062,12 @@ struct Export_vars {
   /** Free pages */
   ulint innodb_buffer_pool_pages_free;  
 
+  /** Kind of pages backing the buffer pool, an os_huge_pages_t */
+  ulint innodb_buffer_pool_huge_pages;
+
+  /** NUMA policy of the buffer pool, an os_numa_policy_t */
+  ulint innodb_buffer_pool_numa;
+
 #ifdef UNIV_DEBUG
   /** Latched pages */
   ulint innodb_buffer_pool_pages_latched;      
@@ -667,6 +1094,33 @@ struct Export_vars {
   /** srv_read_ahead evicted*/
   ulint innodb_buffer_pool_read_ahead_evicted; 
 
+  /** Buf_l2_cache::get_n_hits() */
+  ulint innodb_l2_cache_hits;
+
+  /** Buf_l2_cache::get_n_writes() */
+  ulint innodb_l2_cache_pages_written;
+
+  /** Btr_search::get_n_hits() */
+  ulint innodb_adaptive_hash_hits;
+
+  /** Btr_search::get_n_misses() */
+  ulint innodb_adaptive_hash_misses;
+
+  /** Btr_search::get_n_entries() */
+  ulint innodb_adaptive_hash_entries;
+
+  /** srv_pcur_restore_hits */
+  ulint innodb_pcur_restore_hits;
+
+  /** srv_pcur_restore_misses */
+  ulint innodb_pcur_restore_misses;
+
+  /** srv_defrag_n_pages_scanned */
+  ulint innodb_defrag_pages_scanned;
+
+  /** srv_defrag_n_pages_freed */
+  ulint innodb_defrag_pages_freed;
+
   /** srv_dblwr_pages_written */
   ulint innodb_dblwr_pages_written;            
 
@@ -691,6 +1145,30 @@ struct Export_vars {
   /** Fil::n_log_flushes */
   ulint innodb_os_log_fsyncs;                  
 
+  /** Log::get_n_group_commits() */
+  ulint innodb_log_group_commits;
+
+  /** Log::get_n_group_commit_fsyncs() */
+  ulint innodb_log_group_commit_fsyncs;
+
+  /** innodb_log_group_commits / innodb_log_group_commit_fsyncs */
+  ulint innodb_log_commits_per_fsync;
+
+  /** Log::get_checkpoint_age() */
+  ulint innodb_log_checkpoint_age;
+
+  /** Log::m_max_checkpoint_age_async */
+  ulint innodb_log_checkpoint_age_async;
+
+  /** Log::m_max_checkpoint_age */
+  ulint innodb_log_checkpoint_age_sync;
+
+  /** Log::get_checkpoint_async_time_us() */
+  ulint innodb_log_checkpoint_async_time_us;
+
+  /** Log::get_checkpoint_sync_time_us() */
+  ulint innodb_log_checkpoint_sync_time_us;
+
   /** srv_os_log_pending_writes */
   ulint innodb_os_log_pending_writes;          
 
@@ -735,6 +1213,318 @@ struct Export_vars {
 
   /** srv_n_rows_deleted */
   ulint innodb_rows_deleted;                   
+
+  /** trx_roll_get_n_recovered_trxs() */
+  ulint innodb_recovery_rollback_trxs_left;
+
+  /** trx_roll_get_n_recovered_undo_recs() */
+  ulint innodb_recovery_rollback_undo_recs_left;
+
+  /** Doublewrite restore time in ms */
+  ulint innodb_recovery_dblwr_time_ms;
+
+  /** Pages restored from the doublewrite buffer */
+  ulint innodb_recovery_dblwr_pages_restored;
+
+  /** Log scan time in ms */
+  ulint innodb_recovery_scan_time_ms;
+
+  /** Log bytes scanned */
+  ulint innodb_recovery_scan_bytes;
+
+  /** Log parse time in ms */
+  ulint innodb_recovery_parse_time_ms;
+
+  /** Log records parsed */
+  ulint innodb_recovery_parse_records;
+
+  /** Bytes of the parsed log record bodies */
+  ulint innodb_recovery_parse_bytes;
+
+  /** Log apply time in ms */
+  ulint innodb_recovery_apply_time_ms;
+
+  /** Pages the log records were applied to */
+  ulint innodb_recovery_apply_pages;
+
+  /** Background rollback time in ms */
+  ulint innodb_recovery_rollback_time_ms;
+
+  /** Undo log records rolled back */
+  ulint innodb_recovery_rollback_undo_recs;
+
+  /** Data pages read by all the recovery phases */
+  ulint innodb_recovery_pages_read;
+
+  /** Peak memory used by the parsed log records */
+  ulint innodb_recovery_peak_memory;
+
+  /** Buffer pool initialization time at startup in ms */
+  ulint innodb_startup_buf_pool_time_ms;
+
+  /** System tablespace and log files open time at startup in ms */
+  ulint innodb_startup_files_time_ms;
+
+  /** Single-table tablespaces load time at startup in ms */
+  ulint innodb_startup_tablespaces_time_ms;
+
+  /** Recovery time at startup in ms */
+  ulint innodb_startup_recovery_time_ms;
+
+  /** Transaction system and data dictionary load time at startup in ms */
+  ulint innodb_startup_dict_time_ms;
+
+  /** Background threads start time at startup in ms */
+  ulint innodb_startup_threads_time_ms;
+
+  /** Total startup time in ms */
+  ulint innodb_startup_total_time_ms;
+
+  /** Foreground page reads: pending requests */
+  ulint innodb_aio_foreground_read_pending;
+
+  /** Foreground page reads: recent latency in microseconds */
+  ulint innodb_aio_foreground_read_latency_us;
+
+  /** Read-ahead and buffer pool load reads: pending requests */
+  ulint innodb_aio_read_ahead_pending;
+
+  /** Read-ahead and buffer pool load reads: recent latency in microseconds */
+  ulint innodb_aio_read_ahead_latency_us;
+
+  /** Dirty page writes: pending requests */
+  ulint innodb_aio_flush_pending;
+
+  /** Dirty page writes: recent latency in microseconds */
+  ulint innodb_aio_flush_latency_us;
+
+  /** Redo log reads and writes: pending requests */
+  ulint innodb_aio_log_pending;
+
+  /** Redo log reads and writes: recent latency in microseconds */
+  ulint innodb_aio_log_latency_us;
+
+  /** Data file reads: median of the latency in microseconds */
+  ulint innodb_aio_read_latency_p50_us;
+
+  /** Data file reads: 99th percentile of the latency in microseconds */
+  ulint innodb_aio_read_latency_p99_us;
+
+  /** Data file reads: 99.9th percentile of the latency in microseconds */
+  ulint innodb_aio_read_latency_p999_us;
+
+  /** Data file writes: median of the latency in microseconds */
+  ulint innodb_aio_write_latency_p50_us;
+
+  /** Data file writes: 99th percentile of the latency in microseconds */
+  ulint innodb_aio_write_latency_p99_us;
+
+  /** Data file writes: 99.9th percentile of the latency in microseconds */
+  ulint innodb_aio_write_latency_p999_us;
+
+  /** Log writes: median of the latency in microseconds */
+  ulint innodb_aio_log_write_latency_p50_us;
+
+  /** Log writes: 99th percentile of the latency in microseconds */
+  ulint innodb_aio_log_write_latency_p99_us;
+
+  /** Log writes: 99.9th percentile of the latency in microseconds */
+  ulint innodb_aio_log_write_latency_p999_us;
+
+  /** Data file i/o during crash recovery: pending requests */
+  ulint innodb_aio_recovery_pending;
+
+  /** Data file i/o during crash recovery: recent latency in microseconds */
+  ulint innodb_aio_recovery_latency_us;
+
+  /** Trx_sys::m_rseg_history_len */
+  ulint innodb_purge_history_len;
+
+  /** Undo log records purged per second */
+  ulint innodb_purge_records_per_sec;
+
+  /** Undo logs added to the history list per second */
+  ulint innodb_purge_undo_logs_added_per_sec;
+
+  /** Age in seconds of the oldest read view, it holds back the purge */
+  ulint innodb_purge_oldest_view_age;
+
+  /** Id of the transaction that created the oldest read view */
+  int64_t innodb_purge_oldest_view_trx_id;
+
+  /** srv_dml_needed_delay */
+  ulint innodb_purge_dml_delay_us;
+
+  /** Undo logs assigned from the cache of a rollback segment */
+  ulint innodb_undo_cache_hits;
+
+  /** Undo logs that needed a new undo log segment */
+  ulint innodb_undo_cache_misses;
+
+  /** Undo log segments cached in all the rollback segments */
+  ulint innodb_undo_cached;
+
+  /** Commit undo finalization: median latency in microseconds */
+  ulint innodb_trx_commit_undo_latency_p50_us;
+
+  /** Commit undo finalization: 99th percentile latency in microseconds */
+  ulint innodb_trx_commit_undo_latency_p99_us;
+
+  /** Commit undo finalization: transactions in the phase */
+  ulint innodb_trx_commit_undo_waiting;
+
+  /** Commit lock release: median latency in microseconds */
+  ulint innodb_trx_commit_lock_release_latency_p50_us;
+
+  /** Commit lock release: 99th percentile latency in microseconds */
+  ulint innodb_trx_commit_lock_release_latency_p99_us;
+
+  /** Commit lock release: transactions in the phase */
+  ulint innodb_trx_commit_lock_release_waiting;
+
+  /** Commit log write: median latency in microseconds */
+  ulint innodb_trx_commit_log_write_latency_p50_us;
+
+  /** Commit log write: 99th percentile latency in microseconds */
+  ulint innodb_trx_commit_log_write_latency_p99_us;
+
+  /** Commit log write: transactions in the phase */
+  ulint innodb_trx_commit_log_write_waiting;
+
+  /** Commit log flush: median latency in microseconds */
+  ulint innodb_trx_commit_log_flush_latency_p50_us;
+
+  /** Commit log flush: 99th percentile latency in microseconds */
+  ulint innodb_trx_commit_log_flush_latency_p99_us;
+
+  /** Commit log flush: transactions in the phase */
+  ulint innodb_trx_commit_log_flush_waiting;
+
+  /** Log bytes of the mini-transactions that write log: number of samples */
+  ulint innodb_mtr_log_bytes_count;
+
+  /** Log bytes of the mini-transactions that write log: median */
+  ulint innodb_mtr_log_bytes_p50;
+
+  /** Log bytes of the mini-transactions that write log: 99th percentile */
+  ulint innodb_mtr_log_bytes_p99;
+
+  /** Log bytes of the mini-transactions that write log: largest */
+  ulint innodb_mtr_log_bytes_max;
+
+  /** Memo slots of the mini-transactions at commit: number of samples */
+  ulint innodb_mtr_memo_slots_count;
+
+  /** Memo slots of the mini-transactions at commit: median */
+  ulint innodb_mtr_memo_slots_p50;
+
+  /** Memo slots of the mini-transactions at commit: 99th percentile */
+  ulint innodb_mtr_memo_slots_p99;
+
+  /** Memo slots of the mini-transactions at commit: largest */
+  ulint innodb_mtr_memo_slots_max;
+
+  /** Latch hold time across the commit of the mini-transactions that write log: number of samples */
+  ulint innodb_mtr_commit_count;
+
+  /** Latch hold time across the commit of the mini-transactions that write log: median in microseconds */
+  ulint innodb_mtr_commit_latency_p50_us;
+
+  /** Latch hold time across the commit of the mini-transactions that write log: 99th percentile in microseconds */
+  ulint innodb_mtr_commit_latency_p99_us;
+
+  /** Latch hold time across the commit of the mini-transactions that write log: longest in microseconds */
+  ulint innodb_mtr_commit_latency_max_us;
+
+  /** Waits for space in the log buffer, or for its resize: number of samples */
+  ulint innodb_log_space_waits;
+
+  /** Waits for space in the log buffer, or for its resize: median in microseconds */
+  ulint innodb_log_space_wait_p50_us;
+
+  /** Waits for space in the log buffer, or for its resize: 99th percentile in microseconds */
+  ulint innodb_log_space_wait_p99_us;
+
+  /** Waits for space in the log buffer, or for its resize: longest in microseconds */
+  ulint innodb_log_space_wait_max_us;
+
+  /** Waits for the earlier mini-transactions to add their pages to the flush lists: number of samples */
+  ulint innodb_log_flush_order_waits;
+
+  /** Waits for the earlier mini-transactions to add their pages to the flush lists: median in microseconds */
+  ulint innodb_log_flush_order_wait_p50_us;
+
+  /** Waits for the earlier mini-transactions to add their pages to the flush lists: 99th percentile in microseconds */
+  ulint innodb_log_flush_order_wait_p99_us;
+
+  /** Waits for the earlier mini-transactions to add their pages to the flush lists: longest in microseconds */
+  ulint innodb_log_flush_order_wait_max_us;
+
+  /** Latch acquisitions counted while latch_profile was on */
+  ulint innodb_latch_acquisitions;
+
+  /** Latch acquisitions that had to spin */
+  ulint innodb_latch_contended;
+
+  /** Latch spin rounds */
+  ulint innodb_latch_spin_rounds;
+
+  /** Latch waits that were suspended in the wait array */
+  ulint innodb_latch_os_waits;
+
+  /** Time spent waiting for latches while latch_profile was on */
+  ulint innodb_latch_wait_time_us;
+
+  /** Longest latch wait while latch_profile was on */
+  ulint innodb_latch_max_wait_us;
+
+  /** Bytes allocated by each subsystem, indexed by Mem_tag */
+  ulint innodb_mem_tag_bytes[MEM_TAG_COUNT];
+
+  /** Sampled peak of innodb_mem_tag_bytes */
+  ulint innodb_mem_tag_peak_bytes[MEM_TAG_COUNT];
+
+  /** Number of operations timed, indexed by Srv_op */
+  ulint innodb_op_count[SRV_OP_COUNT];
+
+  /** Median latency of the operations in microseconds, indexed by Srv_op */
+  ulint innodb_op_latency_p50_us[SRV_OP_COUNT];
+
+  /** 99th percentile latency in microseconds, indexed by Srv_op */
+  ulint innodb_op_latency_p99_us[SRV_OP_COUNT];
+
+  /** 99.9th percentile latency in microseconds, indexed by Srv_op */
+  ulint innodb_op_latency_p999_us[SRV_OP_COUNT];
+
+  /** Longest latency in microseconds, indexed by Srv_op */
+  ulint innodb_op_latency_max_us[SRV_OP_COUNT];
+
+  /** Tables in the dictionary cache */
+  ulint innodb_dict_tables_cached;
+
+  /** Tables loaded to the dictionary cache from the system tables */
+  ulint innodb_dict_tables_loaded;
+
+  /** Tables evicted from the dictionary cache */
+  ulint innodb_dict_tables_evicted;
+
+  /** Transactions in the transaction system list */
+  ulint innodb_trx_active;
+
+  /** Transactions allocated for the client */
+  ulint innodb_trx_user;
+
+  /** Record lock structs in the record lock hash */
+  ulint innodb_lock_rec_locks;
+
+  /** Transactions with a place in the admission control */
+  ulint innodb_conc_active;
+
+  /** Transactions waiting for a place in the admission control */
+  ulint innodb_conc_waiting;
+
+  /** Current limit of the admission control, 0 if there is none */
+  ulint innodb_conc_limit;
 };
 
 struct Fil;
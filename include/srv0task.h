@@ -0,0 +1,227 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/*** @file include/srv0task.h
+Shared pool of worker threads for the parallel work of the engine
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Classes of tasks. A class with a lower value has a higher priority. */
+enum class Task_class : uint8_t {
+  /** Purge of a batch of undo log records, limited to purge_threads. */
+  Purge,
+
+  /** Loading of the single-table tablespaces, limited to
+  tablespace_load_threads. */
+  Tablespace_load,
+
+  /** Sorting of the entries of the indexes being built, limited to
+  index_build_threads. */
+  Index_build,
+
+  /** Other work, only limited by the size of the pool. */
+  Background
+};
+
+/** Number of task classes. */
+constexpr size_t N_TASK_CLASSES = 4;
+
+struct Task_group;
+
+/** The task scheduler.
+
+The work that is split over several threads is submitted as tasks of a
+Task_group instead of running on threads of its own. An idle worker takes the
+oldest task of the highest priority class that has fewer tasks running than
+the concurrency limit of the class. A thread that waits for a group runs the
+queued tasks of the group itself, a group completes even when all the workers
+are busy. */
+struct Task_scheduler {
+  /** A task. */
+  using Task = std::function<void()>;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] n_workers       Number of worker threads.
+   */
+  explicit Task_scheduler(ulint n_workers) noexcept;
+
+  /** Destructor. The workers must have been shut down. */
+  ~Task_scheduler() noexcept;
+
+  /**
+   * Creates an instance, the workers are not started.
+   *
+   * @param[in] n_workers       Number of worker threads.
+   *
+   * @return the instance or nullptr if out of memory.
+   */
+  [[nodiscard]] static Task_scheduler *create(ulint n_workers) noexcept;
+
+  /**
+   * Destroys an instance.
+   *
+   * @param[in,out] scheduler   Instance to destroy, set to nullptr on return.
+   */
+  static void destroy(Task_scheduler *&scheduler) noexcept;
+
+  /** Starts the worker threads. */
+  void start() noexcept;
+
+  /** Stops the worker threads once the queued tasks have run. */
+  void shutdown() noexcept;
+
+  /** @return the number of worker threads. */
+  [[nodiscard]] ulint get_n_workers() const noexcept { return m_n_workers; }
+
+ private:
+  friend struct Task_group;
+
+  /** A queued task. */
+  struct Queued {
+    /** Group of the task. */
+    Task_group *m_group;
+
+    /** The task. */
+    Task m_task;
+  };
+
+  /**
+   * Queues a task.
+   *
+   * @param[in] group           Group of the task.
+   * @param[in] task            The task.
+   */
+  void submit(Task_group *group, Task &&task) noexcept;
+
+  /**
+   * Runs a queued task of a group in the calling thread.
+   *
+   * @param[in] group           Group of the task.
+   *
+   * @return false if the group has no queued tasks.
+   */
+  [[nodiscard]] bool run_queued(Task_group *group) noexcept;
+
+  /**
+   * Takes the next task that a worker can run, the caller must own m_mutex.
+   *
+   * @param[out] queued         The task.
+   *
+   * @return the class of the task, or N_TASK_CLASSES if there is none.
+   */
+  [[nodiscard]] size_t next(Queued &queued) noexcept;
+
+  /**
+   * @param[in] task_class      Task class.
+   *
+   * @return the maximum number of workers that run tasks of the class.
+   */
+  [[nodiscard]] static ulint limit(Task_class task_class) noexcept;
+
+  /** A worker thread. */
+  void worker() noexcept;
+
+ private:
+  /** Number of worker threads. */
+  ulint m_n_workers{};
+
+  /** Protects the fields below. */
+  std::mutex m_mutex{};
+
+  /** Signalled when a task is queued, when a task ends and on shutdown. */
+  std::condition_variable m_cv{};
+
+  /** The queued tasks, by class. */
+  std::array<std::deque<Queued>, N_TASK_CLASSES> m_queues{};
+
+  /** Number of tasks that the workers are running, by class. */
+  std::array<ulint, N_TASK_CLASSES> m_n_running{};
+
+  /** Set to true to make the workers exit. */
+  bool m_shutdown{};
+
+  /** The worker threads. */
+  std::vector<std::thread> m_threads{};
+};
+
+/** Tasks of one class that a thread waits for. */
+struct Task_group {
+  /**
+   * Constructor.
+   *
+   * @param[in] task_class      Class of the tasks.
+   */
+  explicit Task_group(Task_class task_class) noexcept;
+
+  /** Destructor. The caller must have waited for the tasks. */
+  ~Task_group() noexcept;
+
+  /**
+   * Runs a task on the scheduler, or on a thread of its own if there is no
+   * scheduler.
+   *
+   * @param[in] task            The task.
+   */
+  void run(Task_scheduler::Task &&task) noexcept;
+
+  /** Waits until the tasks have run, runs the ones that are still queued. */
+  void wait() noexcept;
+
+  /** @return the class of the tasks. */
+  [[nodiscard]] Task_class get_class() const noexcept { return m_task_class; }
+
+ private:
+  friend struct Task_scheduler;
+
+  /** Called when a task of the group has run. */
+  void task_done() noexcept;
+
+ private:
+  /** Class of the tasks. */
+  Task_class m_task_class;
+
+  /** The scheduler, nullptr if the tasks run on threads of their own. */
+  Task_scheduler *m_scheduler{};
+
+  /** Protects m_n_pending. */
+  std::mutex m_mutex{};
+
+  /** Signalled when the last pending task has run. */
+  std::condition_variable m_cv{};
+
+  /** Number of tasks submitted to the scheduler that have not run yet. */
+  ulint m_n_pending{};
+
+  /** The threads of the tasks when there is no scheduler. */
+  std::vector<std::thread> m_threads{};
+};
+
+/** The task scheduler, nullptr if not running. */
+extern Task_scheduler *srv_task_scheduler;
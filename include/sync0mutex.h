@@ -8,6 +8,7 @@
 
 #include "os0sync.h"
 #include "os0thread.h"
+#include "sync0spin.h"
 #include "ut0lst.h"
 
 using lock_word_t = std::atomic<bool>;
@@ -49,6 +50,12 @@ struct mutex_t {
   /** count of os_wait */
   ulong count_os_wait{};
 
+  /** Adaptive spin budget */
+  Sync_spin m_spin{};
+
+  /** Statistics of the mutexes created at the same place */
+  Sync_latch_class *m_class{};
+
 #ifdef UNIV_DEBUG
   /** The thread id of the thread which locked the mutex. */
   os_thread_id_t thread_id{};
@@ -49,9 +49,14 @@ constexpr int RW_NO_LATCH = 3;
 /** We decrement m_lock_word by this amount for each x_lock. It is also the
 start value for the m_lock_word, meaning that it limits the maximum number
 of concurrent read locks before the rw_lock breaks. The current value of
-0x00100000 allows 1,048,575 concurrent readers and 2047 recursive writers.*/
+0x00100000 allows 524,287 concurrent readers (also while an sx-lock is
+held) and 2047 recursive writers.*/
 constexpr int X_LOCK_DECR = 0x00100000;
 
+/** We decrement m_lock_word by this amount for the first sx_lock of the
+holder. An sx-lock excludes other sx-locks and x-locks, but not s-locks. */
+constexpr int X_LOCK_HALF_DECR = X_LOCK_DECR / 2;
+
 typedef struct rw_lock_struct rw_lock_t;
 
 #ifdef UNIV_SYNC_DEBUG
@@ -224,6 +229,27 @@ inline void rw_lock_x_unlock_func(
 /** Releases an exclusive mode lock. */
 #define rw_lock_x_unlock(L) rw_lock_x_unlock_gen(L, 0)
 
+/** NOTE! The following macro should be used in rw sx-locking, not the
+corresponding function. */
+
+#define rw_lock_sx_lock(M) rw_lock_sx_lock_func((M), __FILE__, __LINE__)
+
+/** NOTE! Use the corresponding macro, not directly this function! Lock an
+rw-lock in shared-exclusive mode for the current thread. The sx-lock is
+compatible with s-locks but not with other sx-locks or x-locks, it lets
+readers in while the holder prepares a change that only has to exclude
+other writers. If the same thread has an sx-lock or an x-lock on the
+rw-lock, locking succeeds. An sx-lock holder may also x-lock the rw-lock,
+it then waits for the readers to exit. */
+void rw_lock_sx_lock_func(
+  rw_lock_t *lock,       /** in: pointer to rw-lock */
+  const char *file_name, /** in: file name where lock requested */
+  ulint line
+); /** in: line where requested */
+
+/** Releases a shared-exclusive mode lock. */
+#define rw_lock_sx_unlock(L) rw_lock_sx_unlock_func(L)
+
 /** This function is used in the insert buffer to move the ownership of an
 x-latch on a buffer frame to the current thread. The x-latch was set by
 the buffer read operation and it protected the buffer frame while the
@@ -298,6 +324,10 @@ struct rw_lock_struct {
   /** Holds the state of the lock. */
   std::atomic<int32_t> m_lock_word;
 
+  /** Incremented on every x-unlock, validates a read done without the
+  lock, see rw_lock_read_begin(). */
+  std::atomic<uint64_t> m_x_version;
+
   /** true if there are waiters */
   std::atomic<bool> m_waiters;
 
@@ -321,6 +351,10 @@ struct rw_lock_struct {
   the m_lock_word */
   std::atomic<std::thread::id> m_writer_thread;
 
+  /** Number of sx-locks held by m_writer_thread, only the holder
+  reads and writes it. The lock_word is decremented only for the first. */
+  ulint m_sx_recursive;
+
   /** Thread id of writer thread. Is only
   guaranteed to have sane and non-stale
   value iff recursive flag is set. */
@@ -350,6 +384,12 @@ struct rw_lock_struct {
   /** Count of os_waits. May not be accurate */
   ulint m_count_os_wait;
 
+  /** Adaptive spin budget, shared by the s, x and sx waiters */
+  Sync_spin m_spin;
+
+  /** Statistics of the rw-locks created at the same place */
+  Sync_latch_class *m_class;
+
   /** File name where lock created */
   const char *m_cfile_name;
 
@@ -468,34 +508,66 @@ inline void rw_lock_reset_waiter_flag(rw_lock_t *lock) {
 /** Returns the write-status of the lock - this function made more sense
 with the old rw_lock implementation.
 @param[in] lock                 Lock for which we want the writer count.
-@return	RW_LOCK_NOT_LOCKED, RW_LOCK_EX, RW_LOCK_WAIT_EX */
+@return	RW_LOCK_NOT_LOCKED, RW_LOCK_SX, RW_LOCK_EX, RW_LOCK_WAIT_EX */
 inline ulint rw_lock_get_writer(const rw_lock_t *lock) {
   auto lock_word = lock->m_lock_word.load();
 
-  if (lock_word > 0) {
+  if (lock_word > X_LOCK_HALF_DECR) {
     /* return NOT_LOCKED in s-lock state, like the writer
     member of the old lock implementation. */
     return RW_LOCK_NOT_LOCKED;
-  } else if (((-lock_word) % X_LOCK_DECR) == 0) {
+  } else if (lock_word > 0) {
+    /* sx-locked, there may be readers */
+    return RW_LOCK_SX;
+  } else if (lock_word == 0 || lock_word == -X_LOCK_HALF_DECR || lock_word <= -X_LOCK_DECR) {
+    /* x-locked, possibly recursively and together with an sx-lock */
     return RW_LOCK_EX;
   } else {
-    ut_ad(lock_word > -X_LOCK_DECR);
     return RW_LOCK_WAIT_EX;
   }
 }
 
+/** Starts a read of data protected by the lock without acquiring the lock.
+The data may change during the read, it must be copied and the copy may only
+be used after rw_lock_read_validate() succeeds.
+@param[in] lock                 Lock that protects the data.
+@param[out] version             Version to pass to rw_lock_read_validate().
+@return	false if the lock is x-locked or an x-lock is waiting */
+inline bool rw_lock_read_begin(const rw_lock_t *lock, uint64_t &version) {
+  version = lock->m_x_version.load(std::memory_order_acquire);
+
+  return lock->m_lock_word.load() > 0;
+}
+
+/** Checks that the data read since rw_lock_read_begin() was not modified
+by an x-lock holder.
+@param[in] lock                 Lock that protects the data.
+@param[in] version              Version from rw_lock_read_begin().
+@return	true if the data read is consistent */
+inline bool rw_lock_read_validate(const rw_lock_t *lock, uint64_t version) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return lock->m_lock_word.load() > 0 && lock->m_x_version.load(std::memory_order_relaxed) == version;
+}
+
 /** Returns the number of readers.
 @param[in] lock                 Lock for which number of readers required.
 @return	number of readers */
 inline ulint rw_lock_get_reader_count(const rw_lock_t *lock) {
   auto lock_word = lock->m_lock_word.load();
 
-  if (lock_word > 0) {
+  if (lock_word > X_LOCK_HALF_DECR) {
     /* s-locked, no x-waiters */
     return X_LOCK_DECR - lock_word;
-  } else if (lock_word < 0 && lock_word > -X_LOCK_DECR) {
+  } else if (lock_word > 0) {
+    /* s-locked, with an sx-lock */
+    return X_LOCK_HALF_DECR - lock_word;
+  } else if (lock_word < 0 && lock_word > -X_LOCK_HALF_DECR) {
     /* s-locked, with x-waiters */
     return (ulint)(-lock_word);
+  } else if (lock_word < -X_LOCK_HALF_DECR && lock_word > -X_LOCK_DECR) {
+    /* s-locked, with an sx-lock holder waiting for an x-lock */
+    return (ulint)(-(lock_word + X_LOCK_HALF_DECR));
   } else {
     return 0;
   }
@@ -509,6 +581,11 @@ inline ulint rw_lock_get_x_lock_count(const rw_lock_t *lock) {
   auto lock_copy = lock->m_lock_word.load();
   ut_ad(lock_copy <= X_LOCK_DECR);
 
+  if (lock_copy == -X_LOCK_HALF_DECR || (lock_copy <= -X_LOCK_DECR && (-lock_copy) % X_LOCK_DECR != 0)) {
+    /* The x-lock holder also holds an sx-lock */
+    lock_copy += X_LOCK_HALF_DECR;
+  }
+
   /* If there is a reader, m_lock_word is not divisible by X_LOCK_DECR */
   if (lock_copy > 0 || (-lock_copy) % X_LOCK_DECR != 0) {
     return 0;
@@ -517,18 +594,20 @@ inline ulint rw_lock_get_x_lock_count(const rw_lock_t *lock) {
   }
 }
 
-/** Two different implementations for decrementing the m_lock_word of a rw_lock:
-one for systems supporting atomic operations, one for others. This does
+/** Decrements the m_lock_word of a rw_lock if it is above a threshold. This
 does not support recusive x-locks: they should be handled by the caller and
 need not be atomic since they are performed by the current lock holder.
 Returns true if the decrement was made, false if not.
 @param[in,out] lock             Lock to decrement.
 @param[in] amount               Amount to decrement.
+@param[in] threshold            Decrement only if m_lock_word is above this,
+                                0 for s-locks and X_LOCK_HALF_DECR for
+                                x-locks and sx-locks.
 @return	true if decr occurs */
-inline bool rw_lock_lock_word_decr(rw_lock_t *lock, ulint amount) {
+inline bool rw_lock_lock_word_decr(rw_lock_t *lock, ulint amount, lint threshold) {
   auto local_lock_word = lock->m_lock_word.load();
 
-  while (local_lock_word > 0) {
+  while (local_lock_word > threshold) {
     if (lock->m_lock_word.compare_exchange_strong(local_lock_word, local_lock_word - amount)) {
       return true;
     }
@@ -568,7 +647,7 @@ spinning.
 @param[in] line                 Line in file_name where requested
 @return	true on success */
 inline bool rw_lock_s_lock_low(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
-  if (!rw_lock_lock_word_decr(lock, 1)) {
+  if (!rw_lock_lock_word_decr(lock, 1, 0)) {
     /* Locking did not succeed */
     return false;
   } else {
@@ -612,6 +691,8 @@ inline void rw_lock_s_lock_func(rw_lock_t *lock, ulint pass, const char *file_na
   ut_ad(!rw_lock_own(lock, RW_LOCK_SHARED)); /* see NOTE above */
 #endif                                       /* UNIV_SYNC_DEBUG */
 
+  lock->m_class->acquire();
+
   if (rw_lock_s_lock_low(lock, pass, file_name, line)) {
     return; /* Success */
   } else {
@@ -638,14 +719,16 @@ inline bool rw_lock_x_lock_func_nowait(rw_lock_t *lock, const char *file_name, u
     threads can modify (lock, unlock, or reserve) m_lock_word while
     there is an exclusive writer and this is the writer thread. */
 
-    if (lock->m_lock_word == 0) {
-      /* There is another X-LOCK. */
+    if (lock->m_lock_word == 0 || lock->m_lock_word == -X_LOCK_HALF_DECR || lock->m_lock_word <= -X_LOCK_DECR) {
+      /* There is already an X-LOCK by this thread. */
       lock->m_lock_word -= X_LOCK_DECR;
-    } else if (lock->m_lock_word <= -X_LOCK_DECR) {
-      /* THere is more than one X-LOCK. */
-      --lock->m_lock_word;
     } else {
-      return false;
+      /* An SX-LOCK by this thread, upgrade only if there are no readers. */
+      int32_t sx_only{X_LOCK_HALF_DECR};
+
+      if (!lock->m_lock_word.compare_exchange_strong(sx_only, -X_LOCK_HALF_DECR)) {
+        return false;
+      }
     }
 
     ut_a(lock->m_lock_word < 0);
@@ -676,16 +759,19 @@ inline void rw_lock_s_unlock_func(
 #endif /* UNIV_SYNC_DEBUG */
   rw_lock_t *lock
 ) {
-  ut_ad((lock->m_lock_word % X_LOCK_DECR) != 0);
+  ut_ad((lock->m_lock_word % X_LOCK_HALF_DECR) != 0);
 
 #ifdef UNIV_SYNC_DEBUG
   rw_lock_remove_debug_info(lock, pass, RW_LOCK_SHARED);
 #endif /* UNIV_SYNC_DEBUG */
 
   /* Increment lock_word to indicate 1 less reader */
-  if (rw_lock_lock_word_incr(lock, 1) == 0) {
+  auto lock_word = rw_lock_lock_word_incr(lock, 1);
+
+  if (lock_word == 0 || lock_word == -X_LOCK_HALF_DECR) {
 
-    /* wait_ex waiter exists. It may not be asleep, but we signal
+    /* wait_ex waiter exists, possibly an sx-lock holder that
+    waits for an x-lock. It may not be asleep, but we signal
     anyway. We do not wake other waiters, because they can't
     exist without wait_ex waiter and wait_ex waiter goes first.*/
     os_event_set(lock->m_wait_ex_event);
@@ -705,12 +791,13 @@ inline void rw_lock_x_unlock_func(
 #endif /* UNIV_SYNC_DEBUG */
   rw_lock_t *lock
 ) {
-  ut_ad(lock->m_lock_word == 0 || lock->m_lock_word <= -X_LOCK_DECR);
+  ut_ad(lock->m_lock_word == 0 || lock->m_lock_word == -X_LOCK_HALF_DECR || lock->m_lock_word <= -X_LOCK_DECR);
 
   /* lock->m_recursive flag also indicates if lock->m_writer_thread is
   valid or stale. If we are the last of the recursive callers
   then we must unset lock->m_recursive flag to indicate that the
-  lock->m_writer_thread is now stale.
+  lock->m_writer_thread is now stale. If we still hold an sx-lock
+  the lock_word is -X_LOCK_HALF_DECR and the flag stays set.
 
   Note that since we still hold the x-lock we can safely read the lock_word. */
   if (lock->m_lock_word == 0) {
@@ -722,10 +809,16 @@ inline void rw_lock_x_unlock_func(
   rw_lock_remove_debug_info(lock, pass, RW_LOCK_EX);
 #endif /* UNIV_SYNC_DEBUG */
 
-  if (rw_lock_lock_word_incr(lock, X_LOCK_DECR) == X_LOCK_DECR) {
-    /* Lock is now free. May have to signal read/write waiters.
-    We do not need to signal wait_ex waiters, since they cannot
-    exist when there is a writer. */
+  /* A reader that sees the lock free must also see the new version. */
+  lock->m_x_version.fetch_add(1, std::memory_order_release);
+
+  auto lock_word = rw_lock_lock_word_incr(lock, X_LOCK_DECR);
+
+  if (lock_word == X_LOCK_DECR || lock_word == X_LOCK_HALF_DECR) {
+    /* Lock is now free, or only sx-locked by this thread which lets
+    readers in. May have to signal read/write waiters. We do not need
+    to signal wait_ex waiters, since they cannot exist when there is
+    a writer. */
     if (lock->m_waiters.load()) {
       rw_lock_reset_waiter_flag(lock);
       os_event_set(lock->m_event);
@@ -735,3 +828,36 @@ inline void rw_lock_x_unlock_func(
 
   ut_ad(rw_lock_validate(lock));
 }
+
+/** Releases a shared-exclusive mode lock.
+@param[in,out] lock             Lock instance to sx-unlock */
+inline void rw_lock_sx_unlock_func(rw_lock_t *lock) {
+  ut_ad(lock->m_sx_recursive > 0);
+  ut_ad(lock->m_writer_thread.load(std::memory_order_relaxed) == std::this_thread::get_id());
+
+#ifdef UNIV_SYNC_DEBUG
+  rw_lock_remove_debug_info(lock, 0, RW_LOCK_SX);
+#endif /* UNIV_SYNC_DEBUG */
+
+  if (--lock->m_sx_recursive > 0) {
+    return;
+  }
+
+  if (lock->m_lock_word > 0) {
+    /* Last sx-lock and no x-lock by this thread: m_writer_thread
+    is now stale, see rw_lock_x_unlock_func(). */
+    lock->m_recursive = false;
+
+    if (rw_lock_lock_word_incr(lock, X_LOCK_HALF_DECR) > X_LOCK_HALF_DECR && lock->m_waiters.load()) {
+      /* Free or only s-locked: x-lock and sx-lock waiters may proceed. */
+      rw_lock_reset_waiter_flag(lock);
+      os_event_set(lock->m_event);
+      sync_array_object_signalled(sync_primary_wait_array);
+    }
+  } else {
+    /* This thread still holds an x-lock, there can be no readers. */
+    lock->m_lock_word += X_LOCK_HALF_DECR;
+  }
+
+  ut_ad(rw_lock_validate(lock));
+}
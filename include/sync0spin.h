@@ -0,0 +1,226 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file include/sync0spin.h
+Adaptive spinning for the mutexes and rw-locks
+
+Every latch keeps a moving average of the spin rounds that it took to
+acquire it while spinning. The next waiter spins for twice that average,
+bounded by SYNC_SPIN_ROUNDS / SYNC_SPIN_MIN_DIVISOR below and
+SYNC_SPIN_ROUNDS * SYNC_SPIN_MAX_FACTOR above. A wait that ends up
+suspended in the wait array halves the average, so latches that are
+held for long, or hosts where the holder is often descheduled, stop
+wasting CPU on spinning.
+
+The latches created at the same place in the source (e.g. all the buffer
+block locks) form a latch class, the spin and OS wait statistics are
+kept per class. With sync_latch_profile set the classes also count the
+blocking acquisitions and time the waits, this is the latch contention
+profiler. It can be switched on and off at runtime. The waits are also
+recorded by the wait tracer, see ut0wait.h.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include "ut0counter.h"
+#include "ut0wait.h"
+
+/** The spin budget of a latch is never above SYNC_SPIN_ROUNDS times this */
+constexpr ulint SYNC_SPIN_MAX_FACTOR = 4;
+
+/** The spin budget of a latch is never below SYNC_SPIN_ROUNDS divided
+by this, a latch that was free after a short spin is retried cheaply */
+constexpr ulint SYNC_SPIN_MIN_DIVISOR = 4;
+
+/** Number of shards of the acquisition counter of a latch class */
+constexpr int32_t SYNC_LATCH_PROFILE_SHARDS = 16;
+
+/** Number of latch classes printed by the contention profiler */
+constexpr ulint SYNC_LATCH_PROFILE_TOP_N = 10;
+
+/** If true then the latch acquisitions and waits are profiled per latch
+class. Not synchronized, it is a config variable that can be changed at
+runtime and a stale read only loses a few samples. */
+extern bool sync_latch_profile;
+
+/** Spin and OS wait statistics of the latches created at one place. */
+struct Sync_latch_class {
+  /** File where the latches were created */
+  const char *m_file{};
+
+  /** Line where the latches were created */
+  ulint m_line{};
+
+  /** Number of times a latch of the class had to spin */
+  std::atomic<uint64_t> m_spin_waits{};
+
+  /** Number of spin rounds */
+  std::atomic<uint64_t> m_spin_rounds{};
+
+  /** Number of times the latch was acquired while spinning */
+  std::atomic<uint64_t> m_spin_acquired{};
+
+  /** Number of times a thread was suspended in the wait array */
+  std::atomic<uint64_t> m_os_waits{};
+
+  /** Number of blocking acquisitions while profiling. It is updated on
+  the uncontended path, so it is sharded to keep the class cache line
+  from bouncing between the threads that use the latches of a class. */
+  ut::Thread_id_sharded_counter<SYNC_LATCH_PROFILE_SHARDS> m_acquisitions{};
+
+  /** Total time spent waiting while profiling, in nanoseconds */
+  std::atomic<uint64_t> m_wait_ns{};
+
+  /** Longest wait while profiling, in nanoseconds */
+  std::atomic<uint64_t> m_max_wait_ns{};
+
+  /** Counts a blocking acquisition if the profiler is on. */
+  void acquire() noexcept {
+    if (sync_latch_profile) {
+      m_acquisitions.inc();
+    }
+  }
+
+  /** Adds a wait to the profile.
+  @param[in] wait_ns            Time waited for the latch, in nanoseconds */
+  void waited(uint64_t wait_ns) noexcept {
+    m_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+
+    auto max_wait_ns = m_max_wait_ns.load(std::memory_order_relaxed);
+
+    while (wait_ns > max_wait_ns && !m_max_wait_ns.compare_exchange_weak(max_wait_ns, wait_ns, std::memory_order_relaxed)) {
+    }
+  }
+};
+
+/** Times a latch wait for the contention profiler and the wait tracer.
+The wait is added to the latch class, and traced, when the timer goes out
+of scope, if it was started. */
+struct Sync_wait_timer {
+  using Clock = std::chrono::steady_clock;
+
+  /** @param[in] latch_class       Class of the latch waited for
+  @param[in] latch              The latch waited for */
+  Sync_wait_timer(Sync_latch_class *latch_class, const void *latch) noexcept : m_class(latch_class), m_latch(latch) {}
+
+  ~Sync_wait_timer() noexcept {
+    if (m_started) {
+      if (sync_latch_profile) {
+        const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+
+        m_class->waited(uint64_t(wait.count()));
+      }
+
+      if (ut_wait_trace) {
+        ut::wait_trace_record(ut::Wait_type::LATCH, uint64_t(uintptr_t(m_latch)), m_class->m_file, m_class->m_line, m_start);
+      }
+
+      if (ut::op_profile != nullptr) {
+        const auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start);
+
+        ut::op_profile->add_wait(ut::Wait_type::LATCH, uint64_t(wait.count()));
+      }
+    }
+  }
+
+  /** Starts the timer if the profiler or the tracer is on, or the thread
+  profiles its operation, and it was not started yet. */
+  void start() noexcept {
+    if ((sync_latch_profile || ut_wait_trace || ut::op_profile != nullptr) && !m_started) {
+      m_start = Clock::now();
+      m_started = true;
+    }
+  }
+
+  /** Class of the latch waited for */
+  Sync_latch_class *m_class{};
+
+  /** The latch waited for */
+  const void *m_latch{};
+
+  /** true if start() took a timestamp */
+  bool m_started{};
+
+  /** When the wait started */
+  Clock::time_point m_start{};
+};
+
+/** Sums of the statistics of all the latch classes */
+struct Sync_latch_totals {
+  /** Blocking acquisitions while profiling */
+  uint64_t m_acquisitions{};
+
+  /** Acquisitions that had to spin */
+  uint64_t m_contended{};
+
+  /** Spin rounds */
+  uint64_t m_spin_rounds{};
+
+  /** Suspensions in the wait array */
+  uint64_t m_os_waits{};
+
+  /** Total wait time while profiling, in nanoseconds */
+  uint64_t m_wait_ns{};
+
+  /** Longest wait of any class while profiling, in nanoseconds */
+  uint64_t m_max_wait_ns{};
+};
+
+/** Adaptive spin budget of a latch. */
+struct Sync_spin {
+  /** @param[in] spin_rounds     The configured spin rounds (SYNC_SPIN_ROUNDS)
+  @return the number of rounds to spin before suspending the thread */
+  [[nodiscard]] ulint budget(ulint spin_rounds) const noexcept {
+    const ulint avg = m_avg.load(std::memory_order_relaxed);
+    const auto lo = std::max<ulint>(spin_rounds / SYNC_SPIN_MIN_DIVISOR, 1);
+
+    return std::clamp<ulint>(avg * 2, lo, std::max<ulint>(spin_rounds * SYNC_SPIN_MAX_FACTOR, lo));
+  }
+
+  /** Sets the initial average, the first waiter spins SYNC_SPIN_ROUNDS.
+  @param[in] spin_rounds        The configured spin rounds (SYNC_SPIN_ROUNDS) */
+  void init(ulint spin_rounds) noexcept {
+    m_avg.store(uint32_t(spin_rounds / 2), std::memory_order_relaxed);
+  }
+
+  /** Updates the average after the latch was acquired while spinning.
+  @param[in] rounds             Rounds spun before acquiring the latch */
+  void acquired(ulint rounds) noexcept {
+    const int64_t avg = m_avg.load(std::memory_order_relaxed);
+
+    m_avg.store(uint32_t(avg + (int64_t(rounds) - avg) / 8), std::memory_order_relaxed);
+  }
+
+  /** Updates the average when the spin did not succeed and the thread
+  is about to be suspended. */
+  void parked() noexcept {
+    const auto avg = m_avg.load(std::memory_order_relaxed);
+
+    m_avg.store(avg / 2, std::memory_order_relaxed);
+  }
+
+  /** Moving average of the rounds spun before acquisition, updated
+  without synchronization: a lost update only skews the heuristic */
+  std::atomic<uint32_t> m_avg{};
+};
+
+/** Returns the latch class of the latches created at a place in the
+source, registers it on the first call.
+@param[in] file                 File where the latch is created
+@param[in] line                 Line where the latch is created
+@return the class, it is never freed */
+Sync_latch_class *sync_latch_class_get(const char *file, ulint line) noexcept;
+
+/** Prints the spin and OS wait statistics of the latch classes that
+have waited and, if the profiler has collected anything, the
+SYNC_LATCH_PROFILE_TOP_N classes with the longest total wait.
+@param[in,out] ib_stream        Where to print. */
+void sync_latch_class_print(ib_stream_t ib_stream) noexcept;
+
+/** @return the sums of the statistics of all the latch classes */
+[[nodiscard]] Sync_latch_totals sync_latch_class_totals() noexcept;
@@ -356,6 +356,7 @@ constexpr ulint SYNC_SEARCH_SYS = 160;
 constexpr ulint SYNC_BUF_POOL = 150;
 constexpr ulint SYNC_BUF_BLOCK = 149;
 constexpr ulint SYNC_PARALLEL_READ = 148;
+constexpr ulint SYNC_BUF_FLUSH_LIST = 145;
 constexpr ulint SYNC_DOUBLEWRITE = 140;
 constexpr ulint SYNC_ANY_LATCH = 135;
 constexpr ulint SYNC_THR_LOCAL = 133;
@@ -369,6 +370,7 @@ constexpr ulint RW_LOCK_EXCLUSIVE = 351;
 constexpr ulint RW_LOCK_SHARED = 352;
 constexpr ulint RW_LOCK_WAIT_EX = 353;
 constexpr ulint SYNC_MUTEX = 354;
+constexpr ulint RW_LOCK_SX = 355;
 
 /* NOTE! The structure appears here only for the compiler to know its size.
 Do not use its fields directly! The structure used in the spin lock
@@ -528,6 +530,8 @@ inline void mutex_enter_func(mutex_t *mutex, const char *file_name, ulint line)
 
   ut_d(mutex->count_using++);
 
+  mutex->m_class->acquire();
+
   if (!mutex_test_and_set(mutex)) {
     ut_d(mutex->thread_id = os_thread_get_curr_id());
     IF_SYNC_DEBUG(mutex_set_debug_info(mutex, file_name, line);)
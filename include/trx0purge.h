@@ -29,11 +29,15 @@ Created 3/26/1996 Heikki Tuuri
 #include "mtr0mtr.h"
 #include "page0page.h"
 #include "que0types.h"
+#include "row0types.h"
 #include "trx0sys.h"
 #include "trx0types.h"
 #include "trx0undo.h"
 #include "usr0sess.h"
 
+#include <chrono>
+#include <vector>
+
 /**
  * A dummy undo record used as a return value when we have a whole undo log
  * which needs no purge
@@ -64,6 +68,42 @@ inline Fil_addr trx_purge_get_log_from_hist(Fil_addr node_addr) noexcept {
   return node_addr;
 }
 
+/**
+ * Purge lag statistics. Used to throttle DML when the purge falls behind and
+ * exported as status variables.
+ */
+struct Purge_lag {
+  /** When the rates below were last sampled */
+  std::chrono::steady_clock::time_point m_sampled_at{};
+
+  /** Purge_sys::m_n_recs_purged when the rates were last sampled */
+  uint64_t m_n_recs_purged{};
+
+  /** Purge_sys::m_n_logs_purged when the rates were last sampled */
+  uint64_t m_n_logs_purged{};
+
+  /** History list length when the rates were last sampled */
+  ulint m_history_len{};
+
+  /** Undo log records purged per second */
+  double m_recs_per_sec{};
+
+  /** Undo logs added to the history list per second */
+  double m_logs_added_per_sec{};
+
+  /** Undo logs removed from the history list per second */
+  double m_logs_purged_per_sec{};
+
+  /** DML delay in microseconds, moves gradually towards its target */
+  double m_dml_delay{};
+
+  /** Age in seconds of the oldest read view, 0 if there is none */
+  ulint m_oldest_view_age{};
+
+  /** Id of the transaction that created the oldest read view */
+  trx_id_t m_oldest_view_trx_id{};
+};
+
 /**
  * The control structure used in the purge operation
  */
@@ -161,6 +201,22 @@ private:
    */
   que_t *graph_build() noexcept;
 
+  /**
+   * Refreshes m_lag and computes srv_dml_needed_delay from it. The delay is
+   * proportional to how far the history list is over max_purge_lag and to how
+   * much faster undo logs are added to the history than purged.
+   */
+  void update_lag() noexcept;
+
+  /**
+   * Runs the current purge batch on the worker threads. The calling thread
+   * acts as the coordinator: it fetches the undo records of the batch and
+   * partitions them by table id so that the records of a table are purged in
+   * order by a single worker, purges one partition itself and truncates the
+   * history once all the workers are done.
+   */
+  void run_workers() noexcept;
+
   /**
    * Frees an undo log segment which is in the history list. Cuts the end of the
    * history list at the youngest undo log in this segment.
@@ -238,6 +294,13 @@ public:
   /** The query graph which will do the parallelized purge operation */
   que_t *m_query{};
 
+  /** Purge nodes of the worker threads, one per thread, empty if purge runs
+   * in a single thread */
+  std::vector<purge_node_t *> m_workers{};
+
+  /** Memory heap where m_workers are allocated */
+  mem_heap_t *m_workers_heap{};
+
   /** The latch protecting the purge view. A purge operation must acquire
    * an x-latch here for the instant at which it changes the purge view:
    * an undo log operation can prevent this by obtaining an s-latch here. */
@@ -292,4 +355,14 @@ public:
   /** Temporary storage used during a purge: can be emptied after
    * purge completes */
   mem_heap_t *m_heap{};
+
+  /** Number of undo log records fetched for purge, protected by m_mutex */
+  uint64_t m_n_recs_purged{};
+
+  /** Number of undo logs removed from the history list, protected by
+   * kernel_mutex */
+  uint64_t m_n_logs_purged{};
+
+  /** Purge lag statistics, refreshed at the start of every batch */
+  Purge_lag m_lag{};
 };
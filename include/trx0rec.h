@@ -152,9 +152,13 @@ byte *trx_undo_rec_get_partial_row(
  * @param[in] update In the case of an update, the update vector, otherwise nullptr
  * @param[in] cmpl_info Compiler info on secondary index updates
  * @param[in] rec In the case of an update or delete marking, the record in the clustered index, otherwise nullptr
+ * @param[in,out] row_mtr If not nullptr, the mini-transaction that modifies the clustered index record. The undo
+ *  record is written in it if it fits on the last undo log page. The caller must not latch any page of an index
+ *  tree in row_mtr after this, the undo page latch would then be held above a tree latch.
  * @param[out] roll_ptr Rollback pointer to the inserted undo log record, 0 if BTR_NO_UNDO_LOG flag was specified
  * 
- * @return DB_SUCCESS or error code
+ * @return DB_SUCCESS, DB_FAIL if row_mtr already holds the last undo log page for the records of other rows and
+ *  this one does not fit on it: commit row_mtr and retry, or error code
  */
 db_err trx_undo_report_row_operation(
   ulint flags,
@@ -165,6 +169,7 @@ db_err trx_undo_report_row_operation(
   const upd_t *update,
   ulint cmpl_info,
   const rec_t *rec,
+  mtr_t *row_mtr,
   roll_ptr_t *roll_ptr
   );
 
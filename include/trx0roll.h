@@ -110,6 +110,18 @@ Note: this is done in a background thread.
 @return	a dummy parameter */
 void *trx_rollback_or_clean_all_recovered(void *);
 
+/** @return the number of recovered transactions that the background
+rollback has not yet rolled back. */
+ulint trx_roll_get_n_recovered_trxs();
+
+/** @return the number of undo log records of the recovered transactions
+that the background rollback has not yet undone. */
+ulint trx_roll_get_n_recovered_undo_recs();
+
+/** @return the number of undo log records of the recovered transactions
+that have been undone since the startup. */
+ulint trx_roll_get_n_recovered_undo_recs_done();
+
 /** Finishes a transaction rollback. */
 void trx_finish_rollback_off_kernel(
   que_t *graph, /*!< in: undo graph which can now be freed */
@@ -62,6 +62,17 @@ page_no_t trx_rseg_header_create(space_id_t space, ulint max_size, ulint *slot_n
  */
 void trx_rseg_list_and_array_init(ib_recovery_t recovery, trx_sysf_t *sys_header, mtr_t *mtr);
 
+/**
+ * Creates a new rollback segment in a free slot of the trx system header,
+ * together with its memory object.
+ *
+ * @param[in] space The space id.
+ *
+ * @return the new rollback segment, or nullptr if there is no free slot
+ *  or no space left.
+ */
+trx_rseg_t *trx_rseg_create(space_id_t space);
+
 /**
  * Free's an instance of the rollback segment in memory.
  * 
@@ -26,6 +26,10 @@ Created 3/26/1996 Heikki Tuuri
 
 #include "innodb0types.h"
 
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
 #include "buf0buf.h"
 #include "fil0fil.h"
 #include "fsp0fsp.h"
@@ -102,6 +106,27 @@ two) is assigned, the field TRX_SYS_TRX_ID_STORE on the transaction system
 page is updated */
 constexpr ulint TRX_SYS_TRX_ID_WRITE_MARGIN = 256;
 
+/** Maximum number of freed user transaction objects that are kept for reuse */
+constexpr ulint TRX_SYS_TRX_POOL_SIZE = 1024;
+
+/** Ids and trx numbers of the transactions that a new read view must not
+see, cached by Trx_sys between changes of the transaction list. */
+struct Active_trx_snapshot {
+  struct Entry {
+    /** Transaction id */
+    trx_id_t m_id;
+
+    /** Transaction number, LSN_MAX until the transaction commits */
+    trx_id_t m_no;
+  };
+
+  /** Active and prepared transactions, sorted on trx id, biggest first */
+  std::vector<Entry> m_trxs{};
+
+  /** Trx_sys::m_trx_list_version when the snapshot was built */
+  uint64_t m_version{std::numeric_limits<uint64_t>::max()};
+};
+
 /** The transaction system central memory data structure; protected by the
 kernel mutex */
 struct Trx_sys {
@@ -186,14 +211,42 @@ struct Trx_sys {
   [[nodiscard]] Trx *get_on_id(trx_id_t trx_id) noexcept {
     ut_ad(mutex_own(&kernel_mutex));
 
-    for (const auto trx : m_trx_list) {
-      if (trx_id == trx->m_id) {
+    auto it = m_trx_by_id.find(trx_id);
 
-        return trx;
-      }
-    }
+    return it == m_trx_by_id.end() ? nullptr : it->second;
+  }
+
+  /**
+   * Adds a transaction that got a new id to the front of trx_list.
+   * 
+   * @param[in,out] trx	Transaction to add
+   */
+  void trx_list_add(Trx *trx) noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+    ut_ad(UT_LIST_GET_FIRST(m_trx_list) == nullptr || UT_LIST_GET_FIRST(m_trx_list)->m_id < trx->m_id);
 
-    return nullptr;
+    m_trx_list.push_front(trx);
+
+    const auto inserted = m_trx_by_id.emplace(trx->m_id, trx).second;
+    ut_a(inserted);
+
+    trx_list_changed();
+  }
+
+  /**
+   * Removes a transaction from trx_list.
+   * 
+   * @param[in,out] trx	Transaction to remove
+   */
+  void trx_list_remove(Trx *trx) noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+
+    m_trx_list.remove(trx);
+
+    const auto n_erased = m_trx_by_id.erase(trx->m_id);
+    ut_a(n_erased == 1);
+
+    trx_list_changed();
   }
 
   /**
@@ -212,6 +265,21 @@ struct Trx_sys {
     return trx == nullptr ? m_max_trx_id : trx->m_id;
   }
 
+  /**
+   * Checks without the kernel mutex if a transaction id is below the
+   * smallest id in trx_list. Such a transaction has committed and it
+   * cannot hold an implicit lock. The caller must read trx_id from a
+   * record or a page that it has latched, a false return means that
+   * the transaction may be active.
+   * 
+   * @param[in] trx_id	Trx id read from a record or a page
+   * 
+   * @return	true if the transaction is surely not active
+   */
+  [[nodiscard]] bool cannot_be_active(trx_id_t trx_id) const noexcept {
+    return trx_id < m_min_active_trx_id.load(std::memory_order_acquire);
+  }
+
   /**
    * Checks if a transaction with the given id is active.
    * 
@@ -266,9 +334,38 @@ struct Trx_sys {
 
     ++m_max_trx_id;
 
+    /* A new trx id or trx number changes the set of active transactions
+    or their low limit no, invalidate the cached snapshot. */
+    trx_list_changed();
+
     return id;
   }
 
+  /**
+   * Invalidates the cached snapshot of active transactions. Must be called
+   * whenever a transaction enters or leaves the active or prepared state.
+   */
+  void trx_list_changed() noexcept {
+    ut_ad(mutex_own(&kernel_mutex));
+
+    ++m_trx_list_version;
+
+    /* A transaction writes its id to records only after it is in
+    trx_list, so the id of an active transaction never goes below
+    this value. */
+    m_min_active_trx_id.store(get_min_trx_id(), std::memory_order_release);
+  }
+
+  /**
+   * Returns the ids and trx numbers of the active and prepared transactions,
+   * sorted on trx id, biggest first. The snapshot is rebuilt from m_trx_list
+   * only if the list has changed since the last call, so read views opened
+   * while no transaction starts or commits don't walk the list.
+   *
+   * @return the cached snapshot, valid until kernel_mutex is released.
+   */
+  [[nodiscard]] const Active_trx_snapshot &get_active_trx_snapshot() noexcept;
+
   /**
    * Allocates a new transaction number.
    * 
@@ -397,7 +494,20 @@ struct Trx_sys {
   [[nodiscard]] Trx *create_user_trx(void *arg) noexcept;
 
   /**
-   * Frees a client transaction instance.
+   * Creates rollback segments in the system tablespace until there are n of
+   * them. Transactions are assigned to the rollback segments round robin,
+   * see trx_assign_rseg(), spreading the undo log allocation over the rseg
+   * mutexes.
+   *
+   * @param[in] n Number of rollback segments wanted, at most TRX_SYS_N_RSEGS.
+   *
+   * @return number of rollback segments there are.
+   */
+  ulint create_rsegs(ulint n) noexcept;
+
+  /**
+   * Frees a client transaction instance. The instance is put back in the
+   * transaction pool for reuse by create_user_trx() unless the pool is full.
    *
    * @param[in] trx The transaction object to be freed.
    */
@@ -561,6 +671,14 @@ public:
   id or transaction number */
   trx_id_t m_max_trx_id{};
 
+  /** Incremented every time the set of active transactions changes,
+  protected by the kernel mutex */
+  uint64_t m_trx_list_version{};
+
+  /** Cached snapshot of the active transactions, see
+  get_active_trx_snapshot(), protected by the kernel mutex */
+  Active_trx_snapshot m_active_trx_snapshot{};
+
   /** List of read views sorted on trx no, biggest first */
   UT_LIST_BASE_NODE_T_EXTERN(read_view_t, view_list) m_view_list{};
 
@@ -568,9 +686,20 @@ public:
   sorted on trx id, biggest first */
   UT_LIST_BASE_NODE_T_EXTERN(Trx, m_trx_list) m_trx_list{};
 
+  /** The transactions in m_trx_list by id, protected by the kernel mutex */
+  std::unordered_map<trx_id_t, Trx *> m_trx_by_id{};
+
+  /** get_min_trx_id() as of the last trx_list_changed(), it can be read
+  without the kernel mutex, see cannot_be_active() */
+  std::atomic<trx_id_t> m_min_active_trx_id{};
+
   /** List of transactions created for users */
   UT_LIST_BASE_NODE_T_EXTERN(Trx, m_client_trx_list) m_client_trx_list{};
 
+  /** Freed user transactions kept for reuse, with their sessions, protected
+  by the kernel mutex */
+  std::vector<Trx *> m_trx_pool{};
+
   /** List of rollback segment objects */
   UT_LIST_BASE_NODE_T_EXTERN(trx_rseg_t, rseg_list) m_rseg_list{};
 
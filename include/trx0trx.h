@@ -25,16 +25,42 @@ Created 3/26/1996 Heikki Tuuri
 #pragma once
 
 #include "dict0types.h"
+#include "lock0types.h"
 #include "mem0mem.h"
 #include "que0types.h"
 #include "read0types.h"
 #include "srv0srv.h"
 #include "trx0types.h"
 #include "usr0types.h"
+#include "ut0histogram.h"
+#include "ut0wait.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
 
 struct Lock;
 struct read_view_t;
 
+/** A value that a transaction added to a commutative integer column. The
+row is not locked when the delta is added, the deltas are applied to their
+rows when the transaction commits, see ib_cursor_add_delta(). */
+struct Trx_delta {
+  /** Table of the row */
+  Dict_id m_table_id{};
+
+  /** Clustered index key of the row, allocated from Trx::m_delta_heap */
+  DTuple *m_key{};
+
+  /** Column to add to */
+  ulint m_col_no{};
+
+  /** Value to add, can be negative */
+  int64_t m_delta{};
+};
+
 /*
  * The transaction handle; every session has a trx object which is freed only
  * when the session is freed; in addition there may be session-less transactions
@@ -81,6 +107,15 @@ struct Trx {
    */
   static void destroy(Trx *&trx) noexcept;
 
+  /**
+   * Resets a transaction that is not started so that it can be reused for
+   * a new client. The session, the undo mutex, the lock heap and the read
+   * view heap are kept, the heaps are emptied.
+   *
+   * @param[in] arg Any context that needs to be passed to the trx.
+   */
+  void reset(void *arg) noexcept;
+
   /**
    * Creates a transaction object.
    *
@@ -273,6 +308,13 @@ struct Trx {
    */
   void mark_sql_stat_end() noexcept;
 
+  /**
+   * Discards the deltas of commutative columns that were not applied.
+   *
+   * @param[in] n_deltas The number of deltas to keep, the oldest ones.
+   */
+  void discard_deltas(ulint n_deltas) noexcept;
+
   /**
    * Assigns a read view for a consistent read query. All the consistent reads
    * within the same transaction will get the same read view, which is created
@@ -392,6 +434,18 @@ struct Trx {
    */
   [[nodiscard]] db_err commit() noexcept;
 
+  /**
+   * Does the transaction commit for client without waiting for the log.
+   * The commit is visible and the locks are released when this returns,
+   * callback is invoked once the commit log is written or flushed as
+   * flush_log_at_trx_commit requires, see Log::commit_async().
+   *
+   * @param[in] callback Invoked once the commit is durable.
+   *
+   * @return DB_SUCCESS or error number.
+   */
+  [[nodiscard]] db_err commit_async(std::function<void()> callback) noexcept;
+
   /**
    * Frees a transaction object for client.
    *
@@ -466,6 +520,9 @@ private:
   void prepare_for_commit() noexcept;
 
 public:
+  /* The transaction objects are reused, a field added below must be reset
+  or asserted to be in its initial state in Trx::reset(). */
+
   IF_DEBUG(ulint m_magic_n{TRX_MAGIC_N};)
 
   /** Transaction start id. See m_no below too. */
@@ -476,6 +533,12 @@ public:
   /** English text describing the current operation, or an empty string */
   const char *m_op_info{};
 
+  /** Number, length, waits and rows examined of the API operations of the
+  transaction, only updated while the slow operation log is on. Logged when
+  the transaction is released if its operations took longer than the slow
+  operation threshold in total. */
+  ut::Op_profile m_op_profile{};
+
   /** State of the trx from the point of view of concurrency control:
    * TRX_ACTIVE, TRX_COMMITTED_IN_MEMORY, ... */
   Trx_status m_conc_state{TRX_NOT_STARTED};
@@ -506,21 +569,34 @@ public:
   ulint m_must_flush_log_later{};
 #endif /* WITH_XOPEN */
 
+  /** True if the transaction never modifies data: it has no id and is
+  not in Trx_sys::m_trx_list, see ib_trx_begin_read_only() */
+  bool m_read_only{};
+
+  /** True if commit_off_kernel() must not wait for the commit log to be
+  written, commit_async() waits for it in the background instead */
+  bool m_commit_no_wait{};
+
   /** TRX_DUP_IGNORE | TRX_DUP_REPLACE */
   ulint m_duplicates{};
 
-  /* A mark field used in deadlock checking algorithm.  */
-  bool m_deadlock_mark{};
+  /* A mark field used in deadlock checking algorithm: the value of
+  Lock_sys::m_deadlock_epoch when the search last finished with this trx. */
+  uint64_t m_deadlock_mark{};
 
   /** @see trx_dict_op */
   trx_dict_op_t m_dict_operation{TRX_DICT_OP_NONE};
 
-  /* Fields protected by the srv_conc_mutex. */
+  /* Fields only accessed by the thread that runs the transaction, see
+  Srv_conc. */
 
-  /* This is true if we have declared this transaction in
-  srv_conc_enter_innodb to be inside the InnoDB engine */
+  /** true if the transaction has a place in the admission control */
   bool m_declared_to_be_inside_innodb{};
 
+  /** Number of operations the transaction can still start without going
+  through the admission control */
+  ulint m_n_tickets_to_enter_innodb{};
+
   /* Fields protected by dict_operation_lock. The very latch it is used to track. */
 
   /** 0, RW_S_LATCH, or RW_X_LATCH: the latch mode trx currently holds on dict_operation_lock */
@@ -557,6 +633,19 @@ public:
   /** Client thread handle corresponding to this trx, or nullptr */
   void *m_client_ctx{};
 
+  /** If set, the cursor calls of the transaction return DB_WOULD_BLOCK
+  instead of waiting for a lock or a page read, and this is invoked once
+  the call can be retried, see ib_trx_set_nonblocking() */
+  std::function<void()> m_wake{};
+
+  /** Deltas added to commutative columns that are applied at commit, in
+  the order they were added. Only accessed by the thread that runs the
+  transaction. */
+  std::vector<Trx_delta> m_deltas{};
+
+  /** Heap of the keys of m_deltas, or nullptr */
+  mem_heap_t *m_delta_heap{};
+
   /** Pointer to the SQL query string */
   char **m_client_query_str{};
 
@@ -630,6 +719,9 @@ public:
   /** Memory heap for the locks of the transaction */
   mem_heap_t *m_lock_heap{};
 
+  /** Free lock objects allocated from m_lock_heap, see Lock_sys::lock_alloc() */
+  Lock_pool m_lock_pool{};
+
   /** Locks reserved by the transaction */
   UT_LIST_BASE_NODE_T_EXTERN(Lock, m_trx_locks) m_trx_locks;
 
@@ -689,3 +781,68 @@ public:
 
 UT_LIST_NODE_GETTER_DEFINITION(Trx, m_trx_list);
 UT_LIST_NODE_GETTER_DEFINITION(Trx, m_client_trx_list);
+
+/** Phases of a transaction commit, timed separately to find where the
+commit latency goes. */
+enum Trx_commit_phase : ulint {
+  /** Undo log state change, history list add and the commit mtr. */
+  TRX_COMMIT_UNDO,
+
+  /** Release of the transaction locks. */
+  TRX_COMMIT_LOCK_RELEASE,
+
+  /** Wait for the commit lsn to be written to the log files. */
+  TRX_COMMIT_LOG_WRITE,
+
+  /** Wait for the log files to be flushed to disk. */
+  TRX_COMMIT_LOG_FLUSH,
+
+  TRX_COMMIT_PHASE_COUNT
+};
+
+/** Commit latency and the number of transactions in each commit phase. */
+struct Trx_commit_stats {
+  struct Phase {
+    /** Time spent in the phase, in microseconds. */
+    ut::Latency_histogram m_latency{};
+
+    /** Number of transactions currently in the phase. */
+    std::atomic<ulint> m_n_waiting{};
+  };
+
+  /** Times a commit phase for as long as it is in scope. */
+  struct Timer {
+    /**
+     * @param[in,out] stats Where to record the phase.
+     * @param[in] phase The phase that starts.
+     */
+    Timer(Trx_commit_stats &stats, Trx_commit_phase phase) noexcept
+        : m_phase(stats.m_phases[phase]), m_start(std::chrono::steady_clock::now()) {
+      m_phase.m_n_waiting.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~Timer() noexcept {
+      using namespace std::chrono;
+
+      const auto us = uint64_t(duration_cast<microseconds>(steady_clock::now() - m_start).count());
+
+      m_phase.m_latency.add(us);
+      m_phase.m_n_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+    /** The phase being timed. */
+    Phase &m_phase;
+
+    /** When the phase started. */
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  /** Per phase statistics, indexed by Trx_commit_phase. */
+  std::array<Phase, TRX_COMMIT_PHASE_COUNT> m_phases{};
+};
+
+/** Commit phase statistics of all transactions. */
+extern Trx_commit_stats trx_commit_stats;
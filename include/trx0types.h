@@ -131,6 +131,9 @@ using undo_no_t = uint64_t;
 struct trx_savept_t {
    /** Least undo number to undo */
   undo_no_t least_undo_no;
+
+  /** Number of Trx::m_deltas to keep */
+  ulint n_deltas;
 };
 
 /** Transaction system header */
@@ -26,6 +26,8 @@ Created 3/26/1996 Heikki Tuuri
 
 #include "innodb0types.h"
 
+#include <atomic>
+
 #include "mtr0mtr.h"
 #include "page0types.h"
 #include "trx0sys.h"
@@ -639,6 +641,13 @@ private:
 
 public:
   FSP* m_fsp{};
+
+  /** Number of undo logs assigned from the cache of a rollback segment */
+  std::atomic<ulint> m_n_cache_hits{};
+
+  /** Number of undo logs for which a segment was created, the cache of the
+  rollback segment was empty */
+  std::atomic<ulint> m_n_cache_misses{};
 };
 
 /* @} */
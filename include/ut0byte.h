@@ -26,6 +26,14 @@ Created 1/20/1994 Heikki Tuuri
 
 #include "innodb0types.h"
 
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif /* __AVX2__ */
+
 [[nodiscard]] inline uint64_t ut_uint64_align_down(uint64_t n, ulint align_no) {
   ut_ad(align_no > 0);
   ut_ad(ut_is_2pow(align_no));
@@ -86,3 +94,61 @@ Created 1/20/1994 Heikki Tuuri
     return ~(ulint(1) << n) & a;
   }
 }
+
+/**
+ * Finds the first byte where two byte strings differ. Compares 32 bytes at
+ * a time with AVX2, 16 with NEON and 8 otherwise.
+ *
+ * @param[in] a                 First string.
+ * @param[in] b                 Second string.
+ * @param[in] len               Number of bytes to compare.
+ *
+ * @return the number of leading bytes that are the same, len if all are.
+ */
+[[nodiscard]] inline ulint ut_mismatch(const byte *a, const byte *b, ulint len) noexcept {
+  ulint i{};
+
+#if defined(__AVX2__)
+  for (; i + 32 <= len; i += 32) {
+    const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    const auto ne = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+
+    if (ne != 0) {
+      return i + __builtin_ctz(ne);
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= len; i += 16) {
+    const auto eq = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+    /* 4 bits per byte, all set if the bytes are the same. */
+    const auto mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+
+    if (mask != ~uint64_t{}) {
+      return i + __builtin_ctzll(~mask) / 4;
+    }
+  }
+#endif /* __AVX2__ */
+
+  for (; i + 8 <= len; i += 8) {
+    uint64_t x;
+    uint64_t y;
+
+    memcpy(&x, a + i, sizeof(x));
+    memcpy(&y, b + i, sizeof(y));
+
+    if (x != y) {
+#ifdef WORDS_BIGENDIAN
+      return i + __builtin_clzll(x ^ y) / 8;
+#else  /* WORDS_BIGENDIAN */
+      return i + __builtin_ctzll(x ^ y) / 8;
+#endif /* WORDS_BIGENDIAN */
+    }
+  }
+
+  while (i < len && a[i] == b[i]) {
+    ++i;
+  }
+
+  return i;
+}
@@ -144,4 +144,52 @@ using Thread_id_sharded_counter = Counters<Shards, Thread_id_indexer>;
 template <std::int32_t Shards>
 using CPU_sharded_counter = Counters<Shards, CPU_indexer>;
 
+/** A set of counters that is sharded by thread. A shard holds all the
+counters, a thread updates the counters of its own shard only. The shards
+are padded rather than aligned, the set can be a member of an object that
+is allocated from a memory heap.
+ @tparam N number of counters
+ @tparam Shards number of shards */
+template <std::size_t N, std::size_t Shards>
+struct Counter_set {
+  /** Add to a counter.
+  @param[in] counter            The counter, less than N
+  @param[in] value              Value to add */
+  void inc(std::size_t counter, uint64_t value = 1) noexcept {
+    ut_ad(counter < N);
+    m_shards[shard()].m_values[counter].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /** @return the sum over the shards of a counter.
+  @param[in] counter            The counter, less than N */
+  [[nodiscard]] uint64_t value(std::size_t counter) const noexcept {
+    uint64_t total{};
+
+    ut_ad(counter < N);
+
+    for (const auto &shard : m_shards) {
+      total += shard.m_values[counter].load(std::memory_order_relaxed);
+    }
+
+    return total;
+  }
+
+ private:
+  /** @return the shard of the calling thread, the thread id is hashed once. */
+  [[nodiscard]] static std::size_t shard() noexcept {
+    static thread_local const auto index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % Shards;
+
+    return index;
+  }
+
+  struct Shard {
+    std::atomic<uint64_t> m_values[N]{};
+
+    /** Keeps the values of the next shard off the last cache line. */
+    byte m_pad[hardware_destructive_interference_size];
+  };
+
+  Shard m_shards[Shards]{};
+};
+
 } // namespace ut
@@ -27,7 +27,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
 
 #pragma once
 
-#if defined(__SSE4_2__)
+#if defined(__x86_64__)
 #include <nmmintrin.h>
 #include <wmmintrin.h>
 #endif
@@ -36,6 +36,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
 
 #include "innodb0types.h"
 
+#include <array>
 #include <functional>
 
 namespace crc32 {
@@ -66,7 +67,7 @@ using Checksum = std::function<uint32_t(const byte *, size_t)>;
 
 extern Checksum checksum;
 
-#if defined(__SSE4_2__)
+#if defined(__x86_64__)
 /** Executes cpuid assembly instruction and returns the ecx register's value.
  * 
  * @return ecx value produced by cpuid
@@ -531,8 +532,50 @@ __attribute__((target("sse4.2"), flatten)) static inline uint32_t unrolled_loop_
 
 #endif
 
+/** The CRC-32C polynomial reflected, for the bit order of the table driven
+implementation. */
+constexpr uint32_t CRC32C_POLYNOMIAL_REFLECTED = 0x82F63B78;
+
+/** @return the lookup table of the table driven CRC-32C implementation, one
+entry per byte value. */
+inline constexpr std::array<uint32_t, 256> make_table() noexcept {
+  std::array<uint32_t, 256> table{};
+
+  for (uint32_t i = 0; i < table.size(); ++i) {
+    auto crc = i;
+
+    for (int j = 0; j < 8; ++j) {
+      crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLYNOMIAL_REFLECTED : 0);
+    }
+
+    table[i] = crc;
+  }
+
+  return table;
+}
+
+/** Lookup table of software(). */
+constexpr auto TABLE = make_table();
+
+/** Table driven CRC-32C, used on CPUs without the SSE4.2 crc32 instruction,
+so that the checksums written and verified do not depend on the CPU.
+
+@param[in] data                 Data over which to calculate CRC32-C
+@param[in] len                  Data length
+
+@return CRC-32C (polynomial 0x11EDC6F41) */
+static inline uint32_t software(const byte *data, size_t len) noexcept {
+  uint32_t crc = ~uint32_t{0};
+
+  for (const auto end = data + len; data < end; ++data) {
+    crc = TABLE[(crc ^ *data) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
 static inline Checksum init() noexcept {  // Provide complete type for Checksum
-#if defined(__SSE4_2__)
+#if defined(__x86_64__)
   const auto cpu_enabled = can_use_crc32();
   const auto mul_cpu_enabled = can_use_poly_mul();
 
@@ -545,9 +588,7 @@ static inline Checksum init() noexcept {  // Provide complete type for Checksum
   }
 #endif
 
-  return [](const byte *, size_t) {
-    return NO_CHECKSUM;
-  };
+  return software;
 }
 
 }  // namespace crc32
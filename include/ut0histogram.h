@@ -0,0 +1,249 @@
+/***********************************************************************
+Copyright 2024 Sunny Bains
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or Implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+***********************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <format>
+#include <string>
+
+#include "innodb0types.h"
+#include "ut0counter.h"
+
+namespace ut {
+
+/** Percentiles of a histogram, in microseconds. */
+struct Latency_percentiles {
+  /** @return the percentiles as a string. */
+  [[nodiscard]] std::string to_string() const {
+    return std::format("count: {}, p50: {}us, p99: {}us, p999: {}us, max: {}us", m_count, m_p50, m_p99, m_p999, m_max);
+  }
+
+  /** Number of samples. */
+  uint64_t m_count{};
+
+  /** Median. */
+  uint64_t m_p50{};
+
+  /** 99th percentile. */
+  uint64_t m_p99{};
+
+  /** 99.9th percentile. */
+  uint64_t m_p999{};
+
+  /** Largest sample. */
+  uint64_t m_max{};
+};
+
+/** A histogram of latencies in microseconds with log-linear buckets: the
+values are grouped by their highest set bit and each group is split into
+SUB_BUCKETS linear buckets. A percentile is reported as the upper bound of
+its bucket, which is within 1/SUB_BUCKETS of the value. The buckets are
+updated without a lock, a reader sees a consistent enough snapshot. */
+struct Latency_histogram {
+  /** Number of bits of a value that select the bucket in its group. */
+  static constexpr ulint SUB_BUCKET_BITS = 2;
+
+  /** Number of linear buckets in a group. */
+  static constexpr ulint SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+  /** Values of 2^MAX_BITS microseconds and more, over 19 hours, go to the
+  last bucket. */
+  static constexpr ulint MAX_BITS = 36;
+
+  /** Number of buckets. */
+  static constexpr ulint N_BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  /**
+   * @param[in] us Latency in microseconds.
+   * @return the bucket of a value.
+   */
+  [[nodiscard]] static ulint get_bucket(uint64_t us) noexcept {
+    if (us < SUB_BUCKETS) {
+      return ulint(us);
+    }
+
+    const auto bits = ulint(std::bit_width(us)) - 1;
+
+    if (bits >= MAX_BITS) {
+      return N_BUCKETS - 1;
+    }
+
+    const auto shift = bits - SUB_BUCKET_BITS;
+
+    return (shift + 1) * SUB_BUCKETS + ulint((us >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  /**
+   * @param[in] bucket A bucket number.
+   * @return the largest value that falls in a bucket.
+   */
+  [[nodiscard]] static uint64_t get_upper_bound(ulint bucket) noexcept {
+    if (bucket < SUB_BUCKETS) {
+      return bucket;
+    }
+
+    const auto shift = bucket / SUB_BUCKETS - 1;
+    const auto sub = bucket % SUB_BUCKETS;
+
+    return ((uint64_t(SUB_BUCKETS + sub) + 1) << shift) - 1;
+  }
+
+  /** Adds a sample.
+  @param[in] us Latency in microseconds. */
+  void add(uint64_t us) noexcept {
+    m_buckets[get_bucket(us)].fetch_add(1, std::memory_order_relaxed);
+    update_max(us);
+  }
+
+  /** Adds the samples of another histogram.
+  @param[in] other Histogram to add. */
+  void add(const Latency_histogram &other) noexcept {
+    for (ulint i{}; i < N_BUCKETS; ++i) {
+      m_buckets[i].fetch_add(other.m_buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    update_max(other.m_max.load(std::memory_order_relaxed));
+  }
+
+  /** Moves the samples of another histogram to this one, the samples that
+  are added to it meanwhile are either moved or kept.
+  @param[in,out] other Histogram to empty. */
+  void move_from(Latency_histogram &other) noexcept {
+    for (ulint i{}; i < N_BUCKETS; ++i) {
+      m_buckets[i].fetch_add(other.m_buckets[i].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    update_max(other.m_max.exchange(0, std::memory_order_relaxed));
+  }
+
+  /** Removes all the samples. */
+  void clear() noexcept {
+    for (auto &bucket : m_buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+  /** @return the number of samples. */
+  [[nodiscard]] uint64_t get_count() const noexcept {
+    uint64_t n{};
+
+    for (const auto &bucket : m_buckets) {
+      n += bucket.load(std::memory_order_relaxed);
+    }
+
+    return n;
+  }
+
+  /** @return the median, the 99th and the 99.9th percentiles. */
+  [[nodiscard]] Latency_percentiles get_percentiles() const noexcept {
+    std::array<uint64_t, N_BUCKETS> buckets;
+    Latency_percentiles percentiles{};
+
+    for (ulint i{}; i < N_BUCKETS; ++i) {
+      buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+      percentiles.m_count += buckets[i];
+    }
+
+    if (percentiles.m_count == 0) {
+      return percentiles;
+    }
+
+    percentiles.m_max = m_max.load(std::memory_order_relaxed);
+
+    /* Number of samples at or below each percentile, rounded up. */
+    const auto n = percentiles.m_count;
+    const std::array<uint64_t, 3> ranks{(n * 500 + 999) / 1000, (n * 990 + 999) / 1000, (n * 999 + 999) / 1000};
+    const std::array<uint64_t *, 3> values{&percentiles.m_p50, &percentiles.m_p99, &percentiles.m_p999};
+
+    uint64_t seen{};
+    ulint next{};
+
+    for (ulint i{}; i < N_BUCKETS && next < ranks.size(); ++i) {
+      seen += buckets[i];
+
+      while (next < ranks.size() && seen >= ranks[next]) {
+        *values[next++] = get_upper_bound(i);
+      }
+    }
+
+    return percentiles;
+  }
+
+  /** Sample counts by bucket. */
+  std::array<std::atomic<uint64_t>, N_BUCKETS> m_buckets{};
+
+  /** Largest sample. */
+  std::atomic<uint64_t> m_max{};
+
+ private:
+  /** Raises m_max to a sample, it is rarely written once the histogram has
+  some samples.
+  @param[in] us Latency in microseconds. */
+  void update_max(uint64_t us) noexcept {
+    auto max = m_max.load(std::memory_order_relaxed);
+
+    while (us > max && !m_max.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+  }
+};
+
+/** A latency histogram that is sharded by thread to avoid the contention on
+the buckets of the operations that many threads time at once. A snapshot
+merges the shards.
+@tparam Shards Number of shards. */
+template <std::int32_t Shards>
+struct Sharded_latency_histogram {
+  /** Adds a sample to the shard of the calling thread.
+  @param[in] us Latency in microseconds. */
+  void add(uint64_t us) noexcept {
+    m_shards[m_indexer.get_index() % Shards].m_histogram.add(us);
+  }
+
+  /** Adds the samples of all the shards to a histogram, the shards are
+  emptied if reset is true.
+  @param[out] histogram Histogram to add to.
+  @param[in] reset True to remove the samples that are added. */
+  void collect(Latency_histogram &histogram, bool reset) noexcept {
+    for (auto &shard : m_shards) {
+      if (reset) {
+        histogram.move_from(shard.m_histogram);
+      } else {
+        histogram.add(shard.m_histogram);
+      }
+    }
+  }
+
+ private:
+  /** A shard, on its own cache lines. */
+  struct alignas(hardware_destructive_interference_size) Shard {
+    Latency_histogram m_histogram{};
+  };
+
+  /** Selects the shard of a thread. */
+  Thread_id_indexer m_indexer{};
+
+  /** The shards. */
+  std::array<Shard, Shards> m_shards{};
+};
+
+} // namespace ut
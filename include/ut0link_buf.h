@@ -0,0 +1,143 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file include/ut0link_buf.h
+Tracks the ranges of a sequence that are completed out of order.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <vector>
+
+/**
+ * Tracks the ranges [from, to) of a sequence, e.g., of the lsn, that are
+ * completed concurrently and in any order, and the position up to which all
+ * the ranges are complete, the tail.
+ *
+ * A range is stored in the slot of its start position modulo the capacity,
+ * so a range can be added only when it starts less than capacity positions
+ * after the tail. The ranges must not overlap and must not leave gaps.
+ */
+struct Link_buf {
+  using Position = uint64_t;
+
+  /**
+   * Constructor.
+   *
+   * @param[in] capacity        Number of slots, must be a power of 2.
+   * @param[in] pos             Initial tail.
+   */
+  Link_buf(size_t capacity, Position pos) noexcept
+    : m_links(capacity), m_tail(pos) {
+    ut_a(capacity > 0 && (capacity & (capacity - 1)) == 0);
+  }
+
+  /**
+   * Restarts the tracking at a position. There must be no ranges in progress.
+   *
+   * @param[in] pos             New tail.
+   */
+  void reset(Position pos) noexcept {
+    for (auto &link : m_links) {
+      link.store(0, std::memory_order_relaxed);
+    }
+
+    m_tail.store(pos, std::memory_order_release);
+  }
+
+  /** @return the position up to which all the ranges are complete. */
+  [[nodiscard]] Position tail() const noexcept {
+    return m_tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @param[in] from            Start of a range.
+   *
+   * @return true if a range that starts at from can be added.
+   */
+  [[nodiscard]] bool has_space(Position from) const noexcept {
+    return from < tail() + m_links.size();
+  }
+
+  /**
+   * Marks a range as complete. The caller must have checked has_space().
+   *
+   * @param[in] from            Start of the range.
+   * @param[in] to              End of the range.
+   */
+  void add_link(Position from, Position to) noexcept {
+    ut_ad(to > from);
+    ut_ad(from >= tail());
+    ut_ad(has_space(from));
+
+    m_links[slot(from)].store(to, std::memory_order_release);
+  }
+
+  /**
+   * Moves the tail over the ranges that are complete. Only one thread
+   * advances the tail at a time, if another one is at it this returns
+   * without waiting.
+   *
+   * @return the tail.
+   */
+  Position advance_tail() noexcept {
+    if (!m_advancing.exchange(true, std::memory_order_acquire)) {
+      auto pos = m_tail.load(std::memory_order_relaxed);
+
+      for (;;) {
+        auto &link = m_links[slot(pos)];
+        const auto next = link.load(std::memory_order_acquire);
+
+        if (next == 0) {
+          break;
+        }
+
+        ut_ad(next > pos);
+
+        /* The slot can be reused once the tail is published below. */
+        link.store(0, std::memory_order_relaxed);
+
+        pos = next;
+      }
+
+      m_tail.store(pos, std::memory_order_release);
+
+      m_advancing.store(false, std::memory_order_release);
+    }
+
+    return tail();
+  }
+
+ private:
+  /** @return the slot of a position. */
+  [[nodiscard]] size_t slot(Position pos) const noexcept {
+    return size_t(pos & (m_links.size() - 1));
+  }
+
+ private:
+  /** The end of the range that starts at each slot, 0 if there is none. */
+  std::vector<std::atomic<Position>> m_links;
+
+  /** All the ranges before this position are complete. */
+  std::atomic<Position> m_tail{};
+
+  /** Set while a thread advances the tail. */
+  std::atomic<bool> m_advancing{};
+};
@@ -99,6 +99,103 @@ void ut_allocated_memory(ulint size);
 /** Memory was deallocated externally, @see os0proc.cc */
 void ut_deallocated_memory(ulint size);
 
+/** The subsystems that the memory allocated with ut_new() and by the
+memory heaps is accounted to. The subsystem is derived from the name of
+the source file that allocates, see ut_mem_tag_of(). The buffer pool
+frames are not accounted, their size is known. */
+enum class Mem_tag : uint8_t {
+  /** Buffer pool, other than the frames */
+  BUF,
+
+  /** Data dictionary cache */
+  DICT,
+
+  /** Lock system and the lock heaps */
+  LOCK,
+
+  /** Redo log and archiver */
+  LOG,
+
+  /** Redo log recovery, Recv_sys */
+  RECV,
+
+  /** Index build merge buffers */
+  MERGE,
+
+  /** Row operations, cursors and the query graphs */
+  ROW,
+
+  /** Transactions, undo and purge */
+  TRX,
+
+  /** Tablespaces, file space management and the OS layer */
+  FIL,
+
+  /** Free heap blocks in the thread local caches */
+  HEAP_CACHE,
+
+  /** Everything else */
+  OTHER
+};
+
+/** Number of memory accounting tags */
+constexpr size_t MEM_TAG_COUNT = size_t(Mem_tag::OTHER) + 1;
+
+/** Bytes accounted to a memory tag */
+struct Mem_tag_usage {
+  /** Bytes currently allocated */
+  ulint m_current;
+
+  /** Highest m_current seen by the periodic sampling */
+  ulint m_peak;
+};
+
+/**
+ * Maps a source file to the subsystem that its allocations are accounted to.
+ *
+ * @param[in] file_name Source file, e.g. from std::source_location
+ *
+ * @return the memory tag
+ */
+[[nodiscard]] Mem_tag ut_mem_tag_of(const char *file_name) noexcept;
+
+/**
+ * @param[in] tag Memory tag
+ *
+ * @return the name of the tag, as used in the status variable names
+ */
+[[nodiscard]] const char *ut_mem_tag_name(Mem_tag tag) noexcept;
+
+/**
+ * Accounts an allocation to a subsystem.
+ *
+ * @param[in] tag Memory tag
+ * @param[in] n Bytes allocated
+ */
+void ut_mem_tag_alloc(Mem_tag tag, ulint n) noexcept;
+
+/**
+ * Accounts a deallocation to a subsystem.
+ *
+ * @param[in] tag Memory tag
+ * @param[in] n Bytes freed
+ */
+void ut_mem_tag_free(Mem_tag tag, ulint n) noexcept;
+
+/**
+ * Sums the counters of a tag and updates its peak.
+ *
+ * @param[in] tag Memory tag
+ *
+ * @return the current and peak bytes of the tag
+ */
+[[nodiscard]] Mem_tag_usage ut_mem_tag_usage(Mem_tag tag) noexcept;
+
+/** Updates the peaks of all the tags, called periodically. The counters
+are sharded, so the peak is the highest value seen when sampled, not an
+exact high water mark. */
+void ut_mem_tag_sample_peaks() noexcept;
+
 /**
  * Copies up to size - 1 characters from the NUL-terminated string src to
  * dst, NUL-terminating the result. Returns strlen(src), so truncation
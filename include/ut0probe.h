@@ -0,0 +1,51 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file include/ut0probe.h
+Static tracepoints
+
+The USDT probes of the engine, for tracing with bpftrace, perf or
+SystemTap. They are built with -DWITH_USDT=ON if <sys/sdt.h> is found, else
+IB_PROBE() expands to nothing. The provider is "innodb", a probe named
+page__read__start is listed as innodb:page_read_start:
+
+  bpftrace -e 'usdt:./app:innodb:page_read_start { @[arg0] = count(); }'
+
+A probe is a nop instruction and a note in the ELF file, it costs nothing
+until a tracer attaches to it. The arguments are evaluated either way, the
+probes only pass values that are at hand.
+
+The probes and their arguments:
+
+  page__read__start     space_id, page_no
+  page__read__done      space_id, page_no, err
+  page__flush           space_id, page_no, flush_type, oldest_modification
+  mtr__commit           log bytes, log records, end_lsn
+  trx__start            trx_id, read_only
+  trx__commit           trx_id, commit_lsn
+  trx__rollback         trx_id, partial
+  lock__wait__start     trx_id, table_id
+  lock__wait__done      trx_id, table_id
+  log__write            start_lsn, end_lsn, bytes, flush
+  log__fsync            lsn
+  purge__batch__start   -
+  purge__batch__done    undo pages handled
+  btr__page__split      index_id, page_no, new_page_no, direction
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#ifdef HAVE_USDT
+#include <sys/sdt.h>
+
+/** Fires the probe innodb:name with up to 12 integer or pointer arguments. */
+#define IB_PROBE(name, ...) STAP_PROBEV(innodb, name __VA_OPT__(, ) __VA_ARGS__)
+
+#else /* HAVE_USDT */
+
+#define IB_PROBE(name, ...) \
+  do {                      \
+  } while (false)
+
+#endif /* HAVE_USDT */
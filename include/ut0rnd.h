@@ -151,6 +151,16 @@ inline ulint ut_rnd_gen_ulint(void) {
   return ut_rnd_gen_next_ulint(ut_rnd_ulint_counter);
 }
 
+/** Generates 'random' ulint integers like ut_rnd_gen_ulint() but from a
+state owned by the caller, the same seed gives the same series.
+@return	the 'random' number */
+inline ulint ut_rnd_gen_ulint(ulint *state) /*!< in/out: state, initially the seed */
+{
+  *state = UT_RND1 * *state + UT_RND2;
+
+  return ut_rnd_gen_next_ulint(*state);
+}
+
 /** Generates a random integer from a given interval.
 @return	the 'random' number */
 inline ulint ut_rnd_interval(
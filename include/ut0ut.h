@@ -173,10 +173,18 @@ void ut_print_timestamp(ib_stream_t ib_stream); /*!< in: file where to print */
 /** Sprintfs a timestamp to a buffer, 13..14 chars plus terminating NUL. */
 void ut_sprintf_timestamp(char *buf); /*!< in: buffer where to sprintf */
 
+/** Number of UT_RELAX_CPU() calls in one ut_delay() unit, set by
+ut_delay_calibrate() */
+extern ulint ut_delay_relax_count;
+
+/** Measures the cost of UT_RELAX_CPU() and sets ut_delay_relax_count so
+that a ut_delay() unit takes about the same time on every CPU. */
+void ut_delay_calibrate();
+
 /** Runs an idle loop on CPU. The argument gives the desired delay
-in microseconds on 100 MHz Pentium + Visual C++.
+in units of about 250 ns, see ut_delay_calibrate().
 @return	dummy value */
-ulint ut_delay(ulint delay); /*!< in: delay in microseconds on 100 MHz Pentium */
+ulint ut_delay(ulint delay); /*!< in: delay in units of about 250 ns */
 
 /**
  * Prints the contents of a memory buffer in hex and ascii as a warning
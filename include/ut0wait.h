@@ -0,0 +1,216 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file include/ut0wait.h
+Wait event tracing
+
+With ut_wait_trace set the threads record their waits: for a page read,
+a latch, a log flush, a row or table lock, an fsync or an AIO slot. Each
+wait is a Wait_event with its start, its duration and the object waited
+for, the events of a thread go to a ring buffer of its own that holds the
+last ut_wait_trace_events of them. Recording takes no latch and the fast
+paths are not timed, only the waits, so the tracer can stay on in
+production. It can be switched on and off at runtime.
+
+The rings are never freed, the ring of a thread that exits is reused by a
+thread started later. The events of all the rings can be collected, or
+dumped to a file, while the threads record.
+
+The same timers also add the waits to the Op_profile of the operation that
+the thread runs, if it has one, see the slow operation log.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+/** If true then the waits are traced. Not synchronized, it is a config
+variable that can be changed at runtime and a stale read only loses a few
+events. */
+extern bool ut_wait_trace;
+
+/** Number of events kept per thread, rounded up to a power of 2. The rings
+created after it is changed have the new size. */
+extern ulint ut_wait_trace_events;
+
+namespace ut {
+
+/** What a thread waited for. */
+enum class Wait_type : uint8_t {
+  /** A page read, m_object is space_id << 32 | page_no. */
+  PAGE_READ,
+
+  /** A mutex or an rw-lock, m_object is the address of the latch and the
+  site is where the latch was created. */
+  LATCH,
+
+  /** A log write or flush, m_object is the LSN waited for. */
+  LOG_FLUSH,
+
+  /** A row or table lock, m_object is the table id. */
+  LOCK,
+
+  /** An fsync(), m_object is the file descriptor. */
+  FSYNC,
+
+  /** A free AIO slot, m_object is the IO class. */
+  AIO_SLOT,
+};
+
+/** Number of Wait_type values. */
+constexpr size_t WAIT_TYPE_COUNT = size_t(Wait_type::AIO_SLOT) + 1;
+
+/** @return the name of a wait type. */
+[[nodiscard]] const char *to_string(Wait_type type) noexcept;
+
+/** What the operations of a transaction waited for, and the rows they
+examined. Only the thread that runs the operation updates it, the counters
+are not synchronized. */
+struct Op_profile {
+  /** Adds a wait.
+  @param[in] type               What was waited for
+  @param[in] ns                 Length of the wait in nanoseconds */
+  void add_wait(Wait_type type, uint64_t ns) noexcept {
+    ++m_n_waits[size_t(type)];
+    m_wait_ns[size_t(type)] += ns;
+  }
+
+  /** Adds the counters of another profile to this one.
+  @param[in] other              The profile to add */
+  void add(const Op_profile &other) noexcept {
+    for (size_t i{}; i < WAIT_TYPE_COUNT; ++i) {
+      m_n_waits[i] += other.m_n_waits[i];
+      m_wait_ns[i] += other.m_wait_ns[i];
+    }
+
+    m_n_rows_examined += other.m_n_rows_examined;
+    m_n_ops += other.m_n_ops;
+    m_op_ns += other.m_op_ns;
+  }
+
+  /** Number of waits by Wait_type */
+  std::array<uint64_t, WAIT_TYPE_COUNT> m_n_waits{};
+
+  /** Total length of the waits in nanoseconds by Wait_type */
+  std::array<uint64_t, WAIT_TYPE_COUNT> m_wait_ns{};
+
+  /** Records looked at by the searches, whether they matched or not */
+  uint64_t m_n_rows_examined{};
+
+  /** Number of operations profiled */
+  uint64_t m_n_ops{};
+
+  /** Total length of the operations in nanoseconds */
+  uint64_t m_op_ns{};
+};
+
+/** The profile that the waits of the calling thread are added to, nullptr
+if the thread does not profile the operation it runs. */
+extern thread_local Op_profile *op_profile;
+
+/** A traced wait. */
+struct Wait_event {
+  /** Start of the wait, steady clock nanoseconds since its epoch. */
+  uint64_t m_start_ns{};
+
+  /** Length of the wait in nanoseconds. */
+  uint64_t m_duration_ns{};
+
+  /** The object waited for, see Wait_type. */
+  uint64_t m_object{};
+
+  /** The thread that waited, see os_thread_pf(). */
+  uint64_t m_thread_id{};
+
+  /** Site of the wait, or of the creation of the latch. */
+  const char *m_file{};
+
+  /** Line of m_file. */
+  uint32_t m_line{};
+
+  /** What was waited for. */
+  Wait_type m_type{};
+};
+
+/** Adds a wait to the ring of the calling thread.
+@param[in] type                 What was waited for
+@param[in] object               The object waited for
+@param[in] file                 Site of the wait
+@param[in] line                 Line of file
+@param[in] start                Start of the wait */
+void wait_trace_record(Wait_type type, uint64_t object, const char *file, ulint line,
+                       std::chrono::steady_clock::time_point start) noexcept;
+
+/** Copies the events of all the rings, sorted by start. An event that is
+overwritten while it is copied is left out.
+@param[out] events              The events
+@param[in] reset                If true then the next call returns only the
+                                events recorded after this one */
+void wait_trace_collect(std::vector<Wait_event> &events, bool reset) noexcept;
+
+/** Writes the events of all the rings to a file, one per line.
+@param[in] path                 The file, it is overwritten
+@return DB_SUCCESS or DB_ERROR */
+[[nodiscard]] dberr_t wait_trace_dump(const char *path) noexcept;
+
+/** Times a wait for the tracer. The wait is recorded when the timer is
+stopped or goes out of scope, if it was started. */
+struct Wait_timer {
+  using Clock = std::chrono::steady_clock;
+
+  /** @param[in] type              What is waited for
+  @param[in] object             The object waited for
+  @param[in] file               Site of the wait
+  @param[in] line               Line of file */
+  Wait_timer(Wait_type type, uint64_t object, const char *file, ulint line) noexcept
+      : m_type(type), m_object(object), m_file(file), m_line(line) {}
+
+  ~Wait_timer() noexcept { stop(); }
+
+  /** Starts the timer if the tracer is on or the thread profiles its
+  operation, and it was not started yet. */
+  void start() noexcept {
+    if ((ut_wait_trace || op_profile != nullptr) && !m_started) {
+      m_start = Clock::now();
+      m_started = true;
+    }
+  }
+
+  /** Records the wait if the timer was started. */
+  void stop() noexcept {
+    if (m_started) {
+      m_started = false;
+
+      if (op_profile != nullptr) {
+        op_profile->add_wait(m_type, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count()));
+      }
+
+      if (ut_wait_trace) {
+        wait_trace_record(m_type, m_object, m_file, m_line, m_start);
+      }
+    }
+  }
+
+  /** What is waited for */
+  Wait_type m_type{};
+
+  /** The object waited for */
+  uint64_t m_object{};
+
+  /** Site of the wait */
+  const char *m_file{};
+
+  /** Line of m_file */
+  ulint m_line{};
+
+  /** true if start() took a timestamp */
+  bool m_started{};
+
+  /** When the wait started */
+  Clock::time_point m_start{};
+};
+
+}  // namespace ut
@@ -27,13 +27,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <cstdio>
 
 #include <functional>
+#include <string>
 #include <vector>
 
 struct ib_trx_struct;
 struct ib_crsr_struct;
 struct ib_tpl_struct;
+struct ib_blob_struct;
 struct ib_tbl_sch_struct;
 struct ib_idx_sch_struct;
+struct ib_log_stream_struct;
 
 /** Type of callback in the event of InnoDB panicing. Your callback should
  *  call exit() rather soon, as continuing after a panic will lead to errors
@@ -231,6 +234,10 @@ enum db_err {
 
   /** DDL is in progress. */
   DB_DDL_IN_PROGRESS,
+
+  /** The call of a non-blocking transaction would have waited for a page
+  read or a lock, it must be retried, see ib_trx_set_nonblocking() */
+  DB_WOULD_BLOCK,
 };
 
 using dberr_t = db_err;
@@ -350,7 +357,11 @@ enum ib_col_attr_t {
 
   /** Custom precision type, this is a bit that is ignored by InnoDB and
    * so can be set and queried by users. */
-  IB_COL_CUSTOM3 = 32
+  IB_COL_CUSTOM3 = 32,
+
+  /** Column is IB_INT and the transactions add to it with
+   * ib_cursor_add_delta(), the additions commute. */
+  IB_COL_COMMUTATIVE = 64
 };
 
 /* Note: must match lock0types.h */
@@ -489,7 +500,13 @@ enum ib_shutdown_t {
 
   /** Same as NO_IBUFMERGE_PURGE and in addition do not even flush the buffer
    * pool to data files. No committed transactions are lost */
-  IB_SHUTDOWN_NO_BUFPOOL_FLUSH
+  IB_SHUTDOWN_NO_BUFPOOL_FLUSH,
+
+  /** Same as NO_BUFPOOL_FLUSH, and in addition write a checkpoint at the
+   * oldest dirty page and dump the page ids of the whole buffer pool. The
+   * next startup only recovers the log written after the checkpoint and then
+   * loads the dumped pages back into the buffer pool. */
+  IB_SHUTDOWN_FAST_WARM
 };
 
 /** Generical InnoDB callback prototype. */
@@ -519,6 +536,10 @@ using ib_trx_t = ib_trx_struct*;
 /** InnoDB cursor handle */
 using ib_crsr_t = ib_crsr_struct*;
 
+/** InnoDB column value stream handle, reads a column value, usually a BLOB,
+ * in pieces without copying all of it to the tuple. */
+using ib_blob_t = ib_blob_struct*;
+
 /** InnoDB table schema handle */
 using ib_tbl_sch_t = ib_tbl_sch_struct*; 
 
@@ -838,6 +859,19 @@ extern ib_client_cmp_t  ib_client_compare;
  * @return  innobase txn handle */
 [[nodiscard]] ib_trx_t ib_trx_begin(ib_trx_level_t  trx_level);
 
+/** Begin a read-only transaction. The transaction is not assigned a
+ * transaction id and is not put in the list of active transactions, so
+ * starting and committing it does not invalidate the snapshot that other
+ * read views are built from. Consistent and locking reads are allowed,
+ * inserts, updates and deletes return DB_READONLY, and so do
+ * ib_schema_lock_exclusive() and the DDL functions. With the read_only
+ * config variable set every transaction is started read-only.
+ * 
+ * @ingroup trx
+ * @param trx_level is the transaction isolation level
+ * @return  innobase txn handle */
+[[nodiscard]] ib_trx_t ib_trx_begin_read_only(ib_trx_level_t trx_level);
+
 /** Set client data for a transaction. This is passed back to the client
  * in the trx_is_interrupted callback. InnoDB will only ever pass this
  * around, it will never dereference it.
@@ -869,13 +903,62 @@ void ib_trx_set_client_data(ib_trx_t trx, void* client_data);
 [[nodiscard]] ib_err_t ib_trx_release(ib_trx_t trx);
 
 /** Commit a transaction. This function will release the schema latches too.
-* It will also free the transaction handle.
+* It will also free the transaction handle. The deltas added with
+* ib_cursor_add_delta() are applied first, if one cannot be applied the
+* transaction is rolled back instead and the error returned.
 * 
 * @ingroup trx
 * @param trx is thr transaction handle
 * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_trx_commit(ib_trx_t trx);
 
+/** Callback of ib_trx_commit_async(), invoked with the ctx passed to it. */
+using ib_trx_commit_cb_t = void (*)(void *ctx);
+
+/** Commit a transaction without waiting for the log. The changes are visible
+* to other transactions and the locks and schema latches are released when
+* this returns, and the transaction handle is freed. The callback is invoked
+* once the commit is durable according to flush_log_at_trx_commit, from the
+* log writer or log flusher thread, or from this function if there is nothing
+* to wait for. The callback must not block and must not call back into InnoDB.
+* The deltas are applied as in ib_trx_commit(), the callback is not invoked if
+* the transaction is rolled back because one cannot be applied.
+* 
+* @ingroup trx
+* @param trx is the transaction handle
+* @param callback is invoked once the commit is durable
+* @param ctx is passed to the callback
+* @return  DB_SUCCESS or err code */
+[[nodiscard]] ib_err_t ib_trx_commit_async(ib_trx_t trx, ib_trx_commit_cb_t callback, void *ctx);
+
+/** Callback of ib_trx_set_nonblocking(), invoked with the ctx passed to it. */
+using ib_trx_wake_cb_t = void (*)(void *ctx);
+
+/** Make the cursor calls of a transaction non-blocking, so that one thread
+* can drive many transactions, e.g. from C++20 coroutines. A call that would
+* wait for a lock, or for the read of an index page that ib_cursor_moveto()
+* or ib_cursor_multi_get() search or of the clustered index page that
+* ib_cursor_insert_row() inserts into, returns DB_WOULD_BLOCK instead. The
+* callback is invoked once the call is worth retrying and the caller then
+* repeats the same call, ib_cursor_next() and ib_cursor_prev() return the
+* row they could not lock. Before returning DB_WOULD_BLOCK on a lock wait the
+* lock request is cancelled and the changes of the call are rolled back, it
+* is retried when a transaction releases its locks and may have to wait again.
+*
+* The callback is invoked once per DB_WOULD_BLOCK, from an IO or another user
+* thread, possibly before the call returns. It must not block and must not
+* call back into InnoDB, e.g. it should resume the coroutine on its executor
+* or write to an eventfd. Pages that are read while a call runs, e.g. the
+* pages of a range scan or of externally stored columns, are still waited for.
+*
+* @ingroup trx
+* @param trx is the transaction handle
+* @param callback is invoked when a call that returned DB_WOULD_BLOCK can be
+*  retried, nullptr makes the calls of the transaction blocking again
+* @param ctx is passed to the callback
+* @return  DB_SUCCESS or err code */
+ib_err_t ib_trx_set_nonblocking(ib_trx_t trx, ib_trx_wake_cb_t callback, void *ctx);
+
 /** Rollback a transaction. This function will release the schema latches too.
 * It will also free the transaction handle.
 * 
@@ -932,6 +1015,18 @@ void ib_table_schema_delete(ib_tbl_sch_t ib_tbl_sch);
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_table_schema_create(const char* name, ib_tbl_sch_t* tbl_sch, ib_tbl_fmt_t tbl_fmt, ulint page_size);
 
+/** Make the table of a schema a temporary table. It is dropped at the next
+ * startup, so its file is not recovered after a crash: its pages are written
+ * without the doublewrite buffer and the file is never fsync'ed. It is mostly
+ * read and written in the buffer pool, the file only gets the pages that the
+ * buffer pool evicts or the checkpoints flush. The changes to its pages
+ * write no redo log, only its undo log is logged. Needs file_per_table.
+ *
+ * @ingroup ddl
+ * @param ib_tbl_sch is the table schema instance
+ * @return  DB_SUCCESS or err code */
+[[nodiscard]] ib_err_t ib_table_schema_set_temporary(ib_tbl_sch_t ib_tbl_sch);
+
 /** Add columns to an index schema definition.
  * 
  * @ingroup ddl
@@ -964,6 +1059,14 @@ void ib_table_schema_delete(ib_tbl_sch_t ib_tbl_sch);
  * @param[in, out] crsr is the cursor to update */
 void ib_cursor_set_simple_select(ib_crsr_t crsr);
 
+/** Mark the cursor as used for a long scan. The pages it reads are not made
+ * young in the buffer pool, they are evicted before the working set of the
+ * other cursors. Cleared by ib_cursor_reset().
+ * 
+ * @ingroup sql
+ * @param[in, out] crsr is the cursor to update */
+void ib_cursor_set_scan_resistant(ib_crsr_t crsr);
+
 /** Set index as a unique index.
  * 
  * @ingroup ddl
@@ -1061,14 +1164,18 @@ void ib_index_schema_delete(ib_idx_sch_t idx_sch);
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_cursor_open_table(const char*  name, ib_trx_t trx, ib_crsr_t* crsr);
 
-/** Reset the cursor.
+/** Reset the cursor. The query graphs and buffers of the cursor are kept,
+ * ib_cursor_attach_trx() reuses them for the next transaction without
+ * allocating.
  * 
  * @ingroup cursor
  * @param crsr is an open cursor
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_cursor_reset(ib_crsr_t crsr);
 
-/** Close an InnoDB table and free the cursor.
+/** Close an InnoDB table and free the cursor. The insert and update query
+ * graphs of the cursor are kept by the table, the next cursor opened on it
+ * reuses them instead of building its own.
  * 
  * @ingroup cursor
  * @param crsr is an open cursor
@@ -1083,6 +1190,58 @@ void ib_index_schema_delete(ib_idx_sch_t idx_sch);
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_cursor_insert_row(ib_crsr_t  crsr, const ib_tpl_t tpl);
 
+/** Insert a batch of rows to a table. The rows are inserted in the order of
+ * the clustered index key, consecutive rows that go to the same leaf page
+ * don't search the index tree again. A row that is a duplicate or breaks a
+ * NOT NULL constraint is rolled back on its own and the batch goes on; any
+ * other error stops the batch. A parent key found for one row of the batch
+ * is not searched again for the later rows.
+ * 
+ * @ingroup dml
+ * @param crsr is an open cursor
+ * @param tpls are the tuples to insert
+ * @param n_rows is the number of tuples
+ * @param sorted is true if the tuples are already in clustered key order
+ * @param errs receives the result of each tuple, the rows not tried after
+ *  an error that stopped the batch get that error
+ * @return  DB_SUCCESS if all rows were inserted, else the error that stopped
+ *  the batch or the error of the first row that failed */
+[[nodiscard]] ib_err_t ib_cursor_insert_rows(ib_crsr_t crsr, const ib_tpl_t *tpls, ulint n_rows, bool sorted, ib_err_t *errs);
+
+/** Start a bulk load of an empty table. The table is X locked, the rows
+ * passed to ib_cursor_bulk_load_row() are appended to the clustered index
+ * pages directly, without row locks, undo log records and redo for the page
+ * contents. The rows are only visible once ib_cursor_bulk_load_end() returns,
+ * if it fails or the server crashes before it returns the table stays empty.
+ *
+ * @ingroup dml
+ * @param crsr is an open cursor, its transaction must be started
+ * @return  DB_SUCCESS or err code, DB_INVALID_INPUT if the table is not
+ *  empty */
+[[nodiscard]] ib_err_t ib_cursor_bulk_load_begin(ib_crsr_t crsr);
+
+/** Append a row to a bulk load. The rows must arrive in ascending order
+ * of the clustered index key.
+ *
+ * @ingroup dml
+ * @param crsr is the cursor of the bulk load
+ * @param tpl is the tuple to insert
+ * @return  DB_SUCCESS or err code, DB_DUPLICATE_KEY if the key equals the
+ *  previous key, DB_INVALID_INPUT if it is less than the previous key */
+[[nodiscard]] ib_err_t ib_cursor_bulk_load_row(ib_crsr_t crsr, const ib_tpl_t tpl);
+
+/** Finish a bulk load, the loaded pages are flushed and the tablespace is
+ * synced before the root page of the clustered index is logged. The secondary
+ * indexes of the table are built from the loaded rows. The foreign keys of
+ * the table are then checked in one ordered pass over each foreign index and
+ * its referenced index, the referenced tables are S locked.
+ *
+ * @ingroup dml
+ * @param crsr is the cursor of the bulk load
+ * @return  DB_SUCCESS or err code, DB_NO_REFERENCED_ROW if a loaded row
+ *  has no parent row */
+[[nodiscard]] ib_err_t ib_cursor_bulk_load_end(ib_crsr_t crsr);
+
 /** Update a row in a table.
  * 
  * @ingroup dml
@@ -1092,6 +1251,72 @@ void ib_index_schema_delete(ib_idx_sch_t idx_sch);
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_cursor_update_row(ib_crsr_t crsr, const ib_tpl_t old_tpl, const ib_tpl_t  new_tpl);
 
+/** Insert a row, or update the row with the same primary key if there is one.
+ * 
+ * The insert X-locks the row that has the same key, so the row can't change
+ * between the failed insert and the update and the caller doesn't need to
+ * retry. The columns in update_cols of the existing row are set to the values
+ * in tpl, the other columns keep their values. A duplicate in a unique
+ * secondary index is not updated, DB_DUPLICATE_KEY is returned and that row
+ * stays X-locked. Position the cursor again before moving it after the call.
+ * 
+ * @ingroup dml
+ * @param crsr is a cursor opened on the clustered index
+ * @param tpl is the row to insert
+ * @param update_cols are the column numbers to update in the existing row,
+ *  nullptr to update all the columns
+ * @param n_update_cols is the number of elements in update_cols
+ * @param[out] inserted is set to true if the row was inserted, false if it
+ *  was updated, can be nullptr
+ * @return  DB_SUCCESS or err code */
+[[nodiscard]] ib_err_t ib_cursor_upsert_row(
+  ib_crsr_t crsr, const ib_tpl_t tpl, const ulint *update_cols, ulint n_update_cols, bool *inserted);
+
+/** Add a delta to an integer column of the row the cursor is positioned on.
+ * 
+ * The old value is read and the new one written in place inside the engine,
+ * the row is not copied to the caller and back. The row is not locked by the
+ * call, the cursor lock mode must be IB_LOCK_X and the row must have been
+ * read with it. The column must be an integer column that is not part of any
+ * index.
+ * 
+ * @ingroup dml
+ * @param crsr is the cursor instance
+ * @param col_no is the column to change
+ * @param delta is the value to add, can be negative
+ * @param[out] new_value receives the new value, the bits of the column value
+ *  for an unsigned column above INT64_MAX, can be nullptr
+ * @return  DB_SUCCESS, DB_ERROR if the row is not X locked by the transaction,
+ *  DB_DATA_MISMATCH if the column is not an integer column, is indexed, is
+ *  SQL NULL or the new value is out of its range, or err code */
+[[nodiscard]] ib_err_t ib_cursor_increment(ib_crsr_t crsr, ulint col_no, int64_t delta, int64_t *new_value);
+
+/** Add a delta to a commutative column of a row without locking the row.
+ * 
+ * The delta is kept in the transaction and added to the row when the
+ * transaction commits, the row is X locked only for the commit. The
+ * transactions that add to the same hot row, e.g. a counter, then only
+ * serialize on their commits. The deltas are logged like any update when
+ * they are applied. ib_cursor_read_row() adds the deltas of the transaction
+ * to the row it reads, the other transactions see them once committed.
+ * 
+ * A rollback, also to a savepoint taken before the delta was added,
+ * discards it. ib_trx_commit() returns the error if a delta cannot be
+ * applied, the row is gone or the new value is out of the range of the
+ * column, and rolls the transaction back. The deltas are applied in table
+ * and key order, the transactions that only add deltas don't deadlock with
+ * each other.
+ * 
+ * @ingroup dml
+ * @param crsr is an open cursor on the table
+ * @param key is a clustered index search tuple with the key of the row, see
+ *  ib_clust_search_tuple_create(), it is copied
+ * @param col_no is the column to change, it must have IB_COL_COMMUTATIVE set
+ * @param delta is the value to add, can be negative
+ * @return  DB_SUCCESS, DB_DATA_MISMATCH if the column is not commutative,
+ *  is indexed or the key is not a full clustered index key, or err code */
+[[nodiscard]] ib_err_t ib_cursor_add_delta(ib_crsr_t crsr, const ib_tpl_t key, ulint col_no, int64_t delta);
+
 /** Delete a row in a table.
  * 
  * @ingroup dml
@@ -1099,6 +1324,22 @@ void ib_index_schema_delete(ib_idx_sch_t idx_sch);
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_cursor_delete_row(ib_crsr_t crsr);
 
+/** Delete all the rows whose clustered index key is in a range. The cursor
+ * must be on the clustered index. If the transaction holds an IB_LOCK_X on
+ * the table and the table has no secondary indexes and is not referenced by
+ * a foreign key, the rows are delete marked a leaf page at a time without
+ * record locks. Otherwise the rows are locked and deleted one at a time.
+ * The cursor must be repositioned afterwards.
+ *
+ * @ingroup dml
+ * @param crsr is the cursor instance
+ * @param low_tpl is the lowest key to delete, inclusive, or nullptr to start
+ *  at the first row
+ * @param high_tpl is the highest key to delete, inclusive, or nullptr to
+ *  delete up to the last row
+ * @return  DB_SUCCESS or err code */
+[[nodiscard]] ib_err_t ib_cursor_delete_range(ib_crsr_t crsr, const ib_tpl_t low_tpl, const ib_tpl_t high_tpl);
+
 /** Read current row.
  * 
  * @ingroup dml
@@ -1107,6 +1348,44 @@ void ib_index_schema_delete(ib_idx_sch_t idx_sch);
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_cursor_read_row(ib_crsr_t crsr, ib_tpl_t tpl);
 
+/** The values of one column for a batch of rows, see ib_cursor_read_batch().
+The caller owns the buffers, reusing them between batches avoids allocating
+them again. Integer, FLOAT and DOUBLE values are converted to the host format
+as the ib_tuple_read_*() functions do, the other values are as stored. */
+struct ib_col_batch_t {
+  /** Column number in the table, set by the caller. */
+  ulint col;
+
+  /** The values of the rows, back to back. */
+  std::vector<ib_byte_t> data;
+
+  /** The value of row i is data[offsets[i]] up to data[offsets[i + 1]], so
+  there is one more offset than there are rows. */
+  std::vector<ulint> offsets;
+
+  /** Bit (i % 8) of nulls[i / 8] is set if the value of row i is SQL NULL. */
+  std::vector<ib_byte_t> nulls;
+
+  /** @return the number of rows in the batch. */
+  ulint n_rows() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+  /** @return true if the value of row i is SQL NULL. */
+  bool is_null(ulint i) const { return (nulls[i / 8] >> (i % 8)) & 1; }
+};
+
+/** Read the current row and the rows after it, up to n rows, directly into
+ * column buffers, without converting them to tuples. The cursor is left on
+ * the row after the last one read. The cursor must be on the clustered index.
+ *
+ * @ingroup dml
+ * @param crsr is the cursor instance
+ * @param n is the maximum number of rows to read
+ * @param cols are the columns to read, their buffers are cleared first
+ * @param[out] n_read is the number of rows read
+ * @return  DB_SUCCESS, DB_END_OF_INDEX if there are no rows after the ones
+ *  read, DB_DATA_MISMATCH if a column doesn't exist, or err code */
+[[nodiscard]] ib_err_t ib_cursor_read_batch(ib_crsr_t crsr, ulint n, std::vector<ib_col_batch_t> &cols, ulint *n_read);
+
 /** Move cursor to the prev user record in the table.
  * 
  * @ingroup cursor
@@ -1145,6 +1424,39 @@ void ib_index_schema_delete(ib_idx_sch_t idx_sch);
  * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_cursor_moveto(ib_crsr_t crsr, ib_tpl_t tpl, ib_srch_mode_t srch_mode, int* result);
 
+/** Look up a batch of rows by their clustered index keys. The keys are
+ * looked up in key order: the leaf pages that are not in the buffer pool are
+ * read ahead together first, and a key on the leaf page of the previous one
+ * doesn't search the index tree again. The rows are always copied to the
+ * tuples, also in zero-copy mode. Position the cursor again before moving
+ * it after the call.
+ *
+ * @ingroup cursor
+ * @param crsr is an open cursor on the clustered index
+ * @param keys are the key tuples of the rows to look up
+ * @param n is the number of keys
+ * @param tpls receive the rows, tpls[i] is the row of keys[i]
+ * @param errs receives the result of each key, DB_SUCCESS or
+ *  DB_RECORD_NOT_FOUND, the keys not looked up after an error that stopped
+ *  the batch get that error
+ * @return  DB_SUCCESS, or the error that stopped the batch */
+[[nodiscard]] ib_err_t ib_cursor_multi_get(ib_crsr_t crsr, const ib_tpl_t* keys, ulint n, ib_tpl_t* tpls, ib_err_t* errs);
+
+/** Look up a row by its full clustered index key. A consistent read searches
+ * the leaf page directly and copies the record if the read view of the
+ * transaction sees it, without the row search; a locking read, or a row whose
+ * visible version must be built from the undo log, takes the path of
+ * ib_cursor_moveto() with IB_EXACT_MATCH and ib_cursor_read_row(). The row is
+ * always copied to the tuple, also in zero-copy mode. Position the cursor
+ * again before moving it after the call.
+ *
+ * @ingroup cursor
+ * @param crsr is an open cursor on the clustered index
+ * @param key is the key tuple of the row, with all the key columns set
+ * @param tpl receives the row
+ * @return  DB_SUCCESS, DB_RECORD_NOT_FOUND or err code */
+[[nodiscard]] ib_err_t ib_cursor_get_by_pk(ib_crsr_t crsr, const ib_tpl_t key, ib_tpl_t tpl);
+
 /** Attach the cursor to the transaction. The cursor must not already be
  * attached to another transaction.
  *
@@ -1160,6 +1472,95 @@ void ib_cursor_attach_trx(ib_crsr_t crsr, ib_trx_t trx);
  * @param match_mode is the match mode to set */
 void ib_cursor_set_match_mode(ib_crsr_t crsr, ib_match_mode_t match_mode);
 
+/** Set whether the rows read with the cursor leave the externally stored
+ * part of BLOB columns on the BLOB pages. The part is then only read when the
+ * column value is asked for, or through ib_col_blob_open(). Off by default.
+ *
+ * @ingroup cursor
+ * @param crsr is the cursor instance
+ * @param flag is true to leave the BLOBs on their pages */
+void ib_cursor_set_blob_streaming(ib_crsr_t crsr, bool flag);
+
+/** Set whether ib_cursor_read_row() returns the columns without copying the
+ * row. The column values that ib_col_get_value() returns then point into the
+ * leaf page, which the cursor keeps S-latched. They are only valid until the
+ * next call with the cursor: any move, read, insert, update, delete or lock,
+ * ib_cursor_reset() or ib_cursor_close(). Until then other threads can't
+ * change the page, and the thread must not use other cursors, nor commit or
+ * roll back the transaction. Debug builds assert if the columns are used
+ * after the page was released. Off by default.
+ *
+ * @ingroup cursor
+ * @param crsr is the cursor instance
+ * @param flag is true to read the rows without copying them */
+void ib_cursor_set_zero_copy(ib_crsr_t crsr, bool flag);
+
+/** Set whether the cursor keeps the page it is positioned on buffer-fixed
+ * between the calls. The next call then continues from the page without
+ * searching the index again, unless the page was modified in between. This
+ * suits scans that yield often. The page can't be evicted while it is fixed,
+ * and the table can't be dropped until the cursor is closed. Off by default.
+ *
+ * @ingroup cursor
+ * @param crsr is the cursor instance
+ * @param flag is true to keep the page fixed */
+void ib_cursor_set_keep_page_fixed(ib_crsr_t crsr, bool flag);
+
+/** Set how many rows a scan with the cursor may prefetch per page visit.
+ * After a few rows, ib_cursor_next() and ib_cursor_prev() copy the following
+ * rows into a cache and return them from there. The batch starts small and
+ * doubles while the scan goes on, up to n_rows and 1 MB of row copies. Only
+ * for consistent reads: the cursor is positioned on the last prefetched row,
+ * so don't update or delete rows through it. 0 by default, which disables it.
+ *
+ * @ingroup cursor
+ * @param crsr is the cursor instance
+ * @param n_rows is the maximum number of rows to prefetch, at most 1024 */
+void ib_cursor_set_prefetch_rows(ib_crsr_t crsr, ulint n_rows);
+
+/** Set whether a range scan of a secondary index, that reads columns that
+ * are only in the clustered index, reads ahead the clustered index pages.
+ * When the scan reaches a secondary index page, the clustered index leaf
+ * pages of its remaining records are read asynchronously, in page order. The
+ * rows are still returned in the secondary index order. This pays off when
+ * the table is larger than the buffer pool. Off by default.
+ *
+ * @ingroup cursor
+ * @param crsr is the cursor instance
+ * @param flag is true to read ahead the clustered index pages */
+void ib_cursor_set_multi_range_read(ib_crsr_t crsr, bool flag);
+
+/** A comparison of a column with a constant, evaluated on the stored record
+before it is read into a tuple, see ib_cursor_set_filters() and
+ib_parallel_scan(). */
+struct ib_scan_filter_t {
+  /** Comparison, a NULL column only matches IS_NULL. */
+  enum op_t { EQ, NE, LT, LE, GT, GE, IS_NULL, IS_NOT_NULL };
+
+  /** Column number in the table. The index must store the column in full,
+  in the clustered index it must be a fixed length column. */
+  ulint col;
+
+  /** Comparison to apply. */
+  op_t op;
+};
+
+/** Set filters that the rows read through the cursor must pass. They are
+ * evaluated on the records of the index the cursor is opened on, so a row
+ * of a secondary index that fails them is skipped before the clustered index
+ * record is read, and no row that fails them is copied out. The columns must
+ * be in the index, see ib_scan_filter_t. They apply until they are replaced,
+ * an empty vector removes them.
+ *
+ * @ingroup cursor
+ * @param crsr is the cursor instance
+ * @param filters are the filters, all of them must be true for a row
+ * @param values is a row tuple from ib_clust_read_tuple_create() with the
+ *  values that the filters compare with, they are copied
+ * @return DB_SUCCESS or DB_DATA_MISMATCH if a filter names a column that the
+ *  index does not store in full */
+[[nodiscard]] ib_err_t ib_cursor_set_filters(ib_crsr_t crsr, const std::vector<ib_scan_filter_t> &filters, const ib_tpl_t values);
+
 /** Set a column of the tuple. Make a copy using the tuple's heap.
  * 
  * @ingroup dml
@@ -1277,7 +1678,49 @@ void ib_cursor_set_match_mode(ib_crsr_t crsr, ib_match_mode_t match_mode);
  * @return  len of column data */
 ulint ib_col_get_meta(ib_tpl_t tpl, ulint i, ib_col_meta_t* col_meta);
 
-/** "Clear" or reset an InnoDB tuple. We free the heap and recreate the tuple.
+/** Open a stream on a column value of a tuple. The externally stored part
+ * of a BLOB is only read if the tuple was read with a cursor that has
+ * ib_cursor_set_blob_streaming() set. The stream must be closed before the
+ * tuple is cleared or deleted, and used within the transaction that read the
+ * row: the row must be locked, or read in a consistent read.
+ *
+ * @ingroup dml
+ * @param tpl is the tuple instance
+ * @param i is the index (ordinal position) of the column within the tuple
+ * @param[out] blob is the new stream
+ * @return  DB_SUCCESS, DB_DATA_MISMATCH if the column is SQL NULL, or err code */
+[[nodiscard]] ib_err_t ib_col_blob_open(ib_tpl_t tpl, ulint i, ib_blob_t* blob);
+
+/** Get the length of the column value of a stream.
+ *
+ * @ingroup dml
+ * @param blob is an open stream
+ * @return  length of the column value */
+[[nodiscard]] uint64_t ib_blob_get_len(ib_blob_t blob);
+
+/** Copy a part of the column value of a stream to a buffer. The BLOB pages
+ * are read straight into the buffer and the following pages are read ahead,
+ * reads in increasing offset order visit each BLOB page once.
+ *
+ * @ingroup dml
+ * @param blob is an open stream
+ * @param offset is the offset in the column value to read from
+ * @param[out] dst is the buffer to copy to
+ * @param len is the number of bytes to copy
+ * @param[out] n_read is the number of bytes copied, less than len at the end
+ *   of the value
+ * @return  DB_SUCCESS or err code */
+[[nodiscard]] ib_err_t ib_blob_read(ib_blob_t blob, uint64_t offset, void* dst, ulint len, ulint* n_read);
+
+/** Close a stream.
+ *
+ * @ingroup dml
+ * @param blob is the stream to close */
+void ib_blob_close(ib_blob_t blob);
+
+/** "Clear" or reset an InnoDB tuple. We empty the heap and recreate the
+ * tuple. The heap keeps the capacity that earlier rows needed, up to 1MB,
+ * so that a loop that reuses the tuple doesn't allocate for every row.
  * 
  * @ingroup tuple
  * @param tpl is the tuple to be freed
@@ -1364,6 +1807,18 @@ void ib_tuple_delete(ib_tpl_t tpl);
  * @return  DB_SUCCESS or error code */
 [[nodiscard]] ib_err_t ib_cursor_truncate(ib_crsr_t* crsr, ib_id_t* table_id);
 
+/** Defragment the index of a cursor online. Walks the leaf level and merges
+ * each page into its left neighbour when the records of both fit within the
+ * fill_factor, the emptied pages are freed. The tree is latched for a few
+ * pages at a time, the index stays usable meanwhile. The progress is in the
+ * defrag_pages_scanned and defrag_pages_freed status variables.
+ *
+ * @ingroup ddl
+ * @param crsr is an open cursor, its index is defragmented
+ * @param[out] n_pages_freed is the number of leaf pages freed, or nullptr
+ * @return  DB_SUCCESS or error code */
+[[nodiscard]] ib_err_t ib_index_defragment(ib_crsr_t crsr, ulint *n_pages_freed);
+
 /** Truncate a table.
  * 
  * @ingroup ddl
@@ -1422,7 +1877,8 @@ void ib_tuple_delete(ib_tpl_t tpl);
  * 
  * @ingroup ddl
  * @param trx is the transaction instance
- * @return  DB_SUCCESS or error code */
+ * @return  DB_SUCCESS or error code, DB_READONLY if the read_only config
+ *  variable is set or the transaction is read-only */
 [[nodiscard]] ib_err_t ib_schema_lock_exclusive(ib_trx_t trx);
 
 /** Checks if the data dictionary is latched in exclusive mode by a
@@ -1476,6 +1932,24 @@ void ib_tuple_delete(ib_tpl_t tpl);
  * @param crsr is the cursor instance for which we want to set the flag */
 void ib_cursor_set_cluster_access(ib_crsr_t crsr);
 
+/** Declare the columns that the cursor reads.
+ * 
+ * If the index of the cursor has all of them, not as a column prefix, the rows
+ * are read from the secondary index records without a clustered index lookup,
+ * a row tuple from ib_clust_read_tuple_create() then gets the columns of the
+ * index and SQL NULL for the others. The clustered index record is only looked
+ * up when the secondary index record may not be visible to the read view.
+ * Otherwise the clustered index record is read, like after
+ * ib_cursor_set_cluster_access(). The declaration stays when the cursor is
+ * attached to another transaction.
+ * 
+ * @ingroup dml
+ * @param crsr is the cursor instance
+ * @param cols are the column numbers that are read
+ * @param n_cols is the number of elements in cols
+ * @return  DB_SUCCESS or DB_DATA_MISMATCH if a column doesn't exist */
+[[nodiscard]] ib_err_t ib_cursor_set_columns(ib_crsr_t crsr, const ulint *cols, ulint n_cols);
+
 /** Read a table's schema using the visitor pattern. It will make the
  * following sequence of calls:
  * 
@@ -1744,6 +2218,132 @@ void ib_logger_set(ib_msg_log_t msg_log, ib_msg_stream_t msg_stream);
  * @return  DB_SUCCESS or error code */
 [[nodiscard]] ib_err_t ib_status_get_all(const char***  names, uint32_t*  names_num);
 
+/** Callback for ib_status_visit(), called once per status variable.
+ * 
+ * @param arg is the argument passed to ib_status_visit()
+ * @param name is the status variable name, as in ib_status_get_all()
+ * @param value is its value in the snapshot
+ * @return 0 to continue, nonzero to stop the visit */
+using ib_status_visit_cb_t = int (*)(void *arg, const char *name, int64_t value);
+
+/** Visit all the status variables, e.g., to export them as metrics.
+ * 
+ * The values are read in one pass and copied, the callback is invoked on the
+ * copy so all the values are from the same snapshot and no latch is held while
+ * it runs. The buffer pool, log, lock, transaction, purge, I/O, latch, memory
+ * and latency counters are covered. It is cheap enough to be called every
+ * second.
+ * 
+ * @ingroup misc
+ * @param callback is invoked once per status variable, it must not call back
+ * into InnoDB
+ * @param arg is passed to callback
+ * @return DB_SUCCESS, or DB_INTERRUPTED if callback returned nonzero */
+[[nodiscard]] ib_err_t ib_status_visit(ib_status_visit_cb_t callback, void *arg);
+
+/** @struct ib_latency_t Latency of an operation, see ib_status_get_latencies(). */
+struct ib_latency_t {
+  /** Name of the operation, e.g., "cursor_moveto", static */
+  const char *name;
+
+  /** Number of operations measured */
+  uint64_t count;
+
+  /** Median latency in microseconds */
+  uint64_t p50_us;
+
+  /** 99th percentile latency in microseconds */
+  uint64_t p99_us;
+
+  /** 99.9th percentile latency in microseconds */
+  uint64_t p999_us;
+
+  /** Maximum latency in microseconds */
+  uint64_t max_us;
+};
+
+/** Get the latency percentiles of the cursor calls, the commits and the lock waits.
+ * 
+ * The latencies are recorded in histograms with buckets within a quarter of
+ * the value, the percentiles have that precision, the maximum is exact.
+ * 
+ * @ingroup misc
+ * @param[out] latencies An array allocated with malloc() (user needs to free())
+ * with one element per operation
+ * @param[out] n returns the number of elements in latencies
+ * @param[in] reset true to clear the histograms after reading them, the next
+ * call returns the latencies of the operations since this one
+ * @returns \ref DB_SUCCESS or error */
+[[nodiscard]] ib_err_t ib_status_get_latencies(ib_latency_t **latencies, uint32_t *n, bool reset);
+
+/** @enum ib_wait_type_t What a thread waited for, see ib_wait_event_t. */
+enum ib_wait_type_t {
+  /** A page read, object is space_id << 32 | page_no */
+  IB_WAIT_PAGE_READ,
+
+  /** A mutex or an rw-lock, object is the address of the latch and the site
+   * is where the latch was created */
+  IB_WAIT_LATCH,
+
+  /** A log write or flush, object is the LSN waited for */
+  IB_WAIT_LOG_FLUSH,
+
+  /** A row or table lock, object is the table id */
+  IB_WAIT_LOCK,
+
+  /** An fsync(), object is the file descriptor */
+  IB_WAIT_FSYNC,
+
+  /** A free AIO slot, object is the IO class */
+  IB_WAIT_AIO_SLOT
+};
+
+/** @struct ib_wait_event_t A wait traced while the "wait_trace" config
+ * variable was on, see ib_wait_trace_get(). */
+struct ib_wait_event_t {
+  /** What was waited for */
+  ib_wait_type_t type;
+
+  /** Start of the wait, nanoseconds of the steady clock of the host */
+  uint64_t start_ns;
+
+  /** Length of the wait in nanoseconds */
+  uint64_t duration_ns;
+
+  /** The object waited for, see ib_wait_type_t */
+  uint64_t object;
+
+  /** The thread that waited */
+  uint64_t thread_id;
+
+  /** Source file of the wait, or of the creation of the latch, static */
+  const char *file;
+
+  /** Line in file */
+  uint32_t line;
+};
+
+/** Get the traced waits.
+ *
+ * While the "wait_trace" config variable is on, each thread records its
+ * waits in a ring buffer of its own that keeps the last "wait_trace_events"
+ * of them. The fast paths are not timed, only the waits.
+ *
+ * @ingroup misc
+ * @param[out] events An array allocated with malloc() (user needs to free())
+ * with the waits in all the ring buffers, sorted by start
+ * @param[out] n_events returns the number of elements in events
+ * @param[in] reset true to return only the newer waits on the next call
+ * @returns \ref DB_SUCCESS or error */
+[[nodiscard]] ib_err_t ib_wait_trace_get(ib_wait_event_t **events, uint64_t *n_events, bool reset);
+
+/** Write the traced waits to a file, one per line, see ib_wait_trace_get().
+ *
+ * @ingroup misc
+ * @param[in] path The file, it is overwritten
+ * @returns \ref DB_SUCCESS or DB_ERROR */
+[[nodiscard]] ib_err_t ib_wait_trace_dump(const char *path);
+
 /**
  * Set panic handler.
  * 
@@ -1804,6 +2404,16 @@ struct ib_table_stats_t {
    * is called for; the counter is reset to zero at statistics calculation; this counter is
    * not protected by any latch, because this is only used for heuristics */
   uint64_t  stat_modified_counter;
+
+  /** Number of waits for table and record locks on the table since it was loaded */
+  uint64_t  lock_waits;
+
+  /** Total time of the lock waits on the table in microseconds */
+  uint64_t  lock_wait_time_us;
+
+  /** Bytes of the extents freed in the tablespace of the table whose disk space
+   * is not deallocated yet, see the file_trim_freed_extents option */
+  uint64_t  untrimmed_bytes;
 };
 
 /** Get table statistics.
@@ -1831,15 +2441,463 @@ struct ib_table_stats_t {
  * @returns \ref DB_SUCCESS or error. \ref DB_NOT_FOUND if index is not found */
 [[nodiscard]] ib_err_t ib_get_index_stat_n_diff_key_vals(ib_crsr_t crsr, const char* index_name, uint64_t *ncols, int64_t **n_diff);
 
+/** Get the record lock waits on an index
+ * 
+ * The counters cover the waits since the table was loaded in the data dictionary cache.
+ * 
+ * @ingroup misc
+ * @param crsr A Cursor that is opened to a table
+ * @param index_name name of the index
+ * @param lock_waits returns the number of record lock waits on the index
+ * @param lock_wait_time_us returns the total time of the waits in microseconds
+ * @returns \ref DB_SUCCESS or error. \ref DB_NOT_FOUND if index is not found */
+[[nodiscard]] ib_err_t ib_get_index_lock_wait_stats(ib_crsr_t crsr, const char* index_name, uint64_t *lock_waits, uint64_t *lock_wait_time_us);
+
+/** @struct ib_index_stats_t Operation and structure counters of an index.
+ * The counters cover the operations since the table was loaded in the data
+ * dictionary cache, they are never reset. */
+struct ib_index_stats_t {
+  /** Rows returned by the searches on the index */
+  uint64_t  rows_read;
+
+  /** Entries inserted in the index, including the new entries of an update
+   * that changes the key */
+  uint64_t  rows_inserted;
+
+  /** Records updated in place or moved by an update */
+  uint64_t  rows_updated;
+
+  /** Records delete marked */
+  uint64_t  rows_delete_marked;
+
+  /** Delete marked records removed by purge */
+  uint64_t  rows_purged;
+
+  /** Page splits */
+  uint64_t  page_splits;
+
+  /** Page merges */
+  uint64_t  page_merges;
+
+  /** Inserts that fit in the leaf page */
+  uint64_t  optimistic_inserts;
+
+  /** Inserts that had to split or allocate pages */
+  uint64_t  pessimistic_inserts;
+
+  /** Pages of the index read from disk by the cursors */
+  uint64_t  page_reads;
+
+  /** Number of record lock waits on the index */
+  uint64_t  lock_waits;
+
+  /** Total time of the record lock waits in microseconds */
+  uint64_t  lock_wait_time_us;
+};
+
+/** Get the operation and structure counters of an index
+ * 
+ * @ingroup misc
+ * @param crsr A Cursor that is opened to a table
+ * @param index_name name of the index
+ * @param index_stats a \ref ib_index_stats_t to be filled out by InnoDB
+ * @param sizeof_ib_index_stats_t sizeof(ib_index_stats_t). This allows for ABI compatible changes to the size of ib_index_stats_t.
+ * @returns \ref DB_SUCCESS or error. \ref DB_NOT_FOUND if index is not found */
+[[nodiscard]] ib_err_t ib_index_stats(ib_crsr_t crsr, const char* index_name, ib_index_stats_t *index_stats, size_t sizeof_ib_index_stats_t);
+
 /** Force an update of table and index statistics
  * 
- * This function forces an update to the table and index statistics for the table crsr is opened on.
+ * This function forces an update to the table and index statistics for the table crsr is opened on
+ * and stores them, they are loaded instead of sampled when the table is opened after a restart.
+ * It also rebuilds and stores the key histograms of the indexes of the table, they are used by
+ * ib_cursor_estimate_range() and refreshed from then on when enough of the table was modified.
  * 
  * @ingroup misc
  * @param crsr A Cursor that is opened to a table
  * @returns \ref DB_SUCCESS or error.  */
 [[nodiscard]] ib_err_t ib_update_table_statistics(ib_crsr_t crsr);
 
+/** Set the number of leaf pages sampled per index of a table
+ * 
+ * The statistics of the table are recalculated with the new sample size and stored with
+ * it, it is used from then on, also after a restart, instead of the stats_sample_pages
+ * configuration variable.
+ * 
+ * @ingroup misc
+ * @param crsr A Cursor that is opened to a table
+ * @param n_pages Number of pages to sample per index, 0 to use stats_sample_pages
+ * @returns \ref DB_SUCCESS or error.  */
+[[nodiscard]] ib_err_t ib_table_set_stats_sample_pages(ib_crsr_t crsr, uint64_t n_pages);
+
+/** Estimate the number of rows of the index of a cursor in a key range.
+ * 
+ * The estimate comes from the key histogram of the index if the table was analyzed
+ * with ib_update_table_statistics(), otherwise from a dive to both ends of the range.
+ * 
+ * @ingroup misc
+ * @param crsr A Cursor that is opened to an index
+ * @param low Key tuple of the range start, or nullptr for no lower bound
+ * @param low_mode IB_CUR_GE to include the rows equal to low, IB_CUR_G to exclude them
+ * @param high Key tuple of the range end, or nullptr for no upper bound
+ * @param high_mode IB_CUR_G to include the rows equal to high, IB_CUR_GE to exclude them
+ * @param[out] n_rows The estimated number of rows
+ * @returns \ref DB_SUCCESS or error.  */
+[[nodiscard]] ib_err_t ib_cursor_estimate_range(
+  ib_crsr_t crsr, ib_tpl_t low, ib_srch_mode_t low_mode, ib_tpl_t high, ib_srch_mode_t high_mode, int64_t *n_rows);
+
+/** Read a random sample of the rows of the index of a cursor.
+ * 
+ * Each row is found by a random descent of the index tree, a few pages per row
+ * instead of a scan. A descent favours the rows on pages with few records, it is
+ * corrected by rejecting some of them, the sample is approximately uniform. The
+ * rows are read like ib_cursor_moveto() and ib_cursor_read_row() would, they are
+ * visible to the transaction and locked in its lock mode. A row can be sampled
+ * more than once. Position the cursor again before moving it after the call.
+ * 
+ * @ingroup cursor
+ * @param crsr A Cursor that is opened to an index
+ * @param n Number of rows to sample
+ * @param seed Seed of the random descents, the same seed gives the same sample
+ *  of an unchanged index
+ * @param tpls receive the rows, there must be n of them
+ * @param[out] n_sampled Number of rows read into tpls, less than n if the index
+ *  has few or no rows
+ * @returns \ref DB_SUCCESS or error.  */
+[[nodiscard]] ib_err_t ib_cursor_sample(ib_crsr_t crsr, ulint n, uint64_t seed, ib_tpl_t *tpls, ulint *n_sampled);
+
+/** Number of buckets in ib_buffer_pool_stats_t::n_age. */
+constexpr ulint IB_BUFFER_POOL_N_AGE_BUCKETS = 7;
+
+/** @struct ib_buffer_pool_stats_t Buffer pool usage of an index. */
+struct ib_buffer_pool_stats_t {
+  /** Tablespace id */
+  uint32_t space_id;
+
+  /** Index id, 0 for the pages of the tablespace that are not index pages,
+   * e.g., undo log and file segment inode pages */
+  ib_id_t index_id;
+
+  /** Number of pages in the buffer pool */
+  uint64_t n_pages;
+
+  /** Number of modified pages that are not yet written to disk */
+  uint64_t n_dirty;
+
+  /** Number of pages in the old sublist of the LRU list */
+  uint64_t n_old;
+
+  /** Number of pages in the young sublist of the LRU list */
+  uint64_t n_young;
+
+  /** Number of pages by the time since the first access: never accessed,
+   * less than 1 second, 10 seconds, 1 minute, 10 minutes, 1 hour and older */
+  uint64_t n_age[IB_BUFFER_POOL_N_AGE_BUCKETS];
+};
+
+/** Get the buffer pool usage of each index.
+ * 
+ * The buffer pool is scanned in small batches without blocking the other
+ * threads for long, the numbers are approximate. It is cheap enough to be
+ * sampled periodically, e.g., once a minute.
+ * 
+ * @ingroup misc
+ * @param stats An array allocated with malloc() (user needs to free()) with one
+ * element per (space_id, index_id), sorted by space_id and index_id
+ * @param n_stats returns the number of elements in stats
+ * @returns \ref DB_SUCCESS or error */
+[[nodiscard]] ib_err_t ib_buffer_pool_stats(ib_buffer_pool_stats_t **stats, uint64_t *n_stats);
+
+/** State of a buffer pool block, see ib_buffer_pool_page_t::state. */
+enum ib_buffer_page_state_t {
+  /** In the free list */
+  IB_BUF_PAGE_NOT_USED,
+
+  /** Taken from the free list, about to be used */
+  IB_BUF_PAGE_READY_FOR_USE,
+
+  /** Holds a page of a tablespace */
+  IB_BUF_PAGE_FILE_PAGE,
+
+  /** Used for some other in-memory object, e.g., the adaptive hash index */
+  IB_BUF_PAGE_MEMORY,
+
+  /** Being removed from the adaptive hash index before it is freed */
+  IB_BUF_PAGE_REMOVE_HASH
+};
+
+/** @struct ib_buffer_pool_page_t A buffer pool block, see
+ * ib_buffer_pool_page_visit(). The fields after state are only set for
+ * IB_BUF_PAGE_FILE_PAGE. */
+struct ib_buffer_pool_page_t {
+  /** Buffer pool instance of the block */
+  uint32_t instance;
+
+  /** State of the block */
+  ib_buffer_page_state_t state;
+
+  /** Tablespace id */
+  uint32_t space_id;
+
+  /** Page number */
+  uint32_t page_no;
+
+  /** The FIL_PAGE_TYPE of the page, 0 while it is being read in */
+  uint16_t page_type;
+
+  /** Index id for an index page, else 0 */
+  ib_id_t index_id;
+
+  /** Number of threads that have the page pinned */
+  uint32_t fix_count;
+
+  /** true if an i/o of the page is pending */
+  bool io_pending;
+
+  /** true if the page is modified and not yet written to disk */
+  bool dirty;
+
+  /** LSN of the oldest modification that is not on disk, 0 if clean */
+  uint64_t oldest_modification;
+
+  /** LSN of the newest modification, 0 if never modified */
+  uint64_t newest_modification;
+
+  /** Time of the first access in milliseconds, 0 if never accessed */
+  uint32_t access_time;
+
+  /** true if the page is in the old sublist of the LRU list */
+  bool old;
+
+  /** Position in the LRU list, as the number of pages evicted from the
+   * instance since the page was last moved to the head of the list */
+  uint64_t lru_age;
+};
+
+/** Callback for ib_buffer_pool_page_visit(), called once per block.
+ *
+ * @param arg is the argument passed to ib_buffer_pool_page_visit()
+ * @param page is the block
+ * @return 0 to continue, nonzero to stop the visit */
+using ib_buffer_pool_page_visit_cb_t = int (*)(void *arg, const ib_buffer_pool_page_t *page);
+
+/** Visit the blocks of the buffer pool, e.g., to list the tables with the
+ * most pages in memory or to check which pages stay cached.
+ *
+ * The block descriptors are copied in small batches with the buffer pool
+ * mutex released in between, no latch is held while the callback runs. The
+ * result is not a consistent snapshot, a page that is evicted and read in
+ * again during the visit can be missed or seen twice.
+ *
+ * @ingroup misc
+ * @param callback is invoked once per block, it must not call back
+ * into InnoDB
+ * @param arg is passed to callback
+ * @return DB_SUCCESS, or DB_INTERRUPTED if callback returned nonzero */
+[[nodiscard]] ib_err_t ib_buffer_pool_page_visit(ib_buffer_pool_page_visit_cb_t callback, void *arg);
+
+/** Kind of the pages of an i/o, the index of ib_tablespace_io_stats_t::reads
+ * and ib_tablespace_io_stats_t::writes. */
+enum ib_io_page_class_t {
+  /** B-tree pages */
+  IB_IO_PAGE_INDEX,
+
+  /** Undo log pages */
+  IB_IO_PAGE_UNDO,
+
+  /** BLOB pages */
+  IB_IO_PAGE_BLOB,
+
+  /** Space management, inode, transaction system and the other pages */
+  IB_IO_PAGE_SYSTEM,
+
+  /** Redo log i/o, and the i/o that does not start at a page boundary */
+  IB_IO_PAGE_OTHER,
+
+  /** Number of kinds of pages */
+  IB_IO_PAGE_N_CLASSES
+};
+
+/** @struct ib_io_counters_t Completed reads or writes of one kind of page. */
+struct ib_io_counters_t {
+  /** Number of requests */
+  uint64_t n_ios;
+
+  /** Bytes transferred */
+  uint64_t n_bytes;
+
+  /** Sum of the submit to completion latencies in microseconds */
+  uint64_t latency_us;
+};
+
+/** @struct ib_tablespace_io_stats_t I/O statistics of a tablespace. */
+struct ib_tablespace_io_stats_t {
+  /** Tablespace id */
+  uint32_t space_id;
+
+  /** Tablespace name, the path of its first file. Only valid during the
+   * callback */
+  const char *name;
+
+  /** Reads by kind of page */
+  ib_io_counters_t reads[IB_IO_PAGE_N_CLASSES];
+
+  /** Writes by kind of page */
+  ib_io_counters_t writes[IB_IO_PAGE_N_CLASSES];
+
+  /** Number of requests to the files of the tablespace that did not complete */
+  uint64_t n_pending;
+};
+
+/** Callback for ib_tablespace_io_visit(), called once per tablespace.
+ * 
+ * @param arg is the argument passed to ib_tablespace_io_visit()
+ * @param stats are the statistics of the tablespace
+ * @return 0 to continue, nonzero to stop the visit */
+using ib_tablespace_io_visit_cb_t = int (*)(void *arg, const ib_tablespace_io_stats_t *stats);
+
+/** Visit the i/o statistics of all the tablespaces, e.g., to find the
+ * tables that drive the disk load.
+ * 
+ * The counters cover the requests that completed since the tablespace was
+ * opened, a write that was coalesced with its neighbours counts as one
+ * request. The statistics are copied first, no latch is held while the
+ * callback runs.
+ * 
+ * @ingroup misc
+ * @param callback is invoked once per tablespace, it must not call back
+ * into InnoDB
+ * @param arg is passed to callback
+ * @return DB_SUCCESS, or DB_INTERRUPTED if callback returned nonzero */
+[[nodiscard]] ib_err_t ib_tablespace_io_visit(ib_tablespace_io_visit_cb_t callback, void *arg);
+
+/** @struct ib_log_rec_t A redo log record, see ib_log_stream_read(). */
+struct ib_log_rec_t {
+  /** LSN of the start of the record */
+  uint64_t lsn;
+
+  /** LSN of the end of the record */
+  uint64_t end_lsn;
+
+  /** Type of the record, one of the MLOG_ types of the engine */
+  uint32_t type;
+
+  /** Tablespace id */
+  uint32_t space_id;
+
+  /** Page number */
+  uint32_t page_no;
+
+  /** True if the record ends a mini-transaction, a stream can be opened
+   * at its end_lsn */
+  bool mtr_end;
+
+  /** Body of the record that follows the type, space id and page number.
+   * Valid until the next call of ib_log_stream_read() */
+  const ib_byte_t *body;
+
+  /** Length of body in bytes */
+  uint64_t body_len;
+};
+
+/** A reader of the redo log records. */
+using ib_log_stream_t = ib_log_stream_struct*;
+
+/** Open a stream of the redo log records from an LSN.
+ *
+ * The records are read from the log archive, see the "log_archive_dir"
+ * config variable, and from the log files. Only the log that is flushed to
+ * disk is returned. Without an archive the log before the last checkpoint
+ * is not available. The streams must be closed before ib_shutdown().
+ *
+ * @ingroup misc
+ * @param start_lsn LSN of the start of a mini-transaction, e.g., the end_lsn
+ * of a record with mtr_end set, or 0 for the last checkpoint
+ * @param stream the new stream
+ * @returns \ref DB_SUCCESS or error. \ref DB_INVALID_INPUT if start_lsn
+ * cannot be the start of a record */
+[[nodiscard]] ib_err_t ib_log_stream_open(uint64_t start_lsn, ib_log_stream_t *stream);
+
+/** Read the next redo log record of a stream.
+ *
+ * @ingroup misc
+ * @param stream the stream
+ * @param rec the record
+ * @returns \ref DB_SUCCESS or error. \ref DB_END_OF_INDEX if all the flushed
+ * log is read, a later call returns the log that is flushed meanwhile.
+ * \ref DB_MISSING_HISTORY if the log was overwritten and is not archived */
+[[nodiscard]] ib_err_t ib_log_stream_read(ib_log_stream_t stream, ib_log_rec_t *rec);
+
+/** Close a redo log stream.
+ *
+ * @ingroup misc
+ * @param stream the stream
+ * @returns \ref DB_SUCCESS or error */
+ib_err_t ib_log_stream_close(ib_log_stream_t stream);
+
+/** Options and results of ib_backup(). */
+struct ib_backup_t {
+  /**
+   * Receives the backup as writes to its files. The files are the data files
+   * and the log files, named by their paths as the engine opened them. The
+   * same range of a log file can be written more than once, the last write
+   * wins.
+   *
+   * @param path Path of the file.
+   * @param offset Offset in the file.
+   * @param data The data to write, valid only during the call.
+   * @param len Length of data.
+   * @return DB_SUCCESS or error code, an error stops the backup and is
+   *  returned by ib_backup().
+   */
+  using sink_t = std::function<ib_err_t(const char *path, uint64_t offset, const ib_byte_t *data, ulint len)>;
+
+  /** Receives the backup. */
+  sink_t sink;
+
+  /** For an incremental backup the start_lsn of an earlier backup, only the
+  pages modified after it are copied. 0 for a full backup. */
+  uint64_t since_lsn{};
+
+  /** Maximum number of pages per second that the backup reads, 0 for no
+  limit. */
+  ulint max_pages_per_sec{};
+
+  /** The checkpoint LSN that the recovery of the backup starts at, set by
+  ib_backup(). */
+  uint64_t start_lsn{};
+
+  /** The LSN that the backup restores to, set by ib_backup(). */
+  uint64_t end_lsn{};
+
+  /** Number of pages copied, set by ib_backup(). */
+  uint64_t n_pages{};
+};
+
+/** Back up the database while it runs.
+ *
+ * The pages of the tablespaces are streamed to the sink one at a time, a page
+ * that fails the checksum checks because it was read while it was written is
+ * read again. The redo log written meanwhile is streamed as the images of
+ * the log files, with a checkpoint at the start of the backup. Starting the
+ * engine on the restored files recovers them to end_lsn like after a crash.
+ *
+ * The log is copied from the log archive if there is one, see the
+ * "log_archive_dir" config variable. Without it, the log must not be
+ * overwritten before it is copied, and the log written during the backup
+ * must fit in the log files.
+ *
+ * An incremental backup is restored by writing it over the restored earlier
+ * backup, before the engine is started on them. The tables created during a
+ * backup are created by the recovery, the files of the tables dropped after
+ * an earlier backup remain.
+ *
+ * @ingroup misc
+ * @param backup the options, and the results on return
+ * @returns \ref DB_SUCCESS or error. \ref DB_MISSING_HISTORY if the log was
+ * overwritten before it was copied, \ref DB_OUT_OF_FILE_SPACE if the log
+ * written during the backup does not fit in the log files */
+[[nodiscard]] ib_err_t ib_backup(ib_backup_t &backup);
+
 /** Inject an error into InnoDB
  * 
  * This function will simulate an error condition inside InnoDB.
@@ -1859,15 +2917,178 @@ struct ib_table_stats_t {
  * @param[out] n_rows Number of rows in the table */
 [[nodiscard]] ib_err_t ib_parallel_select_count_star(ib_trx_t trx, std::vector<ib_crsr_t> &crsrs, size_t n_threads, uint64_t &n_rows);
 
+/** Work done by a scan thread of ib_parallel_scan(). */
+struct ib_parallel_scan_stats_t {
+  /** Number of ranges scanned, a range split between the threads counts once
+  for each part. */
+  ulint n_ranges{};
+
+  /** Number of index pages visited. */
+  ulint n_pages{};
+
+  /** Number of rows passed to the row or batch visitor. */
+  uint64_t n_rows{};
+
+  /** Number of records skipped because they were not visible to the
+  transaction or did not pass the filters. */
+  uint64_t n_skipped{};
+
+  /** Rows passed to the visitor from each range, in scan order. */
+  std::vector<uint64_t> range_rows;
+
+  /** Nanoseconds spent scanning the ranges, the visitors included. */
+  uint64_t scan_ns{};
+
+  /** Nanoseconds spent taking the ranges off the shared queue. */
+  uint64_t dequeue_ns{};
+
+  /** Nanoseconds spent waiting for the other threads to hand out work. */
+  uint64_t idle_ns{};
+};
+
+/** Callback functions of ib_parallel_scan(). They are called from the scan
+threads, the thread id is in [0, n_threads) and the same thread never runs two
+callbacks at once, so per thread state can be kept in an array indexed by it.
+A callback returns DB_SUCCESS to continue, any other value aborts the scan and
+is returned by ib_parallel_scan(). */
+struct ib_parallel_scan_t {
+  /**
+   * Called once by each scan thread before its first row and once after its
+   * last row, also when the scan is aborted. Either can be empty.
+   *
+   * @param thread_id The id of the scan thread.
+   * @return DB_SUCCESS or error code.
+   */
+  using thread_t = std::function<ib_err_t(size_t thread_id)>;
+
+  /**
+   * Called for each row visible to the transaction. The tuple is a read only
+   * view of the row, use ib_col_get_meta() and the ib_tuple_read_*() functions
+   * on it. It is valid only during the call.
+   *
+   * @param thread_id The id of the scan thread.
+   * @param tpl The row read.
+   * @return DB_SUCCESS or error code.
+   */
+  using row_t = std::function<ib_err_t(size_t thread_id, const ib_tpl_t tpl)>;
+
+  /** Thread initialization */
+  thread_t init;
+
+  /** Row visitor */
+  row_t row;
+
+  /** Thread finalization */
+  thread_t finish;
+
+  /**
+   * Called instead of row with the rows read by a thread, batch_size rows
+   * at a time, the last batch of a thread can be smaller. The values of the
+   * columns in cols are read directly into the batches, there is one batch
+   * per column in the same order. They are valid only during the call.
+   *
+   * @param thread_id The id of the scan thread.
+   * @param batch The columns of the rows read.
+   * @return DB_SUCCESS or error code.
+   */
+  using batch_t = std::function<ib_err_t(size_t thread_id, const std::vector<ib_col_batch_t> &batch)>;
+
+  /** Column batch visitor, if set row is not used. */
+  batch_t batch;
+
+  /** Number of rows in a batch. */
+  ulint batch_size{1024};
+
+  /** Columns to read into the row tuple, the others are SQL NULL. Empty to
+  read all the columns. */
+  std::vector<ulint> cols;
+
+  /** Only the rows for which all the filters are true are visited. */
+  std::vector<ib_scan_filter_t> filters;
+
+  /** Row tuple from ib_clust_read_tuple_create() with the values that the
+  filters compare with, in the columns that they name. */
+  ib_tpl_t filter_values{};
+
+  /**
+   * Called once by each scan thread after finish, with the work the thread
+   * did. Can be empty.
+   *
+   * @param thread_id The id of the scan thread.
+   * @param stats The work done by the thread.
+   */
+  using stats_t = std::function<void(size_t thread_id, const ib_parallel_scan_stats_t &stats)>;
+
+  /** Scan thread statistics */
+  stats_t stats;
+};
+
+/**
+ * Scan the rows of a table in parallel with a consistent read. The rows of a
+ * range go to one thread in key order, the ranges are spread over the threads.
+ *
+ * @param trx The transaction, its read view is the snapshot read.
+ * @param crsr A cursor opened on the clustered index of the table.
+ * @param n_threads The maximum number of threads to use.
+ * @param start First key to read, from ib_clust_search_tuple_create(), or
+ *  nullptr to start at the first row.
+ * @param end Key to stop before, or nullptr to read to the last row.
+ * @param cbs Callback functions.
+ * @return DB_SUCCESS or error code.
+ */
+[[nodiscard]] ib_err_t ib_parallel_scan(ib_trx_t trx, ib_crsr_t crsr, size_t n_threads, const ib_tpl_t start, const ib_tpl_t end, const ib_parallel_scan_t &cbs);
+
+/** Options and results of ib_check_table(). */
+struct ib_check_table_t {
+  /** Result of checking one index. */
+  struct index_t {
+    /** Index name. */
+    std::string name;
+
+    /** Number of records that are not delete marked. */
+    uint64_t n_recs{};
+
+    /** Number of leaf pages. */
+    uint64_t n_pages{};
+
+    /** Number of records not in ascending order. */
+    uint64_t n_wrong_order{};
+
+    /** Number of duplicate keys in a unique index. */
+    uint64_t n_dups{};
+
+    /** Number of leaf pages that failed the page consistency check. */
+    uint64_t n_bad_pages{};
+
+    /** DB_SUCCESS, or the error found in the index. */
+    ib_err_t err{DB_SUCCESS};
+  };
+
+  /** Maximum number of leaf pages per second that the check reads, 0 for no
+  limit. */
+  ulint max_pages_per_sec{};
+
+  /** The results of the indexes checked, set by ib_check_table(). */
+  std::vector<index_t> indexes;
+};
+
 /**
- * Checks the table for errors using the given transaction and cursor.
+ * Checks the table for errors using the given transaction and cursor. The
+ * leaf pages of the index are checked in parallel partitions for record
+ * order, duplicates in a unique index and page consistency. If the cursor is
+ * on the clustered index, all the indexes of the table are checked at once and
+ * the number of records in each secondary index must match the clustered
+ * index. The records are read without locking and delete marked records are
+ * skipped, so the counts are only exact if the table isn't being modified.
  *
  * @param trx The InnoDB transaction to use for checking the table.
  * @param crsr The InnoDB cursor to use for checking the table.
  * @param n_threads The number of threads to use for checking the table.
+ * @param check The rate limit, and the per index results on return. Can be
+ *  nullptr.
  * @return The error code indicating the result of the table check.
  */
-[[nodiscard]] ib_err_t ib_check_table(ib_trx_t trx, ib_crsr_t crsr, size_t n_threads);
+[[nodiscard]] ib_err_t ib_check_table(ib_trx_t trx, ib_crsr_t crsr, size_t n_threads, ib_check_table_t *check);
 
 namespace logger {
 
@@ -372,7 +372,7 @@ struct Rec_lock_get_node {
   static const ut_list_node<Lock> &get_node(const Lock &lock) { return lock.m_rec.m_rec_locks; }
 };
 
-/* Flags for recursive deadlock search */
+/* Return values of the deadlock search */
 constexpr ulint LOCK_VICTIM_IS_START = 1;
 constexpr ulint LOCK_VICTIM_IS_OTHER = 2;
 constexpr ulint LOCK_EXCEED_MAX_DEPTH = 3;
@@ -475,12 +475,10 @@ bool Lock::has_to_wait_for(const Lock *lock, ulint heap_no) const noexcept {
   }
 }
 
-Lock *Lock::rec_clone(mem_heap_t *heap) const noexcept {
+Lock *Lock::rec_clone(void *ptr) const noexcept {
   ut_ad(type() == LOCK_REC);
 
-  const auto size = sizeof(Lock) + rec_get_n_bits() / 8;
-
-  return static_cast<Lock *>(mem_heap_dup(heap, this, size));
+  return static_cast<Lock *>(memcpy(ptr, this, rec_size()));
 }
 
 uint64_t Lock::table_id() const noexcept {
@@ -824,6 +822,16 @@ bool Lock_sys::is_table_exclusive(Table *table, Trx *trx) noexcept {
   return false;
 }
 
+bool Lock_sys::is_table_x_locked(Table *table, Trx *trx) noexcept {
+  mutex_enter(&kernel_mutex);
+
+  const auto locked = table_has(trx, table, LOCK_X) != nullptr;
+
+  mutex_exit(&kernel_mutex);
+
+  return locked;
+}
+
 #ifdef UNIV_DEBUG
 const Lock *Lock_sys::rec_exists(const Rec_locks &rec_locks, ulint heap_no) const noexcept {
   ut_ad(mutex_own(&kernel_mutex));
@@ -996,6 +1004,51 @@ Trx *Lock_sys::sec_rec_some_has_impl_off_kernel(const rec_t *rec, const Index *i
 
 
 
+Lock *Lock_sys::lock_alloc(Trx *trx, ulint n_bytes) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+
+  const auto size = sizeof(Lock) + n_bytes;
+  const auto size_class = Lock_pool::size_class(n_bytes);
+
+  if (unlikely(size_class == ULINT_UNDEFINED)) {
+    return reinterpret_cast<Lock *>(mem_heap_alloc(trx->m_lock_heap, size));
+  }
+
+  auto &head = trx->m_lock_pool.m_free[size_class];
+
+  if (head == nullptr) {
+    const auto n_locks = std::max(ulint(1), Lock_pool::SLAB_SIZE / size);
+    auto ptr = mem_heap_alloc(trx->m_lock_heap, n_locks * size);
+
+    for (ulint i{}; i < n_locks; ++i, ptr += size) {
+      auto lock = reinterpret_cast<Lock *>(ptr);
+
+      lock->m_trx_locks.m_next = head;
+      head = lock;
+    }
+  }
+
+  auto lock = head;
+
+  head = lock->m_trx_locks.m_next;
+
+  return lock;
+}
+
+void Lock_sys::lock_free(Lock *lock) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+
+  const auto n_bytes = lock->type() == LOCK_REC ? lock->rec_get_n_bits() / 8 : 0;
+  const auto size_class = Lock_pool::size_class(n_bytes);
+
+  if (likely(size_class != ULINT_UNDEFINED)) {
+    auto &head = lock->m_trx->m_lock_pool.m_free[size_class];
+
+    lock->m_trx_locks.m_next = head;
+    head = lock;
+  }
+}
+
 Lock *Lock_sys::rec_create_low(Page_id page_id, Lock_mode type_mode, ulint heap_no, ulint n_bits, const Index *index, Trx *trx) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
@@ -1010,9 +1063,9 @@ Lock *Lock_sys::rec_create_low(Page_id page_id, Lock_mode type_mode, ulint heap_
   }
 
   /* Make lock bitmap bigger by a safety margin */
-  const auto n_bytes = 1 + (n_bits + LOCK_PAGE_BITMAP_MARGIN) / 8;
+  const auto n_bytes = Lock_pool::bitmap_size(1 + (n_bits + LOCK_PAGE_BITMAP_MARGIN) / 8);
 
-  auto lock = reinterpret_cast<Lock *>(mem_heap_alloc(trx->m_lock_heap, sizeof(Lock) + n_bytes));
+  auto lock = lock_alloc(trx, n_bytes);
 
   trx->m_trx_locks.push_back(lock);
 
@@ -1275,6 +1328,16 @@ db_err Lock_sys::rec_lock_slow(bool impl, Lock_mode mode, const Buf_block *block
   return err;
 }
 
+bool Lock_sys::rec_modify_check_fast(const Buf_block *block) const noexcept {
+  ut_ad(!mutex_own(&kernel_mutex));
+  ut_ad(rw_lock_is_locked(const_cast<rw_lock_t *>(&block->m_rw_lock), RW_LOCK_EX));
+
+  /* A lock is added to a page only by a thread that latches it, so none can
+  be added while we hold the x-latch. Without locks on the page the implicit
+  x-lock of the modification needs no lock struct, like in rec_lock_fast(). */
+  return !m_rec_locks.has_locks(block->get_page_id());
+}
+
 db_err Lock_sys::rec_lock(bool impl, Lock_mode mode, const Buf_block *block, ulint heap_no, const Index *index, que_thr_t *thr) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
   ut_ad((LOCK_MODE_MASK & mode) != LOCK_S || table_has(thr_get_trx(thr), index->m_table, LOCK_IS));
@@ -1321,6 +1384,63 @@ bool Lock_sys::rec_has_to_wait_in_queue(const Rec_locks &rec_locks, Lock *waitin
   return false;
 }
 
+bool Lock_sys::rec_has_to_wait_for_granted(const Rec_locks &rec_locks, Lock *waiting_lock, ulint heap_no) const noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+  ut_ad(waiting_lock->is_waiting());
+  ut_ad(heap_no == waiting_lock->rec_find_set_bit());
+
+  for (auto lock : rec_locks) {
+    if (lock != waiting_lock && !lock->is_waiting() && lock->rec_is_nth_bit_set(heap_no) && waiting_lock->has_to_wait_for(lock, heap_no)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Lock_sys::rec_grant_waiting(Rec_locks &rec_locks, ulint heap_no) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+
+  if (!srv_config.m_lock_grant_by_weight) {
+    for (auto lock : rec_locks) {
+      if (lock->is_waiting() && (heap_no == ULINT_UNDEFINED || lock->rec_is_nth_bit_set(heap_no))) {
+        const auto lock_heap_no = heap_no == ULINT_UNDEFINED ? lock->rec_find_set_bit() : heap_no;
+
+        if (!rec_has_to_wait_in_queue(rec_locks, lock, lock_heap_no)) {
+          /* Grant the lock */
+          grant(lock);
+        }
+      }
+    }
+
+    return;
+  }
+
+  auto &candidates = m_grant_candidates;
+
+  candidates.clear();
+
+  for (auto lock : rec_locks) {
+    if (lock->is_waiting() && (heap_no == ULINT_UNDEFINED || lock->rec_is_nth_bit_set(heap_no))) {
+      candidates.push_back(lock);
+    }
+  }
+
+  /* Ties keep the queue order. */
+  std::stable_sort(candidates.begin(), candidates.end(), [](const Lock *lhs, const Lock *rhs) {
+    return lhs->m_trx->m_trx_locks.size() > rhs->m_trx->m_trx_locks.size();
+  });
+
+  for (auto lock : candidates) {
+    if (!rec_has_to_wait_for_granted(rec_locks, lock, lock->rec_find_set_bit())) {
+      rec_locks.remove(lock);
+      rec_locks.push_front(lock);
+
+      grant(lock);
+    }
+  }
+}
+
 void Lock_sys::grant(Lock *lock) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
@@ -1350,6 +1470,22 @@ void Lock_sys::rec_cancel(Lock *lock) noexcept {
   lock->m_trx->end_lock_wait();
 }
 
+bool Lock_sys::cancel_wait_nonblocking(Trx *trx, std::function<void()> callback) noexcept {
+  mutex_enter(&kernel_mutex);
+
+  auto wait_lock = trx->m_wait_lock;
+
+  if (wait_lock != nullptr) {
+    m_release_waiters.push_back(std::move(callback));
+
+    cancel_waiting_and_release(wait_lock);
+  }
+
+  mutex_exit(&kernel_mutex);
+
+  return wait_lock != nullptr;
+}
+
 void Lock_sys::rec_dequeue_from_page(Lock *lock) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
   ut_ad(lock->type() == LOCK_REC);
@@ -1373,16 +1509,13 @@ void Lock_sys::rec_dequeue_from_page(Lock *lock) noexcept {
 
   trx->m_trx_locks.remove(lock);
 
+  lock_free(lock);
+
   /* Check if waiting locks in the queue can now be granted: grant
   locks if there are no conflicting locks ahead. */
 
   if (!rec_locks_empty) {
-    for (auto lock : rec_locks) {
-      if (lock->is_waiting() && !rec_has_to_wait_in_queue(rec_locks, lock, lock->rec_find_set_bit())) {
-        /* Grant the lock */
-        grant(lock);
-      }
-    }
+    rec_grant_waiting(rec_locks, ULINT_UNDEFINED);
   }
 }
 
@@ -1395,6 +1528,8 @@ void Lock_sys::rec_discard(Lock *in_lock) noexcept {
   ut_a(n == 1);
 
   trx->m_trx_locks.remove(in_lock);
+
+  lock_free(in_lock);
 }
 
 void Lock_sys::rec_free_all_from_discard_page(Page_id page_id) noexcept {
@@ -1493,6 +1628,17 @@ void Lock_sys::rec_move(const Buf_block *receiver, const Buf_block *donator, uli
   }
 }
 
+bool Lock_sys::rec_expl_exist_on_page(Page_id page_id) noexcept {
+  mutex_enter(&kernel_mutex);
+
+  const auto it = m_rec_locks.find(page_id);
+  const auto exist = it != m_rec_locks.end() && !it->second.empty();
+
+  mutex_exit(&kernel_mutex);
+
+  return exist;
+}
+
 void Lock_sys::move_reorganize_page(const Buf_block *block, const Buf_block *oblock) noexcept {
   UT_LIST_BASE_NODE_T(Lock, m_trx_locks) old_locks;
 
@@ -1505,15 +1651,27 @@ void Lock_sys::move_reorganize_page(const Buf_block *block, const Buf_block *obl
     return;
   }
 
-  auto heap = mem_heap_create(256);
+  ulint size{};
+
+  for (auto lock : it->second) {
+    size += lock->rec_size();
+  }
+
+  if (m_reorganize_buf.size() < size) {
+    m_reorganize_buf.resize(size);
+  }
+
+  auto ptr = m_reorganize_buf.data();
 
-  /* Copy first all the locks on the page to heap and reset the
+  /* Copy first all the locks on the page to the buffer and reset the
   bitmaps in the original locks; chain the copies of the locks
   using the trx_locks field in them. */
 
   for (auto lock : it->second) {
     /* Make a copy of the lock */
-    auto old_lock = lock->rec_clone(heap);
+    auto old_lock = lock->rec_clone(ptr);
+
+    ptr += old_lock->rec_size();
 
     old_locks.push_back(old_lock);
 
@@ -1575,8 +1733,6 @@ void Lock_sys::move_reorganize_page(const Buf_block *block, const Buf_block *obl
 
   mutex_exit(&kernel_mutex);
 
-  mem_heap_free(heap);
-
   ut_ad(rec_validate_page(block->get_page_id()));
 }
 
@@ -1905,20 +2061,17 @@ void Lock_sys::rec_restore_from_page_infimum(const Buf_block *block, const rec_t
 
 bool Lock_sys::deadlock_occurs(Lock *lock, Trx *trx) noexcept {
   ulint ret;
-  ulint cost{};
 
   ut_ad(mutex_own(&kernel_mutex));
 
 retry:
   /* We check that adding this trx to the waits-for graph
-  does not produce a cycle. First mark all active transactions
-  with 0: */
+  does not produce a cycle. Start a new search, this clears
+  the marks of all transactions. */
 
-  for (auto mark_trx : m_trx_sys->m_trx_list) {
-    mark_trx->m_deadlock_mark = 0;
-  }
+  ++m_deadlock_epoch;
 
-  ret = deadlock_recursive(trx, trx, lock, &cost, 0);
+  ret = deadlock_search(trx, lock);
 
   switch (ret) {
     case LOCK_VICTIM_IS_OTHER:
@@ -1951,157 +2104,178 @@ retry:
   return true;
 }
 
-ulint Lock_sys::deadlock_recursive(Trx *start, Trx *trx, Lock *wait_lock, ulint *cost, ulint depth) noexcept {
-  ulint ret;
+Lock *Lock_sys::deadlock_first_ahead(Lock *wait_lock, ulint &heap_no) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
-  if (trx->m_deadlock_mark == 1) {
-    /* We have already exhaustively searched the subtree starting from this trx */
+  if (wait_lock->type() != LOCK_REC) {
+    heap_no = ULINT_UNDEFINED;
 
-    return 0;
+    return UT_LIST_GET_PREV(m_table.m_locks, wait_lock);
   }
 
-  ++*cost;
+  heap_no = wait_lock->rec_find_set_bit();
+  ut_a(heap_no != ULINT_UNDEFINED);
 
   Lock *found_lock{};
-  ulint heap_no{ULINT_UNDEFINED};
-
-  if (wait_lock->type() == LOCK_REC) {
-    heap_no = wait_lock->rec_find_set_bit();
-    ut_a(heap_no != ULINT_UNDEFINED);
 
-    if (auto it = m_rec_locks.find(wait_lock->page_id()); it != m_rec_locks.end()) {
-      for (auto lock : it->second) {
-        ut_ad(lock->type() == LOCK_REC);
-        if (lock == wait_lock || lock->rec_is_nth_bit_set(heap_no)) {
-          found_lock = lock;
-          break;
-        }
+  if (auto it = m_rec_locks.find(wait_lock->page_id()); it != m_rec_locks.end()) {
+    for (auto lock : it->second) {
+      ut_ad(lock->type() == LOCK_REC);
+      if (lock == wait_lock || lock->rec_is_nth_bit_set(heap_no)) {
+        found_lock = lock;
+        break;
       }
     }
+  }
 
-    if (found_lock == wait_lock) {
-      found_lock = nullptr;
-    }
+  if (found_lock == wait_lock) {
+    found_lock = nullptr;
+  }
 
-    ut_ad(found_lock == nullptr || found_lock->rec_is_nth_bit_set(heap_no));
+  ut_ad(found_lock == nullptr || found_lock->rec_is_nth_bit_set(heap_no));
 
-  } else {
-    found_lock = wait_lock;
-  }
+  return found_lock;
+}
 
-  /* Look at the locks ahead of wait_lock in the lock queue */
+Lock *Lock_sys::deadlock_next_ahead(Lock *wait_lock, Lock *lock, ulint heap_no) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
 
-  for (;;) {
+  if (heap_no == ULINT_UNDEFINED) {
     /* Get previous table lock. */
-    if (heap_no == ULINT_UNDEFINED) {
+    return UT_LIST_GET_PREV(m_table.m_locks, lock);
+  }
 
-      found_lock = UT_LIST_GET_PREV(m_table.m_locks, found_lock);
-    }
+  /* Get the next record lock to check. */
+  do {
+    lock = lock->next();
+  } while (lock != nullptr && lock != wait_lock && !lock->rec_is_nth_bit_set(heap_no));
 
-    if (found_lock == nullptr) {
-      /* We can mark this subtree as searched */
-      trx->m_deadlock_mark = 1;
+  return lock == wait_lock ? nullptr : lock;
+}
 
-      return false;
-    }
+ulint Lock_sys::deadlock_search(Trx *start, Lock *wait_lock) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
 
-    if (wait_lock->has_to_wait_for(found_lock, heap_no)) {
+  ulint cost{1};
+  auto &stack = m_deadlock_stack;
 
-      bool too_far = depth > LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK || *cost > LOCK_MAX_N_STEPS_IN_DEADLOCK_CHECK;
+  stack.clear();
 
-      auto lock_trx = found_lock->m_trx;
+  {
+    ulint heap_no;
+    auto lock = deadlock_first_ahead(wait_lock, heap_no);
 
-      if (lock_trx == start) {
+    stack.push_back({start, wait_lock, lock, heap_no});
+  }
 
-        /* We came back to the recursion starting point: a deadlock detected; or we have searched the waits-for graph too long */
+  while (!stack.empty()) {
+    auto &frame = stack.back();
 
-        log_info("\n*** (1) TRANSACTION:");
+    if (frame.m_lock == nullptr) {
+      /* We can mark this subtree as searched */
+      frame.m_trx->m_deadlock_mark = m_deadlock_epoch;
 
-        log_info(wait_lock->m_trx->to_string(3000));
+      stack.pop_back();
 
-        log_info("*** (1) WAITING FOR THIS LOCK TO BE GRANTED:");
+      continue;
+    }
 
-        log_info(wait_lock->to_string(m_buf_pool));
+    /* Look at the locks ahead of the frame's wait_lock in the lock queue */
 
-        log_info("*** (2) TRANSACTION:");
+    auto found_lock = frame.m_lock;
+    auto cur_wait_lock = frame.m_wait_lock;
 
-        log_info(found_lock->m_trx->to_string(3000));
+    frame.m_lock = deadlock_next_ahead(cur_wait_lock, found_lock, frame.m_heap_no);
 
-        log_info("*** (2) HOLDS THE LOCK(S):");
+    if (!cur_wait_lock->has_to_wait_for(found_lock, frame.m_heap_no)) {
+      continue;
+    }
 
-        log_info(found_lock->to_string(m_buf_pool));
+    const auto depth = stack.size() - 1;
+    bool too_far = depth > LOCK_MAX_DEPTH_IN_DEADLOCK_CHECK || cost > LOCK_MAX_N_STEPS_IN_DEADLOCK_CHECK;
 
-        log_info("*** (2) WAITING FOR THIS LOCK TO BE GRANTED:");
+    auto lock_trx = found_lock->m_trx;
 
-        log_info(wait_lock->to_string(m_buf_pool));
+    if (lock_trx == start) {
 
-        log_info(start->m_wait_lock->to_string(m_buf_pool));
+      /* We came back to the search starting point: a deadlock detected */
 
-        if (Trx::weight_cmp(wait_lock->m_trx, start) >= 0) {
-          /* Our recursion starting point transaction is 'smaller', let us
-          choose 'start' as the victim and roll back it */
+      log_info("\n*** (1) TRANSACTION:");
 
-          return LOCK_VICTIM_IS_START;
-        }
+      log_info(cur_wait_lock->m_trx->to_string(3000));
 
-        lock_deadlock_found = true;
+      log_info("*** (1) WAITING FOR THIS LOCK TO BE GRANTED:");
 
-        /* Let us choose the transaction of wait_lock as a victim to try
-        to avoid deadlocking our recursion starting point transaction */
+      log_info(cur_wait_lock->to_string(m_buf_pool));
 
-        log_info("*** WE ROLL BACK TRANSACTION (1)");
+      log_info("*** (2) TRANSACTION:");
 
-        wait_lock->m_trx->m_was_chosen_as_deadlock_victim = true;
+      log_info(found_lock->m_trx->to_string(3000));
 
-        cancel_waiting_and_release(wait_lock);
+      log_info("*** (2) HOLDS THE LOCK(S):");
 
-        /* Since trx and wait_lock are no longer in the waits-for graph, we can return false;
-        note that our selective algorithm can choose several transactions as victims, but still
-        we may end up rolling back also the recursion starting point transaction! */
+      log_info(found_lock->to_string(m_buf_pool));
 
-        return LOCK_VICTIM_IS_OTHER;
-      }
+      log_info("*** (2) WAITING FOR THIS LOCK TO BE GRANTED:");
+
+      log_info(cur_wait_lock->to_string(m_buf_pool));
 
-      if (too_far) {
+      log_info(start->m_wait_lock->to_string(m_buf_pool));
 
-        /* The information about transaction/lock to be rolled back is available in the top
-        level. Do not print anything here. */
-        return LOCK_EXCEED_MAX_DEPTH;
+      if (Trx::weight_cmp(cur_wait_lock->m_trx, start) >= 0) {
+        /* Our search starting point transaction is 'smaller', let us
+        choose 'start' as the victim and roll back it */
+
+        return LOCK_VICTIM_IS_START;
       }
 
-      if (lock_trx->m_que_state == TRX_QUE_LOCK_WAIT) {
+      lock_deadlock_found = true;
 
-        /* Another trx ahead has requested lock	in an incompatible mode, and is itself waiting for a lock */
+      /* Let us choose the transaction of wait_lock as a victim to try
+      to avoid deadlocking our search starting point transaction */
 
-        ret = deadlock_recursive(start, lock_trx, lock_trx->m_wait_lock, cost, depth + 1);
+      log_info("*** WE ROLL BACK TRANSACTION (1)");
 
-        if (ret != 0) {
+      cur_wait_lock->m_trx->m_was_chosen_as_deadlock_victim = true;
 
-          return ret;
-        }
-      }
+      cancel_waiting_and_release(cur_wait_lock);
+
+      /* Since trx and wait_lock are no longer in the waits-for graph, the search
+      has to be restarted; note that our selective algorithm can choose several
+      transactions as victims, but still we may end up rolling back also the
+      search starting point transaction! */
+
+      return LOCK_VICTIM_IS_OTHER;
     }
-    /* Get the next record lock to check. */
-    if (heap_no != ULINT_UNDEFINED) {
 
-      ut_a(found_lock != nullptr);
+    if (too_far) {
 
-      do {
-        found_lock = found_lock->next();
-      } while (found_lock != nullptr && found_lock != wait_lock && !found_lock->rec_is_nth_bit_set(heap_no));
+      /* The information about transaction/lock to be rolled back is available in the top
+      level. Do not print anything here. */
+      return LOCK_EXCEED_MAX_DEPTH;
+    }
 
-      if (found_lock == wait_lock) {
-        found_lock = nullptr;
-      }
+    if (lock_trx->m_que_state == TRX_QUE_LOCK_WAIT && lock_trx->m_deadlock_mark != m_deadlock_epoch) {
+
+      /* Another trx ahead has requested lock in an incompatible mode, and is itself waiting for a lock */
+
+      ++cost;
+
+      ulint heap_no;
+      auto lock = deadlock_first_ahead(lock_trx->m_wait_lock, heap_no);
+
+      /* Note: frame is invalidated by the push. */
+      stack.push_back({lock_trx, lock_trx->m_wait_lock, lock, heap_no});
     }
-  } /* end of the 'for (;;)'-loop */
+  }
+
+  return 0;
 }
 
 Lock *Lock_sys::table_create(Table *table, Lock_mode type_mode, Trx *trx) noexcept {
   ut_ad(mutex_own(&kernel_mutex));
 
-  auto lock = reinterpret_cast<Lock *>(mem_heap_alloc(trx->m_lock_heap, sizeof(Lock)));
+  auto lock = lock_alloc(trx, 0);
 
   trx->m_trx_locks.push_back(lock);
 
@@ -2128,6 +2302,8 @@ void Lock_sys::table_remove_low(Lock *lock) noexcept {
 
   trx->m_trx_locks.remove(lock);
   table->m_locks.remove(lock);
+
+  lock_free(lock);
 }
 
 [[nodiscard]] db_err Lock_sys::table_enqueue_waiting(Lock_mode mode, Table *table, que_thr_t *thr) noexcept {
@@ -2325,12 +2501,7 @@ void Lock_sys::rec_unlock(Trx *trx, const Buf_block *block, const rec_t *rec, Lo
   }
 
   /* Check if we can now grant waiting lock requests */
-  for (auto lock : it->second) {
-    if (lock->rec_is_nth_bit_set(heap_no) && lock->is_waiting() && !rec_has_to_wait_in_queue(it->second, lock, heap_no)) {
-      /* Grant the lock */
-      grant(lock);
-    }
-  }
+  rec_grant_waiting(it->second, heap_no);
 
   mutex_exit(&kernel_mutex);
 }
@@ -2371,6 +2542,15 @@ void Lock_sys::release_off_kernel(Trx *trx) noexcept {
   }
 
   mem_heap_empty(trx->m_lock_heap);
+
+  trx->m_lock_pool.clear();
+
+  /* Any of the cancelled lock requests may succeed now. */
+  for (auto &wake : m_release_waiters) {
+    wake();
+  }
+
+  m_release_waiters.clear();
 }
 
 void Lock_sys::cancel_waiting_and_release(Lock *lock) noexcept {
@@ -3040,13 +3220,23 @@ db_err Lock_sys::clust_rec_modify_check_and_lock(ulint flags, const Buf_block *b
 
   const auto heap_no = rec_get_heap_no(rec);
 
+  /* A transaction whose id is below the smallest active id cannot
+  hold an implicit lock, check that before taking the kernel mutex. */
+  const auto may_have_impl = !m_trx_sys->cannot_be_active(row_get_rec_trx_id(rec, index, offsets));
+
+  if (!may_have_impl && rec_modify_check_fast(block)) {
+    return DB_SUCCESS;
+  }
+
   mutex_enter(&kernel_mutex);
 
   ut_ad(table_has(thr_get_trx(thr), index->m_table, LOCK_IX));
 
   /* If a transaction has no explicit x-lock set on the record, set one for it */
 
-  rec_convert_impl_to_expl(block, rec, index, offsets);
+  if (may_have_impl) {
+    rec_convert_impl_to_expl(block, rec, index, offsets);
+  }
 
   auto err = rec_lock(true, Lock_mode(LOCK_X | LOCK_REC_NOT_GAP), block, heap_no, index, thr);
 
@@ -3071,13 +3261,19 @@ db_err Lock_sys::sec_rec_modify_check_and_lock(ulint flags, Buf_block *block, co
   /* Another transaction cannot have an implicit lock on the record, because when we come here, we already have modified the clustered
   index record, and this would not have been possible if another active transaction had modified this secondary index record. */
 
-  mutex_enter(&kernel_mutex);
+  db_err err;
 
-  ut_ad(table_has(thr_get_trx(thr), index->m_table, LOCK_IX));
+  if (rec_modify_check_fast(block)) {
+    err = DB_SUCCESS;
+  } else {
+    mutex_enter(&kernel_mutex);
 
-  auto err = rec_lock(true, Lock_mode(LOCK_X | LOCK_REC_NOT_GAP), block, heap_no, index, thr);
+    ut_ad(table_has(thr_get_trx(thr), index->m_table, LOCK_IX));
 
-  mutex_exit(&kernel_mutex);
+    err = rec_lock(true, Lock_mode(LOCK_X | LOCK_REC_NOT_GAP), block, heap_no, index, thr);
+
+    mutex_exit(&kernel_mutex);
+  }
 
 #ifdef UNIV_DEBUG
   {
@@ -3122,16 +3318,20 @@ db_err Lock_sys::sec_rec_read_check_and_lock(ulint flags, const Buf_block *block
 
   const auto heap_no = page_rec_get_heap_no(rec);
 
+  /* Some transaction may have an implicit x-lock on the record only
+  if the max trx id for the page >= min trx id for the trx list or a
+  database recovery is running. The page is latched, the check does
+  not need the kernel mutex. */
+
+  const auto may_have_impl =
+    !page_rec_is_supremum(rec) && (recv_recovery_on || !m_trx_sys->cannot_be_active(page_get_max_trx_id(block->m_frame)));
+
   mutex_enter(&kernel_mutex);
 
   ut_ad(mode != LOCK_X || table_has(thr_get_trx(thr), index->m_table, LOCK_IX));
   ut_ad(mode != LOCK_S || table_has(thr_get_trx(thr), index->m_table, LOCK_IS));
 
-  /* Some transaction may have an implicit x-lock on the record only
-  if the max trx id for the page >= min trx id for the trx list or a
-  database recovery is running. */
-
-  if ((page_get_max_trx_id(block->m_frame) >= m_trx_sys->get_min_trx_id() || recv_recovery_on) && !page_rec_is_supremum(rec)) {
+  if (may_have_impl) {
 
     rec_convert_impl_to_expl(block, rec, index, offsets);
   }
@@ -3159,12 +3359,17 @@ db_err Lock_sys::clust_rec_read_check_and_lock(ulint flags, const Buf_block *blo
 
   const auto heap_no = page_rec_get_heap_no(rec);
 
+  /* A transaction whose id is below the smallest active id cannot
+  hold an implicit lock, check that before taking the kernel mutex. */
+  const auto may_have_impl =
+    likely(heap_no != PAGE_HEAP_NO_SUPREMUM) && !m_trx_sys->cannot_be_active(row_get_rec_trx_id(rec, index, offsets));
+
   mutex_enter(&kernel_mutex);
 
   ut_ad(mode != LOCK_X || table_has(thr_get_trx(thr), index->m_table, LOCK_IX));
   ut_ad(mode != LOCK_S || table_has(thr_get_trx(thr), index->m_table, LOCK_IS));
 
-  if (likely(heap_no != PAGE_HEAP_NO_SUPREMUM)) {
+  if (may_have_impl) {
 
     rec_convert_impl_to_expl(block, rec, index, offsets);
   }
@@ -0,0 +1,463 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file log/log0arch.cc
+Redo log archiving and reading the parsed log records from an lsn
+*******************************************************/
+
+#include "log0arch.h"
+#include "log0log.h"
+#include "log0recv.h"
+#include "srv0srv.h"
+#include "ut0byte.h"
+
+#include <charconv>
+#include <filesystem>
+
+Log_archiver *srv_log_arch{};
+
+Log_archiver::Log_archiver(const char *dir, ulint max_file_size) noexcept
+  : m_dir(dir),
+    m_max_file_size(max_file_size) {
+
+  mutex_create(&m_mutex, IF_DEBUG("log_arch_mutex",) IF_SYNC_DEBUG(SYNC_ANY_LATCH,) Current_location());
+
+  m_buf_ptr = static_cast<byte *>(ut_new(COPY_SIZE + UNIV_PAGE_SIZE));
+
+  if (m_buf_ptr != nullptr) {
+    m_buf = static_cast<byte *>(ut_align(m_buf_ptr, UNIV_PAGE_SIZE));
+  }
+}
+
+Log_archiver::~Log_archiver() noexcept {
+  if (m_file != -1) {
+    (void) os_file_flush(m_file);
+    (void) os_file_close(m_file);
+  }
+
+  if (m_buf_ptr != nullptr) {
+    ut_delete(m_buf_ptr);
+  }
+
+  mutex_free(&m_mutex);
+}
+
+bool Log_archiver::is_enabled() noexcept {
+  const auto dir = srv_config.m_log_archive_dir;
+
+  return dir != nullptr && *dir != '\0';
+}
+
+Log_archiver *Log_archiver::create() noexcept {
+  ut_a(is_enabled());
+
+  const auto dir = srv_config.m_log_archive_dir;
+
+  if (!os_file_create_directory(dir, false)) {
+    log_err(std::format("Cannot create the log archive directory {}", dir));
+    return nullptr;
+  }
+
+  const auto group = UT_LIST_GET_FIRST(log_sys->m_log_groups);
+  auto ptr = ut_new(sizeof(Log_archiver));
+
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+
+  auto log_arch = new (ptr) Log_archiver(dir, group->file_size - LOG_FILE_HDR_SIZE);
+
+  if (log_arch->m_buf_ptr == nullptr) {
+    destroy(log_arch);
+    return nullptr;
+  }
+
+  log_arch->scan_dir();
+
+  /* The log files hold the log from the block of the last checkpoint on. */
+  const auto start_lsn = ut_uint64_align_down(log_sys->m_last_checkpoint_lsn.load(), IB_FILE_BLOCK_SIZE);
+
+  mutex_enter(&log_arch->m_mutex);
+
+  const auto success = log_arch->open_file(start_lsn);
+
+  log_arch->m_archived_lsn.store(start_lsn, std::memory_order_release);
+
+  mutex_exit(&log_arch->m_mutex);
+
+  if (!success) {
+    destroy(log_arch);
+    return nullptr;
+  }
+
+  log_info(std::format("Archiving the log to {} from lsn {}", dir, start_lsn));
+
+  return log_arch;
+}
+
+void Log_archiver::destroy(Log_archiver *&log_arch) noexcept {
+  call_destructor(log_arch);
+  ut_delete(log_arch);
+  log_arch = nullptr;
+}
+
+std::string Log_archiver::file_path(lsn_t start_lsn) const noexcept {
+  return (std::filesystem::path(m_dir) / std::format("{}{:020}", FILE_PREFIX, start_lsn)).string();
+}
+
+void Log_archiver::scan_dir() noexcept {
+  namespace fs = std::filesystem;
+
+  std::error_code ec;
+  const std::string_view prefix{FILE_PREFIX};
+
+  for (const auto &entry : fs::directory_iterator(m_dir, ec)) {
+    const auto name = entry.path().filename().string();
+
+    if (!entry.is_regular_file(ec) || !name.starts_with(prefix)) {
+      continue;
+    }
+
+    lsn_t start_lsn{};
+    const auto last = name.data() + name.size();
+
+    if (std::from_chars(name.data() + prefix.size(), last, start_lsn).ptr != last) {
+      continue;
+    }
+
+    const auto size = entry.file_size(ec);
+
+    if (!ec) {
+      m_files[start_lsn] = File{entry.path().string(), start_lsn + ut_uint64_align_down(size, IB_FILE_BLOCK_SIZE)};
+    }
+  }
+}
+
+bool Log_archiver::open_file(lsn_t start_lsn) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (m_file != -1) {
+    if (!os_file_flush(m_file)) {
+      log_fatal(std::format("Flushing the log archive file {} failed", m_files[m_file_start_lsn].m_path));
+    }
+
+    (void) os_file_close(m_file);
+
+    m_file = -1;
+  }
+
+  auto path = file_path(start_lsn);
+
+  bool success;
+  auto file = os_file_create(path.c_str(), OS_FILE_OVERWRITE, OS_FILE_NORMAL, OS_DATA_FILE, &success);
+
+  if (!success) {
+    log_err(std::format("Cannot create the log archive file {}", path));
+    return false;
+  }
+
+  m_file = file;
+  m_file_start_lsn = start_lsn;
+
+  /* A file of an earlier run that starts at the same lsn is overwritten with
+  the same log. */
+  m_files[start_lsn] = File{std::move(path), start_lsn};
+
+  return true;
+}
+
+void Log_archiver::archive(lsn_t lsn) noexcept {
+  ut_ad(!mutex_own(&log_sys->m_mutex));
+
+  /* The last block can still be written to, it is archived when it is
+  complete. It is not overwritten before the next checkpoint. */
+  const auto end_lsn = ut_uint64_align_down(lsn, IB_FILE_BLOCK_SIZE);
+  const auto group = UT_LIST_GET_FIRST(log_sys->m_log_groups);
+
+  mutex_enter(&m_mutex);
+
+  auto archived_lsn = m_archived_lsn.load(std::memory_order_relaxed);
+
+  if (archived_lsn >= end_lsn) {
+    mutex_exit(&m_mutex);
+    return;
+  }
+
+  while (archived_lsn < end_lsn) {
+    if (archived_lsn - m_file_start_lsn >= m_max_file_size && !open_file(archived_lsn)) {
+      log_fatal("Cannot continue without archiving the log");
+    }
+
+    const auto len = ulint(std::min<lsn_t>(end_lsn - archived_lsn, COPY_SIZE));
+
+    /* The log from the archived lsn on is not overwritten, the checkpoint
+    cannot move past it before this returns. */
+    log_sys->acquire();
+
+    log_sys->group_read_log_seg(LOG_RECOVER, m_buf, group, archived_lsn, archived_lsn + len);
+
+    log_sys->release();
+
+    auto &file = m_files[m_file_start_lsn];
+
+    if (!os_file_write(file.m_path.c_str(), m_file, m_buf, len, off_t(archived_lsn - m_file_start_lsn))) {
+      log_fatal(std::format("Writing to the log archive file {} failed", file.m_path));
+    }
+
+    archived_lsn += len;
+
+    file.m_end_lsn = archived_lsn;
+  }
+
+  if (!os_file_flush(m_file)) {
+    log_fatal(std::format("Flushing the log archive file {} failed", m_files[m_file_start_lsn].m_path));
+  }
+
+  m_archived_lsn.store(archived_lsn, std::memory_order_release);
+
+  mutex_exit(&m_mutex);
+}
+
+ulint Log_archiver::read(lsn_t start_lsn, byte *buf, ulint len) noexcept {
+  ut_ad(start_lsn % IB_FILE_BLOCK_SIZE == 0);
+  ut_ad(len % IB_FILE_BLOCK_SIZE == 0);
+
+  mutex_enter(&m_mutex);
+
+  /* The latest file that starts at or before start_lsn. */
+  auto it = m_files.upper_bound(start_lsn);
+
+  if (it == m_files.begin() || start_lsn >= (--it)->second.m_end_lsn) {
+    mutex_exit(&m_mutex);
+    return 0;
+  }
+
+  const auto file_start_lsn = it->first;
+  const auto off = off_t(start_lsn - file_start_lsn);
+
+  len = ulint(std::min<lsn_t>(len, it->second.m_end_lsn - start_lsn));
+
+  bool success;
+
+  if (file_start_lsn == m_file_start_lsn) {
+    /* The current file, it is closed by archive() when it is full. */
+    success = os_file_read(m_file, buf, len, off);
+
+    mutex_exit(&m_mutex);
+  } else {
+    const auto path = it->second.m_path;
+
+    mutex_exit(&m_mutex);
+
+    auto file = os_file_create_simple(path.c_str(), OS_FILE_OPEN, OS_FILE_READ_ONLY, &success);
+
+    if (success) {
+      success = os_file_read(file, buf, len, off);
+
+      (void) os_file_close(file);
+    }
+  }
+
+  return success ? len : 0;
+}
+
+Log_stream::Log_stream(lsn_t start_lsn) noexcept
+  : m_lsn(start_lsn),
+    m_read_lsn(start_lsn) {
+
+  m_buf_ptr = static_cast<byte *>(ut_new(READ_SIZE + UNIV_PAGE_SIZE));
+
+  if (m_buf_ptr != nullptr) {
+    m_buf = static_cast<byte *>(ut_align(m_buf_ptr, UNIV_PAGE_SIZE));
+  }
+}
+
+Log_stream::~Log_stream() noexcept {
+  if (m_buf_ptr != nullptr) {
+    ut_delete(m_buf_ptr);
+  }
+}
+
+db_err Log_stream::create(lsn_t start_lsn, Log_stream *&stream) noexcept {
+  stream = nullptr;
+
+  if (start_lsn == 0) {
+    /* The oldest modification, the start of a mini-transaction. */
+    start_lsn = log_sys->m_last_checkpoint_lsn.load();
+  }
+
+  /* An lsn never points to a log block header or trailer. */
+  const auto offset = ulint(start_lsn % IB_FILE_BLOCK_SIZE);
+
+  if (start_lsn < LOG_START_LSN || offset < LOG_BLOCK_HDR_SIZE || offset >= IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+    return DB_INVALID_INPUT;
+  }
+
+  auto ptr = ut_new(sizeof(Log_stream));
+
+  if (ptr == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  stream = new (ptr) Log_stream(start_lsn);
+
+  if (stream->m_buf_ptr == nullptr) {
+    destroy(stream);
+    return DB_OUT_OF_MEMORY;
+  }
+
+  return DB_SUCCESS;
+}
+
+void Log_stream::destroy(Log_stream *&stream) noexcept {
+  call_destructor(stream);
+  ut_delete(stream);
+  stream = nullptr;
+}
+
+db_err Log_stream::next(Record &rec) noexcept {
+  for (;;) {
+    if (m_pos < m_data.size()) {
+      auto ptr = m_data.data() + m_pos;
+      const auto single_rec = (*ptr & MLOG_SINGLE_REC_FLAG) != 0;
+
+      byte *body;
+      page_no_t page_no{};
+      space_id_t space{};
+      mlog_type_t type{MLOG_UNKNOWN};
+
+      const auto len = recv_parse_log_rec(ptr, m_data.data() + m_data.size(), &type, &space, &page_no, &body);
+
+      if (len > 0) {
+        rec.m_lsn = m_lsn;
+        rec.m_end_lsn = recv_calc_lsn_on_data_add(m_lsn, len);
+        rec.m_type = type;
+        rec.m_space = space;
+        rec.m_page_no = page_no;
+        rec.m_body = body;
+        rec.m_body_len = body == nullptr ? 0 : ulint(ptr + len - body);
+        rec.m_mtr_end = single_rec || type == MLOG_MULTI_REC_END || type == MLOG_DUMMY_RECORD;
+
+        m_pos += len;
+        m_lsn = rec.m_end_lsn;
+
+        return DB_SUCCESS;
+      }
+    }
+
+    const auto limit_lsn = log_sys->m_flushed_to_disk_lsn.load(std::memory_order_acquire);
+
+    if (m_read_lsn >= limit_lsn) {
+      /* A log write ends at the end of a mini-transaction, a record that is
+      incomplete at the flushed lsn is corrupt. */
+      return m_pos == m_data.size() ? DB_END_OF_INDEX : DB_CORRUPTION;
+    }
+
+    m_data.erase(m_data.begin(), m_data.begin() + m_pos);
+    m_pos = 0;
+
+    const auto read_lsn = m_read_lsn;
+
+    if (auto err = fill(limit_lsn); err != DB_SUCCESS) {
+      return err;
+    } else if (m_read_lsn == read_lsn) {
+      log_err(std::format("The log block at lsn {} ends before the flushed lsn {}", read_lsn, limit_lsn));
+      return DB_CORRUPTION;
+    }
+  }
+}
+
+ulint Log_stream::read_log_files(lsn_t start_lsn, byte *buf, ulint len) noexcept {
+  log_sys->acquire();
+
+  /* The log files hold the log from the block of the last checkpoint on, the
+  log is written with the log mutex held. */
+  if (start_lsn < ut_uint64_align_down(log_sys->m_last_checkpoint_lsn.load(), IB_FILE_BLOCK_SIZE)) {
+    log_sys->release();
+    return 0;
+  }
+
+  log_sys->group_read_log_seg(LOG_RECOVER, buf, UT_LIST_GET_FIRST(log_sys->m_log_groups), start_lsn, start_lsn + len);
+
+  log_sys->release();
+
+  return len;
+}
+
+ulint Log_stream::read_blocks(lsn_t start_lsn, byte *buf, ulint len) noexcept {
+  ulint n{};
+
+  /* Prefer the archive, reading the log files needs the log mutex. */
+  if (srv_log_arch != nullptr && start_lsn < srv_log_arch->get_archived_lsn()) {
+    n = srv_log_arch->read(start_lsn, buf, len);
+  }
+
+  if (n == 0) {
+    n = read_log_files(start_lsn, buf, len);
+  }
+
+  return n;
+}
+
+db_err Log_stream::fill(lsn_t limit_lsn) noexcept {
+  ut_ad(m_read_lsn < limit_lsn);
+
+  const auto start_lsn = ut_uint64_align_down(m_read_lsn, IB_FILE_BLOCK_SIZE);
+  const auto end_lsn = std::min<lsn_t>(ut_uint64_align_up(limit_lsn, IB_FILE_BLOCK_SIZE), start_lsn + READ_SIZE);
+  const auto len = ulint(end_lsn - start_lsn);
+
+  const auto n = read_blocks(start_lsn, m_buf, len);
+
+  if (n == 0) {
+    return DB_MISSING_HISTORY;
+  }
+
+  for (ulint i{}; i < n; i += IB_FILE_BLOCK_SIZE) {
+    const auto block = m_buf + i;
+    const auto block_lsn = start_lsn + i;
+
+    if (Log::block_get_hdr_no(block) != Log::block_convert_lsn_to_no(block_lsn) ||
+        !Log::is_block_checksum_ok(block)) {
+      log_err(std::format("The log block at lsn {} is corrupt", block_lsn));
+      return DB_CORRUPTION;
+    }
+
+    const auto from = ulint(m_read_lsn - block_lsn);
+    auto to = std::min(Log::block_get_data_len(block), IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE);
+
+    if (limit_lsn < block_lsn + to) {
+      to = ulint(limit_lsn - block_lsn);
+    }
+
+    if (to < from) {
+      log_err(std::format("The log block at lsn {} is shorter than expected", block_lsn));
+      return DB_CORRUPTION;
+    }
+
+    m_data.insert(m_data.end(), block + from, block + to);
+
+    if (to < IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+      /* The block is not complete, it is read again on the next call. */
+      m_read_lsn = block_lsn + to;
+      break;
+    }
+
+    m_read_lsn = block_lsn + IB_FILE_BLOCK_SIZE + LOG_BLOCK_HDR_SIZE;
+  }
+
+  return DB_SUCCESS;
+}
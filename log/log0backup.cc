@@ -0,0 +1,330 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file log/log0backup.cc
+Online backup of the data files and the log
+*******************************************************/
+
+#include "log0backup.h"
+#include "buf0buf.h"
+#include "log0arch.h"
+#include "log0log.h"
+#include "ut0byte.h"
+#include "ut0rnd.h"
+
+#include <algorithm>
+#include <thread>
+
+static_assert(Backup::LOG_READ_SIZE >= UNIV_PAGE_SIZE, "The buffer must hold a page");
+
+Backup::Backup(Fil *fil, Sink sink, lsn_t since_lsn, ulint max_pages_per_sec) noexcept
+  : m_fil(fil),
+    m_sink(std::move(sink)),
+    m_since_lsn(since_lsn),
+    m_max_pages_per_sec(max_pages_per_sec) {
+
+  m_buf_ptr = static_cast<byte *>(ut_new(LOG_READ_SIZE + UNIV_PAGE_SIZE));
+
+  if (m_buf_ptr != nullptr) {
+    m_buf = static_cast<byte *>(ut_align(m_buf_ptr, UNIV_PAGE_SIZE));
+  }
+}
+
+Backup::~Backup() noexcept {
+  if (m_buf_ptr != nullptr) {
+    ut_delete(m_buf_ptr);
+  }
+}
+
+db_err Backup::run() noexcept {
+  if (m_buf == nullptr) {
+    return DB_OUT_OF_MEMORY;
+  }
+
+  const auto group = UT_LIST_GET_FIRST(log_sys->m_log_groups);
+
+  for (const auto &space : m_fil->get_space_files(FIL_LOG)) {
+    if (space.m_id == group->space_id) {
+      for (const auto &[path, page_no] : space.m_files) {
+        m_log_files.push_back(path);
+      }
+    }
+  }
+
+  /* The files past the group are left over by a resize of the group that
+was interrupted, see Log::resize_files(). */
+  ut_a(m_log_files.size() >= group->n_files);
+
+  m_log_files.resize(group->n_files);
+
+  m_log_file_size = group->file_size;
+
+  log_sys->acquire();
+
+  /* The pages have all the modifications before the last checkpoint, the
+  log from it on is in the log files until the next checkpoint. */
+  m_start_lsn = log_sys->m_last_checkpoint_lsn.load();
+  m_checkpoint_no = log_sys->m_next_checkpoint_no > 0 ? log_sys->m_next_checkpoint_no - 1 : 0;
+
+  log_sys->release();
+
+  m_log_start_lsn = ut_uint64_align_down(m_start_lsn, IB_FILE_BLOCK_SIZE);
+  m_log_copied_lsn = m_log_start_lsn;
+
+  auto err = write_log_headers();
+
+  if (err == DB_SUCCESS) {
+    err = copy_log(log_sys->m_flushed_to_disk_lsn.load());
+  }
+
+  if (err != DB_SUCCESS) {
+    return err;
+  }
+
+  m_throttle_start = std::chrono::steady_clock::now();
+
+  /* A tablespace that is created after this is created by the recovery,
+  from the log. */
+  for (const auto &space : m_fil->get_space_files(FIL_TABLESPACE)) {
+    if (err = copy_space(space); err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  /* A page is written after the log of its modifications, the log flushed
+  now covers the modifications of all the pages that were copied. */
+  log_sys->buffer_flush_to_disk();
+
+  m_end_lsn = log_sys->m_flushed_to_disk_lsn.load();
+
+  if (err = copy_log(m_end_lsn); err != DB_SUCCESS) {
+    return err;
+  }
+
+  /* The recovery stops at the first block that is not valid. The file can
+  be written over an earlier backup, its log must not follow. */
+  const auto next_lsn = ut_uint64_align_up(m_end_lsn, IB_FILE_BLOCK_SIZE);
+
+  if (next_lsn - m_log_start_lsn < m_log_files.size() * (m_log_file_size - LOG_FILE_HDR_SIZE)) {
+    memset(m_buf, 0x0, IB_FILE_BLOCK_SIZE);
+
+    if (err = write_log(next_lsn, m_buf, IB_FILE_BLOCK_SIZE); err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  log_info(std::format(
+    "Backup from lsn {} to lsn {} done, {} pages copied of {} read", m_start_lsn, m_end_lsn, m_n_pages, m_n_pages_read
+  ));
+
+  return DB_SUCCESS;
+}
+
+db_err Backup::copy_space(const Fil::Space_files &space) noexcept {
+  const auto &files = space.m_files;
+  page_no_t size{};
+
+  for (page_no_t page_no{};; ++page_no) {
+    if (page_no >= size) {
+      /* The space can be extended while it is copied. */
+      size = page_no_t(m_fil->space_get_size(space.m_id));
+
+      if (page_no >= size) {
+        break;
+      }
+    }
+
+    if (m_n_pages_read > 0 && m_n_pages_read % LOG_COPY_INTERVAL == 0) {
+      if (auto err = copy_log(log_sys->m_flushed_to_disk_lsn.load()); err != DB_SUCCESS) {
+        return err;
+      }
+    }
+
+    throttle();
+
+    if (auto err = read_page(space.m_id, page_no); err == DB_TABLESPACE_DELETED) {
+      /* The recovery deletes it again. */
+      return DB_SUCCESS;
+    } else if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    /* The file that the page is in. */
+    auto next = std::upper_bound(files.begin(), files.end(), page_no, [](page_no_t no, const auto &file) {
+      return no < file.second;
+    });
+
+    ut_a(next != files.begin());
+
+    const auto &[path, first_page_no] = *std::prev(next);
+    const auto last_page_no = next == files.end() ? size - 1 : next->second - 1;
+
+    if (m_since_lsn > 0 && page_no != last_page_no && mach_read_from_8(m_buf + FIL_PAGE_LSN) <= m_since_lsn) {
+      continue;
+    }
+
+    const auto offset = uint64_t(page_no - first_page_no) * UNIV_PAGE_SIZE;
+
+    if (auto err = m_sink(path.c_str(), offset, m_buf, UNIV_PAGE_SIZE); err != DB_SUCCESS) {
+      return err;
+    }
+
+    ++m_n_pages;
+  }
+
+  return DB_SUCCESS;
+}
+
+db_err Backup::read_page(space_id_t space_id, page_no_t page_no) noexcept {
+  for (ulint i{}; i < MAX_PAGE_READS; ++i) {
+    if (i > 0) {
+      /* The page was read while it was being written. */
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (auto err = m_fil->io(IO_request::Sync_read, false, space_id, page_no, 0, UNIV_PAGE_SIZE, m_buf, nullptr);
+        err != DB_SUCCESS) {
+      return err;
+    }
+
+    ++m_n_pages_read;
+
+    Fil::decompress_page(m_buf);
+
+    if (!Buf_pool::is_corrupted(m_buf)) {
+      return DB_SUCCESS;
+    }
+  }
+
+  log_err(std::format("Page {} of space {} is corrupt, cannot back it up", page_no, space_id));
+
+  return DB_CORRUPTION;
+}
+
+db_err Backup::write_log_headers() noexcept {
+  const auto group = UT_LIST_GET_FIRST(log_sys->m_log_groups);
+
+  /* The log file headers and a block of zeros to extend the file to its size. */
+  memset(m_buf, 0x0, LOG_FILE_HDR_SIZE + IB_FILE_BLOCK_SIZE);
+
+  for (ulint i{}; i < m_log_files.size(); ++i) {
+    mach_write_to_4(m_buf + LOG_GROUP_ID, group->id);
+    mach_write_to_8(m_buf + LOG_FILE_START_LSN, m_log_start_lsn + i * (m_log_file_size - LOG_FILE_HDR_SIZE));
+    memcpy(m_buf + LOG_FILE_WAS_CREATED_BY_HOT_BACKUP, "    ", 4);
+
+    if (i == 0) {
+      /* The recovery starts at the checkpoint, it is written to both
+      checkpoint fields, see Log::group_checkpoint(). */
+      auto buf = m_buf + LOG_CHECKPOINT_1;
+
+      mach_write_to_8(buf + LOG_CHECKPOINT_NO, m_checkpoint_no);
+      mach_write_to_8(buf + LOG_CHECKPOINT_LSN, m_start_lsn);
+      mach_write_to_4(buf + LOG_CHECKPOINT_OFFSET, ulint(LOG_FILE_HDR_SIZE + (m_start_lsn - m_log_start_lsn)));
+      mach_write_to_4(buf + LOG_CHECKPOINT_LOG_BUF_SIZE, log_sys->m_buf_size.load());
+      mach_write_to_8(buf + LOG_CHECKPOINT_UNUSED_LSN, IB_UINT64_T_MAX);
+
+      auto fold = ut_fold_binary(buf, LOG_CHECKPOINT_CHECKSUM_1);
+      mach_write_to_4(buf + LOG_CHECKPOINT_CHECKSUM_1, fold);
+
+      fold = ut_fold_binary(buf + LOG_CHECKPOINT_LSN, LOG_CHECKPOINT_CHECKSUM_2 - LOG_CHECKPOINT_LSN);
+      mach_write_to_4(buf + LOG_CHECKPOINT_CHECKSUM_2, fold);
+
+      mach_write_to_4(buf + LOG_CHECKPOINT_FSP_MAGIC_N, LOG_CHECKPOINT_FSP_MAGIC_N_VAL);
+
+      memcpy(m_buf + LOG_CHECKPOINT_2, buf, IB_FILE_BLOCK_SIZE);
+    } else {
+      memset(m_buf + IB_FILE_BLOCK_SIZE, 0x0, LOG_FILE_HDR_SIZE - IB_FILE_BLOCK_SIZE);
+    }
+
+    const auto path = m_log_files[i].c_str();
+    auto err = m_sink(path, 0, m_buf, LOG_FILE_HDR_SIZE);
+
+    if (err == DB_SUCCESS) {
+      err = m_sink(path, m_log_file_size - IB_FILE_BLOCK_SIZE, m_buf + LOG_FILE_HDR_SIZE, IB_FILE_BLOCK_SIZE);
+    }
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+  }
+
+  return DB_SUCCESS;
+}
+
+db_err Backup::copy_log(lsn_t lsn) noexcept {
+  while (m_log_copied_lsn < lsn) {
+    const auto end_lsn = std::min<lsn_t>(ut_uint64_align_up(lsn, IB_FILE_BLOCK_SIZE), m_log_copied_lsn + LOG_READ_SIZE);
+    const auto n = Log_stream::read_blocks(m_log_copied_lsn, m_buf, ulint(end_lsn - m_log_copied_lsn));
+
+    if (n == 0) {
+      log_err(std::format(
+        "The log at lsn {} was overwritten before the backup copied it, set log_archive_dir"
+        " or use larger log files",
+        m_log_copied_lsn
+      ));
+      return DB_MISSING_HISTORY;
+    }
+
+    if (auto err = write_log(m_log_copied_lsn, m_buf, n); err != DB_SUCCESS) {
+      return err;
+    }
+
+    m_log_copied_lsn += n;
+  }
+
+  /* The last block is copied again when more of it has been written. */
+  m_log_copied_lsn = std::min(m_log_copied_lsn, ut_uint64_align_down(lsn, IB_FILE_BLOCK_SIZE));
+
+  return DB_SUCCESS;
+}
+
+db_err Backup::write_log(lsn_t lsn, const byte *data, ulint len) noexcept {
+  const auto file_capacity = m_log_file_size - LOG_FILE_HDR_SIZE;
+  auto pos = lsn - m_log_start_lsn;
+
+  if (pos + len > m_log_files.size() * file_capacity) {
+    log_err(std::format(
+      "The log written during the backup, from lsn {}, does not fit in the log files, use larger log files",
+      m_start_lsn
+    ));
+    return DB_OUT_OF_FILE_SPACE;
+  }
+
+  while (len > 0) {
+    const auto file_no = ulint(pos / file_capacity);
+    const auto offset = LOG_FILE_HDR_SIZE + ulint(pos % file_capacity);
+    const auto n = std::min(len, m_log_file_size - offset);
+
+    if (auto err = m_sink(m_log_files[file_no].c_str(), offset, data, n); err != DB_SUCCESS) {
+      return err;
+    }
+
+    pos += n;
+    data += n;
+    len -= n;
+  }
+
+  return DB_SUCCESS;
+}
+
+void Backup::throttle() noexcept {
+  if (m_max_pages_per_sec > 0) {
+    std::this_thread::sleep_until(
+      m_throttle_start + std::chrono::microseconds(m_n_pages_read * 1000000 / m_max_pages_per_sec)
+    );
+  }
+}
@@ -34,11 +34,22 @@ Created 12/9/1995 Heikki Tuuri
 #include "buf0flu.h"
 #include "dict0store.h"
 #include "fil0fil.h"
+#include "log0arch.h"
 #include "log0recv.h"
 #include "mem0mem.h"
+#include "mtr0mtr.h"
+#include "os0sync.h"
+#include "os0thread-create.h"
 #include "srv0srv.h"
 #include "sync0rw.h"
 #include "trx0sys.h"
+#include "ut0probe.h"
+#include "ut0wait.h"
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
 
 /*
 General philosophy of InnoDB redo-logs:
@@ -87,6 +98,18 @@ constexpr ulint LOG_BUF_WRITE_MARGIN = 4 * IB_FILE_BLOCK_SIZE;
 constexpr ulint LOG_BUF_FLUSH_RATIO = 2;
 constexpr ulint LOG_BUF_FLUSH_MARGIN = LOG_BUF_WRITE_MARGIN + 4 * UNIV_PAGE_SIZE;
 
+/** The log buffer is not resized below this, it leaves room for
+LOG_BUF_FLUSH_MARGIN, see Log::m_max_buf_free. */
+constexpr ulint LOG_BUF_MIN_SIZE = 16 * UNIV_PAGE_SIZE;
+
+/** A grown log buffer is shrunk after the log has been generated at less
+than its configured size per second for this many seconds. */
+constexpr double LOG_BUF_SHRINK_IDLE_SECS = 60;
+
+/** Number of checkpoints Log::resize_files() makes to get the log after the
+checkpoint short enough to switch the group to the new number of files. */
+constexpr ulint LOG_RESIZE_FILES_RETRIES = 10;
+
 /** Margin for the free space in the smallest log group, before a new query
 step which modifies the database, is started */
 
@@ -105,24 +128,30 @@ constexpr ulint LOG_POOL_PREFLUSH_RATIO_SYNC = 32;
 the previous */
 constexpr ulint LOG_POOL_PREFLUSH_RATIO_ASYNC = 6;
 
+/** The checkpointer checks the checkpoint age at least this often, the
+threads over the sync margin wait for a checkpoint at most this long before
+they check the age again. */
+constexpr auto CHECKPOINTER_INTERVAL = std::chrono::milliseconds(100);
+
 /* Extra margin, in addition to one log file, used in archiving */
 
 /* Codes used in unlocking flush latches */
 constexpr ulint LOG_UNLOCK_NONE_FLUSHED_LOCK = 1;
 constexpr ulint LOG_UNLOCK_FLUSH_LOCK = 2;
 
-Log::Log() noexcept {
-  mutex_create(&m_mutex, IF_DEBUG("log_sys_mutex",) IF_SYNC_DEBUG(SYNC_LOG,) Current_location());
+static_assert(LOG_RECENT_CLOSED_SIZE <= BUF_FLUSH_LIST_SLACK, "The flush lists are sorted only within BUF_FLUSH_LIST_SLACK");
 
-  acquire();
+Log::Log() noexcept
+  : m_recent_written(LOG_RECENT_WRITTEN_SIZE, LOG_START_LSN),
+    m_recent_closed(LOG_RECENT_CLOSED_SIZE, LOG_START_LSN) {
 
-  /* Start the lsn from one log block from zero: this way every
-  log record has a start lsn != zero, a fact which we will use */
+  mutex_create(&m_mutex, IF_DEBUG("log_sys_mutex",) IF_SYNC_DEBUG(SYNC_LOG,) Current_location());
 
-  m_lsn = LOG_START_LSN;
+  acquire();
 
   ut_a(LOG_BUFFER_SIZE >= 16 * IB_FILE_BLOCK_SIZE);
   ut_a(LOG_BUFFER_SIZE >= 4 * UNIV_PAGE_SIZE);
+  ut_a(LOG_BUFFER_SIZE % IB_FILE_BLOCK_SIZE == 0);
 
   m_buf_ptr = static_cast<byte *>(mem_alloc(LOG_BUFFER_SIZE + IB_FILE_BLOCK_SIZE));
 
@@ -132,6 +161,13 @@ Log::Log() noexcept {
 
   memset(m_buf, '\0', LOG_BUFFER_SIZE);
 
+  /* The unwritten log can be up to the size of the log buffer, the write
+  can start in the middle of a block and the write of a ring buffer that
+  wraps around is done in one go from here. */
+  m_write_buf_ptr = static_cast<byte *>(mem_alloc(LOG_BUFFER_SIZE + 3 * IB_FILE_BLOCK_SIZE));
+
+  m_write_buf = static_cast<byte *>(ut_align(m_write_buf_ptr, IB_FILE_BLOCK_SIZE));
+
   m_max_buf_free = m_buf_size / LOG_BUF_FLUSH_RATIO - LOG_BUF_FLUSH_MARGIN;
   m_check_flush_or_checkpoint = true;
   UT_LIST_INIT(m_log_groups);
@@ -142,15 +178,10 @@ Log::Log() noexcept {
   m_last_printout_time = time(nullptr);
   /*----------------------------*/
 
-  m_buf_next_to_write = 0;
-
   m_write_lsn = 0;
   m_current_flush_lsn = 0;
   m_flushed_to_disk_lsn = 0;
 
-  m_written_to_some_lsn = m_lsn;
-  m_written_to_all_lsn = m_lsn;
-
   m_n_pending_writes = 0;
 
   m_no_flush_event = os_event_create(nullptr);
@@ -161,11 +192,17 @@ Log::Log() noexcept {
 
   os_event_set(m_one_flushed_event);
 
+  m_writer_event = os_event_create("log_writer_event");
+  m_flusher_event = os_event_create("log_flusher_event");
+  m_commit_event = os_event_create("log_commit_event");
+  m_checkpointer_event = os_event_create("log_checkpointer_event");
+  m_checkpoint_done_event = os_event_create("log_checkpoint_done_event");
+
   /*----------------------------*/
   m_adm_checkpoint_interval = ULINT_MAX;
 
   m_next_checkpoint_no = 0;
-  m_last_checkpoint_lsn = m_lsn;
+  m_last_checkpoint_lsn = LOG_START_LSN;
   m_n_pending_checkpoint_writes = 0;
 
   rw_lock_create(&m_checkpoint_lock, SYNC_NO_ORDER_CHECK);
@@ -177,11 +214,10 @@ Log::Log() noexcept {
   memset(m_checkpoint_buf, '\0', IB_FILE_BLOCK_SIZE);
   /*----------------------------*/
 
-  block_init(m_buf, m_lsn);
-  block_set_first_rec_group(m_buf, LOG_BLOCK_HDR_SIZE);
+  /* Start the lsn from one log block from zero: this way every
+  log record has a start lsn != zero, a fact which we will use */
 
-  m_buf_free = LOG_BLOCK_HDR_SIZE;
-  m_lsn = LOG_START_LSN + LOG_BLOCK_HDR_SIZE;
+  reset(LOG_START_LSN, nullptr);
 
   release();
 }
@@ -216,110 +252,510 @@ lsn_t Log::buf_pool_get_oldest_modification() noexcept {
 
   auto lsn = srv_buf_pool->get_oldest_modification();
 
-  if (lsn == 0) {
-    lsn = m_lsn;
+  /* The mini-transactions that have not linked their pages to the flush
+  lists yet all started at or after the closed lsn. If there are none, it
+  is the current lsn. */
+  const auto closed_lsn = m_recent_closed.advance_tail();
+
+  if (lsn == 0 || lsn > closed_lsn) {
+    lsn = closed_lsn;
   }
 
-  return lsn;
+  /* The buffer pool returns a lower bound that can be below the last
+  checkpoint, the oldest modification never moves backwards. */
+  return std::max(lsn, m_last_checkpoint_lsn.load());
 }
 
-lsn_t Log::reserve_and_open(ulint len) noexcept {
-  IF_DEBUG(ulint count = 0;)
+void Log::reset(lsn_t lsn, const byte *last_block) noexcept {
+  ut_ad(mutex_own(&m_mutex));
 
-  ut_a(len < m_buf_size / 2);
+  auto log_block = m_buf + ut_uint64_align_down(lsn, IB_FILE_BLOCK_SIZE) % m_buf_size;
 
-  for (;;) {
-    acquire();
+  if (last_block == nullptr) {
+    ut_a(lsn % IB_FILE_BLOCK_SIZE == 0);
 
-    /* Calculate an upper limit for the space the string may take in the
-    log buffer */
+    block_init(log_block, lsn);
+    block_set_first_rec_group(log_block, LOG_BLOCK_HDR_SIZE);
 
-    auto len_upper_limit = LOG_BUF_WRITE_MARGIN + (5 * len) / 4;
+    lsn += LOG_BLOCK_HDR_SIZE;
+  } else {
+    memcpy(log_block, last_block, IB_FILE_BLOCK_SIZE);
+  }
 
-    if (m_buf_free + len_upper_limit > m_buf_size) {
-      release();
+  m_sn.store(lsn_to_sn(lsn), std::memory_order_release);
 
-      /* Not enough free space, do a synchronous flush of the log buffer */
+  m_buf_limit_lsn.store(ut_uint64_align_down(lsn, IB_FILE_BLOCK_SIZE) + m_buf_size, std::memory_order_release);
 
-      buffer_flush_to_disk();
+  m_recent_written.reset(lsn);
+  m_recent_closed.reset(lsn);
 
-      srv_log_waits++;
+  m_written_to_some_lsn = lsn;
+  m_written_to_all_lsn = lsn;
+}
 
-      ut_ad(++count < 50);
-    } else {
+lsn_t Log::reserve(ulint len, lsn_t *end_lsn) noexcept {
+  using namespace std::chrono;
+
+  if (unlikely(len >= m_buf_size.load(std::memory_order_relaxed) / 2)) {
+    /* A large mini-transaction, e.g., of a BLOB insert. The buffer must be
+    grown before the log is reserved, a resize waits for the reserved log. */
+    resize_buffer(ut_uint64_align_up(len, UNIV_PAGE_SIZE) * 4);
+  }
+
+  auto start_sn = m_sn.fetch_add(len, std::memory_order_acq_rel);
+
+  /* The clock is only read on the slow paths, the epoch means no wait. */
+  steady_clock::time_point wait_start{};
+
+  if (unlikely(start_sn & SN_LOCKED)) {
+    wait_start = steady_clock::now();
+    start_sn &= ~SN_LOCKED;
+    wait_for_resize();
+  }
+
+  ut_a(len < m_buf_size.load(std::memory_order_relaxed) / 2);
+
+  const auto start_lsn = sn_to_lsn(start_sn);
+
+  *end_lsn = sn_to_lsn(start_sn + len);
+
+  if (unlikely(*end_lsn > m_buf_limit_lsn.load(std::memory_order_acquire) || !m_recent_written.has_space(start_lsn))) {
+    if (wait_start == steady_clock::time_point{}) {
+      wait_start = steady_clock::now();
+    }
+
+    wait_for_space(start_lsn, *end_lsn);
+  }
+
+  if (unlikely(wait_start != steady_clock::time_point{})) {
+    mtr_stats.add(MTR_STAT_LOG_SPACE_WAIT_US, uint64_t(duration_cast<microseconds>(steady_clock::now() - wait_start).count()));
+  }
+
+  return start_lsn;
+}
+
+void Log::wait_for_space(lsn_t start_lsn, lsn_t end_lsn) noexcept {
+  for (auto waited = false;; waited = true) {
+    const auto written_lsn = m_recent_written.advance_tail();
+
+    if (end_lsn <= m_buf_limit_lsn.load(std::memory_order_acquire) && m_recent_written.has_space(start_lsn)) {
       break;
     }
+
+    if (!waited) {
+      srv_log_waits.inc();
+
+      /* The buffer is too small for the load, grow it outside of the
+      mini-transactions. */
+      m_buf_grow_requested.store(true, std::memory_order_relaxed);
+    }
+
+    /* Write what the mini-transactions before us have copied, so that the
+    space in the log buffer can be reused. */
+    write_up_to(written_lsn, LOG_WAIT_ALL_GROUPS, false);
+
+    std::this_thread::yield();
   }
+}
 
-  return m_lsn;
+void Log::wait_for_resize() const noexcept {
+  while (m_sn.load(std::memory_order_acquire) & SN_LOCKED) {
+    std::this_thread::yield();
+  }
 }
 
-void Log::write_low(const byte *str, ulint str_len) noexcept {
-  ut_ad(mutex_own(&m_mutex));
+void Log::resize_buffer(ulint size) noexcept {
+  size = std::max(ulint(ut_uint64_align_up(size, UNIV_PAGE_SIZE)), LOG_BUF_MIN_SIZE);
 
-  while (str_len > 0) {
-    /* Calculate a part length */
-    auto data_len = (m_buf_free % IB_FILE_BLOCK_SIZE) + str_len;
+  if (size == m_buf_size.load(std::memory_order_relaxed)) {
+    return;
+  }
 
-    ulint len;
+  /* Allocate before the lock, the mini-transactions wait only for the
+  write of the log that is in the buffer. */
+  auto buf_ptr = static_cast<byte *>(mem_alloc(size + IB_FILE_BLOCK_SIZE));
+  auto write_buf_ptr = static_cast<byte *>(mem_alloc(size + 3 * IB_FILE_BLOCK_SIZE));
 
-    if (data_len <= IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
-      /* The string fits within the current log block */
-      len = str_len;
-    } else {
-      data_len = IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE;
-      len = IB_FILE_BLOCK_SIZE - (m_buf_free % IB_FILE_BLOCK_SIZE) - LOG_BLOCK_TRL_SIZE;
+  /* Another thread can be resizing, wait for it to finish. */
+  uint64_t locked_sn;
+
+  while ((locked_sn = m_sn.fetch_or(SN_LOCKED, std::memory_order_acq_rel)) & SN_LOCKED) {
+    wait_for_resize();
+  }
+
+  const auto lsn = sn_to_lsn(locked_sn);
+
+  /* Wait for the mini-transactions that reserved their log before the lock
+  to copy it. They may need to write the log to get space in the buffer, the
+  mini-transactions after the lock have not copied anything. */
+  while (m_recent_written.advance_tail() < lsn) {
+    write_up_to(m_recent_written.tail(), LOG_WAIT_ALL_GROUPS, false);
+
+    std::this_thread::yield();
+  }
+
+  write_up_to(lsn, LOG_WAIT_ALL_GROUPS, false);
+
+  acquire();
+
+  ut_a(m_written_to_all_lsn == lsn);
+
+  const auto old_size = m_buf_size.load(std::memory_order_relaxed);
+  const auto block_lsn = ut_uint64_align_down(lsn, IB_FILE_BLOCK_SIZE);
+  auto buf = static_cast<byte *>(ut_align(buf_ptr, IB_FILE_BLOCK_SIZE));
+
+  /* The next write starts from the block that contains lsn. */
+  memcpy(buf + block_lsn % size, m_buf + block_lsn % old_size, IB_FILE_BLOCK_SIZE);
+
+  mem_free(m_buf_ptr);
+  mem_free(m_write_buf_ptr);
+
+  m_buf_ptr = buf_ptr;
+  m_buf = buf;
+  m_write_buf_ptr = write_buf_ptr;
+  m_write_buf = static_cast<byte *>(ut_align(write_buf_ptr, IB_FILE_BLOCK_SIZE));
+
+  m_buf_size.store(size, std::memory_order_relaxed);
+  m_max_buf_free.store(size / LOG_BUF_FLUSH_RATIO - LOG_BUF_FLUSH_MARGIN, std::memory_order_relaxed);
+  m_buf_limit_lsn.store(block_lsn + size, std::memory_order_release);
+
+  release();
+
+  m_sn.fetch_and(~SN_LOCKED, std::memory_order_release);
+
+  log_info(std::format("Resized the log buffer from {} to {} bytes", old_size, size));
+}
+
+void Log::grow_buffer() noexcept {
+  if (!m_buf_grow_requested.exchange(false, std::memory_order_relaxed)) {
+    return;
+  }
+
+  const auto size = m_buf_size.load(std::memory_order_relaxed);
+  const auto max_size = std::max(srv_config.m_log_buffer_max_size, LOG_BUFFER_SIZE);
+
+  if (size < max_size) {
+    resize_buffer(std::min(size * 2, max_size));
+  }
+}
+
+void Log::buffer_shrink_if_idle() noexcept {
+  const auto now = time(nullptr);
+  const auto lsn = get_lsn();
+  const auto min_size = LOG_BUFFER_SIZE;
+  const auto size = m_buf_size.load(std::memory_order_relaxed);
+
+  /* The buffer is not grown, or more log was generated since the previous
+  call than the configured size holds: the idle time starts over. */
+  if (size <= min_size || lsn - m_buf_idle_lsn >= min_size) {
+    m_buf_idle_since = now;
+  } else if (difftime(now, m_buf_idle_since) >= LOG_BUF_SHRINK_IDLE_SECS) {
+    resize_buffer(min_size);
+    m_buf_idle_since = now;
+  }
+
+  m_buf_idle_lsn = lsn;
+}
+
+db_err Log::group_create_files(const log_group_t *group, ulint n_files) noexcept {
+  namespace fs = std::filesystem;
+
+  std::vector<std::pair<std::string, page_no_t>> files;
+
+  for (auto &space : srv_fil->get_space_files(FIL_LOG)) {
+    if (space.m_id == group->space_id) {
+      files = std::move(space.m_files);
     }
+  }
 
-    memcpy(m_buf + m_buf_free, str, len);
+  ut_a(files.size() == group->n_files);
 
-    str_len -= len;
-    str += len;
+  const auto dir = fs::path(files.front().first).parent_path();
 
-    auto log_block = static_cast<byte *>(ut_align_down(m_buf + m_buf_free, IB_FILE_BLOCK_SIZE));
+  for (auto i = files.size(); i < n_files; ++i) {
+    const auto path = (dir / std::format("ib_logfile{}", i)).generic_string();
 
-    block_set_data_len(log_block, data_len);
+    bool success{};
+    auto fh = os_file_create(path.c_str(), OS_FILE_OVERWRITE, OS_FILE_NORMAL, OS_LOG_FILE, &success);
 
-    if (data_len == IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
-      /* This block is full. */
-      block_set_data_len(log_block, IB_FILE_BLOCK_SIZE);
-      block_set_checkpoint_no(log_block, m_next_checkpoint_no);
-      len += LOG_BLOCK_HDR_SIZE + LOG_BLOCK_TRL_SIZE;
+    if (!success) {
+      log_err(std::format("Cannot create the log file {}", path));
+      return DB_ERROR;
+    }
 
-      m_lsn += len;
+    log_info(std::format("Creating log file {} of {} MB", path, group->file_size / (1024 * 1024)));
 
-      // Initialize the next block header
-      block_init(log_block + IB_FILE_BLOCK_SIZE, m_lsn);
-    } else {
-      m_lsn += len;
+    /* Written full of zeros, the recovery scan stops at the first block
+    of the file that was not written. */
+    success = os_file_set_size(path.c_str(), fh, off_t(group->file_size));
+
+    {
+      auto success = os_file_close(fh);
+      ut_a(success);
     }
 
-    m_buf_free += len;
+    if (!success) {
+      log_err(std::format("Can't create {}: probably out of disk space", path));
+      (void) os_file_delete_if_exists(path.c_str());
+      return DB_ERROR;
+    }
 
-    ut_ad(m_buf_free <= m_buf_size);
+    srv_fil->node_create(path.c_str(), group->file_size / UNIV_PAGE_SIZE, group->space_id, false);
   }
 
-  ++srv_log_write_requests;
+  return DB_SUCCESS;
 }
 
-lsn_t Log::close(ib_recovery_t recovery) noexcept {
-  auto log_block = static_cast<byte *>(ut_align_down(m_buf + m_buf_free, IB_FILE_BLOCK_SIZE));
-  auto first_rec_group = block_get_first_rec_group(log_block);
-  auto lsn = m_lsn;
-  auto checkpoint_age = lsn - m_last_checkpoint_lsn;
-  auto oldest_lsn = srv_buf_pool->get_oldest_modification();
+void Log::group_delete_files(const log_group_t *group, ulint n_files) noexcept {
+  for (;;) {
+    const auto path = srv_fil->space_free_last_file(group->space_id, n_files);
+
+    if (path.empty()) {
+      break;
+    }
+
+    if (os_file_delete(path.c_str())) {
+      log_info(std::format("Deleted log file {}", path));
+    }
+  }
+}
 
+db_err Log::group_switch_n_files(log_group_t *group, ulint n_files) noexcept {
   ut_ad(mutex_own(&m_mutex));
 
-  if (first_rec_group == 0) {
-    /* We initialized a new log block which was not written
-    full by the current mtr: the next mtr log record group
-    will start within this block at the offset data_len */
+  if (m_n_pending_writes > 0 || m_n_pending_checkpoint_writes > 0) {
+    return DB_FAIL;
+  }
+
+  const auto old_n_files = group->n_files;
+  const auto file_capacity = group->file_size - LOG_FILE_HDR_SIZE;
+  const auto capacity = std::min(group_get_capacity(group), file_capacity * n_files);
+
+  /* The log from the block of the checkpoint up to the end of the last
+  block written must be where the new geometry maps it. */
+  const auto start_lsn = ut_uint64_align_down(m_last_checkpoint_lsn.load(), IB_FILE_BLOCK_SIZE);
+  const auto end_lsn = ut_uint64_align_up(m_write_lsn, IB_FILE_BLOCK_SIZE);
+  const auto len = ulint(end_lsn - start_lsn);
+
+  if (len > file_capacity / 2) {
+    return DB_FAIL;
+  }
+
+  const auto start_offset = group_calc_lsn_offset(start_lsn, group);
+
+  /* The real offsets depend on the file size only: if the log does not wrap
+  around in either geometry it stays where it is. */
+  const auto in_place = group_calc_size_offset(start_offset, group) + len <= capacity;
+
+  byte *buf_ptr{};
+  ulint target{};
+
+  if (!in_place) {
+    /* Copy it to the start of a file that it is not in, the old copy is the
+    one the recovery uses until the checkpoint below is written. */
+    const auto first_file = start_offset / group->file_size;
+    const auto last_file = len > 0 ? group_calc_lsn_offset(end_lsn - IB_FILE_BLOCK_SIZE, group) / group->file_size : first_file;
+
+    while (target == first_file || target == last_file) {
+      ++target;
+    }
+
+    ut_a(target < n_files);
+
+    if (len > 0) {
+      buf_ptr = static_cast<byte *>(mem_alloc(len + IB_FILE_BLOCK_SIZE));
 
-    block_set_first_rec_group(log_block, block_get_data_len(log_block));
+      group_read_log_seg(LOG_RECOVER, static_cast<byte *>(ut_align(buf_ptr, IB_FILE_BLOCK_SIZE)), group, start_lsn, end_lsn);
+    }
+  }
+
+  if (!group_set_n_files(group, n_files)) {
+    ut_a(group_set_n_files(group, old_n_files));
+
+    if (buf_ptr != nullptr) {
+      mem_free(buf_ptr);
+    }
+
+    log_err(std::format("A log group of {} files of {} bytes is too small", n_files, group->file_size));
+
+    return DB_ERROR;
+  }
+
+  if (get_lsn() - start_lsn >= m_max_checkpoint_age) {
+    /* The log since the checkpoint does not fit in the smaller group. */
+    ut_a(group_set_n_files(group, old_n_files));
+
+    if (buf_ptr != nullptr) {
+      mem_free(buf_ptr);
+    }
+
+    return DB_FAIL;
+  }
+
+  group->lsn = start_lsn;
+
+  if (in_place) {
+    group->lsn_offset = start_offset;
+  } else {
+    group->lsn_offset = target * group->file_size + LOG_FILE_HDR_SIZE;
+
+    if (buf_ptr != nullptr) {
+      group_write_buf(group, static_cast<byte *>(ut_align(buf_ptr, IB_FILE_BLOCK_SIZE)), len, start_lsn, 0, true);
+
+      mem_free(buf_ptr);
+    }
+  }
+
+  /* Rewrite the last checkpoint with the new geometry, synchronously: the
+  log mutex stops the writes to the group until it is on disk. */
+  m_next_checkpoint_lsn = m_last_checkpoint_lsn;
+
+  const auto field = group_checkpoint_prepare(group);
+
+  if (log_do_write) {
+    ++m_n_log_ios;
+
+    srv_fil->io(
+      IO_request::Sync_log_write_durable,
+      false,
+      group->space_id,
+      field / UNIV_PAGE_SIZE,
+      field % UNIV_PAGE_SIZE,
+      IB_FILE_BLOCK_SIZE,
+      group->checkpoint_buf,
+      nullptr
+    );
+  }
+
+  ++m_next_checkpoint_no;
+
+  return DB_SUCCESS;
+}
+
+db_err Log::resize_files(ulint n_files) noexcept {
+  std::lock_guard<std::mutex> guard(m_resize_files_mutex);
+
+  if (srv_config.m_read_only) {
+    return DB_READONLY;
+  }
+
+  ut_a(n_files >= 2);
+
+  auto group = UT_LIST_GET_FIRST(m_log_groups);
+
+  if (uint64_t(n_files) * group->file_size >= uint64_t(1) << 32) {
+    log_err("Combined size of log files must be < 4 GB");
+    return DB_ERROR;
+  }
+
+  acquire();
+
+  const auto old_n_files = group->n_files;
+
+  release();
+
+  if (n_files == old_n_files) {
+    return DB_SUCCESS;
+  }
+
+  /* Files past the group are left over by a resize that was interrupted by
+  a crash, they are created again. */
+  group_delete_files(group, old_n_files);
+
+  if (n_files > old_n_files) {
+    if (auto err = group_create_files(group, n_files); err != DB_SUCCESS) {
+      group_delete_files(group, old_n_files);
+      return err;
+    }
+  }
+
+  auto err = DB_FAIL;
+
+  for (ulint i{}; err == DB_FAIL && i < LOG_RESIZE_FILES_RETRIES; ++i) {
+    if (i > 0) {
+      /* Move the checkpoint up to the current lsn, the log to keep is short
+      then, unless the load is heavy. */
+      make_checkpoint_at(IB_UINT64_T_MAX, true);
+    }
+
+    acquire();
+
+    err = group_switch_n_files(group, n_files);
+
+    release();
+  }
+
+  if (err != DB_SUCCESS) {
+    group_delete_files(group, old_n_files);
+
+    if (err == DB_FAIL) {
+      log_warn(std::format("Could not resize the log group to {} files, the log after the checkpoint did not fit", n_files));
+      err = DB_ERROR;
+    }
+
+    return err;
+  }
+
+  group_delete_files(group, n_files);
+
+  log_info(std::format("Resized the log group from {} to {} files of {} MB", old_n_files, n_files, group->file_size / (1024 * 1024)));
+
+  return DB_SUCCESS;
+}
+
+lsn_t Log::write(lsn_t lsn, const byte *str, ulint len) noexcept {
+  while (len > 0) {
+    const auto offset = ulint(lsn % IB_FILE_BLOCK_SIZE);
+
+    ut_ad(offset >= LOG_BLOCK_HDR_SIZE && offset < IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE);
+
+    const auto n = std::min(len, IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE - offset);
+
+    memcpy(m_buf + lsn % m_buf_size, str, n);
+
+    str += n;
+    len -= n;
+    lsn += n;
+
+    if (offset + n == IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+      /* This block is full, skip its trailer and the header of the next
+      one. Only the mini-transaction that continues to the next block
+      writes to its header, the log writer fills in the rest. */
+      lsn += LOG_BLOCK_TRL_SIZE + LOG_BLOCK_HDR_SIZE;
+
+      block_set_first_rec_group(m_buf + (lsn - LOG_BLOCK_HDR_SIZE) % m_buf_size, 0);
+    }
+  }
+
+  return lsn;
+}
+
+void Log::close(lsn_t start_lsn, lsn_t end_lsn) noexcept {
+  ut_ad(end_lsn > start_lsn);
+
+  const auto end_block_lsn = ut_uint64_align_down(end_lsn, IB_FILE_BLOCK_SIZE);
+  const auto new_block = ut_uint64_align_down(start_lsn, IB_FILE_BLOCK_SIZE) != end_block_lsn;
+
+  if (new_block) {
+    /* We started a new log block: the next mtr log record group will
+    start within it. */
+    block_set_first_rec_group(m_buf + end_block_lsn % m_buf_size, ulint(end_lsn % IB_FILE_BLOCK_SIZE));
+  }
+
+  m_recent_written.add_link(start_lsn, end_lsn);
+
+  srv_log_write_requests.inc();
+
+  if (!new_block) {
+    /* The margins are checked once per log block, not by every small
+    mini-transaction, get_oldest_modification() latches the flush lists. */
+    return;
   }
 
-  if (m_buf_free > m_max_buf_free) {
+  const auto checkpoint_age = end_lsn - m_last_checkpoint_lsn.load(std::memory_order_relaxed);
+  const auto oldest_lsn = srv_buf_pool->get_oldest_modification();
+
+  if (end_lsn - (m_buf_limit_lsn.load(std::memory_order_relaxed) - m_buf_size) > m_max_buf_free) {
     m_check_flush_or_checkpoint = true;
   }
 
@@ -347,13 +783,29 @@ lsn_t Log::close(ib_recovery_t recovery) noexcept {
   }
 
   if (checkpoint_age > m_max_modified_age_async ||
-      (oldest_lsn > 0 && lsn - oldest_lsn > m_max_modified_age_async) ||
+      (oldest_lsn > 0 && oldest_lsn < end_lsn && end_lsn - oldest_lsn > m_max_modified_age_async) ||
       checkpoint_age > m_max_checkpoint_age_async) {
 
     m_check_flush_or_checkpoint = true;
   }
+}
 
-  return lsn;
+void Log::flush_order_begin(lsn_t start_lsn) noexcept {
+  if (likely(m_recent_closed.has_space(start_lsn))) {
+    return;
+  }
+
+  using namespace std::chrono;
+
+  const auto start = steady_clock::now();
+
+  while (!m_recent_closed.has_space(start_lsn)) {
+    (void) m_recent_closed.advance_tail();
+
+    std::this_thread::yield();
+  }
+
+  mtr_stats.add(MTR_STAT_FLUSH_ORDER_WAIT_US, uint64_t(duration_cast<microseconds>(steady_clock::now() - start).count()));
 }
 
 ulint Log::group_get_capacity(const log_group_t *group) noexcept {
@@ -426,8 +878,8 @@ void Log::group_set_fields(log_group_t *group, lsn_t lsn) noexcept {
   group->lsn = lsn;
 }
 
-bool Log::calc_max_ages() noexcept {
-  acquire();
+bool Log::calc_max_ages_low() noexcept {
+  ut_ad(mutex_own(&m_mutex));
 
   auto smallest_capacity = ULINT_MAX;
 
@@ -473,6 +925,14 @@ bool Log::calc_max_ages() noexcept {
 
   m_max_checkpoint_age = margin;
 
+  return success;
+}
+
+bool Log::calc_max_ages() noexcept {
+  acquire();
+
+  const auto success = calc_max_ages_low();
+
   release();
 
   if (!success) {
@@ -497,6 +957,43 @@ Log* Log::create() noexcept {
   return log_sys;
 }
 
+void Log::group_alloc_file_header_bufs(log_group_t *group) noexcept {
+  group->file_header_bufs_ptr = static_cast<byte **>(mem_alloc(sizeof(byte *) * group->n_files));
+
+  group->file_header_bufs = static_cast<byte **>(mem_alloc(sizeof(byte *) * group->n_files));
+
+  for (ulint i = 0; i < group->n_files; i++) {
+    group->file_header_bufs_ptr[i] = static_cast<byte *>(mem_alloc(LOG_FILE_HDR_SIZE + IB_FILE_BLOCK_SIZE));
+
+    group->file_header_bufs[i] = static_cast<byte *>(ut_align(group->file_header_bufs_ptr[i], IB_FILE_BLOCK_SIZE));
+
+    memset(*(group->file_header_bufs + i), '\0', LOG_FILE_HDR_SIZE);
+  }
+}
+
+void Log::group_free_file_header_bufs(log_group_t *group) noexcept {
+  for (ulint i = 0; i < group->n_files; ++i) {
+    mem_free(group->file_header_bufs_ptr[i]);
+  }
+
+  mem_free(group->file_header_bufs);
+  mem_free(group->file_header_bufs_ptr);
+}
+
+bool Log::group_set_n_files(log_group_t *group, ulint n_files) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+  ut_a(n_files >= 2);
+
+  /* The headers are written from the buffers only, they hold no state. */
+  group_free_file_header_bufs(group);
+
+  group->n_files = n_files;
+
+  group_alloc_file_header_bufs(group);
+
+  return calc_max_ages_low();
+}
+
 void Log::group_init(ulint id, ulint n_files, off_t file_size, space_id_t space_id) noexcept {
   auto group = static_cast<log_group_t *>(mem_alloc(sizeof(log_group_t)));
 
@@ -511,17 +1008,7 @@ void Log::group_init(ulint id, ulint n_files, off_t file_size, space_id_t space_
   group->lsn_offset = LOG_FILE_HDR_SIZE;
   group->n_pending_writes = 0;
 
-  group->file_header_bufs_ptr = static_cast<byte **>(mem_alloc(sizeof(byte *) * n_files));
-
-  group->file_header_bufs = static_cast<byte **>(mem_alloc(sizeof(byte *) * n_files));
-
-  for (ulint i = 0; i < n_files; i++) {
-    group->file_header_bufs_ptr[i] = static_cast<byte *>(mem_alloc(LOG_FILE_HDR_SIZE + IB_FILE_BLOCK_SIZE));
-
-    group->file_header_bufs[i] = static_cast<byte *>(ut_align(group->file_header_bufs_ptr[i], IB_FILE_BLOCK_SIZE));
-
-    memset(*(group->file_header_bufs + i), '\0', LOG_FILE_HDR_SIZE);
-  }
+  group_alloc_file_header_bufs(group);
 
   group->checkpoint_buf_ptr = static_cast<byte *>(mem_alloc(2 * IB_FILE_BLOCK_SIZE));
 
@@ -596,27 +1083,11 @@ void Log::io_complete_checkpoint() noexcept {
 }
 
 ulint Log::sys_check_flush_completion() noexcept {
-  ulint move_start;
-  ulint move_end;
-
   ut_ad(mutex_own(&m_mutex));
 
   if (m_n_pending_writes == 0) {
 
     m_written_to_all_lsn = m_write_lsn;
-    m_buf_next_to_write = m_write_end_offset;
-
-    if (m_write_end_offset > m_max_buf_free / 2) {
-      /* Move the log buffer content to the start of the buffer */
-
-      move_start = ut_calc_align_down(m_write_end_offset, IB_FILE_BLOCK_SIZE);
-      move_end = ut_calc_align(m_buf_free, IB_FILE_BLOCK_SIZE);
-
-      memmove(m_buf, m_buf + move_start, move_end - move_start);
-      m_buf_free -= move_start;
-
-      m_buf_next_to_write -= move_start;
-    }
 
     return LOG_UNLOCK_FLUSH_LOCK;
   }
@@ -665,7 +1136,7 @@ void Log::io_complete(log_group_t *group) noexcept {
   release();
 }
 
-void Log::group_file_header_flush(log_group_t *group, ulint nth_file, lsn_t start_lsn) noexcept {
+void Log::group_file_header_flush(log_group_t *group, ulint nth_file, lsn_t start_lsn, bool durable) noexcept {
   ut_ad(mutex_own(&m_mutex));
   ut_a(nth_file < group->n_files);
 
@@ -685,7 +1156,7 @@ void Log::group_file_header_flush(log_group_t *group, ulint nth_file, lsn_t star
     ++srv_os_log_pending_writes;
 
     srv_fil->io(
-      IO_request::Sync_log_write,
+      durable ? IO_request::Sync_log_write_durable : IO_request::Sync_log_write,
       false,
       group->space_id,
       dest_offset / UNIV_PAGE_SIZE,
@@ -703,7 +1174,7 @@ void Log::block_store_checksum(byte *block) noexcept {
   block_set_checksum(block, block_calc_checksum(block));
 }
 
-void Log::group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_lsn, ulint new_data_offset) noexcept {
+void Log::group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_lsn, ulint new_data_offset, bool durable) noexcept {
   ut_ad(mutex_own(&m_mutex));
   ut_a(len % IB_FILE_BLOCK_SIZE == 0);
   ut_a(((ulint)start_lsn) % IB_FILE_BLOCK_SIZE == 0);
@@ -715,9 +1186,9 @@ void Log::group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_
 
     if ((next_offset % group->file_size == LOG_FILE_HDR_SIZE) && write_header) {
       /* We start to write a new log file instance in the group */
-      group_file_header_flush(group, next_offset / group->file_size, start_lsn);
-      srv_os_log_written += IB_FILE_BLOCK_SIZE;
-      ++srv_log_writes;
+      group_file_header_flush(group, next_offset / group->file_size, start_lsn, durable);
+      srv_os_log_written.inc(IB_FILE_BLOCK_SIZE);
+      srv_log_writes.inc();
     }
 
     ulint write_len;
@@ -739,7 +1210,7 @@ void Log::group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_
       ++srv_os_log_pending_writes;
 
       srv_fil->io(
-        IO_request::Sync_log_write,
+        durable ? IO_request::Sync_log_write_durable : IO_request::Sync_log_write,
         false,
         group->space_id,
         next_offset / UNIV_PAGE_SIZE,
@@ -751,9 +1222,9 @@ void Log::group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_
 
       --srv_os_log_pending_writes;
 
-      srv_os_log_written += write_len;
+      srv_os_log_written.inc(write_len);
 
-      ++srv_log_writes;
+      srv_log_writes.inc();
     }
 
     if (write_len < len) {
@@ -767,17 +1238,62 @@ void Log::group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_
   }
 }
 
+ulint Log::copy_to_write_buf(lsn_t start_lsn, lsn_t end_lsn) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  const auto area_start = ut_uint64_align_down(start_lsn, IB_FILE_BLOCK_SIZE);
+  const auto area_end = ut_uint64_align_up(end_lsn, IB_FILE_BLOCK_SIZE);
+  const auto len = ulint(area_end - area_start);
+
+  ut_a(len > 0 && len <= m_buf_size + IB_FILE_BLOCK_SIZE);
+
+  /* The log buffer is a ring buffer, the area can wrap around. */
+  const auto offset = ulint(area_start % m_buf_size);
+  const auto n = std::min(len, m_buf_size - offset);
+
+  memcpy(m_write_buf, m_buf + offset, n);
+  memcpy(m_write_buf + n, m_buf, len - n);
+
+  /* The last block is copied again by the next write, the mini-transactions
+  must not reuse its space in the log buffer before that. */
+  m_buf_limit_lsn.store(ut_uint64_align_down(end_lsn, IB_FILE_BLOCK_SIZE) + m_buf_size, std::memory_order_release);
+
+  for (ulint i{}; i < len; i += IB_FILE_BLOCK_SIZE) {
+    auto log_block = m_write_buf + i;
+
+    block_set_hdr_no(log_block, block_convert_lsn_to_no(area_start + i));
+
+    if (i + IB_FILE_BLOCK_SIZE < len) {
+      block_set_data_len(log_block, IB_FILE_BLOCK_SIZE);
+    } else {
+      /* The last block can be incomplete. The mini-transactions may be
+      copying their log after end_lsn, clear it. */
+      const auto data_len = ulint(end_lsn - (area_start + i));
+
+      block_set_data_len(log_block, data_len);
+
+      memset(log_block + data_len, 0x0, IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE - data_len);
+    }
+
+    block_set_checkpoint_no(log_block, m_next_checkpoint_no);
+  }
+
+  block_set_flush_bit(m_write_buf, true);
+
+  return len;
+}
+
 void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
   log_group_t *group;
-  ulint start_offset;
-  ulint end_offset;
-  ulint area_start;
-  ulint area_end;
   ulint unlock;
 
-  IF_DEBUG(ulint loop_count = 0;)
+  auto do_waits = [this, &lsn](ulint wait) {
+    ut::Wait_timer flush_wait(ut::Wait_type::LOG_FLUSH, lsn, __FILE__, __LINE__);
+
+    if (wait != LOG_NO_WAIT) {
+      flush_wait.start();
+    }
 
-  auto do_waits = [this](ulint wait) {
     switch (wait) {
       case LOG_WAIT_ONE_GROUP:
         os_event_wait(m_one_flushed_event);
@@ -794,9 +1310,16 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
     }
   };
 
-  for (;;) {
-    ut_ad(++loop_count < 5);
+  /* The log up to lsn can be reserved by mini-transactions that are still
+  copying it to the log buffer. Wait for them without the log mutex, one
+  of them may need to write the log to get space in the log buffer. */
+  lsn = std::min(lsn, get_lsn());
+
+  while (m_recent_written.advance_tail() < lsn) {
+    std::this_thread::yield();
+  }
 
+  for (;;) {
     acquire();
 
     if (flush_to_disk && m_flushed_to_disk_lsn >= lsn) {
@@ -831,11 +1354,22 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
       release();
 
       /* Wait for the write to complete and try to start a new write */
-      os_event_wait(m_no_flush_event);
+      {
+        ut::Wait_timer flush_wait(ut::Wait_type::LOG_FLUSH, lsn, __FILE__, __LINE__);
+
+        flush_wait.start();
+        os_event_wait(m_no_flush_event);
+      }
       continue;
     }
 
-    if (!flush_to_disk && m_buf_free == m_buf_next_to_write) {
+    /* Write all the log that has been copied to the log buffer. */
+    const auto start_lsn = m_written_to_all_lsn.load();
+    const auto end_lsn = m_recent_written.tail();
+
+    ut_ad(end_lsn >= lsn);
+
+    if (!flush_to_disk && end_lsn == start_lsn) {
       /* Nothing to write and no flush to disk requested */
       release();
       return;
@@ -851,61 +1385,61 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
     os_event_reset(m_no_flush_event);
     os_event_reset(m_one_flushed_event);
 
-    start_offset = m_buf_next_to_write;
-    end_offset = m_buf_free;
-
-    area_start = ut_calc_align_down(start_offset, IB_FILE_BLOCK_SIZE);
-    area_end = ut_calc_align(end_offset, IB_FILE_BLOCK_SIZE);
-
-    ut_ad(area_end - area_start > 0);
-
-    m_write_lsn = m_lsn;
+    m_write_lsn = end_lsn;
 
     if (flush_to_disk) {
-      m_current_flush_lsn = m_lsn;
+      m_current_flush_lsn = end_lsn;
     }
 
     m_one_flushed = false;
 
-    block_set_flush_bit(m_buf + area_start, true);
-
-    block_set_checkpoint_no(m_buf + area_end - IB_FILE_BLOCK_SIZE, m_next_checkpoint_no);
+    /* The mini-transactions can continue to copy their log to the log
+    buffer while we write from the write buffer. */
+    const auto len = copy_to_write_buf(start_lsn, end_lsn);
 
-    /* Copy the last, incompletely written, log block a log block length
-    up, so that when the flush operation writes from the log buffer, the
-    segment to write will not be changed by writers to the log */
-    memcpy(m_buf + area_end, m_buf + area_end - IB_FILE_BLOCK_SIZE, IB_FILE_BLOCK_SIZE);
-
-    m_buf_free += IB_FILE_BLOCK_SIZE;
-    m_write_end_offset = m_buf_free;
+    /* With O_DIRECT the flush is linked to the writes, it completes in the
+    same round trip. */
+    const auto durable = flush_to_disk && srv_config.m_log_io_mode == LOG_IO_DIRECT;
 
     /* Do the write to the log files */
     for (auto group : m_log_groups) {
       group_write_buf(
         group,
-        m_buf + area_start,
-        area_end - area_start,
-        ut_uint64_align_down(m_written_to_all_lsn, IB_FILE_BLOCK_SIZE),
-        start_offset - area_start
+        m_write_buf,
+        len,
+        ut_uint64_align_down(start_lsn, IB_FILE_BLOCK_SIZE),
+        ulint(start_lsn % IB_FILE_BLOCK_SIZE),
+        durable
       );
 
       group_set_fields(group, m_write_lsn);
     }
 
+    IB_PROBE(log__write, start_lsn, end_lsn, len, flush_to_disk);
+
+    const auto write_lsn = m_write_lsn;
+
     release();
 
-    if (srv_config.m_unix_file_flush_method == SRV_UNIX_O_DSYNC) {
-      /* O_DSYNC means the OS did not buffer the log file at all:
-      so we have also flushed to disk what we have written */
-      m_flushed_to_disk_lsn = m_write_lsn;
-    } else if (flush_to_disk) {
+    /* O_DSYNC means the OS did not buffer the log file at all: so we have
+    also flushed to disk what we have written */
+    const auto o_dsync =
+      srv_config.m_unix_file_flush_method == SRV_UNIX_O_DSYNC || srv_config.m_log_io_mode == LOG_IO_DIRECT_DSYNC;
+
+    if (flush_to_disk && !o_dsync && !durable) {
       group = UT_LIST_GET_FIRST(m_log_groups);
       srv_fil->flush(group->space_id);
-      m_flushed_to_disk_lsn = m_write_lsn;
+
+      IB_PROBE(log__fsync, write_lsn);
     }
 
     acquire();
 
+    /* The log flusher can have flushed further meanwhile. */
+    if ((flush_to_disk || o_dsync) && m_flushed_to_disk_lsn < write_lsn) {
+      m_flushed_to_disk_lsn = write_lsn;
+    }
+
     group = UT_LIST_GET_FIRST(m_log_groups);
 
     ut_a(group->n_pending_writes == 1);
@@ -925,37 +1459,308 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
   }
 }
 
-void Log::buffer_flush_to_disk() noexcept {
-  acquire();
+void Log::commit_up_to(lsn_t lsn, bool flush_to_disk) noexcept {
+  if (!m_threads_active.load(std::memory_order_acquire)) {
+    write_up_to(lsn, LOG_WAIT_ONE_GROUP, flush_to_disk);
+    return;
+  }
 
-  auto lsn = m_lsn;
+  auto is_done = [&]() {
+    return (flush_to_disk ? m_flushed_to_disk_lsn : m_written_to_some_lsn).load(std::memory_order_acquire) >= lsn;
+  };
 
-  release();
+  if (flush_to_disk) {
+    m_n_group_commits.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (is_done()) {
+    return;
+  }
+
+  request_write(lsn);
+
+  ut::Wait_timer flush_wait(ut::Wait_type::LOG_FLUSH, lsn, __FILE__, __LINE__);
+
+  flush_wait.start();
 
-  write_up_to(lsn, LOG_WAIT_ALL_GROUPS, true);
+  for (;;) {
+    const auto sig_count = os_event_reset(m_commit_event);
+
+    if (is_done()) {
+      return;
+    }
+
+    if (!m_threads_active.load(std::memory_order_acquire)) {
+      /* The threads were stopped while we waited, write_up_to() traces its
+      own waits. */
+      flush_wait.stop();
+      write_up_to(lsn, LOG_WAIT_ONE_GROUP, flush_to_disk);
+      return;
+    }
+
+    m_commit_event->wait(sig_count);
+  }
 }
 
-void Log::buffer_sync_in_background(bool flush) noexcept {
-  mutex_enter(&m_mutex);
+void Log::request_write(lsn_t lsn) noexcept {
+  auto requested_lsn = m_write_requested_lsn.load(std::memory_order_relaxed);
+
+  while (requested_lsn < lsn && !m_write_requested_lsn.compare_exchange_weak(requested_lsn, lsn, std::memory_order_acq_rel)) {
+    /* No op */
+  }
+
+  os_event_set(m_writer_event);
+}
+
+void Log::commit_async(lsn_t lsn, bool flush_to_disk, std::function<void()> callback) noexcept {
+  if (!m_threads_active.load(std::memory_order_acquire)) {
+    write_up_to(lsn, LOG_WAIT_ONE_GROUP, flush_to_disk);
+    callback();
+    return;
+  }
+
+  if (flush_to_disk) {
+    m_n_group_commits.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_async_commits_mutex);
+
+    (flush_to_disk ? m_async_flushed : m_async_written).emplace(lsn, std::move(callback));
+  }
+
+  /* The threads complete the requests after they advance the written and
+  flushed lsn. The log may already be there, complete it here then. */
+  complete_async_commits();
+
+  request_write(lsn);
+}
+
+void Log::complete_async_commits() noexcept {
+  std::vector<std::function<void()>> done;
+
+  {
+    std::lock_guard<std::mutex> lock(m_async_commits_mutex);
+
+    auto move_done = [&done](auto &requests, lsn_t up_to_lsn) {
+      auto end = requests.upper_bound(up_to_lsn);
+
+      for (auto it = requests.begin(); it != end; ++it) {
+        done.push_back(std::move(it->second));
+      }
+
+      requests.erase(requests.begin(), end);
+    };
+
+    move_done(m_async_written, m_written_to_some_lsn.load(std::memory_order_acquire));
+    move_done(m_async_flushed, m_flushed_to_disk_lsn.load(std::memory_order_acquire));
+  }
+
+  /* Not under the mutex, the callbacks can issue new requests. */
+  for (auto &callback : done) {
+    callback();
+  }
+}
+
+void Log::writer_thread() noexcept {
+  os_thread_bind(OS_THREAD_CLASS_LOG);
+
+  while (!is_threads_shutdown()) {
+    const auto sig_count = os_event_reset(m_writer_event);
+    const auto lsn = m_write_requested_lsn.load(std::memory_order_acquire);
+
+    if (lsn <= m_written_to_all_lsn.load(std::memory_order_acquire)) {
+      /* Another thread may have written the log that a commit_async()
+      request waits for, let the flusher flush it too. */
+      complete_async_commits();
+      os_event_set(m_flusher_event);
+
+      if (!is_threads_shutdown()) {
+        m_writer_event->wait(sig_count);
+      }
+
+      continue;
+    }
+
+    /* With log_io_mode=direct the write and its flush are one round trip,
+    the flusher has nothing left to do. */
+    const auto durable = srv_config.m_log_io_mode == LOG_IO_DIRECT;
+
+    /* Writes all the log that is copied to the log buffer, which can be more
+    than requested. The flusher can flush the previous write meanwhile. */
+    write_up_to(lsn, LOG_WAIT_ALL_GROUPS, durable);
+
+    if (durable) {
+      m_n_group_commit_fsyncs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    os_event_set(m_flusher_event);
+    os_event_set(m_commit_event);
+
+    complete_async_commits();
+  }
+}
+
+void Log::flusher_thread() noexcept {
+  os_thread_bind(OS_THREAD_CLASS_LOG);
+
+  while (!is_threads_shutdown()) {
+    const auto sig_count = os_event_reset(m_flusher_event);
+    const auto lsn = m_written_to_all_lsn.load(std::memory_order_acquire);
+
+    if (lsn <= m_flushed_to_disk_lsn.load(std::memory_order_acquire)) {
+      complete_async_commits();
+
+      if (!is_threads_shutdown()) {
+        m_flusher_event->wait(sig_count);
+      }
+
+      continue;
+    }
+
+    /* All the writes up to lsn have completed, one flush covers all the
+    transactions that wait for them. */
+    srv_fil->flush(UT_LIST_GET_FIRST(m_log_groups)->space_id);
+
+    IB_PROBE(log__fsync, lsn);
+
+    acquire();
+
+    if (m_flushed_to_disk_lsn < lsn) {
+      m_flushed_to_disk_lsn = lsn;
+    }
+
+    release();
+
+    m_n_group_commit_fsyncs.fetch_add(1, std::memory_order_relaxed);
+
+    os_event_set(m_commit_event);
+
+    complete_async_commits();
+  }
+}
+
+void Log::checkpointer_thread() noexcept {
+  os_thread_bind(OS_THREAD_CLASS_LOG);
+
+  auto last_time = std::chrono::steady_clock::now();
+  auto last_age = get_checkpoint_age();
+
+  while (!is_threads_shutdown()) {
+    const auto sig_count = os_event_reset(m_checkpointer_event);
+    const auto now = std::chrono::steady_clock::now();
+    const auto age = get_checkpoint_age();
+
+    /* The time since the last round is attributed to the margin that the
+    age was over then. */
+    const auto us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(now - last_time).count());
+
+    if (last_age > m_max_checkpoint_age) {
+      m_checkpoint_sync_time_us.fetch_add(us, std::memory_order_relaxed);
+    } else if (last_age > m_max_checkpoint_age_async) {
+      m_checkpoint_async_time_us.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    last_time = now;
+    last_age = age;
+
+    /* The data files are closed in the last phase of the shutdown. */
+    if (age > m_max_checkpoint_age_async && srv_shutdown_state != SRV_SHUTDOWN_LAST_PHASE) {
+      const auto checkpoint_lsn = m_last_checkpoint_lsn.load();
+
+      /* Waits for the checkpoint write, it is fuzzy: the oldest modified
+      page can be much younger than the last checkpoint. */
+      (void) checkpoint(true, false);
+
+      os_event_set(m_checkpoint_done_event);
+
+      if (m_last_checkpoint_lsn.load() > checkpoint_lsn) {
+        continue;
+      }
+
+      /* Wait for the page cleaner to flush the oldest pages. */
+    }
+
+    if (!is_threads_shutdown()) {
+      (void) m_checkpointer_event->wait_time(CHECKPOINTER_INTERVAL, sig_count);
+    }
+  }
+}
+
+void Log::start_threads() noexcept {
+  ut_a(!m_writer_thread.joinable());
+  ut_a(!m_flusher_thread.joinable());
+  ut_a(!m_checkpointer_thread.joinable());
+
+  m_threads_shutdown.store(false, std::memory_order_release);
+
+  m_writer_thread = create_joinable_thread(&Log::writer_thread, this);
+  m_flusher_thread = create_joinable_thread(&Log::flusher_thread, this);
+  m_checkpointer_thread = create_joinable_thread(&Log::checkpointer_thread, this);
+
+  m_threads_active.store(true, std::memory_order_release);
+}
+
+void Log::stop_threads() noexcept {
+  m_threads_active.store(false, std::memory_order_release);
+  m_threads_shutdown.store(true, std::memory_order_release);
+
+  if (m_writer_thread.joinable()) {
+    os_event_set(m_writer_event);
+    m_writer_thread.join();
+  }
+
+  if (m_flusher_thread.joinable()) {
+    os_event_set(m_flusher_event);
+    m_flusher_thread.join();
+  }
+
+  if (m_checkpointer_thread.joinable()) {
+    os_event_set(m_checkpointer_event);
+    m_checkpointer_thread.join();
+  }
 
-  auto lsn = m_lsn;
+  /* Wake up the threads that still wait, they write themselves. */
+  os_event_set(m_commit_event);
+  os_event_set(m_checkpoint_done_event);
 
-  mutex_exit(&m_mutex);
+  /* Nobody is left to complete the pending commit_async() requests. */
+  bool pending;
 
-  write_up_to(lsn, LOG_NO_WAIT, flush);
+  {
+    std::lock_guard<std::mutex> lock(m_async_commits_mutex);
+
+    pending = !m_async_written.empty() || !m_async_flushed.empty();
+  }
+
+  if (pending) {
+    write_up_to(get_lsn(), LOG_WAIT_ALL_GROUPS, true);
+
+    complete_async_commits();
+  }
+}
+
+void Log::buffer_flush_to_disk() noexcept {
+  write_up_to(get_lsn(), LOG_WAIT_ALL_GROUPS, true);
+}
+
+void Log::buffer_sync_in_background(bool flush) noexcept {
+  write_up_to(get_lsn(), LOG_NO_WAIT, flush);
 }
 
 void Log::flush_margin() noexcept {
-  lsn_t lsn;
+  lsn_t lsn{};
 
   acquire();
 
-  if (m_buf_free > m_max_buf_free) {
+  const auto current_lsn = get_lsn();
+
+  if (current_lsn - m_written_to_all_lsn > m_max_buf_free) {
 
     if (m_n_pending_writes > 0) {
       /* A flush is running: hope that it will provide enough free space */
     } else {
-      lsn = m_lsn;
+      lsn = current_lsn;
     }
   }
 
@@ -980,31 +1785,31 @@ bool Log::preflush_pool_modified_pages(lsn_t new_oldest, bool sync) noexcept {
     recv_apply_log_recs(srv_dblwr, false);
   }
 
-  auto n_pages = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, ULINT_MAX, new_oldest);
+  auto n_pages = srv_buf_pool->flush_batch(srv_dblwr, BUF_FLUSH_LIST, ULINT_MAX, new_oldest);
 
   if (sync) {
-    srv_buf_pool->m_flusher->wait_batch_end(BUF_FLUSH_LIST);
+    srv_buf_pool->wait_batch_end(BUF_FLUSH_LIST);
   }
 
   return n_pages != ULINT_UNDEFINED;
 }
 
-void Log::checkpoint_set_nth_group_info(byte *buf, ulint n, ulint file_no, ulint offset) noexcept {
+void Log::checkpoint_set_nth_group_info(byte *buf, ulint n, ulint n_files, ulint offset) noexcept {
   ut_ad(n < LOG_MAX_N_GROUPS);
 
-  mach_write_to_4(buf + LOG_CHECKPOINT_GROUP_ARRAY + 8 * n + LOG_CHECKPOINT_UNUSED_FILE_NO, file_no);
+  mach_write_to_4(buf + LOG_CHECKPOINT_GROUP_ARRAY + 8 * n + LOG_CHECKPOINT_N_FILES, n_files);
   mach_write_to_4(buf + LOG_CHECKPOINT_GROUP_ARRAY + 8 * n + LOG_CHECKPOINT_UNUSED_OFFSET, offset);
 }
 
-void Log::checkpoint_get_nth_group_info(const byte *buf, ulint n, ulint *file_no, ulint *offset) noexcept {
+void Log::checkpoint_get_nth_group_info(const byte *buf, ulint n, ulint *n_files, ulint *offset) noexcept {
   ut_ad(n < LOG_MAX_N_GROUPS);
 
-  *file_no = mach_read_from_4(buf + LOG_CHECKPOINT_GROUP_ARRAY + 8 * n + LOG_CHECKPOINT_UNUSED_FILE_NO);
+  *n_files = mach_read_from_4(buf + LOG_CHECKPOINT_GROUP_ARRAY + 8 * n + LOG_CHECKPOINT_N_FILES);
 
   *offset = mach_read_from_4(buf + LOG_CHECKPOINT_GROUP_ARRAY + 8 * n + LOG_CHECKPOINT_UNUSED_OFFSET);
 }
 
-void Log::group_checkpoint(log_group_t *group) noexcept {
+ulint Log::group_checkpoint_prepare(log_group_t *group) noexcept {
   ut_ad(mutex_own(&m_mutex));
 
   static_assert(LOG_CHECKPOINT_SIZE <= IB_FILE_BLOCK_SIZE, "error LOG_CHECKPOINT_SIZE > IB_FILE_BLOCK_SIZE");
@@ -1031,11 +1836,12 @@ void Log::group_checkpoint(log_group_t *group) noexcept {
     checkpoint_set_nth_group_info(buf, i, 0, 0);
   }
 
-  /* Write group info for each log group */
+  /* Write group info for each log group, the number of files the offset
+  is in, it can be changed at runtime, see resize_files(). */
   auto group2 = UT_LIST_GET_FIRST(m_log_groups);
 
   while (group2 != nullptr) {
-    checkpoint_set_nth_group_info(buf, group2->id, 0, 0);
+    checkpoint_set_nth_group_info(buf, group2->id, group2->n_files, 0);
 
     group2 = UT_LIST_GET_NEXT(log_groups, group2);
   }
@@ -1054,14 +1860,19 @@ void Log::group_checkpoint(log_group_t *group) noexcept {
   /* Write the magic number for the tablespace */
   mach_write_to_4(buf + LOG_CHECKPOINT_FSP_MAGIC_N, LOG_CHECKPOINT_FSP_MAGIC_N_VAL);
 
-  ulint write_offset;
-
   /* Alternate the physical place of the checkpoint info in the first log file */
   if ((m_next_checkpoint_no & 1) == 0) {
-    write_offset = LOG_CHECKPOINT_1;
+    return LOG_CHECKPOINT_1;
   } else {
-    write_offset = LOG_CHECKPOINT_2;
+    return LOG_CHECKPOINT_2;
   }
+}
+
+void Log::group_checkpoint(log_group_t *group) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  const auto write_offset = group_checkpoint_prepare(group);
+  auto buf = group->checkpoint_buf;
 
   if (log_do_write) {
     if (m_n_pending_checkpoint_writes == 0) {
@@ -1130,7 +1941,7 @@ bool Log::checkpoint(bool sync, bool write_always) noexcept {
 
   /* Because log also contains headers and dummy log records,
   if the buffer pool contains no dirty buffers, oldest_lsn
-  gets the value m_lsn from the previous function,
+  gets the current lsn from the previous function,
   and we must make sure that the log is flushed up to that
   lsn. If there are dirty buffers in the buffer pool, then our
   write-ahead-logging algorithm ensures that the log has been flushed
@@ -1138,6 +1949,11 @@ bool Log::checkpoint(bool sync, bool write_always) noexcept {
 
   write_up_to(oldest_lsn, LOG_WAIT_ALL_GROUPS, true);
 
+  /* The log before the new checkpoint can be overwritten, archive it first. */
+  if (srv_log_arch != nullptr) {
+    srv_log_arch->archive(m_flushed_to_disk_lsn.load());
+  }
+
   acquire();
 
   if (!write_always && m_last_checkpoint_lsn >= oldest_lsn) {
@@ -1206,8 +2022,9 @@ void Log::checkpoint_margin() noexcept {
       return;
     }
 
+    const auto lsn = get_lsn();
     auto oldest_lsn = buf_pool_get_oldest_modification();
-    auto age = m_lsn - oldest_lsn;
+    auto age = lsn - oldest_lsn;
 
     if (age > m_max_modified_age_sync) {
       sync = true;
@@ -1218,7 +2035,7 @@ void Log::checkpoint_margin() noexcept {
       advance = 0;
     }
 
-    auto checkpoint_age = m_lsn - m_last_checkpoint_lsn;
+    auto checkpoint_age = lsn - m_last_checkpoint_lsn;
 
     if (checkpoint_age > m_max_checkpoint_age) {
       checkpoint_sync = true;
@@ -1242,7 +2059,18 @@ void Log::checkpoint_margin() noexcept {
       }
     }
 
-    if (do_checkpoint) {
+    if (do_checkpoint && m_threads_active.load(std::memory_order_acquire) && srv_shutdown_state != SRV_SHUTDOWN_LAST_PHASE) {
+      /* The checkpointer writes the checkpoint, over the sync margin this
+      thread waits for it and checks the age again. */
+      const auto sig_count = os_event_reset(m_checkpoint_done_event);
+
+      os_event_set(m_checkpointer_event);
+
+      if (checkpoint_sync) {
+        (void) m_checkpoint_done_event->wait_time(CHECKPOINTER_INTERVAL, sig_count);
+        continue;
+      }
+    } else if (do_checkpoint) {
       auto success = checkpoint(checkpoint_sync, false);
 
       if (!success) {
@@ -1308,18 +2136,6 @@ void Log::check_margins() noexcept {
   release();
 }
 
-bool Log::peek_lsn(lsn_t *lsn) noexcept {
-  if (mutex_enter_nowait(&m_mutex) == 0) {
-    *lsn = m_lsn;
-
-    release();
-
-    return true;
-  } else {
-    return false;
-  }
-}
-
 void Log::print() noexcept {
   acquire();
 
@@ -1327,9 +2143,9 @@ void Log::print() noexcept {
     "Log sequence number {}\n"
     "Log flushed up to   {}\n"
     "Last checkpoint at  {}\n",
-    m_lsn,
-    m_flushed_to_disk_lsn,
-    m_last_checkpoint_lsn
+    get_lsn(),
+    m_flushed_to_disk_lsn.load(),
+    m_last_checkpoint_lsn.load()
    ));
 
   auto current_time = time(nullptr);
@@ -1356,12 +2172,7 @@ void Log::refresh_stats() noexcept {
 }
 
 void Log::group_close(log_group_t *group) noexcept {
-  for (ulint i = 0; i < group->n_files; ++i) {
-    mem_free(group->file_header_bufs_ptr[i]);
-  }
-
-  mem_free(group->file_header_bufs);
-  mem_free(group->file_header_bufs_ptr);
+  group_free_file_header_bufs(group);
 
   mem_free(group->checkpoint_buf_ptr);
 
@@ -1369,6 +2180,8 @@ void Log::group_close(log_group_t *group) noexcept {
 }
 
 void Log::shutdown() noexcept {
+  stop_threads();
+
   /* This can happen if we have to abort during startup. */
   if (log_sys == nullptr || UT_LIST_GET_LEN(m_log_groups) == 0) {
     return;
@@ -1387,11 +2200,18 @@ void Log::shutdown() noexcept {
 
   mem_free(m_buf_ptr);
   m_buf_ptr = nullptr;
+  mem_free(m_write_buf_ptr);
+  m_write_buf_ptr = nullptr;
   mem_free(m_checkpoint_buf_ptr);
   m_checkpoint_buf_ptr = nullptr;
 
   os_event_free(m_no_flush_event);
   os_event_free(m_one_flushed_event);
+  os_event_free(m_writer_event);
+  os_event_free(m_flusher_event);
+  os_event_free(m_commit_event);
+  os_event_free(m_checkpointer_event);
+  os_event_free(m_checkpoint_done_event);
 
   rw_lock_free(&m_checkpoint_lock);
 }
@@ -1405,6 +2225,10 @@ void Log::destroy(Log *&log_sys) noexcept {
 }
 
 void Log::free_check() noexcept {
+  if (unlikely(m_buf_grow_requested.load(std::memory_order_relaxed))) {
+    grow_buffer();
+  }
+
   if (m_check_flush_or_checkpoint) {
     check_margins();
   }
@@ -35,6 +35,7 @@ Created 9/20/1997 Heikki Tuuri
 #include "mem0mem.h"
 #include "mtr0log.h"
 #include "mtr0mtr.h"
+#include "os0thread-create.h"
 #include "page0cur.h"
 #include "srv0srv.h"
 #include "sync0sync.h"
@@ -42,16 +43,41 @@ Created 9/20/1997 Heikki Tuuri
 #include "trx0roll.h"
 #include "trx0undo.h"
 
-/** Log records are stored in the hash table in chunks at most of this size;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** The log records of a page are stored in chunks at most of this size;
 this must be less than UNIV_PAGE_SIZE as it is stored in the buffer pool */
-constexpr ulint RECV_DATA_BLOCK_SIZE = MEM_MAX_ALLOC_IN_BUF - sizeof(Log_record_data);
+constexpr ulint RECV_CHUNK_MAX_SIZE = MEM_MAX_ALLOC_IN_BUF - sizeof(Log_record_chunk);
+
+/** Size of the first chunk of the log records of a page, the following
+ones double in size */
+constexpr ulint RECV_CHUNK_MIN_SIZE = 64;
+
+/** ORed to the type of a stored log record that is the first of its mtr
+for the page: the start lsn and the length of the mtr follow the type. The
+other records of the mtr don't repeat them. */
+constexpr byte RECV_NEW_MTR_FLAG = 0x80;
+
+/** Stored record length that means the length is in the next 4 bytes. */
+constexpr ulint RECV_LONG_LEN = 0xFFFF;
 
 /** Read-ahead area in applying log records to file pages */
 constexpr ulint RECV_READ_AHEAD_AREA = 32;
 
+/** How often the progress of an apply batch is printed. */
+constexpr auto RECV_APPLY_PROGRESS_INTERVAL = std::chrono::seconds(10);
+
 /** The recovery system */
 Recv_sys *recv_sys = nullptr;
 
+Recv_stats recv_stats;
+
 /** true when applying redo log records during crash recovery; false
 otherwise.  Note that this is false while a background thread is
 rolling back incomplete transactions. */
@@ -106,22 +132,17 @@ lsn_t recv_max_page_lsn;
  */
 static void recv_start_crash_recovery(DBLWR *dblwr, ib_recovery_t recovery) noexcept;
 
-static std::string to_string(const Recv_sys::Tablespace_map &log_records) noexcept {
+static std::string to_string(const Recv_sys::Page_map &log_records) noexcept {
   std::string str{};
 
-  for (const auto &[space_id, log_records_map] : log_records) {
-    str += "{";
-    for (const auto &[page_no, log_record] : log_records_map) {
-      str += std::format(
-        " space_id: {}, page_no: {}, log_records: {{\n",
-        space_id,
-        page_no
-      );
-
-      str += log_record->to_string() + "},\n";
+  for (const auto &[page_id, log_record] : log_records) {
+    str += std::format(
+      "{{ space_id: {}, page_no: {}, log_records: {{\n",
+      page_id.m_space_id,
+      page_id.m_page_no
+    );
 
-    }
-    str += "},\n";
+    str += log_record->to_string() + "}},\n";
   }
 
   str += "},\n";
@@ -208,15 +229,9 @@ void Recv_sys::open(ulint available_memory) noexcept {
 }
 
 void Recv_sys::clear_log_records() noexcept {
-  for (auto &[space, page_recs] : m_log_records) {
-    for (auto &[page_no, recs] : page_recs) {
-      for (auto recv = recs->m_rec_head; recv != nullptr; recv = recs->m_rec_head) {
-        recs->m_rec_head = recv->m_next;
-        call_destructor(recv);
-      }
-      call_destructor(recs);
-    }
-    page_recs.clear();
+  /* The chunks and the records are in m_heap. */
+  for (auto &[page_id, page_recs] : m_log_records) {
+    call_destructor(page_recs);
   }
 
   m_log_records.clear();
@@ -236,6 +251,9 @@ void Recv_sys::reset() noexcept {
 
   clear_log_records();
 
+  m_prefetch.clear();
+  m_n_prefetched = 0;
+
   mem_heap_empty(m_heap);
 }
 
@@ -307,7 +325,7 @@ static void recv_truncate_group(log_group_t *group, lsn_t recovered_lsn, lsn_t l
 
       auto len = ulint(end_lsn - start_lsn);
 
-      log_sys->group_write_buf(group, log_sys->m_buf, len, start_lsn, 0);
+      log_sys->group_write_buf(group, log_sys->m_buf, len, start_lsn, 0, false);
 
       if (end_lsn >= finish_lsn) {
 
@@ -350,7 +368,7 @@ static void recv_copy_group(log_group_t *up_to_date_group, log_group_t *group, l
 
     auto len = (ulint)(end_lsn - start_lsn);
 
-    log_sys->group_write_buf(group, log_sys->m_buf, len, start_lsn, 0);
+    log_sys->group_write_buf(group, log_sys->m_buf, len, start_lsn, 0, false);
 
     if (end_lsn >= recovered_lsn) {
 
@@ -399,7 +417,12 @@ static void recv_synchronize_groups(log_group_t *up_to_date_group) noexcept {
   /* Copy the checkpoint info to the groups; remember that we have
   incremented checkpoint_no by one, and the info will not be written
   over the max checkpoint info, thus making the preservation of max
-  checkpoint info on disk certain */
+  checkpoint info on disk certain. A read-only instance leaves the
+  checkpoint info as it is. */
+
+  if (srv_config.m_read_only) {
+    return;
+  }
 
   log_sys->groups_write_checkpoint_info();
 
@@ -490,17 +513,6 @@ static db_err recv_find_max_checkpoint(log_group_t **max_group, ulint *max_field
   }
 }
 
-/**
- * Checks if the log block checksum is valid.
- * 
- * @param block Pointer to a log block
- * 
- * @return true if the checksum is valid or if the block is in an old format, false otherwise
- */
-static bool is_log_block_checksum_ok(const byte *block) noexcept {
-  return Log::block_calc_checksum(block) == Log::block_get_checksum(block);
-}
-
 /**
  * Parses and applies a log record body.
  * 
@@ -609,6 +621,10 @@ static byte *recv_parse_or_apply_log_rec_body(
         ptr = page_parse_copy_rec_list_to_created_page(ptr, end_ptr, block, index, mtr);
       }
       break;
+    case MLOG_PAGE_BUILT:
+      ut_ad(page == nullptr || page_type == FIL_PAGE_TYPE_INDEX);
+      ptr = page_parse_built(ptr, end_ptr, block);
+      break;
     case MLOG_PAGE_REORGANIZE:
       ut_ad(page == nullptr || page_type == FIL_PAGE_TYPE_INDEX);
 
@@ -616,6 +632,13 @@ static byte *recv_parse_or_apply_log_rec_body(
         ptr = srv_btree_sys->parse_page_reorganize(ptr, end_ptr, index, block, mtr);
       }
       break;
+    case MLOG_PAGE_COMPACT:
+      ut_ad(page == nullptr || page_type == FIL_PAGE_TYPE_INDEX);
+
+      if ((ptr = mlog_parse_index(ptr, end_ptr, index)) != nullptr) {
+        ptr = page_parse_compact(ptr, end_ptr, block, index, mtr);
+      }
+      break;
     case MLOG_PAGE_CREATE:
       if ((ptr = mlog_parse_index(ptr, end_ptr, index)) != nullptr) {
         /* Allow anything in page_type when creating a page. */
@@ -669,7 +692,7 @@ static byte *recv_parse_or_apply_log_rec_body(
       break;
     default:
       ptr = nullptr;
-      recv_sys->m_found_corrupt_log = true;
+      recv_set_found_corrupt_log();
   }
 
   // Get rid of the dummy index, it's too cosstly to create and destroy so frequently.
@@ -691,16 +714,49 @@ static byte *recv_parse_or_apply_log_rec_body(
  * @return	file address struct, nullptr if not found from the hash table
  */
 static Page_log_records *recv_get_log_record(space_id_t space, page_no_t page_no) noexcept {
-  auto space_it = recv_sys->m_log_records.find(space);
+  auto it = recv_sys->m_log_records.find(Page_id(space, page_no));
+
+  return it == recv_sys->m_log_records.end() ? nullptr : it->second;
+}
 
-  if (space_it == recv_sys->m_log_records.end()) {
-    return nullptr;
+void Recv_sys::add_chunk(Page_log_records *page_recs, ulint min_size) noexcept {
+  auto tail = page_recs->m_tail;
+  auto size = tail == nullptr ? RECV_CHUNK_MIN_SIZE : std::min(ulint(tail->m_size) * 2, RECV_CHUNK_MAX_SIZE);
+
+  size = std::min(std::max(size, min_size), RECV_CHUNK_MAX_SIZE);
+
+  auto chunk = reinterpret_cast<Log_record_chunk *>(mem_heap_alloc(m_heap, sizeof(Log_record_chunk) + size));
+
+  new (chunk) Log_record_chunk();
+
+  chunk->m_size = uint32_t(size);
+
+  if (tail == nullptr) {
+    page_recs->m_head = chunk;
+  } else {
+    tail->m_next = chunk;
   }
 
-  auto &page_map = space_it->second;
-  auto page_it = page_map.find(page_no);
+  page_recs->m_tail = chunk;
+}
 
-  return page_it == page_map.end() ? nullptr : page_it->second;
+void Recv_sys::append(Page_log_records *page_recs, const byte *ptr, ulint len) noexcept {
+  while (len > 0) {
+    auto chunk = page_recs->m_tail;
+
+    if (chunk->m_used == chunk->m_size) {
+      add_chunk(page_recs, len);
+      chunk = page_recs->m_tail;
+    }
+
+    const auto n = std::min(len, ulint(chunk->m_size - chunk->m_used));
+
+    memcpy(chunk->data() + chunk->m_used, ptr, n);
+
+    chunk->m_used += uint32_t(n);
+    ptr += n;
+    len -= n;
+  }
 }
 
 void Recv_sys::add_log_record(
@@ -719,15 +775,6 @@ void Recv_sys::add_log_record(
     return;
   }
 
-  auto recv = reinterpret_cast<Log_record *>(mem_heap_alloc(m_heap, sizeof(Log_record)));
-
-  new (recv) Log_record();
-
-  recv->m_type = type;
-  recv->m_end_lsn = end_lsn;
-  recv->m_len = rec_end - body;
-  recv->m_start_lsn = start_lsn;
-
   auto log_record = recv_get_log_record(space, page_no);
 
   if (log_record == nullptr) {
@@ -735,72 +782,172 @@ void Recv_sys::add_log_record(
 
     new (log_record) Page_log_records();
 
-    log_record->m_rec_head = recv;
-    log_record->m_rec_tail = recv;
-
-    m_log_records[space][page_no] = log_record;
+    m_log_records.emplace(Page_id(space, page_no), log_record);
 
     ++m_n_log_records;
-  } else {
-    log_record->m_rec_tail->m_next = recv;
+
+    m_prefetch.push_back(Page_id(space, page_no));
   }
 
-  ut_a(recv->m_next == nullptr);
-  log_record->m_rec_tail = recv;
+  const auto len = ulint(rec_end - body);
 
-  auto prev_field = &recv->m_data;
+  ++recv_stats.m_phases[RECV_PHASE_PARSE].m_n_items;
+  recv_stats.m_phases[RECV_PHASE_PARSE].m_n_bytes += len;
 
-  /* Store the log record body in chunks of less than UNIV_PAGE_SIZE:
-  m_heap grows into the buffer pool, and bigger chunks could not
-  be allocated */
+  const auto new_mtr = log_record->m_head == nullptr || log_record->m_last_start_lsn != start_lsn;
 
-  while (rec_end > body) {
+  std::array<byte, 1 + 8 + 4 + 2 + 4> hdr;
+  ulint n{};
 
-    auto len = ulint(rec_end - body);
+  ut_ad(!(type & RECV_NEW_MTR_FLAG));
+  hdr[n++] = new_mtr ? byte(type | RECV_NEW_MTR_FLAG) : byte(type);
 
-    if (len > RECV_DATA_BLOCK_SIZE) {
-      len = RECV_DATA_BLOCK_SIZE;
-    }
+  if (new_mtr) {
+    mach_write_to_8(&hdr[n], start_lsn);
+    n += 8;
 
-    auto recv_data = reinterpret_cast<Log_record_data *>(mem_heap_alloc(m_heap, sizeof(Log_record_data) + len));
+    mach_write_to_4(&hdr[n], uint32_t(end_lsn - start_lsn));
+    n += 4;
 
-    *prev_field = recv_data;
+    log_record->m_last_start_lsn = start_lsn;
+  }
 
-    memcpy(recv_data + 1, body, len);
+  if (len < RECV_LONG_LEN) {
+    mach_write_to_2(&hdr[n], len);
+    n += 2;
+  } else {
+    mach_write_to_2(&hdr[n], RECV_LONG_LEN);
+    n += 2;
+
+    mach_write_to_4(&hdr[n], uint32_t(len));
+    n += 4;
+  }
 
-    prev_field = &recv_data->m_next;
+  /* Start a new chunk if the record does not fit in the last one, so that
+  the body of a record is contiguous unless it is bigger than a chunk. */
+  auto tail = log_record->m_tail;
 
-    body += len;
+  if (tail == nullptr || tail->m_size - tail->m_used < n + len) {
+    add_chunk(log_record, n + len);
   }
 
-  *prev_field = nullptr;
+  append(log_record, hdr.data(), n);
+  append(log_record, body, len);
 }
 
-/**
- * Copies the log record body from recv to buf.
- * @param buf The buffer to copy the log record body to.
- * @param recv The log record.
- */
-static void recv_data_copy_to_buf(byte *buf, Log_record *recv) noexcept {
-  ulint part_len;
+/** Decodes the log records of a page in lsn order. */
+struct Log_record_reader {
+  /**
+   * Constructor.
+   *
+   * @param[in] page_recs       Records of the page.
+   */
+  explicit Log_record_reader(const Page_log_records *page_recs) noexcept : m_chunk(page_recs->m_head) {}
+
+  /**
+   * Decodes the next record.
+   *
+   * @param[out] rec            The record, its body is valid until the next call.
+   *
+   * @return false if there are no more records.
+   */
+  [[nodiscard]] bool next(Log_record &rec) noexcept {
+    skip_used();
+
+    if (m_chunk == nullptr) {
+      return false;
+    }
 
-  auto len = recv->m_len;
-  auto recv_data = recv->m_data;
+    byte type;
 
-  while (len > 0) {
-    if (len > RECV_DATA_BLOCK_SIZE) {
-      part_len = RECV_DATA_BLOCK_SIZE;
+    read(&type, 1);
+
+    if (type & RECV_NEW_MTR_FLAG) {
+      std::array<byte, 8 + 4> lsns;
+
+      read(lsns.data(), lsns.size());
+
+      m_start_lsn = mach_read_from_8(lsns.data());
+      m_end_lsn = m_start_lsn + mach_read_from_4(lsns.data() + 8);
+    }
+
+    std::array<byte, 4> len_buf;
+
+    read(len_buf.data(), 2);
+
+    ulint len = mach_read_from_2(len_buf.data());
+
+    if (len == RECV_LONG_LEN) {
+      read(len_buf.data(), 4);
+      len = mach_read_from_4(len_buf.data());
+    }
+
+    rec.m_type = mlog_type_t(type & ~RECV_NEW_MTR_FLAG);
+    rec.m_len = uint32_t(len);
+    rec.m_start_lsn = m_start_lsn;
+    rec.m_end_lsn = m_end_lsn;
+
+    skip_used();
+
+    if (len > 0 && m_chunk != nullptr && m_chunk->m_used - m_offset >= len) {
+      rec.m_body = m_chunk->data() + m_offset;
+      m_offset += len;
     } else {
-      part_len = len;
+      /* The body spans chunks. */
+      m_buf.resize(len + 1);
+      read(m_buf.data(), len);
+      rec.m_body = m_buf.data();
     }
 
-    memcpy(buf, reinterpret_cast<byte *>(recv_data) + sizeof(Log_record_data), part_len);
-    buf += part_len;
-    len -= part_len;
+    return true;
+  }
 
-    recv_data = recv_data->m_next;
+ private:
+  /** Moves to the next chunk if the current one has been read. */
+  void skip_used() noexcept {
+    while (m_chunk != nullptr && m_offset == m_chunk->m_used) {
+      m_chunk = m_chunk->m_next;
+      m_offset = 0;
+    }
   }
-}
+
+  /**
+   * Copies bytes from the chunks.
+   *
+   * @param[out] ptr            Where to copy.
+   * @param[in] len             Number of bytes, they must have been stored.
+   */
+  void read(byte *ptr, ulint len) noexcept {
+    while (len > 0) {
+      skip_used();
+      ut_a(m_chunk != nullptr);
+
+      const auto n = std::min(len, ulint(m_chunk->m_used - m_offset));
+
+      memcpy(ptr, m_chunk->data() + m_offset, n);
+
+      m_offset += n;
+      ptr += n;
+      len -= n;
+    }
+  }
+
+ private:
+  /** Chunk being read */
+  Log_record_chunk *m_chunk{};
+
+  /** Offset of the next record in m_chunk */
+  ulint m_offset{};
+
+  /** Start lsn of the mtr of the last record */
+  lsn_t m_start_lsn{};
+
+  /** End lsn of the mtr of the last record */
+  lsn_t m_end_lsn{};
+
+  /** Copy of a record body that spans chunks */
+  std::vector<byte> m_buf{};
+};
 
 void recv_recover_page(bool just_read_in, Buf_block *block) noexcept {
   mtr_t mtr;
@@ -878,52 +1025,36 @@ void recv_recover_page(bool just_read_in, Buf_block *block) noexcept {
   lsn_t start_lsn{};
   bool modification_to_page{};
 
-  ut_a(log_record->m_rec_head != nullptr);
-
-  for (auto recv{log_record->m_rec_head}; recv != nullptr; recv = recv->m_next) {  
-    byte *buf;
-    byte *ptr{};
-
-    end_lsn = recv->m_end_lsn;
-
-    if (recv->m_len > RECV_DATA_BLOCK_SIZE) {
-      /* We have to copy the record body to a separate buffer */
+  ut_a(log_record->m_head != nullptr);
 
-      ptr = buf = static_cast<byte *>(mem_alloc(recv->m_len));
+  Log_record rec;
+  Log_record_reader reader(log_record);
 
-      recv_data_copy_to_buf(buf, recv);
+  while (reader.next(rec)) {
+    end_lsn = rec.m_end_lsn;
 
-    } else {
-      buf = reinterpret_cast<byte *>(recv->m_data) + sizeof(Log_record_data);
-    }
-
-    if (recv->m_type == MLOG_INIT_FILE_PAGE) {
+    if (rec.m_type == MLOG_INIT_FILE_PAGE) {
       page_lsn = page_newest_lsn;
 
       memset(FIL_PAGE_LSN + page, 0, 8);
       memset(UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + page, 0, 8);
     }
 
-    if (recv->m_start_lsn >= page_lsn) {
+    if (rec.m_start_lsn >= page_lsn) {
 
       if (!modification_to_page) {
 
         modification_to_page = true;
-        start_lsn = recv->m_start_lsn;
+        start_lsn = rec.m_start_lsn;
       }
 
-      recv_parse_or_apply_log_rec_body(recv->m_type, buf, buf + recv->m_len, block, &mtr);
+      recv_parse_or_apply_log_rec_body(rec.m_type, rec.m_body, rec.m_body + rec.m_len, block, &mtr);
 
-      end_lsn = recv->m_start_lsn + recv->m_len;
+      end_lsn = rec.m_start_lsn + rec.m_len;
 
       mach_write_to_8(FIL_PAGE_LSN + page, end_lsn);
       mach_write_to_8(UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + page, end_lsn);
     }
-
-    if (recv->m_len > RECV_DATA_BLOCK_SIZE) {
-      ut_a(ptr != nullptr && ptr == buf);
-      mem_free(ptr);
-    }
   }
 
   mutex_enter(&recv_sys->m_mutex);
@@ -942,7 +1073,7 @@ void recv_recover_page(bool just_read_in, Buf_block *block) noexcept {
   if (modification_to_page) {
     ut_a(block != nullptr);
 
-    srv_buf_pool->m_flusher->recv_note_modification(block, start_lsn, end_lsn);
+    srv_buf_pool->recv_note_modification(block, start_lsn, end_lsn);
   }
 
   /* Make sure that committing mtr does not change the modification
@@ -989,105 +1120,148 @@ static ulint recv_read_in_area(space_id_t space, page_no_t start_page_no) noexce
 
   buf_read_recv_pages(false, space, page_nos.data(), n);
 
+  recv_stats.m_phases[RECV_PHASE_APPLY].m_n_pages_read += n;
+
   return n;
 }
 
-void recv_apply_log_recs(DBLWR *dblwr, bool flush_and_free_pages) noexcept {
-  for (;;) {
+/**
+ * Applies the log records to the pages of a partition. The pages that are in
+ * the buffer pool are recovered by the worker, the others are read in and the
+ * i/o handler threads recover them when the reads complete.
+ *
+ * @param[in] id                Partition of the worker.
+ * @param[in] n_workers         Number of partitions.
+ */
+static void recv_apply_worker(ulint id, ulint n_workers) noexcept {
+  for (const auto &[page_id, log_record] : recv_sys->m_log_records) {
+    const auto space_id = page_id.m_space_id;
+    const auto page_no = page_id.m_page_no;
+
+    /* A read-ahead area belongs to one worker, recv_read_in_area() reads
+    its pages together. */
+    if ((ulint(space_id) + page_no / RECV_READ_AHEAD_AREA) % n_workers != id) {
+      continue;
+    }
+
     mutex_enter(&recv_sys->m_mutex);
 
-    if (!recv_sys->m_apply_batch_on) {
-      break;
-    }
+    const auto state = log_record->m_state;
 
     mutex_exit(&recv_sys->m_mutex);
 
-    os_thread_sleep(100000);
-  }
-
-  recv_sys->m_apply_log_recs = true;
-  recv_sys->m_apply_batch_on = true;
+    if (state != RECV_NOT_PROCESSED) {
+      continue;
+    }
 
-  const ulint n_total{ recv_sys->m_n_log_records };
+    if (srv_buf_pool->peek(space_id, page_no)) {
 
-  ulint n_recs{};
-  bool printed_header{};
+      mtr_t mtr;
 
-  for (const auto &[space_id, log_records_map] : recv_sys->m_log_records) {
+      mtr.start();
 
-    for (const auto &[page_no, log_record] : log_records_map) {
+      Buf_pool::Request req {
+        .m_rw_latch = RW_X_LATCH,
+        .m_page_id = { space_id, page_no },
+        .m_mode = BUF_GET,
+        .m_file = __FILE__,
+        .m_line = __LINE__,
+        .m_mtr = &mtr
+      };
 
-      if (log_record->m_state == RECV_NOT_PROCESSED) {
+      auto block = srv_buf_pool->get(req, nullptr);
+      buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_NO_ORDER_CHECK));
 
-        if (!printed_header) {
-          log_info("Starting an apply batch of log records to the database");
-          log_info_hdr("Progress in percents: ");
-          printed_header = true;
-        }
+      recv_recover_page(false, block);
 
-        mutex_exit(&recv_sys->m_mutex);
+      mtr.commit();
+    } else {
+      recv_read_in_area(space_id, page_no);
+    }
+  }
+}
 
-        if (srv_buf_pool->peek(space_id, page_no)) {
+void recv_apply_log_recs(DBLWR *dblwr, bool flush_and_free_pages) noexcept {
+  const auto apply_start{std::chrono::steady_clock::now()};
 
-          mtr_t mtr;
+  for (;;) {
+    mutex_enter(&recv_sys->m_mutex);
 
-          mtr.start();
+    if (!recv_sys->m_apply_batch_on) {
+      break;
+    }
 
-          Buf_pool::Request req {
-            .m_rw_latch = RW_X_LATCH,
-            .m_page_id = { space_id, page_no },
-            .m_mode = BUF_GET,
-            .m_file = __FILE__,
-            .m_line = __LINE__,
-            .m_mtr = &mtr
-          };
+    mutex_exit(&recv_sys->m_mutex);
 
-          auto block = srv_buf_pool->get(req, nullptr);
-          buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_NO_ORDER_CHECK));
+    os_thread_sleep(100000);
+  }
 
-          recv_recover_page(false, block);
+  recv_sys->m_apply_log_recs = true;
+  recv_sys->m_apply_batch_on = true;
 
-          mtr.commit();
-        } else {
-          recv_read_in_area(space_id, page_no);
-        }
+  const ulint n_total{ recv_sys->m_n_log_records };
+  const auto printed_header{ n_total > 0 };
 
-        mutex_enter(&recv_sys->m_mutex);
-      }
+  std::vector<std::thread> workers{};
 
-      const auto pct { (n_recs * 100) / n_total };
+  if (printed_header) {
+    const auto n_workers{ std::min(srv_config.m_n_recovery_apply_threads, n_total) };
 
-      if (printed_header && pct != ((n_recs + 1) * 100) / n_total) {
-        log_info_msg(std::format("{} ", pct));
-      }
+    log_info(std::format("Starting an apply batch of log records to {} pages with {} threads", n_total, n_workers));
 
-      ++n_recs;
+    for (ulint i{}; i < n_workers; ++i) {
+      workers.push_back(create_joinable_thread(recv_apply_worker, i, n_workers));
     }
   }
 
+  const auto start{ std::chrono::steady_clock::now() };
+  auto last_print{ start };
+
   /* Wait until all the pages have been processed */
   while (recv_sys->m_n_log_records != 0) {
+    const auto n_left{ recv_sys->m_n_log_records };
 
     mutex_exit(&recv_sys->m_mutex);
 
     os_thread_sleep(100000);
 
+    const auto now{ std::chrono::steady_clock::now() };
+
+    if (now - last_print >= RECV_APPLY_PROGRESS_INTERVAL) {
+      const auto n_done{ n_total - n_left };
+      const auto elapsed{ std::chrono::duration_cast<std::chrono::seconds>(now - start).count() };
+
+      if (n_done > 0) {
+        log_info(std::format(
+          "Applied the log records to {} of {} pages ({}%), about {} seconds left",
+          n_done, n_total, (n_done * 100) / n_total, ulint(elapsed) * n_left / n_done));
+      } else {
+        log_info(std::format("Applied the log records to 0 of {} pages", n_total));
+      }
+
+      last_print = now;
+    }
+
     mutex_enter(&recv_sys->m_mutex);
   }
 
-  if (printed_header) {
-    log_info_msg("\n");
+  mutex_exit(&recv_sys->m_mutex);
+
+  for (auto &worker : workers) {
+    worker.join();
   }
 
+  mutex_enter(&recv_sys->m_mutex);
+
   if (flush_and_free_pages) {
     /* Flush all the file pages to disk and invalidate them in the buffer pool */
     mutex_exit(&recv_sys->m_mutex);
     log_sys->release();
 
-    auto n_pages = srv_buf_pool->m_flusher->batch(dblwr, BUF_FLUSH_LIST, ULINT_MAX, IB_UINT64_T_MAX);
+    auto n_pages = srv_buf_pool->flush_batch(dblwr, BUF_FLUSH_LIST, ULINT_MAX, IB_UINT64_T_MAX);
     ut_a(n_pages != ULINT_UNDEFINED);
 
-    srv_buf_pool->m_flusher->wait_batch_end(BUF_FLUSH_LIST);
+    srv_buf_pool->wait_batch_end(BUF_FLUSH_LIST);
 
     srv_buf_pool->invalidate();
 
@@ -1105,21 +1279,12 @@ void recv_apply_log_recs(DBLWR *dblwr, bool flush_and_free_pages) noexcept {
   }
 
   mutex_exit(&recv_sys->m_mutex);
+
+  recv_stats.m_phases[RECV_PHASE_APPLY].m_n_items += n_total;
+  recv_stats.add_time(RECV_PHASE_APPLY, apply_start);
 }
 
-/**
- * Tries to parse a single log record and returns its length.
- * 
- * @param ptr Pointer to the buffer.
- * @param end_ptr Pointer to the end of the buffer.
- * @param type Pointer to the type of the log record.
- * @param space Pointer to the space id.
- * @param page_no Pointer to the page number.
- * @param body Pointer to the log record body.
- * 
- * @return	length of the record, or 0 if the record was not complete
- */
-static ulint recv_parse_log_rec(
+ulint recv_parse_log_rec(
   byte *ptr,
   byte *end_ptr,
   mlog_type_t *type,
@@ -1172,13 +1337,7 @@ static ulint recv_parse_log_rec(
   return new_ptr - ptr;
 }
 
-/**
- * Calculates the new value for lsn when more data is added to the log.
- * 
- * @param lsn The old lsn.
- * @param len The length of the data added, excluding log block headers.
- */
-static lsn_t recv_calc_lsn_on_data_add(lsn_t lsn, uint64_t len) noexcept {
+lsn_t recv_calc_lsn_on_data_add(lsn_t lsn, uint64_t len) noexcept {
   auto frag_len = (ulint(lsn) % IB_FILE_BLOCK_SIZE) - LOG_BLOCK_HDR_SIZE;
 
   ut_ad(frag_len < IB_FILE_BLOCK_SIZE - LOG_BLOCK_HDR_SIZE - LOG_BLOCK_TRL_SIZE);
@@ -1482,6 +1641,249 @@ static void recv_sys_justify_left_parsing_buf() noexcept {
   recv_sys->m_recovered_offset = 0;
 }
 
+/**
+ * Issues the reads of the pages whose first log record was parsed since the
+ * last call, so that they are in the buffer pool when the batch is applied.
+ * The prefetched pages and the stored log records are kept within half of the
+ * memory available for a batch, the pages beyond that are read by the apply.
+ *
+ * @param[in] available_memory  Memory available for a batch.
+ */
+static void recv_prefetch_pages(ulint available_memory) noexcept {
+  auto &pages = recv_sys->m_prefetch;
+
+  if (pages.empty()) {
+    return;
+  }
+
+  const auto used = mem_heap_get_size(recv_sys->m_heap) + recv_sys->m_n_prefetched * UNIV_PAGE_SIZE;
+  const auto n = used < available_memory / 2 ? std::min(pages.size(), (available_memory / 2 - used) / UNIV_PAGE_SIZE) : 0;
+
+  std::sort(pages.begin(), pages.begin() + n, [](const Page_id &lhs, const Page_id &rhs) {
+    return lhs.m_space_id < rhs.m_space_id || (lhs.m_space_id == rhs.m_space_id && lhs.m_page_no < rhs.m_page_no);
+  });
+
+  std::array<page_no_t, RECV_READ_AHEAD_AREA> page_nos;
+
+  for (ulint i{}; i < n;) {
+    const auto space_id = pages[i].m_space_id;
+
+    ulint n_stored{};
+
+    while (i < n && n_stored < page_nos.size() && pages[i].m_space_id == space_id) {
+      page_nos[n_stored++] = pages[i++].m_page_no;
+    }
+
+    buf_read_recv_pages(false, space_id, page_nos.data(), n_stored);
+  }
+
+  recv_sys->m_n_prefetched += n;
+
+  recv_stats.m_phases[RECV_PHASE_SCAN].m_n_pages_read += n;
+
+  pages.clear();
+}
+
+/** Reads the log segments ahead of the recovery scan, so that the next
+segments are read while the current one is parsed. The scanning thread owns
+the log mutex and computes the file offsets of each segment, the reader only
+does the i/o. */
+struct Recv_log_reader {
+  /** Number of segments that are read ahead. */
+  static constexpr ulint N_SEGMENTS = 4;
+
+  /**
+   * Constructor, starts reading. The caller must own the log mutex.
+   *
+   * @param[in] group           Log group to read.
+   * @param[in] start_lsn       Lsn of the first segment.
+   */
+  Recv_log_reader(log_group_t *group, lsn_t start_lsn) noexcept : m_group(group), m_next_lsn(start_lsn) {
+    m_buf_ptr = static_cast<byte *>(ut_new(N_SEGMENTS * RECV_SCAN_SIZE + UNIV_PAGE_SIZE));
+    auto buf = static_cast<byte *>(ut_align(m_buf_ptr, UNIV_PAGE_SIZE));
+
+    for (auto &segment : m_segments) {
+      segment.m_buf = buf;
+      buf += RECV_SCAN_SIZE;
+
+      queue(segment);
+    }
+
+    m_thread = create_joinable_thread(&Recv_log_reader::run, this);
+  }
+
+  /** Destructor, waits for the read in progress. */
+  ~Recv_log_reader() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+
+    m_cond.notify_all();
+    m_thread.join();
+
+    ut_delete(m_buf_ptr);
+  }
+
+  /**
+   * Returns the next segment, the previous one is reused for reading ahead.
+   * The caller must own the log mutex.
+   *
+   * @param[out] start_lsn      Lsn of the segment.
+   *
+   * @return the segment of RECV_SCAN_SIZE bytes, valid until the next call.
+   */
+  [[nodiscard]] const byte *next(lsn_t &start_lsn) noexcept {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_consumed) {
+      queue(m_segments[m_next_segment % N_SEGMENTS]);
+      ++m_next_segment;
+      m_cond.notify_all();
+    }
+
+    auto &segment = m_segments[m_next_segment % N_SEGMENTS];
+
+    m_cond.wait(lock, [&segment] { return segment.m_ready; });
+
+    m_consumed = true;
+    start_lsn = segment.m_start_lsn;
+
+    return segment.m_buf;
+  }
+
+ private:
+  /** A log segment. */
+  struct Segment {
+    /** Where the segment is read to. */
+    byte *m_buf{};
+
+    /** Lsn of the start of the segment. */
+    lsn_t m_start_lsn{};
+
+    /** File offsets of the parts of the segment, it can span two files. */
+    std::array<uint64_t, 2> m_offsets{};
+
+    /** Lengths of the parts. */
+    std::array<ulint, 2> m_lens{};
+
+    /** True if the segment is waiting to be read. */
+    bool m_queued{};
+
+    /** True if the segment has been read. */
+    bool m_ready{};
+  };
+
+  /**
+   * Queues the next segment of the log for reading. The caller must own the
+   * log mutex.
+   *
+   * @param[in,out] segment     Segment to read to.
+   */
+  void queue(Segment &segment) noexcept {
+    auto lsn = m_next_lsn;
+    const auto end_lsn = lsn + RECV_SCAN_SIZE;
+
+    for (ulint i{}; lsn < end_lsn; ++i) {
+      const auto offset = log_sys->group_calc_lsn_offset(lsn, m_group);
+      auto len = ulint(end_lsn - lsn);
+
+      if ((offset % m_group->file_size) + len > m_group->file_size) {
+        len = m_group->file_size - (offset % m_group->file_size);
+      }
+
+      ut_a(i < segment.m_offsets.size());
+
+      segment.m_offsets[i] = offset;
+      segment.m_lens[i] = len;
+
+      lsn += len;
+    }
+
+    segment.m_start_lsn = m_next_lsn;
+    segment.m_queued = true;
+    segment.m_ready = false;
+
+    m_next_lsn = end_lsn;
+  }
+
+  /** The reader thread. */
+  void run() noexcept {
+    for (ulint i{};; ++i) {
+      auto &segment = m_segments[i % N_SEGMENTS];
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      m_cond.wait(lock, [this, &segment] { return m_stop || segment.m_queued; });
+
+      if (m_stop) {
+        return;
+      }
+
+      lock.unlock();
+
+      auto buf = segment.m_buf;
+
+      for (ulint j{}; j < segment.m_lens.size() && segment.m_lens[j] > 0; ++j) {
+        const auto offset = segment.m_offsets[j];
+
+        srv_fil->io(
+          IO_request::Sync_log_read,
+          false,
+          m_group->space_id,
+          offset / UNIV_PAGE_SIZE,
+          offset % UNIV_PAGE_SIZE,
+          segment.m_lens[j],
+          buf,
+          nullptr
+        );
+
+        buf += segment.m_lens[j];
+      }
+
+      lock.lock();
+
+      segment.m_queued = false;
+      segment.m_ready = true;
+
+      lock.unlock();
+
+      m_cond.notify_all();
+    }
+  }
+
+ private:
+  /** The log group that is read. */
+  log_group_t *m_group{};
+
+  /** Lsn of the next segment to queue. */
+  lsn_t m_next_lsn{};
+
+  /** Number of the segment that next() returns next. */
+  ulint m_next_segment{};
+
+  /** True if next() has returned m_next_segment. */
+  bool m_consumed{};
+
+  /** Set to stop the reader thread. */
+  bool m_stop{};
+
+  /** The segments, read in order. */
+  std::array<Segment, N_SEGMENTS> m_segments{};
+
+  /** Memory of the segment buffers. */
+  byte *m_buf_ptr{};
+
+  /** Protects the segment states and m_stop. */
+  std::mutex m_mutex{};
+
+  /** Signalled when a segment is queued or read. */
+  std::condition_variable m_cond{};
+
+  /** The reader thread. */
+  std::thread m_thread{};
+};
+
 /**
  * Scans log from a buffer and stores new log data to the parsing buffer.
  * Parses and stores the log records if new data found.  This function will
@@ -1527,7 +1929,7 @@ static bool recv_scan_log_recs(
 
   do {
     auto no = Log::block_get_hdr_no(log_block);
-    const auto checksum_ok{is_log_block_checksum_ok(log_block)};
+    const auto checksum_ok{Log::is_block_checksum_ok(log_block)};
     const auto block_no{Log::block_convert_lsn_to_no(scanned_lsn)};
 
     if (no != block_no || !checksum_ok) {
@@ -1591,6 +1993,12 @@ static bool recv_scan_log_recs(
       if (!recv_needed_recovery) {
         log_info("Log scan progressed past the checkpoint lsn ", recv_sys->m_scanned_lsn);
         recv_start_crash_recovery(dblwr, recovery);
+
+        if (srv_config.m_read_only) {
+          /* The log records are not parsed, the startup fails. */
+          finished = true;
+          break;
+        }
       }
 
       /* We were able to find more log data: add it to the parsing buffer if parse_start_lsn is already
@@ -1639,13 +2047,22 @@ static bool recv_scan_log_recs(
   if (more_data && !recv_sys->m_found_corrupt_log) {
     /* Try to parse more log records */
 
+    const auto parse_start{std::chrono::steady_clock::now()};
+
     recv_parse_log_recs(store_to_hash);
 
+    recv_stats.add_time(RECV_PHASE_PARSE, parse_start);
+    recv_stats.update_peak_memory(mem_heap_get_size(recv_sys->m_heap));
+
     if (store_to_hash && mem_heap_get_size(recv_sys->m_heap) > available_memory) {
 
       /* Hash table of log records has grown too big: empty it. */
 
       recv_apply_log_recs(dblwr, true);
+
+    } else if (store_to_hash) {
+
+      recv_prefetch_pages(available_memory);
     }
 
     if (recv_sys->m_recovered_offset > RECV_PARSING_BUF_SIZE / 4) {
@@ -1678,25 +2095,43 @@ static void recv_group_scan_log_recs(
 {
 
   bool finished = false;
-  auto start_lsn = *contiguous_lsn;
+  const auto start_lsn{*contiguous_lsn};
+  const auto start{std::chrono::steady_clock::now()};
 
-  while (!finished) {
-    auto end_lsn = start_lsn + RECV_SCAN_SIZE;
+  /* The parse and the apply batches run from within the scan, they are
+  accounted to their own phases. */
+  const uint64_t nested_us{
+    recv_stats.m_phases[RECV_PHASE_PARSE].m_time_us + recv_stats.m_phases[RECV_PHASE_APPLY].m_time_us};
+
+  Recv_log_reader reader(group, *contiguous_lsn);
 
-    log_sys->group_read_log_seg(LOG_RECOVER, log_sys->m_buf, group, start_lsn, end_lsn);
+  while (!finished) {
+    lsn_t start_lsn;
+    auto buf = reader.next(start_lsn);
 
     finished = recv_scan_log_recs(
       dblwr,
       recovery,
-      (srv_buf_pool->m_curr_size - recv_n_pool_free_frames) * UNIV_PAGE_SIZE,
+      (srv_buf_pool->get_curr_pages() - recv_n_pool_free_frames) * UNIV_PAGE_SIZE,
       true,
-      log_sys->m_buf,
+      buf,
       RECV_SCAN_SIZE,
       start_lsn,
       contiguous_lsn,
       group_scanned_lsn
     );
-    start_lsn = end_lsn;
+  }
+
+  auto &scan = recv_stats.m_phases[RECV_PHASE_SCAN];
+  const auto elapsed_us{uint64_t(
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count())};
+  const auto nested_elapsed_us{
+    recv_stats.m_phases[RECV_PHASE_PARSE].m_time_us + recv_stats.m_phases[RECV_PHASE_APPLY].m_time_us - nested_us};
+
+  scan.m_time_us += elapsed_us > nested_elapsed_us ? elapsed_us - nested_elapsed_us : 0;
+
+  if (*group_scanned_lsn > start_lsn) {
+    scan.m_n_bytes += ulint(*group_scanned_lsn - start_lsn);
   }
 }
 
@@ -1705,7 +2140,33 @@ static void recv_start_crash_recovery(DBLWR *dblwr, ib_recovery_t recovery)  noe
 
   recv_needed_recovery = true;
 
+  if (srv_config.m_read_only) {
+    /* The recovery would write to the files. */
+    log_err("Database was not shut down normally! A read-only instance cannot do crash recovery.");
+    return;
+  }
+
   log_warn("Database was not shut down normally! Starting crash recovery.");
+
+  bool loaded{};
+
+  if (srv_config.m_lazy_tablespace_load) {
+    /* The startup skipped these, a normal startup does not need them. */
+    log_warn("Reading tablespace information from the .ibd files...");
+
+    srv_fil->load_single_table_tablespaces(srv_config.m_data_home, recovery, 2);
+
+    loaded = true;
+  } else {
+    /* The startup is loading them while the log is scanned, the log records
+    can't be parsed and applied before they are loaded. */
+    loaded = srv_fil->wait_for_tablespaces();
+  }
+
+  if (loaded && recovery < IB_RECOVERY_NO_LOG_REDO) {
+    log_warn("Restoring possible half-written data pages from the doublewrite buffer...");
+    dblwr->recover_pages();
+  }
 }
 
 /**
@@ -1794,6 +2255,39 @@ db_err recv_recovery_from_checkpoint_start(DBLWR *dblwr, ib_recovery_t recovery,
 
   log_info(std::format("Found max checkpoint lsn: {}, checkpoint no: {}", checkpoint_lsn, checkpoint_no));
 
+  /* The offset is in the geometry of the group when the checkpoint was
+  written, the number of files can have been changed at runtime, see
+  Log::resize_files(). */
+  max_cp_group->lsn = checkpoint_lsn;
+  max_cp_group->lsn_offset = mach_read_from_4(buf + LOG_CHECKPOINT_OFFSET);
+
+  ulint n_files;
+  ulint unused;
+
+  log_sys->checkpoint_get_nth_group_info(buf, max_cp_group->id, &n_files, &unused);
+
+  if (n_files != 0 && n_files != max_cp_group->n_files) {
+    const auto n_found = srv_fil->space_get_size(max_cp_group->space_id) / (max_cp_group->file_size / UNIV_PAGE_SIZE);
+
+    if (n_files > n_found) {
+      log_err(std::format("The checkpoint was written with {} log files, only {} were found", n_files, n_found));
+
+      log_sys->release();
+
+      return DB_ERROR;
+    }
+
+    log_info(std::format("Using {} log files of the {} found, the number of the checkpoint", n_files, n_found));
+
+    if (!log_sys->group_set_n_files(max_cp_group, n_files)) {
+      log_sys->release();
+
+      return DB_ERROR;
+    }
+
+    srv_config.m_n_log_files = n_files;
+  }
+
   /* Start reading the log groups from the checkpoint lsn up. The
   variable contiguous_lsn contains an lsn up to which the log is
   known to be contiguously written to all log groups. */
@@ -1828,6 +2322,14 @@ db_err recv_recovery_from_checkpoint_start(DBLWR *dblwr, ib_recovery_t recovery,
 
   recv_init_crash_recovery(dblwr, recovery, checkpoint_lsn, max_flushed_lsn);
 
+  if (srv_config.m_read_only && recv_needed_recovery) {
+    log_err("The files of a read-only instance must be a copy of a cleanly shut down instance");
+
+    log_sys->release();
+
+    return DB_READONLY;
+  }
+
   /* We currently have only one log group */
   if (group_scanned_lsn < checkpoint_lsn) {
     log_err(std::format(
@@ -1871,14 +2373,7 @@ db_err recv_recovery_from_checkpoint_start(DBLWR *dblwr, ib_recovery_t recovery,
     srv_start_lsn = recv_sys->m_recovered_lsn;
   }
 
-  log_sys->m_lsn = recv_sys->m_recovered_lsn;
-
-  memcpy(log_sys->m_buf, recv_sys->m_last_block, IB_FILE_BLOCK_SIZE);
-
-  log_sys->m_buf_free = ulint(log_sys->m_lsn % IB_FILE_BLOCK_SIZE);
-  log_sys->m_buf_next_to_write = log_sys->m_buf_free;
-  log_sys->m_written_to_some_lsn = log_sys->m_lsn;
-  log_sys->m_written_to_all_lsn = log_sys->m_lsn;
+  log_sys->reset(recv_sys->m_recovered_lsn, recv_sys->m_last_block);
 
   log_sys->m_last_checkpoint_lsn = checkpoint_lsn;
 
@@ -1936,7 +2431,7 @@ void recv_recovery_from_checkpoint_finish(DBLWR *dblwr, ib_recovery_t recovery)
   recv_sys = nullptr;
 
   /* Free up the flush_rbt. */
-  srv_buf_pool->m_flusher->free_flush_list();
+  srv_buf_pool->free_flush_list();
 
   /* Roll back any recovered data dictionary transactions, so
   that the data dictionary tables will be free of any locks.
@@ -1945,6 +2440,33 @@ void recv_recovery_from_checkpoint_finish(DBLWR *dblwr, ib_recovery_t recovery)
   trx_rollback_or_clean_recovered(false);
 }
 
+/**
+ * Rolls back the recovered transactions in the background and prints the
+ * recovery summary when done.
+ *
+ * @return a dummy parameter
+ */
+static void *recv_rollback_thread(void *) noexcept {
+  const auto start{std::chrono::steady_clock::now()};
+  const auto n_undone{trx_roll_get_n_recovered_undo_recs_done()};
+
+  trx_rollback_or_clean_recovered(true);
+
+  recv_stats.m_phases[RECV_PHASE_ROLLBACK].m_n_items += trx_roll_get_n_recovered_undo_recs_done() - n_undone;
+  recv_stats.add_time(RECV_PHASE_ROLLBACK, start);
+
+  if (recv_needed_recovery) {
+    log_info(recv_stats.to_string());
+  }
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
+
 void recv_recovery_rollback_active() noexcept {
   /* This is required to set the compare context before recovery, also
   it's a one-shot. We can safely set it to nullptr after calling it. */
@@ -1962,6 +2484,12 @@ void recv_recovery_rollback_active() noexcept {
   sync_order_checks_on = true;
 #endif
 
+  if (srv_config.m_read_only) {
+    /* After a clean shutdown there is nothing to roll back, and a read-only
+    instance cannot drop anything. */
+    return;
+  }
+
   (void) srv_dict_sys->m_ddl.drop_all_temp_indexes(ib_recovery_t(srv_config.m_force_recovery));
   (void) srv_dict_sys->m_ddl.drop_all_temp_tables(ib_recovery_t(srv_config.m_force_recovery));
 
@@ -1969,17 +2497,20 @@ void recv_recovery_rollback_active() noexcept {
     /* Rollback the uncommitted transactions which have no user
     session */
 
-    os_thread_create(trx_rollback_or_clean_all_recovered, nullptr, nullptr);
+    os_thread_create(recv_rollback_thread, nullptr, nullptr);
+
+  } else if (recv_needed_recovery) {
+    log_info(recv_stats.to_string());
   }
 }
 
 void recv_reset_logs(lsn_t lsn, bool new_logs_created) noexcept {
   ut_ad(mutex_own(&log_sys->m_mutex));
 
-  log_sys->m_lsn = ut_uint64_align_up(lsn, IB_FILE_BLOCK_SIZE);
+  lsn = ut_uint64_align_up(lsn, IB_FILE_BLOCK_SIZE);
 
   for (auto group : log_sys->m_log_groups) {
-    group->lsn = log_sys->m_lsn;
+    group->lsn = lsn;
     group->lsn_offset = LOG_FILE_HDR_SIZE;
 
     if (!new_logs_created) {
@@ -1987,18 +2518,10 @@ void recv_reset_logs(lsn_t lsn, bool new_logs_created) noexcept {
     }
   }
 
-  log_sys->m_buf_next_to_write = 0;
-  log_sys->m_written_to_some_lsn = log_sys->m_lsn;
-  log_sys->m_written_to_all_lsn = log_sys->m_lsn;
-
   log_sys->m_next_checkpoint_no = 0;
   log_sys->m_last_checkpoint_lsn = 0;
 
-  log_sys->block_init(log_sys->m_buf, log_sys->m_lsn);
-  log_sys->block_set_first_rec_group(log_sys->m_buf, LOG_BLOCK_HDR_SIZE);
-
-  log_sys->m_buf_free = LOG_BLOCK_HDR_SIZE;
-  log_sys->m_lsn += LOG_BLOCK_HDR_SIZE;
+  log_sys->reset(lsn, nullptr);
 
   log_sys->release();
 
@@ -2028,28 +2551,75 @@ std::string to_string(Recv_addr_state s) noexcept {
   }
 }
 
-std::string Log_record_data::to_string() const noexcept {
-  return std::format("FIXME");
+const char *to_string(Recv_phase phase) noexcept {
+  switch (phase) {
+    case RECV_PHASE_DBLWR:
+      return "dblwr";
+    case RECV_PHASE_SCAN:
+      return "scan";
+    case RECV_PHASE_PARSE:
+      return "parse";
+    case RECV_PHASE_APPLY:
+      return "apply";
+    case RECV_PHASE_ROLLBACK:
+      return "rollback";
+    case RECV_PHASE_N:
+      break;
+  }
+
+  ut_error;
+  return nullptr;
+}
+
+std::string Recv_stats::to_string() const noexcept {
+  std::string str{"Recovery summary:"};
+
+  for (ulint i{}; i < RECV_PHASE_N; ++i) {
+    const auto &phase = m_phases[i];
+    const uint64_t time_us{phase.m_time_us};
+    const ulint n_bytes{phase.m_n_bytes};
+    const ulint n_items{phase.m_n_items};
+
+    /* Throughput per second, the time is in microseconds. */
+    const auto per_sec = [time_us](ulint n) { return time_us > 0 ? ulint(n * 1000000.0 / time_us) : 0; };
+
+    str += std::format(
+      " {}: {} ms, {} items ({}/s), {} bytes ({} MB/s), {} pages read;",
+      ::to_string(Recv_phase(i)),
+      time_us / 1000,
+      n_items,
+      per_sec(n_items),
+      n_bytes,
+      per_sec(n_bytes) / (1024 * 1024),
+      ulint(phase.m_n_pages_read)
+    );
+  }
+
+  str += std::format(" peak memory: {} bytes", ulint(m_peak_memory));
+
+  return str;
 }
 
 std::string Log_record::to_string() const noexcept {
   return std::format(
-    "m_type: {}, : {}, m_start_lsn: {}, m_end_lsn: {}, data: {}",
+    "m_type: {}, m_len: {}, m_start_lsn: {}, m_end_lsn: {}",
     mlog_type_str(m_type),
     m_len,
     m_start_lsn,
-    m_end_lsn,
-    m_data->to_string()
+    m_end_lsn
   );
 }
 
 std::string Page_log_records::to_string() const noexcept {
   std::string str{};
 
-  for (auto lr = m_rec_head; lr != nullptr; lr = lr->m_next) {
-    str += lr->to_string();
+  Log_record rec;
+  Log_record_reader reader(this);
+
+  while (reader.next(rec)) {
+    str += rec.to_string();
     str += ", ";
-  } 
+  }
 
   return str;
 }
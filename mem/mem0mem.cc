@@ -24,6 +24,11 @@ Created 6/9/1994 Heikki Tuuri
 
 #include <stdarg.h>
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 #include "buf0buf.h"
 #include "srv0srv.h"
 
@@ -82,7 +87,217 @@ borders of the buffer, which is illegal.
 The memory in the buffers is initialized to a random byte sequence.
 After freeing, all the blocks in the heap are set to random bytes
 to help us discover errors which result from the use of
-buffers in an already freed heap. */
+buffers in an already freed heap.
+
+Heaps are created and freed for nearly every row operation, so the
+blocks that are allocated with malloc are rounded up to a size class and
+recycled through a cache local to the freeing thread. The caches are
+bounded per size class; blocks that don't fit go back to free(). */
+
+/** Smallest block size class of the thread local block caches */
+constexpr ulint MEM_CACHE_MIN_CLASS_SIZE = 256;
+
+/** Number of block size classes, each class is twice the previous one.
+Larger blocks bypass the caches. */
+constexpr ulint MEM_CACHE_N_CLASSES = 7;
+
+/** Largest block size class, 16K */
+constexpr ulint MEM_CACHE_MAX_CLASS_SIZE = MEM_CACHE_MIN_CLASS_SIZE << (MEM_CACHE_N_CLASSES - 1);
+
+/** Bytes of free blocks that a thread may keep in one size class */
+constexpr ulint MEM_CACHE_CLASS_BYTES = 64 * 1024;
+
+/**
+ * @param[in] len Block length including the header
+ *
+ * @return the size class of a block, ULINT_UNDEFINED if it is not cached
+ */
+[[nodiscard]] static inline ulint mem_cache_size_class(ulint len) noexcept {
+  if (len > MEM_CACHE_MAX_CLASS_SIZE) {
+    return ULINT_UNDEFINED;
+  }
+
+  ulint size_class{};
+
+  while ((MEM_CACHE_MIN_CLASS_SIZE << size_class) < len) {
+    ++size_class;
+  }
+
+  return size_class;
+}
+
+/**
+ * @param[in] size_class Block size class
+ *
+ * @return the block length of the size class
+ */
+[[nodiscard]] static inline ulint mem_cache_class_size(ulint size_class) noexcept {
+  return MEM_CACHE_MIN_CLASS_SIZE << size_class;
+}
+
+/** Statistics of a size class of one thread. Only the owner thread
+updates them, the monitor reads them. */
+struct Mem_class_stats {
+  /** Blocks allocated */
+  std::atomic<uint64_t> m_allocs{};
+
+  /** Allocations served from the cache */
+  std::atomic<uint64_t> m_hits{};
+
+  /** Blocks freed */
+  std::atomic<uint64_t> m_frees{};
+
+  /** Frees that went to free() because the cache was full */
+  std::atomic<uint64_t> m_overflows{};
+
+  /** Adds one to a counter, there is no other writer */
+  static void inc(std::atomic<uint64_t> &counter) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+};
+
+/** Statistics of a size class, summed over threads */
+struct Mem_class_totals {
+  uint64_t m_allocs{};
+  uint64_t m_hits{};
+  uint64_t m_frees{};
+  uint64_t m_overflows{};
+
+  /** Adds the statistics of a thread.
+  @param[in] stats              Statistics of one thread */
+  void add(const Mem_class_stats &stats) noexcept {
+    m_allocs += stats.m_allocs.load(std::memory_order_relaxed);
+    m_hits += stats.m_hits.load(std::memory_order_relaxed);
+    m_frees += stats.m_frees.load(std::memory_order_relaxed);
+    m_overflows += stats.m_overflows.load(std::memory_order_relaxed);
+  }
+};
+
+struct Mem_block_cache;
+
+/** The thread local caches, for reporting */
+struct Mem_block_caches {
+  /** Protects the fields below, the caches themselves are not shared */
+  std::mutex m_mutex{};
+
+  /** Caches of the running threads */
+  std::vector<Mem_block_cache *> m_caches{};
+
+  /** Statistics of the threads that have exited */
+  std::array<Mem_class_totals, MEM_CACHE_N_CLASSES> m_exited{};
+};
+
+/** @return the registry of the thread local caches */
+static Mem_block_caches &mem_block_caches() noexcept {
+  static Mem_block_caches caches;
+
+  return caches;
+}
+
+/** Free heap blocks of the standard size classes, private to a thread */
+struct Mem_block_cache {
+  /** A cached block, the link is kept in the block itself */
+  struct Free_block {
+    Free_block *m_next;
+  };
+
+  /** Free blocks of one size class */
+  struct Size_class {
+    /** Head of the free list */
+    Free_block *m_head{};
+
+    /** Length of the free list */
+    ulint m_n_blocks{};
+  };
+
+  Mem_block_cache() noexcept {
+    auto &caches = mem_block_caches();
+    std::lock_guard<std::mutex> guard(caches.m_mutex);
+
+    caches.m_caches.push_back(this);
+  }
+
+  ~Mem_block_cache() noexcept {
+    for (ulint i{}; i < MEM_CACHE_N_CLASSES; ++i) {
+      auto &cached = m_classes[i];
+
+      while (cached.m_head != nullptr) {
+        auto block = cached.m_head;
+
+        cached.m_head = block->m_next;
+        ut_mem_tag_free(Mem_tag::HEAP_CACHE, mem_cache_class_size(i));
+        ::free(block);
+      }
+    }
+
+    auto &caches = mem_block_caches();
+    std::lock_guard<std::mutex> guard(caches.m_mutex);
+
+    for (ulint i{}; i < MEM_CACHE_N_CLASSES; ++i) {
+      caches.m_exited[i].add(m_stats[i]);
+    }
+
+    std::erase(caches.m_caches, this);
+  }
+
+  /**
+   * @param[in] size_class Block size class
+   *
+   * @return a block of the size class
+   */
+  [[nodiscard]] void *alloc(ulint size_class) noexcept {
+    auto &cached = m_classes[size_class];
+    auto &stats = m_stats[size_class];
+
+    Mem_class_stats::inc(stats.m_allocs);
+
+    if (cached.m_head != nullptr) {
+      auto block = cached.m_head;
+
+      cached.m_head = block->m_next;
+      --cached.m_n_blocks;
+
+      Mem_class_stats::inc(stats.m_hits);
+      ut_mem_tag_free(Mem_tag::HEAP_CACHE, mem_cache_class_size(size_class));
+
+      return block;
+    }
+
+    return ::malloc(mem_cache_class_size(size_class));
+  }
+
+  /**
+   * @param[in] ptr Block to free
+   * @param[in] size_class Block size class
+   */
+  void free(void *ptr, ulint size_class) noexcept {
+    auto &cached = m_classes[size_class];
+    auto &stats = m_stats[size_class];
+
+    Mem_class_stats::inc(stats.m_frees);
+
+    if (cached.m_n_blocks * mem_cache_class_size(size_class) >= MEM_CACHE_CLASS_BYTES) {
+      Mem_class_stats::inc(stats.m_overflows);
+      ::free(ptr);
+    } else {
+      auto block = static_cast<Free_block *>(ptr);
+
+      block->m_next = cached.m_head;
+      cached.m_head = block;
+      ++cached.m_n_blocks;
+      ut_mem_tag_alloc(Mem_tag::HEAP_CACHE, mem_cache_class_size(size_class));
+    }
+  }
+
+  /** Free lists, by size class */
+  std::array<Size_class, MEM_CACHE_N_CLASSES> m_classes{};
+
+  /** Statistics, by size class */
+  std::array<Mem_class_stats, MEM_CACHE_N_CLASSES> m_stats{};
+};
+
+/** Heap block cache of this thread */
+static thread_local Mem_block_cache mem_block_cache;
 
 char *mem_heap_strdup(mem_heap_t *heap, const char *str) {
   return static_cast<char *>(mem_heap_dup(heap, str, strlen(str) + 1));
@@ -245,12 +460,22 @@ mem_block_t *mem_heap_create_block(mem_heap_t *heap, ulint n, ulint type, Source
   Buf_block *buf_block{};
 
   auto len = mem_block_header_size() + MEM_SPACE_NEEDED(n);
+  const auto tag = heap == nullptr ? ut_mem_tag_of(loc.m_from.file_name()) : heap->m_tag;
 
   if (type == MEM_HEAP_DYNAMIC || len < UNIV_PAGE_SIZE / 2) {
 
     ut_a(type == MEM_HEAP_DYNAMIC || n <= MEM_MAX_ALLOC_IN_BUF);
 
-    block = (mem_block_t *)malloc(len);
+    const auto size_class = mem_cache_size_class(len);
+
+    if (size_class != ULINT_UNDEFINED) {
+      len = mem_cache_class_size(size_class);
+      block = (mem_block_t *)mem_block_cache.alloc(size_class);
+    } else {
+      block = (mem_block_t *)malloc(len);
+    }
+
+    ut_mem_tag_alloc(tag, len);
   } else {
 
     len = UNIV_PAGE_SIZE;
@@ -279,6 +504,7 @@ mem_block_t *mem_heap_create_block(mem_heap_t *heap, ulint n, ulint type, Source
 
   block->magic_n = MEM_BLOCK_MAGIC_N;
   block->m_loc = loc;
+  block->m_tag = tag;
 
   mem_block_set_len(block, len);
   mem_block_set_type(block, type);
@@ -356,7 +582,6 @@ void mem_heap_block_free(mem_heap_t *heap, mem_block_t *block) {
   ut_ad(heap->total_size >= block->len);
   heap->total_size -= block->len;
 
-  auto type = heap->type;
   auto len = block->len;
 
   block->magic_n = MEM_FREED_BLOCK_MAGIC_N;
@@ -364,14 +589,58 @@ void mem_heap_block_free(mem_heap_t *heap, mem_block_t *block) {
   if (!srv_config.m_use_sys_malloc) {
     UNIV_MEM_ASSERT_AND_FREE(block, len);
   }
-  if (type == MEM_HEAP_DYNAMIC || len < UNIV_PAGE_SIZE / 2) {
 
-    free(block);
+  /* Blocks are rounded up to a size class, so the length no longer tells
+  whether the block came from the buffer pool. */
+  if (buf_block == nullptr) {
+    const auto size_class = mem_cache_size_class(len);
+
+    ut_mem_tag_free(block->m_tag, len);
+
+    if (size_class != ULINT_UNDEFINED) {
+      mem_block_cache.free(block, size_class);
+    } else {
+      free(block);
+    }
   } else {
     srv_buf_pool->block_free(buf_block);
   }
 }
 
+void mem_heap_cache_print() noexcept {
+  std::array<Mem_class_totals, MEM_CACHE_N_CLASSES> totals{};
+  auto &caches = mem_block_caches();
+
+  {
+    std::lock_guard<std::mutex> guard(caches.m_mutex);
+
+    totals = caches.m_exited;
+
+    for (auto cache : caches.m_caches) {
+      for (ulint i{}; i < MEM_CACHE_N_CLASSES; ++i) {
+        totals[i].add(cache->m_stats[i]);
+      }
+    }
+  }
+
+  for (ulint i{}; i < MEM_CACHE_N_CLASSES; ++i) {
+    const auto &total = totals[i];
+
+    if (total.m_allocs == 0) {
+      continue;
+    }
+
+    log_warn(std::format(
+      "Heap blocks of {} bytes: allocated {}, from thread cache {}, freed {}, cache full {}",
+      mem_cache_class_size(i),
+      total.m_allocs,
+      total.m_hits,
+      total.m_frees,
+      total.m_overflows
+    ));
+  }
+}
+
 void mem_heap_free_block_free(mem_heap_t *heap) {
   if (likely_null(heap->free_block)) {
     srv_buf_pool->block_free(static_cast<Buf_block *>(heap->free_block));
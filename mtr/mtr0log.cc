@@ -105,7 +105,7 @@ byte *mlog_parse_nbytes(mlog_type_t type, byte *ptr, byte *end_ptr, byte *page)
   ptr += 2;
 
   if (offset >= UNIV_PAGE_SIZE) {
-    recv_sys->m_found_corrupt_log = true;
+    recv_set_found_corrupt_log();
 
     return nullptr;
   }
@@ -156,7 +156,7 @@ byte *mlog_parse_nbytes(mlog_type_t type, byte *ptr, byte *end_ptr, byte *page)
       break;
     default:
     corrupt:
-      recv_sys->m_found_corrupt_log = true;
+      recv_set_found_corrupt_log();
       ptr = nullptr;
   }
 
@@ -263,7 +263,7 @@ byte *mlog_parse_string(byte *ptr, byte *end_ptr, byte *page) {
   ptr += 2;
 
   if (offset >= UNIV_PAGE_SIZE || len + offset > UNIV_PAGE_SIZE) {
-    recv_sys->m_found_corrupt_log = true;
+    recv_set_found_corrupt_log();
 
     return nullptr;
   }
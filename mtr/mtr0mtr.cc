@@ -29,6 +29,11 @@ Created 11/26/1995 Heikki Tuuri
 #include "log0recv.h"
 #include "mtr0log.h"
 #include "page0types.h"
+#include "ut0probe.h"
+
+#include <chrono>
+
+Mtr_stats mtr_stats;
 
 /**
  * Releases the item in the slot given.
@@ -45,6 +50,8 @@ inline void mtr_memo_slot_release(mtr_t *mtr, mtr_memo_slot_t *slot) noexcept {
       srv_buf_pool->release(static_cast<Buf_block *>(object), type, mtr);
     } else if (type == MTR_MEMO_S_LOCK) {
       rw_lock_s_unlock(static_cast<rw_lock_t *>(object));
+    } else if (type == MTR_MEMO_SX_LOCK) {
+      rw_lock_sx_unlock(static_cast<rw_lock_t *>(object));
 #ifndef UNIV_DEBUG
     } else {
       rw_lock_x_unlock(static_cast<rw_lock_t *>(object));
@@ -72,24 +79,70 @@ static void mtr_memo_pop_all(mtr_t *mtr) noexcept {
   /* Currently only used in commit */
   ut_ad(mtr->m_state == MTR_COMMITTING);
 
-  auto offset = dyn_array_get_data_size(&mtr->m_memo);
+  for (auto i = mtr->m_memo_size; i > 0; --i) {
+    mtr_memo_slot_release(mtr, mtr->memo_slot(i - 1));
+  }
+}
+
+/**
+ * Checks if the mini-transaction modified only pages of temporary tables.
+ *
+ * @param[in] mtr               Mini-transaction that is committing.
+ *
+ * @return true if it X-latched at least one page and all of them are in the
+ *  tablespaces of temporary tables, see Buf_page::m_is_temp.
+ */
+static bool mtr_modifies_only_temp_pages(const mtr_t *mtr) noexcept {
+  bool found{};
+
+  for (ulint i = 0; i < mtr->m_memo_size; ++i) {
+    auto slot = mtr->memo_slot(i);
 
-  while (offset > 0) {
-    offset -= sizeof(mtr_memo_slot_t);
-    auto slot = static_cast<mtr_memo_slot_t *>(dyn_array_get_element(&mtr->m_memo, offset));
+    if (slot->m_object != nullptr && slot->m_type == MTR_MEMO_PAGE_X_FIX) {
+      if (!static_cast<const Buf_block *>(slot->m_object)->m_page.m_is_temp) {
+        return false;
+      }
 
-    mtr_memo_slot_release(mtr, slot);
+      found = true;
+    }
   }
+
+  return found;
+}
+
+void mtr_t::memo_grow() noexcept {
+  ut_ad(m_memo_size == m_memo_capacity);
+
+  const auto capacity = m_memo_capacity * 2;
+  auto slots = static_cast<mtr_memo_slot_t *>(ut_new(capacity * sizeof(mtr_memo_slot_t)));
+
+  memcpy(slots, memo_slot(0), m_memo_size * sizeof(mtr_memo_slot_t));
+
+  memo_free();
+
+  m_memo_heap = slots;
+  m_memo_capacity = capacity;
+}
+
+void mtr_t::memo_free() noexcept {
+  if (m_memo_heap != nullptr) {
+    ut_delete(m_memo_heap);
+    m_memo_heap = nullptr;
+  }
+
+  m_memo_size = 0;
+  m_memo_capacity = MEMO_INLINE_SLOTS;
 }
 
 /**
  * Writes the contents of a mini-transaction log, if any, to the database log.
+ * The log is reserved without a mutex and copied to the log buffer in parallel
+ * with the other mini-transactions.
  * 
  * @param[in,out] mtr           Mini-transaction used for the write
  * @param[in,out] log           Log to write to
- * @param[in] recovery          recovery flag
  */
-static void mtr_log_reserve_and_write(mtr_t *mtr, Log* log, ulint recovery) noexcept {
+static void mtr_log_reserve_and_write(mtr_t *mtr, Log* log) noexcept {
   auto mlog = &mtr->m_log;
   auto first_data = dyn_block_get_data(mlog);
 
@@ -99,42 +152,30 @@ static void mtr_log_reserve_and_write(mtr_t *mtr, Log* log, ulint recovery) noex
     *first_data = byte(ulint(*first_data) | MLOG_SINGLE_REC_FLAG);
   }
 
-  if (mlog->heap == nullptr) {
-
-    log->acquire();
-
-    mtr->m_end_lsn = log->reserve_and_write_fast(first_data, dyn_block_get_used(mlog), &mtr->m_start_lsn);
-
-    if (mtr->m_end_lsn != 0) {
-      /* We were able to successfully write to the log. */
-      return;
-    }
-
-    log->release();
-  }
-
-  auto data_size = dyn_array_get_data_size(mlog);
-
-  /* Open the database log for log_write_low */
-  mtr->m_start_lsn = log->reserve_and_open(data_size);
-
   if (mtr->m_log_mode == MTR_LOG_ALL) {
+    mtr->m_start_lsn = log->reserve(dyn_array_get_data_size(mlog), &mtr->m_end_lsn);
 
+    auto lsn = mtr->m_start_lsn;
     const dyn_block_t *block = mlog;
 
     while (block != nullptr) {
-      log->write_low(dyn_block_get_data(block), dyn_block_get_used(block));
+      lsn = log->write(lsn, dyn_block_get_data(block), dyn_block_get_used(block));
       block = dyn_array_get_next_block(mlog, block);
     }
+
+    ut_ad(lsn == mtr->m_end_lsn);
+
+    log->close(mtr->m_start_lsn, mtr->m_end_lsn);
   } else {
     ut_ad(mtr->m_log_mode == MTR_LOG_NONE);
-    /* Do nothing */
+    /* Nothing is written */
+    mtr->m_start_lsn = mtr->m_end_lsn = log->get_lsn();
   }
-
-  mtr->m_end_lsn = log->close(ib_recovery_t(recovery));
 }
 
 void mtr_t::commit() noexcept {
+  using namespace std::chrono;
+
   ut_ad(m_magic_n == MTR_MAGIC_N);
   ut_ad(is_active());
 
@@ -142,27 +183,44 @@ void mtr_t::commit() noexcept {
 
   const auto write_log = m_modifications > 0 && m_n_log_recs > 0;
 
+  mtr_stats.add(MTR_STAT_MEMO_SLOTS, m_memo_size);
+
+  /* Only the commits that write log hold latches long enough to matter. */
+  const auto start = write_log ? steady_clock::now() : steady_clock::time_point{};
+
+  /* The mini-transactions link their modified pages to the flush lists in
+  any order. The flush lists are then sorted on oldest_modification only
+  within LOG_RECENT_CLOSED_SIZE and Log::buf_pool_get_oldest_modification()
+  accounts for the pages that are not linked yet when we make a checkpoint. */
+
   if (write_log) {
-    mtr_log_reserve_and_write(this, log_sys, srv_config.m_force_recovery);
-  }
+    if (mtr_modifies_only_temp_pages(this)) {
+      /* A temporary table is dropped at startup, its changes are never
+      redone. The records are discarded, the pages are still linked to the
+      flush lists like the ones of an MTR_LOG_NONE mtr. An mtr that also
+      changed an undo page or wrote a file operation logs everything. */
+      m_start_lsn = m_end_lsn = log_sys->get_lsn();
+    } else {
+      mtr_log_reserve_and_write(this, log_sys);
+    }
 
-  /* We first update the modification info to buffer pages, and only
-  after that release the log mutex: this guarantees that when the log
-  mutex is free, all buffer pages contain an up-to-date info of their
-  modifications. This fact is used in making a checkpoint when we look
-  at the oldest modification of any page in the buffer pool. It is also
-  required when we insert modified buffer pages in to the flush list
-  which must be sorted on oldest_modification. */
+    log_sys->flush_order_begin(m_start_lsn);
+  }
 
   mtr_memo_pop_all(this);
 
   if (write_log) {
-    log_sys->release();
+    log_sys->flush_order_end(m_start_lsn, m_end_lsn);
+
+    mtr_stats.add(MTR_STAT_LOG_BYTES, m_end_lsn - m_start_lsn);
+    mtr_stats.add(MTR_STAT_COMMIT_US, uint64_t(duration_cast<microseconds>(steady_clock::now() - start).count()));
   }
 
+  IB_PROBE(mtr__commit, write_log ? m_end_lsn - m_start_lsn : 0, write_log ? m_n_log_recs : 0, write_log ? m_end_lsn : 0);
+
   m_state = MTR_COMMITTED;
 
-  dyn_array_free(&m_memo);
+  memo_free();
   dyn_array_free(&m_log);
 }
 
@@ -170,13 +228,10 @@ void mtr_t::rollback_to_savepoint(ulint savepoint) noexcept {
   ut_ad(m_magic_n == MTR_MAGIC_N);
   ut_ad(is_active());
 
-  auto offset = dyn_array_get_data_size(&m_memo);
-  ut_ad(offset >= savepoint);
-
-  while (offset > savepoint) {
-    offset -= sizeof(mtr_memo_slot_t);
+  ut_ad(m_memo_size >= savepoint);
 
-    auto slot = static_cast<mtr_memo_slot_t *>(dyn_array_get_element(&m_memo, offset));
+  for (auto i = m_memo_size; i > savepoint; --i) {
+    auto slot = memo_slot(i - 1);
     ut_ad(slot->m_type != MTR_MEMO_MODIFY);
 
     mtr_memo_slot_release(this, slot);
@@ -187,12 +242,8 @@ void mtr_t::memo_release(void *object, ulint type) noexcept {
   ut_ad(m_magic_n == MTR_MAGIC_N);
   ut_ad(is_active());
 
-  auto offset = dyn_array_get_data_size(&m_memo);
-
-  while (offset > 0) {
-    offset -= sizeof(mtr_memo_slot_t);
-
-    auto slot = static_cast<mtr_memo_slot_t *>(dyn_array_get_element(&m_memo, offset));
+  for (auto i = m_memo_size; i > 0; --i) {
+    auto slot = memo_slot(i - 1);
 
     if (object == slot->m_object && type == slot->m_type) {
 
@@ -230,7 +281,7 @@ bool mtr_t::memo_contains_page(const byte *ptr, ulint type) const noexcept {
 std::string mtr_t::to_string() const noexcept {
   return std::format(
     "Mini-transaction handle: memo size {} bytes log size {} bytes",
-    dyn_array_get_data_size(&m_memo),
+    m_memo_size * sizeof(mtr_memo_slot_t),
     dyn_array_get_data_size(&m_log)
   );
 }
@@ -240,7 +291,9 @@ void mtr_t::release_block_at_savepoint(ulint savepoint, Buf_block *block) noexce
   ut_ad(is_active());
   ut_ad(m_magic_n == MTR_MAGIC_N);
 
-  auto slot = static_cast<mtr_memo_slot_t *>(dyn_array_get_element(&m_memo, savepoint));
+  ut_a(savepoint < m_memo_size);
+
+  auto slot = memo_slot(savepoint);
 
   ut_a(slot->m_object == block);
 
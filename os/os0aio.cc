@@ -16,8 +16,13 @@ limitations under the License.
 ***********************************************************************/
 
 #include <errno.h>
+#include <sched.h>
 
+#include <algorithm>
 #include <array>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
 
 #include <liburing.h>
@@ -30,17 +35,147 @@ limitations under the License.
 #include "ut0byte.h"
 #include "ut0logger.h"
 #include "ut0mpmcbq.h"
+#include "ut0wait.h"
 
 AIO *srv_aio{};
 
 namespace aio {
 
+/** Size of the sparse table of fixed buffers of each io_uring. */
+constexpr unsigned MAX_FIXED_BUFFERS = 1024;
+
+/** Size of the sparse table of registered files of each io_uring. */
+constexpr unsigned MAX_FIXED_FILES = 4096;
+
+/** The kernel limits the size of a fixed buffer, bigger areas are registered
+in pieces of this size. */
+constexpr ulint MAX_FIXED_BUFFER_SIZE = 1024 * 1024 * 1024;
+
+/** How long an idle SQPOLL kernel thread spins before it sleeps, in ms. */
+constexpr unsigned SQPOLL_IDLE_MS = 2000;
+
+/** The best effort i/o priority with a level from 0, the highest, to 7,
+see ioprio_set(2). The block layer schedulers that support priorities
+dispatch the requests with the higher priorities first. */
+constexpr uint16_t ioprio_best_effort(uint16_t level) {
+  return uint16_t((2 << 13) | level);
+}
+
+/** How the requests of an i/o class are scheduled. */
+struct IO_class_policy {
+  /** Percentage of the slots of the handler that the class can use. */
+  ulint m_max_slots_pct;
+
+  /** I/O priority of the requests. */
+  uint16_t m_ioprio;
+};
+
+/** The policies by IO_class. The foreground reads are synchronous and run
+with the priority of the process, level 4 by default. */
+constexpr std::array<IO_class_policy, IO_CLASS_COUNT> IO_CLASS_POLICIES{{
+  /* Foreground_read */
+  {100, ioprio_best_effort(4)},
+  /* Read_ahead */
+  {50, ioprio_best_effort(5)},
+  /* Flush */
+  {75, ioprio_best_effort(6)},
+  /* Log */
+  {100, ioprio_best_effort(0)},
+  /* Recovery */
+  {100, ioprio_best_effort(4)},
+}};
+
+/** The run time state of an i/o class. */
+struct IO_class_state {
+  /** Adds the latency of a completed request to the moving averages.
+  * @param[in] start When the request was submitted. */
+  void update_latency(std::chrono::steady_clock::time_point start) noexcept {
+    using namespace std::chrono;
+
+    const uint64_t sample = std::max(int64_t(duration_cast<nanoseconds>(steady_clock::now() - start).count()), int64_t(1));
+    const auto avg = m_latency.load(std::memory_order_relaxed);
+    const auto baseline = m_baseline.load(std::memory_order_relaxed);
+
+    /* Races between the reapers only lose a sample. */
+    m_latency.store(avg == 0 ? sample : avg - avg / 8 + sample / 8, std::memory_order_relaxed);
+    m_baseline.store(baseline == 0 ? sample : baseline - baseline / 256 + sample / 256, std::memory_order_relaxed);
+  }
+
+  /** @return the statistics of the class. */
+  [[nodiscard]] IO_class_stats get_stats() const noexcept {
+    using namespace std::chrono;
+
+    return IO_class_stats{
+      .m_n_pending = m_n_pending.load(std::memory_order_relaxed),
+      .m_latency = duration_cast<microseconds>(nanoseconds(m_latency.load(std::memory_order_relaxed))),
+      .m_baseline = duration_cast<microseconds>(nanoseconds(m_baseline.load(std::memory_order_relaxed)))
+    };
+  }
+
+  /** Number of requests that were submitted and did not complete. */
+  std::atomic<ulint> m_n_pending{};
+
+  /** Moving average of the latency in nanoseconds, the weight of a new
+  sample is 1/8. */
+  std::atomic<uint64_t> m_latency{};
+
+  /** Moving average of the latency in nanoseconds, the weight of a new
+  sample is 1/256. */
+  std::atomic<uint64_t> m_baseline{};
+
+  /** Set when a request of the class completes, the submitters wait on it
+  while the class uses its share of the slots. */
+  Cond_var *m_slot_freed{};
+};
+
+using IO_class_states = std::array<IO_class_state, IO_CLASS_COUNT>;
+
+/** Submit to completion latencies by IO_request. */
+using Request_latencies = std::array<ut::Latency_histogram, IO_REQUEST_COUNT>;
+
+/** Adds the latency of a request to the histograms of its type and of its
+tablespace, and the request to the i/o statistics of the tablespace.
+@param[in,out] by_request Histograms by request type
+@param[in] io_ctx Context of the completed request
+@param[in] ptr First buffer of the request
+@param[in] len Number of bytes transferred
+@param[in] off File offset of the request
+@param[in] us Latency in microseconds */
+static void record_latency(Request_latencies &by_request, const IO_ctx &io_ctx, const byte *ptr, ulint len, off_t off, uint64_t us) noexcept {
+  by_request[ulint(io_ctx.m_io_request)].add(us);
+
+  /* The space is not freed while it has pending i/o. */
+  auto space = io_ctx.m_fil_node->m_space;
+
+  space->m_io_latency->add(us);
+
+  const auto page_class = io_ctx.is_log_request() ? Fil_io_page_class::OTHER : Fil_space_io_stats::get_page_class(ptr, len, off);
+
+  space->m_io_stats->add(io_ctx.is_read_request(), page_class, len, us);
+}
+
+/** Options of the io_uring rings of the queues. */
+struct Ring_config {
+  /** If true, a kernel thread polls the submission queues, submitting
+  a request then needs no system call while the thread is awake. */
+  bool m_sqpoll{};
+
+  /** If true, a request is submitted to the queue of the CPU that the
+  submitting thread runs on. */
+  bool m_per_cpu{};
+
+  /** Ring that the other rings attach to, so that they share one SQPOLL
+  thread and one async worker pool, -1 until the first ring is created. */
+  int m_wq_fd{-1};
+};
+
 struct Stats {
   std::string to_string() const {
     return std::format(
-      "sqes: {}, cqes: {}, total: {}, partial = {{ reqs: {}, data: {} }}, retries: {{ sqe: {}, cqe: {} }}",
+      "sqes: {}, cqes: {}, total: {}, coalesced: {}, partial = {{ reqs: {}, data: {} }}, retries: {{ sqe: {}, cqe: {} }}",
       m_n_sqes.load(), m_n_cqes.load(),
       m_total.load(),
+      m_n_coalesced.load(),
       m_partial_ops.load(), m_partial_data.load(),
       m_sqe_eintrs.load(), m_cqe_eintrs.load());
   }
@@ -54,6 +189,9 @@ struct Stats {
   /** Total number of bytes read/written. */
   std::atomic<uint64_t> m_total{};
 
+  /** Total number of writes that were appended to an open write run. */
+  std::atomic<uint64_t> m_n_coalesced{};
+
   /** Total number of partial SQEs submitted, */
   std::atomic<uint64_t> m_partial_ops{};
 
@@ -86,6 +224,34 @@ struct Slot {
   /** File offset in bytes */
   off_t m_off{};
 
+  /** Buffers of a vectored write, m_n_iovs is 0 for a request submitted
+  with AIO::submit(). */
+  std::array<iovec, AIO::MAX_IOVS> m_iovs{};
+
+  /** Number of buffers in m_iovs. */
+  ulint m_n_iovs{};
+
+  /** First buffer in m_iovs that has not been written completely. */
+  ulint m_iov_first{};
+
+  /** Index of the fixed buffer that contains m_request, -1 if it is not
+  inside a registered area. */
+  int m_buf_index{-1};
+
+  /** Messages of the writes that were coalesced into this request, one per
+  buffer in m_iovs, m_n_msgs is 0 if the request was not coalesced. */
+  std::array<void *, AIO::MAX_IOVS> m_msgs{};
+
+  /** Lengths of the coalesced writes, the completion of each is reported
+  with its own length. */
+  std::array<uint32_t, AIO::MAX_IOVS> m_msg_lens{};
+
+  /** Number of coalesced writes. */
+  ulint m_n_msgs{};
+
+  /** When the request was reserved, for measuring the write latency. */
+  std::chrono::steady_clock::time_point m_start{};
+
   /** true if this slot is reserved */
   IF_DEBUG(bool m_reserved{};)
 
@@ -143,8 +309,9 @@ struct Handler {
    * @param[in] id Id of the handler
    * @param[in] n_slots Number of slots in the handler
    * @param[in] n_queues Number of queues per handler
+   * @param[in,out] config Options of the io_uring rings
    */
-  explicit Handler(ulint id, size_t n_slots, size_t n_queues) noexcept;
+  explicit Handler(ulint id, size_t n_slots, size_t n_queues, Ring_config &config) noexcept;
 
   /* Destructor */
   ~Handler() noexcept;
@@ -173,15 +340,45 @@ struct Handler {
 
   /** Get the queue for submitting a request
    * 
+   * @param[in] batch           true if the request is part of a batch, it goes
+   *                            to a queue that already has a batch queued up.
+   *
    * @return the queue for the AIO
   */
-  [[nodiscard]] Queue *get_queue_for_submit() noexcept;
+  [[nodiscard]] Queue *get_queue_for_submit(bool batch) noexcept;
+
+  /** Submit the requests that were queued in batch mode on all the queues. */
+  void submit_queued() noexcept;
 
   /** Free the slot.
   * @param[in] slot Slot to free.
   */
   void mark_as_free(Slot* slot) noexcept;
 
+  /** Adds the latency of a completed request to the moving average.
+  * @param[in] slot Slot of the completed request.
+  */
+  void update_latency(const Slot *slot) noexcept;
+
+  /** Accounts the completion of a request to its class.
+  * @param[in] slot Slot of the completed request.
+  */
+  void complete_class(const Slot *slot) noexcept;
+
+  /** Adds the latency of a completed request to the histograms.
+  * @param[in,out] queue Queue that completed the request.
+  * @param[in] slot Slot of the completed request.
+  */
+  void record_latency(Queue *queue, const Slot *slot) noexcept;
+
+  /** @return the number of slots that a class can use in this handler.
+  * @param[in] io_class Class of the requests. */
+  [[nodiscard]] ulint get_class_limit(IO_class io_class) const noexcept {
+    const auto pct = IO_CLASS_POLICIES[ulint(io_class)].m_max_slots_pct;
+
+    return pct >= 100 ? ULINT_MAX : std::max(m_slots.size() * pct / 100, size_t(1));
+  }
+
   /** Wake up the queue queues, we are shutting down. */
   void shutdown() noexcept;
 
@@ -194,9 +391,10 @@ struct Handler {
   * @param[in] id               Id of the handler
   * @param n_slots              Number of slots.
   * @param n_queues            Number of queues in the handler 
+  * @param config               Options of the io_uring rings
   * @return own: handler instance.
   */
-  [[nodiscard]] static Handler *create(ulint id, ulint n_slots, ulint n_queues) noexcept;
+  [[nodiscard]] static Handler *create(ulint id, ulint n_slots, ulint n_queues, Ring_config &config) noexcept;
 
   /** Destoy a Handler instance.
    * @param[in,own] Handler instance to destroy.
@@ -206,6 +404,15 @@ struct Handler {
   /** Type of the handler. */
   ulint m_id{ULINT_UNDEFINED};
 
+  /** If true, requests go to the queue of the submitting thread's CPU. */
+  bool m_per_cpu{};
+
+  /** State of the i/o classes, shared by the handlers. */
+  IO_class_states *m_classes{};
+
+  /** Latencies by request type, shared by the handlers. */
+  Request_latencies *m_by_request{};
+
   /** The event which is set to the signaled state when there are
    * slots available in this handler. */
   Cond_var* m_not_full{};
@@ -217,6 +424,10 @@ struct Handler {
   /** Number of  reserved slots in the handler */
   std::atomic<ulint> m_n_reserved{};
 
+  /** Moving average of the latency of the completed requests in
+  microseconds, 0 if none completed yet. */
+  std::atomic<uint64_t> m_latency{};
+
   /** Slots to use for submitting/reapling requwests. */
   std::vector<Slot> m_slots{};
 
@@ -233,14 +444,51 @@ struct Handler::Queue {
   * @param[in] handler The owning handler of this queue
   * @param[in] id Id of the queue
   * @param[in] queue_size Size of the io_uring queue
+  * @param[in,out] config Options of the io_uring rings
   */
-  Queue(Handler *handler, ulint id, ulint queue_size) noexcept
+  Queue(Handler *handler, ulint id, ulint queue_size, Ring_config &config) noexcept
     : m_handler(handler),
       m_id(id) {
 
-    if (auto ret = io_uring_queue_init(queue_size, &m_iouring, 0); ret < 0) {
+    io_uring_params params{};
+
+    if (config.m_sqpoll) {
+      params.flags |= IORING_SETUP_SQPOLL;
+      params.sq_thread_idle = SQPOLL_IDLE_MS;
+    }
+
+    if (config.m_wq_fd != -1) {
+      params.flags |= IORING_SETUP_ATTACH_WQ;
+      params.wq_fd = config.m_wq_fd;
+    }
+
+    auto ret = io_uring_queue_init_params(queue_size, &m_iouring, &params);
+
+    if (ret < 0 && config.m_sqpoll) {
+      /* SQPOLL needs privileges on older kernels. */
+      log_warn("Initializing an io_uring queue with SQPOLL failed: ", std::to_string(ret), ", not using SQPOLL");
+
+      config.m_sqpoll = false;
+      config.m_wq_fd = -1;
+
+      params = io_uring_params{};
+      ret = io_uring_queue_init_params(queue_size, &m_iouring, &params);
+    }
+
+    if (ret < 0) {
       log_fatal("Initializing io_uring queue failed: " + std::to_string(ret));
     }
+
+    if (config.m_wq_fd == -1) {
+      config.m_wq_fd = m_iouring.ring_fd;
+    }
+
+    /* Older kernels don't support the sparse tables, the buffers and the
+    files are then passed with each request. */
+    m_has_fixed_buffers = io_uring_register_buffers_sparse(&m_iouring, MAX_FIXED_BUFFERS) == 0;
+    m_has_fixed_files = io_uring_register_files_sparse(&m_iouring, MAX_FIXED_FILES) == 0;
+
+    m_fan_out.reserve(AIO::MAX_IOVS);
   }
 
   Queue(Queue &&) = delete;
@@ -255,10 +503,57 @@ struct Handler::Queue {
   /** Submit an asynchronous IO request.
    * 
    * @param[in,out] slot Slot to submit
+   * @param[in] batch If true the request is only queued, it is submitted with
+   *  the next request that is not batched or by submit_queued().
+   * 
+   * @return DB_SUCCESS or error code.
+  */
+  db_err submit(Slot *slot, bool batch) noexcept;
+
+  /** Add a request to the submission queue without submitting it. The caller
+   * must own m_mutex.
+   * 
+   * @param[in,out] slot Slot to queue
    * 
    * @return DB_SUCCESS or error code.
   */
-  db_err submit(Slot *slot) noexcept ;
+  db_err enqueue_low(Slot *slot) noexcept;
+
+  /** Submit the requests that were queued in batch mode and the open
+  write run. */
+  void submit_queued() noexcept {
+    if (m_n_queued.load(std::memory_order_relaxed) > 0 || m_open_run.load(std::memory_order_relaxed) != nullptr) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      close_run_low();
+      submit_low();
+    }
+  }
+
+  /** Append a write to the open write run if it continues the run.
+   * 
+   * @param[in] io_ctx IO context of the write
+   * @param[in] ptr Buffer to write
+   * @param[in] len Length of the buffer
+   * @param[in] off File offset
+   * @param[in] window How long a run stays open for appending
+   * 
+   * @return true if the write was appended.
+  */
+  [[nodiscard]] bool append_to_run(const IO_ctx &io_ctx, void *ptr, uint32_t len, off_t off, std::chrono::microseconds window) noexcept;
+
+  /** Make a reserved write slot the open write run of the queue, the previous
+   * open run is submitted.
+   * 
+   * @param[in,out] slot Slot of the first write of the run
+  */
+  void open_run(Slot *slot) noexcept;
+
+  /** Queue the open write run for submission. The caller must own m_mutex. */
+  void close_run_low() noexcept;
+
+  /** Submit all the queued requests to the kernel. The caller must own m_mutex. */
+  void submit_low() noexcept;
 
   /** Wait for completed requests and return the IO context.
    * 
@@ -285,6 +580,12 @@ struct Handler::Queue {
 
     m_shutdown.store(true);
 
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ut_a(m_n_queued.load() == 0);
+    ut_a(m_open_run.load() == nullptr);
+    ut_a(m_fan_out.empty());
+
     io_uring_sqe *sqe = io_uring_get_sqe(&m_iouring);
     ut_a(sqe != nullptr);
 
@@ -312,6 +613,9 @@ struct Handler::Queue {
     return "stats: { " + m_stats.to_string() + " }";
   }
 
+  /** Submit to completion latencies of the requests of this queue. */
+  ut::Latency_histogram m_latency{};
+
   /** We are shutting down. */
   std::atomic<bool> m_shutdown{};
 
@@ -321,12 +625,33 @@ struct Handler::Queue {
   /** Number of pending AIO slots. */
   std::atomic<ulint> m_pending_slots{};
 
+  /** Number of requests in the submission queue that have not been submitted
+  to the kernel yet. Written under m_mutex. */
+  std::atomic<ulint> m_n_queued{};
+
+  /** Serializes the access to the submission queue of m_iouring. */
+  std::mutex m_mutex{};
+
+  /** Write that adjacent writes to the same file are appended to before it
+  is submitted, nullptr if none. Written under m_mutex. */
+  std::atomic<Slot *> m_open_run{};
+
+  /** Completions of the coalesced writes that were not returned by reap()
+  yet, only accessed by the reap thread of the queue. */
+  std::vector<IO_ctx> m_fan_out{};
+
   /** Parent handler. */
   Handler *m_handler{};
 
   /** Local queue id. */
   ulint m_id{ULINT_UNDEFINED};
 
+  /** true if m_iouring has a table of fixed buffers. */
+  bool m_has_fixed_buffers{};
+
+  /** true if m_iouring has a table of registered files. */
+  bool m_has_fixed_files{};
+
   /** io_uring instance  use for AIO. */
   io_uring m_iouring{};
 };
@@ -336,18 +661,64 @@ struct Impl : public AIO {
    * @param[in] n_slots Total number of slots for all queues
    * @param[in] read_queues Number of reader queues.
    * @param[in] writer_queues Number of writer queues.
+   * @param[in] sqpoll Poll the submission queues with a kernel thread.
+   * @param[in] per_cpu Submit to the queue of the submitter's CPU.
+   * @param[in] coalesce_window How long adjacent writes are coalesced.
    */ 
-  Impl(ulint n_slots, ulint read_queues, ulint write_queues) noexcept
-    : m_n_queues(read_queues + write_queues + 1) {
-    m_handlers[LOG] = Handler::create(LOG, n_slots, 1);
-    m_handlers[READ] = Handler::create(READ, n_slots, read_queues);
-    m_handlers[WRITE] = Handler::create(WRITE, n_slots, write_queues);
+  Impl(ulint n_slots, ulint read_queues, ulint write_queues, bool sqpoll, bool per_cpu, std::chrono::microseconds coalesce_window) noexcept
+    : m_n_queues(read_queues + write_queues + 1),
+      m_coalesce_window(coalesce_window) {
+    Ring_config config{.m_sqpoll = sqpoll, .m_per_cpu = per_cpu};
+
+    m_handlers[LOG] = Handler::create(LOG, n_slots, 1, config);
+    m_handlers[READ] = Handler::create(READ, n_slots, read_queues, config);
+    m_handlers[WRITE] = Handler::create(WRITE, n_slots, write_queues, config);
+
+    for (auto &state : m_classes) {
+      state.m_slot_freed = Cond_var::create(nullptr);
+    }
+
+    for (auto handler : m_handlers) {
+      handler->m_classes = &m_classes;
+      handler->m_by_request = &m_by_request;
+    }
+
+    if (auto ret = io_uring_queue_init(SYNC_RING_SIZE, &m_sync_ring, 0); ret < 0) {
+      log_fatal("Initializing io_uring queue failed: " + std::to_string(ret));
+    }
+
+    if (auto ret = io_uring_queue_init(FSYNC_RING_SIZE, &m_fsync_ring, 0); ret < 0) {
+      log_fatal("Initializing io_uring queue failed: " + std::to_string(ret));
+    }
+
+    m_use_fixed_buffers = true;
+    m_use_fixed_files = true;
+
+    for_each_queue([this](Handler::Queue *queue) {
+      m_use_fixed_buffers = m_use_fixed_buffers && queue->m_has_fixed_buffers;
+      m_use_fixed_files = m_use_fixed_files && queue->m_has_fixed_files;
+    });
+
+    for (int i = MAX_FIXED_BUFFERS; i-- > 0; ) {
+      m_free_buffers.push_back(i);
+    }
+
+    for (int i = MAX_FIXED_FILES; i-- > 0; ) {
+      m_free_files.push_back(i);
+    }
   }
 
   ~Impl() noexcept {
+    io_uring_queue_exit(&m_sync_ring);
+    io_uring_queue_exit(&m_fsync_ring);
+
     Handler::destroy(m_handlers[LOG]);
     Handler::destroy(m_handlers[READ]);
     Handler::destroy(m_handlers[WRITE]);
+
+    for (auto &state : m_classes) {
+      Cond_var::destroy(state.m_slot_freed);
+    }
   }
 
   /**
@@ -361,6 +732,147 @@ struct Impl : public AIO {
   */
   [[nodiscard]] virtual db_err submit(IO_ctx&& io_ctx, void *buf, ulint n, off_t off) noexcept;
 
+  /**
+  * @brief Submit a vectored write request
+  *
+  * @param io_ctx Context of the i/o operation.
+  * @param iov Buffers to write.
+  * @param n_iov Number of buffers.
+  * @param offset File offset of the first buffer.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] virtual db_err submit_vectored(IO_ctx&& io_ctx, const iovec *iov, ulint n_iov, off_t off) noexcept;
+
+  /**
+  * @brief Accounts a request to its class, waits while the class uses its
+  * share of the slots of the handler.
+  *
+  * @param handler Handler of the request.
+  * @param io_class Class of the request.
+  */
+  void acquire_class_slot(Handler *handler, IO_class io_class) noexcept;
+
+  /**
+  * @brief Does a synchronous request and accounts it to its class.
+  *
+  * @param io_ctx Context of the i/o operation.
+  * @param ptr Buffer to read or write.
+  * @param n Number of bytes to read or write.
+  * @param off File offset.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] db_err submit_sync(const IO_ctx &io_ctx, void *ptr, ulint n, off_t off) noexcept;
+
+  /**
+  * @brief Returns the statistics of an i/o class.
+  *
+  * @param io_class Class to return the statistics of.
+  * @return the statistics.
+  */
+  [[nodiscard]] virtual IO_class_stats get_class_stats(IO_class io_class) const noexcept;
+
+  /**
+  * @brief Adds the latencies of the requests of a type to a histogram.
+  *
+  * @param io_request Type of the requests.
+  * @param histogram Histogram to add the latencies to.
+  */
+  virtual void get_latency(IO_request io_request, ut::Latency_histogram &histogram) const noexcept;
+
+  /**
+  * @return the latency percentiles by request type and by queue.
+  */
+  [[nodiscard]] virtual std::string latency_to_string() const;
+
+  /**
+  * @brief Checks if a batched request can be merged with adjacent writes.
+  *
+  * @param io_ctx Context of the i/o operation.
+  * @return true if the request is a data file write that can be coalesced.
+  */
+  [[nodiscard]] bool can_coalesce(const IO_ctx &io_ctx) const noexcept;
+
+  /**
+  * @brief Appends a write to an open write run of the same file that it
+  * continues, or opens a new run with it. The run is written with one
+  * vectored request when it is full, when a write does not continue it
+  * after the coalescing window or by submit_batch().
+  *
+  * @param io_ctx Context of the i/o operation.
+  * @param ptr Buffer to write.
+  * @param n Number of bytes to write.
+  * @param off File offset.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] db_err coalesce(IO_ctx&& io_ctx, void *ptr, ulint n, off_t off) noexcept;
+
+  /**
+  * @return the moving average of the data file write latency.
+  */
+  [[nodiscard]] virtual std::chrono::microseconds get_write_latency() const noexcept;
+
+  /**
+  * @brief Flushes files with fsyncs submitted together to m_fsync_ring.
+  *
+  * @param files Files to flush.
+  * @param n_files Number of files.
+  */
+  virtual void sync_files(const os_file_t *files, ulint n_files) noexcept;
+
+  /**
+  * @brief Registers a memory area as fixed buffers of all the rings.
+  *
+  * @param ptr Start of the area.
+  * @param len Length of the area.
+  */
+  virtual void register_buffer(void *ptr, ulint len) noexcept;
+
+  /**
+  * @brief Unregisters a memory area from all the rings.
+  *
+  * @param ptr Start of the area.
+  * @param len Length of the area.
+  */
+  virtual void unregister_buffer(void *ptr, ulint len) noexcept;
+
+  /**
+  * @brief Registers a file with all the rings.
+  *
+  * @param fh File handle.
+  * @return index of the file, -1 if not registered.
+  */
+  [[nodiscard]] virtual int register_file(os_file_t fh) noexcept;
+
+  /**
+  * @brief Unregisters a file from all the rings.
+  *
+  * @param index Index returned by register_file().
+  */
+  virtual void unregister_file(int index) noexcept;
+
+  /**
+  * @brief Finds the fixed buffer that contains a buffer.
+  *
+  * @param ptr Start of the buffer.
+  * @param n Length of the buffer.
+  * @return index of the fixed buffer, -1 if the buffer is not registered.
+  */
+  [[nodiscard]] int find_fixed_buffer(const void *ptr, ulint n) const noexcept;
+
+  /**
+  * @brief Calls a function for each queue of all the handlers.
+  *
+  * @param f Function to call with the queue.
+  */
+  template <typename F>
+  void for_each_queue(F &&f) noexcept {
+    for (auto handler : m_handlers) {
+      for (auto queue : handler->m_queues) {
+        f(queue);
+      }
+    }
+  }
+
   /**
   * @brief Reap the completed request from io_uring.
   *
@@ -370,6 +882,11 @@ struct Impl : public AIO {
   */
   [[nodiscard]] virtual db_err reap(ulint queue_id, IO_ctx &io_ctx) noexcept;
 
+  /**
+  * @brief Submits the requests that were queued in batch mode and the open write runs.
+  */
+  virtual void submit_batch() noexcept;
+
   /**
   * @brief Waits until there are no pending async operations.
   */
@@ -422,6 +939,19 @@ struct Impl : public AIO {
     return m_n_queues;
   }
 
+  /**
+  * @brief Writes a buffer and makes it durable with one system call: the
+  * write and an fdatasync are submitted together as linked requests, the
+  * fdatasync starts when the write has completed.
+  *
+  * @param io_ctx Context of the i/o operation, a Sync_log_write_durable.
+  * @param ptr Buffer to write.
+  * @param n Number of bytes to write.
+  * @param off File offset.
+  * @return true if the write is durable.
+  */
+  [[nodiscard]] bool write_durable(const IO_ctx &io_ctx, void *ptr, ulint n, off_t off) noexcept;
+
   Impl(Impl&&) = delete;
   Impl(const Impl&) = delete;
   Impl& operator=(Impl&&) = delete;
@@ -437,17 +967,75 @@ struct Impl : public AIO {
 
   /** Total number of queues/queues. */
   std::size_t m_n_queues;
+
+  /** How long a write run stays open for appending adjacent writes, zero
+  if the writes are not coalesced. */
+  std::chrono::microseconds m_coalesce_window{};
+
+  /** State of the i/o classes. */
+  IO_class_states m_classes{};
+
+  /** Latencies by request type. */
+  Request_latencies m_by_request{};
+
+  /** Size of m_sync_ring, a durable write uses two entries. */
+  static constexpr unsigned SYNC_RING_SIZE = 8;
+
+  /** Serializes the durable writes, the log is written by one thread at a
+  time. */
+  std::mutex m_sync_mutex{};
+
+  /** io_uring for the durable writes, they are reaped by the submitter and
+  not by the reap threads. */
+  io_uring m_sync_ring{};
+
+  /** Size of m_fsync_ring, the number of fsyncs that run in parallel. */
+  static constexpr unsigned FSYNC_RING_SIZE = 64;
+
+  /** Serializes the users of m_fsync_ring. */
+  std::mutex m_fsync_mutex{};
+
+  /** io_uring for the data file fsyncs, separate from m_sync_ring so that
+  the durable log writes don't wait for them. */
+  io_uring m_fsync_ring{};
+
+  /** A piece of a registered memory area. */
+  struct Fixed_buffer {
+    /** Length of the piece in bytes. */
+    ulint m_len{};
+
+    /** Index of the piece in the fixed buffer tables of the rings. */
+    int m_index{-1};
+  };
+
+  /** true if all the rings support fixed buffers. */
+  bool m_use_fixed_buffers{};
+
+  /** true if all the rings support registered files. */
+  bool m_use_fixed_files{};
+
+  /** Protects the fixed buffer and registered file tables below. */
+  mutable std::shared_mutex m_fixed_mutex{};
+
+  /** The registered pieces, by their start address. */
+  std::map<const byte *, Fixed_buffer> m_fixed_buffers{};
+
+  /** Free indexes in the fixed buffer tables. */
+  std::vector<int> m_free_buffers{};
+
+  /** Free indexes in the registered file tables. */
+  std::vector<int> m_free_files{};
 };
 
-Handler::Handler(ulint id, size_t n_slots, size_t n_queues) noexcept
-  : m_id(id) {
+Handler::Handler(ulint id, size_t n_slots, size_t n_queues, Ring_config &config) noexcept
+  : m_id(id), m_per_cpu(config.m_per_cpu) {
   m_not_full = Cond_var::create(nullptr);
   m_is_empty = Cond_var::create(nullptr);
 
   m_slots.resize(n_slots);
 
   for (size_t i = 0; i < n_queues; i++) {
-    auto queue = new (ut_new(sizeof(Queue))) Queue(this, i, n_slots);
+    auto queue = new (ut_new(sizeof(Queue))) Queue(this, i, n_slots, config);
     ut_a(queue != nullptr);
     m_queues.push_back(queue);
   }
@@ -504,9 +1092,26 @@ std::string Handler::to_string() const {
   return os.str();
 }
 
-Handler::Queue *Handler::get_queue_for_submit() noexcept {
+Handler::Queue *Handler::get_queue_for_submit(bool batch) noexcept {
   Queue *submit_queue{};
 
+  if (batch) {
+    /* Keep the batch together so that it is submitted with one system call. */
+    for (auto queue : m_queues) {
+      if (queue->m_n_queued.load(std::memory_order_relaxed) > 0) {
+        return queue;
+      }
+    }
+  }
+
+  if (m_per_cpu) {
+    /* The submitters on a CPU share a queue, the queue's ring and lock stay
+    in that CPU's cache. */
+    if (const auto cpu = sched_getcpu(); cpu >= 0) {
+      return m_queues[ulint(cpu) % m_queues.size()];
+    }
+  }
+
   for (auto queue : m_queues) {
     if (!submit_queue) {
       submit_queue = queue;
@@ -519,6 +1124,12 @@ Handler::Queue *Handler::get_queue_for_submit() noexcept {
   return submit_queue;
 }
 
+void Handler::submit_queued() noexcept {
+  for (auto queue : m_queues) {
+    queue->submit_queued();
+  }
+}
+
 void Handler::shutdown() noexcept {
   for (auto &queue : m_queues) {
     if (!queue->m_shutdown.load(std::memory_order_acquire)){
@@ -536,11 +1147,11 @@ void Handler::destroy(Handler *handler) noexcept {
   ut_delete(handler);
 }
 
-Handler *Handler::create(ulint id, ulint n_slots, ulint n_queues) noexcept {
+Handler *Handler::create(ulint id, ulint n_slots, ulint n_queues, Ring_config &config) noexcept {
   ut_a(n_slots > 0);
   ut_a(n_queues > 0);
 
-  return new (ut_new(sizeof(Handler))) Handler(id, n_slots, n_queues);
+  return new (ut_new(sizeof(Handler))) Handler(id, n_slots, n_queues, config);
 }
 
 void Handler::mark_as_free(Slot *slot) noexcept {
@@ -561,13 +1172,56 @@ void Handler::mark_as_free(Slot *slot) noexcept {
   }
 }
 
+void Handler::update_latency(const Slot *slot) noexcept {
+  using namespace std::chrono;
+
+  const uint64_t sample = duration_cast<microseconds>(steady_clock::now() - slot->m_start).count();
+  const auto avg = m_latency.load(std::memory_order_relaxed);
+
+  /* An exponentially weighted moving average with a weight of 1/8 for the
+  new sample, races between the reapers only lose a sample. */
+  m_latency.store(avg == 0 ? std::max(sample, uint64_t(1)) : avg - avg / 8 + sample / 8, std::memory_order_relaxed);
+}
+
+void Handler::complete_class(const Slot *slot) noexcept {
+  const auto io_class = slot->m_io_ctx.m_io_class;
+  auto &state = (*m_classes)[ulint(io_class)];
+
+  state.update_latency(slot->m_start);
+
+  const auto n = state.m_n_pending.fetch_sub(1, std::memory_order_relaxed);
+  ut_a(n > 0);
+
+  if (n == get_class_limit(io_class)) {
+    state.m_slot_freed->set();
+  }
+}
+
+void Handler::record_latency(Queue *queue, const Slot *slot) noexcept {
+  using namespace std::chrono;
+
+  const auto us = uint64_t(duration_cast<microseconds>(steady_clock::now() - slot->m_start).count());
+
+  queue->m_latency.add(us);
+
+  /* The buffer and the offset were advanced past the bytes transferred. */
+  aio::record_latency(*m_by_request, slot->m_io_ctx, slot->m_request.m_ptr - slot->m_len, slot->m_len, slot->m_off - off_t(slot->m_len), us);
+}
+
 Slot *Handler::Queue::reserve_slot(const IO_ctx &io_ctx, void *ptr, uint32_t len, off_t off) noexcept {
   for (;;) {
     if (m_handler->m_n_reserved.load(std::memory_order_relaxed) == m_handler->m_slots.capacity()) {
 
       /* If the handler queues are suspended, wake them
-      so that we get more slots */
+      so that we get more slots. The slots may be held by
+      requests that were queued in batch mode but have not
+      been submitted yet. */
 
+      m_handler->submit_queued();
+
+      ut::Wait_timer slot_wait(ut::Wait_type::AIO_SLOT, uint64_t(io_ctx.m_io_class), __FILE__, __LINE__);
+
+      slot_wait.start();
       m_handler->m_not_full->wait(0);
 
     } else {
@@ -593,6 +1247,11 @@ Slot *Handler::Queue::reserve_slot(const IO_ctx &io_ctx, void *ptr, uint32_t len
 
       slot->m_len = 0;
       slot->m_off = off;
+      slot->m_n_iovs = 0;
+      slot->m_iov_first = 0;
+      slot->m_buf_index = -1;
+      slot->m_n_msgs = 0;
+      slot->m_start = std::chrono::steady_clock::now();
       ut_ad(slot->m_reserved = true);
       slot->m_io_ctx = std::move(io_ctx_copy);
       slot->m_request = {static_cast<byte*>(ptr), len};
@@ -605,52 +1264,179 @@ Slot *Handler::Queue::reserve_slot(const IO_ctx &io_ctx, void *ptr, uint32_t len
   return nullptr;
 }
 
-db_err Handler::Queue::submit(Slot *slot) noexcept {
+db_err Handler::Queue::submit(Slot *slot, bool batch) noexcept {
   ut_a(!m_shutdown.load(std::memory_order_acquire));
   ut_ad(m_handler->m_n_reserved.load(std::memory_order_acquire) > 0);
 
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  const auto err = enqueue_low(slot);
+
+  if (err == DB_SUCCESS && !batch) {
+    submit_low();
+  }
+
+  return err;
+}
+
+db_err Handler::Queue::enqueue_low(Slot *slot) noexcept {
   auto sqe = io_uring_get_sqe(&m_iouring);
 
+  if (sqe == nullptr && m_n_queued.load(std::memory_order_relaxed) > 0) {
+    /* The submission queue is full of batched requests. */
+    submit_low();
+    sqe = io_uring_get_sqe(&m_iouring);
+  }
+
   if (sqe == nullptr) {
     return DB_OUT_OF_MEMORY;
   }
 
   auto &buffer = slot->m_request;
-  auto fh{slot->m_io_ctx.m_fil_node->m_fh};
+  const auto fixed_fd{slot->m_io_ctx.m_fil_node->m_fixed_fd};
+  const auto fh{fixed_fd != -1 ? fixed_fd : slot->m_io_ctx.m_fil_node->m_fh};
 
   /* Do the i/o with ordinary, synchronous i/o functions: */
   if (slot->m_io_ctx.is_read_request()) {
-    io_uring_prep_read(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    if (slot->m_buf_index != -1) {
+      io_uring_prep_read_fixed(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off, slot->m_buf_index);
+    } else {
+      io_uring_prep_read(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    }
+  } else if (slot->m_n_iovs > 0) {
+    /* RWF_ATOMIC covers a single buffer, the callers use the doublewrite
+    buffer for the pages that are written with one vectored write. */
+    auto iov = &slot->m_iovs[slot->m_iov_first];
+
+    io_uring_prep_writev(sqe, fh, iov, slot->m_n_iovs - slot->m_iov_first, slot->m_off);
   } else {
-    io_uring_prep_write(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    if (slot->m_buf_index != -1) {
+      io_uring_prep_write_fixed(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off, slot->m_buf_index);
+    } else {
+      io_uring_prep_write(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    }
+
+#ifdef RWF_ATOMIC
+    if (slot->m_io_ctx.m_fil_node->m_atomic_writes) {
+      /* The device only guarantees that the write is not torn if asked to. */
+      sqe->rw_flags |= RWF_ATOMIC;
+    }
+#endif /* RWF_ATOMIC */
+  }
+
+  if (fixed_fd != -1) {
+    /* The fd is the index of the file in the registered files. */
+    io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
   }
 
+  sqe->ioprio = IO_CLASS_POLICIES[ulint(slot->m_io_ctx.m_io_class)].m_ioprio;
+
   io_uring_sqe_set_data64(sqe, uintptr_t(slot));
 
   m_pending_slots.fetch_add(1, std::memory_order_relaxed);
 
   m_stats.m_n_sqes.fetch_add(1, std::memory_order_relaxed);
 
-  for (;;) {
+  m_n_queued.fetch_add(1, std::memory_order_relaxed);
+
+  return DB_SUCCESS;
+}
+
+bool Handler::Queue::append_to_run(const IO_ctx &io_ctx, void *ptr, uint32_t len, off_t off, std::chrono::microseconds window) noexcept {
+  if (m_open_run.load(std::memory_order_relaxed) == nullptr) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto slot = m_open_run.load(std::memory_order_relaxed);
+
+  if (slot == nullptr || slot->m_io_ctx.m_fil_node != io_ctx.m_fil_node || slot->m_off + off_t(slot->m_request.m_len) != off) {
+    return false;
+  }
+
+  if (std::chrono::steady_clock::now() - slot->m_start > window) {
+    /* Don't hold the pages of the run back any longer. */
+    close_run_low();
+    submit_low();
+    return false;
+  }
+
+  ut_a(slot->m_n_msgs < slot->m_msgs.size());
+
+  slot->m_iovs[slot->m_n_iovs++] = {ptr, len};
+  slot->m_msgs[slot->m_n_msgs] = io_ctx.m_msg;
+  slot->m_msg_lens[slot->m_n_msgs++] = len;
+  slot->m_request.m_len += len;
+
+  m_stats.m_n_coalesced.fetch_add(1, std::memory_order_relaxed);
+
+  if (slot->m_n_msgs == slot->m_msgs.size()) {
+    close_run_low();
+    submit_low();
+  }
+
+  return true;
+}
+
+void Handler::Queue::open_run(Slot *slot) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  close_run_low();
+
+  slot->m_iovs[0] = {slot->m_request.m_ptr, slot->m_request.m_len};
+  slot->m_n_iovs = 1;
+  slot->m_msgs[0] = slot->m_io_ctx.m_msg;
+  slot->m_msg_lens[0] = slot->m_request.m_len;
+  slot->m_n_msgs = 1;
+
+  m_open_run.store(slot, std::memory_order_relaxed);
+}
+
+void Handler::Queue::close_run_low() noexcept {
+  auto slot = m_open_run.load(std::memory_order_relaxed);
+
+  if (slot == nullptr) {
+    return;
+  }
+
+  m_open_run.store(nullptr, std::memory_order_relaxed);
+
+  if (slot->m_n_msgs == 1) {
+    /* Nothing was appended, write it as an ordinary request. */
+    slot->m_n_iovs = 0;
+    slot->m_n_msgs = 0;
+  }
+
+  /* The ring has room for all the slots of the handler. */
+  const auto err = enqueue_low(slot);
+  ut_a(err == DB_SUCCESS);
+}
+
+void Handler::Queue::submit_low() noexcept {
+  while (m_n_queued.load(std::memory_order_relaxed) > 0) {
     const auto ret = io_uring_submit(&m_iouring);
 
-    switch(ret) {
-      case 1:
-        return DB_SUCCESS;
-      case -EINTR:
-      case -EAGAIN:
-        m_stats.m_sqe_eintrs.fetch_add(1);
-        continue;
-      default:
-        log_fatal("io_uring_submit failed: " + std::to_string(ret));
+    if (ret > 0) {
+      ut_a(ulint(ret) <= m_n_queued.load(std::memory_order_relaxed));
+      m_n_queued.fetch_sub(ret, std::memory_order_relaxed);
+    } else if (ret == -EINTR || ret == -EAGAIN) {
+      m_stats.m_sqe_eintrs.fetch_add(1);
+    } else {
+      log_fatal("io_uring_submit failed: " + std::to_string(ret));
     }
-    return DB_ERROR;
   }
-} 
+}
 
 db_err Handler::Queue::reap(IO_ctx &io_ctx) noexcept {
   ut_ad(m_handler->validate());
 
+  if (!m_fan_out.empty()) {
+    io_ctx = m_fan_out.back();
+    m_fan_out.pop_back();
+    return DB_SUCCESS;
+  }
+
   io_uring_cqe *cqe;
 
   for (;;) {
@@ -687,13 +1473,29 @@ db_err Handler::Queue::reap(IO_ctx &io_ctx) noexcept {
     slot->m_request.m_len -= cqe->res;
     slot->m_request.m_ptr += cqe->res;
 
+    if (slot->m_n_iovs > 0) {
+      /* Skip the buffers that were written, a partial one is advanced. */
+      for (auto n = size_t(cqe->res); n > 0; ) {
+        auto &iov = slot->m_iovs[slot->m_iov_first];
+
+        if (n < iov.iov_len) {
+          iov.iov_base = static_cast<byte *>(iov.iov_base) + n;
+          iov.iov_len -= n;
+          break;
+        }
+
+        n -= iov.iov_len;
+        ++slot->m_iov_first;
+      }
+    }
+
     m_stats.m_total.fetch_add(cqe->res, std::memory_order_relaxed);
 
     if (slot->m_request.m_len > 0) {
       m_stats.m_partial_ops.fetch_add(1, std::memory_order_relaxed);
       m_stats.m_partial_data.fetch_add(slot->m_request.m_len, std::memory_order_relaxed);
       /* It was a partial read/write, try and read the remaining bytes. */
-      submit(slot);
+      submit(slot, false);
     } else {
       slot->m_io_ctx.m_ret = cqe->res;
 
@@ -704,6 +1506,27 @@ db_err Handler::Queue::reap(IO_ctx &io_ctx) noexcept {
 
       io_ctx = slot->m_io_ctx;
 
+      if (slot->m_n_msgs > 0) {
+        /* Each coalesced write is completed on its own, the others are
+        returned by the next calls. */
+        io_ctx.m_ret = int(slot->m_msg_lens[0]);
+
+        for (ulint i{1}; i < slot->m_n_msgs; ++i) {
+          m_fan_out.push_back(slot->m_io_ctx);
+          m_fan_out.back().m_msg = slot->m_msgs[i];
+          m_fan_out.back().m_ret = int(slot->m_msg_lens[i]);
+        }
+      }
+
+      if (m_handler->is_write() && slot->m_n_iovs == 0) {
+        /* Only the single buffer writes, a vectored write would skew the
+        average towards its length. */
+        m_handler->update_latency(slot);
+      }
+
+      m_handler->complete_class(slot);
+
+      m_handler->record_latency(this, slot);
 
       m_handler->mark_as_free(slot);
 
@@ -750,6 +1573,26 @@ Handler::Queue *Impl::get_queue(ulint queue_id) noexcept {
   }
 }
 
+/**
+ * @brief Checks that an i/o satisfies the O_DIRECT alignment of its file. A
+ * misaligned i/o would fail with EINVAL, report the request instead.
+ *
+ * @param[in] io_ctx           Context of the i/o operation.
+ * @param[in] ptr              Buffer of the i/o.
+ * @param[in] n                Length of the i/o in bytes.
+ * @param[in] off              File offset of the i/o.
+ */
+static void check_direct_io_align(const IO_ctx &io_ctx, const void *ptr, ulint n, off_t off) noexcept {
+  const auto align = io_ctx.m_fil_node->m_direct_io_align;
+
+  if (unlikely(!os_file_is_direct_io_aligned(align, ptr, n, off))) {
+    log_fatal(std::format(
+      "{} of {} bytes at offset {} from buffer {} to '{}' is not aligned to {} bytes as O_DIRECT requires",
+      to_string(io_ctx.m_io_request), n, off, ptr, io_ctx.m_fil_node->m_file_name, align
+    ));
+  }
+}
+
 db_err Impl::submit(IO_ctx&& io_ctx, void *ptr, ulint n, off_t off) noexcept {
   io_ctx.validate();
 
@@ -758,26 +1601,438 @@ db_err Impl::submit(IO_ctx&& io_ctx, void *ptr, ulint n, off_t off) noexcept {
   ut_ad(n % IB_FILE_BLOCK_SIZE == 0);
   ut_ad(off % IB_FILE_BLOCK_SIZE == 0);
 
+  check_direct_io_align(io_ctx, ptr, n, off);
+
   if (io_ctx.is_sync_request()) {
-    auto fh{io_ctx.m_fil_node->m_fh};
+    return submit_sync(io_ctx, ptr, n, off);
+  }
+  if (io_ctx.m_batch && m_coalesce_window.count() > 0 && can_coalesce(io_ctx)) {
+    return coalesce(std::move(io_ctx), ptr, n, off);
+  }
 
-    if (io_ctx.is_read_request()) {
-      return os_file_read(fh, ptr, n, off) ? DB_SUCCESS : DB_ERROR;
-    } else {
-      auto name{io_ctx.m_fil_node->m_file_name};
+  /* Only reads are batched in the submission queue, batched writes are
+  coalesced above. */
+  const auto batch = io_ctx.m_batch && io_ctx.is_read_request();
+
+  auto handler = m_handlers[get_type(io_ctx)];
+
+  acquire_class_slot(handler, io_ctx.m_io_class);
+
+  auto queue = handler->get_queue_for_submit(batch);
+  auto slot = queue->reserve_slot(io_ctx, ptr, n, off);
+
+  slot->m_buf_index = find_fixed_buffer(ptr, n);
+
+  queue->submit(slot, batch);
+
+  return DB_SUCCESS;
+}
+
+db_err Impl::submit_sync(const IO_ctx &io_ctx, void *ptr, ulint n, off_t off) noexcept {
+  auto &state = m_classes[ulint(io_ctx.m_io_class)];
+  const auto start = std::chrono::steady_clock::now();
+  auto fh{io_ctx.m_fil_node->m_fh};
+  bool success;
+
+  state.m_n_pending.fetch_add(1, std::memory_order_relaxed);
+
+  if (io_ctx.is_read_request()) {
+    success = os_file_read(fh, ptr, n, off);
+  } else if (io_ctx.m_io_request == IO_request::Sync_log_write_durable) {
+    success = write_durable(io_ctx, ptr, n, off);
+  } else {
+    auto name{io_ctx.m_fil_node->m_file_name};
+
+    success = os_file_write(name, fh, ptr, n, off);
+  }
+
+  state.update_latency(start);
+  state.m_n_pending.fetch_sub(1, std::memory_order_relaxed);
+
+  const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  record_latency(m_by_request, io_ctx, static_cast<const byte *>(ptr), n, off, uint64_t(us));
+
+  return success ? DB_SUCCESS : DB_ERROR;
+}
+
+void Impl::acquire_class_slot(Handler *handler, IO_class io_class) noexcept {
+  auto &state = m_classes[ulint(io_class)];
+  const auto limit = handler->get_class_limit(io_class);
+
+  for (;;) {
+    auto n = state.m_n_pending.load(std::memory_order_relaxed);
+
+    if (n < limit) {
+      if (state.m_n_pending.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
 
-      return os_file_write(name, fh, ptr, n, off) ? DB_SUCCESS : DB_ERROR;
+    /* The class holds its share of the slots, the requests that it queued
+    must be submitted for them to complete. */
+    handler->submit_queued();
+
+    const auto sig_count = state.m_slot_freed->reset();
+
+    if (state.m_n_pending.load(std::memory_order_relaxed) >= limit) {
+      ut::Wait_timer slot_wait(ut::Wait_type::AIO_SLOT, uint64_t(io_class), __FILE__, __LINE__);
+
+      slot_wait.start();
+      state.m_slot_freed->wait(sig_count);
     }
   }
-  auto handler = m_handlers[get_type(io_ctx)];
-  auto queue = handler->get_queue_for_submit();
+}
+
+IO_class_stats Impl::get_class_stats(IO_class io_class) const noexcept {
+  return m_classes[ulint(io_class)].get_stats();
+}
+
+void Impl::get_latency(IO_request io_request, ut::Latency_histogram &histogram) const noexcept {
+  histogram.add(m_by_request[ulint(io_request)]);
+}
+
+std::string Impl::latency_to_string() const {
+  std::string str;
+
+  for (ulint i{}; i < IO_REQUEST_COUNT; ++i) {
+    const auto percentiles = m_by_request[i].get_percentiles();
+
+    if (percentiles.m_count > 0) {
+      str += std::format("{}: {}\n", ::to_string(IO_request(i)), percentiles.to_string());
+    }
+  }
+
+  const std::array<const char *, WRITE + 1> names{"log", "read", "write"};
+
+  for (auto handler : m_handlers) {
+    for (auto queue : handler->m_queues) {
+      str += std::format("{} queue {}: {}\n", names[handler->m_id], queue->m_id, queue->m_latency.get_percentiles().to_string());
+    }
+  }
+
+  return str;
+}
+
+bool Impl::can_coalesce(const IO_ctx &io_ctx) const noexcept {
+  /* RWF_ATOMIC covers a single buffer, such writes are not merged. The
+  fanned out completions of a merged write would share the compressed
+  image of the first one. */
+  return io_ctx.m_io_request == IO_request::Async_write && !io_ctx.m_fil_node->m_atomic_writes &&
+         io_ctx.m_comp_buf == nullptr;
+}
+
+db_err Impl::coalesce(IO_ctx&& io_ctx, void *ptr, ulint n, off_t off) noexcept {
+  auto handler = m_handlers[WRITE];
+
+  for (auto queue : handler->m_queues) {
+    if (queue->append_to_run(io_ctx, ptr, uint32_t(n), off, m_coalesce_window)) {
+      return DB_SUCCESS;
+    }
+  }
+
+  acquire_class_slot(handler, io_ctx.m_io_class);
+
+  auto queue = handler->get_queue_for_submit(false);
   auto slot = queue->reserve_slot(io_ctx, ptr, n, off);
 
-  queue->submit(slot);
+  slot->m_buf_index = find_fixed_buffer(ptr, n);
+
+  queue->open_run(slot);
 
   return DB_SUCCESS;
 }
 
+db_err Impl::submit_vectored(IO_ctx&& io_ctx, const iovec *iov, ulint n_iov, off_t off) noexcept {
+  io_ctx.validate();
+
+  ut_a(n_iov > 0);
+  ut_a(n_iov <= MAX_IOVS);
+  ut_a(!io_ctx.is_sync_request());
+  ut_a(!io_ctx.is_read_request());
+  ut_a(!io_ctx.is_log_request());
+  ut_ad(off % IB_FILE_BLOCK_SIZE == 0);
+
+  ulint n{};
+
+  for (ulint i{}; i < n_iov; ++i) {
+    ut_ad(iov[i].iov_len % IB_FILE_BLOCK_SIZE == 0);
+    check_direct_io_align(io_ctx, iov[i].iov_base, iov[i].iov_len, off_t(off + n));
+    n += iov[i].iov_len;
+  }
+
+  auto handler = m_handlers[WRITE];
+
+  acquire_class_slot(handler, io_ctx.m_io_class);
+
+  auto queue = handler->get_queue_for_submit(false);
+  auto slot = queue->reserve_slot(io_ctx, iov[0].iov_base, n, off);
+
+  std::copy(iov, iov + n_iov, slot->m_iovs.begin());
+  slot->m_n_iovs = n_iov;
+
+  queue->submit(slot, false);
+
+  return DB_SUCCESS;
+}
+
+bool Impl::write_durable(const IO_ctx &io_ctx, void *ptr, ulint n, off_t off) noexcept {
+  auto fh{io_ctx.m_fil_node->m_fh};
+
+  std::lock_guard<std::mutex> lock(m_sync_mutex);
+
+  auto sqe = io_uring_get_sqe(&m_sync_ring);
+  ut_a(sqe != nullptr);
+
+  /* A short or failed write cancels the linked fdatasync. */
+  io_uring_prep_write(sqe, fh, ptr, n, off);
+  io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+  io_uring_sqe_set_data64(sqe, 0);
+
+  sqe = io_uring_get_sqe(&m_sync_ring);
+  ut_a(sqe != nullptr);
+
+  io_uring_prep_fsync(sqe, fh, IORING_FSYNC_DATASYNC);
+  io_uring_sqe_set_data64(sqe, 1);
+
+  for (;;) {
+    const auto ret = io_uring_submit_and_wait(&m_sync_ring, 2);
+
+    if (ret == 2) {
+      break;
+    } else if (ret != -EINTR && ret != -EAGAIN) {
+      log_fatal("io_uring_submit failed: " + std::to_string(ret));
+    }
+  }
+
+  std::array<int, 2> res{};
+
+  for (ulint i{}; i < res.size();) {
+    io_uring_cqe *cqe;
+
+    if (const auto ret = io_uring_wait_cqe(&m_sync_ring, &cqe); ret == -EINTR) {
+      continue;
+    } else if (ret < 0) {
+      log_fatal("io_uring_wait_cqe failed: " + std::to_string(ret));
+    }
+
+    res[io_uring_cqe_get_data64(cqe)] = cqe->res;
+
+    io_uring_cqe_seen(&m_sync_ring, cqe);
+
+    ++i;
+  }
+
+  if (res[0] == int(n) && res[1] == 0) {
+    return true;
+  }
+
+  /* A short write, or the file system does not support the request: write
+  it again and sync it the traditional way. */
+  return os_file_write(io_ctx.m_fil_node->m_file_name, fh, ptr, n, off) && os_file_flush(fh);
+}
+
+void Impl::sync_files(const os_file_t *files, ulint n_files) noexcept {
+  std::array<int, FSYNC_RING_SIZE> res;
+
+  std::lock_guard<std::mutex> lock(m_fsync_mutex);
+
+  for (ulint start{}; start < n_files; start += FSYNC_RING_SIZE) {
+    const auto n = std::min(n_files - start, ulint(FSYNC_RING_SIZE));
+
+    for (ulint i{}; i < n; ++i) {
+      auto sqe = io_uring_get_sqe(&m_fsync_ring);
+      ut_a(sqe != nullptr);
+
+      io_uring_prep_fsync(sqe, files[start + i], 0);
+      io_uring_sqe_set_data64(sqe, i);
+    }
+
+    for (ulint submitted{}; submitted < n; ) {
+      const auto ret = io_uring_submit(&m_fsync_ring);
+
+      if (ret >= 0) {
+        submitted += ulint(ret);
+      } else if (ret != -EINTR && ret != -EAGAIN) {
+        log_fatal("io_uring_submit failed: " + std::to_string(ret));
+      }
+    }
+
+    for (ulint i{}; i < n;) {
+      io_uring_cqe *cqe;
+
+      if (const auto ret = io_uring_wait_cqe(&m_fsync_ring, &cqe); ret == -EINTR) {
+        continue;
+      } else if (ret < 0) {
+        log_fatal("io_uring_wait_cqe failed: " + std::to_string(ret));
+      }
+
+      res[io_uring_cqe_get_data64(cqe)] = cqe->res;
+
+      io_uring_cqe_seen(&m_fsync_ring, cqe);
+
+      ++i;
+    }
+
+    os_n_fsyncs += n;
+
+    for (ulint i{}; i < n; ++i) {
+      if (res[i] != 0) {
+        /* Let the synchronous path retry and report the error, it also
+        accepts EINVAL from raw devices. */
+        (void) os_file_flush(files[start + i]);
+      }
+    }
+  }
+}
+
+void Impl::register_buffer(void *ptr, ulint len) noexcept {
+  if (!m_use_fixed_buffers) {
+    return;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(m_fixed_mutex);
+
+  for (auto start = static_cast<byte *>(ptr); len > 0; ) {
+    if (m_free_buffers.empty()) {
+      log_warn("The io_uring fixed buffer tables are full, a buffer pool area is not registered");
+      return;
+    }
+
+    const auto n = std::min(len, MAX_FIXED_BUFFER_SIZE);
+    const auto index = m_free_buffers.back();
+    iovec iov{start, n};
+    int ret{};
+
+    for_each_queue([&](Handler::Queue *queue) {
+      if (ret >= 0) {
+        ret = io_uring_register_buffers_update_tag(&queue->m_iouring, index, &iov, nullptr, 1);
+      }
+    });
+
+    if (ret < 0) {
+      /* Typically RLIMIT_MEMLOCK, clear the entry in the rings that took it. */
+      iovec empty{};
+
+      for_each_queue([&](Handler::Queue *queue) {
+        (void) io_uring_register_buffers_update_tag(&queue->m_iouring, index, &empty, nullptr, 1);
+      });
+
+      log_warn("Registering a buffer pool area with io_uring failed: ", std::to_string(ret));
+      return;
+    }
+
+    m_free_buffers.pop_back();
+    m_fixed_buffers[start] = Fixed_buffer{n, index};
+
+    start += n;
+    len -= n;
+  }
+}
+
+void Impl::unregister_buffer(void *ptr, ulint len) noexcept {
+  if (!m_use_fixed_buffers) {
+    return;
+  }
+
+  const auto start = static_cast<const byte *>(ptr);
+
+  std::unique_lock<std::shared_mutex> lock(m_fixed_mutex);
+
+  auto it = m_fixed_buffers.lower_bound(start);
+
+  while (it != m_fixed_buffers.end() && it->first < start + len) {
+    iovec empty{};
+    const auto index = it->second.m_index;
+
+    for_each_queue([&](Handler::Queue *queue) {
+      (void) io_uring_register_buffers_update_tag(&queue->m_iouring, index, &empty, nullptr, 1);
+    });
+
+    m_free_buffers.push_back(index);
+    it = m_fixed_buffers.erase(it);
+  }
+}
+
+int Impl::find_fixed_buffer(const void *ptr, ulint n) const noexcept {
+  if (!m_use_fixed_buffers) {
+    return -1;
+  }
+
+  const auto start = static_cast<const byte *>(ptr);
+
+  std::shared_lock<std::shared_mutex> lock(m_fixed_mutex);
+
+  auto it = m_fixed_buffers.upper_bound(start);
+
+  if (it == m_fixed_buffers.begin()) {
+    return -1;
+  }
+
+  --it;
+
+  return start + n <= it->first + it->second.m_len ? it->second.m_index : -1;
+}
+
+int Impl::register_file(os_file_t fh) noexcept {
+  if (!m_use_fixed_files) {
+    return -1;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(m_fixed_mutex);
+
+  if (m_free_files.empty()) {
+    return -1;
+  }
+
+  const auto index = m_free_files.back();
+  int ret{};
+
+  for_each_queue([&](Handler::Queue *queue) {
+    if (ret >= 0) {
+      ret = io_uring_register_files_update(&queue->m_iouring, index, &fh, 1);
+    }
+  });
+
+  if (ret < 0) {
+    int empty{-1};
+
+    for_each_queue([&](Handler::Queue *queue) {
+      (void) io_uring_register_files_update(&queue->m_iouring, index, &empty, 1);
+    });
+
+    return -1;
+  }
+
+  m_free_files.pop_back();
+
+  return index;
+}
+
+void Impl::unregister_file(int index) noexcept {
+  ut_a(index >= 0 && unsigned(index) < MAX_FIXED_FILES);
+
+  std::unique_lock<std::shared_mutex> lock(m_fixed_mutex);
+
+  int empty{-1};
+
+  for_each_queue([&](Handler::Queue *queue) {
+    (void) io_uring_register_files_update(&queue->m_iouring, index, &empty, 1);
+  });
+
+  m_free_files.push_back(index);
+}
+
+std::chrono::microseconds Impl::get_write_latency() const noexcept {
+  return std::chrono::microseconds(m_handlers[WRITE]->m_latency.load(std::memory_order_relaxed));
+}
+
+void Impl::submit_batch() noexcept {
+  m_handlers[READ]->submit_queued();
+  m_handlers[WRITE]->submit_queued();
+}
+
 std::string Impl::to_string() noexcept {
   std::ostringstream os{};
 
@@ -791,6 +2046,17 @@ std::string Impl::to_string() noexcept {
     }
   }
 
+  os << "], classes = [";
+
+  for (ulint i{}; i < IO_CLASS_COUNT; ++i) {
+    const auto stats = m_classes[i].get_stats();
+
+    os << std::format(
+      "{}{}: {{ pending: {}, latency: {}us, baseline: {}us }}",
+      i > 0 ? ", " : "", ::to_string(IO_class(i)),
+      stats.m_n_pending, stats.m_latency.count(), stats.m_baseline.count());
+  }
+
   os << "]";
 
   return os.str();
@@ -801,6 +2067,9 @@ db_err Impl::reap(ulint handler_id, IO_ctx &io_ctx) noexcept {
 }
 
 void Impl::wait_for_pending_ops(ulint handler_id) noexcept {
+  /* The open write runs would never complete otherwise. */
+  m_handlers[handler_id]->submit_queued();
+
   m_handlers[handler_id]->m_is_empty->wait(0);
 }
 
@@ -822,11 +2091,11 @@ void IO_ctx::validate() const noexcept {
   ut_a(m_fil_node->m_file_name != nullptr);
 }
 
-AIO* AIO::create(ulint max_slots, ulint read_queues, ulint write_queues) noexcept {
+AIO* AIO::create(ulint max_slots, ulint read_queues, ulint write_queues, bool sqpoll, bool per_cpu, std::chrono::microseconds coalesce_window) noexcept {
   ut_a(read_queues > 0);
   ut_a(write_queues > 0);
 
-  return new (ut_new(sizeof(aio::Impl))) aio::Impl(max_slots, read_queues, write_queues);
+  return new (ut_new(sizeof(aio::Impl))) aio::Impl(max_slots, read_queues, write_queues, sqpoll, per_cpu, coalesce_window);
 }
 
 void AIO::destroy(AIO *&aio) noexcept {
@@ -33,21 +33,28 @@ Created 10/21/1995 Heikki Tuuri
 
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/falloc.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <vector>
 
 #include "api0misc.h"
 #include "buf0buf.h"
 #include "fil0fil.h"
+#include "log0types.h"
 #include "os0file.h"
 #include "srv0srv.h"
 #include "ut0mem.h"
 #include "os0sync.h"
 #include "os0thread.h"
+#include "ut0wait.h"
 
 /** Umask for creating files */
 constexpr lint CREATE_MASK = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
@@ -262,6 +269,23 @@ static int os_file_lock(int fd, const char *name) {
 }
 #endif /* USE_FILE_LOCK */
 
+/** Refuses to create a file when the instance is read-only.
+@param[in] name                 File name.
+@param[in] create_mode          OS_FILE_OPEN, OS_FILE_CREATE, etc.
+@return true if the file must not be created. */
+static bool os_file_create_is_read_only(const char *name, ulint create_mode) {
+  if (!srv_config.m_read_only || create_mode == OS_FILE_OPEN || create_mode == OS_FILE_OPEN_RAW ||
+      create_mode == OS_FILE_OPEN_RETRY) {
+    return false;
+  }
+
+  log_err("Cannot create the file ", name, ", the instance is read-only.");
+
+  errno = EROFS;
+
+  return true;
+}
+
 void os_file_init() { /* Do nothing. */}
 
 void os_file_free() { /* Do Nothing. */}
@@ -304,12 +328,17 @@ bool os_file_create_directory(const char *pathname, bool fail_if_exists) {
 os_file_t os_file_create_simple(const char *name, ulint create_mode, ulint access_type, bool *success) {
   ut_a(name != nullptr);
 
+  if (os_file_create_is_read_only(name, create_mode)) {
+    *success = false;
+    return -1;
+  }
+
   for (;;) {
     int create_flag;
     os_file_t file{-1};
 
     if (create_mode == OS_FILE_OPEN) {
-      if (access_type == OS_FILE_READ_ONLY) {
+      if (access_type == OS_FILE_READ_ONLY || srv_config.m_read_only) {
         create_flag = O_RDONLY;
       } else {
         create_flag = O_RDWR;
@@ -358,6 +387,17 @@ os_file_t os_file_create_simple_no_error_handling(const char *name, ulint create
 
   ut_a(name);
 
+  if (os_file_create_is_read_only(name, create_mode)) {
+    *success = false;
+    return -1;
+  }
+
+  if (srv_config.m_read_only) {
+    /* The files may be shared with the instance that writes them, do not
+    take the write lock either. */
+    access_type = OS_FILE_READ_ONLY;
+  }
+
   if (create_mode == OS_FILE_OPEN) {
     if (access_type == OS_FILE_READ_ONLY) {
       create_flag = O_RDONLY;
@@ -392,7 +432,7 @@ os_file_t os_file_create_simple_no_error_handling(const char *name, ulint create
   return file;
 }
 
-void os_file_set_nocache(int fd, const char *file_name, const char *operation_name) {
+bool os_file_set_nocache(int fd, const char *file_name, const char *operation_name) {
   if (fcntl(fd, F_SETFL, O_DIRECT) == -1) {
     auto errno_save = errno;
 
@@ -402,19 +442,28 @@ void os_file_set_nocache(int fd, const char *file_name, const char *operation_na
     if (errno_save == EINVAL) {
       ib_logger(ib_stream, "  O_DIRECT is known to result in " "'Invalid argument' on Linux on tmpfs.");
     }
+
+    return false;
   }
+
+  return true;
 }
 
 os_file_t os_file_create(const char *name, ulint create_mode, ulint purpose, ulint type, bool *success) {
   bool retry;
 
+  if (os_file_create_is_read_only(name, create_mode)) {
+    *success = false;
+    return -1;
+  }
+
   for (;;) {
     int create_flag;
     const char *mode_str = nullptr;
 
     if (create_mode == OS_FILE_OPEN || create_mode == OS_FILE_OPEN_RAW || create_mode == OS_FILE_OPEN_RETRY) {
       mode_str = "OPEN";
-      create_flag = O_RDWR;
+      create_flag = srv_config.m_read_only ? O_RDONLY : O_RDWR;
     } else if (create_mode == OS_FILE_CREATE) {
       mode_str = "CREATE";
       create_flag = O_RDWR | O_CREAT | O_EXCL;
@@ -439,6 +488,10 @@ os_file_t os_file_create(const char *name, ulint create_mode, ulint purpose, uli
     }
 #endif /* O_SYNC */
 
+    if (type == OS_LOG_FILE && srv_config.m_log_io_mode == LOG_IO_DIRECT_DSYNC) {
+      create_flag = create_flag | O_DSYNC;
+    }
+
     auto file = open(name, create_flag, CREATE_MASK);
 
     if (file == -1) {
@@ -462,15 +515,65 @@ os_file_t os_file_create(const char *name, ulint create_mode, ulint purpose, uli
 
     *success = true;
 
-    /* We disable OS caching (O_DIRECT) only on data files */
+    /* The flush_method disables OS caching (O_DIRECT) only on data files,
+    the log_io_mode on the log files */
     if (type != OS_LOG_FILE && srv_config.m_unix_file_flush_method == SRV_UNIX_O_DIRECT) {
       os_file_set_nocache(file, name, mode_str);
+    } else if (type == OS_LOG_FILE && srv_config.m_log_io_mode != LOG_IO_BUFFERED) {
+      os_file_set_nocache(file, name, mode_str);
     }
 
     return file;
   }
 }
 
+bool os_file_supports_atomic_writes(os_file_t file, ulint len) {
+#if defined(STATX_WRITE_ATOMIC) && defined(RWF_ATOMIC)
+  struct statx stx;
+
+  if (statx(file, "", AT_EMPTY_PATH, STATX_WRITE_ATOMIC, &stx) != 0) {
+    return false;
+  }
+
+  return (stx.stx_mask & STATX_WRITE_ATOMIC) != 0 && (stx.stx_attributes & STATX_ATTR_WRITE_ATOMIC) != 0 &&
+         stx.stx_atomic_write_unit_min <= len && stx.stx_atomic_write_unit_max >= len;
+#else
+  (void) file;
+  (void) len;
+
+  return false;
+#endif /* STATX_WRITE_ATOMIC && RWF_ATOMIC */
+}
+
+ulint os_file_get_direct_io_align(os_file_t file) {
+  const auto flags = fcntl(file, F_GETFL);
+
+  if (flags == -1 || (flags & O_DIRECT) == 0) {
+    return 0;
+  }
+
+#ifdef STATX_DIOALIGN
+  struct statx stx;
+
+  if (statx(file, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN) != 0 &&
+      stx.stx_dio_offset_align > 0) {
+    return std::max(ulint(stx.stx_dio_mem_align), ulint(stx.stx_dio_offset_align));
+  }
+#endif /* STATX_DIOALIGN */
+
+  struct stat st;
+
+  if (fstat(file, &st) == 0 && S_ISBLK(st.st_mode)) {
+    int sector_size;
+
+    if (ioctl(file, BLKSSZGET, &sector_size) == 0 && sector_size > 0) {
+      return ulint(sector_size);
+    }
+  }
+
+  return IB_FILE_BLOCK_SIZE;
+}
+
 bool os_file_delete_if_exists(const char *name) {
   int ret = unlink(name);
 
@@ -537,6 +640,36 @@ int64_t os_file_get_size_as_iblonglong(os_file_t file) {
   }
 }
 
+bool os_file_allocate(os_file_t file, off_t offset, off_t len) {
+  int ret;
+
+  do {
+    ret = fallocate(file, 0, offset, len);
+  } while (ret == -1 && errno == EINTR);
+
+  return ret == 0;
+}
+
+bool os_file_punch_hole(os_file_t file, off_t offset, off_t len) {
+  int ret;
+
+  do {
+    ret = fallocate(file, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, len);
+  } while (ret == -1 && errno == EINTR);
+
+  return ret == 0;
+}
+
+ulint os_file_get_block_size(os_file_t file) {
+  struct stat st;
+
+  if (fstat(file, &st) == 0 && st.st_blksize > 0) {
+    return ulint(st.st_blksize);
+  }
+
+  return IB_FILE_BLOCK_SIZE;
+}
+
 bool os_file_set_size(const char *name, os_file_t file, off_t desired_size) {
   ut_a(desired_size >= off_t(UNIV_PAGE_SIZE));
 
@@ -602,7 +735,12 @@ static int os_file_fsync(os_file_t file) {
   int failures = 0;
 
   do {
-    ret = fsync(file);
+    {
+      ut::Wait_timer fsync_wait(ut::Wait_type::FSYNC, uint64_t(file), __FILE__, __LINE__);
+
+      fsync_wait.start();
+      ret = fsync(file);
+    }
 
     ++os_n_fsyncs;
 
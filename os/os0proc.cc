@@ -33,123 +33,324 @@ Created 9/30/1995 Heikki Tuuri
 #include <unistd.h>
 #endif /* HAVE_UNIST_H */
 
+#ifdef UNIV_LINUX
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif /* UNIV_LINUX */
+
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "os0proc.h"
 #include "ut0byte.h"
 #include "ut0mem.h"
 
 #define OS_MAP_ANON MAP_ANONYMOUS
 
-bool os_use_large_pages;
-
-/* Large page size. This may be a boot-time option on some platforms */
-ulint os_large_page_size;
+/** Number of NUMA nodes with memory, 0 if not determined yet. */
+static ulint os_numa_n_nodes;
 
 /** Reset the variables. */
 
 void os_proc_var_init() {
-  os_use_large_pages = 0;
-  os_large_page_size = 0;
+  os_numa_n_nodes = 0;
 }
 
 ulint os_proc_get_number() {
   return (ulint)getpid();
 }
 
-void *os_mem_alloc_large(ulint *n) {
-  void *ptr;
-  ulint size;
-
-#if defined HAVE_LARGE_PAGES && defined UNIV_LINUX
-  int shmid;
-  struct shmid_ds buf;
-
-  if (!os_use_large_pages || !os_large_page_size) {
-    goto skip;
-  }
-
-  /* Align block size to os_large_page_size */
-  ut_ad(ut_is_2pow(os_large_page_size));
-  size = ut_2pow_round(*n + (os_large_page_size - 1), os_large_page_size);
-
-  shmid = shmget(IPC_PRIVATE, (size_t)size, SHM_HUGETLB | SHM_R | SHM_W);
-  if (shmid < 0) {
-    ib_logger(
-      ib_stream,
-      "HugeTLB: Warning: Failed to allocate"
-      " %lu bytes. errno %d\n",
-      size,
-      errno
-    );
-    ptr = NULL;
-  } else {);
-
-  ut_a(block->m_magic_n == UT_MEM_MAGIC_N);
-  ut_a(ut_total_allocated_memory >= block->m_size);
-    ptr = shmat(shmid, NULL, 0);
-    if (ptr == (void *)-1) {
-      ib_logger(
-        ib_stream,
-        "HugeTLB: Warning: Failed to"
-        " attach shared memory segment, errno %d\n",
-        errno
-      );
-      ptr = NULL;
+ulint os_numa_get_n_nodes() {
+  if (os_numa_n_nodes == 0) {
+    ulint n_nodes{};
+
+#ifdef UNIV_LINUX
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+
+    for (const auto &entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+      const auto name = entry.path().filename().string();
+
+      if (name.starts_with("node") && name.size() > 4 && isdigit(name[4])) {
+        ++n_nodes;
+      }
     }
+#endif /* UNIV_LINUX */
+
+    os_numa_n_nodes = std::max(ulint(1), n_nodes);
+  }
+
+  return os_numa_n_nodes;
+}
+
+bool os_cpu_list_parse(const char *list, std::vector<ulint> &cpus) {
+  cpus.clear();
+
+  for (auto ptr = list; *ptr != '\0';) {
+    char *end;
+    const auto first = strtoul(ptr, &end, 10);
+
+    if (end == ptr) {
+      return false;
+    }
+
+    auto last = first;
+
+    ptr = end;
+
+    if (*ptr == '-') {
+      ++ptr;
+      last = strtoul(ptr, &end, 10);
+
+      if (end == ptr || last < first) {
+        return false;
+      }
+
+      ptr = end;
+    }
+
+    for (auto cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+
+    if (*ptr == ',') {
+      ++ptr;
+    } else if (*ptr != '\0' && *ptr != '\n') {
+      return false;
+    } else {
+      break;
+    }
+  }
+
+  return !cpus.empty();
+}
+
+bool os_numa_node_get_cpus(ulint node, std::vector<ulint> &cpus) {
+  cpus.clear();
+
+#ifdef UNIV_LINUX
+  std::ifstream file(std::format("/sys/devices/system/node/node{}/cpulist", node));
+  std::string list;
+
+  if (std::getline(file, list)) {
+    return os_cpu_list_parse(list.c_str(), cpus);
+  }
+#else
+  (void) node;
+#endif /* UNIV_LINUX */
+
+  return false;
+}
+
+ulint os_numa_node_of_path(const char *path) {
+#ifdef UNIV_LINUX
+  namespace fs = std::filesystem;
+
+  struct stat st;
+
+  if (stat(path, &st) != 0) {
+    return ULINT_UNDEFINED;
+  }
+
+  std::error_code ec;
+  auto dev = fs::canonical(std::format("/sys/dev/block/{}:{}", major(st.st_dev), minor(st.st_dev)), ec);
+
+  if (ec) {
+    return ULINT_UNDEFINED;
+  }
+
+  /* The node is a property of the whole disk, not of a partition. */
+  if (fs::exists(dev / "partition", ec)) {
+    dev = dev.parent_path();
+  }
+
+  /* An NVMe namespace has the controller as its device, the controller has
+  the PCI function as its own. */
+  for (const auto &file : {dev / "device" / "numa_node", dev / "device" / "device" / "numa_node"}) {
+    std::ifstream in(file);
+    long node;
+
+    if (in >> node && node >= 0) {
+      return ulint(node);
+    }
+  }
+#else
+  (void) path;
+#endif /* UNIV_LINUX */
+
+  return ULINT_UNDEFINED;
+}
 
-    /* Remove the shared memory segment so that it will be
-    automatically freed after memory is detached or
-    process exits */
-    shmctl(shmid, IPC_RMID, &buf);
+/**
+ * @param[in] huge_pages        Kind of huge pages.
+ *
+ * @return the size of the huge pages, 0 if they are not of a fixed size.
+ */
+static ulint os_huge_page_size(os_huge_pages_t huge_pages) {
+  switch (huge_pages) {
+    case OS_HUGE_PAGES_2M:
+      return 2 * 1024 * 1024;
+    case OS_HUGE_PAGES_1G:
+      return 1024 * 1024 * 1024;
+    case OS_HUGE_PAGES_OFF:
+    case OS_HUGE_PAGES_TRANSPARENT:
+      break;
   }
 
-  if (ptr) {
-    *n = size;
-    os_fast_mutex_lock(&ut_list_mutex);
-    ut_total_allocated_memory += size;
-    os_fast_mutex_unlock(&ut_list_mutex);
-#ifdef UNIV_SET_MEM_TO_ZERO
-    memset(ptr, '\0', size);
-#endif
-    UNIV_MEM_ALLOC(ptr, size);
-    return (ptr);
+  return 0;
+}
+
+/**
+ * Maps anonymous memory backed by explicitly reserved huge pages.
+ *
+ * @param[in,out] n             Number of bytes, rounded up to the huge page size.
+ * @param[in] huge_pages        OS_HUGE_PAGES_2M or OS_HUGE_PAGES_1G.
+ *
+ * @return the mapped memory or nullptr if there are no free huge pages.
+ */
+static void *os_mem_map_huge(ulint *n, os_huge_pages_t huge_pages) {
+#if defined UNIV_LINUX && defined MAP_HUGETLB && defined MAP_HUGE_SHIFT
+  const auto page_size = os_huge_page_size(huge_pages);
+  const auto size = ut_2pow_round(*n + (page_size - 1), page_size);
+  const int log2_size = huge_pages == OS_HUGE_PAGES_1G ? 30 : 21;
+
+  auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | OS_MAP_ANON | MAP_HUGETLB | (log2_size << MAP_HUGE_SHIFT), -1, 0);
+
+  if (ptr == MAP_FAILED) {
+    log_warn(std::format("HugeTLB: failed to map {} bytes of {} byte pages, errno {}: {}", size, page_size, errno, strerror(errno)));
+    return nullptr;
   }
 
-  ib_logger(ib_stream, "InnoDB HugeTLB: Warning: Using conventional memory pool\n");
-skip:
-#endif /* HAVE_LARGE_PAGES && UNIV_LINUX */
+  *n = size;
+
+  return ptr;
+#else
+  (void) n;
+  (void) huge_pages;
+  return nullptr;
+#endif /* UNIV_LINUX && MAP_HUGETLB && MAP_HUGE_SHIFT */
+}
+
+/**
+ * Sets the NUMA policy of a mapping, before its pages are touched.
+ *
+ * @param[in] ptr               Start of the mapping.
+ * @param[in] size              Size of the mapping.
+ * @param[in,out] placement     Placement requested, m_numa is set to
+ *                              OS_NUMA_OFF if the policy could not be set.
+ */
+static void os_mem_set_numa_policy(void *ptr, ulint size, os_mem_placement_t *placement) {
+  const auto n_nodes = os_numa_get_n_nodes();
+
+  if (placement->m_numa == OS_NUMA_OFF || n_nodes < 2) {
+    placement->m_numa = OS_NUMA_OFF;
+    return;
+  }
+
+#ifdef UNIV_LINUX
+  unsigned long mask{};
+  const auto max_node = sizeof(mask) * 8;
+  int mode;
+
+  if (placement->m_numa == OS_NUMA_INTERLEAVE) {
+    mode = MPOL_INTERLEAVE;
+    mask = n_nodes >= max_node ? ~0UL : (1UL << n_nodes) - 1;
+  } else {
+    ut_a(placement->m_numa == OS_NUMA_BIND);
+    placement->m_numa_node %= std::min(n_nodes, max_node);
+    mode = MPOL_BIND;
+    mask = 1UL << placement->m_numa_node;
+  }
+
+  if (syscall(SYS_mbind, ptr, size, mode, &mask, max_node, 0) == 0) {
+    return;
+  }
+
+  log_warn(std::format("mbind({}, {}) failed, errno {}: {}", ptr, size, errno, strerror(errno)));
+#else
+  (void) ptr;
+  (void) size;
+#endif /* UNIV_LINUX */
+
+  placement->m_numa = OS_NUMA_OFF;
+}
+
+void *os_mem_alloc_large(ulint *n, os_mem_placement_t *placement) {
+  os_mem_placement_t no_placement{};
+
+  if (placement == nullptr) {
+    placement = &no_placement;
+  }
+
+  void *ptr{};
+
+  /* Fall back from 1GB to 2MB pages and from there to transparent huge pages. */
+  for (auto huge_pages = placement->m_huge_pages; ptr == nullptr && huge_pages >= OS_HUGE_PAGES_2M;) {
+    /* Don't waste most of a huge page on a small allocation. */
+    if (*n >= os_huge_page_size(huge_pages)) {
+      ptr = os_mem_map_huge(n, huge_pages);
+    }
+
+    if (ptr != nullptr) {
+      placement->m_huge_pages = huge_pages;
+    } else {
+      huge_pages = os_huge_pages_t(huge_pages - 1);
+      placement->m_huge_pages = huge_pages;
+    }
+  }
+
+  if (ptr == nullptr) {
+    ulint size;
 
 #ifdef HAVE_GETPAGESIZE
-  size = getpagesize();
+    size = getpagesize();
 #else
-  size = UNIV_PAGE_SIZE;
+    size = UNIV_PAGE_SIZE;
 #endif /* HAVE_GETPAGESiZE */
 
-  /* Align block size to system page size */
-  ut_ad(ut_is_2pow(size));
-  size = *n = ut_2pow_round(*n + (size - 1), size);
-  ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | OS_MAP_ANON, -1, 0);
-  if (ptr == (void *)-1) {
-    ib_logger(ib_stream, "mmap(%lu bytes) failed;errno %lu\n", (ulong)size, (ulong)errno);
-    ptr = nullptr;
-  } else {
-    ut_allocated_memory(size);
-    UNIV_MEM_ALLOC(ptr, size);
+    if (placement->m_huge_pages == OS_HUGE_PAGES_TRANSPARENT) {
+      /* Only whole huge pages can be collapsed. */
+      size = os_huge_page_size(OS_HUGE_PAGES_2M);
+    }
+
+    /* Align block size to system page size */
+    ut_ad(ut_is_2pow(size));
+    size = *n = ut_2pow_round(*n + (size - 1), size);
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | OS_MAP_ANON, -1, 0);
+
+    if (ptr == MAP_FAILED) {
+      log_err(std::format("mmap({} bytes) failed; errno {}: {}", size, errno, strerror(errno)));
+      return nullptr;
+    }
+
+#if defined UNIV_LINUX && defined MADV_HUGEPAGE
+    if (placement->m_huge_pages == OS_HUGE_PAGES_TRANSPARENT && madvise(ptr, size, MADV_HUGEPAGE) != 0) {
+      log_warn(std::format("madvise(MADV_HUGEPAGE) failed, errno {}: {}", errno, strerror(errno)));
+      placement->m_huge_pages = OS_HUGE_PAGES_OFF;
+    }
+#else
+    placement->m_huge_pages = OS_HUGE_PAGES_OFF;
+#endif /* UNIV_LINUX && MADV_HUGEPAGE */
   }
-  return (ptr);
+
+  /* The pages have not been touched yet, they will be allocated on the nodes
+  that the policy dictates. */
+  os_mem_set_numa_policy(ptr, *n, placement);
+
+  ut_allocated_memory(*n);
+  UNIV_MEM_ALLOC(ptr, *n);
+
+  return ptr;
 }
 
 void os_mem_free_large(void *ptr, ulint size) {
   ut_a(ut_total_allocated_memory() >= size);
 
-#if defined HAVE_LARGE_PAGES && defined UNIV_LINUX
-  if (os_use_large_pages && os_large_page_size && !shmdt(ptr)) {
-    os_fast_mutex_lock(&ut_list_mutex);
-    ut_a(ut_total_allocated_memory >= size);
-    ut_total_allocated_memory -= size;
-    os_fast_mutex_unlock(&ut_list_mutex);
-    UNIV_MEM_FREE(ptr, size);
-    return;
-  }
-#endif /* HAVE_LARGE_PAGES && UNIV_LINUX */
   if (munmap(ptr, size) != 0) {
     log_err(std::format("munmap({}, {}) failed; errno {}: {}", ptr, size, errno, strerror(errno)));
   } else {
@@ -22,14 +22,92 @@ The interface to the operating system thread control primitives
 Created 9/8/1995 Heikki Tuuri
 *******************************************************/
 
+#include <array>
 #include <chrono>
+#include <string>
 #include <thread>
+#include <vector>
+
+#include <sched.h>
 
 #include "os0thread.h"
 
+#include "os0proc.h"
 #include "os0sync.h"
 #include "srv0srv.h"
 
+/** Names of the thread classes, for the messages. */
+static constexpr std::array<const char *, OS_THREAD_N_CLASSES> os_thread_class_names{"io", "log", "master", "monitor", "task", "reader", "flush"};
+
+/** The CPUs set for each thread class, as configured. */
+static std::array<std::string, OS_THREAD_N_CLASSES> os_thread_class_spec;
+
+/** The CPUs of each thread class, empty if its threads are not bound. Set
+at startup, read by the threads when they start. */
+static std::array<std::vector<ulint>, OS_THREAD_N_CLASSES> os_thread_class_cpus;
+
+/**
+ * Resolves the CPUs of a thread class.
+ *
+ * @param[in] spec              The CPUs, see os_thread_set_class_cpus().
+ * @param[in] data_home         Directory of the data files, nullptr to only
+ *                              check the syntax.
+ * @param[out] cpus             The CPUs.
+ *
+ * @return true if spec is valid.
+ */
+static bool os_thread_resolve_cpus(const std::string &spec, const char *data_home, std::vector<ulint> &cpus) {
+  cpus.clear();
+
+  if (spec.empty()) {
+    return true;
+  } else if (spec == "device") {
+    if (data_home == nullptr) {
+      return true;
+    }
+
+    const auto node = os_numa_node_of_path(data_home);
+
+    return node != ULINT_UNDEFINED && os_numa_node_get_cpus(node, cpus);
+  } else if (spec.starts_with("node:")) {
+    char *end;
+    const auto node = strtoul(spec.c_str() + 5, &end, 10);
+
+    if (end == spec.c_str() + 5 || *end != '\0') {
+      return false;
+    }
+
+    return data_home == nullptr || os_numa_node_get_cpus(node, cpus);
+  } else {
+    return os_cpu_list_parse(spec.c_str(), cpus);
+  }
+}
+
+/**
+ * Binds the calling thread to a set of CPUs.
+ *
+ * @param[in] cpus              The CPUs, not empty.
+ */
+static void os_thread_set_affinity(const std::vector<ulint> &cpus) {
+#ifdef UNIV_LINUX
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+
+  for (auto cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  if (auto ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); ret != 0) {
+    log_warn(std::format("pthread_setaffinity_np() failed: {}", strerror(ret)));
+  }
+#else
+  (void) cpus;
+#endif /* UNIV_LINUX */
+}
+
 bool os_thread_eq(os_thread_id_t a, os_thread_id_t b) {
   return pthread_equal(a, b) > 0;
 }
@@ -67,6 +145,56 @@ void os_thread_exit() {
   os_thread_count.fetch_sub(1, std::memory_order_relaxed);
 }
 
+bool os_thread_set_class_cpus(os_thread_class_t thread_class, const char *cpus) {
+  ut_a(thread_class < OS_THREAD_N_CLASSES);
+
+  std::vector<ulint> unused;
+  const std::string spec{cpus != nullptr ? cpus : ""};
+
+  if (!os_thread_resolve_cpus(spec, nullptr, unused)) {
+    return false;
+  }
+
+  os_thread_class_spec[thread_class] = spec;
+
+  return true;
+}
+
+void os_thread_class_cpus_init(const char *data_home) {
+  for (ulint i{}; i < OS_THREAD_N_CLASSES; ++i) {
+    const auto &spec = os_thread_class_spec[i];
+
+    if (!os_thread_resolve_cpus(spec, data_home, os_thread_class_cpus[i])) {
+      os_thread_class_cpus[i].clear();
+      log_warn(std::format("Cannot find the CPUs of '{}', the {} threads are not bound", spec, os_thread_class_names[i]));
+    } else if (!os_thread_class_cpus[i].empty()) {
+      log_info(std::format("The {} threads are bound to {} CPUs ('{}')", os_thread_class_names[i], os_thread_class_cpus[i].size(), spec));
+    }
+  }
+}
+
+void os_thread_bind(os_thread_class_t thread_class) {
+  ut_a(thread_class < OS_THREAD_N_CLASSES);
+
+  if (const auto &cpus = os_thread_class_cpus[thread_class]; !cpus.empty()) {
+    os_thread_set_affinity(cpus);
+  }
+}
+
+bool os_thread_class_is_bound(os_thread_class_t thread_class) {
+  ut_a(thread_class < OS_THREAD_N_CLASSES);
+
+  return !os_thread_class_cpus[thread_class].empty();
+}
+
+void os_thread_bind_to_numa_node(ulint node) {
+  std::vector<ulint> cpus;
+
+  if (os_numa_node_get_cpus(node, cpus)) {
+    os_thread_set_affinity(cpus);
+  }
+}
+
 os_thread_t os_thread_get_curr() {
   return pthread_self();
 }
@@ -30,6 +30,226 @@ Created 10/4/1994 Heikki Tuuri
 #include "rem0cmp.h"
 #include "ut0ut.h"
 
+#include <bit>
+
+/**
+ * Returns the length of the first field of the index if it is copied to a
+ * Page_dir_cache, the field must sort as an unsigned big-endian number.
+ *
+ * @param[in] index             Index of the page.
+ *
+ * @return the length, or 0 if the keys of the index are not copied.
+ */
+static ulint page_dir_cache_key_len(const Index *index) noexcept {
+  const auto field = index->get_nth_field(0);
+  const auto col = field->get_col();
+
+  if ((col->mtype == DATA_INT || col->mtype == DATA_SYS) && (col->prtype & DATA_NOT_NULL) && field->m_prefix_len == 0 &&
+      field->m_fixed_len > 0 && field->m_fixed_len <= sizeof(uint64_t)) {
+
+    return field->m_fixed_len;
+  }
+
+  return 0;
+}
+
+/**
+ * Reads a key of a Page_dir_cache.
+ *
+ * @param[in] ptr               First byte of the field.
+ * @param[in] len               Length of the field.
+ *
+ * @return the field as a big-endian number.
+ */
+static uint64_t page_dir_cache_read_key(const byte *ptr, ulint len) noexcept {
+  uint64_t key{};
+
+  for (ulint i{}; i < len; ++i) {
+    key = (key << 8) | ptr[i];
+  }
+
+  return key;
+}
+
+/**
+ * Returns the number of leading bytes that two different keys of length len
+ * have in common, the matched bytes of the first field in a comparison.
+ *
+ * @param[in] key1              A key.
+ * @param[in] key2              Another key.
+ * @param[in] len               Length of the keys.
+ *
+ * @return number of bytes.
+ */
+static ulint page_dir_cache_matched_bytes(uint64_t key1, uint64_t key2, ulint len) noexcept {
+  ut_ad(key1 != key2);
+
+  return (ulint(std::countl_zero(key1 ^ key2)) - (sizeof(uint64_t) - len) * 8) / 8;
+}
+
+/**
+ * Branchless binary search.
+ *
+ * @param[in] keys              Sorted keys.
+ * @param[in] n                 Number of keys.
+ * @param[in] key               Key to search.
+ * @param[in] inclusive         false to find the first key >= key,
+ *                              true to find the first key > key.
+ *
+ * @return position of the key found, n if none.
+ */
+static ulint page_dir_cache_bound(const uint64_t *keys, ulint n, uint64_t key, bool inclusive) noexcept {
+  if (n == 0) {
+    return 0;
+  }
+
+  auto base = keys;
+
+  while (n > 1) {
+    const auto half = n / 2;
+
+    base += (inclusive ? base[half] <= key : base[half] < key) ? half : 0;
+    n -= half;
+  }
+
+  return ulint(base - keys) + (inclusive ? *base <= key : *base < key);
+}
+
+Page_dir_cache::~Page_dir_cache() noexcept {
+  if (m_buf != nullptr) {
+    ut_delete(m_buf);
+  }
+}
+
+void Page_dir_cache::destroy(Page_dir_cache *&cache) noexcept {
+  if (cache != nullptr) {
+    call_destructor(cache);
+    ut_delete(cache);
+    cache = nullptr;
+  }
+}
+
+void Page_dir_cache::build(const page_t *page, ulint key_len, uint64_t modify_clock, ulint n_slots) noexcept {
+  const auto n_keys = n_slots - 2;
+
+  /* Readers don't look at the keys while the stamp is stale. */
+  if (n_keys > m_capacity) {
+    if (m_buf != nullptr) {
+      ut_delete(m_buf);
+    }
+
+    m_capacity = ut_calc_align(n_keys, ALIGN / sizeof(uint64_t));
+    m_buf = ut_new(m_capacity * sizeof(uint64_t) + ALIGN);
+    m_keys = static_cast<uint64_t *>(ut_align(m_buf, ALIGN));
+  }
+
+  for (ulint i{}; i < n_keys; ++i) {
+    const auto rec = page_dir_slot_get_rec(page_dir_get_nth_slot(page, i + 1));
+
+    /* The first field starts at the origin of the record in both formats. */
+    m_keys[i] = page_dir_cache_read_key(rec, key_len);
+  }
+
+  m_key_len = key_len;
+  m_n_keys = n_keys;
+
+  /* Publish the keys with the stamp. */
+  m_modify_clock.store(modify_clock, std::memory_order_release);
+  m_n_slots.store(n_slots, std::memory_order_release);
+}
+
+void Page_dir_cache::search(
+  const Buf_block *block, const Index *index, const DTuple *tuple, ulint &low, ulint &up, ulint &low_matched_fields,
+  ulint &low_matched_bytes, ulint &up_matched_fields, ulint &up_matched_bytes) noexcept {
+
+  const auto page = block->get_frame();
+  const auto n_slots = page_dir_get_n_slots(page);
+
+  /* A tuple with the minimum record flag sorts before any record. */
+  if (n_slots < MIN_N_SLOTS || dtuple_get_n_fields_cmp(tuple) == 0 || (dtuple_get_info_bits(tuple) & REC_INFO_MIN_REC_FLAG)) {
+    return;
+  }
+
+  const auto key_len = page_dir_cache_key_len(index);
+  const auto field = dtuple_get_nth_field(tuple, 0);
+
+  if (key_len == 0 || dfield_get_len(field) != key_len) {
+    return;
+  }
+
+  auto cache = block->m_dir_cache.load(std::memory_order_acquire);
+
+  if (cache == nullptr) {
+    auto ptr = ut_new(sizeof(Page_dir_cache));
+    auto new_cache = new (ptr) Page_dir_cache();
+
+    if (block->m_dir_cache.compare_exchange_strong(cache, new_cache, std::memory_order_acq_rel)) {
+      cache = new_cache;
+    } else {
+      destroy(new_cache);
+    }
+  }
+
+  const auto modify_clock = block->m_modify_clock;
+
+  if (cache->m_modify_clock.load(std::memory_order_acquire) != modify_clock ||
+      cache->m_n_slots.load(std::memory_order_acquire) != n_slots || cache->m_key_len != key_len) {
+
+    /* Copy the keys on the second search of an unchanged page only, a page
+    that changes between searches would pay for the copy every time. */
+    if (cache->m_pending_modify_clock.load(std::memory_order_relaxed) != modify_clock ||
+        cache->m_pending_n_slots.load(std::memory_order_relaxed) != n_slots) {
+
+      cache->m_pending_modify_clock.store(modify_clock, std::memory_order_relaxed);
+      cache->m_pending_n_slots.store(n_slots, std::memory_order_relaxed);
+
+      return;
+    }
+
+    if (cache->m_building.exchange(true, std::memory_order_acquire)) {
+      return;
+    }
+
+    cache->build(page, key_len, modify_clock, n_slots);
+
+    cache->m_building.store(false, std::memory_order_release);
+  }
+
+  const auto key = page_dir_cache_read_key(static_cast<const byte *>(dfield_get_data(field)), key_len);
+  const auto keys = cache->m_keys;
+  const auto n_keys = cache->m_n_keys;
+
+  /* The leftmost node pointer of a level sorts before any key, whatever its
+  fields, see cmp_dtuple_rec_with_match(). */
+  ulint start{};
+
+  if (!page_is_leaf(page)) {
+    const auto first_rec = page_rec_get_next_const(page_get_infimum_rec(page));
+
+    if ((rec_get_info_bits(first_rec) & REC_INFO_MIN_REC_FLAG) &&
+        page_dir_slot_get_rec(page_dir_get_nth_slot(page, 1)) == first_rec) {
+
+      start = 1;
+    }
+  }
+
+  /* The slot of keys[i] is i + 1. */
+  const auto lower = start + page_dir_cache_bound(keys + start, n_keys - start, key, false);
+  const auto upper = lower + page_dir_cache_bound(keys + lower, n_keys - lower, key, true);
+
+  if (lower > 0) {
+    low = lower;
+    low_matched_fields = 0;
+    low_matched_bytes = lower > start ? page_dir_cache_matched_bytes(keys[lower - 1], key, key_len) : 0;
+  }
+
+  if (upper < n_keys) {
+    up = upper + 1;
+    up_matched_fields = 0;
+    up_matched_bytes = page_dir_cache_matched_bytes(keys[upper], key, key_len);
+  }
+}
+
 #ifdef PAGE_CUR_ADAPT
 #ifdef UNIV_SEARCH_PERF_STAT
 static ulint page_cur_short_succ = 0;
@@ -121,7 +341,7 @@ static bool page_cur_try_search_shortcut(
   up_match = low_match;
   up_bytes = low_bytes;
 
-  if (page_cmp_dtuple_rec_with_match(index->m_cmp_ctx, tuple, rec, offsets, &low_match, &low_bytes) < 0) {
+  if (page_cmp_dtuple_rec_with_match(index, tuple, rec, offsets, &low_match, &low_bytes) < 0) {
 
     goto exit_func;
   }
@@ -134,7 +354,7 @@ static bool page_cur_try_search_shortcut(
     offsets = record.get_col_offsets(offsets, dtuple_get_n_fields(tuple), &heap, Current_location());
   }
 
-  if (page_cmp_dtuple_rec_with_match(index->m_cmp_ctx, tuple, next_rec, offsets, &up_match, &up_bytes) >= 0) {
+  if (page_cmp_dtuple_rec_with_match(index, tuple, next_rec, offsets, &up_match, &up_bytes) >= 0) {
 
     goto exit_func;
   }
@@ -240,11 +460,11 @@ void page_cur_search_with_match(
   int dbg_cmp;
   ulint dbg_matched_fields;
   ulint dbg_matched_bytes;
-#endif
   mem_heap_t *heap = nullptr;
   ulint offsets_[REC_OFFS_NORMAL_SIZE];
   ulint *offsets = offsets_;
   rec_offs_init(offsets_);
+#endif
 
   ut_ad(block && tuple && iup_matched_fields && iup_matched_bytes && ilow_matched_fields && ilow_matched_bytes && cursor);
   ut_ad(dtuple_validate(tuple));
@@ -298,9 +518,15 @@ void page_cur_search_with_match(
   directory, after that as a linear search in the list of records
   owned by the upper limit directory slot. */
 
+  /* The records compared are user records, the infimum and the supremum
+  are only the limits. */
+  Page_rec_offsets rec_offsets{index, page, dtuple_get_n_fields_cmp(tuple)};
+
   low = 0;
   up = page_dir_get_n_slots(page) - 1;
 
+  Page_dir_cache::search(block, index, tuple, low, up, low_matched_fields, low_matched_bytes, up_matched_fields, up_matched_bytes);
+
   /* Perform binary search until the lower and upper limit directory
   slots come to the distance 1 of each other */
 
@@ -313,13 +539,9 @@ void page_cur_search_with_match(
       &cur_matched_fields, &cur_matched_bytes, low_matched_fields, low_matched_bytes, up_matched_fields, up_matched_bytes
     );
 
-    {
-      Phy_rec record{index, mid_rec};
+    const auto offsets = rec_offsets.get(mid_rec);
 
-      offsets = record.get_col_offsets(offsets, dtuple_get_n_fields_cmp(tuple), &heap, Current_location());
-    }
-
-    cmp = cmp_dtuple_rec_with_match(index->m_cmp_ctx, tuple, mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
+    cmp = cmp_dtuple_rec_with_match(index, tuple, mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
 
     if (likely(cmp > 0)) {
     low_slot_match:
@@ -369,13 +591,9 @@ void page_cur_search_with_match(
       &cur_matched_fields, &cur_matched_bytes, low_matched_fields, low_matched_bytes, up_matched_fields, up_matched_bytes
     );
 
-    {
-      Phy_rec record{index, mid_rec};
-
-      offsets = record.get_col_offsets(offsets, dtuple_get_n_fields_cmp(tuple), &heap, Current_location());
-    }
+    const auto offsets = rec_offsets.get(mid_rec);
 
-    cmp = cmp_dtuple_rec_with_match(index->m_cmp_ctx, tuple, mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
+    cmp = cmp_dtuple_rec_with_match(index, tuple, mid_rec, offsets, &cur_matched_fields, &cur_matched_bytes);
 
     if (likely(cmp > 0)) {
     low_rec_match:
@@ -421,7 +639,7 @@ void page_cur_search_with_match(
     offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location()); 
   }
 
-  dbg_cmp = page_cmp_dtuple_rec_with_match(index->cmp_ctx, tuple, low_rec, offsets, &dbg_matched_fields, &dbg_matched_bytes);
+  dbg_cmp = page_cmp_dtuple_rec_with_match(index, tuple, low_rec, offsets, &dbg_matched_fields, &dbg_matched_bytes);
 
   if (mode == PAGE_CUR_G) {
     ut_a(dbg_cmp >= 0);
@@ -448,7 +666,7 @@ void page_cur_search_with_match(
     offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location()); 
   }
 
-  dbg_cmp = page_cmp_dtuple_rec_with_match(index->cmp_ctx, tuple, up_rec, offsets, &dbg_matched_fields, &dbg_matched_bytes);
+  dbg_cmp = page_cmp_dtuple_rec_with_match(index, tuple, up_rec, offsets, &dbg_matched_fields, &dbg_matched_bytes);
 
   if (mode == PAGE_CUR_G) {
     ut_a(dbg_cmp == -1);
@@ -476,12 +694,15 @@ void page_cur_search_with_match(
   *iup_matched_bytes = up_matched_bytes;
   *ilow_matched_fields = low_matched_fields;
   *ilow_matched_bytes = low_matched_bytes;
+
+#ifdef UNIV_SEARCH_DEBUG
   if (likely_null(heap)) {
     mem_heap_free(heap);
   }
+#endif /* UNIV_SEARCH_DEBUG */
 }
 
-void page_cur_open_on_rnd_user_rec(Buf_block *block, page_cur_t *cursor) {
+void page_cur_open_on_rnd_user_rec(Buf_block *block, page_cur_t *cursor, ulint *rnd_state) {
   ulint rnd;
   ulint n_recs = page_get_n_recs(block->get_frame());
 
@@ -492,7 +713,11 @@ void page_cur_open_on_rnd_user_rec(Buf_block *block, page_cur_t *cursor) {
     return;
   }
 
-  rnd = (ulint)(page_cur_lcg_prng() % n_recs);
+  if (rnd_state != nullptr) {
+    rnd = ut_rnd_gen_ulint(rnd_state) % n_recs;
+  } else {
+    rnd = (ulint)(page_cur_lcg_prng() % n_recs);
+  }
 
   do {
     page_cur_move_to_next(cursor);
@@ -681,7 +906,7 @@ byte *page_cur_parse_insert_rec(bool is_short, byte *ptr, byte *end_ptr, Buf_blo
 
     if (unlikely(offset >= UNIV_PAGE_SIZE)) {
 
-      recv_sys->m_found_corrupt_log = true;
+      recv_set_found_corrupt_log();
 
       return (nullptr);
     }
@@ -695,7 +920,7 @@ byte *page_cur_parse_insert_rec(bool is_short, byte *ptr, byte *end_ptr, Buf_blo
   }
 
   if (unlikely(end_seg_len >= UNIV_PAGE_SIZE << 1)) {
-    recv_sys->m_found_corrupt_log = true;
+    recv_set_found_corrupt_log();
 
     return (nullptr);
   }
@@ -844,6 +1069,7 @@ rec_t *page_cur_insert_rec_low(rec_t *current_rec, const Index *index, const rec
   page = page_align(current_rec);
 
   ut_ad(!page_rec_is_supremum(current_rec));
+  ut_ad(page_cur_change_allowed(page, index, mtr));
 
   /* 1. Get the size of the physical record in the page */
   rec_size = rec_offs_size(offsets);
@@ -973,24 +1199,6 @@ rec_t *page_cur_insert_rec_low(rec_t *current_rec, const Index *index, const rec
   return (insert_rec);
 }
 
-/**
- * @brief Writes a log record of copying a record list end to a newly created page.
- *
- * @param[in] page Index page.
- * @param[in] mtr Mini-transaction.
- * 
- * @return 4-byte field where to write the log data length, or nullptr if logging is disabled.
- */
-static byte *page_copy_rec_list_to_created_page_write_log(page_t *page, mtr_t *mtr) {
-  auto log_ptr = mlog_open_and_write_index(mtr, page, MLOG_LIST_END_COPY_CREATED, 4);
-
-  if (likely(log_ptr != nullptr)) {
-    mlog_close(mtr, log_ptr + 4);
-  }
-
-  return log_ptr;
-}
-
 byte *page_parse_copy_rec_list_to_created_page(byte *ptr, byte *end_ptr, Buf_block *block, Index *index, mtr_t *mtr) {
   byte *rec_end;
   ulint log_data_len;
@@ -1031,6 +1239,74 @@ byte *page_parse_copy_rec_list_to_created_page(byte *ptr, byte *end_ptr, Buf_blo
   return (rec_end);
 }
 
+void page_built_write_log(page_t *page, mtr_t *mtr) {
+  auto log_ptr = mlog_open(mtr, 11 + 5 + 5);
+
+  if (unlikely(log_ptr == nullptr)) {
+    /* Logging in mtr is switched off during crash recovery: in that case
+    mlog_open returns nullptr */
+    return;
+  }
+
+  const auto heap_len = ulint(page_header_get_ptr(page, PAGE_HEAP_TOP) - (page + PAGE_HEADER));
+  const auto dir_len = page_dir_get_n_slots(page) * PAGE_DIR_SLOT_SIZE;
+
+  ut_a(PAGE_HEADER + heap_len + dir_len <= UNIV_PAGE_SIZE - PAGE_DIR);
+
+  log_ptr = mlog_write_initial_log_record_fast(page, MLOG_PAGE_BUILT, log_ptr, mtr);
+
+  log_ptr += mach_write_compressed(log_ptr, heap_len);
+  log_ptr += mach_write_compressed(log_ptr, dir_len);
+
+  mlog_close(mtr, log_ptr);
+
+  mlog_catenate_string(mtr, page + PAGE_HEADER, heap_len);
+  mlog_catenate_string(mtr, page + UNIV_PAGE_SIZE - PAGE_DIR - dir_len, dir_len);
+}
+
+byte *page_parse_built(byte *ptr, byte *end_ptr, Buf_block *block) {
+  const ulint heap_len = mach_parse_compressed(ptr, end_ptr);
+
+  if (ptr == nullptr) {
+
+    return nullptr;
+  }
+
+  const ulint dir_len = mach_parse_compressed(ptr, end_ptr);
+
+  if (ptr == nullptr) {
+
+    return nullptr;
+  }
+
+  if (unlikely(heap_len >= UNIV_PAGE_SIZE || dir_len >= UNIV_PAGE_SIZE ||
+               PAGE_HEADER + heap_len + dir_len > UNIV_PAGE_SIZE - PAGE_DIR)) {
+    recv_set_found_corrupt_log();
+
+    return nullptr;
+  }
+
+  if (end_ptr < ptr + heap_len + dir_len) {
+
+    return nullptr;
+  }
+
+  if (block != nullptr) {
+    auto page = block->get_frame();
+
+    memcpy(page + PAGE_HEADER, ptr, heap_len);
+    memcpy(page + UNIV_PAGE_SIZE - PAGE_DIR - dir_len, ptr + heap_len, dir_len);
+  }
+
+  return ptr + heap_len + dir_len;
+}
+
+#ifdef UNIV_DEBUG
+bool page_cur_change_allowed(const page_t *page, const Index *index, const mtr_t *mtr) noexcept {
+  return page_is_leaf(page) || mtr == nullptr || recv_recovery_on || mtr->memo_contains(index->get_lock(), MTR_MEMO_X_LOCK);
+}
+#endif /* UNIV_DEBUG */
+
 void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const Index *index, mtr_t *mtr) {
   page_dir_slot_t *slot = 0; /* remove warning */
   byte *heap_top;
@@ -1040,15 +1316,11 @@ void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const
   ulint n_recs;
   ulint slot_index;
   ulint rec_size;
-  byte *log_ptr;
-  ulint log_data_len;
-  mem_heap_t *heap = nullptr;
-  ulint offsets_[REC_OFFS_NORMAL_SIZE];
-  ulint *offsets = offsets_;
-  rec_offs_init(offsets_);
+  Page_rec_offsets rec_offsets{index, page_align(rec), ULINT_UNDEFINED};
 
   ut_ad(page_dir_get_n_heap(new_page) == PAGE_HEAP_NO_USER_LOW);
   ut_ad(page_align(rec) != new_page);
+  ut_ad(page_cur_change_allowed(new_page, index, mtr));
 
   if (page_rec_is_infimum(rec)) {
 
@@ -1067,14 +1339,6 @@ void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const
   page_header_set_ptr(new_page, PAGE_HEAP_TOP, new_page + UNIV_PAGE_SIZE - 1);
 #endif /* UNIV_DEBUG */
 
-  log_ptr = page_copy_rec_list_to_created_page_write_log(new_page, mtr);
-
-  log_data_len = dyn_array_get_data_size(&mtr->m_log);
-
-  /* Individual inserts are logged in a shorter form */
-
-  auto log_mode = mtr->set_log_mode(MTR_LOG_SHORT_INSERTS);
-
   prev_rec = page_get_infimum_rec(new_page);
   heap_top = new_page + PAGE_SUPREMUM_END;
   count = 0;
@@ -1082,9 +1346,7 @@ void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const
   n_recs = 0;
 
   do {
-    Phy_rec record{index, rec};
-
-    offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
+    const auto offsets = rec_offsets.get(rec);
 
     insert_rec = rec_copy(heap_top, rec, offsets);
 
@@ -1114,7 +1376,6 @@ void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const
 
     heap_top += rec_size;
 
-    page_cur_insert_rec_write_log(insert_rec, rec_size, prev_rec, index, mtr);
     prev_rec = insert_rec;
     rec = page_rec_get_next(rec);
   } while (!page_rec_is_supremum(rec));
@@ -1134,18 +1395,6 @@ void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const
     slot_index--;
   }
 
-  if (likely_null(heap)) {
-    mem_heap_free(heap);
-  }
-
-  log_data_len = dyn_array_get_data_size(&mtr->m_log) - log_data_len;
-
-  ut_a(log_data_len < 100 * UNIV_PAGE_SIZE);
-
-  if (likely(log_ptr != nullptr)) {
-    mach_write_to_4(log_ptr, log_data_len);
-  }
-
   rec_set_next_offs(insert_rec, PAGE_SUPREMUM);
 
   slot = page_dir_get_nth_slot(new_page, 1 + slot_index);
@@ -1161,12 +1410,9 @@ void page_copy_rec_list_end_to_created_page(page_t *new_page, rec_t *rec, const
   page_header_set_ptr(new_page, PAGE_LAST_INSERT, nullptr);
   page_header_set_field(new_page, PAGE_N_DIRECTION, 0);
 
-  /* Restore the log mode */
-
-  {
-    auto old_mode = mtr->set_log_mode(log_mode);
-    ut_a(old_mode == MTR_LOG_SHORT_INSERTS);
-  }
+  /* The page is logged as a whole, this is far less redo than an insert
+  record for each of the records. */
+  page_built_write_log(new_page, mtr);
 }
 
 /**
@@ -1250,6 +1496,7 @@ void page_cur_delete_rec(page_cur_t *cursor, const Index *index, const ulint *of
 
   current_rec = cursor->m_rec;
   ut_ad(rec_offs_validate(current_rec, index, offsets));
+  ut_ad(page_cur_change_allowed(page, index, mtr));
 
   /* The record must not be the supremum or infimum record. */
   ut_ad(page_rec_is_user_rec(current_rec));
@@ -32,6 +32,9 @@ Created 2/2/1994 Heikki Tuuri
 #include "page0cur.h"
 #include "srv0srv.h"
 
+#include <algorithm>
+#include <vector>
+
 /*			THE INDEX PAGE
 
 The index page consists of a page header which contains the page's
@@ -316,14 +319,117 @@ page_t *page_create(const Index *index, Buf_block *block, mtr_t *mtr) {
   return page;
 }
 
+void page_compact(Buf_block *block, const Index *index, mtr_t *mtr) {
+  /** A user record, its position in the heap and in the key order. */
+  struct Heap_rec {
+    /** Offset of the start of the record */
+    uint16_t m_start;
+
+    /** Size of the record, header included */
+    uint16_t m_size;
+
+    /** Size of the record header */
+    uint16_t m_extra;
+
+    /** Position of the record in the key order */
+    uint16_t m_nth;
+  };
+
+  auto page = block->get_frame();
+  const auto n_recs = page_get_n_recs(page);
+
+  mlog_open_and_write_index(mtr, page, MLOG_PAGE_COMPACT, 0);
+
+  buf_block_modify_clock_inc(block);
+
+  ut_d(const auto data_size = page_get_data_size(page));
+
+  std::vector<Heap_rec> recs;
+  Page_rec_offsets rec_offsets{index, page, ULINT_UNDEFINED};
+
+  recs.reserve(n_recs);
+
+  for (auto rec = page_rec_get_next(page_get_infimum_rec(page)); !page_rec_is_supremum(rec); rec = page_rec_get_next(rec)) {
+    const auto offsets = rec_offsets.get(rec);
+    const auto extra = rec_offs_extra_size(offsets);
+
+    recs.push_back({uint16_t(page_offset(rec) - extra), uint16_t(rec_offs_size(offsets)), uint16_t(extra), uint16_t(recs.size())});
+  }
+
+  ut_a(recs.size() == n_recs);
+
+  /* Slide the records down in address order, no record is moved over a
+  record that was not moved yet. */
+  std::sort(recs.begin(), recs.end(), [](const Heap_rec &lhs, const Heap_rec &rhs) { return lhs.m_start < rhs.m_start; });
+
+  std::vector<uint16_t> origins(n_recs);
+  auto heap_top = PAGE_SUPREMUM_END;
+
+  for (const auto &heap_rec : recs) {
+    ut_ad(heap_top <= heap_rec.m_start);
+
+    if (heap_rec.m_start != heap_top) {
+      memmove(page + heap_top, page + heap_rec.m_start, heap_rec.m_size);
+    }
+
+    origins[heap_rec.m_nth] = uint16_t(heap_top + heap_rec.m_extra);
+    heap_top += heap_rec.m_size;
+  }
+
+  /* Link the records in the key order, number them in that order and point
+  the directory slots to the owners again. */
+  auto prev = page_get_infimum_rec(page);
+  ulint slot_no{1};
+
+  for (ulint i{}; i < n_recs; ++i) {
+    auto rec = page + origins[i];
+
+    rec_set_next_offs(prev, origins[i]);
+    rec_set_heap_no(rec, PAGE_HEAP_NO_USER_LOW + i);
+
+    if (rec_get_n_owned(rec) > 0) {
+      page_dir_slot_set_rec(page_dir_get_nth_slot(page, slot_no), rec);
+      ++slot_no;
+    }
+
+    prev = rec;
+  }
+
+  rec_set_next_offs(prev, PAGE_SUPREMUM);
+
+  ut_a(slot_no == page_dir_get_n_slots(page) - 1);
+
+  const auto old_heap_top = page_header_get_ptr(page, PAGE_HEAP_TOP);
+
+  memset(page + heap_top, 0, old_heap_top - (page + heap_top));
+
+  page_header_set_ptr(page, PAGE_HEAP_TOP, page + heap_top);
+  page_dir_set_n_heap(page, PAGE_HEAP_NO_USER_LOW + n_recs);
+  page_header_set_ptr(page, PAGE_FREE, nullptr);
+  page_header_set_field(page, PAGE_GARBAGE, 0);
+  page_header_set_ptr(page, PAGE_LAST_INSERT, nullptr);
+  page_header_set_field(page, PAGE_DIRECTION, PAGE_NO_DIRECTION);
+  page_header_set_field(page, PAGE_N_DIRECTION, 0);
+
+  ut_ad(page_get_data_size(page) == data_size);
+  ut_ad(page_simple_validate(page));
+}
+
+byte *page_parse_compact(byte *ptr, byte *, Buf_block *block, Index *index, mtr_t *mtr) {
+  /* The record is empty, except for the record initial part */
+
+  if (block != nullptr) {
+    page_compact(block, index, mtr);
+  }
+
+  return ptr;
+}
+
 void page_copy_rec_list_end_no_locks(Buf_block *new_block, Buf_block *block, rec_t *rec, const Index *index, mtr_t *mtr) {
   page_t *new_page = new_block->get_frame();
   page_cur_t cur1;
   rec_t *cur2;
-  mem_heap_t *heap = nullptr;
-  ulint offsets_[REC_OFFS_NORMAL_SIZE];
-  ulint *offsets = offsets_;
-  rec_offs_init(offsets_);
+  Page_rec_offsets rec_offsets{index, page_align(rec), ULINT_UNDEFINED};
 
   page_cur_position(rec, block, &cur1);
 
@@ -340,14 +446,7 @@ void page_copy_rec_list_end_no_locks(Buf_block *new_block, Buf_block *block, rec
 
   while (!page_cur_is_after_last(&cur1)) {
     auto cur1_rec = page_cur_get_rec(&cur1);
-
-    {
-      Phy_rec record{index, cur1_rec};
-
-      offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
-    }
-
-    auto ins_rec = page_cur_insert_rec_low(cur2, index, cur1_rec, offsets, mtr);
+    auto ins_rec = page_cur_insert_rec_low(cur2, index, cur1_rec, rec_offsets.get(cur1_rec), mtr);
 
     if (unlikely(ins_rec == nullptr)) {
       /* Track an assertion failure reported on the mailing
@@ -371,10 +470,6 @@ void page_copy_rec_list_end_no_locks(Buf_block *new_block, Buf_block *block, rec
     page_cur_move_to_next(&cur1);
     cur2 = ins_rec;
   }
-
-  if (likely_null(heap)) {
-    mem_heap_free(heap);
-  }
 }
 
 rec_t *page_copy_rec_list_end(Buf_block *new_block, Buf_block *block, rec_t *rec, const Index *index, mtr_t *mtr) {
@@ -409,11 +504,8 @@ rec_t *page_copy_rec_list_start(Buf_block *new_block, Buf_block *block, rec_t *r
   page_t *new_page = new_block->get_frame();
   page_cur_t cur1;
   rec_t *cur2;
-  mem_heap_t *heap = nullptr;
   rec_t *ret = page_rec_get_prev(page_get_supremum_rec(new_page));
-  ulint offsets_[REC_OFFS_NORMAL_SIZE];
-  ulint *offsets = offsets_;
-  rec_offs_init(offsets_);
+  Page_rec_offsets rec_offsets{index, page_align(rec), ULINT_UNDEFINED};
 
   /* Here, "ret" may be pointing to a user record or the
   predefined infimum record. */
@@ -433,22 +525,12 @@ rec_t *page_copy_rec_list_start(Buf_block *new_block, Buf_block *block, rec_t *r
   while (page_cur_get_rec(&cur1) != rec) {
     auto cur1_rec = page_cur_get_rec(&cur1);
 
-    {
-      Phy_rec record{index, cur1_rec};
-
-      offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
-    }
-
-    cur2 = page_cur_insert_rec_low(cur2, index, cur1_rec, offsets, mtr);
+    cur2 = page_cur_insert_rec_low(cur2, index, cur1_rec, rec_offsets.get(cur1_rec), mtr);
     ut_a(cur2);
 
     page_cur_move_to_next(&cur1);
   }
 
-  if (likely_null(heap)) {
-    mem_heap_free(heap);
-  }
-
   if (!index->is_clustered() && page_is_leaf(page_align(rec))) {
     page_update_max_trx_id(new_block, page_get_max_trx_id(page_align(rec)), mtr);
   }
@@ -517,12 +599,9 @@ void page_delete_rec_list_end(rec_t *rec, Buf_block *block, Index *index, ulint
   rec_t *prev_rec;
   ulint n_owned;
   page_t *page = page_align(rec);
-  mem_heap_t *heap = nullptr;
-  ulint offsets_[REC_OFFS_NORMAL_SIZE];
-  ulint *offsets = offsets_;
-  rec_offs_init(offsets_);
 
   ut_ad(size == ULINT_UNDEFINED || size < UNIV_PAGE_SIZE);
+  ut_ad(page_cur_change_allowed(page, index, mtr));
 
   if (page_rec_is_infimum(rec)) {
     rec = page_rec_get_next(rec);
@@ -551,17 +630,14 @@ void page_delete_rec_list_end(rec_t *rec, Buf_block *block, Index *index, ulint
 
   if ((size == ULINT_UNDEFINED) || (n_recs == ULINT_UNDEFINED)) {
     rec_t *rec2 = rec;
+    Page_rec_offsets rec_offsets{index, page, ULINT_UNDEFINED};
+
     /* Calculate the sum of sizes and the number of records */
     size = 0;
     n_recs = 0;
 
     do {
-      {
-        Phy_rec record{index, rec2};
-
-        offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
-      }
-
+      const auto offsets = rec_offsets.get(rec2);
       auto s = rec_offs_size(offsets);
 
       ut_ad(rec2 - page + s - rec_offs_extra_size(offsets) < UNIV_PAGE_SIZE);
@@ -571,10 +647,6 @@ void page_delete_rec_list_end(rec_t *rec, Buf_block *block, Index *index, ulint
 
       rec2 = page_rec_get_next(rec2);
     } while (!page_rec_is_supremum(rec2));
-
-    if (unlikely(heap != nullptr)) {
-      mem_heap_free(heap);
-    }
   }
 
   ut_ad(size < UNIV_PAGE_SIZE);
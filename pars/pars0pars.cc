@@ -1468,6 +1468,23 @@ pars_user_func_t *pars_info_get_user_func(pars_info_t *info, const char *name) {
   return nullptr;
 }
 
+void pars_rebind_literals(que_t *graph, pars_info_t *info) {
+  for (auto sym_node : graph->sym_tab->sym_list) {
+    if (sym_node->token_type != SYM_LIT || sym_node->name == nullptr) {
+      continue;
+    }
+
+    auto blit = pars_info_get_bound_lit(info, sym_node->name);
+    ut_a(blit != nullptr);
+
+    auto dfield = &sym_node->common.val;
+    ut_a(dfield_get_type(dfield)->mtype == blit->type);
+    ut_a(dfield_get_type(dfield)->prtype == blit->prtype);
+
+    dfield_set_data(dfield, blit->address, blit->length);
+  }
+}
+
 pars_bound_lit_t *pars_info_get_bound_lit(pars_info_t *info, const char *name) {
   if (info == nullptr || info->m_bound_lits.empty()) {
     return nullptr;
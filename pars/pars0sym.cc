@@ -81,6 +81,7 @@ sym_node_t *sym_tab_add_int_lit(sym_tab_t *sym_tab, ulint val) {
   node->token_type = SYM_LIT;
 
   node->indirection = nullptr;
+  node->name = nullptr;
 
   dtype_set(dfield_get_type(&node->common.val), DATA_INT, 0, 4);
 
@@ -110,6 +111,7 @@ sym_node_t *sym_tab_add_str_lit(sym_tab_t *sym_tab, byte *str, ulint len) {
   node->token_type = SYM_LIT;
 
   node->indirection = nullptr;
+  node->name = nullptr;
 
   dtype_set(dfield_get_type(&node->common.val), DATA_VARCHAR, DATA_ENGLISH, 0);
 
@@ -189,6 +191,11 @@ sym_node_t *sym_tab_add_bound_lit(sym_tab_t *sym_tab, const char *name,
 
   dfield_set_data(&(node->common.val), blit->address, blit->length);
 
+  /* The name identifies the literal when the graph is executed again with
+  other values, see pars_rebind_literals(). */
+  node->name = mem_heap_strdup(sym_tab->heap, name);
+  node->name_len = strlen(node->name);
+
   node->common.val_buf_size = 0;
   node->prefetch_buf = nullptr;
   node->cursor_def = nullptr;
@@ -210,6 +217,7 @@ sym_node_t *sym_tab_add_null_lit(sym_tab_t *sym_tab) {
   node->token_type = SYM_LIT;
 
   node->indirection = nullptr;
+  node->name = nullptr;
 
   dfield_get_type(&node->common.val)->mtype = DATA_ERROR;
 
@@ -450,6 +450,7 @@ void que_graph_free_recursive(que_node_t *node) {
       purge = static_cast<purge_node_t *>(node);
 
       mem_heap_free(purge->heap);
+      mem_heap_free(purge->entry_heap);
 
       break;
 
@@ -471,6 +472,7 @@ void que_graph_free_recursive(que_node_t *node) {
       que_graph_free_recursive(upd->m_select);
 
       mem_heap_free(upd->m_heap);
+      mem_heap_free(upd->m_entry_heap);
 
       break;
     case QUE_NODE_CREATE_TABLE:
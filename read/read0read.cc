@@ -28,6 +28,7 @@ Created 2/16/1997 Heikki Tuuri
 #include "read0read.ic"
 #endif
 
+#include "row0vers.h"
 #include "srv0srv.h"
 #include "trx0sys.h"
 
@@ -145,6 +146,8 @@ inline read_view_t *read_view_create_low(ulint n, mem_heap_t *heap) {
 
   view->n_trx_ids = n;
   view->trx_ids = reinterpret_cast<trx_id_t *>(mem_heap_alloc(heap, n * sizeof *view->trx_ids));
+  view->created = time(nullptr);
+  view->vers_cache = nullptr;
 
   return view;
 }
@@ -213,7 +216,11 @@ read_view_t *read_view_oldest_copy_or_open_new(trx_id_t cr_trx_id, mem_heap_t *h
 read_view_t *read_view_open_now(trx_id_t cr_trx_id, mem_heap_t *heap) {
   ut_ad(mutex_own(&kernel_mutex));
 
-  auto view = read_view_create_low(UT_LIST_GET_LEN(srv_trx_sys->m_trx_list), heap);
+  /* The snapshot is only rebuilt from the trx list if a transaction has
+  started or committed since the previous read view was opened. */
+  const auto &snapshot = srv_trx_sys->get_active_trx_snapshot();
+
+  auto view = read_view_create_low(snapshot.m_trxs.size(), heap);
 
   view->creator_trx_id = cr_trx_id;
   view->type = VIEW_NORMAL;
@@ -227,21 +234,19 @@ read_view_t *read_view_open_now(trx_id_t cr_trx_id, mem_heap_t *heap) {
   ulint n = 0;
 
   /* No active transaction should be visible, except cr_trx */
-  for (auto trx: srv_trx_sys->m_trx_list) {
-    ut_ad(trx->m_magic_n == TRX_MAGIC_N);
-
-    if (trx->m_id != cr_trx_id && (trx->m_conc_state == TRX_ACTIVE || trx->m_conc_state == TRX_PREPARED)) {
+  for (const auto &trx : snapshot.m_trxs) {
+    if (trx.m_id != cr_trx_id) {
 
-      read_view_set_nth_trx_id(view, n, trx->m_id);
+      read_view_set_nth_trx_id(view, n, trx.m_id);
 
       ++n;
 
       /* NOTE that a transaction whose trx number is < srv_trx_sys->m_max_trx_id can still be active, if it is
       in the middle of its commit! Note that when a transaction starts, we initialize trx->no to LSN_MAX. */
 
-      if (view->low_limit_no > trx->m_no) {
+      if (view->low_limit_no > trx.m_no) {
 
-        view->low_limit_no = trx->m_no;
+        view->low_limit_no = trx.m_no;
       }
     }
   }
@@ -264,6 +269,9 @@ void read_view_close(read_view_t *view) {
   ut_ad(mutex_own(&kernel_mutex));
 
   UT_LIST_REMOVE(srv_trx_sys->m_view_list, view);
+
+  delete view->vers_cache;
+  view->vers_cache = nullptr;
 }
 
 void read_view_close_for_read_committed(Trx *trx) {
@@ -324,7 +332,9 @@ cursor_view_t *read_cursor_view_create(Trx *cr_trx) {
 
   mutex_enter(&kernel_mutex);
 
-  curview->read_view = read_view_create_low(UT_LIST_GET_LEN(srv_trx_sys->m_trx_list), curview->heap);
+  const auto &snapshot = srv_trx_sys->get_active_trx_snapshot();
+
+  curview->read_view = read_view_create_low(snapshot.m_trxs.size(), curview->heap);
 
   auto view = curview->read_view;
   view->creator_trx_id = cr_trx->m_id;
@@ -339,23 +349,20 @@ cursor_view_t *read_cursor_view_create(Trx *cr_trx) {
   ulint n = 0;
   /* No active transaction should be visible */
 
-  for (auto trx: srv_trx_sys->m_trx_list) {
-    if (trx->m_conc_state == TRX_ACTIVE || trx->m_conc_state == TRX_PREPARED) {
+  for (const auto &trx : snapshot.m_trxs) {
+    read_view_set_nth_trx_id(view, n, trx.m_id);
 
-      read_view_set_nth_trx_id(view, n, trx->m_id);
-
-      n++;
+    n++;
 
-      /* NOTE that a transaction whose trx number is <
-      srv_trx_sys->m_max_trx_id can still be active, if it is
-      in the middle of its commit! Note that when a
-      transaction starts, we initialize trx->no to
-      LSN_MAX. */
+    /* NOTE that a transaction whose trx number is <
+    srv_trx_sys->m_max_trx_id can still be active, if it is
+    in the middle of its commit! Note that when a
+    transaction starts, we initialize trx->no to
+    LSN_MAX. */
 
-      if (view->low_limit_no > trx->m_no) {
+    if (view->low_limit_no > trx.m_no) {
 
-        view->low_limit_no = trx->m_no;
-      }
+      view->low_limit_no = trx.m_no;
     }
   }
 
@@ -284,6 +284,203 @@ static int cmp_whole_field(
   return 0;
 }
 
+/** How a field is encoded in a normalized key */
+enum class Normalized_field {
+  /** Not supported */
+  NONE,
+
+  /** The bytes as they are, the field has a fixed size */
+  FIXED,
+
+  /** The collated bytes, padded to the maximum length of the field */
+  PADDED,
+
+  /** The bytes with 0x00 escaped as 0x00 0xff, terminated by 0x00 0x00 */
+  TERMINATED,
+
+  /** A FLOAT or a DOUBLE with its bits made sortable */
+  REAL
+};
+
+/**
+ * Works out how a field of an index is encoded in a normalized key.
+ *
+ * @param[in] index            Index.
+ * @param[in] i                Field number.
+ * @param[out] max_len         Maximum length of the field data.
+ *
+ * @return the encoding
+ */
+static Normalized_field cmp_normalized_field(const Index *index, ulint i, ulint &max_len) noexcept {
+  const auto field = index->get_nth_field(i);
+  const auto col = field->get_col();
+  const auto mtype = col->mtype;
+  const auto prtype = col->prtype;
+
+  max_len = field->m_prefix_len > 0 ? field->m_prefix_len : col->len;
+
+  if (mtype == DATA_FLOAT || mtype == DATA_DOUBLE) {
+    return Normalized_field::REAL;
+  }
+
+  /* Compared by cmp_whole_field(), see cmp_data_data_slow(). */
+  if (mtype >= DATA_FLOAT || (mtype == DATA_BLOB && !(prtype & DATA_BINARY_TYPE) && dtype_get_charset_coll(prtype) != DATA_CLIENT_LATIN1_SWEDISH_CHARSET_COLL)) {
+    return Normalized_field::NONE;
+  }
+
+  if (max_len > DICT_MAX_INDEX_COL_LEN) {
+    return Normalized_field::NONE;
+  }
+
+  if (dtype_get_pad_char(mtype, prtype) != ULINT_UNDEFINED) {
+    return Normalized_field::PADDED;
+  }
+
+  if (field->m_prefix_len == 0 && col->get_fixed_size() > 0) {
+    return Normalized_field::FIXED;
+  }
+
+  return Normalized_field::TERMINATED;
+}
+
+ulint cmp_normalized_key_max_size(const Index *index, ulint n_fields) noexcept {
+  ulint size{};
+
+  for (ulint i{}; i < n_fields; ++i) {
+    ulint max_len;
+
+    switch (cmp_normalized_field(index, i, max_len)) {
+      case Normalized_field::NONE:
+        return 0;
+      case Normalized_field::FIXED:
+      case Normalized_field::PADDED:
+        size += max_len;
+        break;
+      case Normalized_field::TERMINATED:
+        size += 2 * max_len + 2;
+        break;
+      case Normalized_field::REAL:
+        size += 8;
+        break;
+    }
+
+    /* The NULL flag */
+    if (!(index->get_nth_col(i)->prtype & DATA_NOT_NULL)) {
+      ++size;
+    }
+  }
+
+  return size;
+}
+
+ulint cmp_normalize_key(const Index *index, const dfield_t *fields, ulint n_fields, byte *buf) noexcept {
+  auto ptr = buf;
+
+  for (ulint i{}; i < n_fields; ++i) {
+    ulint max_len;
+    const auto dfield = &fields[i];
+    const auto kind = cmp_normalized_field(index, i, max_len);
+    const auto prtype = index->get_nth_col(i)->prtype;
+    const auto mtype = index->get_nth_col(i)->mtype;
+
+    ut_a(kind != Normalized_field::NONE);
+
+    /* SQL NULL is the smallest value. */
+    if (!(prtype & DATA_NOT_NULL)) {
+      if (dfield_is_null(dfield)) {
+        *ptr++ = 0x00;
+        continue;
+      }
+
+      *ptr++ = 0x01;
+    }
+
+    ut_ad(!dfield_is_null(dfield));
+
+    const auto data = static_cast<const byte *>(dfield_get_data(dfield));
+    const auto len = dfield_get_len(dfield);
+
+    switch (kind) {
+      case Normalized_field::NONE:
+        ut_error;
+
+      case Normalized_field::FIXED:
+        ut_ad(len == max_len);
+        memcpy(ptr, data, len);
+        ptr += len;
+        break;
+
+      case Normalized_field::PADDED: {
+        /* Shorter values are compared as if padded, see cmp_data_data_slow(). */
+        const auto collate = mtype <= DATA_CHAR || mtype == DATA_BLOB;
+        const auto pad = dtype_get_pad_char(mtype, prtype);
+
+        ut_ad(len <= max_len);
+
+        for (ulint j{}; j < len; ++j) {
+          *ptr++ = byte(collate ? cmp_collate(data[j]) : data[j]);
+        }
+
+        memset(ptr, int(collate ? cmp_collate(pad) : pad), max_len - len);
+        ptr += max_len - len;
+        break;
+      }
+
+      case Normalized_field::TERMINATED:
+        /* A value that is a prefix of another one is smaller. */
+        for (ulint j{}; j < len; ++j) {
+          *ptr++ = data[j];
+
+          if (data[j] == 0x00) {
+            *ptr++ = 0xff;
+          }
+        }
+
+        *ptr++ = 0x00;
+        *ptr++ = 0x00;
+        break;
+
+      case Normalized_field::REAL: {
+        /* Flip the sign bit of positive numbers and all the bits of negative
+        ones, -0 and 0 are equal. */
+        if (mtype == DATA_FLOAT) {
+          auto f = mach_float_read(data);
+          uint32_t bits;
+
+          if (f == 0) {
+            f = 0;
+          }
+
+          memcpy(&bits, &f, sizeof(bits));
+
+          bits = bits & 0x80000000 ? ~bits : bits | 0x80000000;
+
+          mach_write_to_4(ptr, bits);
+          memset(ptr + 4, 0x00, 4);
+        } else {
+          auto d = mach_double_read(data);
+          uint64_t bits;
+
+          if (d == 0) {
+            d = 0;
+          }
+
+          memcpy(&bits, &d, sizeof(bits));
+
+          bits = bits & (1ULL << 63) ? ~bits : bits | (1ULL << 63);
+
+          mach_write_to_8(ptr, bits);
+        }
+
+        ptr += 8;
+        break;
+      }
+    }
+  }
+
+  return ptr - buf;
+}
+
 int cmp_data_data_slow(
   void *cmp_ctx,
   ulint mtype,
@@ -321,9 +518,12 @@ int cmp_data_data_slow(
     return cmp_whole_field(cmp_ctx, mtype, (uint16_t)prtype, data1, (unsigned)len1, data2, (unsigned)len2);
   }
 
-  /* Compare then the fields */
+  /* Compare then the fields, the bytes that are the same stay the same
+  after the collation transformation below, skip them. */
 
-  cur_bytes = 0;
+  cur_bytes = ut_mismatch(data1, data2, std::min(len1, len2));
+  data1 += cur_bytes;
+  data2 += cur_bytes;
 
   for (;;) {
     if (len1 <= cur_bytes) {
@@ -500,6 +700,16 @@ int cmp_dtuple_rec_with_match(
     rec_b_ptr = rec_b_ptr + cur_bytes;
     dtuple_b_ptr = (byte *)dfield_get_data(dtuple_field) + cur_bytes;
 
+    /* Skip the bytes that are the same, they stay the same after the
+    collation transformation below. */
+    if (rec_f_len > cur_bytes && dtuple_f_len > cur_bytes) {
+      const auto n = ut_mismatch(dtuple_b_ptr, rec_b_ptr, std::min(rec_f_len, dtuple_f_len) - cur_bytes);
+
+      cur_bytes += n;
+      rec_b_ptr += n;
+      dtuple_b_ptr += n;
+    }
+
     /* Compare then the fields */
     for (;;) {
       if (unlikely(rec_f_len <= cur_bytes)) {
@@ -586,6 +796,105 @@ order_resolved:
   return ret;
 }
 
+int cmp_dtuple_rec_with_match(
+  const Index *index,
+  const DTuple *dtuple,
+  const rec_t *rec,
+  const ulint *offsets,
+  ulint *matched_fields,
+  ulint *matched_bytes) noexcept
+{
+  auto cur_field = *matched_fields;
+  const auto n_int = std::min<ulint>(index->m_n_int_fields, dtuple_get_n_fields_cmp(dtuple));
+
+  /* The predefined minimum record is left to the generic comparison. */
+  if (cur_field < n_int && !((rec_get_info_bits(rec) | dtuple_get_info_bits(dtuple)) & REC_INFO_MIN_REC_FLAG)) {
+    ut_ad(rec_offs_n_fields(offsets) >= n_int);
+
+    for (; cur_field < n_int; ++cur_field) {
+      ulint rec_f_len;
+      const auto dtuple_field = dtuple_get_nth_field(dtuple, cur_field);
+      const auto rec_b_ptr = rec_get_nth_field(rec, offsets, cur_field, &rec_f_len);
+
+      if (unlikely(dfield_get_len(dtuple_field) != rec_f_len)) {
+        /* An SQL null in a search tuple */
+        break;
+      }
+
+      const auto ret = cmp_int_field(static_cast<const byte *>(dfield_get_data(dtuple_field)), rec_b_ptr, rec_f_len);
+
+      if (ret != 0) {
+        ut_ad(ret == cmp_dtuple_rec(index->m_cmp_ctx, dtuple, rec, offsets));
+
+        *matched_fields = cur_field;
+        *matched_bytes = 0;
+
+        return ret;
+      }
+    }
+
+    *matched_fields = cur_field;
+    *matched_bytes = 0;
+  }
+
+  return cmp_dtuple_rec_with_match(index->m_cmp_ctx, dtuple, rec, offsets, matched_fields, matched_bytes);
+}
+
+bool cmp_rec_filters(const Index *index, const rec_t *rec, const ulint *offsets, const Rec_filters &filters) noexcept {
+  using Op = Rec_filter::Op;
+
+  for (const auto &filter : filters) {
+    ulint len;
+    const auto data = rec_get_nth_field(rec, offsets, filter.m_field_no, &len);
+
+    ut_ad(!rec_offs_nth_extern(offsets, filter.m_field_no));
+
+    if (filter.m_op == Op::IS_NULL || filter.m_op == Op::IS_NOT_NULL) {
+      if ((len == UNIV_SQL_NULL) != (filter.m_op == Op::IS_NULL)) {
+        return false;
+      }
+      continue;
+    } else if (len == UNIV_SQL_NULL || dfield_is_null(filter.m_value)) {
+      return false;
+    }
+
+    const auto col = index->get_nth_col(filter.m_field_no);
+    const auto value = static_cast<const byte *>(dfield_get_data(filter.m_value));
+    const auto cmp = cmp_data_data(index->m_cmp_ctx, col->mtype, col->prtype, data, len, value, dfield_get_len(filter.m_value));
+
+    bool match;
+
+    switch (filter.m_op) {
+      case Op::EQ:
+        match = cmp == 0;
+        break;
+      case Op::NE:
+        match = cmp != 0;
+        break;
+      case Op::LT:
+        match = cmp < 0;
+        break;
+      case Op::LE:
+        match = cmp <= 0;
+        break;
+      case Op::GT:
+        match = cmp > 0;
+        break;
+      case Op::GE:
+        match = cmp >= 0;
+        break;
+      default:
+        ut_error;
+    }
+
+    if (!match) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 int cmp_dtuple_rec(void *cmp_ctx, const DTuple *dtuple, const rec_t *rec, const ulint *offsets) noexcept  {
   ulint matched_fields = 0;
   ulint matched_bytes = 0;
@@ -643,7 +952,20 @@ int cmp_rec_rec_simple(
 
   ut_ad(rec_offs_base(offsets1) == rec_offs_base(offsets2));
 
-  for (cur_field = 0; cur_field < n_uniq; cur_field++) {
+  for (cur_field = 0; cur_field < index->m_n_int_fields; ++cur_field) {
+    rec1_b_ptr = rec_get_nth_field(rec1, offsets1, cur_field, &rec1_f_len);
+    rec2_b_ptr = rec_get_nth_field(rec2, offsets2, cur_field, &rec2_f_len);
+
+    ut_ad(rec1_f_len == rec2_f_len);
+
+    const auto ret = cmp_int_field(rec1_b_ptr, rec2_b_ptr, rec1_f_len);
+
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  for (; cur_field < n_uniq; cur_field++) {
 
     ulint mtype;
     uint16_t prtype;
@@ -693,8 +1015,14 @@ int cmp_rec_rec_simple(
       goto next_field;
     }
 
+    /* Skip the bytes that are the same, they stay the same after the
+    collation transformation below. */
+    cur_bytes = ut_mismatch(rec1_b_ptr, rec2_b_ptr, std::min(rec1_f_len, rec2_f_len));
+    rec1_b_ptr += cur_bytes;
+    rec2_b_ptr += cur_bytes;
+
     /* Compare the fields */
-    for (cur_bytes = 0;; cur_bytes++, rec1_b_ptr++, rec2_b_ptr++) {
+    for (;; cur_bytes++, rec1_b_ptr++, rec2_b_ptr++) {
       if (rec2_f_len <= cur_bytes) {
 
         if (rec1_f_len <= cur_bytes) {
@@ -776,6 +1104,27 @@ int cmp_rec_rec_with_match(
   auto cur_field = *matched_fields;
   auto cur_bytes = *matched_bytes;
 
+  /* The leading integer fields, the predefined minimum record is left to
+  the loop below. */
+  if (cur_field < index->m_n_int_fields && !((rec_get_info_bits(rec1) | rec_get_info_bits(rec2)) & REC_INFO_MIN_REC_FLAG)) {
+    const auto n_int = std::min<ulint>(index->m_n_int_fields, std::min(rec1_n_fields, rec2_n_fields));
+
+    cur_bytes = 0;
+
+    for (; cur_field < n_int; ++cur_field) {
+      rec1_b_ptr = rec_get_nth_field(rec1, offsets1, cur_field, &rec1_f_len);
+      rec2_b_ptr = rec_get_nth_field(rec2, offsets2, cur_field, &rec2_f_len);
+
+      ut_ad(rec1_f_len == rec2_f_len);
+
+      ret = cmp_int_field(rec1_b_ptr, rec2_b_ptr, rec1_f_len);
+
+      if (ret != 0) {
+        goto order_resolved;
+      }
+    }
+  }
+
   /* Match fields in a loop */
 
   while ((cur_field < rec1_n_fields) && (cur_field < rec2_n_fields)) {
@@ -854,6 +1203,16 @@ int cmp_rec_rec_with_match(
     rec1_b_ptr = rec1_b_ptr + cur_bytes;
     rec2_b_ptr = rec2_b_ptr + cur_bytes;
 
+    /* Skip the bytes that are the same, they stay the same after the
+    collation transformation below. */
+    if (rec1_f_len > cur_bytes && rec2_f_len > cur_bytes) {
+      const auto n = ut_mismatch(rec1_b_ptr, rec2_b_ptr, std::min(rec1_f_len, rec2_f_len) - cur_bytes);
+
+      cur_bytes += n;
+      rec1_b_ptr += n;
+      rec2_b_ptr += n;
+    }
+
     /* Compare then the fields */
     for (;;) {
       if (rec2_f_len <= cur_bytes) {
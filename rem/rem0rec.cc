@@ -234,6 +234,22 @@ ulint *Phy_rec::get_col_offsets(ulint *offsets, ulint n_fields, mem_heap_t **hea
 
   auto col_offsets{rec_offs_base(offsets)};
 
+  if (const auto ends = m_index->m_fixed_field_ends; ends != nullptr && n > 0 && rec_get_n_fields(m_rec) == m_index->m_n_fields) {
+    /* A node pointer record may have as many fields, it only matches if
+    the last field has the same size too. */
+    const auto last = m_index->m_n_fields - 1;
+    const auto one_byte = rec_get_1byte_offs_flag(m_rec);
+    const auto last_end = one_byte ? rec_1_get_field_end_info(m_rec, last) : rec_2_get_field_end_info(m_rec, last);
+
+    if (likely(last_end == ends[last])) {
+      *col_offsets = REC_N_EXTRA_BYTES + (one_byte ? n : 2 * n);
+
+      memcpy(col_offsets + 1, ends, n * sizeof(ulint));
+
+      return offsets;
+    }
+  }
+
   /* Determine extra size and end offsets */
 
   if (rec_get_1byte_offs_flag(m_rec)) {
@@ -27,6 +27,7 @@ Created 4/20/1996 Heikki Tuuri
 #include "btr0btr.h"
 #include "btr0cur.h"
 #include "buf0lru.h"
+#include "buf0rea.h"
 #include "data0data.h"
 #include "dict0dict.h"
 #include "eval0eval.h"
@@ -42,6 +43,8 @@ Created 4/20/1996 Heikki Tuuri
 #include "trx0undo.h"
 #include "usr0sess.h"
 
+#include <vector>
+
 constexpr ulint ROW_INS_PREV = 1;
 constexpr ulint ROW_INS_NEXT = 2;
 
@@ -212,7 +215,7 @@ db_err Row_insert::sec_index_entry_by_modify(ulint mode, Btree_cursor *btr_cur,
 
     auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
 
-    if (unlikely(buf_pool->m_LRU->buf_pool_running_out())) {
+    if (unlikely(buf_pool->running_out())) {
       err = DB_LOCK_TABLE_FULL;
     } else {
       big_rec_t *dummy_big_rec;
@@ -266,7 +269,7 @@ db_err Row_insert::clust_index_entry_by_modify(ulint mode, Btree_cursor *btr_cur
 
     auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
 
-    if (unlikely(buf_pool->m_LRU->buf_pool_running_out())) {
+    if (unlikely(buf_pool->running_out())) {
 
       return DB_LOCK_TABLE_FULL;
 
@@ -565,9 +568,9 @@ db_err Row_insert::update_cascade_client(que_thr_t *thr, upd_node_t *node, Table
       --table->m_stats.m_n_rows;
     }
 
-    ++srv_n_rows_deleted;
+    srv_n_rows_deleted.inc();
   } else {
-    ++srv_n_rows_updated;
+    srv_n_rows_updated.inc();
   }
 
   ib_update_statistics_if_needed(table);
@@ -894,8 +897,21 @@ db_err Row_insert::set_exclusive_rec_lock(ulint type, const Buf_block *block, co
   }
 }
 
+void Foreign_key_cache::make_key(const Foreign *foreign, const DTuple *entry) {
+  m_key.assign(reinterpret_cast<const char *>(&foreign), sizeof(foreign));
+
+  for (ulint i{}; i < foreign->m_n_fields; ++i) {
+    const auto field = dtuple_get_nth_field(entry, i);
+    const auto len = uint32_t(dfield_get_len(field));
+
+    m_key.append(reinterpret_cast<const char *>(&len), sizeof(len));
+    m_key.append(static_cast<const char *>(dfield_get_data(field)), len);
+  }
+}
+
 db_err Row_insert::check_foreign_constraint(bool check_ref, const Foreign *foreign, const Table *table, DTuple *entry, que_thr_t *thr) noexcept {
   upd_node_t *upd_node;
+  Foreign_key_cache *fk_cache{};
   Table *check_table;
   Index *check_index;
   ulint n_fields_cmp;
@@ -936,7 +952,13 @@ run_again:
     }
   }
 
-  if (que_node_get_type(thr->run_node) == QUE_NODE_UPDATE) {
+  if (check_ref && que_node_get_type(thr->run_node) == QUE_NODE_INSERT) {
+    fk_cache = static_cast<ins_node_t *>(thr->run_node)->m_fk_cache;
+
+    if (fk_cache != nullptr && fk_cache->contains(foreign, entry)) {
+      goto exit_func;
+    }
+  } else if (que_node_get_type(thr->run_node) == QUE_NODE_UPDATE) {
     upd_node = static_cast<upd_node_t *>(thr->run_node);
 
     if (!upd_node->m_is_delete && upd_node->m_foreign == foreign) {
@@ -1057,6 +1079,10 @@ run_again:
         if (check_ref) {
           err = DB_SUCCESS;
 
+          if (fk_cache != nullptr) {
+            fk_cache->insert(foreign, entry);
+          }
+
           break;
         } else if (foreign->m_type != 0) {
           /* There is an ON UPDATE or ON DELETE condition: check them in a separate function */
@@ -1149,6 +1175,152 @@ exit_func:
   return err;
 }
 
+db_err Row_insert::check_foreign_constraint_sorted(const Foreign *foreign) noexcept {
+  /* Distinct keys read from the foreign index per batch. */
+  constexpr ulint BATCH_SIZE = 256;
+
+  const auto child_index = foreign->m_foreign_index;
+  const auto parent_index = foreign->m_referenced_index;
+
+  if (parent_index == nullptr || foreign->m_referenced_table->m_ibd_file_missing) {
+    log_err(std::format("Foreign key constraint {}: the parent table {} does not exist", foreign->m_id, foreign->m_referenced_table_name));
+
+    return DB_NO_REFERENCED_ROW;
+  }
+
+  mtr_t mtr;
+  bool at_end{};
+  db_err err{DB_SUCCESS};
+  mem_heap_t *offsets_heap{};
+  std::vector<DTuple *> keys;
+  ulint offsets_[REC_OFFS_NORMAL_SIZE];
+  ulint *offsets = offsets_;
+  auto heap = mem_heap_create(1024);
+  Btree_pcursor child_pcur(m_dict->m_store.m_fsp, m_dict->m_store.m_btree);
+  Btree_pcursor parent_pcur(m_dict->m_store.m_fsp, m_dict->m_store.m_btree);
+
+  rec_offs_init(offsets_);
+
+  keys.reserve(BATCH_SIZE);
+
+  mtr.start();
+
+  child_pcur.open_at_index_side(true, child_index, BTR_SEARCH_LEAF, true, 0, &mtr);
+
+  while (err == DB_SUCCESS && !at_end) {
+    keys.clear();
+    mem_heap_empty(heap);
+
+    /* Read the next batch of distinct keys of the foreign index. */
+    while (keys.size() < BATCH_SIZE) {
+      if (!child_pcur.move_to_next_user_rec(&mtr)) {
+        at_end = true;
+        break;
+      }
+
+      const auto rec = child_pcur.get_rec();
+
+      if (rec_get_deleted_flag(rec)) {
+        continue;
+      }
+
+      {
+        Phy_rec record{child_index, rec};
+
+        offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &offsets_heap, Current_location());
+      }
+
+      if (!keys.empty() && cmp_dtuple_rec(child_index->m_cmp_ctx, keys.back(), rec, offsets) == 0) {
+        continue;
+      }
+
+      ulint n_ext;
+      auto key = row_rec_to_index_entry(ROW_COPY_DATA, rec, child_index, offsets, &n_ext, heap);
+
+      /* A key with an SQL NULL field is not checked, see check_foreign_constraint(). */
+      bool has_null{};
+
+      for (ulint i{}; i < foreign->m_n_fields && !has_null; ++i) {
+        has_null = dfield_is_null(dtuple_get_nth_field(key, i));
+      }
+
+      if (!has_null) {
+        dtuple_set_n_fields_cmp(key, foreign->m_n_fields);
+        keys.push_back(key);
+      }
+    }
+
+    child_pcur.store_position(&mtr);
+
+    mtr.commit();
+
+    if (!keys.empty()) {
+      mtr.start();
+
+      parent_pcur.open(parent_index, keys.front(), PAGE_CUR_GE, BTR_SEARCH_LEAF, &mtr, Current_location());
+
+      for (auto key : keys) {
+        /* Move forward to the first live parent record that is not less than the key. */
+        for (;;) {
+          if (!parent_pcur.is_on_user_rec() && !parent_pcur.move_to_next_user_rec(&mtr)) {
+            err = DB_NO_REFERENCED_ROW;
+            break;
+          }
+
+          const auto rec = parent_pcur.get_rec();
+
+          {
+            Phy_rec record{parent_index, rec};
+
+            offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &offsets_heap, Current_location());
+          }
+
+          const auto cmp = cmp_dtuple_rec(parent_index->m_cmp_ctx, key, rec, offsets);
+
+          if (cmp < 0) {
+            err = DB_NO_REFERENCED_ROW;
+            break;
+          } else if (cmp == 0 && !rec_get_deleted_flag(rec)) {
+            break;
+          } else if (!parent_pcur.move_to_next_user_rec(&mtr)) {
+            err = DB_NO_REFERENCED_ROW;
+            break;
+          }
+        }
+
+        if (err != DB_SUCCESS) {
+          mutex_enter(&m_dict->m_foreign_err_mutex);
+          log_err(std::format("Foreign key constraint {} fails for table {}, there is no parent row in {} for the tuple:",
+                              foreign->m_id, foreign->m_foreign_table_name, foreign->m_referenced_table_name));
+          dtuple_print(ib_stream, key);
+          mutex_exit(&m_dict->m_foreign_err_mutex);
+          break;
+        }
+      }
+
+      parent_pcur.close();
+
+      mtr.commit();
+    }
+
+    if (err == DB_SUCCESS && !at_end) {
+      mtr.start();
+
+      (void) child_pcur.restore_position(BTR_SEARCH_LEAF, &mtr, Current_location());
+    }
+  }
+
+  child_pcur.close();
+
+  mem_heap_free(heap);
+
+  if (likely_null(offsets_heap)) {
+    mem_heap_free(offsets_heap);
+  }
+
+  return err;
+}
+
 db_err Row_insert::check_foreign_constraints(const Table *table, const Index *index, DTuple *entry, que_thr_t *thr) noexcept {
   db_err err;
   bool got_s_lock = false;
@@ -1211,7 +1383,7 @@ bool Row_insert::dupl_error_with_rec(const rec_t *rec, const DTuple *entry, cons
   ulint matched_bytes{};
   ulint matched_fields{};
 
-  cmp_dtuple_rec_with_match(index->m_cmp_ctx, entry, rec, offsets, &matched_fields, &matched_bytes);
+  cmp_dtuple_rec_with_match(index, entry, rec, offsets, &matched_fields, &matched_bytes);
 
   if (matched_fields < n_unique) {
 
@@ -1341,6 +1513,91 @@ db_err Row_insert::scan_sec_index_for_duplicate(const Index *index, DTuple *entr
   return err;
 }
 
+db_err Row_insert::check_sec_index_for_duplicate_on_page(Btree_cursor *btr_cur, DTuple *entry, que_thr_t *thr) noexcept {
+  const auto index = btr_cur->m_index;
+  const auto block = btr_cur->get_block();
+  const rec_t *rec = btr_cur->get_rec();
+  const auto n_unique = index->get_n_unique();
+
+  ut_ad(!index->is_clustered());
+  ut_ad(index->is_unique());
+
+  for (ulint i = 0; i < n_unique; ++i) {
+    if (UNIV_SQL_NULL == dfield_get_len(dtuple_get_nth_field(entry, i))) {
+
+      return DB_SUCCESS;
+    }
+  }
+
+  const auto n_fields_cmp = dtuple_get_n_fields_cmp(entry);
+
+  dtuple_set_n_fields_cmp(entry, n_unique);
+
+  Page_rec_offsets rec_offsets{index, page_align(rec), ULINT_UNDEFINED};
+
+  /* The cursor is on the last record <= entry, go back to the record
+  before the first one with the unique fields of entry. */
+
+  while (!page_rec_is_infimum(rec) && cmp_dtuple_rec(index->m_cmp_ctx, entry, rec, rec_offsets.get(rec)) == 0) {
+    rec = page_rec_get_prev_const(rec);
+  }
+
+  auto err = DB_FAIL;
+
+  if (!page_rec_is_infimum(rec)) {
+    const auto first = page_rec_get_next_const(rec);
+
+    /* The scan stops after locking the first record greater than the
+    unique fields of entry, it must be on this page too. */
+
+    for (rec = first; !page_rec_is_supremum(rec); rec = page_rec_get_next_const(rec)) {
+      if (cmp_dtuple_rec(index->m_cmp_ctx, entry, rec, rec_offsets.get(rec)) < 0) {
+        err = DB_SUCCESS;
+        break;
+      }
+    }
+
+    if (err == DB_SUCCESS) {
+      const auto allow_duplicates = thr_get_trx(thr)->m_duplicates & TRX_DUP_IGNORE;
+
+      for (rec = first;; rec = page_rec_get_next_const(rec)) {
+        const auto offsets = rec_offsets.get(rec);
+
+        if (allow_duplicates) {
+          err = set_exclusive_rec_lock(LOCK_ORDINARY, block, rec, index, offsets, thr);
+        } else {
+          err = set_shared_rec_lock(LOCK_ORDINARY, block, rec, index, offsets, thr);
+        }
+
+        if (err != DB_SUCCESS) {
+          break;
+        }
+
+        const auto cmp = cmp_dtuple_rec(index->m_cmp_ctx, entry, rec, offsets);
+
+        if (cmp < 0) {
+          break;
+        }
+
+        ut_a(cmp == 0);
+
+        if (dupl_error_with_rec(rec, entry, index, offsets)) {
+          err = DB_DUPLICATE_KEY;
+
+          thr_get_trx(thr)->m_error_info = index;
+
+          break;
+        }
+      }
+    }
+  }
+
+  /* Restore old value */
+  dtuple_set_n_fields_cmp(entry, n_fields_cmp);
+
+  return err;
+}
+
 db_err Row_insert::duplicate_error_in_clust(Btree_cursor *btr_cur, DTuple *entry, que_thr_t *thr, mtr_t *mtr) noexcept {
   db_err err;
   rec_t *rec;
@@ -1479,7 +1736,7 @@ inline ulint Row_insert::must_modify(Btree_cursor *btr_cur) noexcept {
   return 0;
 }
 
-db_err Row_insert::index_entry_low(ulint mode, const Index *index, DTuple *entry, ulint n_ext, que_thr_t *thr) noexcept {
+db_err Row_insert::index_entry_low(ulint mode, const Index *index, DTuple *entry, ulint n_ext, que_thr_t *thr, Btree_leaf_guess *guess) noexcept {
   ulint modify{};
   rec_t *insert_rec;
   rec_t *rec;
@@ -1495,6 +1752,7 @@ db_err Row_insert::index_entry_low(ulint mode, const Index *index, DTuple *entry
   mtr.start();
 
   btr_cur.m_thr = thr;
+  btr_cur.m_leaf_guess = guess;
 
   btr_cur.search_to_nth_level(nullptr, index, 0, entry, PAGE_CUR_LE, mode | BTR_INSERT, &mtr, Current_location());
 
@@ -1522,22 +1780,33 @@ db_err Row_insert::index_entry_low(ulint mode, const Index *index, DTuple *entry
         goto function_exit;
       }
     } else {
-      mtr.commit();
-      err = scan_sec_index_for_duplicate(index, entry, thr);
-      mtr.start();
+      /* Usually the records with the same unique fields are all on the
+      leaf page that is latched, check them there and keep the cursor. */
 
-      if (err != DB_SUCCESS) {
+      err = check_sec_index_for_duplicate_on_page(&btr_cur, entry, thr);
 
-        goto function_exit;
-      }
+      if (err == DB_FAIL) {
+        mtr.commit();
+        err = scan_sec_index_for_duplicate(index, entry, thr);
+        mtr.start();
+
+        if (err != DB_SUCCESS) {
+
+          goto function_exit;
+        }
 
-      /* We did not find a duplicate and we have now
-      locked with s-locks the necessary records to
-      prevent any insertion of a duplicate by another
-      transaction. Let us now reposition the cursor and
-      continue the insertion. */
+        /* We did not find a duplicate and we have now
+        locked with s-locks the necessary records to
+        prevent any insertion of a duplicate by another
+        transaction. Let us now reposition the cursor and
+        continue the insertion. */
 
-      btr_cur.search_to_nth_level(nullptr, index, 0, entry, PAGE_CUR_LE, mode | BTR_INSERT, &mtr, Current_location());
+        btr_cur.search_to_nth_level(nullptr, index, 0, entry, PAGE_CUR_LE, mode | BTR_INSERT, &mtr, Current_location());
+
+      } else if (err != DB_SUCCESS) {
+
+        goto function_exit;
+      }
     }
   }
 
@@ -1571,7 +1840,7 @@ db_err Row_insert::index_entry_low(ulint mode, const Index *index, DTuple *entry
 
       auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
 
-      if (unlikely(buf_pool->m_LRU->buf_pool_running_out())) {
+      if (unlikely(buf_pool->running_out())) {
 
         err = DB_LOCK_TABLE_FULL;
 
@@ -1588,7 +1857,9 @@ function_exit:
   if (likely_null(big_rec)) {
     mtr.start();
 
-    btr_cur.search_to_nth_level(nullptr, index, 0, entry, PAGE_CUR_LE, BTR_MODIFY_TREE, &mtr, Current_location());
+    /* Writing the externally stored fields does not change the tree
+    structure, readers can proceed while the pages are written. */
+    btr_cur.search_to_nth_level(nullptr, index, 0, entry, PAGE_CUR_LE, BTR_MODIFY_LEAF | BTR_MODIFY_EXTERNAL, &mtr, Current_location());
 
     ulint *offsets;
     auto rec = btr_cur.get_rec();
@@ -1618,7 +1889,7 @@ function_exit:
   return err;
 }
 
-db_err Row_insert::index_entry(const Index *index, DTuple *entry, ulint n_ext, bool foreign, que_thr_t *thr) noexcept {
+db_err Row_insert::index_entry(const Index *index, DTuple *entry, ulint n_ext, bool foreign, que_thr_t *thr, Btree_leaf_guess *guess) noexcept {
   if (foreign && !index->m_table->m_foreign_list.empty()) {
     const auto err = check_foreign_constraints(index->m_table, index, entry, thr);
 
@@ -1629,17 +1900,18 @@ db_err Row_insert::index_entry(const Index *index, DTuple *entry, ulint n_ext, b
   }
 
   /* Try first optimistic descent to the B-tree */
-  {
-    const auto err = index_entry_low(BTR_MODIFY_LEAF, index, entry, n_ext, thr);
+  auto err = index_entry_low(BTR_MODIFY_LEAF, index, entry, n_ext, thr, guess);
 
-    if (err != DB_FAIL) {
+  if (err == DB_FAIL) {
+    /* Try then pessimistic descent to the B-tree */
+    err = index_entry_low(BTR_MODIFY_TREE, index, entry, n_ext, thr);
+  }
 
-      return err;
-    }
+  if (err == DB_SUCCESS) {
+    index->m_counters.inc(Index::ROWS_INSERTED);
   }
 
-  /* Try then pessimistic descent to the B-tree */
-  return index_entry_low(BTR_MODIFY_TREE, index, entry, n_ext, thr);
+  return err;
 }
 
 void Row_insert::index_entry_set_vals(Index *index, DTuple *entry, const DTuple *row) noexcept {
@@ -1681,7 +1953,39 @@ db_err Row_insert::index_entry_step(ins_node_t *node, que_thr_t *thr) noexcept {
 
   ut_ad(dtuple_check_typed(node->m_entry));
 
-  return index_entry(node->m_index, node->m_entry, 0, true, thr);
+  auto guess = node->m_index->is_clustered() ? node->m_clust_guess : nullptr;
+
+  return index_entry(node->m_index, node->m_entry, 0, true, thr, guess);
+}
+
+void Row_insert::prefetch_sec_index_leaves(ins_node_t *node) noexcept {
+  /* With a single leaf page to read there is nothing to overlap. */
+  constexpr ulint MIN_N_PAGES = 2;
+  constexpr ulint MAX_N_PAGES = 64;
+
+  ulint n_pages{};
+  std::array<page_no_t, MAX_N_PAGES> page_nos;
+  const auto space = node->m_index->get_space_id();
+  auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
+  Btree_cursor btr_cur(m_dict->m_store.m_fsp, m_dict->m_store.m_btree);
+
+  auto entry = node->m_entry;
+
+  for (auto index = node->m_index; index != nullptr && n_pages < MAX_N_PAGES; index = index->get_next()) {
+    index_entry_set_vals(index, entry, node->m_row);
+
+    const auto page_no = btr_cur.get_leaf_page_no(index, entry, Current_location());
+
+    if (page_no != FIL_NULL && !buf_pool->peek(space, page_no)) {
+      page_nos[n_pages++] = page_no;
+    }
+
+    entry = UT_LIST_GET_NEXT(tuple_list, entry);
+  }
+
+  if (n_pages >= MIN_N_PAGES) {
+    buf_read_ahead_pages(space, page_nos.data(), n_pages);
+  }
 }
 
 inline void Row_insert::alloc_row_id_step(ins_node_t *node) noexcept {
@@ -1770,8 +2074,14 @@ db_err Row_insert::insert(ins_node_t *node, que_thr_t *thr) noexcept {
       return err;
     }
 
+    const auto clustered = node->m_index->is_clustered();
+
     node->m_index = node->m_index->get_next();
     node->m_entry = UT_LIST_GET_NEXT(tuple_list, node->m_entry);
+
+    if (clustered && node->m_index != nullptr) {
+      prefetch_sec_index_leaves(node);
+    }
   }
 
   ut_ad(node->m_entry == nullptr);
@@ -27,6 +27,7 @@ Completed by Sunny Bains and Marko Makela
 #include "api0misc.h"
 #include "btr0btr.h"
 #include "btr0blob.h"
+#include "btr0bulk.h"
 #include "data0data.h"
 #include "data0type.h"
 #include "ddl0ddl.h"
@@ -39,14 +40,18 @@ Completed by Sunny Bains and Marko Makela
 #include "mem0mem.h"
 #include "os0file.h"
 #include "os0proc.h"
+#include "os0thread-create.h"
 #include "pars0pars.h"
 #include "read0read.h"
 #include "rem0cmp.h"
 #include "row0ext.h"
 #include "row0ins.h"
+#include "row0pread.h"
 #include "row0row.h"
 #include "row0sel.h"
 #include "row0upd.h"
+#include "srv0srv.h"
+#include "srv0task.h"
 #include "trx0purge.h"
 #include "trx0rec.h"
 #include "trx0roll.h"
@@ -55,6 +60,15 @@ Completed by Sunny Bains and Marko Makela
 #include "trx0undo.h"
 #include "ut0sort.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -376,6 +390,8 @@ static void row_merge_dup_report(
 static int row_merge_tuple_cmp(
   void *cmp_ctx,     /*!< in: compare context, required
                           for BLOBs and user defined types */
+  ulint n_int,       /*!< in: number of leading integer
+                          fields, see Index::m_n_int_fields */
   ulint n_field,     /*!< in: number of fields */
   const dfield_t *a, /*!< in: first tuple to be compared */
   const dfield_t *b, /*!< in: second tuple to be compared */
@@ -385,12 +401,27 @@ static int row_merge_tuple_cmp(
   int cmp;
   const dfield_t *field = a;
 
-  /* Compare the fields of the rows until a difference is
-  found or we run out of fields to compare.  If !cmp at the
-  end, the rows are equal. */
-  do {
-    cmp = cmp_dfield_dfield(cmp_ctx, a++, b++);
-  } while (!cmp && --n_field);
+  /* The leading integer fields can't be NULL. */
+  for (; n_int > 0; --n_int, --n_field, ++a, ++b) {
+    ut_ad(dfield_get_len(a) == dfield_get_len(b));
+
+    cmp = cmp_int_field(static_cast<const byte *>(dfield_get_data(a)), static_cast<const byte *>(dfield_get_data(b)), dfield_get_len(a));
+
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+
+  if (n_field == 0) {
+    cmp = 0;
+  } else {
+    /* Compare the fields of the rows until a difference is
+    found or we run out of fields to compare.  If !cmp at the
+    end, the rows are equal. */
+    do {
+      cmp = cmp_dfield_dfield(cmp_ctx, a++, b++);
+    } while (!cmp && --n_field);
+  }
 
   if (unlikely(!cmp) && likely_null(dup)) {
     /* Report a duplicate value error if the rows are
@@ -416,18 +447,20 @@ UT_SORT_FUNCTION_BODY().
 @param b	aux (work area), same size as rows[]
 @param c	lower bound of the sorting area, inclusive
 @param d	upper bound of the sorting area, inclusive */
-#define row_merge_tuple_sort_ctx(x, a, b, c, d) row_merge_tuple_sort(x, n_field, dup, a, b, c, d)
+#define row_merge_tuple_sort_ctx(x, a, b, c, d) row_merge_tuple_sort(x, n_int, n_field, dup, a, b, c, d)
 /** Wrapper for row_merge_tuple_cmp() to inject some more context to
 UT_SORT_FUNCTION_BODY().
 @param a	first tuple to be compared
 @param b	second tuple to be compared
 @return	1, 0, -1 if a is greater, equal, less, respectively, than b */
-#define row_merge_tuple_cmp_ctx(x, a, b) row_merge_tuple_cmp(x, n_field, a, b, dup)
+#define row_merge_tuple_cmp_ctx(x, a, b) row_merge_tuple_cmp(x, n_int, n_field, a, b, dup)
 
 /** Merge sort the tuple buffer in main memory. */
 static void row_merge_tuple_sort(
   void *cmp_ctx,           /*!< in: compare context, required
                              for BLOBs and user defined types */
+  ulint n_int,             /*!< in: number of leading integer
+                             fields */
   ulint n_field,           /*!< in: number of fields */
   row_merge_dup_t *dup,    /*!< in/out: for reporting duplicates */
   const dfield_t **rows, /*!< in/out: rows */
@@ -441,13 +474,113 @@ static void row_merge_tuple_sort(
   UT_SORT_FUNCTION_BODY(cmp_ctx, row_merge_tuple_sort_ctx, rows, aux, low, high, row_merge_tuple_cmp_ctx);
 }
 
+/** Largest normalized key used to sort a buffer, longer keys cost more
+memory than they save in comparisons. */
+constexpr ulint ROW_MERGE_MAX_NORMALIZED_KEY = 512;
+
+/** Sort a buffer by the normalized keys of its rows, see cmp_normalize_key(). */
+static void row_merge_buf_sort_normalized(
+  row_merge_buf_t *buf, /*!< in/out: sort buffer */
+  row_merge_dup_t *dup, /*!< in/out: for reporting duplicates */
+  ulint max_size        /*!< in: maximum size of a normalized key */
+)
+{
+  struct Sort_key {
+    /** First bytes of m_key in big-endian order, zero padded */
+    uint64_t m_prefix;
+
+    /** Normalized key */
+    const byte *m_key;
+
+    /** Size of m_key */
+    ulint m_len;
+
+    /** Row of the key */
+    const dfield_t *m_row;
+
+    /** Position of the row in the buffer */
+    ulint m_pos;
+  };
+
+  const auto index = buf->index;
+  const auto n_uniq = index->get_n_unique();
+  auto heap = mem_heap_create(buf->n_recs * sizeof(Sort_key) + UNIV_PAGE_SIZE);
+  auto keys = reinterpret_cast<Sort_key *>(mem_heap_alloc(heap, buf->n_recs * sizeof(Sort_key)));
+  auto tmp = reinterpret_cast<byte *>(mem_heap_alloc(heap, max_size));
+
+  for (ulint i{}; i < buf->n_recs; ++i) {
+    const auto len = cmp_normalize_key(index, buf->rows[i], n_uniq, tmp);
+    auto key = reinterpret_cast<byte *>(mem_heap_alloc(heap, len));
+
+    memcpy(key, tmp, len);
+
+    uint64_t prefix{};
+
+    for (ulint j{}; j < sizeof(prefix); ++j) {
+      prefix = (prefix << 8) | (j < len ? key[j] : 0);
+    }
+
+    keys[i] = Sort_key{prefix, key, len, buf->rows[i], i};
+  }
+
+  /* Most comparisons are decided by the prefixes without touching the keys,
+  which are scattered over the heap. Equal keys keep the order of their rows,
+  the tuple comparison of row_merge_tuple_sort() is stable too. No key is a
+  prefix of another one. */
+  std::sort(keys, keys + buf->n_recs, [](const Sort_key &a, const Sort_key &b) {
+    if (a.m_prefix != b.m_prefix) {
+      return a.m_prefix < b.m_prefix;
+    }
+
+    const auto cmp = memcmp(a.m_key, b.m_key, std::min(a.m_len, b.m_len));
+
+    if (cmp != 0) {
+      return cmp < 0;
+    } else if (a.m_len != b.m_len) {
+      return a.m_len < b.m_len;
+    } else {
+      return a.m_pos < b.m_pos;
+    }
+  });
+
+  for (ulint i{}; i < buf->n_recs; ++i) {
+    buf->rows[i] = keys[i].m_row;
+
+    if (dup == nullptr || i == 0 || keys[i].m_len != keys[i - 1].m_len || memcmp(keys[i].m_key, keys[i - 1].m_key, keys[i].m_len) != 0) {
+      continue;
+    }
+
+    /* NULL columns are logically inequal, see row_merge_tuple_cmp(). */
+    const auto row = keys[i].m_row;
+
+    if (std::none_of(row, row + n_uniq, [](const dfield_t &field) { return dfield_is_null(&field); })) {
+      row_merge_dup_report(dup, row);
+    }
+  }
+
+  mem_heap_free(heap);
+}
+
 /** Sort a buffer. */
 static void row_merge_buf_sort(
   row_merge_buf_t *buf, /*!< in/out: sort buffer */
   row_merge_dup_t *dup
 ) /*!< in/out: for reporting duplicates */
 {
-  row_merge_tuple_sort(buf->index->m_cmp_ctx, buf->index->get_n_unique(), dup, buf->rows, buf->tmp_tuples, 0, buf->n_recs);
+  const auto index = buf->index;
+  const auto n_uniq = index->get_n_unique();
+
+  /* The integer comparisons are as fast as memcmp(). */
+  if (buf->n_recs > 1 && index->m_n_int_fields < n_uniq) {
+    const auto max_size = cmp_normalized_key_max_size(index, n_uniq);
+
+    if (max_size > 0 && max_size <= ROW_MERGE_MAX_NORMALIZED_KEY) {
+      row_merge_buf_sort_normalized(buf, dup, max_size);
+      return;
+    }
+  }
+
+  row_merge_tuple_sort(index->m_cmp_ctx, index->m_n_int_fields, n_uniq, dup, buf->rows, buf->tmp_tuples, 0, buf->n_recs);
 }
 
 /** Write a buffer to a block. */
@@ -543,9 +676,9 @@ static Index *row_merge_dict_table_get_index(
   return (index);
 }
 
-/** Read a merge block from the file system.
+/** Read a merge block from the file system, without the read-ahead.
 @return	true if request was successful, false if fail */
-static bool row_merge_read(
+static bool row_merge_read_low(
   int fd,       /*!< in: file descriptor */
   ulint offset, /*!< in: offset where to read */
   row_merge_block_t *buf
@@ -563,9 +696,9 @@ static bool row_merge_read(
   return success;
 }
 
-/** Read a merge block from the file system.
+/** Write a merge block to the file system, without the write-behind.
 @return	true if request was successful, false if fail */
-static bool row_merge_write(
+static bool row_merge_write_low(
   int fd,       /*!< in: file descriptor */
   ulint offset, /*!< in: offset where to write */
   const void *buf
@@ -576,6 +709,262 @@ static bool row_merge_write(
   return os_file_write("(merge)", OS_FILE_FROM_FD(fd), buf, sizeof(row_merge_block_t), off);
 }
 
+/** Overlaps the merge file I/O with the merging. A background thread reads
+the block that follows the one just read from a file, and writes a full
+output block while the next one is filled. Merge passes read their input
+sequentially, one block at a time per run, so the block is usually there
+when it is asked for. */
+class Row_merge_io {
+ public:
+  Row_merge_io() noexcept {
+    for (auto &slot : m_slots) {
+      slot.m_size = sizeof(row_merge_block_t);
+      slot.m_block = static_cast<row_merge_block_t *>(os_mem_alloc_large(&slot.m_size));
+    }
+
+    m_thread = create_joinable_thread([this]() { run(); });
+  }
+
+  ~Row_merge_io() noexcept {
+    (void) flush();
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_shutdown = true;
+    }
+
+    m_cond.notify_all();
+    m_thread.join();
+
+    for (auto &slot : m_slots) {
+      os_mem_free_large(slot.m_block, slot.m_size);
+    }
+  }
+
+  /**
+   * Read a block, from the read-ahead if it has it. Then start reading the
+   * block after it.
+   *
+   * @param[in] fd File descriptor
+   * @param[in] offset Block number
+   * @param[out] buf Block
+   * @return true if the read succeeded
+   */
+  bool read(int fd, ulint offset, row_merge_block_t *buf) noexcept {
+    bool hit{};
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (ulint i{}; i < N_READ_SLOTS; ++i) {
+      auto &slot = m_slots[i];
+
+      if (slot.m_state != Slot::FREE && slot.m_fd == fd && slot.m_offset == offset) {
+        m_cond.wait(lock, [&] { return slot.m_state == Slot::DONE; });
+
+        /* A failed read-ahead may be past the end of the file, the read below reports the error. */
+        if (slot.m_ok) {
+          memcpy(buf, slot.m_block, sizeof(*buf));
+          hit = true;
+        }
+
+        slot.m_state = Slot::FREE;
+        break;
+      }
+    }
+
+    lock.unlock();
+
+    if (!hit && !row_merge_read_low(fd, offset, buf)) {
+      return false;
+    }
+
+    read_ahead(fd, offset + 1);
+
+    return true;
+  }
+
+  /**
+   * Write a block in the background. Waits for the previous write first.
+   *
+   * @param[in] fd File descriptor
+   * @param[in] offset Block number
+   * @param[in] buf Block, it is copied
+   * @return false if this or the previous write failed
+   */
+  bool write(int fd, ulint offset, const void *buf) noexcept {
+    auto &slot = m_slots[WRITE_SLOT];
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [&] { return slot.m_state != Slot::PENDING; });
+
+    const auto ok = slot.m_state == Slot::FREE || slot.m_ok;
+
+    memcpy(slot.m_block, buf, sizeof(row_merge_block_t));
+
+    slot.m_fd = fd;
+    slot.m_offset = offset;
+    slot.m_state = Slot::PENDING;
+
+    lock.unlock();
+
+    m_cond.notify_all();
+
+    return ok;
+  }
+
+  /**
+   * Wait for the pending write and drop the read-ahead. Must be called
+   * before a file that was written is read, or written again.
+   *
+   * @return false if the last write failed
+   */
+  bool flush() noexcept {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_cond.wait(lock, [&] {
+      return std::none_of(m_slots.begin(), m_slots.end(), [](const Slot &slot) { return slot.m_state == Slot::PENDING; });
+    });
+
+    const auto &write_slot = m_slots[WRITE_SLOT];
+    const auto ok = write_slot.m_state == Slot::FREE || write_slot.m_ok;
+
+    for (auto &slot : m_slots) {
+      slot.m_state = Slot::FREE;
+    }
+
+    return ok;
+  }
+
+ private:
+  /** A block being read or written in the background. */
+  struct Slot {
+    enum State { FREE, PENDING, DONE };
+
+    /** State of the I/O */
+    State m_state{FREE};
+
+    /** File descriptor */
+    int m_fd{-1};
+
+    /** Block number */
+    ulint m_offset{};
+
+    /** Outcome of the I/O once DONE */
+    bool m_ok{};
+
+    /** Contents */
+    row_merge_block_t *m_block{};
+
+    /** Size of the allocation of m_block */
+    ulint m_size{};
+  };
+
+  /** One read-ahead per input run of a two-way merge. */
+  static constexpr ulint N_READ_SLOTS = 2;
+
+  /** Slot of the background write. */
+  static constexpr ulint WRITE_SLOT = N_READ_SLOTS;
+
+  void read_ahead(int fd, ulint offset) noexcept {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto it = std::find_if(m_slots.begin(), m_slots.begin() + N_READ_SLOTS, [](const Slot &slot) { return slot.m_state == Slot::FREE; });
+
+      if (it == m_slots.begin() + N_READ_SLOTS) {
+        return;
+      }
+
+      it->m_fd = fd;
+      it->m_offset = offset;
+      it->m_state = Slot::PENDING;
+    }
+
+    m_cond.notify_all();
+  }
+
+  /** The background thread. */
+  void run() noexcept {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;) {
+      auto it = std::find_if(m_slots.begin(), m_slots.end(), [](const Slot &slot) { return slot.m_state == Slot::PENDING; });
+
+      if (it == m_slots.end()) {
+        if (m_shutdown) {
+          break;
+        }
+
+        m_cond.wait(lock);
+        continue;
+      }
+
+      const auto write = it == m_slots.begin() + WRITE_SLOT;
+
+      lock.unlock();
+
+      /* Only the caller of read() and write() changes a PENDING slot, after waiting for DONE. */
+      const auto ok = write ? row_merge_write_low(it->m_fd, it->m_offset, it->m_block)
+                            : os_file_read_no_error_handling(OS_FILE_FROM_FD(it->m_fd), it->m_block, sizeof(row_merge_block_t), off_t(it->m_offset) * sizeof(row_merge_block_t));
+
+      lock.lock();
+
+      it->m_ok = ok;
+      it->m_state = Slot::DONE;
+
+      m_cond.notify_all();
+    }
+  }
+
+  /** Read-ahead slots, then the write slot */
+  std::array<Slot, N_READ_SLOTS + 1> m_slots{};
+
+  /** Protects m_slots and m_shutdown */
+  std::mutex m_mutex{};
+
+  /** Signalled when a slot changes state */
+  std::condition_variable m_cond{};
+
+  /** Set when the object is destroyed */
+  bool m_shutdown{};
+
+  /** Background I/O thread */
+  std::thread m_thread{};
+};
+
+/** The background I/O of the merge running in this thread, if any. */
+static thread_local Row_merge_io *row_merge_io{};
+
+/** Installs a Row_merge_io for the current thread while in scope. */
+struct Row_merge_io_scope {
+  Row_merge_io_scope() noexcept { row_merge_io = &m_io; }
+
+  ~Row_merge_io_scope() noexcept { row_merge_io = nullptr; }
+
+  Row_merge_io m_io{};
+};
+
+/** Read a merge block from the file system.
+@return	true if request was successful, false if fail */
+static bool row_merge_read(
+  int fd,       /*!< in: file descriptor */
+  ulint offset, /*!< in: offset where to read */
+  row_merge_block_t *buf
+) /*!< out: data */
+{
+  return row_merge_io != nullptr ? row_merge_io->read(fd, offset, buf) : row_merge_read_low(fd, offset, buf);
+}
+
+/** Write a merge block to the file system.
+@return	true if request was successful, false if fail */
+static bool row_merge_write(
+  int fd,       /*!< in: file descriptor */
+  ulint offset, /*!< in: offset where to write */
+  const void *buf
+) /*!< in: data */
+{
+  return row_merge_io != nullptr ? row_merge_io->write(fd, offset, buf) : row_merge_write_low(fd, offset, buf);
+}
+
 /**
  * Reads a record from the specified file buffer and returns a pointer to the merge record.
  * 
@@ -1039,7 +1428,7 @@ static db_err row_merge_read_clustered_index(
         continue;
       }
 
-      ++srv_n_rows_inserted;
+      srv_n_rows_inserted.inc();
 
       /* Build a row based on the clustered index. */
 
@@ -1136,6 +1525,252 @@ static db_err row_merge_read_clustered_index(
   return func_exit(err);
 }
 
+/** State of one thread of a parallel clustered index scan. */
+struct Row_merge_scan_thread {
+  /** Sort buffers, one per index */
+  row_merge_buf_t **m_bufs{};
+
+  /** Buffer for writing a sorted buffer to its file */
+  row_merge_block_t *m_block{};
+
+  /** Size of m_block in bytes */
+  ulint m_block_size{};
+
+  /** Heap for the rows built from the clustered index records */
+  mem_heap_t *m_row_heap{};
+
+  /** Number of rows added to each index */
+  std::vector<uint64_t> m_n_recs{};
+
+  /** Number of rows read */
+  ulint m_n_rows{};
+
+  /** Index that the error of this thread was found in */
+  ulint m_error_key_num{ULINT_UNDEFINED};
+};
+
+/**
+ * Sort the rows in a buffer of a parallel scan and write them as one run at
+ * the end of the file. The file offset is shared by all the threads.
+ *
+ * @param thd Scan thread state
+ * @param i Index of the buffer
+ * @param table Client table, for reporting duplicates
+ * @param file Merge file of the index
+ * @param offset Next free block of the file
+ * @return DB_SUCCESS or error
+ */
+static db_err row_merge_scan_flush(
+  Row_merge_scan_thread &thd,
+  ulint i,
+  table_handle_t table,
+  const merge_file_t *file,
+  std::atomic<ulint> &offset) noexcept
+{
+  auto buf = thd.m_bufs[i];
+
+  if (buf->n_recs == 0) {
+    return DB_SUCCESS;
+  }
+
+  if (buf->index->is_unique()) {
+    row_merge_dup_t dup;
+
+    dup.index = buf->index;
+    dup.table = table;
+    dup.n_dup = 0;
+
+    row_merge_buf_sort(buf, &dup);
+
+    if (dup.n_dup > 0) {
+      thd.m_error_key_num = i;
+      return DB_DUPLICATE_KEY;
+    }
+  } else {
+    row_merge_buf_sort(buf, nullptr);
+  }
+
+  row_merge_buf_write(buf, file, thd.m_block);
+
+  if (!row_merge_write(file->fd, offset.fetch_add(1), thd.m_block)) {
+    thd.m_error_key_num = i;
+    return DB_OUT_OF_FILE_SPACE;
+  }
+
+  UNIV_MEM_INVALID(thd.m_block[0], sizeof thd.m_block[0]);
+
+  thd.m_bufs[i] = row_merge_buf_empty(buf);
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Reads the clustered index with Parallel_reader and writes the entries of
+ * the indexes to be created to the merge files. Every thread fills its own
+ * sort buffers, the sorted buffers of all the threads are runs in the same
+ * file and row_merge_sort() merges them as it does for a single thread.
+ *
+ * @see row_merge_read_clustered_index() for the parameters.
+ *
+ * @param n_threads Number of threads reserved with Parallel_reader::available_threads()
+ * @return DB_SUCCESS or error
+ */
+static db_err row_merge_read_clustered_index_parallel(
+  Trx *trx,
+  table_handle_t table,
+  Table *old_table,
+  const Table *new_table,
+  Index **index,
+  merge_file_t *files,
+  ulint n_index,
+  size_t n_threads) noexcept
+{
+  std::vector<ulint> nonnull{};
+
+  trx->m_op_info = "reading clustered index";
+
+  if (unlikely(old_table != new_table)) {
+    /* See row_merge_read_clustered_index(). */
+    const auto n_cols = old_table->get_n_cols();
+
+    ut_a(n_cols == new_table->get_n_cols());
+
+    for (ulint i{}; i < n_cols; ++i) {
+      if (!(old_table->get_nth_col(i)->prtype & DATA_NOT_NULL) && (new_table->get_nth_col(i)->prtype & DATA_NOT_NULL)) {
+        nonnull.push_back(i);
+      }
+    }
+  }
+
+  std::vector<Row_merge_scan_thread> threads(n_threads);
+
+  for (auto &thd : threads) {
+    thd.m_bufs = static_cast<row_merge_buf_t **>(mem_alloc(n_index * sizeof(row_merge_buf_t *)));
+
+    for (ulint i{}; i < n_index; ++i) {
+      thd.m_bufs[i] = row_merge_buf_create(index[i]);
+    }
+
+    thd.m_block_size = sizeof(row_merge_block_t);
+    thd.m_block = static_cast<row_merge_block_t *>(os_mem_alloc_large(&thd.m_block_size));
+    thd.m_row_heap = mem_heap_create(sizeof(mrec_buf_t));
+    thd.m_n_recs.resize(n_index);
+  }
+
+  std::vector<std::atomic<ulint>> offsets(n_index);
+
+  const auto clust_index = old_table->get_clustered_index();
+
+  Parallel_reader reader(n_threads);
+  Parallel_reader::Scan_range full_scan;
+  Parallel_reader::Config config(full_scan, clust_index);
+
+  config.m_scan_resistant = true;
+
+  /* No read view: the table is locked, the scan returns the records that aren't delete marked. */
+  auto err = reader.add_scan(nullptr, config, [&](const Parallel_reader::Ctx *ctx) -> dberr_t {
+    auto &thd = threads[ctx->thread_id()];
+
+    if (ctx->m_first_rec && unlikely(trx_is_interrupted(trx))) {
+      return DB_INTERRUPTED;
+    }
+
+    row_ext_t *ext;
+    auto row = row_build(ROW_COPY_POINTERS, clust_index, ctx->m_rec, ctx->m_offsets, new_table, &ext, thd.m_row_heap);
+
+    for (ulint i{}; i < nonnull.size(); ++i) {
+      auto field = &row->fields[nonnull[i]];
+      auto field_type = dfield_get_type(field);
+
+      ut_a(!(field_type->prtype & DATA_NOT_NULL));
+
+      if (dfield_is_null(field)) {
+        thd.m_error_key_num = i;
+        return DB_PRIMARY_KEY_IS_NULL;
+      }
+
+      field_type->prtype |= DATA_NOT_NULL;
+    }
+
+    for (ulint i{}; i < n_index; ++i) {
+      if (unlikely(!row_merge_buf_add(thd.m_bufs[i], row, ext))) {
+        if (auto err = row_merge_scan_flush(thd, i, table, &files[i], offsets[i]); err != DB_SUCCESS) {
+          return err;
+        }
+
+        /* An empty buffer should have enough room for at least one record. */
+        if (unlikely(!row_merge_buf_add(thd.m_bufs[i], row, ext))) {
+          ut_error;
+        }
+      }
+
+      ++thd.m_n_recs[i];
+    }
+
+    ++thd.m_n_rows;
+
+    mem_heap_empty(thd.m_row_heap);
+
+    return DB_SUCCESS;
+  });
+
+  if (err == DB_SUCCESS) {
+    err = reader.run(n_threads);
+
+    if (err == DB_OUT_OF_RESOURCES) {
+      log_warn("Resource not available to create threads for the index build scan. Falling back to single thread mode.");
+
+      err = reader.run(0);
+    }
+  }
+
+  /* Write out what is left in the buffers once all threads are done. */
+  for (auto &thd : threads) {
+    for (ulint i{}; i < n_index && err == DB_SUCCESS; ++i) {
+      err = row_merge_scan_flush(thd, i, table, &files[i], offsets[i]);
+    }
+  }
+
+  for (ulint i{}; i < n_index && err == DB_SUCCESS; ++i) {
+    files[i].offset = offsets[i].load();
+
+    if (files[i].offset == 0) {
+      /* The file must contain at least the end of file marker. */
+      row_merge_buf_write(threads[0].m_bufs[i], &files[i], threads[0].m_block);
+
+      if (!row_merge_write(files[i].fd, files[i].offset++, threads[0].m_block)) {
+        threads[0].m_error_key_num = i;
+        err = DB_OUT_OF_FILE_SPACE;
+      }
+    }
+  }
+
+  for (auto &thd : threads) {
+    if (err != DB_SUCCESS && thd.m_error_key_num != ULINT_UNDEFINED) {
+      trx->m_error_key_num = thd.m_error_key_num;
+    }
+
+    for (ulint i{}; i < n_index; ++i) {
+      files[i].n_rec += thd.m_n_recs[i];
+      row_merge_buf_free(thd.m_bufs[i]);
+    }
+
+    srv_n_rows_inserted.inc(thd.m_n_rows);
+
+    mem_free(thd.m_bufs);
+    mem_heap_free(thd.m_row_heap);
+    os_mem_free_large(thd.m_block, thd.m_block_size);
+  }
+
+  if (err == DB_INTERRUPTED) {
+    trx->m_error_key_num = ULINT_UNDEFINED;
+  }
+
+  trx->m_op_info = "";
+
+  return err;
+}
+
 /** Write a record via buffer 2 and read the next record to buffer N.
 @param N	number of the buffer (0 or 1)
 @param AT_END	statement to execute at end of input */
@@ -1427,6 +2062,11 @@ static __attribute__((nonnull)) db_err row_merge(
     return (DB_CORRUPTION);
   }
 
+  /* The output is read by the next pass. */
+  if (row_merge_io != nullptr && !row_merge_io->flush()) {
+    return DB_OUT_OF_FILE_SPACE;
+  }
+
   /* Swap file descriptors for the next pass. */
   *tmpfd = file->fd;
   *file = of;
@@ -1452,6 +2092,7 @@ static db_err row_merge_sort(
                                           if applicable */
 {
   ulint half = file->offset / 2;
+  Row_merge_io_scope io_scope;
 
   /* The file should always contain at least one byte (the end
   of file marker).  Thus, it must be at least one block. */
@@ -1509,52 +2150,46 @@ static void row_merge_copy_blobs(
 }
 
 /**
- * @brief Read sorted file containing index data rows and insert these data rows to the index.
+ * @brief Read sorted file containing index data rows and build the index
+ * from them bottom up, see Btree_bulk.
  * 
  * @param[in] trx Transaction.
- * @param[in] index Index.
- * @param[in] table New table.
+ * @param[in] index Index, empty.
  * @param[in] fd File descriptor.
  * @param[in] block File buffer.
  * 
  * @return DB_SUCCESS or error number.
  */
-static db_err row_merge_insert_index_tuples(Trx *trx, Index *index, Table *table, int fd, row_merge_block_t *block) {
+static db_err row_merge_insert_index_tuples(Trx *trx, Index *index, int fd, row_merge_block_t *block) {
   mrec_buf_t buf;
   const byte *b;
-  que_thr_t *thr;
-  ins_node_t *node;
   mem_heap_t *tuple_heap;
-  mem_heap_t *graph_heap;
   enum db_err err = DB_SUCCESS;
   ulint foffs = 0;
   ulint *offsets;
 
   ut_ad(trx);
   ut_ad(index);
-  ut_ad(table);
 
-  /* We use the insert query graph as the dummy graph
-  needed in the row module call */
+  Row_merge_io_scope io_scope;
 
   trx->m_op_info = "inserting index entries";
 
-  graph_heap = mem_heap_create(500);
-  node = srv_row_ins->node_create(INS_DIRECT, table, graph_heap);
-
-  thr = pars_complete_graph_for_exec(node, trx, graph_heap);
-
-  que_thr_move_to_run_state(thr);
-
   tuple_heap = mem_heap_create(1000);
 
   {
     ulint i = 1 + REC_OFFS_HEADER_SIZE + index->get_n_fields();
-    offsets = reinterpret_cast<ulint *>(mem_heap_alloc(graph_heap, i * sizeof *offsets));
+    offsets = reinterpret_cast<ulint *>(mem_heap_alloc(tuple_heap, i * sizeof *offsets));
     offsets[0] = i;
     offsets[1] = index->get_n_fields();
   }
 
+  /* The tuples come sorted, the tree is built left to right without a
+  descent, a lock or undo log record per tuple. */
+  Btree_bulk bulk(srv_btree_sys, index, trx->m_id);
+
+  auto row_heap = mem_heap_create(1000);
+
   b = *block;
 
   if (!row_merge_read(fd, foffs, block)) {
@@ -1574,51 +2209,200 @@ static db_err row_merge_insert_index_tuples(Trx *trx, Index *index, Table *table
         break;
       }
 
-      dtuple = row_rec_to_index_entry_low(mrec, index, offsets, &n_ext, tuple_heap);
+      dtuple = row_rec_to_index_entry_low(mrec, index, offsets, &n_ext, row_heap);
 
       if (unlikely(n_ext)) {
-        row_merge_copy_blobs(mrec, offsets, dtuple, tuple_heap);
+        row_merge_copy_blobs(mrec, offsets, dtuple, row_heap);
       }
 
-      node->m_row = dtuple;
-      node->m_table = table;
-      node->m_trx_id = trx->m_id;
-
       ut_ad(dtuple_validate(dtuple));
 
-      do {
-        thr->run_node = thr;
-        thr->prev_node = thr->common.parent;
+      err = bulk.insert(dtuple, 0);
 
-        err = srv_row_ins->index_entry(index, dtuple, 0, false, thr);
+      mem_heap_empty(row_heap);
 
-        if (likely(err == DB_SUCCESS)) {
+      if (err != DB_SUCCESS) {
+        break;
+      }
+    }
+  }
 
-          goto next_rec;
-        }
+  err = bulk.finish(err);
 
-        thr->lock_state = QUE_THR_LOCK_ROW;
-        trx->m_error_state = err;
-        que_thr_stop_client(thr);
-        thr->lock_state = QUE_THR_LOCK_NOLOCK;
-      } while (ib_handle_errors(&err, trx, thr, nullptr));
+  trx->m_op_info = "";
 
-      goto err_exit;
-    next_rec:
-      mem_heap_empty(tuple_heap);
+  mem_heap_free(row_heap);
+  mem_heap_free(tuple_heap);
+
+  return err;
+}
+
+/**
+ * Checks if the entries of a new clustered index come in ascending order from
+ * a scan of the clustered index of the table that they are built from, that
+ * is, the new index has the same key.
+ *
+ * @param[in] old_index Clustered index of the table read.
+ * @param[in] new_index Clustered index being created.
+ *
+ * @return true if the entries don't have to be sorted.
+ */
+static bool row_merge_is_clust_order_preserved(const Index *old_index, const Index *new_index) noexcept {
+  const auto n_uniq = new_index->get_n_unique();
+
+  if (!new_index->is_clustered() || old_index->get_n_unique() != n_uniq) {
+    return false;
+  }
+
+  for (ulint i{}; i < n_uniq; ++i) {
+    const auto old_field = old_index->get_nth_field(i);
+    const auto new_field = new_index->get_nth_field(i);
+    const auto old_col = old_field->get_col();
+    const auto new_col = new_field->get_col();
+
+    if (old_col->get_no() != new_col->get_no() || old_field->m_prefix_len != new_field->m_prefix_len ||
+        old_col->mtype != new_col->mtype || old_col->len != new_col->len ||
+        (old_col->prtype & ~DATA_NOT_NULL) != (new_col->prtype & ~DATA_NOT_NULL)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Builds a clustered index that has the same key as the clustered index of
+ * the table it's built from. The records of the table are read in key order
+ * and appended to the new index bottom up, see Btree_bulk, without sorting
+ * them through a merge file.
+ *
+ * @param[in] trx Transaction.
+ * @param[in] old_table Table to read.
+ * @param[in] new_table Table of the index.
+ * @param[in] index Clustered index to build, empty.
+ * @param[in] count_rows true to add the rows read to srv_n_rows_inserted.
+ *
+ * @return DB_SUCCESS or error code.
+ */
+static db_err row_merge_copy_clustered_index(Trx *trx, const Table *old_table, const Table *new_table, Index *index, bool count_rows) noexcept {
+  mtr_t mtr;
+  db_err err{DB_SUCCESS};
+  std::vector<ulint> nonnull{};
+  Btree_pcursor pcur(srv_fsp, srv_btree_sys);
+  const auto clust_index = old_table->get_clustered_index();
+
+  if (old_table != new_table) {
+    /* See row_merge_read_clustered_index(). */
+    for (ulint i{}; i < old_table->get_n_cols(); ++i) {
+      if (!(old_table->get_nth_col(i)->prtype & DATA_NOT_NULL) && (new_table->get_nth_col(i)->prtype & DATA_NOT_NULL)) {
+        nonnull.push_back(i);
+      }
     }
   }
 
-  que_thr_stop_for_client_no_error(thr, trx);
+  Btree_bulk bulk(srv_btree_sys, index, trx->m_id);
 
-err_exit:
-  que_graph_free(thr->graph);
+  auto row_heap = mem_heap_create(sizeof(mrec_buf_t));
 
-  trx->m_op_info = "";
+  mtr.start();
 
-  mem_heap_free(tuple_heap);
+  /* The copy reads the whole table once, it must not evict the working set. */
+  mtr.set_scan();
 
-  return (err);
+  pcur.open_at_index_side(true, clust_index, BTR_SEARCH_LEAF, true, 0, &mtr);
+
+  auto has_next = pcur.move_to_next_user_rec(&mtr);
+
+  while (has_next && err == DB_SUCCESS) {
+    const auto rec = pcur.get_rec();
+
+    if (!rec_get_deleted_flag(rec)) {
+      ulint *offsets;
+      row_ext_t *ext;
+
+      {
+        Phy_rec record{clust_index, rec};
+
+        offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &row_heap, Current_location());
+      }
+
+      auto row = row_build(ROW_COPY_POINTERS, clust_index, rec, offsets, new_table, &ext, row_heap);
+
+      for (auto col_no : nonnull) {
+        auto field = &row->fields[col_no];
+
+        if (dfield_is_null(field)) {
+          err = DB_PRIMARY_KEY_IS_NULL;
+          break;
+        }
+
+        dfield_get_type(field)->prtype |= DATA_NOT_NULL;
+      }
+
+      if (err != DB_SUCCESS) {
+        break;
+      }
+
+      auto entry = row_build_index_entry(row, nullptr, index, row_heap);
+
+      /* Read the externally stored columns, the builder stores them again
+      if they don't fit on the page. The table is locked, they can't be
+      freed while the copy reads them. */
+      for (ulint i{}; i < dtuple_get_n_fields(entry); ++i) {
+        auto field = dtuple_get_nth_field(entry, i);
+
+        if (dfield_is_ext(field)) {
+          ulint len;
+          Blob blob(srv_fsp, srv_btree_sys);
+          const auto data = static_cast<const byte *>(dfield_get_data(field));
+
+          auto copy = blob.copy_externally_stored_field(&len, data, dfield_get_len(field), row_heap);
+
+          dfield_set_data(field, copy, len);
+        }
+      }
+
+      err = bulk.insert(entry, 0);
+
+      if (count_rows) {
+        srv_n_rows_inserted.inc();
+      }
+    }
+
+    mem_heap_empty(row_heap);
+
+    if (err != DB_SUCCESS) {
+      break;
+    }
+
+    pcur.move_to_next_on_page();
+
+    if (pcur.is_after_last_on_page()) {
+      if (unlikely(trx_is_interrupted(trx))) {
+        err = DB_INTERRUPTED;
+        break;
+      }
+
+      /* Release the latch on the page before moving on. */
+      pcur.store_position(&mtr);
+
+      mtr.commit();
+
+      mtr.start();
+
+      (void) pcur.restore_position(BTR_SEARCH_LEAF, &mtr, Current_location());
+
+      has_next = pcur.move_to_next_user_rec(&mtr);
+    }
+  }
+
+  pcur.close();
+
+  mtr.commit();
+
+  mem_heap_free(row_heap);
+
+  return bulk.finish(err);
 }
 
 /** Drop an index from the InnoDB system tables.  The data dictionary must
@@ -1657,10 +2441,22 @@ void row_merge_drop_indexes(
   }
 }
 
+/** Bypasses the page cache for a merge file if the data files bypass it.
+The merge blocks are page aligned and always read and written whole.
+@param[in] fd Merge file descriptor. */
+static void row_merge_file_set_direct(int fd) {
+  if (fd != -1 && srv_config.m_unix_file_flush_method == SRV_UNIX_O_DIRECT) {
+    /* The tmpdir can be on a file system without O_DIRECT support, e.g.,
+    tmpfs, the merge file is then cached. */
+    (void) fcntl(fd, F_SETFL, O_DIRECT);
+  }
+}
+
 /** Create a merge file. */
 static void row_merge_file_create(merge_file_t *merge_file) /*!< out: merge file structure */
 {
   merge_file->fd = ib_create_tempfile("ibmrg");
+  row_merge_file_set_direct(merge_file->fd);
   merge_file->offset = 0;
   merge_file->n_rec = 0;
 }
@@ -1885,10 +2681,76 @@ db_err row_merge_drop_table(Trx *trx, Table *table) {
   return err;
 }
 
-db_err row_merge_build_indexes(
+/**
+ * Merge sort the files of several indexes at the same time, each thread
+ * takes the next index with its own buffers and temporary file.
+ *
+ * @param trx Transaction
+ * @param indexes Indexes being created
+ * @param files Merge files of the indexes
+ * @param n_indexes Number of indexes
+ * @param n_threads Number of threads to use, reserved with Parallel_reader::available_threads()
+ * @param table Client table, for reporting duplicates
+ * @return DB_SUCCESS or error, trx->m_error_key_num is the index of the error
+ */
+static db_err row_merge_sort_parallel(
+  Trx *trx,
+  Index **indexes,
+  merge_file_t *files,
+  ulint n_indexes,
+  size_t n_threads,
+  table_handle_t table) noexcept
+{
+  std::atomic<ulint> next{};
+  std::vector<db_err> errs(n_indexes, DB_SUCCESS);
+
+  auto sort = [&]() {
+    auto block_size = 3 * sizeof(row_merge_block_t);
+    auto block = static_cast<row_merge_block_t *>(os_mem_alloc_large(&block_size));
+    auto tmpfd = ib_create_tempfile("mrg");
+
+    row_merge_file_set_direct(tmpfd);
+
+    for (auto i{next.fetch_add(1)}; i < n_indexes; i = next.fetch_add(1)) {
+      errs[i] = row_merge_sort(trx, indexes[i], &files[i], block, &tmpfd, table);
+    }
+
+    close(tmpfd);
+    os_mem_free_large(block, block_size);
+  };
+
+  Task_group tasks(Task_class::Index_build);
+
+  for (size_t i{1}; i < n_threads; ++i) {
+    tasks.run(sort);
+  }
+
+  sort();
+
+  tasks.wait();
+
+  for (ulint i{}; i < n_indexes; ++i) {
+    if (errs[i] != DB_SUCCESS) {
+      trx->m_error_key_num = i;
+      return errs[i];
+    }
+  }
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Build indexes from the entries of a scan of the clustered index that are
+ * sorted through merge files.
+ *
+ * @see row_merge_build_indexes() for the parameters.
+ *
+ * @return DB_SUCCESS or error code, trx->m_error_key_num is the index of the error
+ */
+static db_err row_merge_build_sorted_indexes(
   Trx *trx,
   Table *old_table,
-  Table *new_table,
+  const Table *new_table,
   Index **indexes,
   ulint n_indexes,
   table_handle_t table)
@@ -1912,11 +2774,22 @@ db_err row_merge_build_indexes(
   }
 
   auto tmpfd = ib_create_tempfile("mrg");
+  row_merge_file_set_direct(tmpfd);
+
+  db_err err;
+  bool sorted{};
+  auto n_threads = Parallel_reader::available_threads(srv_config.m_n_index_build_threads, false);
 
   /* Read clustered index of the table and create files for
   secondary index entries for merge sort */
 
-  auto err = row_merge_read_clustered_index(trx, table, old_table, new_table, indexes, merge_files, n_indexes, block);
+  if (n_threads > 1) {
+    err = row_merge_read_clustered_index_parallel(trx, table, old_table, new_table, indexes, merge_files, n_indexes, n_threads);
+  } else {
+    Parallel_reader::release_threads(n_threads);
+
+    err = row_merge_read_clustered_index(trx, table, old_table, new_table, indexes, merge_files, n_indexes, block);
+  }
 
   if (err != DB_SUCCESS) {
 
@@ -1926,11 +2799,29 @@ db_err row_merge_build_indexes(
   /* Now we have files containing index entries ready for
   sorting and inserting. */
 
+  if (n_threads > 1 && n_indexes > 1) {
+    n_threads = Parallel_reader::available_threads(std::min(size_t(n_indexes), n_threads), false);
+
+    if (n_threads > 1) {
+      err = row_merge_sort_parallel(trx, indexes, merge_files, n_indexes, n_threads, table);
+      sorted = true;
+    }
+
+    Parallel_reader::release_threads(n_threads);
+
+    if (err != DB_SUCCESS) {
+
+      goto func_exit;
+    }
+  }
+
   for (ulint i{}; i < n_indexes; ++i) {
-    err = row_merge_sort(trx, indexes[i], &merge_files[i], block, &tmpfd, table);
+    if (!sorted) {
+      err = row_merge_sort(trx, indexes[i], &merge_files[i], block, &tmpfd, table);
+    }
 
     if (err == DB_SUCCESS) {
-      err = row_merge_insert_index_tuples(trx, indexes[i], new_table, merge_files[i].fd, block);
+      err = row_merge_insert_index_tuples(trx, indexes[i], merge_files[i].fd, block);
     }
 
     /* Close the temporary file to free up space. */
@@ -1954,3 +2845,69 @@ func_exit:
 
   return err;
 }
+
+db_err row_merge_build_indexes(
+  Trx *trx,
+  Table *old_table,
+  Table *new_table,
+  Index **indexes,
+  ulint n_indexes,
+  table_handle_t table)
+{
+  ut_a(trx->m_conc_state != TRX_NOT_STARTED);
+
+  /* A clustered index with the key of the table read, e.g., the copy of a
+  table, is built directly from the scan in key order, without sorting. */
+  ulint clust_i{ULINT_UNDEFINED};
+
+  for (ulint i{}; i < n_indexes; ++i) {
+    if (row_merge_is_clust_order_preserved(old_table->get_clustered_index(), indexes[i])) {
+      clust_i = i;
+      break;
+    }
+  }
+
+  if (clust_i == ULINT_UNDEFINED) {
+    return row_merge_build_sorted_indexes(trx, old_table, new_table, indexes, n_indexes, table);
+  } else if (n_indexes == 1) {
+    auto err = row_merge_copy_clustered_index(trx, old_table, new_table, indexes[clust_i], true);
+
+    if (err != DB_SUCCESS) {
+      trx->m_error_key_num = err == DB_INTERRUPTED ? ULINT_UNDEFINED : clust_i;
+    }
+
+    return err;
+  }
+
+  std::vector<Index *> sorted{};
+
+  for (ulint i{}; i < n_indexes; ++i) {
+    if (i != clust_i) {
+      sorted.push_back(indexes[i]);
+    }
+  }
+
+  /* The clustered index is copied by its own thread while the other indexes
+  are built from a parallel scan. */
+  db_err clust_err{DB_SUCCESS};
+
+  auto thread = create_joinable_thread([&]() {
+    clust_err = row_merge_copy_clustered_index(trx, old_table, new_table, indexes[clust_i], false);
+  });
+
+  auto err = row_merge_build_sorted_indexes(trx, old_table, new_table, sorted.data(), sorted.size(), table);
+
+  thread.join();
+
+  if (err != DB_SUCCESS) {
+    /* Map the error back to the position in indexes[]. */
+    if (trx->m_error_key_num != ULINT_UNDEFINED && trx->m_error_key_num >= clust_i) {
+      ++trx->m_error_key_num;
+    }
+  } else if (clust_err != DB_SUCCESS) {
+    err = clust_err;
+    trx->m_error_key_num = err == DB_INTERRUPTED ? ULINT_UNDEFINED : clust_i;
+  }
+
+  return err;
+}
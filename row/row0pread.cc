@@ -467,6 +467,10 @@ bool Parallel_reader::Scan_ctx::check_visibility(const rec_t *&rec, ulint *&offs
   return true;
 }
 
+bool Parallel_reader::Scan_ctx::check_filters(const rec_t *rec, const ulint *offsets) const {
+  return m_config.m_filters.empty() || cmp_rec_filters(m_config.m_index, rec, offsets, m_config.m_filters);
+}
+
 void Parallel_reader::Scan_ctx::copy_row(const rec_t *rec, Iter *iter) const {
   {
     Phy_rec record{m_config.m_index, rec};
@@ -544,7 +548,26 @@ Parallel_reader::Scan_ctx::create_persistent_cursor(const page_cur_t &page_curso
 bool Parallel_reader::Ctx::move_to_next_node(PCursor *pcursor) {
   IF_DEBUG(auto cur = m_range.first->m_pcur->get_page_cur();)
 
-  auto err = pcursor->move_to_next_block(const_cast<Index *>(index()));
+  dberr_t err;
+  auto reader = m_scan_ctx->m_reader;
+
+  if (reader->m_max_pages_per_sec > 0) {
+    const auto n_pages = reader->m_n_pages_throttled.fetch_add(1, std::memory_order_relaxed) + 1;
+    const auto due = reader->m_throttle_start + std::chrono::microseconds(n_pages * 1000000 / reader->m_max_pages_per_sec);
+
+    if (std::chrono::steady_clock::now() < due) {
+      /* Don't hold the page latches while waiting. */
+      pcursor->savepoint();
+
+      std::this_thread::sleep_until(due);
+
+      err = pcursor->restore_from_savepoint();
+    } else {
+      err = pcursor->move_to_next_block(const_cast<Index *>(index()));
+    }
+  } else {
+    err = pcursor->move_to_next_block(const_cast<Index *>(index()));
+  }
 
   if (err != DB_SUCCESS) {
     ut_a(err == DB_END_OF_INDEX);
@@ -557,6 +580,58 @@ bool Parallel_reader::Ctx::move_to_next_node(PCursor *pcursor) {
   }
 }
 
+dberr_t Parallel_reader::Ctx::donate(PCursor *pcursor) {
+  ut_ad(pcursor->is_after_last_on_page());
+
+  /* The rest of the range starts after the last record of the page. */
+  Scan_ctx::Iter last{};
+
+  last.m_heap = mem_heap_create(UNIV_PAGE_SIZE / 16);
+
+  m_scan_ctx->copy_row(page_rec_get_prev_const(page_cur_get_rec(pcursor->get_page_cursor())), &last);
+
+  /* The index latch is ordered before the page latches. */
+  pcursor->savepoint();
+
+  m_scan_ctx->index_s_lock();
+
+  const Scan_range scan_range(last.m_tuple, m_range.second->m_tuple);
+  Scan_ctx::Ranges ranges{};
+  dberr_t err{DB_SUCCESS};
+
+  /* Split at the shallowest level where the rest spans two sub-trees. */
+  for (size_t level{}; err == DB_SUCCESS && ranges.size() < 2 && level < m_scan_ctx->m_depth; ++level) {
+    ranges.clear();
+    err = m_scan_ctx->partition(scan_range, ranges, level);
+  }
+
+  if (err == DB_SUCCESS && ranges.size() >= 2) {
+    const auto half = ranges.size() / 2;
+
+    ranges.back().second = m_range.second;
+
+    /* This context stops where the first donated range starts. */
+    m_range.second = ranges[half].first;
+
+    for (auto i = half; i < ranges.size() && err == DB_SUCCESS; ++i) {
+      err = m_scan_ctx->create_context(ranges[i], false);
+    }
+
+    if (err != DB_SUCCESS) {
+      m_scan_ctx->set_error_state(err);
+    }
+
+    /* Tell the idle threads that there is work to do. */
+    m_scan_ctx->m_reader->m_event->set();
+  }
+
+  m_scan_ctx->index_s_unlock();
+
+  const auto restore_err = pcursor->restore_from_savepoint();
+
+  return err != DB_SUCCESS ? err : restore_err;
+}
+
 dberr_t Parallel_reader::Ctx::traverse() {
   /* Take index lock if the requested read level is on a non-leaf level as the
   index lock is required to access non-leaf page.  */
@@ -566,6 +641,10 @@ dberr_t Parallel_reader::Ctx::traverse() {
 
   mtr_t mtr;
 
+  if (m_scan_ctx->m_config.m_scan_resistant) {
+    mtr.set_scan();
+  }
+
   mtr.start();
 
   mtr.disable_redo_logging();
@@ -595,7 +674,6 @@ dberr_t Parallel_reader::Ctx::traverse() {
 }
 
 dberr_t Parallel_reader::Ctx::traverse_recs(PCursor *pcursor, mtr_t *mtr) {
-  const auto &end_tuple = m_range.second->m_tuple;
   auto heap = mem_heap_create(UNIV_PAGE_SIZE / 4);
   auto index = m_scan_ctx->m_config.m_index;
 
@@ -611,6 +689,7 @@ dberr_t Parallel_reader::Ctx::traverse_recs(PCursor *pcursor, mtr_t *mtr) {
 
   bool call_end_page{true};
   auto cur = pcursor->get_page_cursor();
+  Rec_offsets rec_offsets;
 
   while (err == DB_SUCCESS) {
     if (page_cur_is_after_last(cur)) {
@@ -627,6 +706,9 @@ dberr_t Parallel_reader::Ctx::traverse_recs(PCursor *pcursor, mtr_t *mtr) {
 
       mem_heap_empty(heap);
 
+      /* The callbacks may have released the page latch. */
+      rec_offsets.invalidate();
+
       if (!(m_n_pages % TRX_IS_INTERRUPTED_PROBE) && trx()->is_interrupted()) {
         err = DB_INTERRUPTED;
         break;
@@ -636,6 +718,19 @@ dberr_t Parallel_reader::Ctx::traverse_recs(PCursor *pcursor, mtr_t *mtr) {
         break;
       }
 
+      /* Only leaf ranges are split, a scan of a higher level holds the index
+      latch that donate() needs. */
+      if (pcursor->is_after_last_on_page() && m_scan_ctx->m_config.m_read_level == 0 && m_scan_ctx->m_reader->is_work_wanted()) {
+        err = donate(pcursor);
+
+        if (err != DB_SUCCESS) {
+          if (err == DB_END_OF_INDEX) {
+            err = DB_SUCCESS;
+          }
+          break;
+        }
+      }
+
       /* Note: The page end callback (above) can save and restore the cursor.
       The restore can end up in the middle of a page. */
       if (pcursor->is_after_last_on_page() && !move_to_next_node(pcursor)) {
@@ -657,18 +752,11 @@ dberr_t Parallel_reader::Ctx::traverse_recs(PCursor *pcursor, mtr_t *mtr) {
       }
     }
 
-    ulint offsets_[REC_OFFS_NORMAL_SIZE];
-    ulint *offsets = offsets_;
-
-    rec_offs_init(offsets_);
-
     const rec_t *rec = page_cur_get_rec(cur);
+    auto offsets = rec_offsets.get(index, rec);
 
-    {
-      Phy_rec record{index, rec};
-
-      offsets = record.get_col_offsets(offsets, ULINT_UNDEFINED, &heap, Current_location());
-    }
+    /* The end moves when the range is donated. */
+    const auto end_tuple = m_range.second->m_tuple;
 
     if (end_tuple != nullptr) {
       ut_ad(rec != nullptr);
@@ -693,10 +781,19 @@ dberr_t Parallel_reader::Ctx::traverse_recs(PCursor *pcursor, mtr_t *mtr) {
     bool skip{};
 
     if (page_is_leaf(cur->m_block->get_frame())) {
-      skip = !m_scan_ctx->check_visibility(rec, offsets, heap, mtr);
+      /* The filters must see the version the transaction reads. Visibility
+      is a read of the DB_TRX_ID unless an old version has to be built. */
+      skip = !m_scan_ctx->check_visibility(rec, offsets, heap, mtr) || !m_scan_ctx->check_filters(rec, offsets);
+
+      /* An old version may have been built over the offsets. */
+      if (rec != page_cur_get_rec(cur)) {
+        rec_offsets.invalidate();
+      }
     }
 
-    if (!skip) {
+    if (skip) {
+      ++m_thread_ctx->m_stats.m_n_skipped;
+    } else {
       m_rec = rec;
       m_offsets = offsets;
       m_block = cur->m_block;
@@ -767,6 +864,8 @@ void Parallel_reader::worker(Parallel_reader::Thread_ctx *thread_ctx) {
   dberr_t err{DB_SUCCESS};
   dberr_t cb_err{DB_SUCCESS};
 
+  os_thread_bind(OS_THREAD_CLASS_READER);
+
   if (m_start_callback) {
     /* Thread start. */
     thread_ctx->m_state = State::THREAD;
@@ -790,8 +889,11 @@ void Parallel_reader::worker(Parallel_reader::Thread_ctx *thread_ctx) {
     int64_t sig_count = m_event->reset();
 
     while (err == DB_SUCCESS && cb_err == DB_SUCCESS && !is_error_set()) {
+      const auto dequeue_start = std::chrono::steady_clock::now();
       auto ctx = dequeue();
 
+      thread_ctx->m_stats.m_dequeue_ns += std::chrono::steady_clock::now() - dequeue_start;
+
       if (ctx == nullptr) {
         break;
       }
@@ -816,7 +918,16 @@ void Parallel_reader::worker(Parallel_reader::Thread_ctx *thread_ctx) {
         }
 
         if (cb_err == DB_SUCCESS && err == DB_SUCCESS) {
+          const auto traverse_start = std::chrono::steady_clock::now();
+
           err = ctx->traverse();
+
+          auto &stats = thread_ctx->m_stats;
+
+          stats.m_traverse_ns += std::chrono::steady_clock::now() - traverse_start;
+          /* The page the traversal starts on is not counted in m_n_pages. */
+          stats.m_n_pages += ctx->m_n_pages + 1;
+          ++stats.m_n_ctxs;
         }
 
         if (m_finish_callback) {
@@ -851,7 +962,14 @@ void Parallel_reader::worker(Parallel_reader::Thread_ctx *thread_ctx) {
     }
 
     if (!m_sync) {
+      /* Busy workers donate part of their ranges while this is set. */
+      const auto idle_start = std::chrono::steady_clock::now();
+
+      m_n_idle.fetch_add(1, std::memory_order_relaxed);
       m_event->wait_time(std::chrono::microseconds::max(), sig_count);
+      m_n_idle.fetch_sub(1, std::memory_order_relaxed);
+
+      thread_ctx->m_stats.m_idle_ns += std::chrono::steady_clock::now() - idle_start;
     }
   }
 
@@ -63,18 +63,7 @@ Prebuilt::Prebuilt(FSP *fsp, Btree *btree, Table *table, mem_heap_t *heap) noexc
 
   clust_index->copy_types(m_clust_ref, ref_len);
 
-  m_row_cache.m_n_max = FETCH_CACHE_SIZE;
-  m_row_cache.m_n_size = m_row_cache.m_n_max;
-
-  {
-    const auto sz = sizeof(*m_row_cache.m_cached_rows) * m_row_cache.m_n_max;
-
-    m_row_cache.m_heap = mem_heap_create(sz);
-
-    auto ptr = mem_heap_zalloc(m_row_cache.m_heap, sz);
-
-    m_row_cache.m_cached_rows = new (ptr) Cached_row[m_row_cache.m_n_max];
-  }
+  m_row_cache.clear();
 
   m_magic_n2 = ROW_PREBUILT_ALLOCATED;
 }
@@ -90,7 +79,11 @@ Prebuilt::~Prebuilt() noexcept {
   m_magic_n = ROW_PREBUILT_FREED;
   m_magic_n2 = ROW_PREBUILT_FREED;
 
+  /* Releases the block a cursor may keep buffer-fixed. */
+  call_destructor(m_pcur);
   ut_delete(m_pcur);
+
+  call_destructor(m_clust_pcur);
   ut_delete(m_clust_pcur);
 
   if (m_sel_graph != nullptr) {
@@ -101,15 +94,11 @@ Prebuilt::~Prebuilt() noexcept {
     mem_heap_free(m_old_vers_heap);
   }
 
-  for (ulint i{}; i < m_row_cache.m_n_max; ++i) {
-    auto &cached_row = m_row_cache.m_cached_rows[i];
-
-    if (cached_row.m_ptr != nullptr) {
-      mem_free(cached_row.m_ptr);
-    }
+  if (m_filter_heap != nullptr) {
+    mem_heap_free(m_filter_heap);
   }
 
-  mem_heap_free(m_row_cache.m_heap);
+  m_row_cache.free();
 }
 
 Prebuilt *Prebuilt::create(FSP *fsp, Btree *btree, Table *table) noexcept {
@@ -135,6 +124,7 @@ void Prebuilt::clear() noexcept {
 
   m_index_usable = false;
   m_simple_select = false;
+  m_scan_resistant = false;
   m_sql_stat_start = true;
   m_client_has_locked = false;
   m_need_to_access_clustered = false;
@@ -174,3 +164,50 @@ void Prebuilt::update_trx(Trx *trx) noexcept {
     m_index_usable = row_merge_is_index_usable(m_trx, m_index);
   }
 }
+
+void Prebuilt::Row_cache::reserve_rows(ulint n_rows) noexcept {
+  ut_a(is_cache_empty());
+
+  if (n_rows > m_n_alloc) {
+    if (m_cached_rows != nullptr) {
+      mem_free(m_cached_rows);
+    }
+
+    auto ptr = mem_alloc(n_rows * sizeof(Cached_row));
+
+    m_cached_rows = new (ptr) Cached_row[n_rows];
+    m_n_alloc = uint16_t(n_rows);
+  }
+}
+
+void Prebuilt::Row_cache::reserve_bytes(ulint len) noexcept {
+  if (len > m_arena_size) {
+    /* Grow geometrically, the rows of the current refill are moved over to the new arena. */
+    const auto size = std::max(len, ulint(m_arena_size) * 2);
+    auto arena = static_cast<byte *>(mem_alloc(size));
+
+    if (m_arena != nullptr) {
+      memcpy(arena, m_arena, m_arena_used);
+      mem_free(m_arena);
+    }
+
+    m_arena = arena;
+    m_arena_size = uint32_t(size);
+  }
+}
+
+void Prebuilt::Row_cache::free() noexcept {
+  if (m_cached_rows != nullptr) {
+    mem_free(m_cached_rows);
+    m_cached_rows = nullptr;
+  }
+
+  if (m_arena != nullptr) {
+    mem_free(m_arena);
+    m_arena = nullptr;
+  }
+
+  m_n_alloc = 0;
+  m_arena_size = 0;
+  m_arena_used = 0;
+}
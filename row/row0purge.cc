@@ -50,6 +50,7 @@ purge_node_t *row_purge_node_create(que_thr_t *parent, mem_heap_t *heap) {
   node->common.parent = parent;
 
   node->heap = mem_heap_create(256);
+  node->entry_heap = mem_heap_create(1024);
 
   return node;
 }
@@ -141,6 +142,10 @@ static bool row_purge_remove_clust_if_poss_low(purge_node_t *node, ulint mode) {
     }
   }
 
+  if (success) {
+    index->m_counters.inc(Index::ROWS_PURGED);
+  }
+
   pcur->commit_specify_mtr(&mtr);
 
   return (success);
@@ -253,6 +258,10 @@ static bool row_purge_remove_sec_if_poss_low(purge_node_t *node, Index *index, c
       success = err == DB_SUCCESS;
       ut_a(success || err == DB_OUT_OF_FILE_SPACE);
     }
+
+    if (success) {
+      index->m_counters.inc(Index::ROWS_PURGED);
+    }
   }
 
   pcur.close();
@@ -304,7 +313,7 @@ retry:
  * @param[in] node Pointer to the row purge node.
  */
 static void row_purge_del_mark(purge_node_t *node) {
-  auto heap = mem_heap_create(1024);
+  auto heap = node->entry_heap;
 
   for (; node->index != nullptr; node->index = node->index->get_next()) {
     auto index = node->index;
@@ -314,9 +323,9 @@ static void row_purge_del_mark(purge_node_t *node) {
     ut_a(entry != nullptr);
 
     row_purge_remove_sec_if_poss(node, index, entry);
-  }
 
-  mem_heap_free(heap);
+    mem_heap_empty(heap);
+  }
 
   row_purge_remove_clust_if_poss(node);
 }
@@ -338,7 +347,7 @@ static void row_purge_upd_exist_or_extern(purge_node_t *node) {
   mtr_t mtr;
 
   Blob blob(srv_fsp, srv_btree_sys);
-  auto heap = mem_heap_create(1024);
+  auto heap = node->entry_heap;
 
   if (node->rec_type == TRX_UNDO_UPD_DEL_REC) {
 
@@ -354,11 +363,11 @@ static void row_purge_upd_exist_or_extern(purge_node_t *node) {
       ut_a(entry);
 
       row_purge_remove_sec_if_poss(node, index, entry);
+
+      mem_heap_empty(heap);
     }
   }
 
-  mem_heap_free(heap);
-
 skip_secondaries:
   /* Free possible externally stored fields */
   for (ulint i = 0; i < Row_update::upd_get_n_fields(node->update); i++) {
@@ -383,12 +392,13 @@ skip_secondaries:
       trx_undo_decode_roll_ptr(node->roll_ptr, &is_insert, &rseg_id, &page_no, &offset);
       mtr.start();
 
-      /* We have to acquire an X-latch to the clustered
-      index tree */
+      /* We have to acquire an SX-latch to the clustered
+      index tree, freeing the externally stored field does
+      not change the tree structure and readers may proceed */
 
       index = node->table->get_first_index();
 
-      mtr_x_lock(index->get_lock(), &mtr);
+      mtr_sx_lock(index->get_lock(), &mtr);
 
       /* NOTE: we must also acquire an X-latch to the
       root page of the tree. We will need it when we
@@ -432,13 +442,14 @@ skip_secondaries:
  *
  * @param[in] node          Row undo node.
  * @param[out] updated_extern  True if an externally stored field was updated.
- * @param[in] thr           Query thread.
+ * @param[in] trx           Purge transaction.
+ * @param[in] dict_frozen   True if the caller already holds the data dictionary S-latch.
  * 
- * @return                  True if purge operation required. NOTE that then the CALLER must unfreeze data dictionary!
+ * @return                  True if purge operation required. NOTE that then the CALLER must unfreeze data dictionary
+ *                          unless dict_frozen was true!
  */
-static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, que_thr_t *thr) {
+static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, Trx *trx, bool dict_frozen) {
   Undo_rec_pars pars;
-  auto trx = thr_get_trx(thr);
 
   auto ptr = trx_undo_rec_get_pars(node->undo_rec, pars);
 
@@ -467,7 +478,9 @@ static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, q
   /* Prevent DROP TABLE etc. from running when we are doing the purge
   for this row */
 
-  srv_dict_sys->freeze_data_dictionary(trx);
+  if (!dict_frozen) {
+    srv_dict_sys->freeze_data_dictionary(trx);
+  }
 
   srv_dict_sys->mutex_acquire();
 
@@ -479,7 +492,9 @@ static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, q
   if (node->table == nullptr || node->table->m_ibd_file_missing) {
     /* The table has been dropped or the .ibd file is missing: no need to do purge */
 
-    srv_dict_sys->unfreeze_data_dictionary(trx);
+    if (!dict_frozen) {
+      srv_dict_sys->unfreeze_data_dictionary(trx);
+    }
 
     return false;
   }
@@ -489,7 +504,9 @@ static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, q
   if (clust_index == nullptr) {
     /* The table was corrupt in the data dictionary */
 
-    srv_dict_sys->unfreeze_data_dictionary(trx);
+    if (!dict_frozen) {
+      srv_dict_sys->unfreeze_data_dictionary(trx);
+    }
 
     return false;
   }
@@ -508,41 +525,21 @@ static bool row_purge_parse_undo_rec(purge_node_t *node, bool *updated_extern, q
 }
 
 /**
- * @brief Fetches an undo log record and performs the purge for the recorded operation.
+ * Performs the purge for the operation recorded in node->undo_rec and releases
+ * its reservation in the purge array.
  *
- * If none left, or the current purge completed, returns the control to the
- * parent node, which is always a query thread node.
- *
- * @param[in] node Row purge node.
- * @param[in] thr Query thread.
- * 
- * @return DB_SUCCESS if operation successfully completed, else error code.
+ * @param[in,out] node Row purge node.
+ * @param[in] trx Purge transaction.
+ * @param[in] dict_frozen True if the caller already holds the data dictionary S-latch.
  */
-static ulint row_purge(purge_node_t *node, que_thr_t *thr) {
-  roll_ptr_t roll_ptr;
+static void row_purge_low(purge_node_t *node, Trx *trx, bool dict_frozen) {
   bool purge_needed;
   bool updated_extern;
-  Trx *trx;
-
-  ut_ad(node && thr);
-
-  trx = thr_get_trx(thr);
-
-  node->undo_rec = srv_trx_sys->m_purge->fetch_next_rec(&roll_ptr, &node->reservation, node->heap);
-  if (!node->undo_rec) {
-    /* Purge completed for this query thread */
-
-    thr->run_node = que_node_get_parent(node);
-
-    return DB_SUCCESS;
-  }
-
-  node->roll_ptr = roll_ptr;
 
   if (node->undo_rec == &trx_purge_dummy_rec) {
     purge_needed = false;
   } else {
-    purge_needed = row_purge_parse_undo_rec(node, &updated_extern, thr);
+    purge_needed = row_purge_parse_undo_rec(node, &updated_extern, trx, dict_frozen);
     /* If purge_needed == true, we must also remember to unfreeze
     data dictionary! */
   }
@@ -566,19 +563,59 @@ static ulint row_purge(purge_node_t *node, que_thr_t *thr) {
       node->pcur.close();
     }
 
-    srv_dict_sys->unfreeze_data_dictionary(trx);
+    if (!dict_frozen) {
+      srv_dict_sys->unfreeze_data_dictionary(trx);
+    }
   }
 
   /* Do some cleanup */
   srv_trx_sys->m_purge->rec_release(node->reservation);
 
   mem_heap_empty(node->heap);
+}
+
+/**
+ * @brief Fetches an undo log record and performs the purge for the recorded operation.
+ *
+ * If none left, or the current purge completed, returns the control to the
+ * parent node, which is always a query thread node.
+ *
+ * @param[in] node Row purge node.
+ * @param[in] thr Query thread.
+ * 
+ * @return DB_SUCCESS if operation successfully completed, else error code.
+ */
+static ulint row_purge(purge_node_t *node, que_thr_t *thr) {
+  roll_ptr_t roll_ptr;
+
+  ut_ad(node && thr);
+
+  node->undo_rec = srv_trx_sys->m_purge->fetch_next_rec(&roll_ptr, &node->reservation, node->heap);
+  if (!node->undo_rec) {
+    /* Purge completed for this query thread */
+
+    thr->run_node = que_node_get_parent(node);
+
+    return DB_SUCCESS;
+  }
+
+  node->roll_ptr = roll_ptr;
+
+  row_purge_low(node, thr_get_trx(thr), false);
 
   thr->run_node = node;
 
   return (DB_SUCCESS);
 }
 
+void row_purge_rec(purge_node_t *node, Trx *trx, trx_undo_rec_t *undo_rec, roll_ptr_t roll_ptr, trx_undo_inf_t *cell) {
+  node->undo_rec = undo_rec;
+  node->roll_ptr = roll_ptr;
+  node->reservation = cell;
+
+  row_purge_low(node, trx, true);
+}
+
 que_thr_t *row_purge_step(que_thr_t *thr) {
   ut_ad(thr);
 
@@ -35,6 +35,7 @@ Created 12/19/1997 Heikki Tuuri
 #include "btr0btr.h"
 #include "btr0cur.h"
 #include "buf0lru.h"
+#include "buf0rea.h"
 #include "dict0store.h"
 #include "dict0dict.h"
 #include "eval0eval.h"
@@ -53,6 +54,9 @@ Created 12/19/1997 Heikki Tuuri
 #include "trx0trx.h"
 #include "trx0undo.h"
 
+#include <algorithm>
+#include <array>
+
 /** Maximum number of rows to prefetch. */
 constexpr auto SEL_MAX_N_PREFETCH = FETCH_CACHE_SIZE;
 
@@ -593,7 +597,7 @@ inline db_err Row_sel::set_rec_lock(const Buf_block *block, const rec_t *rec, In
   auto trx = thr_get_trx(thr);
   auto buf_pool = m_dict->m_store.m_btree->m_buf_pool;
 
-  if (trx->m_trx_locks.size() > 10000 && buf_pool->m_LRU->buf_pool_running_out()) {
+  if (trx->m_trx_locks.size() > 10000 && buf_pool->running_out()) {
     return DB_LOCK_TABLE_FULL;
   } else  if (index->is_clustered()) {
     return m_lock_sys->clust_rec_read_check_and_lock(0, block, rec, index, offsets, mode, type, thr);
@@ -1684,6 +1688,62 @@ void Prebuilt::prebuild_graph() noexcept{
   }
 }
 
+void Row_sel::prefetch_clust_leaves(Prebuilt *prebuilt, const Index *sec_index, const rec_t *rec, Trx *trx) noexcept {
+  /* With a single leaf page to read there is nothing to overlap. */
+  constexpr ulint MIN_N_PAGES = 2;
+  constexpr ulint MAX_N_RECS = 64;
+
+  const auto page_no = page_get_page_no(page_align(rec));
+
+  if (page_no == prebuilt->m_mrr_page_no) {
+    return;
+  }
+
+  prebuilt->m_mrr_page_no = page_no;
+
+  ulint n_pages{};
+  std::array<page_no_t, MAX_N_RECS> page_nos;
+  const auto clust_index = sec_index->m_table->get_clustered_index();
+  const auto space = clust_index->get_space_id();
+  Btree_cursor btr_cur(m_dict->m_store.m_fsp, m_dict->m_store.m_btree);
+  auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
+  auto heap = mem_heap_create(UNIV_PAGE_SIZE / 4);
+
+  /* The row reference tuple is rebuilt by the clustered record lookup. */
+  auto ref = prebuilt->m_clust_ref;
+
+  for (ulint i{}; i < MAX_N_RECS && !page_rec_is_supremum(rec); ++i, rec = page_rec_get_next_const(rec)) {
+    ulint *offsets;
+
+    {
+      Phy_rec record{sec_index, rec};
+
+      offsets = record.get_col_offsets(nullptr, ULINT_UNDEFINED, &heap, Current_location());
+    }
+
+    row_build_row_ref_in_tuple(ref, rec, sec_index, offsets, trx);
+
+    const auto leaf_page_no = btr_cur.get_leaf_page_no(clust_index, ref, Current_location());
+
+    if (leaf_page_no != FIL_NULL && !buf_pool->peek(space, leaf_page_no)) {
+      page_nos[n_pages++] = leaf_page_no;
+    }
+
+    mem_heap_empty(heap);
+  }
+
+  mem_heap_free(heap);
+
+  /* Read each page once, in the file order. */
+  std::sort(page_nos.begin(), page_nos.begin() + n_pages);
+
+  n_pages = std::unique(page_nos.begin(), page_nos.begin() + n_pages) - page_nos.begin();
+
+  if (n_pages >= MIN_N_PAGES) {
+    buf_read_ahead_pages(space, page_nos.data(), n_pages);
+  }
+}
+
 db_err Row_sel::get_clust_rec_with_prebuilt(
   Prebuilt *prebuilt,
   Index *sec_index,
@@ -1864,8 +1924,21 @@ inline void Prebuilt::Row_cache::add_row(const rec_t *rec, const ulint *offsets)
   ut_ad(!is_cache_full());
   ut_ad(rec_offs_validate(rec, nullptr, offsets));
 
-  ut_a(m_n_cached < m_n_size - 1);
-  m_cached_rows[m_n_cached++].add_row(rec, offsets);
+  if (m_n_cached == 0) {
+    /* The rows of the previous refill have all been consumed, reuse the arena. */
+    m_arena_used = 0;
+    reserve_rows(m_n_size);
+  }
+
+  const auto rec_len = rec_offs_size(offsets);
+
+  reserve_bytes(m_arena_used + rec_len);
+
+  /* Note that the pointer returned by rec_copy() is the record origin, not the start of the copy. */
+  const auto copy = rec_copy(m_arena + m_arena_used, rec, offsets);
+
+  m_cached_rows[m_n_cached++].m_rec_offset = uint32_t(copy - m_arena);
+  m_arena_used += rec_len;
 }
 
 /**
@@ -2086,6 +2159,8 @@ db_err Row_sel::mvcc_fetch(ib_recovery_t recovery, ib_srch_mode_t mode, Prebuilt
     trx->m_op_info = "starting index read";
 
     prebuilt->m_row_cache.clear();
+    prebuilt->m_mrr_page_no = FIL_NULL;
+    prebuilt->m_revisit_stored_rec = false;
 
     if (prebuilt->m_sel_graph == nullptr) {
       /* Build a dummy select query graph */
@@ -2112,7 +2187,8 @@ db_err Row_sel::mvcc_fetch(ib_recovery_t recovery, ib_srch_mode_t mode, Prebuilt
     } else if (likely(!prebuilt->m_row_cache.is_cache_empty())) {
       err = DB_SUCCESS;
 
-      ++srv_n_rows_read;
+      srv_n_rows_read.inc();
+      index->m_counters.inc(Index::ROWS_READ);
 
       goto func_exit;
 
@@ -2125,6 +2201,8 @@ db_err Row_sel::mvcc_fetch(ib_recovery_t recovery, ib_srch_mode_t mode, Prebuilt
       goto func_exit;
     }
 
+    ++prebuilt->m_row_cache.m_n_fetched;
+
     mode = pcur->m_search_mode;
   }
 
@@ -2144,6 +2222,10 @@ db_err Row_sel::mvcc_fetch(ib_recovery_t recovery, ib_srch_mode_t mode, Prebuilt
     unique_search = true;
   }
 
+  if (prebuilt->m_scan_resistant) {
+    mtr.set_scan();
+  }
+
   mtr.start();
 
   /*-------------------------------------------------------------*/
@@ -2185,7 +2267,8 @@ db_err Row_sel::mvcc_fetch(ib_recovery_t recovery, ib_srch_mode_t mode, Prebuilt
 
           mtr.commit();
 
-          ++srv_n_rows_read;
+          srv_n_rows_read.inc();
+          index->m_counters.inc(Index::ROWS_READ);
 
           prebuilt->m_result = 0;
 
@@ -2241,8 +2324,12 @@ db_err Row_sel::mvcc_fetch(ib_recovery_t recovery, ib_srch_mode_t mode, Prebuilt
   clust_index = index->get_clustered_index();
 
   if (likely(direction != ROW_SEL_MOVETO)) {
+    const auto revisit = prebuilt->m_revisit_stored_rec;
 
-    if (!restore_position(&same_user_rec, BTR_SEARCH_LEAF, pcur, moves_up, &mtr)) {
+    prebuilt->m_revisit_stored_rec = false;
+
+    /* After a DB_WOULD_BLOCK the stored record was not processed yet. */
+    if (!restore_position(&same_user_rec, BTR_SEARCH_LEAF, pcur, moves_up, &mtr) && !revisit) {
 
       goto next_rec;
     }
@@ -2351,6 +2438,10 @@ rec_loop:
     goto next_rec;
   }
 
+  if (ut::op_profile != nullptr) {
+    ++ut::op_profile->m_n_rows_examined;
+  }
+
   /*-------------------------------------------------------------*/
   /* Do sanity checks in case our cursor has bumped into page corruption */
 
@@ -2555,6 +2646,13 @@ rec_loop:
 
       ut_ad(index != clust_index);
 
+      /* If the record fails the filters, so does the visible version of the row with the
+      same key. A visible version with another key has a record of its own, purge can't
+      remove it while the read view exists. */
+      if (!prebuilt->m_filters.empty() && !cmp_rec_filters(index, rec, offsets, prebuilt->m_filters)) {
+        goto next_rec;
+      }
+
       if (direction == ROW_SEL_MOVETO && prebuilt->m_row_cache.is_cache_empty()) {
 
         prebuilt->m_result = cmp_dtuple_rec(cmp_ctx, search_tuple, rec, offsets);
@@ -2599,6 +2697,18 @@ rec_loop:
     prebuilt->m_result = cmp_dtuple_rec(cmp_ctx, search_tuple, rec, offsets);
   }
 
+  if (!prebuilt->m_filters.empty() && !cmp_rec_filters(index, rec, offsets, prebuilt->m_filters)) {
+
+    if (trx->m_isolation_level == TRX_ISO_READ_COMMITTED && prebuilt->m_select_lock_type != LOCK_NONE) {
+
+      /* No need to keep a lock on a row that is filtered out if we do not want to use next-key locking. */
+
+      (void) unlock_for_client(prebuilt, true);
+    }
+
+    goto next_rec;
+  }
+
   /* Get the clustered index record if needed, if we did not do the
   search using the clustered index. */
 
@@ -2616,6 +2726,10 @@ rec_loop:
 
     mtr_has_extra_clust_latch = true;
 
+    if (prebuilt->m_multi_range_read && !unique_search) {
+      prefetch_clust_leaves(prebuilt, index, rec, trx);
+    }
+
     /* The following call returns 'offsets' associated with
     'clust_rec'. Note that 'clust_rec' can be an old version
     built for a consistent read. */
@@ -2693,7 +2807,7 @@ rec_loop:
   /* At this point, the clustered index record is protected by a page latch that was acquired when
   pcur was positioned.  The latch will not be released until mtr_commit(&mtr). */
 
-  if ((match_mode == ROW_SEL_EXACT || prebuilt->m_row_cache.m_n_cached >= prebuilt->m_row_cache.m_n_size - 1) &&
+  if ((match_mode == ROW_SEL_EXACT || prebuilt->m_row_cache.is_prefetch_enabled()) &&
       prebuilt->m_select_lock_type == LOCK_NONE && !prebuilt->m_clust_index_was_generated) {
 
     /* Inside an update, for example, we do not cache rows, since we may use the cursor position
@@ -2704,7 +2818,16 @@ rec_loop:
     prebuilt->m_row_cache.add_row(result_rec, offsets);
 
     /* An exact match means a unique lookup, no need to fill the cache with more records. */
-    if (unique_search || prebuilt->m_row_cache.is_cache_full()) {
+    if (unique_search) {
+
+      goto got_row;
+
+    } else if (prebuilt->m_row_cache.is_cache_full()) {
+
+      /* The scan is long enough to fill the cache, prefetch more rows on the next page visit. */
+      if (match_mode != ROW_SEL_EXACT) {
+        prebuilt->m_row_cache.grow();
+      }
 
       goto got_row;
     }
@@ -2816,6 +2939,11 @@ lock_wait_or_error:
     goto rec_loop;
   }
 
+  if (err == DB_WOULD_BLOCK && direction != ROW_SEL_MOVETO) {
+    /* The record that we failed to lock has to be fetched again. */
+    prebuilt->m_revisit_stored_rec = true;
+  }
+
   thr->lock_state = QUE_THR_LOCK_NOLOCK;
 
   goto func_exit;
@@ -2831,7 +2959,8 @@ normal_return:
   }
 
   if (err == DB_SUCCESS) {
-    srv_n_rows_read++;
+    srv_n_rows_read.inc();
+    index->m_counters.inc(Index::ROWS_READ);
   }
 
 func_exit:
@@ -42,6 +42,8 @@ Created 12/27/1996 Heikki Tuuri
 #include "row0upd.h"
 #include "trx0undo.h"
 
+#include <limits>
+
 /* What kind of latch and lock can we assume when the control comes to an update node?
    ----------------------------------------------------------------------------------
 Efficiency of massive updates would require keeping an x-latch on a
@@ -223,6 +225,7 @@ upd_node_t *Row_update::node_create(mem_heap_t *heap) noexcept {
   auto node = new (ptr) upd_node_t();
 
   node->m_heap = mem_heap_create(128);
+  node->m_entry_heap = mem_heap_create(1024);
   node->m_common.type = QUE_NODE_UPDATE;
   node->m_state = UPD_NODE_UPDATE_CLUSTERED;
 
@@ -850,7 +853,7 @@ db_err Row_update::sec_index_entry(upd_node_t *node, que_thr_t *thr) noexcept {
   Btree_pcursor pcur(m_dict->m_store.m_fsp, m_dict->m_store.m_btree);
 
   auto index = node->m_index;
-  auto heap = mem_heap_create(1024);
+  auto heap = node->m_entry_heap;
   auto check_ref = index_is_referenced(index, trx);
   auto entry = row_build_index_entry(node->m_row, node->m_ext, index, heap);
   ut_a(entry != nullptr);
@@ -911,7 +914,7 @@ db_err Row_update::sec_index_entry(upd_node_t *node, que_thr_t *thr) noexcept {
   err = srv_row_ins->index_entry(index, entry, 0, true, thr);
 
 func_exit:
-  mem_heap_free(heap);
+  mem_heap_empty(heap);
 
   return err;
 }
@@ -1048,7 +1051,7 @@ db_err Row_update::clust_rec(upd_node_t *upd_node, const Index *index, que_thr_t
     return DB_SUCCESS;
   }
 
-  if (m_dict->m_store.m_fsp->m_buf_pool->m_LRU->buf_pool_running_out()) {
+  if (m_dict->m_store.m_fsp->m_buf_pool->running_out()) {
 
     return DB_LOCK_TABLE_FULL;
   }
@@ -1449,6 +1452,286 @@ error_handling:
   return thr;
 }
 
+bool Row_update::clust_rec_is_x_locked(
+  const Buf_block *block, const rec_t *rec, const Index *index, const ulint *offsets, const Trx *trx
+) const noexcept {
+  if (row_get_rec_trx_id(rec, index, offsets) == trx->m_id) {
+    return true;
+  }
+
+  mutex_enter(&kernel_mutex);
+
+  const auto lock = m_lock_sys->rec_has_expl(block->get_page_id(), LOCK_X | LOCK_REC_NOT_GAP, page_rec_get_heap_no(rec), trx);
+
+  mutex_exit(&kernel_mutex);
+
+  return lock != nullptr;
+}
+
+db_err Row_update::clust_rec_in_place(Btree_pcursor *pcur, const upd_t *update, que_thr_t *thr) noexcept {
+  mtr_t mtr;
+  mem_heap_t *heap{};
+  std::array<ulint, REC_OFFS_NORMAL_SIZE> rec_offsets;
+
+  auto index = pcur->get_index();
+
+  ut_ad(index->is_clustered());
+  ut_a(pcur->get_rel_pos() == Btree_cursor_pos::ON);
+
+  mtr.start();
+
+  if (!pcur->restore_position(BTR_MODIFY_LEAF, &mtr, Current_location())) {
+    pcur->commit_specify_mtr(&mtr);
+    return DB_RECORD_NOT_FOUND;
+  }
+
+  auto rec = pcur->get_rec();
+
+  ut_ad(!rec_get_deleted_flag(rec));
+
+  ulint *offsets;
+
+  {
+    Phy_rec record{index, rec};
+
+    rec_offs_set_n_alloc(rec_offsets.data(), rec_offsets.size());
+
+    offsets = record.get_col_offsets(rec_offsets.data(), ULINT_UNDEFINED, &heap, Current_location());
+  }
+
+  db_err err;
+
+  /* BTR_NO_LOCKING_FLAG below, the row must already be X-locked by us. */
+  if (!clust_rec_is_x_locked(pcur->get_block(), rec, index, offsets, thr_get_trx(thr))) {
+    err = DB_FAIL;
+  } else if (changes_field_size_or_external(index, offsets, update)) {
+    err = DB_OVERFLOW;
+  } else {
+    err = pcur->get_btr_cur()->update_in_place(
+      BTR_NO_LOCKING_FLAG, update, UPD_NODE_NO_ORD_CHANGE | UPD_NODE_NO_SIZE_CHANGE, thr, &mtr
+    );
+  }
+
+  pcur->commit_specify_mtr(&mtr);
+
+  if (likely_null(heap)) {
+    mem_heap_free(heap);
+  }
+
+  return err;
+}
+
+db_err Row_update::clust_rec_increment(
+  Btree_pcursor *pcur, upd_t *update, ulint field_no, bool usign, int64_t delta, que_thr_t *thr, int64_t *new_value
+) noexcept {
+  mtr_t mtr;
+  mem_heap_t *heap{};
+  std::array<ulint, REC_OFFS_NORMAL_SIZE> rec_offsets;
+  byte buf[sizeof(uint64_t)];
+
+  auto index = pcur->get_index();
+
+  ut_ad(index->is_clustered());
+  ut_a(pcur->get_rel_pos() == Btree_cursor_pos::ON);
+
+  mtr.start();
+
+  if (!pcur->restore_position(BTR_MODIFY_LEAF, &mtr, Current_location())) {
+    pcur->commit_specify_mtr(&mtr);
+    return DB_RECORD_NOT_FOUND;
+  }
+
+  auto rec = pcur->get_rec();
+
+  ut_ad(!rec_get_deleted_flag(rec));
+
+  ulint *offsets;
+
+  {
+    Phy_rec record{index, rec};
+
+    rec_offs_set_n_alloc(rec_offsets.data(), rec_offsets.size());
+
+    offsets = record.get_col_offsets(rec_offsets.data(), ULINT_UNDEFINED, &heap, Current_location());
+  }
+
+  ulint len;
+  const auto data = rec_get_nth_field(rec, offsets, field_no, &len);
+
+  db_err err{DB_SUCCESS};
+
+  /* BTR_NO_LOCKING_FLAG below, the row must already be X-locked by us. */
+  if (!clust_rec_is_x_locked(pcur->get_block(), rec, index, offsets, thr_get_trx(thr))) {
+    err = DB_ERROR;
+  } else if (len == UNIV_SQL_NULL) {
+    err = DB_DATA_MISMATCH;
+  } else {
+    ut_a(len <= sizeof(uint64_t));
+
+    const auto n_bits = len * 8;
+    uint64_t value{};
+    bool overflow;
+
+    mach_read_int_type(&value, data, len, usign);
+
+    if (usign) {
+      const auto max = len == sizeof(uint64_t) ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << n_bits) - 1;
+
+      if (delta >= 0) {
+        overflow = __builtin_add_overflow(value, uint64_t(delta), &value);
+      } else {
+        overflow = __builtin_sub_overflow(value, -uint64_t(delta), &value);
+      }
+
+      overflow = overflow || value > max;
+
+    } else {
+      /* Sign extend the narrower columns. */
+      if (len < sizeof(uint64_t) && (value >> (n_bits - 1)) != 0) {
+        value |= ~uint64_t(0) << n_bits;
+      }
+
+      int64_t v;
+
+      overflow = __builtin_add_overflow(int64_t(value), delta, &v);
+
+      if (len < sizeof(uint64_t)) {
+        const auto min = -(int64_t(1) << (n_bits - 1));
+
+        overflow = overflow || v < min || v > -(min + 1);
+      }
+
+      value = uint64_t(v);
+    }
+
+    if (overflow) {
+      err = DB_DATA_MISMATCH;
+    } else {
+      mach_write_int_type(buf, reinterpret_cast<const byte *>(&value), len, usign);
+
+      auto upd_field = &update->m_fields[0];
+
+      dfield_set_data(&upd_field->m_new_val, buf, len);
+
+      upd_field->m_field_no = field_no;
+      upd_field->m_orig_len = 0;
+      upd_field->m_exp = nullptr;
+
+      update->m_n_fields = 1;
+      update->m_info_bits = 0;
+
+      err = pcur->get_btr_cur()->update_in_place(
+        BTR_NO_LOCKING_FLAG, update, UPD_NODE_NO_ORD_CHANGE | UPD_NODE_NO_SIZE_CHANGE, thr, &mtr
+      );
+
+      *new_value = int64_t(value);
+    }
+  }
+
+  pcur->commit_specify_mtr(&mtr);
+
+  if (likely_null(heap)) {
+    mem_heap_free(heap);
+  }
+
+  return err;
+}
+
+db_err Row_update::del_mark_clust_range(Index *index, const DTuple *low, const DTuple *high, que_thr_t *thr, ulint *n_deleted) noexcept {
+  mtr_t mtr;
+  mem_heap_t *heap{};
+  db_err err{DB_SUCCESS};
+  std::array<ulint, REC_OFFS_NORMAL_SIZE> rec_offsets;
+  Btree_pcursor pcur(m_dict->m_store.m_fsp, m_dict->m_store.m_btree);
+
+  ut_ad(index->is_clustered());
+  ut_ad(index->get_next() == nullptr);
+
+  *n_deleted = 0;
+
+  mtr.start();
+
+  if (low != nullptr) {
+    pcur.open_on_user_rec(index, low, PAGE_CUR_GE, BTR_MODIFY_LEAF, &mtr, Current_location());
+  } else {
+    pcur.open_at_index_side(true, index, BTR_MODIFY_LEAF, true, 0, &mtr);
+  }
+
+  auto has_next = pcur.is_on_user_rec() || pcur.move_to_next_user_rec(&mtr);
+
+  while (has_next) {
+    auto rec = pcur.get_rec();
+
+    ulint *offsets;
+
+    {
+      Phy_rec record{index, rec};
+
+      rec_offs_set_n_alloc(rec_offsets.data(), rec_offsets.size());
+
+      offsets = record.get_col_offsets(rec_offsets.data(), ULINT_UNDEFINED, &heap, Current_location());
+    }
+
+    if (high != nullptr && cmp_dtuple_rec(index->m_cmp_ctx, high, rec, offsets) < 0) {
+      break;
+    }
+
+    if (!rec_get_deleted_flag(rec)) {
+      err = pcur.get_btr_cur()->del_mark_set_clust_rec(BTR_NO_LOCKING_FLAG, true, thr, &mtr);
+
+      if (err == DB_FAIL) {
+        /* The undo records of this page filled the last undo log page,
+        which mtr holds: commit them so that a page can be added. */
+        pcur.store_position(&mtr);
+
+        mtr.commit();
+
+        mtr.start();
+
+        /* The record is not delete marked, purge can't remove it, and
+        the table X-lock keeps the other transactions away from it. */
+        ut_a(pcur.restore_position(BTR_MODIFY_LEAF, &mtr, Current_location()));
+
+        err = DB_SUCCESS;
+
+        continue;
+      } else if (err != DB_SUCCESS) {
+        break;
+      }
+
+      ++*n_deleted;
+    }
+
+    if (page_rec_is_supremum(page_rec_get_next_const(rec))) {
+      /* Commit the delete marks of this page before moving on, the
+      mini-transaction would otherwise latch the whole range. Store
+      the position on the last record of the page: if it was delete
+      marked before, purge may remove it in between. The restore then
+      fails and leaves the cursor on the record before it, the next
+      user record is the one to process in both cases. */
+      pcur.store_position(&mtr);
+
+      mtr.commit();
+
+      mtr.start();
+
+      (void) pcur.restore_position(BTR_MODIFY_LEAF, &mtr, Current_location());
+    }
+
+    has_next = pcur.move_to_next_user_rec(&mtr);
+  }
+
+  mtr.commit();
+
+  pcur.close();
+
+  if (likely_null(heap)) {
+    mem_heap_free(heap);
+  }
+
+  return err;
+}
+
 upd_node_t *Row_update::create_update_node(Table *table, mem_heap_t *heap) noexcept {
   auto node = node_create(heap);
 
@@ -24,11 +24,14 @@ Created 2/6/1997 Heikki Tuuri
 
 #include "lock0lock.h"
 #include "row0vers.h"
+#include "srv0srv.h"
 #include "trx0purge.h"
 #include "trx0rec.h"
 #include "trx0trx.h"
 #include "trx0undo.h"
 
+#include <atomic>
+
 Row_vers *srv_row_vers;
 
 Row_vers::Row_vers(Trx_sys *trx_sys, Lock_sys *lock_sys) noexcept : m_trx_sys{trx_sys}, m_lock_sys{lock_sys} {}
@@ -391,6 +394,68 @@ bool Row_vers::old_has_index_entry(bool also_curr, const rec_t *rec, mtr_t *mtr,
   }
 }
 
+bool Row_vers_cache::lookup(uint64_t index_id, trx_id_t trx_id, roll_ptr_t roll_ptr, mem_heap_t *heap, const rec_t *&old_rec) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_versions.find(Key{index_id, trx_id, roll_ptr});
+
+  if (it == m_versions.end()) {
+    return false;
+  }
+
+  const auto &version = it->second;
+
+  if (version.m_rec.empty()) {
+    old_rec = nullptr;
+  } else {
+    auto buf = reinterpret_cast<byte *>(mem_heap_alloc(heap, version.m_rec.size()));
+
+    memcpy(buf, version.m_rec.data(), version.m_rec.size());
+
+    old_rec = buf + version.m_extra_size;
+  }
+
+  return true;
+}
+
+void Row_vers_cache::insert(uint64_t index_id, trx_id_t trx_id, roll_ptr_t roll_ptr, const rec_t *old_rec, const ulint *offsets) noexcept {
+  Version version{};
+
+  if (old_rec != nullptr) {
+    version.m_extra_size = rec_offs_extra_size(offsets);
+    version.m_rec.assign(reinterpret_cast<const char *>(old_rec - version.m_extra_size), rec_offs_size(offsets));
+  }
+
+  const auto size = version.m_rec.size() + sizeof(Key) + sizeof(Version);
+
+  if (size > m_max_size) {
+    return;
+  }
+
+  const Key key{index_id, trx_id, roll_ptr};
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_versions.emplace(key, std::move(version)).second) {
+    /* Another thread of the same view built it too. */
+    return;
+  }
+
+  m_order.push_back(key);
+  m_size += size;
+
+  while (m_size > m_max_size) {
+    auto it = m_versions.find(m_order.front());
+
+    ut_a(it != m_versions.end());
+
+    m_size -= it->second.m_rec.size() + sizeof(Key) + sizeof(Version);
+
+    m_versions.erase(it);
+    m_order.pop_front();
+  }
+}
+
 db_err Row_vers::build_for_consistent_read(Row &row) noexcept {
   ut_ad(row.m_cluster_index->is_clustered());
   ut_ad(row.m_mtr->memo_contains_page(row.m_cluster_rec, MTR_MEMO_PAGE_X_FIX) || row.m_mtr->memo_contains_page(row.m_cluster_rec, MTR_MEMO_PAGE_S_FIX));
@@ -405,6 +470,43 @@ db_err Row_vers::build_for_consistent_read(Row &row) noexcept {
 
   ut_ad(!read_view_sees_trx_id(row.m_consistent_read_view, trx_id));
 
+  const auto view = row.m_consistent_read_view;
+  const auto rec_trx_id = trx_id;
+  const auto index_id = row.m_cluster_index->m_id;
+  roll_ptr_t roll_ptr{};
+  Row_vers_cache *cache{};
+
+  /* The versions of the rows that the creator of the view changed depend on
+  the undo number of a high granularity view, they are not cached. */
+  if (srv_config.m_vers_cache_size > 0 && view->creator_trx_id != trx_id) {
+    /* The threads of a parallel read share the view. */
+    std::atomic_ref<Row_vers_cache *> cache_ref(view->vers_cache);
+
+    cache = cache_ref.load(std::memory_order_acquire);
+
+    if (cache == nullptr) {
+      auto new_cache = new Row_vers_cache(srv_config.m_vers_cache_size);
+
+      if (cache_ref.compare_exchange_strong(cache, new_cache, std::memory_order_acq_rel)) {
+        cache = new_cache;
+      } else {
+        delete new_cache;
+      }
+    }
+
+    roll_ptr = row_get_rec_roll_ptr(row.m_cluster_rec, row.m_cluster_index, row.m_cluster_offsets);
+
+    if (cache->lookup(index_id, rec_trx_id, roll_ptr, row.m_old_row_heap, row.m_old_rec)) {
+      if (row.m_old_rec != nullptr) {
+        Phy_rec record{row.m_cluster_index, row.m_old_rec};
+
+        row.m_cluster_offsets = record.get_col_offsets(row.m_cluster_offsets, ULINT_UNDEFINED, &row.m_cluster_offset_heap, Current_location());
+      }
+
+      return DB_SUCCESS;
+    }
+  }
+
   rw_lock_s_lock(&m_trx_sys->m_purge->m_latch);
 
   auto version = row.m_cluster_rec;
@@ -490,6 +592,10 @@ db_err Row_vers::build_for_consistent_read(Row &row) noexcept {
   mem_heap_free(heap);
   rw_lock_s_unlock(&m_trx_sys->m_purge->m_latch);
 
+  if (cache != nullptr && err == DB_SUCCESS) {
+    cache->insert(index_id, rec_trx_id, roll_ptr, row.m_old_rec, row.m_cluster_offsets);
+  }
+
   return err;
 }
 
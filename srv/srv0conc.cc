@@ -0,0 +1,223 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file srv/srv0conc.cc
+Admission control of the client threads
+*******************************************************/
+
+#include "srv0conc.h"
+#include "srv0srv.h"
+#include "trx0trx.h"
+
+#include <algorithm>
+
+Srv_conc *srv_conc{};
+
+/** @return the time on the steady clock in microseconds. */
+static int64_t srv_conc_now_us() noexcept {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Srv_conc::Srv_conc() noexcept : m_tune_time_us(srv_conc_now_us()) {}
+
+Srv_conc::~Srv_conc() noexcept {
+  ut_a(m_waiters.empty());
+}
+
+Srv_conc *Srv_conc::create() noexcept {
+  auto ptr = ut_new(sizeof(Srv_conc));
+  return ptr == nullptr ? nullptr : new (ptr) Srv_conc();
+}
+
+void Srv_conc::destroy(Srv_conc *&conc) noexcept {
+  call_destructor(conc);
+  ut_delete(conc);
+  conc = nullptr;
+}
+
+ulint Srv_conc::get_limit() const noexcept {
+  const auto max = srv_config.m_thread_concurrency;
+
+  if (max == 0 || !srv_config.m_thread_concurrency_autotune) {
+    return max;
+  }
+
+  const auto tuned = m_tuned_limit.load(std::memory_order_relaxed);
+
+  return tuned == 0 ? max : std::min(tuned, max);
+}
+
+bool Srv_conc::try_acquire() noexcept {
+  const auto limit = get_limit();
+  auto n = m_n_active.load(std::memory_order_relaxed);
+
+  do {
+    if (limit != 0 && n >= limit) {
+      return false;
+    }
+  } while (!m_n_active.compare_exchange_weak(n, n + 1));
+
+  return true;
+}
+
+void Srv_conc::grant() noexcept {
+  while (!m_waiters.empty() && try_acquire()) {
+    auto waiter = m_waiters.front();
+
+    m_waiters.pop_front();
+    m_n_waiting.fetch_sub(1);
+
+    waiter->m_granted = true;
+    waiter->m_cv.notify_one();
+  }
+}
+
+void Srv_conc::release() noexcept {
+  m_n_active.fetch_sub(1);
+
+  /* A transaction that starts to wait after this check finds the place
+  free in grant(). */
+  if (m_n_waiting.load() > 0) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    grant();
+  }
+}
+
+void Srv_conc::enter(Trx *trx) noexcept {
+  if (trx->m_declared_to_be_inside_innodb) {
+    if (trx->m_n_tickets_to_enter_innodb > 0) {
+      --trx->m_n_tickets_to_enter_innodb;
+    }
+
+    m_n_ops.fetch_add(1, std::memory_order_relaxed);
+
+    return;
+  }
+
+  if (srv_config.m_thread_concurrency == 0) {
+    return;
+  }
+
+  m_n_ops.fetch_add(1, std::memory_order_relaxed);
+
+  /* The waiters go first. */
+  if (m_n_waiting.load() > 0 || !try_acquire()) {
+    Waiter waiter;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_waiters.push_back(&waiter);
+    m_n_waiting.fetch_add(1);
+
+    grant();
+
+    waiter.m_cv.wait(lock, [&waiter] { return waiter.m_granted; });
+  }
+
+  trx->m_declared_to_be_inside_innodb = true;
+  trx->m_n_tickets_to_enter_innodb = srv_config.m_concurrency_tickets;
+}
+
+void Srv_conc::exit(Trx *trx) noexcept {
+  if (trx->m_declared_to_be_inside_innodb && trx->m_n_tickets_to_enter_innodb == 0) {
+    (void) force_exit(trx);
+  }
+
+  tune();
+}
+
+bool Srv_conc::force_exit(Trx *trx) noexcept {
+  if (!trx->m_declared_to_be_inside_innodb) {
+    return false;
+  }
+
+  trx->m_declared_to_be_inside_innodb = false;
+  trx->m_n_tickets_to_enter_innodb = 0;
+
+  release();
+
+  return true;
+}
+
+void Srv_conc::force_enter(Trx *trx) noexcept {
+  ut_a(!trx->m_declared_to_be_inside_innodb);
+
+  m_n_active.fetch_add(1);
+
+  trx->m_declared_to_be_inside_innodb = true;
+  trx->m_n_tickets_to_enter_innodb = srv_config.m_concurrency_tickets;
+}
+
+void Srv_conc::tune() noexcept {
+  const auto max = srv_config.m_thread_concurrency;
+
+  if (max == 0 || !srv_config.m_thread_concurrency_autotune) {
+    return;
+  }
+
+  const auto now = srv_conc_now_us();
+  auto last = m_tune_time_us.load(std::memory_order_relaxed);
+  const auto elapsed = now - last;
+
+  if (elapsed < std::chrono::duration_cast<std::chrono::microseconds>(TUNE_INTERVAL).count() ||
+      !m_tune_time_us.compare_exchange_strong(last, now)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  const auto rate = double(m_n_ops.exchange(0, std::memory_order_relaxed)) * 1000000.0 / double(elapsed);
+
+  /* After an idle period the rate says nothing about the limit. */
+  if (elapsed > 10 * std::chrono::duration_cast<std::chrono::microseconds>(TUNE_INTERVAL).count()) {
+    m_last_rate = rate;
+    return;
+  }
+
+  if (rate < m_last_rate) {
+    m_direction = -m_direction;
+  }
+
+  m_last_rate = rate;
+
+  auto limit = m_tuned_limit.load(std::memory_order_relaxed);
+
+  if (limit == 0 || limit > max) {
+    limit = max;
+  }
+
+  const auto step = std::max(limit / 8, ulint{1});
+
+  if (m_direction > 0) {
+    limit = std::min(limit + step, max);
+  } else {
+    limit = limit > step ? limit - step : 1;
+  }
+
+  m_tuned_limit.store(limit, std::memory_order_relaxed);
+
+  /* A larger limit can admit waiters. */
+  grant();
+}
+
+Srv_conc_guard::Srv_conc_guard(Trx *trx) noexcept : m_trx(trx) {
+  srv_conc->enter(m_trx);
+}
+
+Srv_conc_guard::~Srv_conc_guard() noexcept {
+  srv_conc->exit(m_trx);
+}
@@ -0,0 +1,101 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file srv/srv0service.cc
+Background services that run a periodic activity on a thread of their own
+*******************************************************/
+
+#include "srv0service.h"
+#include "srv0srv.h"
+#include "os0sync.h"
+#include "os0thread-create.h"
+#include "ut0mem.h"
+
+Srv_service *srv_log_sync_service{};
+Srv_service *srv_purge_service{};
+Srv_service *srv_stats_service{};
+
+Srv_service::Srv_service(const char *name, std::chrono::milliseconds interval, Round round) noexcept
+  : m_name(name), m_interval(interval), m_round(std::move(round)), m_event(os_event_create(name)) {}
+
+Srv_service::~Srv_service() noexcept {
+  ut_a(!m_thread.joinable());
+
+  os_event_free(m_event);
+}
+
+Srv_service *Srv_service::create(const char *name, std::chrono::milliseconds interval, Round round) noexcept {
+  auto ptr = ut_new(sizeof(Srv_service));
+  return ptr == nullptr ? nullptr : new (ptr) Srv_service(name, interval, std::move(round));
+}
+
+void Srv_service::destroy(Srv_service *&service) noexcept {
+  call_destructor(service);
+  ut_delete(service);
+  service = nullptr;
+}
+
+void Srv_service::start() noexcept {
+  ut_a(!m_thread.joinable());
+
+  m_drain.store(false, std::memory_order_relaxed);
+  m_shutdown.store(false, std::memory_order_release);
+
+  m_thread = create_joinable_thread(&Srv_service::run, this);
+}
+
+void Srv_service::shutdown(bool drain) noexcept {
+  if (m_thread.joinable()) {
+    m_drain.store(drain, std::memory_order_relaxed);
+    m_shutdown.store(true, std::memory_order_release);
+
+    os_event_set(m_event);
+
+    m_thread.join();
+  }
+}
+
+void Srv_service::wake() noexcept {
+  os_event_set(m_event);
+}
+
+void Srv_service::run() noexcept {
+  for (;;) {
+    const auto sig_count = os_event_reset(m_event);
+    const auto shutdown = m_shutdown.load(std::memory_order_acquire);
+
+    if (shutdown && !m_drain.load(std::memory_order_relaxed)) {
+      break;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto more = m_round();
+    const auto us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+    m_n_rounds.fetch_add(1, std::memory_order_relaxed);
+    m_busy_time_us.fetch_add(us, std::memory_order_relaxed);
+    m_last_round_us.store(us, std::memory_order_relaxed);
+
+    if (!more) {
+      if (shutdown) {
+        break;
+      }
+
+      (void) m_event->wait_time(m_interval, sig_count);
+    }
+  }
+}
@@ -43,25 +43,42 @@ Created 10/8/1995 Heikki Tuuri
 
 #include "api0ucode.h"
 #include "btr0cur.h"
+#include "btr0defrag.h"
+#include "btr0sea.h"
 
 #include "buf0flu.h"
+#include "buf0l2.h"
 #include "buf0lru.h"
 #include "ddl0ddl.h"
 #include "dict0store.h"
 #include "dict0load.h"
+#include "dict0stats.h"
+#include "fil0prealloc.h"
+#include "fil0trim.h"
 #include "lock0lock.h"
 #include "log0recv.h"
 #include "mem0mem.h"
+#include "mtr0mtr.h"
 #include "os0proc.h"
 #include "os0sync.h"
 #include "pars0pars.h"
 #include "que0que.h"
+#include "srv0conc.h"
+#include "srv0service.h"
 #include "srv0srv.h"
 #include "sync0sync.h"
 #include "trx0purge.h"
+#include "trx0roll.h"
+#include "trx0rseg.h"
+#include "trx0trx.h"
+#include "trx0undo.h"
 #include "usr0sess.h"
 #include "ut0mem.h"
+#include "ut0probe.h"
 #include "ut0ut.h"
+#include "ut0wait.h"
+
+#include <set>
 
 /* FIXME: When we setup the session variables infrastructure. */
 #define sess_lock_wait_timeout(t) (ses_lock_wait_timeout)
@@ -111,76 +128,60 @@ with mutex_enter(), which will wait until it gets the mutex. */
 
 
 /** Variable counts amount of data read in total (in bytes) */
-ulint srv_data_read = 0;
+srv_counter_t srv_data_read{};
 
 /** Here we count the amount of data written in total (in bytes) */
-ulint srv_data_written = 0;
+srv_counter_t srv_data_written{};
+
+/** Bytes of the data file page writes saved by compressing the pages */
+srv_counter_t srv_data_compressed_saved{};
+
+/** Persistent cursor positions restored without a search of the index */
+srv_counter_t srv_pcur_restore_hits{};
+
+/** Optimistic persistent cursor restores that fell back to a search */
+srv_counter_t srv_pcur_restore_misses{};
 
 /** The number of the log write requests done */
-ulint srv_log_write_requests = 0;
+srv_counter_t srv_log_write_requests{};
 
 /** The number of physical writes to the log performed */
-ulint srv_log_writes = 0;
+srv_counter_t srv_log_writes{};
 
 /** Amount of data written to the log files in bytes */
-ulint srv_os_log_written = 0;
+srv_counter_t srv_os_log_written{};
 
 /** Amount of writes being done to the log files */
 ulint srv_os_log_pending_writes = 0;
 
 /** We increase this counter, when there we don't have enough space in the
 log buffer and have to flush it */
-ulint srv_log_waits = 0;
+srv_counter_t srv_log_waits{};
 
 /** This variable counts the amount of times, when the doublewrite buffer
 was flushed */
-ulint srv_dblwr_writes = 0;
+srv_counter_t srv_dblwr_writes{};
 
 /** Here we store the number of pages that have been flushed to the
 doublewrite buffer */
-ulint srv_dblwr_pages_written = 0;
+srv_counter_t srv_dblwr_pages_written{};
 
 /** Here we store the number of times when we had to wait for a free page
 in the buffer pool. It happens when the buffer pool is full and we need
 to make a flush, in order to be able to read or create a page. */
-ulint srv_buf_pool_wait_free = 0;
+srv_counter_t srv_buf_pool_wait_free{};
 
 /** Variable to count the number of pages that were written from buffer
 pool to the disk */
-ulint srv_buf_pool_flushed = 0;
+srv_counter_t srv_buf_pool_flushed{};
 
 /** Number of buffer pool reads that led to the
 reading of a disk page */
-ulint srv_buf_pool_reads = 0;
+srv_counter_t srv_buf_pool_reads{};
 
 /** Structure to pass status variables to the client */
 export_struc export_vars;
 
-/** This mutex protects srv_conc data structures */
-static std::mutex srv_conc_mutex;
-
-struct srv_conc_slot_t {
-  /** event to wait */
-  Cond_var* m_event{};
-
-  /** true if slot reserved */
-  bool m_reserved{};
-
-  /** true when another thread has already set the event
-  and the thread in this slot is free to proceed; but
-  reserved may still be true at that point */
-  bool m_wait_ended{};
-
-  /** queue node */
-  UT_LIST_NODE_T(srv_conc_slot_t) m_srv_conc_queue;
-};
-
-/** Queue of threads waiting to get in */
-static UT_LIST_BASE_NODE_T(srv_conc_slot_t, m_srv_conc_queue) srv_conc_queue;
-
-/** Array of wait slots */
-static srv_conc_slot_t *srv_conc_slots;
-
 /** The system log file names */
 static char **srv_log_group_home_dirs = nullptr;
 
@@ -196,10 +197,10 @@ bool srv_print_log_io = false;
 bool srv_print_latch_waits = false;
 #endif /* UNIV_DEBUG */
 
-ulint srv_n_rows_inserted = 0;
-ulint srv_n_rows_updated = 0;
-ulint srv_n_rows_deleted = 0;
-ulint srv_n_rows_read = 0;
+srv_counter_t srv_n_rows_inserted{};
+srv_counter_t srv_n_rows_updated{};
+srv_counter_t srv_n_rows_deleted{};
+srv_counter_t srv_n_rows_read{};
 
 static ulint srv_n_rows_inserted_old = 0;
 static ulint srv_n_rows_updated_old = 0;
@@ -211,6 +212,16 @@ ulint srv_n_lock_wait_current_count = 0;
 int64_t srv_n_lock_wait_time = 0;
 ulint srv_n_lock_max_wait_time = 0;
 
+Srv_op_stats srv_op_stats;
+
+const char *Srv_op_stats::get_name(Srv_op op) noexcept {
+  static const char *names[SRV_OP_COUNT] = {
+    "cursor_moveto", "cursor_next", "cursor_insert", "cursor_update", "cursor_delete", "trx_commit", "lock_wait"
+  };
+
+  return names[op];
+}
+
 /** Set the following to 0 if you want InnoDB to write messages on
 ib_stream on startup/shutdown */
 bool srv_print_verbose_log = true;
@@ -248,15 +259,6 @@ static ulint srv_main_background_loops = 0;
 /** Iterations of the loop bounded by the 'flush_loop' label. */
 static ulint srv_main_flush_loops = 0;
 
-/** Log writes involving flush. */
-static ulint srv_log_writes_and_flush = 0;
-
-/** This is only ever touched by the master thread. It records the
-time when the last flush of log file has happened. The master
-thread ensures that we flush the log files at least once per
-second. */
-static time_t srv_last_log_flush_time;
-
 /** The master thread performs various tasks based on the current
 state of IO activity and the level of IO utilization is past
 intervals. Following macros define thresholds for these conditions. */
@@ -454,6 +456,10 @@ struct srv_slot_t {
   /** time when the thread was suspended */
   ib_time_t m_suspend_time;
 
+  /** time after which the lock wait of the thread times out, see
+  srv_lock_waits */
+  ib_time_t m_deadline;
+
   /** event used in suspending the thread when it has nothing to do */
   Cond_var* m_event;
 
@@ -475,6 +481,18 @@ static srv_slot_t *srv_client_table = nullptr;
 
 Cond_var* srv_lock_timeout_thread_event;
 
+/** Suspended client threads ordered by the time their lock wait times out,
+the earliest first; protected by the kernel mutex. The lock timeout thread
+sleeps until the first deadline instead of scanning srv_client_table. */
+static std::set<std::pair<ib_time_t, srv_slot_t *>> srv_lock_waits;
+
+/** Number of waits in srv_lock_waits whose transaction has a client
+context and can therefore be interrupted; protected by the kernel mutex */
+static ulint srv_n_interruptible_lock_waits = 0;
+
+/** Value of srv_slot_t::m_deadline for waits that never time out */
+constexpr ib_time_t SRV_LOCK_WAIT_NO_DEADLINE = std::numeric_limits<ib_time_t>::max();
+
 static srv_sys_t *srv_sys = nullptr;
 
 /* padding to prevent other memory update hotspots from residing on
@@ -549,7 +567,17 @@ static void srv_print_master_thread_info() noexcept {
     srv_main_flush_loops
   ));
 
-  log_warn("srv_master_thread log flush and writes: ", srv_log_writes_and_flush);
+  for (auto service : {srv_log_sync_service, srv_purge_service, srv_stats_service}) {
+    if (service != nullptr) {
+      log_warn(std::format(
+        "{} service: {} rounds, {} us busy, {} us last round",
+        service->get_name(),
+        service->get_n_rounds(),
+        service->get_busy_time_us(),
+        service->get_last_round_us()
+      ));
+    }
+  }
 }
 
 bool InnoDB::parse_log_group_home_dirs(const char *usr_str) noexcept {
@@ -684,31 +712,36 @@ void InnoDB::var_init() noexcept {
 
   srv_log_buffer_size = ULINT_MAX;
 
-  srv_data_read = 0;
+  srv_data_read.clear();
+
+  srv_data_written.clear();
+
+  srv_data_compressed_saved.clear();
 
-  srv_data_written = 0;
+  srv_pcur_restore_hits.clear();
 
-  srv_log_write_requests = 0;
+  srv_pcur_restore_misses.clear();
 
-  srv_log_writes = 0;
+  srv_log_write_requests.clear();
 
-  srv_os_log_written = 0;
+  srv_log_writes.clear();
+
+  srv_os_log_written.clear();
 
   srv_os_log_pending_writes = 0;
 
-  srv_log_waits = 0;
+  srv_log_waits.clear();
 
-  srv_dblwr_writes = 0;
+  srv_dblwr_writes.clear();
 
-  srv_dblwr_pages_written = 0;
+  srv_dblwr_pages_written.clear();
 
-  srv_buf_pool_wait_free = 0;
+  srv_buf_pool_wait_free.clear();
 
-  srv_buf_pool_flushed = 0;
+  srv_buf_pool_flushed.clear();
 
-  srv_buf_pool_reads = 0;
+  srv_buf_pool_reads.clear();
 
-  srv_conc_slots = nullptr;
   srv_last_monitor_time = 0;
 
 #ifdef UNIV_LINUX
@@ -888,43 +921,26 @@ void InnoDB::init() noexcept {
   }
 
   UT_LIST_INIT(srv_sys->m_tasks);
-
-  /* Init the server concurrency restriction data structures */
-
-  UT_LIST_INIT(srv_conc_queue);
-
-  srv_conc_slots = static_cast<srv_conc_slot_t *>(mem_alloc(OS_THREAD_MAX_N * sizeof(srv_conc_slot_t)));
-
-  auto conc_slot = srv_conc_slots;
-
-  for (ulint i = 0; i < OS_THREAD_MAX_N; ++i, ++conc_slot) {
-    conc_slot->m_reserved = false;
-    conc_slot->m_event = os_event_create(nullptr);
-    ut_a(conc_slot->m_event);
-  }
 }
 
 void InnoDB::free() noexcept {
   for (ulint i{}; i < OS_THREAD_MAX_N; ++i) {
     auto slot = srv_table_get_nth_slot(i);
-    auto conc_slot = srv_conc_slots + i;
 
     os_event_free(slot->m_event);
-    os_event_free(conc_slot->m_event);
   }
 
   os_event_free(srv_lock_timeout_thread_event);
   srv_lock_timeout_thread_event = nullptr;
 
+  srv_lock_waits.clear();
+
   mem_free(srv_sys->m_threads);
   srv_sys->m_threads = nullptr;
 
   mem_free(srv_client_table);
   srv_client_table = nullptr;
 
-  mem_free(srv_conc_slots);
-  srv_conc_slots = nullptr;
-
   mutex_free(&srv_innodb_monitor_mutex);
   mutex_free(&kernel_mutex);
 
@@ -1065,8 +1081,6 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   auto trx = thr_get_trx(thr);
 
-  os_event_set(srv_lock_timeout_thread_event);
-
   mutex_enter(&kernel_mutex);
 
   trx->m_error_state = DB_SUCCESS;
@@ -1100,6 +1114,22 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   slot->m_suspend_time = ut_time();
 
+  /* The table and the index of the lock that we wait for. They are not
+  dropped while we hold a lock on the table. */
+  const Table *wait_table{};
+  const Index *wait_index{};
+
+  if (const auto wait_lock = trx->m_wait_lock; wait_lock != nullptr) {
+    if (wait_lock->type() == LOCK_REC) {
+      wait_index = wait_lock->rec_index();
+      wait_table = wait_index->m_table;
+    } else {
+      wait_table = wait_lock->table();
+    }
+  }
+
+  const auto wait_start_us = ut_time_us(nullptr);
+
   if (thr->lock_state == QUE_THR_LOCK_ROW) {
     srv_n_lock_wait_count++;
     srv_n_lock_wait_current_count++;
@@ -1110,9 +1140,29 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
       start_time = (int64_t)sec * 1000000 + ms;
     }
   }
-  /* Wake the lock timeout monitor thread, if it is suspended */
+  /* InnoDB system transactions (such as the purge, and
+  incomplete transactions that are being rolled back after crash
+  recovery) will use the global value of
+  innodb_lock_wait_timeout, because trx->m_client_ctx == nullptr. */
+  lock_wait_timeout = sess_lock_wait_timeout(trx);
+
+  if (lock_wait_timeout < 100000000) {
+    slot->m_deadline = slot->m_suspend_time + lock_wait_timeout;
+  } else {
+    slot->m_deadline = SRV_LOCK_WAIT_NO_DEADLINE;
+  }
 
-  os_event_set(srv_lock_timeout_thread_event);
+  auto it = srv_lock_waits.emplace(slot->m_deadline, slot).first;
+
+  if (trx->m_client_ctx != nullptr) {
+    ++srv_n_interruptible_lock_waits;
+  }
+
+  /* Wake the lock timeout thread if it is idle or sleeps past our deadline */
+
+  if (it == srv_lock_waits.begin()) {
+    os_event_set(srv_lock_timeout_thread_event);
+  }
 
   mutex_exit(&kernel_mutex);
 
@@ -1131,9 +1181,28 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   ut_a(trx->m_dict_operation_lock_mode == 0);
 
+  /* Give up the place in the admission control while we wait, the holder of
+  the lock may wait for one. */
+  const auto was_inside = srv_conc != nullptr && srv_conc->force_exit(trx);
+
   /* Suspend this thread and wait for the event. */
 
-  os_event_wait(event);
+  {
+    const auto table_id = wait_table != nullptr ? wait_table->m_id : DICT_ID_NULL;
+    ut::Wait_timer lock_wait(ut::Wait_type::LOCK, table_id, __FILE__, __LINE__);
+
+    IB_PROBE(lock__wait__start, trx->m_id, table_id);
+
+    lock_wait.start();
+    os_event_wait(event);
+    lock_wait.stop();
+
+    IB_PROBE(lock__wait__done, trx->m_id, table_id);
+  }
+
+  if (was_inside) {
+    srv_conc->force_enter(trx);
+  }
 
   /* After resuming, reacquire the data dictionary latch if
   necessary. */
@@ -1151,6 +1220,13 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   /* Release the slot for others to use */
 
+  srv_lock_waits.erase({slot->m_deadline, slot});
+
+  if (trx->m_client_ctx != nullptr) {
+    ut_a(srv_n_interruptible_lock_waits > 0);
+    --srv_n_interruptible_lock_waits;
+  }
+
   slot->m_in_use = false;
 
   wait_time = ut_difftime(ut_time(), slot->m_suspend_time);
@@ -1183,11 +1259,18 @@ void InnoDB::suspend_user_thread(que_thr_t *thr) noexcept {
 
   mutex_exit(&kernel_mutex);
 
-  /* InnoDB system transactions (such as the purge, and
-  incomplete transactions that are being rolled back after crash
-  recovery) will use the global value of
-  innodb_lock_wait_timeout, because trx->m_client_ctx == nullptr. */
-  lock_wait_timeout = sess_lock_wait_timeout(trx);
+  const auto wait_end_us = ut_time_us(nullptr);
+  const auto wait_us = wait_end_us > wait_start_us ? wait_end_us - wait_start_us : 0;
+
+  srv_op_stats.add(SRV_OP_LOCK_WAIT, wait_us);
+
+  if (wait_table != nullptr) {
+    wait_table->m_lock_waits.add(wait_us);
+  }
+
+  if (wait_index != nullptr) {
+    wait_index->m_lock_waits.add(wait_us);
+  }
 
   if (trx->is_interrupted() || (lock_wait_timeout < 100000000 && wait_time > (double)lock_wait_timeout)) {
 
@@ -1225,10 +1308,10 @@ static void srv_refresh_innodb_monitor_stats() noexcept {
 
   srv_buf_pool->refresh_io_stats();
 
-  srv_n_rows_inserted_old = srv_n_rows_inserted;
-  srv_n_rows_updated_old = srv_n_rows_updated;
-  srv_n_rows_deleted_old = srv_n_rows_deleted;
-  srv_n_rows_read_old = srv_n_rows_read;
+  srv_n_rows_inserted_old = srv_n_rows_inserted.value();
+  srv_n_rows_updated_old = srv_n_rows_updated.value();
+  srv_n_rows_deleted_old = srv_n_rows_deleted.value();
+  srv_n_rows_read_old = srv_n_rows_read.value();
 
   mutex_exit(&srv_innodb_monitor_mutex);
 }
@@ -1308,6 +1391,16 @@ bool InnoDB::printf_innodb_monitor(
 
   log_warn("{}", srv_aio->to_string().c_str());
 
+  log_warn(
+    "--------------\n"
+    "I/O LATENCIES\n"
+    "--------------\n"
+  );
+
+  log_warn(srv_aio->latency_to_string());
+
+  log_warn(srv_fil->io_latency_to_string(10));
+
   /* Only if lock_print_info_summary proceeds correctly,
   before we call the lock_print_info_all_transactions
   to print all the lock information. */
@@ -1344,6 +1437,8 @@ bool InnoDB::printf_innodb_monitor(
   log_warn("Total memory allocated ", ut_total_allocated_memory());
   log_warn("Dictionary memory allocated ", srv_dict_sys->m_size);
 
+  mem_heap_cache_print();
+
   srv_buf_pool->print_io(ib_stream);
 
   log_warn(
@@ -1376,28 +1471,28 @@ bool InnoDB::printf_innodb_monitor(
 
   log_warn(std::format(
     "Number of rows inserted {}, updated {}, deleted {}, read {}",
-    srv_n_rows_inserted,
-    srv_n_rows_updated,
-    srv_n_rows_deleted,
-    srv_n_rows_read
+    srv_n_rows_inserted.value(),
+    srv_n_rows_updated.value(),
+    srv_n_rows_deleted.value(),
+    srv_n_rows_read.value()
   ));
 
   log_warn(std::format(
     "{:.2f} inserts/s, {:.2f} updates/s,"
     " {:.2f} deletes/s, {:.2f} reads/s",
-    (srv_n_rows_inserted - srv_n_rows_inserted_old) / time_elapsed,
-    (srv_n_rows_updated - srv_n_rows_updated_old) / time_elapsed,
-    (srv_n_rows_deleted - srv_n_rows_deleted_old) / time_elapsed,
-    (srv_n_rows_read - srv_n_rows_read_old) / time_elapsed
+    (srv_n_rows_inserted.value() - srv_n_rows_inserted_old) / time_elapsed,
+    (srv_n_rows_updated.value() - srv_n_rows_updated_old) / time_elapsed,
+    (srv_n_rows_deleted.value() - srv_n_rows_deleted_old) / time_elapsed,
+    (srv_n_rows_read.value() - srv_n_rows_read_old) / time_elapsed
   ));
 
-  srv_n_rows_inserted_old = srv_n_rows_inserted;
+  srv_n_rows_inserted_old = srv_n_rows_inserted.value();
 
-  srv_n_rows_updated_old = srv_n_rows_updated;
+  srv_n_rows_updated_old = srv_n_rows_updated.value();
 
-  srv_n_rows_deleted_old = srv_n_rows_deleted;
+  srv_n_rows_deleted_old = srv_n_rows_deleted.value();
 
-  srv_n_rows_read_old = srv_n_rows_read;
+  srv_n_rows_read_old = srv_n_rows_read.value();
 
   log_warn(
     "----------------------------\n"
@@ -1410,49 +1505,77 @@ bool InnoDB::printf_innodb_monitor(
   return ret;
 }
 
-void InnoDB::export_innodb_status() noexcept {
-  mutex_enter(&srv_innodb_monitor_mutex);
+/** Reads the status variables into export_vars, the caller must own
+srv_innodb_monitor_mutex. */
+static void export_innodb_status_low() noexcept {
+  ut_ad(mutex_own(&srv_innodb_monitor_mutex));
 
   export_vars.innodb_data_pending_reads = os_n_pending_reads;
   export_vars.innodb_data_pending_writes = os_n_pending_writes;
   export_vars.innodb_data_pending_fsyncs = srv_fil->get_pending_log_flushes() + srv_fil->get_pending_tablespace_flushes();
   export_vars.innodb_data_fsyncs = os_n_fsyncs;
-  export_vars.innodb_data_read = srv_data_read;
+  export_vars.innodb_data_read = srv_data_read.value();
   export_vars.innodb_data_reads = os_n_file_reads;
   export_vars.innodb_data_writes = os_n_file_writes;
-  export_vars.innodb_data_written = srv_data_written;
-  export_vars.innodb_buffer_pool_read_requests = srv_buf_pool->m_stat.n_page_gets;
-  export_vars.innodb_buffer_pool_write_requests = srv_buf_pool->m_write_requests;
-  export_vars.innodb_buffer_pool_wait_free = srv_buf_pool_wait_free;
-  export_vars.innodb_buffer_pool_pages_flushed = srv_buf_pool_flushed;
-  export_vars.innodb_buffer_pool_reads = srv_buf_pool_reads;
-  export_vars.innodb_buffer_pool_read_ahead = srv_buf_pool->m_stat.n_ra_pages_read;
-  export_vars.innodb_buffer_pool_read_ahead_evicted = srv_buf_pool->m_stat.n_ra_pages_evicted;
-  export_vars.innodb_buffer_pool_pages_data = UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list);
-  export_vars.innodb_buffer_pool_pages_dirty = UT_LIST_GET_LEN(srv_buf_pool->m_flush_list);
-  export_vars.innodb_buffer_pool_pages_free = UT_LIST_GET_LEN(srv_buf_pool->m_free_list);
+  export_vars.innodb_data_written = srv_data_written.value();
+  export_vars.innodb_data_compressed_saved = srv_data_compressed_saved.value();
+  export_vars.innodb_data_pages_preallocated = srv_fil_prealloc != nullptr ? srv_fil_prealloc->get_n_pages_preallocated() : 0;
+  export_vars.innodb_data_pages_trimmed = srv_fil_trim != nullptr ? srv_fil_trim->get_n_pages_trimmed() : 0;
+  export_vars.innodb_data_pages_untrimmed = srv_fil_trim != nullptr ? srv_fil_trim->get_n_pages_untrimmed() : 0;
+  const auto buf_pool_stat = srv_buf_pool->get_stat();
+
+  export_vars.innodb_buffer_pool_read_requests = buf_pool_stat.n_page_gets;
+  export_vars.innodb_buffer_pool_write_requests = srv_buf_pool->get_write_requests();
+  export_vars.innodb_buffer_pool_wait_free = srv_buf_pool_wait_free.value();
+  export_vars.innodb_buffer_pool_pages_flushed = srv_buf_pool_flushed.value();
+  export_vars.innodb_buffer_pool_reads = srv_buf_pool_reads.value();
+  export_vars.innodb_buffer_pool_read_ahead = buf_pool_stat.n_ra_pages_read;
+  export_vars.innodb_buffer_pool_read_ahead_evicted = buf_pool_stat.n_ra_pages_evicted;
+  export_vars.innodb_l2_cache_hits = srv_buf_l2 != nullptr ? srv_buf_l2->get_n_hits() : 0;
+  export_vars.innodb_l2_cache_pages_written = srv_buf_l2 != nullptr ? srv_buf_l2->get_n_writes() : 0;
+  export_vars.innodb_adaptive_hash_hits = srv_btr_search != nullptr ? srv_btr_search->get_n_hits() : 0;
+  export_vars.innodb_adaptive_hash_misses = srv_btr_search != nullptr ? srv_btr_search->get_n_misses() : 0;
+  export_vars.innodb_adaptive_hash_entries = srv_btr_search != nullptr ? srv_btr_search->get_n_entries() : 0;
+  export_vars.innodb_pcur_restore_hits = srv_pcur_restore_hits.value();
+  export_vars.innodb_pcur_restore_misses = srv_pcur_restore_misses.value();
+  export_vars.innodb_defrag_pages_scanned = srv_defrag_n_pages_scanned.load(std::memory_order_relaxed);
+  export_vars.innodb_defrag_pages_freed = srv_defrag_n_pages_freed.load(std::memory_order_relaxed);
+  export_vars.innodb_buffer_pool_pages_data = srv_buf_pool->get_LRU_len();
+  export_vars.innodb_buffer_pool_pages_dirty = srv_buf_pool->get_flush_list_len();
+  export_vars.innodb_buffer_pool_pages_free = srv_buf_pool->get_free_list_len();
 
   ut_d(export_vars.innodb_buffer_pool_pages_latched = srv_buf_pool->get_latched_pages_number());
 
-  export_vars.innodb_buffer_pool_pages_total = srv_buf_pool->m_curr_size;
+  export_vars.innodb_buffer_pool_pages_total = srv_buf_pool->get_curr_pages();
+  export_vars.innodb_buffer_pool_huge_pages = srv_buf_pool->get_huge_pages();
+  export_vars.innodb_buffer_pool_numa = srv_buf_pool->get_numa_policy();
 
   export_vars.innodb_buffer_pool_pages_misc =
-    srv_buf_pool->m_curr_size - UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) - UT_LIST_GET_LEN(srv_buf_pool->m_free_list);
+    srv_buf_pool->get_curr_pages() - srv_buf_pool->get_LRU_len() - srv_buf_pool->get_free_list_len();
 
   export_vars.innodb_have_atomic_builtins = 1;
   export_vars.innodb_page_size = UNIV_PAGE_SIZE;
-  export_vars.innodb_log_waits = srv_log_waits;
-  export_vars.innodb_os_log_written = srv_os_log_written;
+  export_vars.innodb_log_waits = srv_log_waits.value();
+  export_vars.innodb_os_log_written = srv_os_log_written.value();
   export_vars.innodb_os_log_fsyncs = srv_fil->get_log_flushes();
   export_vars.innodb_os_log_pending_fsyncs = srv_fil->get_pending_log_flushes();
   export_vars.innodb_os_log_pending_writes = srv_os_log_pending_writes;
-  export_vars.innodb_log_write_requests = srv_log_write_requests;
-  export_vars.innodb_log_writes = srv_log_writes;
-  export_vars.innodb_dblwr_pages_written = srv_dblwr_pages_written;
-  export_vars.innodb_dblwr_writes = srv_dblwr_writes;
-  export_vars.innodb_pages_created = srv_buf_pool->m_stat.n_pages_created;
-  export_vars.innodb_pages_read = srv_buf_pool->m_stat.n_pages_read;
-  export_vars.innodb_pages_written = srv_buf_pool->m_stat.n_pages_written;
+  export_vars.innodb_log_group_commits = log_sys->get_n_group_commits();
+  export_vars.innodb_log_group_commit_fsyncs = log_sys->get_n_group_commit_fsyncs();
+  export_vars.innodb_log_commits_per_fsync =
+    export_vars.innodb_log_group_commits / std::max(export_vars.innodb_log_group_commit_fsyncs, ulint(1));
+  export_vars.innodb_log_checkpoint_age = log_sys->get_checkpoint_age();
+  export_vars.innodb_log_checkpoint_age_async = log_sys->m_max_checkpoint_age_async;
+  export_vars.innodb_log_checkpoint_age_sync = log_sys->m_max_checkpoint_age;
+  export_vars.innodb_log_checkpoint_async_time_us = log_sys->get_checkpoint_async_time_us();
+  export_vars.innodb_log_checkpoint_sync_time_us = log_sys->get_checkpoint_sync_time_us();
+  export_vars.innodb_log_write_requests = srv_log_write_requests.value();
+  export_vars.innodb_log_writes = srv_log_writes.value();
+  export_vars.innodb_dblwr_pages_written = srv_dblwr_pages_written.value();
+  export_vars.innodb_dblwr_writes = srv_dblwr_writes.value();
+  export_vars.innodb_pages_created = buf_pool_stat.n_pages_created;
+  export_vars.innodb_pages_read = buf_pool_stat.n_pages_read;
+  export_vars.innodb_pages_written = buf_pool_stat.n_pages_written;
   export_vars.innodb_row_lock_waits = srv_n_lock_wait_count;
   export_vars.innodb_row_lock_current_waits = srv_n_lock_wait_current_count;
   export_vars.innodb_row_lock_time = srv_n_lock_wait_time / 1000;
@@ -1463,10 +1586,197 @@ void InnoDB::export_innodb_status() noexcept {
     export_vars.innodb_row_lock_time_avg = 0;
   }
   export_vars.innodb_row_lock_time_max = srv_n_lock_max_wait_time / 1000;
-  export_vars.innodb_rows_read = srv_n_rows_read;
-  export_vars.innodb_rows_inserted = srv_n_rows_inserted;
-  export_vars.innodb_rows_updated = srv_n_rows_updated;
-  export_vars.innodb_rows_deleted = srv_n_rows_deleted;
+  export_vars.innodb_rows_read = srv_n_rows_read.value();
+  export_vars.innodb_rows_inserted = srv_n_rows_inserted.value();
+  export_vars.innodb_rows_updated = srv_n_rows_updated.value();
+  export_vars.innodb_rows_deleted = srv_n_rows_deleted.value();
+  export_vars.innodb_recovery_rollback_trxs_left = trx_roll_get_n_recovered_trxs();
+  export_vars.innodb_recovery_rollback_undo_recs_left = trx_roll_get_n_recovered_undo_recs();
+  export_vars.innodb_recovery_dblwr_time_ms = ulint(recv_stats.m_phases[RECV_PHASE_DBLWR].m_time_us / 1000);
+  export_vars.innodb_recovery_dblwr_pages_restored = ulint(recv_stats.m_phases[RECV_PHASE_DBLWR].m_n_items);
+  export_vars.innodb_recovery_scan_time_ms = ulint(recv_stats.m_phases[RECV_PHASE_SCAN].m_time_us / 1000);
+  export_vars.innodb_recovery_scan_bytes = ulint(recv_stats.m_phases[RECV_PHASE_SCAN].m_n_bytes);
+  export_vars.innodb_recovery_parse_time_ms = ulint(recv_stats.m_phases[RECV_PHASE_PARSE].m_time_us / 1000);
+  export_vars.innodb_recovery_parse_records = ulint(recv_stats.m_phases[RECV_PHASE_PARSE].m_n_items);
+  export_vars.innodb_recovery_parse_bytes = ulint(recv_stats.m_phases[RECV_PHASE_PARSE].m_n_bytes);
+  export_vars.innodb_recovery_apply_time_ms = ulint(recv_stats.m_phases[RECV_PHASE_APPLY].m_time_us / 1000);
+  export_vars.innodb_recovery_apply_pages = ulint(recv_stats.m_phases[RECV_PHASE_APPLY].m_n_items);
+  export_vars.innodb_recovery_rollback_time_ms = ulint(recv_stats.m_phases[RECV_PHASE_ROLLBACK].m_time_us / 1000);
+  export_vars.innodb_recovery_rollback_undo_recs = ulint(recv_stats.m_phases[RECV_PHASE_ROLLBACK].m_n_items);
+
+  export_vars.innodb_recovery_pages_read = 0;
+
+  for (const auto &phase : recv_stats.m_phases) {
+    export_vars.innodb_recovery_pages_read += phase.m_n_pages_read;
+  }
+
+  export_vars.innodb_recovery_peak_memory = recv_stats.m_peak_memory;
+
+  export_vars.innodb_startup_buf_pool_time_ms = ulint(srv_startup_stats.m_time_us[STARTUP_STEP_BUF_POOL] / 1000);
+  export_vars.innodb_startup_files_time_ms = ulint(srv_startup_stats.m_time_us[STARTUP_STEP_FILES] / 1000);
+  export_vars.innodb_startup_tablespaces_time_ms = ulint(srv_startup_stats.m_time_us[STARTUP_STEP_TABLESPACES] / 1000);
+  export_vars.innodb_startup_recovery_time_ms = ulint(srv_startup_stats.m_time_us[STARTUP_STEP_RECOVERY] / 1000);
+  export_vars.innodb_startup_dict_time_ms = ulint(srv_startup_stats.m_time_us[STARTUP_STEP_DICT] / 1000);
+  export_vars.innodb_startup_threads_time_ms = ulint(srv_startup_stats.m_time_us[STARTUP_STEP_THREADS] / 1000);
+  export_vars.innodb_startup_total_time_ms = ulint(srv_startup_stats.m_total_us / 1000);
+
+  const std::array<std::pair<ulint *, ulint *>, IO_CLASS_COUNT> aio_vars{{
+    {&export_vars.innodb_aio_foreground_read_pending, &export_vars.innodb_aio_foreground_read_latency_us},
+    {&export_vars.innodb_aio_read_ahead_pending, &export_vars.innodb_aio_read_ahead_latency_us},
+    {&export_vars.innodb_aio_flush_pending, &export_vars.innodb_aio_flush_latency_us},
+    {&export_vars.innodb_aio_log_pending, &export_vars.innodb_aio_log_latency_us},
+    {&export_vars.innodb_aio_recovery_pending, &export_vars.innodb_aio_recovery_latency_us},
+  }};
+
+  for (ulint i{}; i < IO_CLASS_COUNT; ++i) {
+    const auto stats = srv_aio->get_class_stats(IO_class(i));
+
+    *aio_vars[i].first = stats.m_n_pending;
+    *aio_vars[i].second = ulint(stats.m_latency.count());
+  }
+
+  const auto get_percentiles = [](std::initializer_list<IO_request> io_requests) {
+    ut::Latency_histogram histogram;
+
+    for (auto io_request : io_requests) {
+      srv_aio->get_latency(io_request, histogram);
+    }
+
+    return histogram.get_percentiles();
+  };
+
+  const auto reads = get_percentiles({IO_request::Async_read, IO_request::Sync_read});
+
+  export_vars.innodb_aio_read_latency_p50_us = reads.m_p50;
+  export_vars.innodb_aio_read_latency_p99_us = reads.m_p99;
+  export_vars.innodb_aio_read_latency_p999_us = reads.m_p999;
+
+  const auto writes = get_percentiles({IO_request::Async_write, IO_request::Sync_write});
+
+  export_vars.innodb_aio_write_latency_p50_us = writes.m_p50;
+  export_vars.innodb_aio_write_latency_p99_us = writes.m_p99;
+  export_vars.innodb_aio_write_latency_p999_us = writes.m_p999;
+
+  const auto log_writes = get_percentiles(
+    {IO_request::Async_log_write, IO_request::Sync_log_write, IO_request::Sync_log_write_durable});
+
+  export_vars.innodb_aio_log_write_latency_p50_us = log_writes.m_p50;
+  export_vars.innodb_aio_log_write_latency_p99_us = log_writes.m_p99;
+  export_vars.innodb_aio_log_write_latency_p999_us = log_writes.m_p999;
+
+  export_vars.innodb_purge_history_len = srv_trx_sys->m_rseg_history_len;
+
+  if (srv_trx_sys->m_purge != nullptr) {
+    const auto &lag = srv_trx_sys->m_purge->m_lag;
+
+    export_vars.innodb_purge_records_per_sec = ulint(lag.m_recs_per_sec);
+    export_vars.innodb_purge_undo_logs_added_per_sec = ulint(lag.m_logs_added_per_sec);
+    export_vars.innodb_purge_oldest_view_age = lag.m_oldest_view_age;
+    export_vars.innodb_purge_oldest_view_trx_id = int64_t(lag.m_oldest_view_trx_id);
+  }
+
+  export_vars.innodb_purge_dml_delay_us = srv_dml_needed_delay;
+
+  const std::array<std::array<ulint *, 3>, TRX_COMMIT_PHASE_COUNT> commit_vars{{
+    {&export_vars.innodb_trx_commit_undo_latency_p50_us, &export_vars.innodb_trx_commit_undo_latency_p99_us, &export_vars.innodb_trx_commit_undo_waiting},
+    {&export_vars.innodb_trx_commit_lock_release_latency_p50_us, &export_vars.innodb_trx_commit_lock_release_latency_p99_us, &export_vars.innodb_trx_commit_lock_release_waiting},
+    {&export_vars.innodb_trx_commit_log_write_latency_p50_us, &export_vars.innodb_trx_commit_log_write_latency_p99_us, &export_vars.innodb_trx_commit_log_write_waiting},
+    {&export_vars.innodb_trx_commit_log_flush_latency_p50_us, &export_vars.innodb_trx_commit_log_flush_latency_p99_us, &export_vars.innodb_trx_commit_log_flush_waiting},
+  }};
+
+  for (ulint i{}; i < TRX_COMMIT_PHASE_COUNT; ++i) {
+    const auto &phase = trx_commit_stats.m_phases[i];
+    const auto latency = phase.m_latency.get_percentiles();
+
+    *commit_vars[i][0] = ulint(latency.m_p50);
+    *commit_vars[i][1] = ulint(latency.m_p99);
+    *commit_vars[i][2] = phase.m_n_waiting.load(std::memory_order_relaxed);
+  }
+
+  const std::array<std::array<ulint *, 4>, MTR_STAT_COUNT> mtr_vars{{
+    {&export_vars.innodb_mtr_log_bytes_count, &export_vars.innodb_mtr_log_bytes_p50, &export_vars.innodb_mtr_log_bytes_p99, &export_vars.innodb_mtr_log_bytes_max},
+    {&export_vars.innodb_mtr_memo_slots_count, &export_vars.innodb_mtr_memo_slots_p50, &export_vars.innodb_mtr_memo_slots_p99, &export_vars.innodb_mtr_memo_slots_max},
+    {&export_vars.innodb_mtr_commit_count, &export_vars.innodb_mtr_commit_latency_p50_us, &export_vars.innodb_mtr_commit_latency_p99_us, &export_vars.innodb_mtr_commit_latency_max_us},
+    {&export_vars.innodb_log_space_waits, &export_vars.innodb_log_space_wait_p50_us, &export_vars.innodb_log_space_wait_p99_us, &export_vars.innodb_log_space_wait_max_us},
+    {&export_vars.innodb_log_flush_order_waits, &export_vars.innodb_log_flush_order_wait_p50_us, &export_vars.innodb_log_flush_order_wait_p99_us, &export_vars.innodb_log_flush_order_wait_max_us},
+  }};
+
+  for (ulint i{}; i < MTR_STAT_COUNT; ++i) {
+    const auto percentiles = mtr_stats.get_percentiles(Mtr_stat(i), false);
+
+    *mtr_vars[i][0] = ulint(percentiles.m_count);
+    *mtr_vars[i][1] = ulint(percentiles.m_p50);
+    *mtr_vars[i][2] = ulint(percentiles.m_p99);
+    *mtr_vars[i][3] = ulint(percentiles.m_max);
+  }
+
+  const auto latches = sync_latch_class_totals();
+
+  export_vars.innodb_latch_acquisitions = ulint(latches.m_acquisitions);
+  export_vars.innodb_latch_contended = ulint(latches.m_contended);
+  export_vars.innodb_latch_spin_rounds = ulint(latches.m_spin_rounds);
+  export_vars.innodb_latch_os_waits = ulint(latches.m_os_waits);
+  export_vars.innodb_latch_wait_time_us = ulint(latches.m_wait_ns / 1000);
+  export_vars.innodb_latch_max_wait_us = ulint(latches.m_max_wait_ns / 1000);
+
+  for (size_t i{}; i < MEM_TAG_COUNT; ++i) {
+    const auto usage = ut_mem_tag_usage(Mem_tag(i));
+
+    export_vars.innodb_mem_tag_bytes[i] = usage.m_current;
+    export_vars.innodb_mem_tag_peak_bytes[i] = usage.m_peak;
+  }
+
+  for (ulint i{}; i < SRV_OP_COUNT; ++i) {
+    const auto latency = srv_op_stats.get_percentiles(Srv_op(i), false);
+
+    export_vars.innodb_op_count[i] = ulint(latency.m_count);
+    export_vars.innodb_op_latency_p50_us[i] = ulint(latency.m_p50);
+    export_vars.innodb_op_latency_p99_us[i] = ulint(latency.m_p99);
+    export_vars.innodb_op_latency_p999_us[i] = ulint(latency.m_p999);
+    export_vars.innodb_op_latency_max_us[i] = ulint(latency.m_max);
+  }
+
+  export_vars.innodb_dict_tables_cached = UT_LIST_GET_LEN(srv_dict_sys->m_table_LRU);
+  export_vars.innodb_dict_tables_loaded = srv_dict_sys->m_n_tables_loaded;
+  export_vars.innodb_dict_tables_evicted = srv_dict_sys->m_n_tables_evicted;
+
+  mutex_enter(&kernel_mutex);
+
+  export_vars.innodb_trx_active = UT_LIST_GET_LEN(srv_trx_sys->m_trx_list);
+  export_vars.innodb_trx_user = srv_trx_sys->m_n_user_trx;
+  export_vars.innodb_lock_rec_locks = srv_lock_sys->get_n_rec_locks();
+
+  /* The cached lists are protected by the rseg mutex, the lengths may be stale. */
+  export_vars.innodb_undo_cached = 0;
+
+  for (const auto rseg : srv_trx_sys->m_rseg_list) {
+    export_vars.innodb_undo_cached += UT_LIST_GET_LEN(rseg->insert_undo_cached) + UT_LIST_GET_LEN(rseg->update_undo_cached);
+  }
+
+  mutex_exit(&kernel_mutex);
+
+  export_vars.innodb_undo_cache_hits = srv_undo->m_n_cache_hits.load(std::memory_order_relaxed);
+  export_vars.innodb_undo_cache_misses = srv_undo->m_n_cache_misses.load(std::memory_order_relaxed);
+
+  export_vars.innodb_conc_active = srv_conc != nullptr ? srv_conc->get_n_active() : 0;
+  export_vars.innodb_conc_waiting = srv_conc != nullptr ? srv_conc->get_n_waiting() : 0;
+  export_vars.innodb_conc_limit = srv_conc != nullptr ? srv_conc->get_limit() : 0;
+}
+
+void InnoDB::export_innodb_status() noexcept {
+  mutex_enter(&srv_innodb_monitor_mutex);
+
+  export_innodb_status_low();
+
+  mutex_exit(&srv_innodb_monitor_mutex);
+}
+
+void InnoDB::snapshot_innodb_status(export_struc &vars) noexcept {
+  mutex_enter(&srv_innodb_monitor_mutex);
+
+  export_innodb_status_low();
+
+  vars = export_vars;
 
   mutex_exit(&srv_innodb_monitor_mutex);
 }
@@ -1475,6 +1785,8 @@ void *InnoDB::monitor_thread(void *) noexcept {
   double time_elapsed;
   time_t current_time;
 
+  os_thread_bind(OS_THREAD_CLASS_MONITOR);
+
   srv_last_monitor_time = time(nullptr);
 
   ulint mutex_skipped{};
@@ -1606,48 +1918,60 @@ exit_func:
 }
 
 void *InnoDB::lock_timeout_thread(void *) noexcept {
+  os_thread_bind(OS_THREAD_CLASS_MONITOR);
+
   for (;;) {
-    /* When someone is waiting for a lock, we wake up every second
-    and check if a timeout has passed for a lock wait */
+    mutex_enter(&kernel_mutex);
 
-    os_thread_sleep(1000000);
+    auto sig_count = os_event_reset(srv_lock_timeout_thread_event);
 
-    srv_lock_timeout_active = true;
+    srv_lock_timeout_active = !srv_lock_waits.empty();
 
-    mutex_enter(&kernel_mutex);
+    auto now = ut_time();
+
+    /* The waits are ordered on their deadline: unless some wait can be
+    interrupted, we can stop at the first wait that has not timed out. */
+
+    auto next = srv_lock_waits.end();
 
-    auto some_waits = false;
+    for (auto it = srv_lock_waits.begin(); it != srv_lock_waits.end(); ++it) {
+      const auto &[deadline, slot] = *it;
+      auto timed_out = deadline != SRV_LOCK_WAIT_NO_DEADLINE && ut_difftime(now, deadline) > 0;
 
-    /* Check of all slots if a thread is waiting there, and if it
-    has exceeded the time limit */
+      if (!timed_out && next == srv_lock_waits.end()) {
+        next = it;
 
-    for (ulint i = 0; i < OS_THREAD_MAX_N; i++) {
+        if (srv_n_interruptible_lock_waits == 0) {
+          break;
+        }
+      }
 
-      auto slot = srv_client_table + i;
+      auto trx = thr_get_trx(slot->m_thr);
 
-      if (slot->m_in_use) {
-        some_waits = true;
-        auto wait_time = ut_difftime(ut_time(), slot->m_suspend_time);
-        auto trx = thr_get_trx(slot->m_thr);
-        auto lock_wait_timeout = sess_lock_wait_timeout(trx);
+      if (timed_out || trx->is_interrupted()) {
 
-        if (trx->is_interrupted() ||
-            (lock_wait_timeout < 100000000 &&
-             (wait_time > (double)lock_wait_timeout || wait_time < 0))) {
+        /* Timeout exceeded: cancel the lock request queued by the transaction
+        and release possible other transactions waiting behind; it is possible
+        that the lock has already been granted: in that case do nothing. The
+        thread removes its entry from srv_lock_waits when it resumes. */
 
-          /* Timeout exceeded or a wrap-around in system time counter:
-          cancel the lock request queued by the transaction and release possible
-          other transactions waiting behind; it is possible that the lock has
-          already been granted: in that case do nothing */
-  
-          if (trx->m_wait_lock) {
-            srv_lock_sys->cancel_waiting_and_release(trx->m_wait_lock);
-          }
+        if (trx->m_wait_lock) {
+          srv_lock_sys->cancel_waiting_and_release(trx->m_wait_lock);
         }
       }
     }
 
-    os_event_reset(srv_lock_timeout_thread_event);
+    /* Sleep until the next wait times out, or until a thread is suspended
+    with an earlier deadline or shutdown starts. Interrupts are not signalled
+    by the client, so they are polled once a second. */
+
+    auto timeout = std::chrono::microseconds::max();
+
+    if (srv_n_interruptible_lock_waits > 0) {
+      timeout = std::chrono::seconds(1);
+    } else if (next != srv_lock_waits.end() && next->first != SRV_LOCK_WAIT_NO_DEADLINE) {
+      timeout = std::chrono::seconds(ib_time_t(ut_difftime(next->first, now)) + 1);
+    }
 
     mutex_exit(&kernel_mutex);
 
@@ -1662,9 +1986,7 @@ void *InnoDB::lock_timeout_thread(void *) noexcept {
       return nullptr;
     }
 
-    if (!some_waits) {
-      srv_lock_timeout_active = false;
-    }
+    srv_lock_timeout_thread_event->wait_time(timeout, sig_count);
   }
 }
 
@@ -1673,6 +1995,8 @@ void *InnoDB::error_monitor_thread(void *) noexcept {
   ulint fatal_cnt = 0;
   auto old_lsn = srv_start_lsn;
 
+  os_thread_bind(OS_THREAD_CLASS_MONITOR);
+
 loop:
   srv_error_monitor_active = true;
 
@@ -1700,10 +2024,13 @@ loop:
   }
 
   /* Update the statistics collected for deciding LRU eviction policy. */
-  srv_buf_pool->m_LRU->stat_update();
+  srv_buf_pool->stat_update();
 
-  /* Update the statistics collected for flush rate policy. */
-  srv_buf_pool->m_flusher->stat_update();
+  /* Free the pages of the dropped tablespaces that are still cached. */
+  srv_buf_pool->sweep_dropped();
+
+  /* Sample the memory usage peaks of the subsystems. */
+  ut_mem_tag_sample_peaks();
 
   /* In case mutex_exit is not a memory barrier, it is
   theoretically possible some threads are left waiting though
@@ -1768,27 +2095,97 @@ void InnoDB::wake_master_thread() noexcept {
 }
 
 /**
- * The master thread is tasked to ensure that flush of log file happens
- * once every second in the background. This is to ensure that not more
- * than one second of trxs are lost in case of crash when
- * innodb_flush_logs_at_trx_commit != 1
+ * @return the number of page reads and writes done by the buffer pool.
  */
-static void srv_sync_log_buffer_in_background() {
-  auto current_time = time(nullptr);
+static ulint srv_buf_pool_get_n_ios() {
+  const auto stat = srv_buf_pool->get_stat();
+
+  return stat.n_pages_read + stat.n_pages_written;
+}
+
+/**
+ * A round of the log sync service: flushes the log once a second so that
+ * not more than one second of transactions is lost in a crash when
+ * innodb_flush_logs_at_trx_commit != 1.
+ *
+ * @return false, the next round runs after the interval.
+ */
+static bool srv_log_sync_round() noexcept {
+  log_sys->buffer_sync_in_background(true);
+  log_sys->buffer_shrink_if_idle();
 
-  srv_main_thread_op_info = "flushing log";
+  return false;
+}
+
+/**
+ * A round of the purge service.
+ *
+ * @return true if purge found work, the next round runs right away.
+ */
+static bool srv_purge_round() noexcept {
+  return srv_trx_sys->m_purge->run() > 0;
+}
 
-  if (difftime(current_time, srv_last_log_flush_time) >= 1) {
-    log_sys->buffer_sync_in_background(true);
-    srv_last_log_flush_time = current_time;
-    srv_log_writes_and_flush++;
+/**
+ * A round of the stats service.
+ *
+ * @return false, the next round runs after the interval.
+ */
+static bool srv_stats_round() noexcept {
+  (void) Dict_stats::recalc_queued();
+
+  (void) srv_dict_sys->evict_tables();
+
+  return false;
+}
+
+bool InnoDB::create_services() noexcept {
+  using namespace std::chrono_literals;
+
+  srv_log_sync_service = Srv_service::create("log sync", 1000ms, srv_log_sync_round);
+  srv_stats_service = Srv_service::create("stats", 1000ms, srv_stats_round);
+
+  if (srv_log_sync_service == nullptr || srv_stats_service == nullptr) {
+    return false;
+  }
+
+  if (srv_config.m_force_recovery < IB_RECOVERY_NO_BACKGROUND && !srv_config.m_read_only) {
+    srv_purge_service = Srv_service::create("purge coordinator", 1000ms, srv_purge_round);
+
+    if (srv_purge_service == nullptr) {
+      return false;
+    }
+
+    srv_purge_service->start();
+  }
+
+  srv_log_sync_service->start();
+  srv_stats_service->start();
+
+  return true;
+}
+
+void InnoDB::shutdown_services() noexcept {
+  for (auto service : {srv_log_sync_service, srv_stats_service, srv_purge_service}) {
+    if (service != nullptr) {
+      service->shutdown();
+    }
+  }
+}
+
+void InnoDB::destroy_services() noexcept {
+  shutdown_services();
+
+  for (auto service : {&srv_log_sync_service, &srv_stats_service, &srv_purge_service}) {
+    if (*service != nullptr) {
+      Srv_service::destroy(*service);
+    }
   }
 }
 
 void *InnoDB::master_thread(void*) noexcept {
   Cond_var* event;
   ulint old_activity_count;
-  ulint n_pages_purged = 0;
   ulint n_pages_flushed;
   ulint n_tables_to_drop;
   ulint n_ios;
@@ -1803,6 +2200,8 @@ void *InnoDB::master_thread(void*) noexcept {
 
   srv_main_thread_id = os_thread_pf(os_thread_get_curr_id());
 
+  os_thread_bind(OS_THREAD_CLASS_MASTER);
+
   auto slot_no = srv_table_reserve_slot(SRV_MASTER);
 
   mutex_enter(&kernel_mutex);
@@ -1812,11 +2211,12 @@ void *InnoDB::master_thread(void*) noexcept {
   mutex_exit(&kernel_mutex);
 
 loop:
-  /* When there is database activity by users, we cycle in this loop */
+  /* When there is database activity by users, we cycle in this loop. The
+  log sync, purge and the index statistics run in their own services. */
 
   srv_main_thread_op_info = "reserving kernel mutex";
 
-  n_ios_very_old = log_sys->m_n_log_ios + srv_buf_pool->m_stat.n_pages_read + srv_buf_pool->m_stat.n_pages_written;
+  n_ios_very_old = log_sys->m_n_log_ios + srv_buf_pool_get_n_ios();
   mutex_enter(&kernel_mutex);
 
   /* Store the user activity counter at the start of this loop */
@@ -1824,7 +2224,7 @@ loop:
 
   mutex_exit(&kernel_mutex);
 
-  if (srv_config.m_force_recovery >= IB_RECOVERY_NO_BACKGROUND) {
+  if (srv_config.m_force_recovery >= IB_RECOVERY_NO_BACKGROUND || srv_config.m_read_only) {
 
     goto suspend_thread;
   }
@@ -1832,7 +2232,6 @@ loop:
   /* We run the following loop approximately once per second
   when there is database activity */
 
-  srv_last_log_flush_time = time(nullptr);
   /* No need to sleep if user has signalled shutdown. */
   skip_sleep = (srv_shutdown_state != SRV_SHUTDOWN_NONE);
 
@@ -1849,8 +2248,6 @@ loop:
     /* No need to sleep if user has signalled shutdown. */
     skip_sleep = (srv_shutdown_state != SRV_SHUTDOWN_NONE);
 
-    /* No need to sleep if user has signalled shutdown. */
-
     /* ALTER TABLE on Unix requires that the table handler
     can drop tables lazily after there no longer are SELECT
     queries to them. */
@@ -1866,48 +2263,11 @@ loop:
       goto background_loop;
     }
 
-    /* Flush logs if needed */
-    srv_sync_log_buffer_in_background();
-
     srv_main_thread_op_info = "making checkpoint";
     log_sys->free_check();
 
-    n_pend_ios = srv_buf_pool->get_n_pending_ios() + log_sys->m_n_pending_writes;
-
-    n_ios = log_sys->m_n_log_ios + srv_buf_pool->m_stat.n_pages_read + srv_buf_pool->m_stat.n_pages_written;
-
-    if (unlikely(srv_buf_pool->get_modified_ratio_pct() > srv_config.m_max_buf_pool_modified_pct)) {
-
-      /* Try to keep the number of modified pages in the
-      buffer pool under the limit wished by the user */
-
-      srv_main_thread_op_info = "flushing buffer pool pages";
-      n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
-
-      /* If we had to do the flush, it may have taken
-      even more than 1 second, and also, there may be more
-      to flush. Do not sleep 1 second during the next
-      iteration of this loop. */
-
-      skip_sleep = true;
-
-    } else if (srv_config.m_adaptive_flushing) {
-
-      /* Try to keep the rate of flushing of dirty
-      pages such that redo log generation does not
-      produce bursts of IO at checkpoint time. */
-      ulint n_flush = srv_buf_pool->m_flusher->get_desired_flush_rate();
-
-      if (n_flush) {
-        srv_main_thread_op_info = "flushing buffer pool pages";
-        n_flush = std::min(PCT_IO(100), n_flush);
-        n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, n_flush, IB_ULONGLONG_MAX);
-
-        if (n_flush == PCT_IO(100)) {
-          skip_sleep = true;
-        }
-      }
-    }
+    /* The dirty pages are flushed once a second by the page cleaner, see
+    Page_cleaner::get_flush_list_targets(). */
 
     if (srv_activity_count == old_activity_count) {
 
@@ -1928,38 +2288,20 @@ loop:
   are not required, and may be disabled. */
 
   n_pend_ios = srv_buf_pool->get_n_pending_ios() + log_sys->m_n_pending_writes;
-  n_ios = log_sys->m_n_log_ios + srv_buf_pool->m_stat.n_pages_read + srv_buf_pool->m_stat.n_pages_written;
+  n_ios = log_sys->m_n_log_ios + srv_buf_pool_get_n_ios();
 
   ++srv_main_10_second_loops;
 
   if (n_pend_ios < SRV_PEND_IO_THRESHOLD && (n_ios - n_ios_very_old < SRV_PAST_IO_ACTIVITY)) {
 
     srv_main_thread_op_info = "flushing buffer pool pages";
-    srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_ULONGLONG_MAX);
-
-    /* Flush logs if needed */
-    srv_sync_log_buffer_in_background();
+    srv_buf_pool->flush_batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_ULONGLONG_MAX);
   }
 
-  /* Flush logs if needed */
-  srv_sync_log_buffer_in_background();
-
-  /* We run a full purge every 10 seconds, even if the server
-  were active */
-  do {
-
-    if (srv_config.m_fast_shutdown != IB_SHUTDOWN_NORMAL && srv_shutdown_state > 0) {
-
-      goto background_loop;
-    }
-
-    srv_main_thread_op_info = "purging";
-    n_pages_purged = srv_trx_sys->m_purge->run();
-
-    /* Flush logs if needed */
-    srv_sync_log_buffer_in_background();
+  if (srv_config.m_fast_shutdown != IB_SHUTDOWN_NORMAL && srv_shutdown_state > 0) {
 
-  } while (n_pages_purged);
+    goto background_loop;
+  }
 
   srv_main_thread_op_info = "flushing buffer pool pages";
 
@@ -1971,13 +2313,13 @@ loop:
     (> 70 %), we assume we can afford reserving the disk(s) for
     the time it requires to flush 100 pages */
 
-    n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
+    n_pages_flushed = srv_buf_pool->flush_batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
   } else {
     /* Otherwise, we only flush a small number of pages so that
     we do not unnecessarily use much disk i/o capacity from
     other work */
 
-    n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(10), IB_UINT64_T_MAX);
+    n_pages_flushed = srv_buf_pool->flush_batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(10), IB_UINT64_T_MAX);
   }
 
   srv_main_thread_op_info = "making checkpoint";
@@ -2030,32 +2372,6 @@ background_loop:
     os_thread_sleep(100000);
   }
 
-  srv_main_thread_op_info = "purging";
-
-  /* Run a full purge */
-  do {
-    if (srv_config.m_fast_shutdown != IB_SHUTDOWN_NORMAL && srv_shutdown_state > 0) {
-
-      break;
-    }
-
-    srv_main_thread_op_info = "purging";
-    n_pages_purged = srv_trx_sys->m_purge->run();
-
-    /* Flush logs if needed */
-    srv_sync_log_buffer_in_background();
-
-  } while (n_pages_purged);
-
-  srv_main_thread_op_info = "reserving kernel mutex";
-
-  mutex_enter(&kernel_mutex);
-  if (srv_activity_count != old_activity_count) {
-    mutex_exit(&kernel_mutex);
-    goto loop;
-  }
-  mutex_exit(&kernel_mutex);
-
   srv_main_thread_op_info = "reserving kernel mutex";
 
   mutex_enter(&kernel_mutex);
@@ -2070,8 +2386,8 @@ background_loop:
 flush_loop:
   srv_main_thread_op_info = "flushing buffer pool pages";
   srv_main_flush_loops++;
-  if (srv_config.m_fast_shutdown != IB_SHUTDOWN_NO_BUFPOOL_FLUSH) {
-    n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
+  if (!srv_shutdown_skips_flush(srv_config.m_fast_shutdown)) {
+    n_pages_flushed = srv_buf_pool->flush_batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
   } else {
     /* In the fastest shutdown we do not flush the buffer pool
     to data files: we set n_pages_flushed to 0 artificially. */
@@ -2089,10 +2405,7 @@ flush_loop:
   mutex_exit(&kernel_mutex);
 
   srv_main_thread_op_info = "waiting for buffer pool flush to end";
-  srv_buf_pool->m_flusher->wait_batch_end(BUF_FLUSH_LIST);
-
-  /* Flush logs if needed */
-  srv_sync_log_buffer_in_background();
+  srv_buf_pool->wait_batch_end(BUF_FLUSH_LIST);
 
   srv_main_thread_op_info = "making checkpoint";
 
@@ -2121,20 +2434,12 @@ flush_loop:
   }
   mutex_exit(&kernel_mutex);
 
-  /* Keep looping in the background loop if still work to do */
-
-  if (srv_config.m_fast_shutdown != IB_SHUTDOWN_NORMAL && srv_shutdown_state > 0) {
-    if (n_tables_to_drop + n_pages_flushed != 0) {
+  /* Keep looping in the background loop if still work to do. In a very
+  fast shutdown we do not flush the buffer pool to data files: we have set
+  n_pages_flushed to 0 artificially. A slow shutdown runs purge to
+  completion in the purge service, see srv_prepare_for_shutdown(). */
 
-      /* If we are doing a fast shutdown (= the default) we do not do purge.
-      But we flush the buffer pool completely to disk. In a 'very fast'
-      shutdown we do not flush the buffer pool to data files: we have
-      set n_pages_flushed to 0 artificially. */
-
-      goto background_loop;
-    }
-  } else if (n_tables_to_drop + n_pages_purged + n_pages_flushed != 0) {
-    /* In a 'slow' shutdown we run purge to completion */
+  if (n_tables_to_drop + n_pages_flushed != 0) {
 
     goto background_loop;
   }
@@ -40,17 +40,23 @@ Created 2/16/1996 Heikki Tuuri
 #include "btr0btr.h"
 #include "btr0cur.h"
 #include "btr0pcur.h"
+#include "btr0sea.h"
 #include "buf0buf.h"
 #include "buf0dblwr.h"
+#include "buf0dump.h"
 #include "buf0flu.h"
+#include "buf0l2.h"
 #include "buf0rea.h"
 #include "data0data.h"
 #include "data0type.h"
 #include "dict0dict.h"
 #include "dict0load.h"
 #include "fil0fil.h"
+#include "fil0prealloc.h"
+#include "fil0trim.h"
 #include "fsp0fsp.h"
 #include "lock0lock.h"
+#include "log0arch.h"
 #include "log0log.h"
 #include "log0recv.h"
 #include "mem0mem.h"
@@ -70,6 +76,8 @@ Created 2/16/1996 Heikki Tuuri
 #include "row0sel.h"
 #include "row0upd.h"
 #include "row0undo.h"
+#include "srv0conc.h"
+#include "srv0service.h"
 #include "srv0srv.h"
 #include "sync0sync.h"
 #include "trx0purge.h"
@@ -77,6 +85,7 @@ Created 2/16/1996 Heikki Tuuri
 #include "trx0sys.h"
 #include "trx0trx.h"
 #include "srv0srv.h"
+#include "srv0task.h"
 #include "usr0sess.h"
 #include "ut0mem.h"
 
@@ -95,6 +104,8 @@ uint64_t srv_start_lsn;
 /** Log sequence number at shutdown */
 uint64_t srv_shutdown_lsn;
 
+Startup_stats srv_startup_stats;
+
 /** true if a raw partition is in use */
 bool srv_start_raw_disk_in_use = false;
 
@@ -143,6 +154,8 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
 void *io_handler_thread(void *arg) {
   auto segment = *((ulint *)arg);
 
+  os_thread_bind(OS_THREAD_CLASS_IO);
+
   while (srv_fil->aio_wait(segment)) { }
 
   /* We count the number of threads in os_thread_exit(). A created
@@ -326,13 +339,27 @@ static db_err open_system_tablespace(const std::string &path, lsn_t &flushed_lsn
   /* Convert to number of pages. */
   size /= UNIV_PAGE_SIZE;
 
-  srv_fil->read_flushed_lsn(fh, flushed_lsn);
+  ulint page_size_shift{};
+
+  srv_fil->read_flushed_lsn(fh, flushed_lsn, page_size_shift);
 
   {
     auto success = os_file_close(fh);
     ut_a(success);
   }
 
+  if (page_size_shift < 12 || page_size_shift > 16) {
+    log_err(std::format("The system tablespace '{}' has an invalid page size shift {}", filename.generic_string(), page_size_shift));
+    return DB_CORRUPTION;
+  } else if (page_size_shift != UNIV_PAGE_SIZE_SHIFT) {
+    log_err(std::format(
+      "The system tablespace '{}' has a page size of {} bytes but the library was built with {},"
+      " build it with -DIB_PAGE_SIZE={} to open it",
+      filename.generic_string(), 1UL << page_size_shift, UNIV_PAGE_SIZE, 1UL << page_size_shift
+    ));
+    return DB_ERROR;
+  }
+
   {
     auto success = srv_fil->space_create(filename.c_str(), SYS_TABLESPACE, 0, FIL_TABLESPACE);
     ut_a(success);
@@ -351,6 +378,11 @@ static db_err open_system_tablespace(const std::string &path, lsn_t &flushed_lsn
  * @param err Current error code
  */
 static void srv_startup_abort(db_err err) noexcept {
+  /* The tablespaces may still be loading in the background. */
+  if (srv_fil != nullptr) {
+    (void) srv_fil->wait_for_tablespaces();
+  }
+
   /* This is currently required to inform the master thread only. Once
   we have contexts we can get rid of this global. */
   srv_config.m_fast_shutdown = IB_SHUTDOWN_NORMAL;
@@ -368,6 +400,21 @@ static void srv_startup_abort(db_err err) noexcept {
 
   srv_threads_shutdown();
 
+  InnoDB::destroy_services();
+
+  if (srv_task_scheduler != nullptr) {
+    srv_task_scheduler->shutdown();
+    Task_scheduler::destroy(srv_task_scheduler);
+  }
+
+  if (srv_conc != nullptr) {
+    Srv_conc::destroy(srv_conc);
+  }
+
+  if (srv_log_arch != nullptr) {
+    Log_archiver::destroy(srv_log_arch);
+  }
+
   log_sys->shutdown();
 
   srv_buf_pool->close();
@@ -386,9 +433,63 @@ static void srv_startup_abort(db_err err) noexcept {
   delete srv_buf_pool;
 }
 
+/**
+ * Starts archiving the log if log_archive_dir is set. The log must have been
+ * opened and its last checkpoint read.
+ *
+ * @return DB_SUCCESS or error code
+ */
+static db_err srv_start_log_archive() noexcept {
+  if (!Log_archiver::is_enabled() || srv_config.m_read_only) {
+    return DB_SUCCESS;
+  }
+
+  srv_log_arch = Log_archiver::create();
+
+  return srv_log_arch != nullptr ? DB_SUCCESS : DB_ERROR;
+}
+
+const char *to_string(Startup_step step) noexcept {
+  switch (step) {
+    case STARTUP_STEP_BUF_POOL:
+      return "buffer pool";
+    case STARTUP_STEP_FILES:
+      return "files";
+    case STARTUP_STEP_TABLESPACES:
+      return "tablespaces";
+    case STARTUP_STEP_RECOVERY:
+      return "recovery";
+    case STARTUP_STEP_DICT:
+      return "dictionary";
+    case STARTUP_STEP_THREADS:
+      return "threads";
+    case STARTUP_STEP_N:
+      break;
+  }
+
+  ut_error;
+  return nullptr;
+}
+
+std::string Startup_stats::to_string() const noexcept {
+  std::string str{"Startup summary:"};
+
+  for (ulint i{}; i < STARTUP_STEP_N; ++i) {
+    str += std::format(" {}: {} ms;", ::to_string(Startup_step(i)), m_time_us[i] / 1000);
+  }
+
+  str += std::format(" total: {} ms", m_total_us / 1000);
+
+  return str;
+}
+
 ib_err_t InnoDB::start() noexcept {
   ut_a(!srv_was_started);
 
+  const auto start_time{std::chrono::steady_clock::now()};
+
+  srv_startup_stats.clear();
+
   // FIXME:
   ib_stream = stderr;
 
@@ -469,7 +570,14 @@ ib_err_t InnoDB::start() noexcept {
 
   os_file_init();
 
-  srv_aio = AIO::create(io_limit, srv_config.m_n_read_io_threads, srv_config.m_n_write_io_threads);
+  srv_aio = AIO::create(
+    io_limit,
+    srv_config.m_n_read_io_threads,
+    srv_config.m_n_write_io_threads,
+    srv_config.m_aio_sqpoll,
+    srv_config.m_aio_per_cpu_queues,
+    std::chrono::microseconds(srv_config.m_aio_write_coalesce_window)
+  );
 
   if (srv_aio == nullptr) {
     log_err("Failed to create an AIO instance.");
@@ -491,6 +599,8 @@ ib_err_t InnoDB::start() noexcept {
     return DB_OUT_OF_MEMORY;
   }
 
+  auto step_start{std::chrono::steady_clock::now()};
+
   srv_buf_pool = new (std::nothrow) Buf_pool();
 
   if (!srv_buf_pool->open(srv_config.m_buf_pool_size)) {
@@ -507,12 +617,27 @@ ib_err_t InnoDB::start() noexcept {
     return DB_OUT_OF_MEMORY;
   }
 
+  srv_startup_stats.add_time(STARTUP_STEP_BUF_POOL, step_start);
+
   ut_a(log_sys == nullptr);
   log_sys = Log::create();
 
   ut_a(srv_fsp == nullptr);
   srv_fsp = FSP::create(log_sys, srv_fil, srv_buf_pool);
 
+  /* Resolve the CPUs of the background threads before any is created. */
+  os_thread_class_cpus_init(srv_config.m_data_home);
+
+  /* Created before the tablespaces are loaded, the loading runs on it. */
+  ut_a(srv_task_scheduler == nullptr);
+  srv_task_scheduler = Task_scheduler::create(std::min(srv_config.m_n_task_threads, ulint{256}));
+  ut_a(srv_task_scheduler != nullptr);
+  srv_task_scheduler->start();
+
+  ut_a(srv_conc == nullptr);
+  srv_conc = Srv_conc::create();
+  ut_a(srv_conc != nullptr);
+
   ut_a(srv_trx_sys == nullptr);
   srv_trx_sys = Trx_sys::create(srv_fsp);
 
@@ -522,6 +647,9 @@ ib_err_t InnoDB::start() noexcept {
   ut_a(srv_btree_sys == nullptr);
   srv_btree_sys = Btree::create(srv_lock_sys, srv_fsp, srv_buf_pool);
 
+  ut_a(srv_btr_search == nullptr);
+  srv_btr_search = Btr_search::create(srv_config.m_adaptive_hash_index_parts, srv_config.m_buf_pool_size / UNIV_PAGE_SIZE);
+
   ut_a(srv_undo == nullptr);
   srv_undo = Undo::create(srv_fsp);
 
@@ -536,6 +664,8 @@ ib_err_t InnoDB::start() noexcept {
   bool create_new_db{};
   lsn_t max_flushed_lsn{};
 
+  step_start = std::chrono::steady_clock::now();
+
   {
     namespace fs = std::filesystem;
 
@@ -555,7 +685,10 @@ ib_err_t InnoDB::start() noexcept {
 
     filename /= "system.ibd";
 
-    if (!fs::exists(filename)) {
+    if (!fs::exists(filename) && srv_config.m_read_only) {
+      log_err(std::format("{} does not exist, a read-only instance cannot create it", filename.generic_string()));
+      return DB_ERROR;
+    } else if (!fs::exists(filename)) {
       err = create_system_tablespace(filename);
 
       if (err == DB_SUCCESS) {
@@ -580,6 +713,21 @@ ib_err_t InnoDB::start() noexcept {
   /* Note: Currently we support a single log group (0). */
   std::string log_dir{InnoDB::get_log_dir()};
 
+  /* The number of files can have been changed at runtime, see
+  Log::resize_files(): the files that exist win over the configuration,
+  the recovery uses the number the last checkpoint was written with. */
+  ulint n_found{};
+
+  while (std::filesystem::exists(std::filesystem::path(log_dir) / std::format("ib_logfile{}", n_found))) {
+    ++n_found;
+  }
+
+  if (n_found >= 2 && n_found != srv_config.m_n_log_files) {
+    log_info(std::format("Found {} log files, log_files_in_group is {}: opening the files found", n_found, srv_config.m_n_log_files));
+
+    srv_config.m_n_log_files = n_found;
+  }
+
   ut_a(srv_config.m_n_log_files >= 2);
 
   auto success = srv_fil->space_create(log_dir.c_str(), SRV_LOG_SPACE_FIRST_ID, 0, FIL_LOG);
@@ -594,6 +742,9 @@ ib_err_t InnoDB::start() noexcept {
     if (fs::exists(filename) && fs::status(filename).type() == fs::file_type::regular) {
       err = open_log_file(filename.generic_string());
       log_opened = true;
+    } else if (srv_config.m_read_only) {
+      log_err(std::format("{} does not exist, a read-only instance cannot create it", filename.generic_string()));
+      err = DB_ERROR;
     } else {
       err = create_log_file(filename.generic_string());
       log_created = true;
@@ -646,6 +797,10 @@ ib_err_t InnoDB::start() noexcept {
     log_sys->release();
   }
 
+  srv_startup_stats.add_time(STARTUP_STEP_FILES, step_start);
+
+  step_start = std::chrono::steady_clock::now();
+
   if (create_new_db) {
     mtr_t mtr;
 
@@ -750,6 +905,15 @@ ib_err_t InnoDB::start() noexcept {
       log_sys->make_checkpoint_at(IB_UINT64_T_MAX, true);
     }
 
+    err = srv_start_log_archive();
+
+    if (err != DB_SUCCESS) {
+      srv_startup_abort(err);
+      return DB_ERROR;
+    }
+
+    srv_startup_stats.add_time(STARTUP_STEP_DICT, step_start);
+
   } else {
 
     if (err != DB_SUCCESS) {
@@ -769,7 +933,8 @@ ib_err_t InnoDB::start() noexcept {
     std::pair<page_no_t, page_no_t> offsets{};
 
     if (!DBLWR::check_if_exists(srv_fil, offsets)) {
-      err = srv_dblwr->initialize();
+      /* A read-only instance never writes pages, it has no use for one. */
+      err = srv_config.m_read_only ? DB_SUCCESS : srv_dblwr->initialize();
 
       if (err != DB_SUCCESS) {
         srv_startup_abort(err);
@@ -780,17 +945,17 @@ ib_err_t InnoDB::start() noexcept {
       srv_dblwr->m_block2 = offsets.second;
     }
 
-    log_warn("Reading tablespace information from the .ibd files...");
-
-    /* Recursively scan to a depth of 2. InnoDB needs to do this because the DD
-    can't be accessed until recovery is done. So we have this simplistic scheme. */
-    srv_fil->load_single_table_tablespaces(srv_config.m_data_home, srv_config.m_force_recovery, 2);
-
-    /* We always instantiate the DBLWR buffer. Restore the pages in data files,
-     * and restore them from the doublewrite buffer if possible */
-    if (srv_config.m_force_recovery < IB_RECOVERY_NO_LOG_REDO) {
-      log_warn("Restoring possible half-written data pages from the doublewrite buffer...");
-      srv_dblwr->recover_pages();
+    /* In the lazy mode the .ibd files are scanned and the doublewrite buffer
+    is restored only if the log shows that crash recovery is needed, see
+    recv_start_crash_recovery(). Otherwise the .ibd files are read in the
+    background while the log is scanned, the crash recovery waits for them
+    before it parses the log records. */
+    if (!srv_config.m_lazy_tablespace_load) {
+      log_warn("Reading tablespace information from the .ibd files...");
+
+      /* Recursively scan to a depth of 2. InnoDB needs to do this because the DD
+      can't be accessed until recovery is done. So we have this simplistic scheme. */
+      srv_fil->start_loading_tablespaces(srv_config.m_data_home, srv_config.m_force_recovery, 2);
     }
 
     /* We always try to do a recovery, even if the database had
@@ -803,6 +968,27 @@ ib_err_t InnoDB::start() noexcept {
       return DB_ERROR;
     }
 
+    /* If no crash recovery was needed the tablespaces may still be loading.
+    We always instantiate the DBLWR buffer. Restore the pages in data files,
+    and restore them from the doublewrite buffer if possible */
+    if (srv_fil->wait_for_tablespaces() && srv_config.m_force_recovery < IB_RECOVERY_NO_LOG_REDO) {
+      log_warn("Restoring possible half-written data pages from the doublewrite buffer...");
+      srv_dblwr->recover_pages();
+    }
+
+    /* Archive the log from the recovered checkpoint on, before the recovery
+    makes a new checkpoint. */
+    err = srv_start_log_archive();
+
+    if (err != DB_SUCCESS) {
+      srv_startup_abort(err);
+      return DB_ERROR;
+    }
+
+    srv_startup_stats.add_time(STARTUP_STEP_RECOVERY, step_start);
+
+    step_start = std::chrono::steady_clock::now();
+
     err = srv_trx_sys->start(srv_config.m_force_recovery);
 
     {
@@ -889,10 +1075,24 @@ ib_err_t InnoDB::start() noexcept {
     srv_startup_is_before_trx_rollback_phase = false;
 
     recv_recovery_rollback_active();
+
+    srv_startup_stats.add_time(STARTUP_STEP_DICT, step_start);
+  }
+
+  step_start = std::chrono::steady_clock::now();
+
+  if (srv_config.m_force_recovery == IB_RECOVERY_DEFAULT && !srv_config.m_read_only) {
+    /* Existing rollback segments are never dropped, a smaller value only
+    means that no new ones are created. */
+    srv_trx_sys->create_rsegs(srv_config.m_n_rollback_segments);
   }
 
   log_info("Max allowed record size ", page_get_free_space_of_empty() / 2);
 
+  /* Create the log writer and log flusher threads that the committing
+  transactions wait for, one flush covers a group of commits. */
+  log_sys->start_threads();
+
   /* Create the thread which watches the timeouts for lock waits */
   os_thread_create(&InnoDB::lock_timeout_thread, nullptr, &thread_ids[2 + SRV_MAX_N_IO_THREADS]);
 
@@ -905,23 +1105,113 @@ ib_err_t InnoDB::start() noexcept {
   srv_is_being_started = false;
 
   ut_a(err == DB_SUCCESS);
-  err = srv_dict_sys->m_store.create_or_check_foreign_constraint_tables();
 
-  if (err != DB_SUCCESS) {
-    srv_startup_abort(err);
-    return DB_ERROR;
+  /* A read-only instance uses the system tables that exist, the statistics
+  are then only kept in memory. */
+  if (!srv_config.m_read_only) {
+    err = srv_dict_sys->m_store.create_or_check_foreign_constraint_tables();
+
+    if (err != DB_SUCCESS) {
+      srv_startup_abort(err);
+      return DB_ERROR;
+    }
+
+    err = srv_dict_sys->m_store.create_or_check_histogram_table();
+
+    if (err != DB_SUCCESS) {
+      srv_startup_abort(err);
+      return DB_ERROR;
+    }
+
+    err = srv_dict_sys->m_store.create_or_check_index_stats_table();
+
+    if (err != DB_SUCCESS) {
+      srv_startup_abort(err);
+      return DB_ERROR;
+    }
   }
 
-  /* Create the master thread which does purge and other utility
-  operations */
+  /* Create the master thread which does the background drops, flushing
+  and checkpoints, and the services that run the other activities. */
 
   os_thread_create(&InnoDB::master_thread, nullptr, thread_ids + (1 + SRV_MAX_N_IO_THREADS));
 
+  if (!InnoDB::create_services()) {
+    srv_startup_abort(DB_OUT_OF_MEMORY);
+    return DB_ERROR;
+  }
+
+  /* Create the page cleaner that keeps the free lists and the flush
+  lists of the buffer pool instances in check. */
+
+  if (srv_config.m_force_recovery < IB_RECOVERY_NO_BACKGROUND && !srv_config.m_read_only) {
+    const auto n_threads = std::min(srv_config.m_n_page_cleaner_threads, srv_buf_pool->get_n_instances());
+
+    srv_page_cleaner = Page_cleaner::create(n_threads);
+
+    if (srv_page_cleaner == nullptr) {
+      srv_startup_abort(DB_OUT_OF_MEMORY);
+      return DB_ERROR;
+    }
+
+    srv_page_cleaner->start();
+  }
+
+  /* Cache the evicted pages on the local device, if configured. A failure
+to create the cache file only disables the cache. */
+
+  srv_buf_l2 = srv_config.m_read_only ? nullptr : Buf_l2_cache::create();
+
+  if (srv_buf_l2 != nullptr) {
+    srv_buf_l2->start();
+  }
+
+  /* Warm up the buffer pool from the dump of the previous shutdown and
+  dump it periodically, if configured. */
+
+  if (srv_config.m_force_recovery < IB_RECOVERY_NO_BACKGROUND && !srv_config.m_read_only) {
+    srv_buf_dump = Buf_dump::create();
+
+    if (srv_buf_dump == nullptr) {
+      srv_startup_abort(DB_OUT_OF_MEMORY);
+      return DB_ERROR;
+    }
+
+    srv_buf_dump->start();
+
+    srv_fil_prealloc = Fil_prealloc::create(srv_fil);
+
+    if (srv_fil_prealloc == nullptr) {
+      srv_startup_abort(DB_OUT_OF_MEMORY);
+      return DB_ERROR;
+    }
+
+    srv_fil_prealloc->start();
+
+    srv_fil_trim = Fil_trim::create(srv_fsp);
+
+    if (srv_fil_trim == nullptr) {
+      srv_startup_abort(DB_OUT_OF_MEMORY);
+      return DB_ERROR;
+    }
+
+    srv_fil_trim->start();
+
+    srv_fil->start_file_closer();
+  }
+
   {
     const auto size = srv_fsp->get_system_space_size();
     log_info(std::format("system.ibd file size in the header is {} pages", size));
   }
 
+  srv_startup_stats.add_time(STARTUP_STEP_THREADS, step_start);
+
+  srv_startup_stats.m_total_us = uint64_t(
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count());
+
+  log_info(srv_startup_stats.to_string());
+
   log_info(std::format(
     "InnoDB {} started; log sequence number {}",
     VERSION, srv_start_lsn
@@ -931,6 +1221,10 @@ ib_err_t InnoDB::start() noexcept {
     log_warn(std::format("!!! force_recovery is set to {} !!!", (int) srv_config.m_force_recovery));
   }
 
+  if (srv_config.m_read_only) {
+    log_info("Started in read-only mode");
+  }
+
   srv_was_started = true;
 
   return DB_SUCCESS;
@@ -1002,6 +1296,39 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
 
   srv_shutdown_state = SRV_SHUTDOWN_CLEANUP;
 
+  /* Stop the load and dump the hottest pages while the buffer pool is
+  still fully populated. A fast-warm shutdown dumps all of them. */
+  if (srv_buf_dump != nullptr) {
+    srv_buf_dump->shutdown(shutdown == IB_SHUTDOWN_FAST_WARM);
+  }
+
+  if (srv_fil_prealloc != nullptr) {
+    srv_fil_prealloc->shutdown();
+  }
+
+  if (srv_fil_trim != nullptr) {
+    srv_fil_trim->shutdown();
+  }
+
+  if (srv_fil != nullptr) {
+    srv_fil->shutdown_file_closer();
+  }
+
+  /* Purge keeps running, a slow shutdown waits for it below. */
+  if (srv_log_sync_service != nullptr) {
+    srv_log_sync_service->shutdown();
+  }
+
+  if (srv_stats_service != nullptr) {
+    srv_stats_service->shutdown();
+  }
+
+  /* The master thread does the final flush of the buffer pool, the page
+  cleaner must not race with the checkpoint below. */
+  if (srv_page_cleaner != nullptr) {
+    srv_page_cleaner->shutdown();
+  }
+
   lsn_t lsn;
 
   for (;;) {
@@ -1013,7 +1340,7 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
     normal shutdown. In case of very fast shutdown, however, we can
     proceed without waiting for monitor threads. */
 
-    if (shutdown != IB_SHUTDOWN_NO_BUFPOOL_FLUSH &&
+    if (!srv_shutdown_skips_flush(shutdown) &&
         (srv_error_monitor_active || srv_lock_timeout_active || srv_monitor_active)) {
 
       mutex_exit(&kernel_mutex);
@@ -1031,7 +1358,16 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
       continue;
     }
 
-    if (shutdown == IB_SHUTDOWN_NO_BUFPOOL_FLUSH) {
+    if (srv_config.m_read_only) {
+      /* Nothing was written, the files are left as they were: the next
+      startup of these files sees the same clean shutdown. */
+
+      mutex_exit(&kernel_mutex);
+
+      return;
+    }
+
+    if (srv_shutdown_skips_flush(shutdown)) {
       /* In this fastest shutdown we do not flush the buffer pool:
       it is essentially a 'crash' of the InnoDB server. Make sure
       that the log is all flushed to disk, so that we can recover
@@ -1044,9 +1380,31 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
 
       mutex_exit(&kernel_mutex);
 
+      /* The checkpoint does not flush any pages, it moves up to the oldest
+      modification in the buffer pool so that the recovery only scans and
+      applies the log written after it. The purge position is in the undo
+      logs, it is recovered with them. */
+      if (shutdown == IB_SHUTDOWN_FAST_WARM) {
+        while (!log_sys->checkpoint(true, true)) {}
+
+        log_info(std::format("Fast-warm shutdown, checkpoint at {}, log flushed up to {}",
+          log_sys->m_last_checkpoint_lsn.load(), log_sys->get_lsn()));
+      }
+
       return; /* We SKIP ALL THE REST !! */
     }
 
+    mutex_exit(&kernel_mutex);
+
+    /* In a slow shutdown purge runs until it finds no more work, in the
+    other shutdowns it stops after the current round. It must be done
+    before the final checkpoint. */
+    if (srv_purge_service != nullptr) {
+      srv_purge_service->shutdown(shutdown == IB_SHUTDOWN_NORMAL);
+    }
+
+    mutex_enter(&kernel_mutex);
+
     /* Check that the master thread is suspended */
     if (srv_n_threads_active[SRV_MASTER] != 0) {
 
@@ -1077,7 +1435,7 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
 
     log_sys->acquire();
 
-    lsn = log_sys->m_lsn;
+    lsn = log_sys->get_lsn();
 
     if (lsn != log_sys->m_last_checkpoint_lsn) {
 
@@ -1117,7 +1475,7 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
   srv_shutdown_state = SRV_SHUTDOWN_LAST_PHASE;
 
   /* Make some checks that the server really is quiet */
-  ut_a(lsn == log_sys->m_lsn);
+  ut_a(lsn == log_sys->get_lsn());
   ut_a(srv_buf_pool->all_freed());
   ut_a(srv_n_threads_active[SRV_MASTER] == 0);
 
@@ -1139,7 +1497,7 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
   /* Make some checks that the server really is quiet */
   ut_a(srv_n_threads_active[SRV_MASTER] == 0);
   ut_a(srv_buf_pool->all_freed());
-  ut_a(lsn == log_sys->m_lsn);
+  ut_a(lsn == log_sys->get_lsn());
 }
 
 db_err InnoDB::shutdown(ib_shutdown_t shutdown) noexcept {
@@ -1160,6 +1518,13 @@ db_err InnoDB::shutdown(ib_shutdown_t shutdown) noexcept {
       " the InnoDB buffer pool to data files. At the next startup"
       " InnoDB will do a crash recovery!"
     );
+  } else if (shutdown == IB_SHUTDOWN_FAST_WARM) {
+    log_warn(
+      "User has requested a fast-warm shutdown without flushing"
+      " the InnoDB buffer pool to data files. At the next startup"
+      " InnoDB will recover from the last checkpoint and load the"
+      " buffer pool dump!"
+    );
   }
 
   /* Only if the redo log systemhas been initialized. */
@@ -1171,12 +1536,48 @@ db_err InnoDB::shutdown(ib_shutdown_t shutdown) noexcept {
   to die; all which counts is that we flushed the log; a 'very fast'
   shutdown is essentially a crash. */
 
-  if (shutdown == IB_SHUTDOWN_NO_BUFPOOL_FLUSH) {
+  if (srv_shutdown_skips_flush(shutdown)) {
     return DB_SUCCESS;
   }
 
   srv_threads_shutdown();
 
+  InnoDB::destroy_services();
+
+  if (srv_page_cleaner != nullptr) {
+    Page_cleaner::destroy(srv_page_cleaner);
+  }
+
+  if (srv_buf_dump != nullptr) {
+    Buf_dump::destroy(srv_buf_dump);
+  }
+
+  if (srv_fil_prealloc != nullptr) {
+    Fil_prealloc::destroy(srv_fil_prealloc);
+  }
+
+  if (srv_fil_trim != nullptr) {
+    Fil_trim::destroy(srv_fil_trim);
+  }
+
+  if (srv_task_scheduler != nullptr) {
+    srv_task_scheduler->shutdown();
+    Task_scheduler::destroy(srv_task_scheduler);
+  }
+
+  if (srv_conc != nullptr) {
+    Srv_conc::destroy(srv_conc);
+  }
+
+  if (srv_buf_l2 != nullptr) {
+    srv_buf_l2->shutdown();
+    Buf_l2_cache::destroy(srv_buf_l2);
+  }
+
+  if (srv_log_arch != nullptr) {
+    Log_archiver::destroy(srv_log_arch);
+  }
+
   log_sys->shutdown();
 
   Row_insert::destroy(srv_row_ins);
@@ -1194,6 +1595,8 @@ db_err InnoDB::shutdown(ib_shutdown_t shutdown) noexcept {
 
   Btree::destroy(srv_btree_sys);
 
+  Btr_search::destroy(srv_btr_search);
+
   Lock_sys::destroy(srv_lock_sys);
 
   Trx_sys::destroy(srv_trx_sys);
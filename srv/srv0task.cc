@@ -0,0 +1,229 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file srv/srv0task.cc
+Shared pool of worker threads for the parallel work of the engine
+*******************************************************/
+
+#include "srv0task.h"
+#include "srv0srv.h"
+#include "os0thread-create.h"
+
+#include <algorithm>
+
+Task_scheduler *srv_task_scheduler{};
+
+Task_scheduler::Task_scheduler(ulint n_workers) noexcept : m_n_workers(std::max(n_workers, ulint{1})) {}
+
+Task_scheduler::~Task_scheduler() noexcept {
+  ut_a(m_threads.empty());
+
+  for (const auto &queue : m_queues) {
+    ut_a(queue.empty());
+  }
+}
+
+Task_scheduler *Task_scheduler::create(ulint n_workers) noexcept {
+  auto ptr = ut_new(sizeof(Task_scheduler));
+  return ptr == nullptr ? nullptr : new (ptr) Task_scheduler(n_workers);
+}
+
+void Task_scheduler::destroy(Task_scheduler *&scheduler) noexcept {
+  call_destructor(scheduler);
+  ut_delete(scheduler);
+  scheduler = nullptr;
+}
+
+void Task_scheduler::start() noexcept {
+  ut_a(m_threads.empty());
+
+  m_shutdown = false;
+
+  for (ulint i{}; i < m_n_workers; ++i) {
+    m_threads.push_back(create_joinable_thread(&Task_scheduler::worker, this));
+  }
+}
+
+void Task_scheduler::shutdown() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_shutdown = true;
+  }
+
+  m_cv.notify_all();
+
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+
+  m_threads.clear();
+}
+
+ulint Task_scheduler::limit(Task_class task_class) noexcept {
+  switch (task_class) {
+    case Task_class::Purge:
+      return std::max(srv_config.m_n_purge_threads, ulint{1});
+
+    case Task_class::Tablespace_load:
+      return std::max(srv_config.m_n_tablespace_load_threads, ulint{1});
+
+    case Task_class::Index_build:
+      return std::max(srv_config.m_n_index_build_threads, ulint{1});
+
+    case Task_class::Background:
+      return ULINT_MAX;
+  }
+
+  ut_error;
+  return 0;
+}
+
+void Task_scheduler::submit(Task_group *group, Task &&task) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_queues[size_t(group->get_class())].push_back({group, std::move(task)});
+  }
+
+  m_cv.notify_one();
+}
+
+bool Task_scheduler::run_queued(Task_group *group) noexcept {
+  Queued queued;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto &queue = m_queues[size_t(group->get_class())];
+    auto it = std::find_if(queue.begin(), queue.end(), [group](const Queued &q) { return q.m_group == group; });
+
+    if (it == queue.end()) {
+      return false;
+    }
+
+    queued = std::move(*it);
+    queue.erase(it);
+  }
+
+  queued.m_task();
+  queued.m_task = nullptr;
+
+  group->task_done();
+
+  return true;
+}
+
+size_t Task_scheduler::next(Queued &queued) noexcept {
+  for (size_t i{}; i < N_TASK_CLASSES; ++i) {
+    if (!m_queues[i].empty() && m_n_running[i] < limit(Task_class(i))) {
+      queued = std::move(m_queues[i].front());
+      m_queues[i].pop_front();
+      ++m_n_running[i];
+      return i;
+    }
+  }
+
+  return N_TASK_CLASSES;
+}
+
+void Task_scheduler::worker() noexcept {
+  os_thread_bind(OS_THREAD_CLASS_TASK);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;) {
+    Queued queued;
+    size_t task_class;
+
+    m_cv.wait(lock, [&] {
+      task_class = next(queued);
+
+      return task_class < N_TASK_CLASSES || (m_shutdown && std::all_of(m_queues.begin(), m_queues.end(), [](const auto &queue) { return queue.empty(); }));
+    });
+
+    if (task_class == N_TASK_CLASSES) {
+      break;
+    }
+
+    lock.unlock();
+
+    queued.m_task();
+
+    /* The group can go away once the task is done, drop the callable
+    and its captures before. */
+    queued.m_task = nullptr;
+    queued.m_group->task_done();
+
+    lock.lock();
+
+    --m_n_running[task_class];
+
+    /* Another worker may be waiting for a task of this class. */
+    m_cv.notify_all();
+  }
+}
+
+Task_group::Task_group(Task_class task_class) noexcept : m_task_class(task_class), m_scheduler(srv_task_scheduler) {}
+
+Task_group::~Task_group() noexcept {
+  ut_a(m_n_pending == 0);
+  ut_a(m_threads.empty());
+}
+
+void Task_group::run(Task_scheduler::Task &&task) noexcept {
+  if (m_scheduler == nullptr) {
+    m_threads.push_back(create_joinable_thread(std::move(task)));
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ++m_n_pending;
+  }
+
+  m_scheduler->submit(this, std::move(task));
+}
+
+void Task_group::task_done() noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  ut_a(m_n_pending > 0);
+
+  if (--m_n_pending == 0) {
+    m_cv.notify_all();
+  }
+}
+
+void Task_group::wait() noexcept {
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+
+  m_threads.clear();
+
+  if (m_scheduler != nullptr) {
+    while (m_scheduler->run_queued(this)) {
+      ;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_cv.wait(lock, [this] { return m_n_pending == 0; });
+  }
+}
@@ -29,6 +29,7 @@ The wait array used in synchronization primitives
 Created 9/5/1995 Heikki Tuuri
 *******************************************************/
 
+#include <mutex>
 #include <sstream>
 #include <vector>
 
@@ -66,12 +67,19 @@ of each cell of wait array having one event.  Instead, now the event that
 a thread wants to wait on is embedded in the wait object (mutex or rw_lock).
 We still keep the global wait array for the sake of diagnostics and also
 to avoid infinite wait The error_monitor thread scans the global wait
-array to signal any waiting threads who have missed the signal. */
+array to signal any waiting threads who have missed the signal.
+
+The array is no longer protected by a global mutex either. A waiting thread
+claims a free cell with an atomic flag, starting from the cell it used the
+last time, and the cell has its own mutex that serializes the thread with the
+scans of the error monitor. The waiters of a latch park on the event of the
+latch and the releaser wakes them directly, the array is only a registry of
+the current waits for the diagnostics and the wake up fallback. */
 
 /** A cell where an individual thread may wait suspended
 until a resource is released. The suspending is implemented
 using an operating system event semaphore. */
-struct Sync_cell {
+struct alignas(hardware_destructive_interference_size) Sync_cell {
   /** Determines if we can wake up the thread waiting for a sempahore. */
   bool can_wake_up();
 
@@ -114,13 +122,18 @@ struct Sync_cell {
 
   /** time when the thread reserved the wait cell */
   time_t m_reservation_time{};
+
+  /** true while a thread owns the cell, set with a compare and swap */
+  std::atomic<bool> m_reserved{};
+
+  /** Protects the fields above while the cell is owned, the owner
+  thread writes them and the error monitor reads them */
+  std::mutex m_mutex{};
 };
 
-/* NOTE: It is allowed for a thread to wait
-for an event allocated for the array without owning the
-protecting mutex (depending on the case: OS or database mutex), but
-all changes (set or reset) to the state of the event must be made
-while owning the mutex. */
+/* NOTE: A thread waits for the event of its cell without owning the
+cell mutex, but all changes (set or reset) to the state of the event
+made through the array are made while owning the cell mutex. */
 
 using Cells = std::vector<Sync_cell>;
 
@@ -147,15 +160,15 @@ struct Sync_check {
   @return true if deadlock detected */
   bool deadlock_step(Sync_cell *start, os_thread_id_t thread, ulint pass, ulint depth);
 
-  /** Prints info of the wait array.
-  NOTE! caller must own the mutex
+  /** Prints info of the wait array, the reserved cells are latched
+  one at a time.
   @param[in,out] ib_stream        Where to print. */
   void output_info(ib_stream_t ib_stream);
 
-  /** Reserves the mutex semaphore protecting a sync array. */
+  /** Reserves the mutex semaphore that serializes the deadlock checks. */
   void acquire();
 
-  /** Releases the mutex semaphore protecting a sync array. */
+  /** Releases the mutex semaphore that serializes the deadlock checks. */
   void release();
 
   /** Validate the instance. */
@@ -173,7 +186,7 @@ struct Sync_check {
 #endif /* UNIV_SYNC_DEBUG */
 
   /** Number of currently reserved cells in the wait array */
-  ulint m_n_reserved{};
+  std::atomic<ulint> m_n_reserved{};
 
   /** Wait array */
   Cells m_cells{};
@@ -181,10 +194,10 @@ struct Sync_check {
   /** This flag tells which mutex protects the data */
   ulint m_protection{};
 
-  /** Possible database mutex protecting this data structure */
+  /** Possible database mutex serializing the deadlock checks */
   mutex_t m_mutex{};
 
-  /** Possible operating system mutex protecting the data structure.
+  /** Possible operating system mutex serializing the deadlock checks.
   As this data structure is used in constructing the database mutex, to
   prevent infinite recursion in implementation, we fall back to an OS mutex. */
   OS_mutex *m_os_mutex{};
@@ -193,11 +206,16 @@ struct Sync_check {
   std::atomic<ulint> m_sg_count{};
 
   /** Count of cell reservations since creation of the array */
-  ulint m_res_count{};
+  std::atomic<ulint> m_res_count{};
+
+  /** Hands out the first cell that a thread tries */
+  std::atomic<ulint> m_next_hint{};
 };
 
-Sync_check::Sync_check(ulint n, ulint p) : m_protection(p) {
-  m_cells.resize(n);
+/** The cell that the thread reserved the last time, it is tried first. */
+static thread_local ulint sync_cell_hint{ULINT_UNDEFINED};
+
+Sync_check::Sync_check(ulint n, ulint p) : m_cells(n), m_protection(p) {
 
   /* Then create the mutex to protect the wait array complex */
   if (m_protection == SYNC_ARRAY_OS_MUTEX) {
@@ -243,17 +261,15 @@ void Sync_check::release() {
 void Sync_check::validate() {
   ulint count{};
 
-  acquire();
-
   for (auto &cell : m_cells) {
+    std::lock_guard<std::mutex> guard(cell.m_mutex);
+
     if (cell.m_wait_object != nullptr) {
       count++;
     }
   }
 
-  ut_a(count == m_n_reserved);
-
-  release();
+  ut_a(count == m_n_reserved.load());
 }
 
 Sync_check *sync_array_create(ulint n_cells, ulint protection) {
@@ -277,7 +293,7 @@ Cond_var* Sync_cell::get_event() {
     return reinterpret_cast<mutex_t *>(m_wait_object)->event;
   } else if (m_request_type == RW_LOCK_WAIT_EX) {
     return reinterpret_cast<rw_lock_t *>(m_wait_object)->m_wait_ex_event;
-  } else { /* RW_LOCK_SHARED and RW_LOCK_EX wait on the same event */
+  } else { /* RW_LOCK_SHARED, RW_LOCK_SX and RW_LOCK_EX wait on the same event */
     return reinterpret_cast<rw_lock_t *>(m_wait_object)->m_event;
   }
 }
@@ -286,70 +302,81 @@ void sync_array_reserve_cell(Sync_check *arr, void *object, ulint type, const ch
   ut_a(index != nullptr);
   ut_a(object != nullptr);
 
-  arr->acquire();
-
-  ++arr->m_res_count;
+  arr->m_res_count.fetch_add(1, std::memory_order_relaxed);
 
-  ulint i{};
+  const auto n_cells = arr->m_cells.size();
 
-  /* Reserve a new cell. */
-  for (auto &cell : arr->m_cells) {
+  if (sync_cell_hint == ULINT_UNDEFINED) {
+    sync_cell_hint = arr->m_next_hint.fetch_add(1, std::memory_order_relaxed) % n_cells;
+  }
 
-    ++i;
+  /* Reserve a new cell, without a global latch. */
+  for (ulint i{}; i < n_cells; ++i) {
+    const auto j = (sync_cell_hint + i) % n_cells;
+    auto &cell = arr->m_cells[j];
+    bool reserved{};
 
-    if (cell.m_wait_object != nullptr) {
+    if (cell.m_reserved.load(std::memory_order_relaxed) ||
+        !cell.m_reserved.compare_exchange_strong(reserved, true, std::memory_order_acquire)) {
       continue;
     }
 
-    cell.m_waiting = false;
-    cell.m_wait_object = object;
+    {
+      std::lock_guard<std::mutex> guard(cell.m_mutex);
 
-    if (type == SYNC_MUTEX) {
-      cell.m_old_wait_mutex = static_cast<mutex_t *>(object);
-    } else {
-      cell.m_old_wait_rw_lock = static_cast<rw_lock_t *>(object);
-    }
+      cell.m_waiting = false;
+      cell.m_wait_object = object;
+
+      if (type == SYNC_MUTEX) {
+        cell.m_old_wait_mutex = static_cast<mutex_t *>(object);
+      } else {
+        cell.m_old_wait_rw_lock = static_cast<rw_lock_t *>(object);
+      }
 
-    cell.m_request_type = type;
+      cell.m_request_type = type;
 
-    cell.m_file = file;
-    cell.m_line = line;
+      cell.m_file = file;
+      cell.m_line = line;
 
-    ++arr->m_n_reserved;
+      /* Make sure the event is reset and also store the value of
+      m_signal_count at which the event was reset. */
+      cell.m_signal_count = os_event_reset(cell.get_event());
 
-    *index = i - 1;
+      cell.m_reservation_time = time(nullptr);
 
-    arr->release();
+      cell.m_thread = os_thread_get_curr_id();
+    }
 
-    /* Make sure the event is reset and also store the value of
-    m_signal_count at which the event was reset. */
-    cell.m_signal_count = os_event_reset(cell.get_event());
+    arr->m_n_reserved.fetch_add(1, std::memory_order_relaxed);
 
-    cell.m_reservation_time = time(nullptr);
+    sync_cell_hint = j;
 
-    cell.m_thread = os_thread_get_curr_id();
+    *index = j;
 
     return;
   }
 
   /* No free cell found */
   ut_error;
-
-  return;
 }
 
 void sync_array_wait_event(Sync_check *arr, ulint index) {
-  arr->acquire();
-
   auto &cell = arr->m_cells[index];
+  Cond_var *event;
+  int64_t signal_count;
 
-  ut_a(!cell.m_waiting);
-  ut_a(cell.m_wait_object != nullptr);
-  ut_ad(os_thread_get_curr_id() == cell.m_thread);
+  {
+    std::lock_guard<std::mutex> guard(cell.m_mutex);
 
-  auto event = cell.get_event();
+    ut_a(!cell.m_waiting);
+    ut_a(cell.m_wait_object != nullptr);
+    ut_ad(os_thread_get_curr_id() == cell.m_thread);
 
-  cell.m_waiting = true;
+    event = cell.get_event();
+    signal_count = cell.m_signal_count;
+
+    cell.m_waiting = true;
+  }
 
 #ifdef UNIV_SYNC_DEBUG
 
@@ -358,6 +385,8 @@ void sync_array_wait_event(Sync_check *arr, ulint index) {
   recursively sync_array routines, leading to trouble.
   rw_lock_debug_mutex freezes the debug lists. */
 
+  arr->acquire();
+
   rw_lock_debug_mutex_enter();
 
   if (sync_array_detect_deadlock(arr, &cell, &cell, 0)) {
@@ -367,11 +396,11 @@ void sync_array_wait_event(Sync_check *arr, ulint index) {
   }
 
   rw_lock_debug_mutex_exit();
-#endif /* UNIV_SYNC_DEBUG */
 
   arr->release();
+#endif /* UNIV_SYNC_DEBUG */
 
-  os_event_wait_low(event, cell.m_signal_count);
+  os_event_wait_low(event, signal_count);
 
   sync_array_free_cell(arr, index);
 }
@@ -402,9 +431,9 @@ void Sync_cell::print(ib_stream_t ib_stream) {
       (ulong)mutex->m_waiters.load()
     );
 
-  } else if (type == RW_LOCK_EX || type == RW_LOCK_WAIT_EX || type == RW_LOCK_SHARED) {
+  } else if (type == RW_LOCK_EX || type == RW_LOCK_SX || type == RW_LOCK_WAIT_EX || type == RW_LOCK_SHARED) {
 
-    ib_logger(ib_stream, "%s", type == RW_LOCK_EX ? "X-lock on" : "S-lock on");
+    ib_logger(ib_stream, "%s", type == RW_LOCK_EX ? "X-lock on" : type == RW_LOCK_SX ? "SX-lock on" : "S-lock on");
 
     auto rwlock = m_old_wait_rw_lock;
 
@@ -424,7 +453,10 @@ void Sync_cell::print(ib_stream_t ib_stream) {
       ib_logger(
         ib_stream,
         "a writer (thread id %lu) has reserved it in mode %s",
-        (ulong)thread_id, writer == RW_LOCK_EX ? " exclusive" : " wait exclusive"
+        (ulong)thread_id,
+        writer == RW_LOCK_EX   ? " exclusive"
+        : writer == RW_LOCK_SX ? " shared exclusive"
+                               : " wait exclusive"
       );
     }
 
@@ -544,7 +576,7 @@ bool Sync_check::detect_deadlock(Sync_cell *start, Sync_cell *cell, ulint depth)
     /* No deadlock */
     return false;
 
-  } else if (cell->m_request_type == RW_LOCK_EX || cell->m_request_type == RW_LOCK_WAIT_EX) {
+  } else if (cell->m_request_type == RW_LOCK_EX || cell->m_request_type == RW_LOCK_SX || cell->m_request_type == RW_LOCK_WAIT_EX) {
 
     rw_lock_t *lock = cell->m_wait_object;
 
@@ -553,8 +585,9 @@ bool Sync_check::detect_deadlock(Sync_cell *start, Sync_cell *cell, ulint depth)
       auto thread = debug->thread_id;
 
       if (((debug->lock_type == RW_LOCK_EX) && !os_thread_eq(thread, cell->m_thread)) ||
+          ((debug->lock_type == RW_LOCK_SX) && !os_thread_eq(thread, cell->m_thread)) ||
           ((debug->lock_type == RW_LOCK_WAIT_EX) && !os_thread_eq(thread, cell->m_thread)) ||
-	  debug->lock_type == RW_LOCK_SHARED) {
+	  (debug->lock_type == RW_LOCK_SHARED && cell->m_request_type != RW_LOCK_SX)) {
 
         /* The (wait) x-lock request can block infinitely only if someone (can be also cell
         thread) is holding s-lock, or someone (cannot be cell thread) (wait) x-lock, and
@@ -615,11 +648,11 @@ bool Sync_cell::can_wake_up() {
       return true;
     }
 
-  } else if (m_request_type == RW_LOCK_EX) {
+  } else if (m_request_type == RW_LOCK_EX || m_request_type == RW_LOCK_SX) {
 
     auto lock = static_cast<rw_lock_t *>(m_wait_object);
 
-    if (lock->m_lock_word > 0) {
+    if (lock->m_lock_word > X_LOCK_HALF_DECR) {
 
       /* Either unlocked or only read locked. */
 
@@ -630,8 +663,9 @@ bool Sync_cell::can_wake_up() {
 
     auto lock = static_cast<rw_lock_t *>(m_wait_object);
 
-    /* lock_word == 0 means all readers have left */
-    if (lock->m_lock_word == 0) {
+    /* lock_word == 0 means all readers have left, -X_LOCK_HALF_DECR
+    the same for a waiter that holds an sx-lock */
+    if (lock->m_lock_word == 0 || lock->m_lock_word == -X_LOCK_HALF_DECR) {
 
       return true;
     }
@@ -651,53 +685,45 @@ bool Sync_cell::can_wake_up() {
 }
 
 void sync_array_free_cell(Sync_check *arr, ulint index) {
-  arr->acquire();
-
   auto &cell = arr->m_cells[index];
 
-  ut_a(cell.m_wait_object != nullptr);
+  {
+    std::lock_guard<std::mutex> guard(cell.m_mutex);
 
-  cell.m_waiting = false;
-  cell.m_wait_object = nullptr;
-  cell.m_signal_count = 0;
+    ut_a(cell.m_wait_object != nullptr);
 
-  ut_a(arr->m_n_reserved > 0);
-  --arr->m_n_reserved;
+    cell.m_waiting = false;
+    cell.m_wait_object = nullptr;
+    cell.m_signal_count = 0;
+  }
 
-  arr->release();
+  const auto n_reserved = arr->m_n_reserved.fetch_sub(1, std::memory_order_relaxed);
+  ut_a(n_reserved > 0);
+
+  cell.m_reserved.store(false, std::memory_order_release);
 }
 
 void sync_array_object_signalled(Sync_check *arr) {
-  arr->m_sg_count.fetch_add(1);
+  arr->m_sg_count.fetch_add(1, std::memory_order_relaxed);
 }
 
 void sync_arr_wake_threads_if_sema_free() {
   auto arr = sync_primary_wait_array;
 
-  arr->acquire();
-
-  ulint i{};
-  ulint count{};
-
-  while (count < arr->m_n_reserved) {
-    auto &cell = arr->m_cells[i];
-
-    ++i;
+  for (auto &cell : arr->m_cells) {
 
-    if (cell.m_wait_object == nullptr) {
+    if (!cell.m_reserved.load(std::memory_order_relaxed)) {
 
       continue;
     }
 
-    ++count;
+    std::lock_guard<std::mutex> guard(cell.m_mutex);
 
-    if (cell.can_wake_up()) {
+    if (cell.m_wait_object != nullptr && cell.can_wake_up()) {
 
       os_event_set(cell.get_event());
     }
   }
-
-  arr->release();
 }
 
 bool sync_array_print_long_waits() {
@@ -709,6 +735,13 @@ bool sync_array_print_long_waits() {
 
   for (auto &cell : arr->m_cells) {
 
+    if (!cell.m_reserved.load(std::memory_order_relaxed)) {
+
+      continue;
+    }
+
+    std::lock_guard<std::mutex> guard(cell.m_mutex);
+
     if (cell.m_wait_object != nullptr && cell.m_waiting && difftime(time(nullptr), cell.m_reservation_time) > 240) {
       ib_logger(ib_stream, "Warning: a long semaphore wait:\n");
       cell.print(ib_stream);
@@ -748,28 +781,25 @@ bool sync_array_print_long_waits() {
 }
 
 void Sync_check::output_info(ib_stream_t ib_stream) {
-  ib_logger(ib_stream, "OS WAIT ARRAY INFO: reservation count %ld, signal count %ld\n", (long)m_res_count, (long)m_sg_count);
+  ib_logger(
+    ib_stream, "OS WAIT ARRAY INFO: reservation count %ld, signal count %ld\n", (long)m_res_count.load(), (long)m_sg_count.load()
+  );
 
-  ulint i{};
-  ulint count{};
+  for (auto &cell : m_cells) {
 
-  while (count < m_n_reserved) {
+    if (!cell.m_reserved.load(std::memory_order_relaxed)) {
 
-    auto &cell = m_cells[i];
+      continue;
+    }
+
+    std::lock_guard<std::mutex> guard(cell.m_mutex);
 
     if (cell.m_wait_object != nullptr) {
-      count++;
       cell.print(ib_stream);
     }
-
-    i++;
   }
 }
 
 void sync_array_print_info(ib_stream_t ib_stream, Sync_check *arr) {
-  arr->acquire();
-
   arr->output_info(ib_stream);
-
-  arr->release();
 }
@@ -40,23 +40,45 @@ Created 9/11/1995 Heikki Tuuri
         IMPLEMENTATION OF THE RW_LOCK
         =============================
 The status of a rw_lock is held in lock_word. The initial value of lock_word is
-X_LOCK_DECR. lock_word is decremented by 1 for each s-lock and by X_LOCK_DECR
-for each x-lock. This describes the lock state for each value of lock_word:
+X_LOCK_DECR. lock_word is decremented by 1 for each s-lock, by X_LOCK_DECR
+for each x-lock and by X_LOCK_HALF_DECR for the first sx-lock of the holder.
+This describes the lock state for each value of lock_word:
 
 lock_word == X_LOCK_DECR:      Unlocked.
-0 < lock_word < X_LOCK_DECR:   Read locked, no waiting writers.
+X_LOCK_HALF_DECR < lock_word < X_LOCK_DECR:
+                               Read locked, no waiting writers.
                                (X_LOCK_DECR - lock_word) is the
                                number of readers that hold the lock.
+lock_word == X_LOCK_HALF_DECR: SX locked, no readers.
+0 < lock_word < X_LOCK_HALF_DECR:
+                               SX locked and read locked.
+                               (X_LOCK_HALF_DECR - lock_word) is the
+                               number of readers that hold the lock.
 lock_word == 0:		       Write locked
--X_LOCK_DECR < lock_word < 0:  Read locked, with a waiting writer.
+-X_LOCK_HALF_DECR < lock_word < 0:
+                               Read locked, with a waiting writer.
                                (-lock_word) is the number of readers
                                that hold the lock.
+lock_word == -X_LOCK_HALF_DECR:
+                               Write and SX locked by the same thread.
+-X_LOCK_DECR < lock_word < -X_LOCK_HALF_DECR:
+                               Read locked, with a waiting writer that
+                               holds the SX lock.
+                               (-(lock_word + X_LOCK_HALF_DECR)) is the
+                               number of readers that hold the lock.
 lock_word <= -X_LOCK_DECR:     Recursively write locked. lock_word has been
                                decremented by X_LOCK_DECR once for each lock,
                                so the number of locks is:
-                               ((-lock_word) / X_LOCK_DECR) + 1
-When lock_word <= -X_LOCK_DECR, we also know that lock_word % X_LOCK_DECR == 0:
-other values of lock_word are invalid.
+                               ((-lock_word) / X_LOCK_DECR) + 1, after
+                               adding back X_LOCK_HALF_DECR if the writer
+                               also holds the SX lock.
+When lock_word <= -X_LOCK_DECR, we also know that
+lock_word % X_LOCK_HALF_DECR == 0: other values of lock_word are invalid.
+
+The SX lock is not counted in lock_word once it is held, further sx-locks of
+the holder only increment sx_recursive. Because an sx-lock leaves lock_word
+positive, readers are let in and only x-lock and sx-lock requests, which
+must find lock_word > X_LOCK_HALF_DECR, wait.
 
 The lock_word is always read and updated atomically and consistently, so that
 it always represents the state of the lock, and the state of the lock changes
@@ -85,6 +107,8 @@ recursive:	This and the writer_thread field together control the
                 This flag must be set after the writer_thread field
                 has been updated with a memory ordering barrier.
                 It is unset before the lock_word has been incremented.
+                An sx-lock holder sets it like an x-lock holder does, it is
+                unset when the last of the x-locks and sx-locks is released.
 writer_thread:	Is used only in recursive x-locking. Can only be safely
                 read iff lock->m_recursive flag is true.
                 This field is uninitialized at lock creation time and
@@ -228,11 +252,13 @@ void rw_lock_create_func(
 
   lock->m_waiters = 0;
   lock->m_lock_word = X_LOCK_DECR;
+  lock->m_x_version = 0;
 
   /* We set this value to signify that lock->m_writer_thread
   contains garbage at initialization and cannot be used for
   recursive x-locking. */
   lock->m_recursive = false;
+  lock->m_sx_recursive = 0;
 
 #ifdef UNIV_SYNC_DEBUG
   UT_LIST_INIT(lock->m_debug_list);
@@ -246,6 +272,8 @@ void rw_lock_create_func(
   lock->m_cline = (unsigned int)cline;
 
   lock->m_count_os_wait = 0;
+  lock->m_spin.init(SYNC_SPIN_ROUNDS);
+  lock->m_class = sync_latch_class_get(cfile_name, cline);
   lock->m_last_s_file_name = "not yet reserved";
   lock->m_last_x_file_name = "not yet reserved";
   lock->m_last_s_line = 0;
@@ -296,7 +324,7 @@ bool rw_lock_validate(rw_lock_t *lock) {
 
   ut_a(lock->m_magic_n == RW_LOCK_MAGIC_N);
   ut_a(waiters == 0 || waiters == 1);
-  ut_a(lock_word > -X_LOCK_DECR || (-lock_word) % X_LOCK_DECR == 0);
+  ut_a(lock_word > -X_LOCK_DECR || (-lock_word) % X_LOCK_HALF_DECR == 0);
 
   return true;
 }
@@ -305,14 +333,22 @@ bool rw_lock_validate(rw_lock_t *lock) {
 void rw_lock_s_lock_spin(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
   ulint i{};
   ulint index; /* index of the reserved wait cell */
+  auto latch_class = lock->m_class;
+  Sync_wait_timer timer(latch_class, lock);
 
   ut_ad(rw_lock_validate(lock));
 
+  timer.start();
+
   rw_s_spin_wait_count++; /*!< Count calls to this function */
+  latch_class->m_spin_waits.fetch_add(1, std::memory_order_relaxed);
+
 lock_loop:
 
+  const auto n_rounds = lock->m_spin.budget(SYNC_SPIN_ROUNDS);
+
   /* Spin waiting for the writer field to become free */
-  while (i < SYNC_SPIN_ROUNDS && lock->m_lock_word <= 0) {
+  while (i < n_rounds && lock->m_lock_word <= 0) {
     if (srv_spin_wait_delay) {
       ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
     }
@@ -320,7 +356,7 @@ lock_loop:
     i++;
   }
 
-  if (i == SYNC_SPIN_ROUNDS) {
+  if (i >= n_rounds) {
     os_thread_yield();
   }
 
@@ -340,15 +376,19 @@ lock_loop:
   /* We try once again to obtain the lock */
   if (true == rw_lock_s_lock_low(lock, pass, file_name, line)) {
     rw_s_spin_round_count += i;
+    latch_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
+    latch_class->m_spin_acquired.fetch_add(1, std::memory_order_relaxed);
+    lock->m_spin.acquired(i);
 
     return; /* Success */
   } else {
 
-    if (i < SYNC_SPIN_ROUNDS) {
+    if (i < n_rounds) {
       goto lock_loop;
     }
 
     rw_s_spin_round_count += i;
+    latch_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
 
     sync_array_reserve_cell(sync_primary_wait_array, lock, RW_LOCK_SHARED, file_name, line, &index);
 
@@ -376,6 +416,8 @@ lock_loop:
     /* these stats may not be accurate */
     lock->m_count_os_wait++;
     rw_s_os_wait_count++;
+    latch_class->m_os_waits.fetch_add(1, std::memory_order_relaxed);
+    lock->m_spin.parked();
 
     sync_array_wait_event(sync_primary_wait_array, index);
 
@@ -395,6 +437,9 @@ The caller must have already decremented lock_word by X_LOCK_DECR.
 @param[in] lock                 Select the next writer waiting on this lock.
 @param[in] pass                 Value; != 0, if the lock will be passed
                                 to another thread to unlock
+@param[in] threshold            lock_word once the readers have exited:
+                                0, or -X_LOCK_HALF_DECR if the caller
+                                holds an sx-lock.
 @param[in] file_name            File name where lock requested
 @param[in] line                 Line where requested */
 inline void rw_lock_x_lock_wait(
@@ -402,36 +447,39 @@ inline void rw_lock_x_lock_wait(
 #ifdef UNIV_SYNC_DEBUG
   ulint pass,
 #endif /* UNIV_SYNC_DEBUG */
-  const char *file_name, ulint line
+  lint threshold, const char *file_name, ulint line
 ) {
   ulint index;
   ulint i = 0;
+  const auto n_rounds = lock->m_spin.budget(SYNC_SPIN_ROUNDS);
 
-  ut_ad(lock->m_lock_word <= 0);
+  ut_ad(lock->m_lock_word <= threshold);
 
-  while (lock->m_lock_word < 0) {
+  while (lock->m_lock_word < threshold) {
     if (srv_spin_wait_delay) {
       ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
     }
 
-    if (i < SYNC_SPIN_ROUNDS) {
+    if (i < n_rounds) {
       i++;
       continue;
     }
 
     /* If there is still a reader, then go to sleep.*/
     rw_x_spin_round_count += i;
+    lock->m_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
 
     i = 0;
 
     sync_array_reserve_cell(sync_primary_wait_array, lock, RW_LOCK_WAIT_EX, file_name, line, &index);
 
     /* Check lock_word to ensure wake-up isn't missed.*/
-    if (lock->m_lock_word < 0) {
+    if (lock->m_lock_word < threshold) {
 
       /* These stats may not be accurate */
       ++rw_x_os_wait_count;
       ++lock->m_count_os_wait;
+      lock->m_class->m_os_waits.fetch_add(1, std::memory_order_relaxed);
 
       /* Add debug info as it is needed to detect possible
       deadlock. We must add info for WAIT_EX thread for
@@ -445,7 +493,7 @@ inline void rw_lock_x_lock_wait(
       rw_lock_remove_debug_info(lock, pass, RW_LOCK_WAIT_EX);
 #endif /* UNIV_SYNC_DEBUG */
 
-      /* It is possible to wake when lock_word < 0.
+      /* It is possible to wake when lock_word < threshold.
       We must pass the while-loop check to proceed.*/
     } else {
       sync_array_free_cell(sync_primary_wait_array, index);
@@ -463,7 +511,7 @@ inline void rw_lock_x_lock_wait(
 @param[in] line            Line in filen_ame where requested
 @return	RW_LOCK_NOT_LOCKED if did not succeed, RW_LOCK_EX if success. */
 inline bool rw_lock_x_lock_low(rw_lock_t *lock, ulint pass, const char *file_name, ulint line) {
-  if (rw_lock_lock_word_decr(lock, X_LOCK_DECR)) {
+  if (rw_lock_lock_word_decr(lock, X_LOCK_DECR, X_LOCK_HALF_DECR)) {
 
     /* lock->m_recursive also tells us if the writer_thread
     field is stale or active. As we are going to write
@@ -479,6 +527,7 @@ inline bool rw_lock_x_lock_low(rw_lock_t *lock, ulint pass, const char *file_nam
 #ifdef UNIV_SYNC_DEBUG
       pass,
 #endif /* UNIV_SYNC_DEBUG */
+      0,
       file_name,
       line
     );
@@ -486,8 +535,22 @@ inline bool rw_lock_x_lock_low(rw_lock_t *lock, ulint pass, const char *file_nam
   } else {
     /* Decrement failed: relock or failed lock */
     if (!pass && lock->m_recursive && lock->m_writer_thread.load() == std::this_thread::get_id()) {
-      /* Relock */
-      lock->m_lock_word -= X_LOCK_DECR;
+      if (rw_lock_lock_word_decr(lock, X_LOCK_DECR, 0)) {
+        /* This thread holds an sx-lock but no x-lock, wait for the
+        other readers to exit. */
+        rw_lock_x_lock_wait(
+          lock,
+#ifdef UNIV_SYNC_DEBUG
+          pass,
+#endif /* UNIV_SYNC_DEBUG */
+          -X_LOCK_HALF_DECR,
+          file_name,
+          line
+        );
+      } else {
+        /* Relock */
+        lock->m_lock_word -= X_LOCK_DECR;
+      }
     } else {
       /* Another thread locked before us */
       return false;
@@ -507,34 +570,48 @@ void rw_lock_x_lock_func(rw_lock_t *lock, ulint pass, const char *file_name, uli
   ulint i;
   ulint index;
   bool spinning{false};
+  auto latch_class = lock->m_class;
+  Sync_wait_timer timer(latch_class, lock);
 
   ut_ad(rw_lock_validate(lock));
 
+  latch_class->acquire();
+
   i = 0;
 
 lock_loop:
 
+  const auto n_rounds = lock->m_spin.budget(SYNC_SPIN_ROUNDS);
+
   if (rw_lock_x_lock_low(lock, pass, file_name, line)) {
     rw_x_spin_round_count += i;
 
+    if (spinning) {
+      latch_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
+      latch_class->m_spin_acquired.fetch_add(1, std::memory_order_relaxed);
+      lock->m_spin.acquired(i);
+    }
+
     return; /* Locking succeeded */
 
   } else {
 
     if (!spinning) {
       spinning = true;
+      timer.start();
       rw_x_spin_wait_count++;
+      latch_class->m_spin_waits.fetch_add(1, std::memory_order_relaxed);
     }
 
     /* Spin waiting for the lock_word to become free */
-    while (i < SYNC_SPIN_ROUNDS && lock->m_lock_word <= 0) {
+    while (i < n_rounds && lock->m_lock_word <= X_LOCK_HALF_DECR) {
       if (srv_spin_wait_delay) {
         ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
       }
 
       i++;
     }
-    if (i == SYNC_SPIN_ROUNDS) {
+    if (i >= n_rounds) {
       os_thread_yield();
     } else {
       goto lock_loop;
@@ -542,6 +619,7 @@ lock_loop:
   }
 
   rw_x_spin_round_count += i;
+  latch_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
 
   if (srv_print_latch_waits) {
     ib_logger(
@@ -582,6 +660,121 @@ lock_loop:
   /* these stats may not be accurate */
   lock->m_count_os_wait++;
   rw_x_os_wait_count++;
+  latch_class->m_os_waits.fetch_add(1, std::memory_order_relaxed);
+  lock->m_spin.parked();
+
+  sync_array_wait_event(sync_primary_wait_array, index);
+
+  i = 0;
+  goto lock_loop;
+}
+
+/** Low-level function for acquiring a shared-exclusive lock.
+@param[in,out] lock,       Lock instance on which to acquire an sx-lock
+@param[in] file_name       File name where lock requested
+@param[in] line            Line in filen_ame where requested
+@return	true if success. */
+inline bool rw_lock_sx_lock_low(rw_lock_t *lock, const char *file_name, ulint line) {
+  if (rw_lock_lock_word_decr(lock, X_LOCK_HALF_DECR, X_LOCK_HALF_DECR)) {
+
+    /* See rw_lock_x_lock_low(), the sx-lock does not wait for the
+    readers to exit. */
+    ut_a(!lock->m_recursive);
+
+    rw_lock_set_writer_id_and_recursion_flag(lock, true);
+
+  } else if (lock->m_recursive && lock->m_writer_thread.load() == std::this_thread::get_id()) {
+    /* Relock: this thread holds an x-lock or an sx-lock. */
+    if (lock->m_sx_recursive == 0) {
+      /* Only x-locked, there are no readers to race with. */
+      lock->m_lock_word -= X_LOCK_HALF_DECR;
+    }
+  } else {
+    /* Another thread locked before us */
+    return false;
+  }
+
+  ++lock->m_sx_recursive;
+
+#ifdef UNIV_SYNC_DEBUG
+  rw_lock_add_debug_info(lock, 0, RW_LOCK_SX, file_name, line);
+#endif /* UNIV_SYNC_DEBUG */
+
+  lock->m_last_x_file_name = file_name;
+  lock->m_last_x_line = (unsigned int)line;
+
+  return true;
+}
+
+void rw_lock_sx_lock_func(rw_lock_t *lock, const char *file_name, ulint line) {
+  ulint i{};
+  ulint index;
+  bool spinning{false};
+  auto latch_class = lock->m_class;
+  Sync_wait_timer timer(latch_class, lock);
+
+  ut_ad(rw_lock_validate(lock));
+
+  latch_class->acquire();
+
+lock_loop:
+
+  const auto n_rounds = lock->m_spin.budget(SYNC_SPIN_ROUNDS);
+
+  if (rw_lock_sx_lock_low(lock, file_name, line)) {
+    rw_x_spin_round_count += i;
+
+    if (spinning) {
+      latch_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
+      latch_class->m_spin_acquired.fetch_add(1, std::memory_order_relaxed);
+      lock->m_spin.acquired(i);
+    }
+
+    return; /* Locking succeeded */
+
+  } else {
+
+    if (!spinning) {
+      spinning = true;
+      timer.start();
+      rw_x_spin_wait_count++;
+      latch_class->m_spin_waits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /* Spin waiting for the lock_word to become free of writers */
+    while (i < n_rounds && lock->m_lock_word <= X_LOCK_HALF_DECR) {
+      if (srv_spin_wait_delay) {
+        ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+      }
+
+      i++;
+    }
+    if (i >= n_rounds) {
+      os_thread_yield();
+    } else {
+      goto lock_loop;
+    }
+  }
+
+  rw_x_spin_round_count += i;
+  latch_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
+
+  sync_array_reserve_cell(sync_primary_wait_array, lock, RW_LOCK_SX, file_name, line, &index);
+
+  /* Waiters must be set before checking lock_word, to ensure signal
+  is sent. This could lead to a few unnecessary wake-up signals. */
+  rw_lock_set_waiter_flag(lock);
+
+  if (rw_lock_sx_lock_low(lock, file_name, line)) {
+    sync_array_free_cell(sync_primary_wait_array, index);
+    return; /* Locking succeeded */
+  }
+
+  /* these stats may not be accurate */
+  lock->m_count_os_wait++;
+  rw_x_os_wait_count++;
+  latch_class->m_os_waits.fetch_add(1, std::memory_order_relaxed);
+  lock->m_spin.parked();
 
   sync_array_wait_event(sync_primary_wait_array, index);
 
@@ -711,6 +904,10 @@ bool rw_lock_is_locked(rw_lock_t *lock, ulint lock_type) {
     if (rw_lock_get_writer(lock) == RW_LOCK_EX) {
       ret = true;
     }
+  } else if (lock_type == RW_LOCK_SX) {
+    if (rw_lock_get_writer(lock) == RW_LOCK_SX) {
+      ret = true;
+    }
   } else {
     ut_error;
   }
@@ -801,6 +998,8 @@ void rw_lock_debug_print(rw_lock_debug_t *info) {
     ib_logger(ib_stream, "S-LOCK");
   } else if (rwt == RW_LOCK_EX) {
     ib_logger(ib_stream, "X-LOCK");
+  } else if (rwt == RW_LOCK_SX) {
+    ib_logger(ib_stream, "SX-LOCK");
   } else if (rwt == RW_LOCK_WAIT_EX) {
     ib_logger(ib_stream, "WAIT X-LOCK");
   } else {
@@ -31,6 +31,13 @@ Created 9/5/1995 Heikki Tuuri
 
 #include "sync0sync.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include "buf0buf.h"
 #include "buf0types.h"
 #include "os0sync.h"
@@ -174,6 +181,26 @@ static counter_t mutex_os_wait_count{};
 /** The number of mutex_exit() calls. Intended for performance monitoring. */
 counter_t mutex_exit_count{};
 
+bool sync_latch_profile{false};
+
+/** The registered latch classes, keyed by "file:line". The classes are
+never freed, latches may outlive sync_close(). */
+struct Sync_latch_classes {
+  /** Protects m_classes. Latches are created outside the latching order,
+  so this cannot be one of our own mutexes. */
+  std::mutex m_mutex{};
+
+  /** The classes */
+  std::map<std::string, std::unique_ptr<Sync_latch_class>> m_classes{};
+};
+
+/** @return the latch class registry */
+static Sync_latch_classes &sync_latch_classes() noexcept {
+  static Sync_latch_classes classes;
+
+  return classes;
+}
+
 /** The global array of wait cells for implementation of the database's own
 mutexes and read-write locks */
 Sync_check *sync_primary_wait_array;
@@ -244,6 +271,9 @@ void mutex_create(mutex_t *mutex, IF_DEBUG(const char *cmutex_name, ) IF_SYNC_DE
 
   mutex->init();
 
+  mutex->m_spin.init(SYNC_SPIN_ROUNDS);
+  mutex->m_class = sync_latch_class_get(loc.m_from.file_name(), loc.m_from.line());
+
   IF_SYNC_DEBUG(mutex->file_name = "not yet reserved"; mutex->level = level;)
 
   IF_SYNC_DEBUG(mutex->cfile_name = cfile_name; mutex->cline = cline;)
@@ -338,16 +368,23 @@ void mutex_set_waiters(mutex_t *mutex, ulint n) {
 void mutex_spin_wait(mutex_t *mutex, const char *file_name, ulint line) {
   ulint i;     /* spin round count */
   ulint index; /* index of the reserved wait cell */
+  ulint n_rounds; /* spin budget for this round of spinning */
+  auto latch_class = mutex->m_class;
+  Sync_wait_timer timer(latch_class, mutex);
+
+  timer.start();
 
   /* This update is not thread safe, but we don't mind if the count
   isn't exact. Moved out of ifdef that follows because we are willing
   to sacrifice the cost of counting this as the data is valuable.
   Count the number of calls to mutex_spin_wait. */
   mutex_spin_wait_count.inc(1);
+  latch_class->m_spin_waits.fetch_add(1, std::memory_order_relaxed);
 
 mutex_loop:
 
   i = 0;
+  n_rounds = mutex->m_spin.budget(SYNC_SPIN_ROUNDS);
 
   /* Spin waiting for the lock word to become zero. Note that we do
   not have to assume that the read access to the lock word is atomic,
@@ -358,7 +395,7 @@ mutex_loop:
 spin_loop:
   ut_d(mutex->count_spin_loop++);
 
-  while (mutex_get_lock_word(mutex) != 0 && i < SYNC_SPIN_ROUNDS) {
+  while (mutex_get_lock_word(mutex) != 0 && i < n_rounds) {
     if (srv_spin_wait_delay) {
       ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
     }
@@ -366,18 +403,22 @@ spin_loop:
     i++;
   }
 
-  if (i == SYNC_SPIN_ROUNDS) {
+  if (i == n_rounds) {
     ut_d(mutex->count_os_yield++);
     os_thread_yield();
   }
 
   mutex_spin_round_count.inc(i);
+  latch_class->m_spin_rounds.fetch_add(i, std::memory_order_relaxed);
 
   ut_d(mutex->count_spin_rounds += i);
 
   if (mutex_test_and_set(mutex) == 0) {
     /* Succeeded! */
 
+    mutex->m_spin.acquired(i);
+    latch_class->m_spin_acquired.fetch_add(1, std::memory_order_relaxed);
+
     ut_d(mutex->thread_id = os_thread_get_curr_id());
     IF_SYNC_DEBUG(mutex_set_debug_info(mutex, file_name, line));
 
@@ -393,7 +434,7 @@ spin_loop:
 
   i++;
 
-  if (i < SYNC_SPIN_ROUNDS) {
+  if (i < n_rounds) {
     goto spin_loop;
   }
 
@@ -431,6 +472,9 @@ spin_loop:
   Now there is no risk of infinite wait on the event. */
 
   mutex_os_wait_count.inc(1);
+  latch_class->m_os_waits.fetch_add(1, std::memory_order_relaxed);
+
+  mutex->m_spin.parked();
 
   mutex->count_os_wait++;
 
@@ -863,6 +907,7 @@ void sync_thread_add_level(void *latch, ulint level) {
     case SYNC_TRX_SYS_HEADER:
     case SYNC_FILE_FORMAT_TAG:
     case SYNC_DOUBLEWRITE:
+    case SYNC_BUF_FLUSH_LIST:
     case SYNC_BUF_POOL:
     case SYNC_SEARCH_SYS:
     case SYNC_SEARCH_SYS_CONF:
@@ -1040,6 +1085,8 @@ void sync_init() {
 
   sync_initialized = true;
 
+  ut_delay_calibrate();
+
   /* Create the primary system wait array which is protected by an OS
   mutex */
 
@@ -1120,6 +1167,107 @@ void sync_print_wait_info(ib_stream_t ib_stream) {
     (double)rw_s_spin_round_count / (rw_s_spin_wait_count ? rw_s_spin_wait_count : 1),
     (double)rw_x_spin_round_count / (rw_x_spin_wait_count ? rw_x_spin_wait_count : 1)
   );
+
+  ib_logger(ib_stream, "Spin delay unit: %lu pause instructions\n", (ulong)ut_delay_relax_count);
+
+  sync_latch_class_print(ib_stream);
+}
+
+Sync_latch_class *sync_latch_class_get(const char *file, ulint line) noexcept {
+  auto &classes = sync_latch_classes();
+  auto key = std::string(file) + ":" + std::to_string(line);
+
+  std::lock_guard<std::mutex> guard(classes.m_mutex);
+
+  auto &latch_class = classes.m_classes[key];
+
+  if (!latch_class) {
+    latch_class = std::make_unique<Sync_latch_class>();
+    latch_class->m_file = file;
+    latch_class->m_line = line;
+  }
+
+  return latch_class.get();
+}
+
+void sync_latch_class_print(ib_stream_t ib_stream) noexcept {
+  auto &classes = sync_latch_classes();
+
+  std::lock_guard<std::mutex> guard(classes.m_mutex);
+
+  for (const auto &[key, latch_class] : classes.m_classes) {
+    const auto n_waits = latch_class->m_spin_waits.load(std::memory_order_relaxed);
+
+    if (n_waits == 0) {
+      continue;
+    }
+
+    ib_logger(
+      ib_stream,
+      "%s: spin waits %lu, rounds %lu, acquired spinning %lu, OS waits %lu\n",
+      key.c_str(),
+      (ulong)n_waits,
+      (ulong)latch_class->m_spin_rounds.load(std::memory_order_relaxed),
+      (ulong)latch_class->m_spin_acquired.load(std::memory_order_relaxed),
+      (ulong)latch_class->m_os_waits.load(std::memory_order_relaxed)
+    );
+  }
+
+  std::vector<std::pair<uint64_t, Sync_latch_class *>> profile;
+
+  for (const auto &[key, latch_class] : classes.m_classes) {
+    const auto wait_ns = latch_class->m_wait_ns.load(std::memory_order_relaxed);
+
+    if (wait_ns > 0) {
+      profile.emplace_back(wait_ns, latch_class.get());
+    }
+  }
+
+  if (profile.empty()) {
+    return;
+  }
+
+  const auto n = std::min<size_t>(profile.size(), SYNC_LATCH_PROFILE_TOP_N);
+
+  std::partial_sort(profile.begin(), profile.begin() + n, profile.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs.first > rhs.first;
+  });
+
+  ib_logger(ib_stream, "Latch contention profile, top %lu by wait time:\n", (ulong)n);
+
+  for (size_t i{}; i < n; ++i) {
+    const auto [wait_ns, latch_class] = profile[i];
+
+    ib_logger(
+      ib_stream,
+      "%s:%lu: acquisitions %lu, contended %lu, spin rounds %lu, wait %lu us, max wait %lu us\n",
+      latch_class->m_file,
+      (ulong)latch_class->m_line,
+      (ulong)latch_class->m_acquisitions.value(),
+      (ulong)latch_class->m_spin_waits.load(std::memory_order_relaxed),
+      (ulong)latch_class->m_spin_rounds.load(std::memory_order_relaxed),
+      (ulong)(wait_ns / 1000),
+      (ulong)(latch_class->m_max_wait_ns.load(std::memory_order_relaxed) / 1000)
+    );
+  }
+}
+
+Sync_latch_totals sync_latch_class_totals() noexcept {
+  Sync_latch_totals totals{};
+  auto &classes = sync_latch_classes();
+
+  std::lock_guard<std::mutex> guard(classes.m_mutex);
+
+  for (const auto &[key, latch_class] : classes.m_classes) {
+    totals.m_acquisitions += latch_class->m_acquisitions.value();
+    totals.m_contended += latch_class->m_spin_waits.load(std::memory_order_relaxed);
+    totals.m_spin_rounds += latch_class->m_spin_rounds.load(std::memory_order_relaxed);
+    totals.m_os_waits += latch_class->m_os_waits.load(std::memory_order_relaxed);
+    totals.m_wait_ns += latch_class->m_wait_ns.load(std::memory_order_relaxed);
+    totals.m_max_wait_ns = std::max(totals.m_max_wait_ns, latch_class->m_max_wait_ns.load(std::memory_order_relaxed));
+  }
+
+  return totals;
 }
 
 void sync_print(ib_stream_t ib_stream) {
@@ -0,0 +1,280 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_cursor_add_delta(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT COMMUTATIVE, C3 INT,
+               C4 TINYINT UNSIGNED COMMUTATIVE, PRIMARY KEY(C1));
+INSERT INTO T VALUES(1, 100, 0, 250);
+
+Trx A adds deltas to C2 of row 1, its reads see them, the reads of other
+transactions don't. The row is not locked, a nonblocking trx B X locks it
+and adds its own delta and commits while A is active. Both deltas are in
+the row after A commits.
+
+A rollback, and a rollback to a savepoint taken before a delta, discard it.
+A delta to a column that is not commutative or to the key is rejected with
+DB_DATA_MISMATCH. The commit of a delta that takes C4 out of its range or of
+a delta to a row that doesn't exist fails and rolls the transaction back.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** CREATE TABLE T(C1 INT, C2 INT COMMUTATIVE, C3 INT,
+                   C4 TINYINT UNSIGNED COMMUTATIVE, PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_COMMUTATIVE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c3", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(
+    ib_tbl_sch, "c4", IB_INT, ib_col_attr_t(IB_COL_UNSIGNED | IB_COL_COMMUTATIVE), 0, sizeof(uint8_t)
+  ));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO T VALUES(1, 100, 0, 250); */
+static void insert_row() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(tpl, 0, 1));
+  OK(ib_tuple_write_i32(tpl, 1, 100));
+  OK(ib_tuple_write_i32(tpl, 2, 0));
+  OK(ib_tuple_write_u8(tpl, 3, 250));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Open a cursor on the table. */
+static ib_crsr_t open_cursor(ib_trx_t ib_trx) {
+  ib_crsr_t crsr{};
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  return crsr;
+}
+
+/** Add a delta to a column of a row.
+@return the result of ib_cursor_add_delta() */
+static ib_err_t add_delta(ib_crsr_t crsr, int32_t c1, ulint col_no, int64_t delta) {
+  auto key = ib_clust_search_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+
+  const auto err = ib_cursor_add_delta(crsr, key, col_no, delta);
+
+  /* The key is copied. */
+  ib_tuple_delete(key);
+
+  return err;
+}
+
+/** Read row 1 and check C2 and C4. */
+static void check_row(ib_crsr_t crsr, int32_t c2, uint8_t c4) {
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, 1));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  OK(ib_cursor_read_row(crsr, tpl));
+
+  int32_t v2{};
+  uint8_t v4{};
+
+  OK(ib_tuple_read_i32(tpl, 1, &v2));
+  OK(ib_tuple_read_u8(tpl, 3, &v4));
+  assert(v2 == c2);
+  assert(v4 == c4);
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key);
+}
+
+/** Check the committed values of row 1 with a new transaction. */
+static void check_committed(int32_t c2, uint8_t c4) {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_cursor(ib_trx);
+
+  check_row(crsr, c2, c4);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Wake up callback of the nonblocking transaction, the test doesn't wait. */
+static void wake(void *) {}
+
+/** A nonblocking trx X locks row 1, adds a delta and commits. */
+static void add_delta_nonblocking(int64_t delta) {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(ib_trx, wake, nullptr));
+
+  auto crsr = open_cursor(ib_trx);
+
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, 1));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  ib_tuple_delete(key);
+
+  OK(add_delta(crsr, 1, 1, delta));
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_row();
+
+  /* Trx A sees its deltas, the others see them once A committed. */
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_cursor(ib_trx);
+
+  OK(add_delta(crsr, 1, 1, 5));
+  OK(add_delta(crsr, 1, 1, 5));
+  OK(add_delta(crsr, 1, 3, -50));
+  OK(add_delta(crsr, 1, 1, 0));
+
+  check_row(crsr, 110, 200);
+  check_committed(100, 250);
+
+  /* Not commutative and the key. */
+  assert(add_delta(crsr, 1, 2, 1) == DB_DATA_MISMATCH);
+  assert(add_delta(crsr, 1, 0, 1) == DB_DATA_MISMATCH);
+  assert(add_delta(crsr, 1, 4, 1) == DB_DATA_MISMATCH);
+
+  /* Row 1 is not locked by A. */
+  add_delta_nonblocking(1);
+  check_committed(101, 250);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  check_committed(111, 200);
+
+  /* A rollback discards the deltas. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  OK(add_delta(crsr, 1, 1, 1000));
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+
+  check_committed(111, 200);
+
+  /* A rollback to a savepoint discards the deltas added after it. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  OK(add_delta(crsr, 1, 1, 1));
+  ib_savepoint_take(ib_trx, "sp", 2);
+  OK(add_delta(crsr, 1, 1, 1000));
+  OK(ib_savepoint_rollback(ib_trx, "sp", 2));
+
+  check_row(crsr, 112, 200);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  check_committed(112, 200);
+
+  /* Out of the range of C4, the commit rolls back all the deltas. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  OK(add_delta(crsr, 1, 1, 1));
+  OK(add_delta(crsr, 1, 3, 100));
+
+  OK(ib_cursor_close(crsr));
+  assert(ib_trx_commit(ib_trx) == DB_DATA_MISMATCH);
+
+  check_committed(112, 200);
+
+  /* The row doesn't exist. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  OK(add_delta(crsr, 1, 1, 1));
+  OK(add_delta(crsr, 2, 1, 1));
+
+  OK(ib_cursor_close(crsr));
+  assert(ib_trx_commit(ib_trx) == DB_RECORD_NOT_FOUND);
+
+  check_committed(112, 200);
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test the rows that are too long to be stored on the page, for every page
+size that the library can be built with. It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 BLOB, C3 BLOB, PRIMARY KEY(C1));
+
+Insert rows whose C2 has lengths around half a page and around 16K, and rows
+whose C2 and C3 are each shorter than 16K but longer together. Above 16K
+pages the records must stay below 16K, the field end offsets of a record
+have 14 bits, the longer columns are stored externally.
+
+Read the rows back by key and compare them, update short rows to long ones
+and compare them again.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+/** The column lengths of a row */
+struct Row {
+  int32_t m_c1;
+  ulint m_c2_len;
+  ulint m_c3_len;
+};
+
+static const Row rows[] = {
+  {0, 100, 100},
+  {1, 8000, 0},
+  {2, 16383, 0},
+  {3, 16384, 0},
+  {4, 20000, 0},
+  {5, 30000, 0},
+  {6, 40000, 0},
+  {7, 70000, 0},
+  {8, 9000, 9000},
+  {9, 16000, 16000},
+  {10, 33000, 33000},
+};
+
+/** The value of a column, a function of the key and the column so that a
+value written to the wrong row or column is detected. */
+static std::vector<char> column_value(int32_t c1, ulint col, ulint len) {
+  std::vector<char> value(len);
+
+  for (ulint i = 0; i < len; ++i) {
+    value[i] = char('a' + (i + c1 * 7 + col * 13) % 26);
+  }
+
+  return value;
+}
+
+/** CREATE TABLE T(C1 INT, C2 BLOB, C3 BLOB, PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_tbl_sch_add_blob_col(ib_tbl_sch, "c2"));
+  OK(ib_tbl_sch_add_blob_col(ib_tbl_sch, "c3"));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** Set the columns of a row in a tuple. */
+static void write_row(ib_tpl_t tpl, int32_t c1, ulint c2_len, ulint c3_len) {
+  const auto c2 = column_value(c1, 1, c2_len);
+  const auto c3 = column_value(c1, 2, c3_len);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_col_set_value(tpl, 1, c2.data(), c2.size()));
+  OK(ib_col_set_value(tpl, 2, c3.data(), c3.size()));
+}
+
+/** Read a row by key and check its columns. */
+static void check_row(ib_crsr_t crsr, int32_t c1, ulint c2_len, ulint c3_len) {
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  OK(ib_cursor_read_row(crsr, tpl));
+
+  int32_t v{};
+
+  OK(ib_tuple_read_i32(tpl, 0, &v));
+  assert(v == c1);
+
+  const ulint lens[] = {c2_len, c3_len};
+
+  for (ulint col = 1; col <= 2; ++col) {
+    const auto expected = column_value(c1, col, lens[col - 1]);
+
+    assert(ib_col_get_len(tpl, col) == expected.size());
+    assert(expected.empty() || memcmp(ib_col_get_value(tpl, col), expected.data(), expected.size()) == 0);
+  }
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key);
+}
+
+static void insert_rows(ib_crsr_t crsr) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  for (const auto &row : rows) {
+    write_row(tpl, row.m_c1, row.m_c2_len, row.m_c3_len);
+    OK(ib_cursor_insert_row(crsr, tpl));
+    tpl = ib_tuple_clear(tpl);
+  }
+
+  ib_tuple_delete(tpl);
+}
+
+/** Update the first row to each of the lengths of the other rows. */
+static void update_rows(ib_crsr_t crsr) {
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+  auto old_tpl = ib_clust_read_tuple_create(crsr);
+  auto new_tpl = ib_clust_read_tuple_create(crsr);
+  const auto c1 = rows[0].m_c1;
+
+  for (const auto &row : rows) {
+    OK(ib_tuple_write_i32(key, 0, c1));
+    OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+    assert(res == 0);
+
+    OK(ib_cursor_read_row(crsr, old_tpl));
+    OK(ib_tuple_copy(new_tpl, old_tpl));
+
+    write_row(new_tpl, c1, row.m_c2_len, row.m_c3_len);
+    OK(ib_cursor_update_row(crsr, old_tpl, new_tpl));
+
+    check_row(crsr, c1, row.m_c2_len, row.m_c3_len);
+
+    old_tpl = ib_tuple_clear(old_tpl);
+    new_tpl = ib_tuple_clear(new_tpl);
+  }
+
+  ib_tuple_delete(new_tpl);
+  ib_tuple_delete(old_tpl);
+  ib_tuple_delete(key);
+}
+
+int main(int, char *[]) {
+  ib_crsr_t crsr{};
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  insert_rows(crsr);
+
+  for (const auto &row : rows) {
+    check_row(crsr, row.m_c1, row.m_c2_len, row.m_c3_len);
+  }
+
+  update_rows(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  /* Read them again after the commit, with a new transaction. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  for (const auto &row : rows) {
+    if (row.m_c1 != rows[0].m_c1) {
+      check_row(crsr, row.m_c1, row.m_c2_len, row.m_c3_len);
+    }
+  }
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
@@ -27,36 +27,96 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 static void get_all() {
   static const char *var_names[] = {
+    "adaptive_hash_index",
+    "adaptive_hash_index_parts",
     "additional_mem_pool_size",
+    "aio_per_cpu_queues",
+    "aio_sqpoll",
+    "aio_write_coalesce_window",
     "autoextend_increment",
+    "buffer_pool_chunk_size",
+    "buffer_pool_dump_at_shutdown",
+    "buffer_pool_dump_interval",
+    "buffer_pool_dump_pct",
+    "buffer_pool_huge_pages",
+    "buffer_pool_instances",
+    "buffer_pool_load_at_startup",
+    "buffer_pool_numa",
+    "buffer_pool_prefault",
     "buffer_pool_size",
     "checksums",
+    "concurrency_tickets",
     "data_file_path",
     "data_home_dir",
+    "dict_table_cache_size",
     "doublewrite",
+    "doublewrite_mode",
     "file_format",
     "file_io_threads",
     "file_per_table",
+    "file_preallocate_extents",
+    "file_trim_freed_extents",
+    "fill_factor",
     "flush_log_at_trx_commit",
     "flush_method",
+    "flush_neighbors",
+    "flush_read_throttle",
+    "flush_thread_cpus",
     "force_recovery",
+    "index_build_threads",
+    "io_thread_cpus",
+    "l2_cache_file",
+    "l2_cache_size",
+    "latch_profile",
+    "lazy_checksums",
+    "lazy_tablespace_load",
+    "leaf_prefetch_pages",
+    "lock_grant_by_weight",
     "lock_wait_timeout",
+    "log_archive_dir",
+    "log_buffer_max_size",
     "log_buffer_size",
+    "log_checksum_algorithm",
     "log_file_size",
     "log_files_in_group",
     "log_group_home_dir",
+    "log_io_mode",
+    "log_thread_cpus",
     "max_dirty_pages_pct",
     "max_purge_lag",
+    "max_purge_lag_delay",
+    "master_thread_cpus",
+    "monitor_thread_cpus",
     "lru_old_blocks_pct",
     "lru_block_access_recency",
+    "lru_protected_pct",
     "open_files",
+    "page_cleaner_threads",
+    "page_compression",
     "pre_rollback_hook",
     "print_verbose_log",
+    "purge_threads",
+    "random_read_ahead",
+    "read_only",
+    "reader_thread_cpus",
+    "recovery_apply_threads",
     "rollback_on_timeout",
+    "rollback_segments",
+    "slow_op_threshold_us",
     "stats_sample_pages",
     "status_file",
     "sync_spin_loops",
+    "tablespace_load_threads",
+    "task_threads",
+    "task_thread_cpus",
+    "thread_concurrency",
+    "thread_concurrency_autotune",
+    "truncate_in_place",
+    "undo_cache_size",
     "version",
+    "version_cache_size",
+    "wait_trace",
+    "wait_trace_events",
     nullptr};
 
   const char **ptr;
@@ -0,0 +1,179 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_trx_commit_async(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1));
+
+Insert rows from many transactions that are committed with
+ib_trx_commit_async(), each with its own context. The callback of every
+transaction must be invoked exactly once. The rows are visible to a new
+transaction as soon as the commit returns, before the callback ran.
+
+A read only transaction that is committed asynchronously invokes its
+callback too, it has nothing to wait for.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+constexpr int32_t N_TRXS = 100;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** The context of a commit, the number of times its callback was invoked. */
+static std::atomic<int> n_calls[N_TRXS + 1];
+
+/** The number of callbacks invoked. */
+static std::atomic<int> n_durable{};
+
+/** Callback of ib_trx_commit_async(). */
+static void durable(void *ctx) {
+  auto calls = static_cast<std::atomic<int> *>(ctx);
+
+  ++*calls;
+  ++n_durable;
+}
+
+/** CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** Check that a committed row is visible to a new transaction. */
+static void check_row(int32_t c1) {
+  int res{};
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  auto key = ib_clust_search_tuple_create(crsr);
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  int32_t c2{};
+
+  OK(ib_cursor_read_row(crsr, tpl));
+  OK(ib_tuple_read_i32(tpl, 1, &c2));
+  assert(c2 == c1 * 10);
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** INSERT INTO T VALUES(c1, c1 * 10) and commit asynchronously. */
+static void insert_row(int32_t c1) {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_tuple_write_i32(tpl, 1, c1 * 10));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit_async(ib_trx, durable, &n_calls[c1]));
+}
+
+/** Wait for a number of callbacks, at most a minute. */
+static void wait_for_callbacks(int n) {
+  for (int i = 0; n_durable.load() < n && i < 60000; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  assert(n_durable.load() == n);
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  for (int32_t i = 0; i < N_TRXS; ++i) {
+    insert_row(i);
+
+    /* Visible whether or not the commit is durable yet. */
+    check_row(i);
+  }
+
+  wait_for_callbacks(N_TRXS);
+
+  /* A transaction without changes. */
+  auto ib_trx = ib_trx_begin_read_only(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_commit_async(ib_trx, durable, &n_calls[N_TRXS]));
+
+  wait_for_callbacks(N_TRXS + 1);
+
+  /* Each callback was invoked once, with its own context. */
+  for (const auto &calls : n_calls) {
+    assert(calls.load() == 1);
+  }
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
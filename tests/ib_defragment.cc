@@ -0,0 +1,278 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_index_defragment(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 VARCHAR(200), C3 INT, PRIMARY KEY(C1), INDEX(C3));
+INSERT INTO T VALUES(0, 'a...', 10000), (1, 'b...', 9999), ... ;
+
+The rows are inserted in key order with long C2 values, the leaf pages are
+full. Update C2 of every row to a short value, the leaf pages are then mostly
+empty. Defragment the clustered index while another thread scans the table,
+the scans must see all the rows all the time. Leaf pages must have been
+freed and all the rows must be intact. Defragment the secondary index and
+look the rows up through it.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <atomic>
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include <vector>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+constexpr int32_t N_ROWS = 10000;
+
+constexpr ulint LONG_LEN = 200;
+constexpr ulint SHORT_LEN = 8;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** Set when the defragmentation is done, the scanning thread stops. */
+static std::atomic<bool> done{};
+
+/** CREATE TABLE T(C1 INT, C2 VARCHAR(200), C3 INT, PRIMARY KEY(C1), INDEX(C3)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_tbl_sch_add_varchar_col(ib_tbl_sch, "c2", LONG_LEN));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c3", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c3", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c3", 0));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** The value of C2 of a row. */
+static std::vector<char> c2_value(int32_t c1, ulint len) {
+  return std::vector<char>(len, char('a' + c1 % 26));
+}
+
+/** INSERT INTO T VALUES(0, 'a...', 10000), (1, 'b...', 9999), ... ; */
+static void insert_rows() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  for (int32_t i = 0; i < N_ROWS; ++i) {
+    const auto c2 = c2_value(i, LONG_LEN);
+
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    OK(ib_col_set_value(tpl, 1, c2.data(), c2.size()));
+    OK(ib_tuple_write_i32(tpl, 2, N_ROWS - i));
+    OK(ib_cursor_insert_row(crsr, tpl));
+    tpl = ib_tuple_clear(tpl);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** UPDATE T SET C2 = SUBSTR(C2, 1, 8); */
+static void shrink_rows() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  auto old_tpl = ib_clust_read_tuple_create(crsr);
+  auto new_tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+
+    OK(ib_cursor_read_row(crsr, old_tpl));
+    OK(ib_tuple_read_i32(old_tpl, 0, &c1));
+    OK(ib_tuple_copy(new_tpl, old_tpl));
+
+    const auto c2 = c2_value(c1, SHORT_LEN);
+
+    OK(ib_col_set_value(new_tpl, 1, c2.data(), c2.size()));
+    OK(ib_cursor_update_row(crsr, old_tpl, new_tpl));
+
+    old_tpl = ib_tuple_clear(old_tpl);
+    new_tpl = ib_tuple_clear(new_tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+
+  ib_tuple_delete(new_tpl);
+  ib_tuple_delete(old_tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Scan the table and check the rows. */
+static void check_rows() {
+  ib_crsr_t crsr{};
+  int32_t n_rows{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+    int32_t c3{};
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+    OK(ib_tuple_read_i32(tpl, 2, &c3));
+    assert(c1 == n_rows);
+    assert(c3 == N_ROWS - c1);
+
+    const auto c2 = c2_value(c1, SHORT_LEN);
+
+    assert(ib_col_get_len(tpl, 1) == c2.size());
+    assert(memcmp(ib_col_get_value(tpl, 1), c2.data(), c2.size()) == 0);
+
+    ++n_rows;
+    tpl = ib_tuple_clear(tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(n_rows == N_ROWS);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Scan the table until the defragmentation is done. */
+static void scan_rows() {
+  do {
+    check_rows();
+  } while (!done.load());
+}
+
+/** Look up the rows through the secondary index. */
+static void check_secondary(ib_crsr_t crsr) {
+  ib_crsr_t idx_crsr{};
+
+  OK(ib_cursor_open_index_using_name(crsr, "c3", &idx_crsr));
+  ib_cursor_set_cluster_access(idx_crsr);
+
+  auto key = ib_sec_search_tuple_create(idx_crsr);
+  auto tpl = ib_clust_read_tuple_create(idx_crsr);
+
+  for (int32_t i = 0; i < N_ROWS; i += 97) {
+    int res{};
+    int32_t c1{};
+
+    OK(ib_tuple_write_i32(key, 0, N_ROWS - i));
+    OK(ib_cursor_moveto(idx_crsr, key, IB_CUR_GE, &res));
+    assert(res == 0);
+
+    OK(ib_cursor_read_row(idx_crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+    assert(c1 == i);
+
+    tpl = ib_tuple_clear(tpl);
+  }
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key);
+
+  OK(ib_index_defragment(idx_crsr, nullptr));
+  OK(ib_cursor_close(idx_crsr));
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_rows();
+  shrink_rows();
+  check_rows();
+
+  ib_crsr_t crsr{};
+  ulint n_pages_freed{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  {
+    std::thread scanner(scan_rows);
+
+    OK(ib_index_defragment(crsr, &n_pages_freed));
+
+    done.store(true);
+    scanner.join();
+  }
+
+  /* The leaf pages were mostly empty. */
+  assert(n_pages_freed > 0);
+
+  check_rows();
+
+  /* Defragment the secondary index, and use it before and after. */
+  check_secondary(crsr);
+  check_secondary(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_cursor_delete_range(). It does the following:
+
+Create a database
+CREATE TABLE T1(C1 INT, C2 INT, PRIMARY KEY(C1));
+CREATE TABLE T2(C1 INT, C2 INT, PRIMARY KEY(C1), INDEX(C2));
+INSERT INTO T1 VALUES(0, 0), ... (19, 190);
+INSERT INTO T2 VALUES(0, 0), ... (19, 190);
+
+T1 is X locked and has no secondary indexes, the ranges are delete marked
+a leaf page at a time. T2 has a secondary index, its rows are locked and
+deleted one at a time. For both tables:
+
+DELETE FROM T WHERE C1 BETWEEN 5 AND 9;
+DELETE FROM T WHERE C1 <= 2;
+DELETE FROM T WHERE C1 >= 17;
+
+The bounds are inclusive and the rows outside of the ranges are kept. A
+rollback of the deletes restores all the rows.
+
+DROP TABLE T1;
+DROP TABLE T2;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE1 = "t1";
+constexpr const char *TABLE2 = "t2";
+
+constexpr int32_t N_ROWS = 20;
+
+/** CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1)[, INDEX(C2)]); */
+static void create_table(const char *table_name, bool secondary) {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  if (secondary) {
+    OK(ib_table_schema_add_index(ib_tbl_sch, "c2", &ib_idx_sch));
+    OK(ib_index_schema_add_col(ib_idx_sch, "c2", 0));
+  }
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO T VALUES(0, 0), ... (19, 190); */
+static void insert_rows(const char *table_name) {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  for (int32_t i = 0; i < N_ROWS; ++i) {
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    OK(ib_tuple_write_i32(tpl, 1, i * 10));
+    OK(ib_cursor_insert_row(crsr, tpl));
+    tpl = ib_tuple_clear(tpl);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Delete the rows whose C1 is in [low, high], a negative bound is open. */
+static void delete_range(ib_crsr_t crsr, int32_t low, int32_t high) {
+  ib_tpl_t low_tpl{};
+  ib_tpl_t high_tpl{};
+
+  if (low >= 0) {
+    low_tpl = ib_clust_search_tuple_create(crsr);
+    OK(ib_tuple_write_i32(low_tpl, 0, low));
+  }
+
+  if (high >= 0) {
+    high_tpl = ib_clust_search_tuple_create(crsr);
+    OK(ib_tuple_write_i32(high_tpl, 0, high));
+  }
+
+  OK(ib_cursor_delete_range(crsr, low_tpl, high_tpl));
+
+  if (high_tpl != nullptr) {
+    ib_tuple_delete(high_tpl);
+  }
+
+  if (low_tpl != nullptr) {
+    ib_tuple_delete(low_tpl);
+  }
+}
+
+/** Check that the table has exactly the rows that are not in the deleted
+ranges, [0, 2], [5, 9] and [17, N_ROWS). */
+static void check_rows(const char *table_name, bool all) {
+  ib_crsr_t crsr{};
+  bool seen[N_ROWS]{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+    int32_t c2{};
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+    OK(ib_tuple_read_i32(tpl, 1, &c2));
+
+    assert(c1 >= 0 && c1 < N_ROWS);
+    assert(c2 == c1 * 10);
+    assert(!seen[c1]);
+    seen[c1] = true;
+
+    tpl = ib_tuple_clear(tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+
+  for (int32_t i = 0; i < N_ROWS; ++i) {
+    const auto deleted = i <= 2 || (i >= 5 && i <= 9) || i >= 17;
+
+    assert(seen[i] == (all || !deleted));
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Delete the ranges, roll back, check, delete them again and commit. */
+static void test_delete_range(const char *table_name, ib_lck_mode_t lck_mode) {
+  for (const auto commit : {false, true}) {
+    ib_crsr_t crsr{};
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, lck_mode));
+
+    delete_range(crsr, 5, 9);
+    delete_range(crsr, -1, 2);
+    delete_range(crsr, 17, -1);
+
+    OK(ib_cursor_close(crsr));
+
+    if (commit) {
+      OK(ib_trx_commit(ib_trx));
+    } else {
+      OK(ib_trx_rollback(ib_trx));
+    }
+
+    check_rows(table_name, !commit);
+  }
+}
+
+int main(int, char *[]) {
+  char table1[IB_MAX_TABLE_NAME_LEN];
+  char table2[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table1, sizeof(table1), "%s/%s", DATABASE, TABLE1);
+  snprintf(table2, sizeof(table2), "%s/%s", DATABASE, TABLE2);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table(table1, false);
+  insert_rows(table1);
+
+  /* The table X lock and no secondary indexes, the leaf page path. */
+  test_delete_range(table1, IB_LOCK_X);
+
+  create_table(table2, true);
+  insert_rows(table2);
+
+  /* A secondary index, the rows are deleted one at a time. */
+  test_delete_range(table2, IB_LOCK_IX);
+
+  OK(drop_table(DATABASE, TABLE1));
+  OK(drop_table(DATABASE, TABLE2));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
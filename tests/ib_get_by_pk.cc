@@ -0,0 +1,257 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_cursor_get_by_pk(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1));
+INSERT INTO T VALUES(0, 0), ... (9, 90);
+
+Trx A reads the rows, its read view sees them on the leaf pages.
+Trx B updates row 3 and deletes row 5, and commits.
+Trx A still sees the old row 3 and row 5, their versions are built from the
+undo log. A new trx C sees the new row 3 and doesn't find row 5.
+A key that was never inserted is not found.
+Trx A then reads row 3 with an X lock and sees the committed update, and a
+nonblocking trx D can't lock the row until A commits.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+constexpr int32_t N_ROWS = 10;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO T VALUES(0, 0), ... (9, 90); */
+static void insert_rows() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  for (int32_t i = 0; i < N_ROWS; ++i) {
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    OK(ib_tuple_write_i32(tpl, 1, i * 10));
+    OK(ib_cursor_insert_row(crsr, tpl));
+    tpl = ib_tuple_clear(tpl);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Look up a row.
+@return DB_SUCCESS or DB_RECORD_NOT_FOUND, c2 is set on success */
+static ib_err_t get(ib_crsr_t crsr, int32_t c1, int32_t *c2) {
+  auto key = ib_clust_search_tuple_create(crsr);
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+
+  const auto err = ib_cursor_get_by_pk(crsr, key, tpl);
+
+  assert(err == DB_SUCCESS || err == DB_RECORD_NOT_FOUND);
+
+  if (err == DB_SUCCESS) {
+    int32_t v{};
+
+    OK(ib_tuple_read_i32(tpl, 0, &v));
+    assert(v == c1);
+
+    OK(ib_tuple_read_i32(tpl, 1, c2));
+  }
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key);
+
+  return err;
+}
+
+/** Check that a row is found with a value of c2. */
+static void check_row(ib_crsr_t crsr, int32_t c1, int32_t expected) {
+  int32_t c2{};
+
+  OK(get(crsr, c1, &c2));
+  assert(c2 == expected);
+}
+
+/** Check that a row is not found. */
+static void check_no_row(ib_crsr_t crsr, int32_t c1) {
+  int32_t c2{};
+
+  assert(get(crsr, c1, &c2) == DB_RECORD_NOT_FOUND);
+}
+
+/** UPDATE T SET C2 = 1000 WHERE C1 = 3; DELETE FROM T WHERE C1 = 5; */
+static void update_and_delete() {
+  int res{};
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  auto key = ib_clust_search_tuple_create(crsr);
+  auto old_tpl = ib_clust_read_tuple_create(crsr);
+  auto new_tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, 3));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  OK(ib_cursor_read_row(crsr, old_tpl));
+  OK(ib_tuple_copy(new_tpl, old_tpl));
+  OK(ib_tuple_write_i32(new_tpl, 1, 1000));
+  OK(ib_cursor_update_row(crsr, old_tpl, new_tpl));
+
+  OK(ib_tuple_write_i32(key, 0, 5));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  OK(ib_cursor_delete_row(crsr));
+
+  ib_tuple_delete(new_tpl);
+  ib_tuple_delete(old_tpl);
+  ib_tuple_delete(key);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Wake up callback of the nonblocking transaction, the test doesn't wait. */
+static void wake(void *) {}
+
+/** Check that the row is X locked by another transaction: a nonblocking
+transaction can't lock it. */
+static void check_locked(int32_t c1) {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(ib_trx, wake, nullptr));
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  int32_t c2{};
+
+  assert(get(crsr, c1, &c2) == DB_WOULD_BLOCK);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_rows();
+
+  /* The read view of trx A is assigned when the cursor is opened. */
+  ib_crsr_t crsr_a{};
+  auto trx_a = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, trx_a, &crsr_a));
+
+  for (int32_t i = 0; i < N_ROWS; ++i) {
+    check_row(crsr_a, i, i * 10);
+  }
+
+  check_no_row(crsr_a, N_ROWS);
+  check_no_row(crsr_a, -1);
+
+  update_and_delete();
+
+  /* The read view of trx A predates the changes of trx B. */
+  check_row(crsr_a, 3, 30);
+  check_row(crsr_a, 5, 50);
+  check_row(crsr_a, 4, 40);
+
+  {
+    ib_crsr_t crsr_c{};
+    auto trx_c = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(table_name, trx_c, &crsr_c));
+
+    check_row(crsr_c, 3, 1000);
+    check_no_row(crsr_c, 5);
+    check_row(crsr_c, 4, 40);
+
+    OK(ib_cursor_close(crsr_c));
+    OK(ib_trx_commit(trx_c));
+  }
+
+  /* A locking read sees the latest committed version and keeps the row
+  locked until the commit. */
+  OK(ib_cursor_lock(crsr_a, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr_a, IB_LOCK_X));
+
+  check_row(crsr_a, 3, 1000);
+  check_no_row(crsr_a, 5);
+
+  check_locked(3);
+
+  OK(ib_cursor_close(crsr_a));
+  OK(ib_trx_commit(trx_a));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
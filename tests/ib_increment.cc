@@ -0,0 +1,290 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_cursor_increment(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT, C3 TINYINT UNSIGNED, C4 VARCHAR(10), C5 INT,
+               C6 INT, PRIMARY KEY(C1), INDEX(C6));
+INSERT INTO T VALUES(1, 10, 250, 'a', NULL, 1);
+
+Add positive and negative deltas to C2 and check the returned and the stored
+values. A delta that takes C3 out of its range, an indexed column, a column
+that is not an integer and an SQL NULL are rejected with DB_DATA_MISMATCH
+and leave the row unchanged. A rollback undoes the increments. A cursor
+that doesn't read with X locks gets DB_ERROR.
+
+Two threads increment C2 of the row in their own transactions at the same
+time, none of the increments is lost.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+/** Number of transactions of each of the incrementing threads. */
+constexpr int N_INCREMENTS = 1000;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** CREATE TABLE T(C1 INT, C2 INT, C3 TINYINT UNSIGNED, C4 VARCHAR(10), C5 INT,
+                   C6 INT, PRIMARY KEY(C1), INDEX(C6)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c3", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint8_t)));
+  OK(ib_tbl_sch_add_varchar_col(ib_tbl_sch, "c4", 10));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c5", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c6", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c6", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c6", 0));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO T VALUES(1, 10, 250, 'a', NULL, 1); */
+static void insert_row() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(tpl, 0, 1));
+  OK(ib_tuple_write_i32(tpl, 1, 10));
+  OK(ib_tuple_write_u8(tpl, 2, 250));
+  OK(ib_col_set_value(tpl, 3, "a", 1));
+  OK(ib_col_set_value(tpl, 4, nullptr, IB_SQL_NULL));
+  OK(ib_tuple_write_i32(tpl, 5, 1));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Position the cursor on the row and read it with an X lock. */
+static void read_row(ib_crsr_t crsr, ib_tpl_t tpl) {
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, 1));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  OK(ib_cursor_read_row(crsr, tpl));
+
+  ib_tuple_delete(key);
+}
+
+/** Check the values of C2 and C3 of the row. */
+static void check_row(ib_crsr_t crsr, int32_t c2, uint8_t c3) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  read_row(crsr, tpl);
+
+  int32_t v2{};
+  uint8_t v3{};
+
+  OK(ib_tuple_read_i32(tpl, 1, &v2));
+  OK(ib_tuple_read_u8(tpl, 2, &v3));
+  assert(v2 == c2);
+  assert(v3 == c3);
+  assert(ib_col_get_len(tpl, 4) == IB_SQL_NULL);
+
+  ib_tuple_delete(tpl);
+}
+
+/** Add a delta to a column of the row.
+@return the result of ib_cursor_increment() */
+static ib_err_t increment(ib_crsr_t crsr, ulint col_no, int64_t delta, int64_t *new_value) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  read_row(crsr, tpl);
+
+  const auto err = ib_cursor_increment(crsr, col_no, delta, new_value);
+
+  ib_tuple_delete(tpl);
+
+  return err;
+}
+
+/** Open a cursor that reads with X locks. */
+static ib_crsr_t open_cursor(ib_trx_t ib_trx) {
+  ib_crsr_t crsr{};
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  return crsr;
+}
+
+/** Increment C2 by 1 N_INCREMENTS times, one transaction each. */
+static void increment_rows() {
+  for (int i = 0; i < N_INCREMENTS; ++i) {
+    int64_t value{};
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_cursor(ib_trx);
+
+    OK(increment(crsr, 1, 1, &value));
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+  }
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_row();
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_cursor(ib_trx);
+
+  int64_t value{};
+
+  OK(increment(crsr, 1, 5, &value));
+  assert(value == 15);
+
+  OK(increment(crsr, 1, -20, &value));
+  assert(value == -5);
+
+  OK(increment(crsr, 1, 0, nullptr));
+
+  OK(increment(crsr, 2, 5, &value));
+  assert(value == 255);
+
+  check_row(crsr, -5, 255);
+
+  /* Out of the range of TINYINT UNSIGNED, both ways. */
+  assert(increment(crsr, 2, 1, &value) == DB_DATA_MISMATCH);
+  assert(increment(crsr, 2, -256, &value) == DB_DATA_MISMATCH);
+
+  /* Indexed columns, the key and C6. */
+  assert(increment(crsr, 0, 1, &value) == DB_DATA_MISMATCH);
+  assert(increment(crsr, 5, 1, &value) == DB_DATA_MISMATCH);
+
+  /* Not an integer column, an SQL NULL and no such column. */
+  assert(increment(crsr, 3, 1, &value) == DB_DATA_MISMATCH);
+  assert(increment(crsr, 4, 1, &value) == DB_DATA_MISMATCH);
+  assert(increment(crsr, 6, 1, &value) == DB_DATA_MISMATCH);
+
+  check_row(crsr, -5, 255);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+
+  /* The rollback undid the increments. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  check_row(crsr, 10, 250);
+
+  OK(increment(crsr, 1, 1, &value));
+  assert(value == 11);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  check_row(crsr, 11, 250);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  /* The row is read without a lock, and then the lock mode is set to X
+  after it was read. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  assert(increment(crsr, 1, 1, &value) == DB_ERROR);
+
+  {
+    auto tpl = ib_clust_read_tuple_create(crsr);
+
+    read_row(crsr, tpl);
+
+    OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+    assert(ib_cursor_increment(crsr, 1, 1, &value) == DB_ERROR);
+
+    ib_tuple_delete(tpl);
+  }
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  /* Concurrent increments wait for each other's X lock on the row. */
+  {
+    std::thread t1(increment_rows);
+    std::thread t2(increment_rows);
+
+    t1.join();
+    t2.join();
+  }
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  check_row(crsr, 11 + 2 * N_INCREMENTS, 250);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
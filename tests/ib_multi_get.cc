@@ -0,0 +1,276 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_cursor_multi_get(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT, C3 VARCHAR(128), PRIMARY KEY(C1));
+INSERT INTO T VALUES(0, 0, 'a...'), (2, 6, 'c...'), ... ;
+
+Only the even keys are inserted, enough rows for the table to have many
+leaf pages. Look up batches of keys in random order, with odd keys that are
+not found, keys out of the range of the table and the same key twice. Each
+row must be returned in the tuple of its key.
+
+A transaction X locks a row. A nonblocking transaction that looks up a batch
+with X locks gets DB_WOULD_BLOCK for the locked row and the keys after it,
+the keys before it keep their rows.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+/** The keys are 0, 2, ... 2 * (N_ROWS - 1). */
+constexpr int32_t N_ROWS = 4000;
+
+constexpr ulint C3_LEN = 128;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** CREATE TABLE T(C1 INT, C2 INT, C3 VARCHAR(128), PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_tbl_sch_add_varchar_col(ib_tbl_sch, "c3", C3_LEN));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** The value of C3 of a row. */
+static std::vector<char> c3_value(int32_t c1) {
+  return std::vector<char>(C3_LEN, char('a' + c1 % 26));
+}
+
+/** INSERT INTO T VALUES(0, 0, 'a...'), (2, 6, 'c...'), ... ; */
+static void insert_rows() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  for (int32_t i = 0; i < N_ROWS; ++i) {
+    const auto c3 = c3_value(i * 2);
+
+    OK(ib_tuple_write_i32(tpl, 0, i * 2));
+    OK(ib_tuple_write_i32(tpl, 1, i * 6));
+    OK(ib_col_set_value(tpl, 2, c3.data(), c3.size()));
+    OK(ib_cursor_insert_row(crsr, tpl));
+    tpl = ib_tuple_clear(tpl);
+  }
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Look up a batch of keys.
+@return the result of ib_cursor_multi_get(), errs and the rows in tpls */
+static ib_err_t multi_get(ib_crsr_t crsr, const std::vector<int32_t> &keys, std::vector<ib_tpl_t> &tpls,
+                          std::vector<ib_err_t> &errs) {
+  std::vector<ib_tpl_t> key_tpls;
+
+  for (const auto key : keys) {
+    auto key_tpl = ib_clust_search_tuple_create(crsr);
+
+    OK(ib_tuple_write_i32(key_tpl, 0, key));
+    key_tpls.push_back(key_tpl);
+    tpls.push_back(ib_clust_read_tuple_create(crsr));
+  }
+
+  errs.assign(keys.size(), DB_ERROR);
+
+  const auto err = ib_cursor_multi_get(crsr, key_tpls.data(), keys.size(), tpls.data(), errs.data());
+
+  for (auto key_tpl : key_tpls) {
+    ib_tuple_delete(key_tpl);
+  }
+
+  return err;
+}
+
+/** Check the row of a key that was found. */
+static void check_row(ib_tpl_t tpl, int32_t c1) {
+  int32_t v1{};
+  int32_t v2{};
+  const auto c3 = c3_value(c1);
+
+  OK(ib_tuple_read_i32(tpl, 0, &v1));
+  OK(ib_tuple_read_i32(tpl, 1, &v2));
+  assert(v1 == c1);
+  assert(v2 == c1 * 3);
+  assert(ib_col_get_len(tpl, 2) == C3_LEN);
+  assert(memcmp(ib_col_get_value(tpl, 2), c3.data(), c3.size()) == 0);
+}
+
+static void delete_tuples(std::vector<ib_tpl_t> &tpls) {
+  for (auto tpl : tpls) {
+    ib_tuple_delete(tpl);
+  }
+
+  tpls.clear();
+}
+
+/** Look up batches of random keys and check the rows. */
+static void test_batches(ib_crsr_t crsr) {
+  for (int batch = 0; batch < 20; ++batch) {
+    std::vector<int32_t> keys;
+
+    for (int i = 0; i < 100; ++i) {
+      keys.push_back(int32_t(random() % (N_ROWS * 2 + 20)) - 10);
+    }
+
+    /* The same key twice, and the first and the last rows. */
+    keys.push_back(keys[0]);
+    keys.push_back(0);
+    keys.push_back((N_ROWS - 1) * 2);
+
+    std::vector<ib_tpl_t> tpls;
+    std::vector<ib_err_t> errs;
+
+    OK(multi_get(crsr, keys, tpls, errs));
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const auto key = keys[i];
+
+      if (key >= 0 && key < N_ROWS * 2 && key % 2 == 0) {
+        OK(errs[i]);
+        check_row(tpls[i], key);
+      } else {
+        assert(errs[i] == DB_RECORD_NOT_FOUND);
+      }
+    }
+
+    delete_tuples(tpls);
+  }
+}
+
+/** Wake up callback of the nonblocking transaction, the test doesn't wait. */
+static void wake(void *) {}
+
+/** A batch that runs into a row that another transaction X locked. */
+static void test_would_block(int32_t locked) {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(ib_trx, wake, nullptr));
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  /* The keys are looked up in key order, not in the order of the batch. */
+  const std::vector<int32_t> keys{locked + 100, locked, locked - 100};
+  std::vector<ib_tpl_t> tpls;
+  std::vector<ib_err_t> errs;
+
+  assert(multi_get(crsr, keys, tpls, errs) == DB_WOULD_BLOCK);
+
+  assert(errs[0] == DB_WOULD_BLOCK);
+  assert(errs[1] == DB_WOULD_BLOCK);
+  OK(errs[2]);
+  check_row(tpls[2], keys[2]);
+
+  delete_tuples(tpls);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+}
+
+int main(int, char *[]) {
+  ib_crsr_t crsr{};
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_rows();
+
+  srandom(time(nullptr));
+
+  /* Consistent reads. */
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  test_batches(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  /* Locking reads, the row N_ROWS stays X locked until the commit. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  {
+    std::vector<ib_tpl_t> tpls;
+    std::vector<ib_err_t> errs;
+
+    OK(multi_get(crsr, {N_ROWS}, tpls, errs));
+    OK(errs[0]);
+    check_row(tpls[0], N_ROWS);
+
+    delete_tuples(tpls);
+  }
+
+  test_would_block(N_ROWS);
+
+  test_batches(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,318 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_trx_set_nonblocking(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1));
+INSERT INTO T VALUES(0, 0), ... ;
+
+Trx A X locks row 4. A nonblocking trx B that X locks the row gets
+DB_WOULD_BLOCK, its callback is invoked once A commits and B then repeats
+the call and locks the row. A scan of B with X locks that runs into a row
+that A locked gets DB_WOULD_BLOCK from ib_cursor_next(), the repeated call
+returns the row. An insert of B into a gap that A locked gets DB_WOULD_BLOCK
+and inserts nothing until it is repeated. Without the callback the calls
+wait again.
+
+Restart, the pages of the table are not in the buffer pool. A search of a
+nonblocking trx returns DB_WOULD_BLOCK until the pages are read, and finds
+the row after the callback was invoked.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+constexpr int32_t N_ROWS = 10000;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** Callback of the nonblocking transactions, ctx counts the calls. */
+static void wake(void *ctx) {
+  ++*static_cast<std::atomic<int> *>(ctx);
+}
+
+/** Wait until the callback was invoked, at most a minute. */
+static void wait_for_wake(const std::atomic<int> &n_wakes, int n) {
+  for (int i = 0; n_wakes.load() < n && i < 60000; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  assert(n_wakes.load() >= n);
+}
+
+/** CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO T VALUES(c1, c1 * 10);
+@return the result of ib_cursor_insert_row() */
+static ib_err_t insert_row(ib_crsr_t crsr, int32_t c1) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_tuple_write_i32(tpl, 1, c1 * 10));
+
+  const auto err = ib_cursor_insert_row(crsr, tpl);
+
+  ib_tuple_delete(tpl);
+
+  return err;
+}
+
+/** INSERT INTO T VALUES(0, 0), (2, 20), ... ; only the even keys. */
+static void insert_rows() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  for (int32_t i = 0; i < N_ROWS; i += 2) {
+    OK(insert_row(crsr, i));
+  }
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Open a cursor that reads with X locks. */
+static ib_crsr_t open_cursor(ib_trx_t ib_trx) {
+  ib_crsr_t crsr{};
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  return crsr;
+}
+
+/** Position the cursor on a row.
+@return the result of ib_cursor_moveto() */
+static ib_err_t moveto(ib_crsr_t crsr, int32_t c1) {
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+
+  const auto err = ib_cursor_moveto(crsr, key, IB_CUR_GE, &res);
+
+  assert(err != DB_SUCCESS || res == 0);
+
+  ib_tuple_delete(key);
+
+  return err;
+}
+
+/** Read the row under the cursor and check its key. */
+static void check_row(ib_crsr_t crsr, int32_t c1) {
+  int32_t v{};
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_cursor_read_row(crsr, tpl));
+  OK(ib_tuple_read_i32(tpl, 0, &v));
+  assert(v == c1);
+
+  ib_tuple_delete(tpl);
+}
+
+/** A lock wait of a search. */
+static void test_moveto() {
+  std::atomic<int> n_wakes{};
+  auto trx_a = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr_a = open_cursor(trx_a);
+
+  OK(moveto(crsr_a, 4));
+
+  auto trx_b = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(trx_b, wake, &n_wakes));
+
+  auto crsr_b = open_cursor(trx_b);
+
+  assert(moveto(crsr_b, 4) == DB_WOULD_BLOCK);
+
+  OK(ib_cursor_close(crsr_a));
+  OK(ib_trx_commit(trx_a));
+
+  wait_for_wake(n_wakes, 1);
+
+  OK(moveto(crsr_b, 4));
+  check_row(crsr_b, 4);
+
+  OK(ib_cursor_close(crsr_b));
+  OK(ib_trx_commit(trx_b));
+}
+
+/** A lock wait of a scan, the repeated ib_cursor_next() returns the row. */
+static void test_next() {
+  std::atomic<int> n_wakes{};
+  auto trx_a = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr_a = open_cursor(trx_a);
+
+  OK(moveto(crsr_a, 6));
+
+  auto trx_b = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(trx_b, wake, &n_wakes));
+
+  auto crsr_b = open_cursor(trx_b);
+
+  OK(moveto(crsr_b, 2));
+  OK(ib_cursor_next(crsr_b));
+  check_row(crsr_b, 4);
+
+  assert(ib_cursor_next(crsr_b) == DB_WOULD_BLOCK);
+
+  OK(ib_cursor_close(crsr_a));
+  OK(ib_trx_commit(trx_a));
+
+  wait_for_wake(n_wakes, 1);
+
+  OK(ib_cursor_next(crsr_b));
+  check_row(crsr_b, 6);
+
+  OK(ib_cursor_next(crsr_b));
+  check_row(crsr_b, 8);
+
+  OK(ib_cursor_close(crsr_b));
+  OK(ib_trx_commit(trx_b));
+}
+
+/** A lock wait of an insert into a locked gap, it inserts nothing. */
+static void test_insert() {
+  std::atomic<int> n_wakes{};
+  auto trx_a = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr_a = open_cursor(trx_a);
+
+  /* The next key lock of row 10 covers the gap (8, 10). */
+  OK(moveto(crsr_a, 8));
+  OK(ib_cursor_next(crsr_a));
+  check_row(crsr_a, 10);
+
+  auto trx_b = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(trx_b, wake, &n_wakes));
+
+  auto crsr_b = open_cursor(trx_b);
+
+  assert(insert_row(crsr_b, 9) == DB_WOULD_BLOCK);
+
+  OK(ib_cursor_close(crsr_a));
+  OK(ib_trx_commit(trx_a));
+
+  wait_for_wake(n_wakes, 1);
+
+  OK(insert_row(crsr_b, 9));
+
+  /* Blocking again, nothing else locks the rows. */
+  OK(ib_trx_set_nonblocking(trx_b, nullptr, nullptr));
+  OK(moveto(crsr_b, 9));
+  check_row(crsr_b, 9);
+
+  OK(ib_cursor_close(crsr_b));
+  OK(ib_trx_rollback(trx_b));
+}
+
+/** A search of pages that are not in the buffer pool. */
+static void test_page_read() {
+  std::atomic<int> n_wakes{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(ib_trx, wake, &n_wakes));
+
+  auto crsr = open_cursor(ib_trx);
+
+  /* Each page read is a DB_WOULD_BLOCK, the callback counts them. */
+  for (int n = 1;; ++n) {
+    const auto err = moveto(crsr, N_ROWS - 2);
+
+    if (err == DB_SUCCESS) {
+      break;
+    }
+
+    assert(err == DB_WOULD_BLOCK);
+
+    wait_for_wake(n_wakes, n);
+  }
+
+  check_row(crsr, N_ROWS - 2);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+static void startup() {
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  startup();
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_rows();
+
+  test_moveto();
+  test_next();
+  test_insert();
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  startup();
+
+  test_page_read();
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
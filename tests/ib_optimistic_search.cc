@@ -0,0 +1,292 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Stress the optimistic B-tree descent of the searches. It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 VARCHAR(800), PRIMARY KEY(C1));
+INSERT INTO T VALUES(0, 'a...'), (4, 'b...'), ... ;
+
+The rows with a key that is a multiple of 4 are never changed. The writer
+threads insert long rows between them and delete them again, the inserts
+split the pages and the purge of the deletes merges them. The non-leaf pages
+change all the time. The reader threads look the unchanged rows up with
+non-locking searches (BTR_SEARCH_LEAF), each search must find its row.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <atomic>
+#include <cassert>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+/** Number of rows that are never changed, their keys are multiples of 4. */
+constexpr int32_t N_STABLE = 2000;
+
+/** The keys of the writers are the 3 keys after each of the unchanged rows. */
+constexpr int32_t STEP = 4;
+
+constexpr int N_WRITERS = 2;
+constexpr int N_READERS = 4;
+
+/** Number of times a writer inserts and deletes all of its rows. */
+constexpr int N_ROUNDS = 5;
+
+/** Number of rows a writer changes in a transaction. */
+constexpr int32_t BATCH = 100;
+
+constexpr ulint SHORT_LEN = 8;
+constexpr ulint LONG_LEN = 800;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** Number of writers that are still running, the readers stop at 0. */
+static std::atomic<int> n_writers{};
+
+/** CREATE TABLE T(C1 INT, C2 VARCHAR(800), PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_tbl_sch_add_varchar_col(ib_tbl_sch, "c2", LONG_LEN));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** The value of C2 of a row. */
+static std::vector<char> c2_value(int32_t c1, ulint len) {
+  return std::vector<char>(len, char('a' + c1 % 26));
+}
+
+/** INSERT INTO T VALUES(c1, c2); */
+static void insert_row(ib_crsr_t crsr, int32_t c1, ulint len) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  const auto c2 = c2_value(c1, len);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_col_set_value(tpl, 1, c2.data(), c2.size()));
+  OK(ib_cursor_insert_row(crsr, tpl));
+
+  ib_tuple_delete(tpl);
+}
+
+/** DELETE FROM T WHERE C1 = c1; */
+static void delete_row(ib_crsr_t crsr, int32_t c1) {
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  OK(ib_cursor_delete_row(crsr));
+
+  ib_tuple_delete(key);
+}
+
+/** INSERT INTO T VALUES(0, 'a...'), (4, 'e...'), ... ; */
+static void insert_stable_rows() {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  for (int32_t i = 0; i < N_STABLE; ++i) {
+    insert_row(crsr, i * STEP, SHORT_LEN);
+  }
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Insert or delete the rows of a writer, BATCH rows per transaction. The
+writers own disjoint ranges of the unchanged rows and only change the rows
+in the gaps after them, they don't wait for each other's locks. */
+static void change_rows(int w, bool insert) {
+  constexpr int32_t n_per_writer = N_STABLE / N_WRITERS;
+  const auto first = w * n_per_writer;
+  const auto last = first + n_per_writer;
+
+  for (auto i = first; i < last; i += BATCH) {
+    ib_crsr_t crsr{};
+    auto ib_trx = ib_trx_begin(IB_TRX_READ_COMMITTED);
+
+    OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+    OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+    for (auto j = i; j < i + BATCH && j < last; ++j) {
+      for (int32_t k = 1; k < STEP; ++k) {
+        if (insert) {
+          insert_row(crsr, j * STEP + k, LONG_LEN);
+        } else {
+          delete_row(crsr, j * STEP + k);
+        }
+      }
+    }
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+  }
+}
+
+/** Fill and empty the gaps of a writer N_ROUNDS times. */
+static void writer(int w) {
+  for (int i = 0; i < N_ROUNDS; ++i) {
+    change_rows(w, true);
+    change_rows(w, false);
+  }
+
+  --n_writers;
+}
+
+/** Look up random unchanged rows until the writers are done. */
+static void reader(int r) {
+  int64_t n_lookups{};
+  std::minstd_rand rnd(r + 1);
+
+  do {
+    ib_crsr_t crsr{};
+    auto ib_trx = ib_trx_begin(IB_TRX_READ_COMMITTED);
+
+    OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+    auto key = ib_clust_search_tuple_create(crsr);
+    auto tpl = ib_clust_read_tuple_create(crsr);
+
+    for (int i = 0; i < 1000; ++i, ++n_lookups) {
+      int res{};
+      int32_t c1{};
+      const int32_t k = int32_t(rnd() % N_STABLE) * STEP;
+
+      OK(ib_tuple_write_i32(key, 0, k));
+      OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+      assert(res == 0);
+
+      OK(ib_cursor_read_row(crsr, tpl));
+      OK(ib_tuple_read_i32(tpl, 0, &c1));
+      assert(c1 == k);
+
+      const auto c2 = c2_value(k, SHORT_LEN);
+
+      assert(ib_col_get_len(tpl, 1) == c2.size());
+      assert(memcmp(ib_col_get_value(tpl, 1), c2.data(), c2.size()) == 0);
+
+      tpl = ib_tuple_clear(tpl);
+    }
+
+    ib_tuple_delete(tpl);
+    ib_tuple_delete(key);
+
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+  } while (n_writers.load() > 0);
+
+  assert(n_lookups > 0);
+}
+
+/** Scan the table, only the unchanged rows must be left. */
+static void check_rows() {
+  ib_crsr_t crsr{};
+  int32_t n_rows{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+    assert(c1 == n_rows * STEP);
+
+    ++n_rows;
+    tpl = ib_tuple_clear(tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(n_rows == N_STABLE);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_stable_rows();
+
+  {
+    std::vector<std::thread> threads;
+
+    n_writers.store(N_WRITERS);
+
+    for (int i = 0; i < N_WRITERS; ++i) {
+      threads.emplace_back(writer, i);
+    }
+
+    for (int i = 0; i < N_READERS; ++i) {
+      threads.emplace_back(reader, i);
+    }
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  check_rows();
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,282 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_trx_begin_read_only(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1));
+INSERT INTO T VALUES(0, 0), ... (9, 90);
+
+Read only trx A reads the rows. Trx B inserts a row and commits, the read
+view of A doesn't see it. The inserts, updates, upserts and deletes of A
+return DB_READONLY and change nothing. A locking read of A S-locks a row, a
+nonblocking trx C can't X lock it until A commits. The exclusive schema
+lock and the DDL of a read only trx return DB_READONLY.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+constexpr int32_t N_ROWS = 10;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** CREATE TABLE T(C1 INT, C2 INT, PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** INSERT INTO T VALUES(c1, c1 * 10);
+@return the result of ib_cursor_insert_row() */
+static ib_err_t insert_row(ib_crsr_t crsr, int32_t c1) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_tuple_write_i32(tpl, 1, c1 * 10));
+
+  const auto err = ib_cursor_insert_row(crsr, tpl);
+
+  ib_tuple_delete(tpl);
+
+  return err;
+}
+
+/** Insert the rows [first, last) in a new transaction. */
+static void insert_rows(int32_t first, int32_t last) {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  for (auto i = first; i < last; ++i) {
+    OK(insert_row(crsr, i));
+  }
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Count the rows and check their values.
+@return the number of rows */
+static int32_t count_rows(ib_crsr_t crsr) {
+  int32_t n_rows{};
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+    int32_t c2{};
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+    OK(ib_tuple_read_i32(tpl, 1, &c2));
+    assert(c1 == n_rows);
+    assert(c2 == c1 * 10);
+
+    ++n_rows;
+    tpl = ib_tuple_clear(tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+
+  ib_tuple_delete(tpl);
+
+  return n_rows;
+}
+
+/** Position the cursor on a row and read it. */
+static void moveto(ib_crsr_t crsr, int32_t c1, ib_tpl_t tpl) {
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+  OK(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res));
+  assert(res == 0);
+
+  OK(ib_cursor_read_row(crsr, tpl));
+
+  ib_tuple_delete(key);
+}
+
+/** Every change of a read only transaction is rejected. */
+static void check_changes_rejected(ib_crsr_t crsr) {
+  assert(insert_row(crsr, N_ROWS * 2) == DB_READONLY);
+
+  auto old_tpl = ib_clust_read_tuple_create(crsr);
+  auto new_tpl = ib_clust_read_tuple_create(crsr);
+
+  moveto(crsr, 3, old_tpl);
+
+  OK(ib_tuple_copy(new_tpl, old_tpl));
+  OK(ib_tuple_write_i32(new_tpl, 1, -1));
+  assert(ib_cursor_update_row(crsr, old_tpl, new_tpl) == DB_READONLY);
+
+  bool inserted{};
+
+  assert(ib_cursor_upsert_row(crsr, new_tpl, nullptr, 0, &inserted) == DB_READONLY);
+
+  moveto(crsr, 3, old_tpl);
+  assert(ib_cursor_delete_row(crsr) == DB_READONLY);
+
+  assert(ib_cursor_delete_range(crsr, nullptr, nullptr) == DB_READONLY);
+
+  ib_tuple_delete(new_tpl);
+  ib_tuple_delete(old_tpl);
+}
+
+/** The DDL of a read only transaction is rejected. */
+static void check_ddl_rejected() {
+  char new_name[IB_MAX_TABLE_NAME_LEN];
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  auto ib_trx = ib_trx_begin_read_only(IB_TRX_REPEATABLE_READ);
+
+  snprintf(new_name, sizeof(new_name), "%s/%s2", DATABASE, TABLE);
+
+  assert(ib_schema_lock_exclusive(ib_trx) == DB_READONLY);
+  assert(!ib_schema_lock_is_exclusive(ib_trx));
+
+  OK(ib_table_schema_create(new_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+
+  assert(ib_table_create(ib_trx, ib_tbl_sch, &table_id) == DB_READONLY);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  assert(ib_table_rename(ib_trx, table_name, new_name) == DB_READONLY);
+  assert(ib_table_drop(ib_trx, table_name) == DB_READONLY);
+
+  OK(ib_table_get_id(table_name, &table_id));
+  assert(ib_index_drop(ib_trx, table_id << 32) == DB_READONLY);
+
+  OK(ib_trx_commit(ib_trx));
+}
+
+/** Wake up callback of the nonblocking transaction, the test doesn't wait. */
+static void wake(void *) {}
+
+/** Check that the row is locked by another transaction: a nonblocking
+transaction can't X lock it. */
+static void check_locked(int32_t c1) {
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(ib_trx, wake, nullptr));
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  int res{};
+  auto key = ib_clust_search_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+  assert(ib_cursor_moveto(crsr, key, IB_CUR_GE, &res) == DB_WOULD_BLOCK);
+
+  ib_tuple_delete(key);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+  insert_rows(0, N_ROWS);
+
+  /* The read view of trx A is assigned when the cursor is opened. */
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin_read_only(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  assert(count_rows(crsr) == N_ROWS);
+
+  /* Trx B, the read view of trx A doesn't see its row. */
+  insert_rows(N_ROWS, N_ROWS + 1);
+
+  assert(count_rows(crsr) == N_ROWS);
+
+  check_changes_rejected(crsr);
+
+  /* A locking read. */
+  OK(ib_cursor_lock(crsr, IB_LOCK_IS));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_S));
+
+  {
+    auto tpl = ib_clust_read_tuple_create(crsr);
+
+    moveto(crsr, 3, tpl);
+
+    ib_tuple_delete(tpl);
+  }
+
+  check_locked(3);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  check_ddl_rejected();
+
+  /* Nothing was changed by trx A. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  assert(count_rows(crsr) == N_ROWS + 1);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
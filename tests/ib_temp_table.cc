@@ -0,0 +1,270 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_table_schema_set_temporary(). It does the following:
+
+Create a database
+CREATE TEMPORARY TABLE T(C1 INT, C2 VARCHAR(64), PRIMARY KEY(C1));
+INSERT INTO T VALUES(0, 'a...'), ... ;
+ROLLBACK;
+
+The table must be empty after the rollback. Insert the rows again and
+commit, update them and roll back, the committed rows must be intact.
+Delete half of the rows and commit.
+
+Restart, the temporary table is dropped at startup. Create it again and
+drop it.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+constexpr int32_t N_ROWS = 5000;
+
+constexpr ulint C2_LEN = 64;
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** CREATE TEMPORARY TABLE T(C1 INT, C2 VARCHAR(64), PRIMARY KEY(C1)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_set_temporary(ib_tbl_sch));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_tbl_sch_add_varchar_col(ib_tbl_sch, "c2", C2_LEN));
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** Write C2 of a row, filled with c, or with the initial value if c is 0. */
+static void write_c2(ib_tpl_t tpl, int32_t c1, char c) {
+  char c2[C2_LEN];
+
+  memset(c2, c == 0 ? 'a' + c1 % 26 : c, sizeof(c2));
+  OK(ib_col_set_value(tpl, 1, c2, sizeof(c2)));
+}
+
+/** Open a cursor on the table that X locks the rows. */
+static ib_crsr_t open_cursor(ib_trx_t ib_trx) {
+  ib_crsr_t crsr{};
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_X));
+
+  return crsr;
+}
+
+/** INSERT INTO T VALUES(0, 'a...'), ... ; */
+static void insert_rows(ib_crsr_t crsr) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  for (int32_t i = 0; i < N_ROWS; ++i) {
+    OK(ib_tuple_write_i32(tpl, 0, i));
+    write_c2(tpl, i, 0);
+    OK(ib_cursor_insert_row(crsr, tpl));
+    tpl = ib_tuple_clear(tpl);
+  }
+
+  ib_tuple_delete(tpl);
+}
+
+/** UPDATE T SET C2 = 'X...'; */
+static void update_rows(ib_crsr_t crsr) {
+  auto old_tpl = ib_clust_read_tuple_create(crsr);
+  auto new_tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+
+    OK(ib_cursor_read_row(crsr, old_tpl));
+    OK(ib_tuple_read_i32(old_tpl, 0, &c1));
+    OK(ib_tuple_copy(new_tpl, old_tpl));
+
+    write_c2(new_tpl, c1, 'X');
+    OK(ib_cursor_update_row(crsr, old_tpl, new_tpl));
+
+    old_tpl = ib_tuple_clear(old_tpl);
+    new_tpl = ib_tuple_clear(new_tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+
+  ib_tuple_delete(new_tpl);
+  ib_tuple_delete(old_tpl);
+}
+
+/** DELETE FROM T WHERE C1 % 2 = 1; */
+static void delete_rows(ib_crsr_t crsr) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+
+    if (c1 % 2 == 1) {
+      OK(ib_cursor_delete_row(crsr));
+    }
+
+    tpl = ib_tuple_clear(tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+
+  ib_tuple_delete(tpl);
+}
+
+/** Scan the table with a new transaction and check the rows.
+@param[in] step                 Difference between the keys of the rows. */
+static void check_rows(int32_t n_rows, int32_t step) {
+  int32_t n{};
+  ib_crsr_t crsr{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    int32_t c1{};
+    char c2[C2_LEN];
+
+    OK(ib_cursor_read_row(crsr, tpl));
+    OK(ib_tuple_read_i32(tpl, 0, &c1));
+    assert(c1 == n * step);
+
+    memset(c2, 'a' + c1 % 26, sizeof(c2));
+    assert(ib_col_get_len(tpl, 1) == sizeof(c2));
+    assert(memcmp(ib_col_get_value(tpl, 1), c2, sizeof(c2)) == 0);
+
+    ++n;
+    tpl = ib_tuple_clear(tpl);
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(n == n_rows);
+
+  ib_tuple_delete(tpl);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+}
+
+static void startup() {
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+}
+
+int main(int, char *[]) {
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  startup();
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  /* The rollback applies the undo log of the inserts. */
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_cursor(ib_trx);
+
+  insert_rows(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+
+  check_rows(0, 1);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  insert_rows(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  check_rows(N_ROWS, 1);
+
+  /* The rollback applies the undo log of the updates. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  update_rows(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+
+  check_rows(N_ROWS, 1);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  crsr = open_cursor(ib_trx);
+
+  delete_rows(crsr);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  check_rows(N_ROWS / 2, 2);
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+  /* The temporary table is dropped at startup. */
+  startup();
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  assert(ib_cursor_open_table(table_name, ib_trx, &crsr) == DB_TABLE_NOT_FOUND);
+
+  OK(ib_trx_commit(ib_trx));
+
+  create_table();
+  check_rows(0, 1);
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,1682 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/* TPC-C like transactional benchmark.
+
+Loads the nine TPC-C tables for --warehouses warehouses and runs the five
+transactions from --threads terminals for --duration seconds, with the
+standard mix and no keying or think times:
+
+  New-Order      45%  reads the warehouse, district, customer and items,
+                      increments d_next_o_id, updates 5-15 stock rows and
+                      inserts the order, new order and order lines. 1% of
+                      them hit an unused item and are rolled back.
+  Payment        43%  updates the warehouse, district and customer totals,
+                      the customer is looked up by last name through the
+                      CUST_NAME secondary index 60% of the time, and
+                      inserts a history row.
+  Order-Status    4%  finds the last order of a customer through the
+                      ORDERS_CUST secondary index and reads its lines.
+  Delivery        4%  deletes the oldest new order of each district and
+                      updates its order, order lines and customer.
+  Stock-Level     4%  counts the items of the last 20 orders of a district
+                      that are low on stock.
+
+Each terminal has a home warehouse, 1% of the order lines and 15% of the
+payments go to another warehouse if there is more than one. The
+transactions that fail with a deadlock or a lock wait timeout are rolled
+back and counted, they are not retried.
+
+Every --interval seconds and for the whole run after the --warmup, the
+driver prints NOPM, the New-Order transactions per minute, tpmTOTAL and the
+abort, deadlock and lock wait timeout counts and the latency of each
+transaction type.
+
+The money columns are in cents and the rates in basis points so that all
+the numbers are integers. --items and --customers scale the tables down
+from the TPC-C 100000 items and 3000 customers per district for quick runs. */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test0aux.h"
+
+#define DATABASE "tpcc"
+
+using Clock = std::chrono::steady_clock;
+
+/* Test parameters, set from the command line. */
+static uint32_t n_warehouses = 2;
+static uint32_t n_items = 100000;
+static uint32_t n_customers = 3000;
+static int n_threads = 8;
+static int duration = 60;
+static int warmup = 10;
+static int interval = 10;
+static uint64_t seed = 0;
+
+/** Districts per warehouse. */
+static constexpr uint32_t N_DISTRICTS = 10;
+
+/** Rows inserted by a load transaction. */
+static constexpr int LOAD_BATCH_SIZE = 1000;
+
+/* Set to false to make the terminals exit. */
+static std::atomic<bool> test_running{};
+
+/* Next history row id, the history table has no natural key. */
+static std::atomic<uint64_t> next_h_id{};
+
+/* The constants of NURand(), chosen at startup. */
+static uint32_t c_last_c;
+static uint32_t c_id_c;
+static uint32_t ol_i_id_c;
+
+/** Tables. */
+enum Table_id {
+  T_WAREHOUSE,
+  T_DISTRICT,
+  T_CUSTOMER,
+  T_HISTORY,
+  T_NEW_ORDER,
+  T_ORDERS,
+  T_ORDER_LINE,
+  T_ITEM,
+  T_STOCK,
+  T_N
+};
+
+/** Secondary indexes used by the transactions. */
+enum Index_id { IX_CUSTOMER_NAME, IX_ORDERS_CUST, IX_N };
+
+/* Column numbers, the primary key columns come first in every table. */
+enum { W_ID, W_NAME, W_TAX, W_YTD };
+enum { D_W_ID, D_ID, D_NAME, D_TAX, D_YTD, D_NEXT_O_ID };
+enum {
+  C_W_ID,
+  C_D_ID,
+  C_ID,
+  C_LAST,
+  C_FIRST,
+  C_CREDIT,
+  C_DISCOUNT,
+  C_BALANCE,
+  C_YTD_PAYMENT,
+  C_PAYMENT_CNT,
+  C_DELIVERY_CNT,
+  C_DATA
+};
+enum { H_ID, H_C_ID, H_C_D_ID, H_C_W_ID, H_D_ID, H_W_ID, H_DATE, H_AMOUNT, H_DATA };
+enum { NO_W_ID, NO_D_ID, NO_O_ID };
+enum { O_W_ID, O_D_ID, O_ID, O_C_ID, O_ENTRY_D, O_CARRIER_ID, O_OL_CNT, O_ALL_LOCAL };
+enum { OL_W_ID, OL_D_ID, OL_O_ID, OL_NUMBER, OL_I_ID, OL_SUPPLY_W_ID, OL_DELIVERY_D, OL_QUANTITY, OL_AMOUNT, OL_DIST_INFO };
+enum { I_ID, I_NAME, I_PRICE, I_DATA };
+enum { S_W_ID, S_I_ID, S_QUANTITY, S_YTD, S_ORDER_CNT, S_REMOTE_CNT, S_DIST_INFO, S_DATA };
+
+/* Column positions in the secondary index rows, the index columns followed
+by the rest of the primary key. */
+enum { CN_W_ID, CN_D_ID, CN_LAST, CN_FIRST, CN_ID };
+enum { OC_W_ID, OC_D_ID, OC_C_ID, OC_O_ID };
+
+/** Column definition. */
+struct Column {
+  const char *m_name;
+  ib_col_type_t m_type;
+  ib_col_attr_t m_attr;
+  ulint m_len;
+};
+
+/** Index definition, the first index of a table is the clustered one. */
+struct Index {
+  const char *m_name;
+  std::vector<const char *> m_cols;
+};
+
+/** Table definition. */
+struct Table {
+  const char *m_name;
+  std::vector<Column> m_cols;
+  std::vector<Index> m_indexes;
+};
+
+#define U32(name) Column{name, IB_INT, IB_COL_UNSIGNED, sizeof(uint32_t)}
+#define I64(name) Column{name, IB_INT, IB_COL_NONE, sizeof(int64_t)}
+#define STR(name, len) Column{name, IB_VARCHAR, IB_COL_NONE, len}
+
+/** The schema, in Table_id order. */
+static const Table tables[T_N] = {
+  {"warehouse", {U32("w_id"), STR("w_name", 10), U32("w_tax"), I64("w_ytd")}, {{"PRIMARY", {"w_id"}}}},
+  {"district",
+   {U32("d_w_id"), U32("d_id"), STR("d_name", 10), U32("d_tax"), I64("d_ytd"), U32("d_next_o_id")},
+   {{"PRIMARY", {"d_w_id", "d_id"}}}},
+  {"customer",
+   {U32("c_w_id"),
+    U32("c_d_id"),
+    U32("c_id"),
+    STR("c_last", 16),
+    STR("c_first", 16),
+    STR("c_credit", 2),
+    U32("c_discount"),
+    I64("c_balance"),
+    I64("c_ytd_payment"),
+    U32("c_payment_cnt"),
+    U32("c_delivery_cnt"),
+    STR("c_data", 500)},
+   {{"PRIMARY", {"c_w_id", "c_d_id", "c_id"}}, {"CUST_NAME", {"c_w_id", "c_d_id", "c_last", "c_first"}}}},
+  {"history",
+   {I64("h_id"),
+    U32("h_c_id"),
+    U32("h_c_d_id"),
+    U32("h_c_w_id"),
+    U32("h_d_id"),
+    U32("h_w_id"),
+    I64("h_date"),
+    I64("h_amount"),
+    STR("h_data", 24)},
+   {{"PRIMARY", {"h_id"}}}},
+  {"new_order", {U32("no_w_id"), U32("no_d_id"), U32("no_o_id")}, {{"PRIMARY", {"no_w_id", "no_d_id", "no_o_id"}}}},
+  {"orders",
+   {U32("o_w_id"), U32("o_d_id"), U32("o_id"), U32("o_c_id"), I64("o_entry_d"), U32("o_carrier_id"), U32("o_ol_cnt"), U32("o_all_local")},
+   {{"PRIMARY", {"o_w_id", "o_d_id", "o_id"}}, {"ORDERS_CUST", {"o_w_id", "o_d_id", "o_c_id", "o_id"}}}},
+  {"order_line",
+   {U32("ol_w_id"),
+    U32("ol_d_id"),
+    U32("ol_o_id"),
+    U32("ol_number"),
+    U32("ol_i_id"),
+    U32("ol_supply_w_id"),
+    I64("ol_delivery_d"),
+    U32("ol_quantity"),
+    I64("ol_amount"),
+    STR("ol_dist_info", 24)},
+   {{"PRIMARY", {"ol_w_id", "ol_d_id", "ol_o_id", "ol_number"}}}},
+  {"item", {U32("i_id"), STR("i_name", 24), I64("i_price"), STR("i_data", 50)}, {{"PRIMARY", {"i_id"}}}},
+  {"stock",
+   {U32("s_w_id"), U32("s_i_id"), U32("s_quantity"), U32("s_ytd"), U32("s_order_cnt"), U32("s_remote_cnt"), STR("s_dist_info", 24), STR("s_data", 50)},
+   {{"PRIMARY", {"s_w_id", "s_i_id"}}}},
+};
+
+#undef U32
+#undef I64
+#undef STR
+
+/** The secondary indexes, in Index_id order. */
+static const std::pair<Table_id, const char *> indexes[IX_N] = {{T_CUSTOMER, "CUST_NAME"}, {T_ORDERS, "ORDERS_CUST"}};
+
+/** @return the full name of a table. */
+static std::string table_name(const Table &table) {
+  return std::string(DATABASE "/") + table.m_name;
+}
+
+static void set_u32(ib_tpl_t tpl, int col, uint32_t v) {
+  auto err = ib_tuple_write_u32(tpl, col, v);
+  assert(err == DB_SUCCESS);
+}
+
+static void set_i64(ib_tpl_t tpl, int col, int64_t v) {
+  auto err = ib_tuple_write_i64(tpl, col, v);
+  assert(err == DB_SUCCESS);
+}
+
+static void set_str(ib_tpl_t tpl, int col, const std::string &s) {
+  auto err = ib_col_set_value(tpl, col, s.data(), s.size());
+  assert(err == DB_SUCCESS);
+}
+
+static uint32_t get_u32(ib_tpl_t tpl, int col) {
+  uint32_t v{};
+  auto err = ib_tuple_read_u32(tpl, col, &v);
+  assert(err == DB_SUCCESS);
+  return v;
+}
+
+static int64_t get_i64(ib_tpl_t tpl, int col) {
+  int64_t v{};
+  auto err = ib_tuple_read_i64(tpl, col, &v);
+  assert(err == DB_SUCCESS);
+  return v;
+}
+
+static std::string get_str(ib_tpl_t tpl, int col) {
+  const auto len = ib_col_get_len(tpl, col);
+
+  if (len == IB_SQL_NULL) {
+    return {};
+  }
+
+  return std::string(static_cast<const char *>(ib_col_get_value(tpl, col)), len);
+}
+
+/** @return true if the first columns of a row are equal to key. */
+static bool prefix_matches(ib_tpl_t tpl, std::initializer_list<uint32_t> key) {
+  int i{};
+
+  for (auto v : key) {
+    if (get_u32(tpl, i++) != v) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** @return the TPC-C last name of a number in [0, 999]. */
+static std::string last_name(uint32_t n) {
+  static const char *syllables[] = {"BAR", "OUGHT", "ABLE", "PRI", "PRES", "ESE", "ANTI", "CALLY", "ATION", "EING"};
+
+  return std::string(syllables[n / 100]) + syllables[(n / 10) % 10] + syllables[n % 10];
+}
+
+/** Transaction types. */
+enum Txn_type { TXN_NEW_ORDER, TXN_PAYMENT, TXN_ORDER_STATUS, TXN_DELIVERY, TXN_STOCK_LEVEL, TXN_N };
+
+static const char *txn_names[TXN_N] = {"New-Order", "Payment", "Order-Status", "Delivery", "Stock-Level"};
+
+/** Counters of a transaction type. */
+enum Counter {
+  /** Committed transactions. */
+  CNT_COMMITS,
+
+  /** New-Order transactions rolled back on an unused item, they count in
+  NOPM like the committed ones. */
+  CNT_USER_ABORTS,
+
+  CNT_DEADLOCKS,
+  CNT_LOCK_WAIT_TIMEOUTS,
+
+  /** Other errors. */
+  CNT_ERRORS,
+
+  /** Sum of the latencies of all the transactions in nanoseconds. */
+  CNT_SUM_NS,
+
+  CNT_N
+};
+
+/** Counters of a terminal, updated by it and read by the reporter. */
+using Txn_stats = std::array<std::array<std::atomic<uint64_t>, CNT_N>, TXN_N>;
+
+/** Counters summed over the terminals. */
+using Snapshot = std::array<std::array<uint64_t, CNT_N>, TXN_N>;
+
+static std::vector<std::unique_ptr<Txn_stats>> terminal_stats;
+
+/** @return the counters of all the terminals summed. */
+static Snapshot take_snapshot() {
+  Snapshot snapshot{};
+
+  for (const auto &stats : terminal_stats) {
+    for (int t = 0; t < TXN_N; ++t) {
+      for (int c = 0; c < CNT_N; ++c) {
+        snapshot[t][c] += (*stats)[t][c].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  return snapshot;
+}
+
+/** Print the statistics of a period.
+@param[in] label                Label of the period
+@param[in] cur                  Snapshot at the end of the period
+@param[in] prev                 Snapshot at the start of the period
+@param[in] secs                 Length of the period in seconds */
+static void print_period(const char *label, const Snapshot &cur, const Snapshot &prev, double secs) {
+  Snapshot d{};
+  uint64_t n_txns{};
+  uint64_t n_aborts{};
+  uint64_t n_deadlocks{};
+  uint64_t n_timeouts{};
+
+  for (int t = 0; t < TXN_N; ++t) {
+    for (int c = 0; c < CNT_N; ++c) {
+      d[t][c] = cur[t][c] - prev[t][c];
+    }
+
+    n_txns += d[t][CNT_COMMITS] + d[t][CNT_USER_ABORTS];
+    n_aborts += d[t][CNT_DEADLOCKS] + d[t][CNT_LOCK_WAIT_TIMEOUTS] + d[t][CNT_ERRORS];
+    n_deadlocks += d[t][CNT_DEADLOCKS];
+    n_timeouts += d[t][CNT_LOCK_WAIT_TIMEOUTS];
+  }
+
+  const auto n_new_orders = d[TXN_NEW_ORDER][CNT_COMMITS] + d[TXN_NEW_ORDER][CNT_USER_ABORTS];
+  const auto n_tried = n_txns + n_aborts;
+
+  printf(
+    "%s NOPM=%.0f tpmTOTAL=%.0f aborts=%.2f%% deadlocks=%lu lock_wait_timeouts=%lu\n",
+    label,
+    double(n_new_orders) * 60.0 / secs,
+    double(n_txns) * 60.0 / secs,
+    n_tried > 0 ? double(n_aborts) * 100.0 / double(n_tried) : 0.0,
+    (unsigned long)n_deadlocks,
+    (unsigned long)n_timeouts
+  );
+
+  for (int t = 0; t < TXN_N; ++t) {
+    const auto n = d[t][CNT_COMMITS] + d[t][CNT_USER_ABORTS] + d[t][CNT_DEADLOCKS] + d[t][CNT_LOCK_WAIT_TIMEOUTS] + d[t][CNT_ERRORS];
+
+    if (n == 0) {
+      continue;
+    }
+
+    printf(
+      "  %-13s txns=%-9lu tpm=%-9.0f avg=%.2fms user_aborts=%lu deadlocks=%lu lock_wait_timeouts=%lu errors=%lu\n",
+      txn_names[t],
+      (unsigned long)n,
+      double(n) * 60.0 / secs,
+      double(d[t][CNT_SUM_NS]) / double(n) / 1000000.0,
+      (unsigned long)d[t][CNT_USER_ABORTS],
+      (unsigned long)d[t][CNT_DEADLOCKS],
+      (unsigned long)d[t][CNT_LOCK_WAIT_TIMEOUTS],
+      (unsigned long)d[t][CNT_ERRORS]
+    );
+  }
+
+  fflush(stdout);
+}
+
+/** A cursor with its tuples, opened once and attached to each transaction. */
+struct Cursor {
+  /** Open a cursor on the clustered index of a table. */
+  void open(const Table &table) {
+    const auto name = table_name(table);
+
+    auto err = ib_cursor_open_table(name.c_str(), nullptr, &m_crsr);
+    assert(err == DB_SUCCESS);
+
+    m_key = ib_clust_search_tuple_create(m_crsr);
+    assert(m_key != nullptr);
+
+    m_row = ib_clust_read_tuple_create(m_crsr);
+    assert(m_row != nullptr);
+
+    m_new = ib_clust_read_tuple_create(m_crsr);
+    assert(m_new != nullptr);
+  }
+
+  /** Open a cursor on a secondary index, only for reading the index rows. */
+  void open(const Cursor &table_cursor, const char *index_name) {
+    auto err = ib_cursor_open_index_using_name(table_cursor.m_crsr, index_name, &m_crsr);
+    assert(err == DB_SUCCESS);
+
+    m_key = ib_sec_search_tuple_create(m_crsr);
+    assert(m_key != nullptr);
+
+    m_row = ib_sec_read_tuple_create(m_crsr);
+    assert(m_row != nullptr);
+  }
+
+  void close() {
+    ib_tuple_delete(m_key);
+    ib_tuple_delete(m_row);
+
+    if (m_new != nullptr) {
+      ib_tuple_delete(m_new);
+    }
+
+    auto err = ib_cursor_close(m_crsr);
+    assert(err == DB_SUCCESS);
+  }
+
+  /** @return the search tuple, cleared. */
+  ib_tpl_t key() {
+    m_key = ib_tuple_clear(m_key);
+    assert(m_key != nullptr);
+    return m_key;
+  }
+
+  /** @return the tuple for a new row or the new version of m_row, cleared. */
+  ib_tpl_t new_row() {
+    m_new = ib_tuple_clear(m_new);
+    assert(m_new != nullptr);
+    return m_new;
+  }
+
+  /** Position on the first row whose key is >= the search tuple.
+  @param[in] lock_mode          IB_LOCK_NONE for a consistent read,
+                                IB_LOCK_X to update the row
+  @param[in] exact              true to fail unless the key is equal
+  @return DB_SUCCESS, DB_RECORD_NOT_FOUND or error code */
+  ib_err_t seek(ib_lck_mode_t lock_mode, bool exact) {
+    int res = ~0;
+
+    auto err = ib_cursor_set_lock_mode(m_crsr, lock_mode);
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    ib_cursor_set_match_mode(m_crsr, exact ? IB_EXACT_MATCH : IB_CLOSEST_MATCH);
+
+    err = ib_cursor_moveto(m_crsr, m_key, IB_CUR_GE, &res);
+
+    if (err == DB_END_OF_INDEX || (err == DB_SUCCESS && exact && res != 0)) {
+      err = DB_RECORD_NOT_FOUND;
+    }
+
+    return err;
+  }
+
+  /** Position on the first row >= key, a prefix of the primary key. */
+  ib_err_t seek(ib_lck_mode_t lock_mode, std::initializer_list<uint32_t> key, bool exact) {
+    int i{};
+
+    auto tpl = this->key();
+
+    for (auto v : key) {
+      set_u32(tpl, i++, v);
+    }
+
+    return seek(lock_mode, exact);
+  }
+
+  /** Read the row the cursor is on into m_row. */
+  ib_err_t read() {
+    m_row = ib_tuple_clear(m_row);
+    assert(m_row != nullptr);
+
+    return ib_cursor_read_row(m_crsr, m_row);
+  }
+
+  /** Read the row with the primary key key into m_row. */
+  ib_err_t get(ib_lck_mode_t lock_mode, std::initializer_list<uint32_t> key) {
+    auto err = seek(lock_mode, key, true);
+
+    return err == DB_SUCCESS ? read() : err;
+  }
+
+  /** Replace m_row with a copy changed by modify(). */
+  template <typename F>
+  ib_err_t update(F &&modify) {
+    auto err = ib_tuple_copy(new_row(), m_row);
+    assert(err == DB_SUCCESS);
+
+    modify(m_new);
+
+    return ib_cursor_update_row(m_crsr, m_row, m_new);
+  }
+
+  /** Insert m_new. */
+  ib_err_t insert() {
+    auto err = ib_cursor_lock(m_crsr, IB_LOCK_IX);
+
+    return err == DB_SUCCESS ? ib_cursor_insert_row(m_crsr, m_new) : err;
+  }
+
+  ib_crsr_t m_crsr{};
+  ib_tpl_t m_key{};
+  ib_tpl_t m_row{};
+  ib_tpl_t m_new{};
+};
+
+/** A terminal, it has a cursor on every table and runs one transaction at a
+time. */
+struct Terminal {
+  Terminal(int id, Txn_stats *stats) : m_rng(seed + id), m_w_id(1 + id % n_warehouses), m_stats(stats) {}
+
+  void open() {
+    for (int i = 0; i < T_N; ++i) {
+      m_cursors[i].open(tables[i]);
+    }
+
+    for (int i = 0; i < IX_N; ++i) {
+      m_index_cursors[i].open(m_cursors[indexes[i].first], indexes[i].second);
+    }
+  }
+
+  void close() {
+    for (auto &c : m_index_cursors) {
+      c.close();
+    }
+
+    for (auto &c : m_cursors) {
+      c.close();
+    }
+  }
+
+  /** @return a uniform random number in [lo, hi]. */
+  uint32_t rand(uint32_t lo, uint32_t hi) {
+    return std::uniform_int_distribution<uint32_t>(lo, hi)(m_rng);
+  }
+
+  /** @return the TPC-C non-uniform random number in [lo, hi]. */
+  uint32_t nurand(uint32_t a, uint32_t c, uint32_t lo, uint32_t hi) {
+    return (((rand(0, a) | rand(lo, hi)) + c) % (hi - lo + 1)) + lo;
+  }
+
+  /** @return a random string of [lo, hi] characters. */
+  std::string rand_str(uint32_t lo, uint32_t hi) {
+    static const char txt[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                              "abcdefghijklmnopqrstuvwxyz"
+                              "0123456789";
+    std::string s(rand(lo, hi), ' ');
+
+    for (auto &c : s) {
+      c = txt[rand(0, sizeof(txt) - 2)];
+    }
+
+    return s;
+  }
+
+  /** @return a customer id for a transaction. */
+  uint32_t rand_c_id() { return nurand(1023, c_id_c, 1, n_customers); }
+
+  /** @return a last name for a transaction, one that exists. */
+  std::string rand_last() { return last_name(nurand(255, c_last_c, 0, std::min(999U, n_customers - 1))); }
+
+  /** @return another warehouse than the home one, if there is one. */
+  uint32_t rand_remote_w_id() {
+    if (n_warehouses == 1) {
+      return m_w_id;
+    }
+
+    const auto w_id = rand(1, n_warehouses - 1);
+
+    return w_id >= m_w_id ? w_id + 1 : w_id;
+  }
+
+  Cursor &cursor(Table_id id) { return m_cursors[id]; }
+
+  void begin() {
+    m_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    assert(m_trx != nullptr);
+
+    for (auto &c : m_cursors) {
+      ib_cursor_attach_trx(c.m_crsr, m_trx);
+    }
+
+    for (auto &c : m_index_cursors) {
+      ib_cursor_attach_trx(c.m_crsr, m_trx);
+    }
+  }
+
+  /** Commit the transaction if err is DB_SUCCESS, roll it back otherwise. */
+  ib_err_t end(ib_err_t err) {
+    for (auto &c : m_index_cursors) {
+      auto err2 = ib_cursor_reset(c.m_crsr);
+      assert(err2 == DB_SUCCESS);
+    }
+
+    for (auto &c : m_cursors) {
+      auto err2 = ib_cursor_reset(c.m_crsr);
+      assert(err2 == DB_SUCCESS);
+    }
+
+    if (err == DB_SUCCESS) {
+      err = ib_trx_commit(m_trx);
+    } else {
+      auto err2 = ib_trx_rollback(m_trx);
+      assert(err2 == DB_SUCCESS);
+    }
+
+    m_trx = nullptr;
+
+    return err;
+  }
+
+  /** Find a customer by last name, the one in the middle of the ones with
+  that name in c_first order.
+  @param[in] w_id               Warehouse of the customer
+  @param[in] d_id               District of the customer
+  @param[in] last               Last name
+  @param[out] c_id              Customer id
+  @return DB_SUCCESS or error code */
+  ib_err_t find_customer(uint32_t w_id, uint32_t d_id, const std::string &last, uint32_t &c_id) {
+    auto &c = m_index_cursors[IX_CUSTOMER_NAME];
+    std::vector<uint32_t> c_ids;
+
+    auto key = c.key();
+
+    set_u32(key, CN_W_ID, w_id);
+    set_u32(key, CN_D_ID, d_id);
+    set_str(key, CN_LAST, last);
+
+    auto err = c.seek(IB_LOCK_NONE, false);
+
+    while (err == DB_SUCCESS) {
+      err = c.read();
+
+      if (err != DB_SUCCESS || !prefix_matches(c.m_row, {w_id, d_id}) || get_str(c.m_row, CN_LAST) != last) {
+        break;
+      }
+
+      c_ids.push_back(get_u32(c.m_row, CN_ID));
+
+      err = ib_cursor_next(c.m_crsr);
+    }
+
+    if (err != DB_SUCCESS && err != DB_END_OF_INDEX && err != DB_RECORD_NOT_FOUND) {
+      return err;
+    } else if (c_ids.empty()) {
+      return DB_RECORD_NOT_FOUND;
+    }
+
+    c_id = c_ids[(c_ids.size() - 1) / 2];
+
+    return DB_SUCCESS;
+  }
+
+  ib_err_t new_order() {
+    const auto d_id = rand(1, N_DISTRICTS);
+    const auto c_id = rand_c_id();
+    const auto ol_cnt = rand(5, 15);
+    const auto rollback = rand(1, 100) == 1;
+    const auto now = int64_t(time(nullptr));
+    std::vector<std::pair<uint32_t, uint32_t>> lines;
+    uint32_t all_local = 1;
+
+    for (uint32_t i = 0; i < ol_cnt; ++i) {
+      auto i_id = nurand(8191, ol_i_id_c, 1, n_items);
+      auto supply_w_id = m_w_id;
+
+      if (rollback && i == ol_cnt - 1) {
+        /* An unused item, the transaction is rolled back. */
+        i_id = n_items + 1;
+      } else if (rand(1, 100) == 1) {
+        supply_w_id = rand_remote_w_id();
+      }
+
+      all_local &= supply_w_id == m_w_id;
+
+      lines.emplace_back(i_id, supply_w_id);
+    }
+
+    /* Lock the stock rows in item order like the usual implementations do,
+    to avoid deadlocks between New-Order transactions. */
+    std::sort(lines.begin(), lines.end());
+
+    auto &warehouse = cursor(T_WAREHOUSE);
+    auto err = warehouse.get(IB_LOCK_NONE, {m_w_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &district = cursor(T_DISTRICT);
+    err = district.get(IB_LOCK_X, {m_w_id, d_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    const auto o_id = get_u32(district.m_row, D_NEXT_O_ID);
+
+    err = district.update([&](ib_tpl_t tpl) { set_u32(tpl, D_NEXT_O_ID, o_id + 1); });
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &customer = cursor(T_CUSTOMER);
+    err = customer.get(IB_LOCK_NONE, {m_w_id, d_id, c_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &orders = cursor(T_ORDERS);
+    auto tpl = orders.new_row();
+
+    set_u32(tpl, O_W_ID, m_w_id);
+    set_u32(tpl, O_D_ID, d_id);
+    set_u32(tpl, O_ID, o_id);
+    set_u32(tpl, O_C_ID, c_id);
+    set_i64(tpl, O_ENTRY_D, now);
+    set_u32(tpl, O_CARRIER_ID, 0);
+    set_u32(tpl, O_OL_CNT, ol_cnt);
+    set_u32(tpl, O_ALL_LOCAL, all_local);
+
+    err = orders.insert();
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &new_order = cursor(T_NEW_ORDER);
+    tpl = new_order.new_row();
+
+    set_u32(tpl, NO_W_ID, m_w_id);
+    set_u32(tpl, NO_D_ID, d_id);
+    set_u32(tpl, NO_O_ID, o_id);
+
+    err = new_order.insert();
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &item = cursor(T_ITEM);
+    auto &stock = cursor(T_STOCK);
+    auto &order_line = cursor(T_ORDER_LINE);
+    uint32_t ol_number{};
+
+    for (const auto &[i_id, supply_w_id] : lines) {
+      const auto quantity = rand(1, 10);
+
+      err = item.get(IB_LOCK_NONE, {i_id});
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      const auto price = get_i64(item.m_row, I_PRICE);
+
+      err = stock.get(IB_LOCK_X, {supply_w_id, i_id});
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      const auto dist_info = get_str(stock.m_row, S_DIST_INFO);
+
+      err = stock.update([&](ib_tpl_t tpl) {
+        const auto s_quantity = get_u32(stock.m_row, S_QUANTITY);
+
+        set_u32(tpl, S_QUANTITY, s_quantity >= quantity + 10 ? s_quantity - quantity : s_quantity - quantity + 91);
+        set_u32(tpl, S_YTD, get_u32(stock.m_row, S_YTD) + quantity);
+        set_u32(tpl, S_ORDER_CNT, get_u32(stock.m_row, S_ORDER_CNT) + 1);
+
+        if (supply_w_id != m_w_id) {
+          set_u32(tpl, S_REMOTE_CNT, get_u32(stock.m_row, S_REMOTE_CNT) + 1);
+        }
+      });
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      tpl = order_line.new_row();
+
+      set_u32(tpl, OL_W_ID, m_w_id);
+      set_u32(tpl, OL_D_ID, d_id);
+      set_u32(tpl, OL_O_ID, o_id);
+      set_u32(tpl, OL_NUMBER, ++ol_number);
+      set_u32(tpl, OL_I_ID, i_id);
+      set_u32(tpl, OL_SUPPLY_W_ID, supply_w_id);
+      set_i64(tpl, OL_DELIVERY_D, 0);
+      set_u32(tpl, OL_QUANTITY, quantity);
+      set_i64(tpl, OL_AMOUNT, price * quantity);
+      set_str(tpl, OL_DIST_INFO, dist_info);
+
+      err = order_line.insert();
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+    }
+
+    return DB_SUCCESS;
+  }
+
+  ib_err_t payment() {
+    const auto d_id = rand(1, N_DISTRICTS);
+    const auto amount = int64_t(rand(100, 500000));
+    const auto remote = rand(1, 100) <= 15;
+    const auto c_w_id = remote ? rand_remote_w_id() : m_w_id;
+    const auto c_d_id = remote ? rand(1, N_DISTRICTS) : d_id;
+    uint32_t c_id = rand_c_id();
+
+    auto &warehouse = cursor(T_WAREHOUSE);
+    auto err = warehouse.get(IB_LOCK_X, {m_w_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    const auto w_name = get_str(warehouse.m_row, W_NAME);
+
+    err = warehouse.update([&](ib_tpl_t tpl) { set_i64(tpl, W_YTD, get_i64(warehouse.m_row, W_YTD) + amount); });
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &district = cursor(T_DISTRICT);
+    err = district.get(IB_LOCK_X, {m_w_id, d_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    const auto d_name = get_str(district.m_row, D_NAME);
+
+    err = district.update([&](ib_tpl_t tpl) { set_i64(tpl, D_YTD, get_i64(district.m_row, D_YTD) + amount); });
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    if (rand(1, 100) <= 60) {
+      err = find_customer(c_w_id, c_d_id, rand_last(), c_id);
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+    }
+
+    auto &customer = cursor(T_CUSTOMER);
+    err = customer.get(IB_LOCK_X, {c_w_id, c_d_id, c_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    err = customer.update([&](ib_tpl_t tpl) {
+      set_i64(tpl, C_BALANCE, get_i64(customer.m_row, C_BALANCE) - amount);
+      set_i64(tpl, C_YTD_PAYMENT, get_i64(customer.m_row, C_YTD_PAYMENT) + amount);
+      set_u32(tpl, C_PAYMENT_CNT, get_u32(customer.m_row, C_PAYMENT_CNT) + 1);
+
+      if (get_str(customer.m_row, C_CREDIT) == "BC") {
+        auto data = std::to_string(c_id) + " " + std::to_string(amount) + " " + get_str(customer.m_row, C_DATA);
+
+        data.resize(std::min(data.size(), size_t(500)));
+
+        set_str(tpl, C_DATA, data);
+      }
+    });
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &history = cursor(T_HISTORY);
+    auto tpl = history.new_row();
+
+    set_i64(tpl, H_ID, int64_t(next_h_id.fetch_add(1, std::memory_order_relaxed)));
+    set_u32(tpl, H_C_ID, c_id);
+    set_u32(tpl, H_C_D_ID, c_d_id);
+    set_u32(tpl, H_C_W_ID, c_w_id);
+    set_u32(tpl, H_D_ID, d_id);
+    set_u32(tpl, H_W_ID, m_w_id);
+    set_i64(tpl, H_DATE, int64_t(time(nullptr)));
+    set_i64(tpl, H_AMOUNT, amount);
+    set_str(tpl, H_DATA, w_name + "    " + d_name);
+
+    return history.insert();
+  }
+
+  ib_err_t order_status() {
+    const auto d_id = rand(1, N_DISTRICTS);
+    uint32_t c_id = rand_c_id();
+    ib_err_t err;
+
+    if (rand(1, 100) <= 60) {
+      err = find_customer(m_w_id, d_id, rand_last(), c_id);
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+    }
+
+    auto &customer = cursor(T_CUSTOMER);
+    err = customer.get(IB_LOCK_NONE, {m_w_id, d_id, c_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    /* The last order of the customer is the last index row of the prefix. */
+    auto &orders_cust = m_index_cursors[IX_ORDERS_CUST];
+    uint32_t o_id{};
+
+    err = orders_cust.seek(IB_LOCK_NONE, {m_w_id, d_id, c_id}, false);
+
+    while (err == DB_SUCCESS) {
+      err = orders_cust.read();
+
+      if (err != DB_SUCCESS || !prefix_matches(orders_cust.m_row, {m_w_id, d_id, c_id})) {
+        break;
+      }
+
+      o_id = get_u32(orders_cust.m_row, OC_O_ID);
+
+      err = ib_cursor_next(orders_cust.m_crsr);
+    }
+
+    if (err != DB_SUCCESS && err != DB_END_OF_INDEX && err != DB_RECORD_NOT_FOUND) {
+      return err;
+    } else if (o_id == 0) {
+      /* A customer without orders. */
+      return DB_SUCCESS;
+    }
+
+    err = cursor(T_ORDERS).get(IB_LOCK_NONE, {m_w_id, d_id, o_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    auto &order_line = cursor(T_ORDER_LINE);
+    err = order_line.seek(IB_LOCK_NONE, {m_w_id, d_id, o_id}, false);
+
+    while (err == DB_SUCCESS) {
+      err = order_line.read();
+
+      if (err != DB_SUCCESS || !prefix_matches(order_line.m_row, {m_w_id, d_id, o_id})) {
+        break;
+      }
+
+      err = ib_cursor_next(order_line.m_crsr);
+    }
+
+    return err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND ? DB_SUCCESS : err;
+  }
+
+  ib_err_t delivery() {
+    const auto carrier_id = rand(1, 10);
+    const auto now = int64_t(time(nullptr));
+
+    for (uint32_t d_id = 1; d_id <= N_DISTRICTS; ++d_id) {
+      /* The oldest new order of the district. */
+      auto &new_order = cursor(T_NEW_ORDER);
+      auto err = new_order.seek(IB_LOCK_X, {m_w_id, d_id}, false);
+
+      if (err == DB_SUCCESS) {
+        err = new_order.read();
+      }
+
+      if (err == DB_RECORD_NOT_FOUND || err == DB_END_OF_INDEX || (err == DB_SUCCESS && !prefix_matches(new_order.m_row, {m_w_id, d_id}))) {
+        /* No order to deliver in this district. */
+        continue;
+      } else if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      const auto o_id = get_u32(new_order.m_row, NO_O_ID);
+
+      err = ib_cursor_delete_row(new_order.m_crsr);
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      auto &orders = cursor(T_ORDERS);
+      err = orders.get(IB_LOCK_X, {m_w_id, d_id, o_id});
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      const auto c_id = get_u32(orders.m_row, O_C_ID);
+
+      err = orders.update([&](ib_tpl_t tpl) { set_u32(tpl, O_CARRIER_ID, carrier_id); });
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      auto &order_line = cursor(T_ORDER_LINE);
+      int64_t total{};
+
+      err = order_line.seek(IB_LOCK_X, {m_w_id, d_id, o_id}, false);
+
+      while (err == DB_SUCCESS) {
+        err = order_line.read();
+
+        if (err != DB_SUCCESS || !prefix_matches(order_line.m_row, {m_w_id, d_id, o_id})) {
+          break;
+        }
+
+        total += get_i64(order_line.m_row, OL_AMOUNT);
+
+        err = order_line.update([&](ib_tpl_t tpl) { set_i64(tpl, OL_DELIVERY_D, now); });
+
+        if (err == DB_SUCCESS) {
+          err = ib_cursor_next(order_line.m_crsr);
+        }
+      }
+
+      if (err != DB_SUCCESS && err != DB_END_OF_INDEX && err != DB_RECORD_NOT_FOUND) {
+        return err;
+      }
+
+      auto &customer = cursor(T_CUSTOMER);
+      err = customer.get(IB_LOCK_X, {m_w_id, d_id, c_id});
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      err = customer.update([&](ib_tpl_t tpl) {
+        set_i64(tpl, C_BALANCE, get_i64(customer.m_row, C_BALANCE) + total);
+        set_u32(tpl, C_DELIVERY_CNT, get_u32(customer.m_row, C_DELIVERY_CNT) + 1);
+      });
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+    }
+
+    return DB_SUCCESS;
+  }
+
+  ib_err_t stock_level() {
+    const auto d_id = rand(1, N_DISTRICTS);
+    const auto threshold = rand(10, 20);
+
+    auto &district = cursor(T_DISTRICT);
+    auto err = district.get(IB_LOCK_NONE, {m_w_id, d_id});
+
+    if (err != DB_SUCCESS) {
+      return err;
+    }
+
+    const auto next_o_id = get_u32(district.m_row, D_NEXT_O_ID);
+    const auto first_o_id = next_o_id > 20 ? next_o_id - 20 : 1;
+    std::vector<uint32_t> i_ids;
+
+    auto &order_line = cursor(T_ORDER_LINE);
+    err = order_line.seek(IB_LOCK_NONE, {m_w_id, d_id, first_o_id}, false);
+
+    while (err == DB_SUCCESS) {
+      err = order_line.read();
+
+      if (err != DB_SUCCESS || !prefix_matches(order_line.m_row, {m_w_id, d_id}) || get_u32(order_line.m_row, OL_O_ID) >= next_o_id) {
+        break;
+      }
+
+      i_ids.push_back(get_u32(order_line.m_row, OL_I_ID));
+
+      err = ib_cursor_next(order_line.m_crsr);
+    }
+
+    if (err != DB_SUCCESS && err != DB_END_OF_INDEX && err != DB_RECORD_NOT_FOUND) {
+      return err;
+    }
+
+    std::sort(i_ids.begin(), i_ids.end());
+    i_ids.erase(std::unique(i_ids.begin(), i_ids.end()), i_ids.end());
+
+    auto &stock = cursor(T_STOCK);
+    uint32_t n_low{};
+
+    for (auto i_id : i_ids) {
+      err = stock.get(IB_LOCK_NONE, {m_w_id, i_id});
+
+      if (err != DB_SUCCESS) {
+        return err;
+      }
+
+      n_low += get_u32(stock.m_row, S_QUANTITY) < threshold;
+    }
+
+    /* The count is the result for the terminal, nobody looks at it. */
+    (void)n_low;
+
+    return DB_SUCCESS;
+  }
+
+  /** @return the next transaction type of the mix. */
+  Txn_type choose_txn() {
+    const auto r = rand(1, 100);
+
+    if (r <= 45) {
+      return TXN_NEW_ORDER;
+    } else if (r <= 88) {
+      return TXN_PAYMENT;
+    } else if (r <= 92) {
+      return TXN_ORDER_STATUS;
+    } else if (r <= 96) {
+      return TXN_DELIVERY;
+    } else {
+      return TXN_STOCK_LEVEL;
+    }
+  }
+
+  /** Run a transaction and count its outcome. */
+  void run_txn(Txn_type type) {
+    const auto start = Clock::now();
+    ib_err_t err;
+
+    begin();
+
+    switch (type) {
+      case TXN_NEW_ORDER:
+        err = new_order();
+        break;
+      case TXN_PAYMENT:
+        err = payment();
+        break;
+      case TXN_ORDER_STATUS:
+        err = order_status();
+        break;
+      case TXN_DELIVERY:
+        err = delivery();
+        break;
+      case TXN_STOCK_LEVEL:
+        err = stock_level();
+        break;
+      default:
+        assert(false);
+        err = DB_ERROR;
+    }
+
+    err = end(err);
+
+    auto &stats = (*m_stats)[type];
+
+    switch (err) {
+      case DB_SUCCESS:
+        stats[CNT_COMMITS].fetch_add(1, std::memory_order_relaxed);
+        break;
+      case DB_RECORD_NOT_FOUND:
+        /* Only the unused item of a New-Order is expected not to exist. */
+        stats[type == TXN_NEW_ORDER ? CNT_USER_ABORTS : CNT_ERRORS].fetch_add(1, std::memory_order_relaxed);
+        break;
+      case DB_DEADLOCK:
+        stats[CNT_DEADLOCKS].fetch_add(1, std::memory_order_relaxed);
+        break;
+      case DB_LOCK_WAIT_TIMEOUT:
+        stats[CNT_LOCK_WAIT_TIMEOUTS].fetch_add(1, std::memory_order_relaxed);
+        break;
+      default:
+        stats[CNT_ERRORS].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    stats[CNT_SUM_NS].fetch_add(uint64_t(ns), std::memory_order_relaxed);
+  }
+
+  /** Run transactions until the test stops. */
+  void run() {
+    open();
+
+    while (test_running.load(std::memory_order_relaxed)) {
+      run_txn(choose_txn());
+    }
+
+    close();
+  }
+
+  /** Insert the row built in the m_new tuple of a table, commits every
+  LOAD_BATCH_SIZE rows. */
+  void load_row(Table_id id) {
+    if (m_trx == nullptr) {
+      begin();
+    }
+
+    auto err = cursor(id).insert();
+    assert(err == DB_SUCCESS);
+
+    if (++m_n_loaded % LOAD_BATCH_SIZE == 0) {
+      err = end(DB_SUCCESS);
+      assert(err == DB_SUCCESS);
+    }
+  }
+
+  /** Commit the rows loaded since the last commit. */
+  void load_commit() {
+    if (m_trx != nullptr) {
+      auto err = end(DB_SUCCESS);
+      assert(err == DB_SUCCESS);
+    }
+  }
+
+  void load_items() {
+    auto &item = cursor(T_ITEM);
+
+    for (uint32_t i_id = 1; i_id <= n_items; ++i_id) {
+      auto tpl = item.new_row();
+
+      set_u32(tpl, I_ID, i_id);
+      set_str(tpl, I_NAME, rand_str(14, 24));
+      set_i64(tpl, I_PRICE, rand(100, 10000));
+      set_str(tpl, I_DATA, rand_str(26, 50));
+
+      load_row(T_ITEM);
+    }
+
+    load_commit();
+  }
+
+  /** Load the rows of the home warehouse of the terminal. */
+  void load_warehouse() {
+    const auto w_id = m_w_id;
+    const auto now = int64_t(time(nullptr));
+
+    auto tpl = cursor(T_WAREHOUSE).new_row();
+
+    set_u32(tpl, W_ID, w_id);
+    set_str(tpl, W_NAME, rand_str(6, 10));
+    set_u32(tpl, W_TAX, rand(0, 2000));
+    set_i64(tpl, W_YTD, 30000000);
+
+    load_row(T_WAREHOUSE);
+
+    for (uint32_t i_id = 1; i_id <= n_items; ++i_id) {
+      tpl = cursor(T_STOCK).new_row();
+
+      set_u32(tpl, S_W_ID, w_id);
+      set_u32(tpl, S_I_ID, i_id);
+      set_u32(tpl, S_QUANTITY, rand(10, 100));
+      set_u32(tpl, S_YTD, 0);
+      set_u32(tpl, S_ORDER_CNT, 0);
+      set_u32(tpl, S_REMOTE_CNT, 0);
+      set_str(tpl, S_DIST_INFO, rand_str(24, 24));
+      set_str(tpl, S_DATA, rand_str(26, 50));
+
+      load_row(T_STOCK);
+    }
+
+    /* The last 30% of the orders of each district are not delivered. */
+    const auto first_new_o_id = n_customers - n_customers * 3 / 10 + 1;
+
+    for (uint32_t d_id = 1; d_id <= N_DISTRICTS; ++d_id) {
+      tpl = cursor(T_DISTRICT).new_row();
+
+      set_u32(tpl, D_W_ID, w_id);
+      set_u32(tpl, D_ID, d_id);
+      set_str(tpl, D_NAME, rand_str(6, 10));
+      set_u32(tpl, D_TAX, rand(0, 2000));
+      set_i64(tpl, D_YTD, 3000000);
+      set_u32(tpl, D_NEXT_O_ID, n_customers + 1);
+
+      load_row(T_DISTRICT);
+
+      for (uint32_t c_id = 1; c_id <= n_customers; ++c_id) {
+        tpl = cursor(T_CUSTOMER).new_row();
+
+        set_u32(tpl, C_W_ID, w_id);
+        set_u32(tpl, C_D_ID, d_id);
+        set_u32(tpl, C_ID, c_id);
+        set_str(tpl, C_LAST, last_name(c_id <= 1000 ? c_id - 1 : nurand(255, c_last_c, 0, 999)));
+        set_str(tpl, C_FIRST, rand_str(8, 16));
+        set_str(tpl, C_CREDIT, rand(1, 10) == 1 ? "BC" : "GC");
+        set_u32(tpl, C_DISCOUNT, rand(0, 5000));
+        set_i64(tpl, C_BALANCE, -1000);
+        set_i64(tpl, C_YTD_PAYMENT, 1000);
+        set_u32(tpl, C_PAYMENT_CNT, 1);
+        set_u32(tpl, C_DELIVERY_CNT, 0);
+        set_str(tpl, C_DATA, rand_str(300, 500));
+
+        load_row(T_CUSTOMER);
+
+        tpl = cursor(T_HISTORY).new_row();
+
+        set_i64(tpl, H_ID, int64_t(next_h_id.fetch_add(1, std::memory_order_relaxed)));
+        set_u32(tpl, H_C_ID, c_id);
+        set_u32(tpl, H_C_D_ID, d_id);
+        set_u32(tpl, H_C_W_ID, w_id);
+        set_u32(tpl, H_D_ID, d_id);
+        set_u32(tpl, H_W_ID, w_id);
+        set_i64(tpl, H_DATE, now);
+        set_i64(tpl, H_AMOUNT, 1000);
+        set_str(tpl, H_DATA, rand_str(12, 24));
+
+        load_row(T_HISTORY);
+      }
+
+      /* One order per customer, in random customer order. */
+      std::vector<uint32_t> c_ids(n_customers);
+
+      for (uint32_t i = 0; i < n_customers; ++i) {
+        c_ids[i] = i + 1;
+      }
+
+      std::shuffle(c_ids.begin(), c_ids.end(), m_rng);
+
+      for (uint32_t o_id = 1; o_id <= n_customers; ++o_id) {
+        const auto delivered = o_id < first_new_o_id;
+        const auto ol_cnt = rand(5, 15);
+
+        tpl = cursor(T_ORDERS).new_row();
+
+        set_u32(tpl, O_W_ID, w_id);
+        set_u32(tpl, O_D_ID, d_id);
+        set_u32(tpl, O_ID, o_id);
+        set_u32(tpl, O_C_ID, c_ids[o_id - 1]);
+        set_i64(tpl, O_ENTRY_D, now);
+        set_u32(tpl, O_CARRIER_ID, delivered ? rand(1, 10) : 0);
+        set_u32(tpl, O_OL_CNT, ol_cnt);
+        set_u32(tpl, O_ALL_LOCAL, 1);
+
+        load_row(T_ORDERS);
+
+        for (uint32_t ol_number = 1; ol_number <= ol_cnt; ++ol_number) {
+          tpl = cursor(T_ORDER_LINE).new_row();
+
+          set_u32(tpl, OL_W_ID, w_id);
+          set_u32(tpl, OL_D_ID, d_id);
+          set_u32(tpl, OL_O_ID, o_id);
+          set_u32(tpl, OL_NUMBER, ol_number);
+          set_u32(tpl, OL_I_ID, rand(1, n_items));
+          set_u32(tpl, OL_SUPPLY_W_ID, w_id);
+          set_i64(tpl, OL_DELIVERY_D, delivered ? now : 0);
+          set_u32(tpl, OL_QUANTITY, 5);
+          set_i64(tpl, OL_AMOUNT, delivered ? 0 : rand(1, 999999));
+          set_str(tpl, OL_DIST_INFO, rand_str(24, 24));
+
+          load_row(T_ORDER_LINE);
+        }
+
+        if (!delivered) {
+          tpl = cursor(T_NEW_ORDER).new_row();
+
+          set_u32(tpl, NO_W_ID, w_id);
+          set_u32(tpl, NO_D_ID, d_id);
+          set_u32(tpl, NO_O_ID, o_id);
+
+          load_row(T_NEW_ORDER);
+        }
+      }
+    }
+
+    load_commit();
+  }
+
+  std::mt19937_64 m_rng;
+
+  /** Home warehouse. */
+  uint32_t m_w_id{};
+
+  /** Counters, nullptr while loading. */
+  Txn_stats *m_stats{};
+
+  ib_trx_t m_trx{};
+
+  /** Number of rows loaded, to commit the load in batches. */
+  uint64_t m_n_loaded{};
+
+  std::array<Cursor, T_N> m_cursors{};
+  std::array<Cursor, IX_N> m_index_cursors{};
+};
+
+/** Create the tables, dropping the ones left over by an earlier run. */
+static void create_tables() {
+  for (const auto &table : tables) {
+    const auto name = table_name(table);
+    ib_tbl_sch_t ib_tbl_sch{};
+    ib_id_t table_id{};
+
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    auto err = ib_schema_lock_exclusive(ib_trx);
+    assert(err == DB_SUCCESS);
+
+    (void)ib_table_drop(ib_trx, name.c_str());
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+
+    err = ib_table_schema_create(name.c_str(), &ib_tbl_sch, IB_TBL_V1, 0);
+    assert(err == DB_SUCCESS);
+
+    for (const auto &col : table.m_cols) {
+      err = ib_table_schema_add_col(ib_tbl_sch, col.m_name, col.m_type, col.m_attr, 0, col.m_len);
+      assert(err == DB_SUCCESS);
+    }
+
+    for (const auto &index : table.m_indexes) {
+      ib_idx_sch_t ib_idx_sch{};
+
+      err = ib_table_schema_add_index(ib_tbl_sch, index.m_name, &ib_idx_sch);
+      assert(err == DB_SUCCESS);
+
+      for (auto col : index.m_cols) {
+        err = ib_index_schema_add_col(ib_idx_sch, col, 0);
+        assert(err == DB_SUCCESS);
+      }
+
+      if (&index == &table.m_indexes.front()) {
+        err = ib_index_schema_set_clustered(ib_idx_sch);
+        assert(err == DB_SUCCESS);
+      }
+    }
+
+    ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    err = ib_schema_lock_exclusive(ib_trx);
+    assert(err == DB_SUCCESS);
+
+    err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+
+    ib_table_schema_delete(ib_tbl_sch);
+  }
+}
+
+static void drop_tables() {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  auto err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  for (const auto &table : tables) {
+    err = ib_table_drop(ib_trx, table_name(table).c_str());
+    assert(err == DB_SUCCESS);
+  }
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** Load the items and then the warehouses in parallel. */
+static void load() {
+  const auto start = Clock::now();
+
+  {
+    Terminal terminal(0, nullptr);
+
+    terminal.open();
+    terminal.load_items();
+    terminal.close();
+  }
+
+  std::vector<std::thread> threads;
+
+  for (uint32_t w = 0; w < n_warehouses; ++w) {
+    threads.emplace_back([w]() {
+      Terminal terminal(int(w), nullptr);
+
+      terminal.open();
+      terminal.load_warehouse();
+      terminal.close();
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const auto secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  printf("Loaded %u warehouses in %.1f s\n", n_warehouses, secs);
+}
+
+/** Run the terminals and print the statistics every interval and at the end. */
+static void run() {
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < n_threads; ++t) {
+    terminal_stats.push_back(std::make_unique<Txn_stats>());
+  }
+
+  test_running = true;
+
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([t]() {
+      Terminal terminal(t, terminal_stats[t].get());
+
+      terminal.run();
+    });
+  }
+
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::seconds(warmup + duration);
+  const auto warmup_end = start + std::chrono::seconds(warmup);
+
+  Snapshot prev{};
+  Snapshot baseline{};
+  auto prev_time = start;
+  bool warming_up = warmup > 0;
+
+  while (prev_time < end) {
+    const auto now = std::min({prev_time + std::chrono::seconds(interval), end, warming_up ? warmup_end : end});
+
+    std::this_thread::sleep_until(now);
+
+    const auto cur = take_snapshot();
+    const auto secs = std::chrono::duration<double>(now - prev_time).count();
+    const auto elapsed = std::chrono::duration<double>(now - start).count();
+    char label[64];
+
+    snprintf(label, sizeof(label), "[%6.0f s]%s", elapsed, warming_up ? " warm-up" : "");
+
+    print_period(label, cur, prev, secs);
+
+    if (warming_up && now >= warmup_end) {
+      warming_up = false;
+      baseline = cur;
+    }
+
+    prev = cur;
+    prev_time = now;
+  }
+
+  test_running = false;
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  printf("\nSummary: warehouses=%u threads=%d items=%u customers=%u\n", n_warehouses, n_threads, n_items, n_customers);
+
+  print_period("[overall]", take_snapshot(), baseline, double(duration));
+
+  terminal_stats.clear();
+}
+
+/** Print the options of this program. */
+static void print_tpcc_usage(const char *progname) {
+  print_usage(progname);
+
+  fprintf(stderr,
+          "[--warehouses count]\n"
+          "[--threads count]\n"
+          "[--items count, 100000 for TPC-C]\n"
+          "[--customers count per district, 3000 for TPC-C]\n"
+          "[--duration seconds]\n"
+          "[--warmup seconds]\n"
+          "[--interval seconds]\n"
+          "[--seed number]\n");
+}
+
+/** Set the runtime global options. */
+static void set_options(int argc, char *argv[]) {
+  static const struct option tpcc_opts[] = {
+    {"warehouses", required_argument, nullptr, USER_OPT + 1},
+    {"threads", required_argument, nullptr, USER_OPT + 2},
+    {"items", required_argument, nullptr, USER_OPT + 3},
+    {"customers", required_argument, nullptr, USER_OPT + 4},
+    {"duration", required_argument, nullptr, USER_OPT + 5},
+    {"warmup", required_argument, nullptr, USER_OPT + 6},
+    {"interval", required_argument, nullptr, USER_OPT + 7},
+    {"seed", required_argument, nullptr, USER_OPT + 8},
+  };
+  constexpr int n_tpcc_opts = sizeof(tpcc_opts) / sizeof(tpcc_opts[0]);
+  std::vector<struct option> longopts;
+  int opt;
+
+  /* The InnoDB system options, ours and the sentinel. */
+  for (int i = 0; ib_longopts[i].name != nullptr; ++i) {
+    longopts.push_back(ib_longopts[i]);
+  }
+
+  longopts.insert(longopts.end(), tpcc_opts, tpcc_opts + n_tpcc_opts);
+  longopts.push_back({nullptr, 0, nullptr, 0});
+
+  while ((opt = getopt_long(argc, argv, "", longopts.data(), nullptr)) != -1) {
+    switch (opt) {
+      case USER_OPT + 1:
+        n_warehouses = strtoul(optarg, nullptr, 10);
+        break;
+      case USER_OPT + 2:
+        n_threads = atoi(optarg);
+        break;
+      case USER_OPT + 3:
+        n_items = strtoul(optarg, nullptr, 10);
+        break;
+      case USER_OPT + 4:
+        n_customers = strtoul(optarg, nullptr, 10);
+        break;
+      case USER_OPT + 5:
+        duration = atoi(optarg);
+        break;
+      case USER_OPT + 6:
+        warmup = atoi(optarg);
+        break;
+      case USER_OPT + 7:
+        interval = atoi(optarg);
+        break;
+      case USER_OPT + 8:
+        seed = strtoull(optarg, nullptr, 10);
+        break;
+
+      default:
+        /* If it's an InnoDB parameter, then we let the
+        auxillary function handle it. */
+        if (set_global_option(opt, optarg) != DB_SUCCESS) {
+          print_tpcc_usage(argv[0]);
+          exit(EXIT_FAILURE);
+        }
+    }
+  }
+
+  if (n_warehouses < 1 || n_threads < 1 || n_items < 1 || n_customers < 10 || duration < 1 || warmup < 0 || interval < 1) {
+    print_tpcc_usage(argv[0]);
+    exit(EXIT_FAILURE);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  set_options(argc, argv);
+
+  std::mt19937_64 rng(seed);
+
+  c_last_c = std::uniform_int_distribution<uint32_t>(0, 255)(rng);
+  c_id_c = std::uniform_int_distribution<uint32_t>(0, 1023)(rng);
+  ol_i_id_c = std::uniform_int_distribution<uint32_t>(0, 8191)(rng);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  (void)ib_database_create(DATABASE);
+
+  create_tables();
+
+  load();
+
+  run();
+
+  drop_tables();
+
+  err = ib_database_drop(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** Test ib_cursor_upsert_row(). It does the following:
+
+Create a database
+CREATE TABLE T(C1 INT, C2 INT, C3 INT, PRIMARY KEY(C1), UNIQUE INDEX(C3));
+
+Upsert a new row, it is inserted. Upsert it again, all the columns and then
+only C2, it is updated. Upsert a row whose C3 is the C3 of another row, the
+unique secondary index rejects it with DB_DUPLICATE_KEY.
+
+After the upserts a plain insert of a duplicate key S-locks the row again,
+like without the upserts: a nonblocking transaction can still S-lock it.
+
+DROP TABLE T;
+
+ The test will create all the relevant sub-directories in the current
+ working directory. */
+
+#include <cassert>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNIV_DEBUG_VALGRIND
+#include <valgrind/memcheck.h>
+#endif /* UNIV_DEBUG_VALGRIND */
+
+#include "test0aux.h"
+
+constexpr const char *DATABASE = "test";
+constexpr const char *TABLE = "t";
+
+static char table_name[IB_MAX_TABLE_NAME_LEN];
+
+/** CREATE TABLE T(C1 INT, C2 INT, C3 INT, PRIMARY KEY(C1), UNIQUE INDEX(C3)); */
+static void create_table() {
+  ib_id_t table_id{};
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+
+  OK(ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+  OK(ib_table_schema_add_col(ib_tbl_sch, "c3", IB_INT, IB_COL_NONE, 0, sizeof(int32_t)));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c1", 0));
+  OK(ib_index_schema_set_clustered(ib_idx_sch));
+
+  OK(ib_table_schema_add_index(ib_tbl_sch, "c3", &ib_idx_sch));
+  OK(ib_index_schema_add_col(ib_idx_sch, "c3", 0));
+  OK(ib_index_schema_set_unique(ib_idx_sch));
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_schema_lock_exclusive(ib_trx));
+  OK(ib_table_create(ib_trx, ib_tbl_sch, &table_id));
+  OK(ib_trx_commit(ib_trx));
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** Upsert a row.
+@return the result of ib_cursor_upsert_row() */
+static ib_err_t upsert(ib_crsr_t crsr, int32_t c1, int32_t c2, int32_t c3, const ulint *update_cols, ulint n_update_cols,
+                       bool *inserted) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_tuple_write_i32(tpl, 1, c2));
+  OK(ib_tuple_write_i32(tpl, 2, c3));
+
+  const auto err = ib_cursor_upsert_row(crsr, tpl, update_cols, n_update_cols, inserted);
+
+  ib_tuple_delete(tpl);
+
+  return err;
+}
+
+/** Insert a row.
+@return the result of ib_cursor_insert_row() */
+static ib_err_t insert(ib_crsr_t crsr, int32_t c1, int32_t c2, int32_t c3) {
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(tpl, 0, c1));
+  OK(ib_tuple_write_i32(tpl, 1, c2));
+  OK(ib_tuple_write_i32(tpl, 2, c3));
+
+  const auto err = ib_cursor_insert_row(crsr, tpl);
+
+  ib_tuple_delete(tpl);
+
+  return err;
+}
+
+/** Read a row by key.
+@return the result of ib_cursor_get_by_pk() */
+static ib_err_t get(ib_crsr_t crsr, int32_t c1, int32_t *c2, int32_t *c3) {
+  auto key = ib_clust_search_tuple_create(crsr);
+  auto tpl = ib_clust_read_tuple_create(crsr);
+
+  OK(ib_tuple_write_i32(key, 0, c1));
+
+  const auto err = ib_cursor_get_by_pk(crsr, key, tpl);
+
+  if (err == DB_SUCCESS) {
+    OK(ib_tuple_read_i32(tpl, 1, c2));
+    OK(ib_tuple_read_i32(tpl, 2, c3));
+  }
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key);
+
+  return err;
+}
+
+/** Check the columns of a row. */
+static void check_row(ib_crsr_t crsr, int32_t c1, int32_t c2, int32_t c3) {
+  int32_t v2{};
+  int32_t v3{};
+
+  OK(get(crsr, c1, &v2, &v3));
+  assert(v2 == c2);
+  assert(v3 == c3);
+}
+
+/** Wake up callback of the nonblocking transaction, the test doesn't wait. */
+static void wake(void *) {}
+
+/** Check that another transaction can S-lock a row. */
+static void check_not_x_locked(int32_t c1) {
+  ib_crsr_t crsr{};
+  int32_t c2{};
+  int32_t c3{};
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_trx_set_nonblocking(ib_trx, wake, nullptr));
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IS));
+  OK(ib_cursor_set_lock_mode(crsr, IB_LOCK_S));
+
+  OK(get(crsr, c1, &c2, &c3));
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_rollback(ib_trx));
+}
+
+int main(int, char *[]) {
+  ib_crsr_t crsr{};
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", DATABASE, TABLE);
+
+  OK(ib_init());
+
+  test_configure();
+
+  OK(ib_startup("default"));
+
+  auto success = ib_database_create(DATABASE);
+  assert(success);
+
+  create_table();
+
+  {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+    OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+    OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+    OK(insert(crsr, 5, 50, 500));
+    OK(ib_cursor_close(crsr));
+    OK(ib_trx_commit(ib_trx));
+  }
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+  OK(ib_cursor_lock(crsr, IB_LOCK_IX));
+
+  bool inserted{};
+
+  /* A new key is inserted. */
+  OK(upsert(crsr, 1, 10, 100, nullptr, 0, &inserted));
+  assert(inserted);
+  check_row(crsr, 1, 10, 100);
+
+  /* An existing key is updated, all the columns. */
+  inserted = true;
+  OK(upsert(crsr, 1, 11, 101, nullptr, 0, &inserted));
+  assert(!inserted);
+  check_row(crsr, 1, 11, 101);
+
+  /* Only C2, C3 keeps its value. */
+  const ulint update_cols[] = {1};
+
+  inserted = true;
+  OK(upsert(crsr, 1, 12, 999, update_cols, 1, &inserted));
+  assert(!inserted);
+  check_row(crsr, 1, 12, 101);
+
+  /* A duplicate in the unique secondary index is not updated. */
+  inserted = true;
+  assert(upsert(crsr, 2, 20, 101, nullptr, 0, &inserted) == DB_DUPLICATE_KEY);
+  assert(!inserted);
+
+  {
+    int32_t c2{};
+    int32_t c3{};
+
+    assert(get(crsr, 2, &c2, &c3) == DB_RECORD_NOT_FOUND);
+  }
+
+  check_row(crsr, 1, 12, 101);
+
+  /* A column number out of the row is rejected. */
+  const ulint bad_cols[] = {3};
+
+  assert(upsert(crsr, 1, 13, 101, bad_cols, 1, &inserted) == DB_DATA_MISMATCH);
+
+  /* The duplicate check of a plain insert S-locks the row, the upserts did
+  not leave the X-locking duplicate check of the transaction on. */
+  assert(insert(crsr, 5, 0, 0) == DB_DUPLICATE_KEY);
+  check_not_x_locked(5);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  /* The changes are committed. */
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  OK(ib_cursor_open_table(table_name, ib_trx, &crsr));
+
+  check_row(crsr, 1, 12, 101);
+  check_row(crsr, 5, 50, 500);
+
+  OK(ib_cursor_close(crsr));
+  OK(ib_trx_commit(ib_trx));
+
+  OK(drop_table(DATABASE, TABLE));
+
+  OK(ib_shutdown(IB_SHUTDOWN_NORMAL));
+
+#ifdef UNIV_DEBUG_VALGRIND
+  VALGRIND_DO_LEAK_CHECK;
+#endif /* UNIV_DEBUG_VALGRIND */
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,1044 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/* YCSB style workload driver.
+
+Loads a usertable(ycsb_key BIGINT UNSIGNED PRIMARY KEY, field0 .. fieldN-1
+VARCHAR) with --records rows and then runs one of the YCSB core workloads
+from --threads threads for --duration seconds:
+
+  A  50% read, 50% update, zipfian
+  B  95% read, 5% update, zipfian
+  C  100% read, zipfian
+  D  95% read, 5% insert, latest
+  E  95% scan, 5% insert, zipfian
+  F  50% read, 50% read-modify-write, zipfian
+
+The mix and the key distribution of a workload can be overridden with the
+--*-proportion and --distribution options. --target limits the total number
+of operations per second. The first --warmup seconds of the run are reported
+but left out of the summary.
+
+Every --interval seconds the throughput and the latency percentiles of each
+operation type during the interval are printed. The summary at the end has
+the same figures for the whole run after the warm-up.
+
+The keys are hashed from the insert order like YCSB does, unless
+--ordered-inserts is given. The latest distribution favours the keys that
+were inserted last, a few of them may not be committed yet when they are
+read, those reads are counted as not found. */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test0aux.h"
+
+#define DATABASE "ycsb"
+#define TABLE "usertable"
+
+using Clock = std::chrono::steady_clock;
+
+/** Operation types. */
+enum Op_type { OP_READ, OP_UPDATE, OP_INSERT, OP_SCAN, OP_RMW, OP_N };
+
+static const char *op_names[OP_N] = {"READ", "UPDATE", "INSERT", "SCAN", "READ-MODIFY-WRITE"};
+
+/** Key distributions. */
+enum Distribution { DIST_UNIFORM, DIST_ZIPFIAN, DIST_LATEST };
+
+static const char *dist_names[] = {"uniform", "zipfian", "latest"};
+
+/** The operation mix of a workload, the proportions need not add up to 1. */
+struct Workload {
+  const char *m_name;
+  std::array<double, OP_N> m_proportions;
+  Distribution m_distribution;
+};
+
+/** The YCSB core workloads, the proportions are in Op_type order. */
+static const Workload workloads[] = {
+  {"a", {0.50, 0.50, 0.00, 0.00, 0.00}, DIST_ZIPFIAN},
+  {"b", {0.95, 0.05, 0.00, 0.00, 0.00}, DIST_ZIPFIAN},
+  {"c", {1.00, 0.00, 0.00, 0.00, 0.00}, DIST_ZIPFIAN},
+  {"d", {0.95, 0.00, 0.05, 0.00, 0.00}, DIST_LATEST},
+  {"e", {0.00, 0.00, 0.05, 0.95, 0.00}, DIST_ZIPFIAN},
+  {"f", {0.50, 0.00, 0.00, 0.00, 0.50}, DIST_ZIPFIAN},
+};
+
+/* Test parameters, set from the command line. */
+static Workload workload = workloads[0];
+static uint64_t n_records = 100000;
+static int n_threads = 8;
+static int n_fields = 10;
+static int field_len = 100;
+static int max_scan_len = 100;
+static int duration = 60;
+static int warmup = 10;
+static int interval = 10;
+static uint64_t target = 0;
+static uint64_t seed = 0;
+static bool ordered_inserts = false;
+
+/* Set to false to make the workers exit. */
+static std::atomic<bool> test_running{};
+
+/* Next key number to insert. */
+static std::atomic<uint64_t> next_keynum{};
+
+/* One past the highest key number that was inserted and committed. */
+static std::atomic<uint64_t> n_keys{};
+
+/** 64 bit FNV-1a hash, YCSB spreads the insert order over the key space
+with it. */
+static uint64_t fnv_hash64(uint64_t v) {
+  uint64_t hash = 0xCBF29CE484222325ULL;
+
+  for (int i = 0; i < 8; ++i) {
+    hash ^= v & 0xff;
+    hash *= 0x100000001B3ULL;
+    v >>= 8;
+  }
+
+  return hash;
+}
+
+/** @return the primary key value of a key number. */
+static uint64_t build_key(uint64_t keynum) {
+  return ordered_inserts ? keynum : fnv_hash64(keynum);
+}
+
+/** Zipfian generator over [0, n), Gray et al. "Quickly Generating
+Billion-Record Synthetic Databases", like the YCSB ZipfianGenerator. */
+struct Zipfian {
+  static constexpr double THETA = 0.99;
+
+  explicit Zipfian(uint64_t n) : m_n(n) {
+    double zeta2{};
+
+    for (uint64_t i = 1; i <= n; ++i) {
+      const auto v = 1.0 / std::pow(double(i), THETA);
+
+      m_zetan += v;
+
+      if (i <= 2) {
+        zeta2 += v;
+      }
+    }
+
+    m_alpha = 1.0 / (1.0 - THETA);
+    m_eta = (1.0 - std::pow(2.0 / double(n), 1.0 - THETA)) / (1.0 - zeta2 / m_zetan);
+  }
+
+  /** @return the next value, the lower the more likely. */
+  template <typename Rng>
+  uint64_t next(Rng &rng) const {
+    const auto u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    const auto uz = u * m_zetan;
+
+    if (uz < 1.0) {
+      return 0;
+    } else if (uz < 1.0 + std::pow(0.5, THETA)) {
+      return 1;
+    }
+
+    const auto v = uint64_t(double(m_n) * std::pow(m_eta * u - m_eta + 1.0, m_alpha));
+
+    return std::min(v, m_n - 1);
+  }
+
+  /** Number of items. */
+  uint64_t m_n{};
+
+  /** Sum of 1 / i^THETA over [1, n]. */
+  double m_zetan{};
+
+  double m_alpha{};
+  double m_eta{};
+};
+
+/** Chooses the key numbers to operate on. */
+struct Key_chooser {
+  Key_chooser(Distribution distribution, const Zipfian *zipfian) : m_distribution(distribution), m_zipfian(zipfian) {}
+
+  /** @return a key number below n_keys. */
+  template <typename Rng>
+  uint64_t next(Rng &rng) const {
+    const auto n = n_keys.load(std::memory_order_relaxed);
+
+    switch (m_distribution) {
+      case DIST_UNIFORM:
+        return std::uniform_int_distribution<uint64_t>(0, n - 1)(rng);
+
+      case DIST_ZIPFIAN:
+        /* The hot keys are spread over the loaded key numbers, the
+        inserted ones are never hot, like the YCSB scrambled zipfian. */
+        return fnv_hash64(m_zipfian->next(rng)) % m_zipfian->m_n;
+
+      case DIST_LATEST: {
+        const auto v = m_zipfian->next(rng);
+
+        return v < n ? n - 1 - v : 0;
+      }
+    }
+
+    assert(false);
+    return 0;
+  }
+
+  Distribution m_distribution;
+
+  /** Zipfian over the loaded key numbers. */
+  const Zipfian *m_zipfian;
+};
+
+/** Latency histogram, the buckets cover the 64 bit nanosecond range with
+16 buckets per power of two, that is an error of at most 6.25%. Updated by
+one worker thread, read by the reporter. */
+struct Histogram {
+  static constexpr uint64_t N_SUB = 16;
+  static constexpr size_t N_BUCKETS = (64 - 5) * N_SUB + 2 * N_SUB;
+
+  /** @return the bucket of a latency. */
+  static size_t bucket(uint64_t ns) {
+    if (ns < 2 * N_SUB) {
+      return ns;
+    }
+
+    const auto shift = std::bit_width(ns) - 5;
+
+    return shift * N_SUB + (ns >> shift);
+  }
+
+  /** @return the highest latency that falls into a bucket. */
+  static uint64_t bucket_max(size_t i) {
+    if (i < 2 * N_SUB) {
+      return i;
+    }
+
+    const auto shift = i / N_SUB - 1;
+
+    return (((i % N_SUB + N_SUB + 1) << shift) - 1);
+  }
+
+  void add(uint64_t ns, bool ok) {
+    m_counts[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_sum_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    if (!ok) {
+      m_n_errs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  std::array<std::atomic<uint64_t>, N_BUCKETS> m_counts{};
+  std::atomic<uint64_t> m_sum_ns{};
+  std::atomic<uint64_t> m_n_errs{};
+  std::atomic<uint64_t> m_n_not_found{};
+};
+
+/** A copy of the histograms of an operation type summed over the threads. */
+struct Snapshot {
+  void add(const Histogram &h) {
+    for (size_t i = 0; i < Histogram::N_BUCKETS; ++i) {
+      const auto n = h.m_counts[i].load(std::memory_order_relaxed);
+
+      m_counts[i] += n;
+      m_n_ops += n;
+    }
+
+    m_sum_ns += h.m_sum_ns.load(std::memory_order_relaxed);
+    m_n_errs += h.m_n_errs.load(std::memory_order_relaxed);
+    m_n_not_found += h.m_n_not_found.load(std::memory_order_relaxed);
+  }
+
+  /** @return the difference between this snapshot and an earlier one. */
+  Snapshot operator-(const Snapshot &rhs) const {
+    Snapshot d{*this};
+
+    for (size_t i = 0; i < Histogram::N_BUCKETS; ++i) {
+      d.m_counts[i] -= rhs.m_counts[i];
+    }
+
+    d.m_n_ops -= rhs.m_n_ops;
+    d.m_sum_ns -= rhs.m_sum_ns;
+    d.m_n_errs -= rhs.m_n_errs;
+    d.m_n_not_found -= rhs.m_n_not_found;
+
+    return d;
+  }
+
+  /** @return the latency in microseconds below which pct % of the
+  operations completed. */
+  double percentile(double pct) const {
+    const auto rank = uint64_t(std::ceil(double(m_n_ops) * pct / 100.0));
+    uint64_t n{};
+
+    for (size_t i = 0; i < Histogram::N_BUCKETS; ++i) {
+      n += m_counts[i];
+
+      if (n >= rank && n > 0) {
+        return double(Histogram::bucket_max(i)) / 1000.0;
+      }
+    }
+
+    return 0.0;
+  }
+
+  void print(const char *name, double secs) const {
+    if (m_n_ops == 0) {
+      return;
+    }
+
+    printf(
+      "  %-17s ops=%-10lu ops/s=%-10.0f avg=%.1fus p50=%.1fus p95=%.1fus"
+      " p99=%.1fus p99.9=%.1fus max=%.1fus errs=%lu not_found=%lu\n",
+      name,
+      (unsigned long)m_n_ops,
+      double(m_n_ops) / secs,
+      double(m_sum_ns) / double(m_n_ops) / 1000.0,
+      percentile(50.0),
+      percentile(95.0),
+      percentile(99.0),
+      percentile(99.9),
+      percentile(100.0),
+      (unsigned long)m_n_errs,
+      (unsigned long)m_n_not_found
+    );
+  }
+
+  std::array<uint64_t, Histogram::N_BUCKETS> m_counts{};
+  uint64_t m_n_ops{};
+  uint64_t m_sum_ns{};
+  uint64_t m_n_errs{};
+  uint64_t m_n_not_found{};
+};
+
+using Snapshots = std::array<Snapshot, OP_N>;
+
+/** The histograms of a worker thread. */
+struct Thread_stats {
+  std::array<Histogram, OP_N> m_ops{};
+};
+
+static std::vector<std::unique_ptr<Thread_stats>> thread_stats;
+
+/** @return the histograms of all the threads summed by operation type. */
+static Snapshots take_snapshots() {
+  Snapshots snapshots{};
+
+  for (const auto &stats : thread_stats) {
+    for (int i = 0; i < OP_N; ++i) {
+      snapshots[i].add(stats->m_ops[i]);
+    }
+  }
+
+  return snapshots;
+}
+
+/** Print the throughput and latencies of a period.
+@param[in] label                Label of the period
+@param[in] cur                  Snapshot at the end of the period
+@param[in] prev                 Snapshot at the start of the period
+@param[in] secs                 Length of the period in seconds */
+static void print_period(const char *label, const Snapshots &cur, const Snapshots &prev, double secs) {
+  Snapshots diff;
+  uint64_t n_ops{};
+
+  for (int i = 0; i < OP_N; ++i) {
+    diff[i] = cur[i] - prev[i];
+    n_ops += diff[i].m_n_ops;
+  }
+
+  printf("%s %lu ops %.0f ops/s\n", label, (unsigned long)n_ops, double(n_ops) / secs);
+
+  for (int i = 0; i < OP_N; ++i) {
+    diff[i].print(op_names[i], secs);
+  }
+
+  fflush(stdout);
+}
+
+/** A worker thread. */
+struct Worker {
+  Worker(int id, const Key_chooser &chooser, Thread_stats *stats)
+    : m_rng(seed + id), m_chooser(chooser), m_stats(stats), m_value(field_len, 'x') {}
+
+  ~Worker() {
+    if (m_key_tpl != nullptr) {
+      ib_tuple_delete(m_key_tpl);
+      ib_tuple_delete(m_old_tpl);
+      ib_tuple_delete(m_new_tpl);
+
+      auto err = ib_cursor_close(m_crsr);
+      assert(err == DB_SUCCESS);
+    }
+  }
+
+  void open() {
+    auto err = ib_cursor_open_table(DATABASE "/" TABLE, nullptr, &m_crsr);
+    assert(err == DB_SUCCESS);
+
+    m_key_tpl = ib_clust_search_tuple_create(m_crsr);
+    assert(m_key_tpl != nullptr);
+
+    m_old_tpl = ib_clust_read_tuple_create(m_crsr);
+    assert(m_old_tpl != nullptr);
+
+    m_new_tpl = ib_clust_read_tuple_create(m_crsr);
+    assert(m_new_tpl != nullptr);
+  }
+
+  /** Fill the value buffer with random text. */
+  void gen_value() {
+    static const char txt[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                              "abcdefghijklmnopqrstuvwxyz"
+                              "0123456789";
+
+    for (auto &c : m_value) {
+      c = txt[m_rng() % (sizeof(txt) - 1)];
+    }
+  }
+
+  /** Set the key and all the fields of m_new_tpl. */
+  void build_row(uint64_t keynum) {
+    auto err = ib_tuple_write_u64(m_new_tpl, 0, build_key(keynum));
+    assert(err == DB_SUCCESS);
+
+    for (int i = 1; i <= n_fields; ++i) {
+      gen_value();
+
+      err = ib_col_set_value(m_new_tpl, i, m_value.data(), m_value.size());
+      assert(err == DB_SUCCESS);
+    }
+  }
+
+  /** Position the cursor on a key.
+  @param[in] keynum             Key number to search for
+  @param[in] match_mode         IB_EXACT_MATCH for point lookups
+  @param[out] found             true if the cursor is positioned on the key,
+                                or on a row after it for IB_CLOSEST_MATCH
+  @return DB_SUCCESS or error code */
+  ib_err_t moveto(uint64_t keynum, ib_match_mode_t match_mode, bool &found) {
+    int res = ~0;
+
+    auto err = ib_tuple_write_u64(m_key_tpl, 0, build_key(keynum));
+    assert(err == DB_SUCCESS);
+
+    ib_cursor_set_match_mode(m_crsr, match_mode);
+
+    err = ib_cursor_moveto(m_crsr, m_key_tpl, IB_CUR_GE, &res);
+
+    if (err == DB_RECORD_NOT_FOUND || err == DB_END_OF_INDEX) {
+      found = false;
+      return DB_SUCCESS;
+    }
+
+    found = err == DB_SUCCESS && (res == 0 || match_mode != IB_EXACT_MATCH);
+
+    return err;
+  }
+
+  ib_err_t do_read(bool &found) {
+    auto err = ib_cursor_set_lock_mode(m_crsr, IB_LOCK_NONE);
+
+    if (err == DB_SUCCESS) {
+      err = moveto(m_chooser.next(m_rng), IB_EXACT_MATCH, found);
+    }
+
+    if (err == DB_SUCCESS && found) {
+      err = ib_cursor_read_row(m_crsr, m_old_tpl);
+    }
+
+    return err;
+  }
+
+  /** Update one random field, the read-modify-write also reads the row
+  first, which a plain update needs to do too with this API. */
+  ib_err_t do_update(bool &found) {
+    auto err = ib_cursor_set_lock_mode(m_crsr, IB_LOCK_X);
+
+    if (err == DB_SUCCESS) {
+      err = moveto(m_chooser.next(m_rng), IB_EXACT_MATCH, found);
+    }
+
+    if (err == DB_SUCCESS && found) {
+      err = ib_cursor_read_row(m_crsr, m_old_tpl);
+    }
+
+    if (err == DB_SUCCESS && found) {
+      err = ib_tuple_copy(m_new_tpl, m_old_tpl);
+      assert(err == DB_SUCCESS);
+
+      gen_value();
+
+      err = ib_col_set_value(m_new_tpl, 1 + m_rng() % n_fields, m_value.data(), m_value.size());
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_update_row(m_crsr, m_old_tpl, m_new_tpl);
+    }
+
+    return err;
+  }
+
+  ib_err_t do_insert() {
+    const auto keynum = next_keynum.fetch_add(1, std::memory_order_relaxed);
+
+    auto err = ib_cursor_lock(m_crsr, IB_LOCK_IX);
+
+    if (err == DB_SUCCESS) {
+      build_row(keynum);
+
+      err = ib_cursor_insert_row(m_crsr, m_new_tpl);
+    }
+
+    if (err == DB_SUCCESS) {
+      m_inserted = keynum + 1;
+    }
+
+    return err;
+  }
+
+  ib_err_t do_scan(bool &found) {
+    const auto len = 1 + m_rng() % max_scan_len;
+
+    auto err = ib_cursor_set_lock_mode(m_crsr, IB_LOCK_NONE);
+
+    if (err == DB_SUCCESS) {
+      err = moveto(m_chooser.next(m_rng), IB_CLOSEST_MATCH, found);
+    }
+
+    for (uint64_t i = 0; err == DB_SUCCESS && found && i < len; ++i) {
+      err = ib_cursor_read_row(m_crsr, m_old_tpl);
+
+      if (err == DB_SUCCESS) {
+        err = ib_cursor_next(m_crsr);
+      }
+
+      m_old_tpl = ib_tuple_clear(m_old_tpl);
+      assert(m_old_tpl != nullptr);
+    }
+
+    return err == DB_END_OF_INDEX || err == DB_RECORD_NOT_FOUND ? DB_SUCCESS : err;
+  }
+
+  /** @return the next operation type of the mix. */
+  Op_type choose_op() {
+    double sum{};
+
+    for (auto p : workload.m_proportions) {
+      sum += p;
+    }
+
+    auto r = std::uniform_real_distribution<double>(0.0, sum)(m_rng);
+
+    for (int i = 0; i < OP_N; ++i) {
+      if (r < workload.m_proportions[i]) {
+        return Op_type(i);
+      }
+
+      r -= workload.m_proportions[i];
+    }
+
+    return OP_READ;
+  }
+
+  /** Run one operation in its own transaction and record its latency. */
+  void run_op(Op_type op) {
+    const auto start = Clock::now();
+    bool found = true;
+    ib_err_t err;
+
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    assert(ib_trx != nullptr);
+
+    ib_cursor_attach_trx(m_crsr, ib_trx);
+
+    m_inserted = 0;
+
+    switch (op) {
+      case OP_READ:
+        err = do_read(found);
+        break;
+      case OP_UPDATE:
+      case OP_RMW:
+        err = do_update(found);
+        break;
+      case OP_INSERT:
+        err = do_insert();
+        break;
+      case OP_SCAN:
+        err = do_scan(found);
+        break;
+      default:
+        assert(false);
+        err = DB_ERROR;
+    }
+
+    auto err2 = ib_cursor_reset(m_crsr);
+    assert(err2 == DB_SUCCESS);
+
+    if (err == DB_SUCCESS) {
+      err = ib_trx_commit(ib_trx);
+    } else {
+      err2 = ib_trx_rollback(ib_trx);
+      assert(err2 == DB_SUCCESS);
+    }
+
+    if (err == DB_SUCCESS && m_inserted > 0) {
+      auto n = n_keys.load(std::memory_order_relaxed);
+
+      while (n < m_inserted && !n_keys.compare_exchange_weak(n, m_inserted, std::memory_order_relaxed)) {
+      }
+    }
+
+    m_old_tpl = ib_tuple_clear(m_old_tpl);
+    assert(m_old_tpl != nullptr);
+
+    m_new_tpl = ib_tuple_clear(m_new_tpl);
+    assert(m_new_tpl != nullptr);
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    auto &h = m_stats->m_ops[op];
+
+    h.add(uint64_t(ns), err == DB_SUCCESS);
+
+    if (!found) {
+      h.m_n_not_found.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /** Run operations until the test stops, at most target / n_threads per
+  second if a target is set. */
+  void run() {
+    open();
+
+    const auto period = target > 0 ? std::chrono::nanoseconds(1000000000ULL * n_threads / target) : std::chrono::nanoseconds(0);
+
+    auto next = Clock::now();
+
+    while (test_running.load(std::memory_order_relaxed)) {
+      if (period.count() > 0) {
+        const auto now = Clock::now();
+
+        next += period;
+
+        if (next > now) {
+          std::this_thread::sleep_until(next);
+        } else if (now - next > std::chrono::seconds(1)) {
+          /* Don't try to catch up with more than a second of backlog. */
+          next = now;
+        }
+      }
+
+      run_op(choose_op());
+    }
+  }
+
+  std::mt19937_64 m_rng;
+  const Key_chooser &m_chooser;
+  Thread_stats *m_stats{};
+  std::string m_value{};
+
+  /** One past the key number inserted by the current operation, 0 if none. */
+  uint64_t m_inserted{};
+
+  ib_crsr_t m_crsr{};
+  ib_tpl_t m_key_tpl{};
+  ib_tpl_t m_old_tpl{};
+  ib_tpl_t m_new_tpl{};
+};
+
+/** CREATE TABLE ycsb/usertable, dropping the one left over by an earlier run. */
+static void create_table() {
+  ib_tbl_sch_t ib_tbl_sch{};
+  ib_idx_sch_t ib_idx_sch{};
+  ib_id_t table_id{};
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  auto err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  (void)ib_table_drop(ib_trx, DATABASE "/" TABLE);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_create(DATABASE "/" TABLE, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "ycsb_key", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint64_t));
+  assert(err == DB_SUCCESS);
+
+  for (int i = 0; i < n_fields; ++i) {
+    char name[32];
+
+    snprintf(name, sizeof(name), "field%d", i);
+
+    err = ib_table_schema_add_col(ib_tbl_sch, name, IB_VARCHAR, IB_COL_NONE, 0, field_len);
+    assert(err == DB_SUCCESS);
+  }
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "ycsb_key", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+}
+
+/** DROP TABLE ycsb/usertable */
+static void drop_table() {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  auto err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_drop(ib_trx, DATABASE "/" TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** Insert the key numbers [0, n_records) from all the threads, each
+thread commits every 1000 rows. */
+static void load(const Key_chooser &chooser) {
+  constexpr uint64_t BATCH_SIZE = 1000;
+  std::vector<std::thread> threads;
+  const auto start = Clock::now();
+
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&chooser, t]() {
+      Thread_stats stats;
+      Worker worker(t, chooser, &stats);
+
+      worker.open();
+
+      for (uint64_t i = t * BATCH_SIZE; i < n_records; i += n_threads * BATCH_SIZE) {
+        auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+        assert(ib_trx != nullptr);
+
+        ib_cursor_attach_trx(worker.m_crsr, ib_trx);
+
+        auto err = ib_cursor_lock(worker.m_crsr, IB_LOCK_IX);
+        assert(err == DB_SUCCESS);
+
+        for (auto keynum = i; keynum < std::min(i + BATCH_SIZE, n_records); ++keynum) {
+          worker.build_row(keynum);
+
+          err = ib_cursor_insert_row(worker.m_crsr, worker.m_new_tpl);
+          assert(err == DB_SUCCESS);
+
+          worker.m_new_tpl = ib_tuple_clear(worker.m_new_tpl);
+          assert(worker.m_new_tpl != nullptr);
+        }
+
+        err = ib_cursor_reset(worker.m_crsr);
+        assert(err == DB_SUCCESS);
+
+        err = ib_trx_commit(ib_trx);
+        assert(err == DB_SUCCESS);
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  const auto secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  printf("Loaded %lu records in %.1f s, %.0f rows/s\n", (unsigned long)n_records, secs, double(n_records) / secs);
+
+  next_keynum.store(n_records);
+  n_keys.store(n_records);
+}
+
+/** Run the workload and print the statistics every interval and at the end. */
+static void run(const Key_chooser &chooser) {
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < n_threads; ++t) {
+    thread_stats.push_back(std::make_unique<Thread_stats>());
+  }
+
+  test_running = true;
+
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&chooser, t]() {
+      Worker worker(t, chooser, thread_stats[t].get());
+
+      worker.run();
+    });
+  }
+
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::seconds(warmup + duration);
+  const auto warmup_end = start + std::chrono::seconds(warmup);
+
+  Snapshots prev{};
+  Snapshots baseline{};
+  auto prev_time = start;
+  bool warming_up = warmup > 0;
+
+  while (prev_time < end) {
+    auto now = std::min({prev_time + std::chrono::seconds(interval), end, warming_up ? warmup_end : end});
+
+    std::this_thread::sleep_until(now);
+
+    const auto cur = take_snapshots();
+    const auto secs = std::chrono::duration<double>(now - prev_time).count();
+    const auto elapsed = std::chrono::duration<double>(now - start).count();
+    char label[64];
+
+    snprintf(label, sizeof(label), "[%6.0f s]%s", elapsed, warming_up ? " warm-up" : "");
+
+    print_period(label, cur, prev, secs);
+
+    if (warming_up && now >= warmup_end) {
+      warming_up = false;
+      baseline = cur;
+    }
+
+    prev = cur;
+    prev_time = now;
+  }
+
+  test_running = false;
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  printf("\nSummary: workload=%s distribution=%s threads=%d records=%lu fields=%d x %d bytes target=%lu\n",
+         workload.m_name,
+         dist_names[workload.m_distribution],
+         n_threads,
+         (unsigned long)n_records,
+         n_fields,
+         field_len,
+         (unsigned long)target);
+
+  print_period("[overall]", take_snapshots(), baseline, double(duration));
+
+  thread_stats.clear();
+}
+
+/** Print the options of this program. */
+static void print_ycsb_usage(const char *progname) {
+  print_usage(progname);
+
+  fprintf(stderr,
+          "[--workload a-f]\n"
+          "[--records count]\n"
+          "[--threads count]\n"
+          "[--field-count count]\n"
+          "[--field-length bytes]\n"
+          "[--distribution uniform|zipfian|latest]\n"
+          "[--read-proportion 0-1]\n"
+          "[--update-proportion 0-1]\n"
+          "[--insert-proportion 0-1]\n"
+          "[--scan-proportion 0-1]\n"
+          "[--rmw-proportion 0-1]\n"
+          "[--max-scan-length rows]\n"
+          "[--target ops per second, 0 for no limit]\n"
+          "[--duration seconds]\n"
+          "[--warmup seconds]\n"
+          "[--interval seconds]\n"
+          "[--seed number]\n"
+          "[--ordered-inserts]\n");
+}
+
+/** Set the runtime global options. */
+static void set_options(int argc, char *argv[]) {
+  static const struct option ycsb_opts[] = {
+    {"workload", required_argument, nullptr, USER_OPT + 1},
+    {"records", required_argument, nullptr, USER_OPT + 2},
+    {"threads", required_argument, nullptr, USER_OPT + 3},
+    {"field-count", required_argument, nullptr, USER_OPT + 4},
+    {"field-length", required_argument, nullptr, USER_OPT + 5},
+    {"distribution", required_argument, nullptr, USER_OPT + 6},
+    {"read-proportion", required_argument, nullptr, USER_OPT + 7},
+    {"update-proportion", required_argument, nullptr, USER_OPT + 8},
+    {"insert-proportion", required_argument, nullptr, USER_OPT + 9},
+    {"scan-proportion", required_argument, nullptr, USER_OPT + 10},
+    {"rmw-proportion", required_argument, nullptr, USER_OPT + 11},
+    {"max-scan-length", required_argument, nullptr, USER_OPT + 12},
+    {"target", required_argument, nullptr, USER_OPT + 13},
+    {"duration", required_argument, nullptr, USER_OPT + 14},
+    {"warmup", required_argument, nullptr, USER_OPT + 15},
+    {"interval", required_argument, nullptr, USER_OPT + 16},
+    {"seed", required_argument, nullptr, USER_OPT + 17},
+    {"ordered-inserts", no_argument, nullptr, USER_OPT + 18},
+  };
+  constexpr int n_ycsb_opts = sizeof(ycsb_opts) / sizeof(ycsb_opts[0]);
+  std::vector<struct option> longopts;
+  std::array<double, OP_N> proportions{-1, -1, -1, -1, -1};
+  int distribution = -1;
+  int opt;
+
+  /* The InnoDB system options, ours and the sentinel. */
+  for (int i = 0; ib_longopts[i].name != nullptr; ++i) {
+    longopts.push_back(ib_longopts[i]);
+  }
+
+  longopts.insert(longopts.end(), ycsb_opts, ycsb_opts + n_ycsb_opts);
+  longopts.push_back({nullptr, 0, nullptr, 0});
+
+  while ((opt = getopt_long(argc, argv, "", longopts.data(), nullptr)) != -1) {
+    switch (opt) {
+      case USER_OPT + 1: {
+        const auto it = std::find_if(std::begin(workloads), std::end(workloads), [](const Workload &w) {
+          return strcasecmp(w.m_name, optarg) == 0;
+        });
+
+        if (it == std::end(workloads)) {
+          print_ycsb_usage(argv[0]);
+          exit(EXIT_FAILURE);
+        }
+
+        workload = *it;
+        break;
+      }
+      case USER_OPT + 2:
+        n_records = strtoull(optarg, nullptr, 10);
+        break;
+      case USER_OPT + 3:
+        n_threads = atoi(optarg);
+        break;
+      case USER_OPT + 4:
+        n_fields = atoi(optarg);
+        break;
+      case USER_OPT + 5:
+        field_len = atoi(optarg);
+        break;
+      case USER_OPT + 6:
+        for (int i = 0; i < 3; ++i) {
+          if (strcasecmp(optarg, dist_names[i]) == 0) {
+            distribution = i;
+          }
+        }
+
+        if (distribution == -1) {
+          print_ycsb_usage(argv[0]);
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case USER_OPT + 7:
+      case USER_OPT + 8:
+      case USER_OPT + 9:
+      case USER_OPT + 10:
+      case USER_OPT + 11:
+        proportions[opt - (USER_OPT + 7)] = atof(optarg);
+        break;
+      case USER_OPT + 12:
+        max_scan_len = atoi(optarg);
+        break;
+      case USER_OPT + 13:
+        target = strtoull(optarg, nullptr, 10);
+        break;
+      case USER_OPT + 14:
+        duration = atoi(optarg);
+        break;
+      case USER_OPT + 15:
+        warmup = atoi(optarg);
+        break;
+      case USER_OPT + 16:
+        interval = atoi(optarg);
+        break;
+      case USER_OPT + 17:
+        seed = strtoull(optarg, nullptr, 10);
+        break;
+      case USER_OPT + 18:
+        ordered_inserts = true;
+        break;
+
+      default:
+        /* If it's an InnoDB parameter, then we let the
+        auxillary function handle it. */
+        if (set_global_option(opt, optarg) != DB_SUCCESS) {
+          print_ycsb_usage(argv[0]);
+          exit(EXIT_FAILURE);
+        }
+    }
+  }
+
+  /* The explicit options override the mix of the workload. */
+  for (int i = 0; i < OP_N; ++i) {
+    if (proportions[i] >= 0) {
+      workload.m_proportions[i] = proportions[i];
+    }
+  }
+
+  if (distribution != -1) {
+    workload.m_distribution = Distribution(distribution);
+  }
+
+  if (n_records < 2 || n_threads < 1 || n_fields < 1 || field_len < 1 || max_scan_len < 1 || duration < 1 || warmup < 0 ||
+      interval < 1) {
+    print_ycsb_usage(argv[0]);
+    exit(EXIT_FAILURE);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  set_options(argc, argv);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  (void)ib_database_create(DATABASE);
+
+  create_table();
+
+  const Zipfian zipfian(n_records);
+  const Key_chooser chooser(workload.m_distribution, &zipfian);
+
+  load(chooser);
+
+  run(chooser);
+
+  drop_table();
+
+  err = ib_database_drop(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  return EXIT_SUCCESS;
+}
@@ -24,19 +24,25 @@ Created 3/26/1996 Heikki Tuuri
 
 #include "trx0purge.h"
 
+#include "dict0dict.h"
 #include "fsp0fsp.h"
 #include "fut0fut.h"
 #include "mach0data.h"
 #include "mtr0log.h"
 #include "os0thread.h"
+#include "os0thread-create.h"
 #include "que0que.h"
 #include "read0read.h"
 #include "row0purge.h"
 #include "row0upd.h"
+#include "srv0task.h"
 #include "trx0rec.h"
 #include "trx0roll.h"
 #include "trx0rseg.h"
 #include "trx0trx.h"
+#include "ut0probe.h"
+
+#include <algorithm>
 
 /** A dummy undo record used as a return value when we have a whole undo log
 which needs no purge */
@@ -184,6 +190,7 @@ void Purge_sys::free_segment(trx_rseg_t *rseg, Fil_addr hdr_addr, ulint n_remove
 
   ut_ad(srv_trx_sys->m_rseg_history_len >= n_removed_logs);
   srv_trx_sys->m_rseg_history_len -= n_removed_logs;
+  m_n_logs_purged += n_removed_logs;
 
   mutex_exit(&kernel_mutex);
 
@@ -246,6 +253,7 @@ void Purge_sys::truncate_rseg_history(trx_rseg_t *rseg, trx_id_t limit_trx_no, u
 
       ut_a(srv_trx_sys->m_rseg_history_len >= n_removed_logs);
       srv_trx_sys->m_rseg_history_len -= n_removed_logs;
+      m_n_logs_purged += n_removed_logs;
 
       mutex_exit(&kernel_mutex);
 
@@ -622,6 +630,16 @@ Purge_sys::Purge_sys(Trx *trx) noexcept : m_trx(trx) {
 
   m_query = graph_build();
 
+  if (srv_config.m_n_purge_threads > 1) {
+    auto thr = que_fork_get_first_thr(m_query);
+
+    m_workers_heap = mem_heap_create(512);
+
+    for (ulint i = 0; i < srv_config.m_n_purge_threads; ++i) {
+      m_workers.push_back(row_purge_node_create(thr, m_workers_heap));
+    }
+  }
+
   m_view = read_view_oldest_copy_or_open_new(0, m_heap);
 }
 
@@ -630,6 +648,14 @@ Purge_sys::~Purge_sys() noexcept {
 
   que_graph_free(m_query);
 
+  for (auto node : m_workers) {
+    mem_heap_free(node->heap);
+  }
+
+  if (m_workers_heap != nullptr) {
+    mem_heap_free(m_workers_heap);
+  }
+
   ut_a(m_trx->m_is_purge);
   m_trx->m_conc_state = TRX_NOT_STARTED;
 
@@ -719,6 +745,80 @@ void Purge_sys::rec_release(trx_undo_inf_t *cell) noexcept {
   mutex_exit(&m_mutex);
 }
 
+void Purge_sys::update_lag() noexcept {
+  ut_ad(mutex_own(&m_mutex));
+  ut_ad(mutex_own(&kernel_mutex));
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto history_len = srv_trx_sys->m_rseg_history_len;
+  const auto elapsed = std::chrono::duration<double>(now - m_lag.m_sampled_at).count();
+
+  /* A batch can be much shorter than this, sample the rates at most once
+  a second so that they are not dominated by noise. */
+  if (m_lag.m_sampled_at == std::chrono::steady_clock::time_point{} || elapsed >= 1.0) {
+    if (m_lag.m_sampled_at != std::chrono::steady_clock::time_point{}) {
+      const auto n_logs_purged = m_n_logs_purged - m_lag.m_n_logs_purged;
+      const auto n_logs_added = history_len + n_logs_purged - m_lag.m_history_len;
+      const auto average = [elapsed](double avg, uint64_t n) { return (avg + n / elapsed) / 2; };
+
+      m_lag.m_recs_per_sec = average(m_lag.m_recs_per_sec, m_n_recs_purged - m_lag.m_n_recs_purged);
+      m_lag.m_logs_added_per_sec = average(m_lag.m_logs_added_per_sec, n_logs_added);
+      m_lag.m_logs_purged_per_sec = average(m_lag.m_logs_purged_per_sec, n_logs_purged);
+    }
+
+    m_lag.m_sampled_at = now;
+    m_lag.m_n_recs_purged = m_n_recs_purged;
+    m_lag.m_n_logs_purged = m_n_logs_purged;
+    m_lag.m_history_len = history_len;
+  }
+
+  /* Our own view was closed by the caller, the last one is the oldest. */
+  auto oldest_view = UT_LIST_GET_LAST(srv_trx_sys->m_view_list);
+
+  if (oldest_view != nullptr) {
+    m_lag.m_oldest_view_age = ulint(std::max(difftime(time(nullptr), oldest_view->created), 0.0));
+    m_lag.m_oldest_view_trx_id = oldest_view->creator_trx_id;
+  } else {
+    m_lag.m_oldest_view_age = 0;
+    m_lag.m_oldest_view_trx_id = 0;
+  }
+
+  double target{};
+
+  /* If we cannot advance the 'purge view' because of an old
+  'consistent read view', then the DML statements cannot be delayed.
+  Also, srv_config.m_max_purge_lag <= 0 means 'infinity'. */
+  if (srv_config.m_max_purge_lag > 0 && oldest_view == nullptr) {
+    const auto ratio = double(history_len) / srv_config.m_max_purge_lag;
+
+    if (ratio > 1) {
+      /* If undo is added to the history faster than it is purged the
+      delay grows, up to 4 times the base delay, and it shrinks to half
+      of it while the purge is catching up. */
+      auto pressure = 4.0;
+
+      if (m_lag.m_logs_purged_per_sec > 0) {
+        pressure = std::clamp(m_lag.m_logs_added_per_sec / m_lag.m_logs_purged_per_sec, 0.5, 4.0);
+      }
+
+      /* Maximum delay is 4295 seconds */
+      target = std::min((ratio - .5) * 10000 * pressure, 4295e6);
+    }
+  }
+
+  /* Move towards the target gradually, a step change makes all the
+  writers stall at the same time. */
+  m_lag.m_dml_delay += (target - m_lag.m_dml_delay) / 4;
+
+  if (m_lag.m_dml_delay < 1) {
+    m_lag.m_dml_delay = 0;
+  } else if (srv_config.m_max_purge_lag_delay > 0) {
+    m_lag.m_dml_delay = std::min(m_lag.m_dml_delay, double(srv_config.m_max_purge_lag_delay));
+  }
+
+  srv_dml_needed_delay = ulint(m_lag.m_dml_delay);
+}
+
 ulint Purge_sys::run() noexcept {
   que_thr_t *thr;
   ulint old_pages_handled;
@@ -749,24 +849,7 @@ ulint Purge_sys::run() noexcept {
   /* Determine how much data manipulation language (DML) statements
   need to be delayed in order to reduce the lagging of the purge
   thread. */
-  srv_dml_needed_delay = 0; /* in microseconds; default: no delay */
-
-  /* If we cannot advance the 'purge view' because of an old
-  'consistent read view', then the DML statements cannot be delayed.
-  Also, srv_config.m_max_purge_lag <= 0 means 'infinity'. */
-  if (srv_config.m_max_purge_lag > 0 && !UT_LIST_GET_LAST(srv_trx_sys->m_view_list)) {
-    float ratio = (float)srv_trx_sys->m_rseg_history_len / srv_config.m_max_purge_lag;
-    if (ratio > (float)ULINT_MAX / 10000) {
-      /* Avoid overflow: maximum delay is 4295 seconds */
-      srv_dml_needed_delay = ULINT_MAX;
-    } else if (ratio > 1) {
-      /* If the history list length exceeds the
-      innodb_max_purge_lag, the
-      data manipulation statements are delayed
-      by at least 5000 microseconds. */
-      srv_dml_needed_delay = (ulint)((ratio - .5) * 10000);
-    }
-  }
+  update_lag();
 
   m_view = read_view_oldest_copy_or_open_new(0, m_heap);
 
@@ -784,6 +867,21 @@ ulint Purge_sys::run() noexcept {
 
   mutex_exit(&m_mutex);
 
+  IB_PROBE(purge__batch__start);
+
+  if (!m_workers.empty()) {
+    if (srv_print_thread_releases) {
+
+      log_info("Starting purge with ", m_workers.size(), " threads");
+    }
+
+    run_workers();
+
+    IB_PROBE(purge__batch__done, m_n_pages_handled - old_pages_handled);
+
+    return m_n_pages_handled - old_pages_handled;
+  }
+
   mutex_enter(&kernel_mutex);
 
   thr = que_fork_start_command(m_query);
@@ -807,9 +905,83 @@ ulint Purge_sys::run() noexcept {
 
   que_run_threads(thr);
 
+  IB_PROBE(purge__batch__done, m_n_pages_handled - old_pages_handled);
+
   return m_n_pages_handled - old_pages_handled;
 }
 
+void Purge_sys::run_workers() noexcept {
+  struct Purge_rec {
+    trx_undo_rec_t *m_undo_rec;
+    roll_ptr_t m_roll_ptr;
+    trx_undo_inf_t *m_cell;
+  };
+
+  const auto n_workers = m_workers.size();
+  std::vector<std::vector<Purge_rec>> partitions(n_workers);
+
+  /* The copies of the undo records must stay valid until all the
+  workers are done with the batch. */
+  auto heap = mem_heap_create(UNIV_PAGE_SIZE);
+
+  for (;;) {
+    roll_ptr_t roll_ptr;
+    trx_undo_inf_t *cell;
+
+    auto undo_rec = fetch_next_rec(&roll_ptr, &cell, heap);
+
+    if (undo_rec == nullptr) {
+      break;
+    } else if (undo_rec == &trx_purge_dummy_rec) {
+      /* The whole undo log can be skipped. */
+      rec_release(cell);
+      continue;
+    }
+
+    /* All the records of a table go to the same worker, this keeps the
+    purge of the different versions of a row in the history order. */
+    Undo_rec_pars pars;
+
+    trx_undo_rec_get_pars(undo_rec, pars);
+
+    partitions[pars.m_table_id % n_workers].push_back({undo_rec, roll_ptr, cell});
+  }
+
+  auto purge = [&](ulint i) {
+    for (const auto &rec : partitions[i]) {
+      row_purge_rec(m_workers[i], m_trx, rec.m_undo_rec, rec.m_roll_ptr, rec.m_cell);
+    }
+  };
+
+  /* Prevent DROP TABLE etc. from running for the duration of the batch,
+  the workers don't freeze the data dictionary themselves. */
+  srv_dict_sys->freeze_data_dictionary(m_trx);
+
+  Task_group tasks(Task_class::Purge);
+
+  for (ulint i = 1; i < n_workers; ++i) {
+    if (!partitions[i].empty()) {
+      tasks.run([&purge, i]() { purge(i); });
+    }
+  }
+
+  purge(0);
+
+  tasks.wait();
+
+  srv_dict_sys->unfreeze_data_dictionary(m_trx);
+
+  mem_heap_free(heap);
+
+  /* fetch_next_rec() could not truncate the history while the records
+  of the batch were still reserved in the purge array, do it now. */
+  mutex_enter(&m_mutex);
+
+  truncate_if_arr_empty();
+
+  mutex_exit(&m_mutex);
+}
+
 trx_undo_rec_t *Purge_sys::fetch_next_rec(roll_ptr_t *roll_ptr, trx_undo_inf_t **cell, mem_heap_t *heap) noexcept {
   trx_undo_rec_t *undo_rec;
 
@@ -862,6 +1034,8 @@ trx_undo_rec_t *Purge_sys::fetch_next_rec(roll_ptr_t *roll_ptr, trx_undo_inf_t *
 
   *cell = arr_store_info(m_purge_trx_no, m_purge_undo_no);
 
+  ++m_n_recs_purged;
+
   ut_ad(m_purge_trx_no < m_view->low_limit_no);
 
   /* The following call will advance the stored values of purge_trx_no
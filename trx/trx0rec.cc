@@ -910,9 +910,74 @@ byte *trx_undo_parse_erase_page_end(byte *ptr, byte *end_ptr __attribute__((unus
   return ptr;
 }
 
+/**
+ * @brief Notes in the undo log and the transaction that an undo record was written.
+ *
+ * @param[in,out] undo Undo log
+ * @param[in,out] trx Transaction, owns the undo mutex
+ * @param[in] undo_block Page the record was written to
+ * @param[in] page_no Page number of undo_block
+ * @param[in] offset Offset of the record on the page
+ */
+static void trx_undo_report_done(trx_undo_t *undo, Trx *trx, Buf_block *undo_block, page_no_t page_no, ulint offset) noexcept {
+  undo->m_empty = false;
+  undo->m_top_page_no = page_no;
+  undo->m_top_offset = offset;
+  undo->m_top_undo_no = trx->m_undo_no;
+  undo->m_guess_block = undo_block;
+
+  ++trx->m_undo_no;
+}
+
+/**
+ * @brief X-latches an undo log page and writes an undo record to it.
+ *
+ * @param[in] undo Undo log
+ * @param[in] page_no Page of the undo log to write to
+ * @param[in] op_type TRX_UNDO_INSERT_OP or TRX_UNDO_MODIFY_OP
+ * @param[in] trx Transaction
+ * @param[in] index Clustered index
+ * @param[in] clust_entry Entry to insert, for an insert
+ * @param[in] rec Record to modify, for an update or a delete marking
+ * @param[in] offsets Column offsets of rec
+ * @param[in] update Update vector, for an update
+ * @param[in] cmpl_info Compiler info on secondary index updates
+ * @param[out] offset Offset of the record on the page, 0 if it did not fit
+ * @param[in,out] mtr Mini-transaction that holds the latch on the page
+ *
+ * @return the undo log page
+ */
+static Buf_block *trx_undo_page_report(
+  trx_undo_t *undo, page_no_t page_no, ulint op_type, Trx *trx, const Index *index, const DTuple *clust_entry, const rec_t *rec,
+  const ulint *offsets, const upd_t *update, ulint cmpl_info, ulint *offset, mtr_t *mtr
+) noexcept {
+  Buf_pool::Request req {
+    .m_rw_latch = RW_X_LATCH,
+    .m_page_id = { undo->m_space, page_no },
+    .m_mode = BUF_GET,
+    .m_file = __FILE__,
+    .m_line = __LINE__,
+    .m_mtr = mtr
+  };
+
+  auto undo_block = srv_buf_pool->get(req, undo->m_guess_block);
+
+  buf_block_dbg_add_level(IF_SYNC_DEBUG(undo_block, SYNC_TRX_UNDO_PAGE));
+
+  auto undo_page = undo_block->get_frame();
+
+  if (op_type == TRX_UNDO_INSERT_OP) {
+    *offset = trx_undo_page_report_insert(undo_page, trx, index, clust_entry, mtr);
+  } else {
+    *offset = trx_undo_page_report_modify(undo_page, trx, index, rec, offsets, update, cmpl_info, mtr);
+  }
+
+  return undo_block;
+}
+
 db_err trx_undo_report_row_operation(
   ulint flags, ulint op_type, que_thr_t *thr, const Index *index, const DTuple *clust_entry, const upd_t *update,
-  ulint cmpl_info, const rec_t *rec, roll_ptr_t *roll_ptr
+  ulint cmpl_info, const rec_t *rec, mtr_t *row_mtr, roll_ptr_t *roll_ptr
 ) {
   trx_undo_t *undo;
   db_err err = DB_SUCCESS;
@@ -980,34 +1045,52 @@ db_err trx_undo_report_row_operation(
 
   auto page_no = undo->m_last_page_no;
 
-  mtr_t mtr;
+  if (row_mtr != nullptr) {
+    ulint offset;
 
-  mtr.start();
+    /* Write the record in the mini-transaction of the row: the undo page
+    latch is then held until the row is modified, but the row costs one
+    mini-transaction commit instead of two. */
+    auto undo_block = trx_undo_page_report(undo, page_no, op_type, trx, index, clust_entry, rec, offsets, update, cmpl_info, &offset, row_mtr);
 
-  for (;;) {
+    if (likely(offset != 0)) {
+      trx_undo_report_done(undo, trx, undo_block, page_no, offset);
 
-    Buf_pool::Request req {
-      .m_rw_latch = RW_X_LATCH,
-      .m_page_id = { undo->m_space, page_no },
-      .m_mode = BUF_GET,
-      .m_file = __FILE__,
-      .m_line = __LINE__,
-      .m_mtr = &mtr
-    };
+      mutex_exit(&trx->m_undo_mutex);
 
-    auto undo_block = srv_buf_pool->get(req, undo->m_guess_block);
+      *roll_ptr = trx_undo_build_roll_ptr(op_type == TRX_UNDO_INSERT_OP, rseg->id, page_no, offset);
 
-    buf_block_dbg_add_level(IF_SYNC_DEBUG(undo_block, SYNC_TRX_UNDO_PAGE));
+      if (likely_null(heap)) {
+        mem_heap_free(heap);
+      }
 
-    auto undo_page = undo_block->get_frame();
+      return DB_SUCCESS;
+    }
 
-    ulint offset;
+    /* Nothing was logged, release the page. Adding a page below takes the
+    rseg mutex, which must not be acquired while an undo page is latched. */
+    row_mtr->memo_release(undo_block, MTR_MEMO_PAGE_X_FIX);
 
-    if (op_type == TRX_UNDO_INSERT_OP) {
-      offset = trx_undo_page_report_insert(undo_page, trx, index, clust_entry, &mtr);
-    } else {
-      offset = trx_undo_page_report_modify(undo_page, trx, index, rec, offsets, update, cmpl_info, &mtr);
+    if (row_mtr->memo_contains(undo_block, MTR_MEMO_PAGE_X_FIX)) {
+      /* The records of the previous rows in row_mtr keep it latched. */
+      mutex_exit(&trx->m_undo_mutex);
+
+      if (likely_null(heap)) {
+        mem_heap_free(heap);
+      }
+
+      return DB_FAIL;
     }
+  }
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  for (;;) {
+    ulint offset;
+
+    auto undo_block = trx_undo_page_report(undo, page_no, op_type, trx, index, clust_entry, rec, offsets, update, cmpl_info, &offset, &mtr);
 
     if (unlikely(offset == 0)) {
       /* The record did not fit on the page. We erase the
@@ -1016,20 +1099,14 @@ db_err trx_undo_report_row_operation(
       version the replicate page constructed using the log
       records stays identical to the original page */
 
-      trx_undo_erase_page_end(undo_page, &mtr);
+      trx_undo_erase_page_end(undo_block->get_frame(), &mtr);
       mtr.commit();
     } else {
       /* Success */
 
       mtr.commit();
 
-      undo->m_empty = false;
-      undo->m_top_page_no = page_no;
-      undo->m_top_offset = offset;
-      undo->m_top_undo_no = trx->m_undo_no;
-      undo->m_guess_block = undo_block;
-
-      ++trx->m_undo_no;
+      trx_undo_report_done(undo, trx, undo_block, page_no, offset);
 
       mutex_exit(&trx->m_undo_mutex);
 
@@ -37,6 +37,9 @@ Created 3/26/1996 Heikki Tuuri
 #include "trx0trx.h"
 #include "trx0undo.h"
 #include "usr0sess.h"
+#include "ut0probe.h"
+
+#include <atomic>
 
 /** This many pages must be undone before a truncate is tried within
 rollback */
@@ -52,6 +55,18 @@ static int64_t trx_roll_max_undo_no;
 /** Auxiliary variable which tells the previous progress % we printed */
 static ulint trx_roll_progress_printed_pct;
 
+/** In crash recovery, the number of recovered transactions that the
+background rollback has not yet rolled back */
+static std::atomic<ulint> trx_roll_n_recovered_trxs{};
+
+/** In crash recovery, the number of undo log records of the recovered
+transactions that the background rollback has not yet undone */
+static std::atomic<ulint> trx_roll_n_recovered_undo_recs{};
+
+/** In crash recovery, the number of undo log records of the recovered
+transactions that have been undone */
+static std::atomic<ulint> trx_roll_n_recovered_undo_recs_done{};
+
 db_err trx_general_rollback(Trx *trx, bool partial, trx_savept_t *savept) {
   mem_heap_t *heap;
   que_thr_t *thr;
@@ -62,6 +77,8 @@ db_err trx_general_rollback(Trx *trx, bool partial, trx_savept_t *savept) {
 
   InnoDB::active_wake_master_thread();
 
+  IB_PROBE(trx__rollback, trx->m_id, partial);
+
   heap = mem_heap_create(512);
 
   roll_node = roll_node_create(heap);
@@ -97,6 +114,10 @@ db_err trx_general_rollback(Trx *trx, bool partial, trx_savept_t *savept) {
 
   ut_a(trx->m_error_state == DB_SUCCESS);
 
+  /* The deltas of commutative columns were not applied yet, they have
+  no undo log records. */
+  trx->discard_deltas(partial ? savept->n_deltas : 0);
+
   /* Tell Innobase server that there might be work for
   utility threads: */
 
@@ -142,6 +163,7 @@ trx_savept_t trx_savept_take(Trx *trx) /*!< in: transaction */
   trx_savept_t savept;
 
   savept.least_undo_no = trx->m_undo_no;
+  savept.n_deltas = trx->m_deltas.size();
 
   return savept;
 }
@@ -246,6 +268,10 @@ static void trx_rollback_active(
 
   log_info(std::format("Rolling back of trx id {} completed", TRX_ID_PREP_PRINTF(trx->m_id)));
 
+  if (trx_roll_n_recovered_trxs > 0) {
+    --trx_roll_n_recovered_trxs;
+  }
+
   mem_heap_free(heap);
 
   trx_roll_crash_recv_trx = nullptr;
@@ -259,7 +285,24 @@ void trx_rollback_or_clean_recovered(bool all) {
   }
 
   if (all) {
-    log_info("Starting in background the rollback of uncommitted transactions");
+    ulint n_trxs{};
+    ulint n_undo_recs{};
+
+    for (auto trx : srv_trx_sys->m_trx_list) {
+      if (trx->m_is_recovered && trx->m_conc_state == TRX_ACTIVE) {
+        ++n_trxs;
+        n_undo_recs += ulint(trx->m_undo_no);
+      }
+    }
+
+    trx_roll_n_recovered_trxs = n_trxs;
+    trx_roll_n_recovered_undo_recs = n_undo_recs;
+
+    log_info(std::format(
+      "Starting in background the rollback of {} uncommitted transactions, {} undo log records",
+      n_trxs,
+      n_undo_recs
+    ));
   }
 
   mutex_exit(&kernel_mutex);
@@ -294,6 +337,9 @@ loop:
   }
 
   if (all) {
+    trx_roll_n_recovered_trxs = 0;
+    trx_roll_n_recovered_undo_recs = 0;
+
     log_info("Rollback of non-prepared transactions completed");
   }
 
@@ -301,6 +347,18 @@ leave_function:
   mutex_exit(&kernel_mutex);
 }
 
+ulint trx_roll_get_n_recovered_trxs() {
+  return trx_roll_n_recovered_trxs;
+}
+
+ulint trx_roll_get_n_recovered_undo_recs() {
+  return trx_roll_n_recovered_undo_recs;
+}
+
+ulint trx_roll_get_n_recovered_undo_recs_done() {
+  return trx_roll_n_recovered_undo_recs_done;
+}
+
 void *trx_rollback_or_clean_all_recovered(void *) {
   trx_rollback_or_clean_recovered(true);
 
@@ -601,6 +659,14 @@ try_again:
     }
   }
 
+  if (trx == trx_roll_crash_recv_trx) {
+    ++trx_roll_n_recovered_undo_recs_done;
+
+    if (trx_roll_n_recovered_undo_recs > 0) {
+      --trx_roll_n_recovered_undo_recs;
+    }
+  }
+
   trx->m_undo_no = undo_no;
 
   if (!trx_undo_arr_store_info(trx, undo_no)) {
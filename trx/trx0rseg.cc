@@ -43,7 +43,7 @@ trx_rseg_t *trx_rseg_get_on_id(ulint id) {
 
 page_no_t trx_rseg_header_create(space_id_t space, ulint max_size, ulint *slot_no, mtr_t *mtr) {
   ut_ad(mutex_own(&kernel_mutex));
-  ut_ad(mtr->memo_contains(srv_fil->space_get_latch(space), MTR_MEMO_X_LOCK));
+  ut_ad(mtr->memo_contains(srv_fil->space_get_latch(space), MTR_MEMO_SX_LOCK));
 
   auto sys_header = srv_trx_sys->read_header(mtr);
 
@@ -186,6 +186,34 @@ static trx_rseg_t *trx_rseg_mem_create(
   return rseg;
 }
 
+trx_rseg_t *trx_rseg_create(space_id_t space) {
+  mtr_t mtr;
+
+  mtr.start();
+
+  /* Note that below we first reserve the file space x-latch, and
+  then enter the kernel: we must do it in this order to conform
+  to the latching order rules. */
+
+  mtr_sx_lock(srv_fil->space_get_latch(space), &mtr);
+
+  mutex_enter(&kernel_mutex);
+
+  ulint slot_no;
+  trx_rseg_t *rseg{};
+  auto page_no = trx_rseg_header_create(space, ULINT_MAX, &slot_no, &mtr);
+
+  if (page_no != FIL_NULL) {
+    rseg = trx_rseg_mem_create(IB_RECOVERY_DEFAULT, slot_no, space, page_no, &mtr);
+  }
+
+  mutex_exit(&kernel_mutex);
+
+  mtr.commit();
+
+  return rseg;
+}
+
 void trx_rseg_list_and_array_init(ib_recovery_t recovery, trx_sysf_t *sys_header, mtr_t *mtr) {
   UT_LIST_INIT(srv_trx_sys->m_rseg_list);
 
@@ -62,6 +62,12 @@ Trx_sys::~Trx_sys() noexcept {
   of the functions that we need to call. */
   mutex_enter(&kernel_mutex);
 
+  for (auto trx : m_trx_pool) {
+    destroy_trx(trx);
+  }
+
+  m_trx_pool.clear();
+
   /* There can't be any active transactions. */
   auto rseg = m_rseg_list.front();
 
@@ -218,7 +224,7 @@ dberr_t Trx_sys::create_system_tablespace() noexcept {
   then enter the kernel: we must do it in this order to conform
   to the latching order rules. */
 
-  mtr_x_lock(m_fsp->m_fil->space_get_latch(TRX_SYS_SPACE), &mtr);
+  mtr_sx_lock(m_fsp->m_fil->space_get_latch(TRX_SYS_SPACE), &mtr);
 
   mutex_enter(&kernel_mutex);
 
@@ -297,10 +303,23 @@ void Trx_sys::destroy_trx(Trx *&trx) noexcept {
 }
 
 Trx *Trx_sys::create_user_trx(void *arg) noexcept {
-  auto trx = create_trx(arg);
+  Trx *trx{};
 
   mutex_enter(&kernel_mutex);
 
+  if (!m_trx_pool.empty()) {
+    trx = m_trx_pool.back();
+    m_trx_pool.pop_back();
+
+    trx->reset(arg);
+  } else {
+    mutex_exit(&kernel_mutex);
+
+    trx = create_trx(arg);
+
+    mutex_enter(&kernel_mutex);
+  }
+
   ++m_n_user_trx;
 
   m_client_trx_list.push_front(trx);
@@ -315,7 +334,17 @@ void Trx_sys::destroy_user_trx(Trx *&trx) noexcept {
 
   m_client_trx_list.remove(trx);
 
-  destroy_trx(trx);
+  if (m_trx_pool.size() < TRX_SYS_TRX_POOL_SIZE) {
+    ut_a(trx->m_sess->m_trx == trx);
+    ut_a(trx->m_sess->m_graphs.empty());
+    ut_a(trx->m_sess->m_state != Session::State::ERROR);
+
+    m_trx_pool.push_back(trx);
+
+    trx = nullptr;
+  } else {
+    destroy_trx(trx);
+  }
 
   ut_a(m_n_user_trx > 0);
   --m_n_user_trx;
@@ -370,6 +399,39 @@ void Trx_sys::trx_list_insert_ordered(Trx *in_trx) noexcept {
   } else {
     m_trx_list.push_back(in_trx);
   }
+
+  const auto inserted = m_trx_by_id.emplace(in_trx->m_id, in_trx).second;
+  ut_a(inserted);
+
+  trx_list_changed();
+}
+
+ulint Trx_sys::create_rsegs(ulint n) noexcept {
+  ut_ad(!mutex_own(&kernel_mutex));
+  ut_a(n <= TRX_SYS_N_RSEGS);
+
+  mutex_enter(&kernel_mutex);
+
+  auto n_rsegs = m_rseg_list.size();
+
+  mutex_exit(&kernel_mutex);
+
+  const auto n_existing = n_rsegs;
+
+  while (n_rsegs < n) {
+    if (trx_rseg_create(TRX_SYS_SPACE) == nullptr) {
+      log_warn(std::format("Could only create {} of the {} rollback segments requested", n_rsegs, n));
+      break;
+    }
+
+    ++n_rsegs;
+  }
+
+  if (n_rsegs > n_existing) {
+    log_info(std::format("Created {} new rollback segments, there are now {}", n_rsegs - n_existing, n_rsegs));
+  }
+
+  return n_rsegs;
 }
 
 ulint Trx_sys::trx_assign_rseg() noexcept {
@@ -532,6 +594,32 @@ void Trx_sys::init_at_db_start(ib_recovery_t recovery) noexcept {
 
     rseg = UT_LIST_GET_NEXT(rseg_list, rseg);
   }
+
+  trx_list_changed();
+}
+
+const Active_trx_snapshot &Trx_sys::get_active_trx_snapshot() noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+
+  auto &snapshot = m_active_trx_snapshot;
+
+  if (snapshot.m_version == m_trx_list_version) {
+    return snapshot;
+  }
+
+  snapshot.m_trxs.clear();
+
+  for (auto trx : m_trx_list) {
+    ut_ad(trx->m_magic_n == TRX_MAGIC_N);
+
+    if (trx->m_conc_state == TRX_ACTIVE || trx->m_conc_state == TRX_PREPARED) {
+      snapshot.m_trxs.push_back({trx->m_id, trx->m_no});
+    }
+  }
+
+  snapshot.m_version = m_trx_list_version;
+
+  return snapshot;
 }
 
 int Trx_sys::recover(XID *xid_list, ulint len) noexcept{
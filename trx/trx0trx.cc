@@ -36,10 +36,13 @@ Created 3/26/1996 Heikki Tuuri
 #include "trx0undo.h"
 #include "trx0xa.h"
 #include "usr0sess.h"
+#include "ut0probe.h"
 
 /* Threads with unknown id. */
 os_thread_id_t NULL_THREAD_ID;
 
+Trx_commit_stats trx_commit_stats;
+
 Trx::Trx(Trx_sys *trx_sys, Session *sess, void *arg) noexcept 
  : m_client_ctx(arg), m_sess(sess), m_trx_sys(trx_sys) {
 
@@ -48,7 +51,7 @@ Trx::Trx(Trx_sys *trx_sys, Session *sess, void *arg) noexcept
 
   mutex_create(&m_undo_mutex, IF_DEBUG("trx_undo_mutex",) IF_SYNC_DEBUG(SYNC_TRX_UNDO,) Current_location());
 
-  m_lock_heap = mem_heap_create_in_buffer(256);
+  m_lock_heap = mem_heap_create_in_buffer(Lock_pool::HEAP_SIZE);
 
   m_global_read_view_heap = mem_heap_create(256);
 
@@ -89,6 +92,8 @@ Trx::~Trx() noexcept {
     trx_undo_arr_free(m_undo_no_arr);
   }
 
+  discard_deltas(0);
+
   ut_a(m_signals.empty());
   ut_a(m_reply_signals.empty());
 
@@ -123,6 +128,83 @@ void Trx::destroy(Trx *&trx) noexcept {
   trx = nullptr;
 }
 
+void Trx::reset(void *arg) noexcept {
+  ut_ad(mutex_own(&kernel_mutex));
+
+  ut_a(m_magic_n == TRX_MAGIC_N);
+  ut_a(m_conc_state == TRX_NOT_STARTED);
+  ut_a(m_n_client_tables_in_use == 0);
+  ut_a(m_client_n_tables_locked == 0);
+  ut_a(m_insert_undo == nullptr);
+  ut_a(m_update_undo == nullptr);
+  ut_a(m_signals.empty());
+  ut_a(m_reply_signals.empty());
+  ut_a(m_wait_lock == nullptr);
+  ut_a(m_wait_thrs.empty());
+  ut_a(m_dict_operation_lock_mode == 0);
+  ut_a(m_trx_locks.empty());
+  ut_a(m_read_view == nullptr);
+  ut_a(m_undo_no_arr == nullptr || m_undo_no_arr->n_used == 0);
+  ut_a(!m_commit_no_wait);
+  ut_a(m_deltas.empty());
+  ut_a(m_delta_heap == nullptr);
+
+  /* The locks and the global read view are gone, so the heaps can be
+  emptied instead of freed and created again. */
+  mem_heap_empty(m_lock_heap);
+  m_lock_pool.clear();
+  mem_heap_empty(m_global_read_view_heap);
+
+  m_global_read_view = nullptr;
+
+  trx_roll_free_all_savepoints(this);
+
+  m_id = 0;
+  m_op_info = "";
+  m_op_profile = {};
+  m_isolation_level = TRX_ISO_REPEATABLE_READ;
+  m_check_foreigns = true;
+
+#ifdef WITH_XOPEN
+  memset(&m_xid, 0, sizeof(m_xid));
+  m_xid.formatID = -1;
+  m_support_xa = 0;
+  m_flush_log_later = 0;
+  m_must_flush_log_later = 0;
+#endif /* WITH_XOPEN */
+
+  m_duplicates = 0;
+  m_deadlock_mark = 0;
+  m_dict_operation = TRX_DICT_OP_NONE;
+  m_declared_to_be_inside_innodb = false;
+  m_n_tickets_to_enter_innodb = 0;
+  m_is_recovered = false;
+  m_que_state = TRX_QUE_RUNNING;
+  m_handling_signals = 0;
+  m_start_time = ::time(nullptr);
+  m_no = LSN_MAX;
+  m_commit_lsn = 0;
+  m_read_only = false;
+  m_table_id = 0;
+  m_client_ctx = arg;
+  m_wake = nullptr;
+  m_client_query_str = nullptr;
+  m_error_state = DB_SUCCESS;
+  m_error_info = nullptr;
+  m_error_key_num = 0;
+  m_graph = nullptr;
+  m_n_active_thrs = 0;
+  m_graph_before_signal_handling = nullptr;
+  m_was_chosen_as_deadlock_victim = false;
+  m_wait_started = 0;
+  m_undo_no = 0;
+  m_last_sql_stat_start = {};
+  m_rseg = nullptr;
+  m_roll_limit = 0;
+  m_pages_undone = 0;
+  m_detailed_error[0] = '\0';
+}
+
 bool Trx::is_interrupted() const noexcept {
   return trx_is_interrupted(this);
 }
@@ -163,7 +245,9 @@ bool Trx::start_low(ulint rseg_id) noexcept {
   m_must_flush_log_later = false;
 #endif /* WITH_XOPEN */
 
-  m_trx_sys->m_trx_list.push_front(this);
+  m_trx_sys->trx_list_add(this);
+
+  IB_PROBE(trx__start, m_id, false);
 
   return true;
 }
@@ -183,6 +267,21 @@ bool Trx::start(ulint rseg_id) noexcept {
   /* FIXME: This requires an API change to support */
   /* trx->m_support_xa = ib_supports_xa(trx->m_client_ctx); */
 
+  if (m_read_only) {
+    /* A read-only transaction is not known to other threads until it
+    opens a read view or takes a lock, it needs no id and no rseg. */
+    ut_ad(m_conc_state != TRX_ACTIVE);
+
+    m_id = 0;
+    m_no = LSN_MAX;
+    m_conc_state = TRX_ACTIVE;
+    m_start_time = time(nullptr);
+
+    IB_PROBE(trx__start, m_id, true);
+
+    return true;
+  }
+
   mutex_enter(&kernel_mutex);
 
   auto ret = start_low(rseg_id);
@@ -202,6 +301,8 @@ void Trx::commit_off_kernel() noexcept {
 
     mutex_exit(&kernel_mutex);
 
+    Trx_commit_stats::Timer timer(trx_commit_stats, TRX_COMMIT_UNDO);
+
     mtr_t mtr;
 
     mtr.start();
@@ -285,6 +386,10 @@ void Trx::commit_off_kernel() noexcept {
 
   m_conc_state = TRX_COMMITTED_IN_MEMORY;
 
+  if (!m_read_only) {
+    m_trx_sys->trx_list_changed();
+  }
+
   /* If we release kernel_mutex below and we are still doing
   recovery i.e.: back ground rollback thread is still active
   then there is a chance that the rollback thread may see
@@ -299,7 +404,11 @@ void Trx::commit_off_kernel() noexcept {
 
   m_is_recovered = false;
 
-  srv_lock_sys->release_off_kernel(this);
+  {
+    Trx_commit_stats::Timer timer(trx_commit_stats, TRX_COMMIT_LOCK_RELEASE);
+
+    srv_lock_sys->release_off_kernel(this);
+  }
 
   if (m_global_read_view != nullptr) {
     read_view_close(m_global_read_view);
@@ -351,19 +460,29 @@ void Trx::commit_off_kernel() noexcept {
       m_must_flush_log_later = true;
     } else
 #endif /* WITH_XOPEN */
-      if (srv_config.m_flush_log_at_trx_commit == 0) {
+      if (m_commit_no_wait) {
+        /* commit_async() waits for the log */
+      } else if (srv_config.m_flush_log_at_trx_commit == 0) {
         /* Do nothing */
       } else if (srv_config.m_flush_log_at_trx_commit == 1) {
-        if (srv_config.m_unix_file_flush_method == SRV_UNIX_NOSYNC) {
+        {
           /* Write the log but do not flush it to disk */
-          log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
-        } else {
-          /* Write the log to the log files AND flush them to disk */
-          log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, true);
+          Trx_commit_stats::Timer timer(trx_commit_stats, TRX_COMMIT_LOG_WRITE);
+
+          log->commit_up_to(lsn, false);
+        }
+
+        if (srv_config.m_unix_file_flush_method != SRV_UNIX_NOSYNC) {
+          /* Flush the written log to disk, timed apart from the write */
+          Trx_commit_stats::Timer timer(trx_commit_stats, TRX_COMMIT_LOG_FLUSH);
+
+          log->commit_up_to(lsn, true);
         }
       } else if (srv_config.m_flush_log_at_trx_commit == 2) {
         /* Write the log but do not flush it to disk */
-        log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
+        Trx_commit_stats::Timer timer(trx_commit_stats, TRX_COMMIT_LOG_WRITE);
+
+        log->commit_up_to(lsn, false);
       } else {
         ut_error;
       }
@@ -387,7 +506,11 @@ void Trx::commit_off_kernel() noexcept {
   ut_ad(m_wait_thrs.empty());
   ut_ad(m_trx_locks.empty());
 
-  m_trx_sys->m_trx_list.remove(this);
+  if (!m_read_only) {
+    m_trx_sys->trx_list_remove(this);
+  }
+
+  IB_PROBE(trx__commit, m_id, lsn);
 }
 
 void Trx::cleanup_at_db_startup() noexcept{
@@ -400,7 +523,7 @@ void Trx::cleanup_at_db_startup() noexcept{
   m_conc_state = TRX_NOT_STARTED;
   m_last_sql_stat_start.least_undo_no = 0;
 
-  m_trx_sys->m_trx_list.remove(this);
+  m_trx_sys->trx_list_remove(this);
 }
 
 read_view_t *Trx::assign_read_view() noexcept {
@@ -781,6 +904,25 @@ db_err Trx::commit() noexcept {
 
   m_op_info = "committing";
 
+  if (m_read_only && m_global_read_view == nullptr && m_trx_locks.empty()) {
+    /* Nothing of this transaction is visible to other threads. */
+    ut_a(m_insert_undo == nullptr && m_update_undo == nullptr);
+
+    trx_roll_free_all_savepoints(this);
+
+    m_read_view = nullptr;
+    m_undo_no = 0;
+    m_client_query_str = nullptr;
+    m_conc_state = TRX_NOT_STARTED;
+    m_last_sql_stat_start.least_undo_no = 0;
+
+    m_op_info = "";
+
+    IB_PROBE(trx__commit, m_id, lsn_t{0});
+
+    return DB_SUCCESS;
+  }
+
   mutex_enter(&kernel_mutex);
 
   commit_off_kernel();
@@ -792,6 +934,32 @@ db_err Trx::commit() noexcept {
   return DB_SUCCESS;
 }
 
+db_err Trx::commit_async(std::function<void()> callback) noexcept {
+  m_commit_lsn = 0;
+  m_commit_no_wait = true;
+
+  auto err = commit();
+
+  m_commit_no_wait = false;
+
+  const auto lsn = m_commit_lsn;
+
+  if (err != DB_SUCCESS || lsn == 0 || srv_config.m_flush_log_at_trx_commit == 0) {
+    /* Nothing was logged, or the log is not waited for at commit. */
+    callback();
+  } else if (srv_config.m_flush_log_at_trx_commit == 1) {
+    /* Write the log and flush it to disk, unless flushes are disabled */
+    m_trx_sys->m_fsp->m_log->commit_async(lsn, srv_config.m_unix_file_flush_method != SRV_UNIX_NOSYNC, std::move(callback));
+  } else if (srv_config.m_flush_log_at_trx_commit == 2) {
+    /* Write the log but do not flush it to disk */
+    m_trx_sys->m_fsp->m_log->commit_async(lsn, false, std::move(callback));
+  } else {
+    ut_error;
+  }
+
+  return err;
+}
+
 void Trx::mark_sql_stat_end() noexcept {
   if (m_conc_state == TRX_NOT_STARTED) {
     m_undo_no = 0;
@@ -800,6 +968,18 @@ void Trx::mark_sql_stat_end() noexcept {
   m_last_sql_stat_start.least_undo_no = m_undo_no;
 }
 
+void Trx::discard_deltas(ulint n_deltas) noexcept {
+  if (n_deltas < m_deltas.size()) {
+    m_deltas.resize(n_deltas);
+  }
+
+  /* The keys of the discarded deltas stay in the heap until it is empty. */
+  if (m_deltas.empty() && m_delta_heap != nullptr) {
+    mem_heap_free(m_delta_heap);
+    m_delta_heap = nullptr;
+  }
+}
+
 ulint Trx::number_of_rows_locked() const noexcept {
   ulint n_records{};
 
@@ -876,7 +1056,7 @@ ulint Trx::number_of_rows_locked() const noexcept {
       os << "que state " << (ulong)m_que_state;
   }
 
-  if (!m_trx_locks.empty() || mem_heap_get_size(m_lock_heap) > 400) {
+  if (!m_trx_locks.empty() || mem_heap_get_size(m_lock_heap) > Lock_pool::HEAP_SIZE + 400) {
 
     os << std::format("{} lock struct(s), heap size {}, {} row lock(s)",
       m_trx_locks.size(), mem_heap_get_size(m_lock_heap), number_of_rows_locked()
@@ -968,14 +1148,14 @@ void Trx::prepare_for_commit() noexcept {
     } else if (srv_config.m_flush_log_at_trx_commit == 1) {
       if (srv_config.m_unix_file_flush_method == SRV_UNIX_NOSYNC) {
         /* Write the log but do not flush it to disk */
-        log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
+        log->commit_up_to(lsn, false);
       } else {
         /* Write the log to the log files AND flush them to disk */
-        log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, true);
+        log->commit_up_to(lsn, true);
       }
     } else if (srv_config.m_flush_log_at_trx_commit == 2) {
       /* Write the log but do not flush it to disk */
-      log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
+      log->commit_up_to(lsn, false);
     } else {
       ut_error;
     }
@@ -1016,14 +1196,14 @@ ulint Trx::commit_flush_log() noexcept {
   } else if (srv_config.m_flush_log_at_trx_commit == 1) {
     if (srv_config.m_unix_file_flush_method == SRV_UNIX_NOSYNC) {
       /* Write the log but do not flush it to disk */
-      log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
+      log->commit_up_to(lsn, false);
     } else {
       /* Write the log to the log files AND flush them to disk */
-      log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, true);
+      log->commit_up_to(lsn, true);
     }
   } else if (srv_config.m_flush_log_at_trx_commit == 2) {
     /* Write the log but do not flush it to disk */
-    log->write_up_to(lsn, LOG_WAIT_ONE_GROUP, false);
+    log->commit_up_to(lsn, false);
   } else {
     ut_error;
   }
@@ -944,6 +944,9 @@ void Undo::mark_as_dict_operation(Trx *trx, trx_undo_t *undo, mtr_t *mtr) noexce
 db_err Undo::assign_undo(Trx *trx, ulint type) noexcept {
   auto rseg = trx->m_rseg;
 
+  /* The API rejects modifications by read-only transactions. */
+  ut_a(!trx->m_read_only);
+
   ut_ad(mutex_own(&trx->m_undo_mutex));
 
   mtr_t mtr;
@@ -960,7 +963,11 @@ db_err Undo::assign_undo(Trx *trx, ulint type) noexcept {
   auto undo = reuse_cached(trx, rseg, type, trx->id, &mtr);
 #endif /* WITH_XOPEN */
 
-  if (undo == nullptr) {
+  if (undo != nullptr) {
+    m_n_cache_hits.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    m_n_cache_misses.fetch_add(1, std::memory_order_relaxed);
+
 #ifdef WITH_XOPEN
     auto err = trx_undo_create(trx, rseg, type, trx->m_id, &trx->m_xid, &undo, &mtr);
 #else
@@ -1010,17 +1017,21 @@ page_t *Undo::set_state_at_finish(trx_rseg_t *rseg, Trx *trx __attribute__((unus
 
   if (undo->m_size == 1 && mach_read_from_2(page_hdr + TRX_UNDO_PAGE_FREE) < TRX_UNDO_PAGE_REUSE_LIMIT) {
 
-    /* This is a heuristic to avoid the problem of all UNDO
-    slots ending up in one of the UNDO lists. Previously if
-    the server crashed with all the slots in one of the lists,
-    transactions that required the slots of a different type
-    would fail for lack of slots. */
+    /* Each type caches at most half of the slots, otherwise all the
+    slots could end up cached for one type and transactions that need
+    an undo log of the other type would fail for lack of slots. The
+    cache absorbs bursts: the segments that a burst creates are kept
+    until the cache is full. */
+    const auto n_cached = undo->m_type == TRX_UNDO_INSERT
+      ? UT_LIST_GET_LEN(rseg->insert_undo_cached)
+      : UT_LIST_GET_LEN(rseg->update_undo_cached);
 
-    if (UT_LIST_GET_LEN(rseg->update_undo_list) < 500 &&
-        UT_LIST_GET_LEN(rseg->insert_undo_list) < 500) {
+    if (n_cached < srv_config.m_undo_cache_size) {
       undo->m_state = TRX_UNDO_CACHED;
-    } else {
+    } else if (undo->m_type == TRX_UNDO_INSERT) {
       undo->m_state = TRX_UNDO_TO_FREE;
+    } else {
+      undo->m_state = TRX_UNDO_TO_PURGE;
     }
 
   } else if (undo->m_type == TRX_UNDO_INSERT) {
@@ -28,9 +28,13 @@ Created 5/11/1994 Heikki Tuuri
 
 #include "os0thread.h"
 #include "srv0srv.h"
+#include "ut0counter.h"
 #include "ut0logger.h"
 
+#include <algorithm>
+#include <array>
 #include <stdlib.h>
+#include <string_view>
 
 /** The value of ut_mem_block_struct::magic_n.  Used in detecting
 memory corruption. */
@@ -38,7 +42,7 @@ constexpr uint32_t UT_MEM_MAGIC_N = 1601650166;
 
 /** Dynamically allocated memory block */
 struct Mem_block {
-  Mem_block(uint32_t size) : m_size(size), m_magic_n(UT_MEM_MAGIC_N) {}
+  Mem_block(uint32_t size, Mem_tag tag) : m_size(size), m_magic_n(UT_MEM_MAGIC_N), m_tag(tag) {}
 
   /** mem block list node */
   UT_LIST_NODE_T(Mem_block) m_mem_block_list;
@@ -49,6 +53,9 @@ struct Mem_block {
   /** magic number (UT_MEM_MAGIC_N) */
   uint32_t m_magic_n;
 
+  /** Subsystem that the block is accounted to */
+  Mem_tag m_tag;
+
   /** List of all memory blocks allocated from the operating system
   with malloc.  Protected by s_mutex. */
   using Blocks = UT_LIST_BASE_NODE_T(Mem_block, m_mem_block_list);
@@ -88,7 +95,138 @@ void ut_mem_init() {
   }
 }
 
-static void *allocate(ulint n, bool set_to_zero, bool assert_on_error) {
+/** Number of shards of the memory accounting counters */
+constexpr int32_t UT_MEM_TAG_SHARDS = 16;
+
+/** Memory accounting of one subsystem. The allocated and freed bytes are
+counted separately, so that both counters only grow. */
+struct Mem_tag_counters {
+  /** Bytes allocated */
+  ut::CPU_sharded_counter<UT_MEM_TAG_SHARDS> m_allocated{};
+
+  /** Bytes freed */
+  ut::CPU_sharded_counter<UT_MEM_TAG_SHARDS> m_freed{};
+
+  /** Highest sampled difference of the two */
+  std::atomic<ulint> m_peak{};
+};
+
+/** Memory accounting, by tag */
+static std::array<Mem_tag_counters, MEM_TAG_COUNT> ut_mem_tags{};
+
+/** Source file prefixes and the tags that they map to, the first match
+wins so the more specific prefixes come first. */
+static constexpr std::pair<std::string_view, Mem_tag> ut_mem_tag_prefixes[] = {
+  {"log0recv", Mem_tag::RECV},
+  {"row0merge", Mem_tag::MERGE},
+  {"buf0", Mem_tag::BUF},
+  {"dict0", Mem_tag::DICT},
+  {"lock0", Mem_tag::LOCK},
+  {"log0", Mem_tag::LOG},
+  {"row0", Mem_tag::ROW},
+  {"btr0", Mem_tag::ROW},
+  {"que0", Mem_tag::ROW},
+  {"pars0", Mem_tag::ROW},
+  {"api0", Mem_tag::ROW},
+  {"trx0", Mem_tag::TRX},
+  {"fil0", Mem_tag::FIL},
+  {"fsp0", Mem_tag::FIL},
+  {"os0", Mem_tag::FIL}};
+
+Mem_tag ut_mem_tag_of(const char *file_name) noexcept {
+  /* The file names are string literals, the callers tend to allocate
+  from the same place repeatedly. */
+  static thread_local const char *last_file_name{};
+  static thread_local Mem_tag last_tag{Mem_tag::OTHER};
+
+  if (file_name == last_file_name) {
+    return last_tag;
+  }
+
+  std::string_view name{file_name};
+  const auto slash = name.find_last_of('/');
+
+  if (slash != std::string_view::npos) {
+    name.remove_prefix(slash + 1);
+  }
+
+  auto tag = Mem_tag::OTHER;
+
+  for (const auto &[prefix, prefix_tag] : ut_mem_tag_prefixes) {
+    if (name.starts_with(prefix)) {
+      tag = prefix_tag;
+      break;
+    }
+  }
+
+  last_file_name = file_name;
+  last_tag = tag;
+
+  return tag;
+}
+
+const char *ut_mem_tag_name(Mem_tag tag) noexcept {
+  switch (tag) {
+    case Mem_tag::BUF:
+      return "buf";
+    case Mem_tag::DICT:
+      return "dict";
+    case Mem_tag::LOCK:
+      return "lock";
+    case Mem_tag::LOG:
+      return "log";
+    case Mem_tag::RECV:
+      return "recv";
+    case Mem_tag::MERGE:
+      return "merge";
+    case Mem_tag::ROW:
+      return "row";
+    case Mem_tag::TRX:
+      return "trx";
+    case Mem_tag::FIL:
+      return "fil";
+    case Mem_tag::HEAP_CACHE:
+      return "heap_cache";
+    case Mem_tag::OTHER:
+      return "other";
+  }
+
+  ut_error;
+  return nullptr;
+}
+
+void ut_mem_tag_alloc(Mem_tag tag, ulint n) noexcept {
+  ut_mem_tags[size_t(tag)].m_allocated.inc(n);
+}
+
+void ut_mem_tag_free(Mem_tag tag, ulint n) noexcept {
+  ut_mem_tags[size_t(tag)].m_freed.inc(n);
+}
+
+Mem_tag_usage ut_mem_tag_usage(Mem_tag tag) noexcept {
+  auto &counters = ut_mem_tags[size_t(tag)];
+
+  /* Read the frees first, a concurrent alloc and free then cannot make
+  the difference negative. */
+  const auto freed = counters.m_freed.value();
+  const auto allocated = counters.m_allocated.value();
+  const ulint current = allocated > freed ? allocated - freed : 0;
+
+  auto peak = counters.m_peak.load(std::memory_order_relaxed);
+
+  while (current > peak && !counters.m_peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+  }
+
+  return Mem_tag_usage{current, std::max(current, peak)};
+}
+
+void ut_mem_tag_sample_peaks() noexcept {
+  for (size_t i{}; i < MEM_TAG_COUNT; ++i) {
+    (void) ut_mem_tag_usage(Mem_tag(i));
+  }
+}
+
+static void *allocate(ulint n, bool set_to_zero, bool assert_on_error, Mem_tag tag) {
   if (srv_config.m_use_sys_malloc) {
     auto ptr = new char [n];
     ut_a(ptr != nullptr || !assert_on_error);
@@ -142,7 +280,7 @@ static void *allocate(ulint n, bool set_to_zero, bool assert_on_error) {
       }
     }
 
-    auto mem_block = new (ptr) Mem_block(size);
+    auto mem_block = new (ptr) Mem_block(size, tag);
 
     UNIV_MEM_ALLOC(ret, n + sizeof(Mem_block));
 
@@ -154,6 +292,8 @@ static void *allocate(ulint n, bool set_to_zero, bool assert_on_error) {
 
     ptr = reinterpret_cast<char*>(mem_block + 1);
 
+    ut_mem_tag_alloc(tag, size);
+
     if (set_to_zero) {
       memset(ptr, 0x0, n);
     }
@@ -163,7 +303,7 @@ static void *allocate(ulint n, bool set_to_zero, bool assert_on_error) {
 }
 
 void *ut_new_func(ulint n, Source_location location) {
-  auto ptr = allocate(n, true, true);
+  auto ptr = allocate(n, true, true, ut_mem_tag_of(location.m_from.file_name()));
   return ptr;
 }
 
@@ -183,6 +323,8 @@ void ut_delete_func(void *p, Source_location location) {
 
   Mem_block::s_total_memory.fetch_sub(block->m_size, std::memory_order_relaxed);
 
+  ut_mem_tag_free(block->m_tag, block->m_size);
+
   std::lock_guard<std::mutex> lock(Mem_block::s_mutex);
 
   UT_LIST_REMOVE(Mem_block::s_blocks, block);
@@ -195,7 +337,7 @@ void *ut_realloc_func(void *p, ulint n, Source_location location) {
   auto ptr = reinterpret_cast<char*>(p);
 
   if (ptr == nullptr) {
-    return ut_new(n);
+    return ut_new_func(n, location);
   }
 
   if (n == 0) {
@@ -213,7 +355,7 @@ void *ut_realloc_func(void *p, ulint n, Source_location location) {
   auto old_size = block->m_size - sizeof(Mem_block);
   auto min_size  = n < old_size ? n : old_size;
 
-  auto new_ptr = ut_new(n);
+  auto new_ptr = ut_new_func(n, location);
 
   if (new_ptr == nullptr) {
 
@@ -239,6 +381,8 @@ void ut_delete_all_mem() {
 
     Mem_block::s_total_memory.fetch_sub(block->m_size, std::memory_order_relaxed);
 
+    ut_mem_tag_free(block->m_tag, block->m_size);
+
     UT_LIST_REMOVE(Mem_block::s_blocks, block);
 
     call_destructor(block);
@@ -31,6 +31,8 @@ Created 5/11/1994 Heikki Tuuri
 
 #include <innodb0types.h>
 
+#include <algorithm>
+#include <chrono>
 #include <format>
 #include <sstream>
 
@@ -166,12 +168,45 @@ void ut_sprintf_timestamp(char *buf) {
   );
 }
 
+/** Target duration of one ut_delay() unit in nanoseconds: 50 PAUSE
+instructions on the CPUs that the spin defaults were tuned on. */
+constexpr ulint UT_DELAY_UNIT_NS = 250;
+
+ulint ut_delay_relax_count = 50;
+
+void ut_delay_calibrate() {
+  using Clock = std::chrono::steady_clock;
+
+  constexpr ulint N_RELAX = 10000;
+
+  /* Take the fastest of a few runs, the others may have been
+  preempted. */
+  uint64_t min_ns{std::numeric_limits<uint64_t>::max()};
+
+  for (ulint run = 0; run < 5; ++run) {
+    const auto start = Clock::now();
+
+    for (ulint i = 0; i < N_RELAX; ++i) {
+      UT_RELAX_CPU();
+    }
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    min_ns = std::min<uint64_t>(min_ns, uint64_t(ns));
+  }
+
+  /* The PAUSE latency differs by more than 10x between CPU generations. */
+  const auto relax_ns = std::max<double>(double(min_ns) / N_RELAX, 0.1);
+
+  ut_delay_relax_count = std::clamp<ulint>(ulint(UT_DELAY_UNIT_NS / relax_ns), 1, 1000);
+}
+
 ulint ut_delay(ulint delay) {
   ulint i, j;
 
   j = 0;
 
-  for (i = 0; i < delay * 50; i++) {
+  for (i = 0; i < delay * ut_delay_relax_count; i++) {
     j += i;
     UT_RELAX_CPU();
   }
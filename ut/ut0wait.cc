@@ -0,0 +1,251 @@
+/** Copyright (c) 2024 Sunny Bains. All rights reserved. */
+
+/** @file ut/ut0wait.cc
+Wait event tracing
+*******************************************************/
+
+#include "ut0wait.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os0thread.h"
+#include "ut0logger.h"
+
+bool ut_wait_trace{false};
+
+ulint ut_wait_trace_events{4096};
+
+namespace ut {
+
+thread_local Op_profile *op_profile{};
+
+/** The last events of a thread. There is one writer, the thread that owns
+the ring, the readers copy the slots under a sequence lock per slot. */
+struct Wait_ring {
+  /** A slot with the event that was written to it. */
+  struct Slot {
+    /** 2 * n + 1 while event n is written to the slot, 2 * n + 2 after. */
+    std::atomic<uint64_t> m_seq{};
+
+    /** The event. */
+    Wait_event m_event{};
+  };
+
+  /** @param[in] n_slots          Number of slots, a power of 2 */
+  explicit Wait_ring(size_t n_slots) : m_slots(n_slots) {}
+
+  /** Writes the next event, only called by the owner of the ring.
+  @param[in] event              The event */
+  void push(const Wait_event &event) noexcept {
+    const auto n = m_n_events.load(std::memory_order_relaxed);
+    auto &slot = m_slots[n & (m_slots.size() - 1)];
+
+    slot.m_seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.m_event = event;
+
+    slot.m_seq.store(2 * n + 2, std::memory_order_release);
+    m_n_events.store(n + 1, std::memory_order_release);
+  }
+
+  /** Copies the events that are still in the ring.
+  @param[in,out] events         The events are appended to it
+  @param[in] reset              If true then skip the copied events on the
+                                next call */
+  void collect(std::vector<Wait_event> &events, bool reset) noexcept {
+    const auto n_events = m_n_events.load(std::memory_order_acquire);
+    const auto n_slots = m_slots.size();
+    auto n = std::max(n_events > n_slots ? n_events - n_slots : 0, m_n_collected);
+
+    for (; n < n_events; ++n) {
+      const auto &slot = m_slots[n & (n_slots - 1)];
+      const auto seq = slot.m_seq.load(std::memory_order_acquire);
+
+      if (seq != 2 * n + 2) {
+        /* Being overwritten, the newer events are copied below. */
+        continue;
+      }
+
+      const auto event = slot.m_event;
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (slot.m_seq.load(std::memory_order_relaxed) == seq) {
+        events.push_back(event);
+      }
+    }
+
+    if (reset) {
+      m_n_collected = n_events;
+    }
+  }
+
+  /** The slots. */
+  std::vector<Slot> m_slots;
+
+  /** Number of events written. */
+  std::atomic<uint64_t> m_n_events{};
+
+  /** Events before this were returned by a collect with reset, protected
+  by the registry mutex. */
+  uint64_t m_n_collected{};
+
+  /** true while a thread owns the ring. */
+  std::atomic<bool> m_in_use{true};
+};
+
+/** The rings of all the threads that recorded a wait. */
+struct Wait_rings {
+  /** Protects m_rings. The tracer records latch waits, so this cannot be
+  one of our own mutexes. */
+  std::mutex m_mutex{};
+
+  /** The rings, they are never freed. */
+  std::vector<std::unique_ptr<Wait_ring>> m_rings{};
+};
+
+/** @return the ring registry */
+static Wait_rings &wait_rings() noexcept {
+  static Wait_rings rings;
+
+  return rings;
+}
+
+/** Releases the ring of a thread when the thread exits. */
+struct Wait_ring_owner {
+  ~Wait_ring_owner() noexcept {
+    if (m_ring != nullptr) {
+      m_ring->m_in_use.store(false, std::memory_order_release);
+    }
+  }
+
+  /** The ring of the thread, nullptr until its first wait. */
+  Wait_ring *m_ring{};
+};
+
+static thread_local Wait_ring_owner wait_ring_owner;
+
+/** @return a ring for the calling thread, a free one if there is one. */
+static Wait_ring *wait_ring_acquire() noexcept {
+  auto &rings = wait_rings();
+  const auto n_slots = std::bit_ceil(std::max<size_t>(ut_wait_trace_events, 1));
+
+  std::lock_guard<std::mutex> guard(rings.m_mutex);
+
+  for (auto &ring : rings.m_rings) {
+    if (ring->m_slots.size() == n_slots && !ring->m_in_use.load(std::memory_order_acquire)) {
+      ring->m_in_use.store(true, std::memory_order_relaxed);
+      return ring.get();
+    }
+  }
+
+  rings.m_rings.push_back(std::make_unique<Wait_ring>(n_slots));
+
+  return rings.m_rings.back().get();
+}
+
+const char *to_string(Wait_type type) noexcept {
+  switch (type) {
+    case Wait_type::PAGE_READ:
+      return "page_read";
+    case Wait_type::LATCH:
+      return "latch";
+    case Wait_type::LOG_FLUSH:
+      return "log_flush";
+    case Wait_type::LOCK:
+      return "lock";
+    case Wait_type::FSYNC:
+      return "fsync";
+    case Wait_type::AIO_SLOT:
+      return "aio_slot";
+  }
+
+  return "unknown";
+}
+
+void wait_trace_record(Wait_type type, uint64_t object, const char *file, ulint line,
+                       std::chrono::steady_clock::time_point start) noexcept {
+  const auto end = std::chrono::steady_clock::now();
+  auto &ring = wait_ring_owner.m_ring;
+
+  if (ring == nullptr) {
+    ring = wait_ring_acquire();
+  }
+
+  Wait_event event{};
+
+  event.m_start_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count());
+  event.m_duration_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+  event.m_object = object;
+  event.m_thread_id = os_thread_pf(os_thread_get_curr_id());
+  event.m_file = file;
+  event.m_line = uint32_t(line);
+  event.m_type = type;
+
+  ring->push(event);
+}
+
+void wait_trace_collect(std::vector<Wait_event> &events, bool reset) noexcept {
+  auto &rings = wait_rings();
+
+  events.clear();
+
+  {
+    std::lock_guard<std::mutex> guard(rings.m_mutex);
+
+    for (auto &ring : rings.m_rings) {
+      ring->collect(events, reset);
+    }
+  }
+
+  std::sort(events.begin(), events.end(), [](const Wait_event &lhs, const Wait_event &rhs) {
+    return lhs.m_start_ns < rhs.m_start_ns;
+  });
+}
+
+dberr_t wait_trace_dump(const char *path) noexcept {
+  std::vector<Wait_event> events;
+
+  wait_trace_collect(events, false);
+
+  auto file = fopen(path, "w");
+
+  if (file == nullptr) {
+    log_warn(std::format("Cannot open the wait trace file '{}': {}", path, strerror(errno)));
+    return DB_ERROR;
+  }
+
+  /* The two clocks at the same time, to convert the starts to wall time. */
+  const auto steady_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+  const auto system_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+
+  fprintf(file, "# steady_ns %llu system_ns %llu events %zu\n", (unsigned long long)steady_ns.count(),
+          (unsigned long long)system_ns.count(), events.size());
+  fprintf(file, "# start_ns thread_id type duration_ns object site\n");
+
+  for (const auto &event : events) {
+    fprintf(file, "%llu %llu %s %llu %llu %s:%u\n", (unsigned long long)event.m_start_ns, (unsigned long long)event.m_thread_id,
+            to_string(event.m_type), (unsigned long long)event.m_duration_ns, (unsigned long long)event.m_object,
+            event.m_file != nullptr ? event.m_file : "-", event.m_line);
+  }
+
+  const auto err = ferror(file) != 0;
+
+  if (fclose(file) != 0 || err) {
+    log_warn(std::format("Cannot write the wait trace file '{}'", path));
+    return DB_ERROR;
+  }
+
+  return DB_SUCCESS;
+}
+
+}  // namespace ut